@@ -197,3 +197,21 @@ Feature: Basic Distance Matrix
             | 2 | 70 +-1 | 0      | 30 +-1 | 40 +-1 |
             | 3 | 40 +-1 | 50 +-1 | 0      | 10 +-1 |
             | 4 | 30 +-1 | 40 +-1 | 70 +-1 | 0  |
+
+    Scenario: Testbot - Travel time matrix with a maximum duration
+        Given the node map
+            | a | b | c | d |
+
+        And the ways
+            | nodes |
+            | abcd  |
+
+        And the query options
+            | max_duration | 25 |
+
+        When I request a travel time matrix I should get
+            |   | a  | b  | c  | d  |
+            | a | 0  | 10 | 20 |    |
+            | b | 10 | 0  | 10 | 20 |
+            | c | 20 | 10 | 0  | 10 |
+            | d |    | 20 | 10 | 0  |
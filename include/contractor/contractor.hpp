@@ -29,10 +29,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define CONTRACTOR_CONTRACTOR_HPP
 
 #include "contractor/contractor_config.hpp"
+#include "contractor/core_landmarks.hpp"
+#include "contractor/hub_labels.hpp"
 #include "contractor/query_edge.hpp"
 #include "extractor/edge_based_edge.hpp"
+#include "extractor/edge_based_graph.hpp"
 #include "extractor/edge_based_node.hpp"
-#include "util/deallocating_vector.hpp"
+#include "util/chunked_vector.hpp"
 #include "util/typedefs.hpp"
 
 #include <string>
@@ -57,39 +60,78 @@ class Contractor
     Contractor &operator=(const Contractor &) = delete;
 
     int Run();
+    // Contracts the graph of Extractor::run without reading the .ebg and .enw, the graph is
+    // consumed. The speed and turn penalty files are applied while reading the .ebg and can't be
+    // used with this.
+    int Run(extractor::EdgeBasedGraph &edge_based_graph);
+
+    // Reads the .ebg and applies the speed and turn penalty files to its weights, which also
+    // updates the geometry and the r-tree leaves. Returns the largest node id.
+    static EdgeID
+    LoadEdgeExpandedGraph(const std::string &edge_based_graph_path,
+                          util::ChunkedVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
+                          const std::string &edge_segment_lookup_path,
+                          const std::string &edge_penalty_path,
+                          const std::vector<std::string> &segment_speed_path,
+                          const std::vector<std::string> &turn_penalty_path,
+                          const std::string &nodes_filename,
+                          const std::string &geometry_filename,
+                          const std::string &datasource_names_filename,
+                          const std::string &datasource_indexes_filename,
+                          const std::string &rtree_leaf_filename);
+
+    // The weights of the edges of the .ebg by their id with the speed and turn penalty files, like
+    // LoadEdgeExpandedGraph computes them, without changing any file. INVALID_EDGE_WEIGHT for the
+    // edges a speed of 0 closes.
+    static std::vector<EdgeWeight>
+    LoadEdgeWeights(const std::string &edge_based_graph_path,
+                    const std::string &edge_segment_lookup_path,
+                    const std::string &edge_penalty_path,
+                    const std::vector<std::string> &segment_speed_paths,
+                    const std::vector<std::string> &turn_penalty_paths);
 
   protected:
-    void ContractGraph(const unsigned max_edge_id,
-                       util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
-                       util::DeallocatingVector<QueryEdge> &contracted_edge_list,
+    // checks the config and starts the trace
+    void Initialize() const;
+    int ContractEdgeBasedGraph(extractor::EdgeBasedGraph &edge_based_graph);
+    // returns false if a signal stopped the contraction at a checkpoint
+    bool ContractGraph(const unsigned max_edge_id,
+                       util::ChunkedVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
+                       util::ChunkedVector<QueryEdge> &contracted_edge_list,
                        std::vector<EdgeWeight> &&node_weights,
                        std::vector<bool> &is_core_node,
                        std::vector<float> &inout_node_levels) const;
+    void
+    RecustomizeGraph(const unsigned max_edge_id,
+                     const util::ChunkedVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
+                     const std::vector<NodeID> &previous_renumbering,
+                     util::ChunkedVector<QueryEdge> &contracted_edge_list,
+                     std::vector<bool> &is_core_node) const;
+    void RenumberNodes(const NodeID number_of_nodes,
+                       const std::vector<NodeID> &previous_renumbering,
+                       const std::vector<float> &node_levels,
+                       util::ChunkedVector<QueryEdge> &contracted_edge_list,
+                       std::vector<bool> &is_core_node) const;
+    std::vector<NodeID> ReadNodeRenumbering() const;
     void WriteCoreNodeMarker(std::vector<bool> &&is_core_node) const;
+    void ReadCoreNodeMarker(std::vector<bool> &is_core_node) const;
+    void WriteCoreLandmarks(const CoreLandmarks &landmarks) const;
+    void WriteHubLabels(const HubLabels &hub_labels) const;
     void WriteNodeLevels(std::vector<float> &&node_levels) const;
     void ReadNodeLevels(std::vector<float> &contraction_order) const;
+    std::vector<float> ReadPartitionOrder(
+        const NodeID number_of_nodes,
+        const util::ChunkedVector<extractor::EdgeBasedEdge> &edge_based_edge_list) const;
+    void ReadContractedGraph(util::ChunkedVector<QueryEdge> &contracted_edge_list) const;
     std::size_t
     WriteContractedGraph(unsigned number_of_edge_based_nodes,
-                         const util::DeallocatingVector<QueryEdge> &contracted_edge_list);
+                         util::ChunkedVector<QueryEdge> &contracted_edge_list);
     void FindComponents(unsigned max_edge_id,
-                        const util::DeallocatingVector<extractor::EdgeBasedEdge> &edges,
+                        const util::ChunkedVector<extractor::EdgeBasedEdge> &edges,
                         std::vector<extractor::EdgeBasedNode> &nodes) const;
 
   private:
     ContractorConfig config;
-
-    EdgeID
-    LoadEdgeExpandedGraph(const std::string &edge_based_graph_path,
-                          util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
-                          const std::string &edge_segment_lookup_path,
-                          const std::string &edge_penalty_path,
-                          const std::vector<std::string> &segment_speed_path,
-                          const std::vector<std::string> &turn_penalty_path,
-                          const std::string &nodes_filename,
-                          const std::string &geometry_filename,
-                          const std::string &datasource_names_filename,
-                          const std::string &datasource_indexes_filename,
-                          const std::string &rtree_leaf_filename);
 };
 }
 }
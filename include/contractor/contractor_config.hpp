@@ -39,13 +39,21 @@ namespace contractor
 
 struct ContractorConfig
 {
-    ContractorConfig() : requested_num_threads(0) {}
+    ContractorConfig()
+        : use_partition_order(false), recustomize(false), renumber_nodes(false),
+          requested_num_threads(0), number_of_landmarks(0), compute_hub_labels(false),
+          max_hub_label_nodes(0), use_witness_cache(false), witness_hop_limit(0),
+          witness_hop_limit_degree(0), checkpoint_interval(0), resume(false)
+    {
+    }
 
     // Infer the output names from the path of the .osrm file
     void UseDefaultOutputNames()
     {
         level_output_path = osrm_input_path.string() + ".level";
         core_output_path = osrm_input_path.string() + ".core";
+        landmarks_output_path = osrm_input_path.string() + ".landmarks";
+        hub_labels_output_path = osrm_input_path.string() + ".hub_labels";
         graph_output_path = osrm_input_path.string() + ".hsgr";
         edge_based_graph_path = osrm_input_path.string() + ".ebg";
         edge_segment_lookup_path = osrm_input_path.string() + ".edge_segment_lookup";
@@ -53,8 +61,11 @@ struct ContractorConfig
         node_based_graph_path = osrm_input_path.string() + ".nodes";
         geometry_path = osrm_input_path.string() + ".geometry";
         rtree_leaf_path = osrm_input_path.string() + ".fileIndex";
+        node_renumbering_path = osrm_input_path.string() + ".node_renumbering";
         datasource_names_path = osrm_input_path.string() + ".datasource_names";
         datasource_indexes_path = osrm_input_path.string() + ".datasource_indexes";
+        checkpoint_path = osrm_input_path.string() + ".checkpoint";
+        partition_path = osrm_input_path.string() + ".partition";
     }
 
     boost::filesystem::path config_file_path;
@@ -62,6 +73,8 @@ struct ContractorConfig
 
     std::string level_output_path;
     std::string core_output_path;
+    std::string landmarks_output_path;
+    std::string hub_labels_output_path;
     std::string graph_output_path;
     std::string edge_based_graph_path;
 
@@ -70,8 +83,24 @@ struct ContractorConfig
     std::string node_based_graph_path;
     std::string geometry_path;
     std::string rtree_leaf_path;
+    // the new id of every edge-based node, only there if the nodes were renumbered
+    std::string node_renumbering_path;
     bool use_cached_priority;
 
+    // Contract the nodes in the nested dissection order of the multi-level partition of
+    // osrm-partition instead of by their priority. The order is written to the .level file, it
+    // doesn't depend on the weights and can be reused with use_cached_priority.
+    bool use_partition_order;
+    std::string partition_path;
+
+    // Update the weights of the previous contraction in the .hsgr instead of contracting again.
+    // Keeps its node order, core and shortcuts.
+    bool recustomize;
+
+    // Renumber the nodes by their level and their position for the locality of the queries. The
+    // .hsgr, .core, .landmarks, .hub_labels and the r-tree leaves get the new ids.
+    bool renumber_nodes;
+
     unsigned requested_num_threads;
 
     // A percentage of vertices that will be contracted for the hierarchy.
@@ -80,10 +109,37 @@ struct ContractorConfig
     //(e.g. 0.8 contracts 80 percent of the hierarchy, leaving a core of 20%)
     double core_factor;
 
+    // Number of landmarks selected in the core for ALT queries, 0 disables them
+    unsigned number_of_landmarks;
+
+    // Compute hub labels for the table queries of fully contracted graphs with at most
+    // max_hub_label_nodes nodes, their labels take a lot more memory than the hierarchy
+    bool compute_hub_labels;
+    unsigned max_hub_label_nodes;
+
+    // Skip witness searches whose witnesses from the last priority update are still valid
+    bool use_witness_cache;
+    // Hops the witness searches are limited to while the average degree of the remaining
+    // graph is below witness_hop_limit_degree, 0 disables the limit
+    unsigned witness_hop_limit;
+    double witness_hop_limit_degree;
+
+    // The state of the contraction is written to checkpoint_path every checkpoint_interval
+    // seconds, 0 disables the checkpoints. With resume a contraction continues from the last
+    // checkpoint of the same input. The checkpoint is removed once the outputs are written.
+    std::string checkpoint_path;
+    double checkpoint_interval;
+    bool resume;
+
     std::vector<std::string> segment_speed_lookup_paths;
     std::vector<std::string> turn_penalty_lookup_paths;
     std::string datasource_indexes_path;
     std::string datasource_names_path;
+
+    // the phases are written to this file with what they cost, see util::PhaseTrace
+    boost::filesystem::path trace_path;
+    // json or chrome
+    std::string trace_format;
 };
 }
 }
@@ -0,0 +1,237 @@
+#ifndef CORE_LANDMARKS_HPP
+#define CORE_LANDMARKS_HPP
+
+#include "util/binary_heap.hpp"
+#include "util/d_ary_heap.hpp"
+#include "util/integer_range.hpp"
+#include "util/simple_logger.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/parallel_invoke.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Landmarks of the uncontracted core and the distances between them and every core node,
+// which give the lower bounds for ALT (A*, landmarks, triangle inequality) in the core.
+//
+// Distances are measured on the core graph only, since that is the graph the core search
+// runs on. Unreachable pairs are INVALID_EDGE_WEIGHT.
+struct CoreLandmarks
+{
+    std::vector<NodeID> landmarks;
+    // ids of all core nodes in ascending order
+    std::vector<NodeID> core_nodes;
+    // for the i-th core node the distances from all landmarks to it, followed by the
+    // distances from it to all landmarks, at i * 2 * landmarks.size()
+    std::vector<EdgeWeight> distances;
+};
+
+namespace detail
+{
+// Adjacency array of the core graph, indexed by the position of a node in core_nodes
+struct CoreGraph
+{
+    struct Edge
+    {
+        NodeID target;
+        EdgeWeight weight;
+    };
+
+    std::vector<std::size_t> first_edge;
+    std::vector<Edge> edges;
+};
+
+// Builds the graph of all edges between two core nodes, or its reverse. The edges of the core
+// are stored at both of their nodes, the duplicates don't change any distances.
+template <class EdgeContainerT>
+CoreGraph buildCoreGraph(const EdgeContainerT &edges,
+                         const std::vector<NodeID> &core_rank,
+                         const std::size_t number_of_core_nodes,
+                         const bool reverse)
+{
+    std::vector<std::pair<NodeID, CoreGraph::Edge>> core_edges;
+    const auto addArc = [&](const NodeID from, const NodeID to, const EdgeWeight weight) {
+        if (reverse)
+        {
+            core_edges.emplace_back(to, CoreGraph::Edge{from, weight});
+        }
+        else
+        {
+            core_edges.emplace_back(from, CoreGraph::Edge{to, weight});
+        }
+    };
+
+    for (const auto &edge : edges)
+    {
+        if (edge.source == edge.target || core_rank[edge.source] == SPECIAL_NODEID ||
+            core_rank[edge.target] == SPECIAL_NODEID)
+        {
+            continue;
+        }
+        const NodeID source = core_rank[edge.source];
+        const NodeID target = core_rank[edge.target];
+        if (edge.data.forward)
+        {
+            addArc(source, target, edge.data.distance);
+        }
+        if (edge.data.backward)
+        {
+            addArc(target, source, edge.data.distance);
+        }
+    }
+    std::sort(core_edges.begin(), core_edges.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.first < rhs.first;
+    });
+
+    CoreGraph graph;
+    graph.first_edge.resize(number_of_core_nodes + 1, 0);
+    graph.edges.reserve(core_edges.size());
+    for (const auto &edge : core_edges)
+    {
+        ++graph.first_edge[edge.first + 1];
+        graph.edges.push_back(edge.second);
+    }
+    std::partial_sum(graph.first_edge.begin(), graph.first_edge.end(), graph.first_edge.begin());
+    return graph;
+}
+
+inline std::vector<EdgeWeight> computeDistances(const CoreGraph &graph, const NodeID source)
+{
+    using Heap =
+        util::DAryHeap<NodeID, NodeID, EdgeWeight, NodeID, util::ArrayStorage<NodeID, NodeID>>;
+
+    const std::size_t number_of_nodes = graph.first_edge.size() - 1;
+    std::vector<EdgeWeight> distances(number_of_nodes, INVALID_EDGE_WEIGHT);
+    Heap heap(number_of_nodes);
+    heap.Insert(source, 0, source);
+    while (!heap.Empty())
+    {
+        const NodeID node = heap.DeleteMin();
+        const EdgeWeight distance = heap.GetKey(node);
+        distances[node] = distance;
+
+        for (auto edge = graph.first_edge[node]; edge < graph.first_edge[node + 1]; ++edge)
+        {
+            const NodeID to = graph.edges[edge].target;
+            const EdgeWeight to_distance = distance + graph.edges[edge].weight;
+            if (!heap.WasInserted(to))
+            {
+                heap.Insert(to, to_distance, node);
+            }
+            else if (!heap.WasRemoved(to) && to_distance < heap.GetKey(to))
+            {
+                heap.GetData(to) = node;
+                heap.DecreaseKey(to, to_distance);
+            }
+        }
+    }
+    return distances;
+}
+}
+
+// Selects the landmarks by the farthest heuristic: every new landmark is the core node that is
+// farthest away from all landmarks chosen so far, starting at the node farthest from an
+// arbitrary one. Prefers nodes no landmark reaches, so every strongly connected component of
+// the core gets a landmark as long as there are enough.
+template <class EdgeContainerT>
+CoreLandmarks computeCoreLandmarks(const EdgeContainerT &edges,
+                                   const std::vector<bool> &is_core_node,
+                                   const unsigned number_of_landmarks)
+{
+    CoreLandmarks result;
+
+    std::vector<NodeID> core_rank(is_core_node.size(), SPECIAL_NODEID);
+    for (const auto node : util::irange<NodeID>(0, is_core_node.size()))
+    {
+        if (is_core_node[node])
+        {
+            core_rank[node] = result.core_nodes.size();
+            result.core_nodes.push_back(node);
+        }
+    }
+
+    const std::size_t number_of_core_nodes = result.core_nodes.size();
+    if (number_of_core_nodes == 0 || number_of_landmarks == 0)
+    {
+        return result;
+    }
+
+    const auto forward_graph =
+        detail::buildCoreGraph(edges, core_rank, number_of_core_nodes, false);
+    const auto reverse_graph =
+        detail::buildCoreGraph(edges, core_rank, number_of_core_nodes, true);
+
+    const unsigned used_landmarks =
+        std::min<std::size_t>(number_of_landmarks, number_of_core_nodes);
+    result.distances.resize(number_of_core_nodes * 2 * used_landmarks);
+
+    // distance of every core node to the closest landmark, INVALID_EDGE_WEIGHT if unreachable
+    std::vector<EdgeWeight> closest_landmark = detail::computeDistances(forward_graph, 0);
+    const auto farthestNode = [&] {
+        NodeID farthest = 0;
+        for (const auto node : util::irange<NodeID>(0, number_of_core_nodes))
+        {
+            if (closest_landmark[node] > closest_landmark[farthest])
+            {
+                farthest = node;
+            }
+        }
+        return farthest;
+    };
+
+    for (const auto index : util::irange(0u, used_landmarks))
+    {
+        const NodeID landmark = farthestNode();
+        result.landmarks.push_back(result.core_nodes[landmark]);
+
+        std::vector<EdgeWeight> from_landmark;
+        std::vector<EdgeWeight> to_landmark;
+        tbb::parallel_invoke(
+            [&] { from_landmark = detail::computeDistances(forward_graph, landmark); },
+            [&] { to_landmark = detail::computeDistances(reverse_graph, landmark); });
+
+        for (const auto node : util::irange<std::size_t>(0, number_of_core_nodes))
+        {
+            EdgeWeight *node_distances = &result.distances[node * 2 * used_landmarks];
+            node_distances[index] = from_landmark[node];
+            node_distances[used_landmarks + index] = to_landmark[node];
+        }
+
+        if (index == 0)
+        {
+            closest_landmark.swap(from_landmark);
+        }
+        else
+        {
+            std::transform(closest_landmark.begin(),
+                           closest_landmark.end(),
+                           from_landmark.begin(),
+                           closest_landmark.begin(),
+                           [](const EdgeWeight lhs, const EdgeWeight rhs) {
+                               return std::min(lhs, rhs);
+                           });
+        }
+        // landmarks themselves are never picked again
+        closest_landmark[landmark] = 0;
+    }
+
+    util::SimpleLogger().Write() << "Selected " << used_landmarks << " landmarks in a core of "
+                                 << number_of_core_nodes << " nodes";
+
+    return result;
+}
+}
+}
+
+#endif // CORE_LANDMARKS_HPP
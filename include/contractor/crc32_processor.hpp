@@ -1,116 +1,73 @@
 #ifndef ITERATOR_BASED_CRC32_H
 #define ITERATOR_BASED_CRC32_H
 
-#if defined(__x86_64__) && !defined(__MINGW64__)
-#include <cpuid.h>
-#endif
+#include "util/crc32c.hpp"
 
-#include <boost/crc.hpp> // for boost::crc_32_type
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <iterator>
+#include <vector>
 
 namespace osrm
 {
 namespace contractor
 {
 
+// util::crc32c of the bytes of the elements of a range. The range is split into parts that are
+// computed by all threads, the elements of a part are copied into a buffer to checksum them in
+// large blocks.
 class IteratorbasedCRC32
 {
   public:
-    bool UsingHardware() const { return use_hardware_implementation; }
+    bool UsingHardware() const { return util::isCRC32CInHardware(); }
 
-    IteratorbasedCRC32() : crc(0) { use_hardware_implementation = DetectHardwareSupport(); }
-
-    template <class Iterator> unsigned operator()(Iterator iter, const Iterator end)
-    {
-        unsigned crc = 0;
-        while (iter != end)
-        {
-            using value_type = typename std::iterator_traits<Iterator>::value_type;
-            const char *data = reinterpret_cast<const char *>(&(*iter));
-
-            if (use_hardware_implementation)
-            {
-                crc = ComputeInHardware(data, sizeof(value_type));
-            }
-            else
-            {
-                crc = ComputeInSoftware(data, sizeof(value_type));
-            }
-            ++iter;
-        }
-        return crc;
-    }
-
-  private:
-    bool DetectHardwareSupport() const
-    {
-        static const int sse42_bit = 0x00100000;
-        const unsigned ecx = cpuid();
-        const bool sse42_found = (ecx & sse42_bit) != 0;
-        return sse42_found;
-    }
-
-    unsigned ComputeInSoftware(const char *str, unsigned len)
-    {
-        crc_processor.process_bytes(str, len);
-        return crc_processor.checksum();
-    }
-
-    // adapted from http://byteworm.com/2010/10/13/crc32/
-    unsigned ComputeInHardware(const char *str, unsigned len)
+    template <class Iterator> unsigned operator()(Iterator begin, const Iterator end)
     {
-#if defined(__x86_64__)
-        unsigned q = len / sizeof(unsigned);
-        unsigned r = len % sizeof(unsigned);
-        unsigned *p = (unsigned *)str;
-
-        // crc=0;
-        while (q--)
+        using value_type = typename std::iterator_traits<Iterator>::value_type;
+        const constexpr std::size_t ELEMENTS_PER_BUFFER = 64 * 1024 / sizeof(value_type) + 1;
+        const constexpr std::size_t ELEMENTS_PER_PART = 16 * ELEMENTS_PER_BUFFER;
+
+        const std::size_t size = std::distance(begin, end);
+        const auto number_of_parts = (size + ELEMENTS_PER_PART - 1) / ELEMENTS_PER_PART;
+        std::vector<std::uint32_t> part_crcs(number_of_parts);
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_parts, 1),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                std::vector<char> buffer;
+                buffer.reserve(ELEMENTS_PER_BUFFER * sizeof(value_type));
+                for (auto part = range.begin(); part != range.end(); ++part)
+                {
+                    auto iter = std::next(begin, part * ELEMENTS_PER_PART);
+                    const auto part_end =
+                        std::next(begin, std::min(size, (part + 1) * ELEMENTS_PER_PART));
+                    std::uint32_t crc = 0;
+                    for (; iter != part_end; ++iter)
+                    {
+                        const auto data = reinterpret_cast<const char *>(&(*iter));
+                        buffer.insert(buffer.end(), data, data + sizeof(value_type));
+                        if (buffer.size() == buffer.capacity())
+                        {
+                            crc = util::crc32c(crc, buffer.data(), buffer.size());
+                            buffer.clear();
+                        }
+                    }
+                    part_crcs[part] = util::crc32c(crc, buffer.data(), buffer.size());
+                    buffer.clear();
+                }
+            });
+
+        std::uint32_t crc = 0;
+        for (std::size_t part = 0; part < number_of_parts; ++part)
         {
-            __asm__ __volatile__(".byte 0xf2, 0xf, 0x38, 0xf1, 0xf1;"
-                                 : "=S"(crc)
-                                 : "0"(crc), "c"(*p));
-            ++p;
+            const auto part_size =
+                std::min(ELEMENTS_PER_PART, size - part * ELEMENTS_PER_PART) * sizeof(value_type);
+            crc = util::crc32cCombine(crc, part_crcs[part], part_size);
         }
-
-        str = reinterpret_cast<char *>(p);
-        while (r--)
-        {
-            __asm__ __volatile__(".byte 0xf2, 0xf, 0x38, 0xf1, 0xf1;"
-                                 : "=S"(crc)
-                                 : "0"(crc), "c"(*str));
-            ++str;
-        }
-#else
-        (void)str;
-        (void)len;
-#endif
         return crc;
     }
-
-    inline unsigned cpuid() const
-    {
-        unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
-        // on X64 this calls hardware cpuid(.) instr. otherwise a dummy impl.
-        __get_cpuid(1, &eax, &ebx, &ecx, &edx);
-        return ecx;
-    }
-
-#if defined(__MINGW64__) || defined(_MSC_VER) || !defined(__x86_64__)
-    inline void __get_cpuid(int /*param*/,
-                            unsigned * /*eax*/,
-                            unsigned * /*ebx*/,
-                            unsigned *ecx,
-                            unsigned * /*edx*/) const
-    {
-        *ecx = 0;
-    }
-#endif
-
-    boost::crc_optimal<32, 0x1EDC6F41, 0x0, 0x0, true, true> crc_processor;
-    unsigned crc;
-    bool use_hardware_implementation;
 };
 
 struct RangebasedCRC32
@@ -3,10 +3,15 @@
 
 #include "contractor/query_edge.hpp"
 #include "util/binary_heap.hpp"
-#include "util/deallocating_vector.hpp"
+#include "util/chunked_vector.hpp"
+#include "util/crc32c.hpp"
+#include "util/d_ary_heap.hpp"
 #include "util/dynamic_graph.hpp"
+#include "util/exception.hpp"
 #include "util/integer_range.hpp"
+#include "util/io.hpp"
 #include "util/percent.hpp"
+#include "util/phase_trace.hpp"
 #include "util/simple_logger.hpp"
 #include "util/timing_util.hpp"
 #include "util/typedefs.hpp"
@@ -14,16 +19,27 @@
 #include "util/xor_fast_hash_storage.hpp"
 
 #include <boost/assert.hpp>
+#include <boost/filesystem.hpp>
 
 #include <stxxl/vector>
 
+#include <tbb/blocked_range.h>
 #include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_sort.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
 #include <limits>
 #include <memory>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -31,28 +47,64 @@ namespace osrm
 namespace contractor
 {
 
+// Tuning of the local searches for witness paths, which decide the shortcuts contracting a
+// node needs. A search that reaches a limit keeps the shortcuts it found no witness for, so
+// lower limits make the contraction faster but the hierarchy larger.
+struct WitnessSearchConfig
+{
+    // settled nodes of the searches of priority simulations and of contractions
+    int simulation_settled_nodes = 1000;
+    int contraction_settled_nodes = 2000;
+    // pairs of an average degree of the remaining graph and the hops searches are limited to
+    // in rounds below it, sorted by degree. Rounds above all degrees have no hop limit.
+    std::vector<std::pair<double, short>> hop_limits;
+    // skip the searches whose witnesses from the last evaluation of a node are still valid,
+    // costs memory for the witnesses of all remaining nodes. Without limits the shortcuts are
+    // the same, with them the cache keeps witnesses a new search may not find again.
+    bool use_cache = false;
+};
+
+// Checkpoints of the state of a contraction between two rounds: the remaining nodes, their
+// priorities, the levels, the remaining graph and the edges of the nodes flushed from it. A
+// contraction that was interrupted continues from its last checkpoint instead of starting over.
+struct CheckpointConfig
+{
+    // no checkpoints are written or read if empty
+    std::string path;
+    // seconds between two checkpoints, 0 disables them
+    double interval = 0;
+    // continue from the checkpoint at path if there is one for the same input
+    bool resume = false;
+    // asked before every round, e.g. to stop on the termination notice of a preemptible
+    // instance. If it returns true the contraction writes a checkpoint to path and stops.
+    std::function<bool()> stop;
+};
+
 class GraphContractor
 {
   private:
     struct ContractorEdgeData
     {
         ContractorEdgeData()
-            : distance(0), id(0), originalEdges(0), shortcut(0), forward(0), backward(0),
-              is_original_via_node_ID(false)
+            : distance(0), length(0), id(0), originalEdges(0), shortcut(0), forward(0),
+              backward(0), is_original_via_node_ID(false)
         {
         }
         ContractorEdgeData(unsigned distance,
+                           float length,
                            unsigned original_edges,
                            unsigned id,
                            bool shortcut,
                            bool forward,
                            bool backward)
-            : distance(distance), id(id),
+            : distance(distance), length(length), id(id),
               originalEdges(std::min((unsigned)1 << 28, original_edges)), shortcut(shortcut),
               forward(forward), backward(backward), is_original_via_node_ID(false)
         {
         }
         unsigned distance;
+        // length in meters of the original edges, the distance above is the weight
+        float length;
         unsigned id;
         unsigned originalEdges : 28;
         bool shortcut : 1;
@@ -65,20 +117,28 @@ class GraphContractor
     {
         ContractorHeapData() {}
         ContractorHeapData(short hop_, bool target_) : hop(hop_), target(target_) {}
+        ContractorHeapData(short hop_, bool target_, NodeID parent_)
+            : hop(hop_), target(target_), parent(parent_)
+        {
+        }
 
         short hop = 0;
         bool target = false;
+        // previous node on the shortest path found so far, for the witness cache
+        NodeID parent = SPECIAL_NODEID;
     };
 
     using ContractorGraph = util::DynamicGraph<ContractorEdgeData>;
     //    using ContractorHeap = util::BinaryHeap<NodeID, NodeID, int, ContractorHeapData,
     //    ArrayStorage<NodeID, NodeID>
     //    >;
-    using ContractorHeap = util::BinaryHeap<NodeID,
-                                            NodeID,
-                                            int,
-                                            ContractorHeapData,
-                                            util::XORFastHashStorage<NodeID, NodeID>>;
+    // util::BinaryHeap and util::RadixHeap can be swapped in here, see heap-bench
+    using ContractorHeap = util::DAryHeap<NodeID,
+                                          NodeID,
+                                          int,
+                                          ContractorHeapData,
+                                          util::XORFastHashStorage<NodeID, NodeID>,
+                                          4>;
     using ContractorEdge = ContractorGraph::InputEdge;
 
     struct ContractorThreadData
@@ -89,6 +149,28 @@ class GraphContractor
         explicit ContractorThreadData(NodeID nodes) : heap(nodes) {}
     };
 
+    // Witnesses the last searches from the neighbours of a node found, paths of at most the
+    // stored weight from a source to a target that avoid the node. Edges only get shorter
+    // until one of their nodes is contracted, so a search can be skipped as long as no inner
+    // node of its witness paths was contracted and they are still short enough. The paths
+    // that replace a contracted inner node may lead over the node itself.
+    struct WitnessCacheEntry
+    {
+        struct Search
+        {
+            NodeID source;
+            // first witness and inner node of the search, the next search ends them
+            std::uint32_t first_witness;
+            std::uint32_t first_witness_node;
+        };
+
+        // followed by a sentinel with the ends of the last search
+        std::vector<Search> searches;
+        // pairs of a target and the weight of its witness
+        std::vector<std::pair<NodeID, EdgeWeight>> witnesses;
+        std::vector<NodeID> witness_nodes;
+    };
+
     using NodeDepth = int;
 
     struct ContractionStats
@@ -104,6 +186,37 @@ class GraphContractor
         }
     };
 
+    // seconds spent in the phases of contraction rounds
+    struct RoundTimings
+    {
+        double independent_set = 0;
+        double contract_nodes = 0;
+        double delete_edges = 0;
+        double insert_edges = 0;
+        double compact_graph = 0;
+        double update_priorities = 0;
+
+        RoundTimings &operator+=(const RoundTimings &other)
+        {
+            independent_set += other.independent_set;
+            contract_nodes += other.contract_nodes;
+            delete_edges += other.delete_edges;
+            insert_edges += other.insert_edges;
+            compact_graph += other.compact_graph;
+            update_priorities += other.update_priorities;
+            return *this;
+        }
+
+        friend std::ostream &operator<<(std::ostream &out, const RoundTimings &timings)
+        {
+            return out << "independent sets " << timings.independent_set << "s, contraction "
+                       << timings.contract_nodes << "s, edge deletion " << timings.delete_edges
+                       << "s, edge insertion " << timings.insert_edges << "s, compaction "
+                       << timings.compact_graph << "s, priority updates "
+                       << timings.update_priorities << "s";
+        }
+    };
+
     struct RemainingNodeData
     {
         RemainingNodeData() : id(0), is_independent(false) {}
@@ -111,6 +224,23 @@ class GraphContractor
         bool is_independent : 1;
     };
 
+    // Followed by the remaining nodes, their priorities and depths, the levels, the node
+    // weights, the map to the original node ids, the edges of the remaining graph and the edges
+    // flushed from it
+    struct CheckpointHeader
+    {
+        // of the graph the contractor was constructed from
+        std::uint32_t input_checksum = 0;
+        std::uint32_t number_of_nodes = 0;
+        // of the remaining graph, fewer than number_of_nodes after the flush
+        std::uint32_t number_of_graph_nodes = 0;
+        std::uint32_t number_of_contracted_nodes = 0;
+        std::uint32_t current_level = 0;
+        std::uint8_t flushed_contractor = 0;
+        std::uint8_t use_cached_node_priorities = 0;
+        std::uint8_t padding[2] = {0, 0};
+    };
+
     struct ThreadDataContainer
     {
         explicit ThreadDataContainer(int number_of_nodes) : number_of_nodes(number_of_nodes) {}
@@ -147,46 +277,52 @@ class GraphContractor
                     std::vector<EdgeWeight> &&node_weights_)
         : node_levels(std::move(node_levels_)), node_weights(std::move(node_weights_))
     {
-        std::vector<ContractorEdge> edges;
-        edges.reserve(input_edge_list.size() * 2);
-
-        const auto dend = input_edge_list.dend();
-        for (auto diter = input_edge_list.dbegin(); diter != dend; ++diter)
-        {
-            BOOST_ASSERT_MSG(static_cast<unsigned int>(std::max(diter->weight, 1)) > 0,
-                             "edge distance < 1");
+        // every input edge is stored in both directions, the chunks of the input are converted
+        // by all threads and released once they are done
+        std::vector<ContractorEdge> edges(input_edge_list.size() * 2);
+        input_edge_list.ConsumeChunks([&edges](const std::size_t first_index,
+                                               const typename ContainerT::value_type *first,
+                                               const typename ContainerT::value_type *last) {
+            tbb::parallel_for(
+                tbb::blocked_range<std::size_t>(0, last - first),
+                [&](const tbb::blocked_range<std::size_t> &range) {
+                    for (auto offset = range.begin(); offset != range.end(); ++offset)
+                    {
+                        const auto &input_edge = first[offset];
+                        const auto weight =
+                            static_cast<unsigned int>(std::max(input_edge.weight, 1));
+                        BOOST_ASSERT_MSG(weight > 0, "edge distance < 1");
 #ifndef NDEBUG
-            if (static_cast<unsigned int>(std::max(diter->weight, 1)) > 24 * 60 * 60 * 10)
-            {
-                util::SimpleLogger().Write(logWARNING)
-                    << "Edge weight large -> "
-                    << static_cast<unsigned int>(std::max(diter->weight, 1)) << " : "
-                    << static_cast<unsigned int>(diter->source) << " -> "
-                    << static_cast<unsigned int>(diter->target);
-            }
+                        if (weight > 24 * 60 * 60 * 10)
+                        {
+                            util::SimpleLogger().Write(logWARNING)
+                                << "Edge weight large -> " << weight << " : "
+                                << static_cast<unsigned int>(input_edge.source) << " -> "
+                                << static_cast<unsigned int>(input_edge.target);
+                        }
 #endif
-            edges.emplace_back(diter->source,
-                               diter->target,
-                               static_cast<unsigned int>(std::max(diter->weight, 1)),
-                               1,
-                               diter->edge_id,
-                               false,
-                               diter->forward ? true : false,
-                               diter->backward ? true : false);
-
-            edges.emplace_back(diter->target,
-                               diter->source,
-                               static_cast<unsigned int>(std::max(diter->weight, 1)),
-                               1,
-                               diter->edge_id,
-                               false,
-                               diter->backward ? true : false,
-                               diter->forward ? true : false);
-        }
-        // clear input vector
-        input_edge_list.clear();
-        // FIXME not sure if we need this
-        edges.shrink_to_fit();
+                        const auto index = 2 * (first_index + offset);
+                        edges[index] = ContractorEdge(input_edge.source,
+                                                      input_edge.target,
+                                                      weight,
+                                                      input_edge.length,
+                                                      1,
+                                                      input_edge.edge_id,
+                                                      false,
+                                                      input_edge.forward ? true : false,
+                                                      input_edge.backward ? true : false);
+                        edges[index + 1] = ContractorEdge(input_edge.target,
+                                                          input_edge.source,
+                                                          weight,
+                                                          input_edge.length,
+                                                          1,
+                                                          input_edge.edge_id,
+                                                          false,
+                                                          input_edge.backward ? true : false,
+                                                          input_edge.forward ? true : false);
+                    }
+                });
+        });
 
         tbb::parallel_sort(edges.begin(), edges.end());
         NodeID edge = 0;
@@ -211,23 +347,25 @@ class GraphContractor
             forward_edge.data.id = reverse_edge.data.id = id;
             forward_edge.data.originalEdges = reverse_edge.data.originalEdges = 1;
             forward_edge.data.distance = reverse_edge.data.distance = INVALID_EDGE_WEIGHT;
-            // remove parallel edges
+            forward_edge.data.length = reverse_edge.data.length = 0;
+            // remove parallel edges, keeping the length of the one with the smallest weight
             while (i < edges.size() && edges[i].source == source && edges[i].target == target)
             {
-                if (edges[i].data.forward)
+                if (edges[i].data.forward && edges[i].data.distance < forward_edge.data.distance)
                 {
-                    forward_edge.data.distance =
-                        std::min(edges[i].data.distance, forward_edge.data.distance);
+                    forward_edge.data.distance = edges[i].data.distance;
+                    forward_edge.data.length = edges[i].data.length;
                 }
-                if (edges[i].data.backward)
+                if (edges[i].data.backward && edges[i].data.distance < reverse_edge.data.distance)
                 {
-                    reverse_edge.data.distance =
-                        std::min(edges[i].data.distance, reverse_edge.data.distance);
+                    reverse_edge.data.distance = edges[i].data.distance;
+                    reverse_edge.data.length = edges[i].data.length;
                 }
                 ++i;
             }
             // merge edges (s,t) and (t,s) into bidirectional edge
-            if (forward_edge.data.distance == reverse_edge.data.distance)
+            if (forward_edge.data.distance == reverse_edge.data.distance &&
+                forward_edge.data.length == reverse_edge.data.length)
             {
                 if ((int)forward_edge.data.distance != INVALID_EDGE_WEIGHT)
                 {
@@ -250,6 +388,13 @@ class GraphContractor
         util::SimpleLogger().Write() << "merged " << edges.size() - edge << " edges out of "
                                      << edges.size();
         edges.resize(edge);
+        // identifies the input of checkpoints
+        input_checksum =
+            util::parallelCRC32C(edges.data(), edges.size() * sizeof(ContractorEdge));
+        input_checksum = util::crc32c(
+            input_checksum, node_weights.data(), node_weights.size() * sizeof(EdgeWeight));
+        input_checksum = util::crc32c(
+            input_checksum, node_levels.data(), node_levels.size() * sizeof(float));
         contractor_graph = std::make_shared<ContractorGraph>(nodes, edges);
         edges.clear();
         edges.shrink_to_fit();
@@ -258,7 +403,11 @@ class GraphContractor
         util::SimpleLogger().Write() << "contractor finished initalization";
     }
 
-    void Run(double core_factor = 1.0)
+    // Returns false if the contraction was stopped before it finished, its edges are not
+    // complete then and only the checkpoint can be used
+    bool Run(double core_factor = 1.0,
+             const WitnessSearchConfig &witness_config = WitnessSearchConfig(),
+             const CheckpointConfig &checkpoint_config = CheckpointConfig())
     {
         // for the preperation we can use a big grain size, which is much faster (probably cache)
         const constexpr size_t InitGrainSize = 100000;
@@ -281,55 +430,119 @@ class GraphContractor
         std::vector<float> node_priorities;
         is_core_node.resize(number_of_nodes, false);
 
-        std::vector<RemainingNodeData> remaining_nodes(number_of_nodes);
-        // initialize priorities in parallel
-        tbb::parallel_for(tbb::blocked_range<int>(0, number_of_nodes, InitGrainSize),
-                          [this, &remaining_nodes](const tbb::blocked_range<int> &range) {
-                              for (int x = range.begin(), end = range.end(); x != end; ++x)
-                              {
-                                  remaining_nodes[x].id = x;
-                              }
-                          });
-
         bool use_cached_node_priorities = !node_levels.empty();
-        if (use_cached_node_priorities)
+        witness_search_config = witness_config;
+        unsigned current_level = 0;
+        bool flushed_contractor = false;
+        std::vector<RemainingNodeData> remaining_nodes;
+
+        CheckpointHeader checkpoint;
+        if (checkpoint_config.resume && !checkpoint_config.path.empty() &&
+            ReadCheckpoint(checkpoint_config.path,
+                           number_of_nodes,
+                           use_cached_node_priorities,
+                           checkpoint,
+                           remaining_nodes,
+                           node_priorities,
+                           node_depth))
         {
-            std::cout << "using cached node priorities ..." << std::flush;
-            node_priorities.swap(node_levels);
-            std::cout << "ok" << std::endl;
+            number_of_contracted_nodes = checkpoint.number_of_contracted_nodes;
+            current_level = checkpoint.current_level;
+            flushed_contractor = checkpoint.flushed_contractor != 0;
+            const auto number_of_graph_nodes = contractor_graph->GetNumberOfNodes();
+            thread_data_list.number_of_nodes = number_of_graph_nodes;
+            // the cached witnesses are not part of the checkpoint, the searches are repeated
+            if (witness_search_config.use_cache && !use_cached_node_priorities)
+            {
+                witness_cache.resize(number_of_graph_nodes);
+                is_contracted_node.resize(number_of_graph_nodes, false);
+            }
+            util::SimpleLogger().Write() << "resuming the contraction at round " << current_level
+                                         << " with " << number_of_contracted_nodes
+                                         << " nodes contracted";
         }
         else
         {
-            node_depth.resize(number_of_nodes, 0);
-            node_priorities.resize(number_of_nodes);
-            node_levels.resize(number_of_nodes);
-
-            std::cout << "initializing elimination PQ ..." << std::flush;
-            tbb::parallel_for(tbb::blocked_range<int>(0, number_of_nodes, PQGrainSize),
-                              [this, &node_priorities, &node_depth, &thread_data_list](
-                                  const tbb::blocked_range<int> &range) {
-                                  ContractorThreadData *data = thread_data_list.GetThreadData();
+            remaining_nodes.resize(number_of_nodes);
+            tbb::parallel_for(tbb::blocked_range<int>(0, number_of_nodes, InitGrainSize),
+                              [this, &remaining_nodes](const tbb::blocked_range<int> &range) {
                                   for (int x = range.begin(), end = range.end(); x != end; ++x)
                                   {
-                                      node_priorities[x] =
-                                          this->EvaluateNodePriority(data, node_depth[x], x);
+                                      remaining_nodes[x].id = x;
                                   }
                               });
-            std::cout << "ok" << std::endl;
+
+            witness_hop_limit = GetWitnessHopLimit(remaining_nodes);
+            if (witness_search_config.use_cache && !use_cached_node_priorities)
+            {
+                witness_cache.resize(number_of_nodes);
+                is_contracted_node.resize(number_of_nodes, false);
+            }
+            if (use_cached_node_priorities)
+            {
+                std::cout << "using cached node priorities ..." << std::flush;
+                node_priorities.swap(node_levels);
+                std::cout << "ok" << std::endl;
+            }
+            else
+            {
+                node_depth.resize(number_of_nodes, 0);
+                node_priorities.resize(number_of_nodes);
+                node_levels.resize(number_of_nodes);
+
+                std::cout << "initializing elimination PQ ..." << std::flush;
+                const util::PhaseTrace::ScopedPhase phase("initialize priorities");
+                tbb::parallel_for(tbb::blocked_range<int>(0, number_of_nodes, PQGrainSize),
+                                  [this, &node_priorities, &node_depth, &thread_data_list](
+                                      const tbb::blocked_range<int> &range) {
+                                      ContractorThreadData *data = thread_data_list.GetThreadData();
+                                      for (int x = range.begin(), end = range.end(); x != end; ++x)
+                                      {
+                                          node_priorities[x] =
+                                              this->EvaluateNodePriority(data, node_depth[x], x);
+                                      }
+                                  });
+                std::cout << "ok" << std::endl;
+            }
         }
-        BOOST_ASSERT(node_priorities.size() == number_of_nodes);
+        BOOST_ASSERT(node_priorities.size() == contractor_graph->GetNumberOfNodes());
 
         std::cout << "preprocessing " << number_of_nodes << " nodes ..." << std::flush;
 
-        unsigned current_level = 0;
-        bool flushed_contractor = false;
+        RoundTimings total_timings;
+        std::vector<ContractorEdge> inserted_edges;
+        auto last_checkpoint = std::chrono::steady_clock::now();
+        const auto write_checkpoint = [&] {
+            checkpoint.number_of_nodes = number_of_nodes;
+            checkpoint.number_of_graph_nodes = contractor_graph->GetNumberOfNodes();
+            checkpoint.number_of_contracted_nodes = number_of_contracted_nodes;
+            checkpoint.current_level = current_level;
+            checkpoint.flushed_contractor = flushed_contractor;
+            checkpoint.use_cached_node_priorities = use_cached_node_priorities;
+            WriteCheckpoint(
+                checkpoint_config.path, checkpoint, remaining_nodes, node_priorities, node_depth);
+            last_checkpoint = std::chrono::steady_clock::now();
+        };
         while (number_of_nodes > 2 &&
                number_of_contracted_nodes < static_cast<NodeID>(number_of_nodes * core_factor))
         {
+            if (checkpoint_config.stop && checkpoint_config.stop())
+            {
+                if (!checkpoint_config.path.empty())
+                {
+                    write_checkpoint();
+                }
+                util::SimpleLogger().Write() << "stopped the contraction at round "
+                                             << current_level << " with "
+                                             << number_of_contracted_nodes << " nodes contracted";
+                return false;
+            }
+
+            const util::PhaseTrace::ScopedPhase round_phase("contraction round");
             if (!flushed_contractor && (number_of_contracted_nodes >
                                         static_cast<NodeID>(number_of_nodes * 0.65 * core_factor)))
             {
-                util::DeallocatingVector<ContractorEdge>
+                util::ChunkedVector<ContractorEdge>
                     new_edge_set; // this one is not explicitely
                                   // cleared since it goes out of
                                   // scope anywa
@@ -399,6 +612,14 @@ class GraphContractor
                     }
                 }
 
+                // the witness paths refer to the old ids
+                if (!witness_cache.empty())
+                {
+                    witness_cache.clear();
+                    witness_cache.resize(remaining_nodes.size());
+                    is_contracted_node.assign(remaining_nodes.size(), false);
+                }
+
                 // Delete map from old NodeIDs to new ones.
                 new_node_id_from_orig_id_map.clear();
                 new_node_id_from_orig_id_map.shrink_to_fit();
@@ -428,6 +649,10 @@ class GraphContractor
                 thread_data_list.number_of_nodes = contractor_graph->GetNumberOfNodes();
             }
 
+            witness_hop_limit = GetWitnessHopLimit(remaining_nodes);
+
+            RoundTimings round_timings;
+            TIMER_START(independent_set);
             tbb::parallel_for(
                 tbb::blocked_range<std::size_t>(0, remaining_nodes.size(), IndependentGrainSize),
                 [this, &node_priorities, &remaining_nodes, &thread_data_list](
@@ -457,7 +682,7 @@ class GraphContractor
                 tbb::parallel_for(
                     tbb::blocked_range<std::size_t>(
                         begin_independent_nodes_idx, end_independent_nodes_idx, ContractGrainSize),
-                    [this, remaining_nodes, flushed_contractor, current_level](
+                    [this, &remaining_nodes, flushed_contractor, current_level](
                         const tbb::blocked_range<std::size_t> &range) {
                         if (flushed_contractor)
                         {
@@ -479,8 +704,11 @@ class GraphContractor
                         }
                     });
             }
+            TIMER_STOP(independent_set);
+            round_timings.independent_set = TIMER_SEC(independent_set);
 
             // contract independent nodes
+            TIMER_START(contract_nodes);
             tbb::parallel_for(
                 tbb::blocked_range<std::size_t>(
                     begin_independent_nodes_idx, end_independent_nodes_idx, ContractGrainSize),
@@ -494,7 +722,10 @@ class GraphContractor
                         this->ContractNode<false>(data, x);
                     }
                 });
+            TIMER_STOP(contract_nodes);
+            round_timings.contract_nodes = TIMER_SEC(contract_nodes);
 
+            TIMER_START(delete_edges);
             tbb::parallel_for(
                 tbb::blocked_range<int>(
                     begin_independent_nodes_idx, end_independent_nodes_idx, DeleteGrainSize),
@@ -505,43 +736,47 @@ class GraphContractor
                     {
                         const NodeID x = remaining_nodes[position].id;
                         this->DeleteIncomingEdges(data, x);
+                        if (!is_contracted_node.empty())
+                        {
+                            is_contracted_node[x] = true;
+                        }
                     }
                 });
+            TIMER_STOP(delete_edges);
+            round_timings.delete_edges = TIMER_SEC(delete_edges);
 
-            // make sure we really sort each block
-            tbb::parallel_for(
-                thread_data_list.data.range(),
-                [&](const ThreadDataContainer::EnumerableThreadData::range_type &range) {
-                    for (auto &data : range)
-                        tbb::parallel_sort(data->inserted_edges.begin(),
-                                           data->inserted_edges.end());
-                });
-
-            // insert new edges
+            // merge the shortcuts of all threads and insert them node by node in parallel
+            TIMER_START(insert_edges);
+            std::size_t number_of_inserted_edges = 0;
+            for (const auto &data : thread_data_list.data)
+            {
+                number_of_inserted_edges += data->inserted_edges.size();
+            }
+            inserted_edges.clear();
+            inserted_edges.reserve(number_of_inserted_edges);
             for (auto &data : thread_data_list.data)
             {
-                for (const ContractorEdge &edge : data->inserted_edges)
-                {
-                    const EdgeID current_edge_ID =
-                        contractor_graph->FindEdge(edge.source, edge.target);
-                    if (current_edge_ID < contractor_graph->EndEdges(edge.source))
-                    {
-                        ContractorGraph::EdgeData &current_data =
-                            contractor_graph->GetEdgeData(current_edge_ID);
-                        if (current_data.shortcut && edge.data.forward == current_data.forward &&
-                            edge.data.backward == current_data.backward &&
-                            edge.data.distance < current_data.distance)
-                        {
-                            // found a duplicate edge with smaller weight, update it.
-                            current_data = edge.data;
-                            continue;
-                        }
-                    }
-                    contractor_graph->InsertEdge(edge.source, edge.target, edge.data);
-                }
+                inserted_edges.insert(
+                    inserted_edges.end(), data->inserted_edges.begin(), data->inserted_edges.end());
                 data->inserted_edges.clear();
             }
+            UpdateParallelShortcuts(inserted_edges);
+            contractor_graph->InsertEdges(inserted_edges.begin(), inserted_edges.end());
+            TIMER_STOP(insert_edges);
+            round_timings.insert_edges = TIMER_SEC(insert_edges);
+
+            // free the slots of deleted and moved edges once they take up a quarter of the edge
+            // list, the shortcuts of every round leave many of them behind
+            TIMER_START(compact_graph);
+            if (3 * contractor_graph->GetEdgeListSize() >
+                4 * static_cast<std::size_t>(contractor_graph->GetNumberOfEdges()))
+            {
+                contractor_graph->Compact();
+            }
+            TIMER_STOP(compact_graph);
+            round_timings.compact_graph = TIMER_SEC(compact_graph);
 
+            TIMER_START(update_priorities);
             if (!use_cached_node_priorities)
             {
                 tbb::parallel_for(
@@ -559,6 +794,14 @@ class GraphContractor
                         }
                     });
             }
+            TIMER_STOP(update_priorities);
+            round_timings.update_priorities = TIMER_SEC(update_priorities);
+
+            util::SimpleLogger().Write(logDEBUG)
+                << "round " << current_level << ": contracted "
+                << end_independent_nodes_idx - begin_independent_nodes_idx << " nodes, added "
+                << inserted_edges.size() << " edges, " << round_timings;
+            total_timings += round_timings;
 
             // remove contracted nodes from the pool
             number_of_contracted_nodes += end_independent_nodes_idx - begin_independent_nodes_idx;
@@ -566,6 +809,22 @@ class GraphContractor
 
             p.PrintStatus(number_of_contracted_nodes);
             ++current_level;
+
+            if (checkpoint_config.interval > 0 && !checkpoint_config.path.empty() &&
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - last_checkpoint)
+                        .count() >= checkpoint_config.interval)
+            {
+                write_checkpoint();
+            }
+        }
+
+        util::SimpleLogger().Write() << "contracted in " << current_level << " rounds, "
+                                     << total_timings;
+        if (!witness_cache.empty())
+        {
+            util::SimpleLogger().Write() << "witness cache: skipped "
+                                         << number_of_cached_witness_searches << " of "
+                                         << number_of_witness_searches << " witness searches";
         }
 
         if (remaining_nodes.size() > 2)
@@ -606,6 +865,11 @@ class GraphContractor
                                      << std::endl;
 
         thread_data_list.data.clear();
+        witness_cache.clear();
+        witness_cache.shrink_to_fit();
+        is_contracted_node.clear();
+        is_contracted_node.shrink_to_fit();
+        return true;
     }
 
     inline void GetCoreMarker(std::vector<bool> &out_is_core_node)
@@ -618,52 +882,62 @@ class GraphContractor
         out_node_levels.swap(node_levels);
     }
 
-    template <class Edge> inline void GetEdges(util::DeallocatingVector<Edge> &edges)
+    // The edges of the nodes are written by all threads, at offsets counted from their degrees
+    template <class Edge> inline void GetEdges(util::ChunkedVector<Edge> &edges)
     {
-        util::Percent p(contractor_graph->GetNumberOfNodes());
         util::SimpleLogger().Write() << "Getting edges of minimized graph";
         const NodeID number_of_nodes = contractor_graph->GetNumberOfNodes();
-        if (contractor_graph->GetNumberOfNodes())
+        std::vector<std::size_t> offsets(number_of_nodes + 1, edges.size());
+        for (const auto node : util::irange(0u, number_of_nodes))
         {
-            Edge new_edge;
-            for (const auto node : util::irange(0u, number_of_nodes))
-            {
-                p.PrintStatus(node);
-                for (auto edge : contractor_graph->GetAdjacentEdgeRange(node))
+            offsets[node + 1] = offsets[node] + contractor_graph->GetOutDegree(node);
+        }
+        edges.resize(offsets.back());
+
+        tbb::parallel_for(
+            tbb::blocked_range<NodeID>(0, number_of_nodes),
+            [&](const tbb::blocked_range<NodeID> &range) {
+                Edge new_edge;
+                for (auto node = range.begin(); node != range.end(); ++node)
                 {
-                    const NodeID target = contractor_graph->GetTarget(edge);
-                    const ContractorGraph::EdgeData &data = contractor_graph->GetEdgeData(edge);
-                    if (!orig_node_id_from_new_node_id_map.empty())
-                    {
-                        new_edge.source = orig_node_id_from_new_node_id_map[node];
-                        new_edge.target = orig_node_id_from_new_node_id_map[target];
-                    }
-                    else
-                    {
-                        new_edge.source = node;
-                        new_edge.target = target;
-                    }
-                    BOOST_ASSERT_MSG(SPECIAL_NODEID != new_edge.source, "Source id invalid");
-                    BOOST_ASSERT_MSG(SPECIAL_NODEID != new_edge.target, "Target id invalid");
-                    new_edge.data.distance = data.distance;
-                    new_edge.data.shortcut = data.shortcut;
-                    if (!data.is_original_via_node_ID && !orig_node_id_from_new_node_id_map.empty())
-                    {
-                        // tranlate the _node id_ of the shortcutted node
-                        new_edge.data.id = orig_node_id_from_new_node_id_map[data.id];
-                    }
-                    else
+                    auto position = offsets[node];
+                    for (auto edge : contractor_graph->GetAdjacentEdgeRange(node))
                     {
-                        new_edge.data.id = data.id;
+                        const NodeID target = contractor_graph->GetTarget(edge);
+                        const ContractorGraph::EdgeData &data = contractor_graph->GetEdgeData(edge);
+                        if (!orig_node_id_from_new_node_id_map.empty())
+                        {
+                            new_edge.source = orig_node_id_from_new_node_id_map[node];
+                            new_edge.target = orig_node_id_from_new_node_id_map[target];
+                        }
+                        else
+                        {
+                            new_edge.source = node;
+                            new_edge.target = target;
+                        }
+                        BOOST_ASSERT_MSG(SPECIAL_NODEID != new_edge.source, "Source id invalid");
+                        BOOST_ASSERT_MSG(SPECIAL_NODEID != new_edge.target, "Target id invalid");
+                        new_edge.data.distance = data.distance;
+                        new_edge.data.length = data.length;
+                        new_edge.data.shortcut = data.shortcut;
+                        if (!data.is_original_via_node_ID &&
+                            !orig_node_id_from_new_node_id_map.empty())
+                        {
+                            // tranlate the _node id_ of the shortcutted node
+                            new_edge.data.id = orig_node_id_from_new_node_id_map[data.id];
+                        }
+                        else
+                        {
+                            new_edge.data.id = data.id;
+                        }
+                        BOOST_ASSERT_MSG(new_edge.data.id != INT_MAX, // 2^31
+                                         "edge id invalid");
+                        new_edge.data.forward = data.forward;
+                        new_edge.data.backward = data.backward;
+                        edges[position++] = new_edge;
                     }
-                    BOOST_ASSERT_MSG(new_edge.data.id != INT_MAX, // 2^31
-                                     "edge id invalid");
-                    new_edge.data.forward = data.forward;
-                    new_edge.data.backward = data.backward;
-                    edges.push_back(new_edge);
                 }
-            }
-        }
+            });
         contractor_graph.reset();
         orig_node_id_from_new_node_id_map.clear();
         orig_node_id_from_new_node_id_map.shrink_to_fit();
@@ -678,9 +952,14 @@ class GraphContractor
     inline void RelaxNode(const NodeID node,
                           const NodeID forbidden_node,
                           const int distance,
+                          const short max_hops,
                           ContractorHeap &heap)
     {
         const short current_hop = heap.GetData(node).hop + 1;
+        if (current_hop > max_hops)
+        {
+            return;
+        }
         for (auto edge : contractor_graph->GetAdjacentEdgeRange(node))
         {
             const ContractorEdgeData &data = contractor_graph->GetEdgeData(edge);
@@ -698,13 +977,14 @@ class GraphContractor
             // New Node discovered -> Add to Heap + Node Info Storage
             if (!heap.WasInserted(to))
             {
-                heap.Insert(to, to_distance, ContractorHeapData{current_hop, false});
+                heap.Insert(to, to_distance, ContractorHeapData{current_hop, false, node});
             }
             // Found a shorter Path -> Update distance
             else if (to_distance < heap.GetKey(to))
             {
                 heap.DecreaseKey(to, to_distance);
                 heap.GetData(to).hop = current_hop;
+                heap.GetData(to).parent = node;
             }
         }
     }
@@ -712,6 +992,7 @@ class GraphContractor
     inline void Dijkstra(const int max_distance,
                          const unsigned number_of_targets,
                          const int max_nodes,
+                         const short max_hops,
                          ContractorThreadData &data,
                          const NodeID middle_node)
     {
@@ -743,7 +1024,7 @@ class GraphContractor
                 }
             }
 
-            RelaxNode(node, middle_node, distance, heap);
+            RelaxNode(node, middle_node, distance, max_hops, heap);
         }
     }
 
@@ -786,6 +1067,18 @@ class GraphContractor
         const constexpr bool REVERSE_DIRECTION_ENABLED = true;
         const constexpr bool REVERSE_DIRECTION_DISABLED = false;
 
+        // the witnesses of the last searches are replaced by the ones of this contraction
+        const bool use_witness_cache = !witness_cache.empty();
+        WitnessCacheEntry cached_witnesses;
+        if (use_witness_cache)
+        {
+            std::swap(cached_witnesses, witness_cache[node]);
+        }
+        WitnessCacheEntry &new_witnesses =
+            use_witness_cache ? witness_cache[node] : cached_witnesses;
+        std::size_t number_of_searches = 0;
+        std::size_t number_of_cached_searches = 0;
+
         for (auto in_edge : contractor_graph->GetAdjacentEdgeRange(node))
         {
             const ContractorEdgeData &in_data = contractor_graph->GetEdgeData(in_edge);
@@ -821,6 +1114,7 @@ class GraphContractor
                     continue;
 
                 const EdgeWeight path_distance = in_data.distance + out_data.distance;
+                const float path_length = in_data.length + out_data.length;
                 if (target == source)
                 {
                     if (path_distance < node_weights[node])
@@ -847,6 +1141,7 @@ class GraphContractor
                             inserted_edges.emplace_back(source,
                                                         target,
                                                         path_distance,
+                                                        path_length,
                                                         out_data.originalEdges +
                                                             in_data.originalEdges,
                                                         node,
@@ -857,6 +1152,7 @@ class GraphContractor
                             inserted_edges.emplace_back(target,
                                                         source,
                                                         path_distance,
+                                                        path_length,
                                                         out_data.originalEdges +
                                                             in_data.originalEdges,
                                                         node,
@@ -875,16 +1171,40 @@ class GraphContractor
                 }
             }
 
+            ++number_of_searches;
+            if (use_witness_cache &&
+                ReuseWitnesses(node, source, in_data.distance, cached_witnesses, new_witnesses))
+            {
+                // every target has a witness, so no shortcuts are needed
+                ++number_of_cached_searches;
+                continue;
+            }
+
             if (RUNSIMULATION)
             {
-                const int constexpr SIMULATION_SEARCH_SPACE_SIZE = 1000;
-                Dijkstra(
-                    max_distance, number_of_targets, SIMULATION_SEARCH_SPACE_SIZE, *data, node);
+                Dijkstra(max_distance,
+                         number_of_targets,
+                         witness_search_config.simulation_settled_nodes,
+                         witness_hop_limit,
+                         *data,
+                         node);
             }
             else
             {
-                const int constexpr FULL_SEARCH_SPACE_SIZE = 2000;
-                Dijkstra(max_distance, number_of_targets, FULL_SEARCH_SPACE_SIZE, *data, node);
+                Dijkstra(max_distance,
+                         number_of_targets,
+                         witness_search_config.contraction_settled_nodes,
+                         witness_hop_limit,
+                         *data,
+                         node);
+            }
+            if (use_witness_cache)
+            {
+                new_witnesses.searches.push_back({source,
+                                                  static_cast<std::uint32_t>(
+                                                      new_witnesses.witnesses.size()),
+                                                  static_cast<std::uint32_t>(
+                                                      new_witnesses.witness_nodes.size())});
             }
             for (auto out_edge : contractor_graph->GetAdjacentEdgeRange(node))
             {
@@ -897,6 +1217,7 @@ class GraphContractor
                 if (target == node)
                     continue;
                 const int path_distance = in_data.distance + out_data.distance;
+                const float path_length = in_data.length + out_data.length;
                 const int distance = heap.GetKey(target);
                 if (path_distance < distance)
                 {
@@ -912,6 +1233,7 @@ class GraphContractor
                         inserted_edges.emplace_back(source,
                                                     target,
                                                     path_distance,
+                                                    path_length,
                                                     out_data.originalEdges + in_data.originalEdges,
                                                     node,
                                                     SHORTCUT_ARC,
@@ -921,6 +1243,7 @@ class GraphContractor
                         inserted_edges.emplace_back(target,
                                                     source,
                                                     path_distance,
+                                                    path_length,
                                                     out_data.originalEdges + in_data.originalEdges,
                                                     node,
                                                     SHORTCUT_ARC,
@@ -928,10 +1251,38 @@ class GraphContractor
                                                     REVERSE_DIRECTION_ENABLED);
                     }
                 }
+                else if (use_witness_cache && target != source)
+                {
+                    new_witnesses.witnesses.emplace_back(target, distance);
+                    for (NodeID via = heap.GetData(target).parent; via != source;
+                         via = heap.GetData(via).parent)
+                    {
+                        new_witnesses.witness_nodes.push_back(via);
+                    }
+                }
             }
         }
-        // Check For One-Way Streets to decide on the creation of self-loops
 
+        if (use_witness_cache)
+        {
+            if (RUNSIMULATION)
+            {
+                new_witnesses.searches.push_back(
+                    {SPECIAL_NODEID,
+                     static_cast<std::uint32_t>(new_witnesses.witnesses.size()),
+                     static_cast<std::uint32_t>(new_witnesses.witness_nodes.size())});
+            }
+            else
+            {
+                // the node is gone, no need to keep its witnesses
+                new_witnesses = WitnessCacheEntry{};
+            }
+            number_of_witness_searches.fetch_add(number_of_searches, std::memory_order_relaxed);
+            number_of_cached_witness_searches.fetch_add(number_of_cached_searches,
+                                                        std::memory_order_relaxed);
+        }
+
+        // Check For One-Way Streets to decide on the creation of self-loops
         if (!RUNSIMULATION)
         {
             std::size_t iend = inserted_edges.size();
@@ -952,6 +1303,10 @@ class GraphContractor
                     {
                         continue;
                     }
+                    if (inserted_edges[other].data.length != inserted_edges[i].data.length)
+                    {
+                        continue;
+                    }
                     if (inserted_edges[other].data.shortcut != inserted_edges[i].data.shortcut)
                     {
                         continue;
@@ -971,6 +1326,138 @@ class GraphContractor
         return true;
     }
 
+    // Copies the cached search from the source to the new witnesses if it still has a witness
+    // for every target of the node
+    inline bool ReuseWitnesses(const NodeID node,
+                               const NodeID source,
+                               const EdgeWeight in_distance,
+                               const WitnessCacheEntry &cached_witnesses,
+                               WitnessCacheEntry &new_witnesses) const
+    {
+        const auto &searches = cached_witnesses.searches;
+        if (searches.empty())
+        {
+            return false;
+        }
+        const auto search = std::find_if(searches.begin(),
+                                         searches.end() - 1,
+                                         [source](const WitnessCacheEntry::Search &search) {
+                                             return search.source == source;
+                                         });
+        if (search == searches.end() - 1)
+        {
+            return false;
+        }
+
+        const auto witnesses_begin = cached_witnesses.witnesses.begin() + search->first_witness;
+        const auto witnesses_end =
+            cached_witnesses.witnesses.begin() + std::next(search)->first_witness;
+        const auto witness_nodes_begin =
+            cached_witnesses.witness_nodes.begin() + search->first_witness_node;
+        const auto witness_nodes_end =
+            cached_witnesses.witness_nodes.begin() + std::next(search)->first_witness_node;
+
+        if (std::any_of(witness_nodes_begin, witness_nodes_end, [this](const NodeID via) {
+                return is_contracted_node[via] != 0;
+            }))
+        {
+            return false;
+        }
+
+        for (auto out_edge : contractor_graph->GetAdjacentEdgeRange(node))
+        {
+            const ContractorEdgeData &out_data = contractor_graph->GetEdgeData(out_edge);
+            const NodeID target = contractor_graph->GetTarget(out_edge);
+            if (!out_data.forward || target == node || target == source)
+            {
+                continue;
+            }
+            const EdgeWeight path_distance = in_distance + out_data.distance;
+            const bool has_witness = std::any_of(
+                witnesses_begin, witnesses_end, [target, path_distance](const auto &witness) {
+                    return witness.first == target && witness.second <= path_distance;
+                });
+            if (!has_witness)
+            {
+                return false;
+            }
+        }
+
+        new_witnesses.searches.push_back(
+            {source,
+             static_cast<std::uint32_t>(new_witnesses.witnesses.size()),
+             static_cast<std::uint32_t>(new_witnesses.witness_nodes.size())});
+        new_witnesses.witnesses.insert(
+            new_witnesses.witnesses.end(), witnesses_begin, witnesses_end);
+        new_witnesses.witness_nodes.insert(
+            new_witnesses.witness_nodes.end(), witness_nodes_begin, witness_nodes_end);
+        return true;
+    }
+
+    // Of the new shortcuts in the same directions between the same nodes only the shortest is
+    // kept. It replaces the data of an existing shortcut in these directions if it is shorter
+    // and is dropped otherwise, only edges to new targets or in new directions are left. The
+    // new edges are sorted by all of this, so neither the order the threads added them in nor
+    // the order of the adjacency lists, which a resumed contraction doesn't restore, matter.
+    inline void UpdateParallelShortcuts(std::vector<ContractorEdge> &inserted_edges)
+    {
+        const auto key = [](const ContractorEdge &edge) {
+            return std::make_tuple(edge.source,
+                                   edge.target,
+                                   static_cast<bool>(edge.data.forward),
+                                   static_cast<bool>(edge.data.backward),
+                                   edge.data.distance);
+        };
+        tbb::parallel_sort(inserted_edges.begin(),
+                           inserted_edges.end(),
+                           [&key](const ContractorEdge &lhs, const ContractorEdge &rhs) {
+                               return key(lhs) < key(rhs);
+                           });
+        inserted_edges.erase(std::unique(inserted_edges.begin(),
+                                         inserted_edges.end(),
+                                         [](const ContractorEdge &lhs, const ContractorEdge &rhs) {
+                                             return lhs.source == rhs.source &&
+                                                    lhs.target == rhs.target &&
+                                                    lhs.data.forward == rhs.data.forward &&
+                                                    lhs.data.backward == rhs.data.backward;
+                                         }),
+                             inserted_edges.end());
+
+        // every existing edge is updated by at most one new edge
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, inserted_edges.size()),
+            [this, &inserted_edges](const tbb::blocked_range<std::size_t> &range) {
+                for (auto index = range.begin(), end = range.end(); index != end; ++index)
+                {
+                    ContractorEdge &edge = inserted_edges[index];
+                    for (const auto current_edge :
+                         contractor_graph->GetAdjacentEdgeRange(edge.source))
+                    {
+                        ContractorGraph::EdgeData &current_data =
+                            contractor_graph->GetEdgeData(current_edge);
+                        if (contractor_graph->GetTarget(current_edge) == edge.target &&
+                            current_data.shortcut && current_data.forward == edge.data.forward &&
+                            current_data.backward == edge.data.backward)
+                        {
+                            if (edge.data.distance < current_data.distance)
+                            {
+                                current_data = edge.data;
+                            }
+                            edge.target = SPECIAL_NODEID;
+                            break;
+                        }
+                    }
+                }
+            });
+
+        inserted_edges.erase(std::remove_if(inserted_edges.begin(),
+                                            inserted_edges.end(),
+                                            [](const ContractorEdge &edge) {
+                                                return edge.target == SPECIAL_NODEID;
+                                            }),
+                             inserted_edges.end());
+    }
+
     inline void DeleteIncomingEdges(ContractorThreadData *data, const NodeID node)
     {
         std::vector<NodeID> &neighbours = data->neighbours;
@@ -1089,6 +1576,181 @@ class GraphContractor
         return true;
     }
 
+    // Hop limit of the witness searches for the average degree of the remaining nodes
+    short GetWitnessHopLimit(const std::vector<RemainingNodeData> &remaining_nodes) const
+    {
+        const auto &hop_limits = witness_search_config.hop_limits;
+        if (hop_limits.empty() || remaining_nodes.empty())
+        {
+            return std::numeric_limits<short>::max();
+        }
+
+        std::size_t degree_sum = 0;
+        for (const auto &node : remaining_nodes)
+        {
+            degree_sum += contractor_graph->GetOutDegree(node.id);
+        }
+        const double average_degree = static_cast<double>(degree_sum) / remaining_nodes.size();
+        const auto limit = std::find_if(
+            hop_limits.begin(), hop_limits.end(), [average_degree](const auto &limit) {
+                return average_degree < limit.first;
+            });
+        return limit == hop_limits.end() ? std::numeric_limits<short>::max() : limit->second;
+    }
+
+    // Written to a temporary file that replaces the last checkpoint once it is complete, so an
+    // interruption while writing keeps the last checkpoint
+    void WriteCheckpoint(const std::string &path,
+                         CheckpointHeader header,
+                         const std::vector<RemainingNodeData> &remaining_nodes,
+                         const std::vector<float> &node_priorities,
+                         const std::vector<NodeDepth> &node_depth) const
+    {
+        TIMER_START(checkpoint);
+        const util::PhaseTrace::ScopedPhase phase("write checkpoint");
+        const auto temporary_path = path + ".tmp";
+        std::ofstream stream(temporary_path, std::ios::binary);
+
+        header.input_checksum = input_checksum;
+        util::writeFingerprint(stream);
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        util::serializeVector(stream, remaining_nodes);
+        util::serializeVector(stream, node_priorities);
+        util::serializeVector(stream, node_depth);
+        util::serializeVector(stream, node_levels);
+        util::serializeVector(stream, node_weights);
+        util::serializeVector(stream, orig_node_id_from_new_node_id_map);
+
+        // the edges of the remaining graph in blocks, by source node
+        std::uint64_t number_of_edges = 0;
+        for (const auto node : util::irange(0u, contractor_graph->GetNumberOfNodes()))
+        {
+            number_of_edges += contractor_graph->GetOutDegree(node);
+        }
+        stream.write(reinterpret_cast<const char *>(&number_of_edges), sizeof(number_of_edges));
+        const constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+        std::vector<ContractorEdge> block;
+        block.reserve(BLOCK_SIZE);
+        const auto write_block = [&stream, &block] {
+            stream.write(reinterpret_cast<const char *>(block.data()),
+                         block.size() * sizeof(ContractorEdge));
+            block.clear();
+        };
+        for (const auto node : util::irange(0u, contractor_graph->GetNumberOfNodes()))
+        {
+            for (const auto edge : contractor_graph->GetAdjacentEdgeRange(node))
+            {
+                block.emplace_back(
+                    node, contractor_graph->GetTarget(edge), contractor_graph->GetEdgeData(edge));
+                if (block.size() == BLOCK_SIZE)
+                {
+                    write_block();
+                }
+            }
+        }
+        write_block();
+        util::serializeVector(stream, external_edge_list);
+
+        stream.close();
+        if (!stream)
+        {
+            throw util::exception("Could not write the contraction checkpoint " + temporary_path);
+        }
+        boost::filesystem::rename(temporary_path, path);
+        TIMER_STOP(checkpoint);
+        util::SimpleLogger().Write() << "wrote a checkpoint of round " << header.current_level
+                                     << " to " << path << " in " << TIMER_SEC(checkpoint) << "s";
+    }
+
+    // Restores the state of the checkpoint and returns true, or returns false without changing
+    // anything if there is no checkpoint of this input and build. Throws if it can't be read.
+    bool ReadCheckpoint(const std::string &path,
+                        const NodeID number_of_nodes,
+                        const bool use_cached_node_priorities,
+                        CheckpointHeader &header,
+                        std::vector<RemainingNodeData> &remaining_nodes,
+                        std::vector<float> &node_priorities,
+                        std::vector<NodeDepth> &node_depth)
+    {
+        if (!boost::filesystem::exists(path))
+        {
+            util::SimpleLogger().Write() << "No contraction checkpoint at " << path
+                                         << ", contracting from the start";
+            return false;
+        }
+
+        std::ifstream stream(path, std::ios::binary);
+        if (!util::readAndCheckFingerprint(stream))
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "The contraction checkpoint " << path
+                << " was written by a different build, contracting from the start";
+            return false;
+        }
+        stream.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (!stream || header.input_checksum != input_checksum ||
+            header.number_of_nodes != number_of_nodes ||
+            (header.use_cached_node_priorities != 0) != use_cached_node_priorities)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "The contraction checkpoint " << path
+                << " is of a different input, contracting from the start";
+            return false;
+        }
+
+        TIMER_START(checkpoint);
+        const util::PhaseTrace::ScopedPhase phase("read checkpoint");
+        const auto failed = [&path] {
+            return util::exception("Could not read the contraction checkpoint " + path);
+        };
+        if (!util::deserializeVector(stream, remaining_nodes) ||
+            !util::deserializeVector(stream, node_priorities) ||
+            !util::deserializeVector(stream, node_depth) ||
+            !util::deserializeVector(stream, node_levels) ||
+            !util::deserializeVector(stream, node_weights) ||
+            !util::deserializeVector(stream, orig_node_id_from_new_node_id_map))
+        {
+            throw failed();
+        }
+
+        // the graph of the input is replaced by the remaining graph
+        contractor_graph.reset();
+        std::uint64_t number_of_edges = 0;
+        stream.read(reinterpret_cast<char *>(&number_of_edges), sizeof(number_of_edges));
+        std::vector<ContractorEdge> edges(number_of_edges);
+        stream.read(reinterpret_cast<char *>(edges.data()),
+                    number_of_edges * sizeof(ContractorEdge));
+
+        std::uint64_t number_of_external_edges = 0;
+        stream.read(reinterpret_cast<char *>(&number_of_external_edges),
+                    sizeof(number_of_external_edges));
+        external_edge_list.clear();
+        std::vector<QueryEdge> block(64 * 1024);
+        while (stream && number_of_external_edges > 0)
+        {
+            const auto block_size = std::min<std::uint64_t>(number_of_external_edges, block.size());
+            stream.read(reinterpret_cast<char *>(block.data()), block_size * sizeof(QueryEdge));
+            for (std::uint64_t index = 0; index < block_size; ++index)
+            {
+                external_edge_list.push_back(block[index]);
+            }
+            number_of_external_edges -= block_size;
+        }
+        if (!stream)
+        {
+            throw failed();
+        }
+
+        // the edges of a node are only sorted by target in the input graph
+        tbb::parallel_sort(edges.begin(), edges.end());
+        contractor_graph = std::make_shared<ContractorGraph>(header.number_of_graph_nodes, edges);
+        TIMER_STOP(checkpoint);
+        util::SimpleLogger().Write() << "read the checkpoint of round " << header.current_level
+                                     << " from " << path << " in " << TIMER_SEC(checkpoint)
+                                     << "s";
+        return true;
+    }
+
     // This bias function takes up 22 assembly instructions in total on X86
     inline bool Bias(const NodeID a, const NodeID b) const
     {
@@ -1117,6 +1779,21 @@ class GraphContractor
     std::vector<EdgeWeight> node_weights;
     std::vector<bool> is_core_node;
     util::XORFastHash<> fast_hash;
+
+    // CRC-32C of the merged input edges, node weights and cached levels, checkpoints of other
+    // inputs are not resumed
+    std::uint32_t input_checksum = 0;
+
+    WitnessSearchConfig witness_search_config;
+    // hop limit of the witness searches of the current round
+    short witness_hop_limit = std::numeric_limits<short>::max();
+    // witnesses of the last searches by node, empty if the cache is disabled
+    std::vector<WitnessCacheEntry> witness_cache;
+    // marks the nodes contracted since the last flush for the witness cache, not a vector<bool>
+    // since it is written in parallel
+    std::vector<std::uint8_t> is_contracted_node;
+    std::atomic<std::size_t> number_of_witness_searches{0};
+    std::atomic<std::size_t> number_of_cached_witness_searches{0};
 };
 }
 }
@@ -0,0 +1,472 @@
+#ifndef GRAPH_RECUSTOMIZER_HPP
+#define GRAPH_RECUSTOMIZER_HPP
+
+#include "contractor/query_edge.hpp"
+#include "util/chunked_vector.hpp"
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+#include "util/simple_logger.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Updates the weights of a contracted graph after the weights of the edge-based graph changed,
+// without contracting it again.
+//
+// The node order and the shortcuts of the previous contraction are kept. Original edges get
+// their new weights and every shortcut is recomputed as the shortest of its lower triangles,
+// i.e. the paths u -> v -> w over a node v below u and w. Processing the nodes bottom-up, level
+// by level, makes sure the edges of a triangle are final before it is used. All nodes of a
+// level are independent and handled in parallel.
+//
+// There are no witness searches, so routes stay valid and their weights exact. But a shortcut
+// that was not needed for the old weights is not added for the new ones, so a query can miss a
+// shortest path if a witness path of the previous contraction got slower.
+class GraphRecustomizer
+{
+  public:
+    // Takes the edges of a contracted graph as they are stored in the .hsgr: every edge is
+    // stored at its lower ranked node and edges between two core nodes at both.
+    template <class EdgeContainerT>
+    GraphRecustomizer(const NodeID number_of_nodes,
+                      const EdgeContainerT &contracted_edges,
+                      std::vector<bool> is_core_node_)
+        : is_core_node(std::move(is_core_node_))
+    {
+        if (!is_core_node.empty() && is_core_node.size() != number_of_nodes)
+        {
+            throw util::exception("Core markers don't match the contracted graph");
+        }
+
+        // edges in both directions get separate weights
+        edges.reserve(contracted_edges.size());
+        for (const auto &edge : contracted_edges)
+        {
+            BOOST_ASSERT(edge.source < number_of_nodes && edge.target < number_of_nodes);
+            if (edge.data.forward)
+            {
+                edges.push_back(edge);
+                edges.back().data.backward = false;
+            }
+            if (edge.data.backward)
+            {
+                edges.push_back(edge);
+                edges.back().data.forward = false;
+            }
+        }
+        tbb::parallel_sort(edges.begin(), edges.end());
+
+        first_edge.resize(number_of_nodes + 1, 0);
+        for (const auto &edge : edges)
+        {
+            ++first_edge[edge.source + 1];
+        }
+        std::partial_sum(first_edge.begin(), first_edge.end(), first_edge.begin());
+    }
+
+    // Applies the weights of the edge-based graph the previous contraction was computed from.
+    // Returns the number of original edges whose weight changed; if there were none, the
+    // shortcuts are left alone.
+    template <class EdgeBasedEdgeContainerT>
+    std::size_t Run(const EdgeBasedEdgeContainerT &edge_based_edges)
+    {
+        const std::size_t number_of_changed_edges = UpdateOriginalEdges(edge_based_edges);
+        util::SimpleLogger().Write() << number_of_changed_edges << " original edges changed";
+        if (number_of_changed_edges == 0)
+        {
+            return 0;
+        }
+
+        const auto levels = ComputeLevels();
+        util::SimpleLogger().Write() << "Recustomizing " << edges.size() << " edges in "
+                                     << levels.size() - 1 << " levels";
+
+        // weight and middle node of the best triangle of each shortcut, packed so that both
+        // are updated at once and the result does not depend on the order of the updates
+        std::vector<std::atomic<std::uint64_t>> best_triangles(edges.size());
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, edges.size()),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              for (auto edge = range.begin(); edge != range.end(); ++edge)
+                              {
+                                  best_triangles[edge].store(NO_TRIANGLE,
+                                                             std::memory_order_relaxed);
+                              }
+                          });
+
+        std::atomic<std::size_t> number_of_unsupported_shortcuts{0};
+        const auto finalizeNodes = [&](const NodeID *nodes_begin, const NodeID *nodes_end) {
+            tbb::parallel_for(tbb::blocked_range<const NodeID *>(nodes_begin, nodes_end),
+                              [&](const tbb::blocked_range<const NodeID *> &range) {
+                                  for (const NodeID node : range)
+                                  {
+                                      number_of_unsupported_shortcuts.fetch_add(
+                                          FinalizeShortcuts(node, best_triangles),
+                                          std::memory_order_relaxed);
+                                  }
+                              });
+        };
+
+        for (const auto level : util::irange<std::size_t>(0, levels.size() - 1))
+        {
+            const NodeID *level_begin = level_nodes.data() + levels[level];
+            const NodeID *level_end = level_nodes.data() + levels[level + 1];
+
+            // everything below this level is final, so are the edges of its nodes
+            finalizeNodes(level_begin, level_end);
+
+            tbb::parallel_for(tbb::blocked_range<const NodeID *>(level_begin, level_end),
+                              [&](const tbb::blocked_range<const NodeID *> &range) {
+                                  for (const NodeID node : range)
+                                  {
+                                      RelaxTriangles(node, best_triangles);
+                                  }
+                              });
+        }
+        // the core is never contracted, its nodes have no triangles of their own
+        std::vector<NodeID> core_nodes;
+        for (const auto node : util::irange<NodeID>(0, is_core_node.size()))
+        {
+            if (is_core_node[node])
+            {
+                core_nodes.push_back(node);
+            }
+        }
+        finalizeNodes(core_nodes.data(), core_nodes.data() + core_nodes.size());
+
+        if (number_of_unsupported_shortcuts > 0)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << number_of_unsupported_shortcuts
+                << " shortcuts have no triangle in the hierarchy and keep their weight";
+        }
+
+        return number_of_changed_edges;
+    }
+
+    // Edges in the .hsgr layout, directions with the same data are merged again
+    template <class Edge> void GetEdges(util::ChunkedVector<Edge> &out_edges)
+    {
+        for (std::size_t index = 0; index < edges.size(); ++index)
+        {
+            Edge new_edge(edges[index].source, edges[index].target, edges[index].data);
+            if (index + 1 < edges.size() &&
+                std::tie(edges[index].source, edges[index].target) ==
+                    std::tie(edges[index + 1].source, edges[index + 1].target) &&
+                IsSameEdge(edges[index].data, edges[index + 1].data))
+            {
+                new_edge.data.forward = true;
+                new_edge.data.backward = true;
+                ++index;
+            }
+            out_edges.push_back(new_edge);
+        }
+        edges.clear();
+        edges.shrink_to_fit();
+        first_edge.clear();
+        first_edge.shrink_to_fit();
+    }
+
+  private:
+    static constexpr std::uint64_t NO_TRIANGLE = std::numeric_limits<std::uint64_t>::max();
+
+    struct EdgeWeightAndLength
+    {
+        NodeID source;
+        NodeID target;
+        EdgeWeight weight;
+        float length;
+
+        bool operator<(const EdgeWeightAndLength &other) const
+        {
+            return std::tie(source, target, weight) <
+                   std::tie(other.source, other.target, other.weight);
+        }
+    };
+
+    static bool IsSameEdge(const QueryEdge::EdgeData &lhs, const QueryEdge::EdgeData &rhs)
+    {
+        return lhs.forward != rhs.forward && lhs.id == rhs.id && lhs.shortcut == rhs.shortcut &&
+               lhs.distance == rhs.distance && lhs.length == rhs.length;
+    }
+
+    bool IsCoreNode(const NodeID node) const
+    {
+        return !is_core_node.empty() && is_core_node[node];
+    }
+
+    // source and target of the path an edge represents
+    static std::pair<NodeID, NodeID> GetPath(const QueryEdge &edge)
+    {
+        return edge.data.forward ? std::make_pair(edge.source, edge.target)
+                                 : std::make_pair(edge.target, edge.source);
+    }
+
+    // Parallel edges are merged like in the GraphContractor: the smallest weight wins.
+    template <class EdgeBasedEdgeContainerT>
+    std::size_t UpdateOriginalEdges(const EdgeBasedEdgeContainerT &edge_based_edges)
+    {
+        std::vector<EdgeWeightAndLength> new_weights;
+        new_weights.reserve(edge_based_edges.size());
+        for (const auto &edge : edge_based_edges)
+        {
+            const EdgeWeight weight = std::max(edge.weight, 1);
+            if (edge.forward)
+            {
+                new_weights.push_back({edge.source, edge.target, weight, edge.length});
+            }
+            if (edge.backward)
+            {
+                new_weights.push_back({edge.target, edge.source, weight, edge.length});
+            }
+        }
+        tbb::parallel_sort(new_weights.begin(), new_weights.end());
+
+        std::atomic<std::size_t> number_of_changed_edges{0};
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, edges.size()),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                std::size_t changed = 0;
+                for (auto index = range.begin(); index != range.end(); ++index)
+                {
+                    auto &data = edges[index].data;
+                    if (data.shortcut)
+                    {
+                        continue;
+                    }
+
+                    const auto path = GetPath(edges[index]);
+                    const EdgeWeightAndLength key{path.first, path.second, 0, 0};
+                    const auto new_weight =
+                        std::lower_bound(new_weights.begin(), new_weights.end(), key);
+                    if (new_weight == new_weights.end() || new_weight->source != path.first ||
+                        new_weight->target != path.second)
+                    {
+                        throw util::exception("Edge " + std::to_string(path.first) + " -> " +
+                                              std::to_string(path.second) +
+                                              " of the contracted graph is missing in the "
+                                              "edge-based graph, contract it again");
+                    }
+                    if (data.distance != new_weight->weight)
+                    {
+                        data.distance = new_weight->weight;
+                        data.length = new_weight->length;
+                        ++changed;
+                    }
+                }
+                number_of_changed_edges.fetch_add(changed, std::memory_order_relaxed);
+            });
+
+        return number_of_changed_edges;
+    }
+
+    // The node order is implied by the edges, which all point upwards from their source. The
+    // level of a node is the length of the longest chain of edges below it, so two nodes of the
+    // same level are never adjacent. Fills level_nodes with all non-core nodes sorted by level
+    // and returns the offsets of the levels in it.
+    std::vector<std::size_t> ComputeLevels()
+    {
+        const NodeID number_of_nodes = first_edge.size() - 1;
+
+        std::vector<unsigned> number_of_lower_nodes(number_of_nodes, 0);
+        for (const auto &edge : edges)
+        {
+            if (edge.source != edge.target && !IsCoreNode(edge.source))
+            {
+                ++number_of_lower_nodes[edge.target];
+            }
+        }
+
+        std::vector<unsigned> node_level(number_of_nodes, 0);
+        std::vector<NodeID> queue;
+        for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+        {
+            if (number_of_lower_nodes[node] == 0 && !IsCoreNode(node))
+            {
+                queue.push_back(node);
+            }
+        }
+        // the queue is processed in topological order and ends up as the processing order
+        for (std::size_t index = 0; index < queue.size(); ++index)
+        {
+            const NodeID node = queue[index];
+            for (const auto edge : util::irange(first_edge[node], first_edge[node + 1]))
+            {
+                const NodeID target = edges[edge].target;
+                if (target == node)
+                {
+                    continue;
+                }
+                node_level[target] = std::max(node_level[target], node_level[node] + 1);
+                if (--number_of_lower_nodes[target] == 0 && !IsCoreNode(target))
+                {
+                    queue.push_back(target);
+                }
+            }
+        }
+
+        const std::size_t number_of_core_nodes =
+            std::count(is_core_node.begin(), is_core_node.end(), true);
+        if (queue.size() + number_of_core_nodes != number_of_nodes)
+        {
+            throw util::exception("Contracted graph has no valid node order, contract it again");
+        }
+
+        std::stable_sort(queue.begin(), queue.end(), [&](const NodeID lhs, const NodeID rhs) {
+            return node_level[lhs] < node_level[rhs];
+        });
+        std::vector<std::size_t> levels;
+        for (const auto index : util::irange<std::size_t>(0, queue.size()))
+        {
+            if (index == 0 || node_level[queue[index]] != node_level[queue[index - 1]])
+            {
+                levels.push_back(index);
+            }
+        }
+        levels.push_back(queue.size());
+
+        level_nodes = std::move(queue);
+        return levels;
+    }
+
+    // Lowers the best triangle of all shortcuts from -> to to the path over middle
+    void RelaxShortcuts(const NodeID from,
+                        const NodeID to,
+                        const NodeID middle,
+                        const EdgeWeight weight,
+                        std::vector<std::atomic<std::uint64_t>> &best_triangles) const
+    {
+        const std::uint64_t triangle = (static_cast<std::uint64_t>(weight) << 32) | middle;
+        const auto relax = [&](const NodeID node, const NodeID target, const bool forward) {
+            for (const auto edge : util::irange(first_edge[node], first_edge[node + 1]))
+            {
+                const auto &data = edges[edge].data;
+                if (edges[edge].target != target || !data.shortcut || data.forward != forward)
+                {
+                    continue;
+                }
+                auto &best = best_triangles[edge];
+                std::uint64_t current = best.load(std::memory_order_relaxed);
+                while (triangle < current &&
+                       !best.compare_exchange_weak(current, triangle, std::memory_order_relaxed))
+                {
+                }
+            }
+        };
+        // the shortcut is stored at its lower node, or at both if they are in the core
+        relax(from, to, true);
+        relax(to, from, false);
+    }
+
+    void RelaxTriangles(const NodeID node,
+                        std::vector<std::atomic<std::uint64_t>> &best_triangles) const
+    {
+        for (const auto in_edge : util::irange(first_edge[node], first_edge[node + 1]))
+        {
+            const auto &in_data = edges[in_edge].data;
+            const NodeID from = edges[in_edge].target;
+            if (!in_data.backward || from == node)
+            {
+                continue;
+            }
+
+            for (const auto out_edge : util::irange(first_edge[node], first_edge[node + 1]))
+            {
+                const auto &out_data = edges[out_edge].data;
+                const NodeID to = edges[out_edge].target;
+                if (!out_data.forward || to == node)
+                {
+                    continue;
+                }
+                RelaxShortcuts(
+                    from, to, node, in_data.distance + out_data.distance, best_triangles);
+            }
+        }
+    }
+
+    // Sets weight, middle node and length of the shortcuts stored at a node from their best
+    // triangle. Returns the number of shortcuts without any triangle.
+    std::size_t FinalizeShortcuts(const NodeID node,
+                                  const std::vector<std::atomic<std::uint64_t>> &best_triangles)
+    {
+        std::size_t number_of_unsupported_shortcuts = 0;
+        for (const auto edge : util::irange(first_edge[node], first_edge[node + 1]))
+        {
+            auto &data = edges[edge].data;
+            if (!data.shortcut)
+            {
+                continue;
+            }
+            const std::uint64_t triangle = best_triangles[edge].load(std::memory_order_relaxed);
+            if (triangle == NO_TRIANGLE)
+            {
+                ++number_of_unsupported_shortcuts;
+                continue;
+            }
+
+            const EdgeWeight weight = static_cast<EdgeWeight>(triangle >> 32);
+            const NodeID middle = static_cast<NodeID>(triangle & 0xffffffff);
+            const auto path = GetPath(edges[edge]);
+            data.distance = weight;
+            data.id = middle;
+            data.length = GetTriangleLength(path.first, middle, path.second, weight);
+        }
+        return number_of_unsupported_shortcuts;
+    }
+
+    // Length of the path from -> middle -> to over the edges at middle that add up to weight
+    float GetTriangleLength(const NodeID from,
+                            const NodeID middle,
+                            const NodeID to,
+                            const EdgeWeight weight) const
+    {
+        for (const auto in_edge : util::irange(first_edge[middle], first_edge[middle + 1]))
+        {
+            const auto &in_data = edges[in_edge].data;
+            if (!in_data.backward || edges[in_edge].target != from)
+            {
+                continue;
+            }
+            for (const auto out_edge : util::irange(first_edge[middle], first_edge[middle + 1]))
+            {
+                const auto &out_data = edges[out_edge].data;
+                if (out_data.forward && edges[out_edge].target == to &&
+                    in_data.distance + out_data.distance == weight)
+                {
+                    return in_data.length + out_data.length;
+                }
+            }
+        }
+        BOOST_ASSERT_MSG(false, "best triangle not found");
+        return 0;
+    }
+
+    std::vector<QueryEdge> edges;
+    std::vector<std::size_t> first_edge;
+    std::vector<bool> is_core_node;
+    // all non-core nodes in processing order
+    std::vector<NodeID> level_nodes;
+};
+}
+}
+
+#endif // GRAPH_RECUSTOMIZER_HPP
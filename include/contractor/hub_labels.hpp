@@ -0,0 +1,273 @@
+#ifndef HUB_LABELS_HPP
+#define HUB_LABELS_HPP
+
+#include "util/integer_range.hpp"
+#include "util/simple_logger.hpp"
+#include "util/typedefs.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Hub labels of all nodes of a contracted graph, which answer a query by intersecting the
+// forward label of the source with the backward label of the target (see engine/hub_labels.hpp).
+//
+// The label of node v in direction d is at offsets[2 * v + d] up to offsets[2 * v + d + 1],
+// forward labels being direction 0. Every label is sorted by hub.
+struct HubLabels
+{
+    std::vector<std::uint64_t> offsets;
+    std::vector<NodeID> hubs;
+    std::vector<EdgeWeight> weights;
+};
+
+namespace detail
+{
+using LabelEntry = std::pair<NodeID, EdgeWeight>;
+using Label = std::vector<LabelEntry>;
+
+// The upward edges of the contracted graph, at the node the search relaxes them from
+struct UpwardGraph
+{
+    struct Edge
+    {
+        NodeID target;
+        EdgeWeight weight;
+        bool forward;
+        bool backward;
+    };
+
+    std::vector<std::size_t> first_edge;
+    std::vector<Edge> edges;
+};
+
+template <class EdgeContainerT>
+UpwardGraph buildUpwardGraph(const EdgeContainerT &contracted_edges, const NodeID number_of_nodes)
+{
+    UpwardGraph graph;
+    graph.first_edge.resize(number_of_nodes + 1, 0);
+    for (const auto &edge : contracted_edges)
+    {
+        if (edge.source != edge.target)
+        {
+            ++graph.first_edge[edge.source + 1];
+        }
+    }
+    std::partial_sum(graph.first_edge.begin(), graph.first_edge.end(), graph.first_edge.begin());
+
+    auto next_edge = graph.first_edge;
+    graph.edges.resize(graph.first_edge.back());
+    for (const auto &edge : contracted_edges)
+    {
+        if (edge.source != edge.target)
+        {
+            graph.edges[next_edge[edge.source]++] = {
+                edge.target, edge.data.distance, edge.data.forward, edge.data.backward};
+        }
+    }
+    return graph;
+}
+
+// The distance of the two labels through their common hubs
+inline EdgeWeight queryLabels(const Label &forward, const Label &backward)
+{
+    EdgeWeight distance = INVALID_EDGE_WEIGHT;
+    auto forward_entry = forward.begin();
+    auto backward_entry = backward.begin();
+    while (forward_entry != forward.end() && backward_entry != backward.end())
+    {
+        if (forward_entry->first == backward_entry->first)
+        {
+            distance = std::min(distance, forward_entry->second + backward_entry->second);
+            ++forward_entry;
+            ++backward_entry;
+        }
+        else if (forward_entry->first < backward_entry->first)
+        {
+            ++forward_entry;
+        }
+        else
+        {
+            ++backward_entry;
+        }
+    }
+    return distance;
+}
+
+// The depth of every node below the top of the hierarchy: 0 for nodes without upward edges,
+// otherwise one more than the deepest node above. The labels of a depth only depend on the
+// labels of the depths before it.
+inline std::vector<std::uint32_t> computeDepths(const UpwardGraph &graph)
+{
+    const std::size_t number_of_nodes = graph.first_edge.size() - 1;
+    const auto unvisited = std::numeric_limits<std::uint32_t>::max();
+    std::vector<std::uint32_t> depths(number_of_nodes, unvisited);
+
+    // depth-first, a node is done once all nodes above it are
+    std::vector<std::pair<NodeID, std::size_t>> stack;
+    for (const auto start : util::irange<NodeID>(0, number_of_nodes))
+    {
+        if (depths[start] != unvisited)
+        {
+            continue;
+        }
+        depths[start] = 0;
+        stack.emplace_back(start, graph.first_edge[start]);
+        while (!stack.empty())
+        {
+            auto &top = stack.back();
+            const NodeID node = top.first;
+            if (top.second == graph.first_edge[node + 1])
+            {
+                std::uint32_t depth = 0;
+                for (auto edge = graph.first_edge[node]; edge < graph.first_edge[node + 1]; ++edge)
+                {
+                    depth = std::max(depth, depths[graph.edges[edge].target] + 1);
+                }
+                depths[node] = depth;
+                stack.pop_back();
+                continue;
+            }
+            const NodeID target = graph.edges[top.second++].target;
+            if (depths[target] == unvisited)
+            {
+                depths[target] = 0;
+                stack.emplace_back(target, graph.first_edge[target]);
+            }
+        }
+    }
+    return depths;
+}
+
+// The label of the node from the labels of the nodes above it, without the hubs that another
+// hub of the label covers with a shorter distance
+inline Label computeLabel(const UpwardGraph &graph,
+                          const NodeID node,
+                          const bool forward,
+                          const std::vector<Label> &forward_labels,
+                          const std::vector<Label> &backward_labels)
+{
+    const auto &labels = forward ? forward_labels : backward_labels;
+
+    Label label{{node, 0}};
+    for (auto edge = graph.first_edge[node]; edge < graph.first_edge[node + 1]; ++edge)
+    {
+        const auto &data = graph.edges[edge];
+        if (forward ? data.forward : data.backward)
+        {
+            for (const auto &entry : labels[data.target])
+            {
+                label.emplace_back(entry.first, entry.second + data.weight);
+            }
+        }
+    }
+    // the shortest entry of every hub comes first
+    std::sort(label.begin(), label.end());
+    label.erase(std::unique(label.begin(),
+                            label.end(),
+                            [](const LabelEntry &lhs, const LabelEntry &rhs) {
+                                return lhs.first == rhs.first;
+                            }),
+                label.end());
+
+    // The unpruned label finds the distance to every hub, so an entry above that distance is
+    // not on a shortest path. Entries that are on one are never pruned.
+    Label pruned_label;
+    pruned_label.reserve(label.size());
+    for (const auto &entry : label)
+    {
+        const auto distance = entry.first == node
+                                  ? entry.second
+                                  : forward ? queryLabels(label, backward_labels[entry.first])
+                                            : queryLabels(forward_labels[entry.first], label);
+        if (entry.second <= distance)
+        {
+            pruned_label.push_back(entry);
+        }
+    }
+    return pruned_label;
+}
+}
+
+// Pruned hub labels from the order of the contraction hierarchy: the label of a node is made of
+// itself and the labels of the nodes above it, so the labels are computed from the top of the
+// hierarchy down, the nodes of the same depth in parallel.
+//
+// Only correct for a fully contracted graph, the uncontracted core has no order.
+template <class EdgeContainerT>
+HubLabels computeHubLabels(const EdgeContainerT &contracted_edges, const NodeID number_of_nodes)
+{
+    const auto graph = detail::buildUpwardGraph(contracted_edges, number_of_nodes);
+    const auto depths = detail::computeDepths(graph);
+
+    std::vector<NodeID> nodes_by_depth(number_of_nodes);
+    std::iota(nodes_by_depth.begin(), nodes_by_depth.end(), 0);
+    std::stable_sort(nodes_by_depth.begin(),
+                     nodes_by_depth.end(),
+                     [&](const NodeID lhs, const NodeID rhs) { return depths[lhs] < depths[rhs]; });
+
+    std::vector<detail::Label> forward_labels(number_of_nodes);
+    std::vector<detail::Label> backward_labels(number_of_nodes);
+    for (auto depth_begin = nodes_by_depth.begin(); depth_begin != nodes_by_depth.end();)
+    {
+        const auto depth = depths[*depth_begin];
+        const auto depth_end = std::find_if(
+            depth_begin, nodes_by_depth.end(), [&](const NodeID node) {
+                return depths[node] != depth;
+            });
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, depth_end - depth_begin),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              for (auto index = range.begin(); index != range.end(); ++index)
+                              {
+                                  const NodeID node = *(depth_begin + index);
+                                  forward_labels[node] = detail::computeLabel(
+                                      graph, node, true, forward_labels, backward_labels);
+                                  backward_labels[node] = detail::computeLabel(
+                                      graph, node, false, forward_labels, backward_labels);
+                              }
+                          });
+        depth_begin = depth_end;
+    }
+
+    HubLabels result;
+    result.offsets.reserve(std::size_t{2} * number_of_nodes + 1);
+    result.offsets.push_back(0);
+    for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+    {
+        for (const auto *label : {&forward_labels[node], &backward_labels[node]})
+        {
+            for (const auto &entry : *label)
+            {
+                result.hubs.push_back(entry.first);
+                result.weights.push_back(entry.second);
+            }
+            result.offsets.push_back(result.hubs.size());
+        }
+        // freed as they are copied, they take most of the memory
+        detail::Label().swap(forward_labels[node]);
+        detail::Label().swap(backward_labels[node]);
+    }
+
+    util::SimpleLogger().Write() << "Computed hub labels with "
+                                 << (number_of_nodes > 0
+                                         ? result.hubs.size() / (2. * number_of_nodes)
+                                         : 0.)
+                                 << " hubs per label on average";
+    return result;
+}
+}
+}
+
+#endif // HUB_LABELS_HPP
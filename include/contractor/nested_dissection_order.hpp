@@ -0,0 +1,160 @@
+#ifndef OSRM_CONTRACTOR_NESTED_DISSECTION_ORDER_HPP
+#define OSRM_CONTRACTOR_NESTED_DISSECTION_ORDER_HPP
+
+#include "contractor/query_edge.hpp"
+#include "partition/multi_level_partition.hpp"
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Priorities of a nested dissection order for GraphContractor, which contracts the nodes of
+// cached priorities from the lowest to the highest without updating them.
+//
+// The cells of the multi-level partition are separated by the edges between them. A node gets
+// the highest level at which it has an edge to another cell, plus one, so the nodes inside the
+// cells of level 0 come first and the nodes at the cuts of the top level last. Every cell is
+// contracted independently of the other cells of its level, which keeps the hierarchy flat and
+// the late rounds wide. Within a level, the nodes with fewer edges come first.
+//
+// The order only depends on the partition and the topology, so it holds for any weights.
+template <typename EdgeContainerT>
+std::vector<float> computeNestedDissectionOrder(const partition::MultiLevelPartition &partition,
+                                                const EdgeContainerT &edges)
+{
+    const NodeID number_of_nodes = partition.GetNumberOfNodes();
+    std::vector<partition::LevelID> separator_levels(number_of_nodes, 0);
+    std::vector<std::uint32_t> degrees(number_of_nodes, 0);
+    for (const auto &edge : edges)
+    {
+        BOOST_ASSERT(edge.source < number_of_nodes && edge.target < number_of_nodes);
+        const auto level = partition.GetCommonLevel(edge.source, edge.target);
+        separator_levels[edge.source] = std::max(separator_levels[edge.source], level);
+        separator_levels[edge.target] = std::max(separator_levels[edge.target], level);
+        ++degrees[edge.source];
+        ++degrees[edge.target];
+    }
+
+    // the degree only orders the nodes of one level, so it stays below one
+    const float MAX_DEGREE = 1000;
+    std::vector<float> priorities(number_of_nodes);
+    for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+    {
+        priorities[node] = separator_levels[node] +
+                           std::min<float>(degrees[node], MAX_DEGREE) / (MAX_DEGREE + 1);
+    }
+    return priorities;
+}
+
+struct SearchSpaceSizes
+{
+    std::size_t number_of_samples;
+    double average;
+    std::size_t maximum;
+};
+
+// The number of nodes the upward search from a node can reach in the contracted graph, for the
+// nodes of an even sample. This is the search space of a query without pruning and stalling, an
+// upper bound of the nodes it settles that doesn't depend on the weights.
+template <typename EdgeContainerT>
+SearchSpaceSizes computeSearchSpaceSizes(const EdgeContainerT &contracted_edges,
+                                         const NodeID number_of_nodes,
+                                         const std::size_t number_of_samples)
+{
+    if (number_of_nodes == 0)
+    {
+        return SearchSpaceSizes{0, 0., 0};
+    }
+
+    // the upward edges in forward direction by their source
+    std::vector<std::size_t> first_edges(number_of_nodes + 1, 0);
+    for (const auto &edge : contracted_edges)
+    {
+        if (edge.data.forward)
+        {
+            ++first_edges[edge.source + 1];
+        }
+    }
+    for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+    {
+        first_edges[node + 1] += first_edges[node];
+    }
+    std::vector<NodeID> targets(first_edges.back());
+    {
+        auto positions = first_edges;
+        for (const auto &edge : contracted_edges)
+        {
+            if (edge.data.forward)
+            {
+                targets[positions[edge.source]++] = edge.target;
+            }
+        }
+    }
+
+    const auto samples = std::min<std::size_t>(number_of_samples, number_of_nodes);
+    std::vector<std::size_t> sizes(samples);
+    struct SearchData
+    {
+        // the sample that reached a node last
+        std::vector<std::size_t> visited;
+        std::vector<NodeID> stack;
+    };
+    tbb::enumerable_thread_specific<SearchData> search_data;
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, samples),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          auto &data = search_data.local();
+                          if (data.visited.empty())
+                          {
+                              data.visited.resize(number_of_nodes, samples);
+                          }
+                          for (auto sample = range.begin(); sample != range.end(); ++sample)
+                          {
+                              const NodeID start = sample * number_of_nodes / samples;
+                              data.visited[start] = sample;
+                              data.stack.assign(1, start);
+                              std::size_t size = 0;
+                              while (!data.stack.empty())
+                              {
+                                  const NodeID node = data.stack.back();
+                                  data.stack.pop_back();
+                                  ++size;
+                                  for (auto edge = first_edges[node]; edge < first_edges[node + 1];
+                                       ++edge)
+                                  {
+                                      if (data.visited[targets[edge]] != sample)
+                                      {
+                                          data.visited[targets[edge]] = sample;
+                                          data.stack.push_back(targets[edge]);
+                                      }
+                                  }
+                              }
+                              sizes[sample] = size;
+                          }
+                      });
+
+    SearchSpaceSizes result{samples, 0., 0};
+    for (const auto size : sizes)
+    {
+        result.average += static_cast<double>(size) / samples;
+        result.maximum = std::max(result.maximum, size);
+    }
+    return result;
+}
+}
+}
+
+#endif // OSRM_CONTRACTOR_NESTED_DISSECTION_ORDER_HPP
@@ -0,0 +1,122 @@
+#ifndef OSRM_CONTRACTOR_NODE_RENUMBERING_HPP
+#define OSRM_CONTRACTOR_NODE_RENUMBERING_HPP
+
+#include "contractor/query_edge.hpp"
+#include "util/chunked_vector.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Orders the nodes of the contracted graph for the locality of the queries.
+//
+// The core comes first, then the contracted nodes from the highest to the lowest level, in
+// classes whose range of levels doubles from one class to the next. Within a class the nodes
+// follow the order of the r-tree leaves, which are sorted by the Hilbert value of their
+// segments. The upward searches of a query settle few high nodes, which share a few pages of the
+// node and edge arrays this way, and the many low nodes close to the start and the target are
+// close in memory as well.
+//
+// Takes the level of every node, empty if they aren't known, and the rank of every node in the
+// r-tree. Returns the new id of every node.
+inline std::vector<NodeID> computeNodeRenumbering(const std::vector<float> &node_levels,
+                                                  const std::vector<bool> &is_core_node,
+                                                  const std::vector<NodeID> &spatial_ranks)
+{
+    const NodeID number_of_nodes = spatial_ranks.size();
+    BOOST_ASSERT(node_levels.empty() || node_levels.size() == number_of_nodes);
+    BOOST_ASSERT(is_core_node.empty() || is_core_node.size() == number_of_nodes);
+
+    const auto level_class = [&](const NodeID node) -> std::uint32_t {
+        if (!is_core_node.empty() && is_core_node[node])
+        {
+            return 0;
+        }
+        if (node_levels.empty())
+        {
+            return 1;
+        }
+        // floor(log2(level + 1)), the highest levels get the lowest classes
+        auto level = static_cast<std::uint32_t>(std::max(0.f, node_levels[node])) + 1;
+        std::uint32_t log_level = 0;
+        while (level >>= 1)
+        {
+            ++log_level;
+        }
+        return 1 + 32 - log_level;
+    };
+
+    // the ids break ties between nodes that aren't in the r-tree
+    std::vector<std::tuple<std::uint32_t, NodeID, NodeID>> keys(number_of_nodes);
+    tbb::parallel_for(tbb::blocked_range<NodeID>(0, number_of_nodes),
+                      [&](const tbb::blocked_range<NodeID> &range) {
+                          for (auto node = range.begin(); node != range.end(); ++node)
+                          {
+                              keys[node] =
+                                  std::make_tuple(level_class(node), spatial_ranks[node], node);
+                          }
+                      });
+    tbb::parallel_sort(keys.begin(), keys.end());
+
+    std::vector<NodeID> new_ids(number_of_nodes);
+    for (NodeID position = 0; position < number_of_nodes; ++position)
+    {
+        new_ids[std::get<2>(keys[position])] = position;
+    }
+    return new_ids;
+}
+
+inline std::vector<NodeID> invertNodeRenumbering(const std::vector<NodeID> &new_ids)
+{
+    std::vector<NodeID> old_ids(new_ids.size());
+    for (NodeID node = 0; node < new_ids.size(); ++node)
+    {
+        BOOST_ASSERT(new_ids[node] < new_ids.size());
+        old_ids[new_ids[node]] = node;
+    }
+    return old_ids;
+}
+
+// Moves the edges of a contracted graph to the new ids, including the middle nodes of shortcuts
+inline void renumberContractedEdges(util::ChunkedVector<QueryEdge> &edges,
+                                    const std::vector<NodeID> &new_ids)
+{
+    for (auto &edge : edges)
+    {
+        edge.source = new_ids[edge.source];
+        edge.target = new_ids[edge.target];
+        if (edge.data.shortcut)
+        {
+            edge.data.id = new_ids[edge.data.id];
+        }
+    }
+}
+
+inline std::vector<bool> renumberCoreMarker(const std::vector<bool> &is_core_node,
+                                            const std::vector<NodeID> &new_ids)
+{
+    std::vector<bool> renumbered(is_core_node.size(), false);
+    for (NodeID node = 0; node < is_core_node.size(); ++node)
+    {
+        renumbered[new_ids[node]] = is_core_node[node];
+    }
+    return renumbered;
+}
+}
+}
+
+#endif // OSRM_CONTRACTOR_NODE_RENUMBERING_HPP
@@ -0,0 +1,251 @@
+#ifndef OSRM_CONTRACTOR_QUERY_GRAPH_HPP
+#define OSRM_CONTRACTOR_QUERY_GRAPH_HPP
+
+#include "contractor/query_edge.hpp"
+#include "util/integer_range.hpp"
+#include "util/prefetch.hpp"
+#include "util/shared_memory_vector_wrapper.hpp"
+#include "util/static_graph.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <utility>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// The .hsgr stores the edges of the contracted graph in two arrays. The first one holds what a
+// search needs to relax an edge, eight of them share a cache line. The second one holds what is
+// only needed to unpack a path.
+struct QueryEdgeSearchData
+{
+    NodeID target;
+    int distance : 30;
+    bool forward : 1;
+    bool backward : 1;
+};
+
+struct QueryEdgeUnpackData
+{
+    NodeID id : 31;
+    bool shortcut : 1;
+    // length in meters of all original edges this edge represents
+    float length;
+};
+
+static_assert(sizeof(QueryEdgeSearchData) == 8, "QueryEdgeSearchData needs to be 8 bytes big");
+static_assert(sizeof(QueryEdgeUnpackData) == 8, "QueryEdgeUnpackData needs to be 8 bytes big");
+
+inline QueryEdgeSearchData getSearchData(const NodeID target, const QueryEdge::EdgeData &data)
+{
+    QueryEdgeSearchData search_data;
+    search_data.target = target;
+    search_data.distance = data.distance;
+    search_data.forward = data.forward;
+    search_data.backward = data.backward;
+    return search_data;
+}
+
+inline QueryEdgeUnpackData getUnpackData(const QueryEdge::EdgeData &data)
+{
+    QueryEdgeUnpackData unpack_data;
+    unpack_data.id = data.id;
+    unpack_data.shortcut = data.shortcut;
+    unpack_data.length = data.length;
+    return unpack_data;
+}
+
+inline QueryEdge::EdgeData getEdgeData(const QueryEdgeSearchData &search_data,
+                                       const QueryEdgeUnpackData &unpack_data)
+{
+    QueryEdge::EdgeData data;
+    data.id = unpack_data.id;
+    data.shortcut = unpack_data.shortcut;
+    data.distance = search_data.distance;
+    data.forward = search_data.forward;
+    data.backward = search_data.backward;
+    data.length = unpack_data.length;
+    return data;
+}
+
+using QueryGraphNode = util::StaticGraph<QueryEdge::EdgeData>::NodeArrayEntry;
+
+// The arrays of a QueryGraph that a search reads, without owning them. The data facades hand it
+// out once per search step, so the loops over the edges of a node are inlined instead of calling
+// through the facade for every edge. Only valid as long as the facade doesn't reload its data.
+//
+// On large graphs most of a search waits for the node and edge entries of the nodes it settles
+// to come from memory. With prefetching the searches load them into the cache before they are
+// read, while other nodes are processed.
+class QueryGraphView
+{
+  public:
+    using EdgeRange = util::range<EdgeID>;
+
+    QueryGraphView()
+        : number_of_nodes(0), node_array(nullptr), search_edge_array(nullptr), prefetching(false)
+    {
+    }
+
+    QueryGraphView(const NodeID number_of_nodes,
+                   const QueryGraphNode *node_array,
+                   const QueryEdgeSearchData *search_edge_array,
+                   const bool prefetching = false)
+        : number_of_nodes(number_of_nodes), node_array(node_array),
+          search_edge_array(search_edge_array), prefetching(prefetching)
+    {
+    }
+
+    NodeID GetNumberOfNodes() const { return number_of_nodes; }
+
+    bool IsPrefetching() const { return prefetching; }
+
+    // the entry the edge range of the node is read from
+    void PrefetchNode(const NodeID n) const
+    {
+        BOOST_ASSERT(n < number_of_nodes);
+        util::prefetch(&node_array[n]);
+    }
+
+    // the first cache line of the edges of the node, which holds eight of them
+    void PrefetchEdges(const NodeID n) const
+    {
+        util::prefetch(search_edge_array + BeginEdges(n));
+    }
+
+    NodeID GetTarget(const EdgeID e) const { return search_edge_array[e].target; }
+
+    const QueryEdgeSearchData &GetSearchData(const EdgeID e) const
+    {
+        return search_edge_array[e];
+    }
+
+    EdgeID BeginEdges(const NodeID n) const
+    {
+        BOOST_ASSERT(n < number_of_nodes);
+        return node_array[n].first_edge;
+    }
+
+    EdgeID EndEdges(const NodeID n) const
+    {
+        BOOST_ASSERT(n < number_of_nodes);
+        return node_array[n + 1].first_edge;
+    }
+
+    EdgeRange GetAdjacentEdgeRange(const NodeID n) const
+    {
+        return util::irange(BeginEdges(n), EndEdges(n));
+    }
+
+  private:
+    NodeID number_of_nodes;
+    const QueryGraphNode *node_array;
+    const QueryEdgeSearchData *search_edge_array;
+    bool prefetching;
+};
+
+// The contracted graph as it is stored in the .hsgr, with the same interface as a StaticGraph.
+// GetEdgeData combines both edge arrays, searches only need GetSearchData.
+template <bool UseSharedMemory> class QueryGraph
+{
+  public:
+    using NodeArrayEntry = QueryGraphNode;
+    using EdgeRange = util::range<EdgeID>;
+
+    QueryGraph(typename util::ShM<NodeArrayEntry, UseSharedMemory>::vector &nodes,
+               typename util::ShM<QueryEdgeSearchData, UseSharedMemory>::vector &search_edges,
+               typename util::ShM<QueryEdgeUnpackData, UseSharedMemory>::vector &unpack_edges)
+    {
+        BOOST_ASSERT(search_edges.size() == unpack_edges.size());
+        number_of_nodes = static_cast<decltype(number_of_nodes)>(nodes.size() - 1);
+        number_of_edges = static_cast<decltype(number_of_edges)>(search_edges.size());
+
+        using std::swap;
+        swap(node_array, nodes);
+        swap(search_edge_array, search_edges);
+        swap(unpack_edge_array, unpack_edges);
+    }
+
+    unsigned GetNumberOfNodes() const { return number_of_nodes; }
+
+    unsigned GetNumberOfEdges() const { return number_of_edges; }
+
+    unsigned GetOutDegree(const NodeID n) const { return EndEdges(n) - BeginEdges(n); }
+
+    QueryGraphView GetView(const bool prefetching = false) const
+    {
+        return QueryGraphView(number_of_nodes,
+                              &node_array[0],
+                              number_of_edges == 0 ? nullptr : &search_edge_array[0],
+                              prefetching);
+    }
+
+    NodeID GetTarget(const EdgeID e) const { return search_edge_array[e].target; }
+
+    const QueryEdgeSearchData &GetSearchData(const EdgeID e) const
+    {
+        return search_edge_array[e];
+    }
+
+    QueryEdge::EdgeData GetEdgeData(const EdgeID e) const
+    {
+        return getEdgeData(search_edge_array[e], unpack_edge_array[e]);
+    }
+
+    EdgeID BeginEdges(const NodeID n) const { return EdgeID(node_array.at(n).first_edge); }
+
+    EdgeID EndEdges(const NodeID n) const { return EdgeID(node_array.at(n + 1).first_edge); }
+
+    EdgeRange GetAdjacentEdgeRange(const NodeID node) const
+    {
+        return util::irange(BeginEdges(node), EndEdges(node));
+    }
+
+    // searches for a specific edge
+    EdgeID FindEdge(const NodeID from, const NodeID to) const
+    {
+        for (const auto i : GetAdjacentEdgeRange(from))
+        {
+            if (to == search_edge_array[i].target)
+            {
+                return i;
+            }
+        }
+        return SPECIAL_EDGEID;
+    }
+
+    EdgeID FindEdgeInEitherDirection(const NodeID from, const NodeID to) const
+    {
+        EdgeID tmp = FindEdge(from, to);
+        return (SPECIAL_NODEID != tmp ? tmp : FindEdge(to, from));
+    }
+
+    EdgeID FindEdgeIndicateIfReverse(const NodeID from, const NodeID to, bool &result) const
+    {
+        EdgeID current_iterator = FindEdge(from, to);
+        if (SPECIAL_NODEID == current_iterator)
+        {
+            current_iterator = FindEdge(to, from);
+            if (SPECIAL_NODEID != current_iterator)
+            {
+                result = true;
+            }
+        }
+        return current_iterator;
+    }
+
+  private:
+    NodeID number_of_nodes;
+    EdgeID number_of_edges;
+
+    typename util::ShM<NodeArrayEntry, UseSharedMemory>::vector node_array;
+    typename util::ShM<QueryEdgeSearchData, UseSharedMemory>::vector search_edge_array;
+    typename util::ShM<QueryEdgeUnpackData, UseSharedMemory>::vector unpack_edge_array;
+};
+}
+}
+
+#endif // OSRM_CONTRACTOR_QUERY_GRAPH_HPP
@@ -0,0 +1,112 @@
+#ifndef OSRM_CONTRACTOR_UPDATE_LOOKUPS_HPP
+#define OSRM_CONTRACTOR_UPDATE_LOOKUPS_HPP
+
+#include "util/typedefs.hpp"
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// The speeds and turn penalties of --segment-speed-file and --turn-penalty-file, sorted by
+// their OSM node ids for binary searches.
+//
+// A file is either CSV with a line per value, or the binary format the values of a CSV file are
+// converted to once by osrm-convert-lookup, which is read without parsing. The files are
+// numbered from one in the order they are given, a value of a later file takes precedence over
+// the values of earlier files.
+//
+// CSV files are memory mapped and parsed in chunks on all threads, so a single large file is
+// parsed in parallel as well.
+
+struct Segment final
+{
+    OSMNodeID from, to;
+};
+
+struct SpeedSource final
+{
+    unsigned speed;
+    std::uint8_t source;
+};
+
+struct SegmentSpeedSource final
+{
+    Segment segment;
+    SpeedSource speed_source;
+};
+
+struct Turn final
+{
+    OSMNodeID from, via, to;
+};
+
+struct PenaltySource final
+{
+    double penalty;
+    std::uint8_t source;
+};
+
+struct TurnPenaltySource final
+{
+    Turn turn;
+    PenaltySource penalty_source;
+};
+
+inline bool operator<(const Segment &lhs, const Segment &rhs)
+{
+    return std::tie(lhs.from, lhs.to) < std::tie(rhs.from, rhs.to);
+}
+
+inline bool operator==(const Segment &lhs, const Segment &rhs)
+{
+    return std::tie(lhs.from, lhs.to) == std::tie(rhs.from, rhs.to);
+}
+
+inline bool operator<(const Turn &lhs, const Turn &rhs)
+{
+    return std::tie(lhs.from, lhs.via, lhs.to) < std::tie(rhs.from, rhs.via, rhs.to);
+}
+
+inline bool operator==(const Turn &lhs, const Turn &rhs)
+{
+    return std::tie(lhs.from, lhs.via, lhs.to) == std::tie(rhs.from, rhs.via, rhs.to);
+}
+
+// sorted by their segment, each segment once
+using SegmentSpeedLookup = std::vector<SegmentSpeedSource>;
+// sorted by their turn, each turn once
+using TurnPenaltyLookup = std::vector<TurnPenaltySource>;
+
+// nullptr if there is no speed for the segment
+const SpeedSource *find(const SegmentSpeedLookup &lookup, const Segment &segment);
+// nullptr if there is no penalty for the turn
+const PenaltySource *find(const TurnPenaltyLookup &lookup, const Turn &turn);
+
+// Look up many keys at once, the values are nullptr for keys that are not in the lookup. The
+// keys are sorted and merged with the lookup in a single pass, which gallops over the entries
+// between two keys instead of searching the whole lookup for every key.
+void find(const SegmentSpeedLookup &lookup,
+          const std::vector<Segment> &segments,
+          std::vector<const SpeedSource *> &speeds);
+void find(const TurnPenaltyLookup &lookup,
+          const std::vector<Turn> &turns,
+          std::vector<const PenaltySource *> &penalties);
+
+// Reads the files, throws if one can't be read or is malformed. Within a CSV file the first
+// speed of a segment and the last penalty of a turn are used.
+SegmentSpeedLookup readSegmentSpeedFiles(const std::vector<std::string> &filenames);
+TurnPenaltyLookup readTurnPenaltyFiles(const std::vector<std::string> &filenames);
+
+// Write the values in the binary format, their sources are not stored
+void writeSegmentSpeedFile(const std::string &filename, const SegmentSpeedLookup &lookup);
+void writeTurnPenaltyFile(const std::string &filename, const TurnPenaltyLookup &lookup);
+}
+}
+
+#endif // OSRM_CONTRACTOR_UPDATE_LOOKUPS_HPP
@@ -0,0 +1,107 @@
+#ifndef OSRM_CUSTOMIZER_CELL_CUSTOMIZER_HPP
+#define OSRM_CUSTOMIZER_CELL_CUSTOMIZER_HPP
+
+#include "partition/cell_storage.hpp"
+#include "util/binary_heap.hpp"
+#include "util/integer_range.hpp"
+#include "util/make_unique.hpp"
+#include "util/typedefs.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+namespace osrm
+{
+namespace customizer
+{
+
+struct CellSearchData
+{
+    CellSearchData(const NodeID parent) : parent(parent) {}
+    NodeID parent;
+};
+
+// a cell search only touches the nodes of one cell, so the heap doesn't allocate for all nodes
+using CellSearchHeap = util::BinaryHeap<NodeID,
+                                        NodeID,
+                                        EdgeWeight,
+                                        CellSearchData,
+                                        util::UnorderedMapStorage<NodeID, int>>;
+
+// Computes the weights of the metric between the sources and destinations of a cell with one
+// search from every source that stops once all destinations are settled
+template <typename GraphT>
+void customizeCell(const GraphT &graph,
+                   partition::CellStorage &storage,
+                   const std::uint32_t metric,
+                   const partition::LevelID level,
+                   const partition::CellID cell_id,
+                   CellSearchHeap &heap)
+{
+    const auto cells = storage.GetView().GetMetric(metric);
+    const auto cell = cells.GetCell(level, cell_id);
+    const auto number_of_destinations = cell.GetNumberOfDestinations();
+    EdgeWeight *weights = storage.GetWeights(level, cell_id, metric);
+
+    for (const auto source_index : util::irange<std::uint32_t>(0, cell.GetNumberOfSources()))
+    {
+        EdgeWeight *row = weights + std::size_t{source_index} * number_of_destinations;
+        std::fill(row, row + number_of_destinations, INVALID_EDGE_WEIGHT);
+        if (cells.IsExcluded(cell.GetSource(source_index)))
+        {
+            continue;
+        }
+
+        heap.Clear();
+        heap.Insert(cell.GetSource(source_index), 0, cell.GetSource(source_index));
+        std::uint32_t remaining_destinations = number_of_destinations;
+        partition::searchCell(
+            graph, cells, level, cell_id, heap, [&](const NodeID node, const EdgeWeight weight) {
+                const auto destination_index = cell.FindDestination(node);
+                if (destination_index < number_of_destinations)
+                {
+                    row[destination_index] = weight;
+                    --remaining_destinations;
+                }
+                return remaining_destinations > 0;
+            });
+    }
+}
+
+// Customizes the cells of all metrics level by level from the bottom, the cells of one level in
+// parallel
+template <typename GraphT>
+void customizeCells(const GraphT &graph, partition::CellStorage &storage)
+{
+    const auto cells = storage.GetView();
+    tbb::enumerable_thread_specific<std::unique_ptr<CellSearchHeap>> heaps;
+    for (const auto level : util::irange<partition::LevelID>(0, cells.GetNumberOfLevels()))
+    {
+        tbb::parallel_for(
+            tbb::blocked_range<partition::CellID>(0, cells.GetNumberOfCells(level)),
+            [&](const tbb::blocked_range<partition::CellID> &range) {
+                auto &heap = heaps.local();
+                if (!heap)
+                {
+                    heap = util::make_unique<CellSearchHeap>(cells.GetNumberOfNodes());
+                }
+                for (auto cell_id = range.begin(); cell_id != range.end(); ++cell_id)
+                {
+                    for (const auto metric :
+                         util::irange<std::uint32_t>(0, cells.GetNumberOfMetrics()))
+                    {
+                        customizeCell(graph, storage, metric, level, cell_id, *heap);
+                    }
+                }
+            });
+    }
+}
+}
+}
+
+#endif // OSRM_CUSTOMIZER_CELL_CUSTOMIZER_HPP
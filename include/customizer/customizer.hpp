@@ -0,0 +1,42 @@
+#ifndef OSRM_CUSTOMIZER_CUSTOMIZER_HPP
+#define OSRM_CUSTOMIZER_CUSTOMIZER_HPP
+
+#include "customizer/customizer_config.hpp"
+#include "contractor/query_graph.hpp"
+#include "partition/cell_storage.hpp"
+#include "partition/multi_level_partition.hpp"
+
+#include <vector>
+
+namespace osrm
+{
+namespace customizer
+{
+
+/// Base class of osrm-customize
+class Customizer
+{
+  public:
+    explicit Customizer(const CustomizerConfig &config_) : config{config_} {}
+
+    Customizer(const Customizer &) = delete;
+    Customizer &operator=(const Customizer &) = delete;
+
+    int Run();
+
+  private:
+    partition::MultiLevelPartition LoadPartition(const std::vector<NodeID> &renumbering) const;
+    void SetupExclusions(const std::vector<NodeID> &renumbering,
+                         partition::CellStorage &cells) const;
+    void SetupEdgeWeights(const std::vector<contractor::QueryEdgeUnpackData> &unpack_edges,
+                          partition::CellStorage &cells) const;
+    void WriteGraph(const std::vector<contractor::QueryGraphNode> &nodes,
+                    const std::vector<contractor::QueryEdgeSearchData> &search_edges,
+                    const std::vector<contractor::QueryEdgeUnpackData> &unpack_edges) const;
+
+    CustomizerConfig config;
+};
+}
+}
+
+#endif // OSRM_CUSTOMIZER_CUSTOMIZER_HPP
@@ -0,0 +1,72 @@
+#ifndef OSRM_CUSTOMIZER_CUSTOMIZER_CONFIG_HPP
+#define OSRM_CUSTOMIZER_CUSTOMIZER_CONFIG_HPP
+
+#include <boost/filesystem/path.hpp>
+
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace customizer
+{
+
+struct CustomizerConfig
+{
+    CustomizerConfig() : requested_num_threads(0) {}
+
+    // Infer the input and output names from the path of the .osrm file
+    void UseDefaultOutputNames()
+    {
+        edge_based_graph_path = osrm_input_path.string() + ".ebg";
+        edge_segment_lookup_path = osrm_input_path.string() + ".edge_segment_lookup";
+        edge_penalty_path = osrm_input_path.string() + ".edge_penalties";
+        node_based_graph_path = osrm_input_path.string() + ".nodes";
+        geometry_path = osrm_input_path.string() + ".geometry";
+        rtree_leaf_path = osrm_input_path.string() + ".fileIndex";
+        node_renumbering_path = osrm_input_path.string() + ".node_renumbering";
+        datasource_names_path = osrm_input_path.string() + ".datasource_names";
+        datasource_indexes_path = osrm_input_path.string() + ".datasource_indexes";
+        partition_path = osrm_input_path.string() + ".partition";
+        classes_path = osrm_input_path.string() + ".classes";
+        mld_graph_output_path = osrm_input_path.string() + ".mldgr";
+        cells_output_path = osrm_input_path.string() + ".cells";
+    }
+
+    boost::filesystem::path osrm_input_path;
+
+    std::string edge_based_graph_path;
+    std::string edge_segment_lookup_path;
+    std::string edge_penalty_path;
+    std::string node_based_graph_path;
+    std::string geometry_path;
+    std::string rtree_leaf_path;
+    // the new ids of the nodes, if osrm-contract renumbered them
+    std::string node_renumbering_path;
+    std::string datasource_names_path;
+    std::string datasource_indexes_path;
+    // written by osrm-partition
+    std::string partition_path;
+    // the classes of the edge-based nodes, written by osrm-extract
+    std::string classes_path;
+
+    // the edge-based graph with every edge at both of its nodes
+    std::string mld_graph_output_path;
+    // the boundary nodes of the cells and the weights between them
+    std::string cells_output_path;
+
+    unsigned requested_num_threads;
+
+    std::vector<std::string> segment_speed_lookup_paths;
+    std::vector<std::string> turn_penalty_lookup_paths;
+    // comma separated class names, every combination gets a metric without these classes
+    std::vector<std::string> exclude_classes;
+    // name=file[,file ...], the segment speeds and turn penalties of the metrics with other edge
+    // weights that queries select by name
+    std::vector<std::string> metric_segment_speed_lookups;
+    std::vector<std::string> metric_turn_penalty_lookups;
+};
+}
+}
+
+#endif // OSRM_CUSTOMIZER_CUSTOMIZER_CONFIG_HPP
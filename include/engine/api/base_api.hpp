@@ -5,11 +5,15 @@
 #include "engine/datafacade/datafacade_base.hpp"
 
 #include "engine/api/json_factory.hpp"
+#include "engine/api/pbf.hpp"
+#include "engine/api/waypoint.hpp"
 #include "engine/hint.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/range/algorithm/transform.hpp>
 
+#include <protozero/pbf_writer.hpp>
+
 #include <vector>
 
 namespace osrm
@@ -49,10 +53,34 @@ class BaseAPI
     util::json::Object MakeWaypoint(const PhantomNode &phantom) const
     {
         return json::makeWaypoint(phantom.location,
-                                  facade.GetNameForID(phantom.name_id),
+                                  facade.GetNameForID(phantom.name_id).to_string(),
                                   Hint{phantom, facade.GetCheckSum()});
     }
 
+    // Fills the waypoint of a plain result struct
+    void MakeWaypoint(const PhantomNode &phantom, Waypoint &waypoint) const
+    {
+        waypoint.location = phantom.location;
+        waypoint.name = facade.GetNameForID(phantom.name_id).to_string();
+        waypoint.hint = Hint{phantom, facade.GetCheckSum()};
+    }
+
+    // Writes the waypoint as a message with the given tag
+    void MakeWaypoint(protozero::pbf_writer &writer,
+                      const protozero::pbf_tag_type tag,
+                      const PhantomNode &phantom) const
+    {
+        protozero::pbf_writer waypoint_writer(writer, tag);
+        waypoint_writer.add_string(pbf::waypoint::HINT_TAG,
+                                   Hint{phantom, facade.GetCheckSum()}.ToCompactBase64());
+        const auto name = facade.GetNameForID(phantom.name_id);
+        waypoint_writer.add_string(pbf::waypoint::NAME_TAG, name.data(), name.size());
+        waypoint_writer.add_double(pbf::waypoint::LONGITUDE_TAG,
+                                   static_cast<double>(toFloating(phantom.location.lon)));
+        waypoint_writer.add_double(pbf::waypoint::LATITUDE_TAG,
+                                   static_cast<double>(toFloating(phantom.location.lat)));
+    }
+
     const datafacade::BaseDataFacade &facade;
     const BaseParameters &parameters;
 };
@@ -55,6 +55,14 @@ namespace api
  *              optional per coordinate
  *  - bearings: limits the search for segments in the road network to given bearing(s) in degree
  *              towards true north in clockwise direction, optional per coordinate
+ *  - debug: adds the statistics of the searches of the query to the response
+ *  - exclude: classes of the profile the routes avoid, the dataset needs a metric of
+ *             osrm-customize --exclude for the combination
+ *  - metric: the name of the edge weights of osrm-customize --metric the routes use, empty for
+ *            those of the dataset
+ *  - raw_json: puts the GeoJSON coordinates and the annotations of the response into a
+ *              json::RawJSON with their rendered text instead of an Array of Numbers, for
+ *              callers that only render the response like osrm-routed
  *
  * \see OSRM, Coordinate, Hint, Bearing, RouteParame, RouteParameters, TableParameters,
  *      NearestParameters, TripParameters, MatchParameters and TileParameters
@@ -65,6 +73,10 @@ struct BaseParameters
     std::vector<boost::optional<Hint>> hints;
     std::vector<boost::optional<double>> radiuses;
     std::vector<boost::optional<Bearing>> bearings;
+    bool debug = false;
+    std::vector<std::string> exclude;
+    std::string metric;
+    bool raw_json = false;
 
     // FIXME add validation for invalid bearing values
     bool IsValid() const
@@ -0,0 +1,94 @@
+#ifndef ENGINE_API_ISOCHRONE_API_HPP
+#define ENGINE_API_ISOCHRONE_API_HPP
+
+#include "engine/api/base_api.hpp"
+#include "engine/api/isochrone_parameters.hpp"
+
+#include "engine/api/json_factory.hpp"
+#include "engine/phantom_node.hpp"
+#include "util/coordinate.hpp"
+#include "util/integer_range.hpp"
+#include "util/json_container.hpp"
+
+#include <boost/assert.hpp>
+
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+
+class IsochroneAPI final : public BaseAPI
+{
+  public:
+    // the rings of a contour, each the outline of a polygon
+    using Contour = std::vector<std::vector<util::Coordinate>>;
+
+    IsochroneAPI(const datafacade::BaseDataFacade &facade_,
+                 const IsochroneParameters &parameters_)
+        : BaseAPI(facade_, parameters_), parameters(parameters_)
+    {
+    }
+
+    // Every contour becomes a GeoJSON MultiPolygon, in the order of the contours of the request
+    void MakeResponse(const PhantomNode &source,
+                      const std::vector<Contour> &contours,
+                      util::json::Object &response) const
+    {
+        BOOST_ASSERT(contours.size() == parameters.contours.size());
+
+        util::json::Array isochrones;
+        isochrones.values.reserve(contours.size());
+        for (const auto index : util::irange<std::size_t>(0UL, contours.size()))
+        {
+            util::json::Object isochrone;
+            isochrone.values["duration"] = parameters.contours[index];
+            isochrone.values["geometry"] = MakeGeometry(contours[index]);
+            isochrones.values.push_back(std::move(isochrone));
+        }
+
+        util::json::Array waypoints;
+        waypoints.values.push_back(MakeWaypoint(source));
+
+        response.values["code"] = "Ok";
+        response.values["isochrones"] = std::move(isochrones);
+        response.values["waypoints"] = std::move(waypoints);
+    }
+
+    const IsochroneParameters &parameters;
+
+  private:
+    util::json::Object MakeGeometry(const Contour &contour) const
+    {
+        util::json::Array polygons;
+        polygons.values.reserve(contour.size());
+        for (const auto &ring : contour)
+        {
+            // a polygon without holes has a single ring
+            util::json::Array polygon;
+            if (parameters.raw_json)
+            {
+                polygon.values.push_back(json::renderCoordinateArray(ring.begin(), ring.end()));
+            }
+            else
+            {
+                polygon.values.push_back(json::makeCoordinateArray(ring.begin(), ring.end()));
+            }
+            polygons.values.push_back(std::move(polygon));
+        }
+
+        util::json::Object geometry;
+        geometry.values["type"] = "MultiPolygon";
+        geometry.values["coordinates"] = std::move(polygons);
+        return geometry;
+    }
+};
+
+} // ns api
+} // ns engine
+} // ns osrm
+
+#endif
@@ -11,6 +11,7 @@
 #include "engine/polyline_compressor.hpp"
 #include "util/coordinate.hpp"
 #include "util/json_container.hpp"
+#include "util/json_renderer.hpp"
 
 #include <boost/optional.hpp>
 
@@ -38,36 +39,106 @@ std::string instructionModifierToString(extractor::guidance::DirectionModifier::
 
 util::json::Array coordinateToLonLat(const util::Coordinate coordinate);
 
+// Renders [{lon},{lat}] like coordinateToLonLat
+template <typename OutputT> void renderLonLat(OutputT &out, const util::Coordinate coordinate)
+{
+    out.push_back('[');
+    util::json::renderNumber(out, static_cast<double>(toFloating(coordinate.lon)));
+    out.push_back(',');
+    util::json::renderNumber(out, static_cast<double>(toFloating(coordinate.lat)));
+    out.push_back(']');
+}
+
 std::string modeToString(const extractor::TravelMode mode);
 
 } // namespace detail
 
-template <typename ForwardIter> util::json::String makePolyline(ForwardIter begin, ForwardIter end)
+template <unsigned PRECISION, typename ForwardIter>
+util::json::String makePolyline(ForwardIter begin, ForwardIter end)
+{
+    return {encodePolyline<PRECISION>(begin, end)};
+}
+
+template <typename ForwardIter, typename ToNumberT>
+util::json::Array makeNumberArray(ForwardIter begin, ForwardIter end, ToNumberT to_number)
+{
+    util::json::Array array;
+    array.values.reserve(std::distance(begin, end));
+    std::transform(begin, end, std::back_inserter(array.values), [&to_number](const auto &value) {
+        return util::json::Number(static_cast<double>(to_number(value)));
+    });
+    return array;
+}
+
+// Renders the numbers like makeNumberArray right away, instead of building an Array with a
+// Number for every value of long lists like the annotations
+template <typename ForwardIter, typename ToNumberT>
+util::json::RawJSON renderNumberArray(ForwardIter begin, ForwardIter end, ToNumberT to_number)
+{
+    util::json::RawJSON array;
+    // most values are short, like durations of a few seconds
+    array.value.reserve(std::distance(begin, end) * 8 + 2);
+    array.value.push_back('[');
+    for (auto iter = begin; iter != end; ++iter)
+    {
+        if (iter != begin)
+        {
+            array.value.push_back(',');
+        }
+        util::json::renderNumber(array.value, static_cast<double>(to_number(*iter)));
+    }
+    array.value.push_back(']');
+    return array;
+}
+
+template <typename ForwardIter>
+util::json::Array makeCoordinateArray(ForwardIter begin, ForwardIter end)
+{
+    util::json::Array array;
+    array.values.reserve(std::distance(begin, end));
+    std::transform(begin, end, std::back_inserter(array.values), &detail::coordinateToLonLat);
+    return array;
+}
+
+// Renders [[{lon},{lat}],...] like makeCoordinateArray, the geometries have thousands of
+// coordinates
+template <typename ForwardIter>
+util::json::RawJSON renderCoordinateArray(ForwardIter begin, ForwardIter end)
 {
-    return {encodePolyline(begin, end)};
+    util::json::RawJSON array;
+    array.value.reserve(std::distance(begin, end) * 24 + 2);
+    array.value.push_back('[');
+    for (auto iter = begin; iter != end; ++iter)
+    {
+        if (iter != begin)
+        {
+            array.value.push_back(',');
+        }
+        detail::renderLonLat(array.value, *iter);
+    }
+    array.value.push_back(']');
+    return array;
 }
 
+// The coordinates are an Array, or rendered into RawJSON with render_coordinates
 template <typename ForwardIter>
-util::json::Object makeGeoJSONGeometry(ForwardIter begin, ForwardIter end)
+util::json::Object
+makeGeoJSONGeometry(ForwardIter begin, ForwardIter end, const bool render_coordinates = false)
 {
     auto num_coordinates = std::distance(begin, end);
     BOOST_ASSERT(num_coordinates != 0);
     util::json::Object geojson;
-    if (num_coordinates > 1)
-    {
-        geojson.values["type"] = "LineString";
-        util::json::Array coordinates;
-        coordinates.values.reserve(num_coordinates);
-        std::transform(
-            begin, end, std::back_inserter(coordinates.values), &detail::coordinateToLonLat);
-        geojson.values["coordinates"] = std::move(coordinates);
-    }
-    else if (num_coordinates > 0)
+    if (num_coordinates > 0)
     {
-        geojson.values["type"] = "Point";
-        util::json::Array coordinates;
-        coordinates.values.push_back(detail::coordinateToLonLat(*begin));
-        geojson.values["coordinates"] = std::move(coordinates);
+        geojson.values["type"] = num_coordinates > 1 ? "LineString" : "Point";
+        if (render_coordinates)
+        {
+            geojson.values["coordinates"] = renderCoordinateArray(begin, end);
+        }
+        else
+        {
+            geojson.values["coordinates"] = makeCoordinateArray(begin, end);
+        }
     }
     return geojson;
 }
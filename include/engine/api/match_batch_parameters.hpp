@@ -0,0 +1,71 @@
+/*
+
+Copyright (c) 2016, Project OSRM contributors
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+#ifndef ENGINE_API_MATCH_BATCH_PARAMETERS_HPP
+#define ENGINE_API_MATCH_BATCH_PARAMETERS_HPP
+
+#include "engine/api/match_parameters.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+
+/**
+ * Parameters specific to the OSRM MatchBatch service.
+ *
+ * Every trace is matched on its own, like a Match query with its parameters, and the traces
+ * are matched in parallel. The route options of the traces are ignored: the result only holds
+ * the matched segments, no geometry and no steps.
+ *
+ * Holds member attributes:
+ *  - traces: the traces to match
+ *  - durations: also route between the matched points for the duration of each matching
+ *
+ * \see OSRM, MatchParameters and MatchBatchResult
+ */
+struct MatchBatchParameters
+{
+    std::vector<MatchParameters> traces;
+    bool durations = false;
+
+    bool IsValid() const
+    {
+        return std::all_of(traces.begin(), traces.end(), [](const MatchParameters &trace) {
+            return trace.IsValid();
+        });
+    }
+};
+}
+}
+}
+
+#endif // ENGINE_API_MATCH_BATCH_PARAMETERS_HPP
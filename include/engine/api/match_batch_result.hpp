@@ -0,0 +1,106 @@
+/*
+
+Copyright (c) 2016, Project OSRM contributors
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+#ifndef ENGINE_API_MATCH_BATCH_RESULT_HPP
+#define ENGINE_API_MATCH_BATCH_RESULT_HPP
+
+#include "util/coordinate.hpp"
+#include "util/typedefs.hpp"
+
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+
+/**
+ * Result of the OSRM MatchBatch service, with a MatchedTrace for every trace of the parameters.
+ *
+ * A MatchedTrace holds:
+ *  - tracepoints: one for every coordinate of the trace
+ *  - matchings: the sub matchings the trace was split into
+ *  - code, message: "Ok", or the reason if the trace could not be matched
+ *
+ * A Tracepoint holds:
+ *  - forward_segment_id, reverse_segment_id: the edge based nodes of the matched segment in the
+ *    directions it may have been traversed in, SPECIAL_NODEID if it can't be or the point was
+ *    not matched. Only points where the trace might turn around have both.
+ *  - location: the matched location on the segment
+ *  - timestamp: the timestamp of the coordinate, 0 if the trace had none
+ *  - matchings_index: the index of the matching of the point, INVALID_MATCHING if unmatched
+ *
+ * A Matching holds:
+ *  - confidence: how likely the matching is to be correct, between 0 and 1
+ *  - duration: the duration along the matched points in deci-seconds, INVALID_EDGE_WEIGHT if
+ *    durations were not requested
+ *
+ * The result is not JSON since traces are matched in bulk.
+ *
+ * \see OSRM, MatchBatchParameters
+ */
+struct MatchBatchResult
+{
+    static constexpr unsigned INVALID_MATCHING = std::numeric_limits<unsigned>::max();
+
+    struct Tracepoint
+    {
+        NodeID forward_segment_id = SPECIAL_NODEID;
+        NodeID reverse_segment_id = SPECIAL_NODEID;
+        util::Coordinate location;
+        unsigned timestamp = 0;
+        unsigned matchings_index = INVALID_MATCHING;
+    };
+
+    struct Matching
+    {
+        double confidence = 0;
+        EdgeWeight duration = INVALID_EDGE_WEIGHT;
+    };
+
+    struct MatchedTrace
+    {
+        std::vector<Tracepoint> tracepoints;
+        std::vector<Matching> matchings;
+
+        std::string code;
+        std::string message;
+    };
+
+    std::vector<MatchedTrace> traces;
+
+    std::string code;
+    std::string message;
+};
+}
+}
+}
+
+#endif // ENGINE_API_MATCH_BATCH_RESULT_HPP
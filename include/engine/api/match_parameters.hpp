@@ -30,6 +30,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "engine/api/route_parameters.hpp"
 
+#include <boost/optional.hpp>
+
 #include <vector>
 
 namespace osrm
@@ -44,6 +46,11 @@ namespace api
  *
  * Holds member attributes:
  *  - timestamps: timestamp(s) for the corresponding input coordinate(s)
+ *  - max_candidates: keep at most this many of the closest candidates of each coordinate,
+ *    0 keeps all of them
+ *  - heading_tolerance: drop candidates that are traversed in a direction that differs more
+ *    than this many degrees from the heading of the trace, unset keeps all of them
+ *  - tidy: thin out points that are close to each other before matching, see tidy::tidy
  *
  * \see OSRM, Coordinate, Hint, Bearing, RouteParame, RouteParameters, TableParameters,
  *      NearestParameters, TripParameters, MatchParameters and TileParameters
@@ -67,10 +74,15 @@ struct MatchParameters : public RouteParameters
     }
 
     std::vector<unsigned> timestamps;
+    unsigned max_candidates = 0;
+    boost::optional<unsigned> heading_tolerance;
+    bool tidy = false;
+
     bool IsValid() const
     {
         return RouteParameters::IsValid() &&
-               (timestamps.empty() || timestamps.size() == coordinates.size());
+               (timestamps.empty() || timestamps.size() == coordinates.size()) &&
+               (!heading_tolerance || *heading_tolerance <= 180);
     }
 };
 }
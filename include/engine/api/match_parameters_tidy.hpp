@@ -0,0 +1,100 @@
+#ifndef ENGINE_API_MATCH_PARAMETERS_TIDY_HPP
+#define ENGINE_API_MATCH_PARAMETERS_TIDY_HPP
+
+#include "engine/api/match_parameters.hpp"
+#include "util/coordinate_calculation.hpp"
+#include "util/integer_range.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+namespace tidy
+{
+
+// A point is dropped if it is closer than the distance to the last point that was kept, and if
+// the trace has timestamps, if it was sampled less than the duration after it
+struct Thresholds
+{
+    double distance_in_meters;
+    unsigned duration_in_seconds;
+};
+
+const constexpr Thresholds DEFAULT_THRESHOLDS{10., 5};
+
+struct Result
+{
+    // the parameters of the points that were kept
+    MatchParameters parameters;
+    // the index of every point that was kept in the original trace
+    std::vector<unsigned> original_indices;
+};
+
+// Thins out the points of traces with a high sampling rate before they are matched, like ones of
+// 10 Hz, whose points a few meters apart each add a step with candidates and transitions to the
+// hidden markov model without changing the matching. The points of a vehicle that stands still
+// merge into one point per duration, which keeps the time between the points short enough not to
+// break the matching apart. The first and the last point are always kept.
+inline Result tidy(const MatchParameters &parameters,
+                   const Thresholds thresholds = DEFAULT_THRESHOLDS)
+{
+    BOOST_ASSERT(parameters.IsValid());
+
+    Result result;
+    const auto number_of_points = parameters.coordinates.size();
+    const bool use_timestamps = !parameters.timestamps.empty();
+    std::size_t last_kept = 0;
+    for (const auto index : util::irange<std::size_t>(0, number_of_points))
+    {
+        const bool is_end = index == 0 || index + 1 == number_of_points;
+        const bool is_close =
+            util::coordinate_calculation::haversineDistance(parameters.coordinates[last_kept],
+                                                            parameters.coordinates[index]) <
+            thresholds.distance_in_meters;
+        const bool is_recent =
+            !use_timestamps || parameters.timestamps[index] - parameters.timestamps[last_kept] <
+                                   thresholds.duration_in_seconds;
+        if (is_end || !is_close || !is_recent)
+        {
+            result.original_indices.push_back(index);
+            last_kept = index;
+        }
+    }
+
+    // the options are taken over, the values of the points are those of the points kept
+    result.parameters = parameters;
+    const auto keep = [&](auto &values) {
+        if (values.empty())
+        {
+            return;
+        }
+        typename std::remove_reference<decltype(values)>::type kept_values;
+        kept_values.reserve(result.original_indices.size());
+        for (const auto index : result.original_indices)
+        {
+            kept_values.push_back(values[index]);
+        }
+        values = std::move(kept_values);
+    };
+    keep(result.parameters.coordinates);
+    keep(result.parameters.hints);
+    keep(result.parameters.radiuses);
+    keep(result.parameters.bearings);
+    keep(result.parameters.timestamps);
+    return result;
+}
+}
+}
+}
+}
+
+#endif // ENGINE_API_MATCH_PARAMETERS_TIDY_HPP
@@ -0,0 +1,73 @@
+/*
+
+Copyright (c) 2016, Project OSRM contributors
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+#ifndef ENGINE_API_MATCH_STREAM_PARAMETERS_HPP
+#define ENGINE_API_MATCH_STREAM_PARAMETERS_HPP
+
+#include "engine/api/match_parameters.hpp"
+
+#include <string>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+
+/**
+ * Parameters specific to the OSRM MatchStream service.
+ *
+ * The coordinates are the new points of a trace that is matched incrementally. The points of all
+ * requests with the same session are matched as one trace, and parts of it are returned once
+ * their matching does not change with further points anymore. A request may not have any new
+ * points, e.g. to finish the session. The timestamps have to be given for all points of a
+ * session or for none.
+ *
+ * Holds member attributes:
+ *  - session: identifies the trace the coordinates are appended to
+ *  - finish: the trace ends with the coordinates, everything that is pending is returned and
+ *    the session is removed
+ *
+ * \see OSRM, Coordinate, Hint, Bearing, RouteParame, RouteParameters, TableParameters,
+ *      NearestParameters, TripParameters, MatchParameters and TileParameters
+ */
+struct MatchStreamParameters : public MatchParameters
+{
+    std::string session;
+    bool finish = false;
+
+    bool IsValid() const
+    {
+        return !session.empty() && BaseParameters::IsValid() &&
+               (timestamps.empty() || timestamps.size() == coordinates.size());
+    }
+};
+}
+}
+}
+
+#endif // ENGINE_API_MATCH_STREAM_PARAMETERS_HPP
@@ -3,9 +3,11 @@
 
 #include "engine/api/base_api.hpp"
 #include "engine/api/nearest_parameters.hpp"
+#include "engine/api/nearest_result.hpp"
 
 #include "engine/api/json_factory.hpp"
 #include "engine/phantom_node.hpp"
+#include "util/integer_range.hpp"
 
 #include <boost/assert.hpp>
 
@@ -26,28 +28,81 @@ class NearestAPI final : public BaseAPI
     {
     }
 
+    // One coordinate is answered with its waypoints, several with a result for each of them
+    // that has its own code
     void MakeResponse(const std::vector<std::vector<PhantomNodeWithDistance>> &phantom_nodes,
                       util::json::Object &response) const
     {
-        BOOST_ASSERT(phantom_nodes.size() == 1);
-        BOOST_ASSERT(parameters.coordinates.size() == 1);
+        BOOST_ASSERT(phantom_nodes.size() == parameters.coordinates.size());
+        BOOST_ASSERT(!phantom_nodes.empty());
 
+        response.values["code"] = "Ok";
+        if (phantom_nodes.size() == 1)
+        {
+            BOOST_ASSERT(!phantom_nodes.front().empty());
+            response.values["waypoints"] = MakeWaypoints(phantom_nodes.front());
+            return;
+        }
+
+        util::json::Array results;
+        results.values.reserve(phantom_nodes.size());
+        for (const auto &coordinate_phantom_nodes : phantom_nodes)
+        {
+            util::json::Object result;
+            if (coordinate_phantom_nodes.empty())
+            {
+                result.values["code"] = "NoSegment";
+            }
+            else
+            {
+                result.values["code"] = "Ok";
+                result.values["waypoints"] = MakeWaypoints(coordinate_phantom_nodes);
+            }
+            results.values.push_back(std::move(result));
+        }
+        response.values["results"] = std::move(results);
+    }
+
+    // The same response as plain structs, with a result for each coordinate
+    void MakeResponse(const std::vector<std::vector<PhantomNodeWithDistance>> &phantom_nodes,
+                      NearestResult &response) const
+    {
+        BOOST_ASSERT(phantom_nodes.size() == parameters.coordinates.size());
+
+        response.results.resize(phantom_nodes.size());
+        for (const auto index : util::irange<std::size_t>(0UL, phantom_nodes.size()))
+        {
+            const auto &coordinate_phantom_nodes = phantom_nodes[index];
+            auto &waypoints = response.results[index];
+            waypoints.resize(coordinate_phantom_nodes.size());
+            for (const auto waypoint : util::irange<std::size_t>(0UL, waypoints.size()))
+            {
+                MakeWaypoint(coordinate_phantom_nodes[waypoint].phantom_node,
+                             waypoints[waypoint]);
+                waypoints[waypoint].distance = coordinate_phantom_nodes[waypoint].distance;
+            }
+        }
+        response.code = "Ok";
+    }
+
+    const NearestParameters &parameters;
+
+  private:
+    util::json::Array
+    MakeWaypoints(const std::vector<PhantomNodeWithDistance> &phantom_nodes) const
+    {
         util::json::Array waypoints;
-        waypoints.values.resize(phantom_nodes.front().size());
-        std::transform(phantom_nodes.front().begin(),
-                       phantom_nodes.front().end(),
+        waypoints.values.resize(phantom_nodes.size());
+        std::transform(phantom_nodes.begin(),
+                       phantom_nodes.end(),
                        waypoints.values.begin(),
                        [this](const PhantomNodeWithDistance &phantom_with_distance) {
                            auto waypoint = MakeWaypoint(phantom_with_distance.phantom_node);
                            waypoint.values["distance"] = phantom_with_distance.distance;
                            return waypoint;
                        });
-
-        response.values["code"] = "Ok";
-        response.values["waypoints"] = std::move(waypoints);
+        return waypoints;
     }
-
-    const NearestParameters &parameters;
 };
 
 } // ns api
@@ -0,0 +1,73 @@
+/*
+
+Copyright (c) 2016, Project OSRM contributors
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef ENGINE_API_ONE_TO_ALL_RESULT_HPP
+#define ENGINE_API_ONE_TO_ALL_RESULT_HPP
+
+#include "util/typedefs.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+
+/**
+ * Result of the OSRM OneToAll service.
+ *
+ * Holds member attributes:
+ *  - number_of_sources: number of requested coordinates
+ *  - number_of_nodes: number of nodes in the road network, nodes are the (directed) road
+ *                     segments between two intersections
+ *  - durations: durations in deci-seconds, the duration from source s to node n is stored at
+ *               n * number_of_sources + s. Unreachable nodes are INVALID_EDGE_WEIGHT and the
+ *               segments a source is snapped to can be negative.
+ *  - code, message: the reason if the query failed
+ *
+ * The result is not JSON since it grows with the size of the road network.
+ *
+ * \see OSRM, OneToAllParameters
+ */
+struct OneToAllResult
+{
+    std::size_t number_of_sources = 0;
+    std::size_t number_of_nodes = 0;
+    std::vector<EdgeWeight> durations;
+
+    std::string code;
+    std::string message;
+};
+}
+}
+}
+
+#endif // ENGINE_API_ONE_TO_ALL_RESULT_HPP
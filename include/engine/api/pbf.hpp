@@ -0,0 +1,40 @@
+#ifndef ENGINE_API_PBF_HPP
+#define ENGINE_API_PBF_HPP
+
+#include <cstdint>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+// Field numbers of the protobuf responses, the schema is documented in docs/http.md
+namespace pbf
+{
+
+// every response starts with the code and, for errors, the message of the JSON response
+const constexpr std::uint32_t CODE_TAG = 1;
+const constexpr std::uint32_t MESSAGE_TAG = 2;
+
+namespace waypoint
+{
+const constexpr std::uint32_t HINT_TAG = 1;
+const constexpr std::uint32_t NAME_TAG = 2;
+const constexpr std::uint32_t LONGITUDE_TAG = 3;
+const constexpr std::uint32_t LATITUDE_TAG = 4;
+}
+
+namespace table
+{
+const constexpr std::uint32_t SOURCES_TAG = 3;
+const constexpr std::uint32_t DESTINATIONS_TAG = 4;
+// packed floats in seconds, row by row, NaN if a destination can't be reached
+const constexpr std::uint32_t DURATIONS_TAG = 5;
+}
+}
+}
+}
+}
+
+#endif // ENGINE_API_PBF_HPP
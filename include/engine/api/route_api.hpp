@@ -4,6 +4,7 @@
 #include "engine/api/base_api.hpp"
 #include "engine/api/json_factory.hpp"
 #include "engine/api/route_parameters.hpp"
+#include "engine/api/route_result.hpp"
 
 #include "engine/datafacade/datafacade_base.hpp"
 
@@ -19,6 +20,7 @@
 
 #include "util/coordinate.hpp"
 #include "util/integer_range.hpp"
+#include "util/query_metrics.hpp"
 
 #include <iterator>
 #include <vector>
@@ -40,27 +42,91 @@ class RouteAPI : public BaseAPI
 
     void MakeResponse(const InternalRouteResult &raw_route, util::json::Object &response) const
     {
-        auto number_of_routes = raw_route.has_alternative() ? 2UL : 1UL;
+        const auto number_of_routes = 1 + raw_route.unpacked_alternatives.size();
         util::json::Array routes;
         routes.values.resize(number_of_routes);
-        routes.values[0] = MakeRoute(raw_route.segment_end_coordinates,
-                                     raw_route.unpacked_path_segments,
-                                     raw_route.source_traversed_in_reverse,
-                                     raw_route.target_traversed_in_reverse);
-        if (raw_route.has_alternative())
+        if (raw_route.is_packed())
         {
-            std::vector<std::vector<PathData>> wrapped_leg(1);
-            wrapped_leg.front() = std::move(raw_route.unpacked_alternative);
-            routes.values[1] = MakeRoute(raw_route.segment_end_coordinates,
-                                         wrapped_leg,
-                                         raw_route.alt_source_traversed_in_reverse,
-                                         raw_route.alt_target_traversed_in_reverse);
+            routes.values[0] =
+                MakePackedRoute(raw_route.packed_leg_durations, raw_route.packed_leg_distances);
+        }
+        else
+        {
+            routes.values[0] = MakeRoute(raw_route.segment_end_coordinates,
+                                         raw_route.unpacked_path_segments,
+                                         raw_route.source_traversed_in_reverse,
+                                         raw_route.target_traversed_in_reverse);
+        }
+        const auto number_of_alternatives = raw_route.unpacked_alternatives.size();
+        for (const auto index : util::irange<std::size_t>(0UL, number_of_alternatives))
+        {
+            // alternatives only exist for routes with a single leg
+            const std::vector<PathDataVector> wrapped_leg(
+                1, raw_route.unpacked_alternatives[index]);
+            routes.values[1 + index] =
+                MakeRoute(raw_route.segment_end_coordinates,
+                          wrapped_leg,
+                          {raw_route.alt_source_traversed_in_reverse[index]},
+                          {raw_route.alt_target_traversed_in_reverse[index]});
         }
         response.values["waypoints"] = BaseAPI::MakeWaypoints(raw_route.segment_end_coordinates);
         response.values["routes"] = std::move(routes);
         response.values["code"] = "Ok";
     }
 
+    // The same response as plain structs, only with the summaries of the routes
+    void MakeResponse(const InternalRouteResult &raw_route, RouteResult &response) const
+    {
+        const auto &segment_end_coordinates = raw_route.segment_end_coordinates;
+        response.waypoints.resize(segment_end_coordinates.size() + 1);
+        MakeWaypoint(segment_end_coordinates.front().source_phantom, response.waypoints.front());
+        for (const auto index : util::irange<std::size_t>(0UL, segment_end_coordinates.size()))
+        {
+            MakeWaypoint(segment_end_coordinates[index].target_phantom,
+                         response.waypoints[index + 1]);
+        }
+
+        response.routes.resize(1 + raw_route.unpacked_alternatives.size());
+        if (raw_route.is_packed())
+        {
+            auto &route = response.routes.front();
+            route.legs.resize(raw_route.packed_leg_durations.size());
+            for (const auto index : util::irange<std::size_t>(0UL, route.legs.size()))
+            {
+                route.legs[index].duration = raw_route.packed_leg_durations[index] / 10.;
+                route.legs[index].distance = raw_route.packed_leg_distances[index];
+            }
+        }
+        else
+        {
+            MakeSummaries(segment_end_coordinates,
+                          raw_route.unpacked_path_segments,
+                          raw_route.target_traversed_in_reverse,
+                          response.routes.front().legs);
+        }
+        for (const auto index :
+             util::irange<std::size_t>(0UL, raw_route.unpacked_alternatives.size()))
+        {
+            // alternatives only exist for routes with a single leg
+            const std::vector<PathDataVector> wrapped_leg(
+                1, raw_route.unpacked_alternatives[index]);
+            MakeSummaries(segment_end_coordinates,
+                          wrapped_leg,
+                          {raw_route.alt_target_traversed_in_reverse[index]},
+                          response.routes[1 + index].legs);
+        }
+
+        for (auto &route : response.routes)
+        {
+            for (const auto &leg : route.legs)
+            {
+                route.duration += leg.duration;
+                route.distance += leg.distance;
+            }
+        }
+        response.code = "Ok";
+    }
+
     // FIXME gcc 4.8 doesn't support for lambdas to call protected member functions
     //  protected:
     template <typename ForwardIter>
@@ -68,18 +134,40 @@ class RouteAPI : public BaseAPI
     {
         if (parameters.geometries == RouteParameters::GeometriesType::Polyline)
         {
-            return json::makePolyline(begin, end);
+            return json::makePolyline<100000>(begin, end);
+        }
+
+        if (parameters.geometries == RouteParameters::GeometriesType::Polyline6)
+        {
+            return json::makePolyline<1000000>(begin, end);
         }
 
         BOOST_ASSERT(parameters.geometries == RouteParameters::GeometriesType::GeoJSON);
-        return json::makeGeoJSONGeometry(begin, end);
+        return json::makeGeoJSONGeometry(begin, end, parameters.raw_json);
+    }
+
+    template <typename ForwardIter, typename ToNumberT>
+    util::json::Value MakeAnnotation(ForwardIter begin, ForwardIter end, ToNumberT to_number) const
+    {
+        if (parameters.raw_json)
+        {
+            return json::renderNumberArray(begin, end, to_number);
+        }
+        return json::makeNumberArray(begin, end, to_number);
     }
 
     util::json::Object MakeRoute(const std::vector<PhantomNodes> &segment_end_coordinates,
-                                 const std::vector<std::vector<PathData>> &unpacked_path_segments,
+                                 const std::vector<PathDataVector> &unpacked_path_segments,
                                  const std::vector<bool> &source_traversed_in_reverse,
                                  const std::vector<bool> &target_traversed_in_reverse) const
     {
+        const util::QueryMetrics::ScopedPhase guidance(util::QueryMetrics::Phase::Guidance);
+        if (parameters.IsSummaryOnly())
+        {
+            return MakeSummaryRoute(
+                segment_end_coordinates, unpacked_path_segments, target_traversed_in_reverse);
+        }
+
         std::vector<guidance::RouteLeg> legs;
         std::vector<guidance::LegGeometry> leg_geometries;
         auto number_of_legs = segment_end_coordinates.size();
@@ -146,18 +234,9 @@ class RouteAPI : public BaseAPI
                  * the overall response consistent.
                  */
 
-                guidance::trimShortSegments(steps, leg_geometry);
-                leg.steps = guidance::postProcess(std::move(steps));
-                leg.steps = guidance::collapseTurns(std::move(leg.steps));
-                leg.steps = guidance::buildIntersections(std::move(leg.steps));
-                leg.steps = guidance::assignRelativeLocations(std::move(leg.steps),
-                                                              leg_geometry,
-                                                              phantoms.source_phantom,
-                                                              phantoms.target_phantom);
-                leg.steps = guidance::removeLanesFromRoundabouts(std::move(leg.steps));
-                leg.steps = guidance::anticipateLaneChange(std::move(leg.steps));
-                leg.steps = guidance::collapseUseLane(std::move(leg.steps));
-                leg_geometry = guidance::resyncGeometry(std::move(leg_geometry), leg.steps);
+                guidance::postProcessLeg(
+                    steps, leg_geometry, phantoms.source_phantom, phantoms.target_phantom);
+                leg.steps = std::move(steps);
             }
 
             leg_geometries.push_back(std::move(leg_geometry));
@@ -189,16 +268,8 @@ class RouteAPI : public BaseAPI
                 legs[idx].steps.end(),
                 std::back_inserter(step_geometries),
                 [this, &leg_geometry](const guidance::RouteStep &step) {
-                    if (parameters.geometries == RouteParameters::GeometriesType::Polyline)
-                    {
-                        return static_cast<util::json::Value>(
-                            json::makePolyline(leg_geometry.locations.begin() + step.geometry_begin,
-                                               leg_geometry.locations.begin() + step.geometry_end));
-                    }
-                    BOOST_ASSERT(parameters.geometries == RouteParameters::GeometriesType::GeoJSON);
-                    return static_cast<util::json::Value>(json::makeGeoJSONGeometry(
-                        leg_geometry.locations.begin() + step.geometry_begin,
-                        leg_geometry.locations.begin() + step.geometry_end));
+                    return MakeGeometry(leg_geometry.locations.begin() + step.geometry_begin,
+                                        leg_geometry.locations.begin() + step.geometry_end);
                 });
         }
 
@@ -208,35 +279,27 @@ class RouteAPI : public BaseAPI
         {
             for (const auto idx : util::irange<std::size_t>(0UL, leg_geometries.size()))
             {
-                util::json::Array durations;
-                util::json::Array distances;
-                util::json::Array nodes;
-                util::json::Array datasources;
-                auto &leg_geometry = leg_geometries[idx];
-
-                durations.values.reserve(leg_geometry.annotations.size());
-                distances.values.reserve(leg_geometry.annotations.size());
-                nodes.values.reserve(leg_geometry.osm_node_ids.size());
-                datasources.values.reserve(leg_geometry.annotations.size());
-
-                std::for_each(leg_geometry.annotations.begin(),
-                              leg_geometry.annotations.end(),
-                              [this, &durations, &distances, &datasources](
-                                  const guidance::LegGeometry::Annotation &step) {
-                                  durations.values.push_back(step.duration);
-                                  distances.values.push_back(step.distance);
-                                  datasources.values.push_back(step.datasource);
-                              });
-                std::for_each(leg_geometry.osm_node_ids.begin(),
-                              leg_geometry.osm_node_ids.end(),
-                              [this, &nodes](const OSMNodeID &node_id) {
-                                  nodes.values.push_back(static_cast<std::uint64_t>(node_id));
-                              });
+                const auto &leg_annotations = leg_geometries[idx].annotations;
+                const auto &osm_node_ids = leg_geometries[idx].osm_node_ids;
+                using Annotation = guidance::LegGeometry::Annotation;
+
                 util::json::Object annotation;
-                annotation.values["distance"] = std::move(distances);
-                annotation.values["duration"] = std::move(durations);
-                annotation.values["nodes"] = std::move(nodes);
-                annotation.values["datasources"] = std::move(datasources);
+                annotation.values["distance"] = MakeAnnotation(
+                    leg_annotations.begin(), leg_annotations.end(), [](const Annotation &step) {
+                        return step.distance;
+                    });
+                annotation.values["duration"] = MakeAnnotation(
+                    leg_annotations.begin(), leg_annotations.end(), [](const Annotation &step) {
+                        return step.duration;
+                    });
+                annotation.values["nodes"] = MakeAnnotation(
+                    osm_node_ids.begin(), osm_node_ids.end(), [](const OSMNodeID node_id) {
+                        return static_cast<std::uint64_t>(node_id);
+                    });
+                annotation.values["datasources"] = MakeAnnotation(
+                    leg_annotations.begin(), leg_annotations.end(), [](const Annotation &step) {
+                        return step.datasource;
+                    });
                 annotations.push_back(std::move(annotation));
             }
         }
@@ -250,6 +313,73 @@ class RouteAPI : public BaseAPI
         return result;
     }
 
+    // Skips the geometry and guidance assembly, the legs only get their duration and distance
+    util::json::Object
+    MakeSummaryRoute(const std::vector<PhantomNodes> &segment_end_coordinates,
+                     const std::vector<PathDataVector> &unpacked_path_segments,
+                     const std::vector<bool> &target_traversed_in_reverse) const
+    {
+        std::vector<guidance::RouteLeg> legs;
+        legs.reserve(segment_end_coordinates.size());
+
+        for (auto idx : util::irange<std::size_t>(0UL, segment_end_coordinates.size()))
+        {
+            const auto &phantoms = segment_end_coordinates[idx];
+            const auto &path_data = unpacked_path_segments[idx];
+
+            const auto distance = guidance::assembleDistance(
+                BaseAPI::facade, path_data, phantoms.source_phantom, phantoms.target_phantom);
+            const auto duration = guidance::assembleDuration(path_data,
+                                                             phantoms.source_phantom,
+                                                             phantoms.target_phantom,
+                                                             target_traversed_in_reverse[idx]);
+            legs.push_back(guidance::RouteLeg{duration, distance, "", {}});
+        }
+
+        auto route = guidance::assembleRoute(legs);
+        return json::makeRoute(route, json::makeRouteLegs(std::move(legs), {}, {}), boost::none);
+    }
+
+    // The durations and distances of the legs, like in MakeSummaryRoute
+    void MakeSummaries(const std::vector<PhantomNodes> &segment_end_coordinates,
+                       const std::vector<PathDataVector> &unpacked_path_segments,
+                       const std::vector<bool> &target_traversed_in_reverse,
+                       std::vector<RouteResult::Leg> &legs) const
+    {
+        legs.resize(segment_end_coordinates.size());
+        for (auto idx : util::irange<std::size_t>(0UL, segment_end_coordinates.size()))
+        {
+            const auto &phantoms = segment_end_coordinates[idx];
+            const auto &path_data = unpacked_path_segments[idx];
+
+            legs[idx].distance = guidance::assembleDistance(
+                BaseAPI::facade, path_data, phantoms.source_phantom, phantoms.target_phantom);
+            legs[idx].duration = guidance::assembleDuration(path_data,
+                                                            phantoms.source_phantom,
+                                                            phantoms.target_phantom,
+                                                            target_traversed_in_reverse[idx]);
+        }
+    }
+
+    // Like MakeSummaryRoute, for routes that are only known by the durations and distances of
+    // their legs
+    util::json::Object MakePackedRoute(const std::vector<EdgeWeight> &leg_durations,
+                                       const std::vector<double> &leg_distances) const
+    {
+        BOOST_ASSERT(leg_durations.size() == leg_distances.size());
+        std::vector<guidance::RouteLeg> legs;
+        legs.reserve(leg_durations.size());
+
+        for (auto idx : util::irange<std::size_t>(0UL, leg_durations.size()))
+        {
+            legs.push_back(
+                guidance::RouteLeg{leg_durations[idx] / 10., leg_distances[idx], "", {}});
+        }
+
+        auto route = guidance::assembleRoute(legs);
+        return json::makeRoute(route, json::makeRouteLegs(std::move(legs), {}, {}), boost::none);
+    }
+
     const RouteParameters &parameters;
 };
 
@@ -45,7 +45,8 @@ namespace api
  * Holds member attributes:
  *  - steps: return route step for each route leg
  *  - alternatives: tries to find alternative routes
- *  - geometries: route geometry encoded in Polyline or GeoJSON
+ *  - number_of_alternatives: the number of alternative routes to find at most
+ *  - geometries: route geometry encoded in Polyline, Polyline6 or GeoJSON
  *  - overview: adds overview geometry either Full, Simplified (according to highest zoom level) or
  *              False (not at all)
  *  - continue_straight: enable or disable continue_straight (disabled by default)
@@ -58,7 +59,8 @@ struct RouteParameters : public BaseParameters
     enum class GeometriesType
     {
         Polyline,
-        GeoJSON
+        GeoJSON,
+        Polyline6
     };
     enum class OverviewType
     {
@@ -100,12 +102,19 @@ struct RouteParameters : public BaseParameters
 
     bool steps = false;
     bool alternatives = false;
+    unsigned number_of_alternatives = 1;
     bool annotations = false;
     GeometriesType geometries = GeometriesType::Polyline;
     OverviewType overview = OverviewType::Simplified;
     boost::optional<bool> continue_straight;
 
     bool IsValid() const { return coordinates.size() >= 2 && BaseParameters::IsValid(); }
+
+    // Neither geometry nor steps are requested, so only durations and distances are needed
+    bool IsSummaryOnly() const
+    {
+        return !steps && !annotations && overview == OverviewType::False;
+    }
 };
 }
 }
@@ -3,7 +3,9 @@
 
 #include "engine/api/base_api.hpp"
 #include "engine/api/json_factory.hpp"
+#include "engine/api/pbf.hpp"
 #include "engine/api/table_parameters.hpp"
+#include "engine/api/table_result.hpp"
 
 #include "engine/datafacade/datafacade_base.hpp"
 
@@ -16,10 +18,17 @@
 #include "engine/internal_route_result.hpp"
 
 #include "util/integer_range.hpp"
+#include "util/json_renderer.hpp"
+#include "util/query_metrics.hpp"
 
 #include <boost/range/algorithm/transform.hpp>
 
+#include <protozero/pbf_writer.hpp>
+
+#include <algorithm>
 #include <iterator>
+#include <limits>
+#include <string>
 
 namespace osrm
 {
@@ -70,6 +79,165 @@ class TableAPI final : public BaseAPI
         response.values["code"] = "Ok";
     }
 
+    // Writes the response in the format of the parameters straight into a buffer, without
+    // building a json::Object with a Value for every duration first
+    virtual void MakeResponse(const std::vector<EdgeWeight> &durations,
+                              const std::vector<PhantomNode> &phantoms,
+                              std::string &response) const
+    {
+        // rendered right here instead of in the request handler
+        const util::QueryMetrics::ScopedPhase rendering(util::QueryMetrics::Phase::Rendering);
+        if (parameters.format == TableParameters::OutputFormatType::PBF)
+        {
+            MakePBFResponse(durations, phantoms, response);
+        }
+        else
+        {
+            MakeJSONResponse(durations, phantoms, response);
+        }
+    }
+
+    // The same response as plain structs, with the durations in a single array
+    virtual void MakeResponse(const std::vector<EdgeWeight> &durations,
+                              const std::vector<PhantomNode> &phantoms,
+                              TableResult &response) const
+    {
+        const auto make_waypoints = [&](const std::vector<std::size_t> &indices,
+                                        std::vector<Waypoint> &waypoints) {
+            // no indices means all coordinates, like in the symmetric case above
+            waypoints.resize(indices.empty() ? phantoms.size() : indices.size());
+            for (const auto index : util::irange<std::size_t>(0UL, waypoints.size()))
+            {
+                const auto phantom = indices.empty() ? index : indices[index];
+                BOOST_ASSERT(phantom < phantoms.size());
+                MakeWaypoint(phantoms[phantom], waypoints[index]);
+            }
+        };
+        make_waypoints(parameters.sources, response.sources);
+        make_waypoints(parameters.destinations, response.destinations);
+        BOOST_ASSERT(durations.size() == response.sources.size() * response.destinations.size());
+
+        response.durations.resize(durations.size());
+        std::transform(durations.begin(),
+                       durations.end(),
+                       response.durations.begin(),
+                       [](const EdgeWeight duration) {
+                           return duration == INVALID_EDGE_WEIGHT
+                                      ? std::numeric_limits<float>::quiet_NaN()
+                                      : duration / 10.f;
+                       });
+        response.code = "Ok";
+    }
+
+    // The same JSON as the json::Object response
+    virtual void MakeJSONResponse(const std::vector<EdgeWeight> &durations,
+                                  const std::vector<PhantomNode> &phantoms,
+                                  std::string &response) const
+    {
+        const auto number_of_sources =
+            parameters.sources.empty() ? phantoms.size() : parameters.sources.size();
+        const auto number_of_destinations =
+            parameters.destinations.empty() ? phantoms.size() : parameters.destinations.size();
+        BOOST_ASSERT(durations.size() == number_of_sources * number_of_destinations);
+
+        // most durations take up to 8 characters with their comma
+        response.reserve(response.size() + durations.size() * 8 + phantoms.size() * 128);
+        MakeJSONHead(phantoms, response);
+        MakeJSONRows(durations, 0, number_of_destinations, response);
+        MakeJSONTail(response);
+    }
+
+    // The JSON up to the first row of the durations, the rows and the tail follow. A table
+    // rendered in parts, like a TableStream, is made of these.
+    virtual void MakeJSONHead(const std::vector<PhantomNode> &phantoms,
+                              std::string &response) const
+    {
+        util::json::ArrayRenderer<std::string> renderer(response);
+
+        response += "{\"code\":\"Ok\",\"sources\":";
+        renderer(parameters.sources.empty() ? MakeWaypoints(phantoms)
+                                            : MakeWaypoints(phantoms, parameters.sources));
+        response += ",\"destinations\":";
+        renderer(parameters.destinations.empty()
+                     ? MakeWaypoints(phantoms)
+                     : MakeWaypoints(phantoms, parameters.destinations));
+        response += ",\"durations\":[";
+    }
+
+    // The rows of the durations from first_row on, the ones in front of them are rendered already
+    virtual void MakeJSONRows(const std::vector<EdgeWeight> &durations,
+                              const std::size_t first_row,
+                              const std::size_t number_of_destinations,
+                              std::string &response) const
+    {
+        BOOST_ASSERT(number_of_destinations > 0);
+        BOOST_ASSERT(durations.size() % number_of_destinations == 0);
+        const auto number_of_rows = durations.size() / number_of_destinations;
+        for (const auto row : util::irange<std::size_t>(0UL, number_of_rows))
+        {
+            response += first_row + row == 0 ? "[" : ",[";
+            const auto row_begin = durations.begin() + row * number_of_destinations;
+            for (auto duration = row_begin; duration != row_begin + number_of_destinations;
+                 ++duration)
+            {
+                if (duration != row_begin)
+                {
+                    response.push_back(',');
+                }
+                if (*duration == INVALID_EDGE_WEIGHT)
+                {
+                    response += "null";
+                }
+                else
+                {
+                    util::json::renderNumber(response, *duration / 10.);
+                }
+            }
+            response.push_back(']');
+        }
+    }
+
+    virtual void MakeJSONTail(std::string &response) const { response += "]}"; }
+
+    // The same response as a protobuf message: the durations are a packed array of floats that
+    // clients can use in place, without parsing N*M numbers
+    virtual void MakePBFResponse(const std::vector<EdgeWeight> &durations,
+                                 const std::vector<PhantomNode> &phantoms,
+                                 std::string &response) const
+    {
+        protozero::pbf_writer writer(response);
+        writer.add_string(pbf::CODE_TAG, "Ok");
+
+        const auto make_waypoints = [&](const protozero::pbf_tag_type tag,
+                                        const std::vector<std::size_t> &indices) {
+            // no indices means all coordinates, like in the symmetric case above
+            if (indices.empty())
+            {
+                for (const auto &phantom : phantoms)
+                {
+                    MakeWaypoint(writer, tag, phantom);
+                }
+                return;
+            }
+            for (const auto index : indices)
+            {
+                BOOST_ASSERT(index < phantoms.size());
+                MakeWaypoint(writer, tag, phantoms[index]);
+            }
+        };
+        make_waypoints(pbf::table::SOURCES_TAG, parameters.sources);
+        make_waypoints(pbf::table::DESTINATIONS_TAG, parameters.destinations);
+
+        protozero::packed_field_float durations_writer(
+            writer, pbf::table::DURATIONS_TAG, durations.size());
+        for (const auto duration : durations)
+        {
+            durations_writer.add_element(duration == INVALID_EDGE_WEIGHT
+                                             ? std::numeric_limits<float>::quiet_NaN()
+                                             : duration / 10.f);
+        }
+    }
+
     // FIXME gcc 4.8 doesn't support for lambdas to call protected member functions
     //  protected:
     virtual util::json::Array MakeWaypoints(const std::vector<PhantomNode> &phantoms) const
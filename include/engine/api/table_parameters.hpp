@@ -30,10 +30,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "engine/api/base_parameters.hpp"
 
+#include <boost/optional.hpp>
+
 #include <cstddef>
 
 #include <algorithm>
 #include <iterator>
+#include <string>
 #include <vector>
 
 namespace osrm
@@ -51,14 +54,28 @@ namespace api
  *             use all coordinates as sources
  *  - destinations: indices into coordinates indicating destinations for the Table service, no
  *                  destinations means use all coordinates as destinations
+ *  - format: encoding of the response, JSON or a protobuf message (see docs/http.md)
+ *  - max_duration: durations in seconds above which entries are left out as null, the searches
+ *                  stop there instead of exploring all of their search space
+ *  - session: keeps the search spaces of the table between requests with the same session, which
+ *             then only search from the coordinates that moved (see ManyToManyTableSession)
  *
  * \see OSRM, Coordinate, Hint, Bearing, RouteParame, RouteParameters, TableParameters,
  *      NearestParameters, TripParameters, MatchParameters and TileParameters
  */
 struct TableParameters : public BaseParameters
 {
+    enum class OutputFormatType
+    {
+        JSON,
+        PBF
+    };
+
     std::vector<std::size_t> sources;
     std::vector<std::size_t> destinations;
+    OutputFormatType format = OutputFormatType::JSON;
+    boost::optional<double> max_duration;
+    std::string session;
 
     TableParameters() = default;
     template <typename... Args>
@@ -97,6 +114,9 @@ struct TableParameters : public BaseParameters
         if (std::any_of(begin(destinations), end(destinations), not_in_range))
             return false;
 
+        if (max_duration && *max_duration < 0)
+            return false;
+
         return true;
     }
 };
@@ -0,0 +1,69 @@
+/*
+
+Copyright (c) 2016, Project OSRM contributors
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef ENGINE_API_TABLE_RESULT_HPP
+#define ENGINE_API_TABLE_RESULT_HPP
+
+#include "engine/api/waypoint.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+
+/**
+ * Result of the OSRM Table service as plain structs instead of JSON.
+ *
+ * Holds member attributes:
+ *  - sources, destinations: the snapped sources and destinations
+ *  - durations: durations in seconds, the duration from source s to destination d is stored at
+ *               s * destinations.size() + d. Durations between unconnected coordinates are NaN.
+ *  - code, message: the reason if the query failed
+ *
+ * \see OSRM, TableParameters
+ */
+struct TableResult
+{
+    std::vector<Waypoint> sources;
+    std::vector<Waypoint> destinations;
+    std::vector<float> durations;
+
+    std::string code;
+    std::string message;
+};
+}
+}
+}
+
+#endif // ENGINE_API_TABLE_RESULT_HPP
@@ -0,0 +1,58 @@
+#ifndef ENGINE_API_TABLE_STREAM_HPP
+#define ENGINE_API_TABLE_STREAM_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+
+/**
+ * Receives the JSON response of the Table service in parts while the table is computed, for
+ * tables too large to hold at once.
+ *
+ * The rows are computed in blocks, and every block is rendered and handed to write before the
+ * next one is computed, so the memory of the query doesn't grow with the number of rows. The
+ * parts make up the same JSON as the rendered response.
+ *
+ * Holds member attributes:
+ *  - write: gets the next part, returns false if it can't take it, like when the client went
+ *           away, which stops the query
+ *  - started: set once the first part was written, a query that fails after it can't report
+ *             its error anymore and leaves the response incomplete
+ *  - error: the rendered JSON of an error before the first part
+ *
+ * \see OSRM, TableParameters
+ */
+struct TableStream
+{
+    std::function<bool(const char *data, std::size_t size)> write;
+    bool started = false;
+    std::string error;
+
+    TableStream() = default;
+    explicit TableStream(std::function<bool(const char *, std::size_t)> write_)
+        : write(std::move(write_))
+    {
+    }
+
+    // hands over a part and clears it, false if it wasn't taken
+    bool Write(std::string &part)
+    {
+        started = true;
+        const bool written = write(part.data(), part.size());
+        part.clear();
+        return written;
+    }
+};
+}
+}
+}
+
+#endif // ENGINE_API_TABLE_STREAM_HPP
@@ -0,0 +1,101 @@
+/*
+
+Copyright (c) 2016, Project OSRM contributors
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef ENGINE_ASYNC_HPP
+#define ENGINE_ASYNC_HPP
+
+#include "engine/status.hpp"
+
+#include <boost/optional.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+
+namespace osrm
+{
+namespace engine
+{
+
+/**
+ * Options of a query that runs on the thread pool of an OSRM instance.
+ *
+ * Holds member attributes:
+ *  - deadline: the query fails with the status Timeout and the code "Timeout" if it isn't done
+ *              by then. EngineConfig::max_query_time can move it earlier.
+ *  - cancelled: the query fails with the code "Cancelled" once this is set to true, one flag
+ *               can cancel any number of queries
+ *
+ * Both are checked before the query starts and polled while its searches run, so a query
+ * stops soon after, but not right at its deadline or cancellation.
+ *
+ * \see OSRM::Async
+ */
+struct AsyncOptions
+{
+    boost::optional<std::chrono::steady_clock::time_point> deadline;
+    std::shared_ptr<const std::atomic<bool>> cancelled;
+};
+
+/**
+ * Response of a query that ran on the thread pool of an OSRM instance.
+ *
+ * Holds member attributes:
+ *  - status: whether the query succeeded, as returned by the synchronous services
+ *  - result: the result the query filled
+ *  - exception: what the query threw, the status is Error then. Futures rethrow it instead.
+ *
+ * \see OSRM::Async
+ */
+template <typename ResultT> struct AsyncResponse
+{
+    Status status = Status::Error;
+    ResultT result;
+    std::exception_ptr exception;
+};
+
+// Thrown by the searches of a query that was cancelled or ran past its deadline, with the
+// status, code and message of the error the query fails with
+class QueryAborted final : public std::exception
+{
+  public:
+    QueryAborted(const Status status, const char *code, const char *message)
+        : status(status), code(code), message(message)
+    {
+    }
+    const char *what() const noexcept override { return message; }
+
+    const Status status;
+    const char *const code;
+    const char *const message;
+};
+}
+}
+
+#endif // ENGINE_ASYNC_HPP
@@ -1,6 +1,8 @@
 #ifndef OSRM_BASE64_HPP
 #define OSRM_BASE64_HPP
 
+#include <algorithm>
+#include <array>
 #include <iterator>
 #include <string>
 #include <type_traits>
@@ -8,12 +10,9 @@
 
 #include <climits>
 #include <cstddef>
+#include <cstdint>
 
-#include <boost/algorithm/string/trim.hpp>
-#include <boost/archive/iterators/base64_from_binary.hpp>
-#include <boost/archive/iterators/binary_from_base64.hpp>
-#include <boost/archive/iterators/transform_width.hpp>
-#include <boost/range/algorithm/copy.hpp>
+#include <boost/assert.hpp>
 
 namespace osrm
 {
@@ -27,42 +26,62 @@ namespace detail
 static_assert(CHAR_BIT == 8u, "we assume a byte holds 8 bits");
 static_assert(sizeof(char) == 1u, "we assume a char is one byte large");
 
-using Base64FromBinary = boost::archive::iterators::base64_from_binary<
-    boost::archive::iterators::transform_width<const char *, // sequence of chars
-                                               6,            // get view of 6 bit
-                                               8             // from sequence of 8 bit
-                                               >>;
-
-using BinaryFromBase64 = boost::archive::iterators::transform_width<
-    boost::archive::iterators::binary_from_base64<std::string::const_iterator>,
-    8, // get a view of 8 bit
-    6  // from a sequence of 6 bit
-    >;
+constexpr char BASE64_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Maps the characters of the alphabet to their values, all other characters to 0
+inline const std::array<std::uint8_t, 256> &base64DecodingTable()
+{
+    static const auto table = [] {
+        std::array<std::uint8_t, 256> values{};
+        for (std::uint8_t value = 0; value < 64; ++value)
+        {
+            values[static_cast<unsigned char>(BASE64_ALPHABET[value])] = value;
+        }
+        return values;
+    }();
+    return table;
+}
 } // ns detail
 namespace engine
 {
 
 // Encoding Implementation
 
-// Encodes a chunk of memory to Base64.
+// Encodes a chunk of memory to Base64, three bytes into four characters at a time.
 inline std::string encodeBase64(const unsigned char *first, std::size_t size)
 {
-    std::vector<unsigned char> bytes{first, first + size};
-    BOOST_ASSERT(!bytes.empty());
+    BOOST_ASSERT(size > 0);
 
-    std::size_t bytes_to_pad{0};
+    std::string encoded;
+    encoded.reserve((size + 2) / 3 * 4);
 
-    while (bytes.size() % 3 != 0)
+    const auto append = [&encoded](const std::uint32_t bits, const std::size_t number_of_chars) {
+        for (std::size_t index = 0; index < number_of_chars; ++index)
+        {
+            encoded.push_back(detail::BASE64_ALPHABET[(bits >> (18 - 6 * index)) & 0x3f]);
+        }
+    };
+
+    std::size_t index = 0;
+    for (; index + 3 <= size; index += 3)
     {
-        bytes_to_pad += 1;
-        bytes.push_back(0);
+        append(std::uint32_t{first[index]} << 16 | std::uint32_t{first[index + 1]} << 8 |
+                   std::uint32_t{first[index + 2]},
+               4);
     }
 
-    BOOST_ASSERT(bytes_to_pad == 0 || bytes_to_pad == 1 || bytes_to_pad == 2);
-    BOOST_ASSERT_MSG(0 == bytes.size() % 3, "base64 input data size is not a multiple of 3");
-
-    std::string encoded{detail::Base64FromBinary{bytes.data()},
-                        detail::Base64FromBinary{bytes.data() + (bytes.size() - bytes_to_pad)}};
+    // the remaining bytes are padded with zeros
+    const std::size_t bytes_to_pad = (3 - (size - index)) % 3;
+    if (bytes_to_pad > 0)
+    {
+        std::uint32_t bits = std::uint32_t{first[index]} << 16;
+        if (bytes_to_pad == 1)
+        {
+            bits |= std::uint32_t{first[index + 1]} << 8;
+        }
+        append(bits, 4 - bytes_to_pad);
+    }
 
     return encoded.append(bytes_to_pad, '=');
 }
@@ -99,16 +118,32 @@ template <typename T> std::string encodeBase64Bytewise(const T &x)
 // Decodes into a chunk of memory that is at least as large as the input.
 template <typename OutputIter> void decodeBase64(const std::string &encoded, OutputIter out)
 {
-    auto unpadded = encoded;
-
-    const auto num_padded = std::count(begin(encoded), end(encoded), '=');
-    std::replace(begin(unpadded), end(unpadded), '=', 'A'); // A_64 == \0
-
-    std::string decoded{detail::BinaryFromBase64{begin(unpadded)},
-                        detail::BinaryFromBase64{begin(unpadded) + unpadded.length()}};
-
-    decoded.erase(end(decoded) - num_padded, end(decoded));
-    std::copy(begin(decoded), end(decoded), out);
+    const auto &table = detail::base64DecodingTable();
+
+    // padding characters stand for zero bits of bytes that are dropped
+    const auto num_padded =
+        static_cast<std::size_t>(std::count(begin(encoded), end(encoded), '='));
+    const std::size_t size = encoded.size() * 6 / 8;
+    const std::size_t num_decoded = size > num_padded ? size - num_padded : 0;
+
+    std::uint32_t bits = 0;
+    std::size_t num_bits = 0;
+    std::size_t num_written = 0;
+    for (const char character : encoded)
+    {
+        bits = (bits << 6 | table[static_cast<unsigned char>(character)]) & 0xffffff;
+        num_bits += 6;
+        if (num_bits >= 8)
+        {
+            num_bits -= 8;
+            if (num_written == num_decoded)
+            {
+                break;
+            }
+            *out++ = static_cast<unsigned char>(bits >> num_bits);
+            ++num_written;
+        }
+    }
 }
 
 // Convenience specialization, filling string instead of byte-dumping into it.
@@ -0,0 +1,33 @@
+#ifndef CONTOUR_HPP
+#define CONTOUR_HPP
+
+#include "util/coordinate.hpp"
+
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+// A piece of road inside the area of a contour, a coordinate is a segment of length zero
+struct ContourSegment
+{
+    util::Coordinate from;
+    util::Coordinate to;
+};
+
+// The outlines of the area the segments cover, as closed rings in counterclockwise order with
+// one polygon each.
+//
+// The segments are drawn onto a grid of cells of about cell_size meters, widened by a cell to
+// each side so that roads less than a cell apart fill the area between them. Every group of
+// cells that share a side becomes a polygon, the cells it encloses are added to it, so the
+// polygons have no holes. Grids that would have more than 2048 cells to a side use larger
+// cells instead.
+std::vector<std::vector<util::Coordinate>> makeContour(const std::vector<ContourSegment> &segments,
+                                                       const double cell_size);
+}
+}
+
+#endif // CONTOUR_HPP
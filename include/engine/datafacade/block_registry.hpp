@@ -0,0 +1,84 @@
+#ifndef OSRM_ENGINE_DATAFACADE_BLOCK_REGISTRY_HPP
+#define OSRM_ENGINE_DATAFACADE_BLOCK_REGISTRY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+namespace osrm
+{
+namespace engine
+{
+namespace datafacade
+{
+
+// The blocks of data that several datasets of a process load with the same contents, like the
+// geometries and names of profiles that were extracted with the same ways, or the files that
+// datasets of the same extract with different weights have in common. A dataset that loads a
+// block another one holds already uses that one and drops its own copy, so the profiles of a
+// multi-profile osrm-routed only keep one copy of their common data.
+//
+// Blocks are found by a key of what they hold and a 128 bit hash of the contents they were
+// loaded from. The registry doesn't own them, a block is freed with the last dataset that uses
+// it. Blocks are never changed once they are registered.
+class BlockRegistry
+{
+  public:
+    struct Key
+    {
+        // blocks of different NUMA nodes are never shared, they are replicas on purpose
+        std::size_t domain;
+        // what the block holds, like the extension of the file it was loaded from
+        std::string type;
+        std::uint64_t size;
+        std::uint64_t hash_1;
+        std::uint64_t hash_2;
+
+        bool operator<(const Key &other) const
+        {
+            return std::tie(domain, type, size, hash_1, hash_2) <
+                   std::tie(other.domain, other.type, other.size, other.hash_1, other.hash_2);
+        }
+    };
+
+    static Key MakeKey(const std::size_t domain,
+                       std::string type,
+                       const char *contents,
+                       const std::size_t size);
+
+    static BlockRegistry &GetInstance();
+
+    // The block registered under the key if a dataset still holds it, nullptr otherwise
+    template <typename Block> std::shared_ptr<const Block> Find(const Key &key)
+    {
+        return std::static_pointer_cast<const Block>(FindBlock(key));
+    }
+
+    // Registers the block, unless another one was registered under the key in the meantime,
+    // which is returned instead
+    template <typename Block>
+    std::shared_ptr<const Block> Share(const Key &key, std::shared_ptr<const Block> block)
+    {
+        return std::static_pointer_cast<const Block>(ShareBlock(key, std::move(block)));
+    }
+
+    // the number of blocks held by datasets
+    std::size_t GetNumberOfBlocks() const;
+
+  private:
+    std::shared_ptr<const void> FindBlock(const Key &key);
+    std::shared_ptr<const void> ShareBlock(const Key &key, std::shared_ptr<const void> block);
+    void RemoveExpired();
+
+    mutable std::mutex mutex;
+    std::map<Key, std::weak_ptr<const void>> blocks;
+};
+}
+}
+}
+
+#endif // OSRM_ENGINE_DATAFACADE_BLOCK_REGISTRY_HPP
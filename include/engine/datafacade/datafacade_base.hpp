@@ -4,21 +4,28 @@
 // Exposes all data access interfaces to the algorithms via base class ptr
 
 #include "contractor/query_edge.hpp"
+#include "contractor/query_graph.hpp"
 #include "extractor/edge_based_node.hpp"
 #include "extractor/external_memory_node.hpp"
 #include "extractor/guidance/turn_instruction.hpp"
 #include "extractor/guidance/turn_lane_types.hpp"
+#include "engine/hub_labels.hpp"
 #include "engine/phantom_node.hpp"
+#include "partition/cell_storage.hpp"
 #include "util/exception.hpp"
 #include "util/guidance/bearing_class.hpp"
 #include "util/guidance/entry_class.hpp"
 #include "util/integer_range.hpp"
+#include "util/packed_bitset.hpp"
+#include "util/page_heat.hpp"
 #include "util/string_util.hpp"
+#include "util/string_view.hpp"
 #include "util/typedefs.hpp"
 
 #include "osrm/coordinate.hpp"
 
 #include <cstddef>
+#include <cstdint>
 
 #include <string>
 #include <utility>
@@ -50,7 +57,13 @@ class BaseDataFacade
 
     virtual NodeID GetTarget(const EdgeID e) const = 0;
 
-    virtual const EdgeData &GetEdgeData(const EdgeID e) const = 0;
+    virtual EdgeData GetEdgeData(const EdgeID e) const = 0;
+
+    // target, weight and directions of an edge, all that a search needs to relax it
+    virtual const contractor::QueryEdgeSearchData &GetSearchData(const EdgeID e) const = 0;
+
+    // the edge arrays of the graph, for the inner loops of the searches
+    virtual contractor::QueryGraphView GetSearchGraph() const = 0;
 
     virtual EdgeID BeginEdges(const NodeID n) const = 0;
 
@@ -85,8 +98,18 @@ class BaseDataFacade
     virtual void GetUncompressedDatasources(const EdgeID id,
                                             std::vector<uint8_t> &data_sources) const = 0;
 
+    // Returns the lowest zoom level at which the overview simplification keeps each node of an
+    // uncompressed geometry. Will return an array of 0's when the levels weren't precomputed.
+    virtual void GetUncompressedZoomLevels(const EdgeID id,
+                                           std::vector<std::uint8_t> &zoom_levels) const = 0;
+
+    // Returns the length of the segment that ends at each node of an uncompressed geometry. Will
+    // return an array of INVALID_SEGMENT_LENGTH's when the lengths weren't precomputed.
+    virtual void GetUncompressedLengths(const EdgeID id,
+                                        std::vector<SegmentLength> &lengths) const = 0;
+
     // Gets the name of a datasource
-    virtual std::string GetDatasourceName(const uint8_t datasource_name_id) const = 0;
+    virtual util::StringView GetDatasourceName(const uint8_t datasource_name_id) const = 0;
 
     virtual extractor::guidance::TurnInstruction
     GetTurnInstructionForEdgeID(const unsigned id) const = 0;
@@ -139,6 +162,10 @@ class BaseDataFacade
                                                       const int bearing,
                                                       const int bearing_range) const = 0;
 
+    // Rebuilds the phantom node of a hint, see GeospatialQuery::SegmentPhantomNode
+    virtual PhantomNode SegmentPhantomNode(const util::Coordinate input_coordinate,
+                                           const PhantomNode &segment) const = 0;
+
     virtual bool hasLaneData(const EdgeID id) const = 0;
     virtual util::guidance::LaneTupelIdPair GetLaneData(const EdgeID id) const = 0;
     virtual extractor::guidance::TurnLaneDescription
@@ -146,24 +173,77 @@ class BaseDataFacade
 
     virtual unsigned GetCheckSum() const = 0;
 
+    // Changes whenever the data behind the facade is swapped, e.g. by osrm-datastore
+    virtual unsigned GetDataVersion() const = 0;
+
     virtual bool IsCoreNode(const NodeID id) const = 0;
 
+    // The core markers of all nodes, empty if the dataset has no core. Searches that test many
+    // nodes read them through the view instead of calling IsCoreNode for every node.
+    virtual util::PackedBitsetView GetCoreMarkers() const = 0;
+
     virtual unsigned GetNameIndexFromEdgeID(const unsigned id) const = 0;
 
-    virtual std::string GetNameForID(const unsigned name_id) const = 0;
+    // The names are views into the name data of the facade and are only valid as long as it is
+    virtual util::StringView GetNameForID(const unsigned name_id) const = 0;
 
-    virtual std::string GetRefForID(const unsigned name_id) const = 0;
+    virtual util::StringView GetRefForID(const unsigned name_id) const = 0;
 
-    virtual std::string GetPronunciationForID(const unsigned name_id) const = 0;
+    virtual util::StringView GetPronunciationForID(const unsigned name_id) const = 0;
 
-    virtual std::string GetDestinationsForID(const unsigned name_id) const = 0;
+    virtual util::StringView GetDestinationsForID(const unsigned name_id) const = 0;
 
     virtual std::size_t GetCoreSize() const = 0;
 
+    // Number of landmarks in the core for ALT searches, 0 if the dataset has none
+    virtual unsigned GetNumberOfLandmarks() const = 0;
+
+    // Distances from all landmarks to a core node followed by the distances from the node to
+    // all landmarks, INVALID_EDGE_WEIGHT if unreachable. nullptr for nodes outside the core.
+    virtual const EdgeWeight *GetLandmarkDistances(const NodeID id) const = 0;
+
+    // Whether osrm-contract computed hub labels for the dataset
+    virtual bool HasHubLabels() const = 0;
+
+    // The forward (or backward) hub label of the node, empty if the dataset has none
+    virtual HubLabel GetHubLabel(const NodeID id, const bool forward) const = 0;
+
+    // Whether the facade loaded the graph and cells of osrm-customize for multi-level searches
+    virtual bool HasMultiLevelData() const = 0;
+
+    // The edge-based graph with every edge at both of its nodes, the ids of its unpack data
+    // are those of the original edges
+    virtual contractor::QueryGraphView GetMultiLevelGraph() const = 0;
+
+    virtual EdgeData GetMultiLevelEdgeData(const EdgeID e) const = 0;
+
+    // The cells of the multi-level graph with the weights between their boundary nodes
+    virtual const partition::CellStorageView &GetCellStorage() const = 0;
+
     virtual std::string GetTimestamp() const = 0;
 
+    // The blocks of memory the data is read from, to warm them up before queries touch them.
+    // Data that was parsed into vectors of its own while loading isn't part of them.
+    virtual std::vector<util::MemoryRegion> GetMemoryRegions() const = 0;
+
+    // The same data in the blocks it is made of, the blocks of osrm-datastore or the files and the
+    // sections of the container, to sample which of them are hot
+    virtual std::vector<util::NamedMemoryRegion> GetMemoryBlocks() const = 0;
+
     virtual bool GetContinueStraightDefault() const = 0;
 
+    // Whether the component ids of the nodes are in topological order, a component only reaches
+    // components with larger ids. Datasets extracted by older versions don't order them.
+    virtual bool HasOrderedComponentIDs() const = 0;
+
+    // Whether no path leads from source to target, known from their components without a search
+    bool IsUnreachable(const PhantomNode &source, const PhantomNode &target) const
+    {
+        return HasOrderedComponentIDs() && source.component.id != INVALID_COMPONENTID &&
+               target.component.id != INVALID_COMPONENTID &&
+               source.component.id > target.component.id;
+    }
+
     virtual BearingClassID GetBearingClassID(const NodeID id) const = 0;
 
     virtual util::guidance::BearingClass
@@ -3,34 +3,41 @@
 
 // implements all data storage when shared memory is _NOT_ used
 
+#include "engine/datafacade/block_registry.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
 
 #include "extractor/guidance/turn_instruction.hpp"
 #include "util/guidance/bearing_class.hpp"
 #include "util/guidance/entry_class.hpp"
 
+#include "contractor/query_graph.hpp"
 #include "extractor/compressed_edge_container.hpp"
+#include "extractor/compressed_geometry.hpp"
 #include "extractor/original_edge_data.hpp"
 #include "extractor/profile_properties.hpp"
 #include "extractor/query_node.hpp"
+#include "storage/container_file.hpp"
 #include "storage/storage_config.hpp"
 #include "engine/geospatial_query.hpp"
 #include "util/graph_loader.hpp"
 #include "util/guidance/turn_lanes.hpp"
 #include "util/io.hpp"
+#include "util/make_unique.hpp"
+#include "util/packed_bitset.hpp"
 #include "util/packed_vector.hpp"
 #include "util/range_table.hpp"
 #include "util/rectangle.hpp"
 #include "util/shared_memory_vector_wrapper.hpp"
 #include "util/simple_logger.hpp"
-#include "util/static_graph.hpp"
 #include "util/static_rtree.hpp"
 #include "util/typedefs.hpp"
 
 #include "osrm/coordinate.hpp"
 
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 
 #include <algorithm>
 #include <fstream>
@@ -38,6 +45,7 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <typeinfo>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -46,6 +54,9 @@
 #include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/iostreams/stream.hpp>
 #include <boost/thread/tss.hpp>
 
 namespace osrm
@@ -60,8 +71,7 @@ class InternalDataFacade final : public BaseDataFacade
 
   private:
     using super = BaseDataFacade;
-    using QueryGraph = util::StaticGraph<typename super::EdgeData>;
-    using InputEdge = QueryGraph::InputEdge;
+    using QueryGraph = contractor::QueryGraph<true>;
     using RTreeLeaf = super::RTreeLeaf;
     using InternalRTree =
         util::StaticRTree<RTreeLeaf, util::ShM<util::Coordinate, false>::vector, false>;
@@ -69,25 +79,107 @@ class InternalDataFacade final : public BaseDataFacade
 
     InternalDataFacade() {}
 
+    // The contents of a file that are used in place. A private mapping of the file shares its
+    // pages with every process that maps it and loads them on first access; without mmap the
+    // file is read into a buffer in a single call.
+    struct FileContents
+    {
+        boost::iostreams::mapped_file mapping;
+        std::vector<char> buffer;
+        char *data = nullptr;
+        std::size_t size = 0;
+        // the extension of the file, the name of its section of the container
+        std::string name;
+    };
+
+    // The nodes of the .nodes file, split into one vector per field
+    struct NodeData
+    {
+        util::ShM<util::Coordinate, false>::vector coordinates;
+        util::PackedVector<OSMNodeID, false> osm_node_ids;
+    };
+
+    // Consecutive arrays in the contents of a file
+    class FileCursor
+    {
+      public:
+        FileCursor(const FileContents &contents, const boost::filesystem::path &path)
+            : position(contents.data), end(contents.data + contents.size), path(path)
+        {
+        }
+
+        template <typename T> T *Next(const std::size_t count)
+        {
+            BOOST_ASSERT(reinterpret_cast<std::uintptr_t>(position) % alignof(T) == 0);
+            if (static_cast<std::size_t>(end - position) < count * sizeof(T))
+            {
+                throw util::exception(path.string() + " is truncated.");
+            }
+            auto *result = reinterpret_cast<T *>(position);
+            position += count * sizeof(T);
+            return result;
+        }
+
+        // single values don't need to be aligned
+        template <typename T> T Read()
+        {
+            T value;
+            std::memcpy(&value, Next<char>(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        void Skip(const std::size_t bytes) { Next<char>(bytes); }
+
+      private:
+        char *position;
+        const char *end;
+        const boost::filesystem::path &path;
+    };
+
+    bool m_use_mmap = false;
+    bool prefetch_rtree_leaves = false;
+    bool prefetch_search_graph = false;
+    // counts the reloads of the files, see Engine::Reload
+    unsigned data_version = 0;
+    // share the blocks with the same contents with the other datasets, see BlockRegistry
+    bool share_blocks = false;
+    std::size_t block_domain = 0;
+    // holds the contents of all files but the r-tree if the dataset was packed
+    std::unique_ptr<storage::ContainerFile> m_container;
+    // contents of the files the vectors below point into
+    std::vector<std::shared_ptr<const FileContents>> m_file_contents;
+
     unsigned m_check_sum;
     unsigned m_number_of_nodes;
     std::unique_ptr<QueryGraph> m_query_graph;
+    // only loaded for multi-level searches
+    std::unique_ptr<QueryGraph> m_multi_level_graph;
+    partition::CellStorageView m_cell_storage;
     std::string m_timestamp;
 
-    util::ShM<util::Coordinate, false>::vector m_coordinate_list;
-    util::PackedVector<OSMNodeID, false> m_osmnodeid_list;
+    std::shared_ptr<const NodeData> m_node_data;
     util::ShM<NodeID, false>::vector m_via_node_list;
     util::ShM<unsigned, false>::vector m_name_ID_list;
     util::ShM<extractor::guidance::TurnInstruction, false>::vector m_turn_instruction_list;
     util::ShM<LaneDataID, false>::vector m_lane_data_id;
     util::ShM<util::guidance::LaneTupelIdPair, false>::vector m_lane_tupel_id_pairs;
     util::ShM<extractor::TravelMode, false>::vector m_travel_mode_list;
-    util::ShM<char, false>::vector m_names_char_list;
-    util::ShM<unsigned, false>::vector m_geometry_indices;
-    util::ShM<extractor::CompressedEdgeContainer::CompressedEdge, false>::vector m_geometry_list;
-    util::ShM<bool, false>::vector m_is_core_node;
+    util::ShM<char, true>::vector m_names_char_list;
+    util::ShM<unsigned, true>::vector m_geometry_indices;
+    util::ShM<std::uint64_t, true>::vector m_geometry_block_offsets;
+    util::ShM<unsigned char, true>::vector m_geometry_data;
+    std::vector<util::PackedBitsetView::Word> m_core_marker_words;
+    util::PackedBitsetView m_core_markers;
+    unsigned m_number_of_landmarks = 0;
+    util::ShM<NodeID, false>::vector m_landmark_core_nodes;
+    util::ShM<EdgeWeight, false>::vector m_landmark_distances;
+    util::ShM<std::uint64_t, false>::vector m_hub_label_offsets;
+    util::ShM<NodeID, false>::vector m_hub_label_hubs;
+    util::ShM<EdgeWeight, false>::vector m_hub_label_weights;
     util::ShM<unsigned, false>::vector m_segment_weights;
-    util::ShM<uint8_t, false>::vector m_datasource_list;
+    util::ShM<uint8_t, true>::vector m_datasource_list;
+    util::ShM<std::uint8_t, true>::vector m_geometry_zoom_levels;
+    util::ShM<SegmentLength, true>::vector m_geometry_lengths;
     util::ShM<std::string, false>::vector m_datasource_names;
     util::ShM<std::uint32_t, false>::vector m_lane_description_offsets;
     util::ShM<extractor::guidance::TurnLaneType::Mask, false>::vector m_lane_description_masks;
@@ -111,21 +203,118 @@ class InternalDataFacade final : public BaseDataFacade
     util::RangeTable<16, false> m_bearing_ranges_table;
     util::ShM<DiscreteBearing, false>::vector m_bearing_values_table;
 
+    bool HasFile(const boost::filesystem::path &path) const
+    {
+        return m_container ? m_container->HasSection(path.extension().string())
+                           : boost::filesystem::exists(path);
+    }
+
+    // Opens a file or its section of the container for the loaders that parse a stream
+    std::unique_ptr<std::istream> OpenFile(const boost::filesystem::path &path) const
+    {
+        if (m_container && m_container->HasSection(path.extension().string()))
+        {
+            const auto section = m_container->GetSection(path.extension().string());
+            return util::make_unique<boost::iostreams::stream<boost::iostreams::array_source>>(
+                section.data, section.size);
+        }
+        return util::make_unique<boost::filesystem::ifstream>(path, std::ios::binary);
+    }
+
+    // Without mmap, the contents are shared if the files are shared between datasets. Mappings of
+    // the same file share their pages in any case, sections of the container aren't shared.
+    std::shared_ptr<const FileContents> LoadFile(const boost::filesystem::path &path,
+                                                 const bool share = true)
+    {
+        auto contents = util::make_unique<FileContents>();
+        contents->name = path.extension().string();
+        if (m_container && m_container->HasSection(path.extension().string()))
+        {
+            const auto section = m_container->GetSection(path.extension().string());
+            contents->data = section.data;
+            contents->size = section.size;
+            return contents;
+        }
+
+        if (!boost::filesystem::exists(path))
+        {
+            throw util::exception("Could not open " + path.string() + " for reading.");
+        }
+
+        contents->size = boost::filesystem::file_size(path);
+        // empty files can't be mapped
+        if (m_use_mmap && contents->size > 0)
+        {
+            contents->mapping.open(path, boost::iostreams::mapped_file::priv);
+            contents->data = contents->mapping.data();
+        }
+        else
+        {
+            boost::filesystem::ifstream stream(path, std::ios::binary);
+            contents->buffer.resize(contents->size);
+            stream.read(contents->buffer.data(), contents->size);
+            if (!stream)
+            {
+                throw util::exception("Reading from " + path.string() + " failed.");
+            }
+            contents->data = contents->buffer.data();
+            if (share && share_blocks)
+            {
+                const auto key = MakeBlockKey<FileContents>(path, *contents);
+                const auto size = contents->size;
+                return ShareBlock<FileContents>(
+                    key, path, size, std::shared_ptr<const FileContents>(std::move(contents)));
+            }
+        }
+        return contents;
+    }
+
+    // The block another dataset holds for contents like the ones it was loaded from, or the
+    // block itself which is shared with the datasets loaded after this one
+    template <typename Block>
+    std::shared_ptr<const Block> ShareBlock(const BlockRegistry::Key &key,
+                                            const boost::filesystem::path &path,
+                                            const std::size_t size,
+                                            std::shared_ptr<const Block> block)
+    {
+        auto shared = BlockRegistry::GetInstance().Share(key, block);
+        if (shared != block)
+        {
+            util::SimpleLogger().Write() << "sharing " << size / (1024 * 1024) << " MB of "
+                                         << path.string() << " with another dataset";
+        }
+        return shared;
+    }
+
+    template <typename Block>
+    BlockRegistry::Key MakeBlockKey(const boost::filesystem::path &path,
+                                    const FileContents &source) const
+    {
+        // the block type tells the file contents and the nodes loaded from the same file apart
+        return BlockRegistry::MakeKey(block_domain,
+                                      path.extension().string() + ":" + typeid(Block).name(),
+                                      source.data,
+                                      source.size);
+    }
+
     void LoadProfileProperties(const boost::filesystem::path &properties_path)
     {
-        boost::filesystem::ifstream in_stream(properties_path);
+        const auto stream = OpenFile(properties_path);
+        auto &in_stream = *stream;
         if (!in_stream)
         {
             throw util::exception("Could not open " + properties_path.string() + " for reading.");
         }
 
+        // files of older versions are shorter and leave the new fields at their defaults
         in_stream.read(reinterpret_cast<char *>(&m_profile_properties),
                        sizeof(m_profile_properties));
     }
 
     void LoadLaneTupelIdPairs(const boost::filesystem::path &lane_data_path)
     {
-        boost::filesystem::ifstream in_stream(lane_data_path);
+        const auto stream = OpenFile(lane_data_path);
+        auto &in_stream = *stream;
         if (!in_stream)
         {
             throw util::exception("Could not open " + lane_data_path.string() + " for reading.");
@@ -140,7 +329,8 @@ class InternalDataFacade final : public BaseDataFacade
     void LoadTimestamp(const boost::filesystem::path &timestamp_path)
     {
         util::SimpleLogger().Write() << "Loading Timestamp";
-        boost::filesystem::ifstream timestamp_stream(timestamp_path);
+        const auto stream = OpenFile(timestamp_path);
+        auto &timestamp_stream = *stream;
         if (!timestamp_stream)
         {
             throw util::exception("Could not open " + timestamp_path.string() + " for reading.");
@@ -148,47 +338,155 @@ class InternalDataFacade final : public BaseDataFacade
         getline(timestamp_stream, m_timestamp);
     }
 
-    void LoadGraph(const boost::filesystem::path &hsgr_path)
+    // The .hsgr and the .mldgr of osrm-customize share their layout
+    std::unique_ptr<QueryGraph> ReadQueryGraph(const boost::filesystem::path &graph_path,
+                                               unsigned &check_sum)
     {
-        util::ShM<QueryGraph::NodeArrayEntry, false>::vector node_list;
-        util::ShM<QueryGraph::EdgeArrayEntry, false>::vector edge_list;
+        auto contents = LoadFile(graph_path);
+        FileCursor cursor(*contents, graph_path);
+        const auto fingerprint_loaded = cursor.Read<util::FingerPrint>();
+        if (!fingerprint_loaded.TestGraphUtil(util::FingerPrint::GetValid()))
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << graph_path.extension().string() << " was prepared with different build.\n"
+                                                      "Reprocess to get rid of this warning.";
+        }
+        check_sum = cursor.Read<unsigned>();
+        const auto number_of_nodes = cursor.Read<unsigned>();
+        BOOST_ASSERT_MSG(0 != number_of_nodes, "number of nodes is zero");
+        const auto number_of_edges = cursor.Read<unsigned>();
+
+        util::ShM<QueryGraph::NodeArrayEntry, true>::vector node_list(
+            cursor.Next<QueryGraph::NodeArrayEntry>(number_of_nodes), number_of_nodes);
+        util::ShM<contractor::QueryEdgeSearchData, true>::vector search_edge_list(
+            cursor.Next<contractor::QueryEdgeSearchData>(number_of_edges), number_of_edges);
+        util::ShM<contractor::QueryEdgeUnpackData, true>::vector unpack_edge_list(
+            cursor.Next<contractor::QueryEdgeUnpackData>(number_of_edges), number_of_edges);
 
+        util::SimpleLogger().Write() << "loaded " << node_list.size() << " nodes and "
+                                     << search_edge_list.size() << " edges";
+        m_file_contents.push_back(std::move(contents));
+        return util::make_unique<QueryGraph>(node_list, search_edge_list, unpack_edge_list);
+    }
+
+    void LoadGraph(const boost::filesystem::path &hsgr_path)
+    {
         util::SimpleLogger().Write() << "loading graph from " << hsgr_path.string();
+        m_query_graph = ReadQueryGraph(hsgr_path, m_check_sum);
+        m_number_of_nodes = m_query_graph->GetNumberOfNodes() + 1;
+        util::SimpleLogger().Write() << "Data checksum is " << m_check_sum;
+    }
 
-        m_number_of_nodes = readHSGRFromStream(hsgr_path, node_list, edge_list, &m_check_sum);
+    void LoadMultiLevelData(const boost::filesystem::path &mld_graph_path,
+                            const boost::filesystem::path &cells_path)
+    {
+        if (!HasFile(mld_graph_path) || !HasFile(cells_path))
+        {
+            throw util::exception("Multi-level routing needs " + mld_graph_path.string() +
+                                  " and " + cells_path.string() + ", run osrm-customize first");
+        }
 
-        BOOST_ASSERT_MSG(0 != node_list.size(), "node list empty");
-        // BOOST_ASSERT_MSG(0 != edge_list.size(), "edge list empty");
-        util::SimpleLogger().Write() << "loaded " << node_list.size() << " nodes and "
-                                     << edge_list.size() << " edges";
-        m_query_graph = std::unique_ptr<QueryGraph>(new QueryGraph(node_list, edge_list));
+        unsigned check_sum = 0;
+        m_multi_level_graph = ReadQueryGraph(mld_graph_path, check_sum);
 
-        BOOST_ASSERT_MSG(0 == node_list.size(), "node list not flushed");
-        BOOST_ASSERT_MSG(0 == edge_list.size(), "edge list not flushed");
-        util::SimpleLogger().Write() << "Data checksum is " << m_check_sum;
+        auto contents = LoadFile(cells_path);
+        FileCursor cursor(*contents, cells_path);
+        if (!util::FingerPrint::GetValid().IsMagicNumberOK(cursor.Read<util::FingerPrint>()))
+        {
+            throw util::exception(cells_path.string() + " was written by an incompatible version");
+        }
+        const auto header = cursor.Read<partition::CellStorageHeader>();
+        if (header.number_of_nodes != m_multi_level_graph->GetNumberOfNodes() ||
+            (header.number_of_named_weights > 0 &&
+             header.number_of_edges != m_multi_level_graph->GetNumberOfEdges()))
+        {
+            throw util::exception(cells_path.string() + " does not match " +
+                                  mld_graph_path.string());
+        }
+        const auto cells = cursor.Next<partition::CellData>(header.number_of_cells);
+        const auto level_offsets = cursor.Next<std::uint32_t>(header.GetNumberOfLevelOffsets());
+        const auto node_cells = cursor.Next<partition::CellID>(header.GetNumberOfNodeCells());
+        const auto sources = cursor.Next<NodeID>(header.number_of_sources);
+        const auto destinations = cursor.Next<NodeID>(header.number_of_destinations);
+        const auto weights = cursor.Next<EdgeWeight>(header.GetNumberOfMetricWeights());
+        const auto edge_weights = cursor.Next<EdgeWeight>(header.GetNumberOfEdgeWeights());
+        const auto metric_edge_weights =
+            cursor.Next<std::uint32_t>(header.GetNumberOfMetricEdgeWeights());
+        const auto exclude_masks = cursor.Next<extractor::ClassData>(header.number_of_metrics);
+        const auto node_classes = cursor.Next<extractor::ClassData>(header.number_of_node_classes);
+        const auto class_names = cursor.Next<char>(header.class_names_size);
+        const auto edge_weight_names = cursor.Next<char>(header.edge_weight_names_size);
+        const bool has_named_weights = header.number_of_named_weights > 0;
+        m_cell_storage =
+            partition::CellStorageView(header.number_of_levels,
+                                       header.number_of_nodes,
+                                       node_cells,
+                                       level_offsets,
+                                       cells,
+                                       sources,
+                                       destinations,
+                                       weights,
+                                       header.number_of_weights,
+                                       header.number_of_metrics,
+                                       exclude_masks,
+                                       header.number_of_node_classes > 0 ? node_classes : nullptr,
+                                       header.class_names_size > 0 ? class_names : nullptr,
+                                       header.class_names_size,
+                                       has_named_weights ? edge_weights : nullptr,
+                                       header.number_of_edges,
+                                       has_named_weights ? metric_edge_weights : nullptr,
+                                       has_named_weights ? edge_weight_names : nullptr,
+                                       header.edge_weight_names_size);
+        m_file_contents.push_back(std::move(contents));
+        util::SimpleLogger().Write() << "loaded " << header.number_of_levels << " levels with "
+                                     << header.number_of_cells << " cells and "
+                                     << header.number_of_metrics << " metrics";
     }
 
     void LoadNodeAndEdgeInformation(const boost::filesystem::path &nodes_file,
                                     const boost::filesystem::path &edges_file)
     {
-        boost::filesystem::ifstream nodes_input_stream(nodes_file, std::ios::binary);
-
-        extractor::QueryNode current_node;
-        unsigned number_of_coordinates = 0;
-        nodes_input_stream.read((char *)&number_of_coordinates, sizeof(unsigned));
-        m_coordinate_list.resize(number_of_coordinates);
-        m_osmnodeid_list.reserve(number_of_coordinates);
-        for (unsigned i = 0; i < number_of_coordinates; ++i)
+        // the records are split into one vector per field, so they are copied in any case and
+        // only the copy is shared
+        const auto nodes_contents = LoadFile(nodes_file, false);
+        const bool share_nodes = share_blocks && !m_container;
+        BlockRegistry::Key nodes_key;
+        if (share_nodes)
         {
-            nodes_input_stream.read((char *)&current_node, sizeof(extractor::QueryNode));
-            m_coordinate_list[i] = util::Coordinate(current_node.lon, current_node.lat);
-            m_osmnodeid_list.push_back(current_node.node_id);
-            BOOST_ASSERT(m_coordinate_list[i].IsValid());
+            nodes_key = MakeBlockKey<NodeData>(nodes_file, *nodes_contents);
+            m_node_data = BlockRegistry::GetInstance().Find<NodeData>(nodes_key);
+        }
+        if (m_node_data)
+        {
+            util::SimpleLogger().Write() << "sharing the " << m_node_data->coordinates.size()
+                                         << " nodes of " << nodes_file.string()
+                                         << " with another dataset";
+        }
+        else
+        {
+            auto node_data = std::make_shared<NodeData>();
+            FileCursor nodes_cursor(*nodes_contents, nodes_file);
+            const auto number_of_coordinates = nodes_cursor.Read<unsigned>();
+            node_data->coordinates.resize(number_of_coordinates);
+            node_data->osm_node_ids.reserve(number_of_coordinates);
+            for (unsigned i = 0; i < number_of_coordinates; ++i)
+            {
+                const auto current_node = nodes_cursor.Read<extractor::QueryNode>();
+                node_data->coordinates[i] = util::Coordinate(current_node.lon, current_node.lat);
+                node_data->osm_node_ids.push_back(current_node.node_id);
+                BOOST_ASSERT(node_data->coordinates[i].IsValid());
+            }
+            m_node_data = std::move(node_data);
+            if (share_nodes)
+            {
+                m_node_data =
+                    ShareBlock<NodeData>(nodes_key, nodes_file, nodes_contents->size, m_node_data);
+            }
         }
 
-        boost::filesystem::ifstream edges_input_stream(edges_file, std::ios::binary);
-        unsigned number_of_edges = 0;
-        edges_input_stream.read((char *)&number_of_edges, sizeof(unsigned));
+        const auto edges_contents = LoadFile(edges_file);
+        FileCursor edges_cursor(*edges_contents, edges_file);
+        const auto number_of_edges = edges_cursor.Read<unsigned>();
         m_via_node_list.resize(number_of_edges);
         m_name_ID_list.resize(number_of_edges);
         m_turn_instruction_list.resize(number_of_edges);
@@ -196,11 +494,9 @@ class InternalDataFacade final : public BaseDataFacade
         m_travel_mode_list.resize(number_of_edges);
         m_entry_class_id_list.resize(number_of_edges);
 
-        extractor::OriginalEdgeData current_edge_data;
         for (unsigned i = 0; i < number_of_edges; ++i)
         {
-            edges_input_stream.read((char *)&(current_edge_data),
-                                    sizeof(extractor::OriginalEdgeData));
+            const auto current_edge_data = edges_cursor.Read<extractor::OriginalEdgeData>();
             m_via_node_list[i] = current_edge_data.via_node;
             m_name_ID_list[i] = current_edge_data.name_id;
             m_turn_instruction_list[i] = current_edge_data.turn_instruction;
@@ -212,7 +508,8 @@ class InternalDataFacade final : public BaseDataFacade
 
     void LoadCoreInformation(const boost::filesystem::path &core_data_file)
     {
-        std::ifstream core_stream(core_data_file.string().c_str(), std::ios::binary);
+        const auto stream = OpenFile(core_data_file);
+        auto &core_stream = *stream;
         unsigned number_of_markers;
         core_stream.read((char *)&number_of_markers, sizeof(unsigned));
 
@@ -225,64 +522,135 @@ class InternalDataFacade final : public BaseDataFacade
             return;
         }
 
-        m_is_core_node.resize(number_of_markers);
-        for (auto i = 0u; i < number_of_markers; ++i)
-        {
-            BOOST_ASSERT(unpacked_core_markers[i] == 0 || unpacked_core_markers[i] == 1);
-            m_is_core_node[i] = unpacked_core_markers[i] == 1;
-        }
+        m_core_marker_words.resize(util::PackedBitsetView::GetNumberOfWords(number_of_markers));
+        util::PackedBitsetView::Pack(
+            unpacked_core_markers.data(), number_of_markers, m_core_marker_words.data());
+        m_core_markers = util::PackedBitsetView(m_core_marker_words.data(), number_of_markers);
     }
 
-    void LoadGeometries(const boost::filesystem::path &geometry_file)
+    void LoadLandmarks(const boost::filesystem::path &landmarks_data_file)
     {
-        std::ifstream geometry_stream(geometry_file.string().c_str(), std::ios::binary);
-        unsigned number_of_indices = 0;
-        unsigned number_of_compressed_geometries = 0;
-
-        geometry_stream.read((char *)&number_of_indices, sizeof(unsigned));
+        // the landmarks are optional, older datasets don't have them
+        if (!HasFile(landmarks_data_file))
+        {
+            return;
+        }
 
-        m_geometry_indices.resize(number_of_indices);
-        if (number_of_indices > 0)
+        const auto stream = OpenFile(landmarks_data_file);
+        auto &landmarks_stream = *stream;
+        unsigned number_of_core_nodes = 0;
+        landmarks_stream.read((char *)&m_number_of_landmarks, sizeof(unsigned));
+        landmarks_stream.read((char *)&number_of_core_nodes, sizeof(unsigned));
+        if (m_number_of_landmarks == 0)
         {
-            geometry_stream.read((char *)&(m_geometry_indices[0]),
-                                 number_of_indices * sizeof(unsigned));
+            return;
         }
 
-        geometry_stream.read((char *)&number_of_compressed_geometries, sizeof(unsigned));
+        // the ids of the landmarks themselves are not needed for queries
+        landmarks_stream.ignore(sizeof(NodeID) * m_number_of_landmarks);
+        m_landmark_core_nodes.resize(number_of_core_nodes);
+        landmarks_stream.read((char *)m_landmark_core_nodes.data(),
+                              sizeof(NodeID) * number_of_core_nodes);
+        m_landmark_distances.resize(std::size_t{2} * m_number_of_landmarks *
+                                    number_of_core_nodes);
+        landmarks_stream.read((char *)m_landmark_distances.data(),
+                              sizeof(EdgeWeight) * m_landmark_distances.size());
+    }
 
-        BOOST_ASSERT(m_geometry_indices.back() == number_of_compressed_geometries);
-        m_geometry_list.resize(number_of_compressed_geometries);
+    void LoadHubLabels(const boost::filesystem::path &hub_labels_data_file)
+    {
+        // the hub labels are optional, older datasets don't have them
+        if (!HasFile(hub_labels_data_file))
+        {
+            return;
+        }
 
-        if (number_of_compressed_geometries > 0)
+        const auto stream = OpenFile(hub_labels_data_file);
+        auto &hub_labels_stream = *stream;
+        unsigned number_of_nodes = 0;
+        std::uint64_t number_of_entries = 0;
+        hub_labels_stream.read((char *)&number_of_nodes, sizeof(unsigned));
+        hub_labels_stream.read((char *)&number_of_entries, sizeof(std::uint64_t));
+        if (number_of_nodes == 0)
         {
-            geometry_stream.read((char *)&(m_geometry_list[0]),
-                                 number_of_compressed_geometries *
-                                     sizeof(extractor::CompressedEdgeContainer::CompressedEdge));
+            return;
         }
+
+        m_hub_label_offsets.resize(std::size_t{2} * number_of_nodes + 1);
+        hub_labels_stream.read((char *)m_hub_label_offsets.data(),
+                               sizeof(std::uint64_t) * m_hub_label_offsets.size());
+        m_hub_label_hubs.resize(number_of_entries);
+        hub_labels_stream.read((char *)m_hub_label_hubs.data(), sizeof(NodeID) * number_of_entries);
+        m_hub_label_weights.resize(number_of_entries);
+        hub_labels_stream.read((char *)m_hub_label_weights.data(),
+                               sizeof(EdgeWeight) * number_of_entries);
     }
 
-    void LoadDatasourceInfo(const boost::filesystem::path &datasource_names_file,
-                            const boost::filesystem::path &datasource_indexes_file)
+    void LoadGeometries(const boost::filesystem::path &geometry_file)
     {
-        boost::filesystem::ifstream datasources_stream(datasource_indexes_file, std::ios::binary);
-        if (!datasources_stream)
+        auto contents = LoadFile(geometry_file);
+        FileCursor cursor(*contents, geometry_file);
+
+        const auto number_of_indices = cursor.Read<unsigned>();
+        m_geometry_indices.reset(cursor.Next<unsigned>(number_of_indices), number_of_indices);
+
+        const auto number_of_compressed_geometries = cursor.Read<unsigned>();
+        BOOST_ASSERT(m_geometry_indices[number_of_indices - 1] == number_of_compressed_geometries);
+        (void)number_of_compressed_geometries;
+
+        const auto number_of_blocks = cursor.Read<unsigned>();
+        cursor.Skip(extractor::detail::blockOffsetsPadding(number_of_indices));
+        m_geometry_block_offsets.reset(cursor.Next<std::uint64_t>(number_of_blocks),
+                                       number_of_blocks);
+
+        const auto number_of_bytes = cursor.Read<std::uint64_t>();
+        m_geometry_data.reset(cursor.Next<unsigned char>(number_of_bytes), number_of_bytes);
+        m_file_contents.push_back(std::move(contents));
+    }
+
+    void LoadGeometryZoomLevels(const boost::filesystem::path &zoom_levels_file)
+    {
+        // the zoom levels are optional, osrm-extract only writes them on request
+        if (!HasFile(zoom_levels_file))
         {
-            throw util::exception("Could not open " + datasource_indexes_file.string() +
-                                  " for reading!");
+            return;
         }
-        BOOST_ASSERT(datasources_stream);
 
-        std::uint64_t number_of_datasources = 0;
-        datasources_stream.read(reinterpret_cast<char *>(&number_of_datasources),
-                                sizeof(number_of_datasources));
-        if (number_of_datasources > 0)
+        auto contents = LoadFile(zoom_levels_file);
+        FileCursor cursor(*contents, zoom_levels_file);
+        const auto number_of_zoom_levels = cursor.Read<std::uint64_t>();
+        m_geometry_zoom_levels.reset(cursor.Next<std::uint8_t>(number_of_zoom_levels),
+                                     number_of_zoom_levels);
+        m_file_contents.push_back(std::move(contents));
+    }
+
+    void LoadGeometryLengths(const boost::filesystem::path &lengths_file)
+    {
+        // the lengths are optional, osrm-extract only writes them on request
+        if (!HasFile(lengths_file))
         {
-            m_datasource_list.resize(number_of_datasources);
-            datasources_stream.read(reinterpret_cast<char *>(&(m_datasource_list[0])),
-                                    number_of_datasources * sizeof(uint8_t));
+            return;
         }
 
-        boost::filesystem::ifstream datasourcenames_stream(datasource_names_file, std::ios::binary);
+        auto contents = LoadFile(lengths_file);
+        FileCursor cursor(*contents, lengths_file);
+        const auto number_of_lengths = cursor.Read<std::uint64_t>();
+        m_geometry_lengths.reset(cursor.Next<SegmentLength>(number_of_lengths), number_of_lengths);
+        m_file_contents.push_back(std::move(contents));
+    }
+
+    void LoadDatasourceInfo(const boost::filesystem::path &datasource_names_file,
+                            const boost::filesystem::path &datasource_indexes_file)
+    {
+        auto contents = LoadFile(datasource_indexes_file);
+        FileCursor cursor(*contents, datasource_indexes_file);
+        const auto number_of_datasources = cursor.Read<std::uint64_t>();
+        m_datasource_list.reset(cursor.Next<uint8_t>(number_of_datasources),
+                                number_of_datasources);
+        m_file_contents.push_back(std::move(contents));
+
+        const auto stream = OpenFile(datasource_names_file);
+        auto &datasourcenames_stream = *stream;
         if (!datasourcenames_stream)
         {
             throw util::exception("Could not open " + datasource_names_file.string() +
@@ -298,16 +666,18 @@ class InternalDataFacade final : public BaseDataFacade
 
     void LoadRTree()
     {
-        BOOST_ASSERT_MSG(!m_coordinate_list.empty(), "coordinates must be loaded before r-tree");
+        BOOST_ASSERT_MSG(m_node_data, "coordinates must be loaded before r-tree");
 
-        m_static_rtree.reset(new InternalRTree(ram_index_path, file_index_path, m_coordinate_list));
+        m_static_rtree.reset(
+            new InternalRTree(ram_index_path, file_index_path, m_node_data->coordinates));
+        m_static_rtree->SetLeafPrefetching(prefetch_rtree_leaves);
         m_geospatial_query.reset(
-            new InternalGeospatialQuery(*m_static_rtree, m_coordinate_list, *this));
+            new InternalGeospatialQuery(*m_static_rtree, m_node_data->coordinates, *this));
     }
 
     void LoadLaneDescriptions(const boost::filesystem::path &lane_description_file)
     {
-        if (!util::deserializeAdjacencyArray(lane_description_file.string(),
+        if (!util::deserializeAdjacencyArray(*OpenFile(lane_description_file),
                                              m_lane_description_offsets,
                                              m_lane_description_masks))
             util::SimpleLogger().Write(logWARNING) << "Failed to read turn lane descriptions from "
@@ -316,15 +686,20 @@ class InternalDataFacade final : public BaseDataFacade
 
     void LoadStreetNames(const boost::filesystem::path &names_file)
     {
-        boost::filesystem::ifstream name_stream(names_file, std::ios::binary);
-
-        name_stream >> m_name_table;
+        std::size_t name_table_size = 0;
+        {
+            const auto stream = OpenFile(names_file);
+            *stream >> m_name_table;
+            name_table_size = stream->tellg();
+        }
 
-        unsigned number_of_chars = 0;
-        name_stream.read((char *)&number_of_chars, sizeof(unsigned));
+        auto contents = LoadFile(names_file);
+        FileCursor cursor(*contents, names_file);
+        cursor.Skip(name_table_size);
+        const auto number_of_chars = cursor.Read<unsigned>();
         BOOST_ASSERT_MSG(0 != number_of_chars, "name file broken");
-        m_names_char_list.resize(number_of_chars + 1); //+1 gives sentinel element
-        name_stream.read((char *)&m_names_char_list[0], number_of_chars * sizeof(char));
+        m_names_char_list.reset(cursor.Next<char>(number_of_chars), number_of_chars);
+        m_file_contents.push_back(std::move(contents));
         if (0 == m_names_char_list.size())
         {
             util::SimpleLogger().Write(logWARNING) << "list of street names is empty";
@@ -333,7 +708,8 @@ class InternalDataFacade final : public BaseDataFacade
 
     void LoadIntersectionClasses(const boost::filesystem::path &intersection_class_file)
     {
-        std::ifstream intersection_stream(intersection_class_file.string(), std::ios::binary);
+        const auto stream = OpenFile(intersection_class_file);
+        auto &intersection_stream = *stream;
         if (!intersection_stream)
             throw util::exception("Could not open " + intersection_class_file.string() +
                                   " for reading.");
@@ -387,22 +763,52 @@ class InternalDataFacade final : public BaseDataFacade
         m_geospatial_query.reset();
     }
 
-    explicit InternalDataFacade(const storage::StorageConfig &config)
+    explicit InternalDataFacade(const storage::StorageConfig &config,
+                                const bool use_mmap = false,
+                                const bool prefetch_rtree_leaves_ = false,
+                                const bool prefetch_search_graph_ = false,
+                                const bool load_multi_level_data = false,
+                                const unsigned data_version_ = 0,
+                                const bool share_blocks_ = false,
+                                const std::size_t block_domain_ = 0)
+        : m_use_mmap(use_mmap), prefetch_rtree_leaves(prefetch_rtree_leaves_),
+          prefetch_search_graph(prefetch_search_graph_), data_version(data_version_),
+          share_blocks(share_blocks_), block_domain(block_domain_)
     {
+        if (!config.container_path.empty() && boost::filesystem::exists(config.container_path))
+        {
+            util::SimpleLogger().Write() << "loading container " << config.container_path.string();
+            m_container = util::make_unique<storage::ContainerFile>(config.container_path);
+        }
+
         ram_index_path = config.ram_index_path;
         file_index_path = config.file_index_path;
 
         util::SimpleLogger().Write() << "loading graph data";
         LoadGraph(config.hsgr_data_path);
 
+        if (load_multi_level_data)
+        {
+            util::SimpleLogger().Write() << "loading multi-level data";
+            LoadMultiLevelData(config.mld_graph_data_path, config.cells_data_path);
+        }
+
         util::SimpleLogger().Write() << "loading edge information";
         LoadNodeAndEdgeInformation(config.nodes_data_path, config.edges_data_path);
 
         util::SimpleLogger().Write() << "loading core information";
         LoadCoreInformation(config.core_data_path);
 
+        util::SimpleLogger().Write() << "loading landmarks";
+        LoadLandmarks(config.landmarks_data_path);
+
+        util::SimpleLogger().Write() << "loading hub labels";
+        LoadHubLabels(config.hub_labels_data_path);
+
         util::SimpleLogger().Write() << "loading geometries";
         LoadGeometries(config.geometries_path);
+        LoadGeometryZoomLevels(config.geometry_zoom_levels_path);
+        LoadGeometryLengths(config.geometry_lengths_path);
 
         util::SimpleLogger().Write() << "loading datasource info";
         LoadDatasourceInfo(config.datasource_names_path, config.datasource_indexes_path);
@@ -441,11 +847,21 @@ class InternalDataFacade final : public BaseDataFacade
 
     NodeID GetTarget(const EdgeID e) const override final { return m_query_graph->GetTarget(e); }
 
-    EdgeData &GetEdgeData(const EdgeID e) const override final
+    EdgeData GetEdgeData(const EdgeID e) const override final
     {
         return m_query_graph->GetEdgeData(e);
     }
 
+    const contractor::QueryEdgeSearchData &GetSearchData(const EdgeID e) const override final
+    {
+        return m_query_graph->GetSearchData(e);
+    }
+
+    contractor::QueryGraphView GetSearchGraph() const override final
+    {
+        return m_query_graph->GetView(prefetch_search_graph);
+    }
+
     EdgeID BeginEdges(const NodeID n) const override final { return m_query_graph->BeginEdges(n); }
 
     EdgeID EndEdges(const NodeID n) const override final { return m_query_graph->EndEdges(n); }
@@ -475,12 +891,12 @@ class InternalDataFacade final : public BaseDataFacade
     // node and edge information access
     util::Coordinate GetCoordinateOfNode(const unsigned id) const override final
     {
-        return m_coordinate_list[id];
+        return m_node_data->coordinates[id];
     }
 
     OSMNodeID GetOSMNodeIDOfNode(const unsigned id) const override final
     {
-        return m_osmnodeid_list.at(id);
+        return m_node_data->osm_node_ids.at(id);
     }
 
     extractor::guidance::TurnInstruction
@@ -609,34 +1025,39 @@ class InternalDataFacade final : public BaseDataFacade
             input_coordinate, bearing, bearing_range);
     }
 
+    PhantomNode SegmentPhantomNode(const util::Coordinate input_coordinate,
+                                   const PhantomNode &segment) const override final
+    {
+        BOOST_ASSERT(m_geospatial_query.get());
+
+        return m_geospatial_query->SegmentPhantomNode(input_coordinate, segment);
+    }
+
     unsigned GetCheckSum() const override final { return m_check_sum; }
 
+    // the files are only loaded once
+    unsigned GetDataVersion() const override final { return data_version; }
+
     unsigned GetNameIndexFromEdgeID(const unsigned id) const override final
     {
         return m_name_ID_list.at(id);
     }
 
-    std::string GetNameForID(const unsigned name_id) const override final
+    util::StringView GetNameForID(const unsigned name_id) const override final
     {
         if (std::numeric_limits<unsigned>::max() == name_id)
         {
-            return "";
+            return {};
         }
-        auto range = m_name_table.GetRange(name_id);
-
-        std::string result;
-        result.reserve(range.size());
-        if (range.begin() != range.end())
+        const auto range = m_name_table.GetRange(name_id);
+        if (range.size() == 0)
         {
-            result.resize(range.back() - range.front() + 1);
-            std::copy(m_names_char_list.begin() + range.front(),
-                      m_names_char_list.begin() + range.back() + 1,
-                      result.begin());
+            return {};
         }
-        return result;
+        return util::StringView(&m_names_char_list[range.front()], range.size());
     }
 
-    std::string GetRefForID(const unsigned name_id) const override final
+    util::StringView GetRefForID(const unsigned name_id) const override final
     {
         // We store the ref after the name, destination and pronunciation of a street.
         // We do this to get around the street length limit of 255 which would hit
@@ -645,7 +1066,7 @@ class InternalDataFacade final : public BaseDataFacade
         return GetNameForID(name_id + 3);
     }
 
-    std::string GetPronunciationForID(const unsigned name_id) const override final
+    util::StringView GetPronunciationForID(const unsigned name_id) const override final
     {
         // We store the pronunciation after the name and destination of a street.
         // We do this to get around the street length limit of 255 which would hit
@@ -654,7 +1075,7 @@ class InternalDataFacade final : public BaseDataFacade
         return GetNameForID(name_id + 2);
     }
 
-    std::string GetDestinationsForID(const unsigned name_id) const override final
+    util::StringView GetDestinationsForID(const unsigned name_id) const override final
     {
         // We store the destination after the name of a street.
         // We do this to get around the street length limit of 255 which would hit
@@ -668,49 +1089,94 @@ class InternalDataFacade final : public BaseDataFacade
         return m_via_node_list.at(id);
     }
 
-    virtual std::size_t GetCoreSize() const override final { return m_is_core_node.size(); }
+    virtual std::size_t GetCoreSize() const override final { return m_core_markers.Size(); }
 
-    virtual bool IsCoreNode(const NodeID id) const override final
+    virtual unsigned GetNumberOfLandmarks() const override final { return m_number_of_landmarks; }
+
+    virtual const EdgeWeight *GetLandmarkDistances(const NodeID id) const override final
     {
-        if (m_is_core_node.size() > 0)
+        const auto core_node =
+            std::lower_bound(m_landmark_core_nodes.begin(), m_landmark_core_nodes.end(), id);
+        if (core_node == m_landmark_core_nodes.end() || *core_node != id)
         {
-            return m_is_core_node[id];
+            return nullptr;
         }
-        else
+        const std::size_t rank = std::distance(m_landmark_core_nodes.begin(), core_node);
+        return &m_landmark_distances[rank * 2 * m_number_of_landmarks];
+    }
+
+    virtual bool HasMultiLevelData() const override final { return !!m_multi_level_graph; }
+
+    virtual contractor::QueryGraphView GetMultiLevelGraph() const override final
+    {
+        BOOST_ASSERT(m_multi_level_graph);
+        return m_multi_level_graph->GetView(prefetch_search_graph);
+    }
+
+    virtual EdgeData GetMultiLevelEdgeData(const EdgeID e) const override final
+    {
+        BOOST_ASSERT(m_multi_level_graph);
+        return m_multi_level_graph->GetEdgeData(e);
+    }
+
+    virtual const partition::CellStorageView &GetCellStorage() const override final
+    {
+        return m_cell_storage;
+    }
+
+    virtual bool HasHubLabels() const override final { return !m_hub_label_offsets.empty(); }
+
+    virtual HubLabel GetHubLabel(const NodeID id, const bool forward) const override final
+    {
+        HubLabel label;
+        if (m_hub_label_offsets.empty())
+        {
+            return label;
+        }
+        const std::size_t index = std::size_t{2} * id + (forward ? 0 : 1);
+        BOOST_ASSERT(index + 1 < m_hub_label_offsets.size());
+        const auto begin = m_hub_label_offsets[index];
+        label.size = m_hub_label_offsets[index + 1] - begin;
+        if (label.size > 0)
         {
-            return false;
+            label.hubs = &m_hub_label_hubs[begin];
+            label.weights = &m_hub_label_weights[begin];
         }
+        return label;
     }
 
+    virtual bool IsCoreNode(const NodeID id) const override final
+    {
+        return !m_core_markers.Empty() && m_core_markers.Test(id);
+    }
+
+    util::PackedBitsetView GetCoreMarkers() const override final { return m_core_markers; }
+
     virtual void GetUncompressedGeometry(const EdgeID id,
                                          std::vector<NodeID> &result_nodes) const override final
     {
-        const unsigned begin = m_geometry_indices.at(id);
-        const unsigned end = m_geometry_indices.at(id + 1);
-
         result_nodes.clear();
-        result_nodes.reserve(end - begin);
-        std::for_each(m_geometry_list.begin() + begin,
-                      m_geometry_list.begin() + end,
-                      [&](const osrm::extractor::CompressedEdgeContainer::CompressedEdge &edge) {
-                          result_nodes.emplace_back(edge.node_id);
-                      });
+        result_nodes.reserve(m_geometry_indices.at(id + 1) - m_geometry_indices.at(id));
+        extractor::decodeCompressedGeometry(
+            m_geometry_indices,
+            m_geometry_block_offsets,
+            m_geometry_data,
+            id,
+            [&](const NodeID node, const EdgeWeight) { result_nodes.push_back(node); });
     }
 
     virtual void
     GetUncompressedWeights(const EdgeID id,
                            std::vector<EdgeWeight> &result_weights) const override final
     {
-        const unsigned begin = m_geometry_indices.at(id);
-        const unsigned end = m_geometry_indices.at(id + 1);
-
         result_weights.clear();
-        result_weights.reserve(end - begin);
-        std::for_each(m_geometry_list.begin() + begin,
-                      m_geometry_list.begin() + end,
-                      [&](const osrm::extractor::CompressedEdgeContainer::CompressedEdge &edge) {
-                          result_weights.emplace_back(edge.weight);
-                      });
+        result_weights.reserve(m_geometry_indices.at(id + 1) - m_geometry_indices.at(id));
+        extractor::decodeCompressedGeometry(
+            m_geometry_indices,
+            m_geometry_block_offsets,
+            m_geometry_data,
+            id,
+            [&](const NodeID, const EdgeWeight weight) { result_weights.push_back(weight); });
     }
 
     // Returns the data source ids that were used to supply the edge
@@ -742,7 +1208,46 @@ class InternalDataFacade final : public BaseDataFacade
         }
     }
 
-    virtual std::string GetDatasourceName(const uint8_t datasource_name_id) const override final
+    virtual void
+    GetUncompressedZoomLevels(const EdgeID id,
+                              std::vector<std::uint8_t> &result_zoom_levels) const override final
+    {
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+
+        // without precomputed levels the simplification runs on all nodes
+        if (m_geometry_zoom_levels.empty())
+        {
+            result_zoom_levels.assign(end - begin, 0);
+        }
+        else
+        {
+            result_zoom_levels.assign(m_geometry_zoom_levels.begin() + begin,
+                                      m_geometry_zoom_levels.begin() + end);
+        }
+    }
+
+    virtual void
+    GetUncompressedLengths(const EdgeID id,
+                           std::vector<SegmentLength> &result_lengths) const override final
+    {
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+
+        // without precomputed lengths the callers measure the segments themselves
+        if (m_geometry_lengths.empty())
+        {
+            result_lengths.assign(end - begin, INVALID_SEGMENT_LENGTH);
+        }
+        else
+        {
+            result_lengths.assign(m_geometry_lengths.begin() + begin,
+                                  m_geometry_lengths.begin() + end);
+        }
+    }
+
+    virtual util::StringView
+    GetDatasourceName(const uint8_t datasource_name_id) const override final
     {
         BOOST_ASSERT(m_datasource_names.size() >= 1);
         BOOST_ASSERT(m_datasource_names.size() > datasource_name_id);
@@ -751,11 +1256,52 @@ class InternalDataFacade final : public BaseDataFacade
 
     std::string GetTimestamp() const override final { return m_timestamp; }
 
+    // the container or the files read or mapped, and the r-tree leaves
+    std::vector<util::MemoryRegion> GetMemoryRegions() const override final
+    {
+        std::vector<util::MemoryRegion> regions;
+        if (m_container)
+        {
+            const auto contents = m_container->GetContents();
+            regions.push_back(util::MemoryRegion{contents.data, contents.size});
+        }
+        for (const auto &contents : m_file_contents)
+        {
+            // sections of the container are part of it already
+            if (contents->mapping.is_open() || !contents->buffer.empty())
+            {
+                regions.push_back(util::MemoryRegion{contents->data, contents->size});
+            }
+        }
+        regions.push_back(m_static_rtree->GetLeafRegion());
+        return regions;
+    }
+
+    std::vector<util::NamedMemoryRegion> GetMemoryBlocks() const override final
+    {
+        std::vector<util::NamedMemoryRegion> blocks;
+        for (const auto &contents : m_file_contents)
+        {
+            if (contents->size > 0)
+            {
+                blocks.push_back(util::NamedMemoryRegion{
+                    contents->name, util::MemoryRegion{contents->data, contents->size}});
+            }
+        }
+        blocks.push_back(util::NamedMemoryRegion{".fileIndex", m_static_rtree->GetLeafRegion()});
+        return blocks;
+    }
+
     bool GetContinueStraightDefault() const override final
     {
         return m_profile_properties.continue_straight_at_waypoint;
     }
 
+    bool HasOrderedComponentIDs() const override final
+    {
+        return m_profile_properties.component_ids_in_topological_order;
+    }
+
     BearingClassID GetBearingClassID(const NodeID nid) const override final
     {
         return m_bearing_class_id_table.at(nid);
@@ -3,11 +3,14 @@
 
 // implements all data storage when shared memory _IS_ used
 
+#include "storage/shared_dataset.hpp"
 #include "storage/shared_datatype.hpp"
 #include "storage/shared_memory.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
 
+#include "contractor/query_graph.hpp"
 #include "extractor/compressed_edge_container.hpp"
+#include "extractor/compressed_geometry.hpp"
 #include "extractor/guidance/turn_instruction.hpp"
 #include "extractor/guidance/turn_lane_types.hpp"
 #include "extractor/profile_properties.hpp"
@@ -17,16 +20,18 @@
 
 #include "engine/geospatial_query.hpp"
 #include "util/make_unique.hpp"
+#include "util/packed_bitset.hpp"
 #include "util/range_table.hpp"
 #include "util/rectangle.hpp"
 #include "util/simple_logger.hpp"
-#include "util/static_graph.hpp"
 #include "util/static_rtree.hpp"
 #include "util/typedefs.hpp"
 
 #include <cstddef>
+#include <cstdint>
 
 #include <algorithm>
+#include <chrono>
 #include <iterator>
 #include <limits>
 #include <memory>
@@ -35,8 +40,6 @@
 #include <vector>
 
 #include <boost/assert.hpp>
-#include <boost/thread/lock_guard.hpp>
-#include <boost/thread/shared_mutex.hpp>
 #include <boost/thread/tss.hpp>
 
 namespace osrm
@@ -51,11 +54,11 @@ class SharedDataFacade final : public BaseDataFacade
 
   private:
     using super = BaseDataFacade;
-    using QueryGraph = util::StaticGraph<EdgeData, true>;
+    using QueryGraph = contractor::QueryGraph<true>;
     using GraphNode = QueryGraph::NodeArrayEntry;
-    using GraphEdge = QueryGraph::EdgeArrayEntry;
+    using GraphSearchEdge = contractor::QueryEdgeSearchData;
+    using GraphUnpackEdge = contractor::QueryEdgeUnpackData;
     using IndexBlock = util::RangeTable<16, true>::BlockT;
-    using InputEdge = QueryGraph::InputEdge;
     using RTreeLeaf = super::RTreeLeaf;
     using SharedRTree =
         util::StaticRTree<RTreeLeaf, util::ShM<util::Coordinate, true>::vector, true>;
@@ -64,16 +67,17 @@ class SharedDataFacade final : public BaseDataFacade
 
     storage::SharedDataLayout *data_layout;
     char *shared_memory;
-    storage::SharedDataTimestamp *data_timestamp_ptr;
-
-    storage::SharedDataType CURRENT_LAYOUT;
-    storage::SharedDataType CURRENT_DATA;
-    unsigned CURRENT_TIMESTAMP;
 
     unsigned m_check_sum;
     std::unique_ptr<QueryGraph> m_query_graph;
+    // only loaded for multi-level searches
+    std::unique_ptr<QueryGraph> m_multi_level_graph;
+    partition::CellStorageView m_cell_storage;
+    // released after the regions are detached
+    storage::SharedDatasetReference m_dataset;
     std::unique_ptr<storage::SharedMemory> m_layout_memory;
     std::unique_ptr<storage::SharedMemory> m_large_memory;
+    std::chrono::nanoseconds m_mapping_duration;
     std::string m_timestamp;
     extractor::ProfileProperties *m_profile_properties;
 
@@ -87,9 +91,18 @@ class SharedDataFacade final : public BaseDataFacade
     util::ShM<char, true>::vector m_names_char_list;
     util::ShM<unsigned, true>::vector m_name_begin_indices;
     util::ShM<unsigned, true>::vector m_geometry_indices;
-    util::ShM<extractor::CompressedEdgeContainer::CompressedEdge, true>::vector m_geometry_list;
-    util::ShM<bool, true>::vector m_is_core_node;
+    util::ShM<std::uint64_t, true>::vector m_geometry_block_offsets;
+    util::ShM<unsigned char, true>::vector m_geometry_data;
+    util::PackedBitsetView m_core_markers;
+    unsigned m_number_of_landmarks = 0;
+    util::ShM<NodeID, true>::vector m_landmark_core_nodes;
+    util::ShM<EdgeWeight, true>::vector m_landmark_distances;
+    util::ShM<std::uint64_t, true>::vector m_hub_label_offsets;
+    util::ShM<NodeID, true>::vector m_hub_label_hubs;
+    util::ShM<EdgeWeight, true>::vector m_hub_label_weights;
     util::ShM<uint8_t, true>::vector m_datasource_list;
+    util::ShM<std::uint8_t, true>::vector m_geometry_zoom_levels;
+    util::ShM<SegmentLength, true>::vector m_geometry_lengths;
     util::ShM<std::uint32_t, true>::vector m_lane_description_offsets;
     util::ShM<extractor::guidance::TurnLaneType::Mask, true>::vector m_lane_description_masks;
 
@@ -101,6 +114,8 @@ class SharedDataFacade final : public BaseDataFacade
     std::unique_ptr<SharedRTree> m_static_rtree;
     std::unique_ptr<SharedGeospatialQuery> m_geospatial_query;
     boost::filesystem::path file_index_path;
+    bool prefetch_rtree_leaves = false;
+    bool prefetch_search_graph = false;
 
     std::shared_ptr<util::RangeTable<16, true>> m_name_table;
 
@@ -150,6 +165,7 @@ class SharedDataFacade final : public BaseDataFacade
                             data_layout->num_entries[storage::SharedDataLayout::R_SEARCH_TREE],
                             file_index_path,
                             m_coordinate_list));
+        m_static_rtree->SetLeafPrefetching(prefetch_rtree_leaves);
         m_geospatial_query.reset(
             new SharedGeospatialQuery(*m_static_rtree, m_coordinate_list, *this));
     }
@@ -159,14 +175,105 @@ class SharedDataFacade final : public BaseDataFacade
         auto graph_nodes_ptr = data_layout->GetBlockPtr<GraphNode>(
             shared_memory, storage::SharedDataLayout::GRAPH_NODE_LIST);
 
-        auto graph_edges_ptr = data_layout->GetBlockPtr<GraphEdge>(
-            shared_memory, storage::SharedDataLayout::GRAPH_EDGE_LIST);
+        auto graph_search_edges_ptr = data_layout->GetBlockPtr<GraphSearchEdge>(
+            shared_memory, storage::SharedDataLayout::GRAPH_SEARCH_EDGE_LIST);
+
+        auto graph_unpack_edges_ptr = data_layout->GetBlockPtr<GraphUnpackEdge>(
+            shared_memory, storage::SharedDataLayout::GRAPH_UNPACK_EDGE_LIST);
 
         util::ShM<GraphNode, true>::vector node_list(
             graph_nodes_ptr, data_layout->num_entries[storage::SharedDataLayout::GRAPH_NODE_LIST]);
-        util::ShM<GraphEdge, true>::vector edge_list(
-            graph_edges_ptr, data_layout->num_entries[storage::SharedDataLayout::GRAPH_EDGE_LIST]);
-        m_query_graph.reset(new QueryGraph(node_list, edge_list));
+        util::ShM<GraphSearchEdge, true>::vector search_edge_list(
+            graph_search_edges_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::GRAPH_SEARCH_EDGE_LIST]);
+        util::ShM<GraphUnpackEdge, true>::vector unpack_edge_list(
+            graph_unpack_edges_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::GRAPH_UNPACK_EDGE_LIST]);
+        m_query_graph.reset(new QueryGraph(node_list, search_edge_list, unpack_edge_list));
+    }
+
+    void LoadMultiLevelData()
+    {
+        const auto number_of_levels =
+            data_layout->num_entries[storage::SharedDataLayout::MLD_LEVEL_OFFSETS];
+        if (number_of_levels == 0)
+        {
+            throw util::exception("Multi-level routing needs the .mldgr and .cells of "
+                                  "osrm-customize, which osrm-datastore did not load");
+        }
+
+        util::ShM<GraphNode, true>::vector node_list(
+            data_layout->GetBlockPtr<GraphNode>(shared_memory,
+                                                storage::SharedDataLayout::MLD_GRAPH_NODE_LIST),
+            data_layout->num_entries[storage::SharedDataLayout::MLD_GRAPH_NODE_LIST]);
+        util::ShM<GraphSearchEdge, true>::vector search_edge_list(
+            data_layout->GetBlockPtr<GraphSearchEdge>(
+                shared_memory, storage::SharedDataLayout::MLD_GRAPH_SEARCH_EDGE_LIST),
+            data_layout->num_entries[storage::SharedDataLayout::MLD_GRAPH_SEARCH_EDGE_LIST]);
+        util::ShM<GraphUnpackEdge, true>::vector unpack_edge_list(
+            data_layout->GetBlockPtr<GraphUnpackEdge>(
+                shared_memory, storage::SharedDataLayout::MLD_GRAPH_UNPACK_EDGE_LIST),
+            data_layout->num_entries[storage::SharedDataLayout::MLD_GRAPH_UNPACK_EDGE_LIST]);
+        m_multi_level_graph.reset(new QueryGraph(node_list, search_edge_list, unpack_edge_list));
+
+        // the level offsets have an entry past the last level, the weights of the metrics
+        // follow each other
+        const auto number_of_metrics =
+            data_layout->num_entries[storage::SharedDataLayout::MLD_EXCLUDE_MASKS];
+        const auto number_of_weights =
+            data_layout->num_entries[storage::SharedDataLayout::MLD_CELL_WEIGHTS] /
+            number_of_metrics;
+        const auto number_of_node_classes =
+            data_layout->num_entries[storage::SharedDataLayout::MLD_NODE_CLASSES];
+        const auto class_names_size =
+            data_layout->num_entries[storage::SharedDataLayout::MLD_CLASS_NAMES];
+        // the named edge weights follow each other with a weight for every edge of the graph
+        const auto number_of_metric_edge_weights =
+            data_layout->num_entries[storage::SharedDataLayout::MLD_METRIC_EDGE_WEIGHTS];
+        const auto edge_weight_names_size =
+            data_layout->num_entries[storage::SharedDataLayout::MLD_EDGE_WEIGHT_NAMES];
+        m_cell_storage = partition::CellStorageView(
+            static_cast<partition::LevelID>(number_of_levels - 1),
+            m_multi_level_graph->GetNumberOfNodes(),
+            data_layout->GetBlockPtr<partition::CellID>(shared_memory,
+                                                        storage::SharedDataLayout::MLD_NODE_CELLS),
+            data_layout->GetBlockPtr<std::uint32_t>(shared_memory,
+                                                    storage::SharedDataLayout::MLD_LEVEL_OFFSETS),
+            data_layout->GetBlockPtr<partition::CellData>(shared_memory,
+                                                          storage::SharedDataLayout::MLD_CELLS),
+            data_layout->GetBlockPtr<NodeID>(shared_memory,
+                                             storage::SharedDataLayout::MLD_CELL_SOURCES),
+            data_layout->GetBlockPtr<NodeID>(shared_memory,
+                                             storage::SharedDataLayout::MLD_CELL_DESTINATIONS),
+            data_layout->GetBlockPtr<EdgeWeight>(shared_memory,
+                                                 storage::SharedDataLayout::MLD_CELL_WEIGHTS),
+            number_of_weights,
+            static_cast<std::uint32_t>(number_of_metrics),
+            data_layout->GetBlockPtr<extractor::ClassData>(
+                shared_memory, storage::SharedDataLayout::MLD_EXCLUDE_MASKS),
+            number_of_node_classes > 0 ? data_layout->GetBlockPtr<extractor::ClassData>(
+                                             shared_memory,
+                                             storage::SharedDataLayout::MLD_NODE_CLASSES)
+                                       : nullptr,
+            class_names_size > 0
+                ? data_layout->GetBlockPtr<char>(shared_memory,
+                                                 storage::SharedDataLayout::MLD_CLASS_NAMES)
+                : nullptr,
+            static_cast<std::uint32_t>(class_names_size),
+            number_of_metric_edge_weights > 0
+                ? data_layout->GetBlockPtr<EdgeWeight>(shared_memory,
+                                                       storage::SharedDataLayout::MLD_EDGE_WEIGHTS)
+                : nullptr,
+            m_multi_level_graph->GetNumberOfEdges(),
+            number_of_metric_edge_weights > 0
+                ? data_layout->GetBlockPtr<std::uint32_t>(
+                      shared_memory, storage::SharedDataLayout::MLD_METRIC_EDGE_WEIGHTS)
+                : nullptr,
+            edge_weight_names_size > 0
+                ? data_layout->GetBlockPtr<char>(shared_memory,
+                                                 storage::SharedDataLayout::MLD_EDGE_WEIGHT_NAMES)
+                : nullptr,
+            static_cast<std::uint32_t>(edge_weight_names_size));
     }
 
     void LoadNodeAndEdgeInformation()
@@ -276,11 +383,51 @@ class SharedDataFacade final : public BaseDataFacade
 
     void LoadCoreInformation()
     {
-        auto core_marker_ptr = data_layout->GetBlockPtr<unsigned>(
+        auto core_marker_ptr = data_layout->GetBlockPtr<util::PackedBitsetView::Word>(
             shared_memory, storage::SharedDataLayout::CORE_MARKER);
-        util::ShM<bool, true>::vector is_core_node(
+        m_core_markers = util::PackedBitsetView(
             core_marker_ptr, data_layout->num_entries[storage::SharedDataLayout::CORE_MARKER]);
-        m_is_core_node = std::move(is_core_node);
+    }
+
+    void LoadLandmarks()
+    {
+        auto core_nodes_ptr = data_layout->GetBlockPtr<NodeID>(
+            shared_memory, storage::SharedDataLayout::LANDMARK_CORE_NODES);
+        const auto number_of_core_nodes =
+            data_layout->num_entries[storage::SharedDataLayout::LANDMARK_CORE_NODES];
+        util::ShM<NodeID, true>::vector core_nodes(core_nodes_ptr, number_of_core_nodes);
+        m_landmark_core_nodes = std::move(core_nodes);
+
+        auto distances_ptr = data_layout->GetBlockPtr<EdgeWeight>(
+            shared_memory, storage::SharedDataLayout::LANDMARK_DISTANCES);
+        const auto number_of_distances =
+            data_layout->num_entries[storage::SharedDataLayout::LANDMARK_DISTANCES];
+        util::ShM<EdgeWeight, true>::vector distances(distances_ptr, number_of_distances);
+        m_landmark_distances = std::move(distances);
+
+        m_number_of_landmarks =
+            number_of_core_nodes > 0 ? number_of_distances / (2 * number_of_core_nodes) : 0;
+    }
+
+    void LoadHubLabels()
+    {
+        auto offsets_ptr = data_layout->GetBlockPtr<std::uint64_t>(
+            shared_memory, storage::SharedDataLayout::HUB_LABEL_OFFSETS);
+        util::ShM<std::uint64_t, true>::vector offsets(
+            offsets_ptr, data_layout->num_entries[storage::SharedDataLayout::HUB_LABEL_OFFSETS]);
+        m_hub_label_offsets = std::move(offsets);
+
+        const auto number_of_entries =
+            data_layout->num_entries[storage::SharedDataLayout::HUB_LABEL_HUBS];
+        auto hubs_ptr = data_layout->GetBlockPtr<NodeID>(
+            shared_memory, storage::SharedDataLayout::HUB_LABEL_HUBS);
+        util::ShM<NodeID, true>::vector hubs(hubs_ptr, number_of_entries);
+        m_hub_label_hubs = std::move(hubs);
+
+        auto weights_ptr = data_layout->GetBlockPtr<EdgeWeight>(
+            shared_memory, storage::SharedDataLayout::HUB_LABEL_WEIGHTS);
+        util::ShM<EdgeWeight, true>::vector weights(weights_ptr, number_of_entries);
+        m_hub_label_weights = std::move(weights);
     }
 
     void LoadGeometries()
@@ -292,13 +439,19 @@ class SharedDataFacade final : public BaseDataFacade
             data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_INDEX]);
         m_geometry_indices = std::move(geometry_begin_indices);
 
-        auto geometries_list_ptr =
-            data_layout->GetBlockPtr<extractor::CompressedEdgeContainer::CompressedEdge>(
-                shared_memory, storage::SharedDataLayout::GEOMETRIES_LIST);
-        util::ShM<extractor::CompressedEdgeContainer::CompressedEdge, true>::vector geometry_list(
-            geometries_list_ptr,
-            data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_LIST]);
-        m_geometry_list = std::move(geometry_list);
+        auto geometries_block_offsets_ptr = data_layout->GetBlockPtr<std::uint64_t>(
+            shared_memory, storage::SharedDataLayout::GEOMETRIES_BLOCK_OFFSETS);
+        util::ShM<std::uint64_t, true>::vector geometry_block_offsets(
+            geometries_block_offsets_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_BLOCK_OFFSETS]);
+        m_geometry_block_offsets = std::move(geometry_block_offsets);
+
+        auto geometries_data_ptr = data_layout->GetBlockPtr<unsigned char>(
+            shared_memory, storage::SharedDataLayout::GEOMETRIES_DATA);
+        util::ShM<unsigned char, true>::vector geometry_data(
+            geometries_data_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_DATA]);
+        m_geometry_data = std::move(geometry_data);
 
         auto datasources_list_ptr = data_layout->GetBlockPtr<uint8_t>(
             shared_memory, storage::SharedDataLayout::DATASOURCES_LIST);
@@ -307,6 +460,19 @@ class SharedDataFacade final : public BaseDataFacade
             data_layout->num_entries[storage::SharedDataLayout::DATASOURCES_LIST]);
         m_datasource_list = std::move(datasources_list);
 
+        auto zoom_levels_ptr = data_layout->GetBlockPtr<std::uint8_t>(
+            shared_memory, storage::SharedDataLayout::GEOMETRIES_ZOOM_LEVELS);
+        util::ShM<std::uint8_t, true>::vector zoom_levels(
+            zoom_levels_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_ZOOM_LEVELS]);
+        m_geometry_zoom_levels = std::move(zoom_levels);
+
+        auto lengths_ptr = data_layout->GetBlockPtr<SegmentLength>(
+            shared_memory, storage::SharedDataLayout::GEOMETRIES_LENGTHS);
+        util::ShM<SegmentLength, true>::vector lengths(
+            lengths_ptr, data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_LENGTHS]);
+        m_geometry_lengths = std::move(lengths);
+
         auto datasource_name_data_ptr = data_layout->GetBlockPtr<char>(
             shared_memory, storage::SharedDataLayout::DATASOURCE_NAME_DATA);
         util::ShM<char, true>::vector datasource_name_data(
@@ -366,103 +532,78 @@ class SharedDataFacade final : public BaseDataFacade
   public:
     virtual ~SharedDataFacade() {}
 
-    boost::shared_mutex data_mutex;
-
-    SharedDataFacade()
+    // Attaches to the dataset osrm-datastore loaded last. The facade stays on this dataset, which
+    // is kept loaded for it, use IsCurrent to find out when to replace it with a new one.
+    explicit SharedDataFacade(const bool prefetch_rtree_leaves_ = false,
+                              const bool prefetch_search_graph_ = false,
+                              const bool load_multi_level_data = false)
+        : prefetch_rtree_leaves(prefetch_rtree_leaves_),
+          prefetch_search_graph(prefetch_search_graph_)
     {
-        if (!storage::SharedMemory::RegionExists(storage::CURRENT_REGIONS))
+        util::SimpleLogger().Write(logDEBUG) << "Loading data from shared memory";
+        const auto mapping_start = std::chrono::steady_clock::now();
+        m_layout_memory.reset(storage::makeSharedMemory(m_dataset.Layout()));
+
+        data_layout = static_cast<storage::SharedDataLayout *>(m_layout_memory->Ptr());
+
+        m_large_memory.reset(storage::makeSharedMemory(m_dataset.Data()));
+        shared_memory = (char *)(m_large_memory->Ptr());
+        if (data_layout->huge_page_size > 0)
         {
-            throw util::exception(
-                "No shared memory blocks found, have you forgotten to run osrm-datastore?");
+            util::SimpleLogger().Write() << "shared memory uses huge pages of "
+                                         << data_layout->huge_page_size << " bytes";
+        }
+        else
+        {
+            util::SimpleLogger().Write() << "shared memory uses the default pages";
         }
-        data_timestamp_ptr = static_cast<storage::SharedDataTimestamp *>(
-            storage::makeSharedMemory(
-                storage::CURRENT_REGIONS, sizeof(storage::SharedDataTimestamp), false, false)
-                ->Ptr());
-        CURRENT_LAYOUT = storage::LAYOUT_NONE;
-        CURRENT_DATA = storage::DATA_NONE;
-        CURRENT_TIMESTAMP = 0;
-
-        // load data
-        CheckAndReloadFacade();
-    }
 
-    void CheckAndReloadFacade()
-    {
-        if (CURRENT_LAYOUT != data_timestamp_ptr->layout ||
-            CURRENT_DATA != data_timestamp_ptr->data ||
-            CURRENT_TIMESTAMP != data_timestamp_ptr->timestamp)
+        const auto file_index_ptr = data_layout->GetBlockPtr<char>(
+            shared_memory, storage::SharedDataLayout::FILE_INDEX_PATH);
+        file_index_path = boost::filesystem::path(file_index_ptr);
+        if (!boost::filesystem::exists(file_index_path))
         {
-            // Get exclusive lock
-            util::SimpleLogger().Write(logDEBUG) << "Updates available, getting exclusive lock";
-            const boost::lock_guard<boost::shared_mutex> lock(data_mutex);
+            util::SimpleLogger().Write(logDEBUG) << "Leaf file name " << file_index_path.string();
+            throw util::exception("Could not load leaf index file. "
+                                  "Is any data loaded into shared memory?");
+        }
 
-            if (CURRENT_LAYOUT != data_timestamp_ptr->layout ||
-                CURRENT_DATA != data_timestamp_ptr->data)
-            {
-                // release the previous shared memory segments
-                storage::SharedMemory::Remove(CURRENT_LAYOUT);
-                storage::SharedMemory::Remove(CURRENT_DATA);
+        LoadGraph();
+        if (load_multi_level_data)
+        {
+            LoadMultiLevelData();
+        }
+        LoadChecksum();
+        LoadNodeAndEdgeInformation();
+        LoadGeometries();
+        LoadTimestamp();
+        LoadViaNodeList();
+        LoadNames();
+        LoadTurnLaneDescriptions();
+        LoadCoreInformation();
+        LoadLandmarks();
+        LoadHubLabels();
+        LoadProfileProperties();
+        LoadRTree();
+        LoadIntersectionClasses();
+        m_mapping_duration = std::chrono::steady_clock::now() - mapping_start;
+
+        util::SimpleLogger().Write() << "number of geometries: " << m_coordinate_list.size();
+        for (unsigned i = 0; i < m_coordinate_list.size(); ++i)
+        {
+            BOOST_ASSERT(GetCoordinateOfNode(i).IsValid());
+        }
+    }
 
-                CURRENT_LAYOUT = data_timestamp_ptr->layout;
-                CURRENT_DATA = data_timestamp_ptr->data;
-                CURRENT_TIMESTAMP = 0; // Force trigger a reload
+    // False once osrm-datastore has loaded a different dataset
+    bool IsCurrent() const { return m_dataset.IsCurrent(); }
 
-                util::SimpleLogger().Write(logDEBUG)
-                    << "Current layout was different to new layout, swapping";
-            }
-            else
-            {
-                util::SimpleLogger().Write(logDEBUG)
-                    << "Current layout was same to new layout, not swapping";
-            }
+    unsigned GetDatasetTimestamp() const { return m_dataset.Timestamp(); }
 
-            if (CURRENT_TIMESTAMP != data_timestamp_ptr->timestamp)
-            {
-                CURRENT_TIMESTAMP = data_timestamp_ptr->timestamp;
-
-                util::SimpleLogger().Write(logDEBUG) << "Performing data reload";
-                m_layout_memory.reset(storage::makeSharedMemory(CURRENT_LAYOUT));
-
-                data_layout = static_cast<storage::SharedDataLayout *>(m_layout_memory->Ptr());
-
-                m_large_memory.reset(storage::makeSharedMemory(CURRENT_DATA));
-                shared_memory = (char *)(m_large_memory->Ptr());
-
-                const auto file_index_ptr = data_layout->GetBlockPtr<char>(
-                    shared_memory, storage::SharedDataLayout::FILE_INDEX_PATH);
-                file_index_path = boost::filesystem::path(file_index_ptr);
-                if (!boost::filesystem::exists(file_index_path))
-                {
-                    util::SimpleLogger().Write(logDEBUG) << "Leaf file name "
-                                                         << file_index_path.string();
-                    throw util::exception("Could not load leaf index file. "
-                                          "Is any data loaded into shared memory?");
-                }
-
-                LoadGraph();
-                LoadChecksum();
-                LoadNodeAndEdgeInformation();
-                LoadGeometries();
-                LoadTimestamp();
-                LoadViaNodeList();
-                LoadNames();
-                LoadTurnLaneDescriptions();
-                LoadCoreInformation();
-                LoadProfileProperties();
-                LoadRTree();
-                LoadIntersectionClasses();
-
-                util::SimpleLogger().Write() << "number of geometries: "
-                                             << m_coordinate_list.size();
-                for (unsigned i = 0; i < m_coordinate_list.size(); ++i)
-                {
-                    BOOST_ASSERT(GetCoordinateOfNode(i).IsValid());
-                }
-            }
-            util::SimpleLogger().Write(logDEBUG) << "Releasing exclusive lock";
-        }
-    }
+    // How long attaching to the dataset waited for the barriers of osrm-datastore, and how long
+    // mapping its regions and setting up the views of its blocks took afterwards
+    std::chrono::nanoseconds GetBarrierWait() const { return m_dataset.BarrierWait(); }
+    std::chrono::nanoseconds GetMappingDuration() const { return m_mapping_duration; }
 
     // search graph access
     unsigned GetNumberOfNodes() const override final { return m_query_graph->GetNumberOfNodes(); }
@@ -476,11 +617,21 @@ class SharedDataFacade final : public BaseDataFacade
 
     NodeID GetTarget(const EdgeID e) const override final { return m_query_graph->GetTarget(e); }
 
-    EdgeData &GetEdgeData(const EdgeID e) const override final
+    EdgeData GetEdgeData(const EdgeID e) const override final
     {
         return m_query_graph->GetEdgeData(e);
     }
 
+    const contractor::QueryEdgeSearchData &GetSearchData(const EdgeID e) const override final
+    {
+        return m_query_graph->GetSearchData(e);
+    }
+
+    contractor::QueryGraphView GetSearchGraph() const override final
+    {
+        return m_query_graph->GetView(prefetch_search_graph);
+    }
+
     EdgeID BeginEdges(const NodeID n) const override final { return m_query_graph->BeginEdges(n); }
 
     EdgeID EndEdges(const NodeID n) const override final { return m_query_graph->EndEdges(n); }
@@ -521,32 +672,28 @@ class SharedDataFacade final : public BaseDataFacade
     virtual void GetUncompressedGeometry(const EdgeID id,
                                          std::vector<NodeID> &result_nodes) const override final
     {
-        const unsigned begin = m_geometry_indices.at(id);
-        const unsigned end = m_geometry_indices.at(id + 1);
-
         result_nodes.clear();
-        result_nodes.reserve(end - begin);
-        std::for_each(m_geometry_list.begin() + begin,
-                      m_geometry_list.begin() + end,
-                      [&](const osrm::extractor::CompressedEdgeContainer::CompressedEdge &edge) {
-                          result_nodes.emplace_back(edge.node_id);
-                      });
+        result_nodes.reserve(m_geometry_indices.at(id + 1) - m_geometry_indices.at(id));
+        extractor::decodeCompressedGeometry(
+            m_geometry_indices,
+            m_geometry_block_offsets,
+            m_geometry_data,
+            id,
+            [&](const NodeID node, const EdgeWeight) { result_nodes.push_back(node); });
     }
 
     virtual void
     GetUncompressedWeights(const EdgeID id,
                            std::vector<EdgeWeight> &result_weights) const override final
     {
-        const unsigned begin = m_geometry_indices.at(id);
-        const unsigned end = m_geometry_indices.at(id + 1);
-
         result_weights.clear();
-        result_weights.reserve(end - begin);
-        std::for_each(m_geometry_list.begin() + begin,
-                      m_geometry_list.begin() + end,
-                      [&](const osrm::extractor::CompressedEdgeContainer::CompressedEdge &edge) {
-                          result_weights.emplace_back(edge.weight);
-                      });
+        result_weights.reserve(m_geometry_indices.at(id + 1) - m_geometry_indices.at(id));
+        extractor::decodeCompressedGeometry(
+            m_geometry_indices,
+            m_geometry_block_offsets,
+            m_geometry_data,
+            id,
+            [&](const NodeID, const EdgeWeight weight) { result_weights.push_back(weight); });
     }
 
     virtual unsigned GetGeometryIndexForEdgeID(const unsigned id) const override final
@@ -680,34 +827,39 @@ class SharedDataFacade final : public BaseDataFacade
             input_coordinate, bearing, bearing_range);
     }
 
+    PhantomNode SegmentPhantomNode(const util::Coordinate input_coordinate,
+                                   const PhantomNode &segment) const override final
+    {
+        BOOST_ASSERT(m_geospatial_query.get());
+
+        return m_geospatial_query->SegmentPhantomNode(input_coordinate, segment);
+    }
+
     unsigned GetCheckSum() const override final { return m_check_sum; }
 
+    // osrm-datastore increments the timestamp with every data update
+    unsigned GetDataVersion() const override final { return m_dataset.Timestamp(); }
+
     unsigned GetNameIndexFromEdgeID(const unsigned id) const override final
     {
         return m_name_ID_list.at(id);
     }
 
-    std::string GetNameForID(const unsigned name_id) const override final
+    util::StringView GetNameForID(const unsigned name_id) const override final
     {
         if (std::numeric_limits<unsigned>::max() == name_id)
         {
-            return "";
+            return {};
         }
-        auto range = m_name_table->GetRange(name_id);
-
-        std::string result;
-        result.reserve(range.size());
-        if (range.begin() != range.end())
+        const auto range = m_name_table->GetRange(name_id);
+        if (range.size() == 0)
         {
-            result.resize(range.back() - range.front() + 1);
-            std::copy(m_names_char_list.begin() + range.front(),
-                      m_names_char_list.begin() + range.back() + 1,
-                      result.begin());
+            return {};
         }
-        return result;
+        return util::StringView(&m_names_char_list[range.front()], range.size());
     }
 
-    std::string GetRefForID(const unsigned name_id) const override final
+    util::StringView GetRefForID(const unsigned name_id) const override final
     {
         // We store the ref after the name, destination and pronunciation of a street.
         // We do this to get around the street length limit of 255 which would hit
@@ -716,7 +868,7 @@ class SharedDataFacade final : public BaseDataFacade
         return GetNameForID(name_id + 3);
     }
 
-    std::string GetPronunciationForID(const unsigned name_id) const override final
+    util::StringView GetPronunciationForID(const unsigned name_id) const override final
     {
         // We store the pronunciation after the name and destination of a street.
         // We do this to get around the street length limit of 255 which would hit
@@ -725,7 +877,7 @@ class SharedDataFacade final : public BaseDataFacade
         return GetNameForID(name_id + 2);
     }
 
-    std::string GetDestinationsForID(const unsigned name_id) const override final
+    util::StringView GetDestinationsForID(const unsigned name_id) const override final
     {
         // We store the destination after the name of a street.
         // We do this to get around the street length limit of 255 which would hit
@@ -736,15 +888,72 @@ class SharedDataFacade final : public BaseDataFacade
 
     bool IsCoreNode(const NodeID id) const override final
     {
-        if (m_is_core_node.size() > 0)
+        return !m_core_markers.Empty() && m_core_markers.Test(id);
+    }
+
+    util::PackedBitsetView GetCoreMarkers() const override final { return m_core_markers; }
+
+    virtual std::size_t GetCoreSize() const override final { return m_core_markers.Size(); }
+
+    virtual unsigned GetNumberOfLandmarks() const override final { return m_number_of_landmarks; }
+
+    virtual const EdgeWeight *GetLandmarkDistances(const NodeID id) const override final
+    {
+        if (m_landmark_core_nodes.empty())
         {
-            return m_is_core_node.at(id);
+            return nullptr;
         }
+        // the iterators of the shared memory vector are not random access
+        const NodeID *core_nodes_begin = &m_landmark_core_nodes[0];
+        const NodeID *core_nodes_end = core_nodes_begin + m_landmark_core_nodes.size();
+        const NodeID *core_node = std::lower_bound(core_nodes_begin, core_nodes_end, id);
+        if (core_node == core_nodes_end || *core_node != id)
+        {
+            return nullptr;
+        }
+        const std::size_t rank = core_node - core_nodes_begin;
+        return &m_landmark_distances[rank * 2 * m_number_of_landmarks];
+    }
+
+    virtual bool HasMultiLevelData() const override final { return !!m_multi_level_graph; }
 
-        return false;
+    virtual contractor::QueryGraphView GetMultiLevelGraph() const override final
+    {
+        BOOST_ASSERT(m_multi_level_graph);
+        return m_multi_level_graph->GetView(prefetch_search_graph);
+    }
+
+    virtual EdgeData GetMultiLevelEdgeData(const EdgeID e) const override final
+    {
+        BOOST_ASSERT(m_multi_level_graph);
+        return m_multi_level_graph->GetEdgeData(e);
     }
 
-    virtual std::size_t GetCoreSize() const override final { return m_is_core_node.size(); }
+    virtual const partition::CellStorageView &GetCellStorage() const override final
+    {
+        return m_cell_storage;
+    }
+
+    virtual bool HasHubLabels() const override final { return !m_hub_label_offsets.empty(); }
+
+    virtual HubLabel GetHubLabel(const NodeID id, const bool forward) const override final
+    {
+        HubLabel label;
+        if (m_hub_label_offsets.empty())
+        {
+            return label;
+        }
+        const std::size_t index = std::size_t{2} * id + (forward ? 0 : 1);
+        BOOST_ASSERT(index + 1 < m_hub_label_offsets.size());
+        const auto begin = m_hub_label_offsets[index];
+        label.size = m_hub_label_offsets[index + 1] - begin;
+        if (label.size > 0)
+        {
+            label.hubs = &m_hub_label_hubs[begin];
+            label.weights = &m_hub_label_weights[begin];
+        }
+        return label;
+    }
 
     // Returns the data source ids that were used to supply the edge
     // weights.
@@ -775,28 +984,96 @@ class SharedDataFacade final : public BaseDataFacade
         }
     }
 
-    virtual std::string GetDatasourceName(const uint8_t datasource_name_id) const override final
+    virtual void
+    GetUncompressedZoomLevels(const EdgeID id,
+                              std::vector<std::uint8_t> &result_zoom_levels) const override final
+    {
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+
+        // without precomputed levels the simplification runs on all nodes
+        if (m_geometry_zoom_levels.empty())
+        {
+            result_zoom_levels.assign(end - begin, 0);
+        }
+        else
+        {
+            result_zoom_levels.assign(m_geometry_zoom_levels.begin() + begin,
+                                      m_geometry_zoom_levels.begin() + end);
+        }
+    }
+
+    virtual void
+    GetUncompressedLengths(const EdgeID id,
+                           std::vector<SegmentLength> &result_lengths) const override final
+    {
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+
+        // without precomputed lengths the callers measure the segments themselves
+        if (m_geometry_lengths.empty())
+        {
+            result_lengths.assign(end - begin, INVALID_SEGMENT_LENGTH);
+        }
+        else
+        {
+            result_lengths.assign(m_geometry_lengths.begin() + begin,
+                                  m_geometry_lengths.begin() + end);
+        }
+    }
+
+    virtual util::StringView
+    GetDatasourceName(const uint8_t datasource_name_id) const override final
     {
         BOOST_ASSERT(m_datasource_name_offsets.size() >= 1);
         BOOST_ASSERT(m_datasource_name_offsets.size() > datasource_name_id);
 
-        std::string result;
-        result.reserve(m_datasource_name_lengths[datasource_name_id]);
-        std::copy(m_datasource_name_data.begin() + m_datasource_name_offsets[datasource_name_id],
-                  m_datasource_name_data.begin() + m_datasource_name_offsets[datasource_name_id] +
-                      m_datasource_name_lengths[datasource_name_id],
-                  std::back_inserter(result));
-
-        return result;
+        const auto length = m_datasource_name_lengths[datasource_name_id];
+        if (length == 0)
+        {
+            return {};
+        }
+        return util::StringView(
+            &m_datasource_name_data[m_datasource_name_offsets[datasource_name_id]], length);
     }
 
     std::string GetTimestamp() const override final { return m_timestamp; }
 
+    // the data region of osrm-datastore and the r-tree leaves
+    std::vector<util::MemoryRegion> GetMemoryRegions() const override final
+    {
+        return {util::MemoryRegion{shared_memory, data_layout->GetSizeOfLayout()},
+                m_static_rtree->GetLeafRegion()};
+    }
+
+    std::vector<util::NamedMemoryRegion> GetMemoryBlocks() const override final
+    {
+        std::vector<util::NamedMemoryRegion> blocks;
+        for (int block = 0; block < storage::SharedDataLayout::NUM_BLOCKS; ++block)
+        {
+            const auto block_id = static_cast<storage::SharedDataLayout::BlockID>(block);
+            const auto size = data_layout->GetBlockSize(block_id);
+            if (size > 0)
+            {
+                const auto data = shared_memory + data_layout->GetBlockOffset(block_id);
+                blocks.push_back(util::NamedMemoryRegion{storage::block_id_to_name[block],
+                                                         util::MemoryRegion{data, size}});
+            }
+        }
+        blocks.push_back(util::NamedMemoryRegion{"R_TREE_LEAVES", m_static_rtree->GetLeafRegion()});
+        return blocks;
+    }
+
     bool GetContinueStraightDefault() const override final
     {
         return m_profile_properties->continue_straight_at_waypoint;
     }
 
+    bool HasOrderedComponentIDs() const override final
+    {
+        return m_profile_properties->component_ids_in_topological_order;
+    }
+
     BearingClassID GetBearingClassID(const NodeID id) const override final
     {
         return m_bearing_class_id_table.at(id);
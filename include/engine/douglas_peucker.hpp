@@ -2,8 +2,16 @@
 #define DOUGLAS_PEUCKER_HPP_
 
 #include "util/coordinate.hpp"
+#include "util/coordinate_calculation.hpp"
+#include "util/web_mercator.hpp"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
+#include <limits>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -57,6 +65,12 @@ const constexpr std::uint64_t DOUGLAS_PEUCKER_THRESHOLDS[19] = {
 
 const constexpr auto DOUGLAS_PEUCKER_THRESHOLDS_SIZE =
     sizeof(DOUGLAS_PEUCKER_THRESHOLDS) / sizeof(*DOUGLAS_PEUCKER_THRESHOLDS);
+
+// Longer geometries first drop the coordinates that are close to the previous one they keep,
+// e.g. on cross-country routes at low zoom levels. This shrinks the ranges the quadratic worst
+// case of the algorithm runs on. The dropped coordinates are within half the tolerance of a kept
+// one.
+const constexpr std::size_t DOUGLAS_PEUCKER_RADIAL_FILTER_SIZE = 4096;
 } // ns detail
 
 // These functions compute the bitvector of indicating generalized input
@@ -75,6 +89,89 @@ inline std::vector<util::Coordinate> douglasPeucker(const std::vector<util::Coor
 {
     return douglasPeucker(begin(geometry), end(geometry), zoom_level);
 }
+
+// Computes the lowest zoom level at which douglasPeucker keeps each point of a geometry, points
+// that are not kept at any zoom level get DOUGLAS_PEUCKER_THRESHOLDS_SIZE.
+//
+// The farthest point of a range doesn't depend on the zoom level, so all levels share the tree
+// of splits. A point is kept if its distance and the ones of all splits above it exceed the
+// threshold. This is header only so that osrm-extract can precompute the levels.
+inline std::vector<std::uint8_t>
+douglasPeuckerZoomLevels(const std::vector<util::Coordinate> &geometry)
+{
+    const auto size = geometry.size();
+    std::vector<std::uint8_t> zoom_levels(size, detail::DOUGLAS_PEUCKER_THRESHOLDS_SIZE);
+    if (size == 0)
+    {
+        return zoom_levels;
+    }
+    zoom_levels.front() = 0;
+    zoom_levels.back() = 0;
+
+    std::vector<util::FloatCoordinate> projected_coordinates(size);
+    std::transform(geometry.begin(),
+                   geometry.end(),
+                   projected_coordinates.begin(),
+                   [](const util::Coordinate coordinate) {
+                       return util::web_mercator::fromWGS84(coordinate);
+                   });
+
+    struct GeometryRange
+    {
+        std::size_t first;
+        std::size_t last;
+        // the smallest distance of the splits that lead to this range
+        std::uint64_t significance;
+    };
+    std::vector<GeometryRange> recursion_stack;
+    recursion_stack.push_back({0, size - 1, std::numeric_limits<std::uint64_t>::max()});
+
+    while (!recursion_stack.empty())
+    {
+        const auto range = recursion_stack.back();
+        recursion_stack.pop_back();
+        if (range.last - range.first < 2)
+        {
+            continue;
+        }
+
+        std::uint64_t max_distance = 0;
+        auto farthest_index = range.first + 1;
+        for (auto index = range.first + 1; index < range.last; ++index)
+        {
+            util::FloatCoordinate projected_on_segment;
+            std::tie(std::ignore, projected_on_segment) =
+                util::coordinate_calculation::projectPointOnSegment(
+                    projected_coordinates[range.first],
+                    projected_coordinates[range.last],
+                    projected_coordinates[index]);
+            const auto distance = util::coordinate_calculation::squaredEuclideanDistance(
+                projected_coordinates[index], projected_on_segment);
+            if (distance > max_distance)
+            {
+                max_distance = distance;
+                farthest_index = index;
+            }
+        }
+
+        const auto significance = std::min(max_distance, range.significance);
+        // the thresholds shrink with the zoom level
+        const std::size_t zoom_level = std::distance(
+            std::begin(detail::DOUGLAS_PEUCKER_THRESHOLDS),
+            std::find_if(std::begin(detail::DOUGLAS_PEUCKER_THRESHOLDS),
+                         std::end(detail::DOUGLAS_PEUCKER_THRESHOLDS),
+                         [&](const std::uint64_t threshold) { return significance > threshold; }));
+        if (zoom_level == detail::DOUGLAS_PEUCKER_THRESHOLDS_SIZE)
+        {
+            continue;
+        }
+        zoom_levels[farthest_index] = zoom_level;
+        recursion_stack.push_back({range.first, farthest_index, significance});
+        recursion_stack.push_back({farthest_index, range.last, significance});
+    }
+
+    return zoom_levels;
+}
 }
 }
 
@@ -3,10 +3,16 @@
 
 #include "engine/status.hpp"
 #include "util/json_container.hpp"
+#include "util/query_metrics.hpp"
+#include "util/snapshots.hpp"
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace osrm
 {
@@ -17,11 +23,7 @@ namespace json
 {
 struct Object;
 }
-}
-
-namespace storage
-{
-struct SharedBarriers;
+class PageHeatSampler;
 }
 
 // Fwd decls
@@ -31,20 +33,22 @@ struct EngineConfig;
 namespace api
 {
 struct RouteParameters;
+struct RouteResult;
+struct RouteBatchParameters;
 struct TableParameters;
+struct TableResult;
+struct TableStream;
 struct NearestParameters;
+struct NearestResult;
 struct TripParameters;
 struct MatchParameters;
+struct MatchStreamParameters;
+struct MatchBatchParameters;
+struct MatchBatchResult;
 struct TileParameters;
-}
-namespace plugins
-{
-class ViaRoutePlugin;
-class TablePlugin;
-class NearestPlugin;
-class TripPlugin;
-class MatchPlugin;
-class TilePlugin;
+struct OneToAllParameters;
+struct OneToAllResult;
+struct IsochroneParameters;
 }
 // End fwd decls
 
@@ -53,6 +57,14 @@ namespace datafacade
 class BaseDataFacade;
 }
 
+class MatchSessions;
+class SearchEngineHeapPool;
+class TableSessions;
+class SearchSpaceCache;
+class SnappingCache;
+class TileCache;
+class UnpackingCache;
+
 class Engine final
 {
   public:
@@ -65,23 +77,105 @@ class Engine final
     ~Engine();
 
     Status Route(const api::RouteParameters &parameters, util::json::Object &result) const;
+    Status Route(const api::RouteParameters &parameters, api::RouteResult &result) const;
+    Status RouteBatch(const api::RouteBatchParameters &parameters,
+                      util::json::Object &result) const;
     Status Table(const api::TableParameters &parameters, util::json::Object &result) const;
+    Status Table(const api::TableParameters &parameters, std::string &result) const;
+    Status Table(const api::TableParameters &parameters, api::TableResult &result) const;
+    Status Table(const api::TableParameters &parameters, api::TableStream &result) const;
     Status Nearest(const api::NearestParameters &parameters, util::json::Object &result) const;
+    Status Nearest(const api::NearestParameters &parameters, api::NearestResult &result) const;
     Status Trip(const api::TripParameters &parameters, util::json::Object &result) const;
     Status Match(const api::MatchParameters &parameters, util::json::Object &result) const;
+    Status MatchStream(const api::MatchStreamParameters &parameters,
+                       util::json::Object &result) const;
+    Status MatchBatch(const api::MatchBatchParameters &parameters,
+                      api::MatchBatchResult &result) const;
     Status Tile(const api::TileParameters &parameters, std::string &result) const;
+    Status OneToAll(const api::OneToAllParameters &parameters,
+                    api::OneToAllResult &result) const;
+    Status Isochrone(const api::IsochroneParameters &parameters,
+                     util::json::Object &result) const;
+
+    // Runs the task on the thread pool of the async queries, the task must not throw. The tasks
+    // that are pending when the engine is destroyed are run to their end first.
+    void Async(std::function<void()> task) const;
+
+    // False while the data is still warmed up after the start, see EngineConfig::warmup_data.
+    // Queries are answered in the meantime, only slower.
+    bool IsReady() const;
+
+    // Loads the files of the dataset again while the queries go on with the current data, and
+    // warms them up with EngineConfig::warmup_data. Then swaps in the new data, the previous data
+    // is freed once the queries on it are done. Throws if the files can't be loaded, the current
+    // data is kept then. Data in shared memory is reloaded by osrm-datastore instead.
+    void Reload();
+
+    // Checksum of the dataset the queries run on
+    unsigned GetCheckSum() const;
+    // Changes with every dataset that osrm-datastore loads into shared memory
+    unsigned GetDataVersion() const;
+    // Version of the traffic overlay that route, table and trip queries use, 0 without one
+    std::uint64_t GetTrafficOverlayVersion() const;
 
   private:
-    std::unique_ptr<storage::SharedBarriers> lock;
+    // A facade and the plugins that run queries on it. Queries pin the current snapshot, which
+    // is replaced by a new one when osrm-datastore loads a different dataset.
+    struct DataSnapshot;
+
+    // Pins the current snapshot of the calling thread's NUMA node, after loading the new dataset
+    // if shared memory was updated
+    util::Snapshots<DataSnapshot>::Pin AcquireSnapshot() const;
+
+    template <typename ParameterT, typename PluginT, typename ResultT>
+    Status RunQuery(const util::QueryMetrics::Service service,
+                    std::unique_ptr<PluginT> DataSnapshot::*plugin,
+                    const ParameterT &parameters,
+                    ResultT &result) const;
+
+    // A TBB task arena of EngineConfig::async_threads that counts its pending tasks
+    struct AsyncPool;
+
+    // The snapshots of the traffic overlay in shared memory
+    struct TrafficOverlays;
+
+    // The warmup of the data after the start
+    struct Warmup;
+
+    void LoadSnapshots();
+
+    // A snapshot of the files, or one for each NUMA node with NUMA replicas
+    std::vector<std::unique_ptr<DataSnapshot>> LoadInternalData(const unsigned data_version) const;
+
+    std::unique_ptr<DataSnapshot>
+    MakeSnapshot(std::unique_ptr<datafacade::BaseDataFacade> facade) const;
+
+    std::unique_ptr<const EngineConfig> config;
+
+    // shared by the plugins, empty if disabled
+    std::unique_ptr<UnpackingCache> unpacking_cache;
+    std::unique_ptr<SnappingCache> snapping_cache;
+    std::unique_ptr<SearchSpaceCache> search_space_cache;
+    std::unique_ptr<TileCache> tile_cache;
+    std::unique_ptr<MatchSessions> match_sessions;
+    std::unique_ptr<TableSessions> table_sessions;
+    // the heaps the queries search on, they check out a set for as long as they run
+    std::unique_ptr<SearchEngineHeapPool> heap_pool;
 
-    std::unique_ptr<plugins::ViaRoutePlugin> route_plugin;
-    std::unique_ptr<plugins::TablePlugin> table_plugin;
-    std::unique_ptr<plugins::NearestPlugin> nearest_plugin;
-    std::unique_ptr<plugins::TripPlugin> trip_plugin;
-    std::unique_ptr<plugins::MatchPlugin> match_plugin;
-    std::unique_ptr<plugins::TilePlugin> tile_plugin;
+    // stopped before the snapshots it warms up are replaced
+    std::unique_ptr<Warmup> warmup;
+    // one per NUMA node with NUMA replicas, a single one otherwise
+    std::vector<std::unique_ptr<util::Snapshots<DataSnapshot>>> snapshots;
 
-    std::unique_ptr<datafacade::BaseDataFacade> query_data_facade;
+    std::unique_ptr<AsyncPool> async_pool;
+    // reloads of the files, which are the data version of their data
+    std::unique_ptr<std::mutex> reload_mutex;
+    unsigned number_of_reloads = 0;
+    // empty unless EngineConfig::use_traffic_overlay is set
+    std::unique_ptr<TrafficOverlays> traffic_overlays;
+    // samples the data of the first snapshot, empty unless EngineConfig::block_heat_interval
+    std::unique_ptr<util::PageHeatSampler> heat_sampler;
 };
 }
 }
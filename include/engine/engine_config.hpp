@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/filesystem/path.hpp>
 
+#include <cstddef>
 #include <string>
 
 namespace osrm
@@ -49,25 +50,161 @@ namespace engine
  * These are the maximum number of allowed locations (-1 for unlimited) for the services:
  *  - Trip
  *  - Route
+ *  - RouteBatch (number of coordinate pairs)
  *  - Table
  *  - Match
+ *  - MatchBatch (number of traces)
  *  - Nearest
+ *  - OneToAll
+ *
+ * The longest contour of an isochrone is limited by max_duration_isochrone in seconds, since the
+ * search of an isochrone grows with it.
  *
  * In addition, shared memory can be used for datasets loaded with osrm-datastore.
  *
+ * Large distance tables can be computed with all cores by enabling the parallel distance table;
+ * the searches of a single table request are then spread over the TBB thread pool.
+ * Likewise the legs of a route with several waypoints can be searched and unpacked in parallel
+ * with the parallel route legs, at the cost of up to twice as many searches per leg.
+ * Route and trip legs whose packed paths have at least parallel_unpacking_length edges are
+ * unpacked in chunks on all cores, which cuts the latency of routes across continents. A length
+ * of 0 disables it.
+ *
+ * Trips with more than large_trip_locations locations are split into clusters of nearby
+ * locations that are solved in parallel and stitched together, instead of computing the table of
+ * all locations. Together with max_locations_trip this allows trips with hundreds of locations.
+ * 0 disables it.
+ *
+ * The unpacking cache keeps the original edges of up to unpacking_cache_size recently used
+ * shortcuts, so route, trip and match responses don't unpack the same shortcuts over and over.
+ * A size of 0 disables it.
+ *
+ * The snapping cache keeps the phantom nodes of up to snapping_cache_size recently snapped
+ * coordinates, so route, table, trip and one-to-all queries for the same locations don't search
+ * the r-tree again. A size of 0 disables it.
+ *
+ * The search space cache keeps the upward search spaces of up to search_space_cache_size recently
+ * used table locations in the contraction hierarchy, so depots and hubs that are part of many
+ * tables aren't searched from again. A size of 0 disables it.
+ *
+ * The tile cache keeps the segments of up to tile_cache_size recently rendered tiles of zoom
+ * level 13 with their weights, and the tiles of zoom levels 13 and up are cut from them. A size
+ * of 0 disables it.
+ *
+ * Live traces are matched incrementally in sessions, of which the least recently used are
+ * dropped beyond max_match_sessions. A session keeps the points whose matching isn't final yet,
+ * at most max_match_session_points of them. A max_match_sessions of 0 disables MatchStream.
+ * Likewise tables with a session keep their search spaces for up to max_table_sessions
+ * sessions, 0 disables them.
+ *
+ * Stall-on-demand additionally prunes the nodes that a stalled node of the upward search
+ * reaches, instead of only checking each node when it is settled. Whether that pays off for
+ * the extra scans depends on the hierarchy of the network, so it is off by default.
+ *
+ * Without shared memory the graph, geometry and name files can be memory-mapped instead of
+ * read, which makes loading almost instant and shares their pages between processes.
+ *
+ * NUMA replicas load a copy of the data on every NUMA node of the machine, and queries run on
+ * the copy of the node their thread is bound to (see util::bindThreadToNUMANode). This takes
+ * the memory of the dataset once per node and is only used when the data is read from files.
+ *
+ * The r-tree leaves are always mapped from their file. Where that file is not kept in the page
+ * cache, prefetching reads ahead the leaves a query visits next instead of blocking on each of
+ * them, and counts the page faults on the leaves for the metrics. With prefetch_search_graph the
+ * route searches load the edges of the nodes they settle next into the cache ahead of time,
+ * which hides some of the memory latency on large graphs.
+ *
+ * With warmup_data the engine reads all of the data in the background after it started, so the
+ * first queries don't wait for pages coming from disk or being mapped. Engine::IsReady tells
+ * when it is done. lock_data additionally locks the warmed up memory, so it is never paged out.
+ * Both only cover the blocks the data is read from, the files or the container and their
+ * mappings, the region of osrm-datastore and the r-tree leaves.
+ *
+ * With a block_heat_interval of more than 0 seconds the engine samples which pages of the blocks
+ * of the data are accessed in every interval of that many seconds and logs the share of each
+ * block that was hot, see util::PageHeatSampler. With NUMA replicas only the first copy is
+ * sampled.
+ *
+ * With share_data the instance shares the files it reads with the other instances of the process
+ * that read files with the same contents, and the nodes of .nodes files with the same contents,
+ * see datafacade::BlockRegistry. That's for several profiles served by one process. It costs a
+ * hash of the files while they are loaded and doesn't apply to memory-mapped files, whose
+ * mappings share their pages anyway, to containers and to shared memory.
+ *
+ * Async queries run on a pool of async_threads threads, which the instance owns beside the
+ * threads of the parallel tables and route legs, 0 for as many threads as there are cores.
+ * Queries check their search heaps out of a pool of the instance while they run, so the threads
+ * don't keep heaps of their own.
+ *
+ * A query that runs for longer than max_query_time milliseconds is aborted and fails with the
+ * status Timeout, -1 lets queries run as long as they take. Its searches check the
+ * deadline about every thousand nodes they settle.
+ *
+ * A query that needs more than max_query_memory megabytes for its large arrays, like the
+ * durations of a table, the distance matrix of a trip or the states of the hidden markov model of
+ * a match, fails with TooBig before it allocates them, -1 for no limit. The limit doesn't cover
+ * the search heaps, which the queries check out of the pool of the instance.
+ *
+ * With use_traffic_overlay the route, table and trip queries add the traffic penalties that
+ * osrm-traffic writes into shared memory to the weights of their searches. The engine looks for
+ * a new overlay at most once a second, independent of use_shared_memory.
+ *
+ * The algorithm picks the hierarchy the route and table searches run on. CH uses the contraction
+ * hierarchy of osrm-contract. MLD runs multi-level Dijkstra on the cells of osrm-partition, whose
+ * weights osrm-customize computes in seconds, so new speeds don't need a new contraction. MLD
+ * needs the .mldgr and .cells of osrm-customize, and takes its traffic from the speed files of
+ * osrm-customize instead of the traffic overlay. Alternative routes, one-to-all and isochrone
+ * queries keep using the contraction hierarchy.
+ *
  * \see OSRM, StorageConfig
  */
 struct EngineConfig final
 {
+    enum class Algorithm
+    {
+        CH,
+        MLD
+    };
+
     bool IsValid() const;
 
     storage::StorageConfig storage_config;
     int max_locations_trip = -1;
     int max_locations_viaroute = -1;
+    int max_pairs_route_batch = -1;
     int max_locations_distance_table = -1;
     int max_locations_map_matching = -1;
+    int max_traces_match_batch = -1;
     int max_results_nearest = -1;
+    int max_locations_one_to_all = -1;
+    int max_duration_isochrone = -1;
+    int max_locations_nearest = -1;
     bool use_shared_memory = true;
+    bool use_parallel_distance_table = false;
+    bool use_parallel_route_legs = false;
+    std::size_t parallel_unpacking_length = 0;
+    std::size_t large_trip_locations = 0;
+    std::size_t unpacking_cache_size = 0;
+    std::size_t snapping_cache_size = 0;
+    std::size_t search_space_cache_size = 0;
+    std::size_t tile_cache_size = 0;
+    std::size_t max_match_sessions = 0;
+    std::size_t max_match_session_points = 100;
+    std::size_t max_table_sessions = 0;
+    bool use_stall_on_demand = false;
+    bool use_mmap = false;
+    bool use_numa_replicas = false;
+    bool prefetch_rtree_leaves = false;
+    bool prefetch_search_graph = false;
+    bool warmup_data = false;
+    bool lock_data = false;
+    unsigned block_heat_interval = 0;
+    bool share_data = false;
+    unsigned async_threads = 0;
+    int max_query_time = -1;
+    int max_query_memory = -1;
+    bool use_traffic_overlay = false;
+    Algorithm algorithm = Algorithm::CH;
 };
 }
 }
@@ -2,8 +2,10 @@
 #define GEOSPATIAL_QUERY_HPP
 
 #include "engine/phantom_node.hpp"
+#include "engine/search_engine_data.hpp"
 #include "util/bearing.hpp"
 #include "util/coordinate_calculation.hpp"
+#include "util/integer_range.hpp"
 #include "util/rectangle.hpp"
 #include "util/typedefs.hpp"
 #include "util/web_mercator.hpp"
@@ -12,7 +14,10 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace osrm
@@ -52,13 +57,14 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
     NearestPhantomNodesInRange(const util::Coordinate input_coordinate,
                                const double max_distance) const
     {
-        auto results =
-            rtree.Nearest(input_coordinate,
-                          [this](const CandidateSegment &segment) { return HasValidEdge(segment); },
-                          [this, max_distance, input_coordinate](const std::size_t,
-                                                                 const CandidateSegment &segment) {
-                              return CheckSegmentDistance(input_coordinate, segment, max_distance);
-                          });
+        auto results = NearestInRadius(
+            input_coordinate,
+            max_distance,
+            [this](const CandidateSegment &segment) { return HasValidEdge(segment); },
+            [this, max_distance, input_coordinate](const std::size_t,
+                                                   const CandidateSegment &segment) {
+                return CheckSegmentDistance(input_coordinate, segment, max_distance);
+            });
 
         return MakePhantomNodes(input_coordinate, results);
     }
@@ -71,11 +77,12 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                                const int bearing,
                                const int bearing_range) const
     {
-        auto results = rtree.Nearest(
+        const util::bearing::QuantizedRange bearings(bearing, bearing_range);
+        auto results = NearestInRadius(
             input_coordinate,
-            [this, bearing, bearing_range, max_distance](const CandidateSegment &segment) {
-                return boolPairAnd(CheckSegmentBearing(segment, bearing, bearing_range),
-                                   HasValidEdge(segment));
+            max_distance,
+            [this, bearings, max_distance](const CandidateSegment &segment) {
+                return boolPairAnd(CheckSegmentBearing(segment, bearings), HasValidEdge(segment));
             },
             [this, max_distance, input_coordinate](const std::size_t,
                                                    const CandidateSegment &segment) {
@@ -93,11 +100,11 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                         const int bearing,
                         const int bearing_range) const
     {
+        const util::bearing::QuantizedRange bearings(bearing, bearing_range);
         auto results = rtree.Nearest(
             input_coordinate,
-            [this, bearing, bearing_range](const CandidateSegment &segment) {
-                return boolPairAnd(CheckSegmentBearing(segment, bearing, bearing_range),
-                                   HasValidEdge(segment));
+            [this, bearings](const CandidateSegment &segment) {
+                return boolPairAnd(CheckSegmentBearing(segment, bearings), HasValidEdge(segment));
             },
             [max_results](const std::size_t num_results, const CandidateSegment &) {
                 return num_results >= max_results;
@@ -116,11 +123,12 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                         const int bearing,
                         const int bearing_range) const
     {
-        auto results = rtree.Nearest(
+        const util::bearing::QuantizedRange bearings(bearing, bearing_range);
+        auto results = NearestInRadius(
             input_coordinate,
-            [this, bearing, bearing_range](const CandidateSegment &segment) {
-                return boolPairAnd(CheckSegmentBearing(segment, bearing, bearing_range),
-                                   HasValidEdge(segment));
+            max_distance,
+            [this, bearings](const CandidateSegment &segment) {
+                return boolPairAnd(CheckSegmentBearing(segment, bearings), HasValidEdge(segment));
             },
             [this, max_distance, max_results, input_coordinate](const std::size_t num_results,
                                                                 const CandidateSegment &segment) {
@@ -153,14 +161,15 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                         const unsigned max_results,
                         const double max_distance) const
     {
-        auto results =
-            rtree.Nearest(input_coordinate,
-                          [this](const CandidateSegment &segment) { return HasValidEdge(segment); },
-                          [this, max_distance, max_results, input_coordinate](
-                              const std::size_t num_results, const CandidateSegment &segment) {
-                              return num_results >= max_results ||
-                                     CheckSegmentDistance(input_coordinate, segment, max_distance);
-                          });
+        auto results = NearestInRadius(
+            input_coordinate,
+            max_distance,
+            [this](const CandidateSegment &segment) { return HasValidEdge(segment); },
+            [this, max_distance, max_results, input_coordinate](const std::size_t num_results,
+                                                                const CandidateSegment &segment) {
+                return num_results >= max_results ||
+                       CheckSegmentDistance(input_coordinate, segment, max_distance);
+            });
 
         return MakePhantomNodes(input_coordinate, results);
     }
@@ -251,11 +260,12 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
     std::pair<PhantomNode, PhantomNode> NearestPhantomNodeWithAlternativeFromBigComponent(
         const util::Coordinate input_coordinate, const int bearing, const int bearing_range) const
     {
+        const util::bearing::QuantizedRange bearings(bearing, bearing_range);
         bool has_small_component = false;
         bool has_big_component = false;
         auto results = rtree.Nearest(
             input_coordinate,
-            [this, bearing, bearing_range, &has_big_component, &has_small_component](
+            [this, bearings, &has_big_component, &has_small_component](
                 const CandidateSegment &segment) {
                 auto use_segment = (!has_small_component ||
                                     (!has_big_component && !segment.data.component.is_tiny));
@@ -265,8 +275,7 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                 if (use_segment)
                 {
                     use_directions =
-                        boolPairAnd(CheckSegmentBearing(segment, bearing, bearing_range),
-                                    HasValidEdge(segment));
+                        boolPairAnd(CheckSegmentBearing(segment, bearings), HasValidEdge(segment));
                     if (use_directions.first || use_directions.second)
                     {
                         has_big_component = has_big_component || !segment.data.component.is_tiny;
@@ -298,11 +307,12 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                                                       const int bearing,
                                                       const int bearing_range) const
     {
+        const util::bearing::QuantizedRange bearings(bearing, bearing_range);
         bool has_small_component = false;
         bool has_big_component = false;
         auto results = rtree.Nearest(
             input_coordinate,
-            [this, bearing, bearing_range, &has_big_component, &has_small_component](
+            [this, bearings, &has_big_component, &has_small_component](
                 const CandidateSegment &segment) {
                 auto use_segment = (!has_small_component ||
                                     (!has_big_component && !segment.data.component.is_tiny));
@@ -312,8 +322,7 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                 if (use_segment)
                 {
                     use_directions =
-                        boolPairAnd(CheckSegmentBearing(segment, bearing, bearing_range),
-                                    HasValidEdge(segment));
+                        boolPairAnd(CheckSegmentBearing(segment, bearings), HasValidEdge(segment));
                     if (use_directions.first || use_directions.second)
                     {
                         has_big_component = has_big_component || !segment.data.component.is_tiny;
@@ -339,7 +348,189 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                               MakePhantomNode(input_coordinate, results.back()).phantom_node);
     }
 
+    // Rebuilds the phantom node of the coordinate on the segment of a hint, which only keeps the
+    // segment ids, the position of the segment in its compressed geometry and the weights from
+    // the start of both directions to the snapped location in the offsets. The segment is found
+    // by its ids and the geometry, so no search of the tree is needed. Returns an invalid phantom
+    // node if there is no such segment or if the coordinate projects onto other weights.
+    PhantomNode SegmentPhantomNode(const util::Coordinate input_coordinate,
+                                   const PhantomNode &segment) const
+    {
+        if (!segment.forward_segment_id.enabled && !segment.reverse_segment_id.enabled)
+        {
+            return PhantomNode{};
+        }
+
+        const auto &segment_objects = GetSegmentObjects();
+        const auto id = segment.forward_segment_id.id != SPECIAL_SEGMENTID
+                            ? segment.forward_segment_id.id
+                            : segment.reverse_segment_id.id;
+        if (id >= segment_objects.size() || segment_objects[id] == INVALID_OBJECT_INDEX)
+        {
+            return PhantomNode{};
+        }
+        auto data = rtree.GetObject(segment_objects[id]);
+        if (data.forward_segment_id.id != segment.forward_segment_id.id ||
+            data.reverse_segment_id.id != segment.reverse_segment_id.id)
+        {
+            return PhantomNode{};
+        }
+
+        // Geometries only store the target of each of their segments, the indexed segment is the
+        // one whose end point is missing from the geometry
+        const auto position = segment.fwd_segment_position;
+        std::vector<NodeID> geometry;
+        if (data.forward_packed_geometry_id != SPECIAL_EDGEID)
+        {
+            datafacade.GetUncompressedGeometry(data.forward_packed_geometry_id, geometry);
+            if (position >= geometry.size())
+            {
+                return PhantomNode{};
+            }
+            if (position > 0)
+            {
+                data.u = geometry[position - 1];
+            }
+            data.v = geometry[position];
+        }
+        else
+        {
+            datafacade.GetUncompressedGeometry(data.reverse_packed_geometry_id, geometry);
+            if (position >= geometry.size())
+            {
+                return PhantomNode{};
+            }
+            const auto index = geometry.size() - position - 1;
+            data.u = geometry[index];
+            if (index > 0)
+            {
+                data.v = geometry[index - 1];
+            }
+        }
+        data.fwd_segment_position = position;
+        data.forward_segment_id.enabled &= segment.forward_segment_id.enabled;
+        data.reverse_segment_id.enabled &= segment.reverse_segment_id.enabled;
+
+        const auto phantom_node = MakePhantomNode(input_coordinate, data).phantom_node;
+        // unsigned, the weight of a closed direction is invalid and the sum could overflow
+        const auto weight_to_location = [](const int offset, const int weight) {
+            return static_cast<std::uint32_t>(offset) + static_cast<std::uint32_t>(weight);
+        };
+        if (weight_to_location(phantom_node.forward_offset, phantom_node.forward_weight) !=
+                weight_to_location(segment.forward_offset, segment.forward_weight) ||
+            weight_to_location(phantom_node.reverse_offset, phantom_node.reverse_weight) !=
+                weight_to_location(segment.reverse_offset, segment.reverse_weight))
+        {
+            return PhantomNode{};
+        }
+        return phantom_node;
+    }
+
   private:
+    static constexpr std::uint32_t INVALID_OBJECT_INDEX = std::numeric_limits<std::uint32_t>::max();
+
+    // The index of an r-tree object of every edge-based node. The first segment of the node is
+    // taken if it has a forward geometry, which misses the start of the first segment, and the
+    // last one otherwise. The scan over all segments is done by the first hint that needs it.
+    const std::vector<std::uint32_t> &GetSegmentObjects() const
+    {
+        std::call_once(segment_objects_flag, [this] {
+            const auto number_of_objects = rtree.GetNumberOfObjects();
+            if (number_of_objects >= INVALID_OBJECT_INDEX)
+            {
+                // hints of such networks never apply
+                return;
+            }
+            for (const auto object_index : util::irange<std::uint32_t>(0, number_of_objects))
+            {
+                const auto &data = rtree.GetObject(object_index);
+                const auto id = data.forward_segment_id.id != SPECIAL_SEGMENTID
+                                    ? data.forward_segment_id.id
+                                    : data.reverse_segment_id.id;
+                if (id == SPECIAL_SEGMENTID)
+                {
+                    continue;
+                }
+                if (id >= segment_objects.size())
+                {
+                    segment_objects.resize(id + 1, std::uint32_t{INVALID_OBJECT_INDEX});
+                }
+                auto &segment_object = segment_objects[id];
+                if (segment_object == INVALID_OBJECT_INDEX ||
+                    (data.forward_packed_geometry_id != SPECIAL_EDGEID
+                         ? data.fwd_segment_position == 0
+                         : data.fwd_segment_position >
+                               rtree.GetObject(segment_object).fwd_segment_position))
+                {
+                    segment_object = object_index;
+                }
+            }
+        });
+        return segment_objects;
+    }
+
+    // leaves up to which the segments in the bounding box of a radius are searched directly
+    static constexpr std::size_t MAX_BOX_SEARCH_LEAVES = 32;
+    // degrees added to the bounding box of a radius
+    static constexpr double MIN_BOX_MARGIN = 0.00001;
+
+    // Finds the segments within max_distance of the input. If the bounding box of the circle
+    // only touches a few leaves, which depends on the radius and on how dense the network is
+    // around the input, the segments of these leaves are sorted by their distance instead of
+    // running the best-first search, which would read the same leaves but push every node and
+    // segment it finds through its queue. Many leaves are left to the best-first search, which
+    // skips the ones behind the last result of a search for a number of results.
+    template <typename FilterT, typename TerminationT>
+    std::vector<EdgeData> NearestInRadius(const util::Coordinate input_coordinate,
+                                          const double max_distance,
+                                          const FilterT &filter,
+                                          const TerminationT &terminate) const
+    {
+        util::RectangleInt2D bbox;
+        if (GetRadiusBoundingBox(input_coordinate, max_distance, bbox) &&
+            rtree.CountLeavesInBox(bbox, MAX_BOX_SEARCH_LEAVES + 1) <= MAX_BOX_SEARCH_LEAVES)
+        {
+            return rtree.NearestInBox(input_coordinate, bbox, filter, terminate);
+        }
+        return rtree.Nearest(input_coordinate, filter, terminate);
+    }
+
+    // Sets the rectangle that contains all coordinates within max_distance of the input by
+    // haversineDistance. Returns false for unlimited radii and for circles that reach over the
+    // antimeridian or beyond the latitudes of the web mercator projection.
+    static bool GetRadiusBoundingBox(const util::Coordinate input_coordinate,
+                                     const double max_distance,
+                                     util::RectangleInt2D &bbox)
+    {
+        const double degree_to_rad = util::coordinate_calculation::detail::DEGREE_TO_RAD;
+        // a bit larger for the rounding of the projected segments to fixed point
+        const double angle =
+            1.01 * max_distance / util::coordinate_calculation::detail::EARTH_RADIUS +
+            MIN_BOX_MARGIN * degree_to_rad;
+        const double lat = static_cast<double>(util::toFloating(input_coordinate.lat));
+        const double lon = static_cast<double>(util::toFloating(input_coordinate.lon));
+        const double delta_lat = angle / degree_to_rad;
+        if (!(lat + delta_lat < util::web_mercator::detail::MAX_LATITUDE) ||
+            !(lat - delta_lat > -util::web_mercator::detail::MAX_LATITUDE))
+        {
+            return false;
+        }
+
+        // the widest part of the circle lies closer to the pole than the input
+        const double delta_lon =
+            std::asin(std::sin(angle) / std::cos(lat * degree_to_rad)) / degree_to_rad;
+        if (!(lon - delta_lon > -180.) || !(lon + delta_lon < 180.))
+        {
+            return false;
+        }
+
+        bbox = util::RectangleInt2D{util::FloatLongitude{lon - delta_lon},
+                                    util::FloatLongitude{lon + delta_lon},
+                                    util::FloatLatitude{lat - delta_lat},
+                                    util::FloatLatitude{lat + delta_lat}};
+        return true;
+    }
+
     std::vector<PhantomNodeWithDistance>
     MakePhantomNodes(const util::Coordinate input_coordinate,
                      const std::vector<EdgeData> &results) const
@@ -440,29 +631,19 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                max_distance;
     }
 
+    // The r-tree stores the quantized bearing of every segment, so this is a comparison of bytes
     std::pair<bool, bool> CheckSegmentBearing(const CandidateSegment &segment,
-                                              const int filter_bearing,
-                                              const int filter_bearing_range) const
+                                              const util::bearing::QuantizedRange &bearings) const
     {
         BOOST_ASSERT(segment.data.forward_segment_id.id != SPECIAL_SEGMENTID ||
                      !segment.data.forward_segment_id.enabled);
         BOOST_ASSERT(segment.data.reverse_segment_id.id != SPECIAL_SEGMENTID ||
                      !segment.data.reverse_segment_id.enabled);
 
-        const double forward_edge_bearing = util::coordinate_calculation::bearing(
-            coordinates[segment.data.u], coordinates[segment.data.v]);
-
-        const double backward_edge_bearing = (forward_edge_bearing + 180) > 360
-                                                 ? (forward_edge_bearing - 180)
-                                                 : (forward_edge_bearing + 180);
-
         const bool forward_bearing_valid =
-            util::bearing::CheckInBounds(
-                std::round(forward_edge_bearing), filter_bearing, filter_bearing_range) &&
-            segment.data.forward_segment_id.enabled;
+            bearings.Contains(segment.forward_bearing) && segment.data.forward_segment_id.enabled;
         const bool backward_bearing_valid =
-            util::bearing::CheckInBounds(
-                std::round(backward_edge_bearing), filter_bearing, filter_bearing_range) &&
+            bearings.Contains(util::bearing::reverseQuantized(segment.forward_bearing)) &&
             segment.data.reverse_segment_id.enabled;
         return std::make_pair(forward_bearing_valid, backward_bearing_valid);
     }
@@ -471,7 +652,8 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
      * Checks to see if the edge weights are valid.  We might have an edge,
      * but a traffic update might set the speed to 0 (weight == INVALID_EDGE_WEIGHT).
      * which means that this edge is not currently traversible.  If this is the case,
-     * then we shouldn't snap to this edge.
+     * then we shouldn't snap to this edge.  Neither do we snap to the edge-based nodes of
+     * the classes the query excludes.
      */
     std::pair<bool, bool> HasValidEdge(const CandidateSegment &segment) const
     {
@@ -506,12 +688,24 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
             }
         }
 
+        const auto cell_metric = SearchEngineData::GetCellMetric();
+        if (cell_metric != 0 && datafacade.HasMultiLevelData())
+        {
+            const auto cells = datafacade.GetCellStorage().GetMetric(cell_metric);
+            forward_edge_valid =
+                forward_edge_valid && !cells.IsExcluded(segment.data.forward_segment_id.id);
+            reverse_edge_valid =
+                reverse_edge_valid && !cells.IsExcluded(segment.data.reverse_segment_id.id);
+        }
+
         return std::make_pair(forward_edge_valid, reverse_edge_valid);
     }
 
     const RTreeT &rtree;
     const CoordinateList &coordinates;
     DataFacadeT &datafacade;
+    mutable std::once_flag segment_objects_flag;
+    mutable std::vector<std::uint32_t> segment_objects;
 };
 }
 }
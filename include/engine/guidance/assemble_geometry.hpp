@@ -21,6 +21,22 @@ namespace engine
 {
 namespace guidance
 {
+namespace detail
+{
+// All but the first path point of a leg end the segment of a geometry, whose length osrm-extract
+// may have precomputed. The first one starts at the source phantom node.
+inline double getSegmentLength(const util::Coordinate from,
+                               const util::Coordinate to,
+                               const PathData &path_point,
+                               const bool is_first_point)
+{
+    if (is_first_point || path_point.segment_length == INVALID_SEGMENT_LENGTH)
+    {
+        return util::coordinate_calculation::haversineDistance(from, to);
+    }
+    return path_point.segment_length;
+}
+}
 
 // Extracts the geometry for each segment and calculates the traveled distance
 // Combines the geometry form the phantom node with the PathData
@@ -33,7 +49,7 @@ namespace guidance
 //                 |---| segment 2
 //                     |---| segment 3
 inline LegGeometry assembleGeometry(const datafacade::BaseDataFacade &facade,
-                                    const std::vector<PathData> &leg_data,
+                                    const PathDataVector &leg_data,
                                     const PhantomNode &source_node,
                                     const PhantomNode &target_node,
                                     const bool reversed_source,
@@ -44,6 +60,7 @@ inline LegGeometry assembleGeometry(const datafacade::BaseDataFacade &facade,
     // segment 0 first and last
     geometry.segment_offsets.push_back(0);
     geometry.locations.push_back(source_node.location);
+    geometry.zoom_levels.push_back(0);
 
     //                          u       *      v
     //                          0 -- 1 -- 2 -- 3
@@ -76,8 +93,8 @@ inline LegGeometry assembleGeometry(const datafacade::BaseDataFacade &facade,
     for (const auto &path_point : leg_data)
     {
         auto coordinate = facade.GetCoordinateOfNode(path_point.turn_via_node);
-        current_distance =
-            util::coordinate_calculation::haversineDistance(prev_coordinate, coordinate);
+        current_distance = detail::getSegmentLength(
+            prev_coordinate, coordinate, path_point, &path_point == &leg_data.front());
         cumulative_distance += current_distance;
 
         // all changes to this check have to be matched with assemble_steps
@@ -92,6 +109,7 @@ inline LegGeometry assembleGeometry(const datafacade::BaseDataFacade &facade,
         geometry.annotations.emplace_back(LegGeometry::Annotation{
             current_distance, path_point.duration_until_turn / 10., path_point.datasource_id});
         geometry.locations.push_back(std::move(coordinate));
+        geometry.zoom_levels.push_back(path_point.zoom_level);
         geometry.osm_node_ids.push_back(facade.GetOSMNodeIDOfNode(path_point.turn_via_node));
     }
     current_distance =
@@ -109,6 +127,7 @@ inline LegGeometry assembleGeometry(const datafacade::BaseDataFacade &facade,
                                 forward_datasources[target_node.fwd_segment_position]});
     geometry.segment_offsets.push_back(geometry.locations.size());
     geometry.locations.push_back(target_node.location);
+    geometry.zoom_levels.push_back(0);
 
     //                           u       *      v
     //                           0 -- 1 -- 2 -- 3
@@ -137,9 +156,32 @@ inline LegGeometry assembleGeometry(const datafacade::BaseDataFacade &facade,
     BOOST_ASSERT(geometry.segment_distances.size() == geometry.segment_offsets.size() - 1);
     BOOST_ASSERT(geometry.locations.size() > geometry.segment_distances.size());
     BOOST_ASSERT(geometry.annotations.size() == geometry.locations.size() - 1);
+    BOOST_ASSERT(geometry.zoom_levels.size() == geometry.locations.size());
 
     return geometry;
 }
+
+// Calculates the traveled distance of a leg the same way assembleGeometry does, without
+// building the geometry.
+inline double assembleDistance(const datafacade::BaseDataFacade &facade,
+                               const PathDataVector &leg_data,
+                               const PhantomNode &source_node,
+                               const PhantomNode &target_node)
+{
+    auto distance = 0.;
+    auto prev_coordinate = source_node.location;
+    for (const auto &path_point : leg_data)
+    {
+        const auto coordinate = facade.GetCoordinateOfNode(path_point.turn_via_node);
+        distance += detail::getSegmentLength(
+            prev_coordinate, coordinate, path_point, &path_point == &leg_data.front());
+        prev_coordinate = coordinate;
+    }
+    distance +=
+        util::coordinate_calculation::haversineDistance(prev_coordinate, target_node.location);
+
+    return distance;
+}
 }
 }
 }
@@ -8,10 +8,6 @@
 #include "engine/internal_route_result.hpp"
 #include "util/typedefs.hpp"
 
-#include <boost/algorithm/string/join.hpp>
-#include <boost/range/adaptor/filtered.hpp>
-#include <boost/range/adaptor/transformed.hpp>
-
 #include <cstddef>
 #include <cstdint>
 
@@ -40,7 +36,7 @@ struct NamedSegment
 
 template <std::size_t SegmentNumber>
 
-std::array<std::uint32_t, SegmentNumber> summarizeRoute(const std::vector<PathData> &route_data,
+std::array<std::uint32_t, SegmentNumber> summarizeRoute(const PathDataVector &route_data,
                                                         const PhantomNode &target_node,
                                                         const bool target_traversed_in_reverse)
 {
@@ -121,20 +117,16 @@ std::array<std::uint32_t, SegmentNumber> summarizeRoute(const std::vector<PathDa
 }
 }
 
-inline RouteLeg assembleLeg(const datafacade::BaseDataFacade &facade,
-                            const std::vector<PathData> &route_data,
-                            const LegGeometry &leg_geometry,
-                            const PhantomNode &source_node,
-                            const PhantomNode &target_node,
-                            const bool target_traversed_in_reverse,
-                            const bool needs_summary)
+// Calculates the duration of a leg from its path data and the phantom nodes at its ends
+inline double assembleDuration(const PathDataVector &route_data,
+                               const PhantomNode &source_node,
+                               const PhantomNode &target_node,
+                               const bool target_traversed_in_reverse)
 {
     const auto target_duration =
         (target_traversed_in_reverse ? target_node.reverse_weight : target_node.forward_weight) /
         10.;
 
-    auto distance = std::accumulate(
-        leg_geometry.segment_distances.begin(), leg_geometry.segment_distances.end(), 0.);
     auto duration = std::accumulate(route_data.begin(),
                                     route_data.end(),
                                     0.,
@@ -172,6 +164,22 @@ inline RouteLeg assembleLeg(const datafacade::BaseDataFacade &facade,
                     10.0;
     }
 
+    return duration;
+}
+
+inline RouteLeg assembleLeg(const datafacade::BaseDataFacade &facade,
+                            const PathDataVector &route_data,
+                            const LegGeometry &leg_geometry,
+                            const PhantomNode &source_node,
+                            const PhantomNode &target_node,
+                            const bool target_traversed_in_reverse,
+                            const bool needs_summary)
+{
+    const auto distance = std::accumulate(
+        leg_geometry.segment_distances.begin(), leg_geometry.segment_distances.end(), 0.);
+    const auto duration =
+        assembleDuration(route_data, source_node, target_node, target_traversed_in_reverse);
+
     std::string summary;
     if (needs_summary)
     {
@@ -181,24 +189,22 @@ inline RouteLeg assembleLeg(const datafacade::BaseDataFacade &facade,
         BOOST_ASSERT(detail::MAX_USED_SEGMENTS > 0);
         BOOST_ASSERT(summary_array.begin() != summary_array.end());
 
-        // transform a name_id into a string containing either the name, or -if the name is empty-
-        // the reference.
-        const auto name_id_to_string = [&](const NameID name_id) {
+        // the name, or -if the name is empty- the reference of a name_id
+        const auto name_id_to_view = [&](const NameID name_id) {
             const auto name = facade.GetNameForID(name_id);
-            if (!name.empty())
-                return name;
-            else
-            {
-                const auto ref = facade.GetRefForID(name_id);
-                return ref;
-            }
+            return name.empty() ? facade.GetRefForID(name_id) : name;
         };
 
-        const auto not_empty = [&](const std::string &name) { return !name.empty(); };
-
-        const auto summary_names = summary_array | boost::adaptors::transformed(name_id_to_string) |
-                                   boost::adaptors::filtered(not_empty);
-        summary = boost::algorithm::join(summary_names, ", ");
+        // join the names that aren't empty, only the summary itself is copied
+        for (const auto name_id : summary_array)
+        {
+            const auto name = name_id_to_view(name_id);
+            if (name.empty())
+                continue;
+            if (!summary.empty())
+                summary += ", ";
+            summary.append(name.data(), name.size());
+        }
     }
 
     return RouteLeg{duration, distance, summary, {}};
@@ -38,7 +38,7 @@ std::pair<short, short> getIntermediateBearings(const LegGeometry &leg_geometry,
 } // ns detail
 
 inline std::vector<RouteStep> assembleSteps(const datafacade::BaseDataFacade &facade,
-                                            const std::vector<PathData> &leg_data,
+                                            const PathDataVector &leg_data,
                                             const LegGeometry &leg_geometry,
                                             const PhantomNode &source_node,
                                             const PhantomNode &target_node,
@@ -109,10 +109,10 @@ inline std::vector<RouteStep> assembleSteps(const datafacade::BaseDataFacade &fa
                 const auto distance = leg_geometry.segment_distances[segment_index];
 
                 steps.push_back(RouteStep{step_name_id,
-                                          std::move(name),
-                                          std::move(ref),
-                                          std::move(pronunciation),
-                                          std::move(destinations),
+                                          name,
+                                          ref,
+                                          pronunciation,
+                                          destinations,
                                           NO_ROTARY_NAME,
                                           NO_ROTARY_NAME,
                                           segment_duration / 10.0,
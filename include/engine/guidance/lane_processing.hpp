@@ -18,13 +18,11 @@ namespace guidance
 // we anticipate lane changes emitting only matching lanes early on.
 // the second parameter describes the duration that we feel two segments need to be apart to count
 // as separate maneuvers.
-OSRM_ATTR_WARN_UNUSED
-std::vector<RouteStep> anticipateLaneChange(std::vector<RouteStep> steps,
-                                            const double min_duration_needed_for_lane_change = 15);
+void anticipateLaneChange(std::vector<RouteStep> &steps,
+                          const double min_duration_needed_for_lane_change = 15);
 
 // Remove all lane information from roundabouts. See #2626.
-OSRM_ATTR_WARN_UNUSED
-std::vector<RouteStep> removeLanesFromRoundabouts(std::vector<RouteStep> steps);
+void removeLanesFromRoundabouts(std::vector<RouteStep> &steps);
 
 } // namespace guidance
 } // namespace engine
@@ -8,6 +8,7 @@
 #include <boost/assert.hpp>
 
 #include <cstddef>
+#include <cstdint>
 
 #include <cstdlib>
 #include <vector>
@@ -33,6 +34,8 @@ struct LegGeometry
     std::vector<double> segment_distances;
     // original OSM node IDs for each coordinate
     std::vector<OSMNodeID> osm_node_ids;
+    // lowest zoom level at which the overview simplification keeps each coordinate
+    std::vector<std::uint8_t> zoom_levels;
 
     // Per-coordinate metadata
     struct Annotation
@@ -14,25 +14,30 @@ namespace engine
 {
 namespace guidance
 {
-// passed as none-reference to modify in-place and move out again
-OSRM_ATTR_WARN_UNUSED
-std::vector<RouteStep> postProcess(std::vector<RouteStep> steps);
+// All post-processing passes modify the steps of a leg in place. Collapsed steps are invalidated
+// first and then removed from the array without copying the remaining ones.
+
+// Runs all passes below in order on the steps of a leg and syncs the geometry back up with them
+void postProcessLeg(std::vector<RouteStep> &steps,
+                    LegGeometry &leg_geometry,
+                    const PhantomNode &source_node,
+                    const PhantomNode &target_node);
+
+void postProcess(std::vector<RouteStep> &steps);
 
 // Multiple possible reasons can result in unnecessary/confusing instructions
 // A prime example would be a segregated intersection. Turning around at this
 // intersection would result in two instructions to turn left.
 // Collapsing such turns into a single turn instruction, we give a clearer
 // set of instructionst that is not cluttered by unnecessary turns/name changes.
-OSRM_ATTR_WARN_UNUSED
-std::vector<RouteStep> collapseTurns(std::vector<RouteStep> steps);
+void collapseTurns(std::vector<RouteStep> &steps);
 
 // A check whether two instructions can be treated as one. This is only the case for very short
 // maneuvers that can, in some form, be seen as one. Lookahead of one step.
 bool collapsable(const RouteStep &step, const RouteStep &next);
 
 // Elongate a step by another. the data is added either at the front, or the back
-OSRM_ATTR_WARN_UNUSED
-RouteStep elongate(RouteStep step, const RouteStep &by_step);
+void elongate(RouteStep &step, const RouteStep &by_step);
 
 // trim initial/final segment of very short length.
 // This function uses in/out parameter passing to modify both steps and geometry in place.
@@ -42,19 +47,16 @@ RouteStep elongate(RouteStep step, const RouteStep &by_step);
 void trimShortSegments(std::vector<RouteStep> &steps, LegGeometry &geometry);
 
 // assign relative locations to depart/arrive instructions
-OSRM_ATTR_WARN_UNUSED
-std::vector<RouteStep> assignRelativeLocations(std::vector<RouteStep> steps,
-                                               const LegGeometry &geometry,
-                                               const PhantomNode &source_node,
-                                               const PhantomNode &target_node);
+void assignRelativeLocations(std::vector<RouteStep> &steps,
+                             const LegGeometry &geometry,
+                             const PhantomNode &source_node,
+                             const PhantomNode &target_node);
 
 // collapse suppressed instructions remaining into intersections array
-OSRM_ATTR_WARN_UNUSED
-std::vector<RouteStep> buildIntersections(std::vector<RouteStep> steps);
+void buildIntersections(std::vector<RouteStep> &steps);
 
 // remove steps invalidated by post-processing
-OSRM_ATTR_WARN_UNUSED
-std::vector<RouteStep> removeNoTurnInstructions(std::vector<RouteStep> steps);
+void removeNoTurnInstructions(std::vector<RouteStep> &steps);
 
 // remove use lane information that is not actually a turn. For post-processing, we need to
 // associate lanes with every turn. Some of these use-lane instructions are not required after lane
@@ -63,16 +65,13 @@ std::vector<RouteStep> removeNoTurnInstructions(std::vector<RouteStep> steps);
 // FIXME this is currently only a heuristic. We need knowledge on which lanes actually might become
 // turn lanes. If a straight lane becomes a turn lane, this might be something to consider. Right
 // now we bet on lane-anticipation to catch this.
-OSRM_ATTR_WARN_UNUSED
-std::vector<RouteStep> collapseUseLane(std::vector<RouteStep> steps);
+void collapseUseLane(std::vector<RouteStep> &steps);
 
 // postProcess will break the connection between the leg geometry
 // for which a segment is supposed to represent exactly the coordinates
 // between routing maneuvers and the route steps itself.
 // If required, we can get both in sync again using this function.
-// Move in LegGeometry for modification in place.
-OSRM_ATTR_WARN_UNUSED
-LegGeometry resyncGeometry(LegGeometry leg_geometry, const std::vector<RouteStep> &steps);
+void resyncGeometry(LegGeometry &leg_geometry, const std::vector<RouteStep> &steps);
 
 } // namespace guidance
 } // namespace engine
@@ -9,10 +9,10 @@
 
 #include "extractor/guidance/turn_lane_types.hpp"
 #include "util/guidance/turn_lanes.hpp"
+#include "util/string_view.hpp"
 
 #include <cstddef>
 
-#include <string>
 #include <vector>
 
 namespace osrm
@@ -57,12 +57,13 @@ inline Intersection getInvalidIntersection()
 struct RouteStep
 {
     unsigned name_id;
-    std::string name;
-    std::string ref;
-    std::string pronunciation;
-    std::string destinations;
-    std::string rotary_name;
-    std::string rotary_pronunciation;
+    // views into the name data of the facade, only copied when the step is rendered
+    util::StringView name;
+    util::StringView ref;
+    util::StringView pronunciation;
+    util::StringView destinations;
+    util::StringView rotary_name;
+    util::StringView rotary_pronunciation;
     double duration;
     double distance;
     extractor::TravelMode mode;
@@ -76,12 +77,12 @@ struct RouteStep
 inline RouteStep getInvalidRouteStep()
 {
     return {0,
-            "",
-            "",
-            "",
-            "",
-            "",
-            "",
+            {},
+            {},
+            {},
+            {},
+            {},
+            {},
             0,
             0,
             TRAVEL_MODE_INACCESSIBLE,
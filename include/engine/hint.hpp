@@ -48,6 +48,11 @@ class BaseDataFacade;
 }
 
 // Is returned as a temporary identifier for snapped coodinates
+//
+// Responses carry the compact encoding, which only keeps the segment ids, the position of the
+// segment in its geometry, the weights to the snapped location and the checksum of the data.
+// Its phantom node is rebuilt from the segment when the hint is used, which is valid as long as
+// the coordinate still projects onto the same weights. The full encoding is still accepted.
 struct Hint
 {
     PhantomNode phantom;
@@ -56,7 +61,14 @@ struct Hint
     bool IsValid(const util::Coordinate new_input_coordinates,
                  const datafacade::BaseDataFacade &facade) const;
 
+    // The phantom node for the coordinate, rebuilt from the hinted segment if the hint doesn't
+    // hold one for it. Returns an invalid phantom node if the hint doesn't apply.
+    PhantomNode GetPhantomNode(const util::Coordinate input_coordinate,
+                               const datafacade::BaseDataFacade &facade) const;
+
     std::string ToBase64() const;
+    std::string ToCompactBase64() const;
+    // Decodes both encodings
     static Hint FromBase64(const std::string &base64Hint);
 
     friend bool operator==(const Hint &, const Hint &);
@@ -67,6 +79,14 @@ static_assert(sizeof(Hint) == 60 + 4, "Hint is bigger than expected");
 constexpr std::size_t ENCODED_HINT_SIZE = 88;
 static_assert(ENCODED_HINT_SIZE / 4 * 3 >= sizeof(Hint),
               "ENCODED_HINT_SIZE does not match size of Hint");
+
+// version, checksum, forward and reverse segment id, segment position and the forward and
+// reverse weight from the start of the segment ids to the location
+constexpr std::uint8_t COMPACT_HINT_VERSION = 2;
+constexpr std::size_t COMPACT_HINT_SIZE = 1 + 3 * 4 + 2 + 2 * 4;
+constexpr std::size_t ENCODED_COMPACT_HINT_SIZE = 32;
+static_assert(ENCODED_COMPACT_HINT_SIZE == (COMPACT_HINT_SIZE + 2) / 3 * 4,
+              "ENCODED_COMPACT_HINT_SIZE does not match size of compact hints");
 }
 }
 
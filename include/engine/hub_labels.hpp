@@ -0,0 +1,52 @@
+#ifndef ENGINE_HUB_LABELS_HPP
+#define ENGINE_HUB_LABELS_HPP
+
+#include "util/typedefs.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace osrm
+{
+namespace engine
+{
+
+// The hub label of a node in one direction, as it is stored by the data facades: the hubs in
+// ascending order, with the weight from the node to the hub (or from the hub to the node for
+// backward labels). See contractor/hub_labels.hpp for how they are computed.
+struct HubLabel
+{
+    const NodeID *hubs = nullptr;
+    const EdgeWeight *weights = nullptr;
+    std::size_t size = 0;
+};
+
+// The weight of the shortest path from the node of the forward to the node of the backward label,
+// INVALID_EDGE_WEIGHT if they have no hub in common.
+//
+// Intersects the two sorted labels in a single merge over their hubs. Both sides advance without
+// a branch on which of the hubs is smaller, so the loop doesn't stall on mispredicted branches
+// and the weights are only read where the hubs match.
+inline EdgeWeight queryHubLabels(const HubLabel &forward, const HubLabel &backward)
+{
+    EdgeWeight distance = INVALID_EDGE_WEIGHT;
+    std::size_t forward_index = 0;
+    std::size_t backward_index = 0;
+    while (forward_index < forward.size && backward_index < backward.size)
+    {
+        const NodeID forward_hub = forward.hubs[forward_index];
+        const NodeID backward_hub = backward.hubs[backward_index];
+        if (forward_hub == backward_hub)
+        {
+            distance = std::min(distance,
+                                forward.weights[forward_index] + backward.weights[backward_index]);
+        }
+        forward_index += forward_hub <= backward_hub;
+        backward_index += backward_hub <= forward_hub;
+    }
+    return distance;
+}
+}
+}
+
+#endif // ENGINE_HUB_LABELS_HPP
@@ -6,8 +6,10 @@
 #include "engine/phantom_node.hpp"
 #include "osrm/coordinate.hpp"
 #include "util/guidance/turn_lanes.hpp"
+#include "util/query_arena.hpp"
 #include "util/typedefs.hpp"
 
+#include <cstdint>
 #include <vector>
 
 namespace osrm
@@ -36,33 +38,47 @@ struct PathData
 
     // Source of the speed value on this road segment
     DatasourceID datasource_id;
+
+    // lowest zoom level at which the overview simplification keeps the via node
+    std::uint8_t zoom_level;
+
+    // length of the segment that ends at the via node, INVALID_SEGMENT_LENGTH if the lengths
+    // weren't precomputed
+    SegmentLength segment_length;
 };
 
+// The path data of a leg is a temporary of the query, see util::QueryArena
+using PathDataVector = std::vector<PathData, util::QueryAllocator<PathData>>;
+
 struct InternalRouteResult
 {
-    std::vector<std::vector<PathData>> unpacked_path_segments;
-    std::vector<PathData> unpacked_alternative;
+    std::vector<PathDataVector> unpacked_path_segments;
     std::vector<PhantomNodes> segment_end_coordinates;
     std::vector<bool> source_traversed_in_reverse;
     std::vector<bool> target_traversed_in_reverse;
+    int shortest_path_length;
+    // The alternatives of a route with a single leg, best first
+    std::vector<PathDataVector> unpacked_alternatives;
     std::vector<bool> alt_source_traversed_in_reverse;
     std::vector<bool> alt_target_traversed_in_reverse;
-    int shortest_path_length;
-    int alternative_path_length;
+    std::vector<int> alternative_path_lengths;
+    // Duration and distance of every leg, only set instead of the unpacked path if only the
+    // summary of the route was requested
+    std::vector<EdgeWeight> packed_leg_durations;
+    std::vector<double> packed_leg_distances;
 
     bool is_valid() const { return INVALID_EDGE_WEIGHT != shortest_path_length; }
 
-    bool has_alternative() const { return INVALID_EDGE_WEIGHT != alternative_path_length; }
+    bool has_alternative() const { return !alternative_path_lengths.empty(); }
+
+    bool is_packed() const { return !packed_leg_distances.empty(); }
 
     bool is_via_leg(const std::size_t leg) const
     {
         return (leg != unpacked_path_segments.size() - 1);
     }
 
-    InternalRouteResult()
-        : shortest_path_length(INVALID_EDGE_WEIGHT), alternative_path_length(INVALID_EDGE_WEIGHT)
-    {
-    }
+    InternalRouteResult() : shortest_path_length(INVALID_EDGE_WEIGHT) {}
 };
 }
 }
@@ -5,10 +5,14 @@
 
 #include <boost/assert.hpp>
 #include <boost/math/constants/constants.hpp>
+#include <boost/range/iterator_range.hpp>
 
 #include <cmath>
 
+#include <algorithm>
+#include <cstddef>
 #include <limits>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -48,73 +52,93 @@ struct TransitionLogProbability
     double operator()(const double d_t) const { return -log_beta - d_t / beta; }
 };
 
-template <class CandidateLists> struct HiddenMarkovModel
+// The columns of all timestamps of a trace one after each other in flat arrays, the column of
+// timestamp t is [offsets[t], offsets[t + 1]). A model is reused by all traces that a thread
+// matches, so its arrays only grow with the longest trace instead of being allocated per
+// timestamp and trace.
+struct HiddenMarkovModel
 {
-    std::vector<std::vector<double>> viterbi;
-    std::vector<std::vector<std::pair<unsigned, unsigned>>> parents;
-    std::vector<std::vector<float>> path_distances;
-    std::vector<std::vector<bool>> pruned;
-    std::vector<bool> breakage;
-
-    const CandidateLists &candidates_list;
-    const std::vector<std::vector<double>> &emission_log_probabilities;
-
-    HiddenMarkovModel(const CandidateLists &candidates_list,
-                      const std::vector<std::vector<double>> &emission_log_probabilities)
-        : breakage(candidates_list.size()), candidates_list(candidates_list),
-          emission_log_probabilities(emission_log_probabilities)
+    std::vector<std::size_t> offsets;
+    std::vector<float> emission_log_probabilities;
+    std::vector<double> viterbi;
+    std::vector<std::pair<unsigned, unsigned>> parents;
+    std::vector<float> path_distances;
+    // not std::vector<bool>, the inner loops don't need to mask bits
+    std::vector<char> pruned;
+    std::vector<char> breakage;
+
+    // Lays out the columns for the candidates, the emission log probabilities are set after
+    template <class CandidateLists> void Reset(const CandidateLists &candidates_list)
     {
-        viterbi.resize(candidates_list.size());
-        parents.resize(candidates_list.size());
-        path_distances.resize(candidates_list.size());
-        pruned.resize(candidates_list.size());
-        breakage.resize(candidates_list.size());
-        for (const auto i : util::irange<std::size_t>(0UL, candidates_list.size()))
+        offsets.resize(candidates_list.size() + 1);
+        offsets[0] = 0;
+        for (const auto t : util::irange<std::size_t>(0UL, candidates_list.size()))
         {
-            const auto &num_candidates = candidates_list[i].size();
-            // add empty vectors
-            if (num_candidates > 0)
-            {
-                viterbi[i].resize(num_candidates);
-                parents[i].resize(num_candidates);
-                path_distances[i].resize(num_candidates);
-                pruned[i].resize(num_candidates);
-            }
+            offsets[t + 1] = offsets[t] + candidates_list[t].size();
         }
 
+        const auto number_of_states = offsets.back();
+        emission_log_probabilities.resize(number_of_states);
+        viterbi.resize(number_of_states);
+        parents.resize(number_of_states);
+        path_distances.resize(number_of_states);
+        pruned.resize(number_of_states);
+        breakage.resize(candidates_list.size());
+
         Clear(0);
     }
 
+    std::size_t GetNumberOfTimestamps() const { return offsets.size() - 1; }
+
+    // The states of a timestamp in one of the arrays
+    template <typename T>
+    boost::iterator_range<T *> GetColumn(std::vector<T> &states, const std::size_t t) const
+    {
+        BOOST_ASSERT(t + 1 < offsets.size());
+        return boost::make_iterator_range(states.data() + offsets[t],
+                                          states.data() + offsets[t + 1]);
+    }
+
+    template <typename T>
+    boost::iterator_range<const T *> GetColumn(const std::vector<T> &states,
+                                               const std::size_t t) const
+    {
+        BOOST_ASSERT(t + 1 < offsets.size());
+        return boost::make_iterator_range(states.data() + offsets[t],
+                                          states.data() + offsets[t + 1]);
+    }
+
     void Clear(std::size_t initial_timestamp)
     {
         BOOST_ASSERT(viterbi.size() == parents.size() && parents.size() == path_distances.size() &&
-                     path_distances.size() == pruned.size() && pruned.size() == breakage.size());
-
-        for (const auto t : util::irange(initial_timestamp, viterbi.size()))
-        {
-            std::fill(viterbi[t].begin(), viterbi[t].end(), IMPOSSIBLE_LOG_PROB);
-            std::fill(parents[t].begin(), parents[t].end(), std::make_pair(0u, 0u));
-            std::fill(path_distances[t].begin(), path_distances[t].end(), 0);
-            std::fill(pruned[t].begin(), pruned[t].end(), true);
-        }
+                     path_distances.size() == pruned.size() &&
+                     offsets.size() == breakage.size() + 1);
+
+        const auto first_state = offsets[initial_timestamp];
+        std::fill(viterbi.begin() + first_state, viterbi.end(), IMPOSSIBLE_LOG_PROB);
+        std::fill(parents.begin() + first_state, parents.end(), std::make_pair(0u, 0u));
+        std::fill(path_distances.begin() + first_state, path_distances.end(), 0);
+        std::fill(pruned.begin() + first_state, pruned.end(), true);
         std::fill(breakage.begin() + initial_timestamp, breakage.end(), true);
     }
 
     std::size_t initialize(std::size_t initial_timestamp)
     {
-        auto num_points = candidates_list.size();
+        auto num_points = GetNumberOfTimestamps();
         do
         {
             BOOST_ASSERT(initial_timestamp < num_points);
 
-            for (const auto s : util::irange<std::size_t>(0UL, viterbi[initial_timestamp].size()))
+            for (auto state = offsets[initial_timestamp]; state < offsets[initial_timestamp + 1];
+                 ++state)
             {
-                viterbi[initial_timestamp][s] = emission_log_probabilities[initial_timestamp][s];
-                parents[initial_timestamp][s] = std::make_pair(initial_timestamp, s);
-                pruned[initial_timestamp][s] = viterbi[initial_timestamp][s] < MINIMAL_LOG_PROB;
+                viterbi[state] = emission_log_probabilities[state];
+                parents[state] = std::make_pair(static_cast<unsigned>(initial_timestamp),
+                                                static_cast<unsigned>(
+                                                    state - offsets[initial_timestamp]));
+                pruned[state] = viterbi[state] < MINIMAL_LOG_PROB;
 
-                breakage[initial_timestamp] =
-                    breakage[initial_timestamp] && pruned[initial_timestamp][s];
+                breakage[initial_timestamp] = breakage[initial_timestamp] && pruned[state];
             }
 
             ++initial_timestamp;
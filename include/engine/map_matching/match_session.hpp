@@ -0,0 +1,91 @@
+#ifndef MAP_MATCHING_MATCH_SESSION_HPP
+#define MAP_MATCHING_MATCH_SESSION_HPP
+
+#include "engine/map_matching/hidden_markov_model.hpp"
+#include "engine/phantom_node.hpp"
+#include "util/coordinate.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace map_matching
+{
+
+// A point of a streamed trace with its column of the hidden markov model
+struct MatchSessionPoint
+{
+    util::Coordinate coordinate;
+    unsigned timestamp;
+    std::vector<PhantomNodeWithDistance> candidates;
+    std::vector<double> emission_log_probabilities;
+    std::vector<double> viterbi;
+    // trace index and candidate of the previous point on the best path
+    std::vector<std::pair<std::size_t, std::size_t>> parents;
+    std::vector<float> path_distances;
+    std::vector<bool> pruned;
+    // no candidate is reachable from the previous point that isn't broken
+    bool broken;
+};
+
+// The state of a trace that is matched incrementally.
+//
+// Instead of the whole hidden markov model a session only keeps the points of the current
+// sub matching whose matching is not final yet. Once the best paths to all viable candidates of
+// the last point go through the same candidate of an earlier point, the matching up to that
+// point can't change anymore. It is returned and the point becomes the fixed start of the
+// remaining points.
+struct MatchSession
+{
+    // locked by the query that appends points to the session
+    std::mutex mutex;
+
+    // the dataset the candidates were snapped on
+    unsigned data_checksum = 0;
+    bool use_timestamps = false;
+    // the trace index of the next point
+    std::size_t number_of_points = 0;
+
+    // the points from the start of the current sub matching on, the first one has trace index
+    // first_index
+    std::deque<MatchSessionPoint> points;
+    std::size_t first_index = 0;
+    // the last point of the current sub matching that isn't broken, INVALID_STATE until it has
+    // a viable candidate
+    std::size_t frontier = INVALID_STATE;
+    // the tracepoints before this trace index are final
+    std::size_t final_end = 0;
+    // the last sample times, their median tells apart gaps in the trace
+    std::deque<unsigned> sample_times;
+    unsigned last_timestamp = 0;
+
+    // Drops the pending points, the ones that aren't final stay unmatched
+    void Clear()
+    {
+        points.clear();
+        first_index = number_of_points;
+        frontier = INVALID_STATE;
+        final_end = number_of_points;
+    }
+
+    MatchSessionPoint &GetPoint(const std::size_t trace_index)
+    {
+        return points[trace_index - first_index];
+    }
+
+    const MatchSessionPoint &GetPoint(const std::size_t trace_index) const
+    {
+        return points[trace_index - first_index];
+    }
+};
+}
+}
+}
+
+#endif // MAP_MATCHING_MATCH_SESSION_HPP
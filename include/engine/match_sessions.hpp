@@ -0,0 +1,24 @@
+#ifndef MATCH_SESSIONS_HPP
+#define MATCH_SESSIONS_HPP
+
+#include "engine/map_matching/match_session.hpp"
+#include "engine/sessions.hpp"
+
+#include <cstddef>
+
+namespace osrm
+{
+namespace engine
+{
+
+// The sessions of incrementally matched traces, vehicles that stop sending points never finish
+// theirs
+class MatchSessions final : public Sessions<map_matching::MatchSession>
+{
+  public:
+    explicit MatchSessions(const std::size_t capacity_) : Sessions(capacity_) {}
+};
+}
+}
+
+#endif // MATCH_SESSIONS_HPP
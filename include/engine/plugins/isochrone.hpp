@@ -0,0 +1,50 @@
+#ifndef ISOCHRONE_HPP
+#define ISOCHRONE_HPP
+
+#include "engine/plugins/plugin_base.hpp"
+
+#include "engine/api/isochrone_parameters.hpp"
+#include "engine/routing_algorithms/one_to_all.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/json_container.hpp"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace plugins
+{
+
+// The areas reachable from a coordinate within durations. A single search bounded by the
+// longest duration finds the durations to all nodes it reaches, the road geometry of the
+// reached nodes makes up the contours of all durations.
+class IsochronePlugin final : public BasePlugin
+{
+  public:
+    explicit IsochronePlugin(datafacade::BaseDataFacade &facade,
+                             const int max_duration_isochrone,
+                             SnappingCache *snapping_cache = nullptr);
+
+    Status HandleRequest(const api::IsochroneParameters &params, util::json::Object &result);
+
+  private:
+    // The geometry of every edge-based node, SPECIAL_EDGEID for nodes without one. A node's
+    // geometry is on the original edges that leave it, which are stored at either of their
+    // nodes, so finding them takes a scan over the whole graph. It is done by the first query.
+    const std::vector<unsigned> &GetNodeGeometries();
+
+    SearchEngineData heaps;
+    routing_algorithms::OneToAllRouting<datafacade::BaseDataFacade> one_to_all;
+    std::once_flag node_geometries_flag;
+    std::vector<unsigned> node_geometries;
+    int max_duration_isochrone;
+};
+}
+}
+}
+
+#endif // ISOCHRONE_HPP
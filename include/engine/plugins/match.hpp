@@ -1,14 +1,20 @@
 #ifndef MATCH_HPP
 #define MATCH_HPP
 
+#include "engine/api/match_batch_parameters.hpp"
+#include "engine/api/match_batch_result.hpp"
 #include "engine/api/match_parameters.hpp"
+#include "engine/api/match_stream_parameters.hpp"
 #include "engine/plugins/plugin_base.hpp"
 
 #include "engine/map_matching/bayes_classifier.hpp"
+#include "engine/match_sessions.hpp"
 #include "engine/routing_algorithms/map_matching.hpp"
 #include "engine/routing_algorithms/shortest_path.hpp"
 #include "util/json_util.hpp"
 
+#include <cstddef>
+#include <string>
 #include <vector>
 
 namespace osrm
@@ -23,23 +29,68 @@ class MatchPlugin : public BasePlugin
   public:
     using SubMatching = map_matching::SubMatching;
     using SubMatchingList = routing_algorithms::SubMatchingList;
+    using CandidateList = routing_algorithms::CandidateList;
     using CandidateLists = routing_algorithms::CandidateLists;
     static const constexpr double DEFAULT_GPS_PRECISION = 5;
     static const constexpr double RADIUS_MULTIPLIER = 3;
+    // closer points don't tell the heading of the trace apart from the noise of the GPS
+    static const constexpr double MIN_HEADING_DISTANCE = 20;
 
-    MatchPlugin(datafacade::BaseDataFacade &facade_, const int max_locations_map_matching)
+    // The candidates that were left out of the hidden markov model
+    struct CandidateStatistics
+    {
+        // after the split of the candidates into their directions
+        std::size_t found = 0;
+        std::size_t pruned_by_heading = 0;
+        std::size_t pruned_by_count = 0;
+    };
+
+    MatchPlugin(datafacade::BaseDataFacade &facade_,
+                const int max_locations_map_matching,
+                UnpackingCache *unpacking_cache = nullptr,
+                const bool use_stall_on_demand = false,
+                MatchSessions *match_sessions_ = nullptr,
+                const std::size_t max_match_session_points_ = 100,
+                const int max_traces_match_batch_ = -1)
         : BasePlugin(facade_), map_matching(&facade_, heaps, DEFAULT_GPS_PRECISION),
-          shortest_path(&facade_, heaps), max_locations_map_matching(max_locations_map_matching)
+          shortest_path(&facade_, heaps, unpacking_cache),
+          max_locations_map_matching(max_locations_map_matching), match_sessions(match_sessions_),
+          max_match_session_points(max_match_session_points_),
+          max_traces_match_batch(max_traces_match_batch_)
     {
+        if (use_stall_on_demand)
+        {
+            map_matching.SetStallingMode(routing_algorithms::StallingMode::OnDemand);
+            shortest_path.SetStallingMode(routing_algorithms::StallingMode::OnDemand);
+        }
     }
 
     Status HandleRequest(const api::MatchParameters &parameters, util::json::Object &json_result);
+    Status HandleRequest(const api::MatchStreamParameters &parameters,
+                         util::json::Object &json_result);
+    Status HandleRequest(const api::MatchBatchParameters &parameters,
+                         api::MatchBatchResult &result);
 
   private:
+    // Snaps and matches the trace, or sets the code and message why it can't be matched
+    Status MatchTrace(const api::MatchParameters &parameters,
+                      SubMatchingList &sub_matchings,
+                      CandidateStatistics &statistics,
+                      std::string &code,
+                      std::string &message);
+
+    // the routes along the matched points, for their geometry
+    void RouteSubMatchings(const SubMatchingList &sub_matchings,
+                           std::vector<InternalRouteResult> &sub_routes) const;
+
     SearchEngineData heaps;
     routing_algorithms::MapMatching<datafacade::BaseDataFacade> map_matching;
     routing_algorithms::ShortestPathRouting<datafacade::BaseDataFacade> shortest_path;
     int max_locations_map_matching;
+    // shared by the plugins of all datasets, nullptr if disabled
+    MatchSessions *const match_sessions;
+    const std::size_t max_match_session_points;
+    const int max_traces_match_batch;
 };
 }
 }
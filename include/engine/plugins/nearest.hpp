@@ -2,6 +2,7 @@
 #define NEAREST_HPP
 
 #include "engine/api/nearest_parameters.hpp"
+#include "engine/api/nearest_result.hpp"
 #include "engine/plugins/plugin_base.hpp"
 #include "osrm/json_container.hpp"
 
@@ -15,12 +16,19 @@ namespace plugins
 class NearestPlugin final : public BasePlugin
 {
   public:
-    explicit NearestPlugin(datafacade::BaseDataFacade &facade, const int max_results);
+    explicit NearestPlugin(datafacade::BaseDataFacade &facade,
+                           const int max_results,
+                           const int max_locations = -1);
 
     Status HandleRequest(const api::NearestParameters &params, util::json::Object &result);
+    Status HandleRequest(const api::NearestParameters &params, api::NearestResult &result);
 
   private:
+    template <typename ResultT>
+    Status HandleRequestImpl(const api::NearestParameters &params, ResultT &result);
+
     const int max_results;
+    const int max_locations;
 };
 }
 }
@@ -0,0 +1,42 @@
+#ifndef ONE_TO_ALL_HPP
+#define ONE_TO_ALL_HPP
+
+#include "engine/plugins/plugin_base.hpp"
+
+#include "engine/api/one_to_all_parameters.hpp"
+#include "engine/api/one_to_all_result.hpp"
+#include "engine/routing_algorithms/one_to_all.hpp"
+#include "engine/search_engine_data.hpp"
+
+#include <string>
+
+namespace osrm
+{
+namespace engine
+{
+namespace plugins
+{
+
+class OneToAllPlugin final : public BasePlugin
+{
+  public:
+    explicit OneToAllPlugin(datafacade::BaseDataFacade &facade,
+                            const int max_locations_one_to_all,
+                            SnappingCache *snapping_cache = nullptr);
+
+    Status HandleRequest(const api::OneToAllParameters &params, api::OneToAllResult &result);
+
+  private:
+    Status Error(const std::string &code,
+                 const std::string &message,
+                 api::OneToAllResult &result) const;
+
+    SearchEngineData heaps;
+    routing_algorithms::OneToAllRouting<datafacade::BaseDataFacade> one_to_all;
+    int max_locations_one_to_all;
+};
+}
+}
+}
+
+#endif // ONE_TO_ALL_HPP
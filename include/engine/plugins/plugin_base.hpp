@@ -2,18 +2,31 @@
 #define BASE_PLUGIN_HPP
 
 #include "engine/api/base_parameters.hpp"
+#include "engine/api/pbf.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
+#include "engine/hint.hpp"
 #include "engine/phantom_node.hpp"
+#include "engine/search_engine_data.hpp"
+#include "engine/snapping_cache.hpp"
 #include "engine/status.hpp"
 
 #include "util/coordinate.hpp"
 #include "util/coordinate_calculation.hpp"
+#include "util/hilbert_value.hpp"
 #include "util/integer_range.hpp"
 #include "util/json_container.hpp"
+#include "util/query_metrics.hpp"
+
+#include <protozero/pbf_writer.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <iterator>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -27,7 +40,74 @@ class BasePlugin
 {
   protected:
     datafacade::BaseDataFacade &facade;
-    BasePlugin(datafacade::BaseDataFacade &facade_) : facade(facade_) {}
+    // shared by the plugins of an engine, nullptr if disabled
+    SnappingCache *snapping_cache;
+    BasePlugin(datafacade::BaseDataFacade &facade_, SnappingCache *snapping_cache_ = nullptr)
+        : facade(facade_), snapping_cache(snapping_cache_)
+    {
+    }
+
+    // fewer coordinates are snapped one after the other in their order
+    static constexpr std::size_t MIN_SNAPPING_BATCH_SIZE = 16;
+    static constexpr std::size_t SNAPPING_GRAIN_SIZE = 8;
+
+    // Calls snap with the index of every coordinate, in order until it returns false. The many
+    // coordinates of a table or a trace are snapped in parallel instead, all of them, in the
+    // order of their Hilbert values. Coordinates close to each other are then snapped by the
+    // same thread one after the other, which finds the r-tree nodes they share in its cache.
+    template <typename SnapT>
+    void SnapCoordinates(const std::vector<util::Coordinate> &coordinates, const SnapT &snap) const
+    {
+        if (coordinates.size() < MIN_SNAPPING_BATCH_SIZE)
+        {
+            for (const auto i : util::irange<std::size_t>(0UL, coordinates.size()))
+            {
+                if (!snap(i))
+                {
+                    break;
+                }
+            }
+            return;
+        }
+
+        std::vector<std::pair<std::uint64_t, std::size_t>> order;
+        order.reserve(coordinates.size());
+        for (const auto i : util::irange<std::size_t>(0UL, coordinates.size()))
+        {
+            order.emplace_back(util::hilbertCode(coordinates[i]), i);
+        }
+        std::sort(order.begin(), order.end());
+
+        const auto cell_metric = SearchEngineData::GetCellMetric();
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, order.size(), SNAPPING_GRAIN_SIZE),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              const SearchEngineData::ScopedCellMetric metric(cell_metric);
+                              for (auto index = range.begin(); index != range.end(); ++index)
+                              {
+                                  snap(order[index].second);
+                              }
+                          });
+    }
+
+    // Sets the phantom node of the hint of a coordinate if there is one that applies. A hint
+    // may point at a node of an excluded class, the coordinates are snapped again then.
+    bool GetHintedPhantomNode(const api::BaseParameters &parameters,
+                              const std::size_t index,
+                              PhantomNode &phantom_node) const
+    {
+        if (!parameters.hints[index] || SearchEngineData::GetCellMetric() != 0)
+        {
+            return false;
+        }
+        auto hinted =
+            parameters.hints[index]->GetPhantomNode(parameters.coordinates[index], facade);
+        if (!hinted.IsValid(facade.GetNumberOfNodes()))
+        {
+            return false;
+        }
+        phantom_node = std::move(hinted);
+        return true;
+    }
 
     bool CheckAllCoordinates(const std::vector<util::Coordinate> &coordinates)
     {
@@ -46,11 +126,31 @@ class BasePlugin
         return Status::Error;
     }
 
+    // for the services that can answer with a protobuf message
+    Status Error(const std::string &code, const std::string &message, std::string &pbf_result) const
+    {
+        pbf_result.clear();
+        protozero::pbf_writer writer(pbf_result);
+        writer.add_string(api::pbf::CODE_TAG, code);
+        writer.add_string(api::pbf::MESSAGE_TAG, message);
+        return Status::Error;
+    }
+
+    // for the services that fill a plain result struct
+    template <typename ResultT>
+    Status Error(const std::string &code, const std::string &message, ResultT &result) const
+    {
+        result.code = code;
+        result.message = message;
+        return Status::Error;
+    }
+
     // Decides whether to use the phantom node from a big or small component if both are found.
     // Returns true if all phantom nodes are in the same component after snapping.
     std::vector<PhantomNode>
     SnapPhantomNodes(const std::vector<PhantomNodePair> &phantom_node_pair_list) const
     {
+        const util::QueryMetrics::ScopedPhase snapping(util::QueryMetrics::Phase::Snapping);
         const auto check_component_id_is_tiny =
             [](const std::pair<PhantomNode, PhantomNode> &phantom_pair) {
                 return phantom_pair.first.component.is_tiny;
@@ -114,6 +214,7 @@ class BasePlugin
     GetPhantomNodesInRange(const api::BaseParameters &parameters,
                            const std::vector<double> radiuses) const
     {
+        const util::QueryMetrics::ScopedPhase snapping(util::QueryMetrics::Phase::Snapping);
         std::vector<std::vector<PhantomNodeWithDistance>> phantom_nodes(
             parameters.coordinates.size());
         BOOST_ASSERT(radiuses.size() == parameters.coordinates.size());
@@ -121,17 +222,16 @@ class BasePlugin
         const bool use_hints = !parameters.hints.empty();
         const bool use_bearings = !parameters.bearings.empty();
 
-        for (const auto i : util::irange<std::size_t>(0UL, parameters.coordinates.size()))
-        {
-            if (use_hints && parameters.hints[i] &&
-                parameters.hints[i]->IsValid(parameters.coordinates[i], facade))
+        SnapCoordinates(parameters.coordinates, [&](const std::size_t i) {
+            PhantomNode hinted_phantom;
+            if (use_hints && GetHintedPhantomNode(parameters, i, hinted_phantom))
             {
                 phantom_nodes[i].push_back(PhantomNodeWithDistance{
-                    parameters.hints[i]->phantom,
-                    util::coordinate_calculation::haversineDistance(
-                        parameters.coordinates[i], parameters.hints[i]->phantom.location),
+                    hinted_phantom,
+                    util::coordinate_calculation::haversineDistance(parameters.coordinates[i],
+                                                                    hinted_phantom.location),
                 });
-                continue;
+                return true;
             }
             if (use_bearings && parameters.bearings[i])
             {
@@ -146,7 +246,8 @@ class BasePlugin
                 phantom_nodes[i] =
                     facade.NearestPhantomNodesInRange(parameters.coordinates[i], radiuses[i]);
             }
-        }
+            return true;
+        });
 
         return phantom_nodes;
     }
@@ -154,6 +255,7 @@ class BasePlugin
     std::vector<std::vector<PhantomNodeWithDistance>>
     GetPhantomNodes(const api::BaseParameters &parameters, unsigned number_of_results)
     {
+        const util::QueryMetrics::ScopedPhase snapping(util::QueryMetrics::Phase::Snapping);
         std::vector<std::vector<PhantomNodeWithDistance>> phantom_nodes(
             parameters.coordinates.size());
 
@@ -162,17 +264,16 @@ class BasePlugin
         const bool use_radiuses = !parameters.radiuses.empty();
 
         BOOST_ASSERT(parameters.IsValid());
-        for (const auto i : util::irange<std::size_t>(0UL, parameters.coordinates.size()))
-        {
-            if (use_hints && parameters.hints[i] &&
-                parameters.hints[i]->IsValid(parameters.coordinates[i], facade))
+        SnapCoordinates(parameters.coordinates, [&](const std::size_t i) {
+            PhantomNode hinted_phantom;
+            if (use_hints && GetHintedPhantomNode(parameters, i, hinted_phantom))
             {
                 phantom_nodes[i].push_back(PhantomNodeWithDistance{
-                    parameters.hints[i]->phantom,
-                    util::coordinate_calculation::haversineDistance(
-                        parameters.coordinates[i], parameters.hints[i]->phantom.location),
+                    hinted_phantom,
+                    util::coordinate_calculation::haversineDistance(parameters.coordinates[i],
+                                                                    hinted_phantom.location),
                 });
-                continue;
+                return true;
             }
 
             if (use_bearings && parameters.bearings[i])
@@ -207,32 +308,45 @@ class BasePlugin
                 }
             }
 
-            // we didn't find a fitting node, return error
-            if (phantom_nodes[i].empty())
-            {
-                break;
-            }
-        }
+            // nearest reports the coordinates without a fitting node itself
+            return true;
+        });
         return phantom_nodes;
     }
 
     std::vector<PhantomNodePair> GetPhantomNodes(const api::BaseParameters &parameters)
     {
+        const util::QueryMetrics::ScopedPhase snapping(util::QueryMetrics::Phase::Snapping);
         std::vector<PhantomNodePair> phantom_node_pairs(parameters.coordinates.size());
 
         const bool use_hints = !parameters.hints.empty();
         const bool use_bearings = !parameters.bearings.empty();
         const bool use_radiuses = !parameters.radiuses.empty();
+        const auto data_checksum = facade.GetCheckSum();
+        // the cache holds the snapped nodes without exclusions
+        const auto use_snapping_cache =
+            snapping_cache != nullptr && SearchEngineData::GetCellMetric() == 0;
 
         BOOST_ASSERT(parameters.IsValid());
-        for (const auto i : util::irange<std::size_t>(0UL, parameters.coordinates.size()))
-        {
-            if (use_hints && parameters.hints[i] &&
-                parameters.hints[i]->IsValid(parameters.coordinates[i], facade))
+        SnapCoordinates(parameters.coordinates, [&](const std::size_t i) {
+            if (use_hints && GetHintedPhantomNode(parameters, i, phantom_node_pairs[i].first))
             {
-                phantom_node_pairs[i].first = parameters.hints[i]->phantom;
                 // we don't set the second one - it will be marked as invalid
-                continue;
+                return true;
+            }
+
+            const boost::optional<double> radius =
+                use_radiuses ? parameters.radiuses[i] : boost::none;
+            const auto key = use_bearings && parameters.bearings[i]
+                                 ? SnappingCache::Key{parameters.coordinates[i],
+                                                      radius,
+                                                      parameters.bearings[i]->bearing,
+                                                      parameters.bearings[i]->range}
+                                 : SnappingCache::Key{parameters.coordinates[i], radius};
+            if (use_snapping_cache &&
+                snapping_cache->Get(data_checksum, key, phantom_node_pairs[i]))
+            {
+                return true;
             }
 
             if (use_bearings && parameters.bearings[i])
@@ -274,13 +388,24 @@ class BasePlugin
             // we didn't find a fitting node, return error
             if (!phantom_node_pairs[i].first.IsValid(facade.GetNumberOfNodes()))
             {
-                // TODO document why?
-                phantom_node_pairs.pop_back();
-                break;
+                return false;
             }
-            BOOST_ASSERT(phantom_node_pairs[i].first.IsValid(facade.GetNumberOfNodes()));
             BOOST_ASSERT(phantom_node_pairs[i].second.IsValid(facade.GetNumberOfNodes()));
-        }
+            if (use_snapping_cache)
+            {
+                snapping_cache->Add(data_checksum, key, phantom_node_pairs[i]);
+            }
+            return true;
+        });
+
+        // the number of phantom nodes tells the caller which coordinate couldn't be snapped
+        const auto first_invalid =
+            std::find_if(phantom_node_pairs.begin(),
+                         phantom_node_pairs.end(),
+                         [this](const PhantomNodePair &pair) {
+                             return !pair.first.IsValid(facade.GetNumberOfNodes());
+                         });
+        phantom_node_pairs.erase(first_invalid, phantom_node_pairs.end());
         return phantom_node_pairs;
     }
 };
@@ -4,10 +4,16 @@
 #include "engine/plugins/plugin_base.hpp"
 
 #include "engine/api/table_parameters.hpp"
+#include "engine/api/table_result.hpp"
+#include "engine/api/table_stream.hpp"
 #include "engine/routing_algorithms/many_to_many.hpp"
 #include "engine/search_engine_data.hpp"
+#include "engine/table_sessions.hpp"
 #include "util/json_container.hpp"
 
+#include <string>
+#include <vector>
+
 namespace osrm
 {
 namespace engine
@@ -19,14 +25,55 @@ class TablePlugin final : public BasePlugin
 {
   public:
     explicit TablePlugin(datafacade::BaseDataFacade &facade,
-                         const int max_locations_distance_table);
+                         const int max_locations_distance_table,
+                         const bool use_parallel_distance_table = false,
+                         SnappingCache *snapping_cache = nullptr,
+                         TableSessions *table_sessions = nullptr,
+                         SearchSpaceCache *search_space_cache = nullptr);
 
     Status HandleRequest(const api::TableParameters &params, util::json::Object &result);
+    // the response rendered in the format of the parameters
+    Status HandleRequest(const api::TableParameters &params, std::string &result);
+    Status HandleRequest(const api::TableParameters &params, api::TableResult &result);
+    // computes and writes the JSON in blocks of rows, see api::TableStream
+    Status HandleRequest(const api::TableParameters &params, api::TableStream &result);
 
   private:
+    template <typename ResultT>
+    Status HandleRequestImpl(const api::TableParameters &params, ResultT &result);
+
+    template <typename ResultT>
+    Status MakeTable(const api::TableParameters &params,
+                     const std::vector<PhantomNode> &snapped_phantoms,
+                     const EdgeWeight max_weight,
+                     ResultT &result);
+    Status MakeTable(const api::TableParameters &params,
+                     const std::vector<PhantomNode> &snapped_phantoms,
+                     const EdgeWeight max_weight,
+                     api::TableStream &result);
+
+    Status Fail(const api::TableParameters &params,
+                const std::string &code,
+                const std::string &message,
+                util::json::Object &result) const;
+    Status Fail(const api::TableParameters &params,
+                const std::string &code,
+                const std::string &message,
+                std::string &result) const;
+    Status Fail(const api::TableParameters &params,
+                const std::string &code,
+                const std::string &message,
+                api::TableResult &result) const;
+    Status Fail(const api::TableParameters &params,
+                const std::string &code,
+                const std::string &message,
+                api::TableStream &result) const;
+
     SearchEngineData heaps;
     routing_algorithms::ManyToManyRouting<datafacade::BaseDataFacade> distance_table;
     int max_locations_distance_table;
+    bool use_parallel_distance_table;
+    TableSessions *const table_sessions;
 };
 }
 }
@@ -3,6 +3,7 @@
 
 #include "engine/api/tile_parameters.hpp"
 #include "engine/plugins/plugin_base.hpp"
+#include "engine/tile_cache.hpp"
 
 #include <string>
 
@@ -24,9 +25,17 @@ namespace plugins
 class TilePlugin final : public BasePlugin
 {
   public:
-    TilePlugin(datafacade::BaseDataFacade &facade) : BasePlugin(facade) {}
+    TilePlugin(datafacade::BaseDataFacade &facade, TileCache *tile_cache_ = nullptr)
+        : BasePlugin(facade), tile_cache(tile_cache_)
+    {
+    }
 
     Status HandleRequest(const api::TileParameters &parameters, std::string &pbf_buffer);
+
+  private:
+    void GetTileEdges(const api::TileParameters &parameters, TileEdges &tile_edges) const;
+
+    TileCache *const tile_cache;
 };
 }
 }
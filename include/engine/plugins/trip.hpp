@@ -6,6 +6,7 @@
 #include "engine/api/trip_parameters.hpp"
 #include "engine/routing_algorithms/many_to_many.hpp"
 #include "engine/routing_algorithms/shortest_path.hpp"
+#include "util/dist_table_wrapper.hpp"
 
 #include "osrm/json_container.hpp"
 
@@ -33,15 +34,45 @@ class TripPlugin final : public BasePlugin
     routing_algorithms::ShortestPathRouting<datafacade::BaseDataFacade> shortest_path;
     routing_algorithms::ManyToManyRouting<datafacade::BaseDataFacade> duration_table;
     int max_locations_trip;
+    std::size_t large_trip_locations;
 
+    InternalRouteResult
+    ComputeRoute(const std::vector<PhantomNode> &phantom_node_list,
+                 const std::vector<NodeID> &trip,
+                 const util::DistTableWrapper<EdgeWeight> &result_table,
+                 const routing_algorithms::ManyToManySearchSpaces &search_spaces);
+
+    // Searches every leg of the trip
     InternalRouteResult ComputeRoute(const std::vector<PhantomNode> &phantom_node_list,
                                      const std::vector<NodeID> &trip);
 
+    // Computes a round trip through all locations from the tables of nearby locations only,
+    // returns false if some of them can't reach each other
+    bool ComputeClusteredTrip(const std::vector<PhantomNode> &phantom_node_list,
+                              std::vector<NodeID> &trip);
+
+    // The durations between the locations, false if some of them can't reach each other
+    bool ComputeTable(const std::vector<PhantomNode> &phantom_node_list,
+                      const std::vector<NodeID> &locations,
+                      std::vector<EdgeWeight> &table) const;
+
   public:
-    explicit TripPlugin(datafacade::BaseDataFacade &facade_, const int max_locations_trip_)
-        : BasePlugin(facade_), shortest_path(&facade_, heaps), duration_table(&facade_, heaps),
-          max_locations_trip(max_locations_trip_)
+    explicit TripPlugin(datafacade::BaseDataFacade &facade_,
+                        const int max_locations_trip_,
+                        UnpackingCache *unpacking_cache = nullptr,
+                        const bool use_stall_on_demand = false,
+                        SnappingCache *snapping_cache = nullptr,
+                        const std::size_t parallel_unpacking_length = 0,
+                        const std::size_t large_trip_locations_ = 0)
+        : BasePlugin(facade_, snapping_cache), shortest_path(&facade_, heaps, unpacking_cache),
+          duration_table(&facade_, heaps), max_locations_trip(max_locations_trip_),
+          large_trip_locations(large_trip_locations_)
     {
+        if (use_stall_on_demand)
+        {
+            shortest_path.SetStallingMode(routing_algorithms::StallingMode::OnDemand);
+        }
+        shortest_path.SetParallelUnpackingLength(parallel_unpacking_length);
     }
 
     Status HandleRequest(const api::TripParameters &parameters, util::json::Object &json_result);
@@ -2,6 +2,8 @@
 #define VIA_ROUTE_HPP
 
 #include "engine/api/route_api.hpp"
+#include "engine/api/route_batch_parameters.hpp"
+#include "engine/api/route_result.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
 #include "engine/plugins/plugin_base.hpp"
 
@@ -33,12 +35,38 @@ class ViaRoutePlugin final : public BasePlugin
     routing_algorithms::AlternativeRouting<datafacade::BaseDataFacade> alternative_path;
     routing_algorithms::DirectShortestPathRouting<datafacade::BaseDataFacade> direct_shortest_path;
     int max_locations_viaroute;
+    int max_pairs_route_batch;
+    bool use_parallel_route_legs;
+
+    // Searches the route through all snapped phantom nodes into raw_route
+    void ComputeRoute(const api::RouteParameters &route_parameters,
+                      const std::vector<PhantomNode> &snapped_phantoms,
+                      InternalRouteResult &raw_route);
+
+    template <typename ResultT>
+    Status HandleRequestImpl(const api::RouteParameters &route_parameters, ResultT &result);
+
+    template <typename ResultT>
+    Status NoRouteError(const std::vector<PhantomNode> &snapped_phantoms, ResultT &result) const;
 
   public:
-    explicit ViaRoutePlugin(datafacade::BaseDataFacade &facade, int max_locations_viaroute);
+    explicit ViaRoutePlugin(datafacade::BaseDataFacade &facade,
+                            int max_locations_viaroute,
+                            int max_pairs_route_batch = -1,
+                            UnpackingCache *unpacking_cache = nullptr,
+                            const bool use_stall_on_demand = false,
+                            SnappingCache *snapping_cache = nullptr,
+                            const bool use_parallel_route_legs = false,
+                            const std::size_t parallel_unpacking_length = 0);
 
     Status HandleRequest(const api::RouteParameters &route_parameters,
                          util::json::Object &json_result);
+    // Only the summaries of the routes, whatever the parameters ask for
+    Status HandleRequest(const api::RouteParameters &route_parameters, api::RouteResult &result);
+
+    // Routes every origin/destination pair of the batch independently, reusing the heaps
+    Status HandleRequest(const api::RouteBatchParameters &batch_parameters,
+                         util::json::Object &json_result);
 };
 }
 }
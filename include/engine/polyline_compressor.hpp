@@ -18,13 +18,24 @@ constexpr double POLYLINE_TO_COORDINATE = COORDINATE_PRECISION / POLYLINE_PRECIS
 }
 
 using CoordVectorForwardIter = std::vector<util::Coordinate>::const_iterator;
-// Encodes geometry into polyline format.
+// Encodes geometry into polyline format, with five decimals by default. A PRECISION of 1000000
+// gives polyline6, which keeps the full precision of a util::Coordinate.
 // See: https://developers.google.com/maps/documentation/utilities/polylinealgorithm
+template <unsigned PRECISION = 100000>
 std::string encodePolyline(CoordVectorForwardIter begin, CoordVectorForwardIter end);
 
 // Decodes geometry from polyline format
 // See: https://developers.google.com/maps/documentation/utilities/polylinealgorithm
+template <unsigned PRECISION = 100000>
 std::vector<util::Coordinate> decodePolyline(const std::string &polyline);
+
+// defined for polyline and polyline6 only
+extern template std::string encodePolyline<100000>(CoordVectorForwardIter begin,
+                                                   CoordVectorForwardIter end);
+extern template std::string encodePolyline<1000000>(CoordVectorForwardIter begin,
+                                                    CoordVectorForwardIter end);
+extern template std::vector<util::Coordinate> decodePolyline<100000>(const std::string &polyline);
+extern template std::vector<util::Coordinate> decodePolyline<1000000>(const std::string &polyline);
 }
 }
 
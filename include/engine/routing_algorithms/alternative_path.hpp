@@ -8,6 +8,7 @@
 #include <boost/assert.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <iterator>
 #include <unordered_map>
 #include <unordered_set>
@@ -24,6 +25,8 @@ namespace routing_algorithms
 const double VIAPATH_ALPHA = 0.9;
 const double VIAPATH_EPSILON = 0.95; // alternative at most 95% longer
 const double VIAPATH_GAMMA = 0.35;   // alternative shares at most 35% with the shortest.
+// via nodes that are evaluated exactly per requested alternative, best approximation first
+const constexpr std::size_t VIAPATH_CANDIDATES_PER_ALTERNATIVE = 10;
 
 template <class DataFacadeT>
 class AlternativeRouting final
@@ -44,6 +47,9 @@ class AlternativeRouting final
         NodeID node;
         int length;
         int sharing;
+        // the packed paths <s,..,v> and <v,..,t> of the via path
+        std::vector<NodeID> packed_s_v_path;
+        std::vector<NodeID> packed_v_t_path;
 
         bool operator<(const RankedCandidateNode &other) const
         {
@@ -54,32 +60,33 @@ class AlternativeRouting final
     SearchEngineData &engine_working_data;
 
   public:
-    AlternativeRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
-        : super(facade), facade(facade), engine_working_data(engine_working_data)
+    AlternativeRouting(DataFacadeT *facade,
+                       SearchEngineData &engine_working_data,
+                       UnpackingCache *unpacking_cache = nullptr)
+        : super(facade, unpacking_cache), facade(facade), engine_working_data(engine_working_data)
     {
     }
 
     virtual ~AlternativeRouting() {}
 
-    void operator()(const PhantomNodes &phantom_node_pair, InternalRouteResult &raw_route_data)
+    using super::SetParallelUnpackingLength;
+
+    // Finds the shortest path and up to number_of_alternatives alternatives to it. The sharing
+    // of the alternatives with each other is computed on their packed paths.
+    void operator()(const PhantomNodes &phantom_node_pair,
+                    InternalRouteResult &raw_route_data,
+                    const unsigned number_of_alternatives = 1)
     {
-        std::vector<NodeID> alternative_path;
         std::vector<NodeID> via_node_candidate_list;
         std::vector<SearchSpaceEdge> forward_search_space;
         std::vector<SearchSpaceEdge> reverse_search_space;
 
         // Init queues, semi-expensive because access to TSS invokes a sys-call
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-        engine_working_data.InitializeOrClearSecondThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-        engine_working_data.InitializeOrClearThirdThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-
-        QueryHeap &forward_heap1 = *(engine_working_data.forward_heap_1);
-        QueryHeap &reverse_heap1 = *(engine_working_data.reverse_heap_1);
-        QueryHeap &forward_heap2 = *(engine_working_data.forward_heap_2);
-        QueryHeap &reverse_heap2 = *(engine_working_data.reverse_heap_2);
+        engine_working_data.InitializeOrClearFirstHeaps(super::facade->GetNumberOfNodes());
+        engine_working_data.InitializeOrClearThirdHeaps(super::facade->GetNumberOfNodes());
+
+        QueryHeap &forward_heap1 = *engine_working_data.GetHeaps().forward_heap_1;
+        QueryHeap &reverse_heap1 = *engine_working_data.GetHeaps().reverse_heap_1;
 
         int upper_bound_to_shortest_path_distance = INVALID_EDGE_WEIGHT;
         NodeID middle_node = SPECIAL_NODEID;
@@ -242,7 +249,7 @@ class AlternativeRouting final
         // reverse_search_space.size() << ", marked " << approximated_reverse_sharing.size() << "
         // nodes";
 
-        std::vector<NodeID> preselected_node_list;
+        std::vector<RankedCandidateNode> preselected_candidates;
         for (const NodeID node : via_node_candidate_list)
         {
             if (node == middle_node)
@@ -268,10 +275,22 @@ class AlternativeRouting final
 
             if (length_passes && sharing_passes && stretch_passes)
             {
-                preselected_node_list.emplace_back(node);
+                preselected_candidates.emplace_back(
+                    node, approximated_length, approximated_sharing);
             }
         }
 
+        // only the most promising via nodes are inspected in depth, each takes two half searches
+        const auto number_of_inspected_candidates = std::min<std::size_t>(
+            preselected_candidates.size(),
+            VIAPATH_CANDIDATES_PER_ALTERNATIVE * std::max(1u, number_of_alternatives));
+        std::partial_sort(preselected_candidates.begin(),
+                          preselected_candidates.begin() + number_of_inspected_candidates,
+                          preselected_candidates.end());
+        preselected_candidates.erase(preselected_candidates.begin() +
+                                         number_of_inspected_candidates,
+                                     preselected_candidates.end());
+
         std::vector<NodeID> &packed_shortest_path = packed_forward_path;
         if (!path_is_a_loop)
         {
@@ -283,81 +302,83 @@ class AlternativeRouting final
         std::vector<RankedCandidateNode> ranked_candidates_list;
 
         // prioritizing via nodes for deep inspection
-        for (const NodeID node : preselected_node_list)
-        {
-            int length_of_via_path = 0, sharing_of_via_path = 0;
-            ComputeLengthAndSharingOfViaPath(node,
-                                             &length_of_via_path,
-                                             &sharing_of_via_path,
-                                             packed_shortest_path,
-                                             min_edge_offset);
-            const int maximum_allowed_sharing =
-                static_cast<int>(upper_bound_to_shortest_path_distance * VIAPATH_GAMMA);
-            if (sharing_of_via_path <= maximum_allowed_sharing &&
-                length_of_via_path <= upper_bound_to_shortest_path_distance * (1 + VIAPATH_EPSILON))
+        const int maximum_allowed_sharing =
+            static_cast<int>(upper_bound_to_shortest_path_distance * VIAPATH_GAMMA);
+        for (auto &candidate : preselected_candidates)
+        {
+            if (ComputeLengthAndSharingOfViaPath(
+                    candidate, packed_shortest_path, min_edge_offset) &&
+                candidate.sharing <= maximum_allowed_sharing &&
+                candidate.length <= upper_bound_to_shortest_path_distance * (1 + VIAPATH_EPSILON))
             {
-                ranked_candidates_list.emplace_back(node, length_of_via_path, sharing_of_via_path);
+                ranked_candidates_list.push_back(std::move(candidate));
             }
         }
         std::sort(ranked_candidates_list.begin(), ranked_candidates_list.end());
 
-        NodeID selected_via_node = SPECIAL_NODEID;
-        int length_of_via_path = INVALID_EDGE_WEIGHT;
-        NodeID s_v_middle = SPECIAL_NODEID, v_t_middle = SPECIAL_NODEID;
+        // the packed edges of the selected alternatives, sorted
+        std::vector<SearchSpaceEdge> selected_packed_edges;
+        std::vector<std::vector<NodeID>> packed_alternate_paths;
         for (const RankedCandidateNode &candidate : ranked_candidates_list)
         {
-            if (ViaNodeCandidatePassesTTest(forward_heap1,
-                                            reverse_heap1,
-                                            forward_heap2,
-                                            reverse_heap2,
-                                            candidate,
-                                            upper_bound_to_shortest_path_distance,
-                                            &length_of_via_path,
-                                            &s_v_middle,
-                                            &v_t_middle,
-                                            min_edge_offset))
-            {
-                // select first admissable
-                selected_via_node = candidate.node;
+            if (packed_alternate_paths.size() >= number_of_alternatives)
+            {
                 break;
             }
-        }
 
-        // Unpack shortest path and alternative, if they exist
-        if (INVALID_EDGE_WEIGHT != upper_bound_to_shortest_path_distance)
-        {
-            BOOST_ASSERT(!packed_shortest_path.empty());
-            raw_route_data.unpacked_path_segments.resize(1);
-            raw_route_data.source_traversed_in_reverse.push_back(
-                (packed_shortest_path.front() !=
-                 phantom_node_pair.source_phantom.forward_segment_id.id));
-            raw_route_data.target_traversed_in_reverse.push_back(
-                (packed_shortest_path.back() !=
-                 phantom_node_pair.target_phantom.forward_segment_id.id));
+            if (!ViaNodeCandidatePassesTTest(
+                    candidate, upper_bound_to_shortest_path_distance, min_edge_offset))
+            {
+                continue;
+            }
 
-            super::UnpackPath(
-                // -- packed input
-                packed_shortest_path.begin(),
-                packed_shortest_path.end(),
-                // -- start of route
-                phantom_node_pair,
-                // -- unpacked output
-                raw_route_data.unpacked_path_segments.front());
-            raw_route_data.shortest_path_length = upper_bound_to_shortest_path_distance;
-        }
-
-        if (SPECIAL_NODEID != selected_via_node)
-        {
-            std::vector<NodeID> packed_alternate_path;
-            // retrieve alternate path
-            RetrievePackedAlternatePath(forward_heap1,
-                                        reverse_heap1,
-                                        forward_heap2,
-                                        reverse_heap2,
-                                        s_v_middle,
-                                        v_t_middle,
-                                        packed_alternate_path);
+            // the alternate path <s,..,v,..,t>, v is the end of the first half path
+            std::vector<NodeID> packed_alternate_path(candidate.packed_s_v_path.begin(),
+                                                      candidate.packed_s_v_path.end() - 1);
+            packed_alternate_path.insert(packed_alternate_path.end(),
+                                         candidate.packed_v_t_path.begin(),
+                                         candidate.packed_v_t_path.end());
 
+            if (GetPackedSharing(packed_alternate_path, selected_packed_edges) >
+                maximum_allowed_sharing)
+            {
+                continue;
+            }
+
+            for (const auto index : util::irange<std::size_t>(1UL, packed_alternate_path.size()))
+            {
+                selected_packed_edges.emplace_back(packed_alternate_path[index - 1],
+                                                   packed_alternate_path[index]);
+            }
+            std::sort(selected_packed_edges.begin(), selected_packed_edges.end());
+            raw_route_data.alternative_path_lengths.push_back(candidate.length);
+            packed_alternate_paths.push_back(std::move(packed_alternate_path));
+        }
+
+        // Unpack shortest path and alternatives, if they exist
+        BOOST_ASSERT(!packed_shortest_path.empty());
+        raw_route_data.unpacked_path_segments.resize(1);
+        raw_route_data.source_traversed_in_reverse.push_back(
+            (packed_shortest_path.front() !=
+             phantom_node_pair.source_phantom.forward_segment_id.id));
+        raw_route_data.target_traversed_in_reverse.push_back(
+            (packed_shortest_path.back() !=
+             phantom_node_pair.target_phantom.forward_segment_id.id));
+
+        super::UnpackPath(
+            // -- packed input
+            packed_shortest_path.begin(),
+            packed_shortest_path.end(),
+            // -- start of route
+            phantom_node_pair,
+            // -- unpacked output
+            raw_route_data.unpacked_path_segments.front());
+        raw_route_data.shortest_path_length = upper_bound_to_shortest_path_distance;
+
+        raw_route_data.unpacked_alternatives.resize(packed_alternate_paths.size());
+        for (const auto index : util::irange<std::size_t>(0UL, packed_alternate_paths.size()))
+        {
+            const auto &packed_alternate_path = packed_alternate_paths[index];
             raw_route_data.alt_source_traversed_in_reverse.push_back(
                 (packed_alternate_path.front() !=
                  phantom_node_pair.source_phantom.forward_segment_id.id));
@@ -369,58 +390,51 @@ class AlternativeRouting final
             super::UnpackPath(packed_alternate_path.begin(),
                               packed_alternate_path.end(),
                               phantom_node_pair,
-                              raw_route_data.unpacked_alternative);
-
-            raw_route_data.alternative_path_length = length_of_via_path;
-        }
-        else
-        {
-            BOOST_ASSERT(raw_route_data.alternative_path_length == INVALID_EDGE_WEIGHT);
+                              raw_route_data.unpacked_alternatives[index]);
         }
     }
 
   private:
-    // unpack alternate <s,..,v,..,t> by exploring search spaces from v
-    void RetrievePackedAlternatePath(const QueryHeap &forward_heap1,
-                                     const QueryHeap &reverse_heap1,
-                                     const QueryHeap &forward_heap2,
-                                     const QueryHeap &reverse_heap2,
-                                     const NodeID s_v_middle,
-                                     const NodeID v_t_middle,
-                                     std::vector<NodeID> &packed_path) const
+    // The weight of the packed edges of the path that are part of the sorted edges. Sharing within
+    // different shortcuts is not found, which is good enough to tell apart the alternatives.
+    int GetPackedSharing(const std::vector<NodeID> &packed_path,
+                         const std::vector<SearchSpaceEdge> &sorted_edges) const
     {
-        // fetch packed path [s,v)
-        std::vector<NodeID> packed_v_t_path;
-        super::RetrievePackedPathFromHeap(forward_heap1, reverse_heap2, s_v_middle, packed_path);
-        packed_path.pop_back(); // remove middle node. It's in both half-paths
-
-        // fetch patched path [v,t]
-        super::RetrievePackedPathFromHeap(
-            forward_heap2, reverse_heap1, v_t_middle, packed_v_t_path);
-
-        packed_path.insert(packed_path.end(), packed_v_t_path.begin(), packed_v_t_path.end());
+        int sharing = 0;
+        for (const auto index : util::irange<std::size_t>(1UL, packed_path.size()))
+        {
+            const SearchSpaceEdge edge(packed_path[index - 1], packed_path[index]);
+            if (std::binary_search(sorted_edges.begin(), sorted_edges.end(), edge))
+            {
+                const EdgeID edge_id = facade->FindEdgeInEitherDirection(edge.first, edge.second);
+                sharing += facade->GetEdgeData(edge_id).distance;
+            }
+        }
+        return sharing;
     }
 
     // TODO: reorder parameters
     // compute and unpack <s,..,v> and <v,..,t> by exploring search spaces
     // from v and intersecting against queues. only half-searches have to be
-    // done at this stage
-    void ComputeLengthAndSharingOfViaPath(const NodeID via_node,
-                                          int *real_length_of_via_path,
-                                          int *sharing_of_via_path,
+    // done at this stage, the packed paths are kept for the T-Test and the
+    // alternate path. Returns false if v doesn't connect s and t.
+    bool ComputeLengthAndSharingOfViaPath(RankedCandidateNode &candidate,
                                           const std::vector<NodeID> &packed_shortest_path,
                                           const EdgeWeight min_edge_offset)
     {
-        engine_working_data.InitializeOrClearSecondThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
+        const NodeID via_node = candidate.node;
+        candidate.sharing = 0;
+        int *sharing_of_via_path = &candidate.sharing;
 
-        QueryHeap &existing_forward_heap = *engine_working_data.forward_heap_1;
-        QueryHeap &existing_reverse_heap = *engine_working_data.reverse_heap_1;
-        QueryHeap &new_forward_heap = *engine_working_data.forward_heap_2;
-        QueryHeap &new_reverse_heap = *engine_working_data.reverse_heap_2;
+        engine_working_data.InitializeOrClearSecondHeaps(super::facade->GetNumberOfNodes());
 
-        std::vector<NodeID> packed_s_v_path;
-        std::vector<NodeID> packed_v_t_path;
+        QueryHeap &existing_forward_heap = *engine_working_data.GetHeaps().forward_heap_1;
+        QueryHeap &existing_reverse_heap = *engine_working_data.GetHeaps().reverse_heap_1;
+        QueryHeap &new_forward_heap = *engine_working_data.GetHeaps().forward_heap_2;
+        QueryHeap &new_reverse_heap = *engine_working_data.GetHeaps().reverse_heap_2;
+
+        std::vector<NodeID> &packed_s_v_path = candidate.packed_s_v_path;
+        std::vector<NodeID> &packed_v_t_path = candidate.packed_v_t_path;
 
         std::vector<NodeID> partially_unpacked_shortest_path;
         std::vector<NodeID> partially_unpacked_via_path;
@@ -459,12 +473,11 @@ class AlternativeRouting final
                                DO_NOT_FORCE_LOOPS,
                                DO_NOT_FORCE_LOOPS);
         }
-        *real_length_of_via_path = upper_bound_s_v_path_length + upper_bound_of_v_t_path_length;
-
         if (SPECIAL_NODEID == s_v_middle || SPECIAL_NODEID == v_t_middle)
         {
-            return;
+            return false;
         }
+        candidate.length = upper_bound_s_v_path_length + upper_bound_of_v_t_path_length;
 
         // retrieve packed paths
         super::RetrievePackedPathFromHeap(
@@ -566,8 +579,8 @@ class AlternativeRouting final
                 break;
             }
         }
-        // finished partial unpacking spree! Amount of sharing is stored to appropriate pointer
-        // variable
+        // finished partial unpacking spree! Amount of sharing is stored in the candidate
+        return true;
     }
 
     // int approximateAmountOfSharing(
@@ -625,11 +638,18 @@ class AlternativeRouting final
                                 std::vector<SearchSpaceEdge> &search_space,
                                 const EdgeWeight min_edge_offset) const
     {
+        const auto &graph = facade->GetSearchGraph();
         QueryHeap &forward_heap = (is_forward_directed ? heap1 : heap2);
         QueryHeap &reverse_heap = (is_forward_directed ? heap2 : heap1);
 
+        SearchEngineData::PollQueryControl();
         const NodeID node = forward_heap.DeleteMin();
         const int distance = forward_heap.GetKey(node);
+        SearchStatistics *const statistics = SearchEngineData::GetStatistics();
+        if (statistics)
+        {
+            ++statistics->settled_nodes;
+        }
         // const NodeID parentnode = forward_heap.GetData(node).parent;
         // util::SimpleLogger().Write() << (is_forward_directed ? "[fwd] " : "[rev] ") << "settled
         // edge ("
@@ -679,15 +699,17 @@ class AlternativeRouting final
             }
         }
 
-        for (auto edge : facade->GetAdjacentEdgeRange(node))
+        std::uint64_t relaxed_edges = 0;
+        for (auto edge : graph.GetAdjacentEdgeRange(node))
         {
-            const EdgeData &data = facade->GetEdgeData(edge);
+            const auto &data = graph.GetSearchData(edge);
             const bool edge_is_forward_directed =
                 (is_forward_directed ? data.forward : data.backward);
             if (edge_is_forward_directed)
             {
+                ++relaxed_edges;
 
-                const NodeID to = facade->GetTarget(edge);
+                const NodeID to = data.target;
                 const int edge_weight = data.distance;
 
                 BOOST_ASSERT(edge_weight > 0);
@@ -708,90 +730,24 @@ class AlternativeRouting final
                 }
             }
         }
+        if (statistics)
+        {
+            statistics->relaxed_edges += relaxed_edges;
+        }
     }
 
-    // conduct T-Test
-    bool ViaNodeCandidatePassesTTest(QueryHeap &existing_forward_heap,
-                                     QueryHeap &existing_reverse_heap,
-                                     QueryHeap &new_forward_heap,
-                                     QueryHeap &new_reverse_heap,
-                                     const RankedCandidateNode &candidate,
+    // conduct T-Test on the via path that was computed for the candidate
+    bool ViaNodeCandidatePassesTTest(const RankedCandidateNode &candidate,
                                      const int length_of_shortest_path,
-                                     int *length_of_via_path,
-                                     NodeID *s_v_middle,
-                                     NodeID *v_t_middle,
                                      const EdgeWeight min_edge_offset) const
     {
-        new_forward_heap.Clear();
-        new_reverse_heap.Clear();
-        std::vector<NodeID> packed_s_v_path;
-        std::vector<NodeID> packed_v_t_path;
+        const std::vector<NodeID> &packed_s_v_path = candidate.packed_s_v_path;
+        const std::vector<NodeID> &packed_v_t_path = candidate.packed_v_t_path;
+        BOOST_ASSERT(!packed_s_v_path.empty() && !packed_v_t_path.empty());
 
-        *s_v_middle = SPECIAL_NODEID;
-        int upper_bound_s_v_path_length = INVALID_EDGE_WEIGHT;
-        // compute path <s,..,v> by reusing forward search from s
-        new_reverse_heap.Insert(candidate.node, 0, candidate.node);
+        NodeID s_P = packed_s_v_path.back(), t_P = packed_v_t_path.front();
         const bool constexpr STALLING_ENABLED = true;
         const bool constexpr DO_NOT_FORCE_LOOPS = false;
-        while (new_reverse_heap.Size() > 0)
-        {
-            super::RoutingStep(new_reverse_heap,
-                               existing_forward_heap,
-                               *s_v_middle,
-                               upper_bound_s_v_path_length,
-                               min_edge_offset,
-                               false,
-                               STALLING_ENABLED,
-                               DO_NOT_FORCE_LOOPS,
-                               DO_NOT_FORCE_LOOPS);
-        }
-
-        if (INVALID_EDGE_WEIGHT == upper_bound_s_v_path_length)
-        {
-            return false;
-        }
-
-        // compute path <v,..,t> by reusing backward search from t
-        *v_t_middle = SPECIAL_NODEID;
-        int upper_bound_of_v_t_path_length = INVALID_EDGE_WEIGHT;
-        new_forward_heap.Insert(candidate.node, 0, candidate.node);
-        while (new_forward_heap.Size() > 0)
-        {
-            super::RoutingStep(new_forward_heap,
-                               existing_reverse_heap,
-                               *v_t_middle,
-                               upper_bound_of_v_t_path_length,
-                               min_edge_offset,
-                               true,
-                               STALLING_ENABLED,
-                               DO_NOT_FORCE_LOOPS,
-                               DO_NOT_FORCE_LOOPS);
-        }
-
-        if (INVALID_EDGE_WEIGHT == upper_bound_of_v_t_path_length)
-        {
-            return false;
-        }
-
-        *length_of_via_path = upper_bound_s_v_path_length + upper_bound_of_v_t_path_length;
-
-        // retrieve packed paths
-        super::RetrievePackedPathFromHeap(
-            existing_forward_heap, new_reverse_heap, *s_v_middle, packed_s_v_path);
-
-        super::RetrievePackedPathFromHeap(
-            new_forward_heap, existing_reverse_heap, *v_t_middle, packed_v_t_path);
-
-        NodeID s_P = *s_v_middle, t_P = *v_t_middle;
-        if (SPECIAL_NODEID == s_P)
-        {
-            return false;
-        }
-
-        if (SPECIAL_NODEID == t_P)
-        {
-            return false;
-        }
         const int T_threshold = static_cast<int>(VIAPATH_EPSILON * length_of_shortest_path);
         int unpacked_until_distance = 0;
 
@@ -918,11 +874,10 @@ class AlternativeRouting final
 
         t_test_path_length += unpacked_until_distance;
         // Run actual T-Test query and compare if distances equal.
-        engine_working_data.InitializeOrClearThirdThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
+        engine_working_data.InitializeOrClearThirdHeaps(super::facade->GetNumberOfNodes());
 
-        QueryHeap &forward_heap3 = *engine_working_data.forward_heap_3;
-        QueryHeap &reverse_heap3 = *engine_working_data.reverse_heap_3;
+        QueryHeap &forward_heap3 = *engine_working_data.GetHeaps().forward_heap_3;
+        QueryHeap &reverse_heap3 = *engine_working_data.GetHeaps().reverse_heap_3;
         int upper_bound = INVALID_EDGE_WEIGHT;
         NodeID middle = SPECIAL_NODEID;
 
@@ -32,15 +32,21 @@ class DirectShortestPathRouting final
     SearchEngineData &engine_working_data;
 
   public:
-    DirectShortestPathRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
-        : super(facade), engine_working_data(engine_working_data)
+    DirectShortestPathRouting(DataFacadeT *facade,
+                              SearchEngineData &engine_working_data,
+                              UnpackingCache *unpacking_cache = nullptr)
+        : super(facade, unpacking_cache), engine_working_data(engine_working_data)
     {
     }
 
     ~DirectShortestPathRouting() {}
 
+    // With summary_only set the path is not unpacked, only the duration and distance of the
+    // leg are returned. Otherwise the mode selects the fields of the path data that are unpacked.
     void operator()(const std::vector<PhantomNodes> &phantom_nodes_vector,
-                    InternalRouteResult &raw_route_data) const
+                    InternalRouteResult &raw_route_data,
+                    const bool summary_only = false,
+                    const PathUnpackMode mode = PathUnpackMode::Full) const
     {
         // Get distance to next pair of target nodes.
         BOOST_ASSERT_MSG(1 == phantom_nodes_vector.size(),
@@ -50,10 +56,9 @@ class DirectShortestPathRouting final
         const auto &source_phantom = phantom_node_pair.source_phantom;
         const auto &target_phantom = phantom_node_pair.target_phantom;
 
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-        QueryHeap &forward_heap = *(engine_working_data.forward_heap_1);
-        QueryHeap &reverse_heap = *(engine_working_data.reverse_heap_1);
+        engine_working_data.InitializeOrClearFirstHeaps(super::facade->GetNumberOfNodes());
+        QueryHeap &forward_heap = *engine_working_data.GetHeaps().forward_heap_1;
+        QueryHeap &reverse_heap = *engine_working_data.GetHeaps().reverse_heap_1;
         forward_heap.Clear();
         reverse_heap.Clear();
 
@@ -73,20 +78,31 @@ class DirectShortestPathRouting final
                                 source_phantom.reverse_segment_id.id);
         }
 
-        if (target_phantom.forward_segment_id.enabled)
+        // the route can't end on a segment that the traffic overlay closes
+        if (target_phantom.forward_segment_id.enabled &&
+            super::GetArrivalTrafficPenalty(target_phantom.forward_segment_id.id) !=
+                INVALID_EDGE_WEIGHT)
         {
             reverse_heap.Insert(target_phantom.forward_segment_id.id,
                                 target_phantom.GetForwardWeightPlusOffset(),
                                 target_phantom.forward_segment_id.id);
         }
 
-        if (target_phantom.reverse_segment_id.enabled)
+        if (target_phantom.reverse_segment_id.enabled &&
+            super::GetArrivalTrafficPenalty(target_phantom.reverse_segment_id.id) !=
+                INVALID_EDGE_WEIGHT)
         {
             reverse_heap.Insert(target_phantom.reverse_segment_id.id,
                                 target_phantom.GetReverseWeightPlusOffset(),
                                 target_phantom.reverse_segment_id.id);
         }
 
+        if (reverse_heap.Empty())
+        {
+            raw_route_data.shortest_path_length = INVALID_EDGE_WEIGHT;
+            return;
+        }
+
         int distance = INVALID_EDGE_WEIGHT;
         std::vector<NodeID> packed_leg;
 
@@ -95,10 +111,9 @@ class DirectShortestPathRouting final
 
         if (super::facade->GetCoreSize() > 0)
         {
-            engine_working_data.InitializeOrClearSecondThreadLocalStorage(
-                super::facade->GetNumberOfNodes());
-            QueryHeap &forward_core_heap = *(engine_working_data.forward_heap_2);
-            QueryHeap &reverse_core_heap = *(engine_working_data.reverse_heap_2);
+            engine_working_data.InitializeOrClearSecondHeaps(super::facade->GetNumberOfNodes());
+            QueryHeap &forward_core_heap = *engine_working_data.GetHeaps().forward_heap_2;
+            QueryHeap &reverse_core_heap = *engine_working_data.GetHeaps().reverse_heap_2;
             forward_core_heap.Clear();
             reverse_core_heap.Clear();
 
@@ -125,9 +140,9 @@ class DirectShortestPathRouting final
         if (INVALID_EDGE_WEIGHT == distance)
         {
             raw_route_data.shortest_path_length = INVALID_EDGE_WEIGHT;
-            raw_route_data.alternative_path_length = INVALID_EDGE_WEIGHT;
             return;
         }
+        super::AddArrivalTrafficPenalty(packed_leg, distance);
 
         BOOST_ASSERT_MSG(!packed_leg.empty(), "packed path empty");
 
@@ -138,10 +153,21 @@ class DirectShortestPathRouting final
         raw_route_data.target_traversed_in_reverse.push_back(
             (packed_leg.back() != phantom_node_pair.target_phantom.forward_segment_id.id));
 
+        if (summary_only)
+        {
+            raw_route_data.packed_leg_durations.push_back(distance);
+            raw_route_data.packed_leg_distances.push_back(
+                super::GetPathDistance(packed_leg, source_phantom, target_phantom));
+            return;
+        }
+
         super::UnpackPath(packed_leg.begin(),
                           packed_leg.end(),
                           phantom_node_pair,
-                          raw_route_data.unpacked_path_segments.front());
+                          raw_route_data.unpacked_path_segments.front(),
+                          mode);
+        super::AddArrivalTrafficPenalty(packed_leg.back(),
+                                        raw_route_data.unpacked_path_segments.front());
     }
 };
 }
@@ -1,15 +1,29 @@
 #ifndef MANY_TO_MANY_ROUTING_HPP
 #define MANY_TO_MANY_ROUTING_HPP
 
+#include "engine/hub_labels.hpp"
+#include "engine/phantom_node.hpp"
 #include "engine/routing_algorithms/routing_base.hpp"
 #include "engine/search_engine_data.hpp"
+#include "engine/search_space_cache.hpp"
+#include "util/integer_range.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/assert.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -19,198 +33,1908 @@ namespace engine
 namespace routing_algorithms
 {
 
+// The search spaces of a distance table with the parents of their nodes, to get the packed
+// paths of its entries after the fact instead of searching them again
+struct ManyToManySearchSpaces
+{
+    struct Entry
+    {
+        NodeID node;
+        // the row or column of the search
+        unsigned index;
+        NodeID parent;
+
+        bool operator<(const Entry &rhs) const
+        {
+            return std::tie(node, index) < std::tie(rhs.node, rhs.index);
+        }
+    };
+
+    // of the searches from the sources and to the targets, sorted
+    std::vector<Entry> forward;
+    std::vector<Entry> backward;
+    // where the searches of each table entry meet, SPECIAL_NODEID if they don't or if the path
+    // needs a loop at the meeting node
+    std::vector<NodeID> middle_nodes;
+    std::size_t number_of_targets = 0;
+
+    // Appends the packed path of the table entry to packed_path, false if there is none
+    bool GetPackedPath(const std::size_t row_idx,
+                       const std::size_t column_idx,
+                       std::vector<NodeID> &packed_path) const
+    {
+        if (middle_nodes.empty())
+        {
+            return false;
+        }
+        BOOST_ASSERT(row_idx * number_of_targets + column_idx < middle_nodes.size());
+        const auto middle_node = middle_nodes[row_idx * number_of_targets + column_idx];
+        if (middle_node == SPECIAL_NODEID)
+        {
+            return false;
+        }
+
+        const auto path_begin = packed_path.size();
+        // the phantom nodes are their own parents
+        for (auto node = middle_node;;)
+        {
+            packed_path.push_back(node);
+            const auto parent = GetParent(forward, node, row_idx);
+            if (parent == node)
+            {
+                break;
+            }
+            node = parent;
+        }
+        std::reverse(packed_path.begin() + path_begin, packed_path.end());
+
+        for (auto node = middle_node;;)
+        {
+            const auto parent = GetParent(backward, node, column_idx);
+            if (parent == node)
+            {
+                break;
+            }
+            node = parent;
+            packed_path.push_back(node);
+        }
+        return true;
+    }
+
+  private:
+    static NodeID
+    GetParent(const std::vector<Entry> &entries, const NodeID node, const unsigned index)
+    {
+        const auto entry =
+            std::lower_bound(entries.begin(), entries.end(), Entry{node, index, SPECIAL_NODEID});
+        BOOST_ASSERT(entry != entries.end() && entry->node == node && entry->index == index);
+        return entry->parent;
+    }
+};
+
+// A node settled by the search of a table column (or row), with its distance
+struct ManyToManyNodeBucket
+{
+    NodeID middle_node;
+    unsigned target_id; // essentially a row in the distance matrix
+    EdgeWeight distance;
+    ManyToManyNodeBucket(const NodeID middle_node,
+                         const unsigned target_id,
+                         const EdgeWeight distance)
+        : middle_node(middle_node), target_id(target_id), distance(distance)
+    {
+    }
+
+    // keeps the buckets of a node ordered by target for better locality in the table
+    bool operator<(const ManyToManyNodeBucket &rhs) const
+    {
+        return std::tie(middle_node, target_id) < std::tie(rhs.middle_node, rhs.target_id);
+    }
+
+    // compares by node only, used by std::equal_range to find all buckets of a node
+
+    struct Compare
+    {
+        bool operator()(const ManyToManyNodeBucket &lhs, const NodeID rhs) const
+        {
+            return lhs.middle_node < rhs;
+        }
+        bool operator()(const NodeID lhs, const ManyToManyNodeBucket &rhs) const
+        {
+            return lhs < rhs.middle_node;
+        }
+    };
+};
+
+// The sorted buckets of the backward searches of a table as separate arrays. The nodes with
+// buckets are kept once each with the offset of their first bucket, the target ids and distances
+// of the buckets next to each other without the nodes in between. A forward step searches the
+// small array of nodes and then runs over two dense arrays instead of the larger buckets.
+struct ManyToManyBucketColumns
+{
+    // ascending, offsets has an extra entry past the last bucket
+    std::vector<NodeID> nodes;
+    std::vector<std::size_t> offsets;
+    std::vector<unsigned> target_ids;
+    std::vector<EdgeWeight> distances;
+    // the targets start with non-negative keys, so only penalties could make them negative
+    bool has_negative_distances = false;
+
+    ManyToManyBucketColumns() = default;
+
+    // the buckets need to be sorted
+    explicit ManyToManyBucketColumns(const std::vector<ManyToManyNodeBucket> &buckets)
+    {
+        BOOST_ASSERT(std::is_sorted(buckets.begin(), buckets.end()));
+        target_ids.reserve(buckets.size());
+        distances.reserve(buckets.size());
+        for (const auto &bucket : buckets)
+        {
+            if (nodes.empty() || nodes.back() != bucket.middle_node)
+            {
+                nodes.push_back(bucket.middle_node);
+                offsets.push_back(target_ids.size());
+            }
+            target_ids.push_back(bucket.target_id);
+            distances.push_back(bucket.distance);
+            has_negative_distances |= bucket.distance < 0;
+        }
+        offsets.push_back(target_ids.size());
+    }
+
+    // The first and one past the last bucket of the node, equal if it has none
+    std::pair<std::size_t, std::size_t> GetRange(const NodeID node) const
+    {
+        const auto iter = std::lower_bound(nodes.begin(), nodes.end(), node);
+        if (iter == nodes.end() || *iter != node)
+        {
+            return {0, 0};
+        }
+        const auto index = iter - nodes.begin();
+        return {offsets[index], offsets[index + 1]};
+    }
+};
+
+// The state of a distance table that is updated incrementally, e.g. by a dispatcher whose
+// vehicles move a few at a time.
+//
+// The session keeps the search spaces of all rows and all columns as buckets sorted by node.
+// An update only searches from the sources and targets whose phantom nodes changed: a new column
+// meets the kept search spaces of the unchanged rows, and a new row the search spaces of all
+// columns. The other entries are kept from the last update.
+struct ManyToManyTableSession
+{
+    // locked by the query that updates the table
+    std::mutex mutex;
+
+    // the dataset the search spaces were found on
+    unsigned data_checksum = 0;
+    std::vector<PhantomNode> sources;
+    std::vector<PhantomNode> targets;
+    // the target_id of the forward buckets is the row of their source
+    std::vector<ManyToManyNodeBucket> forward_buckets;
+    std::vector<ManyToManyNodeBucket> backward_buckets;
+    // without a bound on the weights
+    std::vector<EdgeWeight> table;
+    // of the last update
+    std::size_t number_of_updated_rows = 0;
+    std::size_t number_of_updated_columns = 0;
+
+    void Clear()
+    {
+        sources.clear();
+        targets.clear();
+        forward_buckets.clear();
+        backward_buckets.clear();
+        table.clear();
+    }
+};
+
 template <class DataFacadeT>
 class ManyToManyRouting final
     : public BasicRoutingInterface<DataFacadeT, ManyToManyRouting<DataFacadeT>>
 {
     using super = BasicRoutingInterface<DataFacadeT, ManyToManyRouting<DataFacadeT>>;
-    using QueryHeap = SearchEngineData::QueryHeap;
+    using QueryHeap = SearchEngineData::ManyToManyQueryHeap;
     SearchEngineData &engine_working_data;
+    SearchSpaceCache *const search_space_cache;
+
+    using NodeBucket = ManyToManyNodeBucket;
+
+    // All buckets of all backward searches in one contiguous array. It is sorted by node once
+    // the backward searches are done, so every forward step finds its buckets with a binary
+    // search instead of a hash lookup into per-node vectors.
+    using SearchSpaceWithBuckets = std::vector<NodeBucket>;
+    using BucketColumns = ManyToManyBucketColumns;
+    // the statistics the workers of a parallel loop count into, see AddThreadStatistics
+    using ThreadStatistics = tbb::enumerable_thread_specific<SearchStatistics>;
+
+    // number of searches a worker runs in one go in parallel mode
+    static constexpr std::size_t PARALLEL_GRAINSIZE = 16;
+
+    // Tables with at least this many sources and entries are computed with RPHAST, whose memory
+    // doesn't grow with the search spaces of the targets. Below that selecting the subgraph of
+    // the targets costs more than the buckets.
+    static constexpr std::size_t RPHAST_MIN_SOURCES = 64;
+    static constexpr std::size_t RPHAST_MIN_ENTRIES = 512 * 512;
+    // sources that share one sweep over the subgraph, the distances of a node are adjacent
+    static constexpr std::size_t RPHAST_LANES = 8;
+    // above every distance in the subgraph, and still far from overflowing with an edge added
+    static constexpr EdgeWeight RPHAST_INFINITY = std::numeric_limits<EdgeWeight>::max() / 2;
+
+    // The part of the downward graph that reaches the targets, its nodes in an order in which
+    // every node comes after the nodes above it that have an edge down to it
+    struct RestrictedGraph
+    {
+        struct Arc
+        {
+            // the position of the node above
+            std::uint32_t from;
+            EdgeWeight weight;
+        };
+        // where the target search starts, with the key it starts with
+        struct Start
+        {
+            std::uint32_t position;
+            EdgeWeight key;
+        };
+
+        std::unordered_map<NodeID, std::uint32_t> positions;
+        // the arcs into the node at a position are arcs[arc_offsets[p]] to arcs[arc_offsets[p+1]]
+        std::vector<std::uint32_t> arc_offsets;
+        std::vector<Arc> arcs;
+        // the starts of the target of a column are starts[start_offsets[c]] up to the next
+        std::vector<std::uint32_t> start_offsets;
+        std::vector<Start> starts;
+
+        std::size_t GetNumberOfNodes() const { return arc_offsets.size() - 1; }
+    };
+
+  public:
+    // With a search space cache the bucket searches and the search of the single location of a
+    // one-to-many table take the upward search spaces of their phantom nodes from it
+    ManyToManyRouting(DataFacadeT *facade,
+                      SearchEngineData &engine_working_data,
+                      SearchSpaceCache *search_space_cache = nullptr)
+        : super(facade), engine_working_data(engine_working_data),
+          search_space_cache(search_space_cache)
+    {
+    }
+
+    // With parallel set the backward searches and then the forward searches are fanned out
+    // over the TBB thread pool, each task using a heap of the pool of the query. The search spaces
+    // are only kept by the serial searches, which then search with buckets even for a single
+    // source or target. Tables with a traffic overlay are always computed serially, see
+    // TrafficOverlayTable.
+    //
+    // Entries above max_weight are left out as INVALID_EDGE_WEIGHT, and the searches stop where
+    // they can only find entries above it.
+    std::vector<EdgeWeight> operator()(const std::vector<PhantomNode> &phantom_nodes,
+                                       const std::vector<std::size_t> &source_indices,
+                                       const std::vector<std::size_t> &target_indices,
+                                       const bool parallel = false,
+                                       ManyToManySearchSpaces *search_spaces = nullptr,
+                                       const EdgeWeight max_weight = INVALID_EDGE_WEIGHT) const
+    {
+        const auto number_of_sources =
+            source_indices.empty() ? phantom_nodes.size() : source_indices.size();
+        const auto number_of_targets =
+            target_indices.empty() ? phantom_nodes.size() : target_indices.size();
+
+        const auto source_phantom = [&](const std::size_t row_idx) -> const PhantomNode & {
+            return source_indices.empty() ? phantom_nodes[row_idx]
+                                          : phantom_nodes[source_indices[row_idx]];
+        };
+        const auto target_phantom = [&](const std::size_t column_idx) -> const PhantomNode & {
+            return target_indices.empty() ? phantom_nodes[column_idx]
+                                          : phantom_nodes[target_indices[column_idx]];
+        };
+
+        // Sources that reach none of the targets and targets that none of the sources reach are
+        // left out of the searches, which would exhaust their search spaces without a result.
+        // The search spaces of a session are kept by row and column, so all of them take part,
+        // as do the ones of a table with a traffic overlay.
+        const TrafficOverlay *const overlay = SearchEngineData::GetTrafficOverlay();
+        const bool has_traffic = overlay && !overlay->Empty();
+        const bool filter_unreachable =
+            !search_spaces && !has_traffic && super::facade->HasOrderedComponentIDs();
+        std::vector<std::size_t> rows;
+        std::vector<std::size_t> columns;
+        if (filter_unreachable)
+        {
+            FindReachableRowsAndColumns(number_of_sources,
+                                        number_of_targets,
+                                        source_phantom,
+                                        target_phantom,
+                                        rows,
+                                        columns);
+        }
+
+        std::vector<EdgeWeight> result_table;
+        if (has_traffic)
+        {
+            result_table = TrafficOverlayTable(*overlay,
+                                               number_of_sources,
+                                               number_of_targets,
+                                               source_phantom,
+                                               target_phantom,
+                                               search_spaces,
+                                               max_weight);
+        }
+        else if (!filter_unreachable ||
+            (rows.size() == number_of_sources && columns.size() == number_of_targets))
+        {
+            result_table = ComputeTable(number_of_sources,
+                                        number_of_targets,
+                                        source_phantom,
+                                        target_phantom,
+                                        parallel,
+                                        search_spaces,
+                                        max_weight);
+        }
+        else
+        {
+            result_table.resize(number_of_sources * number_of_targets, INVALID_EDGE_WEIGHT);
+            if (!rows.empty() && !columns.empty())
+            {
+                const auto reachable_table = ComputeTable(
+                    rows.size(),
+                    columns.size(),
+                    [&](const std::size_t row_idx) -> const PhantomNode & {
+                        return source_phantom(rows[row_idx]);
+                    },
+                    [&](const std::size_t column_idx) -> const PhantomNode & {
+                        return target_phantom(columns[column_idx]);
+                    },
+                    parallel,
+                    nullptr,
+                    max_weight);
+                for (const auto row_idx : util::irange<std::size_t>(0, rows.size()))
+                {
+                    for (const auto column_idx : util::irange<std::size_t>(0, columns.size()))
+                    {
+                        result_table[rows[row_idx] * number_of_targets + columns[column_idx]] =
+                            reachable_table[row_idx * columns.size() + column_idx];
+                    }
+                }
+            }
+        }
+
+        if (max_weight != INVALID_EDGE_WEIGHT)
+        {
+            // the searches can still meet above the bound before they stop
+            std::replace_if(result_table.begin(),
+                            result_table.end(),
+                            [max_weight](const EdgeWeight weight) { return weight > max_weight; },
+                            INVALID_EDGE_WEIGHT);
+        }
+        return result_table;
+    }
+
+    // The searches only penalize the nodes they settle, not the nodes that were contracted below
+    // a shortcut. Like SearchWithTrafficOverlay does for a route, the table is computed again as
+    // long as the paths of its entries have shortcuts with penalties inside that the previous
+    // runs didn't know yet. The paths are taken from the search spaces of serial searches. After
+    // MAX_TRAFFIC_SEARCHES runs the entries whose paths turned out to be closed are left out.
+    // Every entry adds the arrival penalty of the segment its path ends on.
+    template <typename SourceGetterT, typename TargetGetterT>
+    std::vector<EdgeWeight> TrafficOverlayTable(const TrafficOverlay &overlay,
+                                                const std::size_t number_of_sources,
+                                                const std::size_t number_of_targets,
+                                                const SourceGetterT &source_phantom,
+                                                const TargetGetterT &target_phantom,
+                                                ManyToManySearchSpaces *search_spaces,
+                                                const EdgeWeight max_weight) const
+    {
+        ManyToManySearchSpaces table_search_spaces;
+        if (!search_spaces)
+        {
+            search_spaces = &table_search_spaces;
+        }
+
+        HiddenTrafficPenalties hidden_penalties;
+        const SearchEngineData::ScopedHiddenTrafficPenalties hiding(hidden_penalties);
+        std::vector<NodeID> packed_path;
+        for (unsigned run = 1;; ++run)
+        {
+            auto result_table = ComputeTable(number_of_sources,
+                                             number_of_targets,
+                                             source_phantom,
+                                             target_phantom,
+                                             false,
+                                             search_spaces,
+                                             max_weight);
+            const bool is_last_run = run == super::MAX_TRAFFIC_SEARCHES;
+
+            bool has_new_penalties = false;
+            for (const auto row_idx : util::irange<std::size_t>(0, number_of_sources))
+            {
+                for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
+                {
+                    auto &weight = result_table[row_idx * number_of_targets + column_idx];
+                    if (weight == INVALID_EDGE_WEIGHT)
+                    {
+                        continue;
+                    }
+
+                    packed_path.clear();
+                    if (!search_spaces->GetPackedPath(row_idx, column_idx, packed_path))
+                    {
+                        // a path with a loop at its meeting node isn't kept, it ends on one of
+                        // the segments of the target
+                        weight += GetMinArrivalTrafficPenalty(target_phantom(column_idx));
+                        continue;
+                    }
+
+                    bool is_closed = false;
+                    has_new_penalties = super::AddHiddenTrafficPenalties(overlay,
+                                                                         packed_path.begin(),
+                                                                         packed_path.end(),
+                                                                         hidden_penalties,
+                                                                         is_closed) ||
+                                        has_new_penalties;
+                    if (is_last_run && is_closed)
+                    {
+                        weight = INVALID_EDGE_WEIGHT;
+                        continue;
+                    }
+                    weight += super::GetArrivalTrafficPenalty(packed_path.back());
+                }
+            }
+            if (!has_new_penalties || is_last_run)
+            {
+                return result_table;
+            }
+        }
+    }
+
+    // The lower of the arrival penalties of the segments of the phantom node that the traffic
+    // overlay doesn't close
+    EdgeWeight GetMinArrivalTrafficPenalty(const PhantomNode &phantom) const
+    {
+        EdgeWeight min_penalty = INVALID_EDGE_WEIGHT;
+        if (phantom.forward_segment_id.enabled)
+        {
+            min_penalty = std::min(
+                min_penalty, super::GetArrivalTrafficPenalty(phantom.forward_segment_id.id));
+        }
+        if (phantom.reverse_segment_id.enabled)
+        {
+            min_penalty = std::min(
+                min_penalty, super::GetArrivalTrafficPenalty(phantom.reverse_segment_id.id));
+        }
+        BOOST_ASSERT(min_penalty != INVALID_EDGE_WEIGHT);
+        return min_penalty;
+    }
+
+    // Computes the table in blocks of rows and hands every block to the callback before the next
+    // one is computed, so only a block of up to max_block_entries entries is held at a time. The
+    // callback gets the row the block starts with and its entries, and returns false to stop.
+    // Returns false if a block couldn't be computed or the callback stopped.
+    //
+    // Every block searches the targets again, a block has at least as many rows as a table
+    // that is computed with RPHAST so the searches of the targets are shared by many sources.
+    template <typename BlockCallbackT>
+    bool ComputeTableInBlocks(const std::vector<PhantomNode> &phantom_nodes,
+                              const std::vector<std::size_t> &source_indices,
+                              const std::vector<std::size_t> &target_indices,
+                              const std::size_t max_block_entries,
+                              const bool parallel,
+                              const EdgeWeight max_weight,
+                              BlockCallbackT &&callback) const
+    {
+        const auto number_of_sources =
+            source_indices.empty() ? phantom_nodes.size() : source_indices.size();
+        const auto number_of_targets =
+            target_indices.empty() ? phantom_nodes.size() : target_indices.size();
+        const std::size_t min_rows_per_block = RPHAST_MIN_SOURCES;
+        const auto rows_per_block = std::max(
+            min_rows_per_block, max_block_entries / std::max<std::size_t>(number_of_targets, 1));
+
+        std::vector<std::size_t> block_indices;
+        for (std::size_t first_row = 0; first_row < number_of_sources; first_row += rows_per_block)
+        {
+            const auto last_row = std::min(first_row + rows_per_block, number_of_sources);
+            block_indices.clear();
+            for (const auto row_idx : util::irange(first_row, last_row))
+            {
+                block_indices.push_back(source_indices.empty() ? row_idx : source_indices[row_idx]);
+            }
+            const auto block = (*this)(
+                phantom_nodes, block_indices, target_indices, parallel, nullptr, max_weight);
+            if (block.empty() || !callback(first_row, block))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Updates the table of the session to the phantom nodes and returns it, see
+    // ManyToManyTableSession. The session starts over if the number of sources or targets
+    // changes or the dataset is a different one.
+    //
+    // The kept search spaces have to serve the sources and targets of later updates, so they are
+    // not bounded by max_weight, only the entries above it are left out.
+    std::vector<EdgeWeight> operator()(ManyToManyTableSession &session,
+                                       const std::vector<PhantomNode> &phantom_nodes,
+                                       const std::vector<std::size_t> &source_indices,
+                                       const std::vector<std::size_t> &target_indices,
+                                       const EdgeWeight max_weight = INVALID_EDGE_WEIGHT) const
+    {
+        std::vector<PhantomNode> sources, targets;
+        for (const auto index : source_indices)
+        {
+            sources.push_back(phantom_nodes[index]);
+        }
+        for (const auto index : target_indices)
+        {
+            targets.push_back(phantom_nodes[index]);
+        }
+        if (source_indices.empty())
+        {
+            sources = phantom_nodes;
+        }
+        if (target_indices.empty())
+        {
+            targets = phantom_nodes;
+        }
+        const auto number_of_sources = sources.size();
+        const auto number_of_targets = targets.size();
+
+        // the buckets of the multi-level graph are not kept, and neither are the ones of a traffic
+        // overlay that can change between updates, every update computes all entries
+        const TrafficOverlay *const overlay = SearchEngineData::GetTrafficOverlay();
+        if (super::facade->HasMultiLevelData() || (overlay && !overlay->Empty()))
+        {
+            session.Clear();
+            session.number_of_updated_rows = number_of_sources;
+            session.number_of_updated_columns = number_of_targets;
+            return (*this)(
+                phantom_nodes, source_indices, target_indices, false, nullptr, max_weight);
+        }
+
+        const auto data_checksum = super::facade->GetCheckSum();
+        if (session.data_checksum != data_checksum || session.sources.size() != number_of_sources ||
+            session.targets.size() != number_of_targets)
+        {
+            session.Clear();
+            session.data_checksum = data_checksum;
+            session.table.resize(number_of_sources * number_of_targets, INVALID_EDGE_WEIGHT);
+        }
+
+        std::vector<bool> changed_rows(number_of_sources, true);
+        std::vector<bool> changed_columns(number_of_targets, true);
+        for (const auto row_idx : util::irange<std::size_t>(0, session.sources.size()))
+        {
+            changed_rows[row_idx] = !IsSamePhantom(session.sources[row_idx], sources[row_idx]);
+        }
+        for (const auto column_idx : util::irange<std::size_t>(0, session.targets.size()))
+        {
+            changed_columns[column_idx] =
+                !IsSamePhantom(session.targets[column_idx], targets[column_idx]);
+        }
+
+        // the entries of the changed rows and columns are computed again, and their buckets
+        // must not meet the new searches
+        const auto is_changed = [](const std::vector<bool> &changed) {
+            return [&changed](const NodeBucket &bucket) { return changed[bucket.target_id]; };
+        };
+        session.forward_buckets.erase(std::remove_if(session.forward_buckets.begin(),
+                                                     session.forward_buckets.end(),
+                                                     is_changed(changed_rows)),
+                                      session.forward_buckets.end());
+        session.backward_buckets.erase(std::remove_if(session.backward_buckets.begin(),
+                                                      session.backward_buckets.end(),
+                                                      is_changed(changed_columns)),
+                                       session.backward_buckets.end());
+        for (const auto row_idx : util::irange<std::size_t>(0, number_of_sources))
+        {
+            for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
+            {
+                if (changed_rows[row_idx] || changed_columns[column_idx])
+                {
+                    session.table[row_idx * number_of_targets + column_idx] = INVALID_EDGE_WEIGHT;
+                }
+            }
+        }
+        // a partly updated session would keep the entries of searches that didn't finish
+        session.sources.clear();
+        session.targets.clear();
+
+        engine_working_data.InitializeOrClearManyToManyHeap(super::facade->GetNumberOfNodes());
+        QueryHeap &query_heap = *engine_working_data.GetHeaps().many_to_many_heap;
+
+        // the new columns meet the unchanged rows
+        session.number_of_updated_columns = 0;
+        SearchSpaceWithBuckets new_buckets;
+        for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
+        {
+            if (changed_columns[column_idx])
+            {
+                ++session.number_of_updated_columns;
+                SessionSearch<false>(column_idx,
+                                     number_of_targets,
+                                     targets[column_idx],
+                                     query_heap,
+                                     session.forward_buckets,
+                                     new_buckets,
+                                     session.table);
+            }
+        }
+        MergeBuckets(session.backward_buckets, new_buckets);
+
+        // and the new rows meet all columns
+        session.number_of_updated_rows = 0;
+        new_buckets.clear();
+        for (const auto row_idx : util::irange<std::size_t>(0, number_of_sources))
+        {
+            if (changed_rows[row_idx])
+            {
+                ++session.number_of_updated_rows;
+                SessionSearch<true>(row_idx,
+                                    number_of_targets,
+                                    sources[row_idx],
+                                    query_heap,
+                                    session.backward_buckets,
+                                    new_buckets,
+                                    session.table);
+            }
+        }
+        MergeBuckets(session.forward_buckets, new_buckets);
+
+        session.sources = std::move(sources);
+        session.targets = std::move(targets);
+
+        auto result_table = session.table;
+        if (max_weight != INVALID_EDGE_WEIGHT)
+        {
+            std::replace_if(result_table.begin(),
+                            result_table.end(),
+                            [max_weight](const EdgeWeight weight) { return weight > max_weight; },
+                            INVALID_EDGE_WEIGHT);
+        }
+        return result_table;
+    }
+
+    // The searches of phantom nodes that are the same start with the same keys
+    static bool IsSamePhantom(const PhantomNode &lhs, const PhantomNode &rhs)
+    {
+        return lhs.forward_segment_id.id == rhs.forward_segment_id.id &&
+               lhs.forward_segment_id.enabled == rhs.forward_segment_id.enabled &&
+               lhs.reverse_segment_id.id == rhs.reverse_segment_id.id &&
+               lhs.reverse_segment_id.enabled == rhs.reverse_segment_id.enabled &&
+               lhs.GetForwardWeightPlusOffset() == rhs.GetForwardWeightPlusOffset() &&
+               lhs.GetReverseWeightPlusOffset() == rhs.GetReverseWeightPlusOffset();
+    }
+
+    // Adds the new buckets to the sorted buckets, they stay sorted
+    static void MergeBuckets(SearchSpaceWithBuckets &buckets, SearchSpaceWithBuckets &new_buckets)
+    {
+        std::sort(new_buckets.begin(), new_buckets.end());
+        const auto number_of_old_buckets = buckets.size();
+        buckets.insert(buckets.end(), new_buckets.begin(), new_buckets.end());
+        std::inplace_merge(
+            buckets.begin(), buckets.begin() + number_of_old_buckets, buckets.end());
+    }
+
+    // The search of a row (or column) of a session, which keeps its settled nodes as buckets
+    // and meets the buckets of the other direction at each of them
+    template <bool forward_direction>
+    void SessionSearch(const unsigned idx,
+                       const std::size_t number_of_targets,
+                       const PhantomNode &phantom,
+                       QueryHeap &query_heap,
+                       const SearchSpaceWithBuckets &other_buckets,
+                       SearchSpaceWithBuckets &buckets,
+                       std::vector<EdgeWeight> &result_table) const
+    {
+        SearchEngineData::CheckQueryControl();
+        query_heap.Clear();
+        InsertPhantom<forward_direction>(phantom, query_heap);
+
+        const auto entry_index = [&](const unsigned other_idx) {
+            return forward_direction ? idx * number_of_targets + other_idx
+                                     : other_idx * number_of_targets + idx;
+        };
+        while (!query_heap.Empty())
+        {
+            SearchEngineData::PollQueryControl();
+            const NodeID node = query_heap.DeleteMin();
+            const EdgeWeight distance = query_heap.GetKey(node);
+            buckets.emplace_back(node, idx, distance);
+            MeetBuckets(node, distance, other_buckets, entry_index, result_table, nullptr);
+            if (StallAtNode<forward_direction>(node, distance, query_heap))
+            {
+                continue;
+            }
+            RelaxOutgoingEdges<forward_direction>(node, distance, query_heap);
+        }
+    }
+
+    // The smallest key a search of the phantom starts with, its keys only grow from there
+    template <bool forward_direction>
+    static std::int64_t GetMinPhantomKey(const PhantomNode &phantom)
+    {
+        const std::int64_t sign = forward_direction ? -1 : 1;
+        std::int64_t min_key = std::numeric_limits<std::int64_t>::max();
+        if (phantom.forward_segment_id.enabled)
+        {
+            min_key = std::min(min_key, sign * phantom.GetForwardWeightPlusOffset());
+        }
+        if (phantom.reverse_segment_id.enabled)
+        {
+            min_key = std::min(min_key, sign * phantom.GetReverseWeightPlusOffset());
+        }
+        return min_key;
+    }
+
+    // Adds the statistics of the workers of a parallel loop to the ones of the query, like
+    // BasicRoutingInterface::UnpackPath does for its chunks
+    static void AddThreadStatistics(SearchStatistics *const statistics,
+                                    const ThreadStatistics &thread_statistics)
+    {
+        if (!statistics)
+        {
+            return;
+        }
+        for (const auto &local_statistics : thread_statistics)
+        {
+            statistics->Add(local_statistics);
+        }
+    }
+
+    // The rows of the sources that may reach a target and the columns of the targets that may be
+    // reached by a source, see BaseDataFacade::IsUnreachable. A source reaches a target unless
+    // both have a component and the one of the source is larger, so it is enough to compare
+    // every source to the largest target component and every target to the smallest source one.
+    template <typename SourceGetterT, typename TargetGetterT>
+    static void FindReachableRowsAndColumns(const std::size_t number_of_sources,
+                                            const std::size_t number_of_targets,
+                                            const SourceGetterT &source_phantom,
+                                            const TargetGetterT &target_phantom,
+                                            std::vector<std::size_t> &rows,
+                                            std::vector<std::size_t> &columns)
+    {
+        if (number_of_sources == 0 || number_of_targets == 0)
+        {
+            return;
+        }
+
+        // nodes without a component reach and are reached by all others
+        unsigned max_target_component = 0;
+        for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
+        {
+            const auto component = target_phantom(column_idx).component.id;
+            max_target_component = component == INVALID_COMPONENTID
+                                       ? std::numeric_limits<unsigned>::max()
+                                       : std::max(max_target_component, component);
+        }
+        unsigned min_source_component = std::numeric_limits<unsigned>::max();
+        for (const auto row_idx : util::irange<std::size_t>(0, number_of_sources))
+        {
+            min_source_component =
+                std::min(min_source_component, source_phantom(row_idx).component.id);
+        }
+        static_assert(INVALID_COMPONENTID == 0, "sources without a component are kept as rows");
+
+        for (const auto row_idx : util::irange<std::size_t>(0, number_of_sources))
+        {
+            if (source_phantom(row_idx).component.id <= max_target_component)
+            {
+                rows.push_back(row_idx);
+            }
+        }
+        for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
+        {
+            const auto component = target_phantom(column_idx).component.id;
+            if (component == INVALID_COMPONENTID || min_source_component <= component)
+            {
+                columns.push_back(column_idx);
+            }
+        }
+    }
+
+    // An entry is the key of its source plus the key of its target at a node where their searches
+    // meet. The searches of one side can stop at the key that makes an entry of max_weight with
+    // the smallest key the searches of the other side start with.
+    template <bool forward_direction, typename PhantomGetterT>
+    static std::int64_t GetMaxKey(const EdgeWeight max_weight,
+                                  const std::size_t number_of_others,
+                                  const PhantomGetterT &other_phantom)
+    {
+        if (max_weight == INVALID_EDGE_WEIGHT)
+        {
+            return std::numeric_limits<std::int64_t>::max();
+        }
+        std::int64_t min_other_key = std::numeric_limits<std::int64_t>::max();
+        for (const auto other_idx : util::irange<std::size_t>(0, number_of_others))
+        {
+            const auto other_key = GetMinPhantomKey<!forward_direction>(other_phantom(other_idx));
+            min_other_key = std::min(min_other_key, other_key);
+        }
+        // without any phantom on the other side there is nothing to find
+        if (min_other_key == std::numeric_limits<std::int64_t>::max())
+        {
+            return std::numeric_limits<std::int64_t>::min();
+        }
+        return max_weight - min_other_key;
+    }
+
+    template <typename SourceGetterT, typename TargetGetterT>
+    std::vector<EdgeWeight> ComputeTable(const std::size_t number_of_sources,
+                                         const std::size_t number_of_targets,
+                                         const SourceGetterT &source_phantom,
+                                         const TargetGetterT &target_phantom,
+                                         const bool parallel,
+                                         ManyToManySearchSpaces *search_spaces,
+                                         const EdgeWeight max_weight) const
+    {
+        const auto number_of_entries = number_of_sources * number_of_targets;
+        std::vector<EdgeWeight> result_table(number_of_entries,
+                                             std::numeric_limits<EdgeWeight>::max());
+
+        if (search_spaces)
+        {
+            search_spaces->forward.clear();
+            search_spaces->backward.clear();
+            search_spaces->middle_nodes.clear();
+            search_spaces->number_of_targets = number_of_targets;
+        }
+
+        // the searches on the multi-level graph only run with buckets and don't keep their
+        // search spaces, the hub labels, RPHAST and the one-to-many search are made of the
+        // contraction hierarchy
+        if (super::facade->HasMultiLevelData())
+        {
+            return MultiLevelTable(number_of_sources,
+                                   number_of_targets,
+                                   source_phantom,
+                                   target_phantom,
+                                   max_weight);
+        }
+
+        const TrafficOverlay *const overlay = SearchEngineData::GetTrafficOverlay();
+        if (!search_spaces && super::facade->HasHubLabels() && (!overlay || overlay->Empty()))
+        {
+            return HubLabelSearch(
+                number_of_sources, number_of_targets, source_phantom, target_phantom, parallel);
+        }
+
+        // a single source or target does not need buckets at all
+        if (number_of_sources == 1 && !parallel && !search_spaces)
+        {
+            return OneToManySearch<true>(
+                source_phantom(0), number_of_targets, target_phantom, max_weight);
+        }
+        if (number_of_targets == 1 && !parallel && !search_spaces)
+        {
+            return OneToManySearch<false>(
+                target_phantom(0), number_of_sources, source_phantom, max_weight);
+        }
+
+        const auto max_forward_key =
+            GetMaxKey<true>(max_weight, number_of_targets, target_phantom);
+        const auto max_backward_key =
+            GetMaxKey<false>(max_weight, number_of_sources, source_phantom);
+
+        if (!search_spaces && number_of_sources >= RPHAST_MIN_SOURCES &&
+            number_of_entries >= RPHAST_MIN_ENTRIES)
+        {
+            return RPHASTSearch(number_of_sources,
+                                number_of_targets,
+                                source_phantom,
+                                target_phantom,
+                                parallel,
+                                max_forward_key);
+        }
+
+        SearchSpaceWithBuckets search_space_with_buckets;
+
+        if (!parallel)
+        {
+            engine_working_data.InitializeOrClearManyToManyHeap(super::facade->GetNumberOfNodes());
+            QueryHeap &query_heap = *engine_working_data.GetHeaps().many_to_many_heap;
+
+            if (search_spaces)
+            {
+                search_spaces->middle_nodes.resize(number_of_entries, SPECIAL_NODEID);
+            }
+
+            for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
+            {
+                BackwardSearch(column_idx,
+                               target_phantom(column_idx),
+                               max_backward_key,
+                               query_heap,
+                               search_space_with_buckets,
+                               search_spaces);
+            }
+
+            std::sort(search_space_with_buckets.begin(), search_space_with_buckets.end());
+            const BucketColumns bucket_columns(search_space_with_buckets);
+            SearchSpaceWithBuckets().swap(search_space_with_buckets);
+
+            for (const auto row_idx : util::irange<std::size_t>(0, number_of_sources))
+            {
+                ForwardSearch(row_idx,
+                              number_of_targets,
+                              source_phantom(row_idx),
+                              max_forward_key,
+                              query_heap,
+                              bucket_columns,
+                              result_table,
+                              search_spaces);
+            }
+
+            if (search_spaces)
+            {
+                std::sort(search_spaces->forward.begin(), search_spaces->forward.end());
+                std::sort(search_spaces->backward.begin(), search_spaces->backward.end());
+            }
+
+            return result_table;
+        }
+
+        // every worker collects the buckets of its backward searches in its own array
+        tbb::enumerable_thread_specific<SearchSpaceWithBuckets> thread_buckets;
+        // the workers abort the query for its deadline and cancellation as well, apply its
+        // traffic overlay, search on heaps of its pool and count into statistics of their own
+        const auto options = SearchEngineData::GetQueryControl();
+        auto &heap_pool = SearchEngineData::GetHeapPool();
+        SearchStatistics *const statistics = SearchEngineData::GetStatistics();
+        ThreadStatistics thread_statistics;
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_targets, PARALLEL_GRAINSIZE),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                const SearchEngineData::ScopedQueryControl control(options);
+                const SearchEngineData::ScopedTrafficOverlay traffic(overlay);
+                const SearchEngineData::ScopedHeaps heaps(heap_pool);
+                const SearchEngineData::ScopedStatistics scoped_statistics(
+                    statistics ? &thread_statistics.local() : nullptr);
+                engine_working_data.InitializeOrClearManyToManyHeap(
+                    super::facade->GetNumberOfNodes());
+                QueryHeap &query_heap = *engine_working_data.GetHeaps().many_to_many_heap;
+                auto &local_buckets = thread_buckets.local();
+
+                for (auto column_idx = range.begin(); column_idx != range.end(); ++column_idx)
+                {
+                    BackwardSearch(column_idx,
+                                   target_phantom(column_idx),
+                                   max_backward_key,
+                                   query_heap,
+                                   local_buckets);
+                }
+            });
+
+        std::size_t number_of_buckets = 0;
+        for (const auto &local_buckets : thread_buckets)
+        {
+            number_of_buckets += local_buckets.size();
+        }
+        search_space_with_buckets.reserve(number_of_buckets);
+        for (const auto &local_buckets : thread_buckets)
+        {
+            search_space_with_buckets.insert(
+                search_space_with_buckets.end(), local_buckets.begin(), local_buckets.end());
+        }
+
+        // buckets are ordered by (node, target) so the result does not depend on scheduling
+        tbb::parallel_sort(search_space_with_buckets.begin(), search_space_with_buckets.end());
+        const BucketColumns bucket_columns(search_space_with_buckets);
+        SearchSpaceWithBuckets().swap(search_space_with_buckets);
+
+        // every row of the result table is written by exactly one forward search
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_sources, PARALLEL_GRAINSIZE),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                const SearchEngineData::ScopedQueryControl control(options);
+                const SearchEngineData::ScopedTrafficOverlay traffic(overlay);
+                const SearchEngineData::ScopedHeaps heaps(heap_pool);
+                const SearchEngineData::ScopedStatistics scoped_statistics(
+                    statistics ? &thread_statistics.local() : nullptr);
+                engine_working_data.InitializeOrClearManyToManyHeap(
+                    super::facade->GetNumberOfNodes());
+                QueryHeap &query_heap = *engine_working_data.GetHeaps().many_to_many_heap;
+
+                for (auto row_idx = range.begin(); row_idx != range.end(); ++row_idx)
+                {
+                    ForwardSearch(row_idx,
+                                  number_of_targets,
+                                  source_phantom(row_idx),
+                                  max_forward_key,
+                                  query_heap,
+                                  bucket_columns,
+                                  result_table);
+                }
+            });
+        AddThreadStatistics(statistics, thread_statistics);
+
+        return result_table;
+    }
+
+    // The bucket searches on the multi-level graph. Each search runs on the query levels of its
+    // own phantom node only, see BasicRoutingInterface::MultiLevelSearch. The searches of a
+    // source and a target still meet on their shortest path: at the node where it enters the
+    // first cell that holds neither of them, which both searches settle as a boundary node.
+    template <typename SourceGetterT, typename TargetGetterT>
+    std::vector<EdgeWeight> MultiLevelTable(const std::size_t number_of_sources,
+                                            const std::size_t number_of_targets,
+                                            const SourceGetterT &source_phantom,
+                                            const TargetGetterT &target_phantom,
+                                            const EdgeWeight max_weight) const
+    {
+        std::vector<EdgeWeight> result_table(number_of_sources * number_of_targets,
+                                             std::numeric_limits<EdgeWeight>::max());
+        const auto max_forward_key =
+            GetMaxKey<true>(max_weight, number_of_targets, target_phantom);
+        const auto max_backward_key =
+            GetMaxKey<false>(max_weight, number_of_sources, source_phantom);
+
+        engine_working_data.InitializeOrClearManyToManyHeap(super::facade->GetNumberOfNodes());
+        QueryHeap &query_heap = *engine_working_data.GetHeaps().many_to_many_heap;
+
+        SearchSpaceWithBuckets search_space_with_buckets;
+        for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
+        {
+            MultiLevelSearch<false>(
+                target_phantom(column_idx),
+                max_backward_key,
+                query_heap,
+                [&](const NodeID node, const EdgeWeight distance) {
+                    search_space_with_buckets.emplace_back(node, column_idx, distance);
+                });
+        }
+        std::sort(search_space_with_buckets.begin(), search_space_with_buckets.end());
+
+        for (const auto row_idx : util::irange<std::size_t>(0, number_of_sources))
+        {
+            MultiLevelSearch<true>(source_phantom(row_idx),
+                                   max_forward_key,
+                                   query_heap,
+                                   [&](const NodeID node, const EdgeWeight distance) {
+                                       MeetBuckets(node,
+                                                   distance,
+                                                   search_space_with_buckets,
+                                                   [&](const unsigned column_idx) {
+                                                       return row_idx * number_of_targets +
+                                                              column_idx;
+                                                   },
+                                                   result_table,
+                                                   nullptr);
+                                   });
+        }
+        return result_table;
+    }
 
-    struct NodeBucket
+    // Dijkstra on the multi-level graph from the phantom node, settle is called with every node
+    // it settles
+    template <bool forward_direction, typename SettleT>
+    void MultiLevelSearch(const PhantomNode &phantom,
+                          const std::int64_t max_key,
+                          QueryHeap &query_heap,
+                          const SettleT &settle) const
     {
-        unsigned target_id; // essentially a row in the distance matrix
-        EdgeWeight distance;
-        NodeBucket(const unsigned target_id, const EdgeWeight distance)
-            : target_id(target_id), distance(distance)
+        const auto graph = super::facade->GetMultiLevelGraph();
+        const auto cells =
+            super::facade->GetCellStorage().GetMetric(SearchEngineData::GetCellMetric());
+        const auto get_query_level = [&](const NodeID node) {
+            partition::LevelID level = cells.GetNumberOfLevels();
+            if (phantom.forward_segment_id.enabled)
+            {
+                level = std::min(level, cells.GetCommonLevel(node, phantom.forward_segment_id.id));
+            }
+            if (phantom.reverse_segment_id.enabled)
+            {
+                level = std::min(level, cells.GetCommonLevel(node, phantom.reverse_segment_id.id));
+            }
+            return level;
+        };
+
+        SearchEngineData::CheckQueryControl();
+        query_heap.Clear();
+        InsertPhantom<forward_direction>(phantom, query_heap);
+        SearchStatistics *const statistics = SearchEngineData::GetStatistics();
+        while (!query_heap.Empty() && query_heap.MinKey() <= max_key)
         {
+            SearchEngineData::PollQueryControl();
+            const NodeID node = query_heap.DeleteMin();
+            const EdgeWeight distance = query_heap.GetKey(node);
+            if (statistics)
+            {
+                ++statistics->settled_nodes;
+            }
+            settle(node, distance);
+            super::RelaxMultiLevelEdges(graph,
+                                        cells,
+                                        get_query_level(node),
+                                        node,
+                                        distance,
+                                        forward_direction,
+                                        query_heap);
         }
-    };
-
-    // FIXME This should be replaced by an std::unordered_multimap, though this needs benchmarking
-    using SearchSpaceWithBuckets = std::unordered_map<NodeID, std::vector<NodeBucket>>;
-
-  public:
-    ManyToManyRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
-        : super(facade), engine_working_data(engine_working_data)
-    {
     }
 
-    std::vector<EdgeWeight> operator()(const std::vector<PhantomNode> &phantom_nodes,
-                                       const std::vector<std::size_t> &source_indices,
-                                       const std::vector<std::size_t> &target_indices) const
+    // RPHAST: the subgraph of the targets is selected once, then every source runs its upward
+    // search and a linear sweep down the subgraph, which yields its distances to all targets.
+    // The sweep runs RPHAST_LANES sources at once, so its inner loop vectorizes.
+    //
+    // A source and a target on the same node can meet at it with a negative distance, which the
+    // sweep can not tell apart from the paths through the node. These entries are searched for
+    // on their own, as the other algorithms do with a loop at the meeting node.
+    template <typename SourceGetterT, typename TargetGetterT>
+    std::vector<EdgeWeight> RPHASTSearch(const std::size_t number_of_sources,
+                                         const std::size_t number_of_targets,
+                                         const SourceGetterT &source_phantom,
+                                         const TargetGetterT &target_phantom,
+                                         const bool parallel,
+                                         const std::int64_t max_forward_key) const
     {
-        const auto number_of_sources =
-            source_indices.empty() ? phantom_nodes.size() : source_indices.size();
-        const auto number_of_targets =
-            target_indices.empty() ? phantom_nodes.size() : target_indices.size();
-        const auto number_of_entries = number_of_sources * number_of_targets;
-        std::vector<EdgeWeight> result_table(number_of_entries,
+        std::vector<EdgeWeight> result_table(number_of_sources * number_of_targets,
                                              std::numeric_limits<EdgeWeight>::max());
+        const auto restricted_graph = SelectRestrictedGraph(number_of_targets, target_phantom);
 
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
+        const auto number_of_blocks = (number_of_sources + RPHAST_LANES - 1) / RPHAST_LANES;
+        if (!parallel)
+        {
+            std::vector<EdgeWeight> distances;
+            for (const auto block : util::irange<std::size_t>(0, number_of_blocks))
+            {
+                SweepSources(block * RPHAST_LANES,
+                             std::min(number_of_sources, (block + 1) * RPHAST_LANES),
+                             number_of_targets,
+                             source_phantom,
+                             target_phantom,
+                             max_forward_key,
+                             restricted_graph,
+                             distances,
+                             result_table);
+            }
+            return result_table;
+        }
 
-        QueryHeap &query_heap = *(engine_working_data.forward_heap_1);
+        tbb::enumerable_thread_specific<std::vector<EdgeWeight>> thread_distances;
+        const auto options = SearchEngineData::GetQueryControl();
+        const auto overlay = SearchEngineData::GetTrafficOverlay();
+        SearchStatistics *const statistics = SearchEngineData::GetStatistics();
+        ThreadStatistics thread_statistics;
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_blocks),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                const SearchEngineData::ScopedQueryControl control(options);
+                const SearchEngineData::ScopedTrafficOverlay traffic(overlay);
+                const SearchEngineData::ScopedStatistics scoped_statistics(
+                    statistics ? &thread_statistics.local() : nullptr);
+                auto &distances = thread_distances.local();
+                for (auto block = range.begin(); block != range.end(); ++block)
+                {
+                    SweepSources(block * RPHAST_LANES,
+                                 std::min(number_of_sources, (block + 1) * RPHAST_LANES),
+                                 number_of_targets,
+                                 source_phantom,
+                                 target_phantom,
+                                 max_forward_key,
+                                 restricted_graph,
+                                 distances,
+                                 result_table);
+                }
+            });
+        AddThreadStatistics(statistics, thread_statistics);
+        return result_table;
+    }
 
-        SearchSpaceWithBuckets search_space_with_buckets;
+    // Everything the target searches would settle without stalling, found by a depth-first
+    // search up the backward edges. A node is done after all nodes above it, so its position in
+    // the post order puts it after them.
+    template <typename TargetGetterT>
+    RestrictedGraph SelectRestrictedGraph(const std::size_t number_of_targets,
+                                          const TargetGetterT &target_phantom) const
+    {
+        const auto &graph = super::facade->GetSearchGraph();
+        const TrafficOverlay *const overlay = SearchEngineData::GetTrafficOverlay();
+        const auto unfinished = std::numeric_limits<std::uint32_t>::max();
 
-        unsigned column_idx = 0;
-        const auto search_target_phantom = [&](const PhantomNode &phantom) {
-            query_heap.Clear();
-            // insert target(s) at distance 0
+        RestrictedGraph restricted_graph;
+        std::vector<NodeID> order;
+        std::vector<std::pair<NodeID, EdgeID>> stack;
+        const auto select = [&](const NodeID start) {
+            if (!restricted_graph.positions.emplace(start, unfinished).second)
+            {
+                return;
+            }
+            stack.emplace_back(start, graph.BeginEdges(start));
+            while (!stack.empty())
+            {
+                SearchEngineData::PollQueryControl();
+                auto &top = stack.back();
+                const NodeID node = top.first;
+                if (top.second == graph.EndEdges(node))
+                {
+                    restricted_graph.positions[node] = static_cast<std::uint32_t>(order.size());
+                    order.push_back(node);
+                    stack.pop_back();
+                    continue;
+                }
+                const auto &data = graph.GetSearchData(top.second++);
+                if (data.backward &&
+                    restricted_graph.positions.emplace(data.target, unfinished).second)
+                {
+                    stack.emplace_back(data.target, graph.BeginEdges(data.target));
+                }
+            }
+        };
 
+        SearchEngineData::CheckQueryControl();
+        restricted_graph.start_offsets.reserve(number_of_targets + 1);
+        for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
+        {
+            restricted_graph.start_offsets.push_back(
+                static_cast<std::uint32_t>(restricted_graph.starts.size()));
+            const auto &phantom = target_phantom(column_idx);
+            if (phantom.forward_segment_id.enabled)
+            {
+                select(phantom.forward_segment_id.id);
+                restricted_graph.starts.push_back({0, phantom.GetForwardWeightPlusOffset()});
+            }
+            if (phantom.reverse_segment_id.enabled)
+            {
+                select(phantom.reverse_segment_id.id);
+                restricted_graph.starts.push_back({0, phantom.GetReverseWeightPlusOffset()});
+            }
+        }
+        restricted_graph.start_offsets.push_back(
+            static_cast<std::uint32_t>(restricted_graph.starts.size()));
+        // the positions are only known once their nodes are done
+        for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
+        {
+            const auto &phantom = target_phantom(column_idx);
+            auto start = restricted_graph.starts.begin() +
+                         restricted_graph.start_offsets[column_idx];
             if (phantom.forward_segment_id.enabled)
             {
-                query_heap.Insert(phantom.forward_segment_id.id,
-                                  phantom.GetForwardWeightPlusOffset(),
-                                  phantom.forward_segment_id.id);
+                (start++)->position = restricted_graph.positions[phantom.forward_segment_id.id];
             }
             if (phantom.reverse_segment_id.enabled)
             {
-                query_heap.Insert(phantom.reverse_segment_id.id,
-                                  phantom.GetReverseWeightPlusOffset(),
-                                  phantom.reverse_segment_id.id);
+                start->position = restricted_graph.positions[phantom.reverse_segment_id.id];
             }
+        }
 
-            // explore search space
-            while (!query_heap.Empty())
+        restricted_graph.arc_offsets.reserve(order.size() + 1);
+        for (const auto node : order)
+        {
+            restricted_graph.arc_offsets.push_back(
+                static_cast<std::uint32_t>(restricted_graph.arcs.size()));
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
             {
-                BackwardRoutingStep(column_idx, query_heap, search_space_with_buckets);
+                const auto &data = graph.GetSearchData(edge);
+                if (!data.backward)
+                {
+                    continue;
+                }
+                EdgeWeight weight = data.distance;
+                if (overlay)
+                {
+                    weight = super::GetTrafficWeight(*overlay, node, data.target, false, weight);
+                    if (weight == INVALID_EDGE_WEIGHT)
+                    {
+                        continue;
+                    }
+                }
+                restricted_graph.arcs.push_back(
+                    {restricted_graph.positions.at(data.target), weight});
             }
-            ++column_idx;
-        };
+        }
+        restricted_graph.arc_offsets.push_back(
+            static_cast<std::uint32_t>(restricted_graph.arcs.size()));
+        return restricted_graph;
+    }
+
+    // The rows of the sources from first_row to end_row, at most RPHAST_LANES of them
+    template <typename SourceGetterT, typename TargetGetterT>
+    void SweepSources(const std::size_t first_row,
+                      const std::size_t end_row,
+                      const std::size_t number_of_targets,
+                      const SourceGetterT &source_phantom,
+                      const TargetGetterT &target_phantom,
+                      const std::int64_t max_forward_key,
+                      const RestrictedGraph &restricted_graph,
+                      std::vector<EdgeWeight> &distances,
+                      std::vector<EdgeWeight> &result_table) const
+    {
+        BOOST_ASSERT(end_row - first_row <= RPHAST_LANES);
+        const auto number_of_nodes = restricted_graph.GetNumberOfNodes();
+        distances.assign(number_of_nodes * RPHAST_LANES, RPHAST_INFINITY);
 
-        // for each source do forward search
-        unsigned row_idx = 0;
-        const auto search_source_phantom = [&](const PhantomNode &phantom) {
+        engine_working_data.InitializeOrClearManyToManyHeap(super::facade->GetNumberOfNodes());
+        QueryHeap &query_heap = *engine_working_data.GetHeaps().many_to_many_heap;
+        for (const auto row_idx : util::irange<std::size_t>(first_row, end_row))
+        {
+            const auto lane = row_idx - first_row;
+            SearchEngineData::CheckQueryControl();
             query_heap.Clear();
-            // insert target(s) at distance 0
+            InsertPhantom<true>(source_phantom(row_idx), query_heap);
+            while (!query_heap.Empty() && query_heap.MinKey() <= max_forward_key)
+            {
+                SearchEngineData::PollQueryControl();
+                const NodeID node = query_heap.DeleteMin();
+                const EdgeWeight distance = query_heap.GetKey(node);
+                const auto position = restricted_graph.positions.find(node);
+                if (position != restricted_graph.positions.end())
+                {
+                    auto &node_distance = distances[position->second * RPHAST_LANES + lane];
+                    node_distance = std::min(node_distance, distance);
+                }
+                if (StallAtNode<true>(node, distance, query_heap))
+                {
+                    continue;
+                }
+                RelaxOutgoingEdges<true>(node, distance, query_heap);
+            }
+        }
+
+        SearchEngineData::CheckQueryControl();
+        EdgeWeight *const lanes = distances.data();
+        for (const auto position : util::irange<std::size_t>(0, number_of_nodes))
+        {
+            EdgeWeight *const to = lanes + position * RPHAST_LANES;
+            for (auto arc = restricted_graph.arc_offsets[position];
+                 arc != restricted_graph.arc_offsets[position + 1];
+                 ++arc)
+            {
+                const auto &current_arc = restricted_graph.arcs[arc];
+                const EdgeWeight *const from = lanes + current_arc.from * RPHAST_LANES;
+                for (std::size_t lane = 0; lane < RPHAST_LANES; ++lane)
+                {
+                    to[lane] = std::min(to[lane], from[lane] + current_arc.weight);
+                }
+            }
+        }
+
+        for (const auto row_idx : util::irange<std::size_t>(first_row, end_row))
+        {
+            const auto lane = row_idx - first_row;
+            for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
+            {
+                auto &current_distance = result_table[row_idx * number_of_targets + column_idx];
+                bool meets_at_start = false;
+                for (auto start = restricted_graph.start_offsets[column_idx];
+                     start != restricted_graph.start_offsets[column_idx + 1];
+                     ++start)
+                {
+                    const auto &current_start = restricted_graph.starts[start];
+                    const auto distance =
+                        distances[current_start.position * RPHAST_LANES + lane];
+                    if (distance >= RPHAST_INFINITY)
+                    {
+                        continue;
+                    }
+                    const auto new_distance = distance + current_start.key;
+                    meets_at_start = meets_at_start || new_distance < 0;
+                    current_distance = std::min(current_distance, new_distance);
+                }
+                if (meets_at_start)
+                {
+                    current_distance =
+                        SearchEntry(source_phantom(row_idx), target_phantom(column_idx));
+                }
+            }
+        }
+    }
+
+    // A single entry, for the ones where source and target meet on the same node with a negative
+    // distance and need a loop at the node that the searches find
+    EdgeWeight SearchEntry(const PhantomNode &source, const PhantomNode &target) const
+    {
+        const auto target_getter = [&](const std::size_t) -> const PhantomNode & {
+            return target;
+        };
+        return OneToManySearch<true>(source, 1, target_getter, INVALID_EDGE_WEIGHT)[0];
+    }
 
+    // Every entry from the hub labels of the nodes of the source and the target, no search
+    // needed. Labels don't know the traffic penalties, so tables with an overlay search instead.
+    template <typename SourceGetterT, typename TargetGetterT>
+    std::vector<EdgeWeight> HubLabelSearch(const std::size_t number_of_sources,
+                                           const std::size_t number_of_targets,
+                                           const SourceGetterT &source_phantom,
+                                           const TargetGetterT &target_phantom,
+                                           const bool parallel) const
+    {
+        // the nodes of a phantom with the key its search starts them with
+        struct LabelStart
+        {
+            HubLabel label;
+            EdgeWeight key;
+        };
+        const auto getStarts = [&](const PhantomNode &phantom, const bool forward) {
+            const int sign = forward ? -1 : 1;
+            std::vector<LabelStart> starts;
             if (phantom.forward_segment_id.enabled)
             {
-                query_heap.Insert(phantom.forward_segment_id.id,
-                                  -phantom.GetForwardWeightPlusOffset(),
-                                  phantom.forward_segment_id.id);
+                starts.push_back(
+                    {super::facade->GetHubLabel(phantom.forward_segment_id.id, forward),
+                     sign * phantom.GetForwardWeightPlusOffset()});
             }
             if (phantom.reverse_segment_id.enabled)
             {
-                query_heap.Insert(phantom.reverse_segment_id.id,
-                                  -phantom.GetReverseWeightPlusOffset(),
-                                  phantom.reverse_segment_id.id);
+                starts.push_back(
+                    {super::facade->GetHubLabel(phantom.reverse_segment_id.id, forward),
+                     sign * phantom.GetReverseWeightPlusOffset()});
             }
+            return starts;
+        };
+        std::vector<std::vector<LabelStart>> target_starts;
+        target_starts.reserve(number_of_targets);
+        for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
+        {
+            target_starts.push_back(getStarts(target_phantom(column_idx), false));
+        }
 
-            // explore search space
-            while (!query_heap.Empty())
+        std::vector<EdgeWeight> result_table(number_of_sources * number_of_targets,
+                                             std::numeric_limits<EdgeWeight>::max());
+        const auto computeRow = [&](const std::size_t row_idx) {
+            SearchEngineData::PollQueryControl();
+            const auto source_starts = getStarts(source_phantom(row_idx), true);
+            for (const auto column_idx : util::irange<std::size_t>(0, number_of_targets))
             {
-                ForwardRoutingStep(row_idx,
-                                   number_of_targets,
-                                   query_heap,
-                                   search_space_with_buckets,
-                                   result_table);
+                auto &current_distance = result_table[row_idx * number_of_targets + column_idx];
+                bool meets_at_start = false;
+                for (const auto &source_start : source_starts)
+                {
+                    for (const auto &target_start : target_starts[column_idx])
+                    {
+                        const auto distance =
+                            queryHubLabels(source_start.label, target_start.label);
+                        if (distance == INVALID_EDGE_WEIGHT)
+                        {
+                            continue;
+                        }
+                        const auto new_distance = distance + source_start.key + target_start.key;
+                        meets_at_start = meets_at_start || new_distance < 0;
+                        current_distance = std::min(current_distance, new_distance);
+                    }
+                }
+                if (meets_at_start)
+                {
+                    current_distance =
+                        SearchEntry(source_phantom(row_idx), target_phantom(column_idx));
+                }
             }
-            ++row_idx;
         };
 
-        if (target_indices.empty())
+        if (!parallel)
         {
-            for (const auto &phantom : phantom_nodes)
+            SearchEngineData::CheckQueryControl();
+            for (const auto row_idx : util::irange<std::size_t>(0, number_of_sources))
             {
-                search_target_phantom(phantom);
+                computeRow(row_idx);
             }
+            return result_table;
         }
-        else
+
+        const auto options = SearchEngineData::GetQueryControl();
+        SearchStatistics *const statistics = SearchEngineData::GetStatistics();
+        ThreadStatistics thread_statistics;
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_sources, PARALLEL_GRAINSIZE),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                const SearchEngineData::ScopedQueryControl control(options);
+                const SearchEngineData::ScopedStatistics scoped_statistics(
+                    statistics ? &thread_statistics.local() : nullptr);
+                for (auto row_idx = range.begin(); row_idx != range.end(); ++row_idx)
+                {
+                    computeRow(row_idx);
+                }
+            });
+        AddThreadStatistics(statistics, thread_statistics);
+        return result_table;
+    }
+
+    // The search spaces depend on the penalties of a traffic overlay, the cache holds the ones
+    // without it. Only the contraction hierarchy gets here, the multi-level graph has its own
+    // searches.
+    bool UseSearchSpaceCache() const
+    {
+        const TrafficOverlay *const overlay = SearchEngineData::GetTrafficOverlay();
+        return search_space_cache && (!overlay || overlay->Empty());
+    }
+
+    // The complete upward search space of the phantom node from the cache, or searched and
+    // added to it. The searches that use it stop at their bounds by the distances of its nodes.
+    template <bool forward_direction>
+    SearchSpaceCache::SearchSpacePtr GetSearchSpace(const PhantomNode &phantom,
+                                                    QueryHeap &query_heap) const
+    {
+        const auto data_version = super::facade->GetDataVersion();
+        const SearchSpaceCache::Key key(phantom, forward_direction);
+        if (auto cached = search_space_cache->Get(data_version, key))
         {
-            for (const auto index : target_indices)
+            return cached;
+        }
+
+        SearchEngineData::CheckQueryControl();
+        auto search_space = std::make_shared<SearchSpaceCache::SearchSpace>();
+        query_heap.Clear();
+        InsertPhantom<forward_direction>(phantom, query_heap);
+        while (!query_heap.Empty())
+        {
+            SearchEngineData::PollQueryControl();
+            const NodeID node = query_heap.DeleteMin();
+            const EdgeWeight distance = query_heap.GetKey(node);
+            search_space->push_back({node, distance, query_heap.GetData(node).parent});
+            if (StallAtNode<forward_direction>(node, distance, query_heap))
             {
-                const auto &phantom = phantom_nodes[index];
-                search_target_phantom(phantom);
+                continue;
             }
+            RelaxOutgoingEdges<forward_direction>(node, distance, query_heap);
         }
+        search_space_cache->Add(data_version, key, search_space);
+        return search_space;
+    }
 
-        if (source_indices.empty())
+    // Sources are inserted with negative, targets with positive offsets. The segments of targets
+    // that the traffic overlay closes are left out, see TrafficOverlayTable.
+    template <bool forward_direction, typename HeapT>
+    void InsertPhantom(const PhantomNode &phantom, HeapT &query_heap) const
+    {
+        const int sign = forward_direction ? -1 : 1;
+        const auto can_arrive = [this](const SegmentID segment_id) {
+            return forward_direction ||
+                   super::GetArrivalTrafficPenalty(segment_id.id) != INVALID_EDGE_WEIGHT;
+        };
+        if (phantom.forward_segment_id.enabled && can_arrive(phantom.forward_segment_id))
+        {
+            query_heap.Insert(phantom.forward_segment_id.id,
+                              sign * phantom.GetForwardWeightPlusOffset(),
+                              phantom.forward_segment_id.id);
+        }
+        if (phantom.reverse_segment_id.enabled && can_arrive(phantom.reverse_segment_id))
+        {
+            query_heap.Insert(phantom.reverse_segment_id.id,
+                              sign * phantom.GetReverseWeightPlusOffset(),
+                              phantom.reverse_segment_id.id);
+        }
+    }
+
+    // Computes a table with a single source (or a single target) without buckets: the search
+    // space of the single location stays in one heap, and the search of every other location
+    // meets it directly and stops once it can not improve on the best distance found.
+    template <bool single_is_source, typename PhantomGetterT>
+    std::vector<EdgeWeight> OneToManySearch(const PhantomNode &single_phantom,
+                                            const std::size_t number_of_others,
+                                            const PhantomGetterT &other_phantom,
+                                            const EdgeWeight max_weight) const
+    {
+        std::vector<EdgeWeight> result_table(number_of_others,
+                                             std::numeric_limits<EdgeWeight>::max());
+
+        engine_working_data.InitializeOrClearManyToManyHeap(super::facade->GetNumberOfNodes());
+        engine_working_data.InitializeOrClearFirstHeaps(super::facade->GetNumberOfNodes());
+        QueryHeap &single_heap = *engine_working_data.GetHeaps().many_to_many_heap;
+        SearchEngineData::QueryHeap &other_heap = *engine_working_data.GetHeaps().forward_heap_1;
+
+        const auto max_single_key =
+            GetMaxKey<single_is_source>(max_weight, number_of_others, other_phantom);
+        const std::int64_t max_distance = max_weight;
+        std::int64_t min_single_distance = 0;
+        if (UseSearchSpaceCache())
         {
-            for (const auto &phantom : phantom_nodes)
+            // the settled nodes are all the other searches meet in the heap
+            const auto search_space = GetSearchSpace<single_is_source>(single_phantom, single_heap);
+            if (search_space->empty())
+            {
+                return result_table;
+            }
+            min_single_distance = search_space->front().distance;
+            single_heap.Clear();
+            for (const auto &entry : *search_space)
             {
-                search_source_phantom(phantom);
+                if (entry.distance > max_single_key)
+                {
+                    break;
+                }
+                single_heap.Insert(entry.node, entry.distance, entry.parent);
             }
         }
         else
         {
-            for (const auto index : source_indices)
+            InsertPhantom<single_is_source>(single_phantom, single_heap);
+            if (single_heap.Empty())
+            {
+                return result_table;
+            }
+
+            // keys only grow during the search, so no meeting node is closer to the single
+            // location
+            min_single_distance = single_heap.MinKey();
+            while (!single_heap.Empty() && single_heap.MinKey() <= max_single_key)
+            {
+                SearchEngineData::PollQueryControl();
+                const NodeID node = single_heap.DeleteMin();
+                const EdgeWeight distance = single_heap.GetKey(node);
+                if (StallAtNode<single_is_source>(node, distance, single_heap))
+                {
+                    continue;
+                }
+                RelaxOutgoingEdges<single_is_source>(node, distance, single_heap);
+            }
+        }
+
+        for (const auto other_idx : util::irange<std::size_t>(0, number_of_others))
+        {
+            auto &current_distance = result_table[other_idx];
+
+            other_heap.Clear();
+            InsertPhantom<!single_is_source>(other_phantom(other_idx), other_heap);
+
+            while (!other_heap.Empty() &&
+                   min_single_distance + other_heap.MinKey() < current_distance &&
+                   min_single_distance + other_heap.MinKey() <= max_distance)
             {
-                const auto &phantom = phantom_nodes[index];
-                search_source_phantom(phantom);
+                SearchEngineData::PollQueryControl();
+                const NodeID node = other_heap.DeleteMin();
+                const EdgeWeight other_distance = other_heap.GetKey(node);
+
+                if (single_heap.WasInserted(node))
+                {
+                    const EdgeWeight new_distance = single_heap.GetKey(node) + other_distance;
+                    if (new_distance < 0)
+                    {
+                        const EdgeWeight loop_weight = super::GetLoopWeight(node);
+                        const int new_distance_with_loop = new_distance + loop_weight;
+                        if (loop_weight != INVALID_EDGE_WEIGHT && new_distance_with_loop >= 0)
+                        {
+                            current_distance = std::min(current_distance, new_distance_with_loop);
+                        }
+                    }
+                    else if (new_distance < current_distance)
+                    {
+                        current_distance = new_distance;
+                    }
+                }
+
+                if (StallAtNode<!single_is_source>(node, other_distance, other_heap))
+                {
+                    continue;
+                }
+                RelaxOutgoingEdges<!single_is_source>(node, other_distance, other_heap);
             }
         }
 
         return result_table;
     }
 
+    void BackwardSearch(const unsigned column_idx,
+                        const PhantomNode &phantom,
+                        const std::int64_t max_key,
+                        QueryHeap &query_heap,
+                        SearchSpaceWithBuckets &search_space_with_buckets,
+                        ManyToManySearchSpaces *search_spaces = nullptr) const
+    {
+        if (UseSearchSpaceCache())
+        {
+            const auto search_space = GetSearchSpace<false>(phantom, query_heap);
+            for (const auto &entry : *search_space)
+            {
+                if (entry.distance > max_key)
+                {
+                    break;
+                }
+                search_space_with_buckets.emplace_back(entry.node, column_idx, entry.distance);
+                if (search_spaces)
+                {
+                    search_spaces->backward.push_back({entry.node, column_idx, entry.parent});
+                }
+            }
+            return;
+        }
+
+        SearchEngineData::CheckQueryControl();
+        query_heap.Clear();
+        InsertPhantom<false>(phantom, query_heap);
+
+        // explore search space
+        while (!query_heap.Empty() && query_heap.MinKey() <= max_key)
+        {
+            BackwardRoutingStep(column_idx, query_heap, search_space_with_buckets, search_spaces);
+        }
+    }
+
+    void ForwardSearch(const unsigned row_idx,
+                       const unsigned number_of_targets,
+                       const PhantomNode &phantom,
+                       const std::int64_t max_key,
+                       QueryHeap &query_heap,
+                       const BucketColumns &bucket_columns,
+                       std::vector<EdgeWeight> &result_table,
+                       ManyToManySearchSpaces *search_spaces = nullptr) const
+    {
+        if (UseSearchSpaceCache())
+        {
+            const auto search_space = GetSearchSpace<true>(phantom, query_heap);
+            for (const auto &entry : *search_space)
+            {
+                if (entry.distance > max_key)
+                {
+                    break;
+                }
+                SearchEngineData::PollQueryControl();
+                if (search_spaces)
+                {
+                    search_spaces->forward.push_back({entry.node, row_idx, entry.parent});
+                }
+                MeetBucketColumns(entry.node,
+                                  entry.distance,
+                                  bucket_columns,
+                                  row_idx,
+                                  number_of_targets,
+                                  result_table,
+                                  search_spaces);
+            }
+            return;
+        }
+
+        SearchEngineData::CheckQueryControl();
+        query_heap.Clear();
+        InsertPhantom<true>(phantom, query_heap);
+
+        // explore search space
+        while (!query_heap.Empty() && query_heap.MinKey() <= max_key)
+        {
+            ForwardRoutingStep(row_idx,
+                               number_of_targets,
+                               query_heap,
+                               bucket_columns,
+                               result_table,
+                               search_spaces);
+        }
+    }
+
     void ForwardRoutingStep(const unsigned row_idx,
                             const unsigned number_of_targets,
                             QueryHeap &query_heap,
-                            const SearchSpaceWithBuckets &search_space_with_buckets,
-                            std::vector<EdgeWeight> &result_table) const
+                            const BucketColumns &bucket_columns,
+                            std::vector<EdgeWeight> &result_table,
+                            ManyToManySearchSpaces *search_spaces) const
     {
+        SearchEngineData::PollQueryControl();
         const NodeID node = query_heap.DeleteMin();
         const int source_distance = query_heap.GetKey(node);
+        if (search_spaces)
+        {
+            search_spaces->forward.push_back({node, row_idx, query_heap.GetData(node).parent});
+        }
+
+        MeetBucketColumns(node,
+                          source_distance,
+                          bucket_columns,
+                          row_idx,
+                          number_of_targets,
+                          result_table,
+                          search_spaces);
+        if (StallAtNode<true>(node, source_distance, query_heap))
+        {
+            return;
+        }
+        RelaxOutgoingEdges<true>(node, source_distance, query_heap);
+    }
 
+    // Updates the entries of the buckets of the node with the search that settled it at the
+    // distance. The entry of a bucket is the index into the table of its target_id.
+    template <typename EntryIndexT>
+    void MeetBuckets(const NodeID node,
+                     const EdgeWeight distance,
+                     const SearchSpaceWithBuckets &search_space_with_buckets,
+                     const EntryIndexT &entry_index,
+                     std::vector<EdgeWeight> &result_table,
+                     ManyToManySearchSpaces *search_spaces) const
+    {
         // check if each encountered node has an entry
-        const auto bucket_iterator = search_space_with_buckets.find(node);
-        // iterate bucket if there exists one
-        if (bucket_iterator != search_space_with_buckets.end())
+        const auto bucket_list = std::equal_range(search_space_with_buckets.begin(),
+                                                  search_space_with_buckets.end(),
+                                                  node,
+                                                  typename NodeBucket::Compare());
+        for (auto bucket = bucket_list.first; bucket != bucket_list.second; ++bucket)
+        {
+            UpdateEntry(node,
+                        distance + bucket->distance,
+                        entry_index(bucket->target_id),
+                        result_table,
+                        search_spaces);
+        }
+    }
+
+    // Updates the row of the table with the buckets of the node like MeetBuckets
+    void MeetBucketColumns(const NodeID node,
+                           const EdgeWeight distance,
+                           const BucketColumns &bucket_columns,
+                           const unsigned row_idx,
+                           const unsigned number_of_targets,
+                           std::vector<EdgeWeight> &result_table,
+                           ManyToManySearchSpaces *search_spaces) const
+    {
+        const auto range = bucket_columns.GetRange(node);
+        const std::size_t row_begin = std::size_t{row_idx} * number_of_targets;
+
+        // loops are only closed for negative distances, which the keys near the source have
+        if (distance < 0 || bucket_columns.has_negative_distances || search_spaces)
         {
-            const std::vector<NodeBucket> &bucket_list = bucket_iterator->second;
-            for (const NodeBucket &current_bucket : bucket_list)
+            for (auto index = range.first; index != range.second; ++index)
             {
-                // get target id from bucket entry
-                const unsigned column_idx = current_bucket.target_id;
-                const int target_distance = current_bucket.distance;
-                auto &current_distance = result_table[row_idx * number_of_targets + column_idx];
-                // check if new distance is better
-                const EdgeWeight new_distance = source_distance + target_distance;
-                if (new_distance < 0)
-                {
-                    const EdgeWeight loop_weight = super::GetLoopWeight(node);
-                    const int new_distance_with_loop = new_distance + loop_weight;
-                    if (loop_weight != INVALID_EDGE_WEIGHT && new_distance_with_loop >= 0)
-                    {
-                        current_distance = std::min(current_distance, new_distance_with_loop);
-                    }
-                }
-                else if (new_distance < current_distance)
+                UpdateEntry(node,
+                            distance + bucket_columns.distances[index],
+                            row_begin + bucket_columns.target_ids[index],
+                            result_table,
+                            search_spaces);
+            }
+            return;
+        }
+
+        // without loops and middle nodes to track it is a branch-free minimum per entry
+        EdgeWeight *const row = result_table.data() + row_begin;
+        const unsigned *const target_ids = bucket_columns.target_ids.data();
+        const EdgeWeight *const distances = bucket_columns.distances.data();
+        for (auto index = range.first; index != range.second; ++index)
+        {
+            auto &current_distance = row[target_ids[index]];
+            current_distance = std::min(current_distance, distance + distances[index]);
+        }
+    }
+
+    // Updates the entry of the table with the distance through the node if it is shorter
+    void UpdateEntry(const NodeID node,
+                     const EdgeWeight new_distance,
+                     const std::size_t entry,
+                     std::vector<EdgeWeight> &result_table,
+                     ManyToManySearchSpaces *search_spaces) const
+    {
+        auto &current_distance = result_table[entry];
+        if (new_distance < 0)
+        {
+            // on the multi-level graph only the loop edges close a loop at the node, longer
+            // loops meet at the next node
+            const EdgeWeight loop_weight =
+                super::facade->HasMultiLevelData()
+                    ? super::GetLoopWeight(super::facade->GetMultiLevelGraph(), node)
+                    : super::GetLoopWeight(node);
+            const int new_distance_with_loop = new_distance + loop_weight;
+            if (loop_weight != INVALID_EDGE_WEIGHT && new_distance_with_loop >= 0 &&
+                new_distance_with_loop < current_distance)
+            {
+                current_distance = new_distance_with_loop;
+                if (search_spaces)
                 {
-                    result_table[row_idx * number_of_targets + column_idx] = new_distance;
+                    search_spaces->middle_nodes[entry] = SPECIAL_NODEID;
                 }
             }
         }
-        if (StallAtNode<true>(node, source_distance, query_heap))
+        else if (new_distance < current_distance)
         {
-            return;
+            current_distance = new_distance;
+            if (search_spaces)
+            {
+                search_spaces->middle_nodes[entry] = node;
+            }
         }
-        RelaxOutgoingEdges<true>(node, source_distance, query_heap);
     }
 
     void BackwardRoutingStep(const unsigned column_idx,
                              QueryHeap &query_heap,
-                             SearchSpaceWithBuckets &search_space_with_buckets) const
+                             SearchSpaceWithBuckets &search_space_with_buckets,
+                             ManyToManySearchSpaces *search_spaces) const
     {
+        SearchEngineData::PollQueryControl();
         const NodeID node = query_heap.DeleteMin();
         const int target_distance = query_heap.GetKey(node);
 
         // store settled nodes in search space bucket
-        search_space_with_buckets[node].emplace_back(column_idx, target_distance);
+        search_space_with_buckets.emplace_back(node, column_idx, target_distance);
+        if (search_spaces)
+        {
+            search_spaces->backward.push_back(
+                {node, column_idx, query_heap.GetData(node).parent});
+        }
 
         if (StallAtNode<false>(node, target_distance, query_heap))
         {
@@ -220,20 +1944,34 @@ class ManyToManyRouting final
         RelaxOutgoingEdges<false>(node, target_distance, query_heap);
     }
 
-    template <bool forward_direction>
+    template <bool forward_direction, typename HeapT>
     inline void
-    RelaxOutgoingEdges(const NodeID node, const EdgeWeight distance, QueryHeap &query_heap) const
+    RelaxOutgoingEdges(const NodeID node, const EdgeWeight distance, HeapT &query_heap) const
     {
-        for (auto edge : super::facade->GetAdjacentEdgeRange(node))
+        const auto &graph = super::facade->GetSearchGraph();
+        std::uint64_t relaxed_edges = 0;
+        const TrafficOverlay *const overlay = SearchEngineData::GetTrafficOverlay();
+        for (auto edge : graph.GetAdjacentEdgeRange(node))
         {
-            const auto &data = super::facade->GetEdgeData(edge);
+            const auto &data = graph.GetSearchData(edge);
             const bool direction_flag = (forward_direction ? data.forward : data.backward);
             if (direction_flag)
             {
-                const NodeID to = super::facade->GetTarget(edge);
-                const int edge_weight = data.distance;
+                ++relaxed_edges;
+                const NodeID to = data.target;
+                int edge_weight = data.distance;
 
                 BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
+                // the penalties hidden inside shortcuts are not searched for in tables
+                if (overlay)
+                {
+                    edge_weight = super::GetTrafficWeight(
+                        *overlay, node, to, forward_direction, edge_weight);
+                    if (edge_weight == INVALID_EDGE_WEIGHT)
+                    {
+                        continue;
+                    }
+                }
                 const int to_distance = distance + edge_weight;
 
                 // New Node discovered -> Add to Heap + Node Info Storage
@@ -250,26 +1988,49 @@ class ManyToManyRouting final
                 }
             }
         }
+        if (SearchStatistics *const statistics = SearchEngineData::GetStatistics())
+        {
+            statistics->relaxed_edges += relaxed_edges;
+        }
     }
 
-    // Stalling
-    template <bool forward_direction>
-    inline bool
-    StallAtNode(const NodeID node, const EdgeWeight distance, QueryHeap &query_heap) const
+    // Stalling, every settled node is checked and counted here
+    template <bool forward_direction, typename HeapT>
+    inline bool StallAtNode(const NodeID node, const EdgeWeight distance, HeapT &query_heap) const
     {
-        for (auto edge : super::facade->GetAdjacentEdgeRange(node))
+        const auto &graph = super::facade->GetSearchGraph();
+        SearchStatistics *const statistics = SearchEngineData::GetStatistics();
+        if (statistics)
+        {
+            ++statistics->settled_nodes;
+        }
+        const TrafficOverlay *const overlay = SearchEngineData::GetTrafficOverlay();
+        for (auto edge : graph.GetAdjacentEdgeRange(node))
         {
-            const auto &data = super::facade->GetEdgeData(edge);
+            const auto &data = graph.GetSearchData(edge);
             const bool reverse_flag = ((!forward_direction) ? data.forward : data.backward);
             if (reverse_flag)
             {
-                const NodeID to = super::facade->GetTarget(edge);
-                const int edge_weight = data.distance;
+                const NodeID to = data.target;
+                int edge_weight = data.distance;
                 BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
+                if (overlay)
+                {
+                    edge_weight = super::GetTrafficWeight(
+                        *overlay, node, to, !forward_direction, edge_weight);
+                    if (edge_weight == INVALID_EDGE_WEIGHT)
+                    {
+                        continue;
+                    }
+                }
                 if (query_heap.WasInserted(to))
                 {
                     if (query_heap.GetKey(to) + edge_weight < distance)
                     {
+                        if (statistics)
+                        {
+                            ++statistics->stalled_nodes;
+                        }
                         return true;
                     }
                 }
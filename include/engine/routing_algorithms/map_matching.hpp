@@ -4,11 +4,11 @@
 #include "engine/routing_algorithms/routing_base.hpp"
 
 #include "engine/map_matching/hidden_markov_model.hpp"
+#include "engine/map_matching/match_session.hpp"
 #include "engine/map_matching/matching_confidence.hpp"
 #include "engine/map_matching/sub_matching.hpp"
 
 #include "util/coordinate_calculation.hpp"
-#include "util/for_each_pair.hpp"
 #include "util/json_logger.hpp"
 
 #include <cstddef>
@@ -16,7 +16,9 @@
 #include <algorithm>
 #include <deque>
 #include <iomanip>
+#include <limits>
 #include <numeric>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -29,13 +31,15 @@ namespace routing_algorithms
 
 using CandidateList = std::vector<PhantomNodeWithDistance>;
 using CandidateLists = std::vector<CandidateList>;
-using HMM = map_matching::HiddenMarkovModel<CandidateLists>;
+using HMM = map_matching::HiddenMarkovModel;
 using SubMatchingList = std::vector<map_matching::SubMatching>;
 
 constexpr static const unsigned MAX_BROKEN_STATES = 10;
 constexpr static const double MAX_SPEED = 180 / 3.6; // 180km -> m/s
 static const constexpr double MATCHING_BETA = 10;
 constexpr static const double MAX_DISTANCE_DELTA = 2000.;
+// the number of sample times a session takes the median of
+constexpr static const std::size_t MAX_SESSION_SAMPLE_TIMES = 32;
 
 // implements a hidden markov model map matching algorithm
 template <class DataFacadeT>
@@ -63,6 +67,587 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
         return *median;
     }
 
+    // the length of the trace through the matched coordinates, for the confidence of a matching
+    static double GetTraceDistance(const std::vector<util::Coordinate> &matched_coordinates)
+    {
+        std::vector<double> distances;
+        util::coordinate_calculation::haversineDistances(matched_coordinates, distances);
+        return std::accumulate(distances.begin(), distances.end(), 0.0);
+    }
+
+    // The settled node of the backward search of a target. The parent is the next node on the
+    // way to the target, the node itself for the nodes of the target.
+    struct TransitionBucket
+    {
+        TransitionBucket(const NodeID node,
+                         const unsigned target,
+                         const EdgeWeight duration,
+                         const NodeID parent)
+            : node(node), target(target), duration(duration), parent(parent)
+        {
+        }
+
+        bool operator<(const TransitionBucket &other) const
+        {
+            return std::tie(node, target) < std::tie(other.node, other.target);
+        }
+
+        NodeID node;
+        unsigned target;
+        EdgeWeight duration;
+        NodeID parent;
+    };
+
+    // The fastest connection from a source to a target found so far
+    struct Transition
+    {
+        EdgeWeight duration;
+        NodeID middle;
+        // the path is a loop at the middle node
+        bool is_loop;
+    };
+
+    // Computes the network distances between the candidates of two timestamps, row by row for
+    // the sources: the length of the fastest path if it is faster than the upper bound, max()
+    // otherwise and for the pruned sources. Instead of a bidirectional search per pair, every
+    // target runs one bounded backward search that leaves its search space in buckets and every
+    // source runs one forward search that meets them, like the distance table does. The length
+    // of a path is measured on its packed path, which is retrieved from the parents in the
+    // forward heap and in the buckets.
+    template <typename PrunedRange>
+    void GetTransitionDistances(const CandidateList &sources,
+                                const PrunedRange &sources_pruned,
+                                const CandidateList &targets,
+                                const EdgeWeight duration_upper_bound,
+                                QueryHeap &query_heap,
+                                std::vector<TransitionBucket> &buckets,
+                                std::vector<double> &distances) const
+    {
+        distances.assign(sources.size() * targets.size(), std::numeric_limits<double>::max());
+
+        // forward keys start at the negated weights of the sources
+        EdgeWeight max_source_weight = 0;
+        for (const auto s : util::irange<std::size_t>(0UL, sources.size()))
+        {
+            if (!sources_pruned[s])
+            {
+                max_source_weight =
+                    std::max(max_source_weight, GetMaxWeight(sources[s].phantom_node));
+            }
+        }
+
+        // pairs of candidates without a path keep max() without a search, see
+        // BaseDataFacade::IsUnreachable
+        const auto is_unreachable = [&](const std::size_t s, const std::size_t s_prime) {
+            return super::facade->IsUnreachable(sources[s].phantom_node,
+                                                targets[s_prime].phantom_node);
+        };
+
+        buckets.clear();
+        for (const auto s_prime : util::irange<std::size_t>(0UL, targets.size()))
+        {
+            bool is_reached = false;
+            for (const auto s : util::irange<std::size_t>(0UL, sources.size()))
+            {
+                is_reached = is_reached || (!sources_pruned[s] && !is_unreachable(s, s_prime));
+            }
+            if (!is_reached)
+            {
+                continue;
+            }
+
+            query_heap.Clear();
+            InsertPhantom<false>(targets[s_prime].phantom_node, query_heap);
+            while (!query_heap.Empty())
+            {
+                SearchEngineData::PollQueryControl();
+                const NodeID node = query_heap.DeleteMin();
+                const EdgeWeight duration = query_heap.GetKey(node);
+                // no source reaches the target through the remaining nodes fast enough
+                if (duration - max_source_weight >= duration_upper_bound)
+                {
+                    break;
+                }
+                buckets.emplace_back(node, s_prime, duration, query_heap.GetData(node).parent);
+                if (!StallAtNode<false>(node, duration, query_heap))
+                {
+                    RelaxOutgoingEdges<false>(node, duration, query_heap);
+                }
+            }
+        }
+        std::sort(buckets.begin(), buckets.end());
+
+        std::vector<Transition> transitions(targets.size());
+        std::vector<NodeID> packed_path;
+        for (const auto s : util::irange<std::size_t>(0UL, sources.size()))
+        {
+            if (sources_pruned[s])
+            {
+                continue;
+            }
+
+            std::size_t number_of_reachable_targets = 0;
+            for (const auto s_prime : util::irange<std::size_t>(0UL, targets.size()))
+            {
+                number_of_reachable_targets += is_unreachable(s, s_prime) ? 0 : 1;
+            }
+            if (number_of_reachable_targets == 0)
+            {
+                continue;
+            }
+
+            std::fill(transitions.begin(),
+                      transitions.end(),
+                      Transition{duration_upper_bound, SPECIAL_NODEID, false});
+            std::size_t number_of_found_targets = 0;
+            EdgeWeight max_found_duration = 0;
+
+            query_heap.Clear();
+            InsertPhantom<true>(sources[s].phantom_node, query_heap);
+            while (!query_heap.Empty())
+            {
+                SearchEngineData::PollQueryControl();
+                const NodeID node = query_heap.DeleteMin();
+                const EdgeWeight duration = query_heap.GetKey(node);
+                // backward durations are not negative, so no path through the remaining nodes
+                // is faster
+                if (duration >= duration_upper_bound ||
+                    (number_of_found_targets == number_of_reachable_targets &&
+                     duration >= max_found_duration))
+                {
+                    break;
+                }
+
+                const auto node_buckets = std::equal_range(buckets.begin(),
+                                                           buckets.end(),
+                                                           TransitionBucket{node, 0, 0, node},
+                                                           [](const TransitionBucket &lhs,
+                                                              const TransitionBucket &rhs) {
+                                                               return lhs.node < rhs.node;
+                                                           });
+                bool improved = false;
+                for (auto bucket = node_buckets.first; bucket != node_buckets.second; ++bucket)
+                {
+                    auto &transition = transitions[bucket->target];
+                    EdgeWeight new_duration = duration + bucket->duration;
+                    bool is_loop = false;
+                    // source and target are on the same segment, the source behind the target
+                    if (new_duration < 0)
+                    {
+                        const EdgeWeight loop_weight = super::GetLoopWeight(node);
+                        if (loop_weight == INVALID_EDGE_WEIGHT || new_duration + loop_weight < 0)
+                        {
+                            continue;
+                        }
+                        new_duration += loop_weight;
+                        is_loop = true;
+                    }
+                    if (new_duration < transition.duration)
+                    {
+                        if (transition.middle == SPECIAL_NODEID)
+                        {
+                            ++number_of_found_targets;
+                        }
+                        transition = Transition{new_duration, node, is_loop};
+                        improved = true;
+                    }
+                }
+                if (improved && number_of_found_targets == number_of_reachable_targets)
+                {
+                    max_found_duration = 0;
+                    for (const auto &transition : transitions)
+                    {
+                        if (transition.middle != SPECIAL_NODEID)
+                        {
+                            max_found_duration =
+                                std::max(max_found_duration, transition.duration);
+                        }
+                    }
+                }
+
+                if (!StallAtNode<true>(node, duration, query_heap))
+                {
+                    RelaxOutgoingEdges<true>(node, duration, query_heap);
+                }
+            }
+
+            for (const auto s_prime : util::irange<std::size_t>(0UL, targets.size()))
+            {
+                const auto &transition = transitions[s_prime];
+                if (transition.middle == SPECIAL_NODEID)
+                {
+                    continue;
+                }
+
+                packed_path.clear();
+                if (transition.is_loop)
+                {
+                    packed_path.push_back(transition.middle);
+                    packed_path.push_back(transition.middle);
+                }
+                else
+                {
+                    super::RetrievePackedPathFromSingleHeap(
+                        query_heap, transition.middle, packed_path);
+                    std::reverse(packed_path.begin(), packed_path.end());
+                    packed_path.push_back(transition.middle);
+                    RetrievePackedPathFromBuckets(
+                        buckets, transition.middle, s_prime, packed_path);
+                }
+                distances[s * targets.size() + s_prime] = super::GetContractedPathDistance(
+                    packed_path, sources[s].phantom_node, targets[s_prime].phantom_node);
+            }
+        }
+    }
+
+    // Follows the parents of the backward search of a target from the middle node on
+    void RetrievePackedPathFromBuckets(const std::vector<TransitionBucket> &buckets,
+                                       const NodeID middle,
+                                       const unsigned target,
+                                       std::vector<NodeID> &packed_path) const
+    {
+        NodeID node = middle;
+        while (true)
+        {
+            const auto bucket = std::lower_bound(
+                buckets.begin(), buckets.end(), TransitionBucket{node, target, 0, node});
+            BOOST_ASSERT(bucket != buckets.end() && bucket->node == node &&
+                         bucket->target == target);
+            if (bucket->parent == node)
+            {
+                return;
+            }
+            node = bucket->parent;
+            packed_path.push_back(node);
+        }
+    }
+
+    static EdgeWeight GetMaxWeight(const PhantomNode &phantom)
+    {
+        EdgeWeight weight = 0;
+        if (phantom.forward_segment_id.enabled)
+        {
+            weight = std::max(weight, phantom.GetForwardWeightPlusOffset());
+        }
+        if (phantom.reverse_segment_id.enabled)
+        {
+            weight = std::max(weight, phantom.GetReverseWeightPlusOffset());
+        }
+        return weight;
+    }
+
+    // Sources are inserted with negative, targets with positive weights
+    template <bool forward_direction>
+    void InsertPhantom(const PhantomNode &phantom, QueryHeap &query_heap) const
+    {
+        const int sign = forward_direction ? -1 : 1;
+        if (phantom.forward_segment_id.enabled)
+        {
+            query_heap.Insert(phantom.forward_segment_id.id,
+                              sign * phantom.GetForwardWeightPlusOffset(),
+                              phantom.forward_segment_id.id);
+        }
+        if (phantom.reverse_segment_id.enabled)
+        {
+            query_heap.Insert(phantom.reverse_segment_id.id,
+                              sign * phantom.GetReverseWeightPlusOffset(),
+                              phantom.reverse_segment_id.id);
+        }
+    }
+
+    template <bool forward_direction>
+    void RelaxOutgoingEdges(const NodeID node,
+                            const EdgeWeight duration,
+                            QueryHeap &query_heap) const
+    {
+        const auto &graph = super::facade->GetSearchGraph();
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            const auto &data = graph.GetSearchData(edge);
+            if (forward_direction ? data.forward : data.backward)
+            {
+                const NodeID to = data.target;
+                BOOST_ASSERT_MSG(data.distance > 0, "edge_weight invalid");
+                const EdgeWeight to_duration = duration + data.distance;
+
+                if (!query_heap.WasInserted(to))
+                {
+                    query_heap.Insert(to, to_duration, node);
+                }
+                else if (to_duration < query_heap.GetKey(to))
+                {
+                    query_heap.GetData(to).parent = node;
+                    query_heap.DecreaseKey(to, to_duration);
+                }
+            }
+        }
+    }
+
+    // A node that is reached faster over an edge in the other direction is not on a shortest
+    // path of the upward search
+    template <bool forward_direction>
+    bool StallAtNode(const NodeID node, const EdgeWeight duration, QueryHeap &query_heap) const
+    {
+        const auto &graph = super::facade->GetSearchGraph();
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            const auto &data = graph.GetSearchData(edge);
+            if (forward_direction ? data.backward : data.forward)
+            {
+                const NodeID to = data.target;
+                if (query_heap.WasInserted(to) &&
+                    query_heap.GetKey(to) + data.distance < duration)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // A new column of the hidden markov model, nothing is reachable yet
+    map_matching::MatchSessionPoint
+    MakeSessionPoint(CandidateList candidates,
+                     const util::Coordinate coordinate,
+                     const unsigned timestamp,
+                     const boost::optional<double> &gps_precision) const
+    {
+        map_matching::MatchSessionPoint point;
+        point.coordinate = coordinate;
+        point.timestamp = timestamp;
+        point.candidates = std::move(candidates);
+
+        const auto number_of_candidates = point.candidates.size();
+        point.emission_log_probabilities.resize(number_of_candidates);
+        const auto emission_log_probability =
+            gps_precision ? map_matching::EmissionLogProbability(*gps_precision)
+                          : default_emission_log_probability;
+        std::transform(point.candidates.begin(),
+                       point.candidates.end(),
+                       point.emission_log_probabilities.begin(),
+                       [&emission_log_probability](const PhantomNodeWithDistance &candidate) {
+                           return emission_log_probability(candidate.distance);
+                       });
+        point.viterbi.resize(number_of_candidates, map_matching::IMPOSSIBLE_LOG_PROB);
+        point.parents.resize(number_of_candidates, std::make_pair(0UL, 0UL));
+        point.path_distances.resize(number_of_candidates, 0);
+        point.pruned.resize(number_of_candidates, true);
+        point.broken = true;
+        return point;
+    }
+
+    // Starts a sub matching at the point, like HiddenMarkovModel::initialize
+    static void InitializeSessionPoint(map_matching::MatchSessionPoint &point,
+                                       const std::size_t trace_index)
+    {
+        for (const auto s : util::irange<std::size_t>(0UL, point.candidates.size()))
+        {
+            point.viterbi[s] = point.emission_log_probabilities[s];
+            point.parents[s] = std::make_pair(trace_index, s);
+            point.pruned[s] = point.viterbi[s] < map_matching::MINIMAL_LOG_PROB;
+            point.broken = point.broken && point.pruned[s];
+        }
+    }
+
+    static unsigned GetMedianSessionSampleTime(const std::deque<unsigned> &sample_times)
+    {
+        if (sample_times.empty())
+        {
+            return 1u;
+        }
+        std::vector<unsigned> sorted_sample_times(sample_times.begin(), sample_times.end());
+        auto median = sorted_sample_times.begin() + sorted_sample_times.size() / 2;
+        std::nth_element(sorted_sample_times.begin(), median, sorted_sample_times.end());
+        return std::max(1u, *median);
+    }
+
+    // Computes the column of the point from the frontier of the session, the same way the
+    // timestamps of a whole trace are computed
+    void AdvanceSession(const map_matching::MatchSession &session,
+                        const double max_distance_delta,
+                        map_matching::MatchSessionPoint &point) const
+    {
+        const auto &prev_point = session.GetPoint(session.frontier);
+
+        const auto haversine_distance = util::coordinate_calculation::haversineDistance(
+            prev_point.coordinate, point.coordinate);
+        // assumes minumum of 0.1 m/s
+        const int duration_upper_bound = ((haversine_distance + max_distance_delta) * 0.25) * 10;
+
+        engine_working_data.InitializeOrClearFirstHeaps(super::facade->GetNumberOfNodes());
+        std::vector<TransitionBucket> buckets;
+        std::vector<double> network_distances;
+        GetTransitionDistances(prev_point.candidates,
+                               prev_point.pruned,
+                               point.candidates,
+                               duration_upper_bound,
+                               *engine_working_data.GetHeaps().forward_heap_1,
+                               buckets,
+                               network_distances);
+
+        for (const auto s : util::irange<std::size_t>(0UL, prev_point.candidates.size()))
+        {
+            if (prev_point.pruned[s])
+            {
+                continue;
+            }
+
+            for (const auto s_prime : util::irange<std::size_t>(0UL, point.candidates.size()))
+            {
+                double new_value =
+                    prev_point.viterbi[s] + point.emission_log_probabilities[s_prime];
+                if (point.viterbi[s_prime] > new_value)
+                {
+                    continue;
+                }
+
+                const double network_distance =
+                    network_distances[s * point.candidates.size() + s_prime];
+                const auto d_t = std::abs(network_distance - haversine_distance);
+                if (d_t >= max_distance_delta)
+                {
+                    continue;
+                }
+
+                new_value += transition_log_probability(d_t);
+                if (new_value > point.viterbi[s_prime])
+                {
+                    point.viterbi[s_prime] = new_value;
+                    point.parents[s_prime] = std::make_pair(session.frontier, s);
+                    point.path_distances[s_prime] = network_distance;
+                    point.pruned[s_prime] = false;
+                    point.broken = false;
+                }
+            }
+        }
+    }
+
+    // The viable candidate of the point with the best path to it
+    static std::size_t GetBestCandidate(const map_matching::MatchSessionPoint &point)
+    {
+        std::size_t best_candidate = 0;
+        for (const auto s : util::irange<std::size_t>(0UL, point.candidates.size()))
+        {
+            if (!point.pruned[s] &&
+                (point.pruned[best_candidate] || point.viterbi[s] > point.viterbi[best_candidate]))
+            {
+                best_candidate = s;
+            }
+        }
+        return best_candidate;
+    }
+
+    // The points and candidates of the best path to the candidate from the start of the
+    // sub matching on
+    static std::deque<std::pair<std::size_t, std::size_t>>
+    GetSessionPath(const map_matching::MatchSession &session,
+                   std::size_t trace_index,
+                   std::size_t candidate)
+    {
+        std::deque<std::pair<std::size_t, std::size_t>> path;
+        while (true)
+        {
+            path.emplace_front(trace_index, candidate);
+            const auto &parent = session.GetPoint(trace_index).parents[candidate];
+            // the start of the sub matching is its own parent
+            if (trace_index == session.first_index || parent.first == trace_index)
+            {
+                break;
+            }
+            trace_index = parent.first;
+            candidate = parent.second;
+        }
+        return path;
+    }
+
+    // Returns the sub matching along the path, matchings of a single point are invalid
+    void FinalizeSessionPath(const map_matching::MatchSession &session,
+                             const std::deque<std::pair<std::size_t, std::size_t>> &path,
+                             SubMatchingList &sub_matchings) const
+    {
+        if (path.size() < 2)
+        {
+            return;
+        }
+
+        map_matching::SubMatching matching;
+        auto matching_distance = 0.0;
+        matching.nodes.reserve(path.size());
+        matching.indices.reserve(path.size());
+        std::vector<util::Coordinate> matched_coordinates;
+        matched_coordinates.reserve(path.size());
+        for (const auto &idx : path)
+        {
+            const auto &point = session.GetPoint(idx.first);
+            matching.indices.push_back(idx.first);
+            matching.nodes.push_back(point.candidates[idx.second].phantom_node);
+            matching_distance += point.path_distances[idx.second];
+            matched_coordinates.push_back(point.coordinate);
+        }
+        const auto trace_distance = GetTraceDistance(matched_coordinates);
+        matching.confidence = confidence(trace_distance, matching_distance);
+        sub_matchings.push_back(std::move(matching));
+    }
+
+    // Returns the matching up to the candidate of the point, which starts the remaining points
+    void FinalizeSessionUpTo(map_matching::MatchSession &session,
+                             const std::size_t trace_index,
+                             const std::size_t candidate,
+                             SubMatchingList &sub_matchings) const
+    {
+        BOOST_ASSERT(trace_index > session.first_index);
+        FinalizeSessionPath(
+            session, GetSessionPath(session, trace_index, candidate), sub_matchings);
+
+        session.points.erase(session.points.begin(),
+                             session.points.begin() + (trace_index - session.first_index));
+        session.first_index = trace_index;
+        session.final_end = trace_index + 1;
+
+        // the path to the point was returned already
+        auto &start = session.points.front();
+        for (const auto s : util::irange<std::size_t>(0UL, start.candidates.size()))
+        {
+            start.pruned[s] = s != candidate;
+        }
+        start.parents[candidate] = std::make_pair(trace_index, candidate);
+        start.path_distances[candidate] = 0;
+    }
+
+    // The latest point that the best paths to all viable candidates of the frontier go through
+    static std::pair<std::size_t, std::size_t>
+    GetConvergencePoint(const map_matching::MatchSession &session)
+    {
+        std::size_t trace_index = session.frontier;
+        const auto &frontier_point = session.GetPoint(trace_index);
+        std::vector<std::size_t> candidates;
+        for (const auto s : util::irange<std::size_t>(0UL, frontier_point.candidates.size()))
+        {
+            if (!frontier_point.pruned[s])
+            {
+                candidates.push_back(s);
+            }
+        }
+        BOOST_ASSERT(!candidates.empty());
+
+        // all candidates of a point have their parents at the same previous point
+        while (candidates.size() > 1 && trace_index > session.first_index)
+        {
+            const auto &point = session.GetPoint(trace_index);
+            const auto parent_index = point.parents[candidates.front()].first;
+            for (auto &candidate : candidates)
+            {
+                BOOST_ASSERT(point.parents[candidate].first == parent_index);
+                candidate = point.parents[candidate].second;
+            }
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+            trace_index = parent_index;
+        }
+
+        return std::make_pair(trace_index, candidates.front());
+    }
+
   public:
     MapMatching(DataFacadeT *facade,
                 SearchEngineData &engine_working_data,
@@ -108,66 +693,35 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
             }
         }();
 
-        std::vector<std::vector<double>> emission_log_probabilities(trace_coordinates.size());
-        if (trace_gps_precision.empty())
-        {
-            for (auto t = 0UL; t < candidates_list.size(); ++t)
-            {
-                emission_log_probabilities[t].resize(candidates_list[t].size());
-                std::transform(candidates_list[t].begin(),
-                               candidates_list[t].end(),
-                               emission_log_probabilities[t].begin(),
-                               [this](const PhantomNodeWithDistance &candidate) {
-                                   return default_emission_log_probability(candidate.distance);
-                               });
-            }
-        }
-        else
+        engine_working_data.InitializeHiddenMarkovModel();
+        HMM &model = *engine_working_data.GetHeaps().hidden_markov_model;
+        model.Reset(candidates_list);
+
+        for (const auto t : util::irange<std::size_t>(0UL, candidates_list.size()))
         {
-            for (auto t = 0UL; t < candidates_list.size(); ++t)
-            {
-                emission_log_probabilities[t].resize(candidates_list[t].size());
-                if (trace_gps_precision[t])
-                {
-                    map_matching::EmissionLogProbability emission_log_probability(
-                        *trace_gps_precision[t]);
-                    std::transform(
-                        candidates_list[t].begin(),
-                        candidates_list[t].end(),
-                        emission_log_probabilities[t].begin(),
-                        [&emission_log_probability](const PhantomNodeWithDistance &candidate) {
-                            return emission_log_probability(candidate.distance);
-                        });
-                }
-                else
-                {
-                    std::transform(candidates_list[t].begin(),
-                                   candidates_list[t].end(),
-                                   emission_log_probabilities[t].begin(),
-                                   [this](const PhantomNodeWithDistance &candidate) {
-                                       return default_emission_log_probability(candidate.distance);
-                                   });
-                }
-            }
+            const auto emission_log_probability =
+                !trace_gps_precision.empty() && trace_gps_precision[t]
+                    ? map_matching::EmissionLogProbability(*trace_gps_precision[t])
+                    : default_emission_log_probability;
+            std::transform(candidates_list[t].begin(),
+                           candidates_list[t].end(),
+                           model.GetColumn(model.emission_log_probabilities, t).begin(),
+                           [&emission_log_probability](const PhantomNodeWithDistance &candidate) {
+                               return emission_log_probability(candidate.distance);
+                           });
         }
 
-        HMM model(candidates_list, emission_log_probabilities);
-
         std::size_t initial_timestamp = model.initialize(0);
         if (initial_timestamp == map_matching::INVALID_STATE)
         {
             return sub_matchings;
         }
 
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-        engine_working_data.InitializeOrClearSecondThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-
-        QueryHeap &forward_heap = *(engine_working_data.forward_heap_1);
-        QueryHeap &reverse_heap = *(engine_working_data.reverse_heap_1);
-        QueryHeap &forward_core_heap = *(engine_working_data.forward_heap_2);
-        QueryHeap &reverse_core_heap = *(engine_working_data.reverse_heap_2);
+        engine_working_data.InitializeOrClearFirstHeaps(super::facade->GetNumberOfNodes());
+        QueryHeap &query_heap = *engine_working_data.GetHeaps().forward_heap_1;
+        // reused by all timestamps
+        std::vector<TransitionBucket> buckets;
+        std::vector<double> network_distances;
 
         std::size_t breakage_begin = map_matching::INVALID_STATE;
         std::vector<std::size_t> split_points;
@@ -176,6 +730,8 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
         prev_unbroken_timestamps.push_back(initial_timestamp);
         for (auto t = initial_timestamp + 1; t < candidates_list.size(); ++t)
         {
+            // long traces of close points settle few nodes between the polls of their searches
+            SearchEngineData::CheckQueryControl();
 
             const bool gap_in_trace = [&, use_timestamps]() {
                 // use temporal information if available to determine a split
@@ -195,16 +751,18 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                 BOOST_ASSERT(!prev_unbroken_timestamps.empty());
                 const std::size_t prev_unbroken_timestamp = prev_unbroken_timestamps.back();
 
-                const auto &prev_viterbi = model.viterbi[prev_unbroken_timestamp];
-                const auto &prev_pruned = model.pruned[prev_unbroken_timestamp];
+                const auto prev_viterbi = model.GetColumn(model.viterbi, prev_unbroken_timestamp);
+                const auto prev_pruned = model.GetColumn(model.pruned, prev_unbroken_timestamp);
                 const auto &prev_unbroken_timestamps_list =
                     candidates_list[prev_unbroken_timestamp];
                 const auto &prev_coordinate = trace_coordinates[prev_unbroken_timestamp];
 
-                auto &current_viterbi = model.viterbi[t];
-                auto &current_pruned = model.pruned[t];
-                auto &current_parents = model.parents[t];
-                auto &current_lengths = model.path_distances[t];
+                const auto current_viterbi = model.GetColumn(model.viterbi, t);
+                const auto current_pruned = model.GetColumn(model.pruned, t);
+                const auto current_parents = model.GetColumn(model.parents, t);
+                const auto current_lengths = model.GetColumn(model.path_distances, t);
+                const auto current_emissions =
+                    model.GetColumn(model.emission_log_probabilities, t);
                 const auto &current_timestamps_list = candidates_list[t];
                 const auto &current_coordinate = trace_coordinates[t];
 
@@ -214,6 +772,15 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                 const int duration_upper_bound =
                     ((haversine_distance + max_distance_delta) * 0.25) * 10;
 
+                // all transitions between the two timestamps at once
+                GetTransitionDistances(prev_unbroken_timestamps_list,
+                                       prev_pruned,
+                                       current_timestamps_list,
+                                       duration_upper_bound,
+                                       query_heap,
+                                       buckets,
+                                       network_distances);
+
                 // compute d_t for this timestamp and the next one
                 for (const auto s : util::irange<std::size_t>(0UL, prev_viterbi.size()))
                 {
@@ -225,38 +792,15 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                     for (const auto s_prime :
                          util::irange<std::size_t>(0UL, current_viterbi.size()))
                     {
-                        const double emission_pr = emission_log_probabilities[t][s_prime];
+                        const double emission_pr = current_emissions[s_prime];
                         double new_value = prev_viterbi[s] + emission_pr;
                         if (current_viterbi[s_prime] > new_value)
                         {
                             continue;
                         }
 
-                        forward_heap.Clear();
-                        reverse_heap.Clear();
-
-                        double network_distance;
-                        if (super::facade->GetCoreSize() > 0)
-                        {
-                            forward_core_heap.Clear();
-                            reverse_core_heap.Clear();
-                            network_distance = super::GetNetworkDistanceWithCore(
-                                forward_heap,
-                                reverse_heap,
-                                forward_core_heap,
-                                reverse_core_heap,
-                                prev_unbroken_timestamps_list[s].phantom_node,
-                                current_timestamps_list[s_prime].phantom_node,
-                                duration_upper_bound);
-                        }
-                        else
-                        {
-                            network_distance = super::GetNetworkDistance(
-                                forward_heap,
-                                reverse_heap,
-                                prev_unbroken_timestamps_list[s].phantom_node,
-                                current_timestamps_list[s_prime].phantom_node);
-                        }
+                        const double network_distance =
+                            network_distances[s * current_viterbi.size() + s_prime];
 
                         // get distance diff between loc1/2 and locs/s_prime
                         const auto d_t = std::abs(network_distance - haversine_distance);
@@ -273,7 +817,9 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                         if (new_value > current_viterbi[s_prime])
                         {
                             current_viterbi[s_prime] = new_value;
-                            current_parents[s_prime] = std::make_pair(prev_unbroken_timestamp, s);
+                            current_parents[s_prime] = std::make_pair(
+                                static_cast<unsigned>(prev_unbroken_timestamp),
+                                static_cast<unsigned>(s));
                             current_lengths[s_prime] = network_distance;
                             current_pruned[s_prime] = false;
                             model.breakage[t] = false;
@@ -361,12 +907,12 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
             }
 
             // loop through the columns, and only compare the last entry
+            const auto parent_viterbi = model.GetColumn(model.viterbi, parent_timestamp_index);
             const auto max_element_iter =
-                std::max_element(model.viterbi[parent_timestamp_index].begin(),
-                                 model.viterbi[parent_timestamp_index].end());
+                std::max_element(parent_viterbi.begin(), parent_viterbi.end());
 
             std::size_t parent_candidate_index =
-                std::distance(model.viterbi[parent_timestamp_index].begin(), max_element_iter);
+                std::distance(parent_viterbi.begin(), max_element_iter);
 
             std::deque<std::pair<std::size_t, std::size_t>> reconstructed_indices;
             while (parent_timestamp_index > sub_matching_begin)
@@ -377,7 +923,8 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                 }
 
                 reconstructed_indices.emplace_front(parent_timestamp_index, parent_candidate_index);
-                const auto &next = model.parents[parent_timestamp_index][parent_candidate_index];
+                const auto &next = model.GetColumn(model.parents,
+                                                   parent_timestamp_index)[parent_candidate_index];
                 // make sure we can never get stuck in this loop
                 if (parent_timestamp_index == next.first)
                 {
@@ -394,9 +941,10 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
             }
 
             auto matching_distance = 0.0;
-            auto trace_distance = 0.0;
             matching.nodes.reserve(reconstructed_indices.size());
             matching.indices.reserve(reconstructed_indices.size());
+            std::vector<util::Coordinate> matched_coordinates;
+            matched_coordinates.reserve(reconstructed_indices.size());
             for (const auto idx : reconstructed_indices)
             {
                 const auto timestamp_index = idx.first;
@@ -405,16 +953,11 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                 matching.indices.push_back(timestamp_index);
                 matching.nodes.push_back(
                     candidates_list[timestamp_index][location_index].phantom_node);
-                matching_distance += model.path_distances[timestamp_index][location_index];
+                matching_distance +=
+                    model.GetColumn(model.path_distances, timestamp_index)[location_index];
+                matched_coordinates.push_back(trace_coordinates[timestamp_index]);
             }
-            util::for_each_pair(
-                reconstructed_indices,
-                [&trace_distance,
-                 &trace_coordinates](const std::pair<std::size_t, std::size_t> &prev,
-                                     const std::pair<std::size_t, std::size_t> &curr) {
-                    trace_distance += util::coordinate_calculation::haversineDistance(
-                        trace_coordinates[prev.first], trace_coordinates[curr.first]);
-                });
+            const auto trace_distance = GetTraceDistance(matched_coordinates);
 
             matching.confidence = confidence(trace_distance, matching_distance);
 
@@ -424,6 +967,127 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
 
         return sub_matchings;
     }
+    // Appends the next point of a trace to its session and returns the sub matchings that
+    // became final with it. Pieces of the same sub matching share their boundary point. The
+    // points are handled like the timestamps of a whole trace except that
+    //  - a broken point is skipped, the transitions to the next one start from the same point,
+    //  - the trace is split at a gap or when nothing is reachable anymore, and
+    //  - once the session holds more than max_points points, the best path up to the middle
+    //    of them is returned even though it might still change.
+    void AppendToSession(map_matching::MatchSession &session,
+                         CandidateList candidates,
+                         const util::Coordinate coordinate,
+                         const unsigned timestamp,
+                         const boost::optional<double> &gps_precision,
+                         const std::size_t max_points,
+                         SubMatchingList &sub_matchings) const
+    {
+        BOOST_ASSERT(max_points > 1);
+        auto point = MakeSessionPoint(std::move(candidates), coordinate, timestamp, gps_precision);
+
+        if (session.use_timestamps && session.number_of_points > 0)
+        {
+            session.sample_times.push_back(timestamp - session.last_timestamp);
+            if (session.sample_times.size() > MAX_SESSION_SAMPLE_TIMES)
+            {
+                session.sample_times.pop_front();
+            }
+        }
+        session.last_timestamp = timestamp;
+
+        if (session.frontier != map_matching::INVALID_STATE)
+        {
+            const auto median_sample_time = GetMedianSessionSampleTime(session.sample_times);
+            const auto &prev_point = session.GetPoint(session.frontier);
+            const bool gap_in_trace =
+                session.use_timestamps
+                    ? timestamp - prev_point.timestamp > median_sample_time * MAX_BROKEN_STATES
+                    : session.number_of_points - session.frontier > MAX_BROKEN_STATES;
+
+            if (gap_in_trace)
+            {
+                FinishSession(session, sub_matchings);
+            }
+            else
+            {
+                AdvanceSession(session,
+                               session.use_timestamps ? median_sample_time * MAX_SPEED
+                                                      : MAX_DISTANCE_DELTA,
+                               point);
+            }
+        }
+
+        const auto trace_index = session.number_of_points++;
+        if (session.frontier == map_matching::INVALID_STATE)
+        {
+            // points without a viable candidate before the start of a sub matching stay
+            // unmatched
+            BOOST_ASSERT(session.points.empty());
+            InitializeSessionPoint(point, trace_index);
+            if (point.broken)
+            {
+                session.first_index = trace_index + 1;
+                session.final_end = trace_index + 1;
+                return;
+            }
+            session.first_index = trace_index;
+            session.final_end = trace_index;
+            session.frontier = trace_index;
+            session.points.push_back(std::move(point));
+            return;
+        }
+
+        const bool broken = point.broken;
+        session.points.push_back(std::move(point));
+        if (!broken)
+        {
+            session.frontier = trace_index;
+            const auto convergence_point = GetConvergencePoint(session);
+            if (convergence_point.first > session.first_index)
+            {
+                FinalizeSessionUpTo(
+                    session, convergence_point.first, convergence_point.second, sub_matchings);
+            }
+        }
+
+        if (session.points.size() > max_points)
+        {
+            if (broken)
+            {
+                FinishSession(session, sub_matchings);
+                return;
+            }
+
+            // the latest point of the best path in the first half of the points
+            const auto path = GetSessionPath(
+                session, session.frontier, GetBestCandidate(session.GetPoint(session.frontier)));
+            const auto middle = session.first_index + session.points.size() / 2;
+            auto split = path.back();
+            for (const auto &idx : path)
+            {
+                if (idx.first > session.first_index && idx.first <= middle)
+                {
+                    split = idx;
+                }
+            }
+            FinalizeSessionUpTo(session, split.first, split.second, sub_matchings);
+        }
+    }
+
+    // Ends the trace of a session, its best path is final now
+    void FinishSession(map_matching::MatchSession &session, SubMatchingList &sub_matchings) const
+    {
+        if (session.frontier != map_matching::INVALID_STATE)
+        {
+            FinalizeSessionPath(
+                session,
+                GetSessionPath(session,
+                               session.frontier,
+                               GetBestCandidate(session.GetPoint(session.frontier))),
+                sub_matchings);
+        }
+        session.Clear();
+    }
 };
 }
 }
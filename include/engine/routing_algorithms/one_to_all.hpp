@@ -0,0 +1,312 @@
+#ifndef ONE_TO_ALL_ROUTING_HPP
+#define ONE_TO_ALL_ROUTING_HPP
+
+#include "engine/routing_algorithms/routing_base.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+// Distances from a few sources to every node of the graph, computed PHAST style: an upward
+// search from each source followed by a single linear sweep over the non-core nodes from the
+// top of the hierarchy down, which pulls the distance of every node from the higher ranked
+// nodes it has an incoming edge from.
+//
+// The sweep handles SOURCE_BLOCK_SIZE sources at once. Their labels are stored interleaved per
+// node, so relaxing one edge is a fixed-width min over adjacent values that the compiler turns
+// into vector instructions and the graph is only scanned once per block.
+template <class DataFacadeT>
+class OneToAllRouting final
+    : public BasicRoutingInterface<DataFacadeT, OneToAllRouting<DataFacadeT>>
+{
+    using super = BasicRoutingInterface<DataFacadeT, OneToAllRouting<DataFacadeT>>;
+    using QueryHeap = SearchEngineData::QueryHeap;
+    SearchEngineData &engine_working_data;
+
+    // labels of unreached nodes, small enough that adding an edge weight can not overflow
+    static constexpr EdgeWeight UNREACHED = std::numeric_limits<EdgeWeight>::max() / 2;
+
+  public:
+    static constexpr std::size_t SOURCE_BLOCK_SIZE = 8;
+
+    OneToAllRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
+        : super(facade), engine_working_data(engine_working_data)
+    {
+    }
+
+    // Returns the durations from all sources to all nodes in node-major order, i.e. the
+    // duration from source s to node n is at n * sources.size() + s. Unreachable nodes are
+    // INVALID_EDGE_WEIGHT. The segments of a source itself can be negative, since the search
+    // starts with the offset of the phantom node already travelled.
+    std::vector<EdgeWeight> operator()(const std::vector<PhantomNode> &sources) const
+    {
+        const std::size_t number_of_nodes = super::facade->GetNumberOfNodes();
+        const std::size_t number_of_sources = sources.size();
+        std::vector<EdgeWeight> result(number_of_nodes * number_of_sources, INVALID_EDGE_WEIGHT);
+
+        const auto sweep_order = GetSweepOrder();
+        std::vector<EdgeWeight> block_labels(number_of_nodes * SOURCE_BLOCK_SIZE);
+
+        for (std::size_t block_begin = 0; block_begin < number_of_sources;
+             block_begin += SOURCE_BLOCK_SIZE)
+        {
+            const std::size_t block_end =
+                std::min(block_begin + SOURCE_BLOCK_SIZE, number_of_sources);
+
+            std::fill(block_labels.begin(), block_labels.end(), UNREACHED);
+            for (const auto source_idx : util::irange(block_begin, block_end))
+            {
+                UpwardSearch(sources[source_idx],
+                             UNREACHED,
+                             SOURCE_BLOCK_SIZE,
+                             source_idx - block_begin,
+                             block_labels);
+            }
+
+            Sweep(*sweep_order, block_labels);
+
+            for (const auto node : util::irange<std::size_t>(0, number_of_nodes))
+            {
+                const EdgeWeight *labels = &block_labels[node * SOURCE_BLOCK_SIZE];
+                EdgeWeight *row = &result[node * number_of_sources];
+                for (const auto source_idx : util::irange(block_begin, block_end))
+                {
+                    const EdgeWeight label = labels[source_idx - block_begin];
+                    if (label < UNREACHED)
+                    {
+                        row[source_idx] = label;
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // Returns the durations from a single source to all nodes, INVALID_EDGE_WEIGHT for the nodes
+    // it doesn't reach within max_duration, as for the contours of an isochrone. The upward
+    // search stops at max_duration, which is where most of the work of a short search on a large
+    // graph is saved. The sweep still scans every node, but with a single label per node.
+    std::vector<EdgeWeight> operator()(const PhantomNode &source,
+                                       const EdgeWeight max_duration) const
+    {
+        const auto &graph = super::facade->GetSearchGraph();
+        BOOST_ASSERT(max_duration < UNREACHED);
+        const std::size_t number_of_nodes = super::facade->GetNumberOfNodes();
+
+        const auto sweep_order = GetSweepOrder();
+        std::vector<EdgeWeight> labels(number_of_nodes, UNREACHED);
+        UpwardSearch(source, max_duration, 1, 0, labels);
+
+        for (const NodeID node : *sweep_order)
+        {
+            EdgeWeight label = labels[node];
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                const auto &data = graph.GetSearchData(edge);
+                if (data.backward)
+                {
+                    label = std::min(label, labels[data.target] + data.distance);
+                }
+            }
+            labels[node] = label;
+        }
+
+        for (auto &label : labels)
+        {
+            if (label > max_duration)
+            {
+                label = INVALID_EDGE_WEIGHT;
+            }
+        }
+        return labels;
+    }
+
+  private:
+    using SweepOrder = std::vector<NodeID>;
+
+    // The sweep order only depends on the graph, so it is computed by the first query and
+    // reused until the data facade is swapped.
+    mutable std::mutex sweep_order_mutex;
+    mutable std::shared_ptr<const SweepOrder> sweep_order;
+    mutable unsigned sweep_order_checksum = 0;
+    mutable std::size_t sweep_order_number_of_nodes = 0;
+
+    std::shared_ptr<const SweepOrder> GetSweepOrder() const
+    {
+        std::lock_guard<std::mutex> guard(sweep_order_mutex);
+
+        const unsigned checksum = super::facade->GetCheckSum();
+        const std::size_t number_of_nodes = super::facade->GetNumberOfNodes();
+        if (!sweep_order || sweep_order_checksum != checksum ||
+            sweep_order_number_of_nodes != number_of_nodes)
+        {
+            sweep_order = ComputeSweepOrder();
+            sweep_order_checksum = checksum;
+            sweep_order_number_of_nodes = number_of_nodes;
+        }
+        return sweep_order;
+    }
+
+    // Every edge of the contracted graph is stored at its lower ranked node and points upwards,
+    // so a post-order of a depth first search along the stored edges visits every node after
+    // all nodes above it. We use that instead of the node levels since those are not loaded by
+    // the data facades. Core nodes are not contracted and are settled by the upward search.
+    std::shared_ptr<const SweepOrder> ComputeSweepOrder() const
+    {
+        const auto &graph = super::facade->GetSearchGraph();
+        const std::size_t number_of_nodes = super::facade->GetNumberOfNodes();
+
+        auto order = std::make_shared<SweepOrder>();
+        order->reserve(number_of_nodes);
+
+        std::vector<bool> visited(number_of_nodes, false);
+        std::vector<std::pair<NodeID, EdgeID>> stack;
+
+        const auto core_markers = super::facade->GetCoreMarkers();
+        const auto is_core_node = [&core_markers](const NodeID node) {
+            return !core_markers.Empty() && core_markers.Test(node);
+        };
+
+        for (const auto root : util::irange<NodeID>(0, number_of_nodes))
+        {
+            if (visited[root] || is_core_node(root))
+            {
+                continue;
+            }
+
+            visited[root] = true;
+            stack.emplace_back(root, graph.BeginEdges(root));
+            while (!stack.empty())
+            {
+                auto &top = stack.back();
+                if (top.second == graph.EndEdges(top.first))
+                {
+                    order->push_back(top.first);
+                    stack.pop_back();
+                    continue;
+                }
+
+                const NodeID to = graph.GetTarget(top.second++);
+                if (!visited[to] && !is_core_node(to))
+                {
+                    visited[to] = true;
+                    stack.emplace_back(to, graph.BeginEdges(to));
+                }
+            }
+        }
+
+        return order;
+    }
+
+    // Plain Dijkstra on the upward graph and the core. Without stall-on-demand the labels of
+    // pruned nodes stay valid upper bounds which the sweep can still improve on. Nodes further
+    // than max_duration stay unreached, the sweep can only add to their durations.
+    void UpwardSearch(const PhantomNode &source,
+                      const EdgeWeight max_duration,
+                      const std::size_t labels_per_node,
+                      const std::size_t label_idx,
+                      std::vector<EdgeWeight> &labels) const
+    {
+        const auto &graph = super::facade->GetSearchGraph();
+        engine_working_data.InitializeOrClearFirstHeaps(super::facade->GetNumberOfNodes());
+        QueryHeap &query_heap = *engine_working_data.GetHeaps().forward_heap_1;
+
+        if (source.forward_segment_id.enabled)
+        {
+            query_heap.Insert(source.forward_segment_id.id,
+                              -source.GetForwardWeightPlusOffset(),
+                              source.forward_segment_id.id);
+        }
+        if (source.reverse_segment_id.enabled)
+        {
+            query_heap.Insert(source.reverse_segment_id.id,
+                              -source.GetReverseWeightPlusOffset(),
+                              source.reverse_segment_id.id);
+        }
+
+        while (!query_heap.Empty())
+        {
+            SearchEngineData::PollQueryControl();
+            const NodeID node = query_heap.DeleteMin();
+            const EdgeWeight distance = query_heap.GetKey(node);
+            if (distance > max_duration)
+            {
+                break;
+            }
+            labels[node * labels_per_node + label_idx] = distance;
+
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                const auto &data = graph.GetSearchData(edge);
+                if (!data.forward)
+                {
+                    continue;
+                }
+
+                const NodeID to = data.target;
+                const EdgeWeight to_distance = distance + data.distance;
+                BOOST_ASSERT_MSG(data.distance > 0, "edge distance invalid");
+
+                if (!query_heap.WasInserted(to))
+                {
+                    query_heap.Insert(to, to_distance, node);
+                }
+                else if (to_distance < query_heap.GetKey(to))
+                {
+                    query_heap.GetData(to).parent = node;
+                    query_heap.DecreaseKey(to, to_distance);
+                }
+            }
+        }
+    }
+
+    void Sweep(const SweepOrder &order, std::vector<EdgeWeight> &block_labels) const
+    {
+        const auto &graph = super::facade->GetSearchGraph();
+        for (const NodeID node : order)
+        {
+            EdgeWeight *labels = &block_labels[node * SOURCE_BLOCK_SIZE];
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                const auto &data = graph.GetSearchData(edge);
+                // backward edges at a node are the ones that lead into it from above
+                if (!data.backward)
+                {
+                    continue;
+                }
+
+                const EdgeWeight *from_labels = &block_labels[data.target * SOURCE_BLOCK_SIZE];
+                const EdgeWeight weight = data.distance;
+                for (std::size_t i = 0; i < SOURCE_BLOCK_SIZE; ++i)
+                {
+                    labels[i] = std::min(labels[i], from_labels[i] + weight);
+                }
+            }
+        }
+    }
+};
+
+template <class DataFacadeT> constexpr EdgeWeight OneToAllRouting<DataFacadeT>::UNREACHED;
+template <class DataFacadeT> constexpr std::size_t OneToAllRouting<DataFacadeT>::SOURCE_BLOCK_SIZE;
+}
+}
+}
+
+#endif // ONE_TO_ALL_ROUTING_HPP
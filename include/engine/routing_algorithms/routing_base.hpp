@@ -1,21 +1,34 @@
 #ifndef ROUTING_BASE_HPP
 #define ROUTING_BASE_HPP
 
+#include "contractor/query_graph.hpp"
 #include "extractor/guidance/turn_instruction.hpp"
 #include "engine/internal_route_result.hpp"
 #include "engine/search_engine_data.hpp"
+#include "engine/traffic_overlay.hpp"
+#include "engine/unpacking_cache.hpp"
+#include "partition/cell_storage.hpp"
 #include "util/coordinate_calculation.hpp"
+#include "util/integer_range.hpp"
+#include "util/query_metrics.hpp"
+#include "util/tracepoint.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/assert.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <cstddef>
 #include <cstdint>
 
 #include <algorithm>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <numeric>
 #include <stack>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -27,18 +40,82 @@ namespace engine
 namespace routing_algorithms
 {
 
+// How the upward searches of a CH query prune nodes that were reached on a suboptimal path.
+// A node can be skipped if a node in the same heap reaches it cheaper via a downward edge:
+// its key is not its distance in the full graph, so no shortest path leaves it upwards.
+enum class StallingMode
+{
+    // relax the edges of every settled node
+    Disabled,
+    // check the downward edges of a node when it is settled
+    OnSettle,
+    // like OnSettle, but also stall the nodes in the heap that the stalled node reaches
+    // cheaper than their current key, so they are skipped without scanning their edges
+    OnDemand
+};
+
+// The fields of the path data that UnpackPath looks up, responses without steps don't need the
+// guidance data of the path.
+enum class PathUnpackMode
+{
+    // the nodes and durations of the path
+    Weights,
+    // also the datasources and zoom levels of the nodes for annotations and overviews
+    Geometry,
+    // also the names, turn instructions, lanes, travel modes and entry classes for guidance
+    Full
+};
+
 template <class DataFacadeT, class Derived> class BasicRoutingInterface
 {
   private:
     using EdgeData = typename DataFacadeT::EdgeData;
+    // node, key and parent of a node in a heap
+    using HeapEntry = std::tuple<NodeID, EdgeWeight, NodeID>;
+    // node, weight and parent of a node where a search enters the core
+    using CoreEntryPoint = HeapEntry;
+    // how many chunks UnpackPath splits a packed path into at most when it unpacks in parallel
+    static const constexpr std::size_t MAX_UNPACKING_CHUNKS = 64;
+    // the uncompressed geometry of the edge UnpackPath currently expands
+    struct UnpackingScratch
+    {
+        std::vector<NodeID> id_vector;
+        std::vector<EdgeWeight> weight_vector;
+        std::vector<DatasourceID> datasource_vector;
+        std::vector<std::uint8_t> zoom_level_vector;
+        std::vector<SegmentLength> length_vector;
+    };
 
   protected:
+    // how often Search, or a table, runs with a traffic overlay at most
+    static const constexpr unsigned MAX_TRAFFIC_SEARCHES = 8;
+
     DataFacadeT *facade;
+    // optional, shared by the routing algorithms of all plugins
+    UnpackingCache *unpacking_cache;
+    // used by the upward searches of Search and SearchWithCore
+    StallingMode stalling_mode;
+    // UnpackPath expands packed paths of the contraction hierarchy with at least that many edges
+    // in parallel, 0 for never
+    std::size_t parallel_unpacking_length;
 
   public:
-    explicit BasicRoutingInterface(DataFacadeT *facade) : facade(facade) {}
+    explicit BasicRoutingInterface(DataFacadeT *facade, UnpackingCache *unpacking_cache = nullptr)
+        : facade(facade), unpacking_cache(unpacking_cache), stalling_mode(StallingMode::OnSettle),
+          parallel_unpacking_length(0)
+    {
+    }
     ~BasicRoutingInterface() {}
 
+    StallingMode GetStallingMode() const { return stalling_mode; }
+    void SetStallingMode(const StallingMode mode) { stalling_mode = mode; }
+
+    std::size_t GetParallelUnpackingLength() const { return parallel_unpacking_length; }
+    void SetParallelUnpackingLength(const std::size_t length)
+    {
+        parallel_unpacking_length = length;
+    }
+
     BasicRoutingInterface(const BasicRoutingInterface &) = delete;
     BasicRoutingInterface &operator=(const BasicRoutingInterface &) = delete;
 
@@ -70,9 +147,13 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
     (d, z) with weight 100, (c, z) with weight 0 corresponding.
     Since we are dealing with a graph that contains _negative_ edges,
     we need to add an offset to the termination criterion.
+
+    HeapT can be any heap implementing the util::BinaryHeap interface. Stalling on demand
+    requires HeapT::DataType to have a stalled flag like HeapData.
     */
-    void RoutingStep(SearchEngineData::QueryHeap &forward_heap,
-                     SearchEngineData::QueryHeap &reverse_heap,
+    template <typename HeapT>
+    void RoutingStep(HeapT &forward_heap,
+                     HeapT &reverse_heap,
                      NodeID &middle_node_id,
                      std::int32_t &upper_bound,
                      std::int32_t min_edge_offset,
@@ -81,9 +162,219 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                      const bool force_loop_forward,
                      const bool force_loop_reverse) const
     {
+        RoutingStep(forward_heap,
+                    reverse_heap,
+                    middle_node_id,
+                    upper_bound,
+                    min_edge_offset,
+                    forward_direction,
+                    stalling ? StallingMode::OnSettle : StallingMode::Disabled,
+                    force_loop_forward,
+                    force_loop_reverse);
+    }
+
+    template <typename HeapT>
+    void RoutingStep(HeapT &forward_heap,
+                     HeapT &reverse_heap,
+                     NodeID &middle_node_id,
+                     std::int32_t &upper_bound,
+                     std::int32_t min_edge_offset,
+                     const bool forward_direction,
+                     const StallingMode stalling,
+                     const bool force_loop_forward,
+                     const bool force_loop_reverse) const
+    {
+        // fetched once per step, the loops over the edges below are inlined
+        const auto &graph = facade->GetSearchGraph();
+        SearchEngineData::PollQueryControl();
         const NodeID node = forward_heap.DeleteMin();
+        // the edges of the node settled next load while this one is processed
+        if (graph.IsPrefetching() && !forward_heap.Empty())
+        {
+            graph.PrefetchEdges(forward_heap.Min());
+        }
         const std::int32_t distance = forward_heap.GetKey(node);
+        SearchStatistics *const statistics = SearchEngineData::GetStatistics();
+        if (statistics)
+        {
+            ++statistics->settled_nodes;
+        }
+        const TrafficOverlay *const overlay = SearchEngineData::GetTrafficOverlay();
+
+        UpdateMiddle(forward_heap,
+                     reverse_heap,
+                     node,
+                     distance,
+                     forward_direction,
+                     force_loop_forward,
+                     force_loop_reverse,
+                     middle_node_id,
+                     upper_bound);
+
+        // make sure we don't terminate too early if we initialize the distance
+        // for the nodes in the forward heap with the forward/reverse offset
+        BOOST_ASSERT(min_edge_offset <= 0);
+        if (distance + min_edge_offset > upper_bound)
+        {
+            forward_heap.DeleteAll();
+            return;
+        }
+
+        // stalling and relaxing look up every target in the heap
+        if (graph.IsPrefetching())
+        {
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                forward_heap.Prefetch(graph.GetTarget(edge));
+            }
+        }
+
+        // Stalling
+        if (stalling == StallingMode::OnDemand && forward_heap.GetData(node).stalled)
+        {
+            if (statistics)
+            {
+                ++statistics->stalled_nodes;
+            }
+            return;
+        }
+        if (stalling != StallingMode::Disabled)
+        {
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                const auto &data = graph.GetSearchData(edge);
+                const bool reverse_flag = ((!forward_direction) ? data.forward : data.backward);
+                if (reverse_flag)
+                {
+                    const NodeID to = data.target;
+                    EdgeWeight edge_weight = data.distance;
+
+                    BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
+                    if (overlay)
+                    {
+                        edge_weight =
+                            GetTrafficWeight(*overlay, node, to, !forward_direction, edge_weight);
+                        if (edge_weight == INVALID_EDGE_WEIGHT)
+                        {
+                            continue;
+                        }
+                    }
+
+                    if (forward_heap.WasInserted(to))
+                    {
+                        const std::int32_t stall_distance = forward_heap.GetKey(to) + edge_weight;
+                        if (stall_distance < distance)
+                        {
+                            if (stalling == StallingMode::OnDemand)
+                            {
+                                StallOnDemand(
+                                    forward_heap, node, stall_distance, forward_direction);
+                            }
+                            if (statistics)
+                            {
+                                ++statistics->stalled_nodes;
+                            }
+                            return;
+                        }
+                    }
+                }
+            }
+        }
+
+        std::uint64_t relaxed_edges = 0;
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            const auto &data = graph.GetSearchData(edge);
+            bool forward_directionFlag = (forward_direction ? data.forward : data.backward);
+            if (forward_directionFlag)
+            {
+                ++relaxed_edges;
+
+                const NodeID to = data.target;
+                EdgeWeight edge_weight = data.distance;
+
+                BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
+                if (overlay)
+                {
+                    edge_weight =
+                        GetTrafficWeight(*overlay, node, to, forward_direction, edge_weight);
+                    if (edge_weight == INVALID_EDGE_WEIGHT)
+                    {
+                        continue;
+                    }
+                }
+                const int to_distance = distance + edge_weight;
 
+                // New Node discovered -> Add to Heap + Node Info Storage
+                if (!forward_heap.WasInserted(to))
+                {
+                    forward_heap.Insert(to, to_distance, node);
+                    if (graph.IsPrefetching())
+                    {
+                        graph.PrefetchNode(to);
+                    }
+                }
+                // Found a shorter Path -> Update distance
+                else if (to_distance < forward_heap.GetKey(to))
+                {
+                    // new parent
+                    forward_heap.GetData(to).parent = node;
+                    if (stalling == StallingMode::OnDemand)
+                    {
+                        forward_heap.GetData(to).stalled = false;
+                    }
+                    forward_heap.DecreaseKey(to, to_distance);
+                    if (graph.IsPrefetching())
+                    {
+                        graph.PrefetchNode(to);
+                    }
+                }
+            }
+        }
+        if (statistics)
+        {
+            statistics->relaxed_edges += relaxed_edges;
+        }
+    }
+
+    // Updates the shortest path found so far if the node that was just settled with the
+    // given distance was also reached by the opposite search.
+    template <typename HeapT>
+    void UpdateMiddle(HeapT &forward_heap,
+                      HeapT &reverse_heap,
+                      const NodeID node,
+                      const std::int32_t distance,
+                      const bool forward_direction,
+                      const bool force_loop_forward,
+                      const bool force_loop_reverse,
+                      NodeID &middle_node_id,
+                      std::int32_t &upper_bound) const
+    {
+        UpdateMiddle(facade->GetSearchGraph(),
+                     forward_heap,
+                     reverse_heap,
+                     node,
+                     distance,
+                     forward_direction,
+                     force_loop_forward,
+                     force_loop_reverse,
+                     middle_node_id,
+                     upper_bound);
+    }
+
+    // Loops are looked up in the graph the search runs on
+    template <typename GraphT, typename HeapT>
+    void UpdateMiddle(const GraphT &graph,
+                      HeapT &forward_heap,
+                      HeapT &reverse_heap,
+                      const NodeID node,
+                      const std::int32_t distance,
+                      const bool forward_direction,
+                      const bool force_loop_forward,
+                      const bool force_loop_reverse,
+                      NodeID &middle_node_id,
+                      std::int32_t &upper_bound) const
+    {
         if (reverse_heap.WasInserted(node))
         {
             const std::int32_t new_distance = reverse_heap.GetKey(node) + distance;
@@ -97,14 +388,14 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                     new_distance < 0)
                 {
                     // check whether there is a loop present at the node
-                    for (const auto edge : facade->GetAdjacentEdgeRange(node))
+                    for (const auto edge : graph.GetAdjacentEdgeRange(node))
                     {
-                        const EdgeData &data = facade->GetEdgeData(edge);
+                        const auto &data = graph.GetSearchData(edge);
                         bool forward_directionFlag =
                             (forward_direction ? data.forward : data.backward);
                         if (forward_directionFlag)
                         {
-                            const NodeID to = facade->GetTarget(edge);
+                            const NodeID to = data.target;
                             if (to == node)
                             {
                                 const EdgeWeight edge_weight = data.distance;
@@ -127,79 +418,79 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                 }
             }
         }
+    }
 
-        // make sure we don't terminate too early if we initialize the distance
-        // for the nodes in the forward heap with the forward/reverse offset
-        BOOST_ASSERT(min_edge_offset <= 0);
-        if (distance + min_edge_offset > upper_bound)
-        {
-            forward_heap.DeleteAll();
-            return;
-        }
+    // Marks all nodes in the heap as stalled that can be reached from the stalled node on a
+    // path shorter than their key. The stall distances are spread breadth first along the edges
+    // of the search direction, as long as they keep beating the keys in the heap. Stalled nodes
+    // are reset when they get a smaller key from a node that is not stalled.
+    template <typename HeapT>
+    void StallOnDemand(HeapT &heap,
+                       const NodeID stalled_node,
+                       const std::int32_t stall_distance,
+                       const bool forward_direction) const
+    {
+        const auto &graph = facade->GetSearchGraph();
+        const TrafficOverlay *const overlay = SearchEngineData::GetTrafficOverlay();
+        auto &stall_queue = SearchEngineData::GetHeaps().stall_queue;
+        stall_queue.clear();
+        stall_queue.emplace_back(stalled_node, stall_distance);
 
-        // Stalling
-        if (stalling)
+        for (std::size_t index = 0; index < stall_queue.size(); ++index)
         {
-            for (const auto edge : facade->GetAdjacentEdgeRange(node))
+            const NodeID node = stall_queue[index].first;
+            const std::int32_t distance = stall_queue[index].second;
+
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
             {
-                const EdgeData &data = facade->GetEdgeData(edge);
-                const bool reverse_flag = ((!forward_direction) ? data.forward : data.backward);
-                if (reverse_flag)
+                const auto &data = graph.GetSearchData(edge);
+                const bool forward_directionFlag =
+                    (forward_direction ? data.forward : data.backward);
+                if (!forward_directionFlag)
                 {
-                    const NodeID to = facade->GetTarget(edge);
-                    const EdgeWeight edge_weight = data.distance;
+                    continue;
+                }
 
-                    BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
+                const NodeID to = data.target;
+                if (!heap.WasInserted(to) || heap.WasRemoved(to) || heap.GetData(to).stalled)
+                {
+                    continue;
+                }
 
-                    if (forward_heap.WasInserted(to))
+                EdgeWeight edge_weight = data.distance;
+                if (overlay)
+                {
+                    edge_weight =
+                        GetTrafficWeight(*overlay, node, to, forward_direction, edge_weight);
+                    if (edge_weight == INVALID_EDGE_WEIGHT)
                     {
-                        if (forward_heap.GetKey(to) + edge_weight < distance)
-                        {
-                            return;
-                        }
+                        continue;
                     }
                 }
-            }
-        }
-
-        for (const auto edge : facade->GetAdjacentEdgeRange(node))
-        {
-            const EdgeData &data = facade->GetEdgeData(edge);
-            bool forward_directionFlag = (forward_direction ? data.forward : data.backward);
-            if (forward_directionFlag)
-            {
-
-                const NodeID to = facade->GetTarget(edge);
-                const EdgeWeight edge_weight = data.distance;
-
-                BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
-                const int to_distance = distance + edge_weight;
-
-                // New Node discovered -> Add to Heap + Node Info Storage
-                if (!forward_heap.WasInserted(to))
+                const std::int32_t to_distance = distance + edge_weight;
+                if (to_distance < heap.GetKey(to))
                 {
-                    forward_heap.Insert(to, to_distance, node);
-                }
-                // Found a shorter Path -> Update distance
-                else if (to_distance < forward_heap.GetKey(to))
-                {
-                    // new parent
-                    forward_heap.GetData(to).parent = node;
-                    forward_heap.DecreaseKey(to, to_distance);
+                    heap.GetData(to).stalled = true;
+                    stall_queue.emplace_back(to, to_distance);
                 }
             }
         }
     }
 
     inline EdgeWeight GetLoopWeight(NodeID node) const
+    {
+        return GetLoopWeight(facade->GetSearchGraph(), node);
+    }
+
+    template <typename GraphT> EdgeWeight GetLoopWeight(const GraphT &graph, NodeID node) const
     {
         EdgeWeight loop_weight = INVALID_EDGE_WEIGHT;
-        for (auto edge : facade->GetAdjacentEdgeRange(node))
+        for (auto edge : graph.GetAdjacentEdgeRange(node))
         {
-            const auto &data = facade->GetEdgeData(edge);
+            const auto &data = graph.GetSearchData(edge);
             if (data.forward)
             {
-                const NodeID to = facade->GetTarget(edge);
+                const NodeID to = data.target;
                 if (to == node)
                 {
                     loop_weight = std::min(loop_weight, data.distance);
@@ -209,27 +500,97 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         return loop_weight;
     }
 
+    // The weight of an edge of the search graph with the penalties of the traffic overlay: the
+    // penalty of the node the edge leaves and the penalties hidden inside of it that the
+    // search found so far. The edge leads from node to to in travel direction if leaves_node is
+    // set, from to to node otherwise. INVALID_EDGE_WEIGHT if the overlay closes it.
+    EdgeWeight GetTrafficWeight(const TrafficOverlay &overlay,
+                                const NodeID node,
+                                const NodeID to,
+                                const bool leaves_node,
+                                const EdgeWeight weight) const
+    {
+        const NodeID from = leaves_node ? node : to;
+        const EdgeWeight penalty = overlay.GetPenalty(from);
+        if (penalty == TrafficOverlay::CLOSED)
+        {
+            return INVALID_EDGE_WEIGHT;
+        }
+        EdgeWeight hidden_penalty = 0;
+        if (const HiddenTrafficPenalties *const hidden =
+                SearchEngineData::GetHiddenTrafficPenalties())
+        {
+            hidden_penalty = leaves_node ? hidden->Get(node, to) : hidden->Get(to, node);
+            if (hidden_penalty == TrafficOverlay::CLOSED)
+            {
+                return INVALID_EDGE_WEIGHT;
+            }
+        }
+        return weight + penalty + hidden_penalty;
+    }
+
+    // The penalty of the traffic overlay of the segment a route ends on. The searches only
+    // penalize the nodes their edges leave, so it is added to the weight of a route after its
+    // search, which leaves out the nodes of its target that the overlay closes. 0 without an
+    // overlay, INVALID_EDGE_WEIGHT if the overlay closes the segment.
+    EdgeWeight GetArrivalTrafficPenalty(const NodeID node) const
+    {
+        const TrafficOverlay *const overlay = SearchEngineData::GetTrafficOverlay();
+        if (!overlay)
+        {
+            return 0;
+        }
+        const EdgeWeight penalty = overlay->GetPenalty(node);
+        return penalty == TrafficOverlay::CLOSED ? INVALID_EDGE_WEIGHT : penalty;
+    }
+
+    // Adds the arrival penalty to the weight of a route that arrives at the last node of its
+    // packed path
+    void AddArrivalTrafficPenalty(const std::vector<NodeID> &packed_path,
+                                  std::int32_t &weight) const
+    {
+        if (weight != INVALID_EDGE_WEIGHT)
+        {
+            BOOST_ASSERT(!packed_path.empty());
+            const EdgeWeight penalty = GetArrivalTrafficPenalty(packed_path.back());
+            BOOST_ASSERT(penalty != INVALID_EDGE_WEIGHT);
+            weight += penalty;
+        }
+    }
+
+    // Adds the arrival penalty to the duration of the unpacked path of the last leg of a route.
+    // A leg that doesn't leave the segment of its source has no path data, its duration is
+    // taken from the offsets of the phantom nodes alone.
+    void AddArrivalTrafficPenalty(const NodeID node, PathDataVector &unpacked_path) const
+    {
+        const EdgeWeight penalty = GetArrivalTrafficPenalty(node);
+        if (penalty != INVALID_EDGE_WEIGHT && !unpacked_path.empty())
+        {
+            unpacked_path.back().duration_until_turn += penalty;
+        }
+    }
+
+    // Expands a packed path into the segments of its original edges. Packed paths of the
+    // contraction hierarchy with at least parallel_unpacking_length edges are expanded in
+    // chunks on all cores.
     template <typename RandomIter>
     void UnpackPath(RandomIter packed_path_begin,
                     RandomIter packed_path_end,
                     const PhantomNodes &phantom_node_pair,
-                    std::vector<PathData> &unpacked_path) const
+                    PathDataVector &unpacked_path,
+                    const PathUnpackMode mode = PathUnpackMode::Full) const
     {
+        const auto &graph = facade->GetSearchGraph();
+        const util::QueryMetrics::ScopedPhase unpacking(util::QueryMetrics::Phase::Unpacking);
         BOOST_ASSERT(std::distance(packed_path_begin, packed_path_end) > 0);
+        SearchStatistics *const statistics = SearchEngineData::GetStatistics();
 
         const bool start_traversed_in_reverse =
             (*packed_path_begin != phantom_node_pair.source_phantom.forward_segment_id.id);
         const bool target_traversed_in_reverse =
             (*std::prev(packed_path_end) != phantom_node_pair.target_phantom.forward_segment_id.id);
 
-        std::stack<std::pair<NodeID, NodeID>> recursion_stack;
-
-        // We have to push the path in reverse order onto the stack because it's LIFO.
-        for (auto current = std::prev(packed_path_end); current != packed_path_begin;
-             current = std::prev(current))
-        {
-            recursion_stack.emplace(*std::prev(current), *current);
-        }
+        const bool is_multi_level_path = facade->HasMultiLevelData();
 
         BOOST_ASSERT(*packed_path_begin == phantom_node_pair.source_phantom.forward_segment_id.id ||
                      *packed_path_begin == phantom_node_pair.source_phantom.reverse_segment_id.id);
@@ -237,135 +598,259 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             *std::prev(packed_path_end) == phantom_node_pair.target_phantom.forward_segment_id.id ||
             *std::prev(packed_path_end) == phantom_node_pair.target_phantom.reverse_segment_id.id);
 
-        std::pair<NodeID, NodeID> edge;
-        while (!recursion_stack.empty())
-        {
-            // edge.first         edge.second
-            //     *------------------>*
-            //            edge_id
-            edge = recursion_stack.top();
-            recursion_stack.pop();
+        // Reused by the edges of all paths a thread unpacks. Being thread_local it isn't captured
+        // by the lambdas below, each thread that unpacks a chunk of the path uses its own.
+        thread_local UnpackingScratch scratch;
+        const bool needs_guidance = mode == PathUnpackMode::Full;
+        const bool needs_annotations = mode != PathUnpackMode::Weights;
+        // the durations include the penalties that the search added to the weights
+        const TrafficOverlay *const overlay = SearchEngineData::GetTrafficOverlay();
+
+        // the fields a response doesn't need are left empty
+        const auto get_uncompressed_data = [&](const EdgeID geometry_index) {
+            facade->GetUncompressedGeometry(geometry_index, scratch.id_vector);
+            facade->GetUncompressedWeights(geometry_index, scratch.weight_vector);
+            if (needs_annotations)
+            {
+                facade->GetUncompressedDatasources(geometry_index, scratch.datasource_vector);
+                facade->GetUncompressedZoomLevels(geometry_index, scratch.zoom_level_vector);
+                facade->GetUncompressedLengths(geometry_index, scratch.length_vector);
+            }
+            else
+            {
+                scratch.datasource_vector.assign(scratch.id_vector.size(), 0);
+                scratch.zoom_level_vector.assign(scratch.id_vector.size(), 0);
+                scratch.length_vector.assign(scratch.id_vector.size(), INVALID_SEGMENT_LENGTH);
+            }
+        };
 
-            // Contraction might introduce double edges by inserting shortcuts
-            // this searching for the smallest upwards edge found by the forward search
-            EdgeID smaller_edge_id = SPECIAL_EDGEID;
-            EdgeWeight edge_weight = std::numeric_limits<EdgeWeight>::max();
-            for (const auto edge_id : facade->GetAdjacentEdgeRange(edge.first))
+        // Appends the segments of an original edge to path, which is the unpacked path or the
+        // buffer of a chunk of it. Only the first segment of the unpacked path starts at the
+        // source phantom.
+        const auto unpack_original_edge = [&](PathDataVector &path,
+                                              const NodeID from,
+                                              const EdgeData &ed) {
+            BOOST_ASSERT_MSG(!ed.shortcut, "original edge flagged as shortcut");
+            const auto &id_vector = scratch.id_vector;
+            const auto &weight_vector = scratch.weight_vector;
+            const bool is_first_segment = &path == &unpacked_path && path.empty();
+            const unsigned name_index =
+                needs_guidance ? facade->GetNameIndexFromEdgeID(ed.id) : EMPTY_NAMEID;
+            const extractor::TravelMode travel_mode =
+                (is_first_segment && start_traversed_in_reverse)
+                    ? phantom_node_pair.source_phantom.backward_travel_mode
+                    : (needs_guidance ? facade->GetTravelModeForEdgeID(ed.id)
+                                      : TRAVEL_MODE_INACCESSIBLE);
+
+            get_uncompressed_data(facade->GetGeometryIndexForEdgeID(ed.id));
+            BOOST_ASSERT(id_vector.size() > 0);
+            BOOST_ASSERT(weight_vector.size() > 0);
+
+            auto total_weight = std::accumulate(weight_vector.begin(), weight_vector.end(), 0);
+
+            BOOST_ASSERT(weight_vector.size() == id_vector.size());
+
+            const std::size_t start_index =
+                (is_first_segment
+                     ? ((start_traversed_in_reverse)
+                            ? id_vector.size() -
+                                  phantom_node_pair.source_phantom.fwd_segment_position - 1
+                            : phantom_node_pair.source_phantom.fwd_segment_position)
+                     : 0);
+            const std::size_t end_index = id_vector.size();
+
+            BOOST_ASSERT(start_index < end_index);
+            for (std::size_t i = start_index; i < end_index; ++i)
+            {
+                path.push_back(PathData{id_vector[i],
+                                        name_index,
+                                        weight_vector[i],
+                                        extractor::guidance::TurnInstruction::NO_TURN(),
+                                        {{0, INVALID_LANEID}, INVALID_LANE_DESCRIPTIONID},
+                                        travel_mode,
+                                        INVALID_ENTRY_CLASSID,
+                                        scratch.datasource_vector[i],
+                                        scratch.zoom_level_vector[i],
+                                        scratch.length_vector[i]});
+            }
+            BOOST_ASSERT(path.size() > 0);
+            if (needs_guidance)
             {
-                const EdgeWeight weight = facade->GetEdgeData(edge_id).distance;
-                if ((facade->GetTarget(edge_id) == edge.second) && (weight < edge_weight) &&
-                    facade->GetEdgeData(edge_id).forward)
+                if (facade->hasLaneData(ed.id))
+                    path.back().lane_data = facade->GetLaneData(ed.id);
+
+                path.back().entry_classid = facade->GetEntryClassID(ed.id);
+                path.back().turn_instruction = facade->GetTurnInstructionForEdgeID(ed.id);
+            }
+            path.back().duration_until_turn += (ed.distance - total_weight);
+            if (overlay)
+            {
+                const EdgeWeight penalty = overlay->GetPenalty(from);
+                if (penalty != TrafficOverlay::CLOSED)
                 {
-                    smaller_edge_id = edge_id;
-                    edge_weight = weight;
+                    path.back().duration_until_turn += penalty;
                 }
             }
+        };
+
+        // Expands the packed edges between the nodes from first to last of a packed path of the
+        // contraction hierarchy into path
+        const auto unpack_packed_edges = [&](RandomIter first, RandomIter last,
+                                             PathDataVector &path) {
+            SearchStatistics *const statistics = SearchEngineData::GetStatistics();
+            std::stack<std::pair<NodeID, NodeID>> recursion_stack;
+
+            // We have to push the path in reverse order onto the stack because it's LIFO.
+            for (auto current = last; current != first; current = std::prev(current))
+            {
+                recursion_stack.emplace(*std::prev(current), *current);
+            }
 
-            // edge.first         edge.second
-            //     *<------------------*
-            //            edge_id
-            // if we don't find a forward edge, this edge must have been an downwards edge
-            // found by the reverse search.
-            if (SPECIAL_EDGEID == smaller_edge_id)
+            std::pair<NodeID, NodeID> edge;
+            while (!recursion_stack.empty())
             {
-                for (const auto edge_id : facade->GetAdjacentEdgeRange(edge.second))
+                // edge.first         edge.second
+                //     *------------------>*
+                //            edge_id
+                edge = recursion_stack.top();
+                recursion_stack.pop();
+
+                // Contraction might introduce double edges by inserting shortcuts
+                // this searching for the smallest upwards edge found by the forward search
+                EdgeID smaller_edge_id = SPECIAL_EDGEID;
+                EdgeWeight edge_weight = std::numeric_limits<EdgeWeight>::max();
+                for (const auto edge_id : graph.GetAdjacentEdgeRange(edge.first))
                 {
-                    const EdgeWeight weight = facade->GetEdgeData(edge_id).distance;
-                    if ((facade->GetTarget(edge_id) == edge.first) && (weight < edge_weight) &&
-                        facade->GetEdgeData(edge_id).backward)
+                    const auto &data = graph.GetSearchData(edge_id);
+                    if (data.target == edge.second && data.distance < edge_weight && data.forward)
                     {
                         smaller_edge_id = edge_id;
-                        edge_weight = weight;
+                        edge_weight = data.distance;
+                    }
+                }
+
+                // edge.first         edge.second
+                //     *<------------------*
+                //            edge_id
+                // if we don't find a forward edge, this edge must have been an downwards edge
+                // found by the reverse search.
+                if (SPECIAL_EDGEID == smaller_edge_id)
+                {
+                    for (const auto edge_id : graph.GetAdjacentEdgeRange(edge.second))
+                    {
+                        const auto &data = graph.GetSearchData(edge_id);
+                        if (data.target == edge.first && data.distance < edge_weight &&
+                            data.backward)
+                        {
+                            smaller_edge_id = edge_id;
+                            edge_weight = data.distance;
+                        }
                     }
                 }
+                BOOST_ASSERT_MSG(edge_weight != INVALID_EDGE_WEIGHT, "edge id invalid");
+
+                const EdgeData &ed = facade->GetEdgeData(smaller_edge_id);
+
+                if (ed.shortcut && statistics)
+                {
+                    ++statistics->unpacked_shortcuts;
+                }
+                // cached expansions lack the nodes that the penalties of the overlay belong to
+                if (ed.shortcut && unpacking_cache && !overlay)
+                {
+                    for (const auto original_edge :
+                         *GetShortcutExpansion(smaller_edge_id, edge.first, edge.second))
+                    {
+                        unpack_original_edge(
+                            path, SPECIAL_NODEID, facade->GetEdgeData(original_edge));
+                    }
+                }
+                else if (ed.shortcut)
+                { // unpack
+                    const NodeID middle_node_id = ed.id;
+                    // again, we need to this in reversed order
+                    recursion_stack.emplace(middle_node_id, edge.second);
+                    recursion_stack.emplace(edge.first, middle_node_id);
+                }
+                else
+                {
+                    unpack_original_edge(path, edge.first, ed);
+                }
             }
-            BOOST_ASSERT_MSG(edge_weight != INVALID_EDGE_WEIGHT, "edge id invalid");
+        };
 
-            const EdgeData &ed = facade->GetEdgeData(smaller_edge_id);
-            if (ed.shortcut)
-            { // unpack
-                const NodeID middle_node_id = ed.id;
-                // again, we need to this in reversed order
-                recursion_stack.emplace(middle_node_id, edge.second);
-                recursion_stack.emplace(edge.first, middle_node_id);
+        const std::size_t number_of_packed_edges =
+            std::distance(packed_path_begin, packed_path_end) - 1;
+        // Paths of the multi-level Dijkstra have no shortcuts and are expanded further down.
+        if (is_multi_level_path)
+        {
+            std::vector<std::pair<NodeID, EdgeID>> original_edges;
+            for (auto current = packed_path_begin; std::next(current) != packed_path_end;
+                 ++current)
+            {
+                UnpackMultiLevelEdge(*current, *std::next(current), original_edges);
             }
-            else
+            for (const auto &original_edge : original_edges)
             {
-                BOOST_ASSERT_MSG(!ed.shortcut, "original edge flagged as shortcut");
-                unsigned name_index = facade->GetNameIndexFromEdgeID(ed.id);
-                const auto turn_instruction = facade->GetTurnInstructionForEdgeID(ed.id);
-                const extractor::TravelMode travel_mode =
-                    (unpacked_path.empty() && start_traversed_in_reverse)
-                        ? phantom_node_pair.source_phantom.backward_travel_mode
-                        : facade->GetTravelModeForEdgeID(ed.id);
-
-                const auto geometry_index = facade->GetGeometryIndexForEdgeID(ed.id);
-                std::vector<NodeID> id_vector;
-                facade->GetUncompressedGeometry(geometry_index, id_vector);
-                BOOST_ASSERT(id_vector.size() > 0);
-
-                std::vector<EdgeWeight> weight_vector;
-                facade->GetUncompressedWeights(geometry_index, weight_vector);
-                BOOST_ASSERT(weight_vector.size() > 0);
-
-                std::vector<DatasourceID> datasource_vector;
-                facade->GetUncompressedDatasources(geometry_index, datasource_vector);
-
-                auto total_weight = std::accumulate(weight_vector.begin(), weight_vector.end(), 0);
-
-                BOOST_ASSERT(weight_vector.size() == id_vector.size());
-                const bool is_first_segment = unpacked_path.empty();
-
-                const std::size_t start_index =
-                    (is_first_segment
-                         ? ((start_traversed_in_reverse)
-                                ? id_vector.size() -
-                                      phantom_node_pair.source_phantom.fwd_segment_position - 1
-                                : phantom_node_pair.source_phantom.fwd_segment_position)
-                         : 0);
-                const std::size_t end_index = id_vector.size();
-
-                BOOST_ASSERT(start_index >= 0);
-                BOOST_ASSERT(start_index < end_index);
-                for (std::size_t i = start_index; i < end_index; ++i)
-                {
-                    unpacked_path.push_back(
-                        PathData{id_vector[i],
-                                 name_index,
-                                 weight_vector[i],
-                                 extractor::guidance::TurnInstruction::NO_TURN(),
-                                 {{0, INVALID_LANEID}, INVALID_LANE_DESCRIPTIONID},
-                                 travel_mode,
-                                 INVALID_ENTRY_CLASSID,
-                                 datasource_vector[i]});
-                }
-                BOOST_ASSERT(unpacked_path.size() > 0);
-                if (facade->hasLaneData(ed.id))
-                    unpacked_path.back().lane_data = facade->GetLaneData(ed.id);
-
-                unpacked_path.back().entry_classid = facade->GetEntryClassID(ed.id);
-                unpacked_path.back().turn_instruction = turn_instruction;
-                unpacked_path.back().duration_until_turn += (ed.distance - total_weight);
+                unpack_original_edge(unpacked_path,
+                                     original_edge.first,
+                                     facade->GetMultiLevelEdgeData(original_edge.second));
             }
         }
+        else if (parallel_unpacking_length > 0 &&
+                 number_of_packed_edges >= parallel_unpacking_length)
+        {
+            // The packed edges are split into chunks that are expanded on all cores, the first
+            // one right into the path, the others into buffers that are appended in order.
+            const std::size_t number_of_chunks =
+                std::min<std::size_t>(number_of_packed_edges, MAX_UNPACKING_CHUNKS);
+            std::vector<PathDataVector> chunk_paths(number_of_chunks - 1);
+            std::vector<std::uint64_t> unpacked_shortcuts(number_of_chunks, 0);
+            tbb::parallel_for(
+                tbb::blocked_range<std::size_t>(0, number_of_chunks, 1),
+                [&](const tbb::blocked_range<std::size_t> &range) {
+                    for (auto chunk = range.begin(); chunk != range.end(); ++chunk)
+                    {
+                        // counted apart, the statistics of the query belong to its own thread
+                        SearchStatistics chunk_statistics;
+                        const SearchEngineData::ScopedStatistics scoped_statistics(
+                            chunk_statistics);
+                        const auto first = packed_path_begin +
+                                           chunk * number_of_packed_edges / number_of_chunks;
+                        const auto last = packed_path_begin +
+                                          (chunk + 1) * number_of_packed_edges / number_of_chunks;
+                        unpack_packed_edges(
+                            first, last, chunk == 0 ? unpacked_path : chunk_paths[chunk - 1]);
+                        unpacked_shortcuts[chunk] = chunk_statistics.unpacked_shortcuts;
+                    }
+                });
+            for (const auto &chunk_path : chunk_paths)
+            {
+                unpacked_path.insert(unpacked_path.end(), chunk_path.begin(), chunk_path.end());
+            }
+            if (statistics)
+            {
+                statistics->unpacked_shortcuts += std::accumulate(
+                    unpacked_shortcuts.begin(), unpacked_shortcuts.end(), std::uint64_t{0});
+            }
+        }
+        else
+        {
+            unpack_packed_edges(packed_path_begin, std::prev(packed_path_end), unpacked_path);
+        }
+        const auto &id_vector = scratch.id_vector;
+        const auto &weight_vector = scratch.weight_vector;
+        const auto &datasource_vector = scratch.datasource_vector;
+        const auto &zoom_level_vector = scratch.zoom_level_vector;
+        const auto &length_vector = scratch.length_vector;
         std::size_t start_index = 0, end_index = 0;
-        std::vector<unsigned> id_vector;
-        std::vector<EdgeWeight> weight_vector;
-        std::vector<DatasourceID> datasource_vector;
         const bool is_local_path = (phantom_node_pair.source_phantom.forward_packed_geometry_id ==
                                     phantom_node_pair.target_phantom.forward_packed_geometry_id) &&
                                    unpacked_path.empty();
 
         if (target_traversed_in_reverse)
         {
-            facade->GetUncompressedGeometry(
-                phantom_node_pair.target_phantom.reverse_packed_geometry_id, id_vector);
-
-            facade->GetUncompressedWeights(
-                phantom_node_pair.target_phantom.reverse_packed_geometry_id, weight_vector);
-
-            facade->GetUncompressedDatasources(
-                phantom_node_pair.target_phantom.reverse_packed_geometry_id, datasource_vector);
+            get_uncompressed_data(phantom_node_pair.target_phantom.reverse_packed_geometry_id);
 
             if (is_local_path)
             {
@@ -382,14 +867,7 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                 start_index = phantom_node_pair.source_phantom.fwd_segment_position;
             }
             end_index = phantom_node_pair.target_phantom.fwd_segment_position;
-            facade->GetUncompressedGeometry(
-                phantom_node_pair.target_phantom.forward_packed_geometry_id, id_vector);
-
-            facade->GetUncompressedWeights(
-                phantom_node_pair.target_phantom.forward_packed_geometry_id, weight_vector);
-
-            facade->GetUncompressedDatasources(
-                phantom_node_pair.target_phantom.forward_packed_geometry_id, datasource_vector);
+            get_uncompressed_data(phantom_node_pair.target_phantom.forward_packed_geometry_id);
         }
 
         // Given the following compressed geometry:
@@ -412,7 +890,9 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                 target_traversed_in_reverse ? phantom_node_pair.target_phantom.backward_travel_mode
                                             : phantom_node_pair.target_phantom.forward_travel_mode,
                 INVALID_ENTRY_CLASSID,
-                datasource_vector[i]});
+                datasource_vector[i],
+                zoom_level_vector[i],
+                length_vector[i]});
         }
 
         if (unpacked_path.size() > 0)
@@ -458,6 +938,8 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
 
     void UnpackEdge(const NodeID s, const NodeID t, std::vector<NodeID> &unpacked_path) const
     {
+        const auto &graph = facade->GetSearchGraph();
+        SearchStatistics *const statistics = SearchEngineData::GetStatistics();
         std::stack<std::pair<NodeID, NodeID>> recursion_stack;
         recursion_stack.emplace(s, t);
 
@@ -469,27 +951,25 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
 
             EdgeID smaller_edge_id = SPECIAL_EDGEID;
             EdgeWeight edge_weight = std::numeric_limits<EdgeWeight>::max();
-            for (const auto edge_id : facade->GetAdjacentEdgeRange(edge.first))
+            for (const auto edge_id : graph.GetAdjacentEdgeRange(edge.first))
             {
-                const EdgeWeight weight = facade->GetEdgeData(edge_id).distance;
-                if ((facade->GetTarget(edge_id) == edge.second) && (weight < edge_weight) &&
-                    facade->GetEdgeData(edge_id).forward)
+                const auto &data = graph.GetSearchData(edge_id);
+                if (data.target == edge.second && data.distance < edge_weight && data.forward)
                 {
                     smaller_edge_id = edge_id;
-                    edge_weight = weight;
+                    edge_weight = data.distance;
                 }
             }
 
             if (SPECIAL_EDGEID == smaller_edge_id)
             {
-                for (const auto edge_id : facade->GetAdjacentEdgeRange(edge.second))
+                for (const auto edge_id : graph.GetAdjacentEdgeRange(edge.second))
                 {
-                    const EdgeWeight weight = facade->GetEdgeData(edge_id).distance;
-                    if ((facade->GetTarget(edge_id) == edge.first) && (weight < edge_weight) &&
-                        facade->GetEdgeData(edge_id).backward)
+                    const auto &data = graph.GetSearchData(edge_id);
+                    if (data.target == edge.first && data.distance < edge_weight && data.backward)
                     {
                         smaller_edge_id = edge_id;
-                        edge_weight = weight;
+                        edge_weight = data.distance;
                     }
                 }
             }
@@ -497,6 +977,14 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                              "edge weight invalid");
 
             const EdgeData &ed = facade->GetEdgeData(smaller_edge_id);
+
+            if (ed.shortcut && statistics)
+
+            {
+
+                ++statistics->unpacked_shortcuts;
+
+            }
             if (ed.shortcut)
             { // unpack
                 const NodeID middle_node_id = ed.id;
@@ -541,6 +1029,141 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         }
     }
 
+    // Runs the search, and with a traffic overlay runs it again as long as the path it finds has
+    // shortcuts with penalties inside that the previous runs didn't know yet. The searches only
+    // penalize the nodes they settle, not the nodes that were contracted below a shortcut, so
+    // the penalties of those are looked up by unpacking the shortcuts of the path. Every run
+    // starts from the initial nodes of the heaps. After MAX_TRAFFIC_SEARCHES runs the last path
+    // is kept unless one of its shortcuts turned out to be closed.
+    template <typename SearchT>
+    void SearchWithTrafficOverlay(SearchEngineData::QueryHeap &forward_heap,
+                                  SearchEngineData::QueryHeap &reverse_heap,
+                                  std::int32_t &distance,
+                                  std::vector<NodeID> &packed_leg,
+                                  const SearchT &search) const
+    {
+        const TrafficOverlay *const overlay = SearchEngineData::GetTrafficOverlay();
+        if (!overlay)
+        {
+            search();
+            return;
+        }
+
+        const auto forward_entries = TakeHeapEntries(forward_heap);
+        const auto reverse_entries = TakeHeapEntries(reverse_heap);
+        HiddenTrafficPenalties hidden_penalties;
+        const SearchEngineData::ScopedHiddenTrafficPenalties hiding(hidden_penalties);
+        const auto packed_leg_size = packed_leg.size();
+        for (unsigned run = 1;; ++run)
+        {
+            search();
+            if (distance == INVALID_EDGE_WEIGHT)
+            {
+                return;
+            }
+
+            bool is_closed = false;
+            if (!AddHiddenTrafficPenalties(*overlay,
+                                           packed_leg.begin() + packed_leg_size,
+                                           packed_leg.end(),
+                                           hidden_penalties,
+                                           is_closed))
+            {
+                return;
+            }
+            if (run == MAX_TRAFFIC_SEARCHES)
+            {
+                if (is_closed)
+                {
+                    distance = INVALID_EDGE_WEIGHT;
+                    packed_leg.resize(packed_leg_size);
+                }
+                return;
+            }
+
+            packed_leg.resize(packed_leg_size);
+            PutHeapEntries(forward_heap, forward_entries);
+            PutHeapEntries(reverse_heap, reverse_entries);
+        }
+    }
+
+    // Looks up the penalties of the nodes inside the shortcuts of the packed path that are not
+    // in the hidden penalties yet. False if none of them has a penalty, is_closed is set if one
+    // of the shortcuts of the path is closed.
+    template <typename RandomIter>
+    bool AddHiddenTrafficPenalties(const TrafficOverlay &overlay,
+                                   RandomIter packed_path_begin,
+                                   RandomIter packed_path_end,
+                                   HiddenTrafficPenalties &hidden_penalties,
+                                   bool &is_closed) const
+    {
+        bool has_new_penalties = false;
+        std::vector<NodeID> unpacked_edge;
+        for (auto current = packed_path_begin;
+             current != packed_path_end && std::next(current) != packed_path_end;
+             ++current)
+        {
+            const NodeID from = *current;
+            const NodeID to = *std::next(current);
+            // a loop is a single edge, which has no nodes inside
+            if (from == to)
+            {
+                continue;
+            }
+            if (hidden_penalties.Contains(from, to))
+            {
+                is_closed = is_closed || hidden_penalties.Get(from, to) == TrafficOverlay::CLOSED;
+                continue;
+            }
+
+            unpacked_edge.clear();
+            UnpackEdge(from, to, unpacked_edge);
+            EdgeWeight penalty = 0;
+            for (auto node = std::next(unpacked_edge.begin());
+                 node != unpacked_edge.end() && std::next(node) != unpacked_edge.end();
+                 ++node)
+            {
+                const EdgeWeight node_penalty = overlay.GetPenalty(*node);
+                if (node_penalty == TrafficOverlay::CLOSED)
+                {
+                    penalty = TrafficOverlay::CLOSED;
+                    break;
+                }
+                penalty += node_penalty;
+            }
+            hidden_penalties.Set(from, to, penalty);
+            if (penalty != 0)
+            {
+                has_new_penalties = true;
+                is_closed = is_closed || penalty == TrafficOverlay::CLOSED;
+            }
+        }
+        return has_new_penalties;
+    }
+
+    // Empties the heap and returns its nodes with their keys and parents
+    static std::vector<HeapEntry> TakeHeapEntries(SearchEngineData::QueryHeap &heap)
+    {
+        std::vector<HeapEntry> entries;
+        while (!heap.Empty())
+        {
+            const NodeID node = heap.DeleteMin();
+            entries.emplace_back(node, heap.GetKey(node), heap.GetData(node).parent);
+        }
+        PutHeapEntries(heap, entries);
+        return entries;
+    }
+
+    static void PutHeapEntries(SearchEngineData::QueryHeap &heap,
+                               const std::vector<HeapEntry> &entries)
+    {
+        heap.Clear();
+        for (const auto &entry : entries)
+        {
+            heap.Insert(std::get<0>(entry), std::get<1>(entry), std::get<2>(entry));
+        }
+    }
+
     // assumes that heaps are already setup correctly.
     // ATTENTION: This only works if no additional offset is supplied next to the Phantom Node
     // Offsets.
@@ -560,6 +1183,44 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                 const bool force_loop_forward,
                 const bool force_loop_reverse,
                 const int duration_upper_bound = INVALID_EDGE_WEIGHT) const
+    {
+        const SearchStatistics *const statistics = SearchEngineData::GetStatistics();
+        const std::uint64_t settled_nodes = statistics ? statistics->settled_nodes : 0;
+        OSRM_TRACEPOINT(search__start);
+        if (facade->HasMultiLevelData())
+        {
+            MultiLevelSearch(forward_heap,
+                             reverse_heap,
+                             distance,
+                             packed_leg,
+                             force_loop_forward,
+                             force_loop_reverse,
+                             duration_upper_bound);
+        }
+        else
+        {
+            SearchWithTrafficOverlay(forward_heap, reverse_heap, distance, packed_leg, [&] {
+                SearchOnce(forward_heap,
+                           reverse_heap,
+                           distance,
+                           packed_leg,
+                           force_loop_forward,
+                           force_loop_reverse,
+                           duration_upper_bound);
+            });
+        }
+        OSRM_TRACEPOINT2(search__done,
+                         distance,
+                         statistics ? statistics->settled_nodes - settled_nodes : 0);
+    }
+
+    void SearchOnce(SearchEngineData::QueryHeap &forward_heap,
+                    SearchEngineData::QueryHeap &reverse_heap,
+                    std::int32_t &distance,
+                    std::vector<NodeID> &packed_leg,
+                    const bool force_loop_forward,
+                    const bool force_loop_reverse,
+                    const int duration_upper_bound) const
     {
         NodeID middle = SPECIAL_NODEID;
         distance = duration_upper_bound;
@@ -571,56 +1232,457 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         BOOST_ASSERT(reverse_heap.MinKey() >= 0);
 
         // run two-Target Dijkstra routing step.
-        const constexpr bool STALLING_ENABLED = true;
         while (0 < (forward_heap.Size() + reverse_heap.Size()))
         {
             if (!forward_heap.Empty())
             {
-                RoutingStep(forward_heap,
-                            reverse_heap,
-                            middle,
-                            distance,
-                            min_edge_offset,
-                            true,
-                            STALLING_ENABLED,
-                            force_loop_forward,
-                            force_loop_reverse);
+                RoutingStep(forward_heap,
+                            reverse_heap,
+                            middle,
+                            distance,
+                            min_edge_offset,
+                            true,
+                            stalling_mode,
+                            force_loop_forward,
+                            force_loop_reverse);
+            }
+            if (!reverse_heap.Empty())
+            {
+                RoutingStep(reverse_heap,
+                            forward_heap,
+                            middle,
+                            distance,
+                            min_edge_offset,
+                            false,
+                            stalling_mode,
+                            force_loop_reverse,
+                            force_loop_forward);
+            }
+        }
+
+        // No path found for both target nodes?
+        if (duration_upper_bound <= distance || SPECIAL_NODEID == middle)
+        {
+            distance = INVALID_EDGE_WEIGHT;
+            return;
+        }
+
+        // Was a paths over one of the forward/reverse nodes not found?
+        BOOST_ASSERT_MSG((SPECIAL_NODEID != middle && INVALID_EDGE_WEIGHT != distance),
+                         "no path found");
+
+        // make sure to correctly unpack loops
+        if (distance != forward_heap.GetKey(middle) + reverse_heap.GetKey(middle))
+        {
+            // self loop makes up the full path
+            packed_leg.push_back(middle);
+            packed_leg.push_back(middle);
+        }
+        else
+        {
+            RetrievePackedPathFromHeap(forward_heap, reverse_heap, middle, packed_leg);
+        }
+    }
+
+    // Bidirectional Dijkstra on the multi-level graph, which replaces the CH query if the facade
+    // has multi-level data. A node in the cell of one of the initial nodes on the lowest level is
+    // searched on the edges of the graph. Any other node is searched on the highest level whose
+    // cell contains none of the initial nodes: from a boundary node of that cell the search
+    // jumps to the boundary nodes on the other side with the weights of the cell, and follows
+    // the edges that leave the cell. Both directions thus search the same graph, which shrinks
+    // with the distance to the initial nodes. The packed path has the nodes the search settled,
+    // UnpackPath and GetPathDistance expand the cells between them. The weights are those of the
+    // metric of the query, whose excluded nodes are never settled.
+    void MultiLevelSearch(SearchEngineData::QueryHeap &forward_heap,
+                          SearchEngineData::QueryHeap &reverse_heap,
+                          std::int32_t &distance,
+                          std::vector<NodeID> &packed_leg,
+                          const bool force_loop_forward,
+                          const bool force_loop_reverse,
+                          const int duration_upper_bound) const
+    {
+        const auto graph = facade->GetMultiLevelGraph();
+        const auto cells = facade->GetCellStorage().GetMetric(SearchEngineData::GetCellMetric());
+
+        std::vector<NodeID> initial_nodes;
+        for (const auto &entry : TakeHeapEntries(forward_heap))
+        {
+            initial_nodes.push_back(std::get<0>(entry));
+        }
+        for (const auto &entry : TakeHeapEntries(reverse_heap))
+        {
+            initial_nodes.push_back(std::get<0>(entry));
+        }
+        // 0 for the nodes searched on the edges, the level of the cell plus one otherwise
+        const auto get_query_level = [&](const NodeID node) {
+            partition::LevelID level = cells.GetNumberOfLevels();
+            for (const auto initial_node : initial_nodes)
+            {
+                level = std::min(level, cells.GetCommonLevel(node, initial_node));
+            }
+            return level;
+        };
+
+        NodeID middle = SPECIAL_NODEID;
+        distance = duration_upper_bound;
+
+        // the keys of both heaps are the weights of paths in the same graph, so no path shorter
+        // than the best one found is left once the smallest keys add up to its weight
+        while (!forward_heap.Empty() && !reverse_heap.Empty() &&
+               forward_heap.MinKey() + reverse_heap.MinKey() < distance)
+        {
+            MultiLevelRoutingStep(graph,
+                                  cells,
+                                  get_query_level,
+                                  forward_heap,
+                                  reverse_heap,
+                                  middle,
+                                  distance,
+                                  true,
+                                  force_loop_forward,
+                                  force_loop_reverse);
+            if (!reverse_heap.Empty())
+            {
+                MultiLevelRoutingStep(graph,
+                                      cells,
+                                      get_query_level,
+                                      reverse_heap,
+                                      forward_heap,
+                                      middle,
+                                      distance,
+                                      false,
+                                      force_loop_reverse,
+                                      force_loop_forward);
+            }
+        }
+
+        if (duration_upper_bound <= distance || SPECIAL_NODEID == middle)
+        {
+            distance = INVALID_EDGE_WEIGHT;
+            return;
+        }
+
+        if (distance != forward_heap.GetKey(middle) + reverse_heap.GetKey(middle))
+        {
+            // self loop makes up the full path
+            packed_leg.push_back(middle);
+            packed_leg.push_back(middle);
+        }
+        else
+        {
+            RetrievePackedPathFromHeap(forward_heap, reverse_heap, middle, packed_leg);
+        }
+    }
+
+    template <typename QueryLevelT>
+    void MultiLevelRoutingStep(const contractor::QueryGraphView &graph,
+                               const partition::CellStorageView &cells,
+                               const QueryLevelT &get_query_level,
+                               SearchEngineData::QueryHeap &forward_heap,
+                               SearchEngineData::QueryHeap &reverse_heap,
+                               NodeID &middle_node_id,
+                               std::int32_t &upper_bound,
+                               const bool forward_direction,
+                               const bool force_loop_forward,
+                               const bool force_loop_reverse) const
+    {
+        SearchEngineData::PollQueryControl();
+        const NodeID node = forward_heap.DeleteMin();
+        const std::int32_t weight = forward_heap.GetKey(node);
+        SearchStatistics *const statistics = SearchEngineData::GetStatistics();
+        if (statistics)
+        {
+            ++statistics->settled_nodes;
+        }
+
+        UpdateMiddle(graph,
+                     forward_heap,
+                     reverse_heap,
+                     node,
+                     weight,
+                     forward_direction,
+                     force_loop_forward,
+                     force_loop_reverse,
+                     middle_node_id,
+                     upper_bound);
+
+        RelaxMultiLevelEdges(
+            graph, cells, get_query_level(node), node, weight, forward_direction, forward_heap);
+    }
+
+    // Relaxes the edges of a node that the multi-level Dijkstra settled on the query level of the
+    // node, see MultiLevelSearch
+    template <typename HeapT>
+    void RelaxMultiLevelEdges(const contractor::QueryGraphView &graph,
+                              const partition::CellStorageView &cells,
+                              const partition::LevelID query_level,
+                              const NodeID node,
+                              const std::int32_t weight,
+                              const bool forward_direction,
+                              HeapT &heap) const
+    {
+        std::uint64_t relaxed_edges = 0;
+        const auto relax = [&](const NodeID to, const std::int32_t to_weight) {
+            ++relaxed_edges;
+            if (cells.IsExcluded(to))
+            {
+                return;
+            }
+            if (!heap.WasInserted(to))
+            {
+                heap.Insert(to, to_weight, node);
+            }
+            else if (to_weight < heap.GetKey(to))
+            {
+                heap.GetData(to).parent = node;
+                heap.DecreaseKey(to, to_weight);
+            }
+        };
+
+        partition::CellID cell_id = partition::INVALID_CELL_ID;
+        if (query_level > 0)
+        {
+            const partition::LevelID level = query_level - 1;
+            cell_id = cells.GetCellID(level, node);
+            const auto cell = cells.GetCell(level, cell_id);
+            if (forward_direction)
+            {
+                const auto source_index = cell.FindSource(node);
+                if (source_index < cell.GetNumberOfSources())
+                {
+                    for (const auto destination_index :
+                         util::irange<std::uint32_t>(0, cell.GetNumberOfDestinations()))
+                    {
+                        const auto cell_weight = cell.GetWeight(source_index, destination_index);
+                        if (cell_weight != INVALID_EDGE_WEIGHT)
+                        {
+                            relax(cell.GetDestination(destination_index), weight + cell_weight);
+                        }
+                    }
+                }
             }
-            if (!reverse_heap.Empty())
+            else
             {
-                RoutingStep(reverse_heap,
-                            forward_heap,
-                            middle,
-                            distance,
-                            min_edge_offset,
-                            false,
-                            STALLING_ENABLED,
-                            force_loop_reverse,
-                            force_loop_forward);
+                const auto destination_index = cell.FindDestination(node);
+                if (destination_index < cell.GetNumberOfDestinations())
+                {
+                    for (const auto source_index :
+                         util::irange<std::uint32_t>(0, cell.GetNumberOfSources()))
+                    {
+                        const auto cell_weight = cell.GetWeight(source_index, destination_index);
+                        if (cell_weight != INVALID_EDGE_WEIGHT)
+                        {
+                            relax(cell.GetSource(source_index), weight + cell_weight);
+                        }
+                    }
+                }
             }
         }
 
-        // No path found for both target nodes?
-        if (duration_upper_bound <= distance || SPECIAL_NODEID == middle)
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            const auto &data = graph.GetSearchData(edge);
+            if ((forward_direction ? data.forward : data.backward) &&
+                (query_level == 0 || cells.GetCellID(query_level - 1, data.target) != cell_id))
+            {
+                BOOST_ASSERT_MSG(data.distance > 0, "edge_weight invalid");
+                // the metric of the cells may have weights of its own that close the edge
+                const auto edge_weight = cells.GetEdgeWeight(edge, data.distance);
+                if (edge_weight != INVALID_EDGE_WEIGHT)
+                {
+                    relax(data.target, weight + edge_weight);
+                }
+            }
+        }
+
+        if (SearchStatistics *const statistics = SearchEngineData::GetStatistics())
+        {
+            statistics->relaxed_edges += relaxed_edges;
+        }
+    }
+
+    // A* search through the core from the forward entry points to the reverse entry points,
+    // guided by the lower bounds of the landmarks (ALT). The reverse core heap only holds the
+    // reverse entry points. The keys in the forward core heap are the distance of a node plus
+    // its potential, a lower bound of the remaining distance to the closest reverse entry point
+    // including the weight of that entry point. The key of the middle node is reset to its
+    // distance at the end, so the path can be retrieved as for the bidirectional search.
+    void LandmarkCoreSearch(const std::vector<CoreEntryPoint> &forward_entry_points,
+                            const std::vector<CoreEntryPoint> &reverse_entry_points,
+                            SearchEngineData::QueryHeap &forward_core_heap,
+                            SearchEngineData::QueryHeap &reverse_core_heap,
+                            NodeID &middle,
+                            int &distance,
+                            const bool force_loop_forward,
+                            const bool force_loop_reverse) const
+    {
+        const auto &graph = facade->GetSearchGraph();
+        if (forward_entry_points.empty() || reverse_entry_points.empty())
         {
-            distance = INVALID_EDGE_WEIGHT;
             return;
         }
 
-        // Was a paths over one of the forward/reverse nodes not found?
-        BOOST_ASSERT_MSG((SPECIAL_NODEID != middle && INVALID_EDGE_WEIGHT != distance),
-                         "no path found");
+        const unsigned number_of_landmarks = facade->GetNumberOfLandmarks();
+
+        // For every landmark L and reverse entry point t with weight w_t the distance of a node
+        // v to t is at least d(L,t) - d(L,v) and at least d(v,L) - d(t,L). Taking the closest
+        // target gives the bounds from_bounds[L] - d(L,v) and d(v,L) - to_bounds[L].
+        std::vector<EdgeWeight> from_bounds(number_of_landmarks, INVALID_EDGE_WEIGHT);
+        std::vector<EdgeWeight> to_bounds(number_of_landmarks,
+                                          std::numeric_limits<EdgeWeight>::min());
+        // every path ends at one of the entry points, so their smallest weight is a bound too
+        EdgeWeight min_target_weight = INVALID_EDGE_WEIGHT;
+        for (const auto &entry_point : reverse_entry_points)
+        {
+            const NodeID target = std::get<0>(entry_point);
+            const EdgeWeight weight = std::get<1>(entry_point);
+            min_target_weight = std::min(min_target_weight, weight);
 
-        // make sure to correctly unpack loops
-        if (distance != forward_heap.GetKey(middle) + reverse_heap.GetKey(middle))
+            const EdgeWeight *target_distances = facade->GetLandmarkDistances(target);
+            BOOST_ASSERT(target_distances != nullptr);
+            for (const auto landmark : util::irange(0u, number_of_landmarks))
+            {
+                const EdgeWeight from_landmark = target_distances[landmark];
+                if (from_landmark != INVALID_EDGE_WEIGHT)
+                {
+                    from_bounds[landmark] =
+                        std::min(from_bounds[landmark], from_landmark + weight);
+                }
+
+                // a target that can not reach the landmark makes its bound useless
+                const EdgeWeight to_landmark = target_distances[number_of_landmarks + landmark];
+                if (to_landmark == INVALID_EDGE_WEIGHT)
+                {
+                    to_bounds[landmark] = INVALID_EDGE_WEIGHT;
+                }
+                else if (to_bounds[landmark] != INVALID_EDGE_WEIGHT)
+                {
+                    to_bounds[landmark] = std::max(to_bounds[landmark], to_landmark - weight);
+                }
+            }
+        }
+
+        // Returns INVALID_EDGE_WEIGHT for nodes that can not reach any reverse entry point:
+        // if a node can not reach a landmark that all entry points reach, it reaches none.
+        const auto potential = [&](const NodeID node) {
+            const EdgeWeight *node_distances = facade->GetLandmarkDistances(node);
+            if (node_distances == nullptr)
+            {
+                return INVALID_EDGE_WEIGHT;
+            }
+
+            EdgeWeight bound = min_target_weight;
+            for (const auto landmark : util::irange(0u, number_of_landmarks))
+            {
+                const EdgeWeight from_landmark = node_distances[landmark];
+                if (from_bounds[landmark] != INVALID_EDGE_WEIGHT &&
+                    from_landmark != INVALID_EDGE_WEIGHT)
+                {
+                    bound = std::max(bound, from_bounds[landmark] - from_landmark);
+                }
+
+                if (to_bounds[landmark] != INVALID_EDGE_WEIGHT)
+                {
+                    const EdgeWeight to_landmark = node_distances[number_of_landmarks + landmark];
+                    if (to_landmark == INVALID_EDGE_WEIGHT)
+                    {
+                        return INVALID_EDGE_WEIGHT;
+                    }
+                    bound = std::max(bound, to_landmark - to_bounds[landmark]);
+                }
+            }
+            return bound;
+        };
+
+        for (const auto &entry_point : forward_entry_points)
         {
-            // self loop makes up the full path
-            packed_leg.push_back(middle);
-            packed_leg.push_back(middle);
+            const NodeID node = std::get<0>(entry_point);
+            const EdgeWeight node_potential = potential(node);
+            if (node_potential != INVALID_EDGE_WEIGHT)
+            {
+                forward_core_heap.Insert(
+                    node, std::get<1>(entry_point) + node_potential, std::get<2>(entry_point));
+            }
         }
-        else
+
+        // the potentials are consistent, so the keys are lower bounds of all paths that
+        // continue from the heap and every node is settled only once
+        SearchStatistics *const statistics = SearchEngineData::GetStatistics();
+        const TrafficOverlay *const overlay = SearchEngineData::GetTrafficOverlay();
+        EdgeWeight middle_weight = INVALID_EDGE_WEIGHT;
+        while (!forward_core_heap.Empty() && forward_core_heap.MinKey() < distance)
         {
-            RetrievePackedPathFromHeap(forward_heap, reverse_heap, middle, packed_leg);
+            SearchEngineData::PollQueryControl();
+            const NodeID node = forward_core_heap.DeleteMin();
+            const EdgeWeight weight = forward_core_heap.GetKey(node) - potential(node);
+            if (statistics)
+            {
+                ++statistics->settled_nodes;
+            }
+
+            const auto previous_distance = distance;
+            UpdateMiddle(forward_core_heap,
+                         reverse_core_heap,
+                         node,
+                         weight,
+                         true,
+                         force_loop_forward,
+                         force_loop_reverse,
+                         middle,
+                         distance);
+            if (distance != previous_distance)
+            {
+                middle_weight = weight;
+            }
+
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                const auto &data = graph.GetSearchData(edge);
+                if (!data.forward)
+                {
+                    continue;
+                }
+
+                if (statistics)
+                {
+                    ++statistics->relaxed_edges;
+                }
+
+                const NodeID to = data.target;
+                const EdgeWeight to_potential = potential(to);
+                if (to_potential == INVALID_EDGE_WEIGHT)
+                {
+                    continue;
+                }
+
+                BOOST_ASSERT_MSG(data.distance > 0, "edge_weight invalid");
+                EdgeWeight edge_weight = data.distance;
+                if (overlay)
+                {
+                    // the penalties only make the weights larger, so the potentials stay
+                    // consistent
+                    edge_weight = GetTrafficWeight(*overlay, node, to, true, edge_weight);
+                    if (edge_weight == INVALID_EDGE_WEIGHT)
+                    {
+                        continue;
+                    }
+                }
+                const int to_key = weight + edge_weight + to_potential;
+                if (!forward_core_heap.WasInserted(to))
+                {
+                    forward_core_heap.Insert(to, to_key, node);
+                }
+                else if (to_key < forward_core_heap.GetKey(to))
+                {
+                    forward_core_heap.GetData(to).parent = node;
+                    forward_core_heap.DecreaseKey(to, to_key);
+                }
+            }
+        }
+
+        if (middle_weight != INVALID_EDGE_WEIGHT)
+        {
+            forward_core_heap.DecreaseKey(middle, middle_weight);
         }
     }
 
@@ -642,11 +1704,49 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                         const bool force_loop_forward,
                         const bool force_loop_reverse,
                         int duration_upper_bound = INVALID_EDGE_WEIGHT) const
+    {
+        // the cells already spare the multi-level Dijkstra the dense parts of the graph
+        if (facade->HasMultiLevelData())
+        {
+            MultiLevelSearch(forward_heap,
+                             reverse_heap,
+                             distance,
+                             packed_leg,
+                             force_loop_forward,
+                             force_loop_reverse,
+                             duration_upper_bound);
+            return;
+        }
+        SearchWithTrafficOverlay(forward_heap, reverse_heap, distance, packed_leg, [&] {
+            SearchWithCoreOnce(forward_heap,
+                               reverse_heap,
+                               forward_core_heap,
+                               reverse_core_heap,
+                               distance,
+                               packed_leg,
+                               force_loop_forward,
+                               force_loop_reverse,
+                               duration_upper_bound);
+        });
+    }
+
+    void SearchWithCoreOnce(SearchEngineData::QueryHeap &forward_heap,
+                            SearchEngineData::QueryHeap &reverse_heap,
+                            SearchEngineData::QueryHeap &forward_core_heap,
+                            SearchEngineData::QueryHeap &reverse_core_heap,
+                            int &distance,
+                            std::vector<NodeID> &packed_leg,
+                            const bool force_loop_forward,
+                            const bool force_loop_reverse,
+                            const int duration_upper_bound) const
     {
         NodeID middle = SPECIAL_NODEID;
         distance = duration_upper_bound;
 
-        using CoreEntryPoint = std::tuple<NodeID, EdgeWeight, NodeID>;
+        // tested for every settled node, so read directly instead of through the facade
+        const auto core_markers = facade->GetCoreMarkers();
+        BOOST_ASSERT(!core_markers.Empty());
+
         std::vector<CoreEntryPoint> forward_entry_points;
         std::vector<CoreEntryPoint> reverse_entry_points;
 
@@ -655,13 +1755,12 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         // we only every insert negative offsets for nodes in the forward heap
         BOOST_ASSERT(reverse_heap.MinKey() >= 0);
 
-        const constexpr bool STALLING_ENABLED = true;
         // run two-Target Dijkstra routing step.
         while (0 < (forward_heap.Size() + reverse_heap.Size()))
         {
             if (!forward_heap.Empty())
             {
-                if (facade->IsCoreNode(forward_heap.Min()))
+                if (core_markers.Test(forward_heap.Min()))
                 {
                     const NodeID node = forward_heap.DeleteMin();
                     const int key = forward_heap.GetKey(node);
@@ -675,14 +1774,14 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                                 distance,
                                 min_edge_offset,
                                 true,
-                                STALLING_ENABLED,
+                                stalling_mode,
                                 force_loop_forward,
                                 force_loop_reverse);
                 }
             }
             if (!reverse_heap.Empty())
             {
-                if (facade->IsCoreNode(reverse_heap.Min()))
+                if (core_markers.Test(reverse_heap.Min()))
                 {
                     const NodeID node = reverse_heap.DeleteMin();
                     const int key = reverse_heap.GetKey(node);
@@ -696,13 +1795,18 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                                 distance,
                                 min_edge_offset,
                                 false,
-                                STALLING_ENABLED,
+                                stalling_mode,
                                 force_loop_reverse,
                                 force_loop_forward);
                 }
             }
         }
 
+        if (SearchStatistics *const statistics = SearchEngineData::GetStatistics())
+        {
+            statistics->core_entries += forward_entry_points.size() + reverse_entry_points.size();
+        }
+
         const auto insertInCoreHeap = [](const CoreEntryPoint &p,
                                          SearchEngineData::QueryHeap &core_heap) {
             NodeID id;
@@ -713,54 +1817,67 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             core_heap.Insert(id, weight, parent);
         };
 
-        forward_core_heap.Clear();
-        for (const auto &p : forward_entry_points)
-        {
-            insertInCoreHeap(p, forward_core_heap);
-        }
-
         reverse_core_heap.Clear();
         for (const auto &p : reverse_entry_points)
         {
             insertInCoreHeap(p, reverse_core_heap);
         }
 
-        // get offset to account for offsets on phantom nodes on compressed edges
-        int min_core_edge_offset = 0;
-        if (forward_core_heap.Size() > 0)
+        forward_core_heap.Clear();
+        if (facade->GetNumberOfLandmarks() > 0)
         {
-            min_core_edge_offset = std::min(min_core_edge_offset, forward_core_heap.MinKey());
+            LandmarkCoreSearch(forward_entry_points,
+                               reverse_entry_points,
+                               forward_core_heap,
+                               reverse_core_heap,
+                               middle,
+                               distance,
+                               force_loop_forward,
+                               force_loop_reverse);
         }
-        if (reverse_core_heap.Size() > 0 && reverse_core_heap.MinKey() < 0)
+        else
         {
-            min_core_edge_offset = std::min(min_core_edge_offset, reverse_core_heap.MinKey());
-        }
-        BOOST_ASSERT(min_core_edge_offset <= 0);
+            for (const auto &p : forward_entry_points)
+            {
+                insertInCoreHeap(p, forward_core_heap);
+            }
 
-        // run two-target Dijkstra routing step on core with termination criterion
-        const constexpr bool STALLING_DISABLED = false;
-        while (0 < forward_core_heap.Size() && 0 < reverse_core_heap.Size() &&
-               distance > (forward_core_heap.MinKey() + reverse_core_heap.MinKey()))
-        {
-            RoutingStep(forward_core_heap,
-                        reverse_core_heap,
-                        middle,
-                        distance,
-                        min_core_edge_offset,
-                        true,
-                        STALLING_DISABLED,
-                        force_loop_forward,
-                        force_loop_reverse);
+            // get offset to account for offsets on phantom nodes on compressed edges
+            int min_core_edge_offset = 0;
+            if (forward_core_heap.Size() > 0)
+            {
+                min_core_edge_offset = std::min(min_core_edge_offset, forward_core_heap.MinKey());
+            }
+            if (reverse_core_heap.Size() > 0 && reverse_core_heap.MinKey() < 0)
+            {
+                min_core_edge_offset = std::min(min_core_edge_offset, reverse_core_heap.MinKey());
+            }
+            BOOST_ASSERT(min_core_edge_offset <= 0);
+
+            // run two-target Dijkstra routing step on core with termination criterion
+            while (0 < forward_core_heap.Size() && 0 < reverse_core_heap.Size() &&
+                   distance > (forward_core_heap.MinKey() + reverse_core_heap.MinKey()))
+            {
+                RoutingStep(forward_core_heap,
+                            reverse_core_heap,
+                            middle,
+                            distance,
+                            min_core_edge_offset,
+                            true,
+                            StallingMode::Disabled,
+                            force_loop_forward,
+                            force_loop_reverse);
 
-            RoutingStep(reverse_core_heap,
-                        forward_core_heap,
-                        middle,
-                        distance,
-                        min_core_edge_offset,
-                        false,
-                        STALLING_DISABLED,
-                        force_loop_reverse,
-                        force_loop_forward);
+                RoutingStep(reverse_core_heap,
+                            forward_core_heap,
+                            middle,
+                            distance,
+                            min_core_edge_offset,
+                            false,
+                            StallingMode::Disabled,
+                            force_loop_reverse,
+                            force_loop_forward);
+            }
         }
 
         // No path found for both target nodes?
@@ -775,7 +1892,7 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                          "no path found");
 
         // we need to unpack sub path from core heaps
-        if (facade->IsCoreNode(middle))
+        if (core_markers.Test(middle))
         {
             if (distance != forward_core_heap.GetKey(middle) + reverse_core_heap.GetKey(middle))
             {
@@ -834,61 +1951,51 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                    target_phantom.GetReverseWeightPlusOffset();
     }
 
+    // Distance in meters of a packed path between two phantom nodes. The lengths stored at the
+    // edges already cover the shortcuts, so a path of the CH query is not unpacked, the cells on
+    // a path of the multi-level Dijkstra are. The lengths are summed up in double, but every
+    // edge stores a float and the one of a shortcut was already rounded when the contractor
+    // summed up its edges, so the result can differ from measuring the unpacked geometry by
+    // rounding errors that grow with the number of edges on the path.
     double GetPathDistance(const std::vector<NodeID> &packed_path,
                            const PhantomNode &source_phantom,
                            const PhantomNode &target_phantom) const
     {
-        std::vector<PathData> unpacked_path;
-        PhantomNodes nodes;
-        nodes.source_phantom = source_phantom;
-        nodes.target_phantom = target_phantom;
-        UnpackPath(packed_path.begin(), packed_path.end(), nodes, unpacked_path);
-
-        using util::coordinate_calculation::detail::DEGREE_TO_RAD;
-        using util::coordinate_calculation::detail::EARTH_RADIUS;
+        if (!facade->HasMultiLevelData())
+        {
+            return GetContractedPathDistance(packed_path, source_phantom, target_phantom);
+        }
+        BOOST_ASSERT(!packed_path.empty());
 
+        std::vector<std::pair<NodeID, EdgeID>> original_edges;
+        for (auto current = packed_path.begin(); std::next(current) != packed_path.end();
+             ++current)
+        {
+            UnpackMultiLevelEdge(*current, *std::next(current), original_edges);
+        }
         double distance = 0;
-        double prev_lat =
-            static_cast<double>(toFloating(source_phantom.location.lat)) * DEGREE_TO_RAD;
-        double prev_lon =
-            static_cast<double>(toFloating(source_phantom.location.lon)) * DEGREE_TO_RAD;
-        double prev_cos = std::cos(prev_lat);
-        for (const auto &p : unpacked_path)
+        for (const auto &original_edge : original_edges)
         {
-            const auto current_coordinate = facade->GetCoordinateOfNode(p.turn_via_node);
-
-            const double current_lat =
-                static_cast<double>(toFloating(current_coordinate.lat)) * DEGREE_TO_RAD;
-            const double current_lon =
-                static_cast<double>(toFloating(current_coordinate.lon)) * DEGREE_TO_RAD;
-            const double current_cos = std::cos(current_lat);
-
-            const double sin_dlon = std::sin((prev_lon - current_lon) / 2.0);
-            const double sin_dlat = std::sin((prev_lat - current_lat) / 2.0);
-
-            const double aharv = sin_dlat * sin_dlat + prev_cos * current_cos * sin_dlon * sin_dlon;
-            const double charv = 2. * std::atan2(std::sqrt(aharv), std::sqrt(1.0 - aharv));
-            distance += EARTH_RADIUS * charv;
-
-            prev_lat = current_lat;
-            prev_lon = current_lon;
-            prev_cos = current_cos;
+            distance += facade->GetMultiLevelEdgeData(original_edge.second).length;
         }
+        return CutToPhantomNodes(distance, packed_path, source_phantom, target_phantom);
+    }
 
-        const double current_lat =
-            static_cast<double>(toFloating(target_phantom.location.lat)) * DEGREE_TO_RAD;
-        const double current_lon =
-            static_cast<double>(toFloating(target_phantom.location.lon)) * DEGREE_TO_RAD;
-        const double current_cos = std::cos(current_lat);
-
-        const double sin_dlon = std::sin((prev_lon - current_lon) / 2.0);
-        const double sin_dlat = std::sin((prev_lat - current_lat) / 2.0);
-
-        const double aharv = sin_dlat * sin_dlat + prev_cos * current_cos * sin_dlon * sin_dlon;
-        const double charv = 2. * std::atan2(std::sqrt(aharv), std::sqrt(1.0 - aharv));
-        distance += EARTH_RADIUS * charv;
+    // GetPathDistance of a packed path of the CH graph, also if the facade has multi-level data
+    // and the searches of the routing algorithms run on that
+    double GetContractedPathDistance(const std::vector<NodeID> &packed_path,
+                                     const PhantomNode &source_phantom,
+                                     const PhantomNode &target_phantom) const
+    {
+        BOOST_ASSERT(!packed_path.empty());
 
-        return distance;
+        double distance = 0;
+        for (auto current = packed_path.begin(); std::next(current) != packed_path.end();
+             ++current)
+        {
+            distance += facade->GetEdgeData(FindPackedEdge(*current, *std::next(current))).length;
+        }
+        return CutToPhantomNodes(distance, packed_path, source_phantom, target_phantom);
     }
 
     // Requires the heaps for be empty
@@ -1012,6 +2119,246 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
 
         return GetPathDistance(packed_path, source_phantom, target_phantom);
     }
+
+    // Appends the edges of the multi-level graph between two consecutive nodes of a packed path
+    // of the multi-level Dijkstra, with the nodes they leave. The search went from one to the
+    // other over an edge or the weight of a cell that they are boundary nodes of. Whichever of
+    // them is cheapest was taken, as the path is a shortest path. A cell is expanded by searching
+    // it again, the pairs of nodes of that search are expanded the same way.
+    void UnpackMultiLevelEdge(const NodeID from,
+                              const NodeID to,
+                              std::vector<std::pair<NodeID, EdgeID>> &original_edges) const
+    {
+        const auto graph = facade->GetMultiLevelGraph();
+        const auto cells = facade->GetCellStorage().GetMetric(SearchEngineData::GetCellMetric());
+        std::stack<std::pair<NodeID, NodeID>> recursion_stack;
+        recursion_stack.emplace(from, to);
+
+        while (!recursion_stack.empty())
+        {
+            const auto edge = recursion_stack.top();
+            recursion_stack.pop();
+
+            EdgeID smaller_edge_id = SPECIAL_EDGEID;
+            EdgeWeight edge_weight = INVALID_EDGE_WEIGHT;
+            for (const auto edge_id : graph.GetAdjacentEdgeRange(edge.first))
+            {
+                const auto &data = graph.GetSearchData(edge_id);
+                const auto metric_weight = cells.GetEdgeWeight(edge_id, data.distance);
+                if (data.target == edge.second && metric_weight < edge_weight && data.forward)
+                {
+                    smaller_edge_id = edge_id;
+                    edge_weight = metric_weight;
+                }
+            }
+
+            partition::LevelID cell_level = cells.GetNumberOfLevels();
+            EdgeWeight cell_weight = INVALID_EDGE_WEIGHT;
+            for (auto level = cells.GetCommonLevel(edge.first, edge.second);
+                 level < cells.GetNumberOfLevels();
+                 ++level)
+            {
+                const auto cell = cells.GetCell(level, cells.GetCellID(level, edge.first));
+                const auto source_index = cell.FindSource(edge.first);
+                const auto destination_index = cell.FindDestination(edge.second);
+                if (source_index < cell.GetNumberOfSources() &&
+                    destination_index < cell.GetNumberOfDestinations() &&
+                    cell.GetWeight(source_index, destination_index) < cell_weight)
+                {
+                    cell_level = level;
+                    cell_weight = cell.GetWeight(source_index, destination_index);
+                }
+            }
+
+            if (SPECIAL_EDGEID != smaller_edge_id && edge_weight <= cell_weight)
+            {
+                original_edges.emplace_back(edge.first, smaller_edge_id);
+                continue;
+            }
+            BOOST_ASSERT_MSG(cell_weight != INVALID_EDGE_WEIGHT, "edge id invalid");
+
+            if (SearchStatistics *const statistics = SearchEngineData::GetStatistics())
+            {
+                ++statistics->unpacked_shortcuts;
+            }
+            SearchEngineData::InitializeOrClearCellHeap(facade->GetNumberOfNodes());
+            auto &heap = *SearchEngineData::GetHeaps().cell_heap;
+            heap.Insert(edge.first, 0, edge.first);
+            const NodeID target = edge.second;
+            partition::searchCell(graph,
+                                  cells,
+                                  cell_level,
+                                  cells.GetCellID(cell_level, edge.first),
+                                  heap,
+                                  [target](const NodeID node, const EdgeWeight) {
+                                      return node != target;
+                                  });
+            BOOST_ASSERT(heap.WasInserted(target));
+
+            // again, we need to this in reversed order
+            for (NodeID node = target; node != edge.first; node = heap.GetData(node).parent)
+            {
+                recursion_stack.emplace(heap.GetData(node).parent, node);
+            }
+        }
+    }
+
+  private:
+    // every edge of the path covers its complete source segment, but we start at the source
+    // phantom and end at the target phantom
+    double CutToPhantomNodes(const double distance,
+                             const std::vector<NodeID> &packed_path,
+                             const PhantomNode &source_phantom,
+                             const PhantomNode &target_phantom) const
+    {
+        const auto source_lengths = GetPhantomLengths(
+            source_phantom, packed_path.front() != source_phantom.forward_segment_id.id);
+        const auto target_lengths = GetPhantomLengths(
+            target_phantom, packed_path.back() != target_phantom.forward_segment_id.id);
+
+        return distance - source_lengths.total + source_lengths.after + target_lengths.before;
+    }
+
+    // Finds the edge between two consecutive nodes of a packed path like UnpackPath does
+    EdgeID FindPackedEdge(const NodeID from, const NodeID to) const
+    {
+        const auto &graph = facade->GetSearchGraph();
+        EdgeID smaller_edge_id = SPECIAL_EDGEID;
+        EdgeWeight edge_weight = std::numeric_limits<EdgeWeight>::max();
+        for (const auto edge_id : graph.GetAdjacentEdgeRange(from))
+        {
+            const auto &data = graph.GetSearchData(edge_id);
+            if (data.target == to && data.distance < edge_weight && data.forward)
+            {
+                smaller_edge_id = edge_id;
+                edge_weight = data.distance;
+            }
+        }
+
+        // if we don't find a forward edge, this edge must have been a downwards edge found by
+        // the reverse search
+        if (SPECIAL_EDGEID == smaller_edge_id)
+        {
+            for (const auto edge_id : graph.GetAdjacentEdgeRange(to))
+            {
+                const auto &data = graph.GetSearchData(edge_id);
+                if (data.target == from && data.distance < edge_weight && data.backward)
+                {
+                    smaller_edge_id = edge_id;
+                    edge_weight = data.distance;
+                }
+            }
+        }
+        BOOST_ASSERT_MSG(SPECIAL_EDGEID != smaller_edge_id, "edge id invalid");
+        return smaller_edge_id;
+    }
+
+    // Original edges of a shortcut from the unpacking cache, unpacks and caches them on a miss
+    UnpackingCache::ExpansionPtr
+    GetShortcutExpansion(const EdgeID shortcut, const NodeID from, const NodeID to) const
+    {
+        BOOST_ASSERT(unpacking_cache);
+        const auto data_version = facade->GetDataVersion();
+        if (auto cached = unpacking_cache->Get(data_version, shortcut))
+        {
+            return cached;
+        }
+
+        SearchStatistics *const statistics = SearchEngineData::GetStatistics();
+        auto expansion = std::make_shared<UnpackingCache::Expansion>();
+        std::stack<std::pair<NodeID, NodeID>> recursion_stack;
+        const NodeID middle_node_id = facade->GetEdgeData(shortcut).id;
+        recursion_stack.emplace(middle_node_id, to);
+        recursion_stack.emplace(from, middle_node_id);
+        while (!recursion_stack.empty())
+        {
+            const auto edge = recursion_stack.top();
+            recursion_stack.pop();
+
+            const EdgeID edge_id = FindPackedEdge(edge.first, edge.second);
+            const EdgeData &ed = facade->GetEdgeData(edge_id);
+            if (ed.shortcut && statistics)
+            {
+                ++statistics->unpacked_shortcuts;
+            }
+            if (ed.shortcut)
+            {
+                recursion_stack.emplace(ed.id, edge.second);
+                recursion_stack.emplace(edge.first, ed.id);
+            }
+            else
+            {
+                expansion->push_back(edge_id);
+            }
+        }
+
+        unpacking_cache->Add(data_version, shortcut, expansion);
+        return expansion;
+    }
+
+    struct PhantomLengths
+    {
+        // from the start of the segment to the phantom node
+        double before;
+        // from the phantom node to the end of the segment
+        double after;
+        // of the whole segment, as stored at the edges leaving it
+        double total;
+    };
+
+    // Measures the segment of a phantom node in the direction it is traversed in
+    PhantomLengths GetPhantomLengths(const PhantomNode &phantom,
+                                     const bool traversed_in_reverse) const
+    {
+        std::vector<NodeID> forward_geometry;
+        std::vector<NodeID> reverse_geometry;
+        facade->GetUncompressedGeometry(phantom.forward_packed_geometry_id, forward_geometry);
+        facade->GetUncompressedGeometry(phantom.reverse_packed_geometry_id, reverse_geometry);
+        BOOST_ASSERT(!forward_geometry.empty());
+        BOOST_ASSERT(forward_geometry.size() == reverse_geometry.size());
+
+        // geometries only store the target of each of their segments, the first node in
+        // forward direction is the last target of the reverse geometry
+        std::vector<util::Coordinate> coordinates;
+        coordinates.reserve(forward_geometry.size() + 1);
+        coordinates.push_back(facade->GetCoordinateOfNode(reverse_geometry.back()));
+        for (const auto node : forward_geometry)
+        {
+            coordinates.push_back(facade->GetCoordinateOfNode(node));
+        }
+
+        std::size_t phantom_segment = phantom.fwd_segment_position;
+        if (traversed_in_reverse)
+        {
+            std::reverse(coordinates.begin(), coordinates.end());
+            phantom_segment = forward_geometry.size() - 1 - phantom_segment;
+        }
+        BOOST_ASSERT(phantom_segment + 1 < coordinates.size());
+
+        using util::coordinate_calculation::haversineDistance;
+
+        std::vector<double> segment_lengths;
+        util::coordinate_calculation::haversineDistances(coordinates, segment_lengths);
+
+        PhantomLengths lengths{0., 0., 0.};
+        for (const auto segment : util::irange<std::size_t>(0UL, segment_lengths.size()))
+        {
+            const auto segment_length = segment_lengths[segment];
+            lengths.total += segment_length;
+            if (segment < phantom_segment)
+            {
+                lengths.before += segment_length;
+            }
+            else if (segment > phantom_segment)
+            {
+                lengths.after += segment_length;
+            }
+        }
+        lengths.before += haversineDistance(coordinates[phantom_segment], phantom.location);
+        lengths.after += haversineDistance(phantom.location, coordinates[phantom_segment + 1]);
+
+        return lengths;
+    }
 };
 }
 }
@@ -11,6 +11,13 @@
 #include <boost/assert.hpp>
 #include <boost/optional.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
 namespace osrm
 {
 namespace engine
@@ -27,9 +34,19 @@ class ShortestPathRouting final
     SearchEngineData &engine_working_data;
     const static constexpr bool DO_NOT_FORCE_LOOP = false;
 
+    // The searches of a leg from either node of its source phantom to either node of its target
+    // phantom, indexed by 2 * source direction + target direction with 0 for the forward node
+    struct LegSearches
+    {
+        std::array<int, 4> distances;
+        std::array<std::vector<NodeID>, 4> packed_paths;
+    };
+
   public:
-    ShortestPathRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
-        : super(facade), engine_working_data(engine_working_data)
+    ShortestPathRouting(DataFacadeT *facade,
+                        SearchEngineData &engine_working_data,
+                        UnpackingCache *unpacking_cache = nullptr)
+        : super(facade, unpacking_cache), engine_working_data(engine_working_data)
     {
     }
 
@@ -246,7 +263,8 @@ class ShortestPathRouting final
                     const std::vector<NodeID> &total_packed_path,
                     const std::vector<std::size_t> &packed_leg_begin,
                     const int shortest_path_length,
-                    InternalRouteResult &raw_route_data) const
+                    InternalRouteResult &raw_route_data,
+                    const PathUnpackMode mode = PathUnpackMode::Full) const
     {
         raw_route_data.unpacked_path_segments.resize(packed_leg_begin.size() - 1);
 
@@ -260,7 +278,13 @@ class ShortestPathRouting final
             super::UnpackPath(leg_begin,
                               leg_end,
                               unpack_phantom_node_pair,
-                              raw_route_data.unpacked_path_segments[current_leg]);
+                              raw_route_data.unpacked_path_segments[current_leg],
+                              mode);
+            if (current_leg + 2 == packed_leg_begin.size())
+            {
+                super::AddArrivalTrafficPenalty(
+                    *std::prev(leg_end), raw_route_data.unpacked_path_segments[current_leg]);
+            }
 
             raw_route_data.source_traversed_in_reverse.push_back(
                 (*leg_begin !=
@@ -271,23 +295,287 @@ class ShortestPathRouting final
         }
     }
 
+    // Searches a leg from a single node of its source phantom to a single node of its target
+    // phantom, the distance doesn't include the distance to the source
+    void SearchBetweenNodes(QueryHeap &forward_heap,
+                            QueryHeap &reverse_heap,
+                            QueryHeap &forward_core_heap,
+                            QueryHeap &reverse_core_heap,
+                            const PhantomNode &source_phantom,
+                            const PhantomNode &target_phantom,
+                            const bool from_reverse_node,
+                            const bool to_reverse_node,
+                            const bool needs_loop_forward,
+                            const bool needs_loop_backwards,
+                            int &distance,
+                            std::vector<NodeID> &packed_path) const
+    {
+        forward_heap.Clear();
+        reverse_heap.Clear();
+        const auto source_node = from_reverse_node ? source_phantom.reverse_segment_id.id
+                                                   : source_phantom.forward_segment_id.id;
+        const auto target_node = to_reverse_node ? target_phantom.reverse_segment_id.id
+                                                 : target_phantom.forward_segment_id.id;
+        forward_heap.Insert(source_node,
+                            from_reverse_node ? -source_phantom.GetReverseWeightPlusOffset()
+                                              : -source_phantom.GetForwardWeightPlusOffset(),
+                            source_node);
+        reverse_heap.Insert(target_node,
+                            to_reverse_node ? target_phantom.GetReverseWeightPlusOffset()
+                                            : target_phantom.GetForwardWeightPlusOffset(),
+                            target_node);
+
+        if (super::facade->GetCoreSize() > 0)
+        {
+            forward_core_heap.Clear();
+            reverse_core_heap.Clear();
+            super::SearchWithCore(forward_heap,
+                                  reverse_heap,
+                                  forward_core_heap,
+                                  reverse_core_heap,
+                                  distance,
+                                  packed_path,
+                                  needs_loop_forward,
+                                  needs_loop_backwards);
+        }
+        else
+        {
+            super::Search(forward_heap,
+                          reverse_heap,
+                          distance,
+                          packed_path,
+                          needs_loop_forward,
+                          needs_loop_backwards);
+        }
+    }
+
+    // Searches all legs at once in parallel, each one between all combinations of the nodes of
+    // its phantoms. Their searches don't depend on the distance to the source as the ones of the
+    // serial dynamic program do, so they are stitched together by a dynamic program over the
+    // node each leg arrives at afterwards. The legs are unpacked in parallel as well.
+    void ParallelSearch(const std::vector<PhantomNodes> &phantom_nodes_vector,
+                        const bool allow_uturn_at_waypoint,
+                        InternalRouteResult &raw_route_data,
+                        const PathUnpackMode mode) const
+    {
+        const auto number_of_legs = phantom_nodes_vector.size();
+        std::vector<LegSearches> leg_searches(number_of_legs);
+
+        const auto options = SearchEngineData::GetQueryControl();
+        const auto overlay = SearchEngineData::GetTrafficOverlay();
+        const auto cell_metric = SearchEngineData::GetCellMetric();
+        auto &heap_pool = SearchEngineData::GetHeapPool();
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, 4 * number_of_legs, 1),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                const SearchEngineData::ScopedQueryControl control(options);
+                const SearchEngineData::ScopedTrafficOverlay traffic(overlay);
+                const SearchEngineData::ScopedCellMetric metric(cell_metric);
+                const SearchEngineData::ScopedHeaps heaps(heap_pool);
+                engine_working_data.InitializeOrClearFirstHeaps(super::facade->GetNumberOfNodes());
+                engine_working_data.InitializeOrClearSecondHeaps(super::facade->GetNumberOfNodes());
+
+                QueryHeap &forward_heap = *engine_working_data.GetHeaps().forward_heap_1;
+                QueryHeap &reverse_heap = *engine_working_data.GetHeaps().reverse_heap_1;
+                QueryHeap &forward_core_heap = *engine_working_data.GetHeaps().forward_heap_2;
+                QueryHeap &reverse_core_heap = *engine_working_data.GetHeaps().reverse_heap_2;
+
+                for (auto index = range.begin(); index != range.end(); ++index)
+                {
+                    const auto leg = index / 4;
+                    const auto combination = index % 4;
+                    const bool from_reverse_node = combination / 2 == 1;
+                    const bool to_reverse_node = combination % 2 == 1;
+                    const auto &source_phantom = phantom_nodes_vector[leg].source_phantom;
+                    const auto &target_phantom = phantom_nodes_vector[leg].target_phantom;
+
+                    auto &distance = leg_searches[leg].distances[combination];
+                    distance = INVALID_EDGE_WEIGHT;
+                    if (!(from_reverse_node ? source_phantom.reverse_segment_id.enabled
+                                            : source_phantom.forward_segment_id.enabled) ||
+                        !(to_reverse_node ? target_phantom.reverse_segment_id.enabled
+                                          : target_phantom.forward_segment_id.enabled))
+                    {
+                        continue;
+                    }
+                    // the route can't end on a segment that the traffic overlay closes
+                    const bool ends_route = leg + 1 == number_of_legs;
+                    const auto target_node = to_reverse_node ? target_phantom.reverse_segment_id.id
+                                                             : target_phantom.forward_segment_id.id;
+                    if (ends_route &&
+                        super::GetArrivalTrafficPenalty(target_node) == INVALID_EDGE_WEIGHT)
+                    {
+                        continue;
+                    }
+
+                    // the same loops are forced as by the searches of the serial dynamic program
+                    bool needs_loop_forward = false;
+                    bool needs_loop_backwards = false;
+                    if (allow_uturn_at_waypoint)
+                    {
+                        const auto is_oneway_source = !(source_phantom.forward_segment_id.enabled &&
+                                                        source_phantom.reverse_segment_id.enabled);
+                        const auto is_oneway_target = !(target_phantom.forward_segment_id.enabled &&
+                                                        target_phantom.reverse_segment_id.enabled);
+                        needs_loop_forward =
+                            is_oneway_source &&
+                            super::NeedsLoopForward(source_phantom, target_phantom);
+                        needs_loop_backwards =
+                            is_oneway_target &&
+                            super::NeedsLoopBackwards(source_phantom, target_phantom);
+                    }
+                    else if (to_reverse_node)
+                    {
+                        needs_loop_backwards =
+                            super::NeedsLoopBackwards(source_phantom, target_phantom);
+                    }
+                    else
+                    {
+                        needs_loop_forward =
+                            super::NeedsLoopForward(source_phantom, target_phantom);
+                    }
+
+                    SearchBetweenNodes(forward_heap,
+                                       reverse_heap,
+                                       forward_core_heap,
+                                       reverse_core_heap,
+                                       source_phantom,
+                                       target_phantom,
+                                       from_reverse_node,
+                                       to_reverse_node,
+                                       needs_loop_forward,
+                                       needs_loop_backwards,
+                                       distance,
+                                       leg_searches[leg].packed_paths[combination]);
+                    if (ends_route)
+                    {
+                        super::AddArrivalTrafficPenalty(
+                            leg_searches[leg].packed_paths[combination], distance);
+                    }
+                }
+            });
+
+        // total_distances[leg + 1][direction] is the shortest route up to the end of the leg that
+        // arrives at the node of its target in the direction, taking the search of combinations
+        std::vector<std::array<int, 2>> total_distances(
+            number_of_legs + 1, std::array<int, 2>{{INVALID_EDGE_WEIGHT, INVALID_EDGE_WEIGHT}});
+        std::vector<std::array<std::size_t, 2>> combinations(number_of_legs);
+        const auto &first_source = phantom_nodes_vector.front().source_phantom;
+        total_distances[0][0] = first_source.forward_segment_id.enabled ? 0 : INVALID_EDGE_WEIGHT;
+        total_distances[0][1] = first_source.reverse_segment_id.enabled ? 0 : INVALID_EDGE_WEIGHT;
+
+        for (const auto leg : util::irange<std::size_t>(0UL, number_of_legs))
+        {
+            const auto &distances = leg_searches[leg].distances;
+            for (const auto combination : util::irange<std::size_t>(0UL, 4UL))
+            {
+                // with u-turns a leg can start at either node of its source, no matter which one
+                // the previous leg arrives at
+                const auto from = combination / 2;
+                const auto to = combination % 2;
+                const auto previous_distance =
+                    allow_uturn_at_waypoint
+                        ? std::min(total_distances[leg][0], total_distances[leg][1])
+                        : total_distances[leg][from];
+                if (previous_distance == INVALID_EDGE_WEIGHT ||
+                    distances[combination] == INVALID_EDGE_WEIGHT)
+                {
+                    continue;
+                }
+                const auto distance = previous_distance + distances[combination];
+                if (distance < total_distances[leg + 1][to])
+                {
+                    total_distances[leg + 1][to] = distance;
+                    combinations[leg][to] = combination;
+                }
+            }
+
+            // No path found for both target nodes?
+            if (total_distances[leg + 1][0] == INVALID_EDGE_WEIGHT &&
+                total_distances[leg + 1][1] == INVALID_EDGE_WEIGHT)
+            {
+                raw_route_data.shortest_path_length = INVALID_EDGE_WEIGHT;
+                return;
+            }
+        }
+
+        // follow the combinations back from the faster node of the last target
+        const auto &last_distances = total_distances.back();
+        std::size_t to = last_distances[0] > last_distances[1] ? 1 : 0;
+        std::vector<const std::vector<NodeID> *> packed_legs(number_of_legs);
+        for (auto leg = number_of_legs; leg > 0; --leg)
+        {
+            const auto combination = combinations[leg - 1][to];
+            packed_legs[leg - 1] = &leg_searches[leg - 1].packed_paths[combination];
+            const auto from = combination / 2;
+            to = (allow_uturn_at_waypoint && leg > 1)
+                     ? (total_distances[leg - 1][0] > total_distances[leg - 1][1] ? 1 : 0)
+                     : from;
+        }
+
+        raw_route_data.shortest_path_length = last_distances[0] > last_distances[1]
+                                                  ? last_distances[1]
+                                                  : last_distances[0];
+        raw_route_data.unpacked_path_segments.resize(number_of_legs);
+        for (const auto leg : util::irange<std::size_t>(0UL, number_of_legs))
+        {
+            const auto &packed_leg = *packed_legs[leg];
+            BOOST_ASSERT(!packed_leg.empty());
+            raw_route_data.source_traversed_in_reverse.push_back(
+                (packed_leg.front() !=
+                 phantom_nodes_vector[leg].source_phantom.forward_segment_id.id));
+            raw_route_data.target_traversed_in_reverse.push_back(
+                (packed_leg.back() !=
+                 phantom_nodes_vector[leg].target_phantom.forward_segment_id.id));
+        }
+
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_legs, 1),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              const SearchEngineData::ScopedTrafficOverlay traffic(overlay);
+                              const SearchEngineData::ScopedCellMetric metric(cell_metric);
+                              const SearchEngineData::ScopedHeaps heaps(heap_pool);
+                              for (auto leg = range.begin(); leg != range.end(); ++leg)
+                              {
+                                  super::UnpackPath(packed_legs[leg]->begin(),
+                                                    packed_legs[leg]->end(),
+                                                    phantom_nodes_vector[leg],
+                                                    raw_route_data.unpacked_path_segments[leg],
+                                                    mode);
+                                  if (leg + 1 == number_of_legs)
+                                  {
+                                      super::AddArrivalTrafficPenalty(
+                                          packed_legs[leg]->back(),
+                                          raw_route_data.unpacked_path_segments[leg]);
+                                  }
+                              }
+                          });
+    }
+
+    // With parallel set the legs are searched and unpacked in parallel, see ParallelSearch. The
+    // mode selects the fields of the path data that are unpacked.
     void operator()(const std::vector<PhantomNodes> &phantom_nodes_vector,
                     const boost::optional<bool> continue_straight_at_waypoint,
-                    InternalRouteResult &raw_route_data) const
+                    InternalRouteResult &raw_route_data,
+                    const bool parallel = false,
+                    const PathUnpackMode mode = PathUnpackMode::Full) const
     {
         const bool allow_uturn_at_waypoint =
             !(continue_straight_at_waypoint ? *continue_straight_at_waypoint
                                             : super::facade->GetContinueStraightDefault());
 
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-        engine_working_data.InitializeOrClearSecondThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
+        if (parallel && phantom_nodes_vector.size() > 1)
+        {
+            ParallelSearch(phantom_nodes_vector, allow_uturn_at_waypoint, raw_route_data, mode);
+            return;
+        }
+
+        engine_working_data.InitializeOrClearFirstHeaps(super::facade->GetNumberOfNodes());
+        engine_working_data.InitializeOrClearSecondHeaps(super::facade->GetNumberOfNodes());
 
-        QueryHeap &forward_heap = *(engine_working_data.forward_heap_1);
-        QueryHeap &reverse_heap = *(engine_working_data.reverse_heap_1);
-        QueryHeap &forward_core_heap = *(engine_working_data.forward_heap_2);
-        QueryHeap &reverse_core_heap = *(engine_working_data.reverse_heap_2);
+        QueryHeap &forward_heap = *engine_working_data.GetHeaps().forward_heap_1;
+        QueryHeap &reverse_heap = *engine_working_data.GetHeaps().reverse_heap_1;
+        QueryHeap &forward_core_heap = *engine_working_data.GetHeaps().forward_heap_2;
+        QueryHeap &reverse_core_heap = *engine_working_data.GetHeaps().reverse_heap_2;
 
         int total_distance_to_forward = 0;
         int total_distance_to_reverse = 0;
@@ -320,6 +608,19 @@ class ShortestPathRouting final
 
             bool search_to_forward_node = target_phantom.forward_segment_id.enabled;
             bool search_to_reverse_node = target_phantom.reverse_segment_id.enabled;
+            // the route can't end on a segment that the traffic overlay closes
+            const bool ends_route = current_leg + 1 == phantom_nodes_vector.size();
+            if (ends_route)
+            {
+                search_to_forward_node =
+                    search_to_forward_node &&
+                    super::GetArrivalTrafficPenalty(target_phantom.forward_segment_id.id) !=
+                        INVALID_EDGE_WEIGHT;
+                search_to_reverse_node =
+                    search_to_reverse_node &&
+                    super::GetArrivalTrafficPenalty(target_phantom.reverse_segment_id.id) !=
+                        INVALID_EDGE_WEIGHT;
+            }
 
             BOOST_ASSERT(!search_from_forward_node || source_phantom.forward_segment_id.enabled);
             BOOST_ASSERT(!search_from_reverse_node || source_phantom.reverse_segment_id.enabled);
@@ -379,13 +680,19 @@ class ShortestPathRouting final
                            packed_leg_to_reverse);
                 }
             }
+            if (ends_route)
+            {
+                super::AddArrivalTrafficPenalty(packed_leg_to_forward,
+                                                new_total_distance_to_forward);
+                super::AddArrivalTrafficPenalty(packed_leg_to_reverse,
+                                                new_total_distance_to_reverse);
+            }
 
             // No path found for both target nodes?
             if ((INVALID_EDGE_WEIGHT == new_total_distance_to_forward) &&
                 (INVALID_EDGE_WEIGHT == new_total_distance_to_reverse))
             {
                 raw_route_data.shortest_path_length = INVALID_EDGE_WEIGHT;
-                raw_route_data.alternative_path_length = INVALID_EDGE_WEIGHT;
                 return;
             }
 
@@ -493,7 +800,8 @@ class ShortestPathRouting final
                        total_packed_path_to_reverse,
                        packed_leg_to_reverse_begin,
                        total_distance_to_reverse,
-                       raw_route_data);
+                       raw_route_data,
+                       mode);
         }
         else
         {
@@ -505,7 +813,8 @@ class ShortestPathRouting final
                        total_packed_path_to_forward,
                        packed_leg_to_forward_begin,
                        total_distance_to_forward,
-                       raw_route_data);
+                       raw_route_data,
+                       mode);
         }
     }
 };
@@ -1,40 +1,416 @@
 #ifndef SEARCH_ENGINE_DATA_HPP
 #define SEARCH_ENGINE_DATA_HPP
 
-#include <boost/thread/tss.hpp>
-
+#include "engine/async.hpp"
+#include "engine/map_matching/hidden_markov_model.hpp"
+#include "engine/traffic_overlay.hpp"
 #include "util/binary_heap.hpp"
+#include "util/d_ary_heap.hpp"
+#include "util/query_metrics.hpp"
 #include "util/typedefs.hpp"
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 namespace osrm
 {
 namespace engine
 {
 
+class SearchEngineHeapPool;
+
+// How much work the searches of a query did, to tell whether a slow query had a large search
+// space. Core entries are the nodes where the searches entered the core. Unpacked shortcuts are
+// the shortcuts that unpacking expanded, one whose edges came from the unpacking cache counts once.
+struct SearchStatistics
+{
+    std::uint64_t settled_nodes = 0;
+    std::uint64_t relaxed_edges = 0;
+    std::uint64_t stalled_nodes = 0;
+    std::uint64_t core_entries = 0;
+    std::uint64_t unpacked_shortcuts = 0;
+
+    void Add(const SearchStatistics &other)
+    {
+        settled_nodes += other.settled_nodes;
+        relaxed_edges += other.relaxed_edges;
+        stalled_nodes += other.stalled_nodes;
+        core_entries += other.core_entries;
+        unpacked_shortcuts += other.unpacked_shortcuts;
+    }
+};
+
 struct HeapData
 {
     NodeID parent;
-    /* explicit */ HeapData(NodeID p) : parent(p) {}
+    // set by stall-on-demand, a stalled node is not expanded when it is settled
+    bool stalled;
+    /* explicit */ HeapData(NodeID p) : parent(p), stalled(false) {}
 };
 
 struct SearchEngineData
 {
-    using QueryHeap =
-        util::BinaryHeap<NodeID, NodeID, int, HeapData, util::UnorderedMapStorage<NodeID, int>>;
-    using SearchEngineHeapPtr = boost::thread_specific_ptr<QueryHeap>;
+    // Index storage backing each heap type. The timestamped array needs 8 bytes per node and
+    // heap but makes Clear() O(1); switch back to util::UnorderedMapStorage to trade speed for
+    // memory on very large graphs.
+    using QueryHeapStorage = util::TimestampedArrayStorage<NodeID, int>;
+    using ManyToManyHeapStorage = util::TimestampedArrayStorage<NodeID, int>;
+
+    // A 4-ary heap beats util::BinaryHeap in heap-bench for every storage. util::BinaryHeap
+    // and util::RadixHeap (monotone searches only) are drop-in replacements.
+    using QueryHeap = util::DAryHeap<NodeID, NodeID, int, HeapData, QueryHeapStorage, 4>;
+    using SearchEngineHeapPtr = std::unique_ptr<QueryHeap>;
+
+    using ManyToManyQueryHeap =
+        util::DAryHeap<NodeID, NodeID, int, HeapData, ManyToManyHeapStorage, 4>;
+    using ManyToManyHeapPtr = std::unique_ptr<ManyToManyQueryHeap>;
+
+    using HiddenMarkovModelPtr = std::unique_ptr<map_matching::HiddenMarkovModel>;
+
+    // The heaps a query searches on. They are created on first use and then only cleared, until
+    // a larger graph needs them to grow.
+    struct Heaps
+    {
+        SearchEngineHeapPtr forward_heap_1;
+        SearchEngineHeapPtr reverse_heap_1;
+        SearchEngineHeapPtr forward_heap_2;
+        SearchEngineHeapPtr reverse_heap_2;
+        SearchEngineHeapPtr forward_heap_3;
+        SearchEngineHeapPtr reverse_heap_3;
+        ManyToManyHeapPtr many_to_many_heap;
+        // unpacks the weights of the cells on paths of the multi-level Dijkstra
+        SearchEngineHeapPtr cell_heap;
+        // the arrays of the longest trace matched on these heaps so far
+        HiddenMarkovModelPtr hidden_markov_model;
+        // the nodes stall-on-demand spreads its distances to, kept to reuse the capacity
+        std::vector<std::pair<NodeID, std::int32_t>> stall_queue;
+
+        // heaps that were allocated or grown since the set was checked out
+        std::uint64_t allocations = 0;
+        // bytes of the index storage of the heaps, HEAP_BYTES_PER_NODE for every node they
+        // can address, accounted in util::QueryMetrics until the set is freed
+        std::size_t memory = 0;
+
+        Heaps() = default;
+        Heaps(const Heaps &) = delete;
+        Heaps &operator=(const Heaps &) = delete;
+        ~Heaps();
+    };
+
+    // the index storage of the heaps above takes a key and a generation for every node
+    static const constexpr std::size_t HEAP_BYTES_PER_NODE = 8;
+
+    // The heaps of the query on the calling thread, see ScopedHeaps. A thread that searches
+    // outside of a query checks out a set of the default pool that it keeps until it exits.
+    static Heaps &GetHeaps();
+
+    // The pool of the query on the calling thread, the default pool outside of a query. Queries
+    // pass it on to the threads they hand their searches to.
+    static SearchEngineHeapPool &GetHeapPool();
+
+    // The pool of the searches that run outside of an engine, like in tools and tests
+    static SearchEngineHeapPool &GetDefaultHeapPool();
+
+    // Checks out a set of heaps for the searches on the calling thread while it is alive and
+    // returns it to the pool afterwards. Every scope gets a set of its own, so a task of the
+    // same query that a waiting thread picks up doesn't clobber the heaps it waits with.
+    class ScopedHeaps
+    {
+      public:
+        explicit ScopedHeaps(SearchEngineHeapPool &pool);
+        ~ScopedHeaps();
+
+        ScopedHeaps(const ScopedHeaps &) = delete;
+        ScopedHeaps &operator=(const ScopedHeaps &) = delete;
+
+      private:
+        SearchEngineHeapPool &pool;
+        std::unique_ptr<Heaps> heaps;
+        Heaps *const outer_heaps;
+        SearchEngineHeapPool *const outer_pool;
+    };
+
+    void InitializeOrClearFirstHeaps(const unsigned number_of_nodes);
+
+    void InitializeOrClearSecondHeaps(const unsigned number_of_nodes);
+
+    void InitializeOrClearThirdHeaps(const unsigned number_of_nodes);
+
+    void InitializeOrClearManyToManyHeap(const unsigned number_of_nodes);
+
+    // Static, since the routing algorithms unpack paths without access to their engine data
+    static void InitializeOrClearCellHeap(const unsigned number_of_nodes);
+
+    // HiddenMarkovModel::Reset lays out the columns of a trace
+    void InitializeHiddenMarkovModel();
+
+    // Reserves memory for a large array of the query on the calling thread, like the durations
+    // of a table, until the query is done. False if that takes the query past its limit, it
+    // should fail with TooBig then instead of allocating the array. Always true outside of a
+    // query and on the threads that a query hands its searches to.
+    static bool ReserveQueryMemory(const std::size_t bytes);
+
+    // Accounts the memory that the query on the calling thread reserves while it is alive to
+    // its service in util::QueryMetrics, and holds the query to the limit
+    class ScopedQueryMemory
+    {
+      public:
+        ScopedQueryMemory(const util::QueryMetrics::Service service, const std::size_t limit);
+        ~ScopedQueryMemory();
+
+        ScopedQueryMemory(const ScopedQueryMemory &) = delete;
+        ScopedQueryMemory &operator=(const ScopedQueryMemory &) = delete;
+
+      private:
+        friend struct SearchEngineData;
+
+        const util::QueryMetrics::Service service;
+        const std::size_t limit;
+        std::size_t reserved;
+        bool rejected;
+        ScopedQueryMemory *const outer_memory;
+    };
+
+    // The statistics that the searches on the calling thread count into, nullptr if nobody
+    // collects them. Searches that a query hands to other threads count into statistics of
+    // their own, which the query adds to these afterwards.
+    static SearchStatistics *GetStatistics() { return CurrentStatistics(); }
+
+    // Collects the statistics of the searches on the calling thread while it is alive, nothing
+    // is collected for nullptr
+    class ScopedStatistics
+    {
+      public:
+        explicit ScopedStatistics(SearchStatistics &statistics) : ScopedStatistics(&statistics) {}
+        explicit ScopedStatistics(SearchStatistics *statistics)
+            : outer_statistics(CurrentStatistics())
+        {
+            CurrentStatistics() = statistics;
+        }
+        ~ScopedStatistics() { CurrentStatistics() = outer_statistics; }
+
+        ScopedStatistics(const ScopedStatistics &) = delete;
+        ScopedStatistics &operator=(const ScopedStatistics &) = delete;
+
+      private:
+        SearchStatistics *const outer_statistics;
+    };
+
+    // Throws QueryAborted if the query on the calling thread was cancelled or ran past its
+    // deadline. Does nothing for queries without a deadline or cancellation.
+    static void CheckQueryControl()
+    {
+        if (const AsyncOptions *const options = CurrentOptions())
+        {
+            CheckQueryControl(*options);
+        }
+    }
+    static void CheckQueryControl(const AsyncOptions &options);
+
+    // Like CheckQueryControl, but only checks every QUERY_CONTROL_POLL_INTERVAL calls. Cheap
+    // enough to be called for every node a search settles.
+    static void PollQueryControl()
+    {
+        if (const AsyncOptions *const options = CurrentOptions())
+        {
+            auto &polls = CurrentPolls();
+            if (++polls == QUERY_CONTROL_POLL_INTERVAL)
+            {
+                polls = 0;
+                CheckQueryControl(*options);
+            }
+        }
+    }
+
+    // The options of the query on the calling thread, nullptr if it has none. Queries pass
+    // them on to the threads they hand their searches to.
+    static const AsyncOptions *GetQueryControl() { return CurrentOptions(); }
+
+    // Applies the options to the searches on the calling thread while it is alive
+    class ScopedQueryControl
+    {
+      public:
+        explicit ScopedQueryControl(const AsyncOptions *const options)
+            : outer_options(CurrentOptions())
+        {
+            CurrentOptions() = options;
+        }
+        explicit ScopedQueryControl(const AsyncOptions &options) : ScopedQueryControl(&options)
+        {
+        }
+        ~ScopedQueryControl() { CurrentOptions() = outer_options; }
+
+        ScopedQueryControl(const ScopedQueryControl &) = delete;
+        ScopedQueryControl &operator=(const ScopedQueryControl &) = delete;
+
+      private:
+        const AsyncOptions *const outer_options;
+    };
+
+    // The traffic overlay of the query on the calling thread, nullptr if it has none or it is
+    // empty. Queries pass it on to the threads they hand their searches to.
+    static const TrafficOverlay *GetTrafficOverlay() { return CurrentTrafficOverlay(); }
+
+    // Applies the overlay to the searches on the calling thread while it is alive
+    class ScopedTrafficOverlay
+    {
+      public:
+        explicit ScopedTrafficOverlay(const TrafficOverlay *const overlay)
+            : outer_overlay(CurrentTrafficOverlay())
+        {
+            CurrentTrafficOverlay() = overlay && !overlay->Empty() ? overlay : nullptr;
+        }
+        ~ScopedTrafficOverlay() { CurrentTrafficOverlay() = outer_overlay; }
+
+        ScopedTrafficOverlay(const ScopedTrafficOverlay &) = delete;
+        ScopedTrafficOverlay &operator=(const ScopedTrafficOverlay &) = delete;
+
+      private:
+        const TrafficOverlay *const outer_overlay;
+    };
+
+    // The penalties hidden in shortcuts that the search on the calling thread found so far,
+    // nullptr outside of a search with a traffic overlay
+    static const HiddenTrafficPenalties *GetHiddenTrafficPenalties()
+    {
+        return CurrentHiddenTrafficPenalties();
+    }
+
+    class ScopedHiddenTrafficPenalties
+    {
+      public:
+        explicit ScopedHiddenTrafficPenalties(const HiddenTrafficPenalties &penalties)
+            : outer_penalties(CurrentHiddenTrafficPenalties())
+        {
+            CurrentHiddenTrafficPenalties() = &penalties;
+        }
+        ~ScopedHiddenTrafficPenalties() { CurrentHiddenTrafficPenalties() = outer_penalties; }
+
+        ScopedHiddenTrafficPenalties(const ScopedHiddenTrafficPenalties &) = delete;
+        ScopedHiddenTrafficPenalties &operator=(const ScopedHiddenTrafficPenalties &) = delete;
+
+      private:
+        const HiddenTrafficPenalties *const outer_penalties;
+    };
+
+    // The metric of the cells that the multi-level searches of the query on the calling thread
+    // use, 0 unless the query excludes classes. Queries pass it on to the threads they hand
+    // their searches to.
+    static std::uint32_t GetCellMetric() { return CurrentCellMetric(); }
+
+    class ScopedCellMetric
+    {
+      public:
+        explicit ScopedCellMetric(const std::uint32_t metric) : outer_metric(CurrentCellMetric())
+        {
+            CurrentCellMetric() = metric;
+        }
+        ~ScopedCellMetric() { CurrentCellMetric() = outer_metric; }
+
+        ScopedCellMetric(const ScopedCellMetric &) = delete;
+        ScopedCellMetric &operator=(const ScopedCellMetric &) = delete;
+
+      private:
+        const std::uint32_t outer_metric;
+    };
+
+  private:
+    static Heaps *&CurrentHeaps()
+    {
+        static thread_local Heaps *heaps = nullptr;
+        return heaps;
+    }
+
+    static SearchEngineHeapPool *&CurrentHeapPool()
+    {
+        static thread_local SearchEngineHeapPool *pool = nullptr;
+        return pool;
+    }
+
+    static ScopedQueryMemory *&CurrentQueryMemory()
+    {
+        static thread_local ScopedQueryMemory *memory = nullptr;
+        return memory;
+    }
+
+    static SearchStatistics *&CurrentStatistics()
+    {
+        static thread_local SearchStatistics *statistics = nullptr;
+        return statistics;
+    }
+
+    static const AsyncOptions *&CurrentOptions()
+    {
+        static thread_local const AsyncOptions *options = nullptr;
+        return options;
+    }
+
+    static const TrafficOverlay *&CurrentTrafficOverlay()
+    {
+        static thread_local const TrafficOverlay *overlay = nullptr;
+        return overlay;
+    }
+
+    static const HiddenTrafficPenalties *&CurrentHiddenTrafficPenalties()
+    {
+        static thread_local const HiddenTrafficPenalties *penalties = nullptr;
+        return penalties;
+    }
+
+    static std::uint32_t &CurrentCellMetric()
+    {
+        static thread_local std::uint32_t metric = 0;
+        return metric;
+    }
+
+    static unsigned &CurrentPolls()
+    {
+        static thread_local unsigned polls = 0;
+        return polls;
+    }
+
+    static const constexpr unsigned QUERY_CONTROL_POLL_INTERVAL = 1024;
+};
+
+// How often the sets of heaps of a pool were checked out and how many it holds. A pool only
+// creates a set when all of its sets are in use, so it holds as many as queries and their
+// parallel searches ran at the same time.
+struct SearchEngineHeapPoolStatistics
+{
+    std::uint64_t checkouts = 0;
+    // checkouts that got a set that an earlier query used
+    std::uint64_t reuses = 0;
+    // heaps that were allocated, or grown for a larger graph
+    std::uint64_t allocations = 0;
+    std::size_t heap_sets = 0;
+    std::size_t heap_sets_in_use = 0;
+};
+
+// The sets of heaps of an engine. Queries check them out for as long as they run instead of
+// every thread keeping heaps of its own, so the heaps in memory follow the number of queries
+// that run at the same time instead of the number of threads that ever ran one.
+class SearchEngineHeapPool
+{
+  public:
+    SearchEngineHeapPool() = default;
+    SearchEngineHeapPool(const SearchEngineHeapPool &) = delete;
+    SearchEngineHeapPool &operator=(const SearchEngineHeapPool &) = delete;
 
-    static SearchEngineHeapPtr forward_heap_1;
-    static SearchEngineHeapPtr reverse_heap_1;
-    static SearchEngineHeapPtr forward_heap_2;
-    static SearchEngineHeapPtr reverse_heap_2;
-    static SearchEngineHeapPtr forward_heap_3;
-    static SearchEngineHeapPtr reverse_heap_3;
+    std::unique_ptr<SearchEngineData::Heaps> Acquire();
 
-    void InitializeOrClearFirstThreadLocalStorage(const unsigned number_of_nodes);
+    void Release(std::unique_ptr<SearchEngineData::Heaps> heaps);
 
-    void InitializeOrClearSecondThreadLocalStorage(const unsigned number_of_nodes);
+    SearchEngineHeapPoolStatistics GetStatistics() const;
 
-    void InitializeOrClearThirdThreadLocalStorage(const unsigned number_of_nodes);
+  private:
+    mutable std::mutex mutex;
+    // the most recently used set is handed out first, its heaps are most likely still cached
+    std::vector<std::unique_ptr<SearchEngineData::Heaps>> idle_heaps;
+    SearchEngineHeapPoolStatistics statistics;
 };
 }
 }
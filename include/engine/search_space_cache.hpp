@@ -0,0 +1,98 @@
+#ifndef SEARCH_SPACE_CACHE_HPP
+#define SEARCH_SPACE_CACHE_HPP
+
+#include "engine/phantom_node.hpp"
+#include "util/sharded_lru_cache.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/functional/hash.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+// A node settled by an upward search, with the distance it was settled at and the node it was
+// reached from. The phantom nodes are their own parents.
+struct SearchSpaceEntry
+{
+    NodeID node;
+    EdgeWeight distance;
+    NodeID parent;
+};
+
+// The segments a phantom node starts on, the offsets it starts with and the direction of the
+// search, which is all an upward search space depends on
+struct SearchSpaceKey
+{
+    SearchSpaceKey(const PhantomNode &phantom, const bool forward_direction)
+        : forward_segment_id(phantom.forward_segment_id.enabled ? phantom.forward_segment_id.id
+                                                                : SPECIAL_SEGMENTID),
+          reverse_segment_id(phantom.reverse_segment_id.enabled ? phantom.reverse_segment_id.id
+                                                                : SPECIAL_SEGMENTID),
+          forward_weight(phantom.forward_segment_id.enabled ? phantom.GetForwardWeightPlusOffset()
+                                                            : INVALID_EDGE_WEIGHT),
+          reverse_weight(phantom.reverse_segment_id.enabled ? phantom.GetReverseWeightPlusOffset()
+                                                            : INVALID_EDGE_WEIGHT),
+          forward_direction(forward_direction)
+    {
+    }
+
+    bool operator==(const SearchSpaceKey &other) const
+    {
+        return forward_segment_id == other.forward_segment_id &&
+               reverse_segment_id == other.reverse_segment_id &&
+               forward_weight == other.forward_weight && reverse_weight == other.reverse_weight &&
+               forward_direction == other.forward_direction;
+    }
+
+    // SPECIAL_SEGMENTID for a disabled segment
+    NodeID forward_segment_id;
+    NodeID reverse_segment_id;
+    EdgeWeight forward_weight;
+    EdgeWeight reverse_weight;
+    bool forward_direction;
+};
+
+struct SearchSpaceKeyHash
+{
+    std::size_t operator()(const SearchSpaceKey &key) const
+    {
+        std::size_t seed = 0;
+        boost::hash_combine(seed, key.forward_segment_id);
+        boost::hash_combine(seed, key.reverse_segment_id);
+        boost::hash_combine(seed, key.forward_weight);
+        boost::hash_combine(seed, key.reverse_weight);
+        boost::hash_combine(seed, key.forward_direction);
+        return seed;
+    }
+};
+
+// Bounded LRU cache of the upward search spaces of phantom nodes in the contraction hierarchy,
+// shared by all queries of an engine.
+//
+// Depots and hubs are part of most tables, and their upward searches come out the same every
+// time. The distance tables look up the search space of every source and target here, and only
+// search the upward graph for the ones that are missing. Lookups pass the data version, since a
+// new dataset can have other weights for the same graph.
+class SearchSpaceCache final
+    : public util::ShardedLRUCache<SearchSpaceKey,
+                                   std::shared_ptr<const std::vector<SearchSpaceEntry>>,
+                                   SearchSpaceKeyHash>
+{
+  public:
+    using Entry = SearchSpaceEntry;
+    // the settled nodes in the order they were settled, so by distance
+    using SearchSpace = std::vector<Entry>;
+    using SearchSpacePtr = std::shared_ptr<const SearchSpace>;
+
+    using ShardedLRUCache::ShardedLRUCache;
+};
+}
+}
+
+#endif // SEARCH_SPACE_CACHE_HPP
@@ -0,0 +1,69 @@
+#ifndef ENGINE_SESSIONS_HPP
+#define ENGINE_SESSIONS_HPP
+
+#include "util/sharded_lru_cache.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Bounded LRU of the state that queries of a client keep between calls, shared by all queries
+// of an engine.
+//
+// Clients that stop calling never finish their sessions, so the least recently used sessions
+// are dropped once there are more than the capacity. The sessions are shared pointers with
+// their own locks: a query holds on to its session while it updates it, even if the session is
+// dropped meanwhile, and queries on different sessions don't wait for each other.
+template <typename SessionT> class Sessions
+{
+  public:
+    using Session = std::shared_ptr<SessionT>;
+
+    explicit Sessions(const std::size_t capacity) : sessions(capacity, 1)
+    {
+        BOOST_ASSERT(capacity > 0);
+    }
+
+    // The session with the id, a new one if there is none
+    Session Get(const std::string &id)
+    {
+        return sessions.GetOrAdd(VERSION, id, [] { return std::make_shared<SessionT>(); });
+    }
+
+    // Drops the session if it is still the one with the id
+    void Remove(const std::string &id, const Session &session)
+    {
+        sessions.Remove(VERSION, id, [&](const Session &current) { return current == session; });
+    }
+
+    std::size_t GetNumberOfSessions() const
+    {
+        return sessions.GetStatistics().number_of_entries;
+    }
+
+    std::uint64_t GetNumberOfCreatedSessions() const { return sessions.GetNumberOfMisses(); }
+
+    // Sessions that were dropped before they were finished
+    std::uint64_t GetNumberOfEvictedSessions() const { return sessions.GetNumberOfEvictions(); }
+
+  private:
+    // sessions don't depend on the data
+    static constexpr unsigned VERSION = 0;
+
+    // a single shard, so the least recently used session of all is dropped
+    util::ShardedLRUCache<std::string, Session> sessions;
+};
+
+template <typename SessionT> constexpr unsigned Sessions<SessionT>::VERSION;
+}
+}
+
+#endif // ENGINE_SESSIONS_HPP
@@ -0,0 +1,84 @@
+#ifndef SNAPPING_CACHE_HPP
+#define SNAPPING_CACHE_HPP
+
+#include "engine/phantom_node.hpp"
+#include "util/coordinate.hpp"
+#include "util/sharded_lru_cache.hpp"
+
+#include <boost/functional/hash.hpp>
+#include <boost/optional.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace osrm
+{
+namespace engine
+{
+
+// A coordinate with the bearing and radius it was snapped with. Coordinates are not rounded any
+// further: the phantom nodes store the input coordinate, and a rounded one would change the
+// responses.
+struct SnappingCacheKey
+{
+    SnappingCacheKey(const util::Coordinate coordinate,
+                     const boost::optional<double> radius,
+                     const short bearing,
+                     const short range)
+        : lon(static_cast<std::int32_t>(coordinate.lon)),
+          lat(static_cast<std::int32_t>(coordinate.lat)), radius(radius ? *radius : -1.),
+          bearing(bearing), range(range)
+    {
+    }
+
+    // a coordinate snapped without any bearing filter
+    SnappingCacheKey(const util::Coordinate coordinate, const boost::optional<double> radius)
+        : SnappingCacheKey(coordinate, radius, -1, -1)
+    {
+    }
+
+    bool operator==(const SnappingCacheKey &other) const
+    {
+        return lon == other.lon && lat == other.lat && radius == other.radius &&
+               bearing == other.bearing && range == other.range;
+    }
+
+    std::int32_t lon;
+    std::int32_t lat;
+    // negative if no radius was given
+    double radius;
+    // negative if no bearing was given
+    short bearing;
+    short range;
+};
+
+struct SnappingCacheKeyHash
+{
+    std::size_t operator()(const SnappingCacheKey &key) const
+    {
+        std::size_t seed = 0;
+        boost::hash_combine(seed, key.lon);
+        boost::hash_combine(seed, key.lat);
+        boost::hash_combine(seed, key.radius);
+        boost::hash_combine(seed, key.bearing);
+        boost::hash_combine(seed, key.range);
+        return seed;
+    }
+};
+
+// Bounded LRU cache of snapped coordinates that is shared by all queries of an engine.
+//
+// Fleet clients send the same depots and customers over and over, so route, table and trip
+// queries look up the phantom nodes of every coordinate here before searching the r-tree.
+// Lookups pass the checksum of the data, since the phantom nodes refer to the edges of the
+// dataset they were snapped on.
+class SnappingCache final
+    : public util::ShardedLRUCache<SnappingCacheKey, PhantomNodePair, SnappingCacheKeyHash>
+{
+  public:
+    using ShardedLRUCache::ShardedLRUCache;
+};
+}
+}
+
+#endif // SNAPPING_CACHE_HPP
@@ -35,12 +35,14 @@ namespace engine
 
 /**
  * Status for indicating query success or failure.
- * \see OSRM
+ * Timeout is a failure of a query that ran past its deadline.
+ * \see OSRM, EngineConfig, AsyncOptions
  */
 enum class Status
 {
     Ok,
-    Error
+    Error,
+    Timeout
 };
 }
 }
@@ -0,0 +1,24 @@
+#ifndef TABLE_SESSIONS_HPP
+#define TABLE_SESSIONS_HPP
+
+#include "engine/routing_algorithms/many_to_many.hpp"
+#include "engine/sessions.hpp"
+
+#include <cstddef>
+
+namespace osrm
+{
+namespace engine
+{
+
+// The sessions of incrementally updated distance tables, clients that stop updating a table
+// never tell us
+class TableSessions final : public Sessions<routing_algorithms::ManyToManyTableSession>
+{
+  public:
+    explicit TableSessions(const std::size_t capacity_) : Sessions(capacity_) {}
+};
+}
+}
+
+#endif // TABLE_SESSIONS_HPP
@@ -0,0 +1,94 @@
+#ifndef TILE_CACHE_HPP
+#define TILE_CACHE_HPP
+
+#include "extractor/edge_based_node.hpp"
+#include "util/coordinate.hpp"
+#include "util/sharded_lru_cache.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+// A segment of the r-tree with the attributes that tiles show for it
+struct TileEdge
+{
+    extractor::EdgeBasedNode data;
+    util::Coordinate source;
+    util::Coordinate target;
+    EdgeWeight forward_weight;
+    EdgeWeight reverse_weight;
+    DatasourceID forward_datasource;
+    DatasourceID reverse_datasource;
+    // in meters, precomputed by osrm-extract or measured
+    double length;
+};
+
+using TileEdges = std::vector<TileEdge>;
+
+struct TileCacheKeyHash
+{
+    std::size_t operator()(const std::uint64_t key) const
+    {
+        // neighbouring tiles go to different shards
+        return std::hash<std::uint64_t>{}(key ^ (key >> 29));
+    }
+};
+
+// Bounded LRU index of the segments in tiles of INDEX_ZOOM that is shared by all tile queries of
+// an engine.
+//
+// Debug maps request the tiles of the same area at every zoom level from INDEX_ZOOM on. Their
+// segments are all inside of the tile of INDEX_ZOOM that contains them, which is searched in the
+// r-tree once, with the weights and datasources of its segments unpacked from their geometries.
+// The tiles of the higher zoom levels only pick its segments that intersect them. Lookups pass
+// the checksum of the data, and a tile that is evicted lives on until the query that renders it
+// is done.
+class TileCache final : private util::ShardedLRUCache<std::uint64_t,
+                                                      std::shared_ptr<const TileEdges>,
+                                                      TileCacheKeyHash>
+{
+  public:
+    static constexpr unsigned INDEX_ZOOM = 13;
+
+    using ShardedLRUCache::ShardedLRUCache;
+    using ShardedLRUCache::GetNumberOfHits;
+    using ShardedLRUCache::GetNumberOfMisses;
+    using ShardedLRUCache::GetHitRate;
+
+    // The segments of the tile of INDEX_ZOOM, nullptr if it is not cached
+    std::shared_ptr<const TileEdges>
+    Get(const unsigned data_checksum, const unsigned x, const unsigned y)
+    {
+        return ShardedLRUCache::Get(data_checksum, MakeKey(x, y));
+    }
+
+    void Add(const unsigned data_checksum,
+             const unsigned x,
+             const unsigned y,
+             std::shared_ptr<const TileEdges> edges)
+    {
+        BOOST_ASSERT(edges);
+        ShardedLRUCache::Add(data_checksum, MakeKey(x, y), std::move(edges));
+    }
+
+  private:
+    static std::uint64_t MakeKey(const unsigned x, const unsigned y)
+    {
+        return (static_cast<std::uint64_t>(x) << 32) | y;
+    }
+};
+}
+}
+
+#endif // TILE_CACHE_HPP
@@ -0,0 +1,135 @@
+#ifndef TRAFFIC_OVERLAY_HPP
+#define TRAFFIC_OVERLAY_HPP
+
+#include "storage/traffic_overlay.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+// The live traffic penalties of edge-based nodes that the searches add to the weights of the
+// hierarchy, see storage/traffic_overlay.hpp.
+//
+// An incident touches a few nodes of a graph with millions, so almost every lookup is for a
+// node without a penalty. The nodes are hashed into a bitset with at least 16 bits per penalty,
+// which rules out most of them with a single bit test and no cache miss. Only the nodes whose
+// bit is set are looked up in the sorted penalties.
+class TrafficOverlay
+{
+  public:
+    static const constexpr EdgeWeight CLOSED = storage::TRAFFIC_CLOSED;
+
+    TrafficOverlay() : shift(64 - 6), version(0) {}
+
+    // the penalties need to be sorted by node, each node once
+    TrafficOverlay(std::vector<storage::TrafficPenalty> penalties_, const std::uint64_t version_)
+        : penalties(std::move(penalties_)), shift(64 - 6), version(version_)
+    {
+        BOOST_ASSERT(std::is_sorted(penalties.begin(),
+                                    penalties.end(),
+                                    [](const storage::TrafficPenalty &lhs,
+                                       const storage::TrafficPenalty &rhs) {
+                                        return lhs.node < rhs.node;
+                                    }));
+        while ((std::size_t{1} << (64 - shift)) < 16 * penalties.size())
+        {
+            --shift;
+        }
+        bits.resize((std::size_t{1} << (64 - shift)) / 64, 0);
+        for (const auto &penalty : penalties)
+        {
+            const auto bit = GetBit(penalty.node);
+            bits[bit / 64] |= std::uint64_t{1} << (bit % 64);
+        }
+    }
+
+    // 0 for nodes without a penalty, CLOSED for closed nodes
+    EdgeWeight GetPenalty(const NodeID node) const
+    {
+        if (penalties.empty())
+        {
+            return 0;
+        }
+        const auto bit = GetBit(node);
+        if ((bits[bit / 64] & (std::uint64_t{1} << (bit % 64))) == 0)
+        {
+            return 0;
+        }
+        const auto penalty = std::lower_bound(
+            penalties.begin(),
+            penalties.end(),
+            node,
+            [](const storage::TrafficPenalty &lhs, const NodeID rhs) { return lhs.node < rhs; });
+        return penalty != penalties.end() && penalty->node == node ? penalty->penalty : 0;
+    }
+
+    bool Empty() const { return penalties.empty(); }
+    std::size_t Size() const { return penalties.size(); }
+    // of the overlay in shared memory it was read from, 0 for the empty overlay
+    std::uint64_t GetVersion() const { return version; }
+
+  private:
+    std::size_t GetBit(const NodeID node) const
+    {
+        return static_cast<std::size_t>((static_cast<std::uint64_t>(node) *
+                                         11400714819323198485ull) >>
+                                        shift);
+    }
+
+    std::vector<storage::TrafficPenalty> penalties;
+    std::vector<std::uint64_t> bits;
+    unsigned shift;
+    std::uint64_t version;
+};
+
+// The penalties of the nodes that shortcuts skip over, which the searches don't settle and so
+// can't penalize. Search finds them by unpacking the shortcuts of its path and searches again
+// with them until its path has no unknown penalties left. Keyed by the nodes of the shortcut in
+// travel direction.
+class HiddenTrafficPenalties
+{
+  public:
+    // 0 for edges that weren't unpacked yet
+    EdgeWeight Get(const NodeID from, const NodeID to) const
+    {
+        if (penalties.empty())
+        {
+            return 0;
+        }
+        const auto penalty = penalties.find(GetKey(from, to));
+        return penalty == penalties.end() ? 0 : penalty->second;
+    }
+
+    bool Contains(const NodeID from, const NodeID to) const
+    {
+        return penalties.count(GetKey(from, to)) > 0;
+    }
+
+    void Set(const NodeID from, const NodeID to, const EdgeWeight penalty)
+    {
+        penalties[GetKey(from, to)] = penalty;
+    }
+
+  private:
+    static std::uint64_t GetKey(const NodeID from, const NodeID to)
+    {
+        return (static_cast<std::uint64_t>(from) << 32) | to;
+    }
+
+    std::unordered_map<std::uint64_t, EdgeWeight> penalties;
+};
+}
+}
+
+#endif // TRAFFIC_OVERLAY_HPP
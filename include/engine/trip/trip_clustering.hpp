@@ -0,0 +1,223 @@
+#ifndef TRIP_CLUSTERING_HPP
+#define TRIP_CLUSTERING_HPP
+
+#include "engine/trip/trip_held_karp.hpp"
+#include "util/coordinate.hpp"
+#include "util/coordinate_calculation.hpp"
+#include "util/dist_table_wrapper.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace trip
+{
+
+// the paths through clusters are computed exactly, with an extra location for their open ends
+const constexpr std::size_t CLUSTER_MAX_LOCATIONS = HELD_KARP_MAX_LOCATIONS - 1;
+
+namespace detail
+{
+// the legs to and from the extra location of an open path besides its ends, larger than any path
+// but with room to add a few of them to the states of Held-Karp
+const constexpr EdgeWeight OPEN_PATH_CLOSED = HELD_KARP_UNREACHED / 4;
+
+inline void splitLocations(const std::vector<util::Coordinate> &coordinates,
+                           const std::vector<NodeID>::iterator begin,
+                           const std::vector<NodeID>::iterator end,
+                           const std::size_t max_cluster_size,
+                           std::vector<std::vector<NodeID>> &clusters)
+{
+    const auto size = static_cast<std::size_t>(end - begin);
+    if (size <= max_cluster_size)
+    {
+        clusters.emplace_back(begin, end);
+        return;
+    }
+
+    std::int32_t min_lon = std::numeric_limits<std::int32_t>::max();
+    std::int32_t max_lon = std::numeric_limits<std::int32_t>::min();
+    std::int32_t min_lat = std::numeric_limits<std::int32_t>::max();
+    std::int32_t max_lat = std::numeric_limits<std::int32_t>::min();
+    for (auto location = begin; location != end; ++location)
+    {
+        const auto lon = static_cast<std::int32_t>(coordinates[*location].lon);
+        const auto lat = static_cast<std::int32_t>(coordinates[*location].lat);
+        min_lon = std::min(min_lon, lon);
+        max_lon = std::max(max_lon, lon);
+        min_lat = std::min(min_lat, lat);
+        max_lat = std::max(max_lat, lat);
+    }
+    // degrees of longitude get shorter towards the poles
+    const auto middle_lat = (static_cast<double>(min_lat) + max_lat) / 2 / COORDINATE_PRECISION;
+    const auto lon_extent =
+        (static_cast<double>(max_lon) - min_lon) * std::cos(middle_lat * M_PI / 180.);
+    const auto lat_extent = static_cast<double>(max_lat) - min_lat;
+    const bool split_by_lon = lon_extent >= lat_extent;
+
+    const auto middle = begin + size / 2;
+    std::nth_element(begin, middle, end, [&](const NodeID lhs, const NodeID rhs) {
+        return split_by_lon ? std::make_pair(coordinates[lhs].lon, lhs) <
+                                  std::make_pair(coordinates[rhs].lon, rhs)
+                            : std::make_pair(coordinates[lhs].lat, lhs) <
+                                  std::make_pair(coordinates[rhs].lat, rhs);
+    });
+    splitLocations(coordinates, begin, middle, max_cluster_size, clusters);
+    splitLocations(coordinates, middle, end, max_cluster_size, clusters);
+}
+}
+
+// Splits the locations into clusters of at most max_cluster_size nearby locations. The
+// locations are halved at the median of the wider side of their bounding box until they fit,
+// so the clusters have more than half of max_cluster_size locations unless there are fewer.
+inline std::vector<std::vector<NodeID>>
+ClusterLocations(const std::vector<util::Coordinate> &coordinates,
+                 const std::size_t max_cluster_size)
+{
+    BOOST_ASSERT(max_cluster_size > 0);
+    std::vector<NodeID> locations(coordinates.size());
+    std::iota(locations.begin(), locations.end(), 0);
+    std::vector<std::vector<NodeID>> clusters;
+    detail::splitLocations(
+        coordinates, locations.begin(), locations.end(), max_cluster_size, clusters);
+    return clusters;
+}
+
+// The location of the cluster that is closest to the center of its locations
+inline NodeID GetClusterCenter(const std::vector<NodeID> &cluster,
+                               const std::vector<util::Coordinate> &coordinates)
+{
+    BOOST_ASSERT(!cluster.empty());
+    std::int64_t lon_sum = 0;
+    std::int64_t lat_sum = 0;
+    for (const auto location : cluster)
+    {
+        lon_sum += static_cast<std::int32_t>(coordinates[location].lon);
+        lat_sum += static_cast<std::int32_t>(coordinates[location].lat);
+    }
+    const util::Coordinate center{
+        util::FixedLongitude{static_cast<std::int32_t>(lon_sum / std::int64_t(cluster.size()))},
+        util::FixedLatitude{static_cast<std::int32_t>(lat_sum / std::int64_t(cluster.size()))}};
+    return *std::min_element(
+        cluster.begin(), cluster.end(), [&](const NodeID lhs, const NodeID rhs) {
+            return util::coordinate_calculation::haversineDistance(coordinates[lhs], center) <
+                   util::coordinate_calculation::haversineDistance(coordinates[rhs], center);
+        });
+}
+
+// Picks the locations that a round trip through the clusters in their order enters and leaves
+// every cluster by: the closest pair of locations of every cluster and the next one. A cluster
+// is left by another location than it is entered by, unless it has only one.
+inline std::vector<std::pair<NodeID, NodeID>>
+GetClusterEnds(const std::vector<std::vector<NodeID>> &clusters,
+               const std::vector<util::Coordinate> &coordinates)
+{
+    BOOST_ASSERT(clusters.size() > 1);
+    std::vector<std::pair<NodeID, NodeID>> ends(clusters.size(),
+                                                std::make_pair(SPECIAL_NODEID, SPECIAL_NODEID));
+    for (std::size_t cluster = 0; cluster < clusters.size(); ++cluster)
+    {
+        const auto next_cluster = (cluster + 1) % clusters.size();
+        // the entry of this cluster and the exit of the next one, if they are picked already
+        const auto entry = clusters[cluster].size() > 1 ? ends[cluster].first : SPECIAL_NODEID;
+        const auto next_exit =
+            clusters[next_cluster].size() > 1 ? ends[next_cluster].second : SPECIAL_NODEID;
+
+        auto best_distance = std::numeric_limits<double>::max();
+        for (const auto from : clusters[cluster])
+        {
+            if (from == entry)
+            {
+                continue;
+            }
+            for (const auto to : clusters[next_cluster])
+            {
+                if (to == next_exit)
+                {
+                    continue;
+                }
+                const auto distance =
+                    util::coordinate_calculation::haversineDistance(coordinates[from],
+                                                                    coordinates[to]);
+                if (distance < best_distance)
+                {
+                    best_distance = distance;
+                    ends[cluster].second = from;
+                    ends[next_cluster].first = to;
+                }
+            }
+        }
+    }
+    return ends;
+}
+
+// Computes the shortest path from first through all other locations to last exactly. The path
+// is the round trip of Held-Karp through the locations and an extra one, which only the legs
+// from last and to first reach without a large duration.
+inline std::vector<NodeID> OpenPathTrip(const std::vector<NodeID> &locations,
+                                        const NodeID first,
+                                        const NodeID last,
+                                        const util::DistTableWrapper<EdgeWeight> &dist_table)
+{
+    BOOST_ASSERT(locations.size() <= CLUSTER_MAX_LOCATIONS);
+    BOOST_ASSERT(std::find(locations.begin(), locations.end(), first) != locations.end());
+    BOOST_ASSERT(std::find(locations.begin(), locations.end(), last) != locations.end());
+    BOOST_ASSERT(first != last || locations.size() == 1);
+    if (locations.size() < 3)
+    {
+        return first == last ? std::vector<NodeID>{first} : std::vector<NodeID>{first, last};
+    }
+
+    const auto size = locations.size();
+    const auto extra = static_cast<NodeID>(size);
+    std::vector<EdgeWeight> table((size + 1) * (size + 1), detail::OPEN_PATH_CLOSED);
+    for (std::size_t from = 0; from < size; ++from)
+    {
+        for (std::size_t to = 0; to < size; ++to)
+        {
+            table[from * (size + 1) + to] = dist_table(locations[from], locations[to]);
+        }
+        if (locations[from] == last)
+        {
+            table[from * (size + 1) + extra] = 0;
+        }
+        if (locations[from] == first)
+        {
+            table[extra * (size + 1) + from] = 0;
+        }
+    }
+    table[extra * (size + 1) + extra] = 0;
+    const util::DistTableWrapper<EdgeWeight> open_table(std::move(table), size + 1);
+
+    std::vector<NodeID> indices(size + 1);
+    indices.front() = extra;
+    std::iota(indices.begin() + 1, indices.end(), 0);
+    const auto round_trip = HeldKarpTrip(indices.begin(), indices.end(), size + 1, open_table);
+    BOOST_ASSERT(round_trip.front() == extra);
+
+    std::vector<NodeID> path;
+    path.reserve(size);
+    for (auto index = round_trip.begin() + 1; index != round_trip.end(); ++index)
+    {
+        path.push_back(locations[*index]);
+    }
+    BOOST_ASSERT(path.front() == first && path.back() == last);
+    return path;
+}
+}
+}
+}
+
+#endif // TRIP_CLUSTERING_HPP
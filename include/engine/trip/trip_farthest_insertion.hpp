@@ -1,6 +1,7 @@
 #ifndef TRIP_FARTHEST_INSERTION_HPP
 #define TRIP_FARTHEST_INSERTION_HPP
 
+#include "engine/search_engine_data.hpp"
 #include "util/dist_table_wrapper.hpp"
 #include "util/typedefs.hpp"
 #include "util/typedefs.hpp"
@@ -8,10 +9,16 @@
 #include "osrm/json_container.hpp"
 #include <boost/assert.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
+
 #include <algorithm>
+#include <cstddef>
 #include <cstdlib>
+#include <iterator>
 #include <limits>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -73,6 +80,24 @@ GetShortestRoundTrip(const NodeID new_loc,
     return std::make_pair(min_trip_distance, next_insert_point_candidate);
 }
 
+// the smaller trips are built on the calling thread
+const constexpr std::size_t INSERTION_GRAIN_SIZE = 64;
+
+// an unvisited location with the length of its cheapest insertion into the trip
+struct InsertionCandidate
+{
+    EdgeWeight distance = std::numeric_limits<EdgeWeight>::min();
+    std::ptrdiff_t order = -1;
+    int node = -1;
+    NodeIDIter insert_point;
+
+    // the farther location is inserted first, the later one in order on a tie
+    bool IsBefore(const InsertionCandidate &other) const
+    {
+        return std::make_pair(distance, order) < std::make_pair(other.distance, other.order);
+    }
+};
+
 template <typename NodeIDIterator>
 // given two initial start nodes, find a roundtrip route using the farthest insertion algorithm
 std::vector<NodeID> FindRoute(const std::size_t &number_of_locations,
@@ -100,33 +125,44 @@ std::vector<NodeID> FindRoute(const std::size_t &number_of_locations,
     // add all other nodes missing (two nodes are already in the initial start trip)
     for (std::size_t j = 2; j < component_size; ++j)
     {
-
-        auto farthest_distance = std::numeric_limits<int>::min();
-        auto next_node = -1;
-        NodeIDIter next_insert_point;
-
-        // find unvisited loc i that is the farthest away from all other visited locs
-        for (auto i = start; i != end; ++i)
-        {
-            // find the shortest distance from i to all visited nodes
-            if (!visited[*i])
-            {
-                const auto insert_candidate =
-                    GetShortestRoundTrip(*i, dist_table, number_of_locations, route);
-
-                BOOST_ASSERT_MSG(insert_candidate.first != INVALID_EDGE_WEIGHT,
-                                 "shortest round trip is invalid");
-
-                // add the location to the current trip such that it results in the shortest total
-                // tour
-                if (insert_candidate.first >= farthest_distance)
+        SearchEngineData::CheckQueryControl();
+
+        // find unvisited loc i that is the farthest away from all other visited locs, the
+        // candidates are searched in parallel and the last one in order wins a tie
+        const auto farthest = tbb::parallel_reduce(
+            tbb::blocked_range<NodeIDIterator>(start, end, INSERTION_GRAIN_SIZE),
+            InsertionCandidate(),
+            [&](const tbb::blocked_range<NodeIDIterator> &range, InsertionCandidate farthest) {
+                for (auto i = range.begin(); i != range.end(); ++i)
                 {
-                    farthest_distance = insert_candidate.first;
-                    next_node = *i;
-                    next_insert_point = insert_candidate.second;
+                    // find the shortest distance from i to all visited nodes
+                    if (!visited[*i])
+                    {
+                        const auto insert_candidate =
+                            GetShortestRoundTrip(*i, dist_table, number_of_locations, route);
+
+                        BOOST_ASSERT_MSG(insert_candidate.first != INVALID_EDGE_WEIGHT,
+                                         "shortest round trip is invalid");
+
+                        // add the location to the current trip such that it results in the
+                        // shortest total tour
+                        const InsertionCandidate candidate{insert_candidate.first,
+                                                           std::distance(start, i),
+                                                           static_cast<int>(*i),
+                                                           insert_candidate.second};
+                        if (!candidate.IsBefore(farthest))
+                        {
+                            farthest = candidate;
+                        }
+                    }
                 }
-            }
-        }
+                return farthest;
+            },
+            [](const InsertionCandidate &lhs, const InsertionCandidate &rhs) {
+                return lhs.IsBefore(rhs) ? rhs : lhs;
+            });
+        const auto next_node = farthest.node;
+        const auto next_insert_point = farthest.insert_point;
 
         BOOST_ASSERT_MSG(next_node >= 0, "next node to visit is invalid");
 
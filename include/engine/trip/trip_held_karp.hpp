@@ -0,0 +1,185 @@
+#ifndef TRIP_HELD_KARP_HPP
+#define TRIP_HELD_KARP_HPP
+
+#include "engine/search_engine_data.hpp"
+#include "util/dist_table_wrapper.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace trip
+{
+
+// larger components take too much memory for their states, 2^16 * 16 weights
+const constexpr std::size_t HELD_KARP_MAX_LOCATIONS = 17;
+
+namespace detail
+{
+// subsets that a worker computes in one go
+const constexpr std::size_t HELD_KARP_GRAIN_SIZE = 256;
+// has room to add a duration without overflowing
+const constexpr EdgeWeight HELD_KARP_UNREACHED = std::numeric_limits<EdgeWeight>::max() / 2;
+}
+
+// Computes the shortest round trip exactly with the Held-Karp dynamic program.
+//
+// The first location is the start of the trip. A state is a subset of the other locations,
+// encoded as a bit mask, with the location the path through them ends at. Its duration is the
+// shortest path from the start through all locations of the subset. The states of all subsets
+// of the same size only depend on the ones of the smaller subsets and are computed in parallel.
+// The states of a subset are contiguous and unreached ones are set to a large duration, so the
+// minimum over the previous locations is a branch free loop that the compiler vectorizes.
+template <typename NodeIDIterator>
+std::vector<NodeID> HeldKarpTrip(const NodeIDIterator start,
+                                 const NodeIDIterator end,
+                                 const std::size_t number_of_locations,
+                                 const util::DistTableWrapper<EdgeWeight> &dist_table)
+{
+    using namespace detail;
+    (void)number_of_locations; // unused
+
+    const std::vector<NodeID> locations(start, end);
+    BOOST_ASSERT_MSG(locations.size() > 0, "no locations given");
+    BOOST_ASSERT_MSG(locations.size() <= HELD_KARP_MAX_LOCATIONS, "too many locations");
+    BOOST_ASSERT_MSG(*(std::max_element(std::begin(locations), std::end(locations))) <
+                         number_of_locations,
+                     "invalid node id");
+    if (locations.size() < 3)
+    {
+        return locations;
+    }
+
+    // the locations besides the start
+    const std::size_t size = locations.size() - 1;
+    const std::uint32_t full_subset = (1u << size) - 1;
+    const auto other = [&](const std::size_t index) { return locations[index + 1]; };
+
+    // durations[to * size + from] is the duration from one location to another, contiguous by
+    // the location the leg comes from
+    std::vector<EdgeWeight> durations(size * size);
+    for (std::size_t to = 0; to < size; ++to)
+    {
+        for (std::size_t from = 0; from < size; ++from)
+        {
+            durations[to * size + from] = dist_table(other(from), other(to));
+            BOOST_ASSERT(durations[to * size + from] != INVALID_EDGE_WEIGHT);
+        }
+    }
+
+    // states[subset * size + last]
+    std::vector<EdgeWeight> states((static_cast<std::size_t>(full_subset) + 1) * size,
+                                   HELD_KARP_UNREACHED);
+    for (std::size_t last = 0; last < size; ++last)
+    {
+        states[(std::size_t{1} << last) * size + last] =
+            dist_table(locations.front(), other(last));
+    }
+
+    // the subsets ordered by their number of locations
+    std::vector<std::uint32_t> subsets;
+    subsets.reserve(full_subset);
+    std::vector<std::size_t> subsets_begin(size + 2, 0);
+    for (std::size_t subset_size = 1; subset_size <= size; ++subset_size)
+    {
+        subsets_begin[subset_size] = subsets.size();
+        for (std::uint32_t subset = 1; subset <= full_subset; ++subset)
+        {
+            if (std::bitset<32>(subset).count() == subset_size)
+            {
+                subsets.push_back(subset);
+            }
+        }
+    }
+    subsets_begin[size + 1] = subsets.size();
+
+    for (std::size_t subset_size = 2; subset_size <= size; ++subset_size)
+    {
+        SearchEngineData::CheckQueryControl();
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(
+                subsets_begin[subset_size], subsets_begin[subset_size + 1], HELD_KARP_GRAIN_SIZE),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                for (auto index = range.begin(); index != range.end(); ++index)
+                {
+                    const auto subset = subsets[index];
+                    for (std::size_t last = 0; last < size; ++last)
+                    {
+                        if ((subset & (1u << last)) == 0)
+                        {
+                            continue;
+                        }
+                        // the previous location is unreached if it isn't part of the subset
+                        const auto *previous_states = &states[(subset ^ (1u << last)) * size];
+                        const auto *leg_durations = &durations[last * size];
+                        EdgeWeight duration = HELD_KARP_UNREACHED;
+                        for (std::size_t previous = 0; previous < size; ++previous)
+                        {
+                            const auto via_previous =
+                                previous_states[previous] + leg_durations[previous];
+                            duration = std::min(duration, via_previous);
+                        }
+                        states[subset * size + last] = duration;
+                    }
+                }
+            });
+    }
+
+    // close the trip back to the start, then follow the states back from its end
+    const auto *full_states = &states[full_subset * size];
+    std::size_t last = 0;
+    EdgeWeight trip_duration = HELD_KARP_UNREACHED;
+    for (std::size_t candidate = 0; candidate < size; ++candidate)
+    {
+        const auto duration =
+            full_states[candidate] + dist_table(other(candidate), locations.front());
+        if (duration < trip_duration)
+        {
+            trip_duration = duration;
+            last = candidate;
+        }
+    }
+
+    std::vector<NodeID> route(locations.size());
+    route.front() = locations.front();
+    auto subset = full_subset;
+    for (std::size_t position = size; position > 1; --position)
+    {
+        route[position] = other(last);
+        const auto previous_subset = subset ^ (1u << last);
+        const auto *previous_states = &states[previous_subset * size];
+        const auto *leg_durations = &durations[last * size];
+        const auto duration = states[subset * size + last];
+        const auto previous = std::find_if(
+            previous_states, previous_states + size, [&](const EdgeWeight &previous_duration) {
+                const auto previous_index = &previous_duration - previous_states;
+                return previous_duration + leg_durations[previous_index] == duration;
+            });
+        BOOST_ASSERT(previous != previous_states + size);
+        last = previous - previous_states;
+        subset = previous_subset;
+    }
+    BOOST_ASSERT(subset == (1u << last));
+    route[1] = other(last);
+
+    return route;
+}
+}
+}
+}
+
+#endif // TRIP_HELD_KARP_HPP
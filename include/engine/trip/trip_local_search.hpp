@@ -0,0 +1,298 @@
+#ifndef TRIP_LOCAL_SEARCH_HPP
+#define TRIP_LOCAL_SEARCH_HPP
+
+#include "engine/search_engine_data.hpp"
+#include "util/dist_table_wrapper.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace trip
+{
+
+namespace detail
+{
+// moves are only searched towards the closest locations of each location
+const constexpr std::size_t NUMBER_OF_NEIGHBOURS = 8;
+// the longest run of locations that an or-opt move takes elsewhere
+const constexpr std::size_t MAX_OR_OPT_LENGTH = 3;
+// the moves of smaller trips are searched on the calling thread
+const constexpr std::size_t LOCAL_SEARCH_GRAIN_SIZE = 32;
+// bounds the search on tables where the triangle inequality doesn't hold
+const constexpr std::size_t MAX_MOVES_PER_LOCATION = 16;
+
+struct TripMove
+{
+    enum class Type
+    {
+        None,
+        TwoOpt,
+        OrOpt
+    };
+
+    Type type = Type::None;
+    EdgeWeight gain = 0;
+    // 2-opt reverses the locations from position first + 1 to position last, or-opt moves the
+    // length locations from position first on behind the location at position last
+    std::size_t first = 0;
+    std::size_t last = 0;
+    std::size_t length = 0;
+
+    // the larger gain, ties are broken by the positions to not depend on the parallel split
+    bool IsBetterThan(const TripMove &other) const
+    {
+        return std::make_tuple(gain, other.type, other.first, other.last, other.length) >
+               std::make_tuple(other.gain, type, first, last, length);
+    }
+};
+
+// The trip at its current state, with the lengths of its prefixes in both directions
+class TripState
+{
+  public:
+    TripState(const std::vector<NodeID> &route_,
+              const util::DistTableWrapper<EdgeWeight> &dist_table_)
+        : route(route_), dist_table(dist_table_), positions(dist_table_.GetNumberOfNodes()),
+          forward_lengths(route_.size()), backward_lengths(route_.size())
+    {
+    }
+
+    void Update()
+    {
+        forward_lengths[0] = 0;
+        backward_lengths[0] = 0;
+        for (std::size_t position = 0; position < route.size(); ++position)
+        {
+            positions[route[position]] = position;
+            if (position + 1 < route.size())
+            {
+                forward_lengths[position + 1] =
+                    forward_lengths[position] + Distance(position, position + 1);
+                backward_lengths[position + 1] =
+                    backward_lengths[position] + Distance(position + 1, position);
+            }
+        }
+    }
+
+    std::size_t Next(const std::size_t position) const
+    {
+        return position + 1 == route.size() ? 0 : position + 1;
+    }
+
+    std::size_t Previous(const std::size_t position) const
+    {
+        return position == 0 ? route.size() - 1 : position - 1;
+    }
+
+    EdgeWeight Distance(const std::size_t from, const std::size_t to) const
+    {
+        return dist_table(route[from], route[to]);
+    }
+
+    // Reversing the locations from position first + 1 to position last replaces the legs
+    // first -> first + 1 and last -> last + 1 by first -> last and first + 1 -> last + 1
+    void EvaluateTwoOpt(std::size_t first, std::size_t last, TripMove &best) const
+    {
+        if (first > last)
+        {
+            std::swap(first, last);
+        }
+        if (last < first + 2 || (first == 0 && last + 1 == route.size()))
+        {
+            return;
+        }
+        const auto after_last = Next(last);
+        const auto old_length = Distance(first, first + 1) + Distance(last, after_last) +
+                                forward_lengths[last] - forward_lengths[first + 1];
+        const auto new_length = Distance(first, last) + Distance(first + 1, after_last) +
+                                backward_lengths[last] - backward_lengths[first + 1];
+
+        const TripMove move{TripMove::Type::TwoOpt, old_length - new_length, first, last, 0};
+        if (move.gain > 0 && move.IsBetterThan(best))
+        {
+            best = move;
+        }
+    }
+
+    // Moving the length locations from position first on between the position last and the one
+    // after it, in the same direction since the durations of the legs aren't symmetric
+    void EvaluateOrOpt(const std::size_t first,
+                       const std::size_t length,
+                       const std::size_t last,
+                       TripMove &best) const
+    {
+        const auto size = route.size();
+        BOOST_ASSERT(size >= length + 3);
+        const auto before = Previous(first);
+        // the run and the location before it are no valid positions to insert the run at
+        if ((last + size - before) % size <= length)
+        {
+            return;
+        }
+        const auto end = (first + length - 1) % size;
+        const auto after = Next(end);
+        const auto after_last = Next(last);
+        const auto old_length =
+            Distance(before, first) + Distance(end, after) + Distance(last, after_last);
+        const auto new_length =
+            Distance(before, after) + Distance(last, first) + Distance(end, after_last);
+
+        const TripMove move{TripMove::Type::OrOpt, old_length - new_length, first, last, length};
+        if (move.gain > 0 && move.IsBetterThan(best))
+        {
+            best = move;
+        }
+    }
+
+    const std::vector<NodeID> &route;
+    const util::DistTableWrapper<EdgeWeight> &dist_table;
+    // of the locations in the route
+    std::vector<std::size_t> positions;
+    // from position 0 to the position, in and against the direction of the route
+    std::vector<EdgeWeight> forward_lengths;
+    std::vector<EdgeWeight> backward_lengths;
+};
+
+// the closest locations of every location of the route by the shorter of both directions
+inline std::vector<std::vector<NodeID>>
+GetNeighbours(const std::vector<NodeID> &route,
+              const util::DistTableWrapper<EdgeWeight> &dist_table)
+{
+    const auto number_of_neighbours = std::min(NUMBER_OF_NEIGHBOURS, route.size() - 1);
+    std::vector<std::vector<NodeID>> neighbours(dist_table.GetNumberOfNodes());
+    std::vector<std::pair<EdgeWeight, NodeID>> candidates;
+    for (const auto location : route)
+    {
+        candidates.clear();
+        for (const auto other : route)
+        {
+            if (other != location)
+            {
+                candidates.emplace_back(
+                    std::min(dist_table(location, other), dist_table(other, location)), other);
+            }
+        }
+        std::partial_sort(candidates.begin(),
+                          candidates.begin() + number_of_neighbours,
+                          candidates.end());
+        auto &location_neighbours = neighbours[location];
+        for (std::size_t i = 0; i < number_of_neighbours; ++i)
+        {
+            location_neighbours.push_back(candidates[i].second);
+        }
+    }
+    return neighbours;
+}
+}
+
+// Improves a round trip with 2-opt and or-opt moves until none of them makes it shorter.
+//
+// The moves are only searched between each location and its closest locations. Every step
+// applies the move that shortens the trip the most, and the moves of all locations are searched
+// in parallel. Since the durations of the legs aren't symmetric, 2-opt moves account for the
+// reversed legs by the lengths of the prefixes of the trip in both directions.
+inline void ImproveTrip(std::vector<NodeID> &route,
+                        const util::DistTableWrapper<EdgeWeight> &dist_table)
+{
+    using namespace detail;
+
+    // 2-opt moves need two legs that don't share a location
+    if (route.size() < 4)
+    {
+        return;
+    }
+
+    const auto neighbours = GetNeighbours(route, dist_table);
+    TripState state(route, dist_table);
+    std::vector<NodeID> moved_route;
+    moved_route.reserve(route.size());
+
+    const auto max_moves = MAX_MOVES_PER_LOCATION * route.size();
+    for (std::size_t moves = 0; moves < max_moves; ++moves)
+    {
+        SearchEngineData::CheckQueryControl();
+        state.Update();
+
+        const auto best = tbb::parallel_reduce(
+            tbb::blocked_range<std::size_t>(0, route.size(), LOCAL_SEARCH_GRAIN_SIZE),
+            TripMove(),
+            [&](const tbb::blocked_range<std::size_t> &range, TripMove best) {
+                for (auto position = range.begin(); position != range.end(); ++position)
+                {
+                    for (const auto neighbour : neighbours[route[position]])
+                    {
+                        const auto neighbour_position = state.positions[neighbour];
+                        // the leg to the neighbour is the first or the second new leg
+                        state.EvaluateTwoOpt(position, neighbour_position, best);
+                        state.EvaluateTwoOpt(
+                            state.Previous(position), state.Previous(neighbour_position), best);
+
+                        for (std::size_t length = 1;
+                             length <= MAX_OR_OPT_LENGTH && length + 3 <= route.size();
+                             ++length)
+                        {
+                            // the run starts behind or ends in front of the neighbour
+                            state.EvaluateOrOpt(position, length, neighbour_position, best);
+                            state.EvaluateOrOpt(
+                                (position + route.size() + 1 - length) % route.size(),
+                                length,
+                                state.Previous(neighbour_position),
+                                best);
+                        }
+                    }
+                }
+                return best;
+            },
+            [](const TripMove &lhs, const TripMove &rhs) {
+                return rhs.IsBetterThan(lhs) ? rhs : lhs;
+            });
+
+        if (best.type == TripMove::Type::None)
+        {
+            break;
+        }
+
+        if (best.type == TripMove::Type::TwoOpt)
+        {
+            std::reverse(route.begin() + best.first + 1, route.begin() + best.last + 1);
+        }
+        else
+        {
+            // the remaining locations from the one after the run on, with the run behind last
+            moved_route.clear();
+            auto position = (best.first + best.length) % route.size();
+            for (std::size_t i = 0; i < route.size() - best.length; ++i)
+            {
+                moved_route.push_back(route[position]);
+                if (position == best.last)
+                {
+                    for (std::size_t j = 0; j < best.length; ++j)
+                    {
+                        moved_route.push_back(route[(best.first + j) % route.size()]);
+                    }
+                }
+                position = state.Next(position);
+            }
+            BOOST_ASSERT(moved_route.size() == route.size());
+            route.swap(moved_route);
+        }
+    }
+}
+}
+}
+}
+
+#endif // TRIP_LOCAL_SEARCH_HPP
@@ -1,6 +1,7 @@
 #ifndef TRIP_NEAREST_NEIGHBOUR_HPP
 #define TRIP_NEAREST_NEIGHBOUR_HPP
 
+#include "engine/search_engine_data.hpp"
 #include "util/dist_table_wrapper.hpp"
 #include "util/simple_logger.hpp"
 #include "util/typedefs.hpp"
@@ -45,6 +46,7 @@ std::vector<NodeID> NearestNeighbourTrip(const NodeIDIterator &start,
     // ALWAYS START AT ANOTHER STARTING POINT
     for (auto start_node = start; start_node != end; ++start_node)
     {
+        SearchEngineData::CheckQueryControl();
         NodeID curr_node = *start_node;
 
         std::vector<NodeID> curr_route;
@@ -0,0 +1,35 @@
+#ifndef UNPACKING_CACHE_HPP
+#define UNPACKING_CACHE_HPP
+
+#include "util/sharded_lru_cache.hpp"
+#include "util/typedefs.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Bounded LRU cache of shortcut expansions that is shared by all queries of an engine.
+//
+// A few thousand shortcuts (motorways, bypasses) make up most of the unpacking work, so
+// UnpackPath looks up the original edges of every shortcut here before recursing into it.
+// An expansion stays valid while a query uses it even if it is evicted in the meantime.
+// Lookups pass the data version, since edge ids may refer to a different graph after a
+// shared memory update.
+class UnpackingCache final
+    : public util::ShardedLRUCache<EdgeID, std::shared_ptr<const std::vector<EdgeID>>>
+{
+  public:
+    // edge ids of the original edges a shortcut consists of, in path order
+    using Expansion = std::vector<EdgeID>;
+    using ExpansionPtr = std::shared_ptr<const Expansion>;
+
+    using ShardedLRUCache::ShardedLRUCache;
+};
+}
+}
+
+#endif // UNPACKING_CACHE_HPP
@@ -0,0 +1,253 @@
+#ifndef OSRM_EXTRACTOR_CAR_PROFILE_HPP
+#define OSRM_EXTRACTOR_CAR_PROFILE_HPP
+
+#include "extractor/profile_properties.hpp"
+
+#include <boost/filesystem/path.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium
+{
+class Node;
+class Way;
+}
+
+namespace osrm
+{
+namespace extractor
+{
+
+struct ExtractionNode;
+struct ExtractionWay;
+
+// A hash table from strings to values that is looked up with the C strings of osmium objects,
+// without constructing a std::string for every tag
+template <typename T> class StringTable
+{
+  public:
+    // replaces the value of a key that is there already
+    void Set(const std::string &key, T value)
+    {
+        const auto slot = FindSlot(key.c_str());
+        if (!slots.empty() && slots[slot] != 0)
+        {
+            entries[slots[slot] - 1].second = std::move(value);
+            return;
+        }
+        entries.emplace_back(key, std::move(value));
+        Rehash();
+    }
+
+    void Erase(const std::string &key)
+    {
+        const auto slot = FindSlot(key.c_str());
+        if (!slots.empty() && slots[slot] != 0)
+        {
+            entries.erase(entries.begin() + (slots[slot] - 1));
+            Rehash();
+        }
+    }
+
+    // nullptr if the key isn't there, a missing tag of osmium is nullptr as well
+    const T *Find(const char *key) const
+    {
+        if (key == nullptr || entries.empty())
+        {
+            return nullptr;
+        }
+        const auto slot = FindSlot(key);
+        return slots[slot] == 0 ? nullptr : &entries[slots[slot] - 1].second;
+    }
+
+    bool Contains(const char *key) const { return Find(key) != nullptr; }
+
+    std::size_t Size() const { return entries.size(); }
+
+  private:
+    static std::uint32_t Hash(const char *key)
+    {
+        std::uint32_t hash = 2166136261u;
+        for (; *key != '\0'; ++key)
+        {
+            hash = (hash ^ static_cast<unsigned char>(*key)) * 16777619u;
+        }
+        return hash;
+    }
+
+    // the slot of the key, or the empty one it would be inserted at
+    std::size_t FindSlot(const char *key) const
+    {
+        if (slots.empty())
+        {
+            return 0;
+        }
+        const auto mask = slots.size() - 1;
+        for (auto slot = Hash(key) & mask;; slot = (slot + 1) & mask)
+        {
+            if (slots[slot] == 0 || std::strcmp(entries[slots[slot] - 1].first.c_str(), key) == 0)
+            {
+                return slot;
+            }
+        }
+    }
+
+    // at most half of the slots are used, so probing stops after a few of them
+    void Rehash()
+    {
+        std::size_t size = 8;
+        while (size < 2 * entries.size())
+        {
+            size *= 2;
+        }
+        slots.assign(size, 0);
+        for (std::size_t index = 0; index < entries.size(); ++index)
+        {
+            slots[FindSlot(entries[index].first.c_str())] = static_cast<std::uint32_t>(index + 1);
+        }
+    }
+
+    std::vector<std::pair<std::string, T>> entries;
+    // the index of the entry plus one, 0 for empty slots
+    std::vector<std::uint32_t> slots;
+};
+
+using StringSet = StringTable<bool>;
+
+// The tables and settings of profiles/car.lua, with the values of car.lua by default. Load
+// changes them with a configuration file like profiles/car.ini.
+struct CarProfileConfig
+{
+    CarProfileConfig();
+
+    // Reads "[section]" and "key = value" lines, values replace the ones of the same key and
+    // lists replace the whole list. Throws util::exception for unknown sections and settings.
+    void Load(const boost::filesystem::path &path);
+
+    ProfileProperties properties;
+    double turn_penalty;
+    double turn_bias;
+    double side_road_speed_multiplier;
+    double speed_reduction;
+    bool obey_oneway;
+    bool ignore_areas;
+    bool ignore_hov_ways;
+    bool ignore_toll_ways;
+
+    // by highway, route and bridge, the speed of "default" is used for ways with access tags
+    StringTable<double> speeds;
+    StringTable<double> service_speeds;
+    StringTable<double> surface_speeds;
+    StringTable<double> tracktype_speeds;
+    StringTable<double> smoothness_speeds;
+    // maxspeed tags like "de:rural", and the defaults of the part after the country
+    StringTable<double> maxspeeds;
+    StringTable<double> maxspeed_defaults;
+
+    // the first of these tags that is set decides the access
+    std::vector<std::string> access_tags;
+    StringSet access_whitelist;
+    StringSet access_blacklist;
+    StringSet access_restricted;
+    StringSet barrier_whitelist;
+    StringSet service_restricted;
+    StringSet service_forbidden;
+
+    std::vector<std::string> restriction_exceptions;
+    std::vector<std::string> name_suffixes;
+};
+
+// profiles/car.lua in C++. The keys of the tags it reads get ids once, the tags of an object are
+// then collected by their ids in a single pass instead of comparing the keys of every lookup.
+class CarProfile
+{
+  public:
+    explicit CarProfile(CarProfileConfig config);
+
+    void ProcessNode(const osmium::Node &node, ExtractionNode &result) const;
+    void ProcessWay(const osmium::Way &way, ExtractionWay &result) const;
+    // deci-seconds, like the turn_function of car.lua
+    std::int32_t GetTurnPenalty(const double angle) const;
+
+    const CarProfileConfig &GetConfig() const { return config; }
+
+    // the classes of get_classes in car.lua, by their bit in ExtractionWay::classes
+    enum Class : std::uint8_t
+    {
+        TOLL_CLASS,
+        MOTORWAY_CLASS,
+        FERRY_CLASS,
+        NUMBER_OF_CLASSES
+    };
+    static std::vector<std::string> GetClassNames() { return {"toll", "motorway", "ferry"}; }
+
+    // the fixed keys, the ids of the access tags follow them
+    enum Key : std::uint8_t
+    {
+        HIGHWAY,
+        ROUTE,
+        BRIDGE,
+        AREA,
+        HOV,
+        HOV_LANES,
+        HOV_LANES_FORWARD,
+        HOV_LANES_BACKWARD,
+        ONEWAY,
+        TOLL,
+        IMPASSABLE,
+        STATUS,
+        DURATION,
+        MAXSPEED,
+        MAXSPEED_FORWARD,
+        MAXSPEED_BACKWARD,
+        MAXSPEED_ADVISORY,
+        MAXSPEED_ADVISORY_FORWARD,
+        MAXSPEED_ADVISORY_BACKWARD,
+        SIDE_ROAD,
+        SURFACE,
+        TRACKTYPE,
+        SMOOTHNESS,
+        NAME,
+        NAME_PRONUNCIATION,
+        REF,
+        JUNCTION,
+        SERVICE,
+        DESTINATION,
+        DESTINATION_REF,
+        WIDTH,
+        LANES,
+        LANES_PSV,
+        LANES_PSV_FORWARD,
+        LANES_PSV_BACKWARD,
+        TURN_LANES,
+        TURN_LANES_FORWARD,
+        TURN_LANES_BACKWARD,
+        VEHICLE_LANES,
+        VEHICLE_LANES_FORWARD,
+        VEHICLE_LANES_BACKWARD,
+        BARRIER,
+        BOLLARD,
+        NUMBER_OF_FIXED_KEYS
+    };
+    static const constexpr std::size_t MAX_NUMBER_OF_KEYS = 64;
+
+  private:
+    template <typename ObjectT> void CollectTags(const ObjectT &object, const char **tags) const;
+    const char *FindAccess(const char *const *tags) const;
+
+    CarProfileConfig config;
+    StringTable<std::uint8_t> key_ids;
+    std::vector<std::uint8_t> access_key_ids;
+    std::size_t number_of_keys;
+    // turn_bias of the config is for right-hand driving
+    double turn_bias;
+};
+}
+}
+
+#endif // OSRM_EXTRACTOR_CAR_PROFILE_HPP
@@ -0,0 +1,54 @@
+#ifndef OSRM_EXTRACTOR_CHANGE_MERGER_HPP
+#define OSRM_EXTRACTOR_CHANGE_MERGER_HPP
+
+#include <osmium/memory/buffer.hpp>
+
+#include <boost/filesystem/path.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace osmium
+{
+class OSMObject;
+}
+
+namespace osrm
+{
+namespace extractor
+{
+
+// Applies OSM change files (.osc) to the input while it is read, like osmium apply-changes does
+// before an extraction. The latest version of every changed object replaces the one of the input,
+// deleted objects are removed and created ones are inserted where they belong.
+//
+// The input has to be ordered by type and id like planet dumps and the files written by osmium,
+// the merged buffers are then ordered the same way.
+class ChangeMerger
+{
+  public:
+    // Reads all changes into memory, of several versions of an object the latest one is applied
+    explicit ChangeMerger(const std::vector<boost::filesystem::path> &change_paths);
+
+    ChangeMerger(const ChangeMerger &) = delete;
+    ChangeMerger &operator=(const ChangeMerger &) = delete;
+
+    // The objects of the next buffer of the input with the changes up to its last object
+    osmium::memory::Buffer Merge(const osmium::memory::Buffer &input);
+    // The objects created after the last object of the input
+    osmium::memory::Buffer Finish();
+    // starts over for another read of the input
+    void Reset() { next_change = 0; }
+
+    std::size_t GetNumberOfChanges() const { return changed_objects.size(); }
+
+  private:
+    osmium::memory::Buffer changes;
+    // the latest version of every object by type and id
+    std::vector<const osmium::OSMObject *> changed_objects;
+    std::size_t next_change;
+};
+}
+}
+
+#endif // OSRM_EXTRACTOR_CHANGE_MERGER_HPP
@@ -0,0 +1,80 @@
+#ifndef OSRM_EXTRACTOR_CLASS_DATA_HPP
+#define OSRM_EXTRACTOR_CLASS_DATA_HPP
+
+#include "util/io.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+// The classes of a way as a bit mask, the profile names the bits with get_classes. A query can
+// exclude the edge-based nodes of some classes with exclude=.
+using ClassData = std::uint8_t;
+const constexpr std::size_t MAX_CLASSES = 8;
+
+inline ClassData getClassMask(const std::size_t class_index)
+{
+    return static_cast<ClassData>(1u << class_index);
+}
+
+// The index of the class among the names, names.size() if there is no class of that name
+inline std::size_t findClass(const std::vector<std::string> &names, const std::string &name)
+{
+    std::size_t index = 0;
+    while (index < names.size() && names[index] != name)
+    {
+        ++index;
+    }
+    return index;
+}
+
+// The .classes file: the fingerprint, the class names and the classes of every edge-based node
+inline bool writeClasses(const std::string &path,
+                         const std::vector<std::string> &names,
+                         const std::vector<ClassData> &node_classes)
+{
+    std::ofstream stream(path, std::ios::binary);
+    util::writeFingerprint(stream);
+    const std::uint32_t number_of_names = names.size();
+    stream.write(reinterpret_cast<const char *>(&number_of_names), sizeof(number_of_names));
+    for (const auto &name : names)
+    {
+        const std::uint32_t length = name.size();
+        stream.write(reinterpret_cast<const char *>(&length), sizeof(length));
+        stream.write(name.data(), length);
+    }
+    return util::serializeVector(stream, node_classes);
+}
+
+inline bool readClasses(const std::string &path,
+                        std::vector<std::string> &names,
+                        std::vector<ClassData> &node_classes)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!util::readAndCheckFingerprint(stream))
+    {
+        return false;
+    }
+    std::uint32_t number_of_names = 0;
+    stream.read(reinterpret_cast<char *>(&number_of_names), sizeof(number_of_names));
+    names.resize(stream && number_of_names <= MAX_CLASSES ? number_of_names : 0);
+    for (auto &name : names)
+    {
+        std::uint32_t length = 0;
+        stream.read(reinterpret_cast<char *>(&length), sizeof(length));
+        name.resize(stream ? length : 0);
+        stream.read(&name[0], name.size());
+    }
+    return static_cast<bool>(stream) && number_of_names <= MAX_CLASSES &&
+           util::deserializeVector(stream, node_classes);
+}
+}
+}
+
+#endif // OSRM_EXTRACTOR_CLASS_DATA_HPP
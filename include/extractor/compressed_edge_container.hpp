@@ -1,10 +1,13 @@
 #ifndef GEOMETRY_COMPRESSOR_HPP_
 #define GEOMETRY_COMPRESSOR_HPP_
 
+#include "extractor/query_node.hpp"
+#include "util/node_based_graph.hpp"
 #include "util/typedefs.hpp"
 
-#include <unordered_map>
+#include <boost/range/iterator_range.hpp>
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -13,6 +16,15 @@ namespace osrm
 namespace extractor
 {
 
+// The geometries of the compressed edges. The buckets of the edges lie in one flat arena with a
+// table of their offsets, instead of a vector each, which would take hundreds of millions of
+// small allocations on a planet.
+//
+// CompressEdge appends to a bucket in place if it is the last one of the arena, and moves it to
+// the end otherwise. The space it leaves behind is reclaimed by Compact, which lays out the
+// buckets in the order of their ids once as much arena is unused as is in use, and which the
+// GraphCompressor calls once it is done. The parallel GraphCompressor lays out the buckets in the
+// order of their ids once it knows the sizes of the buckets it fills in.
 class CompressedEdgeContainer
 {
   public:
@@ -22,7 +34,9 @@ class CompressedEdgeContainer
         NodeID node_id;    // refers to an internal node-based-node
         EdgeWeight weight; // the weight of the edge leading to this node
     };
-    using EdgeBucket = std::vector<CompressedEdge>;
+    // The entries of a bucket in the arena, valid until the next change of the container
+    using EdgeBucket = boost::iterator_range<const CompressedEdge *>;
+    using MutableEdgeBucket = boost::iterator_range<CompressedEdge *>;
 
     CompressedEdgeContainer();
     void CompressEdge(const EdgeID surviving_edge_id,
@@ -35,23 +49,64 @@ class CompressedEdgeContainer
     void
     AddUncompressedEdge(const EdgeID edgei_id, const NodeID target_node, const EdgeWeight weight);
 
+    // Assign the buckets exactly like CompressEdge and AddUncompressedEdge, but leave them empty.
+    // The parallel GraphCompressor assigns the buckets in the order of the serial one, sets the
+    // sizes of the empty ones with ResizeBucket, lays out all buckets with AllocateBuckets and
+    // fills in the empty ones afterwards. ResizeBucket and GetMutableBucket can be called for
+    // different edges in parallel.
+    void ReserveCompressedEdge(const EdgeID surviving_edge_id, const EdgeID removed_edge_id);
+    void ReserveUncompressedEdge(const EdgeID edge_id);
+    void ResizeBucket(const EdgeID edge_id, const std::uint32_t size);
+    std::uint32_t GetBucketSize(const EdgeID edge_id) const;
+    void AllocateBuckets();
+    MutableEdgeBucket GetMutableBucket(const EdgeID edge_id);
+
+    // Lays out the buckets in the order of their ids without the space left behind by moved ones
+    void Compact();
+
+    // Moves the buckets to the new ids of their edges, see util::NodeBasedStaticGraph
+    void RenumberEdges(const std::vector<EdgeID> &new_edge_ids);
+
     bool HasEntryForID(const EdgeID edge_id) const;
     void PrintStatistics() const;
     void SerializeInternalVector(const std::string &path) const;
+    void SerializeZoomLevels(const std::string &path,
+                             const std::vector<QueryNode> &internal_to_external_node_map) const;
+    void SerializeSegmentLengths(const std::string &path,
+                                 const util::NodeBasedStaticGraph &graph,
+                                 const std::vector<QueryNode> &internal_to_external_node_map) const;
     unsigned GetPositionForID(const EdgeID edge_id) const;
-    const EdgeBucket &GetBucketReference(const EdgeID edge_id) const;
+    EdgeBucket GetBucketReference(const EdgeID edge_id) const;
     bool IsTrivial(const EdgeID edge_id) const;
     NodeID GetFirstEdgeTargetID(const EdgeID edge_id) const;
     NodeID GetLastEdgeTargetID(const EdgeID edge_id) const;
     NodeID GetLastEdgeSourceID(const EdgeID edge_id) const;
 
   private:
+    // the entries of a bucket in the arena
+    struct BucketRange
+    {
+        std::uint64_t offset;
+        std::uint32_t size;
+    };
+
     int free_list_maximum = 0;
 
     void IncreaseFreeList();
-    std::vector<EdgeBucket> m_compressed_geometries;
+    unsigned AddEntryForID(const EdgeID edge_id);
+    void RemoveEntryForID(const EdgeID edge_id);
+    EdgeBucket GetBucket(const unsigned index) const;
+    void LayOutBuckets();
+    // makes the bucket the last one of the arena, so it can grow in place
+    void MoveBucketToEnd(const unsigned index);
+
+    std::vector<CompressedEdge> m_compressed_edges;
+    // the entries of the arena that belong to no bucket anymore
+    std::uint64_t m_unused_edges = 0;
+    std::vector<BucketRange> m_compressed_geometries;
     std::vector<unsigned> m_free_list;
-    std::unordered_map<EdgeID, unsigned> m_edge_id_to_list_index_map;
+    // the bucket of every edge id, edge ids are dense
+    std::vector<unsigned> m_edge_id_to_list_index;
 };
 }
 }
@@ -0,0 +1,209 @@
+#ifndef OSRM_EXTRACTOR_COMPRESSED_GEOMETRY_HPP
+#define OSRM_EXTRACTOR_COMPRESSED_GEOMETRY_HPP
+
+#include "extractor/compressed_edge_container.hpp"
+#include "util/exception.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+// The .geometry file stores the nodes and weights of the compressed geometries as variable
+// length integers. Every node is the zigzag encoded difference to the previous node of its
+// geometry, followed by the weight of the segment that leads to it. Nodes of the same way have
+// close ids, so most points take two to three bytes instead of eight.
+//
+// The geometries of a block share one byte offset. A geometry is found by skipping the values of
+// the ones in front of it in its block, their number of points is known from the indices.
+//
+// Layout of the file:
+//   unsigned number_of_indices, unsigned indices[number_of_indices]
+//   unsigned number_of_points
+//   unsigned number_of_blocks, padding to 8 bytes, std::uint64_t block_offsets[number_of_blocks]
+//   std::uint64_t number_of_bytes, unsigned char data[number_of_bytes]
+const constexpr std::size_t COMPRESSED_GEOMETRY_BLOCK_SIZE = 16;
+
+namespace detail
+{
+inline void encodeVarint(std::uint32_t value, std::vector<unsigned char> &data)
+{
+    while (value >= 0x80)
+    {
+        data.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<unsigned char>(value));
+}
+
+inline std::uint32_t decodeVarint(const unsigned char *&data)
+{
+    std::uint32_t value = *data & 0x7f;
+    unsigned shift = 7;
+    while (*data++ >= 0x80)
+    {
+        value |= static_cast<std::uint32_t>(*data & 0x7f) << shift;
+        shift += 7;
+    }
+    return value;
+}
+
+inline std::uint32_t encodeZigZag(const std::int32_t value)
+{
+    return (static_cast<std::uint32_t>(value) << 1) ^ static_cast<std::uint32_t>(value >> 31);
+}
+
+inline std::int32_t decodeZigZag(const std::uint32_t value)
+{
+    return static_cast<std::int32_t>(value >> 1) ^ -static_cast<std::int32_t>(value & 1);
+}
+
+// the block offsets are aligned to 8 bytes in the file
+inline std::size_t blockOffsetsPadding(const unsigned number_of_indices)
+{
+    return (sizeof(unsigned) * (number_of_indices + 3)) % sizeof(std::uint64_t);
+}
+}
+
+// Encodes the compressed geometries one after another and writes them to a .geometry file.
+class CompressedGeometryEncoder
+{
+  public:
+    CompressedGeometryEncoder() : indices(1, 0) {}
+
+    template <typename Iterator> void Append(Iterator begin, const Iterator end)
+    {
+        if ((indices.size() - 1) % COMPRESSED_GEOMETRY_BLOCK_SIZE == 0)
+        {
+            block_offsets.push_back(data.size());
+        }
+
+        NodeID previous_node = 0;
+        std::size_t number_of_points = 0;
+        for (; begin != end; ++begin, ++number_of_points)
+        {
+            const auto delta = static_cast<std::int32_t>(begin->node_id - previous_node);
+            detail::encodeVarint(detail::encodeZigZag(delta), data);
+            detail::encodeVarint(static_cast<std::uint32_t>(begin->weight), data);
+            previous_node = begin->node_id;
+        }
+        BOOST_ASSERT(indices.back() + number_of_points < std::numeric_limits<unsigned>::max());
+        indices.push_back(indices.back() + number_of_points);
+    }
+
+    void Write(std::ostream &out) const
+    {
+        const unsigned number_of_indices = indices.size();
+        out.write(reinterpret_cast<const char *>(&number_of_indices), sizeof(number_of_indices));
+        out.write(reinterpret_cast<const char *>(indices.data()),
+                  sizeof(unsigned) * number_of_indices);
+        const unsigned number_of_points = indices.back();
+        out.write(reinterpret_cast<const char *>(&number_of_points), sizeof(number_of_points));
+
+        const unsigned number_of_blocks = block_offsets.size();
+        out.write(reinterpret_cast<const char *>(&number_of_blocks), sizeof(number_of_blocks));
+        const std::uint64_t padding = 0;
+        out.write(reinterpret_cast<const char *>(&padding),
+                  detail::blockOffsetsPadding(number_of_indices));
+        out.write(reinterpret_cast<const char *>(block_offsets.data()),
+                  sizeof(std::uint64_t) * number_of_blocks);
+
+        const std::uint64_t number_of_bytes = data.size();
+        out.write(reinterpret_cast<const char *>(&number_of_bytes), sizeof(number_of_bytes));
+        out.write(reinterpret_cast<const char *>(data.data()), number_of_bytes);
+    }
+
+  private:
+    std::vector<unsigned> indices;
+    std::vector<std::uint64_t> block_offsets;
+    std::vector<unsigned char> data;
+};
+
+// Calls the callback with the node and the weight of every point of a compressed geometry. The
+// vectors are the indices, block offsets and data of a .geometry file.
+template <typename IndexVector, typename OffsetVector, typename DataVector, typename Callback>
+inline void decodeCompressedGeometry(const IndexVector &indices,
+                                     const OffsetVector &block_offsets,
+                                     const DataVector &data,
+                                     const EdgeID id,
+                                     Callback &&callback)
+{
+    const auto number_of_points = indices[id + 1] - indices[id];
+    if (number_of_points == 0)
+    {
+        return;
+    }
+
+    const auto block_begin = id - id % COMPRESSED_GEOMETRY_BLOCK_SIZE;
+    const unsigned char *position = &data[0] + block_offsets[id / COMPRESSED_GEOMETRY_BLOCK_SIZE];
+
+    // every point of the geometries in front is a node and a weight, the last byte of a value
+    // doesn't have the continuation bit set
+    auto skipped_values = 2 * (indices[id] - indices[block_begin]);
+    while (skipped_values > 0)
+    {
+        skipped_values -= *position++ < 0x80;
+    }
+
+    NodeID node = 0;
+    for (unsigned point = 0; point < number_of_points; ++point)
+    {
+        node += static_cast<NodeID>(detail::decodeZigZag(detail::decodeVarint(position)));
+        const auto weight = static_cast<EdgeWeight>(detail::decodeVarint(position));
+        callback(node, weight);
+    }
+}
+
+// Reads all geometries of a .geometry file, used by osrm-contract to update their weights.
+inline void readCompressedGeometries(std::istream &in,
+                                     std::vector<unsigned> &indices,
+                                     std::vector<CompressedEdgeContainer::CompressedEdge> &points)
+{
+    unsigned number_of_indices = 0;
+    in.read(reinterpret_cast<char *>(&number_of_indices), sizeof(number_of_indices));
+    indices.resize(number_of_indices);
+    in.read(reinterpret_cast<char *>(indices.data()), sizeof(unsigned) * number_of_indices);
+    unsigned number_of_points = 0;
+    in.read(reinterpret_cast<char *>(&number_of_points), sizeof(number_of_points));
+
+    unsigned number_of_blocks = 0;
+    in.read(reinterpret_cast<char *>(&number_of_blocks), sizeof(number_of_blocks));
+    in.ignore(detail::blockOffsetsPadding(number_of_indices));
+    std::vector<std::uint64_t> block_offsets(number_of_blocks);
+    in.read(reinterpret_cast<char *>(block_offsets.data()),
+            sizeof(std::uint64_t) * number_of_blocks);
+
+    std::uint64_t number_of_bytes = 0;
+    in.read(reinterpret_cast<char *>(&number_of_bytes), sizeof(number_of_bytes));
+    std::vector<unsigned char> data(number_of_bytes);
+    in.read(reinterpret_cast<char *>(data.data()), number_of_bytes);
+    if (!in)
+    {
+        throw util::exception("Reading the compressed geometries failed.");
+    }
+
+    points.clear();
+    points.reserve(number_of_points);
+    for (EdgeID id = 0; id + 1 < number_of_indices; ++id)
+    {
+        decodeCompressedGeometry(
+            indices, block_offsets, data, id, [&](const NodeID node, const EdgeWeight weight) {
+                points.push_back(CompressedEdgeContainer::CompressedEdge{node, weight});
+            });
+    }
+    BOOST_ASSERT(points.size() == number_of_points);
+}
+}
+}
+
+#endif // OSRM_EXTRACTOR_COMPRESSED_GEOMETRY_HPP
@@ -20,6 +20,7 @@ struct EdgeBasedEdge
                   const NodeID target,
                   const NodeID edge_id,
                   const EdgeWeight weight,
+                  const float length,
                   const bool forward,
                   const bool backward);
 
@@ -31,19 +32,22 @@ struct EdgeBasedEdge
     EdgeWeight weight : 30;
     bool forward : 1;
     bool backward : 1;
+    // length in meters of the source edge based node, which the weight is based on as well
+    float length;
 };
 
 // Impl.
 
 inline EdgeBasedEdge::EdgeBasedEdge()
-    : source(0), target(0), edge_id(0), weight(0), forward(false), backward(false)
+    : source(0), target(0), edge_id(0), weight(0), forward(false), backward(false), length(0)
 {
 }
 
 template <class EdgeT>
 inline EdgeBasedEdge::EdgeBasedEdge(const EdgeT &other)
     : source(other.source), target(other.target), edge_id(other.data.via),
-      weight(other.data.distance), forward(other.data.forward), backward(other.data.backward)
+      weight(other.data.distance), forward(other.data.forward), backward(other.data.backward),
+      length(other.data.length)
 {
 }
 
@@ -51,10 +55,11 @@ inline EdgeBasedEdge::EdgeBasedEdge(const NodeID source,
                                     const NodeID target,
                                     const NodeID edge_id,
                                     const EdgeWeight weight,
+                                    const float length,
                                     const bool forward,
                                     const bool backward)
     : source(source), target(target), edge_id(edge_id), weight(weight), forward(forward),
-      backward(backward)
+      backward(backward), length(length)
 {
 }
 
@@ -0,0 +1,27 @@
+#ifndef OSRM_EXTRACTOR_EDGE_BASED_GRAPH_HPP
+#define OSRM_EXTRACTOR_EDGE_BASED_GRAPH_HPP
+
+#include "extractor/edge_based_edge.hpp"
+#include "util/chunked_vector.hpp"
+#include "util/typedefs.hpp"
+
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+// The edge-expanded graph of an extraction and the weights of its nodes, what the extractor
+// writes to the .ebg and .enw and the contractor reads from them. Passed from Extractor::run to
+// Contractor::Run in memory when both run in the same process.
+struct EdgeBasedGraph
+{
+    EdgeID max_edge_id = 0;
+    util::ChunkedVector<EdgeBasedEdge> edges;
+    std::vector<EdgeWeight> node_weights;
+};
+}
+}
+
+#endif // OSRM_EXTRACTOR_EDGE_BASED_GRAPH_HPP
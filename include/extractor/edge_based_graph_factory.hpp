@@ -3,6 +3,7 @@
 #ifndef EDGE_BASED_GRAPH_FACTORY_HPP_
 #define EDGE_BASED_GRAPH_FACTORY_HPP_
 
+#include "extractor/class_data.hpp"
 #include "extractor/compressed_edge_container.hpp"
 #include "extractor/edge_based_edge.hpp"
 #include "extractor/edge_based_node.hpp"
@@ -17,7 +18,7 @@
 #include "util/guidance/bearing_class.hpp"
 #include "util/guidance/entry_class.hpp"
 
-#include "util/deallocating_vector.hpp"
+#include "util/chunked_vector.hpp"
 #include "util/name_table.hpp"
 #include "util/node_based_graph.hpp"
 #include "util/typedefs.hpp"
@@ -83,7 +84,7 @@ class EdgeBasedGraphFactory
     EdgeBasedGraphFactory(const EdgeBasedGraphFactory &) = delete;
     EdgeBasedGraphFactory &operator=(const EdgeBasedGraphFactory &) = delete;
 
-    explicit EdgeBasedGraphFactory(std::shared_ptr<util::NodeBasedDynamicGraph> node_based_graph,
+    explicit EdgeBasedGraphFactory(std::shared_ptr<util::NodeBasedStaticGraph> node_based_graph,
                                    const CompressedEdgeContainer &compressed_edge_container,
                                    const std::unordered_set<NodeID> &barrier_nodes,
                                    const std::unordered_set<NodeID> &traffic_lights,
@@ -103,10 +104,11 @@ class EdgeBasedGraphFactory
              const bool generate_edge_lookup);
 
     // The following get access functions destroy the content in the factory
-    void GetEdgeBasedEdges(util::DeallocatingVector<EdgeBasedEdge> &edges);
+    void GetEdgeBasedEdges(util::ChunkedVector<EdgeBasedEdge> &edges);
     void GetEdgeBasedNodes(std::vector<EdgeBasedNode> &nodes);
     void GetStartPointMarkers(std::vector<bool> &node_is_startpoint);
     void GetEdgeBasedNodeWeights(std::vector<EdgeWeight> &output_node_weights);
+    void GetEdgeBasedNodeClasses(std::vector<ClassData> &output_node_classes);
 
     // These access functions don't destroy the content
     const std::vector<BearingClassID> &GetBearingClassIds() const;
@@ -128,7 +130,7 @@ class EdgeBasedGraphFactory
                                           const double angle) const;
 
   private:
-    using EdgeData = util::NodeBasedDynamicGraph::EdgeData;
+    using EdgeData = util::NodeBasedStaticGraph::EdgeData;
 
     //! maps index from m_edge_based_node_list to ture/false if the node is an entry point to the
     //! graph
@@ -138,13 +140,16 @@ class EdgeBasedGraphFactory
     //! edge-based node
     std::vector<EdgeWeight> m_edge_based_node_weights;
 
+    //! the classes of the way of every edge-based node, by its id
+    std::vector<ClassData> m_edge_based_node_classes;
+
     //! list of edge based nodes (compressed segments)
     std::vector<EdgeBasedNode> m_edge_based_node_list;
-    util::DeallocatingVector<EdgeBasedEdge> m_edge_based_edge_list;
+    util::ChunkedVector<EdgeBasedEdge> m_edge_based_edge_list;
     EdgeID m_max_edge_id;
 
     const std::vector<QueryNode> &m_node_info_list;
-    std::shared_ptr<util::NodeBasedDynamicGraph> m_node_based_graph;
+    std::shared_ptr<util::NodeBasedStaticGraph> m_node_based_graph;
     std::shared_ptr<RestrictionMap const> m_restriction_map;
 
     const std::unordered_set<NodeID> &m_barrier_nodes;
@@ -8,9 +8,12 @@
 #include "extractor/restriction.hpp"
 #include "extractor/scripting_environment.hpp"
 
+#include "util/coordinate.hpp"
+
+#include <cstddef>
 #include <cstdint>
 #include <stxxl/vector>
-#include <unordered_map>
+#include <vector>
 
 namespace osrm
 {
@@ -25,13 +28,11 @@ namespace extractor
  */
 class ExtractionContainers
 {
-#ifndef _MSC_VER
-    constexpr static unsigned stxxl_memory =
-        ((sizeof(std::size_t) == 4) ? std::numeric_limits<int>::max()
-                                    : std::numeric_limits<unsigned>::max());
-#else
-    const static unsigned stxxl_memory = ((sizeof(std::size_t) == 4) ? INT_MAX : UINT_MAX);
-#endif
+    // bytes of data that are sorted in memory at once
+    const std::size_t sort_memory;
+
+    NodeID GetInternalNodeID(const OSMNodeID node_id) const;
+
     void PrepareNodes();
     void PrepareRestrictions();
     void PrepareEdges(ScriptingEnvironment &scripting_environment);
@@ -58,10 +59,13 @@ class ExtractionContainers
     // an adjacency array containing all turn lane masks
     STXXLRestrictionsVector restrictions_list;
     STXXLWayIDStartEndVector way_start_end_id_list;
-    std::unordered_map<OSMNodeID, NodeID> external_to_internal_node_id_map;
+    // OSM ids of all used nodes in ascending order, the position of an id is its internal id
+    std::vector<OSMNodeID> internal_to_external_node_id_map;
+    // coordinates of all used nodes by their internal id
+    std::vector<util::Coordinate> internal_node_coordinates;
     unsigned max_internal_node_id;
 
-    ExtractionContainers();
+    explicit ExtractionContainers(const std::size_t sort_memory);
 
     void PrepareData(ScriptingEnvironment &scripting_environment,
                      const std::string &output_file_name,
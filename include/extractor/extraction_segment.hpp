@@ -0,0 +1,24 @@
+#ifndef EXTRACTION_SEGMENT_HPP
+#define EXTRACTION_SEGMENT_HPP
+
+#include "extractor/internal_extractor_edge.hpp"
+#include "util/coordinate.hpp"
+
+namespace osrm
+{
+namespace extractor
+{
+
+// A segment between two nodes of a way, whose weight the segment function of the profile can
+// change after looking at the coordinates, e.g. up a raster of elevations
+struct ExtractionSegment
+{
+    util::Coordinate source;
+    util::Coordinate target;
+    double distance;
+    InternalExtractorEdge::WeightData *weight;
+};
+}
+}
+
+#endif // EXTRACTION_SEGMENT_HPP
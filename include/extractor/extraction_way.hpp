@@ -1,6 +1,7 @@
 #ifndef EXTRACTION_WAY_HPP
 #define EXTRACTION_WAY_HPP
 
+#include "extractor/class_data.hpp"
 #include "extractor/guidance/road_classification.hpp"
 #include "extractor/travel_mode.hpp"
 #include "util/guidance/turn_lanes.hpp"
@@ -41,6 +42,7 @@ struct ExtractionWay
         turn_lanes_forward.clear();
         turn_lanes_backward.clear();
         road_classification = guidance::RoadClassification();
+        classes = 0;
     }
 
     // These accessors exists because it's not possible to take the address of a bitfield,
@@ -65,6 +67,8 @@ struct ExtractionWay
     TravelMode forward_travel_mode : 4;
     TravelMode backward_travel_mode : 4;
     guidance::RoadClassification road_classification;
+    // the bits of the names of get_classes, set with set_class in lua
+    ClassData classes;
 };
 }
 }
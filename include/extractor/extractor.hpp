@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define EXTRACTOR_HPP
 
 #include "extractor/edge_based_edge.hpp"
+#include "extractor/edge_based_graph.hpp"
 #include "extractor/edge_based_graph_factory.hpp"
 #include "extractor/extractor_config.hpp"
 #include "extractor/graph_compressor.hpp"
@@ -52,23 +53,28 @@ class Extractor
   public:
     Extractor(ExtractorConfig extractor_config) : config(std::move(extractor_config)) {}
     int run(ScriptingEnvironment &scripting_environment);
+    // Hands the edge-expanded graph to the caller instead of writing the .ebg and .enw, to
+    // contract it in the same process
+    int run(ScriptingEnvironment &scripting_environment, EdgeBasedGraph &edge_based_graph);
 
   private:
     ExtractorConfig config;
 
+    int run(ScriptingEnvironment &scripting_environment, EdgeBasedGraph *edge_based_graph);
+
     std::pair<std::size_t, EdgeID>
     BuildEdgeExpandedGraph(ScriptingEnvironment &scripting_environment,
                            std::vector<QueryNode> &internal_to_external_node_map,
                            std::vector<EdgeBasedNode> &node_based_edge_list,
                            std::vector<bool> &node_is_startpoint,
                            std::vector<EdgeWeight> &edge_based_node_weights,
-                           util::DeallocatingVector<EdgeBasedEdge> &edge_based_edge_list,
+                           util::ChunkedVector<EdgeBasedEdge> &edge_based_edge_list,
                            const std::string &intersection_class_output_file);
     void WriteProfileProperties(const std::string &output_path,
                                 const ProfileProperties &properties) const;
     void WriteNodeMapping(const std::vector<QueryNode> &internal_to_external_node_map);
     void FindComponents(unsigned max_edge_id,
-                        const util::DeallocatingVector<EdgeBasedEdge> &edges,
+                        const util::ChunkedVector<EdgeBasedEdge> &edges,
                         std::vector<EdgeBasedNode> &nodes) const;
     void BuildRTree(std::vector<EdgeBasedNode> node_based_edge_list,
                     std::vector<bool> node_is_startpoint,
@@ -81,7 +87,7 @@ class Extractor
 
     void WriteEdgeBasedGraph(const std::string &output_file_filename,
                              const EdgeID max_edge_id,
-                             util::DeallocatingVector<EdgeBasedEdge> const &edge_based_edge_list);
+                             util::ChunkedVector<EdgeBasedEdge> const &edge_based_edge_list);
 
     void WriteIntersectionClassificationData(
         const std::string &output_file_name,
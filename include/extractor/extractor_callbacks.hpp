@@ -2,38 +2,17 @@
 #define EXTRACTOR_CALLBACKS_HPP
 
 #include "extractor/guidance/turn_lane_types.hpp"
+#include "extractor/name_interner.hpp"
 #include "util/typedefs.hpp"
 
-#include <boost/functional/hash.hpp>
 #include <boost/optional/optional_fwd.hpp>
 
-#include <string>
-#include <unordered_map>
-
 namespace osmium
 {
 class Node;
 class Way;
 }
 
-namespace std
-{
-template <> struct hash<std::tuple<std::string, std::string, std::string, std::string>>
-{
-    std::size_t
-    operator()(const std::tuple<std::string, std::string, std::string, std::string> &mk) const
-        noexcept
-    {
-        std::size_t seed = 0;
-        boost::hash_combine(seed, std::get<0>(mk));
-        boost::hash_combine(seed, std::get<1>(mk));
-        boost::hash_combine(seed, std::get<2>(mk));
-        boost::hash_combine(seed, std::get<3>(mk));
-        return seed;
-    }
-};
-}
-
 namespace osrm
 {
 namespace extractor
@@ -54,11 +33,8 @@ struct ExtractionWay;
 class ExtractorCallbacks
 {
   private:
-    // used to deduplicate street names, refs, destinations, pronunciation: actually maps to name
-    // ids
-    using MapKey = std::tuple<std::string, std::string, std::string, std::string>;
-    using MapVal = unsigned;
-    std::unordered_map<MapKey, MapVal> string_map;
+    // used to deduplicate street names, refs, destinations, pronunciation into name ids
+    NameInterner name_interner;
     guidance::LaneDescriptionMap lane_description_map;
     ExtractionContainers &external_memory;
 
@@ -77,6 +53,14 @@ class ExtractorCallbacks
     // warning: caller needs to take care of synchronization!
     void ProcessWay(const osmium::Way &current_way, const ExtractionWay &result_way);
 
+    // same as above with the key of the names of the way, which can be made beforehand in parallel
+    void ProcessWay(const osmium::Way &current_way,
+                    const ExtractionWay &result_way,
+                    const NameInterner::Key &name_key);
+
+    // whether ProcessWay turns the way into edges
+    static bool IsRoutable(const osmium::Way &current_way, const ExtractionWay &result_way);
+
     // destroys the internal laneDescriptionMap
     guidance::LaneDescriptionMap &&moveOutLaneDescriptionMap();
 };
@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <array>
 #include <string>
+#include <vector>
 
 namespace osrm
 {
@@ -40,7 +41,14 @@ namespace extractor
 
 struct ExtractorConfig
 {
-    ExtractorConfig() noexcept : requested_num_threads(0) {}
+    ExtractorConfig() noexcept : requested_num_threads(0),
+                                 sort_memory(4096),
+                                 generate_geometry_zoom_levels(false),
+                                 generate_segment_lengths(false),
+                                 two_pass(false),
+                                 reuse_way_results(false)
+    {
+    }
     void UseDefaultOutputNames()
     {
         std::string basepath = input_path.string();
@@ -65,16 +73,21 @@ struct ExtractorConfig
         turn_lane_data_file_name = basepath + ".osrm.tld";
         timestamp_file_name = basepath + ".osrm.timestamp";
         geometry_output_path = basepath + ".osrm.geometry";
+        geometry_zoom_levels_output_path = basepath + ".osrm.geometry_zoom_levels";
+        geometry_lengths_output_path = basepath + ".osrm.geometry_lengths";
         node_output_path = basepath + ".osrm.nodes";
         edge_output_path = basepath + ".osrm.edges";
         edge_graph_output_path = basepath + ".osrm.ebg";
         rtree_nodes_output_path = basepath + ".osrm.ramIndex";
         rtree_leafs_output_path = basepath + ".osrm.fileIndex";
+        node_renumbering_path = basepath + ".osrm.node_renumbering";
         edge_segment_lookup_path = basepath + ".osrm.edge_segment_lookup";
         edge_penalty_path = basepath + ".osrm.edge_penalties";
         edge_based_node_weights_output_path = basepath + ".osrm.enw";
+        classes_output_path = basepath + ".osrm.classes";
         profile_properties_output_path = basepath + ".osrm.properties";
         intersection_class_data_output_path = basepath + ".osrm.icd";
+        way_results_path = basepath + ".osrm.way_results";
     }
 
     boost::filesystem::path input_path;
@@ -87,21 +100,45 @@ struct ExtractorConfig
     std::string turn_lane_descriptions_file_name;
     std::string timestamp_file_name;
     std::string geometry_output_path;
+    std::string geometry_zoom_levels_output_path;
+    std::string geometry_lengths_output_path;
     std::string edge_output_path;
     std::string edge_graph_output_path;
     std::string edge_based_node_weights_output_path;
+    // the class names of the profile and the classes of the edge-based nodes
+    std::string classes_output_path;
     std::string node_output_path;
     std::string rtree_nodes_output_path;
     std::string rtree_leafs_output_path;
+    // written by osrm-contract, no longer valid for a new r-tree
+    std::string node_renumbering_path;
     std::string profile_properties_output_path;
     std::string intersection_class_data_output_path;
 
     unsigned requested_num_threads;
     unsigned small_component_size;
+    // MiB of data that are sorted in memory at once, larger data is merged from sorted runs
+    unsigned sort_memory;
 
     bool generate_edge_lookup;
+    // precomputes the zoom levels of the compressed geometries for the overview simplification
+    bool generate_geometry_zoom_levels;
+    // precomputes the lengths of the segments for the annotations and the debug tiles
+    bool generate_segment_lengths;
+    // reads the ways of the input first and only keeps the nodes of routable ways
+    bool two_pass;
+    // .osc files that are applied to the input while it is read
+    std::vector<boost::filesystem::path> change_paths;
+    // reuses the results of the profile for the ways of the last extraction that didn't change
+    bool reuse_way_results;
+    std::string way_results_path;
     std::string edge_penalty_path;
     std::string edge_segment_lookup_path;
+
+    // the phases are written to this file with what they cost, see util::PhaseTrace
+    boost::filesystem::path trace_path;
+    // json or chrome
+    std::string trace_format;
 };
 }
 }
@@ -16,11 +16,26 @@ namespace extractor
 class CompressedEdgeContainer;
 class RestrictionMap;
 
+// Compresses the degree 2 nodes of the node-based graph into the edges of their neighbours.
+//
+// The serial mode visits the nodes by their id and compresses every node it can. The parallel
+// mode checks the nodes and walks the chains of compressible nodes in parallel, applies the
+// compressions to the graph and the turn restrictions in the order of the serial mode and fills
+// in the geometries of the chains in parallel. Both give the same graph, restrictions and
+// geometries, down to the ids of the buckets.
 class GraphCompressor
 {
     using EdgeData = util::NodeBasedDynamicGraph::EdgeData;
 
   public:
+    enum class Mode
+    {
+        Serial,
+        Parallel
+    };
+
+    explicit GraphCompressor(const Mode mode = Mode::Parallel) : mode(mode) {}
+
     void Compress(const std::unordered_set<NodeID> &barrier_nodes,
                   const std::unordered_set<NodeID> &traffic_lights,
                   RestrictionMap &restriction_map,
@@ -28,9 +43,42 @@ class GraphCompressor
                   CompressedEdgeContainer &geometry_compressor);
 
   private:
+    void CompressSerial(const std::unordered_set<NodeID> &barrier_nodes,
+                        const std::unordered_set<NodeID> &traffic_lights,
+                        RestrictionMap &restriction_map,
+                        util::NodeBasedDynamicGraph &graph,
+                        CompressedEdgeContainer &geometry_compressor) const;
+
+    void CompressParallel(const std::unordered_set<NodeID> &barrier_nodes,
+                          const std::unordered_set<NodeID> &traffic_lights,
+                          RestrictionMap &restriction_map,
+                          util::NodeBasedDynamicGraph &graph,
+                          CompressedEdgeContainer &geometry_compressor) const;
+
+    // Whether the node can be compressed into the edges of its current neighbours, but for the
+    // neighbours being connected already
+    bool CanCompress(const NodeID node_v,
+                     const std::unordered_set<NodeID> &barrier_nodes,
+                     const std::unordered_set<NodeID> &traffic_lights,
+                     const RestrictionMap &restriction_map,
+                     const util::NodeBasedDynamicGraph &graph) const;
+
+    bool HasConnectedNeighbours(const NodeID node_v,
+                                const util::NodeBasedDynamicGraph &graph) const;
+
+    // Merges the edges of the node into the edges of its neighbours. With reserve_geometry the
+    // buckets of the geometry are only assigned, their content is added later.
+    void CompressNode(const NodeID node_v,
+                      RestrictionMap &restriction_map,
+                      util::NodeBasedDynamicGraph &graph,
+                      CompressedEdgeContainer &geometry_compressor,
+                      const bool reserve_geometry) const;
+
     void PrintStatistics(unsigned original_number_of_nodes,
                          unsigned original_number_of_edges,
                          const util::NodeBasedDynamicGraph &graph) const;
+
+    Mode mode;
 };
 }
 }
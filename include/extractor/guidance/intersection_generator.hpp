@@ -10,6 +10,12 @@
 #include "util/node_based_graph.hpp"
 #include "util/typedefs.hpp"
 
+#include <tbb/enumerable_thread_specific.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -27,7 +33,24 @@ namespace guidance
 class IntersectionGenerator
 {
   public:
-    IntersectionGenerator(const util::NodeBasedDynamicGraph &node_based_graph,
+    // While a scope exists, the connected roads computed on its thread are cached. Guidance
+    // looks at the same neighbouring intersections for many turns, but the graph doesn't change
+    // during the analysis, so the scope only bounds the memory of the cache. Scopes can nest,
+    // the cache is cleared when the outermost one ends.
+    class CacheScope
+    {
+      public:
+        explicit CacheScope(const IntersectionGenerator &generator);
+        ~CacheScope();
+
+        CacheScope(const CacheScope &) = delete;
+        CacheScope &operator=(const CacheScope &) = delete;
+
+      private:
+        const IntersectionGenerator &generator;
+    };
+
+    IntersectionGenerator(const util::NodeBasedStaticGraph &node_based_graph,
                           const RestrictionMap &restriction_map,
                           const std::unordered_set<NodeID> &barrier_nodes,
                           const std::vector<QueryNode> &node_info_list,
@@ -46,13 +69,32 @@ class IntersectionGenerator
                                            NodeID *resulting_from_node,
                                            EdgeID *resulting_via_edge) const;
 
+    // Number of times connected roads were computed and answered from a cache
+    std::size_t GetNumberOfComputedConnectedRoads() const;
+    std::size_t GetNumberOfCachedConnectedRoads() const;
+
   private:
-    const util::NodeBasedDynamicGraph &node_based_graph;
+    struct ConnectedRoadsCache
+    {
+        unsigned scope_depth = 0;
+        // keyed by the node we come from and the via edge
+        std::unordered_map<std::uint64_t, Intersection> intersections;
+    };
+
+    const util::NodeBasedStaticGraph &node_based_graph;
     const RestrictionMap &restriction_map;
     const std::unordered_set<NodeID> &barrier_nodes;
     const std::vector<QueryNode> &node_info_list;
     const CompressedEdgeContainer &compressed_edge_container;
 
+    mutable tbb::enumerable_thread_specific<ConnectedRoadsCache> connected_roads_caches;
+    mutable std::atomic<std::size_t> number_of_computed_connected_roads;
+    mutable std::atomic<std::size_t> number_of_cached_connected_roads;
+
+    // Returns the connected roads from the cache of the thread if there is a scope
+    OSRM_ATTR_WARN_UNUSED
+    Intersection GetCachedConnectedRoads(const NodeID from_node, const EdgeID via_eid) const;
+
     // Check for restrictions/barriers and generate a list of valid and invalid turns present at
     // the
     // node reached
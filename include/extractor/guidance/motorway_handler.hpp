@@ -24,7 +24,7 @@ namespace guidance
 class MotorwayHandler : public IntersectionHandler
 {
   public:
-    MotorwayHandler(const util::NodeBasedDynamicGraph &node_based_graph,
+    MotorwayHandler(const util::NodeBasedStaticGraph &node_based_graph,
                     const std::vector<QueryNode> &node_info_list,
                     const util::NameTable &name_table,
                     const SuffixTable &street_name_suffix_table,
@@ -40,7 +40,7 @@ struct RoundaboutFlags
 class RoundaboutHandler : public IntersectionHandler
 {
   public:
-    RoundaboutHandler(const util::NodeBasedDynamicGraph &node_based_graph,
+    RoundaboutHandler(const util::NodeBasedStaticGraph &node_based_graph,
                       const std::vector<QueryNode> &node_info_list,
                       const CompressedEdgeContainer &compressed_edge_container,
                       const util::NameTable &name_table,
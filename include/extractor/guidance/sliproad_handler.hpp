@@ -26,7 +26,7 @@ class SliproadHandler : public IntersectionHandler
 {
   public:
     SliproadHandler(const IntersectionGenerator &intersection_generator,
-                    const util::NodeBasedDynamicGraph &node_based_graph,
+                    const util::NodeBasedStaticGraph &node_based_graph,
                     const std::vector<QueryNode> &node_info_list,
                     const util::NameTable &name_table,
                     const SuffixTable &street_name_suffix_table);
@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <iterator>
 #include <map>
 #include <string>
 #include <unordered_map>
@@ -142,7 +143,11 @@ getRepresentativeCoordinate(const NodeID from_node,
 
         if (traverse_in_reverse)
             return detail::getCoordinateFromCompressedRange(
-                base_coordinate, geometry.rbegin(), geometry.rend(), final_coordinate, query_nodes);
+                base_coordinate,
+                std::make_reverse_iterator(geometry.end()),
+                std::make_reverse_iterator(geometry.begin()),
+                final_coordinate,
+                query_nodes);
         else
             return detail::getCoordinateFromCompressedRange(
                 base_coordinate, geometry.begin(), geometry.end(), final_coordinate, query_nodes);
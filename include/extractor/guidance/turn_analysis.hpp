@@ -36,7 +36,7 @@ class TurnAnalysis
 {
 
   public:
-    TurnAnalysis(const util::NodeBasedDynamicGraph &node_based_graph,
+    TurnAnalysis(const util::NodeBasedStaticGraph &node_based_graph,
                  const std::vector<QueryNode> &node_info_list,
                  const RestrictionMap &restriction_map,
                  const std::unordered_set<NodeID> &barrier_nodes,
@@ -56,7 +56,7 @@ class TurnAnalysis
     const IntersectionGenerator &getGenerator() const;
 
   private:
-    const util::NodeBasedDynamicGraph &node_based_graph;
+    const util::NodeBasedStaticGraph &node_based_graph;
     const IntersectionGenerator intersection_generator;
     const RoundaboutHandler roundabout_handler;
     const MotorwayHandler motorway_handler;
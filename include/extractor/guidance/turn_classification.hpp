@@ -24,12 +24,24 @@ namespace extractor
 namespace guidance
 {
 
+// The bearing of every edge of the graph from its source to the representative coordinate of its
+// geometry, indexed by edge id, so the edges of a node are next to each other. The intersection of
+// a node is classified for every edge that leads into it, with the same bearings each time, so
+// they are computed once and in parallel.
+std::vector<double>
+computeEdgeBearings(const util::NodeBasedStaticGraph &node_based_graph,
+                    const extractor::CompressedEdgeContainer &compressed_geometries,
+                    const std::vector<extractor::QueryNode> &query_nodes);
+
+// The edge bearings are the ones of computeEdgeBearings, the roads that are not edges of the
+// node get their bearing computed.
 std::pair<util::guidance::EntryClass, util::guidance::BearingClass>
 classifyIntersection(NodeID nid,
                      const Intersection &intersection,
-                     const util::NodeBasedDynamicGraph &node_based_graph,
+                     const util::NodeBasedStaticGraph &node_based_graph,
                      const extractor::CompressedEdgeContainer &compressed_geometries,
-                     const std::vector<extractor::QueryNode> &query_nodes);
+                     const std::vector<extractor::QueryNode> &query_nodes,
+                     const std::vector<double> &edge_bearings);
 
 } // namespace guidance
 } // namespace extractor
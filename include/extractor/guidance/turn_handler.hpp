@@ -26,7 +26,7 @@ namespace guidance
 class TurnHandler : public IntersectionHandler
 {
   public:
-    TurnHandler(const util::NodeBasedDynamicGraph &node_based_graph,
+    TurnHandler(const util::NodeBasedStaticGraph &node_based_graph,
                 const std::vector<QueryNode> &node_info_list,
                 const util::NameTable &name_table,
                 const SuffixTable &street_name_suffix_table,
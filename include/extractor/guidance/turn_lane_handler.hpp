@@ -69,7 +69,7 @@ class TurnLaneHandler
   public:
     typedef std::vector<TurnLaneData> LaneDataVector;
 
-    TurnLaneHandler(const util::NodeBasedDynamicGraph &node_based_graph,
+    TurnLaneHandler(const util::NodeBasedStaticGraph &node_based_graph,
                     std::vector<std::uint32_t> &turn_lane_offsets,
                     std::vector<TurnLaneType::Mask> &turn_lane_masks,
                     LaneDescriptionMap &lane_description_map,
@@ -87,13 +87,15 @@ class TurnLaneHandler
     mutable std::atomic<std::size_t> count_called;
     // we need to be able to look at previous intersections to, in some cases, find the correct turn
     // lanes for a turn
-    const util::NodeBasedDynamicGraph &node_based_graph;
+    const util::NodeBasedStaticGraph &node_based_graph;
     std::vector<std::uint32_t> &turn_lane_offsets;
     std::vector<TurnLaneType::Mask> &turn_lane_masks;
     LaneDescriptionMap &lane_description_map;
     const std::vector<QueryNode> &node_info_list;
     const TurnAnalysis &turn_analysis;
     LaneDataIdMap &id_map;
+    // the sorted lane data of every lane description, which many intersections share
+    std::vector<LaneDataVector> lane_data_by_description;
 
     // Find out which scenario we have to handle
     TurnLaneScenario deduceScenario(const NodeID at,
@@ -132,7 +134,7 @@ class TurnLaneHandler
                                     LaneDataVector lane_data,
                                     const Intersection &previous_intersection);
 
-    // get the lane data for an intersection
+    // get the lane data for an intersection, copied from the decoded lane descriptions
     void extractLaneData(const EdgeID via_edge,
                          LaneDescriptionID &lane_description_id,
                          LaneDataVector &lane_data) const;
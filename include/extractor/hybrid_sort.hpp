@@ -0,0 +1,109 @@
+#ifndef HYBRID_SORT_HPP
+#define HYBRID_SORT_HPP
+
+#include <boost/assert.hpp>
+
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+/**
+ * Sorts a vector, typically an external stxxl::vector, with tbb::parallel_sort.
+ *
+ * Data that fits into memory_budget bytes is copied into memory, sorted on all cores and copied
+ * back. Larger data is split into runs of the budget's size that are sorted the same way in
+ * place, and then merged into a new vector. The merge reads every run in blocks, which together
+ * stay within the budget.
+ *
+ * The comparison is called concurrently, so it must not use containers that are not safe to
+ * read from several threads, like other stxxl vectors.
+ */
+template <typename VectorT, typename Compare>
+void hybridSort(VectorT &data, const Compare &compare, const std::size_t memory_budget)
+{
+    using ValueT = typename VectorT::value_type;
+    const std::size_t size = data.size();
+    const std::size_t run_size = std::max<std::size_t>(1, memory_budget / sizeof(ValueT));
+
+    std::vector<ValueT> buffer;
+    std::size_t number_of_runs = 0;
+    for (std::size_t begin = 0; begin < size; begin += run_size, ++number_of_runs)
+    {
+        const std::size_t end = std::min(size, begin + run_size);
+        buffer.assign(data.begin() + begin, data.begin() + end);
+        tbb::parallel_sort(buffer.begin(), buffer.end(), compare);
+        std::copy(buffer.begin(), buffer.end(), data.begin() + begin);
+    }
+    if (number_of_runs <= 1)
+    {
+        return;
+    }
+    buffer.clear();
+    buffer.shrink_to_fit();
+
+    struct Run
+    {
+        std::size_t next;
+        std::size_t end;
+        std::vector<ValueT> block;
+        std::size_t block_position;
+    };
+    const std::size_t block_size = std::max<std::size_t>(1, run_size / (number_of_runs + 1));
+    std::vector<Run> runs(number_of_runs);
+    const auto readBlock = [&](Run &run) {
+        const std::size_t block_end = std::min(run.end, run.next + block_size);
+        run.block.assign(data.begin() + run.next, data.begin() + block_end);
+        run.block_position = 0;
+        run.next = block_end;
+    };
+
+    // heap of the runs by their smallest remaining element
+    const auto greater = [&](const std::size_t lhs, const std::size_t rhs) {
+        return compare(runs[rhs].block[runs[rhs].block_position],
+                       runs[lhs].block[runs[lhs].block_position]);
+    };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(greater)> heap(greater);
+    for (std::size_t index = 0; index < number_of_runs; ++index)
+    {
+        runs[index].next = index * run_size;
+        runs[index].end = std::min(size, runs[index].next + run_size);
+        readBlock(runs[index]);
+        heap.push(index);
+    }
+
+    VectorT merged;
+    while (!heap.empty())
+    {
+        const std::size_t index = heap.top();
+        heap.pop();
+        Run &smallest = runs[index];
+        merged.push_back(smallest.block[smallest.block_position++]);
+
+        if (smallest.block_position == smallest.block.size())
+        {
+            if (smallest.next == smallest.end)
+            {
+                smallest.block.clear();
+                smallest.block.shrink_to_fit();
+                continue;
+            }
+            readBlock(smallest);
+        }
+        heap.push(index);
+    }
+    BOOST_ASSERT(merged.size() == size);
+    data.swap(merged);
+}
+}
+}
+
+#endif // HYBRID_SORT_HPP
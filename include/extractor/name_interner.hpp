@@ -0,0 +1,79 @@
+#ifndef NAME_INTERNER_HPP
+#define NAME_INTERNER_HPP
+
+#include "util/string_view.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+struct ExtractionWay;
+
+// Deduplicates the name, destinations, pronunciation and ref of ways into name ids.
+//
+// A key holds views of the four strings and their hash. It is made without touching the
+// interner, so the threads that run the profile can hash the names of their ways and the serial
+// stage only probes the table. The strings of new names are copied into an arena of large
+// blocks, which the table refers to, so there is no allocation per name.
+class NameInterner
+{
+  public:
+    // the strings are truncated to the length that is stored for a name
+    static constexpr std::size_t MAX_STRING_LENGTH = 255;
+
+    struct Key
+    {
+        // name, destinations, pronunciation and ref, in the order they are stored
+        std::array<util::StringView, 4> strings;
+        std::size_t hash;
+    };
+
+    static Key MakeKey(const util::StringView name,
+                       const util::StringView destinations,
+                       const util::StringView pronunciation,
+                       const util::StringView ref);
+    static Key MakeKey(const ExtractionWay &way);
+
+    NameInterner();
+
+    NameInterner(const NameInterner &) = delete;
+    NameInterner &operator=(const NameInterner &) = delete;
+
+    // The id of the name of the key. Names that were not interned yet get the new id.
+    unsigned Intern(const Key &key, const unsigned new_id);
+
+    std::size_t Size() const { return size; }
+
+  private:
+    struct Slot
+    {
+        // nullptr marks an empty slot
+        const char *data;
+        std::size_t hash;
+        std::array<std::uint8_t, 4> lengths;
+        unsigned id;
+    };
+
+    static bool Equals(const Slot &slot, const Key &key);
+    std::size_t GetIndex(const std::size_t hash) const;
+    const char *Store(const Key &key);
+    void Rehash(const std::size_t capacity);
+
+    std::vector<Slot> slots;
+    std::size_t size;
+    unsigned shift;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::size_t block_used;
+};
+}
+}
+
+#endif // NAME_INTERNER_HPP
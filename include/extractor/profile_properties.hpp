@@ -12,7 +12,8 @@ struct ProfileProperties
 {
     ProfileProperties()
         : traffic_signal_penalty(0), u_turn_penalty(0), continue_straight_at_waypoint(true),
-        use_turn_restrictions(false), left_hand_driving(false)
+        use_turn_restrictions(false), left_hand_driving(false),
+        component_ids_in_topological_order(false)
     {
     }
 
@@ -37,6 +38,9 @@ struct ProfileProperties
     bool continue_straight_at_waypoint;
     bool use_turn_restrictions;
     bool left_hand_driving;
+    //! whether a component only reaches components with larger ids. Not a bool, so that it lies
+    //! behind the fields of older files which leave it false.
+    unsigned component_ids_in_topological_order;
 };
 }
 }
@@ -4,15 +4,16 @@
 #include "util/coordinate.hpp"
 #include "util/exception.hpp"
 
-#include <boost/algorithm/string/trim.hpp>
 #include <boost/assert.hpp>
-#include <boost/filesystem.hpp>
-#include <boost/filesystem/fstream.hpp>
-#include <boost/spirit/include/qi.hpp>
-#include <boost/spirit/include/qi_int.hpp>
+#include <boost/filesystem/path.hpp>
 
-#include <iterator>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace osrm
 {
@@ -34,65 +35,61 @@ struct RasterDatum
     RasterDatum(std::int32_t _datum) : datum(_datum) {}
 };
 
+/**
+    \brief The values of a raster, stored in square tiles of TILE_SIZE * TILE_SIZE values.
+
+    A raster is read either from an ASCII grid of whitespace separated integers or from the
+    tiled binary format written by WriteTiles (osrm-raster converts an ASCII grid once). The
+    binary format is memory mapped, the pages of a tile are only read when it is queried and are
+    shared with other processes. Nearby coordinates fall into the same tile, so the values an
+    interpolation or the queries of a way touch are in a few pages.
+
+    Grids are shared: loading the same file with the same dimensions again, e.g. from the lua
+    state of another thread, hands out the grid that is already loaded.
+*/
 class RasterGrid
 {
   public:
-    RasterGrid(const boost::filesystem::path &filepath, std::size_t _xdim, std::size_t _ydim)
+    static constexpr std::size_t TILE_BITS = 6;
+    static constexpr std::size_t TILE_SIZE = std::size_t{1} << TILE_BITS;
+
+    // Loads a raster of the given number of columns and rows, throws if it can't be read or
+    // doesn't have these dimensions
+    static RasterGrid Load(const boost::filesystem::path &filepath,
+                           std::size_t xdim,
+                           std::size_t ydim);
+
+    // Writes the raster in the tiled binary format
+    void WriteTiles(const boost::filesystem::path &filepath) const;
+
+    std::int32_t operator()(std::size_t x, std::size_t y) const
     {
-        xdim = _xdim;
-        ydim = _ydim;
-        _data.reserve(ydim * xdim);
-
-        boost::filesystem::ifstream stream(filepath, std::ios::binary);
-        if (!stream)
-        {
-            throw util::exception("Unable to open raster file.");
-        }
-
-        stream.seekg(0, std::ios_base::end);
-        std::string buffer;
-        buffer.resize(static_cast<std::size_t>(stream.tellg()));
-
-        stream.seekg(0, std::ios_base::beg);
-
-        BOOST_ASSERT(buffer.size() > 1);
-        stream.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
-
-        boost::algorithm::trim(buffer);
-
-        auto itr = buffer.begin();
-        auto end = buffer.end();
-
-        bool r = false;
-        try
-        {
-            r = boost::spirit::qi::parse(
-                itr, end, +boost::spirit::qi::int_ % +boost::spirit::qi::space, _data);
-        }
-        catch (std::exception const &ex)
-        {
-            throw util::exception(
-                std::string("Failed to read from raster source with exception: ") + ex.what());
-        }
-
-        if (!r || itr != end)
-        {
-            throw util::exception("Failed to parse raster source correctly.");
-        }
+        BOOST_ASSERT(x < xdim);
+        BOOST_ASSERT(y < ydim);
+        return tiles[(GetTile(x, y) << (2 * TILE_BITS)) + ((y & (TILE_SIZE - 1)) << TILE_BITS) +
+                     (x & (TILE_SIZE - 1))];
     }
 
-    RasterGrid(const RasterGrid &) = default;
-    RasterGrid &operator=(const RasterGrid &) = default;
-
-    RasterGrid(RasterGrid &&) = default;
-    RasterGrid &operator=(RasterGrid &&) = default;
+    // the index of the tile of the value, tiles are numbered row by row
+    std::size_t GetTile(std::size_t x, std::size_t y) const
+    {
+        return (y >> TILE_BITS) * tiles_per_row + (x >> TILE_BITS);
+    }
 
-    std::int32_t operator()(std::size_t x, std::size_t y) { return _data[y * xdim + x]; }
-    std::int32_t operator()(std::size_t x, std::size_t y) const { return _data[(y)*xdim + (x)]; }
+    std::size_t GetWidth() const { return xdim; }
+    std::size_t GetHeight() const { return ydim; }
 
   private:
-    std::vector<std::int32_t> _data;
+    RasterGrid(std::shared_ptr<const void> storage,
+               const std::int32_t *tiles,
+               std::size_t xdim,
+               std::size_t ydim);
+
+    // the vector of tiles or the mapped file, tiles points into it
+    std::shared_ptr<const void> storage;
+    const std::int32_t *tiles;
     std::size_t xdim, ydim;
+    std::size_t tiles_per_row;
 };
 
 /**
@@ -120,6 +117,10 @@ class RasterSource
 
     RasterDatum GetRasterInterpolate(const int lon, const int lat) const;
 
+    // Interpolates the values at all coordinates, tile by tile
+    void GetRasterInterpolate(const std::vector<util::Coordinate> &coordinates,
+                              std::vector<RasterDatum> &data) const;
+
     RasterSource(RasterGrid _raster_data,
                  std::size_t width,
                  std::size_t height,
@@ -146,7 +147,14 @@ class SourceContainer
 
     RasterDatum GetRasterInterpolateFromSource(unsigned int source_id, double lon, double lat);
 
+    // Interpolates the data at many coordinates with a single call
+    void GetRasterInterpolateFromSource(unsigned int source_id,
+                                        const std::vector<util::Coordinate> &coordinates,
+                                        std::vector<RasterDatum> &data) const;
+
   private:
+    const RasterSource &GetSource(unsigned int source_id) const;
+
     std::vector<RasterSource> LoadedSources;
     std::unordered_map<std::string, int> LoadedSourcePaths;
 };
@@ -3,14 +3,14 @@
 
 #include "extractor/edge_based_edge.hpp"
 #include "extractor/restriction.hpp"
+#include "util/flat_hash_map.hpp"
 #include "util/std_hash.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/assert.hpp>
 
+#include <cstdint>
 #include <memory>
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 namespace osrm
@@ -72,6 +72,11 @@ namespace extractor
 /**
     \brief Efficent look up if an edge is the start + via node of a TurnRestriction
     EdgeBasedEdgeFactory decides by it if edges are inserted or geometry is compressed
+
+    The start and via nodes are bitsets indexed by node id and the (start, via) pairs are kept in
+    an open addressing hash map, so the checks done for every turn touch a few cache lines. Only
+    the fixups of the graph compression modify the map, afterwards the const methods can be
+    used by any number of threads at the same time.
 */
 class RestrictionMap
 {
@@ -109,14 +114,13 @@ class RestrictionMap
 
         for (const NodeID node_x : predecessors)
         {
-            const auto restriction_iterator = m_restriction_map.find({node_x, node_u});
-            if (restriction_iterator == m_restriction_map.end())
+            const auto index = m_restriction_map.Find(GetKey({node_x, node_u}));
+            if (!index)
             {
                 continue;
             }
 
-            const unsigned index = restriction_iterator->second;
-            auto &bucket = m_restriction_bucket_list.at(index);
+            auto &bucket = m_restriction_bucket_list.at(*index);
 
             for (RestrictionTarget &restriction_target : bucket)
             {
@@ -147,15 +151,28 @@ class RestrictionMap
     // check of node is the start of any restriction
     bool IsSourceNode(const NodeID node) const;
 
+    // start and via node packed into one key of the hash map, never its empty key
+    static std::uint64_t GetKey(const RestrictionSource &source)
+    {
+        return (static_cast<std::uint64_t>(source.start_node) << 32) | source.via_node;
+    }
+
+    static bool IsMarked(const std::vector<bool> &nodes, const NodeID node)
+    {
+        return node < nodes.size() && nodes[node];
+    }
+
     using EmanatingRestrictionsVector = std::vector<RestrictionTarget>;
 
     std::size_t m_count;
     //! index -> list of (target, isOnly)
     std::vector<EmanatingRestrictionsVector> m_restriction_bucket_list;
     //! maps (start, via) -> bucket index
-    std::unordered_map<RestrictionSource, unsigned> m_restriction_map;
-    std::unordered_set<NodeID> m_restriction_start_nodes;
-    std::unordered_set<NodeID> m_no_turn_via_node_set;
+    util::FlatHashMap<std::uint64_t, unsigned> m_restriction_map;
+    //! node id -> is the start of a restriction
+    std::vector<bool> m_restriction_start_nodes;
+    //! node id -> is the via node of a restriction
+    std::vector<bool> m_no_turn_via_node_set;
 };
 }
 }
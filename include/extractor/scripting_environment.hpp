@@ -1,6 +1,7 @@
 #ifndef SCRIPTING_ENVIRONMENT_HPP
 #define SCRIPTING_ENVIRONMENT_HPP
 
+#include "extractor/extraction_segment.hpp"
 #include "extractor/guidance/turn_lane_types.hpp"
 #include "extractor/internal_extractor_edge.hpp"
 #include "extractor/profile_properties.hpp"
@@ -52,12 +53,12 @@ class ScriptingEnvironment
 
     virtual std::vector<std::string> GetNameSuffixList() = 0;
     virtual std::vector<std::string> GetExceptions() = 0;
+    // The names of the bits of ExtractionWay::classes, at most MAX_CLASSES
+    virtual std::vector<std::string> GetClassNames() = 0;
     virtual void SetupSources() = 0;
     virtual int32_t GetTurnPenalty(double angle) = 0;
-    virtual void ProcessSegment(const osrm::util::Coordinate &source,
-                                const osrm::util::Coordinate &target,
-                                double distance,
-                                InternalExtractorEdge::WeightData &weight) = 0;
+    // Hands the segments to the profile, once if it can process them in a batch
+    virtual void ProcessSegments(const std::vector<ExtractionSegment> &segments) = 0;
     virtual void
     ProcessElements(const std::vector<osmium::memory::Buffer::const_iterator> &osm_elements,
                     const RestrictionParser &restriction_parser,
@@ -3,6 +3,7 @@
 
 #include "extractor/scripting_environment.hpp"
 
+#include "extractor/extraction_way.hpp"
 #include "extractor/raster_source.hpp"
 
 #include "util/lua_util.hpp"
@@ -12,6 +13,8 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 struct lua_State;
 
@@ -24,6 +27,22 @@ struct LuaScriptingContext final
 {
     void processNode(const osmium::Node &, ExtractionNode &result);
     void processWay(const osmium::Way &, ExtractionWay &result);
+    // Hands all ways to way_batch_function in a single call
+    void processWays(const std::vector<const osmium::Way *> &ways,
+                     std::vector<ExtractionWay> &results);
+    void processSegment(const ExtractionSegment &segment);
+    // Hands all segments to segment_batch_function in a single call
+    void processSegments(const std::vector<ExtractionSegment> &segments);
+
+    // The values of the keys of get_way_cache_keys, ways with the same signature get the same
+    // results from way_function except for the names
+    std::string getWaySignature(const osmium::Way &way) const;
+    // Copies the cached results of the signature and sets the names with way_name_function,
+    // returns false if the signature isn't cached
+    bool processCachedWay(const std::string &signature,
+                          const osmium::Way &way,
+                          ExtractionWay &result);
+    void cacheWay(std::string signature, const ExtractionWay &result);
 
     ProfileProperties properties;
     SourceContainer sources;
@@ -32,7 +51,30 @@ struct LuaScriptingContext final
     bool has_turn_penalty_function;
     bool has_node_function;
     bool has_way_function;
+    bool has_way_batch_function;
     bool has_segment_function;
+    bool has_segment_batch_function;
+    bool has_sources;
+
+    // the names of get_classes, set_class looks them up
+    std::vector<std::string> class_names;
+
+    // The keys of get_node_keys and get_way_keys, elements without any of them get the default
+    // results without a call into the profile
+    bool has_node_keys;
+    bool has_way_keys;
+    std::vector<std::string> node_keys;
+    std::vector<std::string> way_keys;
+    std::size_t number_of_skipped_nodes = 0;
+    std::size_t number_of_skipped_ways = 0;
+
+    // Results of way_function without the names, by the signature of the way. Every thread has
+    // its own cache, it only grows up to a maximum size.
+    bool has_way_cache;
+    std::vector<std::string> way_cache_keys;
+    std::unordered_map<std::string, ExtractionWay> way_cache;
+    std::size_t number_of_cached_ways = 0;
+    std::size_t number_of_signatures = 0;
 };
 
 /**
@@ -46,7 +88,7 @@ class LuaScriptingEnvironment final : public ScriptingEnvironment
 {
   public:
     explicit LuaScriptingEnvironment(const std::string &file_name);
-    ~LuaScriptingEnvironment() override = default;
+    ~LuaScriptingEnvironment() override;
 
     const ProfileProperties &GetProfileProperties() override;
 
@@ -54,12 +96,10 @@ class LuaScriptingEnvironment final : public ScriptingEnvironment
 
     std::vector<std::string> GetNameSuffixList() override;
     std::vector<std::string> GetExceptions() override;
+    std::vector<std::string> GetClassNames() override;
     void SetupSources() override;
     int32_t GetTurnPenalty(double angle) override;
-    void ProcessSegment(const osrm::util::Coordinate &source,
-                        const osrm::util::Coordinate &target,
-                        double distance,
-                        InternalExtractorEdge::WeightData &weight) override;
+    void ProcessSegments(const std::vector<ExtractionSegment> &segments) override;
     void
     ProcessElements(const std::vector<osmium::memory::Buffer::const_iterator> &osm_elements,
                     const RestrictionParser &restriction_parser,
@@ -0,0 +1,48 @@
+#ifndef SCRIPTING_ENVIRONMENT_NATIVE_HPP
+#define SCRIPTING_ENVIRONMENT_NATIVE_HPP
+
+#include "extractor/car_profile.hpp"
+#include "extractor/scripting_environment.hpp"
+
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+/**
+ * Runs the compiled car profile instead of a lua script. The profile is a configuration file
+ * like profiles/car.ini that changes the tables of the car profile.
+ *
+ * The profile has no state besides its configuration, so all threads share it.
+ */
+class NativeScriptingEnvironment final : public ScriptingEnvironment
+{
+  public:
+    explicit NativeScriptingEnvironment(const std::string &file_name);
+
+    const ProfileProperties &GetProfileProperties() override;
+
+    std::vector<std::string> GetNameSuffixList() override;
+    std::vector<std::string> GetExceptions() override;
+    std::vector<std::string> GetClassNames() override;
+    void SetupSources() override;
+    int32_t GetTurnPenalty(double angle) override;
+    void ProcessSegments(const std::vector<ExtractionSegment> &segments) override;
+    void
+    ProcessElements(const std::vector<osmium::memory::Buffer::const_iterator> &osm_elements,
+                    const RestrictionParser &restriction_parser,
+                    tbb::concurrent_vector<std::pair<std::size_t, ExtractionNode>> &resulting_nodes,
+                    tbb::concurrent_vector<std::pair<std::size_t, ExtractionWay>> &resulting_ways,
+                    tbb::concurrent_vector<boost::optional<InputRestrictionContainer>>
+                        &resulting_restrictions) override;
+
+  private:
+    const CarProfile profile;
+};
+}
+}
+
+#endif /* SCRIPTING_ENVIRONMENT_NATIVE_HPP */
@@ -16,10 +16,18 @@
 #include <boost/assert.hpp>
 #include <cstdint>
 
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <climits>
 #include <memory>
-#include <stack>
+#include <numeric>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -27,32 +35,64 @@ namespace osrm
 namespace extractor
 {
 
+// Finds the strongly connected components of a graph that provides GetNumberOfNodes, BeginEdges,
+// EndEdges and GetTarget.
+//
+// Large graphs first peel the component of the node with the largest degree with a parallel
+// forward-backward search: the nodes the pivot reaches and that reach the pivot. On road networks
+// this is almost the whole graph, the iterative Tarjan that finds the remaining components only
+// visits the small pieces that are left. Graphs of at most SMALL_GRAPH_SIZE nodes, like the
+// matrices of /trip, keep the stacks of the search on the call stack.
 template <typename GraphT> class TarjanSCC
 {
+    // the node of a recursion and the edge it continues with, the edges of a node are taken from
+    // the last to the first
     struct TarjanStackFrame
     {
-        explicit TarjanStackFrame(NodeID v, NodeID parent) : v(v), parent(parent) {}
-        NodeID v;
-        NodeID parent;
+        NodeID node;
+        EdgeID edge;
     };
 
     struct TarjanNode
     {
-        TarjanNode() : index(SPECIAL_NODEID), low_link(SPECIAL_NODEID), on_stack(false) {}
+        TarjanNode() : index(SPECIAL_NODEID), low_link(SPECIAL_NODEID) {}
         unsigned index;
         unsigned low_link;
-        bool on_stack;
+    };
+
+    // bounded stack for the small graphs, they are never deeper than the graph has nodes
+    template <typename T, std::size_t capacity> class FixedStack
+    {
+      public:
+        bool empty() const { return size == 0; }
+        T &back() { return values[size - 1]; }
+        void pop_back() { --size; }
+        void push_back(const T &value)
+        {
+            BOOST_ASSERT(size < capacity);
+            values[size++] = value;
+        }
+
+      private:
+        std::array<T, capacity> values;
+        std::size_t size = 0;
     };
 
     std::vector<unsigned> components_index;
     std::vector<NodeID> component_size_vector;
     std::shared_ptr<const GraphT> m_graph;
     std::size_t size_one_counter;
+    std::size_t parallel_threshold;
 
   public:
-    TarjanSCC(std::shared_ptr<const GraphT> graph)
+    static constexpr std::size_t SMALL_GRAPH_SIZE = 64;
+    static constexpr std::size_t PARALLEL_THRESHOLD = 1u << 20;
+
+    // Graphs with at least parallel_threshold nodes peel their largest component in parallel
+    TarjanSCC(std::shared_ptr<const GraphT> graph,
+              const std::size_t parallel_threshold = PARALLEL_THRESHOLD)
         : components_index(graph->GetNumberOfNodes(), SPECIAL_NODEID), m_graph(graph),
-          size_one_counter(0)
+          size_one_counter(0), parallel_threshold(parallel_threshold)
     {
         BOOST_ASSERT(m_graph->GetNumberOfNodes() > 0);
     }
@@ -60,121 +100,363 @@ template <typename GraphT> class TarjanSCC
     void Run()
     {
         TIMER_START(SCC_RUN);
-        const NodeID max_node_id = m_graph->GetNumberOfNodes();
+        const std::size_t number_of_nodes = m_graph->GetNumberOfNodes();
+
+        unsigned component_index = 0;
+        if (number_of_nodes >= parallel_threshold)
+        {
+            component_index = PeelPivotComponent();
+        }
+
+        if (number_of_nodes <= SMALL_GRAPH_SIZE)
+        {
+            FixedStack<TarjanStackFrame, SMALL_GRAPH_SIZE> recursion_stack;
+            FixedStack<NodeID, SMALL_GRAPH_SIZE> tarjan_stack;
+            RunTarjan(recursion_stack, tarjan_stack, component_index);
+        }
+        else
+        {
+            std::vector<TarjanStackFrame> recursion_stack;
+            std::vector<NodeID> tarjan_stack;
+            RunTarjan(recursion_stack, tarjan_stack, component_index);
+        }
+
+        TIMER_STOP(SCC_RUN);
+        util::SimpleLogger().Write() << "SCC run took: " << TIMER_MSEC(SCC_RUN) / 1000. << "s";
+
+        size_one_counter = std::count_if(component_size_vector.begin(),
+                                         component_size_vector.end(),
+                                         [](unsigned value) { return 1 == value; });
+    }
+
+    std::size_t GetNumberOfComponents() const { return component_size_vector.size(); }
+
+    std::size_t GetSizeOneCount() const { return size_one_counter; }
+
+    unsigned GetComponentSize(const unsigned component_id) const
+    {
+        return component_size_vector[component_id];
+    }
 
-        // The following is a hack to distinguish between stuff that happens
-        // before the recursive call and stuff that happens after
-        std::stack<TarjanStackFrame> recursion_stack;
-        // true = stuff before, false = stuff after call
-        std::stack<NodeID> tarjan_stack;
+    unsigned GetComponentID(const NodeID node) const { return components_index[node]; }
+
+    // Renumbers the components after Run such that a component only reaches components with
+    // larger ids. A path from a node to a node of a smaller component id can't exist then.
+    void OrderComponentsTopologically()
+    {
+        const NodeID number_of_nodes = m_graph->GetNumberOfNodes();
+        const unsigned number_of_components = component_size_vector.size();
+
+        // the edges between the components, by their source component
+        std::vector<std::pair<unsigned, unsigned>> component_edges;
+        for (const auto node : util::irange(0u, number_of_nodes))
+        {
+            const auto component = components_index[node];
+            for (const auto edge : m_graph->GetAdjacentEdgeRange(node))
+            {
+                const auto target_component = components_index[m_graph->GetTarget(edge)];
+                if (target_component != component)
+                {
+                    component_edges.emplace_back(component, target_component);
+                }
+            }
+        }
+        std::sort(component_edges.begin(), component_edges.end());
+        component_edges.erase(std::unique(component_edges.begin(), component_edges.end()),
+                              component_edges.end());
+
+        std::vector<std::size_t> offsets(number_of_components + 1, 0);
+        std::vector<unsigned> in_degrees(number_of_components, 0);
+        for (const auto &component_edge : component_edges)
+        {
+            ++offsets[component_edge.first + 1];
+            ++in_degrees[component_edge.second];
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        // Kahn's algorithm, the components are numbered in the order they leave the queue
+        std::vector<unsigned> queue;
+        queue.reserve(number_of_components);
+        for (const auto component : util::irange(0u, number_of_components))
+        {
+            if (in_degrees[component] == 0)
+            {
+                queue.push_back(component);
+            }
+        }
+        std::vector<unsigned> new_ids(number_of_components);
+        for (std::size_t head = 0; head < queue.size(); ++head)
+        {
+            const auto component = queue[head];
+            new_ids[component] = head;
+            for (auto edge = offsets[component]; edge != offsets[component + 1]; ++edge)
+            {
+                if (--in_degrees[component_edges[edge].second] == 0)
+                {
+                    queue.push_back(component_edges[edge].second);
+                }
+            }
+        }
+        // the components of a graph have no cycles
+        BOOST_ASSERT(queue.size() == number_of_components);
+
+        for (auto &component : components_index)
+        {
+            component = new_ids[component];
+        }
+        std::vector<NodeID> sizes(number_of_components);
+        for (const auto component : util::irange(0u, number_of_components))
+        {
+            sizes[new_ids[component]] = component_size_vector[component];
+        }
+        component_size_vector.swap(sizes);
+    }
+
+  private:
+    // Labels the nodes that have no component yet. A node that was visited but has no component
+    // is on the Tarjan stack, so there is no extra flag for it.
+    template <typename FrameStack, typename NodeStack>
+    void RunTarjan(FrameStack &recursion_stack, NodeStack &tarjan_stack, unsigned component_index)
+    {
+        const NodeID max_node_id = m_graph->GetNumberOfNodes();
         std::vector<TarjanNode> tarjan_node_list(max_node_id);
-        unsigned component_index = 0, size_of_current_component = 0;
         unsigned index = 0;
-        std::vector<bool> processing_node_before_recursion(max_node_id, true);
+
+        const auto visit = [&](const NodeID node) {
+            tarjan_node_list[node].index = index;
+            tarjan_node_list[node].low_link = index;
+            ++index;
+            tarjan_stack.push_back(node);
+            recursion_stack.push_back(TarjanStackFrame{node, m_graph->EndEdges(node)});
+        };
+
         for (const NodeID node : util::irange(0u, max_node_id))
         {
-            if (SPECIAL_NODEID == components_index[node])
+            if (SPECIAL_NODEID != components_index[node])
             {
-                recursion_stack.emplace(TarjanStackFrame(node, node));
+                continue;
             }
 
+            visit(node);
             while (!recursion_stack.empty())
             {
-                TarjanStackFrame currentFrame = recursion_stack.top();
-                const NodeID u = currentFrame.parent;
-                const NodeID v = currentFrame.v;
-                recursion_stack.pop();
-
-                const bool before_recursion = processing_node_before_recursion[v];
+                auto &frame = recursion_stack.back();
+                const NodeID v = frame.node;
 
-                if (before_recursion && tarjan_node_list[v].index != UINT_MAX)
+                if (frame.edge != m_graph->BeginEdges(v))
                 {
-                    continue;
-                }
-
-                if (before_recursion)
-                {
-                    // Mark frame to handle tail of recursion
-                    recursion_stack.emplace(currentFrame);
-                    processing_node_before_recursion[v] = false;
-
-                    // Mark essential information for SCC
-                    tarjan_node_list[v].index = index;
-                    tarjan_node_list[v].low_link = index;
-                    tarjan_stack.push(v);
-                    tarjan_node_list[v].on_stack = true;
-                    ++index;
-
-                    for (const auto current_edge : m_graph->GetAdjacentEdgeRange(v))
+                    --frame.edge;
+                    const NodeID vprime = m_graph->GetTarget(frame.edge);
+                    if (SPECIAL_NODEID != components_index[vprime])
                     {
-                        const auto vprime = m_graph->GetTarget(current_edge);
-
-                        if (SPECIAL_NODEID == tarjan_node_list[vprime].index)
-                        {
-                            recursion_stack.emplace(TarjanStackFrame(vprime, v));
-                        }
-                        else
-                        {
-                            if (tarjan_node_list[vprime].on_stack &&
-                                tarjan_node_list[vprime].index < tarjan_node_list[v].low_link)
-                            {
-                                tarjan_node_list[v].low_link = tarjan_node_list[vprime].index;
-                            }
-                        }
+                        continue;
+                    }
+                    if (SPECIAL_NODEID == tarjan_node_list[vprime].index)
+                    {
+                        visit(vprime);
+                    }
+                    else
+                    {
+                        tarjan_node_list[v].low_link =
+                            std::min(tarjan_node_list[v].low_link, tarjan_node_list[vprime].index);
                     }
+                    continue;
                 }
-                else
+
+                // all edges are done, this is the bottom part of the recursion
+                recursion_stack.pop_back();
+                if (!recursion_stack.empty())
                 {
-                    processing_node_before_recursion[v] = true;
+                    const NodeID u = recursion_stack.back().node;
                     tarjan_node_list[u].low_link =
                         std::min(tarjan_node_list[u].low_link, tarjan_node_list[v].low_link);
-                    // after recursion, lets do cycle checking
-                    // Check if we found a cycle. This is the bottom part of the recursion
-                    if (tarjan_node_list[v].low_link == tarjan_node_list[v].index)
+                }
+
+                if (tarjan_node_list[v].low_link == tarjan_node_list[v].index)
+                {
+                    unsigned size_of_current_component = 0;
+                    NodeID vprime;
+                    do
                     {
-                        NodeID vprime;
-                        do
-                        {
-                            vprime = tarjan_stack.top();
-                            tarjan_stack.pop();
-                            tarjan_node_list[vprime].on_stack = false;
-                            components_index[vprime] = component_index;
-                            ++size_of_current_component;
-                        } while (v != vprime);
+                        vprime = tarjan_stack.back();
+                        tarjan_stack.pop_back();
+                        components_index[vprime] = component_index;
+                        ++size_of_current_component;
+                    } while (v != vprime);
 
-                        component_size_vector.emplace_back(size_of_current_component);
+                    AddComponent(component_index, size_of_current_component);
+                    ++component_index;
+                }
+            }
+        }
+    }
 
-                        if (size_of_current_component > 1000)
+    // Labels the component of the node with the largest product of in- and out-degree as the
+    // first component, returns the number of components found
+    unsigned PeelPivotComponent()
+    {
+        const NodeID number_of_nodes = m_graph->GetNumberOfNodes();
+        const constexpr std::size_t GrainSize = 4096;
+
+        // the reversed graph as an adjacency array
+        std::vector<EdgeID> reverse_offsets(number_of_nodes + 1, 0);
+        std::vector<NodeID> reverse_sources;
+        {
+            std::vector<std::atomic<EdgeID>> cursors(number_of_nodes);
+            tbb::parallel_for(tbb::blocked_range<NodeID>(0, number_of_nodes, GrainSize),
+                              [&](const tbb::blocked_range<NodeID> &range) {
+                                  for (auto node = range.begin(); node != range.end(); ++node)
+                                  {
+                                      for (const auto edge : m_graph->GetAdjacentEdgeRange(node))
+                                      {
+                                          cursors[m_graph->GetTarget(edge)].fetch_add(
+                                              1, std::memory_order_relaxed);
+                                      }
+                                  }
+                              });
+            for (const auto node : util::irange(0u, number_of_nodes))
+            {
+                reverse_offsets[node + 1] = reverse_offsets[node] + cursors[node].load();
+                cursors[node].store(reverse_offsets[node]);
+            }
+            reverse_sources.resize(reverse_offsets.back());
+            tbb::parallel_for(tbb::blocked_range<NodeID>(0, number_of_nodes, GrainSize),
+                              [&](const tbb::blocked_range<NodeID> &range) {
+                                  for (auto node = range.begin(); node != range.end(); ++node)
+                                  {
+                                      for (const auto edge : m_graph->GetAdjacentEdgeRange(node))
+                                      {
+                                          const auto position =
+                                              cursors[m_graph->GetTarget(edge)].fetch_add(
+                                                  1, std::memory_order_relaxed);
+                                          reverse_sources[position] = node;
+                                      }
+                                  }
+                              });
+        }
+
+        // the node most likely to be in the largest component, the smallest id on a tie
+        using Candidate = std::pair<std::uint64_t, NodeID>;
+        const auto pivot =
+            tbb::parallel_reduce(
+                tbb::blocked_range<NodeID>(0, number_of_nodes, GrainSize),
+                Candidate{0, 0},
+                [&](const tbb::blocked_range<NodeID> &range, Candidate best) {
+                    for (auto node = range.begin(); node != range.end(); ++node)
+                    {
+                        const std::uint64_t out_degree =
+                            m_graph->EndEdges(node) - m_graph->BeginEdges(node);
+                        const std::uint64_t in_degree =
+                            reverse_offsets[node + 1] - reverse_offsets[node];
+                        if (out_degree * in_degree > best.first)
                         {
-                            util::SimpleLogger().Write() << "large component [" << component_index
-                                                         << "]=" << size_of_current_component;
+                            best = Candidate{out_degree * in_degree, node};
                         }
-
-                        ++component_index;
-                        size_of_current_component = 0;
                     }
-                }
+                    return best;
+                },
+                [](const Candidate &lhs, const Candidate &rhs) {
+                    return lhs.first > rhs.first ||
+                                   (lhs.first == rhs.first && lhs.second < rhs.second)
+                               ? lhs
+                               : rhs;
+                })
+                .second;
+
+        const constexpr std::uint8_t FORWARD = 1;
+        const constexpr std::uint8_t BACKWARD = 2;
+        std::vector<std::atomic<std::uint8_t>> reached(number_of_nodes);
+
+        // The nodes that reach the pivot backwards are only searched among the nodes the pivot
+        // reaches forwards: every path from such a node to the pivot stays in them.
+        ParallelSearch(pivot, FORWARD, 0, reached, [this](const NodeID node, auto &&relax) {
+            for (const auto edge : m_graph->GetAdjacentEdgeRange(node))
+            {
+                relax(m_graph->GetTarget(edge));
             }
-        }
+        });
+        ParallelSearch(pivot, BACKWARD, FORWARD, reached, [&](const NodeID node, auto &&relax) {
+            for (auto edge = reverse_offsets[node]; edge != reverse_offsets[node + 1]; ++edge)
+            {
+                relax(reverse_sources[edge]);
+            }
+        });
 
-        TIMER_STOP(SCC_RUN);
-        util::SimpleLogger().Write() << "SCC run took: " << TIMER_MSEC(SCC_RUN) / 1000. << "s";
+        const unsigned size_of_pivot_component = tbb::parallel_reduce(
+            tbb::blocked_range<NodeID>(0, number_of_nodes, GrainSize),
+            0u,
+            [&](const tbb::blocked_range<NodeID> &range, unsigned size) {
+                for (auto node = range.begin(); node != range.end(); ++node)
+                {
+                    if (reached[node].load(std::memory_order_relaxed) == (FORWARD | BACKWARD))
+                    {
+                        components_index[node] = 0;
+                        ++size;
+                    }
+                }
+                return size;
+            },
+            [](const unsigned lhs, const unsigned rhs) { return lhs + rhs; });
 
-        size_one_counter = std::count_if(component_size_vector.begin(),
-                                         component_size_vector.end(),
-                                         [](unsigned value) { return 1 == value; });
+        AddComponent(0, size_of_pivot_component);
+        return 1;
     }
 
-    std::size_t GetNumberOfComponents() const { return component_size_vector.size(); }
+    // Breadth-first search level by level with the levels split over the threads. Marks the
+    // nodes it finds with the flag, nodes that don't carry the required flags aren't entered.
+    template <typename Neighbours>
+    void ParallelSearch(const NodeID start,
+                        const std::uint8_t flag,
+                        const std::uint8_t required,
+                        std::vector<std::atomic<std::uint8_t>> &reached,
+                        const Neighbours &neighbours) const
+    {
+        const constexpr std::size_t GrainSize = 256;
 
-    std::size_t GetSizeOneCount() const { return size_one_counter; }
+        std::vector<NodeID> frontier = {start};
+        reached[start].fetch_or(flag);
+        tbb::enumerable_thread_specific<std::vector<NodeID>> next_frontiers;
+        while (!frontier.empty())
+        {
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(0, frontier.size(), GrainSize),
+                              [&](const tbb::blocked_range<std::size_t> &range) {
+                                  auto &next_frontier = next_frontiers.local();
+                                  const auto relax = [&](const NodeID node) {
+                                      const auto state =
+                                          reached[node].load(std::memory_order_relaxed);
+                                      if ((state & required) != required || (state & flag) ||
+                                          (reached[node].fetch_or(flag) & flag))
+                                      {
+                                          return;
+                                      }
+                                      next_frontier.push_back(node);
+                                  };
+                                  for (auto index = range.begin(); index != range.end(); ++index)
+                                  {
+                                      neighbours(frontier[index], relax);
+                                  }
+                              });
 
-    unsigned GetComponentSize(const unsigned component_id) const
-    {
-        return component_size_vector[component_id];
+            frontier.clear();
+            for (auto &next_frontier : next_frontiers)
+            {
+                frontier.insert(frontier.end(), next_frontier.begin(), next_frontier.end());
+                next_frontier.clear();
+            }
+        }
     }
 
-    unsigned GetComponentID(const NodeID node) const { return components_index[node]; }
+    void AddComponent(const unsigned component_id, const unsigned size_of_component)
+    {
+        BOOST_ASSERT(component_size_vector.size() == component_id);
+        component_size_vector.emplace_back(size_of_component);
+
+        if (size_of_component > 1000)
+        {
+            util::SimpleLogger().Write() << "large component [" << component_id
+                                         << "]=" << size_of_component;
+        }
+    }
 };
 }
 }
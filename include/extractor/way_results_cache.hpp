@@ -0,0 +1,70 @@
+#ifndef OSRM_EXTRACTOR_WAY_RESULTS_CACHE_HPP
+#define OSRM_EXTRACTOR_WAY_RESULTS_CACHE_HPP
+
+#include "extractor/extraction_way.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace osmium
+{
+class Way;
+}
+
+namespace osrm
+{
+namespace extractor
+{
+
+// The results of the profile for the ways of the last extraction, by the id and version of the
+// ways. A way of the same version has the same tags and nodes, so an extraction of the input with
+// the changes since the last one only needs to run the profile for the changed ways.
+//
+// The results are stored in the order of the ways of the input and read along with the input, so
+// they are never all in memory. The input has to be ordered by id like planet dumps, ways that
+// come out of order only miss the results.
+class WayResultsCache
+{
+  public:
+    // Reads the results of path if it was written for the same profile, the results of this
+    // extraction are written next to it until Finish replaces it
+    WayResultsCache(boost::filesystem::path path, const std::uint64_t profile_hash);
+
+    WayResultsCache(const WayResultsCache &) = delete;
+    WayResultsCache &operator=(const WayResultsCache &) = delete;
+
+    // The result of the same version of the way, the ways have to be looked up in their order
+    bool Find(const osmium::Way &way, ExtractionWay &result);
+    // the results have to be added in the order of the ways as well
+    void Add(const osmium::Way &way, const ExtractionWay &result);
+    void Finish();
+
+    std::size_t GetNumberOfHits() const { return number_of_hits; }
+
+    // A hash of the profile and the lua libraries next to it in lib/, the results of other
+    // profiles are not used
+    static std::uint64_t HashProfile(const boost::filesystem::path &profile_path);
+
+  private:
+    void ReadEntry();
+
+    boost::filesystem::path path;
+    boost::filesystem::path temporary_path;
+    boost::filesystem::ifstream previous_results;
+    boost::filesystem::ofstream results;
+
+    // the next result of the previous extraction
+    bool has_entry;
+    std::int64_t entry_id;
+    std::uint32_t entry_version;
+    ExtractionWay entry_result;
+
+    std::size_t number_of_hits;
+};
+}
+}
+
+#endif // OSRM_EXTRACTOR_WAY_RESULTS_CACHE_HPP
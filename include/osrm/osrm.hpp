@@ -28,9 +28,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef OSRM_HPP
 #define OSRM_HPP
 
+#include "osrm/async.hpp"
 #include "osrm/osrm_fwd.hpp"
 #include "osrm/status.hpp"
 
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 
@@ -39,11 +43,22 @@ namespace osrm
 namespace json = util::json;
 using engine::EngineConfig;
 using engine::api::RouteParameters;
+using engine::api::RouteResult;
+using engine::api::RouteBatchParameters;
 using engine::api::TableParameters;
+using engine::api::TableResult;
+using engine::api::TableStream;
 using engine::api::NearestParameters;
+using engine::api::NearestResult;
 using engine::api::TripParameters;
 using engine::api::MatchParameters;
+using engine::api::MatchStreamParameters;
+using engine::api::MatchBatchParameters;
+using engine::api::MatchBatchResult;
 using engine::api::TileParameters;
+using engine::api::OneToAllParameters;
+using engine::api::OneToAllResult;
+using engine::api::IsochroneParameters;
 
 /**
  * Represents a Open Source Routing Machine with access to its services.
@@ -51,13 +66,24 @@ using engine::api::TileParameters;
  * This represents an Open Source Routing Machine (OSRM) instance, with the services:
  *
  *  - Route: shortest path queries for coordinates
+ *  - RouteBatch: independent shortest path queries for many coordinate pairs
  *  - Table: distance tables for coordinates
  *  - Nearest: nearest street segment for coordinate
  *  - Trip: shortest round trip between coordinates
  *  - Match: snaps noisy coordinate traces to the road network
+ *  - MatchStream: snaps the points of live traces to the road network as they come in
+ *  - MatchBatch: snaps many traces to the road network in parallel
  *  - Tile: vector tiles with internal graph representation
+ *  - OneToAll: durations from coordinates to every node of the road network
+ *  - Isochrone: areas reachable from a coordinate within durations
  *
  *  All services take service-specific parameters, fill a JSON object, and return a status code.
+ *  Tile fills a binary buffer, OneToAll and MatchBatch fill plain result structs instead,
+ *  Table can fill a protobuf message instead of the JSON object. Route, Table and Nearest can
+ *  fill plain result structs as well, which skips building the JSON tree.
+ *
+ *  Each of them can also run asynchronously on a thread pool of the instance with Async.
+ *  Queries that run longer than EngineConfig::max_query_time fail with the status Timeout.
  */
 class OSRM final
 {
@@ -85,6 +111,25 @@ class OSRM final
      */
     Status Route(const RouteParameters &parameters, json::Object &result) const;
 
+    /**
+     * Shortest path queries for coordinates, with only the durations and distances of the
+     * routes and their legs. The steps, the geometry and the annotations are not assembled.
+     *
+     * \param parameters route query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, RouteParameters and RouteResult
+     */
+    Status Route(const RouteParameters &parameters, RouteResult &result) const;
+
+    /**
+     * Independent shortest path queries for many origin/destination pairs in one call.
+     *
+     * \param parameters route batch query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, RouteBatchParameters and json::Object
+     */
+    Status RouteBatch(const RouteBatchParameters &parameters, json::Object &result) const;
+
     /**
      * Distance tables for coordinates.
      *
@@ -94,6 +139,37 @@ class OSRM final
      */
     Status Table(const TableParameters &parameters, json::Object &result) const;
 
+    /**
+     * Distance tables for coordinates rendered in the format of the parameters: JSON text, or a
+     * protobuf message as documented in docs/http.md. Errors come in the same format. Large
+     * tables are rendered a lot faster this way than through a json::Object.
+     *
+     * \param parameters table query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status and TableParameters
+     */
+    Status Table(const TableParameters &parameters, std::string &result) const;
+
+    /**
+     * Distance tables for coordinates as a single array of durations.
+     *
+     * \param parameters table query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, TableParameters and TableResult
+     */
+    Status Table(const TableParameters &parameters, TableResult &result) const;
+
+    /**
+     * Distance tables for coordinates as JSON that is handed to the stream in parts while the
+     * table is computed in blocks of rows, for tables too large to hold at once. An error before
+     * the first part is left in the stream, after it the JSON is incomplete.
+     *
+     * \param parameters table query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, TableParameters and TableStream
+     */
+    Status Table(const TableParameters &parameters, TableStream &result) const;
+
     /**
      * Nearest street segment for coordinate.
      *
@@ -103,6 +179,15 @@ class OSRM final
      */
     Status Nearest(const NearestParameters &parameters, json::Object &result) const;
 
+    /**
+     * Nearest street segments for coordinates as plain structs.
+     *
+     * \param parameters nearest query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, NearestParameters and NearestResult
+     */
+    Status Nearest(const NearestParameters &parameters, NearestResult &result) const;
+
     /**
      * Trip: shortest round trip between coordinates.
      *
@@ -121,6 +206,26 @@ class OSRM final
      */
     Status Match(const MatchParameters &parameters, json::Object &result) const;
 
+    /**
+     * MatchStream: appends points to a trace that is matched incrementally and returns the
+     * parts of its matching that are final. Requires EngineConfig::max_match_sessions.
+     *
+     * \param parameters match stream query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, MatchStreamParameters and json::Object
+     */
+    Status MatchStream(const MatchStreamParameters &parameters, json::Object &result) const;
+
+    /**
+     * MatchBatch: matches many traces in parallel into compact results, without the geometry
+     * and the steps of the matchings.
+     *
+     * \param parameters match batch query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, MatchBatchParameters and MatchBatchResult
+     */
+    Status MatchBatch(const MatchBatchParameters &parameters, MatchBatchResult &result) const;
+
     /**
      * Tile: vector tiles with internal graph representation
      *
@@ -130,6 +235,86 @@ class OSRM final
      */
     Status Tile(const TileParameters &parameters, std::string &result) const;
 
+    /**
+     * OneToAll: durations from coordinates to every node of the road network
+     *
+     * \param parameters one-to-all query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, OneToAllParameters and OneToAllResult
+     */
+    Status OneToAll(const OneToAllParameters &parameters, OneToAllResult &result) const;
+
+    /**
+     * Isochrone: areas reachable from a coordinate within durations
+     *
+     * \param parameters isochrone query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, IsochroneParameters and json::Object
+     */
+    Status Isochrone(const IsochroneParameters &parameters, json::Object &result) const;
+
+    /**
+     * Runs a query of one of the services above on the thread pool of the instance instead of
+     * the calling thread, see EngineConfig::async_threads. The service is the one that takes
+     * the parameters, and the result type picks its result like for the synchronous calls:
+     *
+     *   auto response = osrm.Async<json::Object>(route_parameters);
+     *   auto table = osrm.Async<TableResult>(table_parameters, options);
+     *
+     * A query that is cancelled fails with the code "Cancelled" in its result, a query that
+     * runs past its deadline with the status Timeout and the code "Timeout". Rendered results
+     * get a JSON error.
+     *
+     * \param parameters query specific parameters of the service
+     * \param options the deadline and the cancellation of the query
+     * \return a future of the status and the result, which rethrows what the query threw
+     * \see AsyncOptions and AsyncResponse
+     */
+    template <typename ResultT, typename ParameterT>
+    std::future<AsyncResponse<ResultT>> Async(ParameterT parameters,
+                                              AsyncOptions options = AsyncOptions()) const;
+
+    /**
+     * Like above, with a callback that gets the response on a thread of the pool instead of a
+     * future. The callback must not throw.
+     */
+    template <typename ResultT, typename ParameterT>
+    void Async(ParameterT parameters,
+               std::function<void(AsyncResponse<ResultT>)> callback,
+               AsyncOptions options = AsyncOptions()) const;
+
+    /**
+     * Identify the dataset queries are answered from, e.g. to cache responses. Data that
+     * osrm-datastore loads into shared memory gets a new data version even if the dataset
+     * itself and so its checksum are the same.
+     *
+     * 
+eturn checksum of the dataset or the version of the data
+     */
+    unsigned GetCheckSum() const;
+    unsigned GetDataVersion() const;
+
+    /**
+     * Version of the traffic overlay of osrm-traffic that route, table and trip queries use.
+     * Their responses change with it.
+     *
+     * \return the version of the overlay, 0 without one
+     */
+    std::uint64_t GetTrafficOverlayVersion() const;
+
+    /**
+     * Whether the data is warmed up, see EngineConfig::warmup_data. Always true without it.
+     * Queries are answered before, but may wait for their data to be read.
+     */
+    bool IsReady() const;
+
+    /**
+     * Loads the files of the dataset again in the background of the queries and swaps them in
+     * once they are loaded. Throws if they can't be loaded, the queries keep the current data
+     * then. Not available with shared memory, where osrm-datastore loads new data.
+     */
+    void Reload();
+
   private:
     std::unique_ptr<engine::Engine> engine_;
 };
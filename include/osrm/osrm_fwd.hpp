@@ -29,7 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define OSRM_FWD_HPP
 
 // OSRM API forward declarations for usage in interfaces. Exposes forward declarations for:
-// osrm::util::json::Object, osrm::engine::api::XParameters
+// osrm::util::json::Object, osrm::engine::api::XParameters, osrm::engine::api::XResult
 
 namespace osrm
 {
@@ -47,11 +47,22 @@ namespace engine
 namespace api
 {
 struct RouteParameters;
+struct RouteResult;
+struct RouteBatchParameters;
 struct TableParameters;
+struct TableResult;
+struct TableStream;
 struct NearestParameters;
+struct NearestResult;
 struct TripParameters;
 struct MatchParameters;
+struct MatchStreamParameters;
+struct MatchBatchParameters;
+struct MatchBatchResult;
 struct TileParameters;
+struct OneToAllParameters;
+struct OneToAllResult;
+struct IsochroneParameters;
 } // ns api
 
 class Engine;
@@ -0,0 +1,42 @@
+#ifndef OSRM_PARTITION_BISECTION_GRAPH_HPP
+#define OSRM_PARTITION_BISECTION_GRAPH_HPP
+
+#include "util/coordinate.hpp"
+#include "util/typedefs.hpp"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace partition
+{
+
+// An undirected graph with a position for every node. The neighbours of node v are at
+// first_edge[v] up to first_edge[v + 1] of the targets, sorted and without duplicates, so every
+// edge is there in both directions.
+struct BisectionGraph
+{
+    NodeID GetNumberOfNodes() const { return static_cast<NodeID>(coordinates.size()); }
+    std::size_t GetNumberOfEdges() const { return targets.size(); }
+
+    std::vector<std::size_t> first_edge;
+    std::vector<NodeID> targets;
+    std::vector<util::Coordinate> coordinates;
+};
+
+// The graph of the node pairs, in any direction and with any duplicates and loops
+BisectionGraph makeBisectionGraph(std::vector<std::pair<NodeID, NodeID>> edges,
+                                  std::vector<util::Coordinate> coordinates);
+
+// The subgraph of the nodes on the side with the edges between them. Returns the id in the graph
+// of every node of the subgraph.
+BisectionGraph makeSubgraph(const BisectionGraph &graph,
+                            const std::vector<bool> &sides,
+                            const bool side,
+                            std::vector<NodeID> &graph_ids);
+}
+}
+
+#endif // OSRM_PARTITION_BISECTION_GRAPH_HPP
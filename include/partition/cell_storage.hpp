@@ -0,0 +1,685 @@
+#ifndef OSRM_PARTITION_CELL_STORAGE_HPP
+#define OSRM_PARTITION_CELL_STORAGE_HPP
+
+#include "extractor/class_data.hpp"
+#include "partition/multi_level_partition.hpp"
+#include "util/integer_range.hpp"
+#include "util/io.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace partition
+{
+
+// Where the boundary nodes and the weights of a cell are in the arrays of a CellStorage
+struct CellData
+{
+    std::uint64_t weight_offset;
+    std::uint32_t source_offset;
+    std::uint32_t destination_offset;
+    std::uint32_t number_of_sources;
+    std::uint32_t number_of_destinations;
+};
+
+static_assert(sizeof(CellData) == 24, "CellData needs to be 24 bytes big");
+
+// The cells of a multi-level partition with their boundary nodes and the weights of the shortest
+// paths inside of them. A source of a cell is a node with an edge coming in from outside of the
+// cell, a destination is a node with an edge going out of it. For every source and destination
+// of a cell, the weight is that of the shortest path from the source to the destination that
+// doesn't leave the cell.
+//
+// There is a set of weights for every metric. Metric 0 has all nodes, the other metrics exclude
+// the nodes of some classes: the paths of their weights don't pass through these nodes. A metric
+// can also have edge weights of its own, like those of another set of speeds, which replace the
+// weights of the edges of the graph. All metrics share the graph and the cells, so another one
+// only costs its cell weights and its edge weights.
+//
+// A view only points to the arrays, which are owned by a CellStorage or a data facade. The node
+// ids are those of the graph the cells were customized on. A view has the weights of one metric.
+class CellStorageView
+{
+  public:
+    class Cell
+    {
+      public:
+        Cell(const CellData &data,
+             const NodeID *sources,
+             const NodeID *destinations,
+             const EdgeWeight *weights)
+            : data(data), sources(sources + data.source_offset),
+              destinations(destinations + data.destination_offset),
+              weights(weights + data.weight_offset)
+        {
+        }
+
+        std::uint32_t GetNumberOfSources() const { return data.number_of_sources; }
+        std::uint32_t GetNumberOfDestinations() const { return data.number_of_destinations; }
+
+        // the boundary nodes are in ascending order
+        NodeID GetSource(const std::uint32_t index) const
+        {
+            BOOST_ASSERT(index < data.number_of_sources);
+            return sources[index];
+        }
+
+        NodeID GetDestination(const std::uint32_t index) const
+        {
+            BOOST_ASSERT(index < data.number_of_destinations);
+            return destinations[index];
+        }
+
+        // The index of the node among the sources, GetNumberOfSources() if it is none of them
+        std::uint32_t FindSource(const NodeID node) const
+        {
+            return Find(sources, data.number_of_sources, node);
+        }
+
+        // The index of the node among the destinations, GetNumberOfDestinations() if it is none
+        std::uint32_t FindDestination(const NodeID node) const
+        {
+            return Find(destinations, data.number_of_destinations, node);
+        }
+
+        // INVALID_EDGE_WEIGHT if the destination can't be reached inside of the cell
+        EdgeWeight GetWeight(const std::uint32_t source_index,
+                             const std::uint32_t destination_index) const
+        {
+            BOOST_ASSERT(source_index < data.number_of_sources);
+            BOOST_ASSERT(destination_index < data.number_of_destinations);
+            return weights[std::size_t{source_index} * data.number_of_destinations +
+                           destination_index];
+        }
+
+      private:
+        static std::uint32_t
+        Find(const NodeID *nodes, const std::uint32_t number_of_nodes, const NodeID node)
+        {
+            const auto found = std::lower_bound(nodes, nodes + number_of_nodes, node);
+            if (found != nodes + number_of_nodes && *found == node)
+            {
+                return static_cast<std::uint32_t>(found - nodes);
+            }
+            return number_of_nodes;
+        }
+
+        CellData data;
+        const NodeID *sources;
+        const NodeID *destinations;
+        const EdgeWeight *weights;
+    };
+
+    CellStorageView()
+        : number_of_levels(0), number_of_nodes(0), node_cells(nullptr), level_offsets(nullptr),
+          cells(nullptr), sources(nullptr), destinations(nullptr), weights(nullptr),
+          number_of_weights(0), number_of_metrics(1), exclude_masks(nullptr),
+          node_classes(nullptr), class_names(nullptr), class_names_size(0), edge_weights(nullptr),
+          number_of_edges(0), metric_edge_weights(nullptr), edge_weight_names(nullptr),
+          edge_weight_names_size(0), metric(0), metric_weights(nullptr), exclude_mask(0),
+          metric_graph_weights(nullptr)
+    {
+    }
+
+    // node_cells holds the cells of all nodes level by level, level_offsets the index of the
+    // first cell of every level in cells and the number of cells at its end. The weights of the
+    // metrics follow each other with number_of_weights for every metric, exclude_masks has the
+    // classes every metric excludes. node_classes and class_names are null if there are no
+    // classes, the class names end with a '\0' each.
+    //
+    // edge_weights holds number_of_edges weights for every named set of edge weights, by the
+    // index of the edge in the graph. metric_edge_weights has the set every metric uses, 0 for
+    // the weights of the graph and i for the i-th named set. The names end with a '\0' each. All
+    // are null if there are no named edge weights.
+    CellStorageView(const LevelID number_of_levels,
+                    const NodeID number_of_nodes,
+                    const CellID *node_cells,
+                    const std::uint32_t *level_offsets,
+                    const CellData *cells,
+                    const NodeID *sources,
+                    const NodeID *destinations,
+                    const EdgeWeight *weights,
+                    const std::uint64_t number_of_weights,
+                    const std::uint32_t number_of_metrics,
+                    const extractor::ClassData *exclude_masks,
+                    const extractor::ClassData *node_classes,
+                    const char *class_names,
+                    const std::uint32_t class_names_size,
+                    const EdgeWeight *edge_weights = nullptr,
+                    const std::uint64_t number_of_edges = 0,
+                    const std::uint32_t *metric_edge_weights = nullptr,
+                    const char *edge_weight_names = nullptr,
+                    const std::uint32_t edge_weight_names_size = 0)
+        : number_of_levels(number_of_levels), number_of_nodes(number_of_nodes),
+          node_cells(node_cells), level_offsets(level_offsets), cells(cells), sources(sources),
+          destinations(destinations), weights(weights), number_of_weights(number_of_weights),
+          number_of_metrics(number_of_metrics), exclude_masks(exclude_masks),
+          node_classes(node_classes), class_names(class_names),
+          class_names_size(class_names_size), edge_weights(edge_weights),
+          number_of_edges(number_of_edges), metric_edge_weights(metric_edge_weights),
+          edge_weight_names(edge_weight_names), edge_weight_names_size(edge_weight_names_size),
+          metric(0), metric_weights(weights),
+          exclude_mask(exclude_masks == nullptr ? 0 : exclude_masks[0]),
+          metric_graph_weights(GetGraphWeights(0))
+    {
+    }
+
+    bool Empty() const { return number_of_levels == 0; }
+
+    LevelID GetNumberOfLevels() const { return number_of_levels; }
+    NodeID GetNumberOfNodes() const { return number_of_nodes; }
+
+    CellID GetNumberOfCells(const LevelID level) const
+    {
+        BOOST_ASSERT(level < number_of_levels);
+        return level_offsets[level + 1] - level_offsets[level];
+    }
+
+    CellID GetCellID(const LevelID level, const NodeID node) const
+    {
+        BOOST_ASSERT(level < number_of_levels && node < number_of_nodes);
+        return node_cells[std::size_t{level} * number_of_nodes + node];
+    }
+
+    // The lowest level with both nodes in the same cell, the number of levels if there is none
+    LevelID GetCommonLevel(const NodeID first, const NodeID second) const
+    {
+        LevelID level = 0;
+        while (level < number_of_levels && GetCellID(level, first) != GetCellID(level, second))
+        {
+            ++level;
+        }
+        return level;
+    }
+
+    Cell GetCell(const LevelID level, const CellID cell) const
+    {
+        BOOST_ASSERT(cell < GetNumberOfCells(level));
+        return Cell(cells[level_offsets[level] + cell], sources, destinations, metric_weights);
+    }
+
+    std::uint32_t GetNumberOfMetrics() const { return number_of_metrics; }
+
+    // The same cells with the weights of the metric
+    CellStorageView GetMetric(const std::uint32_t new_metric) const
+    {
+        BOOST_ASSERT(new_metric < number_of_metrics);
+        CellStorageView view = *this;
+        view.metric = new_metric;
+        view.metric_weights = weights + new_metric * number_of_weights;
+        view.exclude_mask = exclude_masks == nullptr ? 0 : exclude_masks[new_metric];
+        view.metric_graph_weights = GetGraphWeights(new_metric);
+        return view;
+    }
+
+    // The metric that excludes exactly the classes of the mask with the named edge weights,
+    // GetNumberOfMetrics() if there is none. Metric 0 excludes no classes and has the weights of
+    // the graph.
+    std::uint32_t FindMetric(const extractor::ClassData mask,
+                             const std::uint32_t named_weights = 0) const
+    {
+        for (const auto found : util::irange<std::uint32_t>(0, number_of_metrics))
+        {
+            if ((exclude_masks == nullptr ? 0 : exclude_masks[found]) == mask &&
+                (metric_edge_weights == nullptr ? 0 : metric_edge_weights[found]) ==
+                    named_weights)
+            {
+                return found;
+            }
+        }
+        return number_of_metrics;
+    }
+
+    // The weight of the edge of the graph in the metric of the view, graph_weight is its weight
+    // in the graph. INVALID_EDGE_WEIGHT if the metric closes the edge.
+    EdgeWeight GetEdgeWeight(const EdgeID edge, const EdgeWeight graph_weight) const
+    {
+        BOOST_ASSERT(metric_graph_weights == nullptr || edge < number_of_edges);
+        return metric_graph_weights == nullptr ? graph_weight : metric_graph_weights[edge];
+    }
+
+    // The index of the named edge weights for FindMetric, 0 are the weights of the graph and
+    // GetEdgeWeightNames().size() + 1 means there are none of that name
+    std::uint32_t FindEdgeWeights(const std::string &name) const
+    {
+        const auto names = GetEdgeWeightNames();
+        return static_cast<std::uint32_t>(std::find(names.begin(), names.end(), name) -
+                                          names.begin()) +
+               1;
+    }
+
+    std::vector<std::string> GetEdgeWeightNames() const
+    {
+        return SplitNames(edge_weight_names, edge_weight_names_size);
+    }
+
+    // the classes the metric of the view excludes
+    extractor::ClassData GetExcludeMask() const { return exclude_mask; }
+
+    bool IsExcluded(const NodeID node) const
+    {
+        BOOST_ASSERT(exclude_mask == 0 || node < number_of_nodes);
+        return exclude_mask != 0 && (node_classes[node] & exclude_mask) != 0;
+    }
+
+    // the names of the bits of the classes
+    std::vector<std::string> GetClassNames() const
+    {
+        return SplitNames(class_names, class_names_size);
+    }
+
+  private:
+    static std::vector<std::string> SplitNames(const char *names, const std::uint32_t size)
+    {
+        std::vector<std::string> split;
+        for (std::uint32_t offset = 0; offset < size;)
+        {
+            split.emplace_back(names + offset);
+            offset += split.back().size() + 1;
+        }
+        return split;
+    }
+
+    // null for the weights of the graph
+    const EdgeWeight *GetGraphWeights(const std::uint32_t of_metric) const
+    {
+        if (metric_edge_weights == nullptr || metric_edge_weights[of_metric] == 0)
+        {
+            return nullptr;
+        }
+        return edge_weights + (metric_edge_weights[of_metric] - 1) * number_of_edges;
+    }
+
+    LevelID number_of_levels;
+    NodeID number_of_nodes;
+    const CellID *node_cells;
+    const std::uint32_t *level_offsets;
+    const CellData *cells;
+    const NodeID *sources;
+    const NodeID *destinations;
+    const EdgeWeight *weights;
+    std::uint64_t number_of_weights;
+    std::uint32_t number_of_metrics;
+    const extractor::ClassData *exclude_masks;
+    const extractor::ClassData *node_classes;
+    const char *class_names;
+    std::uint32_t class_names_size;
+    const EdgeWeight *edge_weights;
+    std::uint64_t number_of_edges;
+    const std::uint32_t *metric_edge_weights;
+    const char *edge_weight_names;
+    std::uint32_t edge_weight_names_size;
+
+    std::uint32_t metric;
+    const EdgeWeight *metric_weights;
+    extractor::ClassData exclude_mask;
+    const EdgeWeight *metric_graph_weights;
+};
+
+// The sizes of the arrays of a .cells file. The arrays follow the header in the order cells,
+// level offsets, node cells, sources, destinations, the weights of all metrics, the named edge
+// weights, the edge weights of the metrics, the exclude masks of the metrics, the classes of the
+// nodes, the class names and the names of the edge weights, so the cells start at an offset
+// that is a multiple of eight and the arrays of four bytes follow each other.
+struct CellStorageHeader
+{
+    std::uint32_t number_of_levels = 0;
+    std::uint32_t number_of_nodes = 0;
+    std::uint32_t number_of_cells = 0;
+    std::uint32_t number_of_sources = 0;
+    std::uint32_t number_of_destinations = 0;
+    std::uint32_t number_of_metrics = 1;
+    // of every metric
+    std::uint64_t number_of_weights = 0;
+    // the number of nodes if there are classes, 0 otherwise
+    std::uint32_t number_of_node_classes = 0;
+    std::uint32_t class_names_size = 0;
+    // of every set of named edge weights, the number of edges of the graph if there are any
+    std::uint64_t number_of_edges = 0;
+    std::uint32_t number_of_named_weights = 0;
+    std::uint32_t edge_weight_names_size = 0;
+
+    std::uint64_t GetNumberOfLevelOffsets() const { return number_of_levels + 1; }
+    std::uint64_t GetNumberOfNodeCells() const
+    {
+        return std::uint64_t{number_of_levels} * number_of_nodes;
+    }
+    std::uint64_t GetNumberOfMetricWeights() const
+    {
+        return number_of_weights * number_of_metrics;
+    }
+    std::uint64_t GetNumberOfEdgeWeights() const
+    {
+        return number_of_edges * number_of_named_weights;
+    }
+    // the metrics only name their edge weights if there are named ones
+    std::uint32_t GetNumberOfMetricEdgeWeights() const
+    {
+        return number_of_named_weights > 0 ? number_of_metrics : 0;
+    }
+};
+
+static_assert(sizeof(CellStorageHeader) == 56, "CellStorageHeader needs to be 56 bytes big");
+
+// Reads the fingerprint and the header of a .cells file, the arrays follow
+inline bool readCellStorageHeader(std::istream &stream, CellStorageHeader &header)
+{
+    if (!util::readAndCheckFingerprint(stream))
+    {
+        return false;
+    }
+    stream.read(reinterpret_cast<char *>(&header), sizeof(CellStorageHeader));
+    return static_cast<bool>(stream);
+}
+
+// Owns the arrays of a CellStorageView. The boundary nodes of the cells come from the edges of
+// the graph, the weights are all INVALID_EDGE_WEIGHT until osrm-customize computes them.
+class CellStorage
+{
+  public:
+    CellStorage() = default;
+
+    // The graph stores every edge at both of its nodes, with the direction flags of a
+    // contractor::QueryGraphView. Its nodes are those of the partition.
+    template <typename GraphT>
+    CellStorage(const MultiLevelPartition &partition, const GraphT &graph)
+        : number_of_levels(partition.GetNumberOfLevels()),
+          number_of_nodes(partition.GetNumberOfNodes()), node_cells(partition.GetCells())
+    {
+        BOOST_ASSERT(graph.GetNumberOfNodes() == number_of_nodes);
+
+        level_offsets.push_back(0);
+        for (LevelID level = 0; level < number_of_levels; ++level)
+        {
+            level_offsets.push_back(level_offsets.back() + partition.GetNumberOfCells(level));
+        }
+        cells.resize(level_offsets.back(), CellData{0, 0, 0, 0, 0});
+
+        std::vector<std::vector<NodeID>> cell_sources;
+        std::vector<std::vector<NodeID>> cell_destinations;
+        for (LevelID level = 0; level < number_of_levels; ++level)
+        {
+            cell_sources.assign(partition.GetNumberOfCells(level), {});
+            cell_destinations.assign(partition.GetNumberOfCells(level), {});
+            // the nodes are visited in ascending order, so the boundaries stay sorted
+            for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+            {
+                const auto cell = partition.GetCell(level, node);
+                bool is_source = false;
+                bool is_destination = false;
+                for (const auto edge : graph.GetAdjacentEdgeRange(node))
+                {
+                    const auto &data = graph.GetSearchData(edge);
+                    if (partition.GetCell(level, data.target) != cell)
+                    {
+                        is_source = is_source || data.backward;
+                        is_destination = is_destination || data.forward;
+                    }
+                }
+                if (is_source)
+                {
+                    cell_sources[cell].push_back(node);
+                }
+                if (is_destination)
+                {
+                    cell_destinations[cell].push_back(node);
+                }
+            }
+
+            for (const auto cell : util::irange<CellID>(0, partition.GetNumberOfCells(level)))
+            {
+                auto &data = cells[level_offsets[level] + cell];
+                data.source_offset = static_cast<std::uint32_t>(sources.size());
+                data.destination_offset = static_cast<std::uint32_t>(destinations.size());
+                data.weight_offset = number_of_weights;
+                data.number_of_sources = static_cast<std::uint32_t>(cell_sources[cell].size());
+                data.number_of_destinations =
+                    static_cast<std::uint32_t>(cell_destinations[cell].size());
+                sources.insert(sources.end(), cell_sources[cell].begin(), cell_sources[cell].end());
+                destinations.insert(destinations.end(),
+                                    cell_destinations[cell].begin(),
+                                    cell_destinations[cell].end());
+                number_of_weights +=
+                    std::uint64_t{data.number_of_sources} * data.number_of_destinations;
+            }
+        }
+        weights.resize(number_of_weights, INVALID_EDGE_WEIGHT);
+    }
+
+    // The classes of the nodes by their id and the names of the class bits
+    void SetClasses(std::vector<extractor::ClassData> new_node_classes,
+                    const std::vector<std::string> &new_class_names)
+    {
+        BOOST_ASSERT(new_node_classes.empty() || new_node_classes.size() == number_of_nodes);
+        node_classes = std::move(new_node_classes);
+        class_names.clear();
+        for (const auto &name : new_class_names)
+        {
+            class_names.insert(class_names.end(), name.begin(), name.end());
+            class_names.push_back('\0');
+        }
+    }
+
+    // Adds weights of the edges of the graph under a name, by the index of the edge in the
+    // graph. INVALID_EDGE_WEIGHT closes an edge. Returns the index for AddMetric.
+    std::uint32_t AddEdgeWeights(const std::string &name,
+                                 const std::vector<EdgeWeight> &new_edge_weights)
+    {
+        BOOST_ASSERT(number_of_named_weights == 0 || new_edge_weights.size() == number_of_edges);
+        number_of_edges = new_edge_weights.size();
+        edge_weights.insert(edge_weights.end(), new_edge_weights.begin(), new_edge_weights.end());
+        edge_weight_names.insert(edge_weight_names.end(), name.begin(), name.end());
+        edge_weight_names.push_back('\0');
+        return ++number_of_named_weights;
+    }
+
+    // Adds a metric without the nodes of the classes of the mask and with the named edge
+    // weights, 0 for those of the graph. Returns its index. Its weights are all
+    // INVALID_EDGE_WEIGHT until osrm-customize computes them.
+    std::uint32_t AddMetric(const extractor::ClassData exclude_mask,
+                            const std::uint32_t named_weights = 0)
+    {
+        BOOST_ASSERT(exclude_mask != 0 || named_weights != 0);
+        BOOST_ASSERT(exclude_mask == 0 || !node_classes.empty());
+        BOOST_ASSERT(named_weights <= number_of_named_weights);
+        exclude_masks.push_back(exclude_mask);
+        metric_edge_weights.push_back(named_weights);
+        weights.resize(number_of_weights * exclude_masks.size(), INVALID_EDGE_WEIGHT);
+        return static_cast<std::uint32_t>(exclude_masks.size() - 1);
+    }
+
+    CellStorageView GetView() const
+    {
+        return CellStorageView(number_of_levels,
+                               number_of_nodes,
+                               node_cells.data(),
+                               level_offsets.data(),
+                               cells.data(),
+                               sources.data(),
+                               destinations.data(),
+                               weights.data(),
+                               number_of_weights,
+                               static_cast<std::uint32_t>(exclude_masks.size()),
+                               exclude_masks.data(),
+                               node_classes.empty() ? nullptr : node_classes.data(),
+                               class_names.empty() ? nullptr : class_names.data(),
+                               static_cast<std::uint32_t>(class_names.size()),
+                               edge_weights.empty() ? nullptr : edge_weights.data(),
+                               number_of_edges,
+                               number_of_named_weights > 0 ? metric_edge_weights.data() : nullptr,
+                               edge_weight_names.empty() ? nullptr : edge_weight_names.data(),
+                               static_cast<std::uint32_t>(edge_weight_names.size()));
+    }
+
+    // The weights of the cell in the metric row by row, one row of all destinations for every
+    // source
+    EdgeWeight *GetWeights(const LevelID level, const CellID cell, const std::uint32_t metric = 0)
+    {
+        BOOST_ASSERT(level < number_of_levels && metric < exclude_masks.size());
+        return weights.data() + metric * number_of_weights +
+               cells[level_offsets[level] + cell].weight_offset;
+    }
+
+    // The .cells file: the fingerprint, the header and the arrays in the order of the header
+    bool Write(const std::string &path) const
+    {
+        std::ofstream stream(path, std::ios::binary);
+        if (!util::writeFingerprint(stream))
+        {
+            return false;
+        }
+        CellStorageHeader header;
+        header.number_of_levels = number_of_levels;
+        header.number_of_nodes = number_of_nodes;
+        header.number_of_cells = cells.size();
+        header.number_of_sources = sources.size();
+        header.number_of_destinations = destinations.size();
+        header.number_of_metrics = exclude_masks.size();
+        header.number_of_weights = number_of_weights;
+        header.number_of_node_classes = node_classes.size();
+        header.class_names_size = class_names.size();
+        header.number_of_edges = number_of_edges;
+        header.number_of_named_weights = number_of_named_weights;
+        header.edge_weight_names_size = edge_weight_names.size();
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(CellStorageHeader));
+        stream.write(reinterpret_cast<const char *>(cells.data()),
+                     cells.size() * sizeof(CellData));
+        stream.write(reinterpret_cast<const char *>(level_offsets.data()),
+                     level_offsets.size() * sizeof(std::uint32_t));
+        stream.write(reinterpret_cast<const char *>(node_cells.data()),
+                     node_cells.size() * sizeof(CellID));
+        stream.write(reinterpret_cast<const char *>(sources.data()),
+                     sources.size() * sizeof(NodeID));
+        stream.write(reinterpret_cast<const char *>(destinations.data()),
+                     destinations.size() * sizeof(NodeID));
+        stream.write(reinterpret_cast<const char *>(weights.data()),
+                     weights.size() * sizeof(EdgeWeight));
+        stream.write(reinterpret_cast<const char *>(edge_weights.data()),
+                     edge_weights.size() * sizeof(EdgeWeight));
+        stream.write(reinterpret_cast<const char *>(metric_edge_weights.data()),
+                     header.GetNumberOfMetricEdgeWeights() * sizeof(std::uint32_t));
+        stream.write(reinterpret_cast<const char *>(exclude_masks.data()),
+                     exclude_masks.size() * sizeof(extractor::ClassData));
+        stream.write(reinterpret_cast<const char *>(node_classes.data()),
+                     node_classes.size() * sizeof(extractor::ClassData));
+        stream.write(class_names.data(), class_names.size());
+        stream.write(edge_weight_names.data(), edge_weight_names.size());
+        return static_cast<bool>(stream);
+    }
+
+  private:
+    LevelID number_of_levels = 0;
+    NodeID number_of_nodes = 0;
+    std::uint64_t number_of_weights = 0;
+    std::vector<CellID> node_cells;
+    std::vector<std::uint32_t> level_offsets;
+    std::vector<CellData> cells;
+    std::vector<NodeID> sources;
+    std::vector<NodeID> destinations;
+    std::vector<EdgeWeight> weights;
+    // metric 0 excludes nothing
+    std::vector<extractor::ClassData> exclude_masks{0};
+    std::vector<extractor::ClassData> node_classes;
+    std::vector<char> class_names;
+    std::uint64_t number_of_edges = 0;
+    std::uint32_t number_of_named_weights = 0;
+    std::vector<EdgeWeight> edge_weights;
+    // metric 0 has the weights of the graph
+    std::vector<std::uint32_t> metric_edge_weights{0};
+    std::vector<char> edge_weight_names;
+};
+
+// Settles the nodes of a Dijkstra search that stays inside a cell, starting from the nodes in
+// the heap. On level 0 it follows the edges of the graph. Above, it follows the weights of the
+// cells one level below from their sources to their destinations, and the edges between these
+// cells. The cells one level below need to be customized already.
+//
+// settle is called with every node and its weight when it is settled, the search stops when it
+// returns false. The data of the heap needs a parent. The nodes the metric of the cells excludes
+// are never settled, the edges have the weights of the metric.
+template <typename GraphT, typename HeapT, typename SettleT>
+void searchCell(const GraphT &graph,
+                const CellStorageView &cells,
+                const LevelID level,
+                const CellID cell,
+                HeapT &heap,
+                const SettleT &settle)
+{
+    const auto relax = [&](const NodeID from, const NodeID to, const EdgeWeight weight) {
+        if (cells.IsExcluded(to))
+        {
+            return;
+        }
+        if (!heap.WasInserted(to))
+        {
+            heap.Insert(to, weight, from);
+        }
+        else if (weight < heap.GetKey(to))
+        {
+            heap.GetData(to).parent = from;
+            heap.DecreaseKey(to, weight);
+        }
+    };
+
+    while (!heap.Empty())
+    {
+        const NodeID node = heap.DeleteMin();
+        const EdgeWeight weight = heap.GetKey(node);
+        if (!settle(node, weight))
+        {
+            return;
+        }
+
+        // the cell of the node one level below, the edges inside of it are covered by its weights
+        CellID sub_cell = INVALID_CELL_ID;
+        if (level > 0)
+        {
+            sub_cell = cells.GetCellID(level - 1, node);
+            const auto sub_cell_data = cells.GetCell(level - 1, sub_cell);
+            const auto source_index = sub_cell_data.FindSource(node);
+            if (source_index < sub_cell_data.GetNumberOfSources())
+            {
+                for (const auto destination_index :
+                     util::irange<std::uint32_t>(0, sub_cell_data.GetNumberOfDestinations()))
+                {
+                    const auto sub_weight =
+                        sub_cell_data.GetWeight(source_index, destination_index);
+                    if (sub_weight != INVALID_EDGE_WEIGHT)
+                    {
+                        relax(node,
+                              sub_cell_data.GetDestination(destination_index),
+                              weight + sub_weight);
+                    }
+                }
+            }
+        }
+
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            const auto &data = graph.GetSearchData(edge);
+            if (data.forward && cells.GetCellID(level, data.target) == cell &&
+                (level == 0 || cells.GetCellID(level - 1, data.target) != sub_cell))
+            {
+                const auto edge_weight = cells.GetEdgeWeight(edge, data.distance);
+                if (edge_weight != INVALID_EDGE_WEIGHT)
+                {
+                    relax(node, data.target, weight + edge_weight);
+                }
+            }
+        }
+    }
+}
+}
+}
+
+#endif // OSRM_PARTITION_CELL_STORAGE_HPP
@@ -0,0 +1,35 @@
+#ifndef OSRM_PARTITION_INERTIAL_FLOW_HPP
+#define OSRM_PARTITION_INERTIAL_FLOW_HPP
+
+#include "partition/bisection_graph.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace osrm
+{
+namespace partition
+{
+
+struct Bisection
+{
+    // true for the nodes of the second half
+    std::vector<bool> sides;
+    // the number of edges between the halves
+    std::size_t cut_size;
+};
+
+// Inertial flow: for every direction the nodes are ordered by their position along it, and the
+// smallest cut between the first and the last boundary_factor of them is a maximum flow with a
+// capacity of one per edge. The smallest cut of all directions wins, one with a larger side
+// above balance times half of the nodes only over cuts that are all as unbalanced.
+//
+// The directions are tried in parallel. Needs at least two nodes.
+Bisection inertialFlow(const BisectionGraph &graph,
+                       const unsigned number_of_directions,
+                       const double boundary_factor,
+                       const double balance);
+}
+}
+
+#endif // OSRM_PARTITION_INERTIAL_FLOW_HPP
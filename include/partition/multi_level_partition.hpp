@@ -0,0 +1,110 @@
+#ifndef OSRM_PARTITION_MULTI_LEVEL_PARTITION_HPP
+#define OSRM_PARTITION_MULTI_LEVEL_PARTITION_HPP
+
+#include "util/io.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace partition
+{
+
+using LevelID = std::uint8_t;
+using CellID = std::uint32_t;
+static const constexpr CellID INVALID_CELL_ID = std::numeric_limits<CellID>::max();
+
+// The cells of the nodes of a graph on every level of a nested partition. Level 0 has the
+// smallest cells and every cell of a level is within a single cell of the level above it, so two
+// nodes in the same cell of a level share the cells of all levels above as well.
+class MultiLevelPartition
+{
+  public:
+    MultiLevelPartition() : number_of_nodes(0) {}
+
+    // Takes the cells of all nodes of the first level, followed by the cells of the next levels
+    MultiLevelPartition(std::vector<std::uint32_t> max_cell_sizes_, std::vector<CellID> cells_)
+        : max_cell_sizes(std::move(max_cell_sizes_)), cells(std::move(cells_)),
+          number_of_nodes(max_cell_sizes.empty() ? 0 : cells.size() / max_cell_sizes.size())
+    {
+        BOOST_ASSERT(max_cell_sizes.size() <= std::numeric_limits<LevelID>::max());
+        BOOST_ASSERT(cells.size() == number_of_nodes * max_cell_sizes.size());
+        number_of_cells.reserve(max_cell_sizes.size());
+        for (LevelID level = 0; level < GetNumberOfLevels(); ++level)
+        {
+            const auto first = cells.begin() + level * number_of_nodes;
+            number_of_cells.push_back(
+                number_of_nodes == 0 ? 0 : *std::max_element(first, first + number_of_nodes) + 1);
+        }
+    }
+
+    LevelID GetNumberOfLevels() const { return static_cast<LevelID>(max_cell_sizes.size()); }
+    NodeID GetNumberOfNodes() const { return number_of_nodes; }
+    CellID GetNumberOfCells(const LevelID level) const { return number_of_cells[level]; }
+    std::uint32_t GetMaxCellSize(const LevelID level) const { return max_cell_sizes[level]; }
+
+    CellID GetCell(const LevelID level, const NodeID node) const
+    {
+        BOOST_ASSERT(level < GetNumberOfLevels() && node < number_of_nodes);
+        return cells[std::size_t{level} * number_of_nodes + node];
+    }
+
+    // The lowest level with both nodes in the same cell, the number of levels if there is none
+    LevelID GetCommonLevel(const NodeID first, const NodeID second) const
+    {
+        LevelID level = 0;
+        while (level < GetNumberOfLevels() && GetCell(level, first) != GetCell(level, second))
+        {
+            ++level;
+        }
+        return level;
+    }
+
+    const std::vector<std::uint32_t> &GetMaxCellSizes() const { return max_cell_sizes; }
+    const std::vector<CellID> &GetCells() const { return cells; }
+
+  private:
+    std::vector<std::uint32_t> max_cell_sizes;
+    std::vector<CellID> cells;
+    std::vector<CellID> number_of_cells;
+    NodeID number_of_nodes;
+};
+
+// The .partition file: the fingerprint, the largest cell size of every level and the cells of
+// all nodes level by level
+inline bool writeMultiLevelPartition(const std::string &path, const MultiLevelPartition &partition)
+{
+    std::ofstream stream(path, std::ios::binary);
+    return util::writeFingerprint(stream) &&
+           util::serializeVector(stream, partition.GetMaxCellSizes()) &&
+           util::serializeVector(stream, partition.GetCells());
+}
+
+inline bool readMultiLevelPartition(const std::string &path, MultiLevelPartition &partition)
+{
+    std::ifstream stream(path, std::ios::binary);
+    std::vector<std::uint32_t> max_cell_sizes;
+    std::vector<CellID> cells;
+    if (!util::readAndCheckFingerprint(stream) ||
+        !util::deserializeVector(stream, max_cell_sizes) ||
+        !util::deserializeVector(stream, cells) ||
+        (!max_cell_sizes.empty() && cells.size() % max_cell_sizes.size() != 0))
+    {
+        return false;
+    }
+    partition = MultiLevelPartition(std::move(max_cell_sizes), std::move(cells));
+    return true;
+}
+}
+}
+
+#endif // OSRM_PARTITION_MULTI_LEVEL_PARTITION_HPP
@@ -0,0 +1,32 @@
+#ifndef OSRM_PARTITION_PARTITIONER_HPP
+#define OSRM_PARTITION_PARTITIONER_HPP
+
+#include "partition/bisection_graph.hpp"
+#include "partition/partitioner_config.hpp"
+
+namespace osrm
+{
+namespace partition
+{
+
+/// Base class of osrm-partition
+class Partitioner
+{
+  public:
+    explicit Partitioner(const PartitionerConfig &config_) : config{config_} {}
+
+    Partitioner(const Partitioner &) = delete;
+    Partitioner &operator=(const Partitioner &) = delete;
+
+    int Run();
+
+  private:
+    BisectionGraph LoadEdgeBasedGraph() const;
+    std::vector<util::Coordinate> LoadNodeCoordinates(const NodeID number_of_nodes) const;
+
+    PartitionerConfig config;
+};
+}
+}
+
+#endif // OSRM_PARTITION_PARTITIONER_HPP
@@ -0,0 +1,59 @@
+#ifndef OSRM_PARTITION_PARTITIONER_CONFIG_HPP
+#define OSRM_PARTITION_PARTITIONER_CONFIG_HPP
+
+#include <boost/filesystem/path.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace partition
+{
+
+struct PartitionerConfig
+{
+    PartitionerConfig()
+        : requested_num_threads(0), balance(1.2), boundary_factor(0.25),
+          number_of_directions(10), max_cell_sizes{128, 4096, 65536, 2097152}
+    {
+    }
+
+    // Infer the input and output names from the path of the .osrm file
+    void UseDefaultOutputNames()
+    {
+        edge_based_graph_path = osrm_input_path.string() + ".ebg";
+        node_based_graph_path = osrm_input_path.string() + ".nodes";
+        rtree_leaf_path = osrm_input_path.string() + ".fileIndex";
+        node_renumbering_path = osrm_input_path.string() + ".node_renumbering";
+        partition_output_path = osrm_input_path.string() + ".partition";
+    }
+
+    boost::filesystem::path osrm_input_path;
+
+    std::string edge_based_graph_path;
+    // the coordinates of the edge-based nodes come from their segments in the r-tree leaves
+    std::string node_based_graph_path;
+    std::string rtree_leaf_path;
+    // the new ids of the r-tree leaves, if osrm-contract renumbered them
+    std::string node_renumbering_path;
+    std::string partition_output_path;
+
+    unsigned requested_num_threads;
+
+    // Largest side of a bisection relative to half of the nodes that is taken over a smaller
+    // cut of a less balanced one
+    double balance;
+    // Share of the nodes on either end of a direction that the flow of a cut starts and ends in
+    double boundary_factor;
+    // Directions through the graph that a bisection tries cuts along
+    unsigned number_of_directions;
+
+    // The largest number of nodes in a cell of every level, starting with the smallest cells
+    std::vector<std::uint32_t> max_cell_sizes;
+};
+}
+}
+
+#endif // OSRM_PARTITION_PARTITIONER_CONFIG_HPP
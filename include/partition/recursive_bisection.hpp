@@ -0,0 +1,21 @@
+#ifndef OSRM_PARTITION_RECURSIVE_BISECTION_HPP
+#define OSRM_PARTITION_RECURSIVE_BISECTION_HPP
+
+#include "partition/bisection_graph.hpp"
+#include "partition/multi_level_partition.hpp"
+#include "partition/partitioner_config.hpp"
+
+namespace osrm
+{
+namespace partition
+{
+
+// Bisects the graph with inertial flow, and both halves again, until no part is larger than the
+// cells of the first level. The cells of a level are the largest parts within its cell size, so
+// the levels nest. The halves are bisected in parallel.
+MultiLevelPartition computeMultiLevelPartition(BisectionGraph graph,
+                                               const PartitionerConfig &config);
+}
+}
+
+#endif // OSRM_PARTITION_RECURSIVE_BISECTION_HPP
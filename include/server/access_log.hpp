@@ -0,0 +1,120 @@
+#ifndef ACCESS_LOG_HPP
+#define ACCESS_LOG_HPP
+
+#include <boost/asio/ip/address.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+
+// Writes a line for every answered request, in the background so that the threads answering the
+// requests neither format the lines nor wait for each other.
+//
+// Every thread that adds records gets a ring buffer of its own, which only it writes to and only
+// the background thread reads from, so adding a record takes no lock. Records that don't fit
+// into a full buffer are dropped and counted. The background thread writes what was added every
+// few milliseconds, holding the lock of util::SimpleLogger once per batch so that the lines don't
+// interleave with other log lines, and drains all buffers before the log is destroyed.
+class AccessLog
+{
+  public:
+    enum class Format
+    {
+        // the line osrm-routed always wrote: time, client, referrer, agent, status and query
+        Text,
+        // one JSON object per line, with the time it took to answer the request
+        JSON
+    };
+
+    struct Record
+    {
+        std::time_t time;
+        boost::asio::ip::address endpoint;
+        std::string referrer;
+        std::string agent;
+        int status;
+        std::chrono::microseconds duration;
+        std::string request;
+    };
+
+    // Records a share of sample_rate of the successful requests, and all others. Every thread
+    // buffers up to buffer_size records.
+    AccessLog(const Format format,
+              const double sample_rate,
+              std::ostream &output,
+              const std::size_t buffer_size = 4096);
+    ~AccessLog();
+
+    AccessLog(const AccessLog &) = delete;
+    AccessLog &operator=(const AccessLog &) = delete;
+
+    // whether the record of a request with the status is sampled, call before building it
+    bool IsSampled(const int status) const;
+
+    void Add(Record record);
+
+    // records that were dropped since their buffer was full
+    std::uint64_t GetDropped() const { return dropped; }
+
+    static void Write(const Format format, const Record &record, std::ostream &output);
+
+  private:
+    // single producer, single consumer
+    class RingBuffer
+    {
+      public:
+        explicit RingBuffer(const std::size_t capacity);
+
+        // false if the buffer is full
+        bool Push(Record &record);
+        // moves the records that were pushed so far to the end of records
+        void PopAll(std::vector<Record> &records);
+
+      private:
+        std::vector<Record> slots;
+        const std::size_t mask;
+        std::atomic<std::size_t> head{0};
+        std::atomic<std::size_t> tail{0};
+    };
+
+    RingBuffer &GetThreadBuffer();
+    void Run();
+    // false once stopped
+    bool Wait();
+    void Drain(std::vector<Record> &records);
+
+    const Format format;
+    const double sample_rate;
+    std::ostream &output;
+    const std::size_t buffer_size;
+    // tells the buffers of the threads of different logs apart
+    const std::uint64_t id;
+    std::atomic<std::uint64_t> dropped{0};
+
+    // the buffers are only added while the log exists
+    std::mutex buffers_mutex;
+    std::vector<std::unique_ptr<RingBuffer>> buffers;
+
+    std::mutex mutex;
+    std::condition_variable stopped;
+    bool stop = false;
+    std::thread thread;
+};
+}
+}
+
+#endif // ACCESS_LOG_HPP
@@ -11,6 +11,8 @@
 #include <boost/spirit/include/phoenix.hpp>
 #include <boost/spirit/include/qi.hpp>
 
+#include <algorithm>
+#include <cstddef>
 #include <limits>
 #include <string>
 
@@ -27,22 +29,28 @@ namespace ph = boost::phoenix;
 namespace qi = boost::spirit::qi;
 }
 
-template <typename T, char... Fmt> struct no_trailing_dot_policy : qi::real_policies<T>
+// Leaves the dot of a format extension like .json or .pbf after the last coordinate alone
+template <typename T> struct no_trailing_dot_policy : qi::real_policies<T>
 {
     template <typename Iterator> static bool parse_dot(Iterator &first, Iterator const &last)
     {
         if (first == last || *first != '.')
             return false;
 
-        static const constexpr char fmt[sizeof...(Fmt)] = {Fmt...};
-
-        if (first + sizeof(fmt) < last && std::equal(fmt, fmt + sizeof(fmt), first + 1u))
+        if (isFollowedBy(first, last, "json") || isFollowedBy(first, last, "pbf"))
             return false;
 
         ++first;
         return true;
     }
 
+    template <typename Iterator, std::size_t N>
+    static bool isFollowedBy(const Iterator dot, const Iterator last, const char (&format)[N])
+    {
+        static_assert(N > 1, "format must not be empty");
+        return dot + (N - 1) < last && std::equal(format, format + (N - 1), dot + 1u);
+    }
+
     template <typename Iterator> static bool parse_exp(Iterator &, const Iterator &)
     {
         return false;
@@ -70,7 +78,7 @@ template <typename T, char... Fmt> struct no_trailing_dot_policy : qi::real_poli
 template <typename Iterator, typename Signature>
 struct BaseParametersGrammar : boost::spirit::qi::grammar<Iterator, Signature>
 {
-    using json_policy = no_trailing_dot_policy<double, 'j', 's', 'o', 'n'>;
+    using json_policy = no_trailing_dot_policy<double>;
 
     BaseParametersGrammar(qi::rule<Iterator, Signature> &root_rule)
         : BaseParametersGrammar::base_type(root_rule)
@@ -100,7 +108,7 @@ struct BaseParametersGrammar : boost::spirit::qi::grammar<Iterator, Signature>
             };
 
         polyline_chars = qi::char_("a-zA-Z0-9_.--[]{}@?|\\%~`^");
-        base64_char = qi::char_("a-zA-Z0-9--_=");
+        base64_char = qi::char_("a-zA-Z0-9_=-");
         unlimited_rule = qi::lit("unlimited")[qi::_val = std::numeric_limits<double>::infinity()];
 
         bearing_rule =
@@ -136,16 +144,33 @@ struct BaseParametersGrammar : boost::spirit::qi::grammar<Iterator, Signature>
                         (-(qi::double_ | unlimited_rule) %
                          ';')[ph::bind(&engine::api::BaseParameters::radiuses, qi::_r1) = qi::_1];
 
-        hints_rule = qi::lit("hints=") >
-                     (-qi::as_string[qi::repeat(engine::ENCODED_HINT_SIZE)[base64_char]])[ph::bind(
-                         add_hint, qi::_r1, qi::_1)] %
-                         ';';
+        // the full encoding is tried first since the compact one is a prefix of it, hold drops
+        // the characters it consumed if it doesn't match
+        hints_rule =
+            qi::lit("hints=") >
+            (-qi::as_string[qi::hold[qi::repeat(engine::ENCODED_HINT_SIZE)[base64_char]] |
+                            qi::repeat(engine::ENCODED_COMPACT_HINT_SIZE)[base64_char]])
+                    [ph::bind(add_hint, qi::_r1, qi::_1)] %
+                ';';
 
         bearings_rule =
             qi::lit("bearings=") >
             (-(qi::short_ > ',' > qi::short_))[ph::bind(add_bearing, qi::_r1, qi::_1)] % ';';
 
-        base_rule = radiuses_rule(qi::_r1) | hints_rule(qi::_r1) | bearings_rule(qi::_r1);
+        debug_rule = qi::lit("debug=") >
+                     qi::bool_[ph::bind(&engine::api::BaseParameters::debug, qi::_r1) = qi::_1];
+
+        exclude_rule = qi::lit("exclude=") >
+                       (qi::as_string[+qi::char_("a-zA-Z0-9_.~:-")] %
+                        ',')[ph::bind(&engine::api::BaseParameters::exclude, qi::_r1) = qi::_1];
+
+        metric_rule =
+            qi::lit("metric=") >
+            qi::as_string[+qi::char_("a-zA-Z0-9_.~:-")]
+                         [ph::bind(&engine::api::BaseParameters::metric, qi::_r1) = qi::_1];
+
+        base_rule = radiuses_rule(qi::_r1) | hints_rule(qi::_r1) | bearings_rule(qi::_r1) |
+                    debug_rule(qi::_r1) | exclude_rule(qi::_r1) | metric_rule(qi::_r1);
     }
 
   protected:
@@ -156,6 +181,9 @@ struct BaseParametersGrammar : boost::spirit::qi::grammar<Iterator, Signature>
     qi::rule<Iterator, Signature> bearings_rule;
     qi::rule<Iterator, Signature> radiuses_rule;
     qi::rule<Iterator, Signature> hints_rule;
+    qi::rule<Iterator, Signature> debug_rule;
+    qi::rule<Iterator, Signature> exclude_rule;
+    qi::rule<Iterator, Signature> metric_rule;
 
     qi::rule<Iterator, osrm::engine::Bearing()> bearing_rule;
     qi::rule<Iterator, osrm::util::Coordinate()> location_rule;
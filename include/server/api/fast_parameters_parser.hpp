@@ -0,0 +1,50 @@
+#ifndef SERVER_API_FAST_PARAMETERS_PARSER_HPP
+#define SERVER_API_FAST_PARAMETERS_PARSER_HPP
+
+#include "engine/hint.hpp"
+#include "util/coordinate.hpp"
+
+#include <boost/optional.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+namespace api
+{
+
+// Hand-written parsers for the parts of a query that grow with its coordinates: the coordinates
+// themselves and the lists of options with an element per coordinate. The grammars spend most of
+// the time of large queries on them, the fast path of parseParameters runs these instead.
+//
+// They only accept the plain forms clients send, like decimal numbers without exponents, and
+// return false for everything else without reporting where, parseParameters parses the query
+// with the grammar then. What they accept is parsed to the same values as by the grammars.
+namespace fast
+{
+
+// Parses "{lon},{lat};{lon},{lat}..." from position up to the format or the options of the
+// query, and leaves position there
+bool parseCoordinates(const char *&position,
+                      const char *end,
+                      std::vector<util::Coordinate> &coordinates);
+
+// Parse the value of an option, the part between "=" and "&" or the end, and leave the values
+// unchanged if they return false
+bool parseHints(const char *begin,
+                const char *end,
+                std::vector<boost::optional<engine::Hint>> &hints);
+bool parseRadiuses(const char *begin,
+                   const char *end,
+                   std::vector<boost::optional<double>> &radiuses);
+// "all" leaves the indices as they are
+bool parseIndices(const char *begin, const char *end, std::vector<std::size_t> &indices);
+}
+}
+}
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef ISOCHRONE_PARAMETERS_GRAMMAR_HPP
+#define ISOCHRONE_PARAMETERS_GRAMMAR_HPP
+
+#include "server/api/base_parameters_grammar.hpp"
+#include "engine/api/isochrone_parameters.hpp"
+
+#include <boost/spirit/include/phoenix.hpp>
+#include <boost/spirit/include/qi.hpp>
+
+namespace osrm
+{
+namespace server
+{
+namespace api
+{
+
+namespace
+{
+namespace ph = boost::phoenix;
+namespace qi = boost::spirit::qi;
+}
+
+template <typename Iterator = std::string::iterator,
+          typename Signature = void(engine::api::IsochroneParameters &)>
+struct IsochroneParametersGrammar final : public BaseParametersGrammar<Iterator, Signature>
+{
+    using BaseGrammar = BaseParametersGrammar<Iterator, Signature>;
+
+    IsochroneParametersGrammar() : BaseGrammar(root_rule)
+    {
+        contours_rule =
+            qi::lit("contours=") >
+            (qi::uint_ % ';')[ph::bind(&engine::api::IsochroneParameters::contours, qi::_r1) =
+                                  qi::_1];
+
+        cell_size_rule =
+            qi::lit("cell_size=") >
+            qi::double_[ph::bind(&engine::api::IsochroneParameters::cell_size, qi::_r1) = qi::_1];
+
+        isochrone_rule = contours_rule(qi::_r1) | cell_size_rule(qi::_r1);
+
+        root_rule = BaseGrammar::query_rule(qi::_r1) > -qi::lit(".json") >
+                    -('?' > (isochrone_rule(qi::_r1) | BaseGrammar::base_rule(qi::_r1)) % '&');
+    }
+
+  private:
+    qi::rule<Iterator, Signature> root_rule;
+    qi::rule<Iterator, Signature> isochrone_rule;
+    qi::rule<Iterator, Signature> contours_rule;
+    qi::rule<Iterator, Signature> cell_size_rule;
+};
+}
+}
+}
+
+#endif
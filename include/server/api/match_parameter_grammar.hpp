@@ -33,13 +33,32 @@ struct MatchParametersGrammar final : public RouteParametersGrammar<Iterator, Si
             (qi::uint_ %
              ';')[ph::bind(&engine::api::MatchParameters::timestamps, qi::_r1) = qi::_1];
 
-        root_rule = BaseGrammar::query_rule(qi::_r1) > -qi::lit(".json") >
-                    -('?' > (timestamps_rule(qi::_r1) | BaseGrammar::base_rule(qi::_r1)) % '&');
+        max_candidates_rule =
+            qi::lit("max_candidates=") >
+            qi::uint_[ph::bind(&engine::api::MatchParameters::max_candidates, qi::_r1) = qi::_1];
+
+        heading_tolerance_rule =
+            qi::lit("heading_tolerance=") >
+            qi::uint_[ph::bind(&engine::api::MatchParameters::heading_tolerance, qi::_r1) =
+                          qi::_1];
+
+        tidy_rule = qi::lit("tidy=") >
+                    qi::bool_[ph::bind(&engine::api::MatchParameters::tidy, qi::_r1) = qi::_1];
+
+        root_rule =
+            BaseGrammar::query_rule(qi::_r1) > -qi::lit(".json") >
+            -('?' > (timestamps_rule(qi::_r1) | max_candidates_rule(qi::_r1) |
+                     heading_tolerance_rule(qi::_r1) | tidy_rule(qi::_r1) |
+                     BaseGrammar::base_rule(qi::_r1)) %
+                        '&');
     }
 
   private:
     qi::rule<Iterator, Signature> root_rule;
     qi::rule<Iterator, Signature> timestamps_rule;
+    qi::rule<Iterator, Signature> max_candidates_rule;
+    qi::rule<Iterator, Signature> heading_tolerance_rule;
+    qi::rule<Iterator, Signature> tidy_rule;
 };
 }
 }
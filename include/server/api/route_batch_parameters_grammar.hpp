@@ -0,0 +1,47 @@
+#ifndef ROUTE_BATCH_PARAMETERS_GRAMMAR_HPP
+#define ROUTE_BATCH_PARAMETERS_GRAMMAR_HPP
+
+#include "server/api/route_parameters_grammar.hpp"
+#include "engine/api/route_batch_parameters.hpp"
+
+#include <boost/spirit/include/phoenix.hpp>
+#include <boost/spirit/include/qi.hpp>
+
+namespace osrm
+{
+namespace server
+{
+namespace api
+{
+
+namespace
+{
+namespace ph = boost::phoenix;
+namespace qi = boost::spirit::qi;
+}
+
+template <typename Iterator = std::string::iterator,
+          typename Signature = void(engine::api::RouteBatchParameters &)>
+struct RouteBatchParametersGrammar final : public RouteParametersGrammar<Iterator, Signature>
+{
+    using BaseGrammar = RouteParametersGrammar<Iterator, Signature>;
+
+    RouteBatchParametersGrammar() : BaseGrammar(root_rule)
+    {
+        summary_rule =
+            qi::lit("summary=") >
+            qi::bool_[ph::bind(&engine::api::RouteBatchParameters::summary, qi::_r1) = qi::_1];
+
+        root_rule = BaseGrammar::query_rule(qi::_r1) > -qi::lit(".json") >
+                    -('?' > (summary_rule(qi::_r1) | BaseGrammar::base_rule(qi::_r1)) % '&');
+    }
+
+  private:
+    qi::rule<Iterator, Signature> root_rule;
+    qi::rule<Iterator, Signature> summary_rule;
+};
+}
+}
+}
+
+#endif
@@ -30,7 +30,11 @@ struct RouteParametersGrammar : public BaseParametersGrammar<Iterator, Signature
     {
         route_rule =
             (qi::lit("alternatives=") >
-             qi::bool_[ph::bind(&engine::api::RouteParameters::alternatives, qi::_r1) = qi::_1]) |
+             (qi::bool_[ph::bind(&engine::api::RouteParameters::alternatives, qi::_r1) = qi::_1] |
+              qi::uint_[ph::bind(&engine::api::RouteParameters::alternatives, qi::_r1) =
+                            qi::_1 > 0u,
+                        ph::bind(&engine::api::RouteParameters::number_of_alternatives,
+                                 qi::_r1) = qi::_1])) |
             (qi::lit("continue_straight=") >
              (qi::lit("default") |
               qi::bool_[ph::bind(&engine::api::RouteParameters::continue_straight, qi::_r1) =
@@ -43,7 +47,8 @@ struct RouteParametersGrammar : public BaseParametersGrammar<Iterator, Signature
     RouteParametersGrammar(qi::rule<Iterator, Signature> &root_rule_) : BaseGrammar(root_rule_)
     {
         geometries_type.add("geojson", engine::api::RouteParameters::GeometriesType::GeoJSON)(
-            "polyline", engine::api::RouteParameters::GeometriesType::Polyline);
+            "polyline", engine::api::RouteParameters::GeometriesType::Polyline)(
+            "polyline6", engine::api::RouteParameters::GeometriesType::Polyline6);
 
         overview_type.add("simplified", engine::api::RouteParameters::OverviewType::Simplified)(
             "full", engine::api::RouteParameters::OverviewType::Full)(
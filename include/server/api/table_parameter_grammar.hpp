@@ -48,17 +48,35 @@ struct TableParametersGrammar final : public BaseParametersGrammar<Iterator, Sig
             (qi::lit("all") |
              (size_t_ % ';')[ph::bind(&engine::api::TableParameters::sources, qi::_r1) = qi::_1]);
 
-        table_rule = destinations_rule(qi::_r1) | sources_rule(qi::_r1);
+        max_duration_rule =
+            qi::lit("max_duration=") >
+            qi::double_[ph::bind(&engine::api::TableParameters::max_duration, qi::_r1) = qi::_1];
 
-        root_rule = BaseGrammar::query_rule(qi::_r1) > -qi::lit(".json") >
+        session_rule = qi::lit("session=") >
+                       qi::as_string[+qi::char_("a-zA-Z0-9_.~-")]
+                                    [ph::bind(&engine::api::TableParameters::session, qi::_r1) =
+                                         qi::_1];
+
+        table_rule = destinations_rule(qi::_r1) | sources_rule(qi::_r1) |
+                     max_duration_rule(qi::_r1) | session_rule(qi::_r1);
+
+        format_rule =
+            qi::lit(".json") |
+            qi::lit(".pbf")[ph::bind(&engine::api::TableParameters::format, qi::_r1) =
+                                engine::api::TableParameters::OutputFormatType::PBF];
+
+        root_rule = BaseGrammar::query_rule(qi::_r1) > -format_rule(qi::_r1) >
                     -('?' > (table_rule(qi::_r1) | BaseGrammar::base_rule(qi::_r1)) % '&');
     }
 
   private:
     qi::rule<Iterator, Signature> root_rule;
     qi::rule<Iterator, Signature> table_rule;
+    qi::rule<Iterator, Signature> format_rule;
     qi::rule<Iterator, Signature> sources_rule;
     qi::rule<Iterator, Signature> destinations_rule;
+    qi::rule<Iterator, Signature> max_duration_rule;
+    qi::rule<Iterator, Signature> session_rule;
     qi::rule<Iterator, std::size_t()> size_t_;
 };
 }
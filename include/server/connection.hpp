@@ -4,6 +4,7 @@
 #include "server/http/compression_type.hpp"
 #include "server/http/reply.hpp"
 #include "server/http/request.hpp"
+#include "server/reply_stream.hpp"
 #include "server/request_parser.hpp"
 
 #include <boost/array.hpp>
@@ -11,7 +12,9 @@
 #include <boost/config.hpp>
 #include <boost/version.hpp>
 
+#include <array>
 #include <memory>
+#include <string>
 #include <vector>
 
 // workaround for incomplete std::shared_ptr compatibility in old boost versions
@@ -32,39 +35,83 @@ namespace server
 {
 
 class RequestHandler;
+class QueryPool;
 
 /// Represents a single connection from a client.
-class Connection : public std::enable_shared_from_this<Connection>
+class Connection : public std::enable_shared_from_this<Connection>, public ReplyStream
 {
   public:
-    explicit Connection(boost::asio::io_service &io_service, RequestHandler &handler);
+    // Queries run on the query pool if there is one, otherwise on the thread of the io_service
+    explicit Connection(boost::asio::io_service &io_service,
+                        RequestHandler &handler,
+                        QueryPool *query_pool = nullptr);
     Connection(const Connection &) = delete;
     Connection &operator=(const Connection &) = delete;
 
-    boost::asio::ip::tcp::socket &socket();
+    // accepts the connections of TCP and of Unix domain sockets
+    boost::asio::generic::stream_protocol::socket &socket();
 
     /// Start the first asynchronous operation for the connection.
     void start();
 
+    // Writes the chunk right away from the thread of the query, nothing else uses the socket
+    // until the query posts its reply back. Compressed like the other replies.
+    bool Write(http::reply &reply, const char *data, const std::size_t size) override;
+
   private:
+    /// Reads the next chunk of requests, closes the connection when it is idle for too long.
+    void read();
+
     void handle_read(const boost::system::error_code &e, std::size_t bytes_transferred);
 
+    /// Parses the input and answers the request once it is complete.
+    void process(char *begin, char *end);
+
+    /// Runs the query and prepares the reply
+    void handle_request(const http::compression_type compression_type);
+
+    void write_reply();
+    // sends a part of a streamed reply, the last one closes the compressed stream
+    bool write_chunk(http::reply &reply,
+                     const char *data,
+                     const std::size_t size,
+                     const bool is_last);
+    // sends the last chunk of a streamed reply, which tells the client the reply is complete
+    bool finish_stream();
+
     /// Handle completion of a write operation.
     void handle_write(const boost::system::error_code &e);
 
-    std::vector<char> compress_buffers(const std::vector<char> &uncompressed_data,
-                                       const http::compression_type compression_type);
+    void handle_timeout(const boost::system::error_code &e);
+
+    void handle_continue(const boost::system::error_code &e);
+
+    // compresses with a zlib stream of the calling thread that is reused for every reply
+    void compress_buffers(const std::vector<char> &uncompressed_data,
+                          const http::compression_type compression_type,
+                          std::vector<char> &compressed_data);
 
     boost::asio::io_service::strand strand;
-    boost::asio::ip::tcp::socket TCP_socket;
+    boost::asio::generic::stream_protocol::socket stream_socket;
+    boost::asio::deadline_timer timer;
     RequestHandler &request_handler;
+    QueryPool *query_pool;
     RequestParser request_parser;
     boost::array<char, 8192> incoming_data_buffer;
     http::request current_request;
     http::reply current_reply;
     std::vector<char> compressed_output;
     // Header compression_header;
-    std::vector<boost::asio::const_buffer> output_buffer;
+    std::array<boost::asio::const_buffer, 2> output_buffer;
+    // of the reply that is streamed, see Write
+    http::compression_type stream_compression;
+    bool stream_failed;
+    std::string chunk_header;
+    // input after the current request, i.e. pipelined requests
+    char *pending_begin;
+    char *pending_end;
+    bool keep_alive;
+    unsigned processed_requests;
 };
 }
 }
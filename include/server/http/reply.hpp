@@ -5,6 +5,8 @@
 
 #include <boost/asio.hpp>
 
+#include <array>
+#include <string>
 #include <vector>
 
 namespace osrm
@@ -21,22 +23,50 @@ class reply
     {
         ok = 200,
         bad_request = 400,
-        internal_server_error = 500
+        too_many_requests = 429,
+        internal_server_error = 500,
+        service_unavailable = 503
     } status;
 
+    // The headers most replies share, they are formatted once
+    enum class static_headers
+    {
+        none,
+        // CORS and the type of the JSON replies of the services
+        json,
+        // CORS and the type of tiles
+        protobuf,
+        // CORS and the type of the stock replies
+        html
+    };
+
+    static_headers common_headers;
+    // the headers that differ between replies, written after the common ones
     std::vector<header> headers;
-    std::vector<boost::asio::const_buffer> to_buffers();
-    std::vector<boost::asio::const_buffer> headers_to_buffers();
     std::vector<char> content;
+    // the content is compressed with gzip already, like a stored tile
+    bool is_gzipped;
+    // the Content-Encoding of the body that is sent, nullptr if it isn't compressed
+    const char *content_encoding;
+    // the body was sent in chunks while it was computed instead of with the reply, see
+    // ReplyStream, the headers say so instead of giving its length
+    bool is_streamed;
+    bool keep_alive;
+
+    // The status line and the headers with the Content-Length of the body, and the body. The
+    // buffers point into the reply and the body, and are sent with a single gathering write.
+    std::array<boost::asio::const_buffer, 2> to_buffers();
+    std::array<boost::asio::const_buffer, 2> to_buffers(const std::vector<char> &body);
     static reply stock_reply(const status_type status);
-    void set_size(const std::size_t size);
-    void set_uncompressed_size();
+    void set_keep_alive(const bool keep_alive);
 
     reply();
 
   private:
     std::string status_to_string(reply::status_type status);
-    boost::asio::const_buffer status_to_buffer(reply::status_type status);
+
+    // reused by every call of to_buffers
+    std::string header_block;
 };
 }
 }
@@ -15,9 +15,15 @@ namespace http
 struct request
 {
     std::string uri;
+    // the rest of the URI for POST requests, e.g. coordinates that don't fit into a URL
+    std::string body;
     std::string referrer;
     std::string agent;
     boost::asio::ip::address endpoint;
+    // whether the client wants to send more requests over the connection
+    bool keep_alive = false;
+    // whether the client takes a body in chunks, which HTTP/1.1 clients do
+    bool chunked_encoding = false;
 };
 }
 }
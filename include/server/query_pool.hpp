@@ -0,0 +1,63 @@
+#ifndef QUERY_POOL_HPP
+#define QUERY_POOL_HPP
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+
+// Runs queries on threads of their own, so a long query doesn't block the thread that handles
+// the I/O of many connections.
+//
+// Queries are either cheap (nearest, route) or heavy (all other services). Cheap queries are
+// always taken first, and heavy ones never occupy more than three quarters of the threads, so
+// small queries don't wait behind long trips or tables. Each class has a bounded queue, Submit
+// rejects queries that don't fit and the connection answers them with 429 Too Many Requests.
+class QueryPool
+{
+  public:
+    enum class Priority
+    {
+        cheap = 0,
+        heavy = 1
+    };
+
+    QueryPool(const unsigned number_of_threads, const std::size_t max_queued_queries);
+    // Drops the queries still in the queues and waits for the running ones
+    ~QueryPool();
+
+    QueryPool(const QueryPool &) = delete;
+    QueryPool &operator=(const QueryPool &) = delete;
+
+    // returns false if the queue of the priority is full
+    bool Submit(const Priority priority, std::function<void()> query);
+
+    // the priority of a request by the service in its URI, e.g. /route/v1/...
+    static Priority GetPriority(const std::string &uri);
+
+  private:
+    void Work();
+
+    std::mutex mutex;
+    std::condition_variable has_work;
+    std::array<std::deque<std::function<void()>>, 2> queues;
+    const std::size_t max_queued_queries;
+    const unsigned max_running_heavy_queries;
+    unsigned running_heavy_queries;
+    bool stopping;
+    std::vector<std::thread> threads;
+};
+}
+}
+
+#endif // QUERY_POOL_HPP
@@ -0,0 +1,31 @@
+#ifndef REPLY_STREAM_HPP
+#define REPLY_STREAM_HPP
+
+#include <cstddef>
+
+namespace osrm
+{
+namespace server
+{
+namespace http
+{
+class reply;
+}
+
+// Sends the body of a reply in chunks while it is still computed, with chunked transfer encoding,
+// for replies too large to hold at once like the JSON of large tables. The connection of a client
+// that understands chunks hands it to RequestHandler::HandleRequest.
+class ReplyStream
+{
+  public:
+    virtual ~ReplyStream() = default;
+
+    // Sends the part as the next chunk, the status line and the headers of the reply go out with
+    // the first one and mark it as streamed. False if the connection failed, the reply is cut
+    // off then.
+    virtual bool Write(http::reply &reply, const char *data, const std::size_t size) = 0;
+};
+}
+}
+
+#endif // REPLY_STREAM_HPP
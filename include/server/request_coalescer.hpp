@@ -0,0 +1,101 @@
+#ifndef REQUEST_COALESCER_HPP
+#define REQUEST_COALESCER_HPP
+
+#include "server/http/reply.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace osrm
+{
+namespace server
+{
+
+// Lets identical queries that arrive at the same time share a single computation, for crowds
+// of clients that send the same query within milliseconds, like a fleet that asks for the table
+// of its depot every full minute. Where the response cache answers queries that were computed
+// before, this answers the ones that are computed right now.
+//
+// The first request of a key computes the reply and hands it to the requests that joined in the
+// meantime, which wait for it instead of running the query. The key has to contain everything
+// the reply depends on, like the normalized query and the checksum and version of the data.
+class RequestCoalescer
+{
+    struct Flight
+    {
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool is_finished = false;
+        // nullptr if the computation failed
+        std::shared_ptr<const http::reply> reply;
+    };
+
+  public:
+    struct Statistics
+    {
+        // requests that computed their reply
+        std::uint64_t computed;
+        // requests that got the reply of another one
+        std::uint64_t coalesced;
+    };
+
+    // A request that either computes the reply of its key or waits for the one computing it
+    class Ticket
+    {
+      public:
+        Ticket() = default;
+        Ticket(Ticket &&other) noexcept;
+        Ticket &operator=(Ticket &&other) noexcept;
+        // a computation that didn't finish fails, the waiting requests compute their replies
+        ~Ticket();
+
+        Ticket(const Ticket &) = delete;
+        Ticket &operator=(const Ticket &) = delete;
+
+        // whether this request computes the reply, only then Finish is called
+        bool IsComputing() const { return coalescer && is_computing; }
+
+        // Waits for the reply and copies it, false if its computation failed
+        bool Wait(http::reply &reply);
+
+        // hands the reply to the requests that wait for it
+        void Finish(const http::reply &reply);
+
+      private:
+        friend class RequestCoalescer;
+        Ticket(RequestCoalescer &coalescer,
+               std::string key,
+               std::shared_ptr<Flight> flight,
+               const bool is_computing);
+
+        void Complete(std::shared_ptr<const http::reply> reply);
+
+        RequestCoalescer *coalescer = nullptr;
+        std::string key;
+        std::shared_ptr<Flight> flight;
+        bool is_computing = false;
+    };
+
+    RequestCoalescer() = default;
+    RequestCoalescer(const RequestCoalescer &) = delete;
+    RequestCoalescer &operator=(const RequestCoalescer &) = delete;
+
+    // The first request of a key computes, the ones that join before it finishes wait
+    Ticket Join(const std::string &key);
+
+    Statistics GetStatistics() const;
+
+  private:
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<Flight>> flights;
+    std::uint64_t computed = 0;
+    std::uint64_t coalesced = 0;
+};
+}
+}
+
+#endif // REQUEST_COALESCER_HPP
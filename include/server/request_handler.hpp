@@ -1,8 +1,17 @@
 #ifndef REQUEST_HANDLER_HPP
 #define REQUEST_HANDLER_HPP
 
+#include "server/access_log.hpp"
+#include "server/reply_stream.hpp"
+#include "server/request_coalescer.hpp"
+#include "server/response_cache.hpp"
 #include "server/service_handler.hpp"
+#include "server/tile_store.hpp"
 
+#include "util/coordinate.hpp"
+
+#include <map>
+#include <memory>
 #include <string>
 
 namespace osrm
@@ -24,12 +33,62 @@ class RequestHandler
     RequestHandler(const RequestHandler &) = delete;
     RequestHandler &operator=(const RequestHandler &) = delete;
 
-    void RegisterServiceHandler(std::unique_ptr<ServiceHandler> service_handler);
+    // Registers the dataset of a profile. A single dataset answers the queries of every profile,
+    // with several the profile of the URL selects the dataset.
+    void RegisterServiceHandler(std::unique_ptr<ServiceHandlerInterface> service_handler,
+                                const std::string &profile = "");
+
+    // answers repeated route and table queries from the cache, they are all computed otherwise
+    void RegisterResponseCache(std::unique_ptr<ResponseCache> response_cache,
+                               const std::string &profile = "");
+
+    // answers tile queries with the stored tiles, and stores the tiles it renders
+    void RegisterTileStore(std::unique_ptr<TileStore> tile_store, const std::string &profile = "");
+
+    // Renders and stores the tiles from zoom 12 to max_zoom that cover the bounding box for
+    // every dataset with a registered tile store. Returns the number of tiles that were rendered.
+    std::size_t PrerenderTiles(const util::Coordinate south_west,
+                               const util::Coordinate north_east,
+                               const unsigned max_zoom);
+
+    // writes the access log of all datasets, there is none unless one is registered
+    void RegisterAccessLog(std::unique_ptr<AccessLog> access_log);
 
-    void HandleRequest(const http::request &current_request, http::reply &current_reply);
+    // lets identical queries of all datasets that arrive at the same time share their reply
+    void RegisterRequestCoalescer(std::unique_ptr<RequestCoalescer> request_coalescer);
+
+    // JSON tables of at least min_entries entries are sent in chunks while they are computed to
+    // the clients whose connection hands over a reply stream, 0 never streams them
+    void SetStreamedTableEntries(const std::size_t min_entries);
+
+    // With a stream the reply may be sent in chunks already, it is marked as streamed then and
+    // its content is empty
+    void HandleRequest(const http::request &current_request,
+                       http::reply &current_reply,
+                       ReplyStream *stream = nullptr);
 
   private:
-    std::unique_ptr<ServiceHandler> service_handler;
+    // The caches belong to a dataset, since they drop their entries when they see another one
+    struct Dataset
+    {
+        std::unique_ptr<ServiceHandlerInterface> service_handler;
+        std::unique_ptr<ResponseCache> response_cache;
+        std::unique_ptr<TileStore> tile_store;
+    };
+
+    // the dataset that answers the queries of the profile, nullptr if there is none
+    Dataset *FindDataset(const std::string &profile);
+
+    std::size_t PrerenderTiles(ServiceHandlerInterface &service_handler,
+                               TileStore &tile_store,
+                               const util::Coordinate south_west,
+                               const util::Coordinate north_east,
+                               const unsigned max_zoom);
+
+    std::map<std::string, Dataset> datasets;
+    std::unique_ptr<AccessLog> access_log;
+    std::unique_ptr<RequestCoalescer> request_coalescer;
+    std::size_t streamed_table_entries = 0;
 };
 }
 }
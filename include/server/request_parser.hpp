@@ -4,6 +4,8 @@
 #include "server/http/compression_type.hpp"
 #include "server/http/header.hpp"
 
+#include <cstddef>
+#include <string>
 #include <tuple>
 
 namespace osrm
@@ -28,9 +30,20 @@ class RequestParser
         indeterminate
     };
 
-    std::tuple<RequestStatus, http::compression_type>
+    // Consumes input up to the end of a request and returns the position after it. Any input
+    // left over belongs to the next request on the connection, which needs a new parser.
+    //
+    // A request with a Content-Length header is valid once its body has been read as well.
+    std::tuple<RequestStatus, http::compression_type, char *>
     parse(http::request &current_request, char *begin, char *end);
 
+    // True once the headers asked for "Expect: 100-continue" before sending the body, which the
+    // connection answers with an interim 100 Continue reply. Only returns true once.
+    bool ContinueExpected();
+
+    // larger bodies make the request invalid
+    static constexpr std::size_t MAX_BODY_SIZE = 32 * 1024 * 1024;
+
   private:
     RequestStatus consume(http::request &current_request, const char input);
 
@@ -64,11 +77,20 @@ class RequestParser
         space_before_header_value,
         header_value,
         expecting_newline_2,
-        expecting_newline_3
+        expecting_newline_3,
+        body
     } state;
 
     http::header current_header;
     http::compression_type selected_compression;
+    unsigned http_version_major;
+    unsigned http_version_minor;
+    // value of the Connection header
+    std::string connection;
+    // body bytes that are still to be read
+    std::size_t remaining_body_size;
+    bool expects_continue;
+    bool continue_expected;
 };
 }
 }
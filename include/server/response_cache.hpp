@@ -0,0 +1,103 @@
+#ifndef RESPONSE_CACHE_HPP
+#define RESPONSE_CACHE_HPP
+
+#include "server/http/reply.hpp"
+#include "util/sharded_lru_cache.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+
+namespace osrm
+{
+namespace server
+{
+
+// Bounded LRU cache of the replies to route and table queries, for clients that send the same
+// query again and again, like retries of mobile apps or the tables of a depot every few minutes.
+//
+// Replies are cached under their normalized query, see MakeKey, and belong to the dataset they
+// were computed on: the cache drops all of them when it sees another checksum or data version,
+// so a reply never outlives an update by osrm-datastore, or another version of the traffic
+// overlay that routes and tables are computed with. Replies older than the time to live count as
+// missing. The capacity limits the total size of the cached keys and reply contents.
+class ResponseCache
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Statistics
+    {
+        std::size_t number_of_replies;
+        std::size_t size;
+        std::size_t capacity;
+        std::chrono::seconds time_to_live;
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t evictions;
+    };
+
+    ResponseCache(const std::size_t capacity, const std::chrono::seconds time_to_live);
+
+    ResponseCache(const ResponseCache &) = delete;
+    ResponseCache &operator=(const ResponseCache &) = delete;
+
+    // whether replies of the service are cached at all
+    static bool IsCacheable(const std::string &service);
+
+    // The decoded request URI with its options sorted by name, so the same query with the
+    // options in a different order is found as well. Repeated options keep their order, since
+    // the last one wins.
+    static std::string MakeKey(const std::string &request);
+
+    // Copies the cached reply into reply, returns false if there is none
+    bool Get(const unsigned checksum,
+             const unsigned data_version,
+             const std::uint64_t traffic_overlay_version,
+             const std::string &key,
+             http::reply &reply,
+             const Clock::time_point now = Clock::now());
+
+    void Add(const unsigned checksum,
+             const unsigned data_version,
+             const std::uint64_t traffic_overlay_version,
+             const std::string &key,
+             const http::reply &reply,
+             const Clock::time_point now = Clock::now());
+
+    Statistics GetStatistics() const;
+
+  private:
+    struct Entry
+    {
+        http::reply reply;
+        Clock::time_point added;
+    };
+
+    struct EntrySize
+    {
+        std::size_t operator()(const std::string &key,
+                               const std::shared_ptr<const Entry> &entry) const
+        {
+            return key.size() + entry->reply.content.size();
+        }
+    };
+
+    using Version = std::tuple<unsigned, unsigned, std::uint64_t>;
+    using Cache = util::ShardedLRUCache<std::string,
+                                        std::shared_ptr<const Entry>,
+                                        std::hash<std::string>,
+                                        Version,
+                                        EntrySize>;
+
+    const std::chrono::seconds time_to_live;
+    // a single shard, so the capacity is exact
+    Cache cache;
+};
+}
+}
+
+#endif // RESPONSE_CACHE_HPP
@@ -2,10 +2,15 @@
 #define SERVER_HPP
 
 #include "server/connection.hpp"
+#include "server/query_pool.hpp"
 #include "server/request_handler.hpp"
+#include "server/response_cache.hpp"
 #include "server/service_handler.hpp"
 
+#include "util/exception.hpp"
 #include "util/integer_range.hpp"
+#include "util/make_unique.hpp"
+#include "util/numa.hpp"
 #include "util/simple_logger.hpp"
 
 #include <boost/asio.hpp>
@@ -16,6 +21,7 @@
 #ifndef _WIN32
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unistd.h>
 #endif
 
 #include <functional>
@@ -33,49 +39,152 @@ class Server
 {
   public:
     // Note: returns a shared instead of a unique ptr as it is captured in a lambda somewhere else
-    static std::shared_ptr<Server>
-    CreateServer(std::string &ip_address, int ip_port, unsigned requested_num_threads)
+    static std::shared_ptr<Server> CreateServer(std::string &ip_address,
+                                                int ip_port,
+                                                unsigned requested_num_threads,
+                                                bool bind_to_numa_nodes = false,
+                                                bool io_service_per_thread = false,
+                                                unsigned compute_threads = 0,
+                                                std::size_t max_queued_queries = 0,
+                                                const std::string &unix_socket_path = "")
     {
         util::SimpleLogger().Write() << "http 1.1 compression handled by zlib version "
                                      << zlibVersion();
         const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
         const unsigned real_num_threads = std::min(hardware_threads, requested_num_threads);
-        return std::make_shared<Server>(ip_address, ip_port, real_num_threads);
+        return std::make_shared<Server>(ip_address,
+                                        ip_port,
+                                        real_num_threads,
+                                        bind_to_numa_nodes,
+                                        io_service_per_thread,
+                                        compute_threads,
+                                        max_queued_queries,
+                                        unix_socket_path);
     }
 
-    explicit Server(const std::string &address, const int port, const unsigned thread_pool_size)
-        : thread_pool_size(thread_pool_size), acceptor(io_service),
-          new_connection(std::make_shared<Connection>(io_service, request_handler))
+    // With an io_service per thread every thread accepts and handles its own connections on an
+    // acceptor of its own, and the kernel spreads the connections over the acceptors with
+    // SO_REUSEPORT. Otherwise all threads share a single io_service and acceptor.
+    //
+    // With compute threads the queries run on a QueryPool of that many threads and the threads
+    // of the io_services only read requests and write replies. A query that finds the queue of
+    // its service class holding max_queued_queries is answered with 429 Too Many Requests.
+    // Without compute threads queries run on the thread that read the request.
+    //
+    // With a unix_socket_path the server also accepts connections on a Unix domain socket at
+    // that path, which skips the TCP stack for clients on the same host. Its connections are
+    // handled like the ones of TCP, by the first io_service. A file left at the path by an
+    // earlier run is replaced, the permissions of the socket file control who may connect.
+    explicit Server(const std::string &address,
+                    const int port,
+                    const unsigned thread_pool_size,
+                    const bool bind_to_numa_nodes = false,
+                    const bool io_service_per_thread = false,
+                    const unsigned compute_threads = 0,
+                    const std::size_t max_queued_queries = 0,
+                    const std::string &unix_socket_path = "")
+        : thread_pool_size(thread_pool_size), bind_to_numa_nodes(bind_to_numa_nodes)
     {
+        if (compute_threads > 0)
+        {
+            const std::size_t queue_size =
+                max_queued_queries > 0 ? max_queued_queries : 64 * compute_threads;
+            query_pool = util::make_unique<QueryPool>(compute_threads, queue_size);
+            util::SimpleLogger().Write() << "running queries on " << compute_threads
+                                         << " compute threads";
+        }
+
         const auto port_string = std::to_string(port);
 
-        boost::asio::ip::tcp::resolver resolver(io_service);
+        boost::asio::io_service resolver_service;
+        boost::asio::ip::tcp::resolver resolver(resolver_service);
         boost::asio::ip::tcp::resolver::query query(address, port_string);
         boost::asio::ip::tcp::endpoint endpoint = *resolver.resolve(query);
 
-        acceptor.open(endpoint.protocol());
+        unsigned number_of_workers = 1;
+        if (io_service_per_thread)
+        {
+#ifdef SO_REUSEPORT
+            number_of_workers = thread_pool_size;
+#else
+            util::SimpleLogger().Write(logWARNING)
+                << "SO_REUSEPORT is not supported, all threads share one io_service";
+#endif
+        }
+
+        for (unsigned i = 0; i < number_of_workers; ++i)
+        {
+            workers.push_back(util::make_unique<Worker>(request_handler, query_pool.get()));
+            auto &acceptor = workers.back()->acceptor;
+            acceptor.open(endpoint.protocol());
 #ifdef SO_REUSEPORT
-        const int option = 1;
-        setsockopt(acceptor.native_handle(), SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option));
+            const int option = 1;
+            setsockopt(
+                acceptor.native_handle(), SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option));
 #endif
-        acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
-        acceptor.bind(endpoint);
-        acceptor.listen();
+            acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+            acceptor.bind(endpoint);
+            acceptor.listen();
+            AsyncAccept(*workers.back());
+        }
+
+        util::SimpleLogger().Write() << "Listening on: "
+                                     << workers.front()->acceptor.local_endpoint();
+        if (workers.size() > 1)
+        {
+            util::SimpleLogger().Write() << "with an io_service per thread";
+        }
 
-        util::SimpleLogger().Write() << "Listening on: " << acceptor.local_endpoint();
+        if (!unix_socket_path.empty())
+        {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+            auto &worker = *workers.front();
+            ::unlink(unix_socket_path.c_str());
+            local_acceptor = util::make_unique<boost::asio::local::stream_protocol::acceptor>(
+                worker.io_service,
+                boost::asio::local::stream_protocol::endpoint(unix_socket_path));
+            local_socket_path = unix_socket_path;
+            new_local_connection =
+                std::make_shared<Connection>(worker.io_service, request_handler, query_pool.get());
+            AsyncAcceptLocal();
+            util::SimpleLogger().Write() << "Listening on: " << unix_socket_path;
+#else
+            throw util::exception("Unix domain sockets are not supported on this platform");
+#endif
+        }
+    }
 
-        acceptor.async_accept(
-            new_connection->socket(),
-            boost::bind(&Server::HandleAccept, this, boost::asio::placeholders::error));
+    ~Server()
+    {
+        if (!local_socket_path.empty())
+        {
+            ::unlink(local_socket_path.c_str());
+        }
     }
 
     void Run()
     {
+        const auto numa_nodes = util::getNUMANodes();
+        if (bind_to_numa_nodes)
+        {
+            util::SimpleLogger().Write() << "binding threads to " << numa_nodes.size()
+                                         << " NUMA nodes";
+        }
+
         std::vector<std::shared_ptr<std::thread>> threads;
         for (unsigned i = 0; i < thread_pool_size; ++i)
         {
-            std::shared_ptr<std::thread> thread = std::make_shared<std::thread>(
-                boost::bind(&boost::asio::io_service::run, &io_service));
+            // the threads take turns on the nodes, the engine picks the data of a thread's node
+            auto thread = std::make_shared<std::thread>([this, i, &numa_nodes] {
+                const auto node_index = i % numa_nodes.size();
+                if (bind_to_numa_nodes &&
+                    !util::bindThreadToNUMANode(node_index, numa_nodes[node_index]))
+                {
+                    util::SimpleLogger().Write(logWARNING) << "could not bind thread " << i
+                                                           << " to NUMA node " << node_index;
+                }
+                workers[i % workers.size()]->io_service.run();
+            });
             threads.push_back(thread);
         }
         for (auto thread : threads)
@@ -84,31 +193,120 @@ class Server
         }
     }
 
-    void Stop() { io_service.stop(); }
+    void Stop()
+    {
+        for (auto &worker : workers)
+        {
+            worker->io_service.stop();
+        }
+    }
+
+    // see RequestHandler for the datasets of several profiles
+    void RegisterServiceHandler(std::unique_ptr<ServiceHandlerInterface> service_handler_,
+                                const std::string &profile = "")
+    {
+        request_handler.RegisterServiceHandler(std::move(service_handler_), profile);
+    }
+
+    void RegisterResponseCache(std::unique_ptr<ResponseCache> response_cache,
+                               const std::string &profile = "")
+    {
+        request_handler.RegisterResponseCache(std::move(response_cache), profile);
+    }
+
+    void RegisterTileStore(std::unique_ptr<TileStore> tile_store, const std::string &profile = "")
+    {
+        request_handler.RegisterTileStore(std::move(tile_store), profile);
+    }
+
+    void RegisterAccessLog(std::unique_ptr<AccessLog> access_log)
+    {
+        request_handler.RegisterAccessLog(std::move(access_log));
+    }
+
+    void RegisterRequestCoalescer(std::unique_ptr<RequestCoalescer> request_coalescer)
+    {
+        request_handler.RegisterRequestCoalescer(std::move(request_coalescer));
+    }
+
+    void SetStreamedTableEntries(const std::size_t min_entries)
+    {
+        request_handler.SetStreamedTableEntries(min_entries);
+    }
 
-    void RegisterServiceHandler(std::unique_ptr<ServiceHandler> service_handler_)
+    std::size_t PrerenderTiles(const util::Coordinate south_west,
+                               const util::Coordinate north_east,
+                               const unsigned max_zoom)
     {
-        request_handler.RegisterServiceHandler(std::move(service_handler_));
+        return request_handler.PrerenderTiles(south_west, north_east, max_zoom);
     }
 
   private:
-    void HandleAccept(const boost::system::error_code &e)
+    // An io_service with the acceptor and connections that are handled on it
+    struct Worker
+    {
+        Worker(RequestHandler &request_handler, QueryPool *query_pool)
+            : acceptor(io_service),
+              new_connection(std::make_shared<Connection>(io_service, request_handler, query_pool))
+        {
+        }
+
+        boost::asio::io_service io_service;
+        boost::asio::ip::tcp::acceptor acceptor;
+        std::shared_ptr<Connection> new_connection;
+    };
+
+    void AsyncAccept(Worker &worker)
+    {
+        worker.acceptor.async_accept(
+            worker.new_connection->socket(),
+            boost::bind(
+                &Server::HandleAccept, this, std::ref(worker), boost::asio::placeholders::error));
+    }
+
+    void HandleAccept(Worker &worker, const boost::system::error_code &e)
+    {
+        if (!e)
+        {
+            worker.new_connection->start();
+            worker.new_connection = std::make_shared<Connection>(
+                worker.io_service, request_handler, query_pool.get());
+            AsyncAccept(worker);
+        }
+    }
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+    void AsyncAcceptLocal()
+    {
+        local_acceptor->async_accept(
+            new_local_connection->socket(),
+            boost::bind(&Server::HandleAcceptLocal, this, boost::asio::placeholders::error));
+    }
+
+    void HandleAcceptLocal(const boost::system::error_code &e)
     {
         if (!e)
         {
-            new_connection->start();
-            new_connection = std::make_shared<Connection>(io_service, request_handler);
-            acceptor.async_accept(
-                new_connection->socket(),
-                boost::bind(&Server::HandleAccept, this, boost::asio::placeholders::error));
+            new_local_connection->start();
+            new_local_connection = std::make_shared<Connection>(
+                workers.front()->io_service, request_handler, query_pool.get());
+            AsyncAcceptLocal();
         }
     }
+#endif
 
     unsigned thread_pool_size;
-    boost::asio::io_service io_service;
-    boost::asio::ip::tcp::acceptor acceptor;
-    std::shared_ptr<Connection> new_connection;
+    bool bind_to_numa_nodes;
     RequestHandler request_handler;
+    std::vector<std::unique_ptr<Worker>> workers;
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+    // on the io_service of the first worker
+    std::unique_ptr<boost::asio::local::stream_protocol::acceptor> local_acceptor;
+#endif
+    std::shared_ptr<Connection> new_local_connection;
+    std::string local_socket_path;
+    // destroyed before the workers, the queued queries hold on to their connections
+    std::unique_ptr<QueryPool> query_pool;
 };
 }
 }
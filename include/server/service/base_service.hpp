@@ -7,6 +7,8 @@
 
 #include <variant/variant.hpp>
 
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -17,10 +19,27 @@ namespace server
 namespace service
 {
 
+// JSON that a service rendered itself instead of building a json::Object, e.g. large tables
+struct RenderedJSON
+{
+    std::string value;
+};
+
+// Asks for the JSON in parts while it is computed, when the result holds it as the query starts.
+// Only the table service writes tables of at least min_entries entries this way and keeps it in
+// the result once a part was written, everything else replaces it with the usual result.
+struct StreamedJSON
+{
+    std::function<bool(const char *data, std::size_t size)> write;
+    std::size_t min_entries;
+};
+
 class BaseService
 {
   public:
-    using ResultT = mapbox::util::variant<util::json::Object, std::string>;
+    // a JSON object, a protobuf message, rendered JSON or JSON that was written in parts
+    using ResultT =
+        mapbox::util::variant<util::json::Object, std::string, RenderedJSON, StreamedJSON>;
 
     BaseService(OSRM &routing_machine) : routing_machine(routing_machine) {}
     virtual ~BaseService() = default;
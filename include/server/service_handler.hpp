@@ -5,6 +5,8 @@
 
 #include "osrm/osrm.hpp"
 
+#include <cstdint>
+#include <string>
 #include <unordered_map>
 
 namespace osrm
@@ -23,13 +25,53 @@ namespace api
 struct ParsedURL;
 }
 
-class ServiceHandler
+// Answers the queries of a dataset, either computed by the engine or by other osrm-routed
+class ServiceHandlerInterface
 {
   public:
-    ServiceHandler(osrm::EngineConfig &config);
     using ResultT = service::BaseService::ResultT;
 
-    engine::Status RunQuery(api::ParsedURL parsed_url, ResultT &result);
+    virtual ~ServiceHandlerInterface() = default;
+
+    virtual engine::Status RunQuery(api::ParsedURL parsed_url, ResultT &result) = 0;
+
+    // renders a tile that isn't requested by a client, like the tiles rendered ahead of time
+    virtual engine::Status RunTileQuery(const engine::api::TileParameters &parameters,
+                                        std::string &result) = 0;
+
+    // identify the dataset the queries run on
+    virtual unsigned GetCheckSum() const = 0;
+    virtual unsigned GetDataVersion() const = 0;
+    virtual std::uint64_t GetTrafficOverlayVersion() const = 0;
+
+    // false until the data is warmed up
+    virtual bool IsReady() const = 0;
+};
+
+class ServiceHandler final : public ServiceHandlerInterface
+{
+  public:
+    ServiceHandler(osrm::EngineConfig &config);
+
+    engine::Status RunQuery(api::ParsedURL parsed_url, ResultT &result) override;
+
+    engine::Status RunTileQuery(const engine::api::TileParameters &parameters,
+                                std::string &result) override
+    {
+        return routing_machine.Tile(parameters, result);
+    }
+
+    unsigned GetCheckSum() const override { return routing_machine.GetCheckSum(); }
+    unsigned GetDataVersion() const override { return routing_machine.GetDataVersion(); }
+    std::uint64_t GetTrafficOverlayVersion() const override
+    {
+        return routing_machine.GetTrafficOverlayVersion();
+    }
+
+    bool IsReady() const override { return routing_machine.IsReady(); }
+
+    // loads the files of the dataset again, see OSRM::Reload
+    void Reload() { routing_machine.Reload(); }
 
   private:
     std::unordered_map<std::string, std::unique_ptr<service::BaseService>> service_map;
@@ -0,0 +1,98 @@
+#ifndef SERVER_SHARD_SERVICE_HANDLER_HPP
+#define SERVER_SHARD_SERVICE_HANDLER_HPP
+
+#include "server/service_handler.hpp"
+
+#include "engine/api/route_parameters.hpp"
+#include "engine/api/table_parameters.hpp"
+#include "util/coordinate.hpp"
+#include "util/json_container.hpp"
+#include "util/shard_map.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+
+/**
+ * Answers the queries of osrm-routed --shards with the osrm-routed of the shards of a shard map.
+ *
+ * Queries whose coordinates are all in the region of one shard are passed on to that shard. The
+ * route and table queries across shards are combined from the shards: a table from the sources
+ * to the boundary points of their shards, the overlay between the boundary points, and a table
+ * from the boundary points of the shards of the destinations. A route follows the best of those
+ * paths with a route in every shard it passes.
+ *
+ * Routes across shards have a single leg between every pair of coordinates, without
+ * alternatives and annotations. Other services work within a shard only.
+ */
+class ShardServiceHandler final : public ServiceHandlerInterface
+{
+  public:
+    // timeout is the number of seconds to wait for a shard, 0 to wait forever
+    ShardServiceHandler(util::ShardMap shard_map,
+                        const unsigned max_table_size,
+                        const double timeout);
+
+    engine::Status RunQuery(api::ParsedURL parsed_url, ResultT &result) override;
+
+    engine::Status RunTileQuery(const engine::api::TileParameters &parameters,
+                                std::string &result) override;
+
+    unsigned GetCheckSum() const override { return checksum; }
+    unsigned GetDataVersion() const override { return 0; }
+    // the shards apply their overlays on their own
+    std::uint64_t GetTrafficOverlayVersion() const override { return 0; }
+
+    // the shards are warmed up on their own
+    bool IsReady() const override { return true; }
+
+  private:
+    // the durations between the coordinates computed by a shard, with their waypoints
+    struct ShardTable
+    {
+        // infinity if there is no route
+        std::vector<std::vector<double>> durations;
+        util::json::Array sources;
+        util::json::Array destinations;
+    };
+
+    // Passes the query on to the shard, the reply is the reply of the shard
+    engine::Status
+    Forward(const std::uint32_t shard, const std::string &path, ResultT &result) const;
+
+    ShardTable GetTable(const std::uint32_t shard,
+                        const std::string &profile,
+                        const std::vector<util::Coordinate> &sources,
+                        const std::vector<util::Coordinate> &destinations) const;
+
+    util::json::Object GetRoute(const std::uint32_t shard,
+                                const std::string &profile,
+                                const util::Coordinate from,
+                                const util::Coordinate to,
+                                const engine::api::RouteParameters &parameters) const;
+
+    // the coordinates of the query are in the region of a single shard, else INVALID_INDEX
+    std::uint32_t FindCommonShard(const std::vector<util::Coordinate> &coordinates) const;
+
+    engine::Status RouteAcrossShards(const std::string &profile,
+                                     const engine::api::RouteParameters &parameters,
+                                     util::json::Object &result) const;
+
+    engine::Status TableAcrossShards(const std::string &profile,
+                                     const engine::api::TableParameters &parameters,
+                                     util::json::Object &result) const;
+
+    const util::ShardMap shard_map;
+    const unsigned max_table_size;
+    const double timeout;
+    unsigned checksum;
+};
+}
+}
+
+#endif // SERVER_SHARD_SERVICE_HANDLER_HPP
@@ -0,0 +1,104 @@
+#ifndef TILE_STORE_HPP
+#define TILE_STORE_HPP
+
+#include "util/sharded_lru_cache.hpp"
+
+#include <boost/filesystem/path.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+
+// Rendered vector tiles, kept compressed with gzip in memory and optionally on disk.
+//
+// A tile only depends on its zoom, x and y and on the dataset it was rendered from, so tiles are
+// stored under these and served without running the tile plugin again. The memory part is a
+// bounded LRU like the ResponseCache and drops all tiles when it sees another checksum or data
+// version. Tiles on disk are written to <directory>/<checksum>-<data version>/<z>/<x>/<y>.mvt.gz
+// and survive restarts. The data version of shared memory starts over when the shared memory is
+// removed, so the directory has to be emptied when osrm-datastore loads new weights after that.
+class TileStore
+{
+  public:
+    using Tile = std::shared_ptr<const std::vector<char>>;
+
+    struct Statistics
+    {
+        std::size_t number_of_tiles;
+        std::size_t size;
+        std::size_t capacity;
+        std::uint64_t hits;
+        std::uint64_t disk_hits;
+        std::uint64_t misses;
+    };
+
+    // A capacity of 0 keeps no tiles in memory, an empty directory none on disk
+    TileStore(const std::size_t capacity, boost::filesystem::path directory);
+
+    TileStore(const TileStore &) = delete;
+    TileStore &operator=(const TileStore &) = delete;
+
+    // The compressed tile, nullptr if it was not rendered yet
+    Tile Get(const unsigned checksum,
+             const unsigned data_version,
+             const unsigned z,
+             const unsigned x,
+             const unsigned y);
+
+    // Compresses the rendered protobuf and stores it, returns the compressed tile
+    Tile Add(const unsigned checksum,
+             const unsigned data_version,
+             const unsigned z,
+             const unsigned x,
+             const unsigned y,
+             const std::string &tile);
+
+    Statistics GetStatistics() const;
+
+    // gzip used for the stored tiles, also for clients that don't accept gzip
+    static void Compress(const std::string &input, std::vector<char> &output);
+    static void Decompress(const std::vector<char> &input, std::vector<char> &output);
+
+  private:
+    using Key = std::uint64_t;
+
+    struct TileSize
+    {
+        std::size_t operator()(const Key, const Tile &tile) const { return tile->size(); }
+    };
+
+    using Version = std::pair<unsigned, unsigned>;
+    using Cache = util::ShardedLRUCache<Key, Tile, std::hash<Key>, Version, TileSize>;
+
+    static Key MakeKey(const unsigned z, const unsigned x, const unsigned y);
+    boost::filesystem::path GetPath(const unsigned checksum,
+                                    const unsigned data_version,
+                                    const unsigned z,
+                                    const unsigned x,
+                                    const unsigned y) const;
+    Tile Load(const boost::filesystem::path &path) const;
+    void Save(const boost::filesystem::path &path, const std::vector<char> &tile);
+
+    const boost::filesystem::path directory;
+
+    // a single shard, so the capacity is exact
+    Cache cache;
+    // tiles that were missing in memory and loaded from disk
+    std::atomic<std::uint64_t> disk_hits;
+    // a full disk is reported only once
+    std::atomic<bool> reported_write_error;
+};
+}
+}
+
+#endif // TILE_STORE_HPP
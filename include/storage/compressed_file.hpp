@@ -0,0 +1,49 @@
+#ifndef COMPRESSED_FILE_HPP
+#define COMPRESSED_FILE_HPP
+
+#include <boost/filesystem/path.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace osrm
+{
+namespace storage
+{
+
+/**
+ * Copies of the files of a dataset that are compressed in independent blocks with zlib, to copy
+ * less data to the hosts of a dataset. All blocks of a file are decompressed at once by as many
+ * threads as there are, straight into a mapping of the file they were compressed from.
+ *
+ * The file starts with a header of the block size and the size of the original file, followed by
+ * the offsets of the blocks after it. The copy of a file has its name with EXTENSION appended,
+ * e.g. "berlin.osrm.hsgr.zb".
+ */
+namespace compressed_file
+{
+const constexpr std::uint32_t VERSION = 1;
+const constexpr std::size_t DEFAULT_BLOCK_SIZE = 4 * 1024 * 1024;
+const constexpr char EXTENSION[] = ".zb";
+
+boost::filesystem::path getCompressedPath(const boost::filesystem::path &path);
+
+// Writes the compressed copy of a file, throws util::exception if it can't be read or written
+void compress(const boost::filesystem::path &path,
+              const boost::filesystem::path &compressed_path,
+              const std::size_t block_size = DEFAULT_BLOCK_SIZE);
+
+// Writes the file of a compressed copy, throws util::exception if the copy isn't valid
+void decompress(const boost::filesystem::path &compressed_path,
+                const boost::filesystem::path &path);
+
+// Decompresses the copies of the files that are missing or older than their copy, which is the
+// case after new copies were put next to the files of the last dataset. Returns the number of
+// files that were decompressed.
+std::size_t decompressUpdated(const std::vector<boost::filesystem::path> &paths);
+}
+}
+}
+
+#endif // COMPRESSED_FILE_HPP
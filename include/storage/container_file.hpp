@@ -0,0 +1,85 @@
+#ifndef CONTAINER_FILE_HPP
+#define CONTAINER_FILE_HPP
+
+#include "util/fingerprint.hpp"
+
+#include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace storage
+{
+
+/**
+ * A single file that holds the files of a dataset as sections.
+ *
+ * The file starts with a header of the container version and the fingerprint of the build
+ * that wrote it, followed by a table of contents with the name, offset, size and CRC-32C of every
+ * section. Sections start at page boundaries and hold the unchanged contents of the file they
+ * were packed from, so they can be mapped and used in place without any parsing.
+ *
+ * Sections are named by the extension of their file, e.g. ".hsgr" or ".names".
+ */
+class ContainerFile
+{
+  public:
+    static constexpr std::uint32_t VERSION = 2;
+    static constexpr std::size_t SECTION_ALIGNMENT = 4096;
+
+    struct Section
+    {
+        char *data;
+        std::size_t size;
+    };
+
+    // Maps the container and validates its header and table of contents. The mapping is
+    // private, changes to the sections are never written back.
+    explicit ContainerFile(const boost::filesystem::path &path);
+
+    // Writes the given files into a container at path
+    static void Write(const boost::filesystem::path &path,
+                      const std::vector<boost::filesystem::path> &files);
+
+    bool HasSection(const std::string &name) const;
+    Section GetSection(const std::string &name) const;
+
+    // the whole mapping, header and table of contents included
+    Section GetContents() const;
+
+    // Computes the checksums of all sections with all threads, which reads the whole container
+    bool ValidateChecksums() const;
+
+  private:
+    struct Entry
+    {
+        char name[32];
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::uint32_t checksum;
+        std::uint32_t padding;
+    };
+
+    struct Header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t number_of_sections;
+        util::FingerPrint fingerprint;
+    };
+
+    const Entry *FindEntry(const std::string &name) const;
+
+    boost::filesystem::path path;
+    boost::iostreams::mapped_file mapping;
+    std::vector<Entry> entries;
+};
+}
+}
+
+#endif // CONTAINER_FILE_HPP
@@ -1,26 +1,97 @@
 #ifndef SHARED_BARRIERS_HPP
 #define SHARED_BARRIERS_HPP
 
-#include <boost/interprocess/sync/named_condition.hpp>
+#include "storage/shared_memory.hpp"
+
+#include <boost/interprocess/managed_mapped_file.hpp>
+#include <boost/interprocess/sync/interprocess_mutex.hpp>
+#include <boost/interprocess/sync/interprocess_sharable_mutex.hpp>
 #include <boost/interprocess/sync/named_mutex.hpp>
 #include <boost/interprocess/sync/named_sharable_mutex.hpp>
 
+#include <memory>
+
 namespace osrm
 {
 namespace storage
 {
-struct SharedBarriers
+
+// The mutexes of the processes that share the regions of osrm-datastore. They are named mutexes of
+// the system, or with getSharedMemoryDirectory() live in the file osrm-barriers next to the
+// regions, so that they are shared wherever the regions are.
+class SharedBarriers
 {
+  public:
+    class Mutex
+    {
+      public:
+        void lock() { named ? named->lock() : in_file->lock(); }
+        bool try_lock() { return named ? named->try_lock() : in_file->try_lock(); }
+        void unlock() { named ? named->unlock() : in_file->unlock(); }
+
+      private:
+        friend class SharedBarriers;
+        std::unique_ptr<boost::interprocess::named_mutex> named;
+        boost::interprocess::interprocess_mutex *in_file = nullptr;
+    };
+
+    class SharableMutex
+    {
+      public:
+        void lock() { named ? named->lock() : in_file->lock(); }
+        bool try_lock() { return named ? named->try_lock() : in_file->try_lock(); }
+        void unlock() { named ? named->unlock() : in_file->unlock(); }
+        void lock_sharable() { named ? named->lock_sharable() : in_file->lock_sharable(); }
+        bool try_lock_sharable()
+        {
+            return named ? named->try_lock_sharable() : in_file->try_lock_sharable();
+        }
+        void unlock_sharable() { named ? named->unlock_sharable() : in_file->unlock_sharable(); }
+
+      private:
+        friend class SharedBarriers;
+        std::unique_ptr<boost::interprocess::named_sharable_mutex> named;
+        boost::interprocess::interprocess_sharable_mutex *in_file = nullptr;
+    };
 
     SharedBarriers()
-        : pending_update_mutex(boost::interprocess::open_or_create, "pending_update"),
-          query_mutex(boost::interprocess::open_or_create, "query")
     {
+        const auto directory = getSharedMemoryDirectory();
+        if (directory.empty())
+        {
+            using boost::interprocess::open_or_create;
+            pending_update_mutex.named.reset(
+                new boost::interprocess::named_mutex(open_or_create, "pending_update"));
+            query_mutex.named.reset(
+                new boost::interprocess::named_sharable_mutex(open_or_create, "query"));
+            traffic_mutex.named.reset(
+                new boost::interprocess::named_sharable_mutex(open_or_create, "traffic"));
+            return;
+        }
+
+        // creating the file and its objects is atomic across processes
+        file.reset(new boost::interprocess::managed_mapped_file(
+            boost::interprocess::open_or_create,
+            (directory / "osrm-barriers").string().c_str(),
+            BARRIERS_FILE_SIZE));
+        pending_update_mutex.in_file =
+            file->find_or_construct<boost::interprocess::interprocess_mutex>("pending_update")();
+        query_mutex.in_file =
+            file->find_or_construct<boost::interprocess::interprocess_sharable_mutex>("query")();
+        traffic_mutex.in_file =
+            file->find_or_construct<boost::interprocess::interprocess_sharable_mutex>("traffic")();
     }
 
     // Mutex to protect access to the boolean variable
-    boost::interprocess::named_mutex pending_update_mutex;
-    boost::interprocess::named_sharable_mutex query_mutex;
+    Mutex pending_update_mutex;
+    SharableMutex query_mutex;
+    // osrm-traffic holds it while it replaces the traffic overlay
+    SharableMutex traffic_mutex;
+
+  private:
+    static constexpr std::size_t BARRIERS_FILE_SIZE = 64 * 1024;
+
+    std::unique_ptr<boost::interprocess::managed_mapped_file> file;
 };
 }
 }
@@ -0,0 +1,117 @@
+#ifndef SHARED_DATASET_HPP
+#define SHARED_DATASET_HPP
+
+#include "storage/shared_barriers.hpp"
+#include "storage/shared_datatype.hpp"
+#include "storage/shared_memory.hpp"
+#include "util/exception.hpp"
+#include "util/simple_logger.hpp"
+
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/interprocess/sync/sharable_lock.hpp>
+
+#include <chrono>
+#include <exception>
+#include <memory>
+
+namespace osrm
+{
+namespace storage
+{
+
+/**
+ * A reference to the dataset osrm-datastore loaded last. osrm-datastore loads newer datasets into
+ * other slots without waiting for it, and the dataset is only removed once the last reference to
+ * it is gone, by whoever drops that reference.
+ */
+class SharedDatasetReference
+{
+  public:
+    SharedDatasetReference()
+    {
+        if (!SharedMemory::RegionExists(CURRENT_REGIONS))
+        {
+            throw util::exception(
+                "No shared memory blocks found, have you forgotten to run osrm-datastore?");
+        }
+        // writable for the references
+        timestamp_memory.reset(makeSharedMemory(CURRENT_REGIONS, 0, true));
+        current = static_cast<SharedDataTimestamp *>(timestamp_memory->Ptr());
+
+        // osrm-datastore only swaps and removes datasets with the exclusive lock
+        const auto lock_start = std::chrono::steady_clock::now();
+        boost::interprocess::sharable_lock<SharedBarriers::SharableMutex> query_lock(
+            barriers.query_mutex);
+        barrier_wait = std::chrono::steady_clock::now() - lock_start;
+        layout = current->layout;
+        data = current->data;
+        timestamp = current->timestamp;
+        slot = getDatasetSlot(layout);
+        if (slot == NUM_DATASET_SLOTS || current->generations[slot].timestamp != timestamp)
+        {
+            throw util::exception("No dataset is loaded into shared memory yet");
+        }
+        ++current->generations[slot].references;
+    }
+
+    ~SharedDatasetReference()
+    {
+        try
+        {
+            boost::interprocess::scoped_lock<SharedBarriers::SharableMutex> query_lock(
+                barriers.query_mutex);
+            auto &generation = current->generations[slot];
+            // osrm-datastore reused the slot, which it only does once it gave up on this
+            // reference
+            if (generation.timestamp != timestamp)
+            {
+                return;
+            }
+            if (--generation.references == 0 && current->layout != layout)
+            {
+                util::SimpleLogger().Write() << "removing the outdated dataset " << timestamp;
+                SharedMemory::Remove(layout);
+                SharedMemory::Remove(data);
+                generation.timestamp = 0;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            util::SimpleLogger().Write(logWARNING) << "could not release the dataset "
+                                                   << timestamp << ": " << e.what();
+        }
+    }
+
+    SharedDatasetReference(const SharedDatasetReference &) = delete;
+    SharedDatasetReference &operator=(const SharedDatasetReference &) = delete;
+
+    SharedDataType Layout() const { return layout; }
+    SharedDataType Data() const { return data; }
+    unsigned Timestamp() const { return timestamp; }
+
+    // How long attaching waited for osrm-datastore to let go of the barriers
+    std::chrono::nanoseconds BarrierWait() const { return barrier_wait; }
+
+    // False once osrm-datastore has loaded a different dataset. This doesn't take the lock, a
+    // torn read while osrm-datastore updates the region just reports the dataset as outdated.
+    bool IsCurrent() const
+    {
+        return layout == current->layout && data == current->data &&
+               timestamp == current->timestamp;
+    }
+
+  private:
+    SharedBarriers barriers;
+    std::unique_ptr<SharedMemory> timestamp_memory;
+    SharedDataTimestamp *current;
+
+    SharedDataType layout;
+    SharedDataType data;
+    unsigned timestamp;
+    unsigned slot;
+    std::chrono::nanoseconds barrier_wait;
+};
+}
+}
+
+#endif // SHARED_DATASET_HPP
@@ -2,8 +2,10 @@
 #define SHARED_DATA_TYPE_HPP
 
 #include "util/exception.hpp"
+#include "util/packed_bitset.hpp"
 #include "util/simple_logger.hpp"
 
+#include <atomic>
 #include <cstdint>
 
 #include <array>
@@ -22,7 +24,8 @@ const constexpr char *block_id_to_name[] = {"NAME_OFFSETS",
                                             "NAME_ID_LIST",
                                             "VIA_NODE_LIST",
                                             "GRAPH_NODE_LIST",
-                                            "GRAPH_EDGE_LIST",
+                                            "GRAPH_SEARCH_EDGE_LIST",
+                                            "GRAPH_UNPACK_EDGE_LIST",
                                             "COORDINATE_LIST",
                                             "OSM_NODE_ID_LIST",
                                             "TURN_INSTRUCTION",
@@ -30,7 +33,8 @@ const constexpr char *block_id_to_name[] = {"NAME_OFFSETS",
                                             "ENTRY_CLASSID",
                                             "R_SEARCH_TREE",
                                             "GEOMETRIES_INDEX",
-                                            "GEOMETRIES_LIST",
+                                            "GEOMETRIES_BLOCK_OFFSETS",
+                                            "GEOMETRIES_DATA",
                                             "HSGR_CHECKSUM",
                                             "TIMESTAMP",
                                             "FILE_INDEX_PATH",
@@ -48,7 +52,29 @@ const constexpr char *block_id_to_name[] = {"NAME_OFFSETS",
                                             "LANE_DATA_ID",
                                             "TURN_LANE_DATA",
                                             "LANE_DESCRIPTION_OFFSETS",
-                                            "LANE_DESCRIPTION_MASKS"};
+                                            "LANE_DESCRIPTION_MASKS",
+                                            "LANDMARK_CORE_NODES",
+                                            "LANDMARK_DISTANCES",
+                                            "GEOMETRIES_ZOOM_LEVELS",
+                                            "GEOMETRIES_LENGTHS",
+                                            "HUB_LABEL_OFFSETS",
+                                            "HUB_LABEL_HUBS",
+                                            "HUB_LABEL_WEIGHTS",
+                                            "MLD_GRAPH_NODE_LIST",
+                                            "MLD_GRAPH_SEARCH_EDGE_LIST",
+                                            "MLD_GRAPH_UNPACK_EDGE_LIST",
+                                            "MLD_CELLS",
+                                            "MLD_LEVEL_OFFSETS",
+                                            "MLD_NODE_CELLS",
+                                            "MLD_CELL_SOURCES",
+                                            "MLD_CELL_DESTINATIONS",
+                                            "MLD_CELL_WEIGHTS",
+                                            "MLD_EXCLUDE_MASKS",
+                                            "MLD_NODE_CLASSES",
+                                            "MLD_CLASS_NAMES",
+                                            "MLD_EDGE_WEIGHTS",
+                                            "MLD_METRIC_EDGE_WEIGHTS",
+                                            "MLD_EDGE_WEIGHT_NAMES"};
 
 struct SharedDataLayout
 {
@@ -60,7 +86,8 @@ struct SharedDataLayout
         NAME_ID_LIST,
         VIA_NODE_LIST,
         GRAPH_NODE_LIST,
-        GRAPH_EDGE_LIST,
+        GRAPH_SEARCH_EDGE_LIST,
+        GRAPH_UNPACK_EDGE_LIST,
         COORDINATE_LIST,
         OSM_NODE_ID_LIST,
         TURN_INSTRUCTION,
@@ -68,7 +95,8 @@ struct SharedDataLayout
         ENTRY_CLASSID,
         R_SEARCH_TREE,
         GEOMETRIES_INDEX,
-        GEOMETRIES_LIST,
+        GEOMETRIES_BLOCK_OFFSETS,
+        GEOMETRIES_DATA,
         HSGR_CHECKSUM,
         TIMESTAMP,
         FILE_INDEX_PATH,
@@ -87,13 +115,37 @@ struct SharedDataLayout
         TURN_LANE_DATA,
         LANE_DESCRIPTION_OFFSETS,
         LANE_DESCRIPTION_MASKS,
+        LANDMARK_CORE_NODES,
+        LANDMARK_DISTANCES,
+        GEOMETRIES_ZOOM_LEVELS,
+        GEOMETRIES_LENGTHS,
+        HUB_LABEL_OFFSETS,
+        HUB_LABEL_HUBS,
+        HUB_LABEL_WEIGHTS,
+        MLD_GRAPH_NODE_LIST,
+        MLD_GRAPH_SEARCH_EDGE_LIST,
+        MLD_GRAPH_UNPACK_EDGE_LIST,
+        MLD_CELLS,
+        MLD_LEVEL_OFFSETS,
+        MLD_NODE_CELLS,
+        MLD_CELL_SOURCES,
+        MLD_CELL_DESTINATIONS,
+        MLD_CELL_WEIGHTS,
+        MLD_EXCLUDE_MASKS,
+        MLD_NODE_CLASSES,
+        MLD_CLASS_NAMES,
+        MLD_EDGE_WEIGHTS,
+        MLD_METRIC_EDGE_WEIGHTS,
+        MLD_EDGE_WEIGHT_NAMES,
         NUM_BLOCKS
     };
 
     std::array<uint64_t, NUM_BLOCKS> num_entries;
     std::array<uint64_t, NUM_BLOCKS> entry_size;
+    // size of the huge pages the data region was allocated on, 0 for the default pages
+    uint64_t huge_page_size;
 
-    SharedDataLayout() : num_entries(), entry_size() {}
+    SharedDataLayout() : num_entries(), entry_size(), huge_page_size(0) {}
 
     template <typename T> inline void SetBlockSize(BlockID bid, uint64_t entries)
     {
@@ -107,12 +159,22 @@ struct SharedDataLayout
         return (block_size + (alignment - 1)) & ~(alignment - 1);
     }
 
+    // The blocks start at multiples of the word size, so the packed bits of the core markers and
+    // the 64 bit entries of other blocks are read with aligned loads. The start canary of a block
+    // stays right in front of it, the padding goes before that.
+    inline uint64_t AlignBlockOffset(uint64_t offset) const
+    {
+        const uint64_t alignment = alignof(std::uint64_t);
+        return (offset + (alignment - 1)) & ~(alignment - 1);
+    }
+
     inline uint64_t GetBlockSize(BlockID bid) const
     {
         // special bit encoding
         if (bid == CORE_MARKER)
         {
-            return AlignBlockSize((num_entries[bid] / 32 + 1) * entry_size[bid]);
+            return AlignBlockSize(util::PackedBitsetView::GetNumberOfWords(num_entries[bid]) *
+                                  entry_size[bid]);
         }
         return AlignBlockSize(num_entries[bid] * entry_size[bid]);
     }
@@ -124,10 +186,10 @@ struct SharedDataLayout
 
     inline uint64_t GetBlockOffset(BlockID bid) const
     {
-        uint64_t result = sizeof(CANARY);
+        uint64_t result = AlignBlockOffset(sizeof(CANARY));
         for (auto i = 0; i < bid; i++)
         {
-            result += GetBlockSize((BlockID)i) + 2 * sizeof(CANARY);
+            result = AlignBlockOffset(result + GetBlockSize((BlockID)i) + 2 * sizeof(CANARY));
         }
         return result;
     }
@@ -173,14 +235,65 @@ enum SharedDataType
     LAYOUT_2,
     DATA_2,
     LAYOUT_NONE,
-    DATA_NONE
+    DATA_NONE,
+    // written by osrm-traffic, independent of the dataset regions
+    TRAFFIC_OVERLAY,
+    LAYOUT_3,
+    DATA_3,
+    LAYOUT_4,
+    DATA_4
+};
+
+// osrm-datastore loads every dataset into one of these slots, while the datasets of the other
+// slots stay loaded until the last osrm-routed that uses them lets go of them
+const constexpr unsigned NUM_DATASET_SLOTS = 4;
+
+inline SharedDataType getLayoutRegion(const unsigned slot)
+{
+    const constexpr SharedDataType regions[NUM_DATASET_SLOTS] = {
+        LAYOUT_1, LAYOUT_2, LAYOUT_3, LAYOUT_4};
+    return regions[slot];
+}
+
+inline SharedDataType getDataRegion(const unsigned slot)
+{
+    const constexpr SharedDataType regions[NUM_DATASET_SLOTS] = {DATA_1, DATA_2, DATA_3, DATA_4};
+    return regions[slot];
+}
+
+// NUM_DATASET_SLOTS if the region is not the layout of a slot
+inline unsigned getDatasetSlot(const SharedDataType layout_region)
+{
+    for (unsigned slot = 0; slot < NUM_DATASET_SLOTS; ++slot)
+    {
+        if (getLayoutRegion(slot) == layout_region)
+        {
+            return slot;
+        }
+    }
+    return NUM_DATASET_SLOTS;
+}
+
+// The dataset in a slot. Changed with the exclusive query lock held, but the references are
+// taken with the sharable one and live in shared memory, so they need to be lock-free atomics.
+struct SharedDataGeneration
+{
+    // the timestamp of the dataset, 0 while the slot is empty or being loaded
+    unsigned timestamp;
+    // the facades attached to the dataset
+    std::atomic<std::uint32_t> references;
 };
 
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "references in shared memory need lock-free atomics");
+
+// Zero-initialized when osrm-datastore creates the region
 struct SharedDataTimestamp
 {
+    // the dataset that was loaded last
     SharedDataType layout;
     SharedDataType data;
     unsigned timestamp;
+    SharedDataGeneration generations[NUM_DATASET_SLOTS];
 };
 
 static_assert(sizeof(block_id_to_name) / sizeof(*block_id_to_name) == SharedDataLayout::NUM_BLOCKS,
@@ -6,6 +6,7 @@
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/interprocess/file_mapping.hpp>
 #include <boost/interprocess/mapped_region.hpp>
 #ifndef _WIN32
 #include <boost/interprocess/xsi_shared_memory.hpp>
@@ -14,12 +15,17 @@
 #endif
 
 #ifdef __linux__
+#include <linux/magic.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <sys/vfs.h>
 #endif
 
-// #include <cstring>
+#include <cerrno>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 
 #include <algorithm>
 #include <exception>
@@ -39,6 +45,15 @@ struct OSRMLockFile
     }
 };
 
+// The directory of OSRM_SHARED_MEMORY_DIR, empty if it is not set. With a directory the regions
+// are files in it instead of System V shared memory, so that processes that share the directory
+// share the data, like containers on a host that mount the same tmpfs.
+inline boost::filesystem::path getSharedMemoryDirectory()
+{
+    const char *directory = std::getenv("OSRM_SHARED_MEMORY_DIR");
+    return directory != nullptr ? boost::filesystem::path(directory) : boost::filesystem::path();
+}
+
 #ifndef _WIN32
 class SharedMemory
 {
@@ -78,6 +93,10 @@ class SharedMemory
   public:
     void *Ptr() const { return region.get_address(); }
 
+    // Size of the pages backing a region allocated by this process, 0 if they are the default
+    // pages of the system.
+    uint64_t HugePageSize() const { return huge_page_size; }
+
     SharedMemory(const SharedMemory &) = delete;
     SharedMemory &operator=(const SharedMemory &) = delete;
 
@@ -86,9 +105,23 @@ class SharedMemory
                  const IdentifierT id,
                  const uint64_t size = 0,
                  bool read_write = false,
-                 bool remove_prev = true)
-        : key(lock_file.string().c_str(), id)
+                 bool remove_prev = true,
+                 const uint64_t requested_huge_page_size = 0)
+        : key(lock_file.string().c_str(), id), huge_page_size(0)
     {
+        const auto directory = getSharedMemoryDirectory();
+        if (!directory.empty())
+        {
+            OpenFile(directory, GetFilePath(directory, id), size, read_write, remove_prev);
+            if (requested_huge_page_size > 0 && huge_page_size == 0)
+            {
+                util::SimpleLogger().Write(logWARNING)
+                    << "huge pages for regions in files need the directory on hugetlbfs, using "
+                       "the default pages";
+            }
+            return;
+        }
+
         if (0 == size)
         { // read_only
             shm = boost::interprocess::xsi_shared_memory(boost::interprocess::open_only, key);
@@ -104,6 +137,13 @@ class SharedMemory
             {
                 Remove(key);
             }
+#ifdef __linux__
+            if (requested_huge_page_size > 0)
+            {
+                CreateOnHugePages(size, requested_huge_page_size);
+            }
+#endif
+            // opens the huge page segment if one was created above
             shm = boost::interprocess::xsi_shared_memory(
                 boost::interprocess::open_or_create, key, size);
 #ifdef __linux__
@@ -125,6 +165,12 @@ class SharedMemory
 
     template <typename IdentifierT> static bool RegionExists(const IdentifierT id)
     {
+        const auto directory = getSharedMemoryDirectory();
+        if (!directory.empty())
+        {
+            return boost::filesystem::exists(GetFilePath(directory, id));
+        }
+
         bool result = true;
         try
         {
@@ -141,12 +187,130 @@ class SharedMemory
 
     template <typename IdentifierT> static bool Remove(const IdentifierT id)
     {
+        const auto directory = getSharedMemoryDirectory();
+        if (!directory.empty())
+        {
+            boost::system::error_code error;
+            return boost::filesystem::remove(GetFilePath(directory, id), error);
+        }
+
         OSRMLockFile lock_file;
         boost::interprocess::xsi_key key(lock_file().string().c_str(), id);
         return Remove(key);
     }
 
   private:
+    // Removes the file of a region on destruction, mappings of it stay valid
+    class file_remove
+    {
+      public:
+        void SetPath(boost::filesystem::path new_path) { path = std::move(new_path); }
+
+        file_remove() = default;
+        file_remove(const file_remove &) = delete;
+        file_remove &operator=(const file_remove &) = delete;
+
+        ~file_remove()
+        {
+            boost::system::error_code error;
+            if (!path.empty() && !boost::filesystem::remove(path, error))
+            {
+                util::SimpleLogger().Write(logDEBUG) << "could not remove " << path.string();
+            }
+        }
+
+      private:
+        boost::filesystem::path path;
+    };
+
+    template <typename IdentifierT>
+    static boost::filesystem::path GetFilePath(const boost::filesystem::path &directory,
+                                               const IdentifierT id)
+    {
+        return directory / ("osrm-region-" + std::to_string(static_cast<int>(id)));
+    }
+
+    // Maps the file of a region shared with the other processes. A new region replaces the
+    // file, so the processes that still map the previous one keep its data.
+    void OpenFile(const boost::filesystem::path &directory,
+                  const boost::filesystem::path &path,
+                  const uint64_t size,
+                  const bool read_write,
+                  const bool remove_prev)
+    {
+        if (0 == size)
+        {
+            const auto mode =
+                read_write ? boost::interprocess::read_write : boost::interprocess::read_only;
+            file = boost::interprocess::file_mapping(path.string().c_str(), mode);
+            region = boost::interprocess::mapped_region(file, mode);
+            return;
+        }
+
+        if (remove_prev)
+        {
+            boost::system::error_code error;
+            boost::filesystem::remove(path, error);
+        }
+        uint64_t file_size = size;
+#ifdef __linux__
+        // files on hugetlbfs need to span whole huge pages
+        struct statfs file_system;
+        if (statfs(directory.string().c_str(), &file_system) == 0 &&
+            file_system.f_type == HUGETLBFS_MAGIC)
+        {
+            huge_page_size = file_system.f_bsize;
+            file_size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+        }
+#else
+        (void)directory;
+#endif
+        {
+            boost::filesystem::ofstream create(path, std::ios::binary | std::ios::app);
+            if (!create)
+            {
+                throw util::exception("could not create " + path.string());
+            }
+        }
+        boost::filesystem::resize_file(path, file_size);
+        file = boost::interprocess::file_mapping(path.string().c_str(),
+                                                 boost::interprocess::read_write);
+        region = boost::interprocess::mapped_region(file, boost::interprocess::read_write);
+        file_remover.SetPath(path);
+        util::SimpleLogger().Write(logDEBUG) << "writeable memory allocated " << size
+                                             << " bytes in " << path.string();
+    }
+
+#ifdef __linux__
+    // Creates the segment on huge pages of the given size, which are taken from the pool
+    // configured in /proc/sys/vm/nr_hugepages (or its counterpart for the size). Falls back to
+    // the default pages with a warning if the pool is too small or the size is not supported.
+    void CreateOnHugePages(const uint64_t size, const uint64_t requested_huge_page_size)
+    {
+        int flags = IPC_CREAT | IPC_EXCL | SHM_HUGETLB | 0644;
+#ifdef SHM_HUGE_SHIFT
+        int page_size_log2 = 0;
+        while ((uint64_t{1} << page_size_log2) < requested_huge_page_size)
+        {
+            ++page_size_log2;
+        }
+        flags |= page_size_log2 << SHM_HUGE_SHIFT;
+#endif
+        // huge page segments need to span whole pages
+        const uint64_t rounded_size = (size + requested_huge_page_size - 1) /
+                                      requested_huge_page_size * requested_huge_page_size;
+        if (-1 == shmget(key.get_key(), rounded_size, flags))
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "could not allocate shared memory on huge pages of "
+                << requested_huge_page_size << " bytes (" << std::strerror(errno)
+                << "), using the default pages";
+            return;
+        }
+        huge_page_size = requested_huge_page_size;
+    }
+#endif
+
     static bool RegionExists(const boost::interprocess::xsi_key &key)
     {
         bool result = true;
@@ -182,8 +346,12 @@ class SharedMemory
 
     boost::interprocess::xsi_key key;
     boost::interprocess::xsi_shared_memory shm;
+    // with getSharedMemoryDirectory() instead of shm
+    boost::interprocess::file_mapping file;
     boost::interprocess::mapped_region region;
     shm_remove remover;
+    file_remove file_remover;
+    uint64_t huge_page_size;
 };
 #else
 // Windows - specific code
@@ -226,11 +394,15 @@ class SharedMemory
   public:
     void *Ptr() const { return region.get_address(); }
 
+    // Huge pages are not supported on Windows
+    uint64_t HugePageSize() const { return 0; }
+
     SharedMemory(const boost::filesystem::path &lock_file,
                  const int id,
                  const uint64_t size = 0,
                  bool read_write = false,
-                 bool remove_prev = true)
+                 bool remove_prev = true,
+                 const uint64_t /* requested_huge_page_size */ = 0)
     {
         sprintf(key, "%s.%d", "osrm.lock", id);
         if (0 == size)
@@ -330,7 +502,8 @@ template <typename IdentifierT, typename LockFileT = OSRMLockFile>
 SharedMemory *makeSharedMemory(const IdentifierT &id,
                                const uint64_t size = 0,
                                bool read_write = false,
-                               bool remove_prev = true)
+                               bool remove_prev = true,
+                               const uint64_t huge_page_size = 0)
 {
     try
     {
@@ -346,7 +519,7 @@ SharedMemory *makeSharedMemory(const IdentifierT &id,
                 boost::filesystem::ofstream ofs(lock_file());
             }
         }
-        return new SharedMemory(lock_file(), id, size, read_write, remove_prev);
+        return new SharedMemory(lock_file(), id, size, read_write, remove_prev, huge_page_size);
     }
     catch (const boost::interprocess::interprocess_exception &e)
     {
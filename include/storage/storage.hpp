@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/filesystem/path.hpp>
 
+#include <cstddef>
 #include <string>
 
 namespace osrm
@@ -41,12 +42,22 @@ namespace storage
 class Storage
 {
   public:
-    Storage(StorageConfig config);
+    // huge_page_size selects huge pages of that size for the data region if it is not 0.
+    // weights_only copies all blocks but those with weights from the dataset that is loaded.
+    Storage(StorageConfig config,
+            const std::size_t huge_page_size = 0,
+            const bool weights_only = false);
     int Run();
 
   private:
     StorageConfig config;
+    std::size_t huge_page_size;
+    bool weights_only;
 };
+
+// Logs the number of entries and the size of every block of the dataset in shared memory, the
+// largest first. False if there is none.
+bool logCurrentLayout();
 }
 }
 
@@ -30,6 +30,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/filesystem/path.hpp>
 
+#include <vector>
+
 namespace osrm
 {
 namespace storage
@@ -58,7 +60,18 @@ struct StorageConfig final
     boost::filesystem::path nodes_data_path;
     boost::filesystem::path edges_data_path;
     boost::filesystem::path core_data_path;
+    // optional, only written by osrm-contract for a core with landmarks
+    boost::filesystem::path landmarks_data_path;
+    // optional, only written by osrm-contract, without labels if they weren't computed
+    boost::filesystem::path hub_labels_data_path;
+    // optional, only written by osrm-customize for multi-level searches
+    boost::filesystem::path mld_graph_data_path;
+    boost::filesystem::path cells_data_path;
     boost::filesystem::path geometries_path;
+    // optional, only written by osrm-extract --generate-geometry-zoom-levels
+    boost::filesystem::path geometry_zoom_levels_path;
+    // optional, only written by osrm-extract --generate-segment-lengths
+    boost::filesystem::path geometry_lengths_path;
     boost::filesystem::path timestamp_path;
     boost::filesystem::path datasource_names_path;
     boost::filesystem::path datasource_indexes_path;
@@ -67,6 +80,14 @@ struct StorageConfig final
     boost::filesystem::path intersection_class_path;
     boost::filesystem::path turn_lane_data_path;
     boost::filesystem::path turn_lane_description_path;
+    // optional, a single file with the contents of all files above except the r-tree
+    boost::filesystem::path container_path;
+
+    // files that are packed into a container
+    std::vector<boost::filesystem::path> GetContainerFiles() const;
+
+    // the large files that osrm-datastore --compress writes compressed copies of
+    std::vector<boost::filesystem::path> GetCompressibleFiles() const;
 };
 }
 }
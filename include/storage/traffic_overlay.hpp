@@ -0,0 +1,48 @@
+#ifndef OSRM_STORAGE_TRAFFIC_OVERLAY_HPP
+#define OSRM_STORAGE_TRAFFIC_OVERLAY_HPP
+
+#include "util/typedefs.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace storage
+{
+
+// The live traffic penalties that osrm-traffic writes into the TRAFFIC_OVERLAY region of shared
+// memory, which the engines with EngineConfig::use_traffic_overlay add to the weights of their
+// searches. Writing an overlay replaces the previous one and takes effect without reloading the
+// dataset with osrm-datastore.
+//
+// The region holds a header with a version, which every write increments, and the penalties
+// sorted by their node. The region is only attached while it is read or written, under a lock
+// of its own, so readers never see a partial write and the queries never wait on osrm-datastore.
+
+// The penalty is added to the weight of the edge-based node, TRAFFIC_CLOSED closes it
+struct TrafficPenalty final
+{
+    NodeID node;
+    EdgeWeight penalty;
+};
+
+const constexpr EdgeWeight TRAFFIC_CLOSED = INVALID_EDGE_WEIGHT;
+
+// Reads a CSV file with a line "edge_based_node_id,seconds" per penalty, "closed" instead of
+// the seconds closes the node. Throws if the file can't be read or is malformed.
+std::vector<TrafficPenalty> readTrafficPenaltyFile(const std::string &filename);
+
+// Replaces the overlay in shared memory by the penalties, returns its new version
+std::uint64_t writeSharedTrafficOverlay(const std::vector<TrafficPenalty> &penalties);
+
+// Reads the overlay in shared memory into penalties if its version is not the known version.
+// Version 0 is the empty overlay if there is no region.
+bool readSharedTrafficOverlay(const std::uint64_t known_version,
+                              std::uint64_t &version,
+                              std::vector<TrafficPenalty> &penalties);
+}
+}
+
+#endif // OSRM_STORAGE_TRAFFIC_OVERLAY_HPP
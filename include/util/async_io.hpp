@@ -0,0 +1,79 @@
+#ifndef OSRM_UTIL_ASYNC_IO_HPP
+#define OSRM_UTIL_ASYNC_IO_HPP
+
+#include <boost/filesystem/path.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace osrm
+{
+namespace util
+{
+
+// Reads and writes large regions of files with many requests in flight at once, straight into
+// and out of their final buffers instead of through the buffer of a stream. The regions are split
+// into requests of BLOCK_SIZE bytes, of which up to the queue depth are in flight.
+//
+// With ENABLE_IO_URING the requests go to an io_uring of the kernel. Where that isn't compiled
+// in or the kernel doesn't allow it, like before Linux 5.1 or in containers that block it, a pool
+// of as many threads as the queue is deep calls pread and pwrite.
+//
+// Read, Create and Write can be called from several threads at once. The buffers and the memory
+// behind them must stay alive until Wait returns, which must not be called while other threads
+// queue requests.
+class AsyncIO
+{
+  public:
+    enum class Backend
+    {
+        IOUring,
+        ThreadPool
+    };
+
+    static const constexpr std::size_t BLOCK_SIZE = 1024 * 1024;
+    static const constexpr unsigned DEFAULT_QUEUE_DEPTH = 64;
+
+    // io_uring if it is available, the thread pool otherwise
+    explicit AsyncIO(const unsigned queue_depth = DEFAULT_QUEUE_DEPTH);
+    // Throws util::exception if the backend isn't available
+    AsyncIO(const Backend backend, const unsigned queue_depth = DEFAULT_QUEUE_DEPTH);
+    // Waits for the requests in flight, errors are dropped
+    ~AsyncIO();
+
+    AsyncIO(const AsyncIO &) = delete;
+    AsyncIO &operator=(const AsyncIO &) = delete;
+
+    Backend GetBackend() const;
+    static const char *GetBackendName(const Backend backend);
+    static bool IsAvailable(const Backend backend);
+
+    // Queues a read of size bytes at offset of the file into buffer
+    void Read(const boost::filesystem::path &path,
+              const std::uint64_t offset,
+              void *buffer,
+              const std::uint64_t size);
+
+    // Creates the file, or truncates it if it exists, for the writes that follow
+    void Create(const boost::filesystem::path &path);
+
+    // Queues a write of size bytes of buffer at offset of the file, which is created if it
+    // doesn't exist
+    void Write(const boost::filesystem::path &path,
+               const std::uint64_t offset,
+               const void *buffer,
+               const std::uint64_t size);
+
+    // Waits until all queued requests are done and closes the files. Throws util::exception with
+    // the file of the first request that failed or read past the end of its file.
+    void Wait();
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+}
+}
+
+#endif // OSRM_UTIL_ASYNC_IO_HPP
@@ -2,6 +2,9 @@
 #define BEARING_HPP
 
 #include <boost/assert.hpp>
+
+#include <cmath>
+#include <cstdint>
 #include <string>
 
 namespace osrm
@@ -96,6 +99,58 @@ inline double reverseBearing(const double bearing)
         return bearing - 180.;
     return bearing + 180;
 }
+
+// Bearings in steps of 360/256 degrees, so that a bearing fits into a byte
+const constexpr double QUANTIZED_BEARING_STEP = 360. / 256.;
+
+inline std::uint8_t quantize(const double bearing)
+{
+    BOOST_ASSERT(bearing >= 0);
+    BOOST_ASSERT(bearing <= 360);
+    return static_cast<std::uint8_t>(
+        static_cast<int>(std::round(bearing / QUANTIZED_BEARING_STEP)));
+}
+
+inline std::uint8_t reverseQuantized(const std::uint8_t quantized_bearing)
+{
+    return static_cast<std::uint8_t>(quantized_bearing + 128);
+}
+
+// The quantized bearings of CheckInBounds(bearing, range), as an interval of bytes that wraps
+// around. It is widened by half a step on each side, so a quantized bearing is rejected only if
+// all bearings that round to it are outside of the range.
+class QuantizedRange
+{
+  public:
+    QuantizedRange(const int bearing, const int range) : first(0), width(MAX_WIDTH)
+    {
+        if (range < 0)
+        {
+            width = -1;
+        }
+        else if (range < 180)
+        {
+            const int low =
+                static_cast<int>(std::ceil((bearing - range) / QUANTIZED_BEARING_STEP - 0.5));
+            const int high =
+                static_cast<int>(std::floor((bearing + range) / QUANTIZED_BEARING_STEP + 0.5));
+            // the low byte of a negative int is its value modulo 256
+            first = static_cast<std::uint8_t>(low & MAX_WIDTH);
+            width = high - low < MAX_WIDTH ? high - low : MAX_WIDTH;
+        }
+    }
+
+    bool Contains(const std::uint8_t quantized_bearing) const
+    {
+        return static_cast<std::uint8_t>(quantized_bearing - first) <= width;
+    }
+
+  private:
+    static const constexpr int MAX_WIDTH = 255;
+
+    std::uint8_t first;
+    int width;
+};
 }
 }
 }
@@ -1,9 +1,12 @@
 #ifndef BINARY_HEAP_H
 #define BINARY_HEAP_H
 
+#include "util/prefetch.hpp"
+
 #include <boost/assert.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <map>
 #include <type_traits>
@@ -26,12 +29,67 @@ template <typename NodeID, typename Key> class ArrayStorage
 
     Key peek_index(const NodeID node) const { return positions[node]; }
 
+    void Prefetch(const NodeID node) const { prefetch(&positions[node]); }
+
     void Clear() {}
 
+    std::size_t Capacity() const { return positions.size(); }
+
   private:
     std::vector<Key> positions;
 };
 
+// Flat array storage that tags every slot with the generation it was written in.
+// Clear() only bumps the generation, so it is O(1) and stale slots read as not inserted
+// without touching the heap's node list.
+template <typename NodeID, typename Key> class TimestampedArrayStorage
+{
+  public:
+    explicit TimestampedArrayStorage(size_t size) : entries(size), generation(1) {}
+
+    Key &operator[](NodeID node)
+    {
+        auto &entry = entries[node];
+        entry.generation = generation;
+        return entry.key;
+    }
+
+    Key peek_index(const NodeID node) const
+    {
+        const auto &entry = entries[node];
+        if (entry.generation == generation)
+        {
+            return entry.key;
+        }
+        return std::numeric_limits<Key>::max();
+    }
+
+    void Prefetch(const NodeID node) const { prefetch(&entries[node]); }
+
+    void Clear()
+    {
+        ++generation;
+        // on wrap-around old stamps would become valid again
+        if (generation == 0)
+        {
+            std::fill(entries.begin(), entries.end(), Entry());
+            generation = 1;
+        }
+    }
+
+    std::size_t Capacity() const { return entries.size(); }
+
+  private:
+    struct Entry
+    {
+        Key key = 0;
+        std::uint32_t generation = 0;
+    };
+
+    std::vector<Entry> entries;
+    std::uint32_t generation;
+};
+
 template <typename NodeID, typename Key> class MapStorage
 {
   public:
@@ -41,6 +99,11 @@ template <typename NodeID, typename Key> class MapStorage
 
     void Clear() { nodes.clear(); }
 
+    // the nodes of a map are not worth finding ahead of the lookup
+    void Prefetch(const NodeID) const {}
+
+    std::size_t Capacity() const { return std::numeric_limits<std::size_t>::max(); }
+
     Key peek_index(const NodeID node) const
     {
         const auto iter = nodes.find(node);
@@ -80,6 +143,11 @@ template <typename NodeID, typename Key> class UnorderedMapStorage
 
     void Clear() { nodes.clear(); }
 
+    // the nodes of a map are not worth finding ahead of the lookup
+    void Prefetch(const NodeID) const {}
+
+    std::size_t Capacity() const { return std::numeric_limits<std::size_t>::max(); }
+
   private:
     std::unordered_map<NodeID, Key> nodes;
 };
@@ -113,6 +181,9 @@ class BinaryHeap
 
     bool Empty() const { return 0 == Size(); }
 
+    // Largest number of distinct node ids the index storage can address
+    std::size_t Capacity() const { return node_index.Capacity(); }
+
     void Insert(NodeID node, Weight weight, const Data &data)
     {
         HeapElement element;
@@ -151,6 +222,9 @@ class BinaryHeap
         return inserted_nodes[index].key == 0;
     }
 
+    // loads the index slot of the node into the cache ahead of a lookup
+    void Prefetch(const NodeID node) const { node_index.Prefetch(node); }
+
     bool WasInserted(const NodeID node) const
     {
         const auto index = node_index.peek_index(node);
@@ -0,0 +1,273 @@
+#ifndef CHUNKED_VECTOR_HPP
+#define CHUNKED_VECTOR_HPP
+
+#include "util/huge_page_arena.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+const constexpr std::size_t CHUNKED_VECTOR_CHUNK_BYTES = 32 * 1024 * 1024;
+
+// A chunk holds the largest power of two of elements that fits into CHUNKED_VECTOR_CHUNK_BYTES,
+// so an index is split into its chunk and the offset in it with a shift and a mask
+template <typename ElementT> constexpr std::size_t getChunkedVectorShift()
+{
+    std::size_t shift = 0;
+    while ((std::size_t{2} << shift) * sizeof(ElementT) <= CHUNKED_VECTOR_CHUNK_BYTES)
+    {
+        ++shift;
+    }
+    return shift;
+}
+
+template <typename ValueT, typename ElementT>
+class ChunkedVectorIterator
+    : public boost::iterator_facade<ChunkedVectorIterator<ValueT, ElementT>,
+                                    ValueT,
+                                    std::random_access_iterator_tag>
+{
+  public:
+    ChunkedVectorIterator() : index(0), chunks(nullptr) {}
+    ChunkedVectorIterator(const std::size_t index, ElementT *const *chunks)
+        : index(index), chunks(chunks)
+    {
+    }
+
+    // iterators convert to const iterators
+    template <typename OtherValueT,
+              typename = typename std::enable_if<
+                  std::is_convertible<OtherValueT *, ValueT *>::value>::type>
+    ChunkedVectorIterator(const ChunkedVectorIterator<OtherValueT, ElementT> &other)
+        : index(other.index), chunks(other.chunks)
+    {
+    }
+
+  private:
+    template <typename, typename> friend class ChunkedVectorIterator;
+    friend class boost::iterator_core_access;
+
+    static constexpr std::size_t SHIFT = getChunkedVectorShift<ElementT>();
+    static constexpr std::size_t MASK = (std::size_t{1} << SHIFT) - 1;
+
+    void advance(const std::ptrdiff_t n) { index += n; }
+    void increment() { ++index; }
+    void decrement() { --index; }
+
+    template <typename OtherValueT>
+    bool equal(const ChunkedVectorIterator<OtherValueT, ElementT> &other) const
+    {
+        return index == other.index;
+    }
+
+    // 'other minus this', sorting breaks otherwise
+    template <typename OtherValueT>
+    std::ptrdiff_t distance_to(const ChunkedVectorIterator<OtherValueT, ElementT> &other) const
+    {
+        return static_cast<std::ptrdiff_t>(other.index) - static_cast<std::ptrdiff_t>(index);
+    }
+
+    ValueT &dereference() const { return chunks[index >> SHIFT][index & MASK]; }
+
+    std::size_t index;
+    ElementT *const *chunks;
+};
+
+/**
+ * A vector for the large edge lists of the contraction. The elements are stored in chunks of up
+ * to 32 MiB that are allocated as huge page arenas, so a chunk is filled with a few page faults
+ * and growing never copies the elements that are already stored. The chunks are independent, so
+ * bulk passes run over them in parallel, and they are released one by one while the elements
+ * are consumed by ConsumeChunks.
+ *
+ * Elements have to be trivially destructible, chunks are released without destroying them.
+ */
+template <typename ElementT> class ChunkedVector
+{
+    static_assert(std::is_trivially_destructible<ElementT>::value,
+                  "elements of a ChunkedVector are never destroyed");
+
+  public:
+    static constexpr std::size_t CHUNK_SHIFT = getChunkedVectorShift<ElementT>();
+    static constexpr std::size_t ELEMENTS_PER_CHUNK = std::size_t{1} << CHUNK_SHIFT;
+
+    using value_type = ElementT;
+    using iterator = ChunkedVectorIterator<ElementT, ElementT>;
+    using const_iterator = ChunkedVectorIterator<const ElementT, ElementT>;
+
+    ChunkedVector() : current_size(0) {}
+    ChunkedVector(const ChunkedVector &) = delete;
+    ChunkedVector &operator=(const ChunkedVector &) = delete;
+    ChunkedVector(ChunkedVector &&other) noexcept : ChunkedVector() { swap(other); }
+    ChunkedVector &operator=(ChunkedVector &&other) noexcept
+    {
+        clear();
+        swap(other);
+        return *this;
+    }
+    ~ChunkedVector() { clear(); }
+
+    void swap(ChunkedVector &other) noexcept
+    {
+        std::swap(current_size, other.current_size);
+        chunks.swap(other.chunks);
+    }
+
+    // releases all chunks
+    void clear()
+    {
+        for (auto chunk : chunks)
+        {
+            if (chunk != nullptr)
+            {
+                releaseHugePageArena(chunk, CHUNK_BYTES);
+            }
+        }
+        chunks.clear();
+        chunks.shrink_to_fit();
+        current_size = 0;
+    }
+
+    void reserve(const std::size_t new_capacity)
+    {
+        while (capacity() < new_capacity)
+        {
+            AddChunk();
+        }
+    }
+
+    // New elements are value-initialized by all threads, shrinking releases the chunks that are
+    // not needed anymore.
+    void resize(const std::size_t new_size)
+    {
+        if (new_size > current_size)
+        {
+            reserve(new_size);
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(current_size, new_size),
+                              [this](const tbb::blocked_range<std::size_t> &range) {
+                                  for (auto index = range.begin(); index != range.end(); ++index)
+                                  {
+                                      new (&(*this)[index]) ElementT();
+                                  }
+                              });
+        }
+        else
+        {
+            const auto number_of_chunks = (new_size + ELEMENTS_PER_CHUNK - 1) >> CHUNK_SHIFT;
+            while (chunks.size() > number_of_chunks)
+            {
+                releaseHugePageArena(chunks.back(), CHUNK_BYTES);
+                chunks.pop_back();
+            }
+        }
+        current_size = new_size;
+    }
+
+    template <typename... Ts> void emplace_back(Ts &&... arguments)
+    {
+        if (current_size == capacity())
+        {
+            AddChunk();
+        }
+        new (&(*this)[current_size]) ElementT(std::forward<Ts>(arguments)...);
+        ++current_size;
+    }
+
+    void push_back(const ElementT &element) { emplace_back(element); }
+
+    template <class InputIterator> void append(InputIterator first, const InputIterator last)
+    {
+        for (; first != last; ++first)
+        {
+            emplace_back(*first);
+        }
+    }
+
+    std::size_t size() const { return current_size; }
+
+    bool empty() const { return current_size == 0; }
+
+    std::size_t capacity() const { return chunks.size() * ELEMENTS_PER_CHUNK; }
+
+    ElementT &operator[](const std::size_t index)
+    {
+        return chunks[index >> CHUNK_SHIFT][index & (ELEMENTS_PER_CHUNK - 1)];
+    }
+
+    const ElementT &operator[](const std::size_t index) const
+    {
+        return chunks[index >> CHUNK_SHIFT][index & (ELEMENTS_PER_CHUNK - 1)];
+    }
+
+    ElementT &back()
+    {
+        BOOST_ASSERT(!empty());
+        return (*this)[current_size - 1];
+    }
+
+    iterator begin() { return iterator(0, chunks.data()); }
+    iterator end() { return iterator(current_size, chunks.data()); }
+    const_iterator begin() const { return const_iterator(0, chunks.data()); }
+    const_iterator end() const { return const_iterator(current_size, chunks.data()); }
+
+    // Calls function(first_index, first, last) with the elements of every chunk and releases the
+    // chunk after it, so memory is freed while the elements are moved somewhere else. Leaves the
+    // vector empty.
+    template <typename Function> void ConsumeChunks(Function &&function)
+    {
+        for (std::size_t chunk = 0; chunk < chunks.size(); ++chunk)
+        {
+            const auto first_index = chunk << CHUNK_SHIFT;
+            if (first_index < current_size)
+            {
+                const auto chunk_size = std::min(ELEMENTS_PER_CHUNK, current_size - first_index);
+                function(first_index,
+                         static_cast<const ElementT *>(chunks[chunk]),
+                         static_cast<const ElementT *>(chunks[chunk] + chunk_size));
+            }
+            releaseHugePageArena(chunks[chunk], CHUNK_BYTES);
+            chunks[chunk] = nullptr;
+        }
+        clear();
+    }
+
+  private:
+    static constexpr std::size_t CHUNK_BYTES = ELEMENTS_PER_CHUNK * sizeof(ElementT);
+
+    void AddChunk()
+    {
+        chunks.reserve(chunks.size() + 1);
+        chunks.push_back(static_cast<ElementT *>(allocateHugePageArena(CHUNK_BYTES)));
+    }
+
+    std::size_t current_size;
+    std::vector<ElementT *> chunks;
+};
+
+template <typename ElementT> constexpr std::size_t ChunkedVector<ElementT>::CHUNK_SHIFT;
+template <typename ElementT> constexpr std::size_t ChunkedVector<ElementT>::ELEMENTS_PER_CHUNK;
+template <typename ElementT> constexpr std::size_t ChunkedVector<ElementT>::CHUNK_BYTES;
+
+template <typename ElementT> void swap(ChunkedVector<ElementT> &lhs, ChunkedVector<ElementT> &rhs)
+{
+    lhs.swap(rhs);
+}
+}
+}
+
+#endif /* CHUNKED_VECTOR_HPP */
@@ -6,6 +6,7 @@
 #include <boost/optional.hpp>
 
 #include <utility>
+#include <vector>
 
 namespace osrm
 {
@@ -30,6 +31,24 @@ double haversineDistance(const Coordinate first_coordinate, const Coordinate sec
 
 double greatCircleDistance(const Coordinate first_coordinate, const Coordinate second_coordinate);
 
+// Batch versions of the distances and bearings for whole lines and candidate lists. They give the
+// results of the functions for single pairs, but compute the trigonometry of every coordinate
+// once and run the rest as loops without branches over plain arrays, which the compiler
+// vectorizes.
+
+// the haversineDistance of every pair of consecutive coordinates, one less than there are
+void haversineDistances(const std::vector<Coordinate> &coordinates, std::vector<double> &distances);
+
+// the haversineDistance from the source to every target
+void haversineDistances(const Coordinate source,
+                        const std::vector<Coordinate> &targets,
+                        std::vector<double> &distances);
+
+// the greatCircleDistance from the source to every target
+void greatCircleDistances(const Coordinate source,
+                          const std::vector<Coordinate> &targets,
+                          std::vector<double> &distances);
+
 inline std::pair<double, FloatCoordinate> projectPointOnSegment(const FloatCoordinate &source,
                                                                 const FloatCoordinate &target,
                                                                 const FloatCoordinate &coordinate)
@@ -82,6 +101,9 @@ Coordinate centroid(const Coordinate lhs, const Coordinate rhs);
 
 double bearing(const Coordinate first_coordinate, const Coordinate second_coordinate);
 
+// the bearing of every pair of consecutive coordinates, one less than there are
+void bearings(const std::vector<Coordinate> &coordinates, std::vector<double> &bearings);
+
 // Get angle of line segment (A,C)->(C,B)
 double computeAngle(const Coordinate first, const Coordinate second, const Coordinate third);
 
@@ -0,0 +1,30 @@
+#ifndef OSRM_UTIL_CRC32C_HPP
+#define OSRM_UTIL_CRC32C_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace osrm
+{
+namespace util
+{
+
+// CRC-32C (Castagnoli) as computed by the crc32 instructions of SSE 4.2 and ARMv8, without
+// inverting it at the start and the end. That makes it linear, the CRC of data continues with
+// crc32c(crc_of_data, more_data) and the CRCs of parts are combined by crc32cCombine.
+//
+// Uses the instructions of the CPU if it has them, with three independent streams to hide their
+// latency, and tables otherwise.
+std::uint32_t crc32c(std::uint32_t crc, const void *data, std::size_t size);
+
+// The CRC of a followed by b, from the CRCs of a and b and the size of b
+std::uint32_t crc32cCombine(std::uint32_t crc_a, std::uint32_t crc_b, std::uint64_t size_b);
+
+// crc32c(0, data, size) of large data, computed in chunks by all threads
+std::uint32_t parallelCRC32C(const void *data, std::size_t size);
+
+bool isCRC32CInHardware();
+}
+}
+
+#endif // OSRM_UTIL_CRC32C_HPP
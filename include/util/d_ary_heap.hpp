@@ -0,0 +1,314 @@
+#ifndef D_ARY_HEAP_HPP
+#define D_ARY_HEAP_HPP
+
+#include "util/binary_heap.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+namespace detail
+{
+// Allocates blocks that start at a multiple of Alignment, std::allocator only guarantees the
+// alignment of the fundamental types
+template <typename T, std::size_t Alignment> class AlignedAllocator
+{
+  public:
+    using value_type = T;
+    template <typename U> struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    T *allocate(const std::size_t n)
+    {
+        // the allocated block is kept in front of the aligned one to free it
+        const std::size_t size = n * sizeof(T) + Alignment + sizeof(void *);
+        void *const block = ::operator new(size);
+        void *aligned = static_cast<char *>(block) + sizeof(void *);
+        std::size_t space = size - sizeof(void *);
+        std::align(Alignment, n * sizeof(T), aligned, space);
+        BOOST_ASSERT(aligned != nullptr);
+        static_cast<void **>(aligned)[-1] = block;
+        return static_cast<T *>(aligned);
+    }
+
+    void deallocate(T *pointer, const std::size_t)
+    {
+        ::operator delete(reinterpret_cast<void **>(pointer)[-1]);
+    }
+
+    friend bool operator==(const AlignedAllocator &, const AlignedAllocator &) { return true; }
+    friend bool operator!=(const AlignedAllocator &, const AlignedAllocator &) { return false; }
+};
+}
+
+// Implicit d-ary heap with the same interface as BinaryHeap.
+//
+// A wider fan-out makes the heap shallower, which trades a few more comparisons in Downheap
+// for fewer cache misses. The root is stored at position Arity - 1 so that all siblings
+// start at a multiple of Arity. The elements are allocated at the start of a cache line, so
+// a group of 4 children (8 bytes each) never straddles two cache lines.
+template <typename NodeID,
+          typename Key,
+          typename Weight,
+          typename Data,
+          typename IndexStorage = ArrayStorage<NodeID, NodeID>,
+          unsigned Arity = 4>
+class DAryHeap
+{
+    static_assert(Arity >= 2, "a heap needs at least two children per node");
+
+  private:
+    DAryHeap(const DAryHeap &right);
+    void operator=(const DAryHeap &right);
+
+  public:
+    using WeightType = Weight;
+    using DataType = Data;
+
+    explicit DAryHeap(size_t maxID) : node_index(maxID) { Clear(); }
+
+    void Clear()
+    {
+        heap.resize(ROOT);
+        inserted_nodes.clear();
+        node_index.Clear();
+    }
+
+    std::size_t Size() const { return heap.size() - ROOT; }
+
+    bool Empty() const { return 0 == Size(); }
+
+    std::size_t Capacity() const { return node_index.Capacity(); }
+
+    void Insert(NodeID node, Weight weight, const Data &data)
+    {
+        HeapElement element;
+        element.index = static_cast<Key>(inserted_nodes.size());
+        element.weight = weight;
+        const Key key = static_cast<Key>(heap.size());
+        heap.emplace_back(element);
+        inserted_nodes.emplace_back(node, key, weight, data);
+        node_index[node] = element.index;
+        Upheap(key);
+        CheckHeap();
+    }
+
+    Data &GetData(NodeID node)
+    {
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].data;
+    }
+
+    Data const &GetData(NodeID node) const
+    {
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].data;
+    }
+
+    Weight &GetKey(NodeID node)
+    {
+        const Key index = node_index[node];
+        return inserted_nodes[index].weight;
+    }
+
+    bool WasRemoved(const NodeID node) const
+    {
+        BOOST_ASSERT(WasInserted(node));
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].key == REMOVED;
+    }
+
+    // loads the index slot of the node into the cache ahead of a lookup
+    void Prefetch(const NodeID node) const { node_index.Prefetch(node); }
+
+    bool WasInserted(const NodeID node) const
+    {
+        const auto index = node_index.peek_index(node);
+        if (index >= static_cast<decltype(index)>(inserted_nodes.size()))
+        {
+            return false;
+        }
+        return inserted_nodes[index].node == node;
+    }
+
+    NodeID Min() const
+    {
+        BOOST_ASSERT(!Empty());
+        return inserted_nodes[heap[ROOT].index].node;
+    }
+
+    Weight MinKey() const
+    {
+        BOOST_ASSERT(!Empty());
+        return heap[ROOT].weight;
+    }
+
+    NodeID DeleteMin()
+    {
+        BOOST_ASSERT(!Empty());
+        const Key removed_index = heap[ROOT].index;
+        heap[ROOT] = heap.back();
+        heap.pop_back();
+        if (!Empty())
+        {
+            Downheap(ROOT);
+        }
+        inserted_nodes[removed_index].key = REMOVED;
+        CheckHeap();
+        return inserted_nodes[removed_index].node;
+    }
+
+    void DeleteAll()
+    {
+        for (auto i = heap.begin() + ROOT; i != heap.end(); ++i)
+        {
+            inserted_nodes[i->index].key = REMOVED;
+        }
+        heap.resize(ROOT);
+    }
+
+    void DecreaseKey(NodeID node, Weight weight)
+    {
+        BOOST_ASSERT(std::numeric_limits<NodeID>::max() != node);
+        const Key index = node_index.peek_index(node);
+        const Key key = inserted_nodes[index].key;
+
+        inserted_nodes[index].weight = weight;
+        // settled nodes only keep their new weight, like in BinaryHeap
+        if (key == REMOVED)
+        {
+            return;
+        }
+        heap[key].weight = weight;
+        Upheap(key);
+        CheckHeap();
+    }
+
+  private:
+    static constexpr std::size_t CACHE_LINE_SIZE = 64;
+    static constexpr Key ROOT = Arity - 1;
+    // positions below ROOT are never used, so 0 can mark removed nodes like in BinaryHeap
+    static constexpr Key REMOVED = 0;
+
+    class HeapNode
+    {
+      public:
+        HeapNode(NodeID n, Key k, Weight w, Data d) : node(n), key(k), weight(w), data(std::move(d))
+        {
+        }
+
+        NodeID node;
+        Key key;
+        Weight weight;
+        Data data;
+    };
+    struct HeapElement
+    {
+        Key index;
+        Weight weight;
+    };
+
+    std::vector<HeapNode> inserted_nodes;
+    std::vector<HeapElement, detail::AlignedAllocator<HeapElement, CACHE_LINE_SIZE>> heap;
+    IndexStorage node_index;
+
+    static Key FirstChild(const Key key) { return Arity * (key - ROOT + 1); }
+    static Key Parent(const Key key) { return (key - ROOT - 1) / Arity + ROOT; }
+
+    void Downheap(Key key)
+    {
+        const Key dropping_index = heap[key].index;
+        const Weight weight = heap[key].weight;
+        const Key heap_size = static_cast<Key>(heap.size());
+        Key first_child = FirstChild(key);
+        while (first_child < heap_size)
+        {
+            const Key last_child = std::min<Key>(first_child + Arity, heap_size);
+            Key min_child = first_child;
+            for (Key child = first_child + 1; child < last_child; ++child)
+            {
+                if (heap[child].weight < heap[min_child].weight)
+                {
+                    min_child = child;
+                }
+            }
+            if (weight <= heap[min_child].weight)
+            {
+                break;
+            }
+            heap[key] = heap[min_child];
+            inserted_nodes[heap[key].index].key = key;
+            key = min_child;
+            first_child = FirstChild(key);
+        }
+        heap[key].index = dropping_index;
+        heap[key].weight = weight;
+        inserted_nodes[dropping_index].key = key;
+    }
+
+    void Upheap(Key key)
+    {
+        const Key rising_index = heap[key].index;
+        const Weight weight = heap[key].weight;
+        while (key > ROOT)
+        {
+            const Key parent = Parent(key);
+            if (heap[parent].weight <= weight)
+            {
+                break;
+            }
+            heap[key] = heap[parent];
+            inserted_nodes[heap[key].index].key = key;
+            key = parent;
+        }
+        heap[key].index = rising_index;
+        heap[key].weight = weight;
+        inserted_nodes[rising_index].key = key;
+    }
+
+    void CheckHeap()
+    {
+#ifndef NDEBUG
+        for (std::size_t i = ROOT + 1; i < heap.size(); ++i)
+        {
+            BOOST_ASSERT(heap[i].weight >= heap[Parent(i)].weight);
+        }
+#endif
+    }
+};
+
+template <typename NodeID,
+          typename Key,
+          typename Weight,
+          typename Data,
+          typename IndexStorage,
+          unsigned Arity>
+constexpr Key DAryHeap<NodeID, Key, Weight, Data, IndexStorage, Arity>::ROOT;
+
+template <typename NodeID,
+          typename Key,
+          typename Weight,
+          typename Data,
+          typename IndexStorage,
+          unsigned Arity>
+constexpr Key DAryHeap<NodeID, Key, Weight, Data, IndexStorage, Arity>::REMOVED;
+}
+}
+
+#endif // D_ARY_HEAP_HPP
@@ -7,10 +7,13 @@
 
 #include <boost/assert.hpp>
 
+#include <tbb/parallel_for.h>
+
 #include <cstdint>
 
 #include <algorithm>
 #include <atomic>
+#include <iterator>
 #include <limits>
 #include <tuple>
 #include <vector>
@@ -200,6 +203,165 @@ template <typename EdgeDataT> class DynamicGraph
         return EdgeIterator(node.first_edge + node.edges);
     }
 
+    // adds a batch of edges sorted by source in parallel. Invalidates edge iterators for all
+    // source nodes.
+    //
+    // Nodes whose new edges don't fit into the free slots behind their edges are moved to the
+    // end of the edge list, which is grown once for all of them. Nodes without edges are always
+    // moved, their first edge may point into the free slots of another node.
+    template <typename InputEdgeIterator>
+    void InsertEdges(const InputEdgeIterator first, const InputEdgeIterator last)
+    {
+        BOOST_ASSERT(std::is_sorted(first, last, [](const InputEdge &lhs, const InputEdge &rhs) {
+            return lhs.source < rhs.source;
+        }));
+        const std::size_t number_of_new_edges = std::distance(first, last);
+        if (number_of_new_edges == 0)
+        {
+            return;
+        }
+
+        // offsets of the edges of every source node into the batch
+        std::vector<std::size_t> runs;
+        for (const auto index : irange<std::size_t>(0, number_of_new_edges))
+        {
+            if (index == 0 || first[index].source != first[index - 1].source)
+            {
+                runs.push_back(index);
+            }
+        }
+        runs.push_back(number_of_new_edges);
+        const std::size_t number_of_runs = runs.size() - 1;
+
+        // slots every node gets at the end of the edge list, 0 if its new edges fit in place
+        std::vector<EdgeIterator> moved_slots(number_of_runs + 1, 0);
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_runs),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              for (auto run = range.begin(), end = range.end(); run != end; ++run)
+                              {
+                                  const Node &node = node_array[first[runs[run]].source];
+                                  const EdgeIterator count = runs[run + 1] - runs[run];
+                                  const EdgeIterator first_new_edge = node.first_edge + node.edges;
+                                  bool fits = node.edges > 0;
+                                  for (EdgeIterator slot = first_new_edge;
+                                       fits && slot < first_new_edge + count;
+                                       ++slot)
+                                  {
+                                      fits = slot < edge_list.size() && isDummy(slot);
+                                  }
+                                  if (!fits)
+                                  {
+                                      moved_slots[run] = (node.edges + count) * 1.1 + 2;
+                                  }
+                              }
+                          });
+
+        // turn the slot counts into the new first edges of the moved nodes
+        EdgeIterator moved_first_edge = edge_list.size();
+        for (auto &slots : moved_slots)
+        {
+            const EdgeIterator first_edge = moved_first_edge;
+            moved_first_edge += slots;
+            slots = first_edge;
+        }
+        edge_list.resize(moved_first_edge);
+
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_runs),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                for (auto run = range.begin(), end = range.end(); run != end; ++run)
+                {
+                    Node &node = node_array[first[runs[run]].source];
+                    const EdgeIterator count = runs[run + 1] - runs[run];
+                    if (moved_slots[run] != moved_slots[run + 1])
+                    {
+                        const EdgeIterator new_first_edge = moved_slots[run];
+                        for (const auto i : irange(0u, node.edges))
+                        {
+                            edge_list[new_first_edge + i] = edge_list[node.first_edge + i];
+                            makeDummy(node.first_edge + i);
+                        }
+                        for (auto slot = new_first_edge + node.edges + count;
+                             slot < moved_slots[run + 1];
+                             ++slot)
+                        {
+                            makeDummy(slot);
+                        }
+                        node.first_edge = new_first_edge;
+                    }
+                    for (const auto i : irange<EdgeIterator>(0, count))
+                    {
+                        Edge &edge = edge_list[node.first_edge + node.edges + i];
+                        edge.target = first[runs[run] + i].target;
+                        edge.data = first[runs[run] + i].data;
+                    }
+                    node.edges += count;
+                }
+            });
+        number_of_edges += number_of_new_edges;
+    }
+
+    // Moves the edges of all nodes to the front of the edge list, closing the gaps that deleted
+    // and moved edges leave behind, and frees the slots after the last edge. Every node keeps up
+    // to the free slots it would get when moved by InsertEdge, if its gap was that large.
+    // Invalidates all edge iterators.
+    void Compact()
+    {
+        std::vector<NodeIterator> nodes_by_first_edge;
+        nodes_by_first_edge.reserve(number_of_nodes);
+        for (const auto node : irange(0u, number_of_nodes))
+        {
+            if (node_array[node].edges > 0)
+            {
+                nodes_by_first_edge.push_back(node);
+            }
+        }
+        std::sort(nodes_by_first_edge.begin(),
+                  nodes_by_first_edge.end(),
+                  [this](const NodeIterator lhs, const NodeIterator rhs) {
+                      return node_array[lhs].first_edge < node_array[rhs].first_edge;
+                  });
+
+        // edges only move to the front, so no node overwrites edges that are not moved yet
+        EdgeIterator position = 0;
+        for (const auto index : irange<std::size_t>(0, nodes_by_first_edge.size()))
+        {
+            Node &node = node_array[nodes_by_first_edge[index]];
+            BOOST_ASSERT(position <= node.first_edge);
+            for (const auto i : irange(0u, node.edges))
+            {
+                edge_list[position + i] = edge_list[node.first_edge + i];
+            }
+            node.first_edge = position;
+            position += node.edges;
+
+            const EdgeIterator end_of_gap =
+                index + 1 < nodes_by_first_edge.size()
+                    ? node_array[nodes_by_first_edge[index + 1]].first_edge
+                    : static_cast<EdgeIterator>(edge_list.size());
+            const EdgeIterator free_slots =
+                std::min<EdgeIterator>(node.edges * 0.1 + 2, end_of_gap - position);
+            for (const auto slot : irange(position, position + free_slots))
+            {
+                makeDummy(slot);
+            }
+            position += free_slots;
+        }
+
+        // nodes without edges are moved to the end on insertion
+        for (auto &node : node_array)
+        {
+            if (node.edges == 0)
+            {
+                node.first_edge = position;
+            }
+        }
+        edge_list.resize(position);
+    }
+
+    // number of slots in the edge list, including the free ones
+    std::size_t GetEdgeListSize() const { return edge_list.size(); }
+
     // removes an edge. Invalidates edge iterators for the source node
     void DeleteEdge(const NodeIterator source, const EdgeIterator e)
     {
@@ -0,0 +1,182 @@
+#ifndef FLAT_HASH_MAP_HPP
+#define FLAT_HASH_MAP_HPP
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Hash map with open addressing over unsigned integer keys: one array of key and value pairs,
+// linear probing and backward shift deletion, so there are no tombstones. The largest key marks
+// an empty slot and can't be stored. The const methods can be called from any number of threads
+// as long as nobody modifies the map.
+template <typename Key, typename Value> class FlatHashMap
+{
+    static_assert(std::is_unsigned<Key>::value, "keys need to be unsigned integers");
+
+    using Slot = std::pair<Key, Value>;
+
+  public:
+    static constexpr Key EMPTY_KEY = std::numeric_limits<Key>::max();
+
+    FlatHashMap() : slots(MIN_CAPACITY, Slot{EMPTY_KEY, Value{}}), shift(64 - MIN_CAPACITY_BITS)
+    {
+    }
+
+    // the value of the key, nullptr if the key is not in the map
+    const Value *Find(const Key key) const
+    {
+        const auto index = FindIndex(key);
+        return index == NOT_FOUND ? nullptr : &slots[index].second;
+    }
+
+    Value *Find(const Key key)
+    {
+        const auto index = FindIndex(key);
+        return index == NOT_FOUND ? nullptr : &slots[index].second;
+    }
+
+    // Adds the key with the value unless the key is in the map already, returns if it was added
+    bool Insert(const Key key, Value value)
+    {
+        BOOST_ASSERT(key != EMPTY_KEY);
+        if (FindIndex(key) != NOT_FOUND)
+        {
+            return false;
+        }
+        // at most half of the slots are used, so there is always an empty slot to stop a probe
+        if (2 * (size + 1) > slots.size())
+        {
+            Rehash(2 * slots.size());
+        }
+        InsertNew(key, std::move(value));
+        return true;
+    }
+
+    // Removes the key, returns if it was in the map
+    bool Erase(const Key key)
+    {
+        auto index = FindIndex(key);
+        if (index == NOT_FOUND)
+        {
+            return false;
+        }
+
+        // move the following entries of the probe sequence into the hole, if the hole isn't
+        // before their home slot
+        const auto mask = slots.size() - 1;
+        for (auto next = (index + 1) & mask; slots[next].first != EMPTY_KEY;
+             next = (next + 1) & mask)
+        {
+            const auto home = HomeIndex(slots[next].first);
+            if (((next - home) & mask) >= ((next - index) & mask))
+            {
+                slots[index] = std::move(slots[next]);
+                index = next;
+            }
+        }
+        slots[index] = Slot{EMPTY_KEY, Value{}};
+        --size;
+        return true;
+    }
+
+    std::size_t Size() const { return size; }
+
+    bool Empty() const { return size == 0; }
+
+    // Makes room for the number of entries without rehashing
+    void Reserve(const std::size_t number_of_entries)
+    {
+        std::size_t capacity = slots.size();
+        while (2 * number_of_entries > capacity)
+        {
+            capacity *= 2;
+        }
+        if (capacity != slots.size())
+        {
+            Rehash(capacity);
+        }
+    }
+
+  private:
+    static constexpr std::size_t MIN_CAPACITY_BITS = 4;
+    static constexpr std::size_t MIN_CAPACITY = std::size_t{1} << MIN_CAPACITY_BITS;
+    static constexpr std::size_t NOT_FOUND = std::numeric_limits<std::size_t>::max();
+
+    // Fibonacci hashing, the high bits of the product are well mixed even for dense keys
+    std::size_t HomeIndex(const Key key) const
+    {
+        return static_cast<std::size_t>((static_cast<std::uint64_t>(key) *
+                                         UINT64_C(0x9E3779B97F4A7C15)) >>
+                                        shift);
+    }
+
+    std::size_t FindIndex(const Key key) const
+    {
+        const auto mask = slots.size() - 1;
+        for (auto index = HomeIndex(key); slots[index].first != EMPTY_KEY;
+             index = (index + 1) & mask)
+        {
+            if (slots[index].first == key)
+            {
+                return index;
+            }
+        }
+        return NOT_FOUND;
+    }
+
+    void InsertNew(const Key key, Value value)
+    {
+        const auto mask = slots.size() - 1;
+        auto index = HomeIndex(key);
+        while (slots[index].first != EMPTY_KEY)
+        {
+            index = (index + 1) & mask;
+        }
+        slots[index] = Slot{key, std::move(value)};
+        ++size;
+    }
+
+    void Rehash(const std::size_t capacity)
+    {
+        BOOST_ASSERT((capacity & (capacity - 1)) == 0);
+        std::vector<Slot> old_slots(capacity, Slot{EMPTY_KEY, Value{}});
+        old_slots.swap(slots);
+        shift = 64;
+        for (auto bits = capacity; bits > 1; bits /= 2)
+        {
+            --shift;
+        }
+        size = 0;
+        for (auto &slot : old_slots)
+        {
+            if (slot.first != EMPTY_KEY)
+            {
+                InsertNew(slot.first, std::move(slot.second));
+            }
+        }
+    }
+
+    std::vector<Slot> slots;
+    unsigned shift;
+    std::size_t size = 0;
+};
+
+template <typename Key, typename Value> constexpr Key FlatHashMap<Key, Value>::EMPTY_KEY;
+template <typename Key, typename Value>
+constexpr std::size_t FlatHashMap<Key, Value>::MIN_CAPACITY_BITS;
+template <typename Key, typename Value> constexpr std::size_t FlatHashMap<Key, Value>::MIN_CAPACITY;
+template <typename Key, typename Value> constexpr std::size_t FlatHashMap<Key, Value>::NOT_FOUND;
+}
+}
+
+#endif // FLAT_HASH_MAP_HPP
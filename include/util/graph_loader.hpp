@@ -7,6 +7,7 @@
 #include "extractor/restriction.hpp"
 #include "util/exception.hpp"
 #include "util/fingerprint.hpp"
+#include "util/integer_range.hpp"
 #include "util/simple_logger.hpp"
 #include "util/typedefs.hpp"
 
@@ -14,9 +15,13 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 #include <tbb/parallel_sort.h>
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 
 #include <fstream>
 #include <ios>
@@ -81,19 +86,40 @@ NodeID loadNodesFromFile(std::istream &input_stream,
     input_stream.read(reinterpret_cast<char *>(&n), sizeof(NodeID));
     SimpleLogger().Write() << "Importing n = " << n << " nodes ";
 
-    extractor::ExternalMemoryNode current_node;
-    for (NodeID i = 0; i < n; ++i)
+    // the nodes are read a block at a time instead of one by one, and converted on all threads
+    const std::size_t NODE_BLOCK_SIZE = 1024 * 1024;
+    std::vector<extractor::ExternalMemoryNode> block(std::min<std::size_t>(n, NODE_BLOCK_SIZE));
+    const auto first_node = node_array.size();
+    node_array.resize(first_node + n);
+    for (std::size_t block_begin = 0; block_begin < n; block_begin += NODE_BLOCK_SIZE)
     {
-        input_stream.read(reinterpret_cast<char *>(&current_node),
-                          sizeof(extractor::ExternalMemoryNode));
-        node_array.emplace_back(current_node.lon, current_node.lat, current_node.node_id);
-        if (current_node.barrier)
+        const auto block_size = std::min<std::size_t>(NODE_BLOCK_SIZE, n - block_begin);
+        input_stream.read(reinterpret_cast<char *>(block.data()),
+                          block_size * sizeof(extractor::ExternalMemoryNode));
+        if (!input_stream)
         {
-            barrier_node_list.emplace_back(i);
+            throw exception("Nodes of the .osrm are truncated");
         }
-        if (current_node.traffic_lights)
+
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, block_size),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              for (auto index = range.begin(); index != range.end(); ++index)
+                              {
+                                  const auto &node = block[index];
+                                  node_array[first_node + block_begin + index] =
+                                      extractor::QueryNode(node.lon, node.lat, node.node_id);
+                              }
+                          });
+        for (const auto index : irange<std::size_t>(0, block_size))
         {
-            traffic_light_node_list.emplace_back(i);
+            if (block[index].barrier)
+            {
+                barrier_node_list.emplace_back(block_begin + index);
+            }
+            if (block[index].traffic_lights)
+            {
+                traffic_light_node_list.emplace_back(block_begin + index);
+            }
         }
     }
 
@@ -148,10 +174,13 @@ NodeID loadEdgesFromFile(std::istream &input_stream,
     return m;
 }
 
-template <typename NodeT, typename EdgeT>
+// The edges of the .hsgr are split into an array with the data for searches and one with the
+// data for unpacking, see contractor::QueryGraph
+template <typename NodeT, typename SearchEdgeT, typename UnpackEdgeT>
 unsigned readHSGRFromStream(const boost::filesystem::path &hsgr_file,
                             std::vector<NodeT> &node_list,
-                            std::vector<EdgeT> &edge_list,
+                            std::vector<SearchEdgeT> &search_edge_list,
+                            std::vector<UnpackEdgeT> &unpack_edge_list,
                             unsigned *check_sum)
 {
     if (!boost::filesystem::exists(hsgr_file))
@@ -189,11 +218,14 @@ unsigned readHSGRFromStream(const boost::filesystem::path &hsgr_file,
     hsgr_input_stream.read(reinterpret_cast<char *>(&node_list[0]),
                            number_of_nodes * sizeof(NodeT));
 
-    edge_list.resize(number_of_edges);
+    search_edge_list.resize(number_of_edges);
+    unpack_edge_list.resize(number_of_edges);
     if (number_of_edges > 0)
     {
-        hsgr_input_stream.read(reinterpret_cast<char *>(&edge_list[0]),
-                               number_of_edges * sizeof(EdgeT));
+        hsgr_input_stream.read(reinterpret_cast<char *>(&search_edge_list[0]),
+                               number_of_edges * sizeof(SearchEdgeT));
+        hsgr_input_stream.read(reinterpret_cast<char *>(&unpack_edge_list[0]),
+                               number_of_edges * sizeof(UnpackEdgeT));
     }
 
     return number_of_nodes;
@@ -10,6 +10,7 @@
 #include "util/guidance/bearing_class.hpp"
 #include "util/guidance/entry_class.hpp"
 #include "util/simple_logger.hpp"
+#include "util/string_view.hpp"
 
 #include <algorithm>
 #include <string>
@@ -139,14 +140,15 @@ inline bool staysOnRoundabout(const extractor::guidance::TurnInstruction instruc
 // Name Change Logic
 // Used both during Extraction as well as during Post-Processing
 
-inline std::pair<std::string, std::string> getPrefixAndSuffix(const std::string &data)
+inline std::pair<std::string, std::string> getPrefixAndSuffix(const StringView data)
 {
     const auto suffix_pos = data.find_last_of(' ');
-    if (suffix_pos == std::string::npos)
+    if (suffix_pos == StringView::npos)
         return {};
 
     const auto prefix_pos = data.find_first_of(' ');
-    auto result = std::make_pair(data.substr(0, prefix_pos), data.substr(suffix_pos + 1));
+    auto result = std::make_pair(data.substr(0, prefix_pos).to_string(),
+                                 data.substr(suffix_pos + 1).to_string());
     boost::to_lower(result.first);
     boost::to_lower(result.second);
     return result;
@@ -155,10 +157,10 @@ inline std::pair<std::string, std::string> getPrefixAndSuffix(const std::string
 // Note: there is an overload without suffix checking below.
 // (that's the reason we template the suffix table here)
 template <typename SuffixTable>
-inline bool requiresNameAnnounced(const std::string &from_name,
-                                  const std::string &from_ref,
-                                  const std::string &to_name,
-                                  const std::string &to_ref,
+inline bool requiresNameAnnounced(const StringView from_name,
+                                  const StringView from_ref,
+                                  const StringView to_name,
+                                  const StringView to_ref,
                                   const SuffixTable &suffix_table)
 {
     // first is empty and the second is not
@@ -171,11 +173,10 @@ inline bool requiresNameAnnounced(const std::string &from_name,
 
     // check similarity of names
     const auto names_are_empty = from_name.empty() && to_name.empty();
-    const auto name_is_contained =
-        boost::starts_with(from_name, to_name) || boost::starts_with(to_name, from_name);
+    const auto name_is_contained = from_name.starts_with(to_name) || to_name.starts_with(from_name);
 
     const auto checkForPrefixOrSuffixChange = [](
-        const std::string &first, const std::string &second, const SuffixTable &suffix_table) {
+        const StringView first, const StringView second, const SuffixTable &suffix_table) {
 
         const auto first_prefix_and_suffixes = getPrefixAndSuffix(first);
         const auto second_prefix_and_suffixes = getPrefixAndSuffix(second);
@@ -197,11 +198,8 @@ inline bool requiresNameAnnounced(const std::string &from_name,
                 return false;
             if (!checkTable(second_prefix_and_suffixes.first))
                 return false;
-            return !first.compare(getOffset(first_prefix_and_suffixes.first),
-                                  std::string::npos,
-                                  second,
-                                  getOffset(second_prefix_and_suffixes.first),
-                                  std::string::npos);
+            return first.substr(getOffset(first_prefix_and_suffixes.first)) ==
+                   second.substr(getOffset(second_prefix_and_suffixes.first));
         }();
 
         const bool is_suffix_change = [&]() -> bool {
@@ -209,11 +207,9 @@ inline bool requiresNameAnnounced(const std::string &from_name,
                 return false;
             if (!checkTable(second_prefix_and_suffixes.second))
                 return false;
-            return !first.compare(0,
-                                  first.length() - getOffset(first_prefix_and_suffixes.second),
-                                  second,
-                                  0,
-                                  second.length() - getOffset(second_prefix_and_suffixes.second));
+            return first.substr(0, first.length() - getOffset(first_prefix_and_suffixes.second)) ==
+                   second.substr(0,
+                                 second.length() - getOffset(second_prefix_and_suffixes.second));
         }();
 
         return is_prefix_change || is_suffix_change;
@@ -226,7 +222,7 @@ inline bool requiresNameAnnounced(const std::string &from_name,
     const auto refs_are_empty = from_ref.empty() && to_ref.empty();
     const auto ref_is_contained =
         from_ref.empty() || to_ref.empty() ||
-        (from_ref.find(to_ref) != std::string::npos || to_ref.find(from_ref) != std::string::npos);
+        (from_ref.find(to_ref) != StringView::npos || to_ref.find(from_ref) != StringView::npos);
     const auto ref_is_removed = !from_ref.empty() && to_ref.empty();
 
     const auto obvious_change =
@@ -242,10 +238,10 @@ inline bool requiresNameAnnounced(const std::string &from_name,
 }
 
 // Overload without suffix checking
-inline bool requiresNameAnnounced(const std::string &from_name,
-                                  const std::string &from_ref,
-                                  const std::string &to_name,
-                                  const std::string &to_ref)
+inline bool requiresNameAnnounced(const StringView from_name,
+                                  const StringView from_ref,
+                                  const StringView to_name,
+                                  const StringView to_ref)
 {
     // Dummy since we need to provide a SuffixTable but do not have the data for it.
     // (Guidance Post-Processing does not keep the suffix table around at the moment)
@@ -0,0 +1,27 @@
+#ifndef OSRM_UTIL_HTTP_CLIENT_HPP
+#define OSRM_UTIL_HTTP_CLIENT_HPP
+
+#include <string>
+
+namespace osrm
+{
+namespace util
+{
+
+struct HTTPResponse
+{
+    unsigned status;
+    std::string body;
+};
+
+// A blocking HTTP/1.1 GET on a connection of its own, for talking to other osrm-routed instances.
+// Reads and writes time out after timeout seconds, 0 waits forever. Throws util::exception if the
+// server can't be reached or sends no valid reply.
+HTTPResponse httpGet(const std::string &host,
+                     const std::string &port,
+                     const std::string &path,
+                     const double timeout);
+}
+}
+
+#endif // OSRM_UTIL_HTTP_CLIENT_HPP
@@ -0,0 +1,22 @@
+#ifndef HUGE_PAGE_ARENA_HPP
+#define HUGE_PAGE_ARENA_HPP
+
+#include <cstddef>
+
+namespace osrm
+{
+namespace util
+{
+
+// Large blocks of zeroed memory for bulk data like the edge lists of the contraction. On Linux
+// they are mapped anonymously, aligned to 2 MiB and advised to be backed by transparent huge
+// pages, so filling them takes a fault per huge page instead of one per 4 KiB page. Elsewhere
+// they come from the heap. Throws util::exception if the memory can't be allocated.
+void *allocateHugePageArena(const std::size_t size);
+
+// Takes the size the arena was allocated with
+void releaseHugePageArena(void *arena, const std::size_t size);
+}
+}
+
+#endif // HUGE_PAGE_ARENA_HPP
@@ -0,0 +1,63 @@
+#ifndef OSRM_UTIL_ID_BITSET_HPP
+#define OSRM_UTIL_ID_BITSET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// A set of non-negative 64 bit ids like the ids of OSM objects, with a bit for every id. The bits
+// are allocated in pages of 2^20 ids when the first id of a page is added, so a planet needs a bit
+// per id up to the largest one and a small extract only the pages of its ids.
+//
+// Adding ids isn't thread-safe, reading them from several threads is.
+class IdBitset
+{
+  public:
+    void Add(const std::uint64_t id)
+    {
+        const auto page_index = id >> PAGE_BITS;
+        if (page_index >= pages.size())
+        {
+            pages.resize(page_index + 1);
+        }
+        auto &page = pages[page_index];
+        if (!page)
+        {
+            page.reset(new std::uint64_t[WORDS_PER_PAGE]());
+        }
+        auto &word = page[(id & PAGE_MASK) / 64];
+        const auto bit = std::uint64_t{1} << (id % 64);
+        number_of_ids += (word & bit) == 0;
+        word |= bit;
+    }
+
+    bool Contains(const std::uint64_t id) const
+    {
+        const auto page_index = id >> PAGE_BITS;
+        if (page_index >= pages.size() || !pages[page_index])
+        {
+            return false;
+        }
+        return (pages[page_index][(id & PAGE_MASK) / 64] >> (id % 64)) & 1;
+    }
+
+    std::size_t Size() const { return number_of_ids; }
+
+  private:
+    static const constexpr std::uint64_t PAGE_BITS = 20;
+    static const constexpr std::uint64_t PAGE_MASK = (std::uint64_t{1} << PAGE_BITS) - 1;
+    static const constexpr std::size_t WORDS_PER_PAGE = (std::size_t{1} << PAGE_BITS) / 64;
+
+    std::vector<std::unique_ptr<std::uint64_t[]>> pages;
+    std::size_t number_of_ids = 0;
+};
+}
+}
+
+#endif // OSRM_UTIL_ID_BITSET_HPP
@@ -149,12 +149,10 @@ bool serializeVector(std::ofstream &out_stream, const stxxl::vector<simple_type>
 }
 
 template <typename simple_type>
-bool deserializeAdjacencyArray(const std::string &filename,
+bool deserializeAdjacencyArray(std::istream &in_stream,
                                std::vector<std::uint32_t> &offsets,
                                std::vector<simple_type> &data)
 {
-    std::ifstream in_stream(filename, std::ios::binary);
-
     if (!deserializeVector(in_stream, offsets))
         return false;
 
@@ -168,6 +166,15 @@ bool deserializeAdjacencyArray(const std::string &filename,
     return static_cast<bool>(in_stream);
 }
 
+template <typename simple_type>
+bool deserializeAdjacencyArray(const std::string &filename,
+                               std::vector<std::uint32_t> &offsets,
+                               std::vector<simple_type> &data)
+{
+    std::ifstream in_stream(filename, std::ios::binary);
+    return deserializeAdjacencyArray(in_stream, offsets, data);
+}
+
 inline bool serializeFlags(const boost::filesystem::path &path, const std::vector<bool> &flags)
 {
     // TODO this should be replaced with a FILE-based write using error checking
@@ -33,8 +33,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <variant/variant.hpp>
 
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
 #include <string>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -114,6 +117,20 @@ struct Null
 {
 };
 
+/**
+ * JSON text that is rendered as it is.
+ *
+ * The API writes long arrays of numbers like geometries and annotations into one right away
+ * instead of building an Array with a Number for every value. Unwrap the text via its value
+ * member attribute.
+ */
+struct RawJSON
+{
+    RawJSON() = default;
+    RawJSON(std::string value_) : value{std::move(value_)} {}
+    std::string value;
+};
+
 /**
  * Typed Value sum-type implemented as a variant able to represent tree-like JSON structures.
  *
@@ -125,7 +142,122 @@ using Value = mapbox::util::variant<String,
                                     mapbox::util::recursive_wrapper<Array>,
                                     True,
                                     False,
-                                    Null>;
+                                    Null,
+                                    RawJSON>;
+
+/**
+ * The key-value pairs of an Object in the order they were added.
+ *
+ * Objects only have a handful of keys, so looking them up in a vector needs a single allocation
+ * per object instead of one per key for the nodes of a hash map, and keys are rendered in a
+ * predictable order. Offers the parts of the std::unordered_map interface used to build and to
+ * read responses.
+ */
+class ObjectValues
+{
+  public:
+    using value_type = std::pair<std::string, Value>;
+    using iterator = std::vector<value_type>::iterator;
+    using const_iterator = std::vector<value_type>::const_iterator;
+    using size_type = std::vector<value_type>::size_type;
+
+    ObjectValues() = default;
+    ObjectValues(std::initializer_list<value_type> init)
+    {
+        pairs.reserve(init.size());
+        for (const auto &pair : init)
+        {
+            emplace(pair.first, pair.second);
+        }
+    }
+
+    Value &operator[](const std::string &key)
+    {
+        const auto found = find(key);
+        if (found != end())
+        {
+            return found->second;
+        }
+        pairs.emplace_back(key, Value());
+        return pairs.back().second;
+    }
+
+    Value &at(const std::string &key)
+    {
+        const auto found = find(key);
+        if (found == end())
+        {
+            throw std::out_of_range("no JSON value for " + key);
+        }
+        return found->second;
+    }
+
+    const Value &at(const std::string &key) const
+    {
+        const auto found = find(key);
+        if (found == end())
+        {
+            throw std::out_of_range("no JSON value for " + key);
+        }
+        return found->second;
+    }
+
+    iterator find(const std::string &key)
+    {
+        return std::find_if(pairs.begin(), pairs.end(), [&](const value_type &pair) {
+            return pair.first == key;
+        });
+    }
+
+    const_iterator find(const std::string &key) const
+    {
+        return std::find_if(pairs.begin(), pairs.end(), [&](const value_type &pair) {
+            return pair.first == key;
+        });
+    }
+
+    size_type count(const std::string &key) const { return find(key) == end() ? 0 : 1; }
+
+    // keeps the position of a key that is there already, like insert of a map
+    std::pair<iterator, bool> emplace(std::string key, Value value)
+    {
+        const auto found = find(key);
+        if (found != end())
+        {
+            return std::make_pair(found, false);
+        }
+        pairs.emplace_back(std::move(key), std::move(value));
+        return std::make_pair(std::prev(pairs.end()), true);
+    }
+
+    iterator erase(const_iterator position) { return pairs.erase(position); }
+
+    size_type erase(const std::string &key)
+    {
+        const auto found = find(key);
+        if (found == end())
+        {
+            return 0;
+        }
+        pairs.erase(found);
+        return 1;
+    }
+
+    void reserve(const size_type size) { pairs.reserve(size); }
+    void clear() { pairs.clear(); }
+    size_type size() const { return pairs.size(); }
+    bool empty() const { return pairs.empty(); }
+
+    iterator begin() { return pairs.begin(); }
+    iterator end() { return pairs.end(); }
+    const_iterator begin() const { return pairs.begin(); }
+    const_iterator end() const { return pairs.end(); }
+    const_iterator cbegin() const { return pairs.cbegin(); }
+    const_iterator cend() const { return pairs.cend(); }
+
+  private:
+    std::vector<value_type> pairs;
+};
 
 /**
  * Typed Object.
@@ -134,7 +266,7 @@ using Value = mapbox::util::variant<String,
  */
 struct Object
 {
-    std::unordered_map<std::string, Value> values;
+    ObjectValues values;
 };
 
 /**
@@ -123,6 +123,17 @@ struct Comparator : mapbox::util::static_visitor<bool>
         return true;
     }
 
+    // compares the text, the same values written differently are different
+    bool operator()(const RawJSON &lhs, const RawJSON &rhs) const
+    {
+        bool is_same = lhs.value == rhs.value;
+        if (!is_same)
+        {
+            reason = lhs_path + " (= " + lhs.value + ") != " + rhs_path + " (= " + rhs.value + ")";
+        }
+        return is_same;
+    }
+
     bool operator()(const True &, const True &) const { return true; }
     bool operator()(const False &, const False &) const { return true; }
     bool operator()(const Null &, const Null &) const { return true; }
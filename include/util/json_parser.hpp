@@ -0,0 +1,23 @@
+#ifndef OSRM_UTIL_JSON_PARSER_HPP
+#define OSRM_UTIL_JSON_PARSER_HPP
+
+#include "osrm/json_container.hpp"
+
+#include <string>
+
+namespace osrm
+{
+namespace util
+{
+namespace json
+{
+
+// Parses JSON, like the responses of other osrm-routed instances, into the containers the
+// renderer writes. Escapes in strings are resolved, \u escapes into UTF-8. Returns false if the
+// text is no valid JSON.
+bool parse(const std::string &text, Value &value);
+}
+}
+}
+
+#endif // OSRM_UTIL_JSON_PARSER_HPP
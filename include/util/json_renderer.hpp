@@ -9,6 +9,9 @@
 
 #include "osrm/json_container.hpp"
 
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <ostream>
 #include <string>
@@ -73,13 +76,66 @@ struct Renderer
 
     void operator()(const Null &) const { out << "null"; }
 
+    void operator()(const RawJSON &raw) const { out << raw.value; }
+
   private:
     std::ostream &out;
 };
 
-struct ArrayRenderer
+// Writes a number like cast::to_string_with_precision, with up to six decimals and no trailing
+// zeros, but without a stringstream for every number
+template <typename OutputT> void renderNumber(OutputT &out, const double number)
 {
-    explicit ArrayRenderer(std::vector<char> &_out) : out(_out) {}
+    // larger numbers don't fit into 64 bit with their decimals
+    if (!(std::abs(number) < 1e12))
+    {
+        const std::string number_string = cast::to_string_with_precision(number);
+        out.insert(out.end(), number_string.begin(), number_string.end());
+        return;
+    }
+
+    std::int64_t scaled = std::llround(number * 1e6);
+    if (scaled < 0)
+    {
+        out.push_back('-');
+        scaled = -scaled;
+    }
+    std::int64_t integral = scaled / 1000000;
+    std::int64_t fraction = scaled % 1000000;
+
+    // the digits are written backwards from the end of the buffer
+    char buffer[24];
+    char *const end = buffer + sizeof(buffer);
+    char *begin = end;
+
+    int number_of_decimals = 6;
+    while (number_of_decimals > 0 && fraction % 10 == 0)
+    {
+        fraction /= 10;
+        --number_of_decimals;
+    }
+    if (number_of_decimals > 0)
+    {
+        for (int decimal = 0; decimal < number_of_decimals; ++decimal)
+        {
+            *--begin = '0' + fraction % 10;
+            fraction /= 10;
+        }
+        *--begin = '.';
+    }
+    do
+    {
+        *--begin = '0' + integral % 10;
+        integral /= 10;
+    } while (integral > 0);
+
+    out.insert(out.end(), begin, end);
+}
+
+// Renders into a std::vector<char> or std::string
+template <typename OutputT = std::vector<char>> struct ArrayRenderer
+{
+    explicit ArrayRenderer(OutputT &_out) : out(_out) {}
 
     void operator()(const String &string) const
     {
@@ -89,11 +145,7 @@ struct ArrayRenderer
         out.push_back('\"');
     }
 
-    void operator()(const Number &number) const
-    {
-        const std::string number_string = cast::to_string_with_precision(number.value);
-        out.insert(out.end(), number_string.begin(), number_string.end());
-    }
+    void operator()(const Number &number) const { renderNumber(out, number.value); }
 
     void operator()(const Object &object) const
     {
@@ -128,38 +180,37 @@ struct ArrayRenderer
         out.push_back(']');
     }
 
-    void operator()(const True &) const
-    {
-        const std::string temp("true");
-        out.insert(out.end(), temp.begin(), temp.end());
-    }
+    void operator()(const True &) const { append("true"); }
+
+    void operator()(const False &) const { append("false"); }
 
-    void operator()(const False &) const
+    void operator()(const Null &) const { append("null"); }
+
+    void operator()(const RawJSON &raw) const
     {
-        const std::string temp("false");
-        out.insert(out.end(), temp.begin(), temp.end());
+        out.insert(std::end(out), std::begin(raw.value), std::end(raw.value));
     }
 
-    void operator()(const Null &) const
+  private:
+    template <std::size_t N> void append(const char (&literal)[N]) const
     {
-        const std::string temp("null");
-        out.insert(out.end(), temp.begin(), temp.end());
+        out.insert(out.end(), literal, literal + N - 1);
     }
 
-  private:
-    std::vector<char> &out;
+    OutputT &out;
 };
 
-inline void render(std::ostream &out, const Object &object)
+// The objects are rendered in place, without copying them into a Value first
+inline void render(std::ostream &out, const Object &object) { Renderer{out}(object); }
+
+inline void render(std::vector<char> &out, const Object &object)
 {
-    Value value = object;
-    mapbox::util::apply_visitor(Renderer(out), value);
+    ArrayRenderer<std::vector<char>>{out}(object);
 }
 
-inline void render(std::vector<char> &out, const Object &object)
+inline void render(std::string &out, const Object &object)
 {
-    Value value = object;
-    mapbox::util::apply_visitor(ArrayRenderer(out), value);
+    ArrayRenderer<std::string>{out}(object);
 }
 
 } // namespace json
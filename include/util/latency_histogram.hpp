@@ -0,0 +1,158 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace osrm
+{
+namespace util
+{
+
+// Counts durations in buckets that get wider with the duration, like an HdrHistogram: every
+// power of two of microseconds is split into eight buckets, so quantiles are off by less than
+// 12.5% from a microsecond up to a minute. Longer durations end up in the last bucket.
+//
+// Recording is an increment of relaxed atomics on one of a few shards. Threads pick a shard
+// when they first record, so threads that record at once rarely touch the same cache lines.
+class LatencyHistogram
+{
+  public:
+    static constexpr unsigned SUB_BUCKET_BITS = 3;
+    static constexpr unsigned SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    // 2^26us are about 67s
+    static constexpr unsigned MAX_EXPONENT = 26;
+    static constexpr std::size_t NUMBER_OF_BUCKETS =
+        (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    // The counts of all shards added up
+    struct Snapshot
+    {
+        std::array<std::uint64_t, NUMBER_OF_BUCKETS> counts;
+        std::uint64_t count;
+        std::chrono::nanoseconds sum;
+
+        // upper bound of the bucket the quantile in [0, 1] falls into, 0 if there is no sample
+        std::chrono::microseconds GetQuantile(const double quantile) const
+        {
+            BOOST_ASSERT(quantile >= 0. && quantile <= 1.);
+            if (count == 0)
+            {
+                return std::chrono::microseconds(0);
+            }
+            // the rank of the sample, counted from one
+            const auto rank =
+                std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(quantile * count)));
+            std::uint64_t seen = 0;
+            for (std::size_t bucket = 0; bucket < NUMBER_OF_BUCKETS; ++bucket)
+            {
+                seen += counts[bucket];
+                if (seen >= rank)
+                {
+                    return GetUpperBound(bucket);
+                }
+            }
+            return GetUpperBound(NUMBER_OF_BUCKETS - 1);
+        }
+    };
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    void Record(const std::chrono::nanoseconds duration)
+    {
+        auto &shard = shards[GetShardIndex()];
+        const auto microseconds = static_cast<std::uint64_t>(
+            std::max<std::int64_t>(0, duration.count()) / 1000);
+        shard.counts[GetBucket(microseconds)].fetch_add(1, std::memory_order_relaxed);
+        shard.count.fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(std::max<std::int64_t>(0, duration.count()),
+                            std::memory_order_relaxed);
+    }
+
+    Snapshot GetSnapshot() const
+    {
+        Snapshot snapshot;
+        snapshot.counts.fill(0);
+        snapshot.count = 0;
+        std::uint64_t sum = 0;
+        for (const auto &shard : shards)
+        {
+            for (std::size_t bucket = 0; bucket < NUMBER_OF_BUCKETS; ++bucket)
+            {
+                snapshot.counts[bucket] += shard.counts[bucket].load(std::memory_order_relaxed);
+            }
+            snapshot.count += shard.count.load(std::memory_order_relaxed);
+            sum += shard.sum.load(std::memory_order_relaxed);
+        }
+        snapshot.sum = std::chrono::nanoseconds(sum);
+        return snapshot;
+    }
+
+    // Durations below eight microseconds get a bucket each, above that the three bits after the
+    // highest set bit select one of the eight buckets of its power of two
+    static std::size_t GetBucket(const std::uint64_t microseconds)
+    {
+        if (microseconds < SUB_BUCKETS)
+        {
+            return microseconds;
+        }
+        unsigned exponent = SUB_BUCKET_BITS;
+        while (exponent < MAX_EXPONENT && (microseconds >> (exponent + 1)) != 0)
+        {
+            ++exponent;
+        }
+        if ((microseconds >> (exponent + 1)) != 0)
+        {
+            return NUMBER_OF_BUCKETS - 1;
+        }
+        const auto sub_bucket = (microseconds >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+        return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub_bucket;
+    }
+
+    // the first duration that doesn't fall into the bucket anymore
+    static std::chrono::microseconds GetUpperBound(const std::size_t bucket)
+    {
+        BOOST_ASSERT(bucket < NUMBER_OF_BUCKETS);
+        if (bucket < SUB_BUCKETS)
+        {
+            return std::chrono::microseconds(bucket + 1);
+        }
+        const unsigned exponent = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+        const std::uint64_t sub_bucket = bucket % SUB_BUCKETS;
+        return std::chrono::microseconds((SUB_BUCKETS + sub_bucket + 1)
+                                         << (exponent - SUB_BUCKET_BITS));
+    }
+
+  private:
+    static constexpr std::size_t NUMBER_OF_SHARDS = 8;
+
+    struct alignas(64) Shard
+    {
+        std::array<std::atomic<std::uint64_t>, NUMBER_OF_BUCKETS> counts{};
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> sum{0};
+    };
+
+    static std::size_t GetShardIndex()
+    {
+        static std::atomic<std::size_t> next_shard{0};
+        thread_local const std::size_t shard =
+            next_shard.fetch_add(1, std::memory_order_relaxed) % NUMBER_OF_SHARDS;
+        return shard;
+    }
+
+    std::array<Shard, NUMBER_OF_SHARDS> shards;
+};
+}
+}
+
+#endif // LATENCY_HISTOGRAM_HPP
@@ -5,6 +5,7 @@
 #include <iterator>
 #include <vector>
 
+#include "util/integer_range.hpp"
 #include "util/typedefs.hpp"
 
 namespace osrm
@@ -15,37 +16,51 @@ namespace util
 // This Wrapper provides all methods that are needed for extractor::TarjanSCC, when the graph is
 // given in a
 // matrix representation (e.g. as output from a distance table call)
+//
+// The valid entries of the matrix are kept as an adjacency array, the edges of a node are the
+// columns of its row that aren't INVALID_EDGE_WEIGHT.
 
 template <typename T> class MatrixGraphWrapper
 {
   public:
-    MatrixGraphWrapper(std::vector<T> table, const std::size_t number_of_nodes)
-        : table_(std::move(table)), number_of_nodes_(number_of_nodes)
-    {
-    }
-
-    std::size_t GetNumberOfNodes() const { return number_of_nodes_; }
+    using EdgeRange = range<EdgeID>;
 
-    std::vector<T> GetAdjacentEdgeRange(const NodeID node) const
+    MatrixGraphWrapper(const std::vector<T> &table, const std::size_t number_of_nodes)
+        : number_of_nodes_(number_of_nodes)
     {
-
-        std::vector<T> edges;
-        // find all valid adjacent edges and move to vector `edges`
-        for (std::size_t i = 0; i < number_of_nodes_; ++i)
+        offsets_.reserve(number_of_nodes_ + 1);
+        offsets_.push_back(0);
+        for (std::size_t node = 0; node < number_of_nodes_; ++node)
         {
-            if (*(std::begin(table_) + node * number_of_nodes_ + i) != INVALID_EDGE_WEIGHT)
+            const auto row = std::begin(table) + node * number_of_nodes_;
+            for (std::size_t i = 0; i < number_of_nodes_; ++i)
             {
-                edges.push_back(i);
+                if (*(row + i) != INVALID_EDGE_WEIGHT)
+                {
+                    targets_.push_back(i);
+                }
             }
+            offsets_.push_back(targets_.size());
         }
-        return edges;
     }
 
-    EdgeWeight GetTarget(const EdgeWeight edge) const { return edge; }
+    std::size_t GetNumberOfNodes() const { return number_of_nodes_; }
+
+    EdgeID BeginEdges(const NodeID node) const { return offsets_[node]; }
+
+    EdgeID EndEdges(const NodeID node) const { return offsets_[node + 1]; }
+
+    EdgeRange GetAdjacentEdgeRange(const NodeID node) const
+    {
+        return irange(BeginEdges(node), EndEdges(node));
+    }
+
+    NodeID GetTarget(const EdgeID edge) const { return targets_[edge]; }
 
   private:
-    const std::vector<T> table_;
     const std::size_t number_of_nodes_;
+    std::vector<EdgeID> offsets_;
+    std::vector<NodeID> targets_;
 };
 }
 }
@@ -5,10 +5,13 @@
 #include "extractor/node_based_edge.hpp"
 #include "util/dynamic_graph.hpp"
 #include "util/graph_utils.hpp"
+#include "util/integer_range.hpp"
 
 #include <tbb/parallel_sort.h>
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 namespace osrm
 {
@@ -21,7 +24,7 @@ struct NodeBasedEdgeData
         : distance(INVALID_EDGE_WEIGHT), edge_id(SPECIAL_NODEID),
           name_id(std::numeric_limits<unsigned>::max()), access_restricted(false), reversed(false),
           roundabout(false), travel_mode(TRAVEL_MODE_INACCESSIBLE),
-          lane_description_id(INVALID_LANE_DESCRIPTIONID)
+          lane_description_id(INVALID_LANE_DESCRIPTIONID), classes(0)
     {
     }
 
@@ -36,7 +39,8 @@ struct NodeBasedEdgeData
                       const LaneDescriptionID lane_description_id)
         : distance(distance), edge_id(edge_id), name_id(name_id),
           access_restricted(access_restricted), reversed(reversed), roundabout(roundabout),
-          startpoint(startpoint), travel_mode(travel_mode), lane_description_id(lane_description_id)
+          startpoint(startpoint), travel_mode(travel_mode),
+          lane_description_id(lane_description_id), classes(0)
     {
     }
 
@@ -50,13 +54,14 @@ struct NodeBasedEdgeData
     extractor::TravelMode travel_mode : 4;
     LaneDescriptionID lane_description_id;
     extractor::guidance::RoadClassification road_classification;
+    extractor::ClassData classes;
 
     bool IsCompatibleTo(const NodeBasedEdgeData &other) const
     {
         return (reversed == other.reversed) && (roundabout == other.roundabout) &&
                (startpoint == other.startpoint) && (access_restricted == other.access_restricted) &&
                (travel_mode == other.travel_mode) &&
-               (road_classification == other.road_classification);
+               (road_classification == other.road_classification) && (classes == other.classes);
     }
 
     bool CanCombineWith(const NodeBasedEdgeData &other) const
@@ -67,6 +72,84 @@ struct NodeBasedEdgeData
 
 using NodeBasedDynamicGraph = DynamicGraph<NodeBasedEdgeData>;
 
+// The node-based graph once GraphCompressor is done with it, the edge expansion and the guidance
+// only read it. The edges of a node are consecutive and their targets are kept apart from their
+// data, so that walking over the edges of a node reads a single short array, and the graph has no
+// free slots for edges that are inserted later.
+class NodeBasedStaticGraph
+{
+  public:
+    using NodeIterator = NodeID;
+    using EdgeIterator = EdgeID;
+    using EdgeData = NodeBasedEdgeData;
+    using EdgeRange = range<EdgeIterator>;
+
+    // Copies the edges of the graph in their order. new_edge_ids maps the edge ids of graph to the
+    // ids here, SPECIAL_EDGEID for its free slots.
+    NodeBasedStaticGraph(const NodeBasedDynamicGraph &graph, std::vector<EdgeID> &new_edge_ids)
+    {
+        const auto number_of_nodes = graph.GetNumberOfNodes();
+        first_edges.reserve(number_of_nodes + 1);
+        targets.reserve(graph.GetNumberOfEdges());
+        edge_data.reserve(graph.GetNumberOfEdges());
+        new_edge_ids.assign(graph.GetEdgeListSize(), SPECIAL_EDGEID);
+        for (const auto node : irange(0u, number_of_nodes))
+        {
+            first_edges.push_back(targets.size());
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                new_edge_ids[edge] = targets.size();
+                targets.push_back(graph.GetTarget(edge));
+                edge_data.push_back(graph.GetEdgeData(edge));
+            }
+        }
+        first_edges.push_back(targets.size());
+    }
+
+    unsigned GetNumberOfNodes() const { return first_edges.size() - 1; }
+
+    unsigned GetNumberOfEdges() const { return targets.size(); }
+
+    unsigned GetOutDegree(const NodeIterator n) const { return EndEdges(n) - BeginEdges(n); }
+
+    // the edges that can be driven along
+    unsigned GetDirectedOutDegree(const NodeIterator n) const
+    {
+        return std::count_if(edge_data.begin() + BeginEdges(n),
+                             edge_data.begin() + EndEdges(n),
+                             [](const EdgeData &data) { return !data.reversed; });
+    }
+
+    NodeIterator GetTarget(const EdgeIterator e) const { return targets[e]; }
+
+    EdgeData &GetEdgeData(const EdgeIterator e) { return edge_data[e]; }
+
+    const EdgeData &GetEdgeData(const EdgeIterator e) const { return edge_data[e]; }
+
+    EdgeIterator BeginEdges(const NodeIterator n) const { return first_edges[n]; }
+
+    EdgeIterator EndEdges(const NodeIterator n) const { return first_edges[n + 1]; }
+
+    EdgeRange GetAdjacentEdgeRange(const NodeIterator n) const
+    {
+        return irange(BeginEdges(n), EndEdges(n));
+    }
+
+    // the first edge from one node to the other, SPECIAL_EDGEID if there is none
+    EdgeIterator FindEdge(const NodeIterator from, const NodeIterator to) const
+    {
+        const auto begin = targets.begin() + BeginEdges(from);
+        const auto end = targets.begin() + EndEdges(from);
+        const auto iter = std::find(begin, end, to);
+        return iter == end ? SPECIAL_EDGEID : static_cast<EdgeIterator>(iter - targets.begin());
+    }
+
+  private:
+    std::vector<EdgeIterator> first_edges;
+    std::vector<NodeIterator> targets;
+    std::vector<EdgeData> edge_data;
+};
+
 /// Factory method to create NodeBasedDynamicGraph from NodeBasedEdges
 /// Since DynamicGraph expects directed edges, we need to insert
 /// two edges for undirected edges.
@@ -88,6 +171,7 @@ NodeBasedDynamicGraphFromEdges(NodeID number_of_nodes,
             output_edge.data.startpoint = input_edge.startpoint;
             output_edge.data.road_classification = input_edge.road_classification;
             output_edge.data.lane_description_id = input_edge.lane_description_id;
+            output_edge.data.classes = input_edge.classes;
         });
 
     tbb::parallel_sort(edges_list.begin(), edges_list.end());
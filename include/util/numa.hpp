@@ -0,0 +1,31 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// The CPUs of a NUMA node
+using NUMANode = std::vector<unsigned>;
+
+// Parses a CPU list like "0-7,16-23" as found in /sys/devices/system/node/node*/cpulist
+NUMANode parseCPUList(const std::string &cpu_list);
+
+// The NUMA nodes of the machine with their CPUs. Without NUMA or on systems other than
+// Linux this is a single node with all CPUs.
+std::vector<NUMANode> getNUMANodes();
+
+// Restricts the calling thread to the CPUs of a node. Memory the thread touches first is then
+// allocated on that node by the kernel. Returns false if the thread could not be bound.
+bool bindThreadToNUMANode(const unsigned node_index, const NUMANode &node);
+
+// The index of the node the calling thread was bound to, 0 for threads that are not bound
+unsigned getThreadNUMANode();
+}
+}
+
+#endif // NUMA_HPP
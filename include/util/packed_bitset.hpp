@@ -0,0 +1,65 @@
+#ifndef OSRM_UTIL_PACKED_BITSET_HPP
+#define OSRM_UTIL_PACKED_BITSET_HPP
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace osrm
+{
+namespace util
+{
+
+// A read-only view of a flag per id packed into 64 bit words, like the core markers of the nodes
+// in shared memory. Testing a flag is a shift of the word it shares with 63 other ids, so the
+// flags of a search stay in a few cache lines and the check can be inlined into its hot loops.
+class PackedBitsetView
+{
+  public:
+    using Word = std::uint64_t;
+    static const constexpr std::size_t BITS_PER_WORD = 64;
+
+    PackedBitsetView() : words(nullptr), size(0) {}
+    PackedBitsetView(const Word *words, const std::size_t size) : words(words), size(size) {}
+
+    static std::size_t GetNumberOfWords(const std::size_t size)
+    {
+        return (size + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    }
+
+    // Packs the flags of unpacked, 0 or 1 per id, into the GetNumberOfWords(size) words
+    static void Pack(const char *unpacked, const std::size_t size, Word *words)
+    {
+        for (std::size_t word = 0; word < GetNumberOfWords(size); ++word)
+        {
+            Word value = 0;
+            const auto first = word * BITS_PER_WORD;
+            const auto last = first + BITS_PER_WORD < size ? first + BITS_PER_WORD : size;
+            for (auto index = first; index < last; ++index)
+            {
+                BOOST_ASSERT(unpacked[index] == 0 || unpacked[index] == 1);
+                value |= static_cast<Word>(unpacked[index] == 1) << (index - first);
+            }
+            words[word] = value;
+        }
+    }
+
+    bool Test(const std::size_t index) const
+    {
+        BOOST_ASSERT(index < size);
+        return (words[index / BITS_PER_WORD] >> (index % BITS_PER_WORD)) & 1;
+    }
+
+    std::size_t Size() const { return size; }
+
+    bool Empty() const { return size == 0; }
+
+  private:
+    const Word *words;
+    std::size_t size;
+};
+}
+}
+
+#endif // OSRM_UTIL_PACKED_BITSET_HPP
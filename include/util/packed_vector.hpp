@@ -4,7 +4,12 @@
 #include "util/shared_memory_vector_wrapper.hpp"
 #include "util/typedefs.hpp"
 
-#include <cmath>
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -13,65 +18,48 @@ namespace util
 {
 
 /**
- * Since OSM node IDs are (at the time of writing) not quite yet overflowing 32 bits, and
- * will predictably be containable within 33 bits for a long time, the following packs
- * 64-bit OSM IDs as 33-bit numbers within a 64-bit vector.
+ * Since OSM node IDs are past 33 bits, but will predictably be containable within 34 bits for a
+ * long time, the following packs 64-bit OSM IDs as 34-bit numbers within a 64-bit vector.
  *
- * NOTE: this type is templated for future use, but will require a slight refactor to
- * configure BITSIZE and ELEMSIZE
+ * The elements are stored one after another starting at the lowest bit of a block, an element
+ * that doesn't fit into the rest of a block continues at the lowest bit of the next one. This
+ * keeps the access to an element down to one or two shifts of the blocks it is in.
  */
-template <typename T, bool UseSharedMemory = false> class PackedVector
+template <typename T, bool UseSharedMemory = false, std::size_t BITSIZE = 34> class PackedVector
 {
-    static const constexpr std::size_t BITSIZE = 33;
     static const constexpr std::size_t ELEMSIZE = 64;
-    static const constexpr std::size_t PACKSIZE = BITSIZE * ELEMSIZE;
+    static const constexpr std::uint64_t MASK = (std::uint64_t{1} << BITSIZE) - 1;
+
+    static_assert(BITSIZE > 0 && BITSIZE < ELEMSIZE, "elements need to fit into a block");
 
   public:
     /**
      * Returns the size of the packed vector datastructure with `elements` packed elements (the size
-     * of
-     * its underlying uint64 vector)
+     * of its underlying uint64 vector)
      */
     inline static std::size_t elements_to_blocks(std::size_t elements)
     {
-        return std::ceil(static_cast<double>(elements) * BITSIZE / ELEMSIZE);
+        return (elements * BITSIZE + ELEMSIZE - 1) / ELEMSIZE;
     }
 
     void push_back(T incoming_node_id)
     {
-        std::uint64_t node_id = static_cast<std::uint64_t>(incoming_node_id);
-
         // mask incoming values, just in case they are > bitsize
-        const std::uint64_t incoming_mask = static_cast<std::uint64_t>(pow(2, BITSIZE)) - 1;
-        node_id = node_id & incoming_mask;
-
-        const std::size_t available = (PACKSIZE - BITSIZE * num_elements) % ELEMSIZE;
+        const std::uint64_t node_id = static_cast<std::uint64_t>(incoming_node_id) & MASK;
 
-        if (available == 0)
+        const std::size_t offset = (num_elements * BITSIZE) % ELEMSIZE;
+        if (offset == 0)
         {
-            // insert ID at the left side of this element
-            std::uint64_t at_left = node_id << (ELEMSIZE - BITSIZE);
-
-            add_last_elem(at_left);
-        }
-        else if (available >= BITSIZE)
-        {
-            // insert ID somewhere in the middle of this element; ID can be contained
-            // entirely within one element
-            const std::uint64_t shifted = node_id << (available - BITSIZE);
-
-            replace_last_elem(vec_back() | shifted);
+            add_last_elem(node_id);
         }
         else
         {
-            // ID will be split between the end of this element and the beginning
-            // of the next element
-            const std::uint64_t left = node_id >> (BITSIZE - available);
-
-            std::uint64_t right = node_id << (ELEMSIZE - (BITSIZE - available));
-
-            replace_last_elem(vec_back() | left);
-            add_last_elem(right);
+            replace_last_elem(vec_back() | (node_id << offset));
+            if (offset + BITSIZE > ELEMSIZE)
+            {
+                // ID is split between the end of this element and the beginning of the next
+                add_last_elem(node_id >> (ELEMSIZE - offset));
+            }
         }
 
         num_elements++;
@@ -81,41 +69,45 @@ template <typename T, bool UseSharedMemory = false> class PackedVector
     {
         BOOST_ASSERT(a_index < num_elements);
 
-        const std::size_t pack_group = trunc(a_index / ELEMSIZE);
-        const std::size_t pack_index = (a_index + ELEMSIZE) % ELEMSIZE;
-        const std::size_t left_index = (PACKSIZE - BITSIZE * pack_index) % ELEMSIZE;
-
-        const bool back_half = pack_index >= BITSIZE;
-        const std::size_t index = pack_group * BITSIZE + trunc(pack_index / BITSIZE) +
-                                  trunc((pack_index - back_half) / 2);
+        const std::size_t bit_index = a_index * BITSIZE;
+        const std::size_t index = bit_index / ELEMSIZE;
+        const std::size_t offset = bit_index % ELEMSIZE;
 
         BOOST_ASSERT(index < vec.size());
-        const std::uint64_t elem = static_cast<std::uint64_t>(vec.at(index));
-
-        if (left_index == 0)
+        std::uint64_t value = static_cast<std::uint64_t>(vec[index]) >> offset;
+        if (offset + BITSIZE > ELEMSIZE)
         {
-            // ID is at the far left side of this element
-            return T{elem >> (ELEMSIZE - BITSIZE)};
+            BOOST_ASSERT(index + 1 < vec.size());
+            value |= static_cast<std::uint64_t>(vec[index + 1]) << (ELEMSIZE - offset);
         }
-        else if (left_index >= BITSIZE)
+        return T{value & MASK};
+    }
+
+    // Decodes the elements from begin to end into out. ELEMSIZE elements take exactly BITSIZE
+    // blocks, the elements of these groups are unpacked with shifts that are known at compile
+    // time, without branches and without the divisions of at().
+    template <typename OutputIterator>
+    OutputIterator decode_range(std::size_t begin, const std::size_t end, OutputIterator out) const
+    {
+        BOOST_ASSERT(begin <= end && end <= num_elements);
+
+        for (; begin < end && begin % ELEMSIZE != 0; ++begin)
         {
-            // ID is entirely contained within this element
-            const std::uint64_t at_right = elem >> (left_index - BITSIZE);
-            const std::uint64_t left_mask = static_cast<std::uint64_t>(pow(2, BITSIZE)) - 1;
-            return T{at_right & left_mask};
+            *out++ = at(begin);
         }
-        else
-        {
-            // ID is split between this and the next element
-            const std::uint64_t left_mask = static_cast<std::uint64_t>(pow(2, left_index)) - 1;
-            const std::uint64_t left_side = (elem & left_mask) << (BITSIZE - left_index);
 
-            BOOST_ASSERT(index < vec.size() - 1);
-            const std::uint64_t next_elem = static_cast<std::uint64_t>(vec.at(index + 1));
+        for (; begin + ELEMSIZE <= end; begin += ELEMSIZE)
+        {
+            out = decode_group(&vec[begin / ELEMSIZE * BITSIZE],
+                               out,
+                               std::make_index_sequence<ELEMSIZE>{});
+        }
 
-            const std::uint64_t right_side = next_elem >> (ELEMSIZE - (BITSIZE - left_index));
-            return T{left_side | right_side};
+        for (; begin < end; ++begin)
+        {
+            *out++ = at(begin);
         }
+        return out;
     }
 
     std::size_t size() const { return num_elements; }
@@ -139,22 +131,44 @@ template <typename T, bool UseSharedMemory = false> class PackedVector
         num_elements = count;
     }
 
-    std::size_t capacity() const
+    std::size_t capacity() const { return vec.capacity() * ELEMSIZE / BITSIZE; }
+
+  private:
+    template <std::size_t INDEX> static std::uint64_t decode_element(const std::uint64_t *group)
+    {
+        const constexpr std::size_t block = INDEX * BITSIZE / ELEMSIZE;
+        const constexpr std::size_t offset = INDEX * BITSIZE % ELEMSIZE;
+        const std::uint64_t value = group[block] >> offset;
+        // the branch is resolved at compile time, the last element of a group is never split
+        return offset + BITSIZE > ELEMSIZE
+                   ? (value | (group[block + 1] << (ELEMSIZE - offset))) & MASK
+                   : value & MASK;
+    }
+
+    template <typename OutputIterator, std::size_t... INDICES>
+    static OutputIterator decode_group(const std::uint64_t *group,
+                                       OutputIterator out,
+                                       std::index_sequence<INDICES...>)
     {
-        return std::floor(static_cast<double>(vec.capacity()) * ELEMSIZE / BITSIZE);
+        const std::uint64_t values[] = {decode_element<INDICES>(group)...};
+        for (const auto value : values)
+        {
+            *out++ = T{value};
+        }
+        return out;
     }
 
-  private:
     typename util::ShM<std::uint64_t, UseSharedMemory>::vector vec;
 
     std::size_t num_elements = 0;
 
-    signed cursor = -1;
+    // the blocks written in shared memory, where the vector has a fixed size
+    std::size_t num_blocks = 0;
 
     template <bool enabled = UseSharedMemory>
     void replace_last_elem(typename std::enable_if<enabled, std::uint64_t>::type last_elem)
     {
-        vec[cursor] = last_elem;
+        vec[num_blocks - 1] = last_elem;
     }
 
     template <bool enabled = UseSharedMemory>
@@ -166,8 +180,7 @@ template <typename T, bool UseSharedMemory = false> class PackedVector
     template <bool enabled = UseSharedMemory>
     void add_last_elem(typename std::enable_if<enabled, std::uint64_t>::type last_elem)
     {
-        vec[cursor + 1] = last_elem;
-        cursor++;
+        vec[num_blocks++] = last_elem;
     }
 
     template <bool enabled = UseSharedMemory>
@@ -179,7 +192,7 @@ template <typename T, bool UseSharedMemory = false> class PackedVector
     template <bool enabled = UseSharedMemory>
     std::uint64_t vec_back(typename std::enable_if<enabled>::type * = nullptr)
     {
-        return vec[cursor];
+        return vec[num_blocks - 1];
     }
 
     template <bool enabled = UseSharedMemory>
@@ -0,0 +1,38 @@
+#ifndef PAGE_FAULTS_HPP
+#define PAGE_FAULTS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace osrm
+{
+namespace util
+{
+
+// A block of memory that a data facade reads its data from
+struct MemoryRegion
+{
+    const void *data;
+    std::size_t size;
+};
+
+// Asks the kernel to read the pages of a memory-mapped file that overlap the range into the page
+// cache in the background. Does nothing on systems other than Linux.
+void adviseWillNeed(const void *address, const std::size_t size);
+
+// The number of major page faults the calling thread took so far, faults that had to wait for
+// a file to be read from disk. Always 0 on systems other than Linux.
+std::uint64_t getThreadMajorPageFaults();
+
+// Reads a byte of every page of the region with the TBB thread pool, so that the pages are in
+// memory and mapped before queries touch them. Stops early once stop is set.
+void prefaultMemory(const MemoryRegion &region, const std::atomic<bool> &stop);
+
+// Locks the pages of the region into memory. False if that fails, like when it is larger than
+// RLIMIT_MEMLOCK allows, and always on systems other than Linux.
+bool lockMemory(const MemoryRegion &region);
+}
+}
+
+#endif // PAGE_FAULTS_HPP
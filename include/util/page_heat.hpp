@@ -0,0 +1,92 @@
+#ifndef PAGE_HEAT_HPP
+#define PAGE_HEAT_HPP
+
+#include "util/page_faults.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// A block of the data with the name it is reported under
+struct NamedMemoryRegion
+{
+    std::string name;
+    MemoryRegion region;
+};
+
+/**
+ * Samples which pages of the blocks of the data are hot, on a thread of its own.
+ *
+ * On Linux with idle page tracking (/sys/kernel/mm/page_idle/bitmap, which needs CAP_SYS_ADMIN
+ * to see the page frames) the pages of all blocks are marked idle at the start of every
+ * interval, and the pages whose idle bit got cleared by the end were accessed in it. Pages of
+ * hugetlbfs aren't tracked and always count as accessed. Elsewhere it falls back to the pages
+ * mincore reports as resident, which only tells something about memory-mapped files.
+ *
+ * After every interval it logs the share of the pages of every block that were hot in it and
+ * in any interval since the start, the hottest blocks first.
+ */
+class PageHeatSampler
+{
+  public:
+    enum class Mode
+    {
+        Accessed,
+        Resident
+    };
+
+    // called at the start of every interval, the blocks may change between intervals
+    using GetBlocksT = std::function<std::vector<NamedMemoryRegion>()>;
+
+    PageHeatSampler(GetBlocksT get_blocks, const std::chrono::seconds interval);
+    ~PageHeatSampler();
+
+    PageHeatSampler(const PageHeatSampler &) = delete;
+    PageHeatSampler &operator=(const PageHeatSampler &) = delete;
+
+    Mode GetMode() const { return mode; }
+
+    // The pages of the region that are in memory, the first one may start before the region.
+    // None on systems other than Linux.
+    static std::vector<bool> GetResidentPages(const MemoryRegion &region);
+
+  private:
+    struct BlockHeat
+    {
+        std::size_t size = 0;
+        std::uint64_t hot_pages = 0;
+        // of all intervals, reset if the block changes its size
+        std::vector<bool> ever_hot;
+    };
+
+    void Run();
+    // false once stopped
+    bool Wait();
+    void Report(const std::vector<NamedMemoryRegion> &blocks,
+                const std::vector<std::vector<bool>> &hot_pages);
+
+    GetBlocksT get_blocks;
+    const std::chrono::seconds interval;
+    Mode mode;
+    std::map<std::string, BlockHeat> heat;
+
+    std::mutex mutex;
+    std::condition_variable stopped;
+    bool stop = false;
+    std::thread thread;
+};
+}
+}
+
+#endif // PAGE_HEAT_HPP
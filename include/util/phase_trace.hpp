@@ -0,0 +1,110 @@
+#ifndef PHASE_TRACE_HPP
+#define PHASE_TRACE_HPP
+
+#include <boost/filesystem/path.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// The phases of osrm-extract and osrm-contract with what they cost: wall and CPU time, the peak
+// resident memory, the bytes read and written and how busy the threads were. Written as JSON or
+// as a Chrome trace for chrome://tracing once the tool is done, so it shows which phase takes
+// the time and which phase doesn't use the threads.
+//
+// The code of a phase is wrapped into a ScopedPhase, which does nothing unless tracing was
+// enabled. Phases nest, the CPU time and the bytes of a phase include its nested phases. They
+// are measured for the whole process, so phases are meant to be run by the thread that drives
+// the pipeline, with the work they hand to the TBB threads counted in.
+class PhaseTrace
+{
+  public:
+    enum class Format
+    {
+        JSON,
+        Chrome
+    };
+
+    struct Phase
+    {
+        std::string name;
+        unsigned depth;
+        std::chrono::microseconds start;
+        std::chrono::microseconds wall_time;
+        std::chrono::microseconds cpu_time;
+        // the high-water mark of the process at the end of the phase
+        std::uint64_t peak_rss;
+        // passed through read and write calls, memory mapped files don't count
+        std::uint64_t bytes_read;
+        std::uint64_t bytes_written;
+    };
+
+    static PhaseTrace &GetInstance();
+
+    PhaseTrace(const PhaseTrace &) = delete;
+    PhaseTrace &operator=(const PhaseTrace &) = delete;
+
+    // Starts recording the phases, the utilization of a phase is its CPU time shared by the
+    // given number of threads
+    void Enable(const unsigned number_of_threads);
+
+    bool IsEnabled() const { return enabled; }
+
+    // Writes the phases that are done, throws if the file can't be written
+    void Write(const boost::filesystem::path &path, const Format format) const;
+
+    // the format by its name on the command line, false for an unknown name
+    static bool GetFormat(const std::string &name, Format &format);
+
+    // Measures the phase until it goes out of scope, or until Stop is called
+    class ScopedPhase
+    {
+      public:
+        explicit ScopedPhase(std::string name);
+        ~ScopedPhase();
+
+        void Stop();
+
+        ScopedPhase(const ScopedPhase &) = delete;
+        ScopedPhase &operator=(const ScopedPhase &) = delete;
+
+      private:
+        struct Sample
+        {
+            std::chrono::steady_clock::time_point wall;
+            std::chrono::microseconds cpu;
+            std::uint64_t peak_rss;
+            std::uint64_t bytes_read;
+            std::uint64_t bytes_written;
+        };
+        static Sample TakeSample();
+
+        bool running;
+        std::string name;
+        unsigned depth;
+        Sample start;
+    };
+
+  private:
+    PhaseTrace() = default;
+
+    void Record(Phase phase);
+
+    bool enabled = false;
+    unsigned number_of_threads = 1;
+    std::chrono::steady_clock::time_point start;
+    mutable std::mutex mutex;
+    std::vector<Phase> phases;
+};
+}
+}
+
+#endif // PHASE_TRACE_HPP
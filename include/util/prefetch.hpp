@@ -0,0 +1,22 @@
+#ifndef OSRM_UTIL_PREFETCH_HPP
+#define OSRM_UTIL_PREFETCH_HPP
+
+namespace osrm
+{
+namespace util
+{
+
+// Asks the CPU to load the cache line of the address for reading, without waiting for it. Only a
+// hint, it does nothing with compilers that have no builtin for it.
+inline void prefetch(const void *address)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address, 0, 3);
+#else
+    (void)address;
+#endif
+}
+}
+}
+
+#endif // OSRM_UTIL_PREFETCH_HPP
@@ -0,0 +1,121 @@
+#ifndef OSRM_UTIL_QUERY_ARENA_HPP
+#define OSRM_UTIL_QUERY_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// A monotonic arena for the temporaries of the query running on a thread, like the unpacked
+// paths of a route. Allocations take a pointer bump, freeing them does nothing, and the arena
+// is reset once the query is done. The memory of the last query is kept for the next one, so a
+// thread that answers queries of similar sizes doesn't allocate anymore.
+//
+// Engine opens a Scope for every query, containers take the memory of the arena with a
+// QueryAllocator. Their memory must not be used after the query is done.
+class QueryArena
+{
+  public:
+    // Makes the arena of the calling thread the one of its query. The arena is reset when the
+    // outermost scope ends, scopes of nested queries share it.
+    class Scope
+    {
+      public:
+        Scope();
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+    // nullptr outside of a query
+    static QueryArena *Current();
+
+    // Memory of the arena if it is the one of the calling thread, memory of the heap otherwise,
+    // aligned like std::max_align_t. Throws std::bad_alloc.
+    static void *Allocate(QueryArena *arena, const std::size_t bytes);
+    // Frees memory of the heap, memory of an arena stays until the arena is reset
+    static void Deallocate(void *pointer) noexcept;
+
+    // the bytes of the blocks the arena holds
+    std::size_t GetCapacity() const { return capacity; }
+
+    QueryArena() = default;
+    QueryArena(const QueryArena &) = delete;
+    QueryArena &operator=(const QueryArena &) = delete;
+
+  private:
+    // Starts a new block with room for the bytes at least
+    void AllocateBlock(const std::size_t bytes);
+    // Frees all allocations and keeps the memory
+    void Reset();
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::size_t last_block_size = 0;
+    std::size_t capacity = 0;
+    // the free memory of the last block
+    char *position = nullptr;
+    char *end = nullptr;
+};
+
+// An allocator for the containers of the temporaries of a query. It takes the memory of the
+// arena of the query that constructed it, but only on the thread of that query: other threads
+// that take part in the query, like the ones of a parallel loop, allocate from the heap. The
+// memory of one allocator can be freed by any other.
+template <typename T> class QueryAllocator
+{
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types aren't supported");
+
+  public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::true_type;
+
+    QueryAllocator() noexcept : arena(QueryArena::Current()) {}
+    template <typename U>
+    QueryAllocator(const QueryAllocator<U> &other) noexcept : arena(other.arena)
+    {
+    }
+
+    // a copy belongs to the query running where it is copied
+    QueryAllocator select_on_container_copy_construction() const { return QueryAllocator(); }
+
+    T *allocate(const std::size_t n)
+    {
+        if (n > static_cast<std::size_t>(-1) / sizeof(T))
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(QueryArena::Allocate(arena, n * sizeof(T)));
+    }
+
+    void deallocate(T *pointer, const std::size_t) noexcept { QueryArena::Deallocate(pointer); }
+
+  private:
+    template <typename U> friend class QueryAllocator;
+
+    QueryArena *arena;
+};
+
+template <typename T, typename U>
+bool operator==(const QueryAllocator<T> &, const QueryAllocator<U> &) noexcept
+{
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const QueryAllocator<T> &, const QueryAllocator<U> &) noexcept
+{
+    return false;
+}
+}
+}
+
+#endif // OSRM_UTIL_QUERY_ARENA_HPP
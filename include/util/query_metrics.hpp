@@ -0,0 +1,204 @@
+#ifndef QUERY_METRICS_HPP
+#define QUERY_METRICS_HPP
+
+#include "util/latency_histogram.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace osrm
+{
+namespace util
+{
+
+// Latency histograms of the queries of each service, and of the phases the queries spend their
+// time in, so it shows where slow queries come from. osrm-routed serves them on /metrics.
+//
+// Engine wraps every query into a ScopedQuery, and the code of a phase into a ScopedPhase. The
+// phases of a query are added up and recorded once the query is done, each without the time of
+// the phases nested into it, like unpacking in a search. Work that the query hands to other
+// threads is only part of the total. Rendering and compression happen after the query, in the
+// server, which records them directly.
+//
+// The work of the searches of the queries is added up per service as well, so the size of the
+// search spaces can be compared with the durations.
+//
+// Swaps of the dataset in shared memory are timed as well, since the queries that arrive during a
+// swap wait for it: the barriers of osrm-datastore and the mapping of the new dataset. The
+// draining of the queries that still run on the previous one until it is released is timed too,
+// although no query waits for it.
+//
+// The memory outside of the data is accounted as well: the index storage of the search heaps of
+// all heap pools, and the memory that the queries of each service reserve for their large arrays,
+// like the durations of a table, see engine::SearchEngineData::ReserveQueryMemory.
+class QueryMetrics
+{
+  public:
+    enum class Service
+    {
+        Route,
+        RouteBatch,
+        Table,
+        Nearest,
+        Trip,
+        Match,
+        Tile,
+        OneToAll,
+        Isochrone
+    };
+    static constexpr std::size_t NUMBER_OF_SERVICES = 9;
+
+    enum class Phase
+    {
+        Query,
+        Snapping,
+        Search,
+        Unpacking,
+        Guidance,
+        Rendering,
+        Compression
+    };
+    static constexpr std::size_t NUMBER_OF_PHASES = 7;
+
+    // The work of the searches of the queries, see engine::SearchStatistics
+    enum class SearchCounter
+    {
+        SettledNodes,
+        RelaxedEdges,
+        StalledNodes,
+        CoreEntries,
+        UnpackedShortcuts
+    };
+    static constexpr std::size_t NUMBER_OF_SEARCH_COUNTERS = 5;
+
+    // The phases of a swap to the dataset osrm-datastore loaded last
+    enum class SwapPhase
+    {
+        Barriers,
+        Mapping,
+        Draining
+    };
+    static constexpr std::size_t NUMBER_OF_SWAP_PHASES = 3;
+
+    static QueryMetrics &GetInstance();
+
+    QueryMetrics(const QueryMetrics &) = delete;
+    QueryMetrics &operator=(const QueryMetrics &) = delete;
+
+    void Record(const Service service, const Phase phase, const std::chrono::nanoseconds duration);
+
+    void AddSearchCount(const Service service,
+                        const SearchCounter counter,
+                        const std::uint64_t count);
+
+    // Counts the major page faults queries took on r-tree leaves that were not in memory
+    void AddLeafPageFaults(const std::uint64_t number_of_faults);
+
+    // Counts a set of search heaps that a query checked out of the heap pool of its engine
+    void AddHeapCheckout(const bool reused);
+
+    // Counts the search heaps that queries allocated, or grew for a larger graph
+    void AddHeapAllocations(const std::uint64_t number_of_allocations);
+
+    // Adds to the bytes of the search heaps, negative for heaps that were replaced or freed
+    void AddHeapMemory(const std::int64_t bytes);
+
+    // Adds to the bytes that the running queries of a service reserved, negative once they are
+    // done
+    void AddQueryMemory(const Service service, const std::int64_t bytes);
+
+    // Records the bytes that a query reserved in total once it is done, and whether it was
+    // rejected for needing more than its limit
+    void RecordQueryMemory(const Service service, const std::uint64_t bytes, const bool rejected);
+
+    void RecordSwap(const SwapPhase phase, const std::chrono::nanoseconds duration);
+
+    // Records how long a query waited for a swap of the dataset before it could start
+    void RecordSwapStall(const std::chrono::nanoseconds duration);
+
+    // the service by its name in URLs, false for an unknown name
+    static bool GetService(const std::string &name, Service &service);
+
+    static const char *GetServiceName(const Service service);
+
+    static const char *GetPhaseName(const Phase phase);
+
+    // The service of the query that runs on the calling thread and the innermost phase it is in,
+    // Phase::Query outside of the other phases. False outside of a query. Only reads thread
+    // locals, so the SamplingProfiler calls it from its signal handler.
+    static bool GetCurrentQuery(Service &service, Phase &phase);
+
+    // All histograms that have samples as summaries in the Prometheus text format
+    void Render(std::string &output) const;
+
+    class ScopedPhase;
+
+    // Measures a query that runs on the calling thread
+    class ScopedQuery
+    {
+      public:
+        explicit ScopedQuery(const Service service);
+        ~ScopedQuery();
+
+        ScopedQuery(const ScopedQuery &) = delete;
+        ScopedQuery &operator=(const ScopedQuery &) = delete;
+
+      private:
+        friend class QueryMetrics;
+        friend class ScopedPhase;
+
+        const Service service;
+        const std::chrono::steady_clock::time_point start;
+        std::array<std::chrono::nanoseconds, NUMBER_OF_PHASES> phases;
+        std::array<bool, NUMBER_OF_PHASES> has_phase;
+        ScopedQuery *const outer_query;
+    };
+
+    // Adds the time until it goes out of scope to a phase of the query running on the thread,
+    // without the time of the phases nested into it. Does nothing outside of a query.
+    class ScopedPhase
+    {
+      public:
+        explicit ScopedPhase(const Phase phase);
+        ~ScopedPhase();
+
+        ScopedPhase(const ScopedPhase &) = delete;
+        ScopedPhase &operator=(const ScopedPhase &) = delete;
+
+      private:
+        friend class QueryMetrics;
+
+        const Phase phase;
+        ScopedQuery *const query;
+        ScopedPhase *const outer_phase;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::nanoseconds nested;
+    };
+
+  private:
+    QueryMetrics() = default;
+
+    std::array<std::array<LatencyHistogram, NUMBER_OF_PHASES>, NUMBER_OF_SERVICES> histograms;
+    std::array<std::array<std::atomic<std::uint64_t>, NUMBER_OF_SEARCH_COUNTERS>,
+               NUMBER_OF_SERVICES>
+        search_counts{};
+    std::array<LatencyHistogram, NUMBER_OF_SWAP_PHASES> swap_histograms;
+    LatencyHistogram swap_stalls;
+    std::atomic<std::uint64_t> leaf_page_faults{0};
+    std::atomic<std::uint64_t> heap_checkouts{0};
+    std::atomic<std::uint64_t> reused_heap_checkouts{0};
+    std::atomic<std::uint64_t> heap_allocations{0};
+    std::atomic<std::int64_t> heap_memory{0};
+    std::array<std::atomic<std::int64_t>, NUMBER_OF_SERVICES> query_memory{};
+    std::array<std::atomic<std::uint64_t>, NUMBER_OF_SERVICES> query_memory_peak{};
+    std::array<std::atomic<std::uint64_t>, NUMBER_OF_SERVICES> query_memory_total{};
+    std::array<std::atomic<std::uint64_t>, NUMBER_OF_SERVICES> query_memory_rejections{};
+};
+}
+}
+
+#endif // QUERY_METRICS_HPP
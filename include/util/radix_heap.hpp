@@ -0,0 +1,279 @@
+#ifndef RADIX_HEAP_HPP
+#define RADIX_HEAP_HPP
+
+#include "util/binary_heap.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Monotone radix heap for integral weights with the same interface as BinaryHeap.
+//
+// Elements are kept in buckets by the highest bit in which their weight differs from the
+// last extracted minimum, so Insert and DecreaseKey are O(1) and DeleteMin is amortized
+// O(log C) for the weight range C. As a monotone queue it requires that no weight smaller
+// than the last removed minimum is inserted, which holds for Dijkstra-style searches.
+// Negative weights (e.g. phantom node offsets) are supported.
+//
+// DecreaseKey re-inserts the element into a lower bucket and leaves the old entry in place;
+// stale entries are recognized by their weight and dropped when their bucket is scanned.
+template <typename NodeID,
+          typename Key,
+          typename Weight,
+          typename Data,
+          typename IndexStorage = ArrayStorage<NodeID, NodeID>>
+class RadixHeap
+{
+    static_assert(std::is_integral<Weight>::value, "radix heap only works on integral weights");
+
+  private:
+    RadixHeap(const RadixHeap &right);
+    void operator=(const RadixHeap &right);
+
+    using UnsignedWeight = typename std::make_unsigned<Weight>::type;
+    static constexpr std::size_t NUM_BUCKETS = sizeof(Weight) * 8 + 1;
+
+  public:
+    using WeightType = Weight;
+    using DataType = Data;
+
+    explicit RadixHeap(size_t maxID) : node_index(maxID) { Clear(); }
+
+    void Clear()
+    {
+        for (auto &bucket : buckets)
+        {
+            bucket.clear();
+        }
+        inserted_nodes.clear();
+        node_index.Clear();
+        last_deleted = 0;
+        size = 0;
+    }
+
+    std::size_t Size() const { return size; }
+
+    bool Empty() const { return 0 == Size(); }
+
+    std::size_t Capacity() const { return node_index.Capacity(); }
+
+    void Insert(NodeID node, Weight weight, const Data &data)
+    {
+        const Key index = static_cast<Key>(inserted_nodes.size());
+        inserted_nodes.emplace_back(node, weight, data);
+        node_index[node] = index;
+        Push(index, weight);
+        ++size;
+    }
+
+    Data &GetData(NodeID node)
+    {
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].data;
+    }
+
+    Data const &GetData(NodeID node) const
+    {
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].data;
+    }
+
+    Weight &GetKey(NodeID node)
+    {
+        const Key index = node_index[node];
+        return inserted_nodes[index].weight;
+    }
+
+    bool WasRemoved(const NodeID node) const
+    {
+        BOOST_ASSERT(WasInserted(node));
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].removed;
+    }
+
+    bool WasInserted(const NodeID node) const
+    {
+        const auto index = node_index.peek_index(node);
+        if (index >= static_cast<decltype(index)>(inserted_nodes.size()))
+        {
+            return false;
+        }
+        return inserted_nodes[index].node == node;
+    }
+
+    NodeID Min() const
+    {
+        BOOST_ASSERT(!Empty());
+        return inserted_nodes[Top()].node;
+    }
+
+    Weight MinKey() const
+    {
+        BOOST_ASSERT(!Empty());
+        return inserted_nodes[Top()].weight;
+    }
+
+    NodeID DeleteMin()
+    {
+        BOOST_ASSERT(!Empty());
+        const Key removed_index = Top();
+        buckets[0].pop_back();
+        inserted_nodes[removed_index].removed = true;
+        --size;
+        return inserted_nodes[removed_index].node;
+    }
+
+    void DeleteAll()
+    {
+        for (auto &bucket : buckets)
+        {
+            for (const auto &element : bucket)
+            {
+                inserted_nodes[element.index].removed = true;
+            }
+            bucket.clear();
+        }
+        size = 0;
+    }
+
+    void DecreaseKey(NodeID node, Weight weight)
+    {
+        BOOST_ASSERT(std::numeric_limits<NodeID>::max() != node);
+        const Key index = node_index.peek_index(node);
+        BOOST_ASSERT(weight <= inserted_nodes[index].weight);
+
+        inserted_nodes[index].weight = weight;
+        // settled nodes only keep their new weight, like in BinaryHeap
+        if (!inserted_nodes[index].removed)
+        {
+            Push(index, weight);
+        }
+    }
+
+  private:
+    struct HeapNode
+    {
+        HeapNode(NodeID n, Weight w, Data d) : node(n), weight(w), data(std::move(d)) {}
+
+        NodeID node;
+        Weight weight;
+        bool removed = false;
+        Data data;
+    };
+    struct BucketElement
+    {
+        Key index;
+        Weight weight;
+    };
+    using Bucket = std::vector<BucketElement>;
+
+    std::vector<HeapNode> inserted_nodes;
+    // mutable since Min()/MinKey() need to redistribute lazily like DeleteMin() does
+    mutable std::array<Bucket, NUM_BUCKETS> buckets;
+    mutable UnsignedWeight last_deleted;
+    std::size_t size;
+    IndexStorage node_index;
+
+    // Maps signed weights to unsigned ones preserving their order
+    static UnsignedWeight ToUnsigned(const Weight weight)
+    {
+        return static_cast<UnsignedWeight>(weight) ^
+               (std::is_signed<Weight>::value
+                    ? static_cast<UnsignedWeight>(std::numeric_limits<Weight>::min())
+                    : UnsignedWeight{0});
+    }
+
+    static std::size_t BucketIndex(const UnsignedWeight weight, const UnsignedWeight last)
+    {
+        UnsignedWeight difference = weight ^ last;
+        std::size_t bucket = 0;
+        while (difference != 0)
+        {
+            difference >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    bool IsStale(const BucketElement &element) const
+    {
+        const auto &node = inserted_nodes[element.index];
+        return node.removed || node.weight != element.weight;
+    }
+
+    void Push(const Key index, const Weight weight)
+    {
+        const auto unsigned_weight = ToUnsigned(weight);
+        BOOST_ASSERT_MSG(unsigned_weight >= last_deleted, "radix heap is not monotone");
+        buckets[BucketIndex(unsigned_weight, last_deleted)].push_back({index, weight});
+    }
+
+    // Makes sure the back of bucket 0 holds a live element with the minimal weight and
+    // returns its index.
+    Key Top() const
+    {
+        auto &front = buckets[0];
+        while (!front.empty() && IsStale(front.back()))
+        {
+            front.pop_back();
+        }
+
+        while (front.empty())
+        {
+            std::size_t bucket = 1;
+            while (buckets[bucket].empty())
+            {
+                ++bucket;
+                BOOST_ASSERT(bucket < NUM_BUCKETS);
+            }
+
+            // all live elements of this bucket have a weight smaller than any element in
+            // the buckets above, so its minimum becomes the new reference point
+            auto &source = buckets[bucket];
+            bool found_live = false;
+            UnsignedWeight new_last = std::numeric_limits<UnsignedWeight>::max();
+            for (const auto &element : source)
+            {
+                if (!IsStale(element))
+                {
+                    found_live = true;
+                    new_last = std::min(new_last, ToUnsigned(element.weight));
+                }
+            }
+
+            if (found_live)
+            {
+                last_deleted = new_last;
+                for (const auto &element : source)
+                {
+                    if (!IsStale(element))
+                    {
+                        buckets[BucketIndex(ToUnsigned(element.weight), last_deleted)]
+                            .push_back(element);
+                    }
+                }
+            }
+            source.clear();
+        }
+
+        return front.back().index;
+    }
+};
+
+template <typename NodeID, typename Key, typename Weight, typename Data, typename IndexStorage>
+constexpr std::size_t RadixHeap<NodeID, Key, Weight, Data, IndexStorage>::NUM_BUCKETS;
+}
+}
+
+#endif // RADIX_HEAP_HPP
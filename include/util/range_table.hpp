@@ -147,15 +147,10 @@ template <unsigned BLOCK_SIZE, bool USE_SHARED_MEMORY> class RangeTable
 
         BOOST_ASSERT(block_idx < diff_blocks.size());
 
-        unsigned begin_idx = 0;
-        unsigned end_idx = 0;
-        begin_idx = block_offsets[block_idx];
         const BlockT &block = diff_blocks[block_idx];
-        if (internal_idx > 0)
-        {
-            begin_idx += PrefixSumAtIndex(internal_idx - 1, block);
-        }
+        const unsigned begin_idx = block_offsets[block_idx] + PrefixSumAtIndex(internal_idx, block);
 
+        unsigned end_idx = 0;
         // next index inside current block
         if (internal_idx < BLOCK_SIZE)
         {
@@ -175,7 +170,8 @@ template <unsigned BLOCK_SIZE, bool USE_SHARED_MEMORY> class RangeTable
     }
 
   private:
-    inline unsigned PrefixSumAtIndex(int index, const BlockT &block) const;
+    // sum of the lengths of the first index entries of the block
+    inline unsigned PrefixSumAtIndex(const unsigned index, const BlockT &block) const;
 
     // contains offset for each differential block
     OffsetContainerT block_offsets;
@@ -184,16 +180,16 @@ template <unsigned BLOCK_SIZE, bool USE_SHARED_MEMORY> class RangeTable
     unsigned sum_lengths;
 };
 
+// The loop always runs over the whole block and masks out the lengths from the index on. With
+// a fixed trip count and no branches the compiler unrolls and vectorizes it.
 template <unsigned BLOCK_SIZE, bool USE_SHARED_MEMORY>
-unsigned RangeTable<BLOCK_SIZE, USE_SHARED_MEMORY>::PrefixSumAtIndex(int index,
+unsigned RangeTable<BLOCK_SIZE, USE_SHARED_MEMORY>::PrefixSumAtIndex(const unsigned index,
                                                                      const BlockT &block) const
 {
-    // this loop looks inefficent, but a modern compiler
-    // will emit nice SIMD here, at least for sensible block sizes. (I checked.)
     unsigned sum = 0;
-    for (int i = 0; i <= index; ++i)
+    for (unsigned i = 0; i < BLOCK_SIZE; ++i)
     {
-        sum += block[i];
+        sum += i < index ? block[i] : 0;
     }
 
     return sum;
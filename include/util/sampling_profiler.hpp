@@ -0,0 +1,69 @@
+#ifndef SAMPLING_PROFILER_HPP
+#define SAMPLING_PROFILER_HPP
+
+#include <boost/filesystem/path.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace osrm
+{
+namespace util
+{
+
+// A sampling profiler built into osrm-routed, for flamegraphs of the production traffic without
+// attaching perf, which needs privileges. While a profile runs, a timer of the CPU time of the
+// process sends SIGPROF to the thread that is running about frequency times per second of CPU
+// time. The handler records the stack of the thread together with the service and the phase of
+// the query it runs, see QueryMetrics::GetCurrentQuery.
+//
+// Once the profile is done the stacks are symbolized and written as collapsed stacks, which
+// flamegraph.pl, inferno and speedscope read: a line per stack with its frames from the root,
+// separated by semicolons, and the number of samples. The service and the phase are the first
+// frames, so the flamegraph splits by them. Frames of functions that are not exported are
+// written as the file and the offset into it, for addr2line.
+//
+// Threads that block SIGPROF are not sampled. One profile runs at a time, the samples are kept
+// in a buffer of fixed size that the handler fills without locks or allocations.
+class SamplingProfiler
+{
+  public:
+    struct Summary
+    {
+        std::uint64_t number_of_samples;
+        // samples that didn't fit into the buffer
+        std::uint64_t number_of_dropped_samples;
+        std::size_t number_of_stacks;
+    };
+
+    static const constexpr unsigned DEFAULT_FREQUENCY = 99;
+
+    static SamplingProfiler &GetInstance();
+
+    SamplingProfiler(const SamplingProfiler &) = delete;
+    SamplingProfiler &operator=(const SamplingProfiler &) = delete;
+
+    // false on platforms without SIGPROF
+    static bool IsAvailable();
+
+    // Samples the threads for the duration and writes the collapsed stacks to the file. Blocks
+    // until the file is written. Returns false without sampling if another profile runs, throws
+    // if the timer can't be set or the file can't be written.
+    bool Profile(const std::chrono::milliseconds duration,
+                 const unsigned frequency,
+                 const boost::filesystem::path &path,
+                 Summary &summary);
+
+    bool IsRunning() const { return running.load(); }
+
+  private:
+    SamplingProfiler() = default;
+
+    std::atomic<bool> running{false};
+};
+}
+}
+
+#endif // SAMPLING_PROFILER_HPP
@@ -0,0 +1,113 @@
+#ifndef OSRM_UTIL_SHARD_MAP_HPP
+#define OSRM_UTIL_SHARD_MAP_HPP
+
+#include "util/coordinate.hpp"
+#include "util/rectangle.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+/**
+ * The regions a network is split into by osrm-shard, each served by an osrm-routed of its own.
+ *
+ * The cores of the shards tile the network. A shard is extracted from its region, which is its
+ * core grown by an overlap, so routes that leave the core for a bit are still found by the shard
+ * alone. Where roads cross from one core into another there are boundary points, which are in the
+ * regions of both shards. The overlay connects the boundary points of every shard with the
+ * durations of the shortest routes between them in that shard, so a route across shards is a
+ * route to a boundary point, a path in the overlay and a route from a boundary point.
+ *
+ * Shard maps are text files with a line per shard, backend, boundary point and overlay edge:
+ *
+ *   shard <index> <core west south east north> <region west south east north>
+ *   backend <shard index> <host>:<port>
+ *   boundary <longitude> <latitude> <shard index> <shard index>
+ *   overlay <shard index> <boundary index> <boundary index> <duration in seconds>
+ */
+class ShardMap
+{
+  public:
+    static const constexpr std::uint32_t INVALID_INDEX = std::numeric_limits<std::uint32_t>::max();
+
+    struct Shard
+    {
+        RectangleInt2D core;
+        RectangleInt2D region;
+        // the osrm-routed that serves the shard
+        std::string host;
+        std::string port;
+    };
+
+    struct BoundaryPoint
+    {
+        Coordinate coordinate;
+        std::uint32_t shards[2];
+    };
+
+    struct OverlayEdge
+    {
+        std::uint32_t shard;
+        std::uint32_t from;
+        std::uint32_t to;
+        double duration;
+    };
+
+    ShardMap() = default;
+
+    // throws util::exception if the file can't be read or isn't a valid shard map
+    explicit ShardMap(const std::string &path);
+
+    void Write(const std::string &path) const;
+
+    void AddShard(const RectangleInt2D &core, const RectangleInt2D &region);
+    void SetBackend(const std::uint32_t shard, const std::string &host, const std::string &port);
+    std::uint32_t AddBoundaryPoint(const Coordinate coordinate,
+                                   const std::uint32_t first_shard,
+                                   const std::uint32_t second_shard);
+    // replaces the overlay edges, which are then looked up by the boundary point they start at
+    void SetOverlay(std::vector<OverlayEdge> edges);
+
+    const std::vector<Shard> &GetShards() const { return shards; }
+    const std::vector<BoundaryPoint> &GetBoundaryPoints() const { return boundary_points; }
+    const std::vector<OverlayEdge> &GetOverlayEdges() const { return overlay_edges; }
+
+    // the boundary points in the region of the shard
+    std::vector<std::uint32_t> GetBoundaryPoints(const std::uint32_t shard) const;
+
+    // the shard whose core contains the coordinate, or with the nearest core
+    std::uint32_t FindShard(const Coordinate coordinate) const;
+
+    bool IsInRegion(const std::uint32_t shard, const Coordinate coordinate) const
+    {
+        return shards[shard].region.Contains(coordinate);
+    }
+
+    // Dijkstra in the overlay that starts at the boundary points with a finite duration. Leaves
+    // the duration of the shortest path to every boundary point in durations, and the overlay
+    // edge it ends with in parent_edges, INVALID_INDEX for the boundary points it starts at.
+    void SearchOverlay(std::vector<double> &durations,
+                       std::vector<std::uint32_t> &parent_edges) const;
+
+    // the overlay edges of the path to the boundary point, from its start point on
+    std::vector<std::uint32_t> GetOverlayPath(const std::vector<std::uint32_t> &parent_edges,
+                                              std::uint32_t boundary_point) const;
+
+  private:
+    std::vector<Shard> shards;
+    std::vector<BoundaryPoint> boundary_points;
+    // sorted by the boundary point they start at
+    std::vector<OverlayEdge> overlay_edges;
+    // the first overlay edge of every boundary point, and one past the last edge
+    std::vector<std::uint32_t> first_overlay_edge;
+};
+}
+}
+
+#endif // OSRM_UTIL_SHARD_MAP_HPP
@@ -0,0 +1,289 @@
+#ifndef OSRM_UTIL_SHARDED_LRU_CACHE_HPP
+#define OSRM_UTIL_SHARDED_LRU_CACHE_HPP
+
+#include <boost/assert.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace osrm
+{
+namespace util
+{
+
+// Every entry of a ShardedLRUCache counts as one towards its capacity
+struct UnitCost
+{
+    template <typename KeyT, typename ValueT>
+    std::size_t operator()(const KeyT &, const ValueT &) const
+    {
+        return 1;
+    }
+};
+
+// Bounded LRU cache that is shared by the threads of an engine or a server.
+//
+// The keys are split into shards by their hash, each with its own lock, so concurrent lookups
+// rarely wait on each other. A shard keeps its entries in a list from the most to the least
+// recently used one with an index by key, and drops the least recently used entries once their
+// cost is above its share of the capacity. An entry costs CostT of its key and value, one by
+// default, or e.g. the bytes of a reply. Caches that need an exact bound use a single shard.
+//
+// Every lookup passes the version of the data that the values were computed on, like the
+// checksum of a dataset. A shard that sees another version drops all its entries. Values that
+// queries go on using after they are evicted should be shared pointers.
+template <typename KeyT,
+          typename ValueT,
+          typename HashT = std::hash<KeyT>,
+          typename VersionT = unsigned,
+          typename CostT = UnitCost>
+class ShardedLRUCache
+{
+  public:
+    using Key = KeyT;
+    using Value = ValueT;
+    using Version = VersionT;
+
+    struct Statistics
+    {
+        std::size_t number_of_entries;
+        std::size_t cost;
+        std::size_t capacity;
+        std::uint64_t hits;
+        std::uint64_t misses;
+        // dropped for the capacity, not for a new version
+        std::uint64_t evictions;
+    };
+
+    static constexpr std::size_t DEFAULT_NUMBER_OF_SHARDS = 16;
+
+    // A capacity of 0 keeps nothing
+    explicit ShardedLRUCache(const std::size_t capacity,
+                             const std::size_t number_of_shards = DEFAULT_NUMBER_OF_SHARDS)
+        : capacity(capacity), shard_capacity((capacity + number_of_shards - 1) / number_of_shards),
+          number_of_shards(number_of_shards), shards(new Shard[number_of_shards]), hits(0),
+          misses(0), evictions(0)
+    {
+        BOOST_ASSERT(number_of_shards > 0);
+    }
+
+    ShardedLRUCache(const ShardedLRUCache &) = delete;
+    ShardedLRUCache &operator=(const ShardedLRUCache &) = delete;
+
+    // Sets the value and returns true if the key is cached
+    bool Get(const Version &version, const Key &key, Value &value)
+    {
+        return Get(version, key, value, [](const Value &) { return true; });
+    }
+
+    // Like Get, but an entry that is_valid rejects, like an expired one, is dropped and missing
+    template <typename ValidT>
+    bool Get(const Version &version, const Key &key, Value &value, const ValidT &is_valid)
+    {
+        auto &shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ResetOutdated(shard, version);
+
+        const auto iter = shard.index.find(key);
+        if (iter == shard.index.end() || !is_valid(iter->second->second))
+        {
+            if (iter != shard.index.end())
+            {
+                Remove(shard, iter->second);
+            }
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        hits.fetch_add(1, std::memory_order_relaxed);
+
+        shard.entries.splice(shard.entries.begin(), shard.entries, iter->second);
+        value = iter->second->second;
+        return true;
+    }
+
+    // The cached value, or a default constructed one like nullptr if there is none
+    Value Get(const Version &version, const Key &key)
+    {
+        Value value{};
+        Get(version, key, value);
+        return value;
+    }
+
+    // Adds the value, or replaces the one of the key, which another thread might have computed
+    // concurrently. A value that costs more than the share of a shard isn't added.
+    void Add(const Version &version, const Key &key, Value value)
+    {
+        const auto cost = CostT{}(key, value);
+        if (cost > shard_capacity)
+        {
+            return;
+        }
+
+        auto &shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ResetOutdated(shard, version);
+
+        const auto iter = shard.index.find(key);
+        if (iter != shard.index.end())
+        {
+            Remove(shard, iter->second);
+        }
+        Insert(shard, key, std::move(value), cost);
+    }
+
+    // The value of the key, made with make_value and added under the lock of the shard if there
+    // is none, so concurrent callers get the same value
+    template <typename MakeT>
+    Value GetOrAdd(const Version &version, const Key &key, const MakeT &make_value)
+    {
+        auto &shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ResetOutdated(shard, version);
+
+        const auto iter = shard.index.find(key);
+        if (iter != shard.index.end())
+        {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            shard.entries.splice(shard.entries.begin(), shard.entries, iter->second);
+            return iter->second->second;
+        }
+        misses.fetch_add(1, std::memory_order_relaxed);
+
+        Value value = make_value();
+        const auto cost = CostT{}(key, value);
+        if (cost <= shard_capacity)
+        {
+            Insert(shard, key, value, cost);
+        }
+        return value;
+    }
+
+    // Drops the entry of the key if should_remove accepts its value
+    template <typename PredicateT>
+    void Remove(const Version &version, const Key &key, const PredicateT &should_remove)
+    {
+        auto &shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ResetOutdated(shard, version);
+
+        const auto iter = shard.index.find(key);
+        if (iter != shard.index.end() && should_remove(iter->second->second))
+        {
+            Remove(shard, iter->second);
+        }
+    }
+
+    std::uint64_t GetNumberOfHits() const { return hits.load(std::memory_order_relaxed); }
+
+    std::uint64_t GetNumberOfMisses() const { return misses.load(std::memory_order_relaxed); }
+
+    std::uint64_t GetNumberOfEvictions() const
+    {
+        return evictions.load(std::memory_order_relaxed);
+    }
+
+    // Share of lookups that were answered from the cache, 0 if there were none
+    double GetHitRate() const
+    {
+        const auto number_of_hits = GetNumberOfHits();
+        const auto number_of_lookups = number_of_hits + GetNumberOfMisses();
+        return number_of_lookups == 0 ? 0. : static_cast<double>(number_of_hits) /
+                                                 static_cast<double>(number_of_lookups);
+    }
+
+    // Locks the shards one after the other
+    Statistics GetStatistics() const
+    {
+        Statistics statistics{0,
+                              0,
+                              capacity,
+                              GetNumberOfHits(),
+                              GetNumberOfMisses(),
+                              GetNumberOfEvictions()};
+        for (std::size_t index = 0; index < number_of_shards; ++index)
+        {
+            std::lock_guard<std::mutex> lock(shards[index].mutex);
+            statistics.number_of_entries += shards[index].entries.size();
+            statistics.cost += shards[index].cost;
+        }
+        return statistics;
+    }
+
+  private:
+    struct Entry
+    {
+        Entry(Key key, Value value, const std::size_t cost)
+            : first(std::move(key)), second(std::move(value)), cost(cost)
+        {
+        }
+
+        Key first;
+        Value second;
+        std::size_t cost;
+    };
+    using EntryList = std::list<Entry>;
+
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        EntryList entries;
+        std::unordered_map<Key, typename EntryList::iterator, HashT> index;
+        std::size_t cost = 0;
+        Version version{};
+    };
+
+    Shard &GetShard(const Key &key) { return shards[HashT{}(key) % number_of_shards]; }
+
+    void Insert(Shard &shard, const Key &key, Value value, const std::size_t cost)
+    {
+        shard.entries.emplace_front(key, std::move(value), cost);
+        shard.index.emplace(key, shard.entries.begin());
+        shard.cost += cost;
+        while (shard.cost > shard_capacity)
+        {
+            Remove(shard, std::prev(shard.entries.end()));
+            evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static void Remove(Shard &shard, const typename EntryList::iterator entry)
+    {
+        shard.cost -= entry->cost;
+        shard.index.erase(entry->first);
+        shard.entries.erase(entry);
+    }
+
+    static void ResetOutdated(Shard &shard, const Version &version)
+    {
+        if (shard.version != version)
+        {
+            shard.entries.clear();
+            shard.index.clear();
+            shard.cost = 0;
+            shard.version = version;
+        }
+    }
+
+    const std::size_t capacity;
+    const std::size_t shard_capacity;
+    const std::size_t number_of_shards;
+    const std::unique_ptr<Shard[]> shards;
+    std::atomic<std::uint64_t> hits;
+    std::atomic<std::uint64_t> misses;
+    std::atomic<std::uint64_t> evictions;
+};
+
+template <typename KeyT, typename ValueT, typename HashT, typename VersionT, typename CostT>
+constexpr std::size_t
+    ShardedLRUCache<KeyT, ValueT, HashT, VersionT, CostT>::DEFAULT_NUMBER_OF_SHARDS;
+}
+}
+
+#endif // OSRM_UTIL_SHARDED_LRU_CACHE_HPP
@@ -42,7 +42,8 @@ class SimpleLogger
     SimpleLogger();
 
     virtual ~SimpleLogger();
-    std::mutex &get_mutex();
+    // held while a line is written, for writers that bypass Write
+    static std::mutex &get_mutex();
     std::ostringstream &Write(LogLevel l = logINFO) noexcept;
 
   private:
@@ -0,0 +1,125 @@
+#ifndef SNAPSHOTS_HPP
+#define SNAPSHOTS_HPP
+
+#include <boost/assert.hpp>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace osrm
+{
+namespace util
+{
+
+// Holds the current version of a value that many threads read at once and that is replaced
+// rarely, like the data a query runs on.
+//
+// Readers pin the current version with Acquire(), which shares the ownership of it and never
+// blocks. Update() publishes a new version and lets go of the previous one, which the last reader
+// that pinned it destroys. The versions live in two slots that take turns being current. A slot
+// counts the readers that are copying its version, so an update only waits for these copies
+// before it lets go of the previous version. The counters of the slots are never freed, so a
+// reader that races with an update can always undo its increment and try again.
+template <typename T> class Snapshots
+{
+    struct Slot
+    {
+        std::shared_ptr<T> value;
+        std::atomic<unsigned> pins{0};
+    };
+
+  public:
+    // Keeps a version alive while it is in scope
+    class Pin
+    {
+      public:
+        Pin() = default;
+        explicit Pin(std::shared_ptr<T> value_) : value(std::move(value_)) {}
+        Pin(const Pin &) = delete;
+        Pin &operator=(const Pin &) = delete;
+        Pin(Pin &&) noexcept = default;
+        Pin &operator=(Pin &&) noexcept = default;
+
+        T &operator*() const
+        {
+            BOOST_ASSERT(value);
+            return *value;
+        }
+        T *operator->() const
+        {
+            BOOST_ASSERT(value);
+            return value.get();
+        }
+        explicit operator bool() const { return value != nullptr; }
+
+      private:
+        std::shared_ptr<T> value;
+    };
+
+    explicit Snapshots(std::unique_ptr<T> initial) : current(0)
+    {
+        BOOST_ASSERT(initial);
+        slots[0].value = std::move(initial);
+    }
+
+    Snapshots(const Snapshots &) = delete;
+    Snapshots &operator=(const Snapshots &) = delete;
+
+    Pin Acquire() const
+    {
+        while (true)
+        {
+            const unsigned index = current.load();
+            Slot &slot = slots[index];
+            slot.pins.fetch_add(1);
+            // An update might have made the other slot current in between and let go of this
+            // version already. Otherwise the update waits for this copy before it does.
+            if (current.load() == index)
+            {
+                Pin pin(slot.value);
+                slot.pins.fetch_sub(1);
+                return pin;
+            }
+            slot.pins.fetch_sub(1);
+        }
+    }
+
+    // Calls update with the current version, which returns the next version or nullptr to
+    // keep the current one. Updates are serialized. The previous version is destroyed here if
+    // nobody pins it, otherwise by the release of its last pin.
+    template <typename UpdateT> void Update(const UpdateT &update)
+    {
+        std::lock_guard<std::mutex> guard(update_mutex);
+        const unsigned index = current.load();
+        std::unique_ptr<T> next_value = update(static_cast<const T &>(*slots[index].value));
+        if (!next_value)
+        {
+            return;
+        }
+
+        Slot &next = slots[1 - index];
+        BOOST_ASSERT(!next.value);
+        next.value = std::move(next_value);
+        current.store(1 - index);
+
+        // only the readers that are copying the previous version right now, not its pins
+        while (slots[index].pins.load() != 0)
+        {
+            std::this_thread::yield();
+        }
+        slots[index].value.reset();
+    }
+
+  private:
+    mutable std::array<Slot, 2> slots;
+    std::atomic<unsigned> current;
+    std::mutex update_mutex;
+};
+}
+}
+
+#endif // SNAPSHOTS_HPP
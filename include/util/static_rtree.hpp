@@ -7,6 +7,8 @@
 #include "util/exception.hpp"
 #include "util/hilbert_value.hpp"
 #include "util/integer_range.hpp"
+#include "util/page_faults.hpp"
+#include "util/query_metrics.hpp"
 #include "util/rectangle.hpp"
 #include "util/shared_memory_vector_wrapper.hpp"
 #include "util/typedefs.hpp"
@@ -25,10 +27,14 @@
 
 #include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstring>
+#include <future>
 #include <limits>
 #include <memory>
 #include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
 // An extended alignment is implementation-defined, so use compiler attributes
@@ -61,15 +67,21 @@ class StaticRTree
     using EdgeData = EdgeDataT;
     using CoordinateList = CoordinateListT;
 
-    static_assert(LEAF_PAGE_SIZE >= sizeof(uint32_t) + sizeof(EdgeDataT), "page size is too small");
+    // the ids and the projected coordinates of the end points of an object and its bearing
+    static constexpr std::uint32_t LEAF_OBJECT_SIZE =
+        2 * sizeof(NodeID) + 4 * sizeof(std::int32_t) + sizeof(std::uint8_t);
+    static_assert(LEAF_PAGE_SIZE >= sizeof(uint32_t) + sizeof(Rectangle) + LEAF_OBJECT_SIZE,
+                  "page size is too small");
     static_assert(((LEAF_PAGE_SIZE - 1) & LEAF_PAGE_SIZE) == 0, "page size is not a power of 2");
     static constexpr std::uint32_t LEAF_NODE_SIZE =
-        (LEAF_PAGE_SIZE - sizeof(uint32_t) - sizeof(Rectangle)) / sizeof(EdgeDataT);
+        (LEAF_PAGE_SIZE - sizeof(uint32_t) - sizeof(Rectangle)) / LEAF_OBJECT_SIZE;
 
     struct CandidateSegment
     {
         Coordinate fixed_projected_coordinate;
         EdgeDataT data;
+        // the bearing from u to v, see bearing::quantize
+        std::uint8_t forward_bearing;
     };
 
     struct TreeIndex
@@ -80,23 +92,110 @@ class StaticRTree
         std::uint32_t is_leaf : 1;
     };
 
+    // The bounding rectangles of the children of a tree node, one array per value, so that the
+    // distances to all children are computed in one loop without touching the children
+    struct ChildRectangles
+    {
+        void Set(const std::uint32_t index, const Rectangle &rectangle)
+        {
+            min_lon[index] = static_cast<std::int32_t>(rectangle.min_lon);
+            max_lon[index] = static_cast<std::int32_t>(rectangle.max_lon);
+            min_lat[index] = static_cast<std::int32_t>(rectangle.min_lat);
+            max_lat[index] = static_cast<std::int32_t>(rectangle.max_lat);
+        }
+
+        Rectangle Get(const std::uint32_t index) const
+        {
+            return Rectangle{FixedLongitude{min_lon[index]},
+                             FixedLongitude{max_lon[index]},
+                             FixedLatitude{min_lat[index]},
+                             FixedLatitude{max_lat[index]}};
+        }
+
+        std::array<std::int32_t, BRANCHING_FACTOR> min_lon;
+        std::array<std::int32_t, BRANCHING_FACTOR> max_lon;
+        std::array<std::int32_t, BRANCHING_FACTOR> min_lat;
+        std::array<std::int32_t, BRANCHING_FACTOR> max_lat;
+    };
+
     struct TreeNode
     {
-        TreeNode() : child_count(0) {}
+        TreeNode() : child_count(0), child_rectangles() {}
         std::uint32_t child_count;
         Rectangle minimum_bounding_rectangle;
         TreeIndex children[BRANCHING_FACTOR];
+        ChildRectangles child_rectangles;
+    };
+
+    // The fixed point Web Mercator coordinates of the end points of the objects of a leaf, so
+    // that queries don't have to look up and project them. One array per value lets the
+    // compiler vectorize the loop over all objects of a leaf.
+    struct ProjectedSegments
+    {
+        std::array<std::int32_t, LEAF_NODE_SIZE> u_lon;
+        std::array<std::int32_t, LEAF_NODE_SIZE> u_lat;
+        std::array<std::int32_t, LEAF_NODE_SIZE> v_lon;
+        std::array<std::int32_t, LEAF_NODE_SIZE> v_lat;
+    };
+
+    // The ids of the end points of the objects of a leaf in the coordinate list, which the
+    // search in a box tests against the unprojected rectangle
+    struct SegmentNodes
+    {
+        std::array<NodeID, LEAF_NODE_SIZE> u;
+        std::array<NodeID, LEAF_NODE_SIZE> v;
     };
 
+    // A leaf only holds what the searches look at for every object. The objects themselves are
+    // stored after the leaves and only read for the candidates that reach the filter, the j-th
+    // object of the i-th leaf is at i * LEAF_NODE_SIZE + j.
     struct ALIGNED(LEAF_PAGE_SIZE) LeafNode
     {
-        LeafNode() : object_count(0), objects() {}
+        LeafNode() : object_count(0), segment_nodes(), projected_segments(), forward_bearings()
+        {
+        }
         std::uint32_t object_count;
         Rectangle minimum_bounding_rectangle;
-        std::array<EdgeDataT, LEAF_NODE_SIZE> objects;
+        SegmentNodes segment_nodes;
+        ProjectedSegments projected_segments;
+        // the quantized bearings from u to v, which bearing filters compare without coordinates
+        std::array<std::uint8_t, LEAF_NODE_SIZE> forward_bearings;
     };
     static_assert(sizeof(LeafNode) == LEAF_PAGE_SIZE, "LeafNode size does not fit the page size");
 
+    // The leaf file starts with this header, padded to a page, and is followed by the leaves and
+    // the objects of all leaves in the order of the leaves
+    struct ALIGNED(LEAF_PAGE_SIZE) LeafFileHeader
+    {
+        std::uint64_t number_of_leaves;
+        std::uint64_t number_of_objects;
+    };
+    static_assert(sizeof(LeafFileHeader) == LEAF_PAGE_SIZE,
+                  "LeafFileHeader size does not fit the page size");
+
+    // The objects of a mapped leaf file in the order of the leaves, for the tools that go over
+    // all segments without searching the tree. Throws if the file is too short for its header.
+    static std::pair<const EdgeDataT *, const EdgeDataT *>
+    GetLeafFileObjects(const void *data, const std::size_t size)
+    {
+        const auto header = static_cast<const LeafFileHeader *>(data);
+        if (size < sizeof(LeafFileHeader) ||
+            size < GetObjectsOffset(*header) + header->number_of_objects * sizeof(EdgeDataT))
+        {
+            throw exception("the leaf file is truncated");
+        }
+        const auto first = reinterpret_cast<const EdgeDataT *>(
+            static_cast<const char *>(data) + GetObjectsOffset(*header));
+        return {first, first + header->number_of_objects};
+    }
+
+    static std::pair<EdgeDataT *, EdgeDataT *> GetLeafFileObjects(void *data,
+                                                                  const std::size_t size)
+    {
+        const auto objects = GetLeafFileObjects(static_cast<const void *>(data), size);
+        return {const_cast<EdgeDataT *>(objects.first), const_cast<EdgeDataT *>(objects.second)};
+    }
+
   private:
     struct WrappedInputElement
     {
@@ -151,12 +250,145 @@ class StaticRTree
         Coordinate fixed_projected_coordinate;
     };
 
+    // A priority queue of candidates on a vector that each thread keeps for its next query,
+    // so that queries don't allocate the queue. A query that runs while another one on the same
+    // thread holds the vector, like one from a filter, starts with an empty one.
+    class CandidateQueue
+    {
+      public:
+        CandidateQueue()
+        {
+            candidates.swap(GetCache());
+            if (candidates.capacity() < INITIAL_CAPACITY)
+            {
+                candidates.reserve(INITIAL_CAPACITY);
+            }
+        }
+
+        ~CandidateQueue()
+        {
+            auto &cache = GetCache();
+            if (candidates.capacity() <= MAX_CACHED_CAPACITY &&
+                candidates.capacity() > cache.capacity())
+            {
+                candidates.clear();
+                candidates.swap(cache);
+            }
+        }
+
+        CandidateQueue(const CandidateQueue &) = delete;
+        CandidateQueue &operator=(const CandidateQueue &) = delete;
+
+        bool empty() const { return candidates.empty(); }
+        const QueryCandidate &top() const { return candidates.front(); }
+
+        void push(const QueryCandidate &candidate)
+        {
+            candidates.push_back(candidate);
+            std::push_heap(candidates.begin(), candidates.end());
+        }
+
+        void pop()
+        {
+            std::pop_heap(candidates.begin(), candidates.end());
+            candidates.pop_back();
+        }
+
+      private:
+        static constexpr std::size_t INITIAL_CAPACITY = 4 * BRANCHING_FACTOR;
+        // queries that had to look far keep their memory to themselves
+        static constexpr std::size_t MAX_CACHED_CAPACITY = 1 << 16;
+
+        static std::vector<QueryCandidate> &GetCache()
+        {
+            thread_local std::vector<QueryCandidate> cache;
+            return cache;
+        }
+
+        std::vector<QueryCandidate> candidates;
+    };
+
+    // The distance of the k-th nearest segment that was queued so far. A search that stops
+    // after k results never gets to candidates that are farther away, so it doesn't need to
+    // queue them. Only valid if every segment counts as a result, so unbounded otherwise.
+    class DistanceBound
+    {
+      public:
+        static constexpr std::size_t UNBOUNDED = std::numeric_limits<std::size_t>::max();
+
+        // nothing is nearer than the nearest zero segments, so that is unbounded as well
+        explicit DistanceBound(const std::size_t max_results_)
+            : max_results(max_results_ == 0 ? UNBOUNDED : max_results_)
+        {
+            if (max_results != UNBOUNDED)
+            {
+                distances.reserve(max_results);
+            }
+        }
+
+        std::uint64_t Get() const
+        {
+            return distances.size() < max_results ? std::numeric_limits<std::uint64_t>::max()
+                                                  : distances.front();
+        }
+
+        // distances must not be larger than Get()
+        void Add(const std::uint64_t squared_distance)
+        {
+            if (max_results == UNBOUNDED)
+            {
+                return;
+            }
+            if (distances.size() == max_results)
+            {
+                std::pop_heap(distances.begin(), distances.end());
+                distances.pop_back();
+            }
+            distances.push_back(squared_distance);
+            std::push_heap(distances.begin(), distances.end());
+        }
+
+      private:
+        const std::size_t max_results;
+        // a max-heap of the distances of the nearest segments
+        std::vector<std::uint64_t> distances;
+    };
+
     typename ShM<TreeNode, UseSharedMemory>::vector m_search_tree;
     const CoordinateListT &m_coordinate_list;
 
     boost::iostreams::mapped_file_source m_leaves_region;
     // read-only view of leaves
     typename ShM<const LeafNode, true>::vector m_leaves;
+    // read-only view of the objects after the leaves
+    typename ShM<const EdgeDataT, true>::vector m_objects;
+    bool prefetch_leaves = false;
+
+    // the leaves that are read ahead when the search reaches the last inner level
+    static constexpr std::uint32_t PREFETCHED_LEAVES = 4;
+
+    // Adds the major page faults a query takes while in scope to the metrics. The inner nodes
+    // are held in memory, so they come from leaves that were not in the page cache.
+    class LeafPageFaultCounter
+    {
+      public:
+        explicit LeafPageFaultCounter(const bool enabled_)
+            : enabled(enabled_), start(enabled ? getThreadMajorPageFaults() : 0)
+        {
+        }
+
+        ~LeafPageFaultCounter()
+        {
+            if (enabled)
+            {
+                QueryMetrics::GetInstance().AddLeafPageFaults(getThreadMajorPageFaults() - start);
+            }
+        }
+
+      private:
+        const bool enabled;
+        const std::uint64_t start;
+    };
 
   public:
     StaticRTree(const StaticRTree &) = delete;
@@ -201,107 +433,111 @@ class StaticRTree
                 }
             });
 
-        // open leaf file
-        boost::filesystem::ofstream leaf_node_file(leaf_node_filename, std::ios::binary);
-
         // sort the hilbert-value representatives
         tbb::parallel_sort(input_wrapper_vector.begin(), input_wrapper_vector.end());
-        std::vector<TreeNode> tree_nodes_in_level;
 
-        // pack M elements into leaf node, write to leaf file and add child index to the parent node
-        uint64_t wrapped_element_index = 0;
-        for (std::uint32_t node_index = 0; wrapped_element_index < element_count; ++node_index)
+        // Pack M elements into each leaf. Blocks of leaves are packed in parallel and written to
+        // the leaf file in one go, the next block is packed while the last one is being written.
+        const std::uint64_t leaf_count = (element_count + LEAF_NODE_SIZE - 1) / LEAF_NODE_SIZE;
+        std::vector<Rectangle> leaf_rectangles(leaf_count);
         {
-            TreeNode current_node;
-            for (std::uint32_t leaf_index = 0;
-                 leaf_index < BRANCHING_FACTOR && wrapped_element_index < element_count;
-                 ++leaf_index)
+            boost::filesystem::ofstream leaf_node_file(leaf_node_filename, std::ios::binary);
+
+            LeafFileHeader header;
+            header.number_of_leaves = leaf_count;
+            header.number_of_objects = element_count;
+            leaf_node_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+            // plain bytes, since vectors don't align the leaves to pages
+            std::vector<char> packed_block(LEAVES_PER_WRITE * sizeof(LeafNode));
+            std::vector<char> written_block(LEAVES_PER_WRITE * sizeof(LeafNode));
+            std::future<void> writing;
+            for (std::uint64_t first_leaf = 0; first_leaf < leaf_count;
+                 first_leaf += LEAVES_PER_WRITE)
             {
-                LeafNode current_leaf;
-                Rectangle &rectangle = current_leaf.minimum_bounding_rectangle;
-                for (std::uint32_t object_index = 0;
-                     object_index < LEAF_NODE_SIZE && wrapped_element_index < element_count;
-                     ++object_index, ++wrapped_element_index)
+                const std::uint64_t block_leaf_count =
+                    std::min(std::uint64_t{LEAVES_PER_WRITE}, leaf_count - first_leaf);
+                tbb::parallel_for(
+                    tbb::blocked_range<std::uint64_t>(0, block_leaf_count),
+                    [&](const tbb::blocked_range<std::uint64_t> &range) {
+                        for (auto block_index = range.begin(), end = range.end();
+                             block_index != end;
+                             ++block_index)
+                        {
+                            const auto leaf_index = first_leaf + block_index;
+                            LeafNode leaf;
+                            PackLeaf(input_data_vector,
+                                     input_wrapper_vector,
+                                     leaf_index * LEAF_NODE_SIZE,
+                                     std::min((leaf_index + 1) * LEAF_NODE_SIZE, element_count),
+                                     leaf);
+                            leaf_rectangles[leaf_index] = leaf.minimum_bounding_rectangle;
+                            std::memcpy(packed_block.data() + block_index * sizeof(LeafNode),
+                                        &leaf,
+                                        sizeof(LeafNode));
+                        }
+                    });
+
+                if (writing.valid())
                 {
-                    const std::uint32_t input_object_index =
-                        input_wrapper_vector[wrapped_element_index].m_array_index;
-                    const EdgeDataT &object = input_data_vector[input_object_index];
-
-                    current_leaf.object_count += 1;
-                    current_leaf.objects[object_index] = object;
-
-                    Coordinate projected_u{
-                        web_mercator::fromWGS84(Coordinate{m_coordinate_list[object.u]})};
-                    Coordinate projected_v{
-                        web_mercator::fromWGS84(Coordinate{m_coordinate_list[object.v]})};
-
-                    BOOST_ASSERT(std::abs(toFloating(projected_u.lon).operator double()) <= 180.);
-                    BOOST_ASSERT(std::abs(toFloating(projected_u.lat).operator double()) <= 180.);
-                    BOOST_ASSERT(std::abs(toFloating(projected_v.lon).operator double()) <= 180.);
-                    BOOST_ASSERT(std::abs(toFloating(projected_v.lat).operator double()) <= 180.);
-
-                    rectangle.min_lon =
-                        std::min(rectangle.min_lon, std::min(projected_u.lon, projected_v.lon));
-                    rectangle.max_lon =
-                        std::max(rectangle.max_lon, std::max(projected_u.lon, projected_v.lon));
-
-                    rectangle.min_lat =
-                        std::min(rectangle.min_lat, std::min(projected_u.lat, projected_v.lat));
-                    rectangle.max_lat =
-                        std::max(rectangle.max_lat, std::max(projected_u.lat, projected_v.lat));
-
-                    BOOST_ASSERT(rectangle.IsValid());
+                    writing.get();
                 }
-
-                // append the leaf node to the current tree node
-                current_node.child_count += 1;
-                current_node.children[leaf_index] =
-                    TreeIndex{node_index * BRANCHING_FACTOR + leaf_index, true};
-                current_node.minimum_bounding_rectangle.MergeBoundingBoxes(
-                    current_leaf.minimum_bounding_rectangle);
-
-                // write leaf_node to leaf node file
-                leaf_node_file.write((char *)&current_leaf, sizeof(current_leaf));
+                packed_block.swap(written_block);
+                writing = std::async(std::launch::async,
+                                     [&leaf_node_file, &written_block, block_leaf_count] {
+                                         leaf_node_file.write(written_block.data(),
+                                                              block_leaf_count * sizeof(LeafNode));
+                                     });
+            }
+            if (writing.valid())
+            {
+                writing.get();
             }
 
-            tree_nodes_in_level.emplace_back(current_node);
-        }
-        leaf_node_file.flush();
-        leaf_node_file.close();
-
-        std::uint32_t processing_level = 0;
-        while (1 < tree_nodes_in_level.size())
-        {
-            std::vector<TreeNode> tree_nodes_in_next_level;
-            std::uint32_t processed_tree_nodes_in_level = 0;
-            while (processed_tree_nodes_in_level < tree_nodes_in_level.size())
+            // the objects of the leaves in the same order, which fills the leaves in turn
+            std::vector<EdgeDataT> objects;
+            objects.reserve(std::min(element_count, LEAVES_PER_WRITE * LEAF_NODE_SIZE));
+            for (std::uint64_t first_object = 0; first_object < element_count;
+                 first_object += LEAVES_PER_WRITE * LEAF_NODE_SIZE)
             {
-                TreeNode parent_node;
-                // pack BRANCHING_FACTOR elements into tree_nodes each
-                for (std::uint32_t current_child_node_index = 0;
-                     current_child_node_index < BRANCHING_FACTOR;
-                     ++current_child_node_index)
+                const auto last_object =
+                    std::min(first_object + LEAVES_PER_WRITE * LEAF_NODE_SIZE, element_count);
+                objects.clear();
+                for (auto index = first_object; index < last_object; ++index)
                 {
-                    if (processed_tree_nodes_in_level < tree_nodes_in_level.size())
-                    {
-                        TreeNode &current_child_node =
-                            tree_nodes_in_level[processed_tree_nodes_in_level];
-                        // add tree node to parent entry
-                        parent_node.children[current_child_node_index] =
-                            TreeIndex{m_search_tree.size(), false};
-                        m_search_tree.emplace_back(current_child_node);
-                        // merge MBRs
-                        parent_node.minimum_bounding_rectangle.MergeBoundingBoxes(
-                            current_child_node.minimum_bounding_rectangle);
-                        // increase counters
-                        ++parent_node.child_count;
-                        ++processed_tree_nodes_in_level;
-                    }
+                    objects.push_back(
+                        input_data_vector[input_wrapper_vector[index].m_array_index]);
                 }
-                tree_nodes_in_next_level.emplace_back(parent_node);
+                leaf_node_file.write(reinterpret_cast<const char *>(objects.data()),
+                                     objects.size() * sizeof(EdgeDataT));
+            }
+            leaf_node_file.flush();
+            if (!leaf_node_file)
+            {
+                throw exception("writing the leaves to " + leaf_node_filename + " failed");
             }
-            tree_nodes_in_level.swap(tree_nodes_in_next_level);
-            ++processing_level;
+        }
+
+        // the lowest level of tree nodes holds the leaves
+        std::vector<TreeNode> tree_nodes_in_level =
+            MakeParents(leaf_count, 0, true, [&leaf_rectangles](const std::uint64_t index) {
+                return leaf_rectangles[index];
+            });
+
+        // Every level is appended to the tree before its parents are built, so a parent
+        // references its children by their position in the tree in the order of the level.
+        while (1 < tree_nodes_in_level.size())
+        {
+            const std::uint64_t first_child_index = m_search_tree.size();
+            m_search_tree.insert(
+                m_search_tree.end(), tree_nodes_in_level.begin(), tree_nodes_in_level.end());
+            tree_nodes_in_level = MakeParents(tree_nodes_in_level.size(),
+                                              first_child_index,
+                                              false,
+                                              [&tree_nodes_in_level](const std::uint64_t index) {
+                                                  return tree_nodes_in_level[index]
+                                                      .minimum_bounding_rectangle;
+                                              });
         }
         BOOST_ASSERT_MSG(tree_nodes_in_level.size() == 1, "tree broken, more than one root node");
         // last remaining entry is the root node, store it
@@ -383,8 +619,12 @@ class StaticRTree
         try
         {
             m_leaves_region.open(leaf_file);
-            std::size_t num_leaves = m_leaves_region.size() / sizeof(LeafNode);
-            m_leaves.reset(reinterpret_cast<const LeafNode *>(m_leaves_region.data()), num_leaves);
+            const auto objects =
+                GetLeafFileObjects(m_leaves_region.data(), m_leaves_region.size());
+            const auto header = reinterpret_cast<const LeafFileHeader *>(m_leaves_region.data());
+            m_leaves.reset(reinterpret_cast<const LeafNode *>(header + 1),
+                           header->number_of_leaves);
+            m_objects.reset(objects.first, objects.second - objects.first);
         }
         catch (const std::exception &exc)
         {
@@ -393,17 +633,33 @@ class StaticRTree
         }
     }
 
+    // The leaves are mapped from their file and read from disk on first access if the file is
+    // not in the page cache, which blocks the query. With prefetching the searches ask the kernel
+    // to read the leaves they are going to visit next in the background, and count the page
+    // faults they still take for the metrics.
+    void SetLeafPrefetching(const bool prefetch_leaves_) { prefetch_leaves = prefetch_leaves_; }
+
+    // The objects in the order of the leaves, for lookups of segments that don't search the tree
+    std::uint64_t GetNumberOfObjects() const { return m_objects.size(); }
+
+    const EdgeDataT &GetObject(const std::uint64_t object_index) const
+    {
+        BOOST_ASSERT(object_index < m_objects.size());
+        return m_objects[object_index];
+    }
+
+    // the mapping of the leaf file
+    MemoryRegion GetLeafRegion() const
+    {
+        return MemoryRegion{m_leaves_region.data(), m_leaves_region.size()};
+    }
+
     /* Returns all features inside the bounding box.
        Rectangle needs to be projected!*/
     std::vector<EdgeDataT> SearchInBox(const Rectangle &search_rectangle) const
     {
-        const Rectangle projected_rectangle{
-            search_rectangle.min_lon,
-            search_rectangle.max_lon,
-            toFixed(FloatLatitude{
-                web_mercator::latToY(toFloating(FixedLatitude(search_rectangle.min_lat)))}),
-            toFixed(FloatLatitude{
-                web_mercator::latToY(toFloating(FixedLatitude(search_rectangle.max_lat)))})};
+        const LeafPageFaultCounter page_fault_counter(prefetch_leaves);
+        const auto projected_rectangle = ProjectRectangle(search_rectangle);
         std::vector<EdgeDataT> results;
 
         std::queue<TreeIndex> traversal_queue;
@@ -418,25 +674,24 @@ class StaticRTree
             {
                 const LeafNode &current_leaf_node = m_leaves[current_tree_index.index];
 
+                const SegmentNodes &nodes = current_leaf_node.segment_nodes;
+
                 for (const auto i : irange(0u, current_leaf_node.object_count))
                 {
-                    const auto &current_edge = current_leaf_node.objects[i];
+                    const auto &u = m_coordinate_list[nodes.u[i]];
+                    const auto &v = m_coordinate_list[nodes.v[i]];
 
                     // we don't need to project the coordinates here,
                     // because we use the unprojected rectangle to test against
-                    const Rectangle bbox{std::min(m_coordinate_list[current_edge.u].lon,
-                                                  m_coordinate_list[current_edge.v].lon),
-                                         std::max(m_coordinate_list[current_edge.u].lon,
-                                                  m_coordinate_list[current_edge.v].lon),
-                                         std::min(m_coordinate_list[current_edge.u].lat,
-                                                  m_coordinate_list[current_edge.v].lat),
-                                         std::max(m_coordinate_list[current_edge.u].lat,
-                                                  m_coordinate_list[current_edge.v].lat)};
+                    const Rectangle bbox{std::min(u.lon, v.lon),
+                                         std::max(u.lon, v.lon),
+                                         std::min(u.lat, v.lat),
+                                         std::max(u.lat, v.lat)};
 
                     // use the _unprojected_ input rectangle here
                     if (bbox.Intersects(search_rectangle))
                     {
-                        results.push_back(current_edge);
+                        results.push_back(GetObject(current_tree_index, i));
                     }
                 }
             }
@@ -448,14 +703,15 @@ class StaticRTree
                 // to the search queue if their bounding boxes intersect
                 for (std::uint32_t i = 0; i < current_tree_node.child_count; ++i)
                 {
-                    const TreeIndex child_id = current_tree_node.children[i];
-                    const auto &child_rectangle =
-                        child_id.is_leaf ? m_leaves[child_id.index].minimum_bounding_rectangle
-                                         : m_search_tree[child_id.index].minimum_bounding_rectangle;
-
-                    if (child_rectangle.Intersects(projected_rectangle))
+                    if (current_tree_node.child_rectangles.Get(i).Intersects(projected_rectangle))
                     {
-                        traversal_queue.push(child_id);
+                        const auto &child = current_tree_node.children[i];
+                        if (prefetch_leaves && child.is_leaf)
+                        {
+                            // the queue is breadth-first, so all leaves are read in the end
+                            adviseWillNeed(&m_leaves[child.index], sizeof(LeafNode));
+                        }
+                        traversal_queue.push(child);
                     }
                 }
             }
@@ -463,15 +719,17 @@ class StaticRTree
         return results;
     }
 
-    // Override filter and terminator for the desired behaviour.
+    // Returns the max_results nearest segments. Skips the parts of the tree that are farther
+    // away than the nearest max_results segments found so far.
     std::vector<EdgeDataT> Nearest(const Coordinate input_coordinate,
                                    const std::size_t max_results) const
     {
-        return Nearest(input_coordinate,
-                       [](const CandidateSegment &) { return std::make_pair(true, true); },
-                       [max_results](const std::size_t num_results, const CandidateSegment &) {
-                           return num_results >= max_results;
-                       });
+        return Search(input_coordinate,
+                      [](const CandidateSegment &) { return std::make_pair(true, true); },
+                      [max_results](const std::size_t num_results, const CandidateSegment &) {
+                          return num_results >= max_results;
+                      },
+                      DistanceBound{max_results});
     }
 
     // Override filter and terminator for the desired behaviour.
@@ -480,12 +738,233 @@ class StaticRTree
                                    const FilterT filter,
                                    const TerminationT terminate) const
     {
+        return Search(
+            input_coordinate, filter, terminate, DistanceBound{DistanceBound::UNBOUNDED});
+    }
+
+    // The number of leaves that intersect the unprojected rectangle, counted up to max_leaves.
+    // Only looks at the inner nodes, which are held in memory.
+    std::size_t CountLeavesInBox(const Rectangle &search_rectangle,
+                                 const std::size_t max_leaves) const
+    {
+        const auto projected_rectangle = ProjectRectangle(search_rectangle);
+        std::size_t number_of_leaves = 0;
+
+        std::vector<TreeIndex> traversal_stack{TreeIndex{}};
+        while (!traversal_stack.empty() && number_of_leaves < max_leaves)
+        {
+            const TreeNode &current_tree_node = m_search_tree[traversal_stack.back().index];
+            traversal_stack.pop_back();
+            for (std::uint32_t i = 0; i < current_tree_node.child_count; ++i)
+            {
+                if (current_tree_node.child_rectangles.Get(i).Intersects(projected_rectangle))
+                {
+                    if (current_tree_node.children[i].is_leaf)
+                    {
+                        ++number_of_leaves;
+                    }
+                    else
+                    {
+                        traversal_stack.push_back(current_tree_node.children[i]);
+                    }
+                }
+            }
+        }
+        return std::min(number_of_leaves, max_leaves);
+    }
+
+    // Returns the same segments as Nearest if terminate stops at the first segment outside of
+    // the unprojected rectangle, like a search in a radius that the rectangle contains. Projects
+    // the input onto all segments of the leaves that intersect the rectangle and sorts them,
+    // instead of ordering the nodes and segments of the whole search in a queue.
+    template <typename FilterT, typename TerminationT>
+    std::vector<EdgeDataT> NearestInBox(const Coordinate input_coordinate,
+                                        const Rectangle &search_rectangle,
+                                        const FilterT &filter,
+                                        const TerminationT &terminate) const
+    {
+        const LeafPageFaultCounter page_fault_counter(prefetch_leaves);
+        const auto projected_rectangle = ProjectRectangle(search_rectangle);
+        const Coordinate fixed_projected_coordinate{web_mercator::fromWGS84(input_coordinate)};
+
+        std::vector<QueryCandidate> candidates;
+        std::array<std::int32_t, LEAF_NODE_SIZE> nearest_lon;
+        std::array<std::int32_t, LEAF_NODE_SIZE> nearest_lat;
+        std::vector<TreeIndex> traversal_stack{TreeIndex{}};
+        while (!traversal_stack.empty())
+        {
+            const TreeNode &current_tree_node = m_search_tree[traversal_stack.back().index];
+            traversal_stack.pop_back();
+            for (std::uint32_t i = 0; i < current_tree_node.child_count; ++i)
+            {
+                const auto &child = current_tree_node.children[i];
+                if (!current_tree_node.child_rectangles.Get(i).Intersects(projected_rectangle))
+                {
+                    continue;
+                }
+                if (!child.is_leaf)
+                {
+                    traversal_stack.push_back(child);
+                    continue;
+                }
+
+                const auto object_count = ProjectOntoLeaf(
+                    m_leaves[child.index], fixed_projected_coordinate, nearest_lon, nearest_lat);
+                for (std::uint32_t j = 0; j < object_count; ++j)
+                {
+                    const Coordinate projected_nearest{FixedLongitude{nearest_lon[j]},
+                                                       FixedLatitude{nearest_lat[j]}};
+                    candidates.push_back(QueryCandidate{
+                        coordinate_calculation::squaredEuclideanDistance(
+                            fixed_projected_coordinate, projected_nearest),
+                        child,
+                        j,
+                        projected_nearest});
+                }
+            }
+        }
+
+        std::sort(candidates.begin(),
+                  candidates.end(),
+                  [](const QueryCandidate &lhs, const QueryCandidate &rhs) {
+                      return lhs.squared_min_dist < rhs.squared_min_dist;
+                  });
+
+        std::vector<EdgeDataT> results;
+        for (const auto &candidate : candidates)
+        {
+            if (!AddSegment(candidate, filter, terminate, results))
+            {
+                break;
+            }
+        }
+        return results;
+    }
+
+  private:
+    // The rectangles of the tree are in web mercator coordinates
+    static Rectangle ProjectRectangle(const Rectangle &rectangle)
+    {
+        return {rectangle.min_lon,
+                rectangle.max_lon,
+                toFixed(FloatLatitude{
+                    web_mercator::latToY(toFloating(FixedLatitude(rectangle.min_lat)))}),
+                toFixed(FloatLatitude{
+                    web_mercator::latToY(toFloating(FixedLatitude(rectangle.max_lat)))})};
+    }
+
+    // leaves packed in parallel and written to the leaf file at once during construction
+    static constexpr std::uint64_t LEAVES_PER_WRITE = 1024;
+
+    static std::uint64_t GetObjectsOffset(const LeafFileHeader &header)
+    {
+        return sizeof(LeafFileHeader) + header.number_of_leaves * sizeof(LeafNode);
+    }
+
+    const EdgeDataT &GetObject(const TreeIndex &leaf_id, const std::uint32_t object_index) const
+    {
+        BOOST_ASSERT(object_index < m_leaves[leaf_id.index].object_count);
+        return m_objects[std::uint64_t{leaf_id.index} * LEAF_NODE_SIZE + object_index];
+    }
+
+    // Packs the sorted input elements [first, last) and their projected coordinates into leaf
+    void PackLeaf(const std::vector<EdgeDataT> &input_data_vector,
+                  const std::vector<WrappedInputElement> &input_wrapper_vector,
+                  const std::uint64_t first,
+                  const std::uint64_t last,
+                  LeafNode &leaf) const
+    {
+        BOOST_ASSERT(last - first <= LEAF_NODE_SIZE);
+        Rectangle &rectangle = leaf.minimum_bounding_rectangle;
+        for (std::uint32_t object_index = 0; object_index < last - first; ++object_index)
+        {
+            const std::uint32_t input_object_index =
+                input_wrapper_vector[first + object_index].m_array_index;
+            const EdgeDataT &object = input_data_vector[input_object_index];
+
+            leaf.object_count += 1;
+            leaf.segment_nodes.u[object_index] = object.u;
+            leaf.segment_nodes.v[object_index] = object.v;
+
+            const Coordinate u{m_coordinate_list[object.u]};
+            const Coordinate v{m_coordinate_list[object.v]};
+            Coordinate projected_u{web_mercator::fromWGS84(u)};
+            Coordinate projected_v{web_mercator::fromWGS84(v)};
+            leaf.forward_bearings[object_index] =
+                bearing::quantize(coordinate_calculation::bearing(u, v));
+
+            BOOST_ASSERT(std::abs(toFloating(projected_u.lon).operator double()) <= 180.);
+            BOOST_ASSERT(std::abs(toFloating(projected_u.lat).operator double()) <= 180.);
+            BOOST_ASSERT(std::abs(toFloating(projected_v.lon).operator double()) <= 180.);
+            BOOST_ASSERT(std::abs(toFloating(projected_v.lat).operator double()) <= 180.);
+
+            auto &segments = leaf.projected_segments;
+            segments.u_lon[object_index] = static_cast<std::int32_t>(projected_u.lon);
+            segments.u_lat[object_index] = static_cast<std::int32_t>(projected_u.lat);
+            segments.v_lon[object_index] = static_cast<std::int32_t>(projected_v.lon);
+            segments.v_lat[object_index] = static_cast<std::int32_t>(projected_v.lat);
+
+            rectangle.min_lon =
+                std::min(rectangle.min_lon, std::min(projected_u.lon, projected_v.lon));
+            rectangle.max_lon =
+                std::max(rectangle.max_lon, std::max(projected_u.lon, projected_v.lon));
+
+            rectangle.min_lat =
+                std::min(rectangle.min_lat, std::min(projected_u.lat, projected_v.lat));
+            rectangle.max_lat =
+                std::max(rectangle.max_lat, std::max(projected_u.lat, projected_v.lat));
+
+            BOOST_ASSERT(rectangle.IsValid());
+        }
+    }
+
+    // Builds the parents of a level of child_count nodes in parallel, each of BRANCHING_FACTOR
+    // consecutive children. The children are referenced by their index in the level plus
+    // first_child_index, get_rectangle returns their bounding rectangle by index in the level.
+    template <typename GetRectangleT>
+    static std::vector<TreeNode> MakeParents(const std::uint64_t child_count,
+                                             const std::uint64_t first_child_index,
+                                             const bool children_are_leaves,
+                                             const GetRectangleT &get_rectangle)
+    {
+        std::vector<TreeNode> parents((child_count + BRANCHING_FACTOR - 1) / BRANCHING_FACTOR);
+        tbb::parallel_for(
+            tbb::blocked_range<std::uint64_t>(0, parents.size()),
+            [&](const tbb::blocked_range<std::uint64_t> &range) {
+                for (auto parent_index = range.begin(), end = range.end(); parent_index != end;
+                     ++parent_index)
+                {
+                    TreeNode &parent = parents[parent_index];
+                    const std::uint64_t first_child = parent_index * BRANCHING_FACTOR;
+                    const std::uint64_t last_child =
+                        std::min<std::uint64_t>(first_child + BRANCHING_FACTOR, child_count);
+                    for (auto child = first_child; child < last_child; ++child)
+                    {
+                        const Rectangle rectangle = get_rectangle(child);
+                        parent.children[parent.child_count] =
+                            TreeIndex{first_child_index + child, children_are_leaves};
+                        parent.minimum_bounding_rectangle.MergeBoundingBoxes(rectangle);
+                        parent.child_rectangles.Set(parent.child_count, rectangle);
+                        ++parent.child_count;
+                    }
+                }
+            });
+        return parents;
+    }
+
+    // Best-first search over the tree [2, 3]
+    template <typename FilterT, typename TerminationT>
+    std::vector<EdgeDataT> Search(const Coordinate input_coordinate,
+                                  const FilterT &filter,
+                                  const TerminationT &terminate,
+                                  DistanceBound bound) const
+    {
+        const LeafPageFaultCounter page_fault_counter(prefetch_leaves);
         std::vector<EdgeDataT> results;
-        auto projected_coordinate = web_mercator::fromWGS84(input_coordinate);
-        Coordinate fixed_projected_coordinate{projected_coordinate};
+        const Coordinate fixed_projected_coordinate{web_mercator::fromWGS84(input_coordinate)};
 
         // initialize queue with root element
-        std::priority_queue<QueryCandidate> traversal_queue;
+        CandidateQueue traversal_queue;
         traversal_queue.push(QueryCandidate{0, TreeIndex{}});
 
         while (!traversal_queue.empty())
@@ -498,93 +977,191 @@ class StaticRTree
             { // current object is a tree node
                 if (current_tree_index.is_leaf)
                 {
-                    ExploreLeafNode(current_tree_index,
-                                    fixed_projected_coordinate,
-                                    projected_coordinate,
-                                    traversal_queue);
+                    ExploreLeafNode(
+                        current_tree_index, fixed_projected_coordinate, traversal_queue, bound);
                 }
                 else
                 {
                     ExploreTreeNode(
-                        current_tree_index, fixed_projected_coordinate, traversal_queue);
+                        current_tree_index, fixed_projected_coordinate, traversal_queue, bound);
                 }
             }
-            else
+            else if (!AddSegment(current_query_node, filter, terminate, results))
             { // current candidate is an actual road segment
-                auto edge_data =
-                    m_leaves[current_tree_index.index].objects[current_query_node.segment_index];
-                const auto &current_candidate =
-                    CandidateSegment{current_query_node.fixed_projected_coordinate, edge_data};
-
-                // to allow returns of no-results if too restrictive filtering, this needs to be
-                // done here even though performance would indicate that we want to stop after
-                // adding the first candidate
-                if (terminate(results.size(), current_candidate))
-                {
-                    break;
-                }
-
-                auto use_segment = filter(current_candidate);
-                if (!use_segment.first && !use_segment.second)
-                {
-                    continue;
-                }
-                edge_data.forward_segment_id.enabled &= use_segment.first;
-                edge_data.reverse_segment_id.enabled &= use_segment.second;
-
-                // store phantom node in result vector
-                results.push_back(std::move(edge_data));
+                break;
             }
         }
 
         return results;
     }
 
-  private:
-    template <typename QueueT>
-    void ExploreLeafNode(const TreeIndex &leaf_id,
-                         const Coordinate &projected_input_coordinate_fixed,
-                         const FloatCoordinate &projected_input_coordinate,
-                         QueueT &traversal_queue) const
+    // Adds the segment of a candidate to the results unless the filter rejects it. Returns false
+    // once terminate ends the search.
+    template <typename FilterT, typename TerminationT>
+    bool AddSegment(const QueryCandidate &candidate,
+                    const FilterT &filter,
+                    const TerminationT &terminate,
+                    std::vector<EdgeDataT> &results) const
     {
-        const LeafNode &current_leaf_node = m_leaves[leaf_id.index];
+        auto edge_data = GetObject(candidate.tree_index, candidate.segment_index);
+        const auto &current_candidate = CandidateSegment{
+            candidate.fixed_projected_coordinate,
+            edge_data,
+            m_leaves[candidate.tree_index.index].forward_bearings[candidate.segment_index]};
+
+        // to allow returns of no-results if too restrictive filtering, this needs to be
+        // done here even though performance would indicate that we want to stop after
+        // adding the first candidate
+        if (terminate(results.size(), current_candidate))
+        {
+            return false;
+        }
 
-        // current object represents a block on disk
-        for (const auto i : irange(0u, current_leaf_node.object_count))
+        auto use_segment = filter(current_candidate);
+        if (!use_segment.first && !use_segment.second)
         {
-            const auto &current_edge = current_leaf_node.objects[i];
-            const auto projected_u = web_mercator::fromWGS84(m_coordinate_list[current_edge.u]);
-            const auto projected_v = web_mercator::fromWGS84(m_coordinate_list[current_edge.v]);
+            return true;
+        }
+        edge_data.forward_segment_id.enabled &= use_segment.first;
+        edge_data.reverse_segment_id.enabled &= use_segment.second;
+
+        // store phantom node in result vector
+        results.push_back(std::move(edge_data));
+        return true;
+    }
 
-            FloatCoordinate projected_nearest;
-            std::tie(std::ignore, projected_nearest) =
-                coordinate_calculation::projectPointOnSegment(
-                    projected_u, projected_v, projected_input_coordinate);
+    // Projects the input onto all segments of the leaf like projectPointOnSegment, but in fixed
+    // point coordinates, and returns the number of segments. The ratio is clamped with abs
+    // instead of comparisons, which compilers only vectorize with -ffast-math, so that the loop
+    // runs on vectors of coordinates.
+    static std::uint32_t ProjectOntoLeaf(const LeafNode &leaf_node,
+                                         const Coordinate &projected_input_coordinate_fixed,
+                                         std::array<std::int32_t, LEAF_NODE_SIZE> &nearest_lon,
+                                         std::array<std::int32_t, LEAF_NODE_SIZE> &nearest_lat)
+    {
+        const ProjectedSegments &segments = leaf_node.projected_segments;
+        const std::uint32_t object_count = leaf_node.object_count;
+        BOOST_ASSERT(object_count <= LEAF_NODE_SIZE);
 
+        const double input_lon = static_cast<std::int32_t>(projected_input_coordinate_fixed.lon);
+        const double input_lat = static_cast<std::int32_t>(projected_input_coordinate_fixed.lat);
+
+        for (std::uint32_t i = 0; i < object_count; ++i)
+        {
+            const double u_lon = segments.u_lon[i];
+            const double u_lat = segments.u_lat[i];
+            const double slope_lon = segments.v_lon[i] - u_lon;
+            const double slope_lat = segments.v_lat[i] - u_lat;
+            const double unnormed_ratio =
+                slope_lon * (input_lon - u_lon) + slope_lat * (input_lat - u_lat);
+            // The end points are integers, so a segment is at least one long or a point, which
+            // has no slope and projects onto its start. max(1, length) of a point is one.
+            const double squared_length = slope_lon * slope_lon + slope_lat * slope_lat;
+            const double divisor = 0.5 * (squared_length + 1. + std::abs(squared_length - 1.));
+            const double normed_ratio = unnormed_ratio / divisor;
+            // min(1, max(0, ratio))
+            const double ratio = 0.5 * (std::abs(normed_ratio) - std::abs(normed_ratio - 1.) + 1.);
+
+            nearest_lon[i] = static_cast<std::int32_t>(u_lon + ratio * slope_lon);
+            nearest_lat[i] = static_cast<std::int32_t>(u_lat + ratio * slope_lat);
+        }
+        return object_count;
+    }
+
+    void ExploreLeafNode(const TreeIndex &leaf_id,
+                         const Coordinate &projected_input_coordinate_fixed,
+                         CandidateQueue &traversal_queue,
+                         DistanceBound &bound) const
+    {
+        std::array<std::int32_t, LEAF_NODE_SIZE> nearest_lon;
+        std::array<std::int32_t, LEAF_NODE_SIZE> nearest_lat;
+        const auto object_count = ProjectOntoLeaf(
+            m_leaves[leaf_id.index], projected_input_coordinate_fixed, nearest_lon, nearest_lat);
+
+        for (std::uint32_t i = 0; i < object_count; ++i)
+        {
+            const Coordinate projected_nearest{FixedLongitude{nearest_lon[i]},
+                                               FixedLatitude{nearest_lat[i]}};
             const auto squared_distance = coordinate_calculation::squaredEuclideanDistance(
                 projected_input_coordinate_fixed, projected_nearest);
-            // distance must be non-negative
-            BOOST_ASSERT(0. <= squared_distance);
-            traversal_queue.push(
-                QueryCandidate{squared_distance, leaf_id, i, Coordinate{projected_nearest}});
+            if (squared_distance <= bound.Get())
+            {
+                bound.Add(squared_distance);
+                traversal_queue.push(
+                    QueryCandidate{squared_distance, leaf_id, i, projected_nearest});
+            }
         }
     }
 
-    template <class QueueT>
+    // The minimum distances to the rectangles of all children like
+    // Rectangle::GetMinSquaredDist, in a loop without branches that compilers vectorize for
+    // SSE4.1 and up
     void ExploreTreeNode(const TreeIndex &parent_id,
                          const Coordinate &fixed_projected_input_coordinate,
-                         QueueT &traversal_queue) const
+                         CandidateQueue &traversal_queue,
+                         const DistanceBound &bound) const
     {
         const TreeNode &parent = m_search_tree[parent_id.index];
+        const ChildRectangles &rectangles = parent.child_rectangles;
+        const std::uint32_t child_count = parent.child_count;
+        BOOST_ASSERT(child_count <= BRANCHING_FACTOR);
+
+        const auto input_lon = static_cast<std::int32_t>(fixed_projected_input_coordinate.lon);
+        const auto input_lat = static_cast<std::int32_t>(fixed_projected_input_coordinate.lat);
+
+        std::array<std::uint64_t, BRANCHING_FACTOR> squared_distances;
+        for (std::uint32_t i = 0; i < child_count; ++i)
+        {
+            // zero inside of the rectangle, the distance to the nearest side outside of it
+            const std::uint32_t delta_lon = std::max(
+                std::max(rectangles.min_lon[i] - input_lon, input_lon - rectangles.max_lon[i]), 0);
+            const std::uint32_t delta_lat = std::max(
+                std::max(rectangles.min_lat[i] - input_lat, input_lat - rectangles.max_lat[i]), 0);
+            squared_distances[i] = static_cast<std::uint64_t>(delta_lon) * delta_lon +
+                                   static_cast<std::uint64_t>(delta_lat) * delta_lat;
+        }
+
+        const auto max_squared_distance = bound.Get();
+        for (std::uint32_t i = 0; i < child_count; ++i)
+        {
+            if (squared_distances[i] <= max_squared_distance)
+            {
+                traversal_queue.push(QueryCandidate{squared_distances[i], parent.children[i]});
+            }
+        }
+
+        if (prefetch_leaves && child_count > 0 && parent.children[0].is_leaf)
+        {
+            PrefetchNearestLeaves(parent, squared_distances, max_squared_distance);
+        }
+    }
+
+    // Reads ahead the nearest leaves below a node of the last inner level, which the search
+    // most likely continues with
+    void PrefetchNearestLeaves(const TreeNode &parent,
+                               const std::array<std::uint64_t, BRANCHING_FACTOR> &squared_distances,
+                               const std::uint64_t max_squared_distance) const
+    {
+        std::array<std::uint32_t, BRANCHING_FACTOR> candidates;
+        std::uint32_t candidate_count = 0;
         for (std::uint32_t i = 0; i < parent.child_count; ++i)
         {
-            const TreeIndex child_id = parent.children[i];
-            const auto &child_rectangle =
-                child_id.is_leaf ? m_leaves[child_id.index].minimum_bounding_rectangle
-                                 : m_search_tree[child_id.index].minimum_bounding_rectangle;
-            const auto squared_lower_bound_to_element =
-                child_rectangle.GetMinSquaredDist(fixed_projected_input_coordinate);
-            traversal_queue.push(QueryCandidate{squared_lower_bound_to_element, child_id});
+            if (squared_distances[i] <= max_squared_distance)
+            {
+                candidates[candidate_count++] = i;
+            }
+        }
+
+        const auto prefetch_count = std::min(candidate_count, std::uint32_t{PREFETCHED_LEAVES});
+        std::partial_sort(candidates.begin(),
+                          candidates.begin() + prefetch_count,
+                          candidates.begin() + candidate_count,
+                          [&](const std::uint32_t lhs, const std::uint32_t rhs) {
+                              return squared_distances[lhs] < squared_distances[rhs];
+                          });
+        for (std::uint32_t i = 0; i < prefetch_count; ++i)
+        {
+            adviseWillNeed(&m_leaves[parent.children[candidates[i]].index], sizeof(LeafNode));
         }
     }
 };
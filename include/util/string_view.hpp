@@ -0,0 +1,18 @@
+#ifndef OSRM_STRING_VIEW_HPP
+#define OSRM_STRING_VIEW_HPP
+
+#include <boost/utility/string_ref.hpp>
+
+namespace osrm
+{
+namespace util
+{
+
+// Non-owning, read-only view into a contiguous range of chars, e.g. into the name data of the
+// data facades. It is only valid as long as the data it points into.
+using StringView = boost::string_ref;
+
+} // namespace util
+} // namespace osrm
+
+#endif // OSRM_STRING_VIEW_HPP
@@ -0,0 +1,35 @@
+#ifndef OSRM_UTIL_TRACEPOINT_HPP
+#define OSRM_UTIL_TRACEPOINT_HPP
+
+// Static tracepoints of the provider osrm, compiled in with -DENABLE_USDT=ON. A tracepoint is a
+// single nop in the code and a note in the binary that perf, bpftrace or systemtap turn into a
+// breakpoint once they attach to it, so osrm-routed can be traced in production without a
+// rebuild, e.g. with
+//
+//   bpftrace -e 'usdt:./osrm-routed:osrm:phase__done { @[str(arg0)] = hist(arg1); }'
+//
+// The arguments are integers or C strings, which are only read by an attached tracer. Without
+// ENABLE_USDT the tracepoints compile to nothing and don't evaluate their arguments.
+//
+// Tracepoints and their arguments:
+//   request__start(uri) / request__done(status, bytes)      a request in osrm-routed
+//   query__start(service) / query__done(service, ns)        a query of the engine
+//   phase__start(phase) / phase__done(phase, ns)            a phase of a query, see QueryMetrics
+//   search__start() / search__done(weight, settled_nodes)   a point to point search
+//   render__start() / render__done(bytes)                   rendering the JSON of a reply
+//   compress__start(bytes) / compress__done(bytes)          compressing a reply
+// The durations of the phases don't include the time of the phases nested into them.
+#ifdef OSRM_ENABLE_USDT
+#include <sys/sdt.h>
+
+#define OSRM_TRACEPOINT(name) DTRACE_PROBE(osrm, name)
+#define OSRM_TRACEPOINT1(name, arg1) DTRACE_PROBE1(osrm, name, arg1)
+#define OSRM_TRACEPOINT2(name, arg1, arg2) DTRACE_PROBE2(osrm, name, arg1, arg2)
+#else
+#define OSRM_TRACEPOINT(name) ((void)0)
+// the arguments count as used, but aren't evaluated
+#define OSRM_TRACEPOINT1(name, arg1) ((void)sizeof(arg1))
+#define OSRM_TRACEPOINT2(name, arg1, arg2) ((void)sizeof(arg1), (void)sizeof(arg2))
+#endif
+
+#endif // OSRM_UTIL_TRACEPOINT_HPP
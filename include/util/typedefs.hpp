@@ -85,6 +85,10 @@ static const EdgeWeight INVALID_EDGE_WEIGHT = std::numeric_limits<EdgeWeight>::m
 
 using DatasourceID = std::uint8_t;
 
+// in meters, of the segments of the compressed geometries
+using SegmentLength = float;
+static const SegmentLength INVALID_SEGMENT_LENGTH = -1;
+
 struct SegmentID
 {
     SegmentID(const NodeID id_, const bool enabled_) : id{id_}, enabled{enabled_}
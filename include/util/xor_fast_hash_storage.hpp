@@ -63,6 +63,9 @@ class XORFastHashStorage
         return positions[position].key;
     }
 
+    // the slot of a node is only known after probing
+    void Prefetch(const NodeID) const {}
+
     void Clear()
     {
         ++current_timestamp;
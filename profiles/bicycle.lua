@@ -127,6 +127,23 @@ function get_exceptions(vector)
   end
 end
 
+-- node_function and way_function only read elements with one of these keys, osrm-extract gives
+-- the others the default results without calling them
+function get_node_keys(vector)
+  for i,key in ipairs(access_tags_hierarchy) do
+    vector:Add(key)
+  end
+  vector:Add("barrier")
+  vector:Add("highway")
+end
+
+function get_way_keys(vector)
+  for i,key in ipairs({"highway", "route", "man_made", "railway", "amenity",
+                       "public_transport", "bridge"}) do
+    vector:Add(key)
+  end
+end
+
 function node_function (node, result)
   -- parse access and barrier tags
   local highway = node:get_value_by_key("highway")
@@ -159,6 +159,7 @@ local obey_oneway                = true
 local ignore_areas               = true
 local ignore_hov_ways            = true
 local ignore_toll_ways           = false
+local excludable_classes         = { "toll", "motorway", "ferry" }
 
 local abs = math.abs
 local min = math.min
@@ -178,6 +179,13 @@ function get_exceptions(vector)
   end
 end
 
+-- the classes of ways a query can exclude with exclude=, at most 8
+function get_classes(vector)
+  for i,v in ipairs(excludable_classes) do
+    vector:Add(v)
+  end
+end
+
 local function parse_maxspeed(source)
   if not source then
     return 0
@@ -202,6 +210,22 @@ local function parse_maxspeed(source)
   return n
 end
 
+-- node_function and way_function only read elements with one of these keys, osrm-extract gives
+-- the others the default results without calling them
+function get_node_keys(vector)
+  for i,key in ipairs(access_tags_hierarchy) do
+    vector:Add(key)
+  end
+  vector:Add("barrier")
+  vector:Add("highway")
+end
+
+function get_way_keys(vector)
+  for i,key in ipairs({"highway", "route", "bridge"}) do
+    vector:Add(key)
+  end
+end
+
 function node_function (node, result)
   -- parse access and barrier tags
   local access = find_access_tag(node, access_tags_hierarchy)
@@ -586,6 +610,24 @@ function way_function (way, result)
 
   -- only allow this road as start point if it not a ferry
   result.is_startpoint = result.forward_mode == mode.driving or result.backward_mode == mode.driving
+
+  if toll and "yes" == toll then
+    result:set_class("toll")
+  end
+  if result.road_classification.motorway_class then
+    result:set_class("motorway")
+  end
+  if result.forward_mode == mode.ferry then
+    result:set_class("ferry")
+  end
+end
+
+-- osrm-extract passes the ways of a chunk of the input to this function at once instead of
+-- calling way_function for each of them, which saves most of the calls into lua
+function way_batch_function (ways, results)
+  for i = 1, #ways do
+    way_function(ways[i], results[i])
+  end
 end
 
 function turn_function (angle)
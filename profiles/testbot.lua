@@ -43,9 +43,24 @@ function node_function (node, result)
   end
 end
 
+-- way_function only reads these keys besides the name, osrm-extract reuses its results for
+-- ways with the same values of them and only calls way_name_function
+function get_way_cache_keys(vector)
+  for i,key in ipairs({"highway", "oneway", "route", "duration", "maxspeed",
+                       "maxspeed:forward", "maxspeed:backward", "junction"}) do
+    vector:Add(key)
+  end
+end
+
+function way_name_function (way, result)
+  local name = way:get_value_by_key("name")
+  if name then
+    result.name = name
+  end
+end
+
 function way_function (way, result)
   local highway = way:get_value_by_key("highway")
-  local name = way:get_value_by_key("name")
   local oneway = way:get_value_by_key("oneway")
   local route = way:get_value_by_key("route")
   local duration = way:get_value_by_key("duration")
@@ -54,9 +69,7 @@ function way_function (way, result)
   local maxspeed_backward = tonumber(way:get_value_by_key( "maxspeed:backward"))
   local junction = way:get_value_by_key("junction")
 
-  if name then
-    result.name = name
-  end
+  way_name_function(way, result)
 
   result.forward_mode = mode.driving
   result.backward_mode = mode.driving
@@ -0,0 +1,93 @@
+#!/usr/bin/env bash
+
+# Runs the toolchain on synthetic networks of growing size and records the wall time and the
+# peak memory of every stage, plus the latency of random route queries against osrm-routed.
+#
+# usage: scaling_benchmark.sh [<build directory>] [<sizes>...]
+#
+#   BUILD    directory with the osrm binaries, needs BUILD_TOOLS for osrm-osmgen and osrm-loadgen
+#   PROFILE  profile for osrm-extract, defaults to profiles/car.lua
+#   WORKDIR  directory for the generated data, defaults to a temporary directory
+#   SEED     seed of osrm-osmgen, defaults to 1
+#   QUERIES  number of route queries, defaults to 1000
+#   RESULTS  file the results are appended to as tab separated values
+
+set -o errexit
+set -o pipefail
+set -o nounset
+
+SCRIPT_DIR=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+
+BUILD=${1:-${BUILD:-build}}
+shift || true
+SIZES=${@:-10000 100000 1000000 10000000}
+PROFILE=${PROFILE:-${SCRIPT_DIR}/../profiles/car.lua}
+WORKDIR=${WORKDIR:-$(mktemp -d)}
+SEED=${SEED:-1}
+QUERIES=${QUERIES:-1000}
+RESULTS=${RESULTS:-scaling_benchmark.tsv}
+PORT=${PORT:-5123}
+
+if [[ ! -x /usr/bin/time ]]; then
+    echo "GNU time is needed to measure the peak memory at /usr/bin/time" >&2
+    exit 1
+fi
+
+if [[ ! -s ${RESULTS} ]]; then
+    echo -e "nodes\tseed\tstage\tseconds\tmax_rss_kb\tfile_bytes" > ${RESULTS}
+fi
+
+# stage name, file whose size is recorded, command
+function measure {
+    local stage=$1
+    local file=$2
+    shift 2
+    echo "[${stage}] $*"
+    /usr/bin/time -f "%e %M" -o ${WORKDIR}/time.txt "$@" > ${WORKDIR}/${stage}.log 2>&1
+    read seconds rss < ${WORKDIR}/time.txt
+    local bytes=$(stat -c %s ${file} 2>/dev/null || echo 0)
+    echo -e "${NODES}\t${SEED}\t${stage}\t${seconds}\t${rss}\t${bytes}" >> ${RESULTS}
+}
+
+# the grid of osrm-osmgen with its default spacing and shape nodes starts at 0,0 and grows
+# north east, so random coordinates in its extent snap to the network
+function write_queries {
+    awk -v nodes=${NODES} -v queries=${QUERIES} -v seed=${SEED} 'BEGIN {
+        srand(seed);
+        extent = sqrt(nodes / 3) * 100 / 111319.49;
+        for (i = 0; i < queries; ++i) {
+            printf "/route/v1/driving/%.6f,%.6f;%.6f,%.6f?overview=false\n",
+                rand() * extent, rand() * extent, rand() * extent, rand() * extent;
+        }
+    }' > ${WORKDIR}/queries.txt
+}
+
+for NODES in ${SIZES}; do
+    BASE=${WORKDIR}/grid_${NODES}
+    measure generate ${BASE}.osm.pbf \
+        ${BUILD}/osrm-osmgen ${BASE}.osm.pbf --nodes ${NODES} --seed ${SEED}
+    measure extract ${BASE}.osrm ${BUILD}/osrm-extract -p ${PROFILE} ${BASE}.osm.pbf
+    measure contract ${BASE}.osrm.hsgr ${BUILD}/osrm-contract ${BASE}.osrm
+    measure datastore ${BASE}.osrm.hsgr ${BUILD}/osrm-datastore ${BASE}.osrm
+
+    ${BUILD}/osrm-routed --shared-memory --port ${PORT} > ${WORKDIR}/routed.log 2>&1 &
+    ROUTED=$!
+    trap "kill ${ROUTED} 2> /dev/null || true" EXIT
+    for attempt in $(seq 1 60); do
+        if grep -q "running and waiting for requests" ${WORKDIR}/routed.log; then
+            break
+        fi
+        sleep 1
+    done
+
+    write_queries
+    measure queries ${WORKDIR}/queries.txt \
+        ${BUILD}/osrm-loadgen ${WORKDIR}/queries.txt --port ${PORT} --keep-alive
+    grep "latency ms" ${WORKDIR}/queries.log | sed "s/^/[queries] ${NODES} nodes: /"
+
+    kill ${ROUTED}
+    wait ${ROUTED} 2> /dev/null || true
+    rm -f ${BASE}.osm.pbf ${BASE}.osrm*
+done
+
+column -t ${RESULTS}
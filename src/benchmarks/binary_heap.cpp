@@ -0,0 +1,122 @@
+#include "util/binary_heap.hpp"
+#include "util/d_ary_heap.hpp"
+#include "util/radix_heap.hpp"
+#include "util/timing_util.hpp"
+#include "util/typedefs.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace benchmarks
+{
+
+// Choosen by a fair W20 dice roll (this value is completely arbitrary)
+constexpr unsigned RANDOM_SEED = 13;
+
+struct HeapData
+{
+    NodeID parent;
+    HeapData(NodeID p) : parent(p) {}
+};
+
+template <typename StorageT>
+using BinaryHeap = util::BinaryHeap<NodeID, NodeID, int, HeapData, StorageT>;
+template <typename StorageT>
+using QuaternaryHeap = util::DAryHeap<NodeID, NodeID, int, HeapData, StorageT, 4>;
+template <typename StorageT>
+using RadixHeap = util::RadixHeap<NodeID, NodeID, int, HeapData, StorageT>;
+
+// Emulates the access pattern of a CH query: every search touches a small, random part of a
+// large id space, relaxes a few edges per settled node and the heap is cleared between
+// searches.
+template <typename HeapT>
+void benchmarkHeap(const std::string &name,
+                   const unsigned num_nodes,
+                   const unsigned num_queries,
+                   const unsigned nodes_per_query)
+{
+    HeapT heap(num_nodes);
+
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<NodeID> node_udist(0, num_nodes - 1);
+    std::uniform_int_distribution<int> weight_udist(1, 1000);
+
+    std::cout << "Running " << name << " with " << num_queries << " queries: " << std::flush;
+
+    std::size_t settled = 0;
+    TIMER_START(query);
+    for (unsigned query = 0; query < num_queries; ++query)
+    {
+        heap.Clear();
+        heap.Insert(node_udist(mt_rand), 0, SPECIAL_NODEID);
+
+        unsigned relaxed = 0;
+        while (!heap.Empty() && relaxed < nodes_per_query)
+        {
+            const NodeID node = heap.DeleteMin();
+            const int weight = heap.GetKey(node);
+            ++settled;
+
+            for (unsigned edge = 0; edge < 4; ++edge, ++relaxed)
+            {
+                const NodeID to = node_udist(mt_rand);
+                const int to_weight = weight + weight_udist(mt_rand);
+                if (!heap.WasInserted(to))
+                {
+                    heap.Insert(to, to_weight, node);
+                }
+                else if (!heap.WasRemoved(to) && to_weight < heap.GetKey(to))
+                {
+                    heap.GetData(to).parent = node;
+                    heap.DecreaseKey(to, to_weight);
+                }
+            }
+        }
+    }
+    TIMER_STOP(query);
+
+    std::cout << "Took " << TIMER_MSEC(query) << "ms  ->  " << TIMER_MSEC(query) / num_queries
+              << " ms/query (" << settled << " nodes settled)" << std::endl;
+}
+
+template <template <typename> class HeapT>
+void benchmarkStorages(const std::string &name,
+                       const unsigned num_nodes,
+                       const unsigned num_queries,
+                       const unsigned nodes_per_query)
+{
+    benchmarkHeap<HeapT<util::UnorderedMapStorage<NodeID, int>>>(
+        name + " / UnorderedMapStorage", num_nodes, num_queries, nodes_per_query);
+    benchmarkHeap<HeapT<util::ArrayStorage<NodeID, int>>>(
+        name + " / ArrayStorage", num_nodes, num_queries, nodes_per_query);
+    benchmarkHeap<HeapT<util::TimestampedArrayStorage<NodeID, int>>>(
+        name + " / TimestampedArrayStorage", num_nodes, num_queries, nodes_per_query);
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned num_nodes = argc > 1 ? std::stoul(argv[1]) : 10000000;
+    const unsigned num_queries = argc > 2 ? std::stoul(argv[2]) : 1000;
+    const unsigned nodes_per_query = argc > 3 ? std::stoul(argv[3]) : 4000;
+
+    if (num_nodes == 0)
+    {
+        std::cout << "./heap-bench [num_nodes] [num_queries] [nodes_per_query]"
+                  << "\n";
+        return EXIT_FAILURE;
+    }
+
+    using namespace osrm::benchmarks;
+    benchmarkStorages<BinaryHeap>("BinaryHeap", num_nodes, num_queries, nodes_per_query);
+    benchmarkStorages<QuaternaryHeap>("DAryHeap<4>", num_nodes, num_queries, nodes_per_query);
+    benchmarkStorages<RadixHeap>("RadixHeap", num_nodes, num_queries, nodes_per_query);
+
+    return EXIT_SUCCESS;
+}
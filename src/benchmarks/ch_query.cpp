@@ -0,0 +1,331 @@
+#include "contractor/core_landmarks.hpp"
+#include "contractor/graph_contractor.hpp"
+#include "contractor/query_edge.hpp"
+#include "contractor/query_graph.hpp"
+#include "extractor/edge_based_edge.hpp"
+#include "engine/routing_algorithms/routing_base.hpp"
+#include "engine/search_engine_data.hpp"
+#include "partition/cell_storage.hpp"
+#include "util/chunked_vector.hpp"
+#include "util/integer_range.hpp"
+#include "util/packed_bitset.hpp"
+#include "util/static_graph.hpp"
+#include "util/timing_util.hpp"
+#include "util/typedefs.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace benchmarks
+{
+
+// Choosen by a fair W20 dice roll (this value is completely arbitrary)
+constexpr unsigned RANDOM_SEED = 13;
+
+using QueryHeap = engine::SearchEngineData::QueryHeap;
+using engine::routing_algorithms::StallingMode;
+
+// Serves a contracted graph to the routing algorithms and counts how often the adjacency of
+// a node is scanned, which is what stalling and the landmarks save on.
+class GraphFacade
+{
+  public:
+    using EdgeData = contractor::QueryEdge::EdgeData;
+    using Graph = util::StaticGraph<EdgeData>;
+    using EdgeRange = Graph::EdgeRange;
+
+    explicit GraphFacade(Graph graph) : graph(std::move(graph)), number_of_scans(0) {}
+
+    GraphFacade(Graph graph,
+                const std::vector<bool> &is_core_node,
+                contractor::CoreLandmarks landmarks)
+        : graph(std::move(graph)),
+          core_marker_words(util::PackedBitsetView::GetNumberOfWords(is_core_node.size())),
+          number_of_core_markers(is_core_node.size()), landmarks(std::move(landmarks)),
+          number_of_scans(0)
+    {
+        for (const auto node : util::irange<std::size_t>(0, is_core_node.size()))
+        {
+            core_marker_words[node / util::PackedBitsetView::BITS_PER_WORD] |=
+                util::PackedBitsetView::Word{is_core_node[node]}
+                << (node % util::PackedBitsetView::BITS_PER_WORD);
+        }
+    }
+
+    unsigned GetNumberOfNodes() const { return graph.GetNumberOfNodes(); }
+
+    EdgeRange GetAdjacentEdgeRange(const NodeID node) const
+    {
+        ++number_of_scans;
+        return graph.GetAdjacentEdgeRange(node);
+    }
+
+    const EdgeData &GetEdgeData(const EdgeID edge) const { return graph.GetEdgeData(edge); }
+
+    contractor::QueryEdgeSearchData GetSearchData(const EdgeID edge) const
+    {
+        return contractor::getSearchData(graph.GetTarget(edge), graph.GetEdgeData(edge));
+    }
+
+    NodeID GetTarget(const EdgeID edge) const { return graph.GetTarget(edge); }
+
+    // the searches read the graph through the facade itself, so its scans are counted
+    const GraphFacade &GetSearchGraph() const { return *this; }
+
+    bool IsPrefetching() const { return false; }
+    void PrefetchNode(const NodeID) const {}
+    void PrefetchEdges(const NodeID) const {}
+
+    // the benchmark only has the hierarchy, the multi-level search is never taken
+    bool HasMultiLevelData() const { return false; }
+    contractor::QueryGraphView GetMultiLevelGraph() const { return {}; }
+    const partition::CellStorageView &GetCellStorage() const { return cell_storage; }
+
+    bool HasCore() const { return number_of_core_markers > 0; }
+
+    util::PackedBitsetView GetCoreMarkers() const
+    {
+        return util::PackedBitsetView(core_marker_words.data(), number_of_core_markers);
+    }
+
+    bool IsCoreNode(const NodeID node) const { return HasCore() && GetCoreMarkers().Test(node); }
+
+    unsigned GetNumberOfLandmarks() const
+    {
+        return use_landmarks ? landmarks.landmarks.size() : 0;
+    }
+
+    const EdgeWeight *GetLandmarkDistances(const NodeID node) const
+    {
+        const auto core_node =
+            std::lower_bound(landmarks.core_nodes.begin(), landmarks.core_nodes.end(), node);
+        if (core_node == landmarks.core_nodes.end() || *core_node != node)
+        {
+            return nullptr;
+        }
+        const std::size_t rank = std::distance(landmarks.core_nodes.begin(), core_node);
+        return &landmarks.distances[rank * 2 * landmarks.landmarks.size()];
+    }
+
+    void UseLandmarks(const bool use) { use_landmarks = use; }
+
+    std::size_t GetNumberOfScans() const { return number_of_scans; }
+    void ResetNumberOfScans() { number_of_scans = 0; }
+
+  private:
+    Graph graph;
+    std::vector<util::PackedBitsetView::Word> core_marker_words;
+    std::size_t number_of_core_markers = 0;
+    contractor::CoreLandmarks landmarks;
+    partition::CellStorageView cell_storage;
+    bool use_landmarks = false;
+    mutable std::size_t number_of_scans;
+};
+
+class QueryRouting final
+    : public engine::routing_algorithms::BasicRoutingInterface<GraphFacade, QueryRouting>
+{
+    using super = engine::routing_algorithms::BasicRoutingInterface<GraphFacade, QueryRouting>;
+
+  public:
+    explicit QueryRouting(GraphFacade *facade) : super(facade) {}
+
+    EdgeWeight operator()(QueryHeap &forward_heap,
+                          QueryHeap &reverse_heap,
+                          QueryHeap &forward_core_heap,
+                          QueryHeap &reverse_core_heap,
+                          const NodeID source,
+                          const NodeID target) const
+    {
+        forward_heap.Clear();
+        reverse_heap.Clear();
+        forward_heap.Insert(source, 0, source);
+        reverse_heap.Insert(target, 0, target);
+
+        EdgeWeight weight = INVALID_EDGE_WEIGHT;
+        std::vector<NodeID> packed_path;
+        if (super::facade->HasCore())
+        {
+            super::SearchWithCore(forward_heap,
+                                  reverse_heap,
+                                  forward_core_heap,
+                                  reverse_core_heap,
+                                  weight,
+                                  packed_path,
+                                  false,
+                                  false);
+        }
+        else
+        {
+            super::Search(forward_heap, reverse_heap, weight, packed_path, false, false);
+        }
+        return weight;
+    }
+};
+
+// Contracts a grid with random weights, roads in both directions and a few long one-ways
+// between random nodes, which act as the fast roads of a real network. With a core factor
+// below 1 the top of the hierarchy is left as a core with the given number of landmarks.
+GraphFacade buildGraph(const unsigned grid_size,
+                       const double core_factor = 1.0,
+                       const unsigned number_of_landmarks = 0)
+{
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<EdgeWeight> weight_udist(10, 100);
+    const unsigned number_of_nodes = grid_size * grid_size;
+    std::uniform_int_distribution<NodeID> node_udist(0, number_of_nodes - 1);
+
+    util::ChunkedVector<extractor::EdgeBasedEdge> edges;
+    const auto addEdge = [&](const NodeID from, const NodeID to, const EdgeWeight weight) {
+        edges.push_back(extractor::EdgeBasedEdge{
+            from, to, static_cast<NodeID>(edges.size()), weight, 0.f, true, false});
+    };
+
+    for (const auto row : util::irange(0u, grid_size))
+    {
+        for (const auto column : util::irange(0u, grid_size))
+        {
+            const NodeID node = row * grid_size + column;
+            if (column + 1 < grid_size)
+            {
+                addEdge(node, node + 1, weight_udist(mt_rand));
+                addEdge(node + 1, node, weight_udist(mt_rand));
+            }
+            if (row + 1 < grid_size)
+            {
+                addEdge(node, node + grid_size, weight_udist(mt_rand));
+                addEdge(node + grid_size, node, weight_udist(mt_rand));
+            }
+        }
+    }
+
+    for (unsigned shortcut = 0; shortcut < number_of_nodes / 100; ++shortcut)
+    {
+        addEdge(node_udist(mt_rand), node_udist(mt_rand), 50 * weight_udist(mt_rand));
+    }
+
+    // u-turns are never cheaper than zero, so no loops are added to the graph
+    contractor::GraphContractor graph_contractor(
+        number_of_nodes, edges, {}, std::vector<EdgeWeight>(number_of_nodes, 0));
+    graph_contractor.Run(core_factor);
+    util::ChunkedVector<contractor::QueryEdge> contracted_edges;
+    graph_contractor.GetEdges(contracted_edges);
+
+    std::vector<GraphFacade::Graph::InputEdge> graph_edges;
+    graph_edges.reserve(contracted_edges.size());
+    for (const auto &edge : contracted_edges)
+    {
+        graph_edges.emplace_back(edge.source, edge.target, edge.data);
+    }
+    std::sort(graph_edges.begin(), graph_edges.end());
+
+    if (core_factor >= 1.0)
+    {
+        return GraphFacade(GraphFacade::Graph(number_of_nodes, graph_edges));
+    }
+
+    std::vector<bool> is_core_node;
+    graph_contractor.GetCoreMarker(is_core_node);
+    auto landmarks =
+        contractor::computeCoreLandmarks(graph_edges, is_core_node, number_of_landmarks);
+    return GraphFacade(GraphFacade::Graph(number_of_nodes, graph_edges),
+                       std::move(is_core_node),
+                       std::move(landmarks));
+}
+
+void benchmarkQueries(const std::string &name,
+                      const StallingMode mode,
+                      GraphFacade &facade,
+                      const std::vector<std::pair<NodeID, NodeID>> &queries,
+                      std::vector<EdgeWeight> &weights)
+{
+    QueryRouting routing(&facade);
+    routing.SetStallingMode(mode);
+    QueryHeap forward_heap(facade.GetNumberOfNodes());
+    QueryHeap reverse_heap(facade.GetNumberOfNodes());
+    QueryHeap forward_core_heap(facade.GetNumberOfNodes());
+    QueryHeap reverse_core_heap(facade.GetNumberOfNodes());
+
+    std::cout << "Running " << name << " with " << queries.size() << " queries: " << std::flush;
+
+    std::vector<EdgeWeight> result;
+    result.reserve(queries.size());
+    facade.ResetNumberOfScans();
+    TIMER_START(query);
+    for (const auto &query : queries)
+    {
+        result.push_back(routing(forward_heap,
+                                 reverse_heap,
+                                 forward_core_heap,
+                                 reverse_core_heap,
+                                 query.first,
+                                 query.second));
+    }
+    TIMER_STOP(query);
+
+    std::cout << "Took " << TIMER_MSEC(query) << "ms  ->  " << TIMER_MSEC(query) / queries.size()
+              << " ms/query (" << facade.GetNumberOfScans() / queries.size()
+              << " nodes scanned/query)" << std::endl;
+
+    if (weights.empty())
+    {
+        weights = std::move(result);
+    }
+    else if (weights != result)
+    {
+        std::cout << "Error: " << name << " found different shortest paths" << std::endl;
+    }
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned grid_size = argc > 1 ? std::stoul(argv[1]) : 300;
+    const unsigned num_queries = argc > 2 ? std::stoul(argv[2]) : 1000;
+    const double core_factor = argc > 3 ? std::stod(argv[3]) : 0.9;
+    const unsigned number_of_landmarks = argc > 4 ? std::stoul(argv[4]) : 16;
+
+    if (grid_size < 2 || core_factor <= 0 || core_factor > 1)
+    {
+        std::cout << "./query-bench [grid_size] [num_queries] [core_factor] [landmarks]"
+                  << "\n";
+        return EXIT_FAILURE;
+    }
+
+    using namespace osrm;
+    using namespace osrm::benchmarks;
+
+    GraphFacade facade = buildGraph(grid_size);
+
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<NodeID> node_udist(0, facade.GetNumberOfNodes() - 1);
+    std::vector<std::pair<NodeID, NodeID>> queries;
+    for (unsigned query = 0; query < num_queries; ++query)
+    {
+        queries.emplace_back(node_udist(mt_rand), node_udist(mt_rand));
+    }
+
+    std::vector<EdgeWeight> weights;
+    benchmarkQueries("no stalling", StallingMode::Disabled, facade, queries, weights);
+    benchmarkQueries("stalling on settle", StallingMode::OnSettle, facade, queries, weights);
+    benchmarkQueries("stall-on-demand", StallingMode::OnDemand, facade, queries, weights);
+
+    if (core_factor < 1.0)
+    {
+        GraphFacade core_facade = buildGraph(grid_size, core_factor, number_of_landmarks);
+        benchmarkQueries("core Dijkstra", StallingMode::OnSettle, core_facade, queries, weights);
+        core_facade.UseLandmarks(true);
+        benchmarkQueries("core ALT", StallingMode::OnSettle, core_facade, queries, weights);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,432 @@
+#include "engine/polyline_compressor.hpp"
+#include "util/binary_heap.hpp"
+#include "util/coordinate.hpp"
+#include "util/json_container.hpp"
+#include "util/json_renderer.hpp"
+#include "util/name_table.hpp"
+#include "util/packed_vector.hpp"
+#include "util/range_table.hpp"
+#include "util/static_graph.hpp"
+#include "util/typedefs.hpp"
+#include "util/xor_fast_hash_storage.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace osrm
+{
+namespace benchmarks
+{
+
+// Choosen by a fair W20 dice roll (this value is completely arbitrary)
+constexpr unsigned RANDOM_SEED = 13;
+
+struct Options
+{
+    unsigned warmup = 2;
+    unsigned repetitions = 10;
+    int cpu = -1;
+    bool json = false;
+    std::string filter;
+};
+
+// Runs every benchmark warmup times untimed and repetitions times timed and reports the
+// minimum, median and maximum time per operation of the timed runs. A benchmark returns a
+// checksum of its results, so that the compiler can't drop the work.
+class Harness
+{
+  public:
+    explicit Harness(const Options &options) : options(options) {}
+
+    template <typename Function>
+    void Run(const std::string &name, const std::size_t operations, Function function)
+    {
+        if (name.find(options.filter) == std::string::npos)
+        {
+            return;
+        }
+
+        std::uint64_t checksum = 0;
+        for (unsigned run = 0; run < options.warmup; ++run)
+        {
+            checksum += function();
+        }
+
+        std::vector<double> nanoseconds;
+        for (unsigned run = 0; run < options.repetitions; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            checksum += function();
+            const auto stop = std::chrono::steady_clock::now();
+            nanoseconds.push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count() /
+                static_cast<double>(operations));
+        }
+        std::sort(nanoseconds.begin(), nanoseconds.end());
+
+        const double min = nanoseconds.front();
+        const double median = nanoseconds[nanoseconds.size() / 2];
+        const double max = nanoseconds.back();
+        if (options.json)
+        {
+            util::json::Object result;
+            result.values["name"] = name;
+            result.values["operations"] = static_cast<double>(operations);
+            result.values["repetitions"] = static_cast<double>(options.repetitions);
+            result.values["min_ns"] = min;
+            result.values["median_ns"] = median;
+            result.values["max_ns"] = max;
+            result.values["checksum"] = std::to_string(checksum);
+            results.values.push_back(std::move(result));
+        }
+        else
+        {
+            std::cout << name << ": " << median << " ns/op (min " << min << ", max " << max
+                      << ", checksum " << checksum << ")" << std::endl;
+        }
+    }
+
+    // Prints the results of all benchmarks as one JSON document in JSON mode
+    void Finish() const
+    {
+        if (options.json)
+        {
+            util::json::Object document;
+            document.values["warmup"] = static_cast<double>(options.warmup);
+            document.values["cpu"] = static_cast<double>(options.cpu);
+            document.values["benchmarks"] = results;
+            util::json::render(std::cout, document);
+            std::cout << std::endl;
+        }
+    }
+
+  private:
+    const Options options;
+    util::json::Array results;
+};
+
+// Binds the process to a CPU, so that the timings don't include migrations between cores
+bool pinToCPU(const int cpu)
+{
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+struct HeapData
+{
+    HeapData(NodeID parent) : parent(parent) {}
+    NodeID parent;
+};
+
+// The access pattern of a CH query: every search touches a small, random part of a large id
+// space and the heap is cleared between searches. The random numbers are drawn up front.
+template <typename StorageT>
+void benchmarkHeap(Harness &harness, const std::string &name, const unsigned num_nodes)
+{
+    using Heap = util::BinaryHeap<NodeID, NodeID, int, HeapData, StorageT>;
+    const unsigned num_queries = 100;
+    const unsigned relaxations_per_query = 4000;
+
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<NodeID> node_udist(0, num_nodes - 1);
+    std::uniform_int_distribution<int> weight_udist(1, 1000);
+    std::vector<NodeID> targets(num_queries * (relaxations_per_query + 1));
+    std::vector<int> weights(targets.size());
+    std::generate(targets.begin(), targets.end(), [&] { return node_udist(mt_rand); });
+    std::generate(weights.begin(), weights.end(), [&] { return weight_udist(mt_rand); });
+
+    Heap heap(num_nodes);
+    harness.Run(name, num_queries * relaxations_per_query, [&] {
+        std::uint64_t settled = 0;
+        std::size_t next = 0;
+        for (unsigned query = 0; query < num_queries; ++query)
+        {
+            heap.Clear();
+            heap.Insert(targets[next++], 0, SPECIAL_NODEID);
+            for (unsigned relaxed = 0; relaxed < relaxations_per_query && !heap.Empty();)
+            {
+                const NodeID node = heap.DeleteMin();
+                const int weight = heap.GetKey(node);
+                ++settled;
+                for (unsigned edge = 0; edge < 4 && relaxed < relaxations_per_query;
+                     ++edge, ++relaxed, ++next)
+                {
+                    const NodeID to = targets[next];
+                    const int to_weight = weight + weights[next];
+                    if (!heap.WasInserted(to))
+                    {
+                        heap.Insert(to, to_weight, node);
+                    }
+                    else if (!heap.WasRemoved(to) && to_weight < heap.GetKey(to))
+                    {
+                        heap.GetData(to).parent = node;
+                        heap.DecreaseKey(to, to_weight);
+                    }
+                }
+            }
+        }
+        return settled;
+    });
+}
+
+struct GraphEdgeData
+{
+    GraphEdgeData() : distance(0) {}
+    GraphEdgeData(EdgeWeight distance) : distance(distance) {}
+    EdgeWeight distance;
+};
+
+// Sums the targets and weights of the adjacent edges of all nodes in id order and of random
+// nodes, like the scans of a preprocessing pass and the settled nodes of a query
+void benchmarkStaticGraph(Harness &harness, const unsigned num_nodes)
+{
+    using Graph = util::StaticGraph<GraphEdgeData>;
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<NodeID> node_udist(0, num_nodes - 1);
+    std::uniform_int_distribution<unsigned> degree_udist(1, 7);
+    std::uniform_int_distribution<EdgeWeight> weight_udist(1, 1000);
+
+    std::vector<Graph::InputEdge> edges;
+    for (NodeID node = 0; node < num_nodes; ++node)
+    {
+        for (unsigned edge = degree_udist(mt_rand); edge > 0; --edge)
+        {
+            edges.emplace_back(node, node_udist(mt_rand), weight_udist(mt_rand));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    const Graph graph(num_nodes, edges);
+
+    std::vector<NodeID> random_nodes(num_nodes);
+    std::generate(random_nodes.begin(), random_nodes.end(), [&] { return node_udist(mt_rand); });
+
+    const auto sum_adjacent = [&graph](const NodeID node) {
+        std::uint64_t sum = 0;
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            sum += graph.GetTarget(edge) + graph.GetEdgeData(edge).distance;
+        }
+        return sum;
+    };
+    harness.Run("StaticGraph/sequential_adjacency", edges.size(), [&] {
+        std::uint64_t sum = 0;
+        for (NodeID node = 0; node < num_nodes; ++node)
+        {
+            sum += sum_adjacent(node);
+        }
+        return sum;
+    });
+    harness.Run("StaticGraph/random_adjacency", edges.size(), [&] {
+        std::uint64_t sum = 0;
+        for (const auto node : random_nodes)
+        {
+            sum += sum_adjacent(node);
+        }
+        return sum;
+    });
+}
+
+void benchmarkPackedVector(Harness &harness, const std::size_t num_elements)
+{
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<std::uint64_t> id_udist(0, (std::uint64_t{1} << 34) - 1);
+    std::uniform_int_distribution<std::size_t> index_udist(0, num_elements - 1);
+
+    util::PackedVector<OSMNodeID> packed_ids;
+    packed_ids.reserve(num_elements);
+    for (std::size_t i = 0; i < num_elements; ++i)
+    {
+        packed_ids.push_back(OSMNodeID{id_udist(mt_rand)});
+    }
+    std::vector<std::size_t> indices(num_elements);
+    std::generate(indices.begin(), indices.end(), [&] { return index_udist(mt_rand); });
+
+    harness.Run("PackedVector/random_at", indices.size(), [&] {
+        std::uint64_t sum = 0;
+        for (const auto index : indices)
+        {
+            sum += static_cast<std::uint64_t>(packed_ids.at(index));
+        }
+        return sum;
+    });
+}
+
+// Random strings with the lengths of street names, which are stored in blocks of four per name
+// id like the name data of a dataset
+std::vector<std::string> makeNames(const unsigned num_names)
+{
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<unsigned> length_udist(0, 24);
+    std::uniform_int_distribution<int> char_udist('a', 'z');
+    std::vector<std::string> names(num_names);
+    for (auto &name : names)
+    {
+        name.resize(length_udist(mt_rand));
+        std::generate(
+            name.begin(), name.end(), [&] { return static_cast<char>(char_udist(mt_rand)); });
+    }
+    return names;
+}
+
+void benchmarkRangeTableAndNames(Harness &harness, const unsigned num_names)
+{
+    const auto names = makeNames(num_names);
+    std::vector<unsigned> lengths;
+    std::string characters;
+    for (const auto &name : names)
+    {
+        lengths.push_back(name.size());
+        characters += name;
+    }
+    const util::RangeTable<16, false> table(lengths);
+
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<unsigned> id_udist(0, num_names - 1);
+    std::vector<unsigned> ids(num_names);
+    std::generate(ids.begin(), ids.end(), [&] { return id_udist(mt_rand); });
+
+    harness.Run("RangeTable/GetRange", ids.size(), [&] {
+        std::uint64_t sum = 0;
+        for (const auto id : ids)
+        {
+            const auto range = table.GetRange(id);
+            sum += range.front() + range.size();
+        }
+        return sum;
+    });
+
+    // the name table only loads from a file
+    const auto path =
+        boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%%%.names");
+    {
+        boost::filesystem::ofstream name_stream(path, std::ios::binary);
+        name_stream << table;
+        const unsigned number_of_chars = characters.size();
+        name_stream.write(reinterpret_cast<const char *>(&number_of_chars),
+                          sizeof(number_of_chars));
+        name_stream.write(characters.data(), characters.size());
+    }
+    const util::NameTable name_table(path.string());
+    boost::filesystem::remove(path);
+
+    harness.Run("NameTable/GetNameForID", ids.size(), [&] {
+        std::uint64_t sum = 0;
+        for (const auto id : ids)
+        {
+            const auto name = name_table.GetNameForID(id);
+            sum += name.size() + (name.empty() ? 0 : name.front());
+        }
+        return sum;
+    });
+}
+
+// A random walk with steps of up to a few meters, like the geometry of a long route
+void benchmarkPolyline(Harness &harness, const unsigned num_coordinates)
+{
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<std::int32_t> step_udist(-300, 300);
+    std::vector<util::Coordinate> coordinates;
+    std::int32_t lon = 13388860;
+    std::int32_t lat = 52517037;
+    for (unsigned index = 0; index < num_coordinates; ++index)
+    {
+        lon += step_udist(mt_rand);
+        lat += step_udist(mt_rand);
+        coordinates.emplace_back(util::FixedLongitude{lon}, util::FixedLatitude{lat});
+    }
+
+    harness.Run("encodePolyline/polyline", coordinates.size(), [&] {
+        return engine::encodePolyline<100000>(coordinates.begin(), coordinates.end()).size();
+    });
+    harness.Run("encodePolyline/polyline6", coordinates.size(), [&] {
+        return engine::encodePolyline<1000000>(coordinates.begin(), coordinates.end()).size();
+    });
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    using namespace osrm::benchmarks;
+
+    Options options;
+    for (int index = 1; index < argc; ++index)
+    {
+        const std::string argument = argv[index];
+        const bool has_value = index + 1 < argc;
+        if (argument == "--json")
+        {
+            options.json = true;
+        }
+        else if (argument == "--warmup" && has_value)
+        {
+            options.warmup = std::stoul(argv[++index]);
+        }
+        else if (argument == "--repetitions" && has_value)
+        {
+            options.repetitions = std::stoul(argv[++index]);
+        }
+        else if (argument == "--cpu" && has_value)
+        {
+            options.cpu = std::stoi(argv[++index]);
+        }
+        else if (argument == "--filter" && has_value)
+        {
+            options.filter = argv[++index];
+        }
+        else
+        {
+            std::cout << "./micro-bench [--warmup N] [--repetitions N] [--cpu N] [--filter name] "
+                         "[--json]"
+                      << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.repetitions == 0)
+    {
+        options.repetitions = 1;
+    }
+    if (options.cpu >= 0 && !pinToCPU(options.cpu))
+    {
+        std::cerr << "Could not pin the benchmarks to CPU " << options.cpu << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Harness harness(options);
+
+    const unsigned num_nodes = 1000000;
+    benchmarkHeap<osrm::util::ArrayStorage<NodeID, NodeID>>(
+        harness, "BinaryHeap/ArrayStorage", num_nodes);
+    benchmarkHeap<osrm::util::UnorderedMapStorage<NodeID, NodeID>>(
+        harness, "BinaryHeap/UnorderedMapStorage", num_nodes);
+    benchmarkHeap<osrm::util::XORFastHashStorage<NodeID, NodeID>>(
+        harness, "BinaryHeap/XORFastHashStorage", num_nodes);
+    benchmarkStaticGraph(harness, num_nodes);
+    benchmarkPackedVector(harness, num_nodes);
+    benchmarkRangeTableAndNames(harness, num_nodes);
+    benchmarkPolyline(harness, 10000);
+
+    harness.Finish();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+#include "util/packed_vector.hpp"
+#include "util/timing_util.hpp"
+#include "util/typedefs.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace benchmarks
+{
+
+// Choosen by a fair W20 dice roll (this value is completely arbitrary)
+constexpr unsigned RANDOM_SEED = 13;
+
+template <typename Function>
+void benchmark(const std::string &name, const std::size_t num_accesses, Function function)
+{
+    std::cout << "Running " << name << ": " << std::flush;
+
+    TIMER_START(access);
+    const auto checksum = function();
+    TIMER_STOP(access);
+
+    std::cout << "Took " << TIMER_MSEC(access) << "ms  ->  "
+              << TIMER_NSEC(access) / num_accesses << " ns/element (checksum " << checksum << ")"
+              << std::endl;
+}
+
+// Compares the access to OSM node ids in a packed vector with a plain array of them, in the
+// random order of the nodes of a query and in the sequential order of a dataset load.
+void benchmarkPackedVector(const std::size_t num_elements, const std::size_t num_accesses)
+{
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<std::uint64_t> id_udist(0, (std::uint64_t{1} << 34) - 1);
+    std::uniform_int_distribution<std::size_t> index_udist(0, num_elements - 1);
+
+    std::vector<std::uint64_t> raw_ids;
+    util::PackedVector<OSMNodeID> packed_ids;
+    raw_ids.reserve(num_elements);
+    packed_ids.reserve(num_elements);
+    for (std::size_t i = 0; i < num_elements; ++i)
+    {
+        raw_ids.push_back(id_udist(mt_rand));
+        packed_ids.push_back(OSMNodeID{raw_ids.back()});
+    }
+
+    std::vector<std::size_t> indices(num_accesses);
+    for (auto &index : indices)
+    {
+        index = index_udist(mt_rand);
+    }
+
+    std::cout << num_elements << " elements, " << num_elements * sizeof(std::uint64_t) / 1024
+              << " kB raw, " << util::PackedVector<OSMNodeID>::elements_to_blocks(num_elements) *
+                                    sizeof(std::uint64_t) / 1024
+              << " kB packed" << std::endl;
+
+    benchmark("raw random access", num_accesses, [&] {
+        std::uint64_t checksum = 0;
+        for (const auto index : indices)
+        {
+            checksum += raw_ids[index];
+        }
+        return checksum;
+    });
+    benchmark("packed random access", num_accesses, [&] {
+        std::uint64_t checksum = 0;
+        for (const auto index : indices)
+        {
+            checksum += static_cast<std::uint64_t>(packed_ids.at(index));
+        }
+        return checksum;
+    });
+
+    std::vector<std::uint64_t> copied(num_elements);
+    benchmark("raw copy", num_elements, [&] {
+        std::copy(raw_ids.begin(), raw_ids.end(), copied.begin());
+        return copied.back();
+    });
+    std::vector<OSMNodeID> decoded(num_elements);
+    benchmark("packed at() copy", num_elements, [&] {
+        for (std::size_t index = 0; index < num_elements; ++index)
+        {
+            decoded[index] = packed_ids.at(index);
+        }
+        return static_cast<std::uint64_t>(decoded.back());
+    });
+    benchmark("packed decode_range", num_elements, [&] {
+        packed_ids.decode_range(0, num_elements, decoded.begin());
+        return static_cast<std::uint64_t>(decoded.back());
+    });
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    const std::size_t num_elements = argc > 1 ? std::stoul(argv[1]) : 100000000;
+    const std::size_t num_accesses = argc > 2 ? std::stoul(argv[2]) : 10000000;
+
+    if (num_elements == 0)
+    {
+        std::cout << "./packedvector-bench [num_elements] [num_accesses]"
+                  << "\n";
+        return EXIT_FAILURE;
+    }
+
+    osrm::benchmarks::benchmarkPackedVector(num_elements, num_accesses);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+#include "engine/polyline_compressor.hpp"
+#include "util/coordinate.hpp"
+#include "util/timing_util.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace benchmarks
+{
+
+// Choosen by a fair W20 dice roll (this value is completely arbitrary)
+constexpr unsigned RANDOM_SEED = 13;
+
+// A random walk with steps of up to a few meters, like the geometry of a long route
+std::vector<util::Coordinate> makeGeometry(const unsigned num_coordinates)
+{
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<std::int32_t> step_udist(-300, 300);
+
+    std::vector<util::Coordinate> coordinates;
+    coordinates.reserve(num_coordinates);
+    std::int32_t lon = 13388860;
+    std::int32_t lat = 52517037;
+    for (unsigned index = 0; index < num_coordinates; ++index)
+    {
+        lon += step_udist(mt_rand);
+        lat += step_udist(mt_rand);
+        coordinates.emplace_back(util::FixedLongitude{lon}, util::FixedLatitude{lat});
+    }
+    return coordinates;
+}
+
+template <unsigned PRECISION>
+void benchmarkEncoding(const std::string &name,
+                       const std::vector<util::Coordinate> &coordinates,
+                       const unsigned num_runs)
+{
+    std::cout << "Encoding " << coordinates.size() << " coordinates as " << name << " "
+              << num_runs << " times: " << std::flush;
+
+    std::size_t characters = 0;
+    TIMER_START(encode);
+    for (unsigned run = 0; run < num_runs; ++run)
+    {
+        characters += engine::encodePolyline<PRECISION>(coordinates.begin(), coordinates.end())
+                          .size();
+    }
+    TIMER_STOP(encode);
+
+    std::cout << "Took " << TIMER_MSEC(encode) << "ms  ->  " << TIMER_MSEC(encode) / num_runs
+              << " ms/polyline (" << characters / num_runs << " characters)" << std::endl;
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned num_coordinates = argc > 1 ? std::stoul(argv[1]) : 50000;
+    const unsigned num_runs = argc > 2 ? std::stoul(argv[2]) : 1000;
+
+    if (num_coordinates == 0 || num_runs == 0)
+    {
+        std::cout << "./polyline-bench [num_coordinates] [num_runs]"
+                  << "\n";
+        return EXIT_FAILURE;
+    }
+
+    using namespace osrm::benchmarks;
+    const auto coordinates = makeGeometry(num_coordinates);
+    benchmarkEncoding<100000>("polyline", coordinates, num_runs);
+    benchmarkEncoding<1000000>("polyline6", coordinates, num_runs);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,299 @@
+#include "server/api/parsed_url.hpp"
+#include "server/api/url_parser.hpp"
+#include "server/service_handler.hpp"
+#include "util/json_renderer.hpp"
+#include "util/string_util.hpp"
+
+#include "osrm/engine_config.hpp"
+#include "osrm/json_container.hpp"
+#include "osrm/status.hpp"
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace benchmarks
+{
+
+using Clock = std::chrono::steady_clock;
+
+// A query of the workload. The label groups the queries in the report, it defaults to the
+// service so that route queries with and without steps can be told apart by labelling them.
+struct Query
+{
+    std::size_t label;
+    server::api::ParsedURL url;
+};
+
+struct Workload
+{
+    std::vector<std::string> labels;
+    std::vector<Query> queries;
+};
+
+// Every line of a workload is a request as osrm-routed gets it, optionally prefixed by a label
+// and a space. Scheme and host are dropped, so the .requests of test/data work as well:
+//
+//   # comment
+//   /route/v1/driving/7.416351,43.731205;7.420363,43.736189?steps=true
+//   route-alternatives /route/v1/driving/7.416351,43.731205;7.420363,43.736189?alternatives=true
+//   http://127.0.0.1:5000/nearest/v1/driving/7.416351,43.731205
+Workload readWorkload(const std::string &path)
+{
+    boost::filesystem::ifstream input(path);
+    if (!input)
+    {
+        throw std::runtime_error("Could not open " + path);
+    }
+
+    Workload workload;
+    std::string line;
+    for (std::size_t line_number = 1; std::getline(input, line); ++line_number)
+    {
+        boost::algorithm::trim(line);
+        if (line.empty() || line.front() == '#')
+        {
+            continue;
+        }
+
+        std::string label;
+        const auto space = line.find(' ');
+        if (space != std::string::npos)
+        {
+            label = line.substr(0, space);
+            line = boost::algorithm::trim_copy(line.substr(space + 1));
+        }
+        const auto scheme = line.find("://");
+        if (scheme != std::string::npos)
+        {
+            const auto path_begin = line.find('/', scheme + 3);
+            line = path_begin == std::string::npos ? std::string() : line.substr(path_begin);
+        }
+
+        std::string request;
+        util::URIDecode(line, request);
+        auto iter = request.begin();
+        const auto url = server::api::parseURL(iter, request.end());
+        if (!url || iter != request.end())
+        {
+            throw std::runtime_error(path + ":" + std::to_string(line_number) +
+                                     ": not a valid request");
+        }
+        if (label.empty())
+        {
+            label = url->service;
+        }
+
+        const auto known = std::find(workload.labels.begin(), workload.labels.end(), label);
+        const std::size_t label_index = std::distance(workload.labels.begin(), known);
+        if (known == workload.labels.end())
+        {
+            workload.labels.push_back(label);
+        }
+        workload.queries.push_back(Query{label_index, *url});
+    }
+
+    if (workload.queries.empty())
+    {
+        throw std::runtime_error(path + " contains no queries");
+    }
+    return workload;
+}
+
+struct Sample
+{
+    std::size_t label;
+    std::chrono::nanoseconds duration;
+    bool failed;
+};
+
+// Runs and renders a query like osrm-routed does, without the HTTP connection
+Sample runQuery(server::ServiceHandler &handler, const Query &query, std::string &buffer)
+{
+    const auto start = Clock::now();
+    server::ServiceHandler::ResultT result;
+    const auto status = handler.RunQuery(query.url, result);
+    buffer.clear();
+    if (result.is<util::json::Object>())
+    {
+        util::json::render(buffer, result.get<util::json::Object>());
+    }
+    else if (result.is<server::service::RenderedJSON>())
+    {
+        buffer = std::move(result.get<server::service::RenderedJSON>().value);
+    }
+    else
+    {
+        buffer = std::move(result.get<std::string>());
+    }
+    const auto duration = Clock::now() - start;
+    return Sample{query.label,
+                  std::chrono::duration_cast<std::chrono::nanoseconds>(duration),
+                  status != engine::Status::Ok};
+}
+
+// the smallest duration that at least the given share of the sorted durations doesn't exceed
+double getQuantile(const std::vector<std::chrono::nanoseconds> &sorted, const double quantile)
+{
+    const auto rank = std::max<std::size_t>(1, std::ceil(quantile * sorted.size()));
+    return sorted[rank - 1].count() / 1e6;
+}
+
+void printLine(const std::string &label,
+               std::vector<std::chrono::nanoseconds> durations,
+               const std::size_t failures,
+               const double seconds)
+{
+    std::sort(durations.begin(), durations.end());
+    std::chrono::nanoseconds sum(0);
+    for (const auto duration : durations)
+    {
+        sum += duration;
+    }
+
+    std::cout << std::left << std::setw(24) << label << std::right << std::setw(9)
+              << durations.size() << std::setw(8) << failures << std::fixed << std::setprecision(1)
+              << std::setw(11) << durations.size() / seconds << std::setprecision(3)
+              << std::setw(10) << sum.count() / 1e6 / durations.size() << std::setw(10)
+              << getQuantile(durations, 0.5) << std::setw(10) << getQuantile(durations, 0.95)
+              << std::setw(10) << getQuantile(durations, 0.99) << std::endl;
+}
+
+// Replays the workload the given number of times with the given number of threads. The threads
+// take the next query of the workload in turn, so every run does the same queries.
+void benchmarkWorkload(server::ServiceHandler &handler,
+                       const Workload &workload,
+                       const unsigned number_of_threads,
+                       const std::size_t repetitions)
+{
+    const auto number_of_queries = workload.queries.size() * repetitions;
+    std::atomic<std::size_t> next_query(0);
+    std::vector<std::vector<Sample>> thread_samples(number_of_threads);
+
+    const auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned thread = 0; thread < number_of_threads; ++thread)
+    {
+        threads.emplace_back([&, thread] {
+            auto &samples = thread_samples[thread];
+            samples.reserve(number_of_queries / number_of_threads + 1);
+            std::string buffer;
+            for (auto index = next_query++; index < number_of_queries; index = next_query++)
+            {
+                samples.push_back(runQuery(
+                    handler, workload.queries[index % workload.queries.size()], buffer));
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    const auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<std::vector<std::chrono::nanoseconds>> label_durations(workload.labels.size());
+    std::vector<std::size_t> label_failures(workload.labels.size(), 0);
+    std::vector<std::chrono::nanoseconds> all_durations;
+    std::size_t all_failures = 0;
+    for (const auto &samples : thread_samples)
+    {
+        for (const auto &sample : samples)
+        {
+            label_durations[sample.label].push_back(sample.duration);
+            label_failures[sample.label] += sample.failed;
+            all_durations.push_back(sample.duration);
+            all_failures += sample.failed;
+        }
+    }
+
+    std::cout << "\n" << number_of_threads << " thread(s), " << seconds << "s\n";
+    std::cout << std::left << std::setw(24) << "label" << std::right << std::setw(9) << "queries"
+              << std::setw(8) << "errors" << std::setw(11) << "queries/s" << std::setw(10)
+              << "mean ms" << std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms"
+              << std::setw(10) << "p99 ms" << std::endl;
+    for (std::size_t label = 0; label < workload.labels.size(); ++label)
+    {
+        printLine(workload.labels[label], label_durations[label], label_failures[label], seconds);
+    }
+    printLine("all", std::move(all_durations), all_failures, seconds);
+}
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " data.osrm workload [threads, e.g. 1,2,4,8] [repetitions] [prefetch]\n"
+                  << "Pass shared instead of a .osrm to use a dataset of osrm-datastore\n"
+                  << "Pass prefetch to prefetch the search graph as --prefetch-search-graph\n";
+        return EXIT_FAILURE;
+    }
+
+    using namespace osrm;
+
+    const std::string data_path = argv[1];
+    const auto workload = benchmarks::readWorkload(argv[2]);
+
+    std::vector<unsigned> thread_counts;
+    std::vector<std::string> thread_arguments;
+    const std::string threads_argument = argc > 3 ? argv[3] : "1";
+    boost::algorithm::split(
+        thread_arguments, threads_argument, [](const char c) { return c == ','; });
+    for (const auto &argument : thread_arguments)
+    {
+        thread_counts.push_back(std::max(1, std::stoi(argument)));
+    }
+    const std::size_t repetitions = argc > 4 ? std::max(1, std::stoi(argv[4])) : 10;
+
+    // no caches, every repetition of a query does the same work
+    EngineConfig config;
+    config.use_shared_memory = data_path == "shared";
+    config.prefetch_search_graph = argc > 5 && std::string(argv[5]) == "prefetch";
+    if (!config.use_shared_memory)
+    {
+        config.storage_config = {data_path};
+    }
+    server::ServiceHandler handler(config);
+
+    std::cout << workload.queries.size() << " queries with " << workload.labels.size()
+              << " label(s), " << repetitions << " repetition(s)" << std::endl;
+
+    // fault the dataset in before anything is measured
+    std::string buffer;
+    for (const auto &query : workload.queries)
+    {
+        benchmarks::runQuery(handler, query, buffer);
+    }
+
+    for (const auto number_of_threads : thread_counts)
+    {
+        benchmarks::benchmarkWorkload(handler, workload, number_of_threads, repetitions);
+    }
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
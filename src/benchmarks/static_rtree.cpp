@@ -10,6 +10,7 @@
 #include <random>
 
 #include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
 
 namespace osrm
 {
@@ -67,6 +68,35 @@ void benchmarkQuery(const std::vector<util::Coordinate> &queries,
               << ")" << std::endl;
 }
 
+// Builds a tree of the segments between consecutive coordinates into temporary files
+void benchmarkConstruction(const std::vector<util::Coordinate> &coords)
+{
+    std::vector<RTreeLeaf> segments(coords.size() > 0 ? coords.size() - 1 : 0);
+    for (std::size_t i = 0; i < segments.size(); ++i)
+    {
+        segments[i].forward_segment_id = {static_cast<NodeID>(i), true};
+        segments[i].reverse_segment_id = {SPECIAL_SEGMENTID, false};
+        segments[i].u = i;
+        segments[i].v = i + 1;
+    }
+
+    const auto temporary_path =
+        boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    const auto nodes_path = temporary_path.string() + ".ramIndex";
+    const auto leaves_path = temporary_path.string() + ".fileIndex";
+
+    std::cout << "Building RTree of " << segments.size() << " segments: " << std::flush;
+    TIMER_START(construction);
+    {
+        BenchStaticRTree rtree(segments, nodes_path, leaves_path, coords);
+    }
+    TIMER_STOP(construction);
+    std::cout << "Took " << TIMER_SEC(construction) << " seconds" << std::endl;
+
+    boost::filesystem::remove(nodes_path);
+    boost::filesystem::remove(leaves_path);
+}
+
 void benchmark(BenchStaticRTree &rtree, unsigned num_queries)
 {
     std::mt19937 mt_rand(RANDOM_SEED);
@@ -107,6 +137,7 @@ int main(int argc, char **argv)
     osrm::benchmarks::BenchStaticRTree rtree(ram_path, file_path, coords);
 
     osrm::benchmarks::benchmark(rtree, 10000);
+    osrm::benchmarks::benchmarkConstruction(coords);
 
     return 0;
 }
@@ -1,15 +1,27 @@
 #include "contractor/contractor.hpp"
 #include "contractor/crc32_processor.hpp"
 #include "contractor/graph_contractor.hpp"
+#include "contractor/graph_recustomizer.hpp"
+#include "contractor/nested_dissection_order.hpp"
+#include "contractor/node_renumbering.hpp"
+#include "contractor/query_graph.hpp"
+#include "contractor/update_lookups.hpp"
 
+#include "extractor/compressed_edge_based_edges.hpp"
 #include "extractor/compressed_edge_container.hpp"
+#include "extractor/compressed_geometry.hpp"
 #include "extractor/edge_based_graph_factory.hpp"
 #include "extractor/node_based_edge.hpp"
 
+#include "partition/multi_level_partition.hpp"
+
+#include "util/async_io.hpp"
 #include "util/exception.hpp"
 #include "util/graph_loader.hpp"
 #include "util/integer_range.hpp"
 #include "util/io.hpp"
+#include "util/make_unique.hpp"
+#include "util/phase_trace.hpp"
 #include "util/simple_logger.hpp"
 #include "util/static_graph.hpp"
 #include "util/static_rtree.hpp"
@@ -19,58 +31,105 @@
 
 #include <boost/assert.hpp>
 #include <boost/filesystem/fstream.hpp>
-#include <boost/functional/hash.hpp>
+#include <boost/filesystem/operations.hpp>
 #include <boost/interprocess/file_mapping.hpp>
 #include <boost/interprocess/mapped_region.hpp>
-#include <boost/spirit/include/qi.hpp>
 
 #include <tbb/blocked_range.h>
-#include <tbb/concurrent_unordered_map.h>
 #include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_for_each.h>
 #include <tbb/parallel_invoke.h>
 #include <tbb/parallel_sort.h>
-#include <tbb/spin_mutex.h>
 
 #include <algorithm>
+#include <atomic>
 #include <bitset>
+#include <csignal>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <thread>
 #include <tuple>
 #include <vector>
 
-namespace std
+namespace osrm
+{
+namespace contractor
 {
 
-template <> struct hash<std::pair<OSMNodeID, OSMNodeID>>
+namespace
 {
-    std::size_t operator()(const std::pair<OSMNodeID, OSMNodeID> &k) const noexcept
+
+// Set by SIGTERM and SIGINT while a contraction writes checkpoints
+std::atomic<bool> stop_requested{false};
+
+void requestStop(int) { stop_requested = true; }
+
+// A termination notice, e.g. of a preemptible instance, stops the contraction after the running
+// round with a checkpoint instead of losing it
+class ScopedStopSignals
+{
+  public:
+    ScopedStopSignals()
+        : previous_term_handler(std::signal(SIGTERM, requestStop)),
+          previous_int_handler(std::signal(SIGINT, requestStop))
+    {
+    }
+
+    ~ScopedStopSignals()
     {
-        return static_cast<uint64_t>(k.first) ^ (static_cast<uint64_t>(k.second) << 12);
+        std::signal(SIGTERM, previous_term_handler);
+        std::signal(SIGINT, previous_int_handler);
     }
+
+  private:
+    using Handler = void (*)(int);
+    Handler previous_term_handler;
+    Handler previous_int_handler;
 };
 
-template <> struct hash<std::tuple<OSMNodeID, OSMNodeID, OSMNodeID>>
+// The source of the speed of every segment, an empty list if all are from the profile
+void writeDatasourceIndexes(const std::string &filename,
+                            const std::vector<std::uint8_t> &datasources)
 {
-    std::size_t operator()(const std::tuple<OSMNodeID, OSMNodeID, OSMNodeID> &k) const noexcept
+    std::ofstream datasource_stream(filename, std::ios::binary);
+    if (!datasource_stream)
     {
-        std::size_t seed = 0;
-        boost::hash_combine(seed, static_cast<uint64_t>(std::get<0>(k)));
-        boost::hash_combine(seed, static_cast<uint64_t>(std::get<1>(k)));
-        boost::hash_combine(seed, static_cast<uint64_t>(std::get<2>(k)));
-        return seed;
+        throw util::exception("Failed to open " + filename + " for writing");
+    }
+    std::uint64_t number_of_datasource_entries = datasources.size();
+    datasource_stream.write(reinterpret_cast<const char *>(&number_of_datasource_entries),
+                            sizeof(number_of_datasource_entries));
+    if (number_of_datasource_entries > 0)
+    {
+        datasource_stream.write(reinterpret_cast<const char *>(&(datasources[0])),
+                                number_of_datasource_entries * sizeof(uint8_t));
     }
-};
 }
 
-namespace osrm
-{
-namespace contractor
+void writeDatasourceNames(const std::string &filename,
+                          const std::vector<std::string> &segment_speed_filenames)
 {
+    std::ofstream datasource_stream(filename, std::ios::binary);
+    if (!datasource_stream)
+    {
+        throw util::exception("Failed to open " + filename + " for writing");
+    }
+    datasource_stream << "lua profile" << std::endl;
+    for (auto const &name : segment_speed_filenames)
+    {
+        // Only write the filename, without path or extension.
+        // This prevents information leakage, and keeps names short
+        // for rendering in the debug tiles.
+        const boost::filesystem::path p(name);
+        datasource_stream << p.stem().string() << std::endl;
+    }
+}
+}
 
 // Returns duration in deci-seconds
 inline EdgeWeight distanceAndSpeedToWeight(double distance_in_meters, double speed_in_kmh)
@@ -81,287 +140,418 @@ inline EdgeWeight distanceAndSpeedToWeight(double distance_in_meters, double spe
     return std::max<EdgeWeight>(1, static_cast<EdgeWeight>(std::round(duration * 10)));
 }
 
-int Contractor::Run()
+namespace
 {
-#ifdef WIN32
-#pragma message("Memory consumption on Windows can be higher due to different bit packing")
-#else
-    static_assert(sizeof(extractor::NodeBasedEdge) == 24,
-                  "changing extractor::NodeBasedEdge type has influence on memory consumption!");
-    static_assert(sizeof(extractor::EdgeBasedEdge) == 16,
-                  "changing EdgeBasedEdge type has influence on memory consumption!");
-#endif
 
-    if (config.core_factor > 1.0 || config.core_factor < 0)
-    {
-        throw util::exception("Core factor must be between 0.0 to 1.0 (inclusive)");
-    }
+// Set the struct packing to 1 byte word sizes.  This prevents any padding.  We only read
+// this struct once, so any alignment penalty is trivial.  If this is *not* done, then
+// the struct will be padded out by an extra 4 bytes, and sizeof() will mean we read
+// too much data from the original file.
+#pragma pack(push, r1, 1)
+struct EdgeBasedGraphHeader
+{
+    util::FingerPrint fingerprint;
+    std::uint64_t number_of_edges;
+    EdgeID max_edge_id;
+};
+#pragma pack(pop, r1)
 
-    TIMER_START(preparing);
+boost::interprocess::mapped_region mmapFile(const std::string &filename)
+{
+    using boost::interprocess::file_mapping;
+    using boost::interprocess::mapped_region;
+    using boost::interprocess::read_only;
+
+    const file_mapping mapping{filename.c_str(), read_only};
+    mapped_region region{mapping, read_only};
+    region.advise(mapped_region::advice_sequential);
+    return region;
+}
 
-    util::SimpleLogger().Write() << "Loading edge-expanded graph representation";
+// Computes the weights of the edges of the .ebg from their segments in the segment lookup and
+// their turns in the penalty file, with the speeds and turn penalties of the lookups where they
+// have one. set_weight is called with the index of every edge in the .ebg and its weight in the
+// order of the edges, INVALID_EDGE_WEIGHT if a speed of 0 closes the edge.
+//
+// The edges are computed in blocks: the segments and turns of a block are looked up at once,
+// which merges them with the sorted lookups instead of searching the lookups for each of them,
+// then the weights of the block are computed in the order of the edges.
+template <typename SetWeightT>
+void computeEdgeWeights(const char *edge_segment_byte_ptr,
+                        const extractor::lookup::PenaltyBlock *penaltyblock,
+                        const std::size_t number_of_edges,
+                        const SegmentSpeedLookup &segment_speed_lookup,
+                        const TurnPenaltyLookup &turn_penalty_lookup,
+                        const SetWeightT &set_weight)
+{
+    const std::size_t UPDATE_BLOCK_SIZE = 1024 * 1024;
+    std::vector<const extractor::lookup::SegmentHeaderBlock *> block_headers;
+    std::vector<std::size_t> block_segment_offsets;
+    std::vector<Segment> block_segments;
+    std::vector<Turn> block_turns;
+    std::vector<const SpeedSource *> block_speeds;
+    std::vector<const PenaltySource *> block_penalties;
+
+    std::size_t edge_index = 0;
+    while (edge_index != number_of_edges)
+    {
+        const auto block_size =
+            std::min<std::size_t>(UPDATE_BLOCK_SIZE, number_of_edges - edge_index);
+        const auto block_begin = edge_index;
+        edge_index += block_size;
+
+        // the segments of an edge follow its header, so the headers are found by walking them
+        block_headers.resize(block_size);
+        block_segment_offsets.resize(block_size + 1);
+        block_segments.clear();
+        block_turns.resize(block_size);
+        block_segment_offsets[0] = 0;
+        for (const auto index : util::irange<std::size_t>(0, block_size))
+        {
+            const auto header = reinterpret_cast<const extractor::lookup::SegmentHeaderBlock *>(
+                edge_segment_byte_ptr);
+            edge_segment_byte_ptr += sizeof(extractor::lookup::SegmentHeaderBlock);
+            const auto segmentblocks =
+                reinterpret_cast<const extractor::lookup::SegmentBlock *>(edge_segment_byte_ptr);
+            const auto num_segments = header->num_osm_nodes - 1;
+            edge_segment_byte_ptr += sizeof(extractor::lookup::SegmentBlock) * num_segments;
+
+            auto previous_osm_node_id = header->previous_osm_node_id;
+            for (const auto i : util::irange<std::size_t>(0, num_segments))
+            {
+                block_segments.push_back(
+                    Segment{previous_osm_node_id, segmentblocks[i].this_osm_node_id});
+                previous_osm_node_id = segmentblocks[i].this_osm_node_id;
+            }
 
-    util::DeallocatingVector<extractor::EdgeBasedEdge> edge_based_edge_list;
+            block_headers[index] = header;
+            block_segment_offsets[index + 1] = block_segments.size();
+            const auto &turn = penaltyblock[index];
+            block_turns[index] = Turn{turn.from_id, turn.via_id, turn.to_id};
+        }
 
-    EdgeID max_edge_id = LoadEdgeExpandedGraph(config.edge_based_graph_path,
-                                               edge_based_edge_list,
-                                               config.edge_segment_lookup_path,
-                                               config.edge_penalty_path,
-                                               config.segment_speed_lookup_paths,
-                                               config.turn_penalty_lookup_paths,
-                                               config.node_based_graph_path,
-                                               config.geometry_path,
-                                               config.datasource_names_path,
-                                               config.datasource_indexes_path,
-                                               config.rtree_leaf_path);
+        find(segment_speed_lookup, block_segments, block_speeds);
+        find(turn_penalty_lookup, block_turns, block_penalties);
 
-    // Contracting the edge-expanded graph
+        for (const auto index : util::irange<std::size_t>(0, block_size))
+        {
+            const auto header = block_headers[index];
+            const auto segmentblocks = reinterpret_cast<const extractor::lookup::SegmentBlock *>(
+                reinterpret_cast<const char *>(header) +
+                sizeof(extractor::lookup::SegmentHeaderBlock));
+            const auto first_segment = block_segment_offsets[index];
+            int new_weight = 0;
+            int compressed_edge_nodes = static_cast<int>(header->num_osm_nodes);
 
-    TIMER_START(contraction);
-    std::vector<bool> is_core_node;
-    std::vector<float> node_levels;
-    if (config.use_cached_priority)
-    {
-        ReadNodeLevels(node_levels);
-    }
+            bool skip_this_edge = false;
+            for (auto segment = first_segment; segment < block_segment_offsets[index + 1];
+                 ++segment)
+            {
+                const auto &segmentblock = segmentblocks[segment - first_segment];
+                const auto speed_source = block_speeds[segment];
+                if (speed_source)
+                {
+                    if (speed_source->speed > 0)
+                    {
+                        auto new_segment_weight = distanceAndSpeedToWeight(
+                            segmentblock.segment_length, speed_source->speed);
+                        new_weight += new_segment_weight;
+                    }
+                    else
+                    {
+                        // If we hit a 0-speed edge, then it's effectively not traversible.
+                        // We don't want to include it in the routing network, so
+                        // we set a flag and `continue` the parent loop as soon as we can.
+                        skip_this_edge = true;
+                        break;
+                    }
+                }
+                else
+                {
+                    // If no lookup found, use the original weight value for this segment
+                    new_weight += segmentblock.segment_weight;
+                }
+            }
 
-    util::SimpleLogger().Write() << "Reading node weights.";
-    std::vector<EdgeWeight> node_weights;
-    std::string node_file_name = config.osrm_input_path.string() + ".enw";
-    if (util::deserializeVector(node_file_name, node_weights))
-    {
-        util::SimpleLogger().Write() << "Done reading node weights.";
-    }
-    else
-    {
-        throw util::exception("Failed reading node weights.");
-    }
+            // We found a zero-speed edge, so we'll skip this whole edge-based-edge which
+            // effectively removes it from the routing network.
+            if (skip_this_edge)
+            {
+                set_weight(block_begin + index, INVALID_EDGE_WEIGHT);
+                continue;
+            }
 
-    util::DeallocatingVector<QueryEdge> contracted_edge_list;
-    ContractGraph(max_edge_id,
-                  edge_based_edge_list,
-                  contracted_edge_list,
-                  std::move(node_weights),
-                  is_core_node,
-                  node_levels);
-    TIMER_STOP(contraction);
+            const auto &turn = penaltyblock[index];
+            const auto turn_penalty_source = block_penalties[index];
+            if (turn_penalty_source)
+            {
+                int new_turn_weight = static_cast<int>(turn_penalty_source->penalty * 10);
 
-    util::SimpleLogger().Write() << "Contraction took " << TIMER_SEC(contraction) << " sec";
+                if (new_turn_weight + new_weight < compressed_edge_nodes)
+                {
+                    util::SimpleLogger().Write(logWARNING)
+                        << "turn penalty " << turn_penalty_source->penalty << " for turn "
+                        << turn.from_id << ", " << turn.via_id << ", " << turn.to_id
+                        << " is too negative: clamping turn weight to " << compressed_edge_nodes;
+                }
 
-    std::size_t number_of_used_edges = WriteContractedGraph(max_edge_id, contracted_edge_list);
-    WriteCoreNodeMarker(std::move(is_core_node));
-    if (!config.use_cached_priority)
-    {
-        WriteNodeLevels(std::move(node_levels));
+                set_weight(block_begin + index,
+                           std::max(new_turn_weight + new_weight, compressed_edge_nodes));
+            }
+            else
+            {
+                set_weight(block_begin + index, turn.fixed_penalty + new_weight);
+            }
+        }
+        penaltyblock += block_size;
     }
+}
+}
 
-    TIMER_STOP(preparing);
+int Contractor::Run()
+{
+    Initialize();
 
-    util::SimpleLogger().Write() << "Preprocessing : " << TIMER_SEC(preparing) << " seconds";
-    util::SimpleLogger().Write() << "Contraction: " << ((max_edge_id + 1) / TIMER_SEC(contraction))
-                                 << " nodes/sec and "
-                                 << number_of_used_edges / TIMER_SEC(contraction) << " edges/sec";
+    util::SimpleLogger().Write() << "Loading edge-expanded graph representation";
 
-    util::SimpleLogger().Write() << "finished preprocessing";
+    extractor::EdgeBasedGraph edge_based_graph;
+
+    util::PhaseTrace::ScopedPhase loading_phase("load edge-expanded graph");
+    edge_based_graph.max_edge_id = LoadEdgeExpandedGraph(config.edge_based_graph_path,
+                                                         edge_based_graph.edges,
+                                                         config.edge_segment_lookup_path,
+                                                         config.edge_penalty_path,
+                                                         config.segment_speed_lookup_paths,
+                                                         config.turn_penalty_lookup_paths,
+                                                         config.node_based_graph_path,
+                                                         config.geometry_path,
+                                                         config.datasource_names_path,
+                                                         config.datasource_indexes_path,
+                                                         config.rtree_leaf_path);
+
+    // a recustomization only needs the weights of the edges
+    if (!config.recustomize)
+    {
+        util::SimpleLogger().Write() << "Reading node weights.";
+        std::string node_file_name = config.osrm_input_path.string() + ".enw";
+        if (util::deserializeVector(node_file_name, edge_based_graph.node_weights))
+        {
+            util::SimpleLogger().Write() << "Done reading node weights.";
+        }
+        else
+        {
+            throw util::exception("Failed reading node weights.");
+        }
+    }
+    loading_phase.Stop();
 
-    return 0;
+    return ContractEdgeBasedGraph(edge_based_graph);
 }
 
-// Utilities for LoadEdgeExpandedGraph to restore my sanity
-namespace
+int Contractor::Run(extractor::EdgeBasedGraph &edge_based_graph)
 {
+    if (!config.segment_speed_lookup_paths.empty() || !config.turn_penalty_lookup_paths.empty())
+    {
+        throw util::exception("Speed and turn penalty files can only be applied to the .ebg");
+    }
 
-struct Segment final
-{
-    OSMNodeID from, to;
-};
+    Initialize();
 
-struct SpeedSource final
-{
-    unsigned speed;
-    std::uint8_t source;
-};
+    // without the updates of LoadEdgeExpandedGraph every segment has the speed of the profile
+    writeDatasourceIndexes(config.datasource_indexes_path, {});
+    writeDatasourceNames(config.datasource_names_path, {});
 
-struct SegmentSpeedSource final
-{
-    Segment segment;
-    SpeedSource speed_source;
-};
-
-using SegmentSpeedSourceFlatMap = std::vector<SegmentSpeedSource>;
+    return ContractEdgeBasedGraph(edge_based_graph);
+}
 
-// Binary Search over a flattened key,val Segment storage
-SegmentSpeedSourceFlatMap::iterator find(SegmentSpeedSourceFlatMap &map, const Segment &key)
+void Contractor::Initialize() const
 {
-    const auto last = end(map);
-
-    const auto by_segment = [](const SegmentSpeedSource &lhs, const SegmentSpeedSource &rhs) {
-        return std::tie(lhs.segment.from, lhs.segment.to) >
-               std::tie(rhs.segment.from, rhs.segment.to);
-    };
+#ifdef WIN32
+#pragma message("Memory consumption on Windows can be higher due to different bit packing")
+#else
+    static_assert(sizeof(extractor::NodeBasedEdge) == 24,
+                  "changing extractor::NodeBasedEdge type has influence on memory consumption!");
+    static_assert(sizeof(extractor::EdgeBasedEdge) == 20,
+                  "changing EdgeBasedEdge type has influence on memory consumption!");
+#endif
 
-    auto it = std::lower_bound(begin(map), last, SegmentSpeedSource{key, {0, 0}}, by_segment);
+    if (config.core_factor > 1.0 || config.core_factor < 0)
+    {
+        throw util::exception("Core factor must be between 0.0 to 1.0 (inclusive)");
+    }
 
-    if (it != last && (std::tie(it->segment.from, it->segment.to) == std::tie(key.from, key.to)))
-        return it;
+    if (config.use_partition_order && (config.use_cached_priority || config.recustomize))
+    {
+        throw util::exception("The partition order can't be combined with the level cache or a "
+                              "recustomization, which keep the order of the last contraction");
+    }
 
-    return last;
+    // the trace of an extraction in the same process goes on with the contraction
+    if (!config.trace_path.empty() && !util::PhaseTrace::GetInstance().IsEnabled())
+    {
+        util::PhaseTrace::GetInstance().Enable(config.requested_num_threads);
+    }
 }
 
-// Convenience aliases. TODO: make actual types at some point in time.
-// TODO: turn penalties need flat map + binary search optimization, take a look at segment speeds
-
-using Turn = std::tuple<OSMNodeID, OSMNodeID, OSMNodeID>;
-using TurnHasher = std::hash<Turn>;
-using PenaltySource = std::pair<double, std::uint8_t>;
-using TurnPenaltySourceMap = tbb::concurrent_unordered_map<Turn, PenaltySource, TurnHasher>;
-
-// Functions for parsing files and creating lookup tables
-
-SegmentSpeedSourceFlatMap
-parse_segment_lookup_from_csv_files(const std::vector<std::string> &segment_speed_filenames)
+int Contractor::ContractEdgeBasedGraph(extractor::EdgeBasedGraph &edge_based_graph)
 {
-    // TODO: shares code with turn penalty lookup parse function
-
-    using Mutex = tbb::spin_mutex;
-
-    // Loaded and parsed in parallel, at the end we combine results in a flattened map-ish view
-    SegmentSpeedSourceFlatMap flatten;
-    Mutex flatten_mutex;
-
-    const auto parse_segment_speed_file = [&](const std::size_t idx) {
-        const auto file_id = idx + 1; // starts at one, zero means we assigned the weight
-        const auto filename = segment_speed_filenames[idx];
+    TIMER_START(preparing);
 
-        std::ifstream segment_speed_file{filename, std::ios::binary};
-        if (!segment_speed_file)
-            throw util::exception{"Unable to open segment speed file " + filename};
+    const EdgeID max_edge_id = edge_based_graph.max_edge_id;
+    auto &edge_based_edge_list = edge_based_graph.edges;
 
-        SegmentSpeedSourceFlatMap local;
+    // the ids of the previous contraction, if it renumbered the nodes
+    const auto previous_renumbering = ReadNodeRenumbering();
 
-        std::uint64_t from_node_id{};
-        std::uint64_t to_node_id{};
-        unsigned speed{};
+    // Contracting the edge-expanded graph
 
-        for (std::string line; std::getline(segment_speed_file, line);)
+    TIMER_START(contraction);
+    util::PhaseTrace::ScopedPhase contraction_phase("contraction");
+    std::vector<bool> is_core_node;
+    std::vector<float> node_levels;
+    util::ChunkedVector<QueryEdge> contracted_edge_list;
+    if (config.recustomize)
+    {
+        RecustomizeGraph(max_edge_id,
+                         edge_based_edge_list,
+                         previous_renumbering,
+                         contracted_edge_list,
+                         is_core_node);
+    }
+    else
+    {
+        if (config.use_cached_priority)
         {
-            using namespace boost::spirit::qi;
-
-            auto it = begin(line);
-            const auto last = end(line);
-
-            // The ulong_long -> uint64_t will likely break on 32bit platforms
-            const auto ok =
-                parse(it,
-                      last,                                                                  //
-                      (ulong_long >> ',' >> ulong_long >> ',' >> uint_ >> *(',' >> *char_)), //
-                      from_node_id,
-                      to_node_id,
-                      speed); //
-
-            if (!ok || it != last)
-                throw util::exception{"Segment speed file " + filename + " malformed"};
-
-            SegmentSpeedSource val{{OSMNodeID{from_node_id}, OSMNodeID{to_node_id}},
-                                   {speed, static_cast<std::uint8_t>(file_id)}};
-
-            local.push_back(std::move(val));
+            ReadNodeLevels(node_levels);
         }
-
-        util::SimpleLogger().Write() << "Loaded speed file " << filename << " with " << local.size()
-                                     << " speeds";
-
+        // the contractor takes the order as cached priorities and keeps no levels of its own
+        std::vector<float> partition_order;
+        if (config.use_partition_order)
         {
-            Mutex::scoped_lock _{flatten_mutex};
-
-            flatten.insert(end(flatten),
-                           std::make_move_iterator(begin(local)),
-                           std::make_move_iterator(end(local)));
+            partition_order = ReadPartitionOrder(max_edge_id + 1, edge_based_edge_list);
+            node_levels = partition_order;
         }
-    };
 
-    tbb::parallel_for(std::size_t{0}, segment_speed_filenames.size(), parse_segment_speed_file);
-
-    // With flattened map-ish view of all the files, sort and unique them on from,to,source
-    // The greater '>' is used here since we want to give files later on higher precedence
-    const auto sort_by = [](const SegmentSpeedSource &lhs, const SegmentSpeedSource &rhs) {
-        return std::tie(lhs.segment.from, lhs.segment.to, lhs.speed_source.source) >
-               std::tie(rhs.segment.from, rhs.segment.to, rhs.speed_source.source);
-    };
-
-    std::stable_sort(begin(flatten), end(flatten), sort_by);
-
-    // Unique only on from,to to take the source precedence into account and remove duplicates
-    const auto unique_by = [](const SegmentSpeedSource &lhs, const SegmentSpeedSource &rhs) {
-        return std::tie(lhs.segment.from, lhs.segment.to) ==
-               std::tie(rhs.segment.from, rhs.segment.to);
-    };
-
-    const auto it = std::unique(begin(flatten), end(flatten), unique_by);
+        if (!ContractGraph(max_edge_id,
+                           edge_based_edge_list,
+                           contracted_edge_list,
+                           std::move(edge_based_graph.node_weights),
+                           is_core_node,
+                           node_levels))
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "The contraction was stopped, continue it from " << config.checkpoint_path
+                << " with --resume";
+            return 1;
+        }
+        if (config.use_partition_order)
+        {
+            node_levels = std::move(partition_order);
+        }
+    }
+    contraction_phase.Stop();
+    TIMER_STOP(contraction);
 
-    flatten.erase(it, end(flatten));
+    util::SimpleLogger().Write() << "Contraction took " << TIMER_SEC(contraction) << " sec";
 
-    util::SimpleLogger().Write() << "In total loaded " << segment_speed_filenames.size()
-                                 << " speed file(s) with a total of " << flatten.size()
-                                 << " unique values";
+    // the search spaces compare the orders, a sample of the nodes is enough for that
+    const constexpr std::size_t SEARCH_SPACE_SAMPLES = 1000;
+    const auto search_space_sizes =
+        computeSearchSpaceSizes(contracted_edge_list, max_edge_id + 1, SEARCH_SPACE_SAMPLES);
+    util::SimpleLogger().Write() << "Upward search spaces of "
+                                 << search_space_sizes.number_of_samples
+                                 << " nodes: " << search_space_sizes.average
+                                 << " nodes on average, " << search_space_sizes.maximum
+                                 << " at most";
+
+    // the r-tree has to go back to the ids of the edge-based graph if they aren't renumbered
+    if (config.renumber_nodes || !previous_renumbering.empty())
+    {
+        const util::PhaseTrace::ScopedPhase phase("renumber nodes");
+        RenumberNodes(max_edge_id + 1,
+                      previous_renumbering,
+                      node_levels,
+                      contracted_edge_list,
+                      is_core_node);
+    }
 
-    return flatten;
-}
+    util::PhaseTrace::ScopedPhase writing_phase("write contracted graph");
+    std::size_t number_of_used_edges = WriteContractedGraph(max_edge_id, contracted_edge_list);
+    writing_phase.Stop();
+
+    TIMER_START(landmarks);
+    util::PhaseTrace::ScopedPhase landmarks_phase("landmarks");
+    WriteCoreLandmarks(
+        computeCoreLandmarks(contracted_edge_list, is_core_node, config.number_of_landmarks));
+    landmarks_phase.Stop();
+    TIMER_STOP(landmarks);
+    util::SimpleLogger().Write() << "Landmark selection took " << TIMER_SEC(landmarks) << " sec";
+
+    // an old file would not match the new graph, so one without labels is written instead
+    HubLabels hub_labels;
+    if (config.compute_hub_labels)
+    {
+        const NodeID number_of_nodes = max_edge_id + 1;
+        if (std::find(is_core_node.begin(), is_core_node.end(), true) != is_core_node.end())
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "Hub labels need a fully contracted graph, none are computed for a core";
+        }
+        else if (number_of_nodes > config.max_hub_label_nodes)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "No hub labels are computed for " << number_of_nodes
+                << " nodes, more than --hub-labels-max-nodes";
+        }
+        else
+        {
+            TIMER_START(hub_labels);
+            const util::PhaseTrace::ScopedPhase hub_labels_phase("hub labels");
+            hub_labels = computeHubLabels(contracted_edge_list, number_of_nodes);
+            TIMER_STOP(hub_labels);
+            util::SimpleLogger().Write() << "Hub labels took " << TIMER_SEC(hub_labels) << " sec";
+        }
+    }
+    WriteHubLabels(hub_labels);
 
-TurnPenaltySourceMap
-parse_turn_penalty_lookup_from_csv_files(const std::vector<std::string> &turn_penalty_filenames)
-{
-    // TODO: shares code with turn penalty lookup parse function
-    TurnPenaltySourceMap map;
+    WriteCoreNodeMarker(std::move(is_core_node));
+    // a recustomized graph keeps the order of the previous contraction
+    if (!config.use_cached_priority && !config.recustomize)
+    {
+        WriteNodeLevels(std::move(node_levels));
+    }
 
-    const auto parse_turn_penalty_file = [&](const std::size_t idx) {
-        const auto file_id = idx + 1; // starts at one, zero means we assigned the weight
-        const auto filename = turn_penalty_filenames[idx];
+    // the outputs are complete, a resumed contraction would only repeat them
+    if (!config.checkpoint_path.empty())
+    {
+        boost::filesystem::remove(config.checkpoint_path);
+    }
 
-        std::ifstream turn_penalty_file{filename, std::ios::binary};
-        if (!turn_penalty_file)
-            throw util::exception{"Unable to open turn penalty file " + filename};
+    TIMER_STOP(preparing);
 
-        std::uint64_t from_node_id{};
-        std::uint64_t via_node_id{};
-        std::uint64_t to_node_id{};
-        double penalty{};
+    util::SimpleLogger().Write() << "Preprocessing : " << TIMER_SEC(preparing) << " seconds";
+    util::SimpleLogger().Write() << "Contraction: " << ((max_edge_id + 1) / TIMER_SEC(contraction))
+                                 << " nodes/sec and "
+                                 << number_of_used_edges / TIMER_SEC(contraction) << " edges/sec";
 
-        for (std::string line; std::getline(turn_penalty_file, line);)
+    if (!config.trace_path.empty())
+    {
+        util::PhaseTrace::Format trace_format;
+        if (!util::PhaseTrace::GetFormat(config.trace_format, trace_format))
         {
-            using namespace boost::spirit::qi;
-
-            auto it = begin(line);
-            const auto last = end(line);
-
-            // The ulong_long -> uint64_t will likely break on 32bit platforms
-            const auto ok = parse(it,
-                                  last, //
-                                  (ulong_long >> ',' >> ulong_long >> ',' >> ulong_long >> ',' >>
-                                   double_ >> *(',' >> *char_)), //
-                                  from_node_id,
-                                  via_node_id,
-                                  to_node_id,
-                                  penalty); //
-
-            if (!ok || it != last)
-                throw util::exception{"Turn penalty file " + filename + " malformed"};
-
-            map[std::make_tuple(
-                OSMNodeID{from_node_id}, OSMNodeID{via_node_id}, OSMNodeID{to_node_id})] =
-                std::make_pair(penalty, file_id);
+            throw util::exception("Unknown trace format " + config.trace_format);
         }
-    };
+        util::PhaseTrace::GetInstance().Write(config.trace_path, trace_format);
+    }
 
-    tbb::parallel_for(std::size_t{0}, turn_penalty_filenames.size(), parse_turn_penalty_file);
+    util::SimpleLogger().Write() << "finished preprocessing";
 
-    return map;
+    return 0;
 }
-} // anon ns
 
 EdgeID Contractor::LoadEdgeExpandedGraph(
     std::string const &edge_based_graph_filename,
-    util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
+    util::ChunkedVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
     const std::string &edge_segment_lookup_filename,
     const std::string &edge_penalty_filename,
     const std::vector<std::string> &segment_speed_filenames,
@@ -377,18 +567,12 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
 
     util::SimpleLogger().Write() << "Opening " << edge_based_graph_filename;
 
-    auto mmap_file = [](const std::string &filename) {
-        using boost::interprocess::file_mapping;
-        using boost::interprocess::mapped_region;
-        using boost::interprocess::read_only;
-
-        const file_mapping mapping{filename.c_str(), read_only};
-        mapped_region region{mapping, read_only};
-        region.advise(mapped_region::advice_sequential);
-        return region;
-    };
-
-    const auto edge_based_graph_region = mmap_file(edge_based_graph_filename);
+    std::vector<unsigned char> edge_based_graph_bytes(
+        boost::filesystem::file_size(edge_based_graph_filename));
+    if (edge_based_graph_bytes.size() < sizeof(EdgeBasedGraphHeader))
+    {
+        throw util::exception("Truncated " + edge_based_graph_filename);
+    }
 
     const bool update_edge_weights = !segment_speed_filenames.empty();
     const bool update_turn_penalties = !turn_penalty_filenames.empty();
@@ -396,7 +580,7 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
     const auto edge_penalty_region = [&] {
         if (update_edge_weights || update_turn_penalties)
         {
-            return mmap_file(edge_penalty_filename);
+            return mmapFile(edge_penalty_filename);
         }
         return boost::interprocess::mapped_region();
     }();
@@ -404,45 +588,22 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
     const auto edge_segment_region = [&] {
         if (update_edge_weights || update_turn_penalties)
         {
-            return mmap_file(edge_segment_lookup_filename);
+            return mmapFile(edge_segment_lookup_filename);
         }
         return boost::interprocess::mapped_region();
     }();
 
-// Set the struct packing to 1 byte word sizes.  This prevents any padding.  We only use
-// this struct once, so any alignment penalty is trivial.  If this is *not* done, then
-// the struct will be padded out by an extra 4 bytes, and sizeof() will mean we read
-// too much data from the original file.
-#pragma pack(push, r1, 1)
-    struct EdgeBasedGraphHeader
-    {
-        util::FingerPrint fingerprint;
-        std::uint64_t number_of_edges;
-        EdgeID max_edge_id;
-    };
-#pragma pack(pop, r1)
-
-    const EdgeBasedGraphHeader graph_header =
-        *(reinterpret_cast<const EdgeBasedGraphHeader *>(edge_based_graph_region.get_address()));
-
-    const util::FingerPrint fingerprint_valid = util::FingerPrint::GetValid();
-    graph_header.fingerprint.TestContractor(fingerprint_valid);
-
-    edge_based_edge_list.resize(graph_header.number_of_edges);
-    util::SimpleLogger().Write() << "Reading " << graph_header.number_of_edges
-                                 << " edges from the edge based graph";
-
-    SegmentSpeedSourceFlatMap segment_speed_lookup;
-    TurnPenaltySourceMap turn_penalty_lookup;
+    SegmentSpeedLookup segment_speed_lookup;
+    TurnPenaltyLookup turn_penalty_lookup;
 
     const auto parse_segment_speeds = [&] {
         if (update_edge_weights)
-            segment_speed_lookup = parse_segment_lookup_from_csv_files(segment_speed_filenames);
+            segment_speed_lookup = readSegmentSpeedFiles(segment_speed_filenames);
     };
 
     const auto parse_turn_penalties = [&] {
         if (update_turn_penalties)
-            turn_penalty_lookup = parse_turn_penalty_lookup_from_csv_files(turn_penalty_filenames);
+            turn_penalty_lookup = readTurnPenaltyFiles(turn_penalty_filenames);
     };
 
     // If we update the edge weights, this file will hold the datasource information for each
@@ -453,6 +614,13 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
     std::vector<unsigned> m_geometry_indices;
     std::vector<extractor::CompressedEdgeContainer::CompressedEdge> m_geometry_list;
 
+    // The .ebg and the nodes are read with many reads in flight while the updates are parsed
+    util::AsyncIO io;
+    io.Read(edge_based_graph_filename,
+            0,
+            edge_based_graph_bytes.data(),
+            edge_based_graph_bytes.size());
+
     const auto maybe_load_internal_to_external_node_map = [&] {
         if (!(update_edge_weights || update_turn_penalties))
             return;
@@ -469,8 +637,10 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
         internal_to_external_node_map.resize(number_of_nodes);
 
         // Load all the query nodes into a vector
-        nodes_input_stream.read(reinterpret_cast<char *>(&(internal_to_external_node_map[0])),
-                                number_of_nodes * sizeof(extractor::QueryNode));
+        io.Read(nodes_filename,
+                sizeof(unsigned),
+                internal_to_external_node_map.data(),
+                number_of_nodes * sizeof(extractor::QueryNode));
     };
 
     const auto maybe_load_geometries = [&] {
@@ -482,29 +652,7 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
         {
             throw util::exception("Failed to open " + geometry_filename);
         }
-        unsigned number_of_indices = 0;
-        unsigned number_of_compressed_geometries = 0;
-
-        geometry_stream.read((char *)&number_of_indices, sizeof(unsigned));
-
-        m_geometry_indices.resize(number_of_indices);
-        if (number_of_indices > 0)
-        {
-            geometry_stream.read((char *)&(m_geometry_indices[0]),
-                                 number_of_indices * sizeof(unsigned));
-        }
-
-        geometry_stream.read((char *)&number_of_compressed_geometries, sizeof(unsigned));
-
-        BOOST_ASSERT(m_geometry_indices.back() == number_of_compressed_geometries);
-        m_geometry_list.resize(number_of_compressed_geometries);
-
-        if (number_of_compressed_geometries > 0)
-        {
-            geometry_stream.read((char *)&(m_geometry_list[0]),
-                                 number_of_compressed_geometries *
-                                     sizeof(extractor::CompressedEdgeContainer::CompressedEdge));
-        }
+        extractor::readCompressedGeometries(geometry_stream, m_geometry_indices, m_geometry_list);
     };
 
     // Folds all our actions into independently concurrently executing lambdas
@@ -512,6 +660,16 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
                          parse_turn_penalties, //
                          maybe_load_internal_to_external_node_map,
                          maybe_load_geometries);
+    io.Wait();
+
+    EdgeBasedGraphHeader graph_header;
+    std::memcpy(&graph_header, edge_based_graph_bytes.data(), sizeof(EdgeBasedGraphHeader));
+
+    const util::FingerPrint fingerprint_valid = util::FingerPrint::GetValid();
+    graph_header.fingerprint.TestContractor(fingerprint_valid);
+
+    util::SimpleLogger().Write() << "Reading " << graph_header.number_of_edges
+                                 << " edges from the edge based graph";
 
     if (update_edge_weights || update_turn_penalties)
     {
@@ -528,17 +686,19 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
 
         // Now, we iterate over all the segments stored in the StaticRTree, updating
         // the packed geometry weights in the `.geometries` file (note: we do not
-        // update the RTree itself, we just use the leaf nodes to iterate over all segments)
-        using LeafNode = util::StaticRTree<extractor::EdgeBasedNode>::LeafNode;
+        // update the RTree itself, we just use the objects of its leaves to iterate over all
+        // segments)
+        using RTree = util::StaticRTree<extractor::EdgeBasedNode>;
 
         using boost::interprocess::mapped_region;
 
-        auto region = mmap_file(rtree_leaf_filename.c_str());
+        auto region = mmapFile(rtree_leaf_filename.c_str());
         region.advise(mapped_region::advice_willneed);
 
-        const auto bytes = region.get_size();
-        const auto first = static_cast<const LeafNode *>(region.get_address());
-        const auto last = first + (bytes / sizeof(LeafNode));
+        const extractor::EdgeBasedNode *first, *last;
+        std::tie(first, last) =
+            RTree::GetLeafFileObjects(static_cast<const void *>(region.get_address()),
+                                      region.get_size());
 
         // vector to count used speeds for logging
         // size offset by one since index 0 is used for speeds not from external file
@@ -548,110 +708,99 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
             counters_type(num_counters, 0));
         const constexpr auto LUA_SOURCE = 0;
 
-        tbb::parallel_for_each(first, last, [&](const LeafNode &current_node) {
+        tbb::parallel_for_each(first, last, [&](const extractor::EdgeBasedNode &leaf_object) {
             auto &counters = segment_speeds_counters.local();
-            for (size_t i = 0; i < current_node.object_count; i++)
+            extractor::QueryNode *u;
+            extractor::QueryNode *v;
+
+            if (leaf_object.forward_packed_geometry_id != SPECIAL_EDGEID)
             {
-                const auto &leaf_object = current_node.objects[i];
-                extractor::QueryNode *u;
-                extractor::QueryNode *v;
+                const unsigned forward_begin =
+                    m_geometry_indices.at(leaf_object.forward_packed_geometry_id);
 
-                if (leaf_object.forward_packed_geometry_id != SPECIAL_EDGEID)
+                if (leaf_object.fwd_segment_position == 0)
                 {
-                    const unsigned forward_begin =
-                        m_geometry_indices.at(leaf_object.forward_packed_geometry_id);
-
-                    if (leaf_object.fwd_segment_position == 0)
-                    {
-                        u = &(internal_to_external_node_map[leaf_object.u]);
-                        v = &(
-                            internal_to_external_node_map[m_geometry_list[forward_begin].node_id]);
-                    }
-                    else
-                    {
-                        u = &(internal_to_external_node_map
-                                  [m_geometry_list[forward_begin +
-                                                   leaf_object.fwd_segment_position - 1]
-                                       .node_id]);
-                        v = &(internal_to_external_node_map
-                                  [m_geometry_list[forward_begin + leaf_object.fwd_segment_position]
-                                       .node_id]);
-                    }
-                    const double segment_length = util::coordinate_calculation::greatCircleDistance(
-                        util::Coordinate{u->lon, u->lat}, util::Coordinate{v->lon, v->lat});
+                    u = &(internal_to_external_node_map[leaf_object.u]);
+                    v = &(internal_to_external_node_map[m_geometry_list[forward_begin].node_id]);
+                }
+                else
+                {
+                    u = &(internal_to_external_node_map
+                              [m_geometry_list[forward_begin + leaf_object.fwd_segment_position - 1]
+                                   .node_id]);
+                    v = &(internal_to_external_node_map
+                              [m_geometry_list[forward_begin + leaf_object.fwd_segment_position]
+                                   .node_id]);
+                }
+                const double segment_length = util::coordinate_calculation::greatCircleDistance(
+                    util::Coordinate{u->lon, u->lat}, util::Coordinate{v->lon, v->lat});
 
-                    auto forward_speed_iter =
-                        find(segment_speed_lookup, Segment{u->node_id, v->node_id});
-                    if (forward_speed_iter != segment_speed_lookup.end())
-                    {
-                        auto new_segment_weight =
-                            (forward_speed_iter->speed_source.speed > 0)
-                                ? distanceAndSpeedToWeight(segment_length,
-                                                           forward_speed_iter->speed_source.speed)
-                                : INVALID_EDGE_WEIGHT;
-                        m_geometry_list[forward_begin + leaf_object.fwd_segment_position].weight =
-                            new_segment_weight;
-                        m_geometry_datasource[forward_begin + leaf_object.fwd_segment_position] =
-                            forward_speed_iter->speed_source.source;
-
-                        // count statistics for logging
-                        counters[forward_speed_iter->speed_source.source] += 1;
-                    }
-                    else
-                    {
-                        // count statistics for logging
-                        counters[LUA_SOURCE] += 1;
-                    }
+                auto forward_speed_source =
+                    find(segment_speed_lookup, Segment{u->node_id, v->node_id});
+                if (forward_speed_source)
+                {
+                    auto new_segment_weight =
+                        (forward_speed_source->speed > 0)
+                            ? distanceAndSpeedToWeight(segment_length, forward_speed_source->speed)
+                            : INVALID_EDGE_WEIGHT;
+                    m_geometry_list[forward_begin + leaf_object.fwd_segment_position].weight =
+                        new_segment_weight;
+                    m_geometry_datasource[forward_begin + leaf_object.fwd_segment_position] =
+                        forward_speed_source->source;
+
+                    // count statistics for logging
+                    counters[forward_speed_source->source] += 1;
                 }
-                if (leaf_object.reverse_packed_geometry_id != SPECIAL_EDGEID)
+                else
                 {
-                    const unsigned reverse_begin =
-                        m_geometry_indices.at(leaf_object.reverse_packed_geometry_id);
-                    const unsigned reverse_end =
-                        m_geometry_indices.at(leaf_object.reverse_packed_geometry_id + 1);
-
-                    int rev_segment_position =
-                        (reverse_end - reverse_begin) - leaf_object.fwd_segment_position - 1;
-                    if (rev_segment_position == 0)
-                    {
-                        u = &(internal_to_external_node_map[leaf_object.v]);
-                        v = &(
-                            internal_to_external_node_map[m_geometry_list[reverse_begin].node_id]);
-                    }
-                    else
-                    {
-                        u = &(
-                            internal_to_external_node_map[m_geometry_list[reverse_begin +
-                                                                          rev_segment_position - 1]
-                                                              .node_id]);
-                        v = &(internal_to_external_node_map
-                                  [m_geometry_list[reverse_begin + rev_segment_position].node_id]);
-                    }
-                    const double segment_length = util::coordinate_calculation::greatCircleDistance(
-                        util::Coordinate{u->lon, u->lat}, util::Coordinate{v->lon, v->lat});
+                    // count statistics for logging
+                    counters[LUA_SOURCE] += 1;
+                }
+            }
+            if (leaf_object.reverse_packed_geometry_id != SPECIAL_EDGEID)
+            {
+                const unsigned reverse_begin =
+                    m_geometry_indices.at(leaf_object.reverse_packed_geometry_id);
+                const unsigned reverse_end =
+                    m_geometry_indices.at(leaf_object.reverse_packed_geometry_id + 1);
+
+                int rev_segment_position =
+                    (reverse_end - reverse_begin) - leaf_object.fwd_segment_position - 1;
+                if (rev_segment_position == 0)
+                {
+                    u = &(internal_to_external_node_map[leaf_object.v]);
+                    v = &(internal_to_external_node_map[m_geometry_list[reverse_begin].node_id]);
+                }
+                else
+                {
+                    u = &(internal_to_external_node_map
+                              [m_geometry_list[reverse_begin + rev_segment_position - 1].node_id]);
+                    v = &(internal_to_external_node_map
+                              [m_geometry_list[reverse_begin + rev_segment_position].node_id]);
+                }
+                const double segment_length = util::coordinate_calculation::greatCircleDistance(
+                    util::Coordinate{u->lon, u->lat}, util::Coordinate{v->lon, v->lat});
 
-                    auto reverse_speed_iter =
-                        find(segment_speed_lookup, Segment{u->node_id, v->node_id});
-                    if (reverse_speed_iter != segment_speed_lookup.end())
-                    {
-                        auto new_segment_weight =
-                            (reverse_speed_iter->speed_source.speed > 0)
-                                ? distanceAndSpeedToWeight(segment_length,
-                                                           reverse_speed_iter->speed_source.speed)
-                                : INVALID_EDGE_WEIGHT;
-                        m_geometry_list[reverse_begin + rev_segment_position].weight =
-                            new_segment_weight;
-                        m_geometry_datasource[reverse_begin + rev_segment_position] =
-                            reverse_speed_iter->speed_source.source;
-
-                        // count statistics for logging
-                        counters[reverse_speed_iter->speed_source.source] += 1;
-                    }
-                    else
-                    {
-                        // count statistics for logging
-                        counters[LUA_SOURCE] += 1;
-                    }
+                auto reverse_speed_source =
+                    find(segment_speed_lookup, Segment{u->node_id, v->node_id});
+                if (reverse_speed_source)
+                {
+                    auto new_segment_weight =
+                        (reverse_speed_source->speed > 0)
+                            ? distanceAndSpeedToWeight(segment_length, reverse_speed_source->speed)
+                            : INVALID_EDGE_WEIGHT;
+                    m_geometry_list[reverse_begin + rev_segment_position].weight =
+                        new_segment_weight;
+                    m_geometry_datasource[reverse_begin + rev_segment_position] =
+                        reverse_speed_source->source;
+
+                    // count statistics for logging
+                    counters[reverse_speed_source->source] += 1;
+                }
+                else
+                {
+                    // count statistics for logging
+                    counters[LUA_SOURCE] += 1;
                 }
             }
         }); // parallel_for_each
@@ -692,49 +841,21 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
         {
             throw util::exception("Failed to open " + geometry_filename + " for writing");
         }
-        const unsigned number_of_indices = m_geometry_indices.size();
-        const unsigned number_of_compressed_geometries = m_geometry_list.size();
-        geometry_stream.write(reinterpret_cast<const char *>(&number_of_indices), sizeof(unsigned));
-        geometry_stream.write(reinterpret_cast<char *>(&(m_geometry_indices[0])),
-                              number_of_indices * sizeof(unsigned));
-        geometry_stream.write(reinterpret_cast<const char *>(&number_of_compressed_geometries),
-                              sizeof(unsigned));
-        geometry_stream.write(reinterpret_cast<char *>(&(m_geometry_list[0])),
-                              number_of_compressed_geometries *
-                                  sizeof(extractor::CompressedEdgeContainer::CompressedEdge));
+        extractor::CompressedGeometryEncoder encoder;
+        for (std::size_t id = 0; id + 1 < m_geometry_indices.size(); ++id)
+        {
+            encoder.Append(m_geometry_list.begin() + m_geometry_indices[id],
+                           m_geometry_list.begin() + m_geometry_indices[id + 1]);
+        }
+        encoder.Write(geometry_stream);
     };
 
     const auto save_datasource_indexes = [&] {
-        std::ofstream datasource_stream(datasource_indexes_filename, std::ios::binary);
-        if (!datasource_stream)
-        {
-            throw util::exception("Failed to open " + datasource_indexes_filename + " for writing");
-        }
-        std::uint64_t number_of_datasource_entries = m_geometry_datasource.size();
-        datasource_stream.write(reinterpret_cast<const char *>(&number_of_datasource_entries),
-                                sizeof(number_of_datasource_entries));
-        if (number_of_datasource_entries > 0)
-        {
-            datasource_stream.write(reinterpret_cast<char *>(&(m_geometry_datasource[0])),
-                                    number_of_datasource_entries * sizeof(uint8_t));
-        }
+        writeDatasourceIndexes(datasource_indexes_filename, m_geometry_datasource);
     };
 
     const auto save_datastore_names = [&] {
-        std::ofstream datasource_stream(datasource_names_filename, std::ios::binary);
-        if (!datasource_stream)
-        {
-            throw util::exception("Failed to open " + datasource_names_filename + " for writing");
-        }
-        datasource_stream << "lua profile" << std::endl;
-        for (auto const &name : segment_speed_filenames)
-        {
-            // Only write the filename, without path or extension.
-            // This prevents information leakage, and keeps names short
-            // for rendering in the debug tiles.
-            const boost::filesystem::path p(name);
-            datasource_stream << p.stem().string() << std::endl;
-        }
+        writeDatasourceNames(datasource_names_filename, segment_speed_filenames);
     };
 
     tbb::parallel_invoke(maybe_save_geometries, save_datasource_indexes, save_datastore_names);
@@ -742,111 +863,95 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
     auto penaltyblock = reinterpret_cast<const extractor::lookup::PenaltyBlock *>(
         edge_penalty_region.get_address());
     auto edge_segment_byte_ptr = reinterpret_cast<const char *>(edge_segment_region.get_address());
-    auto edge_based_edge_ptr = reinterpret_cast<extractor::EdgeBasedEdge *>(
-        reinterpret_cast<char *>(edge_based_graph_region.get_address()) +
-        sizeof(EdgeBasedGraphHeader));
-
-    const auto edge_based_edge_last = reinterpret_cast<extractor::EdgeBasedEdge *>(
-        reinterpret_cast<char *>(edge_based_graph_region.get_address()) +
-        sizeof(EdgeBasedGraphHeader) +
-        sizeof(extractor::EdgeBasedEdge) * graph_header.number_of_edges);
+    extractor::readEdgeBasedEdges(edge_based_graph_bytes.data() + sizeof(EdgeBasedGraphHeader),
+                                  edge_based_graph_bytes.data() + edge_based_graph_bytes.size(),
+                                  graph_header.number_of_edges,
+                                  edge_based_edge_list);
 
-    while (edge_based_edge_ptr != edge_based_edge_last)
+    // the edges that are kept are moved over the ones that were read
+    if (update_edge_weights || update_turn_penalties)
     {
-        // Make a copy of the data from the memory map
-        extractor::EdgeBasedEdge inbuffer = *edge_based_edge_ptr;
-        edge_based_edge_ptr++;
-
-        if (update_edge_weights || update_turn_penalties)
-        {
-            bool skip_this_edge = false;
-            auto header = reinterpret_cast<const extractor::lookup::SegmentHeaderBlock *>(
-                edge_segment_byte_ptr);
-            edge_segment_byte_ptr += sizeof(extractor::lookup::SegmentHeaderBlock);
-
-            auto previous_osm_node_id = header->previous_osm_node_id;
-            int new_weight = 0;
-            int compressed_edge_nodes = static_cast<int>(header->num_osm_nodes);
-
-            auto segmentblocks =
-                reinterpret_cast<const extractor::lookup::SegmentBlock *>(edge_segment_byte_ptr);
-            edge_segment_byte_ptr +=
-                sizeof(extractor::lookup::SegmentBlock) * (header->num_osm_nodes - 1);
-
-            const auto num_segments = header->num_osm_nodes - 1;
-            for (auto i : util::irange<std::size_t>(0, num_segments))
-            {
-                auto speed_iter =
-                    find(segment_speed_lookup,
-                         Segment{previous_osm_node_id, segmentblocks[i].this_osm_node_id});
-                if (speed_iter != segment_speed_lookup.end())
-                {
-                    if (speed_iter->speed_source.speed > 0)
-                    {
-                        auto new_segment_weight = distanceAndSpeedToWeight(
-                            segmentblocks[i].segment_length, speed_iter->speed_source.speed);
-                        new_weight += new_segment_weight;
-                    }
-                    else
-                    {
-                        // If we hit a 0-speed edge, then it's effectively not traversible.
-                        // We don't want to include it in the edge_based_edge_list, so
-                        // we set a flag and `continue` the parent loop as soon as we can.
-                        // This would be a perfect place to use `goto`, but Patrick vetoed it.
-                        skip_this_edge = true;
-                        break;
-                    }
-                }
-                else
-                {
-                    // If no lookup found, use the original weight value for this segment
-                    new_weight += segmentblocks[i].segment_weight;
-                }
-
-                previous_osm_node_id = segmentblocks[i].this_osm_node_id;
-            }
-
-            // We found a zero-speed edge, so we'll skip this whole edge-based-edge which
-            // effectively removes it from the routing network.
-            if (skip_this_edge)
-            {
-                penaltyblock++;
-                continue;
-            }
-
-            const auto turn_iter = turn_penalty_lookup.find(
-                std::make_tuple(penaltyblock->from_id, penaltyblock->via_id, penaltyblock->to_id));
-            if (turn_iter != turn_penalty_lookup.end())
-            {
-                int new_turn_weight = static_cast<int>(turn_iter->second.first * 10);
-
-                if (new_turn_weight + new_weight < compressed_edge_nodes)
-                {
-                    util::SimpleLogger().Write(logWARNING)
-                        << "turn penalty " << turn_iter->second.first << " for turn "
-                        << penaltyblock->from_id << ", " << penaltyblock->via_id << ", "
-                        << penaltyblock->to_id << " is too negative: clamping turn weight to "
-                        << compressed_edge_nodes;
-                }
-
-                inbuffer.weight = std::max(new_turn_weight + new_weight, compressed_edge_nodes);
-            }
-            else
-            {
-                inbuffer.weight = penaltyblock->fixed_penalty + new_weight;
-            }
-
-            // Increment the pointer
-            penaltyblock++;
-        }
-
-        edge_based_edge_list.emplace_back(std::move(inbuffer));
+        std::size_t number_of_kept_edges = 0;
+        computeEdgeWeights(edge_segment_byte_ptr,
+                           penaltyblock,
+                           edge_based_edge_list.size(),
+                           segment_speed_lookup,
+                           turn_penalty_lookup,
+                           [&](const std::size_t index, const EdgeWeight weight) {
+                               if (weight != INVALID_EDGE_WEIGHT)
+                               {
+                                   extractor::EdgeBasedEdge edge = edge_based_edge_list[index];
+                                   edge.weight = weight;
+                                   edge_based_edge_list[number_of_kept_edges++] = edge;
+                               }
+                           });
+        edge_based_edge_list.resize(number_of_kept_edges);
     }
 
     util::SimpleLogger().Write() << "Done reading edges";
     return graph_header.max_edge_id;
 }
 
+std::vector<EdgeWeight>
+Contractor::LoadEdgeWeights(const std::string &edge_based_graph_filename,
+                            const std::string &edge_segment_lookup_filename,
+                            const std::string &edge_penalty_filename,
+                            const std::vector<std::string> &segment_speed_filenames,
+                            const std::vector<std::string> &turn_penalty_filenames)
+{
+    // only the number of edges is needed from the .ebg
+    EdgeBasedGraphHeader graph_header;
+    boost::filesystem::ifstream edge_based_graph_stream(edge_based_graph_filename,
+                                                        std::ios::binary);
+    edge_based_graph_stream.read(reinterpret_cast<char *>(&graph_header), sizeof(graph_header));
+    if (!edge_based_graph_stream)
+    {
+        throw util::exception("Failed to read " + edge_based_graph_filename);
+    }
+    graph_header.fingerprint.TestContractor(util::FingerPrint::GetValid());
+
+    const auto edge_penalty_region = mmapFile(edge_penalty_filename);
+    const auto edge_segment_region = mmapFile(edge_segment_lookup_filename);
+
+    SegmentSpeedLookup segment_speed_lookup;
+    TurnPenaltyLookup turn_penalty_lookup;
+    tbb::parallel_invoke(
+        [&] { segment_speed_lookup = readSegmentSpeedFiles(segment_speed_filenames); },
+        [&] { turn_penalty_lookup = readTurnPenaltyFiles(turn_penalty_filenames); });
+
+    std::vector<EdgeWeight> weights(graph_header.number_of_edges, INVALID_EDGE_WEIGHT);
+    computeEdgeWeights(
+        reinterpret_cast<const char *>(edge_segment_region.get_address()),
+        reinterpret_cast<const extractor::lookup::PenaltyBlock *>(
+            edge_penalty_region.get_address()),
+        weights.size(),
+        segment_speed_lookup,
+        turn_penalty_lookup,
+        [&](const std::size_t index, const EdgeWeight weight) { weights[index] = weight; });
+    return weights;
+}
+
+// The nested dissection order of the partition of osrm-partition, which has the ids of the .ebg
+std::vector<float> Contractor::ReadPartitionOrder(
+    const NodeID number_of_nodes,
+    const util::ChunkedVector<extractor::EdgeBasedEdge> &edge_based_edge_list) const
+{
+    partition::MultiLevelPartition partition;
+    if (!partition::readMultiLevelPartition(config.partition_path, partition))
+    {
+        throw util::exception("Failed reading " + config.partition_path +
+                              ", run osrm-partition first");
+    }
+    if (partition.GetNumberOfNodes() != number_of_nodes)
+    {
+        throw util::exception(config.partition_path + " does not match the edge-based graph");
+    }
+    util::SimpleLogger().Write() << "Ordering the nodes by the "
+                                 << static_cast<unsigned>(partition.GetNumberOfLevels())
+                                 << " levels of " << config.partition_path;
+    return computeNestedDissectionOrder(partition, edge_based_edge_list);
+}
+
 void Contractor::ReadNodeLevels(std::vector<float> &node_levels) const
 {
     boost::filesystem::ifstream order_input_stream(config.level_output_path, std::ios::binary);
@@ -857,6 +962,31 @@ void Contractor::ReadNodeLevels(std::vector<float> &node_levels) const
     order_input_stream.read((char *)node_levels.data(), sizeof(float) * node_levels.size());
 }
 
+// Reads the contracted graph written by WriteContractedGraph back into an edge list
+void Contractor::ReadContractedGraph(
+    util::ChunkedVector<QueryEdge> &contracted_edge_list) const
+{
+    std::vector<QueryGraph<false>::NodeArrayEntry> node_list;
+    std::vector<QueryEdgeSearchData> search_edge_list;
+    std::vector<QueryEdgeUnpackData> unpack_edge_list;
+    unsigned checksum = 0;
+    util::readHSGRFromStream(
+        config.graph_output_path, node_list, search_edge_list, unpack_edge_list, &checksum);
+
+    // the last node is a sentinel
+    for (const auto node : util::irange<NodeID>(0, node_list.size() - 1))
+    {
+        for (const auto edge :
+             util::irange(node_list[node].first_edge, node_list[node + 1].first_edge))
+        {
+            contracted_edge_list.push_back(
+                QueryEdge(node,
+                          search_edge_list[edge].target,
+                          getEdgeData(search_edge_list[edge], unpack_edge_list[edge])));
+        }
+    }
+}
+
 void Contractor::WriteNodeLevels(std::vector<float> &&in_node_levels) const
 {
     std::vector<float> node_levels(std::move(in_node_levels));
@@ -868,6 +998,27 @@ void Contractor::WriteNodeLevels(std::vector<float> &&in_node_levels) const
     order_output_stream.write((char *)node_levels.data(), sizeof(float) * node_levels.size());
 }
 
+void Contractor::ReadCoreNodeMarker(std::vector<bool> &is_core_node) const
+{
+    boost::filesystem::ifstream core_marker_input_stream(config.core_output_path,
+                                                         std::ios::binary);
+    if (!core_marker_input_stream)
+    {
+        throw util::exception("Could not open " + config.core_output_path + " for reading.");
+    }
+
+    unsigned number_of_markers = 0;
+    core_marker_input_stream.read((char *)&number_of_markers, sizeof(unsigned));
+    std::vector<char> unpacked_bool_flags(number_of_markers);
+    core_marker_input_stream.read(unpacked_bool_flags.data(), sizeof(char) * number_of_markers);
+
+    is_core_node.resize(number_of_markers);
+    for (auto i = 0u; i < number_of_markers; ++i)
+    {
+        is_core_node[i] = unpacked_bool_flags[i] == 1;
+    }
+}
+
 void Contractor::WriteCoreNodeMarker(std::vector<bool> &&in_is_core_node) const
 {
     std::vector<bool> is_core_node(std::move(in_is_core_node));
@@ -885,9 +1036,57 @@ void Contractor::WriteCoreNodeMarker(std::vector<bool> &&in_is_core_node) const
                                     sizeof(char) * unpacked_bool_flags.size());
 }
 
+// The hub labels file stores the number of nodes and label entries, the offsets of the labels,
+// their hubs and their weights. Without labels both numbers are 0.
+void Contractor::WriteHubLabels(const HubLabels &hub_labels) const
+{
+    boost::filesystem::ofstream hub_labels_output_stream(config.hub_labels_output_path,
+                                                         std::ios::binary);
+    const unsigned number_of_nodes =
+        hub_labels.offsets.empty() ? 0 : (hub_labels.offsets.size() - 1) / 2;
+    const std::uint64_t number_of_entries = hub_labels.hubs.size();
+    BOOST_ASSERT(hub_labels.weights.size() == number_of_entries);
+
+    hub_labels_output_stream.write((char *)&number_of_nodes, sizeof(unsigned));
+    hub_labels_output_stream.write((char *)&number_of_entries, sizeof(std::uint64_t));
+    if (number_of_nodes > 0)
+    {
+        hub_labels_output_stream.write((char *)hub_labels.offsets.data(),
+                                       sizeof(std::uint64_t) * hub_labels.offsets.size());
+        hub_labels_output_stream.write((char *)hub_labels.hubs.data(),
+                                       sizeof(NodeID) * number_of_entries);
+        hub_labels_output_stream.write((char *)hub_labels.weights.data(),
+                                       sizeof(EdgeWeight) * number_of_entries);
+    }
+}
+
+// The landmarks file stores the number of landmarks and core nodes, the landmarks, the sorted
+// core nodes and the distance table. Without a core or landmarks both numbers are 0.
+void Contractor::WriteCoreLandmarks(const CoreLandmarks &landmarks) const
+{
+    boost::filesystem::ofstream landmarks_output_stream(config.landmarks_output_path,
+                                                        std::ios::binary);
+    const unsigned number_of_landmarks = landmarks.landmarks.size();
+    const unsigned number_of_core_nodes = number_of_landmarks > 0 ? landmarks.core_nodes.size() : 0;
+    BOOST_ASSERT(landmarks.distances.size() ==
+                 std::size_t{2} * number_of_landmarks * number_of_core_nodes);
+
+    landmarks_output_stream.write((char *)&number_of_landmarks, sizeof(unsigned));
+    landmarks_output_stream.write((char *)&number_of_core_nodes, sizeof(unsigned));
+    if (number_of_landmarks > 0)
+    {
+        landmarks_output_stream.write((char *)landmarks.landmarks.data(),
+                                      sizeof(NodeID) * number_of_landmarks);
+        landmarks_output_stream.write((char *)landmarks.core_nodes.data(),
+                                      sizeof(NodeID) * number_of_core_nodes);
+        landmarks_output_stream.write((char *)landmarks.distances.data(),
+                                      sizeof(EdgeWeight) * landmarks.distances.size());
+    }
+}
+
 std::size_t
 Contractor::WriteContractedGraph(unsigned max_node_id,
-                                 const util::DeallocatingVector<QueryEdge> &contracted_edge_list)
+                                 util::ChunkedVector<QueryEdge> &contracted_edge_list)
 {
     // Sorting contracted edges in a way that the static query graph can read some in in-place.
     tbb::parallel_sort(contracted_edge_list.begin(), contracted_edge_list.end());
@@ -895,9 +1094,6 @@ Contractor::WriteContractedGraph(unsigned max_node_id,
     util::SimpleLogger().Write() << "Serializing compacted graph of " << contracted_edge_count
                                  << " edges";
 
-    const util::FingerPrint fingerprint = util::FingerPrint::GetValid();
-    boost::filesystem::ofstream hsgr_output_stream(config.graph_output_path, std::ios::binary);
-    hsgr_output_stream.write((char *)&fingerprint, sizeof(util::FingerPrint));
     const NodeID max_used_node_id = [&contracted_edge_list] {
         NodeID tmp_max = 0;
         for (const QueryEdge &edge : contracted_edge_list)
@@ -948,26 +1144,39 @@ Contractor::WriteContractedGraph(unsigned max_node_id,
     const unsigned edges_crc32 = crc32_calculator(contracted_edge_list);
     util::SimpleLogger().Write() << "Writing CRC32: " << edges_crc32;
 
+    // The header, the nodes and both halves of the edges are written at their offsets with many
+    // writes in flight, the edges are converted in parallel meanwhile.
+    const util::FingerPrint fingerprint = util::FingerPrint::GetValid();
     const unsigned node_array_size = node_array.size();
-    // serialize crc32, aka checksum
-    hsgr_output_stream.write((char *)&edges_crc32, sizeof(unsigned));
-    // serialize number of nodes
-    hsgr_output_stream.write((char *)&node_array_size, sizeof(unsigned));
-    // serialize number of edges
-    hsgr_output_stream.write((char *)&contracted_edge_count, sizeof(unsigned));
+    // fingerprint, crc32 aka checksum, number of nodes and number of edges
+    std::vector<char> header(sizeof(util::FingerPrint) + 3 * sizeof(unsigned));
+    std::memcpy(header.data(), &fingerprint, sizeof(util::FingerPrint));
+    std::memcpy(header.data() + sizeof(util::FingerPrint), &edges_crc32, sizeof(unsigned));
+    std::memcpy(header.data() + sizeof(util::FingerPrint) + sizeof(unsigned),
+                &node_array_size,
+                sizeof(unsigned));
+    std::memcpy(header.data() + sizeof(util::FingerPrint) + 2 * sizeof(unsigned),
+                &contracted_edge_count,
+                sizeof(unsigned));
+    // the buffers need to outlive the writes
+    std::vector<QueryEdgeSearchData> search_data(contracted_edge_count);
+    std::vector<QueryEdgeUnpackData> unpack_data(contracted_edge_count);
+
+    util::AsyncIO io;
+    io.Create(config.graph_output_path);
+    std::uint64_t offset = 0;
+    io.Write(config.graph_output_path, offset, header.data(), header.size());
+    offset += header.size();
+
     // serialize all nodes
-    if (node_array_size > 0)
-    {
-        hsgr_output_stream.write((char *)&node_array[0],
-                                 sizeof(util::StaticGraph<EdgeData>::NodeArrayEntry) *
-                                     node_array_size);
-    }
+    const std::uint64_t node_array_bytes =
+        sizeof(util::StaticGraph<EdgeData>::NodeArrayEntry) * node_array_size;
+    io.Write(config.graph_output_path, offset, node_array.data(), node_array_bytes);
+    offset += node_array_bytes;
 
-    // serialize all edges
+    // serialize all edges, first the parts a search needs, then the parts to unpack them
     util::SimpleLogger().Write() << "Building edge array";
-    std::size_t number_of_used_edges = 0;
-
-    util::StaticGraph<EdgeData>::EdgeArrayEntry current_edge;
+#ifndef NDEBUG
     for (const auto edge : util::irange<std::size_t>(0UL, contracted_edge_list.size()))
     {
         // some self-loops are required for oneway handling. Need to assertthat we only keep these
@@ -975,12 +1184,10 @@ Contractor::WriteContractedGraph(unsigned max_node_id,
         // no eigen loops
         // BOOST_ASSERT(contracted_edge_list[edge].source != contracted_edge_list[edge].target ||
         // node_represents_oneway[contracted_edge_list[edge].source]);
-        current_edge.target = contracted_edge_list[edge].target;
-        current_edge.data = contracted_edge_list[edge].data;
+        const auto &current_edge = contracted_edge_list[edge];
 
         // every target needs to be valid
         BOOST_ASSERT(current_edge.target <= max_used_node_id);
-#ifndef NDEBUG
         if (current_edge.data.distance <= 0)
         {
             util::SimpleLogger().Write(logWARNING)
@@ -991,25 +1198,193 @@ Contractor::WriteContractedGraph(unsigned max_node_id,
             util::SimpleLogger().Write(logWARNING) << "Failed at adjacency list of node "
                                                    << contracted_edge_list[edge].source << "/"
                                                    << node_array.size() - 1;
+            io.Wait();
             return 1;
         }
+    }
 #endif
-        hsgr_output_stream.write((char *)&current_edge,
-                                 sizeof(util::StaticGraph<EdgeData>::EdgeArrayEntry));
 
-        ++number_of_used_edges;
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, contracted_edge_count),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          for (auto edge = range.begin(); edge != range.end(); ++edge)
+                          {
+                              const auto &current_edge = contracted_edge_list[edge];
+                              search_data[edge] =
+                                  getSearchData(current_edge.target, current_edge.data);
+                              unpack_data[edge] = getUnpackData(current_edge.data);
+                          }
+                      });
+    io.Write(config.graph_output_path,
+             offset,
+             search_data.data(),
+             sizeof(QueryEdgeSearchData) * search_data.size());
+    offset += sizeof(QueryEdgeSearchData) * search_data.size();
+    io.Write(config.graph_output_path,
+             offset,
+             unpack_data.data(),
+             sizeof(QueryEdgeUnpackData) * unpack_data.size());
+    io.Wait();
+
+    return contracted_edge_count;
+}
+
+std::vector<NodeID> Contractor::ReadNodeRenumbering() const
+{
+    std::vector<NodeID> renumbering;
+    if (boost::filesystem::exists(config.node_renumbering_path) &&
+        !util::deserializeVector(config.node_renumbering_path, renumbering))
+    {
+        throw util::exception("Failed reading " + config.node_renumbering_path);
+    }
+    return renumbering;
+}
+
+// Renumbers the nodes of the contracted graph, see computeNodeRenumbering. The objects of the
+// r-tree leaves are rewritten in place with the new ids, the renumbering is kept next to them to
+// get back to the ids of the edge-based graph: for a recustomization and for the next
+// contraction, which removes it again if it doesn't renumber the nodes.
+void Contractor::RenumberNodes(const NodeID number_of_nodes,
+                               const std::vector<NodeID> &previous_renumbering,
+                               const std::vector<float> &node_levels,
+                               util::ChunkedVector<QueryEdge> &contracted_edge_list,
+                               std::vector<bool> &is_core_node) const
+{
+    using RTree = util::StaticRTree<extractor::EdgeBasedNode>;
+    using boost::interprocess::file_mapping;
+    using boost::interprocess::mapped_region;
+    using boost::interprocess::read_write;
+
+    const file_mapping mapping{config.rtree_leaf_path.c_str(), read_write};
+    mapped_region region{mapping, read_write};
+    extractor::EdgeBasedNode *first, *last;
+    std::tie(first, last) = RTree::GetLeafFileObjects(region.get_address(), region.get_size());
+
+    if (!previous_renumbering.empty() && previous_renumbering.size() != number_of_nodes)
+    {
+        throw util::exception("The node renumbering in " + config.node_renumbering_path +
+                              " does not match the edge-based graph");
     }
+    const auto previous_ids = invertNodeRenumbering(previous_renumbering);
+    const auto edge_based_id = [&](const NodeID id) {
+        BOOST_ASSERT(id < number_of_nodes);
+        return previous_ids.empty() ? id : previous_ids[id];
+    };
+
+    std::vector<NodeID> new_ids;
+    if (config.renumber_nodes)
+    {
+        util::SimpleLogger().Write() << "Renumbering " << number_of_nodes << " nodes";
 
-    return number_of_used_edges;
+        // the levels of a previous contraction if this one didn't compute them
+        std::vector<float> levels;
+        if (node_levels.empty() && boost::filesystem::exists(config.level_output_path))
+        {
+            ReadNodeLevels(levels);
+        }
+        const auto &known_levels = node_levels.empty() ? levels : node_levels;
+        const std::vector<float> no_levels;
+        const auto &renumbering_levels =
+            known_levels.size() == number_of_nodes ? known_levels : no_levels;
+
+        std::vector<NodeID> spatial_ranks(number_of_nodes, SPECIAL_NODEID);
+        NodeID rank = 0;
+        const auto add_rank = [&](const SegmentID segment) {
+            if (segment.id != SPECIAL_SEGMENTID)
+            {
+                auto &spatial_rank = spatial_ranks[edge_based_id(segment.id)];
+                spatial_rank = std::min(spatial_rank, rank++);
+            }
+        };
+        std::for_each(first, last, [&](const extractor::EdgeBasedNode &object) {
+            add_rank(object.forward_segment_id);
+            add_rank(object.reverse_segment_id);
+        });
+
+        new_ids = computeNodeRenumbering(renumbering_levels, is_core_node, spatial_ranks);
+        renumberContractedEdges(contracted_edge_list, new_ids);
+        is_core_node = renumberCoreMarker(is_core_node, new_ids);
+    }
+
+    const auto renumber = [&](SegmentID &segment) {
+        if (segment.id != SPECIAL_SEGMENTID)
+        {
+            const auto id = edge_based_id(segment.id);
+            segment.id = new_ids.empty() ? id : new_ids[id];
+        }
+    };
+    tbb::parallel_for_each(first, last, [&](extractor::EdgeBasedNode &object) {
+        renumber(object.forward_segment_id);
+        renumber(object.reverse_segment_id);
+    });
+    region.flush();
+
+    if (new_ids.empty())
+    {
+        boost::filesystem::remove(config.node_renumbering_path);
+    }
+    else if (!util::serializeVector(config.node_renumbering_path, new_ids))
+    {
+        throw util::exception("Failed writing " + config.node_renumbering_path);
+    }
 }
 
 /**
  \brief Build contracted graph.
  */
-void Contractor::ContractGraph(
+// Keeps the hierarchy of the previous run and only updates its weights, see GraphRecustomizer.
+// The node order and the core are read from the .hsgr and the .core of that run, in the ids of
+// the edge-based graph if that run renumbered the nodes.
+void Contractor::RecustomizeGraph(
+    const unsigned max_edge_id,
+    const util::ChunkedVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
+    const std::vector<NodeID> &previous_renumbering,
+    util::ChunkedVector<QueryEdge> &contracted_edge_list,
+    std::vector<bool> &is_core_node) const
+{
+    util::SimpleLogger().Write() << "Loading the previous contraction from "
+                                 << config.graph_output_path;
+    util::ChunkedVector<QueryEdge> previous_edge_list;
+    ReadContractedGraph(previous_edge_list);
+    ReadCoreNodeMarker(is_core_node);
+
+    const NodeID number_of_nodes = max_edge_id + 1;
+    if (!previous_renumbering.empty())
+    {
+        if (previous_renumbering.size() != number_of_nodes)
+        {
+            throw util::exception("The node renumbering of the previous contraction does not "
+                                  "match the edge-based graph, contract it again without "
+                                  "--recustomize");
+        }
+        const auto old_ids = invertNodeRenumbering(previous_renumbering);
+        renumberContractedEdges(previous_edge_list, old_ids);
+        is_core_node = renumberCoreMarker(is_core_node, old_ids);
+    }
+
+    const NodeID max_used_node_id = [&previous_edge_list] {
+        NodeID tmp_max = 0;
+        for (const QueryEdge &edge : previous_edge_list)
+        {
+            tmp_max = std::max({tmp_max, edge.source, edge.target});
+        }
+        return tmp_max;
+    }();
+    if (max_used_node_id >= number_of_nodes)
+    {
+        throw util::exception("The previous contraction does not match the edge-based graph, "
+                              "contract it again without --recustomize");
+    }
+
+    GraphRecustomizer graph_recustomizer(number_of_nodes, previous_edge_list, is_core_node);
+    previous_edge_list.clear();
+    graph_recustomizer.Run(edge_based_edge_list);
+    graph_recustomizer.GetEdges(contracted_edge_list);
+}
+
+bool Contractor::ContractGraph(
     const EdgeID max_edge_id,
-    util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
-    util::DeallocatingVector<QueryEdge> &contracted_edge_list,
+    util::ChunkedVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
+    util::ChunkedVector<QueryEdge> &contracted_edge_list,
     std::vector<EdgeWeight> &&node_weights,
     std::vector<bool> &is_core_node,
     std::vector<float> &inout_node_levels) const
@@ -1017,12 +1392,42 @@ void Contractor::ContractGraph(
     std::vector<float> node_levels;
     node_levels.swap(inout_node_levels);
 
+    util::PhaseTrace::ScopedPhase building_phase("build contractor graph");
     GraphContractor graph_contractor(
         max_edge_id + 1, edge_based_edge_list, std::move(node_levels), std::move(node_weights));
-    graph_contractor.Run(config.core_factor);
+    building_phase.Stop();
+    WitnessSearchConfig witness_config;
+    witness_config.use_cache = config.use_witness_cache;
+    if (config.witness_hop_limit > 0)
+    {
+        witness_config.hop_limits.emplace_back(
+            config.witness_hop_limit_degree,
+            static_cast<short>(std::min<unsigned>(config.witness_hop_limit,
+                                                  std::numeric_limits<short>::max())));
+    }
+    CheckpointConfig checkpoint_config;
+    checkpoint_config.path = config.checkpoint_path;
+    checkpoint_config.interval = config.checkpoint_interval;
+    checkpoint_config.resume = config.resume;
+    std::unique_ptr<ScopedStopSignals> stop_signals;
+    if (config.checkpoint_interval > 0)
+    {
+        stop_requested = false;
+        stop_signals = util::make_unique<ScopedStopSignals>();
+        checkpoint_config.stop = [] { return stop_requested.load(); };
+    }
+    if (!graph_contractor.Run(config.core_factor, witness_config, checkpoint_config))
+    {
+        return false;
+    }
+    stop_signals.reset();
+
+    util::PhaseTrace::ScopedPhase edges_phase("get contracted edges");
     graph_contractor.GetEdges(contracted_edge_list);
+    edges_phase.Stop();
     graph_contractor.GetCoreMarker(is_core_node);
     graph_contractor.GetNodeLevels(inout_node_levels);
+    return true;
 }
 }
 }
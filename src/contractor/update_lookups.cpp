@@ -0,0 +1,468 @@
+#include "contractor/update_lookups.hpp"
+
+#include "util/exception.hpp"
+#include "util/simple_logger.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/spirit/include/qi.hpp>
+
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace osrm
+{
+namespace contractor
+{
+
+namespace
+{
+// CSV files are parsed in chunks of this many bytes, a line belongs to the chunk it starts in
+const std::size_t CSV_CHUNK_SIZE = 16 * 1024 * 1024;
+
+const std::uint32_t LOOKUP_VERSION = 1;
+const char SPEED_MAGIC[8] = {'O', 'S', 'R', 'M', 'S', 'P', 'D', 'S'};
+const char PENALTY_MAGIC[8] = {'O', 'S', 'R', 'M', 'T', 'R', 'N', 'S'};
+
+struct LookupHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t record_size;
+    std::uint64_t number_of_records;
+};
+
+struct SpeedRecord
+{
+    std::uint64_t from;
+    std::uint64_t to;
+    std::uint32_t speed;
+    std::uint32_t padding;
+};
+
+struct PenaltyRecord
+{
+    std::uint64_t from;
+    std::uint64_t via;
+    std::uint64_t to;
+    double penalty;
+};
+
+static_assert(sizeof(LookupHeader) == 24, "the header is written as it is");
+static_assert(sizeof(SpeedRecord) == 24, "the records are written as they are");
+static_assert(sizeof(PenaltyRecord) == 32, "the records are written as they are");
+
+// An entry with the position it was read from, which decides between the values of a key in
+// the same file
+template <typename Entry> struct ParsedEntry
+{
+    Entry entry;
+    std::uint64_t position;
+};
+
+const Segment &getKey(const SegmentSpeedSource &entry) { return entry.segment; }
+const Turn &getKey(const TurnPenaltySource &entry) { return entry.turn; }
+std::uint8_t &getSource(SegmentSpeedSource &entry) { return entry.speed_source.source; }
+std::uint8_t &getSource(TurnPenaltySource &entry) { return entry.penalty_source.source; }
+std::uint8_t getSource(const SegmentSpeedSource &entry) { return entry.speed_source.source; }
+std::uint8_t getSource(const TurnPenaltySource &entry) { return entry.penalty_source.source; }
+
+// from_node_id,to_node_id,speed with optional columns that are ignored
+bool parseLine(const char *first, const char *last, SegmentSpeedSource &entry)
+{
+    using namespace boost::spirit::qi;
+
+    std::uint64_t from_node_id{};
+    std::uint64_t to_node_id{};
+    unsigned speed{};
+
+    // The ulong_long -> uint64_t will likely break on 32bit platforms
+    const auto ok = parse(first,
+                          last,                                                                  //
+                          (ulong_long >> ',' >> ulong_long >> ',' >> uint_ >> *(',' >> *char_)), //
+                          from_node_id,
+                          to_node_id,
+                          speed); //
+
+    entry = SegmentSpeedSource{{OSMNodeID{from_node_id}, OSMNodeID{to_node_id}}, {speed, 0}};
+    return ok && first == last;
+}
+
+// from_node_id,via_node_id,to_node_id,penalty with optional columns that are ignored
+bool parseLine(const char *first, const char *last, TurnPenaltySource &entry)
+{
+    using namespace boost::spirit::qi;
+
+    std::uint64_t from_node_id{};
+    std::uint64_t via_node_id{};
+    std::uint64_t to_node_id{};
+    double penalty{};
+
+    // The ulong_long -> uint64_t will likely break on 32bit platforms
+    const auto ok = parse(first,
+                          last, //
+                          (ulong_long >> ',' >> ulong_long >> ',' >> ulong_long >> ',' >> double_ >>
+                           *(',' >> *char_)), //
+                          from_node_id,
+                          via_node_id,
+                          to_node_id,
+                          penalty); //
+
+    entry = TurnPenaltySource{
+        {OSMNodeID{from_node_id}, OSMNodeID{via_node_id}, OSMNodeID{to_node_id}}, {penalty, 0}};
+    return ok && first == last;
+}
+
+SegmentSpeedSource fromRecord(const SpeedRecord &record)
+{
+    return SegmentSpeedSource{{OSMNodeID{record.from}, OSMNodeID{record.to}}, {record.speed, 0}};
+}
+
+TurnPenaltySource fromRecord(const PenaltyRecord &record)
+{
+    return TurnPenaltySource{
+        {OSMNodeID{record.from}, OSMNodeID{record.via}, OSMNodeID{record.to}},
+        {record.penalty, 0}};
+}
+
+const char *getMagic(const SegmentSpeedSource &) { return SPEED_MAGIC; }
+const char *getMagic(const TurnPenaltySource &) { return PENALTY_MAGIC; }
+
+template <typename Record, typename Entry>
+void readBinaryFile(const std::string &filename,
+                    const char *data,
+                    const std::size_t size,
+                    std::vector<ParsedEntry<Entry>> &entries)
+{
+    LookupHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.version != LOOKUP_VERSION || header.record_size != sizeof(Record))
+    {
+        throw util::exception(filename + " was written by a different version, convert it again");
+    }
+    if (size != sizeof(header) + header.number_of_records * sizeof(Record))
+    {
+        throw util::exception(filename + " is truncated");
+    }
+
+    entries.resize(header.number_of_records);
+    const auto records = data + sizeof(header);
+    tbb::parallel_for(std::size_t{0}, entries.size(), [&](const std::size_t index) {
+        Record record;
+        std::memcpy(&record, records + index * sizeof(Record), sizeof(Record));
+        entries[index] = ParsedEntry<Entry>{fromRecord(record), index};
+    });
+}
+
+template <typename Entry>
+void parseCSVFile(const std::string &filename,
+                  const std::string &description,
+                  const char *data,
+                  const std::size_t size,
+                  std::vector<ParsedEntry<Entry>> &entries)
+{
+    const auto end = data + size;
+    const auto number_of_chunks = (size + CSV_CHUNK_SIZE - 1) / CSV_CHUNK_SIZE;
+    std::vector<std::vector<ParsedEntry<Entry>>> chunk_entries(number_of_chunks);
+
+    tbb::parallel_for(std::size_t{0}, number_of_chunks, [&](const std::size_t chunk) {
+        const auto chunk_end = data + std::min(size, (chunk + 1) * CSV_CHUNK_SIZE);
+        auto line = data + chunk * CSV_CHUNK_SIZE;
+        if (chunk > 0)
+        {
+            // skip the line that started in the previous chunk
+            line = std::find(line - 1, end, '\n');
+            line = line == end ? end : line + 1;
+        }
+
+        auto &local = chunk_entries[chunk];
+        while (line < chunk_end)
+        {
+            const auto line_end = std::find(line, end, '\n');
+            Entry entry;
+            if (!parseLine(line, line_end, entry))
+            {
+                throw util::exception("Malformed " + description + " " + filename +
+                                      " at byte " + std::to_string(line - data));
+            }
+            local.push_back(ParsedEntry<Entry>{entry, static_cast<std::uint64_t>(line - data)});
+            line = line_end == end ? end : line_end + 1;
+        }
+    });
+
+    std::vector<std::size_t> offsets(number_of_chunks + 1, 0);
+    for (std::size_t chunk = 0; chunk < number_of_chunks; ++chunk)
+    {
+        offsets[chunk + 1] = offsets[chunk] + chunk_entries[chunk].size();
+    }
+    entries.resize(offsets.back());
+    tbb::parallel_for(std::size_t{0}, number_of_chunks, [&](const std::size_t chunk) {
+        std::copy(chunk_entries[chunk].begin(),
+                  chunk_entries[chunk].end(),
+                  entries.begin() + offsets[chunk]);
+    });
+}
+
+template <typename Record, typename Entry>
+void readFile(const std::string &filename,
+              const std::string &description,
+              std::vector<ParsedEntry<Entry>> &entries)
+{
+    if (!boost::filesystem::is_regular_file(filename))
+    {
+        throw util::exception{"Unable to open " + description + " " + filename};
+    }
+    // empty files can't be mapped
+    const auto size = boost::filesystem::file_size(filename);
+    if (size == 0)
+    {
+        return;
+    }
+
+    using boost::interprocess::file_mapping;
+    using boost::interprocess::mapped_region;
+    using boost::interprocess::read_only;
+
+    const file_mapping mapping{filename.c_str(), read_only};
+    mapped_region region{mapping, read_only};
+    region.advise(mapped_region::advice_sequential);
+    const auto data = static_cast<const char *>(region.get_address());
+
+    const auto magic = getMagic(Entry{});
+    if (size >= sizeof(LookupHeader) && std::equal(magic, magic + sizeof(SPEED_MAGIC), data))
+    {
+        readBinaryFile<Record>(filename, data, size, entries);
+    }
+    else
+    {
+        parseCSVFile(filename, description, data, size, entries);
+    }
+}
+
+// Reads all files, sorts the values by their keys and keeps the value of the last file for each
+// key. Within a file the first or the last value of a key is kept.
+template <typename Record, typename Entry>
+std::vector<Entry> readFiles(const std::vector<std::string> &filenames,
+                             const std::string &description,
+                             const bool keep_last_of_file)
+{
+    std::vector<std::vector<ParsedEntry<Entry>>> file_entries(filenames.size());
+    tbb::parallel_for(std::size_t{0}, filenames.size(), [&](const std::size_t index) {
+        readFile<Record>(filenames[index], description, file_entries[index]);
+
+        // starts at one, zero means we assigned the weight
+        const auto file_id = static_cast<std::uint8_t>(index + 1);
+        for (auto &parsed : file_entries[index])
+        {
+            getSource(parsed.entry) = file_id;
+        }
+        util::SimpleLogger().Write() << "Loaded " << description << " " << filenames[index]
+                                     << " with " << file_entries[index].size() << " values";
+    });
+
+    std::vector<ParsedEntry<Entry>> entries;
+    for (auto &file : file_entries)
+    {
+        entries.insert(entries.end(), file.begin(), file.end());
+        std::vector<ParsedEntry<Entry>>().swap(file);
+    }
+
+    // the value that is kept comes first of all values of its key
+    tbb::parallel_sort(entries.begin(),
+                       entries.end(),
+                       [keep_last_of_file](const ParsedEntry<Entry> &lhs,
+                                           const ParsedEntry<Entry> &rhs) {
+                           if (getKey(lhs.entry) < getKey(rhs.entry))
+                               return true;
+                           if (getKey(rhs.entry) < getKey(lhs.entry))
+                               return false;
+                           if (getSource(lhs.entry) != getSource(rhs.entry))
+                               return getSource(lhs.entry) > getSource(rhs.entry);
+                           return keep_last_of_file ? lhs.position > rhs.position
+                                                    : lhs.position < rhs.position;
+                       });
+    const auto last = std::unique(
+        entries.begin(),
+        entries.end(),
+        [](const ParsedEntry<Entry> &lhs, const ParsedEntry<Entry> &rhs) {
+            return getKey(lhs.entry) == getKey(rhs.entry);
+        });
+    entries.erase(last, entries.end());
+
+    std::vector<Entry> lookup(entries.size());
+    tbb::parallel_for(std::size_t{0}, entries.size(), [&](const std::size_t index) {
+        lookup[index] = entries[index].entry;
+    });
+
+    util::SimpleLogger().Write() << "In total loaded " << filenames.size() << " " << description
+                                 << "(s) with a total of " << lookup.size() << " unique values";
+    return lookup;
+}
+
+template <typename Record, typename Entry, typename ToRecord>
+void writeFile(const std::string &filename,
+               const std::vector<Entry> &lookup,
+               const ToRecord &to_record)
+{
+    LookupHeader header;
+    const auto magic = getMagic(Entry{});
+    std::copy(magic, magic + sizeof(header.magic), header.magic);
+    header.version = LOOKUP_VERSION;
+    header.record_size = sizeof(Record);
+    header.number_of_records = lookup.size();
+
+    boost::filesystem::ofstream output(filename, std::ios::binary);
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    std::vector<Record> records;
+    const std::size_t block_size = 1024 * 1024;
+    for (std::size_t begin = 0; begin < lookup.size(); begin += block_size)
+    {
+        const auto end = std::min(lookup.size(), begin + block_size);
+        records.resize(end - begin);
+        std::transform(lookup.begin() + begin, lookup.begin() + end, records.begin(), to_record);
+        output.write(reinterpret_cast<const char *>(records.data()),
+                     records.size() * sizeof(Record));
+    }
+    if (!output)
+    {
+        throw util::exception("Could not write " + filename);
+    }
+}
+
+// the first entry from the position on whose key is not smaller than the key, found with steps
+// of growing size and a binary search within the last step
+template <typename Entry, typename Key>
+std::size_t gallop(const std::vector<Entry> &lookup, const std::size_t position, const Key &key)
+{
+    auto low = position;
+    auto high = position;
+    for (std::size_t step = 1; high < lookup.size() && getKey(lookup[high]) < key; step *= 2)
+    {
+        low = high + 1;
+        high = low + step;
+    }
+    high = std::min(high, lookup.size());
+    return std::distance(lookup.begin(),
+                         std::lower_bound(lookup.begin() + low,
+                                          lookup.begin() + high,
+                                          key,
+                                          [](const Entry &entry, const Key &key) {
+                                              return getKey(entry) < key;
+                                          }));
+}
+
+template <typename Entry, typename Key, typename Value>
+void findAll(const std::vector<Entry> &lookup,
+             const std::vector<Key> &keys,
+             std::vector<const Value *> &values,
+             const Value Entry::*value)
+{
+    values.assign(keys.size(), nullptr);
+    if (lookup.empty())
+    {
+        return;
+    }
+
+    std::vector<std::pair<Key, std::size_t>> sorted_keys(keys.size());
+    for (std::size_t index = 0; index < keys.size(); ++index)
+    {
+        sorted_keys[index] = std::make_pair(keys[index], index);
+    }
+    tbb::parallel_sort(sorted_keys.begin(),
+                       sorted_keys.end(),
+                       [](const std::pair<Key, std::size_t> &lhs,
+                          const std::pair<Key, std::size_t> &rhs) {
+                           return lhs.first < rhs.first;
+                       });
+
+    std::size_t position = 0;
+    for (const auto &key : sorted_keys)
+    {
+        position = gallop(lookup, position, key.first);
+        if (position == lookup.size())
+        {
+            break;
+        }
+        if (getKey(lookup[position]) == key.first)
+        {
+            values[key.second] = &(lookup[position].*value);
+        }
+    }
+}
+
+template <typename Entry, typename Key>
+const Entry *findEntry(const std::vector<Entry> &lookup, const Key &key)
+{
+    const auto it = std::lower_bound(
+        lookup.begin(), lookup.end(), key, [](const Entry &entry, const Key &key) {
+            return getKey(entry) < key;
+        });
+    if (it != lookup.end() && getKey(*it) == key)
+        return &*it;
+    return nullptr;
+}
+}
+
+const SpeedSource *find(const SegmentSpeedLookup &lookup, const Segment &segment)
+{
+    const auto entry = findEntry(lookup, segment);
+    return entry ? &entry->speed_source : nullptr;
+}
+
+const PenaltySource *find(const TurnPenaltyLookup &lookup, const Turn &turn)
+{
+    const auto entry = findEntry(lookup, turn);
+    return entry ? &entry->penalty_source : nullptr;
+}
+
+void find(const SegmentSpeedLookup &lookup,
+          const std::vector<Segment> &segments,
+          std::vector<const SpeedSource *> &speeds)
+{
+    findAll(lookup, segments, speeds, &SegmentSpeedSource::speed_source);
+}
+
+void find(const TurnPenaltyLookup &lookup,
+          const std::vector<Turn> &turns,
+          std::vector<const PenaltySource *> &penalties)
+{
+    findAll(lookup, turns, penalties, &TurnPenaltySource::penalty_source);
+}
+
+SegmentSpeedLookup readSegmentSpeedFiles(const std::vector<std::string> &filenames)
+{
+    return readFiles<SpeedRecord, SegmentSpeedSource>(filenames, "segment speed file", false);
+}
+
+TurnPenaltyLookup readTurnPenaltyFiles(const std::vector<std::string> &filenames)
+{
+    return readFiles<PenaltyRecord, TurnPenaltySource>(filenames, "turn penalty file", true);
+}
+
+void writeSegmentSpeedFile(const std::string &filename, const SegmentSpeedLookup &lookup)
+{
+    writeFile<SpeedRecord>(filename, lookup, [](const SegmentSpeedSource &entry) {
+        return SpeedRecord{static_cast<std::uint64_t>(entry.segment.from),
+                           static_cast<std::uint64_t>(entry.segment.to),
+                           entry.speed_source.speed,
+                           0};
+    });
+}
+
+void writeTurnPenaltyFile(const std::string &filename, const TurnPenaltyLookup &lookup)
+{
+    writeFile<PenaltyRecord>(filename, lookup, [](const TurnPenaltySource &entry) {
+        return PenaltyRecord{static_cast<std::uint64_t>(entry.turn.from),
+                             static_cast<std::uint64_t>(entry.turn.via),
+                             static_cast<std::uint64_t>(entry.turn.to),
+                             entry.penalty_source.penalty};
+    });
+}
+}
+}
@@ -0,0 +1,368 @@
+#include "customizer/customizer.hpp"
+#include "customizer/cell_customizer.hpp"
+
+#include "contractor/contractor.hpp"
+#include "contractor/crc32_processor.hpp"
+#include "extractor/class_data.hpp"
+#include "extractor/edge_based_edge.hpp"
+#include "partition/cell_storage.hpp"
+
+#include "util/chunked_vector.hpp"
+#include "util/exception.hpp"
+#include "util/fingerprint.hpp"
+#include "util/integer_range.hpp"
+#include "util/io.hpp"
+#include "util/simple_logger.hpp"
+#include "util/timing_util.hpp"
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace customizer
+{
+
+namespace
+{
+// an edge of the multi-level graph at the node it is stored at
+struct GraphEdge
+{
+    NodeID node;
+    contractor::QueryEdgeSearchData search_data;
+    contractor::QueryEdgeUnpackData unpack_data;
+};
+}
+
+int Customizer::Run()
+{
+    TIMER_START(loading);
+    util::ChunkedVector<extractor::EdgeBasedEdge> edge_based_edges;
+    const EdgeID max_edge_id =
+        contractor::Contractor::LoadEdgeExpandedGraph(config.edge_based_graph_path,
+                                                      edge_based_edges,
+                                                      config.edge_segment_lookup_path,
+                                                      config.edge_penalty_path,
+                                                      config.segment_speed_lookup_paths,
+                                                      config.turn_penalty_lookup_paths,
+                                                      config.node_based_graph_path,
+                                                      config.geometry_path,
+                                                      config.datasource_names_path,
+                                                      config.datasource_indexes_path,
+                                                      config.rtree_leaf_path);
+    const NodeID number_of_nodes = max_edge_id + 1;
+
+    // the engine uses the ids of the .hsgr, which osrm-contract may have renumbered
+    std::vector<NodeID> renumbering;
+    if (boost::filesystem::exists(config.node_renumbering_path) &&
+        (!util::deserializeVector(config.node_renumbering_path, renumbering) ||
+         renumbering.size() != number_of_nodes))
+    {
+        throw util::exception("Failed reading " + config.node_renumbering_path);
+    }
+    const auto partition = LoadPartition(renumbering);
+    if (partition.GetNumberOfNodes() != number_of_nodes)
+    {
+        throw util::exception(config.partition_path + " does not match the edge-based graph");
+    }
+    TIMER_STOP(loading);
+    util::SimpleLogger().Write() << "Loaded " << edge_based_edges.size() << " edges and "
+                                 << static_cast<unsigned>(partition.GetNumberOfLevels())
+                                 << " levels in " << TIMER_SEC(loading) << "s";
+
+    // every edge is stored at both of its nodes, so that the cells see the edges coming in
+    std::vector<GraphEdge> edges;
+    edges.reserve(2 * edge_based_edges.size());
+    for (const auto &edge : edge_based_edges)
+    {
+        const auto source = renumbering.empty() ? edge.source : renumbering[edge.source];
+        const auto target = renumbering.empty() ? edge.target : renumbering[edge.target];
+
+        GraphEdge graph_edge;
+        graph_edge.node = source;
+        graph_edge.search_data.target = target;
+        graph_edge.search_data.distance = edge.weight;
+        graph_edge.search_data.forward = edge.forward;
+        graph_edge.search_data.backward = edge.backward;
+        graph_edge.unpack_data.id = edge.edge_id;
+        graph_edge.unpack_data.shortcut = false;
+        graph_edge.unpack_data.length = edge.length;
+        edges.push_back(graph_edge);
+
+        graph_edge.node = target;
+        graph_edge.search_data.target = source;
+        graph_edge.search_data.forward = edge.backward;
+        graph_edge.search_data.backward = edge.forward;
+        edges.push_back(graph_edge);
+    }
+    util::ChunkedVector<extractor::EdgeBasedEdge>().swap(edge_based_edges);
+
+    tbb::parallel_sort(edges.begin(), edges.end(), [](const GraphEdge &lhs, const GraphEdge &rhs) {
+        return lhs.node < rhs.node ||
+               (lhs.node == rhs.node && lhs.search_data.target < rhs.search_data.target);
+    });
+
+    std::vector<contractor::QueryGraphNode> nodes(number_of_nodes + 1);
+    std::vector<contractor::QueryEdgeSearchData> search_edges;
+    std::vector<contractor::QueryEdgeUnpackData> unpack_edges;
+    search_edges.reserve(edges.size());
+    unpack_edges.reserve(edges.size());
+    for (const auto node : util::irange<NodeID>(0, number_of_nodes + 1))
+    {
+        nodes[node].first_edge = 0;
+    }
+    for (const auto &edge : edges)
+    {
+        ++nodes[edge.node + 1].first_edge;
+        search_edges.push_back(edge.search_data);
+        unpack_edges.push_back(edge.unpack_data);
+    }
+    std::vector<GraphEdge>().swap(edges);
+    for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+    {
+        nodes[node + 1].first_edge += nodes[node].first_edge;
+    }
+
+    TIMER_START(customizing);
+    const contractor::QueryGraphView graph(
+        number_of_nodes, nodes.data(), search_edges.empty() ? nullptr : search_edges.data());
+    partition::CellStorage cells(partition, graph);
+    SetupExclusions(renumbering, cells);
+    SetupEdgeWeights(unpack_edges, cells);
+    customizeCells(graph, cells);
+    TIMER_STOP(customizing);
+    util::SimpleLogger().Write() << "Customization of " << cells.GetView().GetNumberOfMetrics()
+                                 << " metrics took " << TIMER_SEC(customizing) << "s";
+
+    WriteGraph(nodes, search_edges, unpack_edges);
+    if (!cells.Write(config.cells_output_path))
+    {
+        throw util::exception("Failed writing " + config.cells_output_path);
+    }
+    return 0;
+}
+
+// The partition is computed on the ids of the .ebg, the cells of a node move to its new id
+partition::MultiLevelPartition
+Customizer::LoadPartition(const std::vector<NodeID> &renumbering) const
+{
+    partition::MultiLevelPartition partition;
+    if (!partition::readMultiLevelPartition(config.partition_path, partition))
+    {
+        throw util::exception("Failed reading " + config.partition_path +
+                              ", run osrm-partition first");
+    }
+    if (renumbering.empty())
+    {
+        return partition;
+    }
+    if (partition.GetNumberOfNodes() != renumbering.size())
+    {
+        throw util::exception(config.partition_path + " does not match " +
+                              config.node_renumbering_path);
+    }
+
+    const auto number_of_nodes = partition.GetNumberOfNodes();
+    std::vector<partition::CellID> cells(partition.GetCells().size());
+    for (const auto level : util::irange<partition::LevelID>(0, partition.GetNumberOfLevels()))
+    {
+        for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+        {
+            cells[std::size_t{level} * number_of_nodes + renumbering[node]] =
+                partition.GetCell(level, node);
+        }
+    }
+    return partition::MultiLevelPartition(partition.GetMaxCellSizes(), std::move(cells));
+}
+
+// Stores the classes of the nodes and adds a metric for every combination of --exclude. Datasets
+// of older versions of osrm-extract have no .classes and can't exclude anything.
+void Customizer::SetupExclusions(const std::vector<NodeID> &renumbering,
+                                 partition::CellStorage &cells) const
+{
+    if (!boost::filesystem::exists(config.classes_path))
+    {
+        if (!config.exclude_classes.empty())
+        {
+            throw util::exception(config.classes_path + " is needed for --exclude, run a newer " +
+                                  "osrm-extract first");
+        }
+        return;
+    }
+
+    std::vector<std::string> class_names;
+    std::vector<extractor::ClassData> node_classes;
+    if (!extractor::readClasses(config.classes_path, class_names, node_classes) ||
+        node_classes.size() != cells.GetView().GetNumberOfNodes())
+    {
+        throw util::exception("Failed reading " + config.classes_path);
+    }
+    if (!renumbering.empty())
+    {
+        std::vector<extractor::ClassData> renumbered_classes(node_classes.size());
+        for (const auto node : util::irange<NodeID>(0, node_classes.size()))
+        {
+            renumbered_classes[renumbering[node]] = node_classes[node];
+        }
+        node_classes.swap(renumbered_classes);
+    }
+    cells.SetClasses(std::move(node_classes), class_names);
+
+    std::vector<extractor::ClassData> exclude_masks;
+    for (const auto &classes : config.exclude_classes)
+    {
+        std::vector<std::string> names;
+        boost::split(names, classes, boost::is_any_of(","));
+        extractor::ClassData mask = 0;
+        for (const auto &name : names)
+        {
+            const auto class_index = extractor::findClass(class_names, name);
+            if (class_index == class_names.size())
+            {
+                throw util::exception("The profile has no class " + name + " to exclude");
+            }
+            mask |= extractor::getClassMask(class_index);
+        }
+        if (std::find(exclude_masks.begin(), exclude_masks.end(), mask) == exclude_masks.end())
+        {
+            exclude_masks.push_back(mask);
+            cells.AddMetric(mask);
+            util::SimpleLogger().Write() << "Adding a metric without " << classes;
+        }
+    }
+}
+
+// Adds the edge weights of every --metric and a metric with them for every combination of
+// --exclude. The weights start from those of the profile, like the ones of osrm-contract do, and
+// every edge of the graph gets the weight of its edge in the .ebg.
+void Customizer::SetupEdgeWeights(
+    const std::vector<contractor::QueryEdgeUnpackData> &unpack_edges,
+    partition::CellStorage &cells) const
+{
+    const auto split_option = [](const std::string &option,
+                                 std::string &name,
+                                 std::vector<std::string> &paths) {
+        const auto separator = option.find('=');
+        if (separator == std::string::npos || separator == 0 || separator + 1 == option.size())
+        {
+            throw util::exception("Metrics are given as NAME=FILE[,FILE ...], not " + option);
+        }
+        name = option.substr(0, separator);
+        const auto files = option.substr(separator + 1);
+        boost::split(paths, files, boost::is_any_of(","));
+    };
+
+    std::vector<std::string> names;
+    std::vector<std::vector<std::string>> segment_speed_paths;
+    std::vector<std::vector<std::string>> turn_penalty_paths;
+    for (const auto &option : config.metric_segment_speed_lookups)
+    {
+        std::string name;
+        std::vector<std::string> paths;
+        split_option(option, name, paths);
+        // the names have to fit into metric= of a query
+        if (!std::all_of(name.begin(), name.end(), [](const char c) {
+                return std::isalnum(static_cast<unsigned char>(c)) ||
+                       std::string("_.~:-").find(c) != std::string::npos;
+            }))
+        {
+            throw util::exception("The metric " + name +
+                                  " can only have letters, digits and _.~:- in its name");
+        }
+        if (std::find(names.begin(), names.end(), name) != names.end())
+        {
+            throw util::exception("The metric " + name + " is given twice");
+        }
+        names.push_back(name);
+        segment_speed_paths.push_back(std::move(paths));
+        turn_penalty_paths.emplace_back();
+    }
+    for (const auto &option : config.metric_turn_penalty_lookups)
+    {
+        std::string name;
+        std::vector<std::string> paths;
+        split_option(option, name, paths);
+        const auto found = std::find(names.begin(), names.end(), name) - names.begin();
+        if (found == static_cast<std::ptrdiff_t>(names.size()))
+        {
+            throw util::exception("Turn penalties of " + name + " need a --metric " + name);
+        }
+        auto &metric_paths = turn_penalty_paths[found];
+        metric_paths.insert(metric_paths.end(), paths.begin(), paths.end());
+    }
+
+    // all metrics so far have the weights of the graph
+    std::vector<extractor::ClassData> exclude_masks;
+    const auto view = cells.GetView();
+    for (const auto metric : util::irange<std::uint32_t>(0, view.GetNumberOfMetrics()))
+    {
+        exclude_masks.push_back(view.GetMetric(metric).GetExcludeMask());
+    }
+
+    for (const auto index : util::irange<std::size_t>(0, names.size()))
+    {
+        const auto ebg_weights =
+            contractor::Contractor::LoadEdgeWeights(config.edge_based_graph_path,
+                                                    config.edge_segment_lookup_path,
+                                                    config.edge_penalty_path,
+                                                    segment_speed_paths[index],
+                                                    turn_penalty_paths[index]);
+        std::vector<EdgeWeight> edge_weights(unpack_edges.size());
+        for (const auto edge : util::irange<std::size_t>(0, unpack_edges.size()))
+        {
+            if (unpack_edges[edge].id >= ebg_weights.size())
+            {
+                throw util::exception(config.edge_segment_lookup_path +
+                                      " does not match the edge-based graph");
+            }
+            edge_weights[edge] = ebg_weights[unpack_edges[edge].id];
+        }
+        const auto named_weights = cells.AddEdgeWeights(names[index], edge_weights);
+        for (const auto exclude_mask : exclude_masks)
+        {
+            cells.AddMetric(exclude_mask, named_weights);
+        }
+        util::SimpleLogger().Write() << "Adding the metric " << names[index];
+    }
+}
+
+// The .mldgr has the layout of the .hsgr, so it is read with util::readHSGRFromStream
+void Customizer::WriteGraph(const std::vector<contractor::QueryGraphNode> &nodes,
+                            const std::vector<contractor::QueryEdgeSearchData> &search_edges,
+                            const std::vector<contractor::QueryEdgeUnpackData> &unpack_edges) const
+{
+    boost::filesystem::ofstream stream(config.mld_graph_output_path, std::ios::binary);
+    const util::FingerPrint fingerprint = util::FingerPrint::GetValid();
+    stream.write(reinterpret_cast<const char *>(&fingerprint), sizeof(util::FingerPrint));
+
+    contractor::RangebasedCRC32 crc32_calculator;
+    const unsigned checksum = crc32_calculator(search_edges);
+    const unsigned number_of_nodes = nodes.size();
+    const unsigned number_of_edges = search_edges.size();
+    stream.write(reinterpret_cast<const char *>(&checksum), sizeof(unsigned));
+    stream.write(reinterpret_cast<const char *>(&number_of_nodes), sizeof(unsigned));
+    stream.write(reinterpret_cast<const char *>(&number_of_edges), sizeof(unsigned));
+    stream.write(reinterpret_cast<const char *>(nodes.data()),
+                 nodes.size() * sizeof(contractor::QueryGraphNode));
+    stream.write(reinterpret_cast<const char *>(search_edges.data()),
+                 search_edges.size() * sizeof(contractor::QueryEdgeSearchData));
+    stream.write(reinterpret_cast<const char *>(unpack_edges.data()),
+                 unpack_edges.size() * sizeof(contractor::QueryEdgeUnpackData));
+    if (!stream)
+    {
+        throw util::exception("Failed writing " + config.mld_graph_output_path);
+    }
+}
+}
+}
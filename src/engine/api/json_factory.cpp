@@ -175,6 +175,7 @@ std::string modeToString(const extractor::TravelMode mode)
 util::json::Object makeStepManeuver(const guidance::StepManeuver &maneuver)
 {
     util::json::Object step_maneuver;
+    step_maneuver.values.reserve(6);
     if (maneuver.waypoint_type == guidance::WaypointType::None)
         step_maneuver.values["type"] = detail::instructionTypeToString(maneuver.instruction.type);
     else
@@ -196,6 +197,7 @@ util::json::Object makeStepManeuver(const guidance::StepManeuver &maneuver)
 util::json::Object makeIntersection(const guidance::Intersection &intersection)
 {
     util::json::Object result;
+    result.values.reserve(6);
     util::json::Array bearings;
     util::json::Array entry;
 
@@ -216,8 +218,8 @@ util::json::Object makeIntersection(const guidance::Intersection &intersection)
                    });
 
     result.values["location"] = detail::coordinateToLonLat(intersection.location);
-    result.values["bearings"] = bearings;
-    result.values["entry"] = entry;
+    result.values["bearings"] = std::move(bearings);
+    result.values["entry"] = std::move(entry);
     if (intersection.in != guidance::Intersection::NO_INDEX)
         result.values["in"] = intersection.in;
     if (intersection.out != guidance::Intersection::NO_INDEX)
@@ -232,21 +234,22 @@ util::json::Object makeIntersection(const guidance::Intersection &intersection)
 util::json::Object makeRouteStep(guidance::RouteStep step, util::json::Value geometry)
 {
     util::json::Object route_step;
+    route_step.values.reserve(12);
     route_step.values["distance"] = std::round(step.distance * 10) / 10.;
     route_step.values["duration"] = std::round(step.duration * 10) / 10.;
-    route_step.values["name"] = std::move(step.name);
+    route_step.values["name"] = step.name.to_string();
     if (!step.ref.empty())
-        route_step.values["ref"] = std::move(step.ref);
+        route_step.values["ref"] = step.ref.to_string();
     if (!step.pronunciation.empty())
-        route_step.values["pronunciation"] = std::move(step.pronunciation);
+        route_step.values["pronunciation"] = step.pronunciation.to_string();
     if (!step.destinations.empty())
-        route_step.values["destinations"] = std::move(step.destinations);
+        route_step.values["destinations"] = step.destinations.to_string();
     if (!step.rotary_name.empty())
     {
-        route_step.values["rotary_name"] = std::move(step.rotary_name);
+        route_step.values["rotary_name"] = step.rotary_name.to_string();
         if (!step.rotary_pronunciation.empty())
         {
-            route_step.values["rotary_pronunciation"] = std::move(step.rotary_pronunciation);
+            route_step.values["rotary_pronunciation"] = step.rotary_pronunciation.to_string();
         }
     }
 
@@ -283,9 +286,10 @@ util::json::Object makeRoute(const guidance::Route &route,
 util::json::Object makeWaypoint(const util::Coordinate location, std::string name, const Hint &hint)
 {
     util::json::Object waypoint;
+    waypoint.values.reserve(3);
     waypoint.values["location"] = detail::coordinateToLonLat(location);
     waypoint.values["name"] = std::move(name);
-    waypoint.values["hint"] = hint.ToBase64();
+    waypoint.values["hint"] = hint.ToCompactBase64();
     return waypoint;
 }
 
@@ -0,0 +1,291 @@
+#include "engine/contour.hpp"
+#include "util/coordinate.hpp"
+#include "util/coordinate_calculation.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace osrm
+{
+namespace engine
+{
+
+namespace
+{
+const constexpr double MAX_GRID_SIZE = 2048;
+// empty cells around the drawn ones, so the outside is connected and a ring never leaves the grid
+const constexpr int GRID_MARGIN = 2;
+
+enum CellState : std::uint8_t
+{
+    EMPTY,
+    COVERED,
+    OUTSIDE
+};
+
+// the directions of the sides of the cells, in counterclockwise order
+enum Direction
+{
+    EAST,
+    NORTH,
+    WEST,
+    SOUTH
+};
+const constexpr int DIRECTION_DX[] = {1, 0, -1, 0};
+const constexpr int DIRECTION_DY[] = {0, 1, 0, -1};
+
+// The cell (x, y) spans the corners (x, y) to (x + 1, y + 1), the y axis points north
+class Grid
+{
+  public:
+    Grid(const int width, const int height)
+        : width(width), height(height), states(width * height, EMPTY),
+          polygons(width * height, NO_POLYGON)
+    {
+    }
+
+    bool Contains(const int x, const int y) const
+    {
+        return x >= 0 && y >= 0 && x < width && y < height;
+    }
+
+    std::uint8_t &State(const int x, const int y) { return states[y * width + x]; }
+    std::uint32_t &Polygon(const int x, const int y) { return polygons[y * width + x]; }
+
+    bool InPolygon(const int x, const int y, const std::uint32_t polygon) const
+    {
+        return Contains(x, y) && polygons[y * width + x] == polygon;
+    }
+
+    static constexpr std::uint32_t NO_POLYGON = std::numeric_limits<std::uint32_t>::max();
+
+    const int width;
+    const int height;
+
+  private:
+    std::vector<std::uint8_t> states;
+    std::vector<std::uint32_t> polygons;
+};
+
+constexpr std::uint32_t Grid::NO_POLYGON;
+
+// The outside is everything an empty cell at the border reaches through empty cells, including
+// diagonal steps, since a polygon of cells that only touch at a corner doesn't enclose them
+void markOutside(Grid &grid)
+{
+    std::vector<std::pair<int, int>> stack{{0, 0}};
+    grid.State(0, 0) = OUTSIDE;
+    while (!stack.empty())
+    {
+        const auto cell = stack.back();
+        stack.pop_back();
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                const int x = cell.first + dx;
+                const int y = cell.second + dy;
+                if (grid.Contains(x, y) && grid.State(x, y) == EMPTY)
+                {
+                    grid.State(x, y) = OUTSIDE;
+                    stack.emplace_back(x, y);
+                }
+            }
+        }
+    }
+}
+
+// Assigns the polygon to all cells that are not outside and share a side with the first cell
+void fillPolygon(Grid &grid, const int first_x, const int first_y, const std::uint32_t polygon)
+{
+    std::vector<std::pair<int, int>> stack{{first_x, first_y}};
+    grid.Polygon(first_x, first_y) = polygon;
+    while (!stack.empty())
+    {
+        const auto cell = stack.back();
+        stack.pop_back();
+        for (const auto direction : {EAST, NORTH, WEST, SOUTH})
+        {
+            const int x = cell.first + DIRECTION_DX[direction];
+            const int y = cell.second + DIRECTION_DY[direction];
+            if (grid.Contains(x, y) && grid.State(x, y) != OUTSIDE &&
+                grid.Polygon(x, y) == Grid::NO_POLYGON)
+            {
+                grid.Polygon(x, y) = polygon;
+                stack.emplace_back(x, y);
+            }
+        }
+    }
+}
+
+// true if the side from the corner in the direction has the polygon on its left and not on its
+// right
+bool isOutline(const Grid &grid,
+               const int x,
+               const int y,
+               const Direction direction,
+               const std::uint32_t polygon)
+{
+    switch (direction)
+    {
+    case EAST:
+        return grid.InPolygon(x, y, polygon) && !grid.InPolygon(x, y - 1, polygon);
+    case NORTH:
+        return grid.InPolygon(x - 1, y, polygon) && !grid.InPolygon(x, y, polygon);
+    case WEST:
+        return grid.InPolygon(x - 1, y - 1, polygon) && !grid.InPolygon(x - 1, y, polygon);
+    case SOUTH:
+        return grid.InPolygon(x, y - 1, polygon) && !grid.InPolygon(x - 1, y - 1, polygon);
+    }
+    return false;
+}
+
+// Walks along the sides of the cells with the polygon on the left, starting at the south side of
+// its lowest cell. Turning left before going straight keeps cells that only touch at a corner
+// apart, the same as the polygons are made of cells that share a side. Returns the corners.
+template <typename CornerT>
+void traceOutline(const Grid &grid,
+                  const int first_x,
+                  const int first_y,
+                  const std::uint32_t polygon,
+                  const CornerT &corner)
+{
+    int x = first_x;
+    int y = first_y;
+    auto direction = EAST;
+    corner(x, y);
+    do
+    {
+        x += DIRECTION_DX[direction];
+        y += DIRECTION_DY[direction];
+
+        const auto left = static_cast<Direction>((direction + 1) % 4);
+        const auto right = static_cast<Direction>((direction + 3) % 4);
+        auto next = right;
+        if (isOutline(grid, x, y, left, polygon))
+        {
+            next = left;
+        }
+        else if (isOutline(grid, x, y, direction, polygon))
+        {
+            next = direction;
+        }
+        BOOST_ASSERT(next != right || isOutline(grid, x, y, right, polygon));
+
+        if (next != direction)
+        {
+            corner(x, y);
+        }
+        direction = next;
+    } while (x != first_x || y != first_y || direction != EAST);
+}
+}
+
+std::vector<std::vector<util::Coordinate>> makeContour(const std::vector<ContourSegment> &segments,
+                                                       const double cell_size)
+{
+    BOOST_ASSERT(cell_size > 0);
+    std::vector<std::vector<util::Coordinate>> rings;
+    if (segments.empty())
+    {
+        return rings;
+    }
+
+    std::int32_t min_lon = std::numeric_limits<std::int32_t>::max();
+    std::int32_t min_lat = std::numeric_limits<std::int32_t>::max();
+    std::int32_t max_lon = std::numeric_limits<std::int32_t>::min();
+    std::int32_t max_lat = std::numeric_limits<std::int32_t>::min();
+    for (const auto &segment : segments)
+    {
+        for (const auto &coordinate : {segment.from, segment.to})
+        {
+            min_lon = std::min(min_lon, static_cast<std::int32_t>(coordinate.lon));
+            min_lat = std::min(min_lat, static_cast<std::int32_t>(coordinate.lat));
+            max_lon = std::max(max_lon, static_cast<std::int32_t>(coordinate.lon));
+            max_lat = std::max(max_lat, static_cast<std::int32_t>(coordinate.lat));
+        }
+    }
+
+    // the size of a cell in fixed point degrees, the cells are square at the center latitude
+    const double degree_to_rad = util::coordinate_calculation::detail::DEGREE_TO_RAD;
+    const double meters_per_degree =
+        util::coordinate_calculation::detail::EARTH_RADIUS * degree_to_rad;
+    const double center_latitude = (min_lat + max_lat) / 2. / COORDINATE_PRECISION;
+    const double center_cosine = std::max(std::cos(center_latitude * degree_to_rad), 0.01);
+    double lat_step = cell_size / meters_per_degree * COORDINATE_PRECISION;
+    double lon_step = lat_step / center_cosine;
+    const double scale = std::max({1.,
+                                   (max_lon - min_lon) / lon_step / MAX_GRID_SIZE,
+                                   (max_lat - min_lat) / lat_step / MAX_GRID_SIZE});
+    lat_step *= scale;
+    lon_step *= scale;
+
+    const double origin_lon = min_lon - GRID_MARGIN * lon_step;
+    const double origin_lat = min_lat - GRID_MARGIN * lat_step;
+    Grid grid(static_cast<int>((max_lon - min_lon) / lon_step) + 2 * GRID_MARGIN + 1,
+              static_cast<int>((max_lat - min_lat) / lat_step) + 2 * GRID_MARGIN + 1);
+
+    // every segment covers the cells of points at most half a cell apart, and their neighbours
+    for (const auto &segment : segments)
+    {
+        const double from_x = (static_cast<std::int32_t>(segment.from.lon) - origin_lon) / lon_step;
+        const double from_y = (static_cast<std::int32_t>(segment.from.lat) - origin_lat) / lat_step;
+        const double to_x = (static_cast<std::int32_t>(segment.to.lon) - origin_lon) / lon_step;
+        const double to_y = (static_cast<std::int32_t>(segment.to.lat) - origin_lat) / lat_step;
+        const int number_of_steps = static_cast<int>(
+            std::ceil(2 * std::max(std::abs(to_x - from_x), std::abs(to_y - from_y))));
+        for (int step = 0; step <= number_of_steps; ++step)
+        {
+            const double factor = number_of_steps == 0 ? 0. : step / double(number_of_steps);
+            const int x = static_cast<int>(from_x + factor * (to_x - from_x));
+            const int y = static_cast<int>(from_y + factor * (to_y - from_y));
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    BOOST_ASSERT(grid.Contains(x + dx, y + dy));
+                    grid.State(x + dx, y + dy) = COVERED;
+                }
+            }
+        }
+    }
+
+    markOutside(grid);
+
+    const auto to_coordinate = [&](const int x, const int y) {
+        return util::Coordinate{util::FixedLongitude{static_cast<std::int32_t>(
+                                    std::lround(origin_lon + x * lon_step))},
+                                util::FixedLatitude{static_cast<std::int32_t>(
+                                    std::lround(origin_lat + y * lat_step))}};
+    };
+
+    // the first cell of a polygon in this order is on its lowest row
+    for (int y = 0; y < grid.height; ++y)
+    {
+        for (int x = 0; x < grid.width; ++x)
+        {
+            if (grid.State(x, y) == OUTSIDE || grid.Polygon(x, y) != Grid::NO_POLYGON)
+            {
+                continue;
+            }
+            const auto polygon = static_cast<std::uint32_t>(rings.size());
+            fillPolygon(grid, x, y, polygon);
+
+            rings.emplace_back();
+            auto &ring = rings.back();
+            traceOutline(grid, x, y, polygon, [&](const int corner_x, const int corner_y) {
+                ring.push_back(to_coordinate(corner_x, corner_y));
+            });
+            BOOST_ASSERT(ring.size() >= 5 && ring.front() == ring.back());
+        }
+    }
+
+    return rings;
+}
+}
+}
@@ -0,0 +1,113 @@
+#include "engine/datafacade/block_registry.hpp"
+
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+namespace osrm
+{
+namespace engine
+{
+namespace datafacade
+{
+
+namespace
+{
+inline std::uint64_t rotateLeft(const std::uint64_t value, const int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline std::uint64_t finalize(std::uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+}
+
+// Two independent hashes of the contents in one pass over eight bytes at a time, which is fast
+// enough to hash the files while they are loaded
+BlockRegistry::Key BlockRegistry::MakeKey(const std::size_t domain,
+                                          std::string type,
+                                          const char *contents,
+                                          const std::size_t size)
+{
+    std::uint64_t hash_1 = 0x9e3779b97f4a7c15ULL ^ size;
+    std::uint64_t hash_2 = 0x6a09e667f3bcc909ULL;
+    std::size_t position = 0;
+    const auto add = [&](const std::uint64_t word) {
+        hash_1 ^= rotateLeft(word * 0x87c37b91114253d5ULL, 31) * 0x4cf5ad432745937fULL;
+        hash_1 = rotateLeft(hash_1, 27) * 5 + 0x52dce729;
+        hash_2 = rotateLeft(hash_2 + word * 0xc2b2ae3d27d4eb4fULL, 29) * 0x9e3779b185ebca87ULL;
+    };
+    for (; position + sizeof(std::uint64_t) <= size; position += sizeof(std::uint64_t))
+    {
+        std::uint64_t word;
+        std::memcpy(&word, contents + position, sizeof(word));
+        add(word);
+    }
+    if (position < size)
+    {
+        std::uint64_t word = 0;
+        std::memcpy(&word, contents + position, size - position);
+        add(word);
+    }
+    return Key{domain, std::move(type), size, finalize(hash_1), finalize(hash_2 ^ hash_1)};
+}
+
+BlockRegistry &BlockRegistry::GetInstance()
+{
+    static BlockRegistry registry;
+    return registry;
+}
+
+std::size_t BlockRegistry::GetNumberOfBlocks() const
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    std::size_t number_of_blocks = 0;
+    for (const auto &block : blocks)
+    {
+        if (!block.second.expired())
+        {
+            ++number_of_blocks;
+        }
+    }
+    return number_of_blocks;
+}
+
+std::shared_ptr<const void> BlockRegistry::FindBlock(const Key &key)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    const auto iter = blocks.find(key);
+    return iter == blocks.end() ? nullptr : iter->second.lock();
+}
+
+std::shared_ptr<const void> BlockRegistry::ShareBlock(const Key &key,
+                                                      std::shared_ptr<const void> block)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    RemoveExpired();
+    auto &registered = blocks[key];
+    if (auto registered_block = registered.lock())
+    {
+        return registered_block;
+    }
+    registered = block;
+    return block;
+}
+
+// only called while blocks are registered, which happens as often as datasets are loaded
+void BlockRegistry::RemoveExpired()
+{
+    for (auto iter = blocks.begin(); iter != blocks.end();)
+    {
+        iter = iter->second.expired() ? blocks.erase(iter) : std::next(iter);
+    }
+}
+}
+}
+}
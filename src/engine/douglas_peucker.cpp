@@ -8,8 +8,9 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <iterator>
-#include <stack>
+#include <limits>
 #include <utility>
 
 namespace osrm
@@ -17,18 +18,111 @@ namespace osrm
 namespace engine
 {
 
-// Normed to the thresholds table
-std::uint64_t fastPerpendicularDistance(const util::FloatCoordinate &projected_start,
-                                        const util::FloatCoordinate &projected_target,
-                                        const util::FloatCoordinate &projected)
+namespace
 {
-    util::FloatCoordinate projected_point_on_segment;
-    std::tie(std::ignore, projected_point_on_segment) =
-        util::coordinate_calculation::projectPointOnSegment(
-            projected_start, projected_target, projected);
-    auto squared_distance = util::coordinate_calculation::squaredEuclideanDistance(
-        projected, projected_point_on_segment);
-    return squared_distance;
+// The projected coordinates split by component so the distance scan runs over contiguous
+// arrays, both in floating point and in fixed point representation. Reused by the geometries a
+// thread simplifies.
+struct ProjectedGeometry
+{
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<std::int32_t> fixed_xs;
+    std::vector<std::int32_t> fixed_ys;
+    // the input index of each projected coordinate
+    std::vector<std::size_t> indices;
+
+    void Clear()
+    {
+        xs.clear();
+        ys.clear();
+        fixed_xs.clear();
+        fixed_ys.clear();
+        indices.clear();
+    }
+
+    void Add(const util::FloatCoordinate projected, const std::size_t index)
+    {
+        xs.push_back(static_cast<double>(projected.lon));
+        ys.push_back(static_cast<double>(projected.lat));
+        fixed_xs.push_back(static_cast<std::int32_t>(util::toFixed(projected.lon)));
+        fixed_ys.push_back(static_cast<std::int32_t>(util::toFixed(projected.lat)));
+        indices.push_back(index);
+    }
+
+    std::size_t Size() const { return xs.size(); }
+};
+
+// Squared distances of the coordinates between first and last to the segment between them,
+// normed to the thresholds table. This is projectPointOnSegment followed by the fixed point
+// squaredEuclideanDistance, written without branches so that the loops are vectorized.
+void perpendicularDistances(const ProjectedGeometry &geometry,
+                            const std::size_t first,
+                            const std::size_t last,
+                            std::vector<double> &distances)
+{
+    const auto *const xs = geometry.xs.data() + first + 1;
+    const auto *const ys = geometry.ys.data() + first + 1;
+    const auto *const fixed_xs = geometry.fixed_xs.data() + first + 1;
+    const auto *const fixed_ys = geometry.fixed_ys.data() + first + 1;
+    const double start_x = geometry.xs[first];
+    const double start_y = geometry.ys[first];
+    const double target_x = geometry.xs[last];
+    const double target_y = geometry.ys[last];
+    const double slope_x = target_x - start_x;
+    const double slope_y = target_y - start_y;
+    const double squared_length = slope_x * slope_x + slope_y * slope_y;
+    // a segment without length projects everything on its start
+    const bool has_length = squared_length >= std::numeric_limits<double>::epsilon();
+    const double divisor = has_length ? squared_length : 1.;
+    const double ratio_factor = has_length ? 1. : 0.;
+
+    distances.resize(last - first - 1);
+    auto *const out = distances.data();
+    const auto count = distances.size();
+    // the clamped ratios of the projections first, mixing them with the conversion to fixed
+    // point below keeps the compiler from vectorizing the loop
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const double unnormed_ratio = slope_x * (xs[i] - start_x) + slope_y * (ys[i] - start_y);
+        out[i] = std::min(1., std::max(0., ratio_factor * (unnormed_ratio / divisor)));
+    }
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const double clamped_ratio = out[i];
+        const double on_segment_x = (1.0 - clamped_ratio) * start_x + target_x * clamped_ratio;
+        const double on_segment_y = (1.0 - clamped_ratio) * start_y + target_y * clamped_ratio;
+        const double delta_x = static_cast<double>(
+            fixed_xs[i] - static_cast<std::int32_t>(on_segment_x * COORDINATE_PRECISION));
+        const double delta_y = static_cast<double>(
+            fixed_ys[i] - static_cast<std::int32_t>(on_segment_y * COORDINATE_PRECISION));
+        out[i] = delta_x * delta_x + delta_y * delta_y;
+    }
+}
+
+// Drops the coordinates that are closer than half the tolerance to the last kept one, which
+// bounds the deviation the simplification adds to the one of the plain algorithm.
+void projectWithRadialFilter(std::vector<util::Coordinate>::const_iterator begin,
+                             const std::size_t size,
+                             const double threshold,
+                             ProjectedGeometry &geometry)
+{
+    const double filter_threshold = threshold / 4.;
+    geometry.Add(util::web_mercator::fromWGS84(begin[0]), 0);
+    for (std::size_t index = 1; index + 1 < size; ++index)
+    {
+        const auto projected = util::web_mercator::fromWGS84(begin[index]);
+        const double delta_x = static_cast<double>(
+            static_cast<std::int32_t>(util::toFixed(projected.lon)) - geometry.fixed_xs.back());
+        const double delta_y = static_cast<double>(
+            static_cast<std::int32_t>(util::toFixed(projected.lat)) - geometry.fixed_ys.back());
+        if (delta_x * delta_x + delta_y * delta_y > filter_threshold)
+        {
+            geometry.Add(projected, index);
+        }
+    }
+    geometry.Add(util::web_mercator::fromWGS84(begin[size - 1]), size - 1);
+}
 }
 
 std::vector<util::Coordinate> douglasPeucker(std::vector<util::Coordinate>::const_iterator begin,
@@ -44,76 +138,77 @@ std::vector<util::Coordinate> douglasPeucker(std::vector<util::Coordinate>::cons
         return {};
     }
 
-    std::vector<util::FloatCoordinate> projected_coordinates(size);
-    std::transform(begin, end, projected_coordinates.begin(), [](const util::Coordinate coord) {
-        return util::web_mercator::fromWGS84(coord);
-    });
+    const auto threshold = static_cast<double>(detail::DOUGLAS_PEUCKER_THRESHOLDS[zoom_level]);
+
+    thread_local ProjectedGeometry geometry;
+    geometry.Clear();
+    if (size > detail::DOUGLAS_PEUCKER_RADIAL_FILTER_SIZE)
+    {
+        projectWithRadialFilter(begin, size, threshold, geometry);
+    }
+    else
+    {
+        for (auto idx : util::irange<std::size_t>(0UL, size))
+        {
+            geometry.Add(util::web_mercator::fromWGS84(begin[idx]), idx);
+        }
+    }
+    const auto projected_size = geometry.Size();
 
-    std::vector<bool> is_necessary(size, false);
+    thread_local std::vector<unsigned char> is_necessary;
+    is_necessary.assign(projected_size, false);
     BOOST_ASSERT(is_necessary.size() >= 2);
     is_necessary.front() = true;
     is_necessary.back() = true;
     using GeometryRange = std::pair<std::size_t, std::size_t>;
 
-    std::stack<GeometryRange> recursion_stack;
+    thread_local std::vector<GeometryRange> recursion_stack;
+    thread_local std::vector<double> distances;
+    recursion_stack.clear();
 
-    recursion_stack.emplace(0UL, size - 1);
+    recursion_stack.emplace_back(0UL, projected_size - 1);
 
     // mark locations as 'necessary' by divide-and-conquer
     while (!recursion_stack.empty())
     {
         // pop next element
-        const GeometryRange pair = recursion_stack.top();
-        recursion_stack.pop();
+        const GeometryRange pair = recursion_stack.back();
+        recursion_stack.pop_back();
         // sanity checks
         BOOST_ASSERT_MSG(is_necessary[pair.first], "left border must be necessary");
         BOOST_ASSERT_MSG(is_necessary[pair.second], "right border must be necessary");
-        BOOST_ASSERT_MSG(pair.second < size, "right border outside of geometry");
+        BOOST_ASSERT_MSG(pair.second < projected_size, "right border outside of geometry");
         BOOST_ASSERT_MSG(pair.first <= pair.second, "left border on the wrong side");
 
-        std::uint64_t max_distance = 0;
-        auto farthest_entry_index = pair.second;
-
-        // sweep over range to find the maximum
-        for (auto idx = pair.first + 1; idx != pair.second; ++idx)
+        if (pair.second - pair.first < 2)
         {
-            using namespace util::coordinate_calculation;
-            const auto distance = fastPerpendicularDistance(projected_coordinates[pair.first],
-                                                            projected_coordinates[pair.second],
-                                                            projected_coordinates[idx]);
-            // found new feasible maximum?
-            if (distance > max_distance &&
-                distance > detail::DOUGLAS_PEUCKER_THRESHOLDS[zoom_level])
-            {
-                farthest_entry_index = idx;
-                max_distance = distance;
-            }
+            continue;
         }
 
+        // sweep over range to find the maximum
+        perpendicularDistances(geometry, pair.first, pair.second, distances);
+        const auto farthest = std::max_element(distances.begin(), distances.end());
+
         // check if maximum violates a zoom level dependent threshold
-        if (max_distance > detail::DOUGLAS_PEUCKER_THRESHOLDS[zoom_level])
+        if (*farthest > threshold)
         {
+            const auto farthest_entry_index =
+                pair.first + 1 + std::distance(distances.begin(), farthest);
             //  mark idx as necessary
             is_necessary[farthest_entry_index] = true;
-            if (pair.first < farthest_entry_index)
-            {
-                recursion_stack.emplace(pair.first, farthest_entry_index);
-            }
-            if (farthest_entry_index < pair.second)
-            {
-                recursion_stack.emplace(farthest_entry_index, pair.second);
-            }
+            recursion_stack.emplace_back(pair.first, farthest_entry_index);
+            recursion_stack.emplace_back(farthest_entry_index, pair.second);
         }
     }
 
     auto simplified_size = std::count(is_necessary.begin(), is_necessary.end(), true);
     std::vector<util::Coordinate> simplified_geometry;
     simplified_geometry.reserve(simplified_size);
-    for (auto idx : util::irange<std::size_t>(0UL, size))
+    for (auto idx : util::irange<std::size_t>(0UL, projected_size))
     {
         if (is_necessary[idx])
         {
-            simplified_geometry.push_back(begin[idx]);
+            simplified_geometry.push_back(begin[geometry.indices[idx]]);
         }
     }
 
@@ -1,10 +1,21 @@
+#include "engine/api/route_batch_parameters.hpp"
 #include "engine/api/route_parameters.hpp"
 #include "engine/engine.hpp"
 #include "engine/engine_config.hpp"
+#include "engine/match_sessions.hpp"
+#include "engine/search_engine_data.hpp"
+#include "engine/search_space_cache.hpp"
+#include "engine/snapping_cache.hpp"
+#include "engine/table_sessions.hpp"
+#include "engine/tile_cache.hpp"
 #include "engine/status.hpp"
+#include "engine/traffic_overlay.hpp"
+#include "engine/unpacking_cache.hpp"
 
+#include "engine/plugins/isochrone.hpp"
 #include "engine/plugins/match.hpp"
 #include "engine/plugins/nearest.hpp"
+#include "engine/plugins/one_to_all.hpp"
 #include "engine/plugins/table.hpp"
 #include "engine/plugins/tile.hpp"
 #include "engine/plugins/trip.hpp"
@@ -14,61 +25,217 @@
 #include "engine/datafacade/internal_datafacade.hpp"
 #include "engine/datafacade/shared_datafacade.hpp"
 
-#include "storage/shared_barriers.hpp"
+#include "extractor/class_data.hpp"
+#include "storage/traffic_overlay.hpp"
+#include "util/integer_range.hpp"
+#include "util/json_renderer.hpp"
 #include "util/make_unique.hpp"
+#include "util/numa.hpp"
+#include "util/page_faults.hpp"
+#include "util/page_heat.hpp"
+#include "util/query_arena.hpp"
 #include "util/simple_logger.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/interprocess/sync/named_condition.hpp>
-#include <boost/interprocess/sync/scoped_lock.hpp>
-#include <boost/interprocess/sync/sharable_lock.hpp>
-#include <boost/thread/lock_types.hpp>
+
+#include <tbb/task_arena.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
 #include <fstream>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace
 {
-// Abstracted away the query locking into a template function
-// Works the same for every plugin.
-template <typename ParameterT, typename PluginT, typename ResultT>
-osrm::engine::Status
-RunQuery(const std::unique_ptr<osrm::storage::SharedBarriers> &lock,
-         osrm::engine::datafacade::BaseDataFacade &facade,
-         const ParameterT &parameters,
-         PluginT &plugin,
-         ResultT &result)
+template <typename Plugin, typename Facade, typename... Args>
+std::unique_ptr<Plugin> create(Facade &facade, Args... args)
 {
-    if (!lock)
+    return osrm::util::make_unique<Plugin>(facade, std::forward<Args>(args)...);
+}
+
+void recordSearchStatistics(const osrm::util::QueryMetrics::Service service,
+                            const osrm::engine::SearchStatistics &statistics)
+{
+    using osrm::util::QueryMetrics;
+    auto &metrics = QueryMetrics::GetInstance();
+    metrics.AddSearchCount(
+        service, QueryMetrics::SearchCounter::SettledNodes, statistics.settled_nodes);
+    metrics.AddSearchCount(
+        service, QueryMetrics::SearchCounter::RelaxedEdges, statistics.relaxed_edges);
+    metrics.AddSearchCount(
+        service, QueryMetrics::SearchCounter::StalledNodes, statistics.stalled_nodes);
+    metrics.AddSearchCount(
+        service, QueryMetrics::SearchCounter::CoreEntries, statistics.core_entries);
+    metrics.AddSearchCount(
+        service, QueryMetrics::SearchCounter::UnpackedShortcuts, statistics.unpacked_shortcuts);
+}
+
+// the statistics go into the debug field of JSON responses of queries with debug=true
+template <typename ParameterT>
+typename std::enable_if<std::is_base_of<osrm::engine::api::BaseParameters, ParameterT>::value>::type
+addDebugField(const ParameterT &parameters,
+              const osrm::engine::SearchStatistics &statistics,
+              osrm::util::json::Object &result)
+{
+    if (!parameters.debug)
     {
-        return plugin.HandleRequest(parameters, result);
+        return;
     }
+    osrm::util::json::Object debug;
+    debug.values["settled_nodes"] = statistics.settled_nodes;
+    debug.values["relaxed_edges"] = statistics.relaxed_edges;
+    debug.values["stalled_nodes"] = statistics.stalled_nodes;
+    debug.values["core_entries"] = statistics.core_entries;
+    debug.values["unpacked_shortcuts"] = statistics.unpacked_shortcuts;
+    result.values["debug"] = std::move(debug);
+}
+
+// tiles and rendered responses have no place for them
+template <typename ParameterT, typename ResultT>
+void addDebugField(const ParameterT &, const osrm::engine::SearchStatistics &, ResultT &)
+{
+}
+
+// the services whose searches add the penalties of the traffic overlay, matching follows the
+// roads the trace was driven on whatever the traffic
+bool usesTrafficOverlay(const osrm::util::QueryMetrics::Service service)
+{
+    using Service = osrm::util::QueryMetrics::Service;
+    return service == Service::Route || service == Service::RouteBatch ||
+           service == Service::Table || service == Service::Trip;
+}
 
-    BOOST_ASSERT(lock);
-    // this locks aquires shared ownership of the query mutex: other requets are allowed
-    // to run, but data updates need to wait for all queries to finish until they can aquire an exclusive lock
-    boost::interprocess::sharable_lock<boost::interprocess::named_sharable_mutex> query_lock(
-        lock->query_mutex);
+// the services that search the multi-level graph with the metric of excluded classes or other
+// edge weights, the searches of the others run on the contraction hierarchy or on all nodes
+bool supportsCellMetric(const osrm::util::QueryMetrics::Service service)
+{
+    using Service = osrm::util::QueryMetrics::Service;
+    return service == Service::Route || service == Service::RouteBatch ||
+           service == Service::Table || service == Service::Nearest ||
+           service == Service::Trip || service == Service::Match;
+}
 
-    auto &shared_facade = static_cast<osrm::engine::datafacade::SharedDataFacade &>(facade);
-    shared_facade.CheckAndReloadFacade();
-    // Get a shared data lock so that other threads won't update
-    // things while the query is running
-    boost::shared_lock<boost::shared_mutex> data_lock{shared_facade.data_mutex};
+// the metric of the cells that avoids the classes of exclude= with the edge weights of metric=,
+// 0 without either
+template <typename ParameterT>
+typename std::enable_if<std::is_base_of<osrm::engine::api::BaseParameters, ParameterT>::value,
+                        std::uint32_t>::type
+findCellMetric(const osrm::util::QueryMetrics::Service service,
+               const osrm::engine::datafacade::BaseDataFacade &facade,
+               const ParameterT &parameters)
+{
+    using osrm::engine::QueryAborted;
+    using osrm::engine::Status;
+    if (parameters.exclude.empty() && parameters.metric.empty())
+    {
+        return 0;
+    }
+    if (!supportsCellMetric(service))
+    {
+        throw QueryAborted(Status::Error,
+                           "NotImplemented",
+                           parameters.exclude.empty()
+                               ? "Selecting a metric is not supported by this service"
+                               : "Excluding classes is not supported by this service");
+    }
+    if (!facade.HasMultiLevelData())
+    {
+        throw QueryAborted(Status::Error,
+                           "InvalidValue",
+                           parameters.exclude.empty()
+                               ? "Metrics need a dataset made with osrm-customize --metric"
+                               : "Excluding classes needs a dataset made with osrm-customize "
+                                 "--exclude");
+    }
 
-    osrm::engine::Status status = plugin.HandleRequest(parameters, result);
+    const auto &cells = facade.GetCellStorage();
+    std::uint32_t edge_weights = 0;
+    if (!parameters.metric.empty())
+    {
+        edge_weights = cells.FindEdgeWeights(parameters.metric);
+        if (edge_weights > cells.GetEdgeWeightNames().size())
+        {
+            throw QueryAborted(Status::Error, "InvalidValue", "Metric names an unknown metric");
+        }
+    }
 
-    return status;
+    const auto class_names = cells.GetClassNames();
+    osrm::extractor::ClassData mask = 0;
+    for (const auto &name : parameters.exclude)
+    {
+        const auto class_index = osrm::extractor::findClass(class_names, name);
+        if (class_index == class_names.size())
+        {
+            throw QueryAborted(Status::Error, "InvalidValue", "Exclude names an unknown class");
+        }
+        mask |= osrm::extractor::getClassMask(class_index);
+    }
+    const auto metric = cells.FindMetric(mask, edge_weights);
+    if (metric == cells.GetNumberOfMetrics())
+    {
+        throw QueryAborted(Status::Error,
+                           "InvalidValue",
+                           "The dataset is not customized for excluding these classes");
+    }
+    return metric;
 }
 
-template <typename Plugin, typename Facade, typename... Args>
-std::unique_ptr<Plugin> create(Facade &facade, Args... args)
+// tiles have no exclusions, and match batches ignore the route options of their traces
+template <typename ParameterT>
+typename std::enable_if<!std::is_base_of<osrm::engine::api::BaseParameters, ParameterT>::value,
+                        std::uint32_t>::type
+findCellMetric(const osrm::util::QueryMetrics::Service,
+               const osrm::engine::datafacade::BaseDataFacade &,
+               const ParameterT &)
 {
-    return osrm::util::make_unique<Plugin>(facade, std::forward<Args>(args)...);
+    return 0;
+}
+
+// the error of an aborted query, in the format of the result
+template <typename ResultT>
+void setAbortError(const osrm::engine::QueryAborted &aborted, ResultT &result)
+{
+    result.code = aborted.code;
+    result.message = aborted.message;
+}
+
+void setAbortError(const osrm::engine::QueryAborted &aborted, osrm::util::json::Object &result)
+{
+    result.values["code"] = aborted.code;
+    result.values["message"] = aborted.message;
+}
+
+void setAbortError(const osrm::engine::QueryAborted &aborted, std::string &result)
+{
+    osrm::util::json::Object json_result;
+    setAbortError(aborted, json_result);
+    result.clear();
+    osrm::util::json::render(result, json_result);
+}
+
+// the receiver of a stream only gets the error if no part was written yet
+void setAbortError(const osrm::engine::QueryAborted &aborted,
+                   osrm::engine::api::TableStream &result)
+{
+    setAbortError(aborted, result.error);
 }
 
+// drops what an aborted query left in the result
+template <typename ResultT> void resetResult(ResultT &result) { result = ResultT(); }
+
+// the parts of a stream are written already, its writer is kept
+void resetResult(osrm::engine::api::TableStream &result) { result.error.clear(); }
+
 } // anon. ns
 
 namespace osrm
@@ -76,68 +243,770 @@ namespace osrm
 namespace engine
 {
 
-Engine::Engine(const EngineConfig &config)
-    : lock(config.use_shared_memory ? std::make_unique<storage::SharedBarriers>()
-                                    : std::unique_ptr<storage::SharedBarriers>())
+struct Engine::DataSnapshot
 {
-    if (config.use_shared_memory)
+    // The last query on a dataset that a newer one replaced destroys it, which ends the draining
+    // of the swap, see AcquireSnapshot
+    ~DataSnapshot()
     {
-        query_data_facade = util::make_unique<datafacade::SharedDataFacade>();
+        if (replaced == std::chrono::steady_clock::time_point{})
+        {
+            return;
+        }
+        const auto draining = std::chrono::steady_clock::now() - replaced;
+        util::QueryMetrics::GetInstance().RecordSwap(util::QueryMetrics::SwapPhase::Draining,
+                                                     draining);
+        util::SimpleLogger().Write()
+            << "released dataset " << shared_facade->GetDatasetTimestamp() << " after "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(draining).count()
+            << "ms of draining";
     }
-    else
+
+    // true if the data on shared memory is still the one osrm-datastore loaded last
+    bool IsCurrent() const { return !shared_facade || shared_facade->IsCurrent(); }
+
+    // when a newer dataset replaced this one, set by the update that swapped it out
+    mutable std::chrono::steady_clock::time_point replaced;
+
+    std::unique_ptr<datafacade::BaseDataFacade> facade;
+    // the same facade if it is on shared memory, nullptr otherwise
+    const datafacade::SharedDataFacade *shared_facade = nullptr;
+
+    std::unique_ptr<plugins::ViaRoutePlugin> route_plugin;
+    std::unique_ptr<plugins::TablePlugin> table_plugin;
+    std::unique_ptr<plugins::NearestPlugin> nearest_plugin;
+    std::unique_ptr<plugins::TripPlugin> trip_plugin;
+    std::unique_ptr<plugins::MatchPlugin> match_plugin;
+    std::unique_ptr<plugins::TilePlugin> tile_plugin;
+    std::unique_ptr<plugins::OneToAllPlugin> one_to_all_plugin;
+    std::unique_ptr<plugins::IsochronePlugin> isochrone_plugin;
+};
+
+// The traffic overlay that osrm-traffic wrote into shared memory. One query a second reads the
+// version of the overlay in shared memory, and copies the overlay into a new snapshot if it
+// changed. The other queries go on with the current snapshot meanwhile.
+struct Engine::TrafficOverlays
+{
+    util::Snapshots<TrafficOverlay>::Pin Acquire()
     {
-        if (!config.storage_config.IsValid())
+        using std::chrono::steady_clock;
+        const auto now = steady_clock::now().time_since_epoch().count();
+        auto next = next_check.load();
+        if (now >= next &&
+            next_check.compare_exchange_strong(
+                next,
+                now + std::chrono::duration_cast<steady_clock::duration>(REFRESH_INTERVAL)
+                          .count()))
         {
-            throw util::exception("Invalid file paths given!");
+            // the pin is released right away, the previous overlay goes with the last pin on it
+            const auto known_version = snapshots.Acquire()->GetVersion();
+            std::uint64_t version;
+            std::vector<storage::TrafficPenalty> penalties;
+            try
+            {
+                if (storage::readSharedTrafficOverlay(known_version, version, penalties))
+                {
+                    snapshots.Update([&](const TrafficOverlay &) {
+                        return util::make_unique<TrafficOverlay>(std::move(penalties), version);
+                    });
+                    util::SimpleLogger().Write() << "using traffic overlay version " << version;
+                }
+            }
+            catch (const std::exception &error)
+            {
+                // the queries go on with the previous overlay
+                util::SimpleLogger().Write(logWARNING) << "could not read the traffic overlay: "
+                                                       << error.what();
+            }
         }
-        query_data_facade =
-            util::make_unique<datafacade::InternalDataFacade>(config.storage_config);
+        return snapshots.Acquire();
     }
 
-    // Register plugins
+    static constexpr std::chrono::seconds REFRESH_INTERVAL{1};
+
+    util::Snapshots<TrafficOverlay> snapshots{util::make_unique<TrafficOverlay>()};
+    std::atomic<std::chrono::steady_clock::rep> next_check{0};
+};
+
+constexpr std::chrono::seconds Engine::TrafficOverlays::REFRESH_INTERVAL;
+
+// Works the same for every plugin. Queries don't take any locks: they pin the current snapshot,
+// and the first query that notices a data update loads the new dataset into a new snapshot. The
+// previous snapshot is destroyed once the queries running on it are done, and its dataset in
+// shared memory stays loaded until then while osrm-datastore loads newer ones into other slots.
+util::Snapshots<Engine::DataSnapshot>::Pin Engine::AcquireSnapshot() const
+{
+    // threads that are not bound to a NUMA node use the first one
+    auto &node_snapshots = *snapshots[util::getThreadNUMANode() % snapshots.size()];
+    auto snapshot = node_snapshots.Acquire();
+    if (!snapshot->IsCurrent())
+    {
+        // the outdated snapshot is destroyed with the last pin on it, which may be this one
+        snapshot = {};
+        const auto stall_start = std::chrono::steady_clock::now();
+        bool swapped = false;
+        unsigned timestamp = 0;
+        std::chrono::nanoseconds barriers{0};
+        std::chrono::nanoseconds mapping{0};
+        node_snapshots.Update([&](const DataSnapshot &current) -> std::unique_ptr<DataSnapshot> {
+            if (current.IsCurrent())
+            {
+                // another query loaded the new dataset already
+                return nullptr;
+            }
+            auto next = MakeSnapshot(util::make_unique<datafacade::SharedDataFacade>(
+                config->prefetch_rtree_leaves,
+                config->prefetch_search_graph,
+                config->algorithm == EngineConfig::Algorithm::MLD));
+            swapped = true;
+            timestamp = next->shared_facade->GetDatasetTimestamp();
+            barriers = next->shared_facade->GetBarrierWait();
+            mapping = next->shared_facade->GetMappingDuration();
+            current.replaced = std::chrono::steady_clock::now();
+            return next;
+        });
+
+        // every query that got here waited for the swap, the one that did it reports it
+        const auto done = std::chrono::steady_clock::now();
+        auto &metrics = util::QueryMetrics::GetInstance();
+        metrics.RecordSwapStall(done - stall_start);
+        if (swapped)
+        {
+            // the draining is reported once the previous snapshot is destroyed
+            using util::QueryMetrics;
+            metrics.RecordSwap(QueryMetrics::SwapPhase::Barriers, barriers);
+            metrics.RecordSwap(QueryMetrics::SwapPhase::Mapping, mapping);
+            const auto toMilliseconds = [](const std::chrono::nanoseconds duration) {
+                return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+            };
+            util::SimpleLogger().Write() << "swapped to dataset " << timestamp << ": waited "
+                                         << toMilliseconds(barriers)
+                                         << "ms for the barriers, mapped it in "
+                                         << toMilliseconds(mapping) << "ms";
+        }
+        snapshot = node_snapshots.Acquire();
+    }
+    return snapshot;
+}
+
+template <typename ParameterT, typename PluginT, typename ResultT>
+Status Engine::RunQuery(const util::QueryMetrics::Service service,
+                        std::unique_ptr<PluginT> DataSnapshot::*plugin,
+                        const ParameterT &parameters,
+                        ResultT &result) const
+{
+    const util::QueryMetrics::ScopedQuery query(service);
+    // the temporaries of the query are freed at once when it is done
+    const util::QueryArena::Scope arena;
+    SearchStatistics statistics;
+
+    // the deadline of the query time, unless the caller set an earlier one
+    AsyncOptions options;
+    if (const auto outer_options = SearchEngineData::GetQueryControl())
+    {
+        options = *outer_options;
+    }
+    if (config->max_query_time >= 0)
+    {
+        const auto deadline = std::chrono::steady_clock::now() +
+                              std::chrono::milliseconds(config->max_query_time);
+        if (!options.deadline || deadline < *options.deadline)
+        {
+            options.deadline = deadline;
+        }
+    }
+    const bool has_query_control = options.deadline || options.cancelled;
+
+    Status status;
+    try
+    {
+        const SearchEngineData::ScopedStatistics counting(statistics);
+        const SearchEngineData::ScopedHeaps heaps(*heap_pool);
+        const SearchEngineData::ScopedQueryMemory memory(
+            service,
+            config->max_query_memory >= 0
+                ? static_cast<std::size_t>(config->max_query_memory) * 1024 * 1024
+                : std::numeric_limits<std::size_t>::max());
+        const SearchEngineData::ScopedQueryControl controlling(has_query_control ? &options
+                                                                                 : nullptr);
+        // an async query might have waited in the pool past its deadline
+        SearchEngineData::CheckQueryControl();
+        const auto snapshot = AcquireSnapshot();
+        util::Snapshots<TrafficOverlay>::Pin overlay;
+        if (traffic_overlays && usesTrafficOverlay(service))
+        {
+            overlay = traffic_overlays->Acquire();
+        }
+        const SearchEngineData::ScopedTrafficOverlay traffic(overlay ? &*overlay : nullptr);
+        const SearchEngineData::ScopedCellMetric metric(
+            findCellMetric(service, *(*snapshot).facade, parameters));
+        status = ((*snapshot).*plugin)->HandleRequest(parameters, result);
+    }
+    catch (const QueryAborted &aborted)
+    {
+        resetResult(result);
+        setAbortError(aborted, result);
+        status = aborted.status;
+    }
+    recordSearchStatistics(service, statistics);
+    if (status == Status::Ok)
+    {
+        addDebugField(parameters, statistics, result);
+    }
+    return status;
+}
+
+std::unique_ptr<Engine::DataSnapshot>
+Engine::MakeSnapshot(std::unique_ptr<datafacade::BaseDataFacade> facade) const
+{
     using namespace plugins;
 
-    route_plugin = create<ViaRoutePlugin>(*query_data_facade, config.max_locations_viaroute);
-    table_plugin = create<TablePlugin>(*query_data_facade, config.max_locations_distance_table);
-    nearest_plugin = create<NearestPlugin>(*query_data_facade, config.max_results_nearest);
-    trip_plugin = create<TripPlugin>(*query_data_facade, config.max_locations_trip);
-    match_plugin = create<MatchPlugin>(*query_data_facade, config.max_locations_map_matching);
-    tile_plugin = create<TilePlugin>(*query_data_facade);
+    auto snapshot = util::make_unique<DataSnapshot>();
+    snapshot->facade = std::move(facade);
+    if (config->use_shared_memory)
+    {
+        snapshot->shared_facade =
+            static_cast<const datafacade::SharedDataFacade *>(snapshot->facade.get());
+    }
+
+    auto &query_data_facade = *snapshot->facade;
+    snapshot->route_plugin = create<ViaRoutePlugin>(query_data_facade,
+                                                    config->max_locations_viaroute,
+                                                    config->max_pairs_route_batch,
+                                                    unpacking_cache.get(),
+                                                    config->use_stall_on_demand,
+                                                    snapping_cache.get(),
+                                                    config->use_parallel_route_legs,
+                                                    config->parallel_unpacking_length);
+    snapshot->table_plugin = create<TablePlugin>(query_data_facade,
+                                                 config->max_locations_distance_table,
+                                                 config->use_parallel_distance_table,
+                                                 snapping_cache.get(),
+                                                 table_sessions.get(),
+                                                 search_space_cache.get());
+    snapshot->nearest_plugin = create<NearestPlugin>(
+        query_data_facade, config->max_results_nearest, config->max_locations_nearest);
+    snapshot->trip_plugin = create<TripPlugin>(query_data_facade,
+                                               config->max_locations_trip,
+                                               unpacking_cache.get(),
+                                               config->use_stall_on_demand,
+                                               snapping_cache.get(),
+                                               config->parallel_unpacking_length,
+                                               config->large_trip_locations);
+    snapshot->match_plugin = create<MatchPlugin>(query_data_facade,
+                                                 config->max_locations_map_matching,
+                                                 unpacking_cache.get(),
+                                                 config->use_stall_on_demand,
+                                                 match_sessions.get(),
+                                                 config->max_match_session_points,
+                                                 config->max_traces_match_batch);
+    snapshot->tile_plugin = create<TilePlugin>(query_data_facade, tile_cache.get());
+    snapshot->one_to_all_plugin = create<OneToAllPlugin>(
+        query_data_facade, config->max_locations_one_to_all, snapping_cache.get());
+    snapshot->isochrone_plugin = create<IsochronePlugin>(
+        query_data_facade, config->max_duration_isochrone, snapping_cache.get());
+    return snapshot;
+}
+
+struct Engine::AsyncPool
+{
+    // no slot is reserved for a thread that joins the arena, only its workers run the tasks
+    explicit AsyncPool(const unsigned number_of_threads)
+        : arena(number_of_threads == 0 ? static_cast<int>(tbb::task_arena::automatic)
+                                       : static_cast<int>(number_of_threads),
+                0)
+    {
+    }
+
+    ~AsyncPool()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return number_of_pending_tasks == 0; });
+    }
+
+    void Run(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++number_of_pending_tasks;
+        }
+        arena.enqueue([this, task] {
+            // The parallel loops of a query only pick up its own work while they wait, another
+            // query started on the same thread would hold up this one until it is done.
+            tbb::this_task_arena::isolate(task);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--number_of_pending_tasks == 0)
+            {
+                done.notify_all();
+            }
+        });
+    }
+
+    tbb::task_arena arena;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t number_of_pending_tasks = 0;
+};
+
+namespace
+{
+// Reads the memory of the data of the facade, and locks it with lock_data. Adds the size of the
+// memory to size, and returns false if not all of it could be locked.
+bool warmupData(const osrm::engine::datafacade::BaseDataFacade &facade,
+                const bool lock_data,
+                const std::atomic<bool> &stop,
+                std::size_t &size)
+{
+    bool locked = true;
+    for (const auto &region : facade.GetMemoryRegions())
+    {
+        if (stop.load())
+        {
+            break;
+        }
+        osrm::util::prefaultMemory(region, stop);
+        if (lock_data)
+        {
+            locked = osrm::util::lockMemory(region) && locked;
+        }
+        size += region.size;
+    }
+    return locked;
+}
+
+void logWarmup(const std::size_t size, const std::chrono::steady_clock::time_point start)
+{
+    osrm::util::SimpleLogger().Write()
+        << "warmed up " << (size >> 20) << " MB of data in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                 start)
+               .count()
+        << "ms";
+}
+}
+
+// Reads the memory of the data of all snapshots on a thread of its own, so the server can answer
+// health checks in the meantime. The snapshots stay pinned until it is done, a new dataset in
+// shared memory is only loaded afterwards.
+struct Engine::Warmup
+{
+    Warmup(const std::vector<std::unique_ptr<util::Snapshots<DataSnapshot>>> &snapshots,
+           const bool lock_data_)
+        : lock_data(lock_data_)
+    {
+        for (const auto &node_snapshots : snapshots)
+        {
+            pins.push_back(node_snapshots->Acquire());
+        }
+        thread = std::thread([this] { Run(); });
+    }
+
+    ~Warmup()
+    {
+        stop.store(true);
+        thread.join();
+    }
+
+    void Run()
+    {
+        const auto start = std::chrono::steady_clock::now();
+        std::size_t size = 0;
+        bool locked = true;
+        for (const auto &pin : pins)
+        {
+            locked = warmupData(*pin->facade, lock_data, stop, size) && locked;
+        }
+        pins.clear();
+        if (stop.load())
+        {
+            return;
+        }
+
+        if (!locked)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "could not lock all of the data into memory, check the limit of locked memory";
+        }
+        logWarmup(size, start);
+        ready.store(true);
+    }
+
+    const bool lock_data;
+    // released by the warmup thread once it is done
+    std::vector<util::Snapshots<DataSnapshot>::Pin> pins;
+    std::atomic<bool> stop{false};
+    std::atomic<bool> ready{false};
+    std::thread thread;
+};
+
+Engine::Engine(const EngineConfig &config_)
+    : config(util::make_unique<const EngineConfig>(config_))
+{
+    if (config->unpacking_cache_size > 0)
+    {
+        unpacking_cache = util::make_unique<UnpackingCache>(config->unpacking_cache_size);
+    }
+    if (config->snapping_cache_size > 0)
+    {
+        snapping_cache = util::make_unique<SnappingCache>(config->snapping_cache_size);
+    }
+    if (config->search_space_cache_size > 0)
+    {
+        search_space_cache = util::make_unique<SearchSpaceCache>(config->search_space_cache_size);
+    }
+    if (config->tile_cache_size > 0)
+    {
+        tile_cache = util::make_unique<TileCache>(config->tile_cache_size);
+    }
+    if (config->max_match_sessions > 0)
+    {
+        match_sessions = util::make_unique<MatchSessions>(config->max_match_sessions);
+    }
+    if (config->max_table_sessions > 0)
+    {
+        table_sessions = util::make_unique<TableSessions>(config->max_table_sessions);
+    }
+    heap_pool = util::make_unique<SearchEngineHeapPool>();
+    reload_mutex = util::make_unique<std::mutex>();
+    async_pool = util::make_unique<AsyncPool>(config->async_threads);
+    if (config->use_traffic_overlay && config->algorithm == EngineConfig::Algorithm::MLD)
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "The traffic overlay is not supported with MLD, customize the speeds instead";
+    }
+    else if (config->use_traffic_overlay)
+    {
+        traffic_overlays = util::make_unique<TrafficOverlays>();
+    }
+
+    LoadSnapshots();
+    if (config->warmup_data)
+    {
+        warmup = util::make_unique<Warmup>(snapshots, config->lock_data);
+    }
+    if (config->block_heat_interval > 0)
+    {
+        // the snapshots are updated in place, so they outlive moves of the engine
+        auto *const node_snapshots = snapshots.front().get();
+        heat_sampler = util::make_unique<util::PageHeatSampler>(
+            [node_snapshots] { return (*node_snapshots->Acquire()).facade->GetMemoryBlocks(); },
+            std::chrono::seconds(config->block_heat_interval));
+    }
+}
+
+void Engine::LoadSnapshots()
+{
+    if (config->use_shared_memory)
+    {
+        snapshots.push_back(util::make_unique<util::Snapshots<DataSnapshot>>(
+            MakeSnapshot(util::make_unique<datafacade::SharedDataFacade>(
+                config->prefetch_rtree_leaves,
+                config->prefetch_search_graph,
+                config->algorithm == EngineConfig::Algorithm::MLD))));
+        if (config->use_numa_replicas)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "NUMA replicas are not supported with shared memory";
+        }
+        return;
+    }
+
+    for (auto &snapshot : LoadInternalData(0))
+    {
+        snapshots.push_back(util::make_unique<util::Snapshots<DataSnapshot>>(std::move(snapshot)));
+    }
+}
+
+std::vector<std::unique_ptr<Engine::DataSnapshot>>
+Engine::LoadInternalData(const unsigned data_version) const
+{
+    if (!config->storage_config.IsValid())
+    {
+        throw util::exception("Invalid file paths given!");
+    }
+    // replicas on NUMA nodes only share blocks with the datasets on the same node
+    const auto makeInternalSnapshot = [this, data_version](const std::size_t numa_node) {
+        return MakeSnapshot(
+            util::make_unique<datafacade::InternalDataFacade>(config->storage_config,
+                                                              config->use_mmap,
+                                                              config->prefetch_rtree_leaves,
+                                                              config->prefetch_search_graph,
+                                                              config->algorithm ==
+                                                                  EngineConfig::Algorithm::MLD,
+                                                              data_version,
+                                                              config->share_data,
+                                                              numa_node));
+    };
+
+    std::vector<std::unique_ptr<DataSnapshot>> data;
+    const auto numa_nodes = util::getNUMANodes();
+    if (!config->use_numa_replicas || numa_nodes.size() == 1 || config->use_mmap)
+    {
+        if (config->use_numa_replicas && config->use_mmap)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "NUMA replicas are not supported with memory-mapped files";
+        }
+        data.push_back(makeInternalSnapshot(0));
+        return data;
+    }
+
+    // Every replica is loaded by a thread bound to its node, so the kernel allocates its pages
+    // there when they are first touched.
+    util::SimpleLogger().Write() << "loading a replica of the data on each of "
+                                 << numa_nodes.size() << " NUMA nodes";
+    data.resize(numa_nodes.size());
+    std::vector<std::exception_ptr> errors(numa_nodes.size());
+    std::vector<std::thread> loaders;
+    for (const auto node_index : util::irange<std::size_t>(0, numa_nodes.size()))
+    {
+        loaders.emplace_back([&, node_index] {
+            try
+            {
+                if (!util::bindThreadToNUMANode(node_index, numa_nodes[node_index]))
+                {
+                    util::SimpleLogger().Write(logWARNING)
+                        << "could not bind the loader of NUMA node " << node_index;
+                }
+                data[node_index] = makeInternalSnapshot(node_index);
+            }
+            catch (...)
+            {
+                errors[node_index] = std::current_exception();
+            }
+        });
+    }
+    for (auto &loader : loaders)
+    {
+        loader.join();
+    }
+    for (const auto &error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+    return data;
+}
+
+void Engine::Reload()
+{
+    if (config->use_shared_memory)
+    {
+        throw util::exception("Data in shared memory is reloaded by osrm-datastore");
+    }
+    std::lock_guard<std::mutex> guard(*reload_mutex);
+
+    util::SimpleLogger().Write() << "reloading the data";
+    const auto start = std::chrono::steady_clock::now();
+    auto data = LoadInternalData(number_of_reloads + 1);
+    BOOST_ASSERT(data.size() == snapshots.size());
+    if (config->warmup_data)
+    {
+        const auto warmup_start = std::chrono::steady_clock::now();
+        const std::atomic<bool> stop{false};
+        std::size_t size = 0;
+        bool locked = true;
+        for (const auto &snapshot : data)
+        {
+            locked = warmupData(*snapshot->facade, config->lock_data, stop, size) && locked;
+        }
+        if (!locked)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "could not lock all of the data into memory, check the limit of locked memory";
+        }
+        logWarmup(size, warmup_start);
+    }
+
+    ++number_of_reloads;
+    // the queries that still run on the previous data release it when they are done
+    for (const auto node_index : util::irange<std::size_t>(0, snapshots.size()))
+    {
+        snapshots[node_index]->Update(
+            [&](const DataSnapshot &) { return std::move(data[node_index]); });
+    }
+    util::SimpleLogger().Write() << "reloaded the data in "
+                                 << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                        std::chrono::steady_clock::now() - start)
+                                        .count()
+                                 << "ms";
 }
 
 // make sure we deallocate the unique ptr at a position where we know the size of the plugins
-Engine::~Engine() = default;
+Engine::~Engine()
+{
+    // the pending async queries, the warmup and the sampling still use the data
+    async_pool.reset();
+    warmup.reset();
+    heat_sampler.reset();
+
+    if (unpacking_cache)
+    {
+        const auto number_of_hits = unpacking_cache->GetNumberOfHits();
+        util::SimpleLogger().Write() << "Unpacking cache answered " << number_of_hits << " of "
+                                     << number_of_hits + unpacking_cache->GetNumberOfMisses()
+                                     << " shortcut lookups (" << std::fixed
+                                     << std::setprecision(1)
+                                     << 100. * unpacking_cache->GetHitRate() << "%)";
+    }
+    if (snapping_cache)
+    {
+        const auto number_of_hits = snapping_cache->GetNumberOfHits();
+        util::SimpleLogger().Write() << "Snapping cache answered " << number_of_hits << " of "
+                                     << number_of_hits + snapping_cache->GetNumberOfMisses()
+                                     << " coordinate lookups (" << std::fixed
+                                     << std::setprecision(1)
+                                     << 100. * snapping_cache->GetHitRate() << "%)";
+    }
+    if (search_space_cache)
+    {
+        const auto number_of_hits = search_space_cache->GetNumberOfHits();
+        util::SimpleLogger().Write() << "Search space cache answered " << number_of_hits << " of "
+                                     << number_of_hits + search_space_cache->GetNumberOfMisses()
+                                     << " searches (" << std::fixed << std::setprecision(1)
+                                     << 100. * search_space_cache->GetHitRate() << "%)";
+    }
+    if (tile_cache)
+    {
+        const auto number_of_hits = tile_cache->GetNumberOfHits();
+        util::SimpleLogger().Write() << "Tile cache answered " << number_of_hits << " of "
+                                     << number_of_hits + tile_cache->GetNumberOfMisses()
+                                     << " tile lookups (" << std::fixed << std::setprecision(1)
+                                     << 100. * tile_cache->GetHitRate() << "%)";
+    }
+    if (match_sessions)
+    {
+        util::SimpleLogger().Write() << "Match sessions: "
+                                     << match_sessions->GetNumberOfCreatedSessions()
+                                     << " started, "
+                                     << match_sessions->GetNumberOfEvictedSessions()
+                                     << " dropped before they were finished";
+    }
+    if (table_sessions)
+    {
+        util::SimpleLogger().Write() << "Table sessions: "
+                                     << table_sessions->GetNumberOfCreatedSessions()
+                                     << " started, "
+                                     << table_sessions->GetNumberOfEvictedSessions() << " dropped";
+    }
+}
 Engine::Engine(Engine &&) noexcept = default;
 Engine &Engine::operator=(Engine &&) noexcept = default;
 
 Status Engine::Route(const api::RouteParameters &params, util::json::Object &result) const
 {
-    return RunQuery(lock, *query_data_facade, params, *route_plugin, result);
+    return RunQuery(
+        util::QueryMetrics::Service::Route, &DataSnapshot::route_plugin, params, result);
+}
+
+Status Engine::Route(const api::RouteParameters &params, api::RouteResult &result) const
+{
+    return RunQuery(
+        util::QueryMetrics::Service::Route, &DataSnapshot::route_plugin, params, result);
+}
+
+Status Engine::RouteBatch(const api::RouteBatchParameters &params,
+                          util::json::Object &result) const
+{
+    return RunQuery(
+        util::QueryMetrics::Service::RouteBatch, &DataSnapshot::route_plugin, params, result);
 }
 
 Status Engine::Table(const api::TableParameters &params, util::json::Object &result) const
 {
-    return RunQuery(lock, *query_data_facade, params, *table_plugin, result);
+    return RunQuery(
+        util::QueryMetrics::Service::Table, &DataSnapshot::table_plugin, params, result);
+}
+
+Status Engine::Table(const api::TableParameters &params, std::string &result) const
+{
+    return RunQuery(
+        util::QueryMetrics::Service::Table, &DataSnapshot::table_plugin, params, result);
+}
+
+Status Engine::Table(const api::TableParameters &params, api::TableResult &result) const
+{
+    return RunQuery(
+        util::QueryMetrics::Service::Table, &DataSnapshot::table_plugin, params, result);
+}
+
+Status Engine::Table(const api::TableParameters &params, api::TableStream &result) const
+{
+    return RunQuery(
+        util::QueryMetrics::Service::Table, &DataSnapshot::table_plugin, params, result);
 }
 
 Status Engine::Nearest(const api::NearestParameters &params, util::json::Object &result) const
 {
-    return RunQuery(lock, *query_data_facade, params, *nearest_plugin, result);
+    return RunQuery(
+        util::QueryMetrics::Service::Nearest, &DataSnapshot::nearest_plugin, params, result);
+}
+
+Status Engine::Nearest(const api::NearestParameters &params, api::NearestResult &result) const
+{
+    return RunQuery(
+        util::QueryMetrics::Service::Nearest, &DataSnapshot::nearest_plugin, params, result);
 }
 
 Status Engine::Trip(const api::TripParameters &params, util::json::Object &result) const
 {
-    return RunQuery(lock, *query_data_facade, params, *trip_plugin, result);
+    return RunQuery(util::QueryMetrics::Service::Trip, &DataSnapshot::trip_plugin, params, result);
 }
 
 Status Engine::Match(const api::MatchParameters &params, util::json::Object &result) const
 {
-    return RunQuery(lock, *query_data_facade, params, *match_plugin, result);
+    return RunQuery(
+        util::QueryMetrics::Service::Match, &DataSnapshot::match_plugin, params, result);
+}
+
+Status Engine::MatchStream(const api::MatchStreamParameters &params,
+                           util::json::Object &result) const
+{
+    return RunQuery(
+        util::QueryMetrics::Service::Match, &DataSnapshot::match_plugin, params, result);
+}
+
+Status Engine::MatchBatch(const api::MatchBatchParameters &params,
+                          api::MatchBatchResult &result) const
+{
+    return RunQuery(
+        util::QueryMetrics::Service::Match, &DataSnapshot::match_plugin, params, result);
 }
 
 Status Engine::Tile(const api::TileParameters &params, std::string &result) const
 {
-    return RunQuery(lock, *query_data_facade, params, *tile_plugin, result);
+    return RunQuery(util::QueryMetrics::Service::Tile, &DataSnapshot::tile_plugin, params, result);
+}
+
+Status Engine::OneToAll(const api::OneToAllParameters &params, api::OneToAllResult &result) const
+{
+    return RunQuery(
+        util::QueryMetrics::Service::OneToAll, &DataSnapshot::one_to_all_plugin, params, result);
+}
+
+Status Engine::Isochrone(const api::IsochroneParameters &params, util::json::Object &result) const
+{
+    return RunQuery(
+        util::QueryMetrics::Service::Isochrone, &DataSnapshot::isochrone_plugin, params, result);
+}
+
+void Engine::Async(std::function<void()> task) const
+{
+    BOOST_ASSERT(async_pool);
+    async_pool->Run(std::move(task));
+}
+
+bool Engine::IsReady() const { return !warmup || warmup->ready.load(); }
+
+unsigned Engine::GetCheckSum() const { return AcquireSnapshot()->facade->GetCheckSum(); }
+
+unsigned Engine::GetDataVersion() const { return AcquireSnapshot()->facade->GetDataVersion(); }
+
+std::uint64_t Engine::GetTrafficOverlayVersion() const
+{
+    return traffic_overlays ? traffic_overlays->Acquire()->GetVersion() : 0;
 }
 
 } // engine ns
@@ -23,7 +23,15 @@ bool EngineConfig::IsValid() const
                               unlimited_or_more_than(max_locations_map_matching, 2) &&
                               unlimited_or_more_than(max_locations_trip, 2) &&
                               unlimited_or_more_than(max_locations_viaroute, 2) &&
-                              unlimited_or_more_than(max_results_nearest, 0);
+                              unlimited_or_more_than(max_pairs_route_batch, 0) &&
+                              unlimited_or_more_than(max_traces_match_batch, 0) &&
+                              unlimited_or_more_than(max_results_nearest, 0) &&
+                              unlimited_or_more_than(max_locations_one_to_all, 0) &&
+                              unlimited_or_more_than(max_duration_isochrone, 0) &&
+                              unlimited_or_more_than(max_locations_nearest, 0) &&
+                              unlimited_or_more_than(max_query_time, 0) &&
+                              unlimited_or_more_than(max_query_memory, 0) &&
+                              max_match_session_points >= 2;
 
     return ((use_shared_memory && all_path_are_empty) || storage_config.IsValid()) && limits_valid;
 }
@@ -5,6 +5,8 @@
 #include "engine/guidance/leg_geometry.hpp"
 #include "util/viewport.hpp"
 
+#include <boost/assert.hpp>
+
 #include <iterator>
 #include <limits>
 #include <numeric>
@@ -75,9 +77,23 @@ std::vector<util::Coordinate> assembleOverview(const std::vector<LegGeometry> &l
     if (use_simplification)
     {
         const auto zoom_level = std::min(18u, calculateOverviewZoomLevel(leg_geometries));
+        std::vector<util::Coordinate> kept_locations;
         for (const auto &geometry : leg_geometries)
         {
-            const auto simplified = douglasPeucker(geometry.locations.begin(), geometry.locations.end(), zoom_level);
+            BOOST_ASSERT(geometry.zoom_levels.size() == geometry.locations.size());
+            // the precomputed zoom levels already drop the coordinates that the simplification
+            // of their compressed geometries removes, datasets without them keep all
+            kept_locations.clear();
+            for (std::size_t index = 0; index < geometry.locations.size(); ++index)
+            {
+                const auto is_end = index == 0 || index + 1 == geometry.locations.size();
+                if (is_end || geometry.zoom_levels[index] <= zoom_level)
+                {
+                    kept_locations.push_back(geometry.locations[index]);
+                }
+            }
+            const auto simplified =
+                douglasPeucker(kept_locations.begin(), kept_locations.end(), zoom_level);
             insert_without_overlap(simplified.begin(), simplified.end());
         }
     }
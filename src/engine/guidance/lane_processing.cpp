@@ -6,9 +6,11 @@
 #include "engine/guidance/post_processing.hpp"
 #include "engine/guidance/toolkit.hpp"
 
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
-#include <unordered_set>
 #include <utility>
+#include <vector>
 
 using TurnInstruction = osrm::extractor::guidance::TurnInstruction;
 namespace TurnType = osrm::extractor::guidance::TurnType;
@@ -24,8 +26,8 @@ namespace engine
 namespace guidance
 {
 
-std::vector<RouteStep> anticipateLaneChange(std::vector<RouteStep> steps,
-                                            const double min_duration_needed_for_lane_change)
+void anticipateLaneChange(std::vector<RouteStep> &steps,
+                          const double min_duration_needed_for_lane_change)
 {
     // Lane anticipation works on contiguous ranges of quick steps that have lane information
     const auto is_quick_has_lanes = [&](const RouteStep &step) {
@@ -34,10 +36,12 @@ std::vector<RouteStep> anticipateLaneChange(std::vector<RouteStep> steps,
         return has_lanes && is_quick;
     };
 
-    using StepIter = decltype(steps)::iterator;
+    using StepIter = std::vector<RouteStep>::iterator;
     using StepIterRange = std::pair<StepIter, StepIter>;
 
-    std::vector<StepIterRange> quick_lanes_ranges;
+    // scratch space of the thread, reused by all legs it processes
+    thread_local std::vector<StepIterRange> quick_lanes_ranges;
+    quick_lanes_ranges.clear();
 
     const auto range_back_inserter = [&](StepIterRange range) {
         if (std::distance(range.first, range.second) > 1)
@@ -46,9 +50,19 @@ std::vector<RouteStep> anticipateLaneChange(std::vector<RouteStep> steps,
 
     util::group_by(begin(steps), end(steps), is_quick_has_lanes, range_back_inserter);
 
-    // The lanes for a keep straight depend on the next left/right turn. Tag them in advance.
-    std::unordered_set<const RouteStep *> is_straight_left;
-    std::unordered_set<const RouteStep *> is_straight_right;
+    // The lanes for a keep straight depend on the next left/right turn. Tag them in advance,
+    // indexed by the position of the step.
+    enum StraightTag : std::uint8_t
+    {
+        NOT_TAGGED,
+        STRAIGHT_LEFT,
+        STRAIGHT_RIGHT
+    };
+    thread_local std::vector<std::uint8_t> straight_tags;
+    straight_tags.assign(steps.size(), NOT_TAGGED);
+    const auto tag = [&](const RouteStep &step) -> std::uint8_t & {
+        return straight_tags[static_cast<std::size_t>(&step - steps.data())];
+    };
 
     // Walk backwards over all turns, constraining possible turn lanes.
     // Later turn lanes constrain earlier ones: we have to anticipate lane changes.
@@ -96,10 +110,10 @@ std::vector<RouteStep> anticipateLaneChange(std::vector<RouteStep> steps,
 
             if (previous_is_straight)
             {
-                if (isLeftTurn(current_inst) || is_straight_left.count(&current) > 0)
-                    is_straight_left.insert(&previous);
-                else if (isRightTurn(current_inst) || is_straight_right.count(&current) > 0)
-                    is_straight_right.insert(&previous);
+                if (isLeftTurn(current_inst) || tag(current) == STRAIGHT_LEFT)
+                    tag(previous) = STRAIGHT_LEFT;
+                else if (isRightTurn(current_inst) || tag(current) == STRAIGHT_RIGHT)
+                    tag(previous) = STRAIGHT_RIGHT;
             }
 
             // 1/ How to anticipate left, right:
@@ -159,9 +173,9 @@ std::vector<RouteStep> anticipateLaneChange(std::vector<RouteStep> steps,
                 //
                 // coming from right, going to left (in direction of way) -> handle as left turn
 
-                if (is_straight_left.count(&current) > 0)
+                if (tag(current) == STRAIGHT_LEFT)
                     anticipate_for_left_turn();
-                else if (is_straight_right.count(&current) > 0)
+                else if (tag(current) == STRAIGHT_RIGHT)
                     anticipate_for_right_turn();
                 else // FIXME: right-sided driving
                     anticipate_for_right_turn();
@@ -172,7 +186,7 @@ std::vector<RouteStep> anticipateLaneChange(std::vector<RouteStep> steps,
             // step as invalid, scheduled for later removal.
             if (collapsable(previous, current))
             {
-                previous = elongate(previous, current);
+                elongate(previous, current);
                 current.maneuver.instruction = TurnInstruction::NO_TURN();
             }
         });
@@ -181,19 +195,17 @@ std::vector<RouteStep> anticipateLaneChange(std::vector<RouteStep> steps,
     std::for_each(begin(quick_lanes_ranges), end(quick_lanes_ranges), constrain_lanes);
 
     // Lane Anticipation might have collapsed steps after constraining lanes. Remove invalid steps.
-    steps = removeNoTurnInstructions(std::move(steps));
-
-    return steps;
+    removeNoTurnInstructions(steps);
 }
 
-std::vector<RouteStep> removeLanesFromRoundabouts(std::vector<RouteStep> steps)
+void removeLanesFromRoundabouts(std::vector<RouteStep> &steps)
 {
     using namespace util::guidance;
 
     const auto removeLanes = [](RouteStep &step) {
         for (auto &intersection : step.intersections)
         {
-            intersection.lane_description = {};
+            intersection.lane_description.clear();
             intersection.lanes = {};
         }
     };
@@ -205,8 +217,6 @@ std::vector<RouteStep> removeLanesFromRoundabouts(std::vector<RouteStep> steps)
         if (entersRoundabout(inst) || staysOnRoundabout(inst) || leavesRoundabout(inst))
             removeLanes(step);
     }
-
-    return steps;
 }
 
 } // namespace guidance
@@ -52,7 +52,6 @@ inline void forwardStepSignage(RouteStep &destination, const RouteStep &origin)
     destination.name = origin.name;
     destination.pronunciation = origin.pronunciation;
     destination.destinations = origin.destinations;
-    destination.destinations = origin.destinations;
     destination.ref = origin.ref;
 }
 
@@ -83,8 +82,44 @@ bool isCollapsableInstruction(const TurnInstruction instruction)
 
 bool compatible(const RouteStep &lhs, const RouteStep &rhs) { return lhs.mode == rhs.mode; }
 
-// invalidate a step and set its content to nothing
-void invalidateStep(RouteStep &step) { step = getInvalidRouteStep(); }
+// invalidate a step and set its content to nothing. Unlike assigning getInvalidRouteStep() this
+// keeps the buffers of the strings and intersections, the step is removed later on anyway.
+void invalidateStep(RouteStep &step)
+{
+    step.name_id = 0;
+    step.name.clear();
+    step.ref.clear();
+    step.pronunciation.clear();
+    step.destinations.clear();
+    step.rotary_name.clear();
+    step.rotary_pronunciation.clear();
+    step.duration = 0;
+    step.distance = 0;
+    step.mode = TRAVEL_MODE_INACCESSIBLE;
+    step.maneuver = getInvalidStepManeuver();
+    step.geometry_begin = 0;
+    step.geometry_end = 0;
+
+    step.intersections.resize(1);
+    auto &intersection = step.intersections.front();
+    intersection.location = util::Coordinate{util::FloatLongitude{0.0}, util::FloatLatitude{0.0}};
+    intersection.bearings.clear();
+    intersection.entry.clear();
+    intersection.in = Intersection::NO_INDEX;
+    intersection.out = Intersection::NO_INDEX;
+    intersection.lanes = util::guidance::LaneTupel();
+    intersection.lane_description.clear();
+}
+
+// The signage of a step that is moved out of it before the step is invalidated
+struct StepSignage
+{
+    unsigned name_id;
+    util::StringView name;
+    util::StringView pronunciation;
+    util::StringView destinations;
+    util::StringView ref;
+};
 
 // Compute the angle between two bearings on a normal turn circle
 //
@@ -139,8 +174,7 @@ double nameSegmentLength(std::size_t at, const std::vector<RouteStep> &steps)
     return result;
 }
 
-OSRM_ATTR_WARN_UNUSED
-RouteStep forwardInto(RouteStep destination, const RouteStep &source)
+void forwardInto(RouteStep &destination, const RouteStep &source)
 {
     // Merge a turn into a silent turn
     // Overwrites turn instruction and increases exit NR
@@ -162,7 +196,6 @@ RouteStep forwardInto(RouteStep destination, const RouteStep &source)
 
     destination.geometry_begin = std::min(destination.geometry_begin, source.geometry_begin);
     destination.geometry_end = std::max(destination.geometry_end, source.geometry_end);
-    return destination;
 }
 
 void fixFinalRoundabout(std::vector<RouteStep> &steps)
@@ -197,8 +230,7 @@ void fixFinalRoundabout(std::vector<RouteStep> &steps)
             // TODO this operates on the data that is in the instructions.
             // We are missing out on the final segment after the last stay-on-roundabout
             // instruction though. it is not contained somewhere until now
-            steps[propagation_index - 1] =
-                forwardInto(std::move(steps[propagation_index - 1]), propagation_step);
+            forwardInto(steps[propagation_index - 1], propagation_step);
             invalidateStep(propagation_step);
         }
     }
@@ -264,7 +296,7 @@ void closeOffRoundabout(const bool on_roundabout,
                      steps[1].maneuver.instruction.type == TurnType::UseLane);
         steps[0].geometry_end = 1;
         steps[1].geometry_begin = 0;
-        steps[1] = forwardInto(steps[1], steps[0]);
+        forwardInto(steps[1], steps[0]);
         steps[1].intersections.erase(steps[1].intersections.begin()); // otherwise we copy the
                                                                       // source
         if (leavesRoundabout(steps[1].maneuver.instruction))
@@ -296,20 +328,23 @@ void closeOffRoundabout(const bool on_roundabout,
     BOOST_ASSERT(!steps[step_index].intersections.empty());
     // the very first intersection in the steps represents the location of the turn. Following
     // intersections are locations passed along the way
-    const auto exit_intersection = steps[step_index].intersections.front();
+    const auto &exit_intersection = steps[step_index].intersections.front();
     const auto exit_bearing = exit_intersection.bearings[exit_intersection.out];
-    const auto destination_copy = step;
     if (step_index > 1)
     {
+        // the exit step is invalidated first, but its signage is forwarded to the entry
+        StepSignage signage{
+            step.name_id, step.name, step.pronunciation, step.destinations, step.ref};
+
         // The very first route-step is head, so we cannot iterate past that one
         for (std::size_t propagation_index = step_index - 1; propagation_index > 0;
              --propagation_index)
         {
             auto &propagation_step = steps[propagation_index];
-            propagation_step = forwardInto(propagation_step, steps[propagation_index + 1]);
+            forwardInto(propagation_step, steps[propagation_index + 1]);
             if (entersRoundabout(propagation_step.maneuver.instruction))
             {
-                const auto entry_intersection = propagation_step.intersections.front();
+                const auto &entry_intersection = propagation_step.intersections.front();
 
                 // remember rotary name
                 if (propagation_step.maneuver.instruction.type == TurnType::EnterRotary ||
@@ -333,7 +368,11 @@ void closeOffRoundabout(const bool on_roundabout,
                         ::osrm::util::guidance::getTurnDirection(angle);
                 }
 
-                forwardStepSignage(propagation_step, destination_copy);
+                propagation_step.name_id = signage.name_id;
+                propagation_step.name = signage.name;
+                propagation_step.pronunciation = signage.pronunciation;
+                propagation_step.destinations = signage.destinations;
+                propagation_step.ref = signage.ref;
                 invalidateStep(steps[propagation_index + 1]);
                 break;
             }
@@ -406,7 +445,7 @@ void collapseTurnAt(std::vector<RouteStep> &steps,
                      one_back_step.intersections.front().bearings.size() > 2)
                 steps[step_index].maneuver.instruction.type = TurnType::Turn;
 
-            steps[two_back_index] = elongate(std::move(steps[two_back_index]), one_back_step);
+            elongate(steps[two_back_index], one_back_step);
             // If the previous instruction asked to continue, the name change will have to
             // be changed into a turn
             invalidateStep(steps[one_back_index]);
@@ -419,7 +458,7 @@ void collapseTurnAt(std::vector<RouteStep> &steps,
         // TODO check for lanes (https://github.com/Project-OSRM/osrm-backend/issues/2553)
         if (compatible(one_back_step, current_step))
         {
-            steps[one_back_index] = elongate(std::move(steps[one_back_index]), steps[step_index]);
+            elongate(steps[one_back_index], steps[step_index]);
 
             if ((TurnType::Continue == one_back_step.maneuver.instruction.type ||
                  TurnType::Suppressed == one_back_step.maneuver.instruction.type) &&
@@ -490,13 +529,12 @@ void collapseTurnAt(std::vector<RouteStep> &steps,
 
         if (direct_u_turn || u_turn_with_name_change)
         {
-            steps[one_back_index] = elongate(std::move(steps[one_back_index]), steps[step_index]);
+            elongate(steps[one_back_index], steps[step_index]);
             invalidateStep(steps[step_index]);
             if (u_turn_with_name_change &&
                 compatible(steps[one_back_index], steps[next_step_index]))
             {
-                steps[one_back_index] =
-                    elongate(std::move(steps[one_back_index]), steps[next_step_index]);
+                elongate(steps[one_back_index], steps[next_step_index]);
                 invalidateStep(steps[next_step_index]); // will be skipped due to the
                                                         // continue statement at the
                                                         // beginning of this function
@@ -557,8 +595,7 @@ bool isStaggeredIntersection(const RouteStep &previous, const RouteStep &current
 } // namespace
 
 // elongate a step by another. the data is added either at the front, or the back
-OSRM_ATTR_WARN_UNUSED
-RouteStep elongate(RouteStep step, const RouteStep &by_step)
+void elongate(RouteStep &step, const RouteStep &by_step)
 {
     step.duration += by_step.duration;
     step.distance += by_step.distance;
@@ -588,7 +625,6 @@ RouteStep elongate(RouteStep step, const RouteStep &by_step)
         step.intersections.insert(
             step.intersections.begin(), by_step.intersections.begin(), by_step.intersections.end());
     }
-    return step;
 }
 
 // Post processing can invalidate some instructions. For example StayOnRoundabout
@@ -615,7 +651,7 @@ bool collapsable(const RouteStep &step, const RouteStep &next)
     return false;
 }
 
-std::vector<RouteStep> removeNoTurnInstructions(std::vector<RouteStep> steps)
+void removeNoTurnInstructions(std::vector<RouteStep> &steps)
 {
     // finally clean up the post-processed instructions.
     // Remove all invalid instructions from the set of instructions.
@@ -642,8 +678,6 @@ std::vector<RouteStep> removeNoTurnInstructions(std::vector<RouteStep> steps)
     BOOST_ASSERT(steps.back().intersections.front().bearings.size() == 1);
     BOOST_ASSERT(steps.back().intersections.front().entry.size() == 1);
     BOOST_ASSERT(steps.back().maneuver.waypoint_type == WaypointType::Arrive);
-
-    return steps;
 }
 
 // Every Step Maneuver consists of the information until the turn.
@@ -652,12 +686,12 @@ std::vector<RouteStep> removeNoTurnInstructions(std::vector<RouteStep> steps)
 // They are required for maintenance purposes. We can calculate the number
 // of exits to pass in a roundabout and the number of intersections
 // that we come across.
-std::vector<RouteStep> postProcess(std::vector<RouteStep> steps)
+void postProcess(std::vector<RouteStep> &steps)
 {
     // the steps should always include the first/last step in form of a location
     BOOST_ASSERT(steps.size() >= 2);
     if (steps.size() == 2)
-        return steps;
+        return;
 
     // Count Street Exits forward
     bool on_roundabout = false;
@@ -721,14 +755,14 @@ std::vector<RouteStep> postProcess(std::vector<RouteStep> steps)
     BOOST_ASSERT(steps.back().intersections.front().entry.size() == 1);
     BOOST_ASSERT(steps.back().maneuver.waypoint_type == WaypointType::Arrive);
 
-    return removeNoTurnInstructions(std::move(steps));
+    removeNoTurnInstructions(steps);
 }
 
 // Post Processing to collapse unnecessary sets of combined instructions into a single one
-std::vector<RouteStep> collapseTurns(std::vector<RouteStep> steps)
+void collapseTurns(std::vector<RouteStep> &steps)
 {
     if (steps.size() <= 2)
-        return steps;
+        return;
 
     // Get the previous non-invalid instruction
     const auto getPreviousIndex = [&steps](std::size_t index) {
@@ -798,8 +832,7 @@ std::vector<RouteStep> collapseTurns(std::vector<RouteStep> steps)
             {
                 // Traffic light on the sliproad, the road itself will be handled in the next
                 // iteration, when one-back-index again points to the sliproad.
-                steps[one_back_index] =
-                    elongate(std::move(steps[one_back_index]), steps[step_index]);
+                elongate(steps[one_back_index], steps[step_index]);
                 invalidateStep(steps[step_index]);
             }
             else
@@ -816,8 +849,7 @@ std::vector<RouteStep> collapseTurns(std::vector<RouteStep> steps)
                     else
                         steps[one_back_index].maneuver.instruction.type = TurnType::Turn;
 
-                    steps[one_back_index] =
-                        elongate(std::move(steps[one_back_index]), steps[step_index]);
+                    elongate(steps[one_back_index], steps[step_index]);
 
                     forwardStepSignage(steps[one_back_index], steps[step_index]);
                     // the turn lanes for this turn are on the sliproad itself, so we have to
@@ -827,10 +859,10 @@ std::vector<RouteStep> collapseTurns(std::vector<RouteStep> steps)
                     steps[one_back_index].intersections.front().lane_description =
                         current_step.intersections.front().lane_description;
 
-                    const auto exit_intersection = steps[step_index].intersections.front();
+                    const auto &exit_intersection = steps[step_index].intersections.front();
                     const auto exit_bearing = exit_intersection.bearings[exit_intersection.out];
 
-                    const auto entry_intersection = steps[one_back_index].intersections.front();
+                    const auto &entry_intersection = steps[one_back_index].intersections.front();
                     const auto entry_bearing = entry_intersection.bearings[entry_intersection.in];
 
                     const double angle =
@@ -859,8 +891,7 @@ std::vector<RouteStep> collapseTurns(std::vector<RouteStep> steps)
 
             for (std::size_t index = last_available_name_index + 1; index <= step_index; ++index)
             {
-                steps[last_available_name_index] =
-                    elongate(std::move(steps[last_available_name_index]), steps[index]);
+                elongate(steps[last_available_name_index], steps[index]);
                 invalidateStep(steps[index]);
             }
         }
@@ -879,9 +910,8 @@ std::vector<RouteStep> collapseTurns(std::vector<RouteStep> steps)
             {
                 if (compatible(one_back_step, steps[two_back_index]))
                 {
-                    steps[two_back_index] =
-                        elongate(elongate(std::move(steps[two_back_index]), steps[one_back_index]),
-                                 steps[step_index]);
+                    elongate(steps[two_back_index], steps[one_back_index]);
+                    elongate(steps[two_back_index], steps[step_index]);
                     invalidateStep(steps[one_back_index]);
                     invalidateStep(steps[step_index]);
                 }
@@ -893,13 +923,11 @@ std::vector<RouteStep> collapseTurns(std::vector<RouteStep> steps)
             {
                 if (compatible(steps[two_back_index], steps[one_back_index]))
                 {
-                    steps[two_back_index] =
-                        elongate(std::move(steps[two_back_index]), steps[one_back_index]);
+                    elongate(steps[two_back_index], steps[one_back_index]);
                     invalidateStep(steps[one_back_index]);
                     if (nameSegmentLength(step_index, steps) < name_segment_cutoff_length)
                     {
-                        steps[two_back_index] =
-                            elongate(std::move(steps[two_back_index]), steps[step_index]);
+                        elongate(steps[two_back_index], steps[step_index]);
                         invalidateStep(steps[step_index]);
                     }
                 }
@@ -915,9 +943,8 @@ std::vector<RouteStep> collapseTurns(std::vector<RouteStep> steps)
                     // change,
                     // we don't wan't to collapse the initial intersection.
                     // a - b ---BRIDGE -- c
-                    steps[one_back_index] =
-                        elongate(std::move(steps[one_back_index]),
-                                 elongate(std::move(steps[step_index]), steps[next_step_index]));
+                    elongate(steps[step_index], steps[next_step_index]);
+                    elongate(steps[one_back_index], steps[step_index]);
                     invalidateStep(steps[step_index]);
                     invalidateStep(steps[next_step_index]);
                 }
@@ -960,7 +987,7 @@ std::vector<RouteStep> collapseTurns(std::vector<RouteStep> steps)
     BOOST_ASSERT(steps.back().intersections.front().entry.size() == 1);
     BOOST_ASSERT(steps.back().maneuver.waypoint_type == WaypointType::Arrive);
 
-    return removeNoTurnInstructions(std::move(steps));
+    removeNoTurnInstructions(steps);
 }
 
 // Doing this step in post-processing provides a few challenges we cannot overcome.
@@ -1011,6 +1038,8 @@ void trimShortSegments(std::vector<RouteStep> &steps, LegGeometry &geometry)
                                        geometry.annotations.begin() + offset);
             geometry.osm_node_ids.erase(geometry.osm_node_ids.begin(),
                                         geometry.osm_node_ids.begin() + offset);
+            geometry.zoom_levels.erase(geometry.zoom_levels.begin(),
+                                       geometry.zoom_levels.begin() + offset);
         }
 
         // We have to adjust the first step both for its name and the bearings
@@ -1104,6 +1133,7 @@ void trimShortSegments(std::vector<RouteStep> &steps, LegGeometry &geometry)
         geometry.locations.resize(geometry.segment_offsets.back() + 1);
         geometry.annotations.resize(geometry.segment_offsets.back() + 1);
         geometry.osm_node_ids.resize(geometry.segment_offsets.back() + 1);
+        geometry.zoom_levels.resize(geometry.segment_offsets.back() + 1);
 
         BOOST_ASSERT(geometry.segment_distances.back() <= 1);
         geometry.segment_distances.pop_back();
@@ -1140,6 +1170,7 @@ void trimShortSegments(std::vector<RouteStep> &steps, LegGeometry &geometry)
         // This can happen if the last coordinate snaps to a node in the unpacked geometry
         geometry.locations.pop_back();
         geometry.annotations.pop_back();
+        geometry.zoom_levels.pop_back();
         geometry.segment_offsets.back()--;
         // since the last geometry includes the location of arrival, the arrival instruction
         // geometry overlaps with the previous segment
@@ -1174,10 +1205,10 @@ void trimShortSegments(std::vector<RouteStep> &steps, LegGeometry &geometry)
 }
 
 // assign relative locations to depart/arrive instructions
-std::vector<RouteStep> assignRelativeLocations(std::vector<RouteStep> steps,
-                                               const LegGeometry &leg_geometry,
-                                               const PhantomNode &source_node,
-                                               const PhantomNode &target_node)
+void assignRelativeLocations(std::vector<RouteStep> &steps,
+                             const LegGeometry &leg_geometry,
+                             const PhantomNode &source_node,
+                             const PhantomNode &target_node)
 {
     // We report the relative position of source/target to the road only within a range that is
     // sufficiently different but not full of the path
@@ -1217,10 +1248,9 @@ std::vector<RouteStep> assignRelativeLocations(std::vector<RouteStep> steps,
     BOOST_ASSERT(steps.back().intersections.front().bearings.size() == 1);
     BOOST_ASSERT(steps.back().intersections.front().entry.size() == 1);
     BOOST_ASSERT(steps.back().maneuver.waypoint_type == WaypointType::Arrive);
-    return steps;
 }
 
-LegGeometry resyncGeometry(LegGeometry leg_geometry, const std::vector<RouteStep> &steps)
+void resyncGeometry(LegGeometry &leg_geometry, const std::vector<RouteStep> &steps)
 {
     // The geometry uses an adjacency array-like structure for representation.
     // To sync it back up with the steps, we cann add a segment for every step.
@@ -1239,11 +1269,9 @@ LegGeometry resyncGeometry(LegGeometry leg_geometry, const std::vector<RouteStep
     // remove the data from the reached-target step again
     leg_geometry.segment_offsets.pop_back();
     leg_geometry.segment_distances.pop_back();
-
-    return leg_geometry;
 }
 
-std::vector<RouteStep> buildIntersections(std::vector<RouteStep> steps)
+void buildIntersections(std::vector<RouteStep> &steps)
 {
     std::size_t last_valid_instruction = 0;
     for (std::size_t step_index = 0; step_index < steps.size(); ++step_index)
@@ -1254,8 +1282,7 @@ std::vector<RouteStep> buildIntersections(std::vector<RouteStep> steps)
         {
             // count intersections. We cannot use exit, since intersections can follow directly
             // after a roundabout
-            steps[last_valid_instruction] =
-                elongate(std::move(steps[last_valid_instruction]), step);
+            elongate(steps[last_valid_instruction], step);
             step.maneuver.instruction = TurnInstruction::NO_TURN();
         }
         else if (!isSilent(instruction))
@@ -1280,10 +1307,10 @@ std::vector<RouteStep> buildIntersections(std::vector<RouteStep> steps)
             last_valid_instruction = step_index;
         }
     }
-    return removeNoTurnInstructions(std::move(steps));
+    removeNoTurnInstructions(steps);
 }
 
-std::vector<RouteStep> collapseUseLane(std::vector<RouteStep> steps)
+void collapseUseLane(std::vector<RouteStep> &steps)
 {
     const auto containsTag = [](const extractor::guidance::TurnLaneType::Mask mask,
                                 const extractor::guidance::TurnLaneType::Mask tag) {
@@ -1302,7 +1329,7 @@ std::vector<RouteStep> collapseUseLane(std::vector<RouteStep> steps)
 
     const auto canCollapeUseLane =
         [containsTag](const util::guidance::LaneTupel lanes,
-                      extractor::guidance::TurnLaneDescription lane_description) {
+                      const extractor::guidance::TurnLaneDescription &lane_description) {
             // the lane description is given left to right, lanes are counted from the right.
             // Therefore we access the lane description using the reverse iterator
             if (lanes.first_lane_from_the_right > 0 &&
@@ -1329,12 +1356,28 @@ std::vector<RouteStep> collapseUseLane(std::vector<RouteStep> steps)
                               step.intersections.front().lane_description))
         {
             const auto previous = getPreviousIndex(step_index);
-            steps[previous] = elongate(std::move(steps[previous]), steps[step_index]);
+            elongate(steps[previous], steps[step_index]);
             // elongate(steps[step_index-1], steps[step_index]);
             invalidateStep(steps[step_index]);
         }
     }
-    return removeNoTurnInstructions(std::move(steps));
+    removeNoTurnInstructions(steps);
+}
+
+void postProcessLeg(std::vector<RouteStep> &steps,
+                    LegGeometry &leg_geometry,
+                    const PhantomNode &source_node,
+                    const PhantomNode &target_node)
+{
+    trimShortSegments(steps, leg_geometry);
+    postProcess(steps);
+    collapseTurns(steps);
+    buildIntersections(steps);
+    assignRelativeLocations(steps, leg_geometry, source_node, target_node);
+    removeLanesFromRoundabouts(steps);
+    anticipateLaneChange(steps);
+    collapseUseLane(steps);
+    resyncGeometry(leg_geometry, steps);
 }
 
 } // namespace guidance
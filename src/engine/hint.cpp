@@ -5,6 +5,7 @@
 #include <boost/assert.hpp>
 
 #include <algorithm>
+#include <array>
 #include <iterator>
 #include <ostream>
 #include <tuple>
@@ -23,20 +24,63 @@ bool Hint::IsValid(const util::Coordinate new_input_coordinates,
            facade.GetCheckSum() == data_checksum;
 }
 
-std::string Hint::ToBase64() const
+PhantomNode Hint::GetPhantomNode(const util::Coordinate input_coordinate,
+                                 const datafacade::BaseDataFacade &facade) const
 {
-    auto base64 = encodeBase64Bytewise(*this);
+    if (IsValid(input_coordinate, facade))
+    {
+        return phantom;
+    }
+    if (facade.GetCheckSum() != data_checksum)
+    {
+        return PhantomNode{};
+    }
+    return facade.SegmentPhantomNode(input_coordinate, phantom);
+}
 
-    // Make safe for usage as GET parameter in URLs
+namespace
+{
+// Make safe for usage as GET parameter in URLs
+std::string makeURLSafe(std::string base64)
+{
     std::replace(begin(base64), end(base64), '+', '-');
     std::replace(begin(base64), end(base64), '/', '_');
-
     return base64;
 }
+}
+
+std::string Hint::ToBase64() const { return makeURLSafe(encodeBase64Bytewise(*this)); }
+
+std::string Hint::ToCompactBase64() const
+{
+    std::array<unsigned char, COMPACT_HINT_SIZE> bytes;
+    auto out = bytes.begin();
+    const auto write = [&out](const void *value, const std::size_t size) {
+        const auto first = static_cast<const unsigned char *>(value);
+        out = std::copy(first, first + size, out);
+    };
+    *out++ = COMPACT_HINT_VERSION;
+    write(&data_checksum, sizeof(data_checksum));
+    write(&phantom.forward_segment_id, sizeof(phantom.forward_segment_id));
+    write(&phantom.reverse_segment_id, sizeof(phantom.reverse_segment_id));
+    write(&phantom.fwd_segment_position, sizeof(phantom.fwd_segment_position));
+    // unsigned, the weight of a closed direction is invalid and the sum could overflow
+    const std::uint32_t forward_weight = static_cast<std::uint32_t>(phantom.forward_offset) +
+                                         static_cast<std::uint32_t>(phantom.forward_weight);
+    const std::uint32_t reverse_weight = static_cast<std::uint32_t>(phantom.reverse_offset) +
+                                         static_cast<std::uint32_t>(phantom.reverse_weight);
+    write(&forward_weight, sizeof(forward_weight));
+    write(&reverse_weight, sizeof(reverse_weight));
+    BOOST_ASSERT(out == bytes.end());
+
+    return makeURLSafe(encodeBase64(bytes.data(), bytes.size()));
+}
 
 Hint Hint::FromBase64(const std::string &base64Hint)
 {
-    BOOST_ASSERT_MSG(base64Hint.size() == ENCODED_HINT_SIZE, "Hint has invalid size");
+    BOOST_ASSERT_MSG(base64Hint.size() == ENCODED_HINT_SIZE ||
+                         base64Hint.size() == ENCODED_COMPACT_HINT_SIZE,
+                     "Hint has invalid size");
 
     // We need mutability but don't want to change the API
     auto encoded = base64Hint;
@@ -45,7 +89,42 @@ Hint Hint::FromBase64(const std::string &base64Hint)
     std::replace(begin(encoded), end(encoded), '-', '+');
     std::replace(begin(encoded), end(encoded), '_', '/');
 
-    return decodeBase64Bytewise<Hint>(encoded);
+    if (encoded.size() == ENCODED_HINT_SIZE)
+    {
+        return decodeBase64Bytewise<Hint>(encoded);
+    }
+
+    std::array<unsigned char, COMPACT_HINT_SIZE> bytes;
+    decodeBase64(encoded, bytes.begin());
+
+    // only the parts the compact encoding keeps are set, the others stay invalid
+    Hint hint{PhantomNode{}, 0};
+    if (bytes[0] != COMPACT_HINT_VERSION)
+    {
+        // hints of other versions never apply
+        return hint;
+    }
+    auto in = std::next(bytes.begin());
+    const auto read = [&in](void *value, const std::size_t size) {
+        std::copy(in, in + size, static_cast<unsigned char *>(value));
+        in += size;
+    };
+    read(&hint.data_checksum, sizeof(hint.data_checksum));
+    read(&hint.phantom.forward_segment_id, sizeof(hint.phantom.forward_segment_id));
+    read(&hint.phantom.reverse_segment_id, sizeof(hint.phantom.reverse_segment_id));
+    read(&hint.phantom.fwd_segment_position, sizeof(hint.phantom.fwd_segment_position));
+    // the weights to the location are kept in the offsets
+    std::uint32_t forward_weight;
+    std::uint32_t reverse_weight;
+    read(&forward_weight, sizeof(forward_weight));
+    read(&reverse_weight, sizeof(reverse_weight));
+    hint.phantom.forward_offset = static_cast<int>(forward_weight);
+    hint.phantom.reverse_offset = static_cast<int>(reverse_weight);
+    hint.phantom.forward_weight = 0;
+    hint.phantom.reverse_weight = 0;
+    BOOST_ASSERT(in == bytes.end());
+
+    return hint;
 }
 
 bool operator==(const Hint &lhs, const Hint &rhs)
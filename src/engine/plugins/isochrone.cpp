@@ -0,0 +1,206 @@
+#include "engine/plugins/isochrone.hpp"
+
+#include "engine/api/isochrone_api.hpp"
+#include "engine/api/isochrone_parameters.hpp"
+#include "engine/contour.hpp"
+#include "engine/routing_algorithms/one_to_all.hpp"
+#include "util/coordinate_calculation.hpp"
+#include "util/integer_range.hpp"
+#include "util/query_metrics.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+namespace osrm
+{
+namespace engine
+{
+namespace plugins
+{
+
+namespace
+{
+// Longer contours are cut to it, a search with that bound reaches every node anyway and the
+// labels of the search have room left for the weight of another edge
+const constexpr EdgeWeight MAX_CONTOUR_WEIGHT = INVALID_EDGE_WEIGHT / 4;
+
+// the weights are in deci-seconds
+EdgeWeight toWeight(const unsigned duration)
+{
+    return static_cast<EdgeWeight>(
+        std::min<std::uint64_t>(std::uint64_t{duration} * 10, MAX_CONTOUR_WEIGHT));
+}
+}
+
+IsochronePlugin::IsochronePlugin(datafacade::BaseDataFacade &facade,
+                                 const int max_duration_isochrone,
+                                 SnappingCache *snapping_cache)
+    : BasePlugin{facade, snapping_cache}, one_to_all(&facade, heaps),
+      max_duration_isochrone(max_duration_isochrone)
+{
+}
+
+const std::vector<unsigned> &IsochronePlugin::GetNodeGeometries()
+{
+    std::call_once(node_geometries_flag, [this] {
+        const auto number_of_nodes = facade.GetNumberOfNodes();
+        node_geometries.resize(number_of_nodes, SPECIAL_EDGEID);
+        for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+        {
+            for (const auto edge : facade.GetAdjacentEdgeRange(node))
+            {
+                const auto data = facade.GetEdgeData(edge);
+                if (data.shortcut)
+                {
+                    continue;
+                }
+                const NodeID from = data.forward ? node : facade.GetTarget(edge);
+                if (node_geometries[from] == SPECIAL_EDGEID)
+                {
+                    node_geometries[from] = facade.GetGeometryIndexForEdgeID(data.id);
+                }
+            }
+        }
+    });
+    return node_geometries;
+}
+
+Status IsochronePlugin::HandleRequest(const api::IsochroneParameters &params,
+                                      util::json::Object &result)
+{
+    BOOST_ASSERT(params.IsValid());
+
+    if (!CheckAllCoordinates(params.coordinates))
+    {
+        return Error("InvalidOptions", "Coordinates are invalid", result);
+    }
+
+    const auto max_contour = *std::max_element(params.contours.begin(), params.contours.end());
+    if (max_duration_isochrone > 0 && max_contour > static_cast<unsigned>(max_duration_isochrone))
+    {
+        return Error("TooBig",
+                     "Contour duration " + std::to_string(max_contour) +
+                         " is higher than current maximum (" +
+                         std::to_string(max_duration_isochrone) + ")",
+                     result);
+    }
+
+    auto phantom_node_pairs = GetPhantomNodes(params);
+    if (phantom_node_pairs.size() != params.coordinates.size())
+    {
+        return Error("NoSegment", "Could not find a matching segment for coordinate 0", result);
+    }
+    const auto source = SnapPhantomNodes(phantom_node_pairs).front();
+
+    const auto max_weight = toWeight(max_contour);
+    std::vector<EdgeWeight> durations;
+    {
+        const util::QueryMetrics::ScopedPhase search(util::QueryMetrics::Phase::Search);
+        durations = one_to_all(source, max_weight);
+    }
+
+    // The segments of the reached nodes with the duration at their end. A contour also has the
+    // parts of the segments it ends on. The segments behind the source are not reached.
+    std::vector<std::pair<EdgeWeight, ContourSegment>> segments;
+    std::vector<std::vector<ContourSegment>> partial_segments(params.contours.size());
+    const auto &node_geometries = GetNodeGeometries();
+    std::vector<NodeID> geometry;
+    std::vector<EdgeWeight> weights;
+    for (const auto node : util::irange<NodeID>(0, durations.size()))
+    {
+        if (durations[node] == INVALID_EDGE_WEIGHT || node_geometries[node] == SPECIAL_EDGEID)
+        {
+            continue;
+        }
+        facade.GetUncompressedGeometry(node_geometries[node], geometry);
+        facade.GetUncompressedWeights(node_geometries[node], weights);
+        BOOST_ASSERT(geometry.size() == weights.size());
+
+        // the geometry starts with the end of the first segment
+        EdgeWeight to_duration = durations[node];
+        util::Coordinate from_coordinate;
+        for (const auto index : util::irange<std::size_t>(0UL, geometry.size()))
+        {
+            const auto from_duration = to_duration;
+            to_duration += weights[index];
+            const auto to_coordinate = facade.GetCoordinateOfNode(geometry[index]);
+            if (to_duration >= 0)
+            {
+                const auto start =
+                    from_duration < 0 ? source.location
+                                      : (index == 0 ? to_coordinate : from_coordinate);
+                if (to_duration <= max_weight)
+                {
+                    segments.push_back({to_duration, ContourSegment{start, to_coordinate}});
+                }
+                for (const auto contour : util::irange<std::size_t>(0UL, params.contours.size()))
+                {
+                    const auto contour_weight = toWeight(params.contours[contour]);
+                    if (index > 0 && from_duration >= 0 && from_duration < contour_weight &&
+                        contour_weight < to_duration)
+                    {
+                        const double factor = (contour_weight - from_duration) /
+                                              static_cast<double>(to_duration - from_duration);
+                        partial_segments[contour].push_back(ContourSegment{
+                            from_coordinate,
+                            util::coordinate_calculation::interpolateLinear(
+                                factor, from_coordinate, to_coordinate)});
+                    }
+                }
+            }
+            if (to_duration > max_weight)
+            {
+                break;
+            }
+            from_coordinate = to_coordinate;
+        }
+    }
+    std::sort(segments.begin(),
+              segments.end(),
+              [](const std::pair<EdgeWeight, ContourSegment> &lhs,
+                 const std::pair<EdgeWeight, ContourSegment> &rhs) {
+                  return lhs.first < rhs.first;
+              });
+
+    std::vector<api::IsochroneAPI::Contour> contours;
+    contours.reserve(params.contours.size());
+    std::vector<ContourSegment> contour_segments;
+    for (const auto contour : util::irange<std::size_t>(0UL, params.contours.size()))
+    {
+        const auto contour_weight = toWeight(params.contours[contour]);
+        const auto end = std::upper_bound(
+            segments.begin(),
+            segments.end(),
+            contour_weight,
+            [](const EdgeWeight weight, const std::pair<EdgeWeight, ContourSegment> &segment) {
+                return weight < segment.first;
+            });
+
+        contour_segments.clear();
+        contour_segments.push_back(ContourSegment{source.location, source.location});
+        std::transform(segments.begin(),
+                       end,
+                       std::back_inserter(contour_segments),
+                       [](const std::pair<EdgeWeight, ContourSegment> &segment) {
+                           return segment.second;
+                       });
+        contour_segments.insert(contour_segments.end(),
+                                partial_segments[contour].begin(),
+                                partial_segments[contour].end());
+        contours.push_back(makeContour(contour_segments, params.cell_size));
+    }
+
+    api::IsochroneAPI isochrone_api(facade, params);
+    isochrone_api.MakeResponse(source, contours, result);
+
+    return Status::Ok;
+}
+}
+}
+}
@@ -2,19 +2,34 @@
 #include "engine/plugins/plugin_base.hpp"
 
 #include "engine/api/match_api.hpp"
+#include "engine/api/match_batch_parameters.hpp"
+#include "engine/api/match_batch_result.hpp"
 #include "engine/api/match_parameters.hpp"
+#include "engine/api/match_parameters_tidy.hpp"
+#include "engine/api/match_stream_parameters.hpp"
 #include "engine/map_matching/bayes_classifier.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/bearing.hpp"
 #include "util/coordinate_calculation.hpp"
 #include "util/integer_range.hpp"
 #include "util/json_logger.hpp"
 #include "util/json_util.hpp"
+#include "util/query_metrics.hpp"
 #include "util/string_util.hpp"
 
+#include <boost/optional.hpp>
+
+#include <cmath>
 #include <cstdlib>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <algorithm>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -24,6 +39,15 @@ namespace engine
 namespace plugins
 {
 
+namespace
+{
+// the emission and viterbi probabilities, the parent, the path distance and the pruned flag of a
+// state of the hidden markov model, see map_matching::HiddenMarkovModel
+const constexpr std::size_t HMM_STATE_BYTES = sizeof(float) + sizeof(double) +
+                                              sizeof(std::pair<unsigned, unsigned>) +
+                                              sizeof(float) + sizeof(char);
+}
+
 // Filters PhantomNodes to obtain a set of viable candiates
 void filterCandidates(const std::vector<util::Coordinate> &coordinates,
                       MatchPlugin::CandidateLists &candidates_lists)
@@ -106,31 +130,142 @@ void filterCandidates(const std::vector<util::Coordinate> &coordinates,
     }
 }
 
-Status MatchPlugin::HandleRequest(const api::MatchParameters &parameters,
-                                  util::json::Object &json_result)
+// The bearing of the segment a candidate is on in forward direction, none if the geometry
+// has no extent at the candidate
+boost::optional<double> getSegmentBearing(const datafacade::BaseDataFacade &facade,
+                                          const PhantomNode &phantom)
 {
-    BOOST_ASSERT(parameters.IsValid());
+    std::vector<NodeID> geometry;
+    if (phantom.forward_packed_geometry_id != SPECIAL_EDGEID)
+    {
+        facade.GetUncompressedGeometry(phantom.forward_packed_geometry_id, geometry);
+        BOOST_ASSERT(phantom.fwd_segment_position < geometry.size());
+        // geometries only store the target of each of their segments
+        const auto target = facade.GetCoordinateOfNode(geometry[phantom.fwd_segment_position]);
+        if (target != phantom.location)
+        {
+            return util::coordinate_calculation::bearing(phantom.location, target);
+        }
+        if (phantom.fwd_segment_position > 0)
+        {
+            return util::coordinate_calculation::bearing(
+                facade.GetCoordinateOfNode(geometry[phantom.fwd_segment_position - 1]), target);
+        }
+    }
+    if (phantom.reverse_packed_geometry_id != SPECIAL_EDGEID)
+    {
+        facade.GetUncompressedGeometry(phantom.reverse_packed_geometry_id, geometry);
+        BOOST_ASSERT(phantom.fwd_segment_position < geometry.size());
+        // the target of the segment in reverse direction is its source in forward direction
+        const auto index = geometry.size() - phantom.fwd_segment_position - 1;
+        const auto source = facade.GetCoordinateOfNode(geometry[index]);
+        if (source != phantom.location)
+        {
+            return util::coordinate_calculation::bearing(source, phantom.location);
+        }
+        if (index > 0)
+        {
+            return util::coordinate_calculation::bearing(
+                source, facade.GetCoordinateOfNode(geometry[index - 1]));
+        }
+    }
+    return boost::none;
+}
 
-    // enforce maximum number of locations for performance reasons
-    if (max_locations_map_matching > 0 &&
-        static_cast<int>(parameters.coordinates.size()) > max_locations_map_matching)
+// Drops the candidates that aren't worth the routes to compute their transitions before the
+// hidden markov model is built: the ones that are traversed against the heading of the trace and
+// the ones beyond the closest max_candidates, their emission probabilities are the lowest.
+// Expects the candidates split into their directions and sorted by distance, see
+// filterCandidates.
+void pruneCandidates(const datafacade::BaseDataFacade &facade,
+                     const api::MatchParameters &parameters,
+                     const std::vector<util::Coordinate> &coordinates,
+                     MatchPlugin::CandidateLists &candidates_lists,
+                     MatchPlugin::CandidateStatistics &statistics)
+{
+    BOOST_ASSERT(coordinates.size() == candidates_lists.size());
+    for (const auto current_coordinate : util::irange<std::size_t>(0, coordinates.size()))
     {
-        return Error("TooBig", "Too many trace coordinates", json_result);
+        auto &candidates = candidates_lists[current_coordinate];
+        statistics.found += candidates.size();
+        if (candidates.empty())
+        {
+            continue;
+        }
+
+        const auto previous_coordinate = current_coordinate > 0 ? current_coordinate - 1 : 0;
+        const auto next_coordinate = std::min(current_coordinate + 1, coordinates.size() - 1);
+        if (parameters.heading_tolerance &&
+            util::coordinate_calculation::haversineDistance(coordinates[previous_coordinate],
+                                                            coordinates[next_coordinate]) >=
+                MatchPlugin::MIN_HEADING_DISTANCE)
+        {
+            const auto heading = util::coordinate_calculation::bearing(
+                coordinates[previous_coordinate], coordinates[next_coordinate]);
+            const auto matches_heading = [&](const PhantomNodeWithDistance &candidate) {
+                const auto &phantom = candidate.phantom_node;
+                // candidates at possible u-turns keep both directions
+                if (phantom.forward_segment_id.enabled == phantom.reverse_segment_id.enabled)
+                {
+                    return true;
+                }
+                const auto segment_bearing = getSegmentBearing(facade, phantom);
+                if (!segment_bearing)
+                {
+                    return true;
+                }
+                const auto direction = phantom.forward_segment_id.enabled
+                                           ? *segment_bearing
+                                           : *segment_bearing + 180.;
+                return util::bearing::CheckInBounds(std::round(direction),
+                                                    std::round(heading),
+                                                    *parameters.heading_tolerance);
+            };
+
+            // keeps the order by distance, a point without any candidate along the heading
+            // keeps all of them instead
+            const auto matching_end =
+                std::stable_partition(candidates.begin(), candidates.end(), matches_heading);
+            if (matching_end != candidates.begin())
+            {
+                statistics.pruned_by_heading += candidates.end() - matching_end;
+                candidates.erase(matching_end, candidates.end());
+            }
+        }
+
+        if (parameters.max_candidates > 0 && candidates.size() > parameters.max_candidates)
+        {
+            statistics.pruned_by_count += candidates.size() - parameters.max_candidates;
+            candidates.resize(parameters.max_candidates);
+        }
     }
+}
 
-    if (!CheckAllCoordinates(parameters.coordinates))
+void addCandidateStatistics(const api::MatchParameters &parameters,
+                            const MatchPlugin::CandidateStatistics &statistics,
+                            util::json::Object &json_result)
+{
+    if (parameters.max_candidates == 0 && !parameters.heading_tolerance)
     {
-        return Error("InvalidValue", "Invalid coordinate value.", json_result);
+        return;
     }
+    util::json::Object json_statistics;
+    json_statistics.values["found"] = static_cast<double>(statistics.found);
+    json_statistics.values["pruned_by_heading"] = static_cast<double>(statistics.pruned_by_heading);
+    json_statistics.values["pruned_by_count"] = static_cast<double>(statistics.pruned_by_count);
+    json_result.values["candidates"] = std::move(json_statistics);
+}
 
-    // assuming radius is the standard deviation of a normal distribution
-    // that models GPS noise (in this model), x3 should give us the correct
-    // search radius with > 99% confidence
+// assuming radius is the standard deviation of a normal distribution
+// that models GPS noise (in this model), x3 should give us the correct
+// search radius with > 99% confidence
+std::vector<double> getSearchRadiuses(const api::MatchParameters &parameters)
+{
     std::vector<double> search_radiuses;
     if (parameters.radiuses.empty())
     {
         search_radiuses.resize(parameters.coordinates.size(),
-                               DEFAULT_GPS_PRECISION * RADIUS_MULTIPLIER);
+                               MatchPlugin::DEFAULT_GPS_PRECISION * MatchPlugin::RADIUS_MULTIPLIER);
     }
     else
     {
@@ -141,40 +276,229 @@ Status MatchPlugin::HandleRequest(const api::MatchParameters &parameters,
                        [](const boost::optional<double> &maybe_radius) {
                            if (maybe_radius)
                            {
-                               return *maybe_radius * RADIUS_MULTIPLIER;
+                               return *maybe_radius * MatchPlugin::RADIUS_MULTIPLIER;
                            }
                            else
                            {
-                               return DEFAULT_GPS_PRECISION * RADIUS_MULTIPLIER;
+                               return MatchPlugin::DEFAULT_GPS_PRECISION *
+                                      MatchPlugin::RADIUS_MULTIPLIER;
                            }
 
                        });
     }
+    return search_radiuses;
+}
 
-    auto candidates_lists = GetPhantomNodesInRange(parameters, search_radiuses);
+Status MatchPlugin::MatchTrace(const api::MatchParameters &parameters,
+                               SubMatchingList &sub_matchings,
+                               CandidateStatistics &statistics,
+                               std::string &code,
+                               std::string &message)
+{
+    BOOST_ASSERT(parameters.IsValid());
+
+    // enforce maximum number of locations for performance reasons
+    if (max_locations_map_matching > 0 &&
+        static_cast<int>(parameters.coordinates.size()) > max_locations_map_matching)
+    {
+        code = "TooBig";
+        message = "Too many trace coordinates";
+        return Status::Error;
+    }
+
+    if (!CheckAllCoordinates(parameters.coordinates))
+    {
+        code = "InvalidValue";
+        message = "Invalid coordinate value.";
+        return Status::Error;
+    }
+
+    // the tidied trace is matched, its indices are mapped back to the points of the request
+    api::tidy::Result tidied;
+    if (parameters.tidy)
+    {
+        tidied = api::tidy::tidy(parameters);
+    }
+    const auto &trace = parameters.tidy ? tidied.parameters : parameters;
+
+    const auto search_radiuses = getSearchRadiuses(trace);
+    auto candidates_lists = GetPhantomNodesInRange(trace, search_radiuses);
+
+    filterCandidates(trace.coordinates, candidates_lists);
+    pruneCandidates(BasePlugin::facade, trace, trace.coordinates, candidates_lists, statistics);
+
+    // the candidates and the states of the hidden markov model, one per candidate
+    std::size_t number_of_candidates = 0;
+    for (const auto &candidates : candidates_lists)
+    {
+        number_of_candidates += candidates.size();
+    }
+    if (!SearchEngineData::ReserveQueryMemory(
+            number_of_candidates * (sizeof(PhantomNodeWithDistance) + HMM_STATE_BYTES)))
+    {
+        code = "TooBig";
+        message = "Trace needs more memory than a query may use";
+        return Status::Error;
+    }
 
-    filterCandidates(parameters.coordinates, candidates_lists);
     if (std::all_of(candidates_lists.begin(),
                     candidates_lists.end(),
                     [](const std::vector<PhantomNodeWithDistance> &candidates) {
                         return candidates.empty();
                     }))
     {
-        return Error("NoSegment",
-                     std::string("Could not find a matching segment for any coordinate."),
-                     json_result);
+        code = "NoSegment";
+        message = "Could not find a matching segment for any coordinate.";
+        return Status::Error;
     }
 
+    // the matching and the routes between the matched points are all part of the search
+    const util::QueryMetrics::ScopedPhase search(util::QueryMetrics::Phase::Search);
+
     // call the actual map matching
-    SubMatchingList sub_matchings = map_matching(
-        candidates_lists, parameters.coordinates, parameters.timestamps, parameters.radiuses);
+    sub_matchings =
+        map_matching(candidates_lists, trace.coordinates, trace.timestamps, trace.radiuses);
 
     if (sub_matchings.size() == 0)
     {
-        return Error("NoMatch", "Could not match the trace.", json_result);
+        code = "NoMatch";
+        message = "Could not match the trace.";
+        return Status::Error;
+    }
+
+    if (parameters.tidy)
+    {
+        for (auto &sub_matching : sub_matchings)
+        {
+            for (auto &index : sub_matching.indices)
+            {
+                index = tidied.original_indices[index];
+            }
+        }
+    }
+
+    return Status::Ok;
+}
+
+Status MatchPlugin::HandleRequest(const api::MatchParameters &parameters,
+                                  util::json::Object &json_result)
+{
+    SubMatchingList sub_matchings;
+    CandidateStatistics statistics;
+    std::string code;
+    std::string message;
+    if (MatchTrace(parameters, sub_matchings, statistics, code, message) != Status::Ok)
+    {
+        return Error(code, message, json_result);
+    }
+
+    std::vector<InternalRouteResult> sub_routes;
+    {
+        const util::QueryMetrics::ScopedPhase search(util::QueryMetrics::Phase::Search);
+        RouteSubMatchings(sub_matchings, sub_routes);
     }
 
-    std::vector<InternalRouteResult> sub_routes(sub_matchings.size());
+    api::MatchAPI match_api{BasePlugin::facade, parameters};
+    match_api.MakeResponse(sub_matchings, sub_routes, json_result);
+    addCandidateStatistics(parameters, statistics, json_result);
+
+    return Status::Ok;
+}
+
+Status MatchPlugin::HandleRequest(const api::MatchBatchParameters &parameters,
+                                  api::MatchBatchResult &result)
+{
+    BOOST_ASSERT(parameters.IsValid());
+
+    if (max_traces_match_batch > 0 &&
+        static_cast<int>(parameters.traces.size()) > max_traces_match_batch)
+    {
+        result.traces.clear();
+        result.code = "TooBig";
+        result.message = "Too many traces";
+        return Status::Error;
+    }
+
+    // every range of traces runs on heaps checked out of the pool of the query
+    result.traces.resize(parameters.traces.size());
+    const auto options = SearchEngineData::GetQueryControl();
+    const auto cell_metric = SearchEngineData::GetCellMetric();
+    auto &heap_pool = SearchEngineData::GetHeapPool();
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, parameters.traces.size()),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            const SearchEngineData::ScopedQueryControl control(options);
+            const SearchEngineData::ScopedCellMetric metric(cell_metric);
+            const SearchEngineData::ScopedHeaps heaps(heap_pool);
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                const auto &trace = parameters.traces[index];
+                auto &matched_trace = result.traces[index];
+
+                SubMatchingList sub_matchings;
+                CandidateStatistics statistics;
+                if (MatchTrace(trace,
+                               sub_matchings,
+                               statistics,
+                               matched_trace.code,
+                               matched_trace.message) != Status::Ok)
+                {
+                    continue;
+                }
+                matched_trace.code = "Ok";
+
+                matched_trace.tracepoints.resize(trace.coordinates.size());
+                for (const auto i : util::irange<std::size_t>(0UL, trace.timestamps.size()))
+                {
+                    matched_trace.tracepoints[i].timestamp = trace.timestamps[i];
+                }
+
+                matched_trace.matchings.resize(sub_matchings.size());
+                for (const auto matching_index :
+                     util::irange<std::size_t>(0UL, sub_matchings.size()))
+                {
+                    const auto &sub_matching = sub_matchings[matching_index];
+                    matched_trace.matchings[matching_index].confidence = sub_matching.confidence;
+                    for (const auto i : util::irange<std::size_t>(0UL, sub_matching.nodes.size()))
+                    {
+                        const auto &phantom = sub_matching.nodes[i];
+                        auto &tracepoint = matched_trace.tracepoints[sub_matching.indices[i]];
+                        if (phantom.forward_segment_id.enabled)
+                        {
+                            tracepoint.forward_segment_id = phantom.forward_segment_id.id;
+                        }
+                        if (phantom.reverse_segment_id.enabled)
+                        {
+                            tracepoint.reverse_segment_id = phantom.reverse_segment_id.id;
+                        }
+                        tracepoint.location = phantom.location;
+                        tracepoint.matchings_index = static_cast<unsigned>(matching_index);
+                    }
+                }
+
+                if (parameters.durations)
+                {
+                    // only the packed paths of the routes, they are never assembled
+                    std::vector<InternalRouteResult> sub_routes;
+                    RouteSubMatchings(sub_matchings, sub_routes);
+                    for (const auto matching_index :
+                         util::irange<std::size_t>(0UL, sub_routes.size()))
+                    {
+                        matched_trace.matchings[matching_index].duration =
+                            sub_routes[matching_index].shortest_path_length;
+                    }
+                }
+            }
+        });
+
+    result.code = "Ok";
+    return Status::Ok;
+}
+
+void MatchPlugin::RouteSubMatchings(const SubMatchingList &sub_matchings,
+                                    std::vector<InternalRouteResult> &sub_routes) const
+{
+    sub_routes.resize(sub_matchings.size());
     for (auto index : util::irange<std::size_t>(0UL, sub_matchings.size()))
     {
         BOOST_ASSERT(sub_matchings[index].nodes.size() > 1);
@@ -196,10 +520,138 @@ Status MatchPlugin::HandleRequest(const api::MatchParameters &parameters,
         shortest_path(sub_routes[index].segment_end_coordinates, {false}, sub_routes[index]);
         BOOST_ASSERT(sub_routes[index].shortest_path_length != INVALID_EDGE_WEIGHT);
     }
+}
 
-    api::MatchAPI match_api{BasePlugin::facade, parameters};
+Status MatchPlugin::HandleRequest(const api::MatchStreamParameters &parameters,
+                                  util::json::Object &json_result)
+{
+    BOOST_ASSERT(parameters.IsValid());
+
+    if (!match_sessions)
+    {
+        return Error("NotImplemented", "Match sessions are disabled.", json_result);
+    }
+
+    // enforce maximum number of locations for performance reasons
+    if (max_locations_map_matching > 0 &&
+        static_cast<int>(parameters.coordinates.size()) > max_locations_map_matching)
+    {
+        return Error("TooBig", "Too many trace coordinates", json_result);
+    }
+
+    if (!CheckAllCoordinates(parameters.coordinates))
+    {
+        return Error("InvalidValue", "Invalid coordinate value.", json_result);
+    }
+
+    const auto search_radiuses = getSearchRadiuses(parameters);
+    auto candidates_lists = GetPhantomNodesInRange(parameters, search_radiuses);
+
+    const auto session = match_sessions->Get(parameters.session);
+    std::lock_guard<std::mutex> lock(session->mutex);
+
+    if (!parameters.coordinates.empty())
+    {
+        if (session->number_of_points == 0)
+        {
+            session->use_timestamps = !parameters.timestamps.empty();
+        }
+        else if (session->use_timestamps == parameters.timestamps.empty())
+        {
+            return Error("InvalidValue",
+                         "Timestamps are required for all points of a session or for none.",
+                         json_result);
+        }
+    }
+
+    // the pending candidates are on a dataset that is gone
+    const auto data_checksum = BasePlugin::facade.GetCheckSum();
+    if (session->data_checksum != data_checksum)
+    {
+        session->Clear();
+        session->data_checksum = data_checksum;
+    }
+
+    // the last pending point tells apart u-turns at the first new one
+    std::vector<util::Coordinate> filter_coordinates;
+    std::size_t first_new_point = 0;
+    if (!session->points.empty())
+    {
+        filter_coordinates.push_back(session->points.back().coordinate);
+        candidates_lists.insert(candidates_lists.begin(), CandidateList());
+        first_new_point = 1;
+    }
+    filter_coordinates.insert(filter_coordinates.end(),
+                              parameters.coordinates.begin(),
+                              parameters.coordinates.end());
+    filterCandidates(filter_coordinates, candidates_lists);
+    CandidateStatistics statistics;
+    pruneCandidates(
+        BasePlugin::facade, parameters, filter_coordinates, candidates_lists, statistics);
+
+    const util::QueryMetrics::ScopedPhase search(util::QueryMetrics::Phase::Search);
+
+    const auto reported_end = session->final_end;
+    SubMatchingList sub_matchings;
+    try
+    {
+        for (const auto i : util::irange<std::size_t>(0UL, parameters.coordinates.size()))
+        {
+            map_matching.AppendToSession(
+                *session,
+                std::move(candidates_lists[first_new_point + i]),
+                parameters.coordinates[i],
+                parameters.timestamps.empty() ? 0 : parameters.timestamps[i],
+                parameters.radiuses.empty() ? boost::optional<double>() : parameters.radiuses[i],
+                max_match_session_points,
+                sub_matchings);
+        }
+    }
+    catch (const QueryAborted &)
+    {
+        // the point the query was aborted at is only partly matched, the session starts over
+        // from the next call like after a data update
+        session->Clear();
+        throw;
+    }
+    if (parameters.finish)
+    {
+        map_matching.FinishSession(*session, sub_matchings);
+        match_sessions->Remove(parameters.session, session);
+    }
+
+    std::vector<InternalRouteResult> sub_routes;
+    RouteSubMatchings(sub_matchings, sub_routes);
+
+    // the first piece may start at the boundary point that the last response returned
+    auto first_tracepoint = reported_end;
+    if (!sub_matchings.empty())
+    {
+        first_tracepoint = std::min<std::size_t>(first_tracepoint,
+                                                 sub_matchings.front().indices.front());
+    }
+    for (auto &sub_matching : sub_matchings)
+    {
+        for (auto &index : sub_matching.indices)
+        {
+            index -= first_tracepoint;
+        }
+    }
+
+    // the API only counts the coordinates for the tracepoints
+    api::MatchParameters response_parameters(parameters);
+    response_parameters.coordinates.resize(session->final_end - first_tracepoint);
+    api::MatchAPI match_api{BasePlugin::facade, response_parameters};
     match_api.MakeResponse(sub_matchings, sub_routes, json_result);
 
+    auto &tracepoints = json_result.values["tracepoints"].get<util::json::Array>().values;
+    tracepoints.erase(tracepoints.begin(),
+                      tracepoints.begin() + (reported_end - first_tracepoint));
+    json_result.values["first_tracepoint"] = static_cast<double>(reported_end);
+    json_result.values["pending"] =
+        static_cast<double>(session->number_of_points - session->final_end);
+    addCandidateStatistics(parameters, statistics, json_result);
+
     return Status::Ok;
 }
 }
@@ -1,6 +1,7 @@
 #include "engine/plugins/nearest.hpp"
 #include "engine/api/nearest_api.hpp"
 #include "engine/api/nearest_parameters.hpp"
+#include "engine/api/nearest_result.hpp"
 #include "engine/phantom_node.hpp"
 #include "util/integer_range.hpp"
 
@@ -17,13 +18,28 @@ namespace engine
 namespace plugins
 {
 
-NearestPlugin::NearestPlugin(datafacade::BaseDataFacade &facade, const int max_results_)
-    : BasePlugin{facade}, max_results{max_results_}
+NearestPlugin::NearestPlugin(datafacade::BaseDataFacade &facade,
+                             const int max_results_,
+                             const int max_locations_)
+    : BasePlugin{facade}, max_results{max_results_}, max_locations{max_locations_}
 {
 }
 
 Status NearestPlugin::HandleRequest(const api::NearestParameters &params,
-                                    util::json::Object &json_result)
+                                    util::json::Object &result)
+{
+    return HandleRequestImpl(params, result);
+}
+
+Status NearestPlugin::HandleRequest(const api::NearestParameters &params,
+                                    api::NearestResult &result)
+{
+    return HandleRequestImpl(params, result);
+}
+
+// Both results come from the same query, only the response is made differently
+template <typename ResultT>
+Status NearestPlugin::HandleRequestImpl(const api::NearestParameters &params, ResultT &result)
 {
     BOOST_ASSERT(params.IsValid());
 
@@ -33,27 +49,32 @@ Status NearestPlugin::HandleRequest(const api::NearestParameters &params,
         return Error("TooBig",
                      "Number of results " + std::to_string(params.number_of_results) +
                          " is higher than current maximum (" + std::to_string(max_results) + ")",
-                     json_result);
+                     result);
     }
 
     if (!CheckAllCoordinates(params.coordinates))
-        return Error("InvalidOptions", "Coordinates are invalid", json_result);
+        return Error("InvalidOptions", "Coordinates are invalid", result);
 
-    if (params.coordinates.size() != 1)
+    if (max_locations > 0 &&
+        (boost::numeric_cast<std::int64_t>(params.coordinates.size()) > max_locations))
     {
-        return Error("InvalidOptions", "Only one input coordinate is supported", json_result);
+        return Error("TooBig",
+                     "Number of entries " + std::to_string(params.coordinates.size()) +
+                         " is higher than current maximum (" + std::to_string(max_locations) +
+                         ")",
+                     result);
     }
 
     auto phantom_nodes = GetPhantomNodes(params, params.number_of_results);
 
-    if (phantom_nodes.front().size() == 0)
+    // the results of many coordinates have a code each
+    if (phantom_nodes.size() == 1 && phantom_nodes.front().size() == 0)
     {
-        return Error("NoSegment", "Could not find a matching segments for coordinate", json_result);
+        return Error("NoSegment", "Could not find a matching segments for coordinate", result);
     }
-    BOOST_ASSERT(phantom_nodes.front().size() > 0);
 
     api::NearestAPI nearest_api(facade, params);
-    nearest_api.MakeResponse(phantom_nodes, json_result);
+    nearest_api.MakeResponse(phantom_nodes, result);
 
     return Status::Ok;
 }
@@ -0,0 +1,77 @@
+#include "engine/plugins/one_to_all.hpp"
+
+#include "engine/api/one_to_all_parameters.hpp"
+#include "engine/api/one_to_all_result.hpp"
+#include "engine/routing_algorithms/one_to_all.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/query_metrics.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+namespace osrm
+{
+namespace engine
+{
+namespace plugins
+{
+
+OneToAllPlugin::OneToAllPlugin(datafacade::BaseDataFacade &facade,
+                               const int max_locations_one_to_all,
+                               SnappingCache *snapping_cache)
+    : BasePlugin{facade, snapping_cache}, one_to_all(&facade, heaps),
+      max_locations_one_to_all(max_locations_one_to_all)
+{
+}
+
+Status OneToAllPlugin::Error(const std::string &code,
+                             const std::string &message,
+                             api::OneToAllResult &result) const
+{
+    result.code = code;
+    result.message = message;
+    return Status::Error;
+}
+
+Status OneToAllPlugin::HandleRequest(const api::OneToAllParameters &params,
+                                     api::OneToAllResult &result)
+{
+    BOOST_ASSERT(params.IsValid());
+
+    if (!CheckAllCoordinates(params.coordinates))
+    {
+        return Error("InvalidOptions", "Coordinates are invalid", result);
+    }
+
+    if (max_locations_one_to_all > 0 &&
+        params.coordinates.size() > static_cast<std::size_t>(max_locations_one_to_all))
+    {
+        return Error("TooBig", "Too many one-to-all coordinates", result);
+    }
+
+    auto phantom_node_pairs = GetPhantomNodes(params);
+    if (phantom_node_pairs.size() != params.coordinates.size())
+    {
+        return Error("NoSegment",
+                     std::string("Could not find a matching segment for coordinate ") +
+                         std::to_string(phantom_node_pairs.size()),
+                     result);
+    }
+    const auto snapped_phantoms = SnapPhantomNodes(phantom_node_pairs);
+
+    result.number_of_sources = snapped_phantoms.size();
+    result.number_of_nodes = facade.GetNumberOfNodes();
+    {
+        const util::QueryMetrics::ScopedPhase search(util::QueryMetrics::Phase::Search);
+        result.durations = one_to_all(snapped_phantoms);
+    }
+    result.code = "Ok";
+
+    return Status::Ok;
+}
+}
+}
+}
@@ -2,15 +2,19 @@
 
 #include "engine/api/table_api.hpp"
 #include "engine/api/table_parameters.hpp"
+#include "engine/api/table_stream.hpp"
 #include "engine/routing_algorithms/many_to_many.hpp"
 #include "engine/search_engine_data.hpp"
 #include "util/json_container.hpp"
+#include "util/json_renderer.hpp"
+#include "util/query_metrics.hpp"
 #include "util/string_util.hpp"
 
 #include <cstdlib>
 
 #include <algorithm>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -23,25 +27,134 @@ namespace engine
 namespace plugins
 {
 
-TablePlugin::TablePlugin(datafacade::BaseDataFacade &facade, const int max_locations_distance_table)
-    : BasePlugin{facade}, distance_table(&facade, heaps),
-      max_locations_distance_table(max_locations_distance_table)
+namespace
+{
+// the entries of a block of rows of a streamed table, the blocks take 16 MiB of durations
+const constexpr std::size_t STREAM_BLOCK_ENTRIES = 4 * 1024 * 1024;
+
+// a duration and about as many bytes for its rendering
+const constexpr std::size_t TABLE_ENTRY_BYTES = sizeof(EdgeWeight) + 8;
+
+// The memory a table takes, its durations and their response
+template <typename ResultT>
+std::size_t getTableMemory(const api::TableParameters &, const std::size_t entries, const ResultT &)
+{
+    return entries * TABLE_ENTRY_BYTES;
+}
+
+// a streamed table only holds a block of rows at a time, unless a session keeps the whole table
+std::size_t getTableMemory(const api::TableParameters &params,
+                           const std::size_t entries,
+                           const api::TableStream &)
+{
+    return (params.session.empty() ? std::min(entries, STREAM_BLOCK_ENTRIES) : entries) *
+           TABLE_ENTRY_BYTES;
+}
+}
+
+TablePlugin::TablePlugin(datafacade::BaseDataFacade &facade,
+                         const int max_locations_distance_table,
+                         const bool use_parallel_distance_table,
+                         SnappingCache *snapping_cache,
+                         TableSessions *table_sessions,
+                         SearchSpaceCache *search_space_cache)
+    : BasePlugin{facade, snapping_cache}, distance_table(&facade, heaps, search_space_cache),
+      max_locations_distance_table(max_locations_distance_table),
+      use_parallel_distance_table(use_parallel_distance_table), table_sessions(table_sessions)
 {
 }
 
 Status TablePlugin::HandleRequest(const api::TableParameters &params, util::json::Object &result)
+{
+    return HandleRequestImpl(params, result);
+}
+
+Status TablePlugin::HandleRequest(const api::TableParameters &params, std::string &result)
+{
+    return HandleRequestImpl(params, result);
+}
+
+Status TablePlugin::HandleRequest(const api::TableParameters &params, api::TableResult &result)
+{
+    return HandleRequestImpl(params, result);
+}
+
+Status TablePlugin::HandleRequest(const api::TableParameters &params, api::TableStream &result)
+{
+    if (params.format != api::TableParameters::OutputFormatType::JSON)
+    {
+        return Fail(params, "InvalidOptions", "Only JSON tables are streamed", result);
+    }
+    return HandleRequestImpl(params, result);
+}
+
+Status TablePlugin::Fail(const api::TableParameters &,
+                         const std::string &code,
+                         const std::string &message,
+                         util::json::Object &result) const
+{
+    return Error(code, message, result);
+}
+
+Status TablePlugin::Fail(const api::TableParameters &params,
+                         const std::string &code,
+                         const std::string &message,
+                         std::string &result) const
+{
+    if (params.format == api::TableParameters::OutputFormatType::PBF)
+    {
+        return Error(code, message, result);
+    }
+
+    util::json::Object json_result;
+    Error(code, message, json_result);
+    result.clear();
+    util::json::render(result, json_result);
+    return Status::Error;
+}
+
+Status TablePlugin::Fail(const api::TableParameters &,
+                         const std::string &code,
+                         const std::string &message,
+                         api::TableResult &result) const
+{
+    return Error(code, message, result);
+}
+
+Status TablePlugin::Fail(const api::TableParameters &,
+                         const std::string &code,
+                         const std::string &message,
+                         api::TableStream &result) const
+{
+    util::json::Object json_result;
+    Error(code, message, json_result);
+    result.error.clear();
+    util::json::render(result.error, json_result);
+    return Status::Error;
+}
+
+// All formats run the same query, only the response is made differently
+template <typename ResultT>
+Status TablePlugin::HandleRequestImpl(const api::TableParameters &params, ResultT &result)
 {
     BOOST_ASSERT(params.IsValid());
 
+    if (!params.session.empty() && !table_sessions)
+    {
+        return Fail(params, "InvalidOptions", "Table sessions are disabled", result);
+    }
+
     if (!CheckAllCoordinates(params.coordinates))
     {
-        return Error("InvalidOptions", "Coordinates are invalid", result);
+        return Fail(params, "InvalidOptions", "Coordinates are invalid", result);
     }
 
     if (params.bearings.size() > 0 && params.coordinates.size() != params.bearings.size())
     {
-        return Error(
-            "InvalidOptions", "Number of bearings does not match number of coordinates", result);
+        return Fail(params,
+                    "InvalidOptions",
+                    "Number of bearings does not match number of coordinates",
+                    result);
     }
 
     // Empty sources or destinations means the user wants all of them included, respectively
@@ -55,15 +168,59 @@ Status TablePlugin::HandleRequest(const api::TableParameters &params, util::json
         ((num_sources * num_destinations) >
          static_cast<std::size_t>(max_locations_distance_table * max_locations_distance_table)))
     {
-        return Error("TooBig", "Too many table coordinates", result);
+        return Fail(params, "TooBig", "Too many table coordinates", result);
+    }
+
+    if (!SearchEngineData::ReserveQueryMemory(
+            getTableMemory(params, num_sources * num_destinations, result)))
+    {
+        return Fail(params, "TooBig", "Table needs more memory than a query may use", result);
+    }
+
+    auto phantom_node_pairs = GetPhantomNodes(params);
+    if (phantom_node_pairs.size() != params.coordinates.size())
+    {
+        return Fail(params,
+                    "NoSegment",
+                    std::string("Could not find a matching segment for coordinate ") +
+                        std::to_string(phantom_node_pairs.size()),
+                    result);
     }
+    auto snapped_phantoms = SnapPhantomNodes(phantom_node_pairs);
+    // weights are in tenths of a second
+    const auto max_weight =
+        params.max_duration && *params.max_duration * 10. < INVALID_EDGE_WEIGHT
+            ? static_cast<EdgeWeight>(*params.max_duration * 10.)
+            : INVALID_EDGE_WEIGHT;
+    return MakeTable(params, snapped_phantoms, max_weight, result);
+}
 
-    auto snapped_phantoms = SnapPhantomNodes(GetPhantomNodes(params));
-    auto result_table = distance_table(snapped_phantoms, params.sources, params.destinations);
+template <typename ResultT>
+Status TablePlugin::MakeTable(const api::TableParameters &params,
+                              const std::vector<PhantomNode> &snapped_phantoms,
+                              const EdgeWeight max_weight,
+                              ResultT &result)
+{
+    auto result_table = [&] {
+        const util::QueryMetrics::ScopedPhase search(util::QueryMetrics::Phase::Search);
+        if (!params.session.empty())
+        {
+            const auto session = table_sessions->Get(params.session);
+            std::lock_guard<std::mutex> lock(session->mutex);
+            return distance_table(
+                *session, snapped_phantoms, params.sources, params.destinations, max_weight);
+        }
+        return distance_table(snapped_phantoms,
+                              params.sources,
+                              params.destinations,
+                              use_parallel_distance_table,
+                              nullptr,
+                              max_weight);
+    }();
 
     if (result_table.empty())
     {
-        return Error("NoTable", "No table found", result);
+        return Fail(params, "NoTable", "No table found", result);
     }
 
     api::TableAPI table_api{facade, params};
@@ -71,6 +228,68 @@ Status TablePlugin::HandleRequest(const api::TableParameters &params, util::json
 
     return Status::Ok;
 }
+
+// The head of the JSON is written with the first block, so the errors up to it are still reported
+Status TablePlugin::MakeTable(const api::TableParameters &params,
+                              const std::vector<PhantomNode> &snapped_phantoms,
+                              const EdgeWeight max_weight,
+                              api::TableStream &result)
+{
+    api::TableAPI table_api{facade, params};
+    const auto number_of_destinations =
+        params.destinations.empty() ? snapped_phantoms.size() : params.destinations.size();
+
+    std::string part;
+    const auto write_block = [&](const std::size_t first_row,
+                                 const std::vector<EdgeWeight> &block) {
+        {
+            const util::QueryMetrics::ScopedPhase rendering(
+                util::QueryMetrics::Phase::Rendering);
+            if (first_row == 0)
+            {
+                table_api.MakeJSONHead(snapped_phantoms, part);
+            }
+            table_api.MakeJSONRows(block, first_row, number_of_destinations, part);
+        }
+        return result.Write(part);
+    };
+
+    bool is_complete = false;
+    {
+        const util::QueryMetrics::ScopedPhase search(util::QueryMetrics::Phase::Search);
+        if (!params.session.empty())
+        {
+            // the session keeps the whole table anyway, it is only written in parts
+            const auto session = table_sessions->Get(params.session);
+            std::lock_guard<std::mutex> lock(session->mutex);
+            const auto result_table = distance_table(
+                *session, snapped_phantoms, params.sources, params.destinations, max_weight);
+            is_complete = !result_table.empty() && write_block(0, result_table);
+        }
+        else
+        {
+            is_complete = distance_table.ComputeTableInBlocks(snapped_phantoms,
+                                                              params.sources,
+                                                              params.destinations,
+                                                              STREAM_BLOCK_ENTRIES,
+                                                              use_parallel_distance_table,
+                                                              max_weight,
+                                                              write_block);
+        }
+    }
+
+    if (!result.started)
+    {
+        return Fail(params, "NoTable", "No table found", result);
+    }
+    table_api.MakeJSONTail(part);
+    if (!is_complete || !result.Write(part))
+    {
+        // the client got part of the table, it can't tell the error anymore
+        return Status::Error;
+    }
+    return Status::Ok;
+}
 }
 }
 }
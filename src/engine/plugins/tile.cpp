@@ -2,18 +2,24 @@
 #include "engine/plugins/plugin_base.hpp"
 
 #include "util/coordinate_calculation.hpp"
+#include "util/integer_range.hpp"
+#include "util/rectangle.hpp"
+#include "util/string_view.hpp"
 #include "util/vector_tile.hpp"
 #include "util/web_mercator.hpp"
 
-#include <boost/geometry.hpp>
-#include <boost/geometry/geometries/geometries.hpp>
-#include <boost/geometry/geometries/point_xy.hpp>
-#include <boost/geometry/multi/geometries/multi_linestring.hpp>
+#include <boost/functional/hash.hpp>
 
 #include <protozero/pbf_writer.hpp>
 #include <protozero/varint.hpp>
 
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <array>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -31,10 +37,11 @@ namespace detail
 // Simple container class for WGS84 coordinates
 template <typename T> struct Point final
 {
+    Point() : x(0), y(0) {}
     Point(T _x, T _y) : x(_x), y(_y) {}
 
-    const T x;
-    const T y;
+    T x;
+    T y;
 };
 
 // from mapnik-vector-tile
@@ -68,31 +75,23 @@ struct point_type_i final
     const std::int64_t y;
 };
 
-using FixedLine = std::vector<detail::Point<std::int32_t>>;
-using FloatLine = std::vector<detail::Point<double>>;
+// The features of the tile are single segments, so their lines all have two points
+using FixedLine = std::array<detail::Point<std::int32_t>, 2>;
+
+const constexpr double CLIP_MIN = -util::vector_tile::BUFFER;
+const constexpr double CLIP_MAX = util::vector_tile::EXTENT + util::vector_tile::BUFFER;
 
-typedef boost::geometry::model::point<double, 2, boost::geometry::cs::cartesian> point_t;
-typedef boost::geometry::model::linestring<point_t> linestring_t;
-typedef boost::geometry::model::box<point_t> box_t;
-typedef boost::geometry::model::multi_linestring<linestring_t> multi_linestring_t;
-const static box_t clip_box(point_t(-util::vector_tile::BUFFER, -util::vector_tile::BUFFER),
-                            point_t(util::vector_tile::EXTENT + util::vector_tile::BUFFER,
-                                    util::vector_tile::EXTENT + util::vector_tile::BUFFER));
+// the segments of the tile are encoded in chunks of this size, each by one thread
+const constexpr std::size_t FEATURE_CHUNK_SIZE = 512;
 
 // from mapnik-vector-tile
 // Encodes a linestring using protobuf zigzag encoding
-inline bool encodeLinestring(const FixedLine &line,
+inline void encodeLinestring(const FixedLine &line,
                              protozero::packed_field_uint32 &geometry,
                              std::int32_t &start_x,
                              std::int32_t &start_y)
 {
-    const std::size_t line_size = line.size();
-    if (line_size < 2)
-    {
-        return false;
-    }
-
-    const unsigned line_to_length = static_cast<const unsigned>(line_size) - 1;
+    const unsigned line_to_length = static_cast<const unsigned>(line.size()) - 1;
 
     auto pt = line.begin();
     geometry.add_element(9); // move_to | (1 << 3)
@@ -110,64 +109,171 @@ inline bool encodeLinestring(const FixedLine &line,
         start_x = pt->x;
         start_y = pt->y;
     }
-    return true;
 }
 
-FixedLine coordinatesToTileLine(const util::Coordinate start,
-                                const util::Coordinate target,
-                                const detail::BBox &tile_bbox)
+// Clips the segment to the buffered tile extent (Liang-Barsky). Returns false if less than a
+// segment of it is left, which includes very short segments whose tile coordinates are dupes.
+inline bool clipLine(Point<double> &start, Point<double> &target)
 {
-    FloatLine geo_line;
-    geo_line.emplace_back(static_cast<double>(util::toFloating(start.lon)),
-                          static_cast<double>(util::toFloating(start.lat)));
-    geo_line.emplace_back(static_cast<double>(util::toFloating(target.lon)),
-                          static_cast<double>(util::toFloating(target.lat)));
+    const double dx = target.x - start.x;
+    const double dy = target.y - start.y;
+    if (dx == 0 && dy == 0)
+    {
+        return false;
+    }
+    double enter = 0.;
+    double leave = 1.;
+    // for each side of the box how fast the line moves out of it and how far inside it starts
+    const std::array<std::pair<double, double>, 4> sides{{{-dx, start.x - CLIP_MIN},
+                                                         {dx, CLIP_MAX - start.x},
+                                                         {-dy, start.y - CLIP_MIN},
+                                                         {dy, CLIP_MAX - start.y}}};
+    for (const auto &side : sides)
+    {
+        if (side.first == 0)
+        {
+            if (side.second < 0)
+            {
+                return false;
+            }
+            continue;
+        }
+        const double ratio = side.second / side.first;
+        if (side.first < 0)
+        {
+            enter = std::max(enter, ratio);
+        }
+        else
+        {
+            leave = std::min(leave, ratio);
+        }
+    }
+    if (enter >= leave)
+    {
+        return false;
+    }
 
-    linestring_t unclipped_line;
+    const Point<double> clipped_start{start.x + enter * dx, start.y + enter * dy};
+    target = Point<double>{start.x + leave * dx, start.y + leave * dy};
+    start = clipped_start;
+    return true;
+}
 
-    for (auto const &pt : geo_line)
-    {
-        double px_merc = pt.x * util::web_mercator::DEGREE_TO_PX;
-        double py_merc = util::web_mercator::latToY(util::FloatLatitude{pt.y}) *
-                         util::web_mercator::DEGREE_TO_PX;
+// Projects the segment into the tile and clips it, returns false if it is not in the tile
+bool coordinatesToTileLine(const util::Coordinate start,
+                           const util::Coordinate target,
+                           const detail::BBox &tile_bbox,
+                           FixedLine &tile_line)
+{
+    const auto to_tile = [&tile_bbox](const util::Coordinate coordinate) {
+        const double px_merc = static_cast<double>(util::toFloating(coordinate.lon)) *
+                               util::web_mercator::DEGREE_TO_PX;
+        const double py_merc =
+            util::web_mercator::latToY(util::toFloating(coordinate.lat)) *
+            util::web_mercator::DEGREE_TO_PX;
         // convert lon/lat to tile coordinates
-        const auto px = std::round(
-            ((px_merc - tile_bbox.minx) * util::web_mercator::TILE_SIZE / tile_bbox.width()) *
-            util::vector_tile::EXTENT / util::web_mercator::TILE_SIZE);
-        const auto py = std::round(
-            ((tile_bbox.maxy - py_merc) * util::web_mercator::TILE_SIZE / tile_bbox.height()) *
-            util::vector_tile::EXTENT / util::web_mercator::TILE_SIZE);
-
-        boost::geometry::append(unclipped_line, point_t(px, py));
+        return Point<double>{
+            std::round(
+                ((px_merc - tile_bbox.minx) * util::web_mercator::TILE_SIZE / tile_bbox.width()) *
+                util::vector_tile::EXTENT / util::web_mercator::TILE_SIZE),
+            std::round(
+                ((tile_bbox.maxy - py_merc) * util::web_mercator::TILE_SIZE / tile_bbox.height()) *
+                util::vector_tile::EXTENT / util::web_mercator::TILE_SIZE)};
+    };
+
+    auto tile_start = to_tile(start);
+    auto tile_target = to_tile(target);
+    if (!clipLine(tile_start, tile_target))
+    {
+        return false;
     }
 
-    multi_linestring_t clipped_line;
+    tile_line[0] = Point<std::int32_t>{static_cast<std::int32_t>(tile_start.x),
+                                       static_cast<std::int32_t>(tile_start.y)};
+    tile_line[1] = Point<std::int32_t>{static_cast<std::int32_t>(tile_target.x),
+                                       static_cast<std::int32_t>(tile_target.y)};
+    return true;
+}
 
-    boost::geometry::intersection(clip_box, unclipped_line, clipped_line);
+// The features of both directions of a segment, without their lines if they are not in the tile
+struct SegmentFeatures final
+{
+    FixedLine forward_line;
+    FixedLine reverse_line;
+    std::uint32_t forward_speed = 0;
+    std::uint32_t reverse_speed = 0;
+    bool has_forward = false;
+    bool has_reverse = false;
+};
 
-    FixedLine tile_line;
+// Looks up the coordinates, weights and datasources of the segments. The geometries are unpacked
+// into buffers that each thread reuses.
+void makeTileEdges(const datafacade::BaseDataFacade &facade,
+                   const std::vector<datafacade::BaseDataFacade::RTreeLeaf> &edges,
+                   TileEdges &tile_edges)
+{
+    thread_local std::vector<EdgeWeight> weights;
+    thread_local std::vector<DatasourceID> datasources;
+    thread_local std::vector<SegmentLength> lengths;
 
-    // b::g::intersection might return a line with one point if the
-    // original line was very short and coords were dupes
-    if (!clipped_line.empty() && clipped_line[0].size() == 2)
+    tile_edges.reserve(tile_edges.size() + edges.size());
+    for (const auto &edge : edges)
     {
-        if (clipped_line[0].size() == 2)
+        TileEdge tile_edge{edge,
+                           facade.GetCoordinateOfNode(edge.u),
+                           facade.GetCoordinateOfNode(edge.v),
+                           0,
+                           0,
+                           0,
+                           0,
+                           INVALID_SEGMENT_LENGTH};
+
+        if (edge.forward_packed_geometry_id != SPECIAL_EDGEID)
         {
-            for (const auto &p : clipped_line[0])
+            facade.GetUncompressedWeights(edge.forward_packed_geometry_id, weights);
+            tile_edge.forward_weight = weights[edge.fwd_segment_position];
+
+            facade.GetUncompressedDatasources(edge.forward_packed_geometry_id, datasources);
+            tile_edge.forward_datasource = datasources[edge.fwd_segment_position];
+
+            facade.GetUncompressedLengths(edge.forward_packed_geometry_id, lengths);
+            tile_edge.length = lengths[edge.fwd_segment_position];
+        }
+
+        if (edge.reverse_packed_geometry_id != SPECIAL_EDGEID)
+        {
+            facade.GetUncompressedWeights(edge.reverse_packed_geometry_id, weights);
+            BOOST_ASSERT(edge.fwd_segment_position < weights.size());
+            tile_edge.reverse_weight = weights[weights.size() - edge.fwd_segment_position - 1];
+
+            facade.GetUncompressedDatasources(edge.reverse_packed_geometry_id, datasources);
+            tile_edge.reverse_datasource =
+                datasources[datasources.size() - edge.fwd_segment_position - 1];
+
+            if (tile_edge.length == INVALID_SEGMENT_LENGTH)
             {
-                tile_line.emplace_back(p.get<0>(), p.get<1>());
+                facade.GetUncompressedLengths(edge.reverse_packed_geometry_id, lengths);
+                tile_edge.length = lengths[lengths.size() - edge.fwd_segment_position - 1];
             }
         }
-    }
 
-    return tile_line;
+        // datasets without precomputed lengths
+        if (tile_edge.length == INVALID_SEGMENT_LENGTH)
+        {
+            tile_edge.length = util::coordinate_calculation::haversineDistance(tile_edge.source,
+                                                                               tile_edge.target);
+        }
+
+        tile_edges.push_back(std::move(tile_edge));
+    }
 }
 }
 
-Status TilePlugin::HandleRequest(const api::TileParameters &parameters, std::string &pbf_buffer)
+// Finds the segments of the tile like the r-tree does, by the bounding boxes of the segments, in
+// the same order. Tiles of the TileCache::INDEX_ZOOM and above pick them from the cached tile of
+// that zoom level that contains them.
+void TilePlugin::GetTileEdges(const api::TileParameters &parameters, TileEdges &tile_edges) const
 {
-    BOOST_ASSERT(parameters.IsValid());
-
     double min_lon, min_lat, max_lon, max_lat;
 
     // Convert the z,x,y mercator tile coordinates into WGS84 lon/lat values
@@ -177,91 +283,284 @@ Status TilePlugin::HandleRequest(const api::TileParameters &parameters, std::str
     util::Coordinate southwest{util::FloatLongitude{min_lon}, util::FloatLatitude{min_lat}};
     util::Coordinate northeast{util::FloatLongitude{max_lon}, util::FloatLatitude{max_lat}};
 
-    // Fetch all the segments that are in our bounding box.
-    // This hits the OSRM StaticRTree
-    const auto edges = facade.GetEdgesInBox(southwest, northeast);
+    if (!tile_cache || parameters.z < TileCache::INDEX_ZOOM)
+    {
+        // Fetch all the segments that are in our bounding box.
+        // This hits the OSRM StaticRTree
+        detail::makeTileEdges(facade, facade.GetEdgesInBox(southwest, northeast), tile_edges);
+        return;
+    }
+
+    const unsigned shift = parameters.z - TileCache::INDEX_ZOOM;
+    const unsigned index_x = parameters.x >> shift;
+    const unsigned index_y = parameters.y >> shift;
+    const auto data_checksum = facade.GetCheckSum();
+    auto indexed_edges = tile_cache->Get(data_checksum, index_x, index_y);
+    if (!indexed_edges)
+    {
+        double index_min_lon, index_min_lat, index_max_lon, index_max_lat;
+        util::web_mercator::xyzToWGS84(index_x,
+                                       index_y,
+                                       TileCache::INDEX_ZOOM,
+                                       index_min_lon,
+                                       index_min_lat,
+                                       index_max_lon,
+                                       index_max_lat);
+        // a bit larger, since the corners of the tiles inside of it are rounded on their own
+        const util::Coordinate index_southwest{
+            util::toFixed(util::FloatLongitude{index_min_lon}) - util::FixedLongitude{2},
+            util::toFixed(util::FloatLatitude{index_min_lat}) - util::FixedLatitude{2}};
+        const util::Coordinate index_northeast{
+            util::toFixed(util::FloatLongitude{index_max_lon}) + util::FixedLongitude{2},
+            util::toFixed(util::FloatLatitude{index_max_lat}) + util::FixedLatitude{2}};
+
+        auto edges = std::make_shared<TileEdges>();
+        detail::makeTileEdges(
+            facade, facade.GetEdgesInBox(index_southwest, index_northeast), *edges);
+        indexed_edges = std::move(edges);
+        tile_cache->Add(data_checksum, index_x, index_y, indexed_edges);
+    }
+
+    const util::RectangleInt2D tile_rectangle{
+        southwest.lon, northeast.lon, southwest.lat, northeast.lat};
+    for (const auto &tile_edge : *indexed_edges)
+    {
+        const auto &source = tile_edge.source;
+        const auto &target = tile_edge.target;
+        const util::RectangleInt2D edge_rectangle{std::min(source.lon, target.lon),
+                                                  std::max(source.lon, target.lon),
+                                                  std::min(source.lat, target.lat),
+                                                  std::max(source.lat, target.lat)};
+        if (edge_rectangle.Intersects(tile_rectangle))
+        {
+            tile_edges.push_back(tile_edge);
+        }
+    }
+}
+
+Status TilePlugin::HandleRequest(const api::TileParameters &parameters, std::string &pbf_buffer)
+{
+    BOOST_ASSERT(parameters.IsValid());
+
+    // reused by the tiles a thread renders
+    thread_local TileEdges edges;
+    thread_local std::vector<std::size_t> edge_names;
+    edges.clear();
+    edge_names.clear();
+    GetTileEdges(parameters, edges);
 
     std::vector<int> used_weights;
     std::unordered_map<int, std::size_t> weight_offsets;
     uint8_t max_datasource_id = 0;
-    std::vector<std::string> names;
-    std::unordered_map<std::string, std::size_t> name_offsets;
+    // views into the names of the facade, they are only copied into the tile
+    std::vector<util::StringView> names;
+    const auto hash_name = [](const util::StringView name) {
+        return boost::hash_range(name.begin(), name.end());
+    };
+    std::unordered_map<util::StringView, std::size_t, decltype(hash_name)> name_offsets(
+        0, hash_name);
 
     // Loop over all edges once to tally up all the attributes we'll need.
     // We need to do this so that we know the attribute offsets to use
     // when we encode each feature in the tile.
-    for (const auto &edge : edges)
+    for (const auto &tile_edge : edges)
     {
-        int forward_weight = 0, reverse_weight = 0;
-        uint8_t forward_datasource = 0;
-        uint8_t reverse_datasource = 0;
-
-        if (edge.forward_packed_geometry_id != SPECIAL_EDGEID)
+        const auto &edge = tile_edge.data;
+        if (edge.forward_packed_geometry_id != SPECIAL_EDGEID &&
+            weight_offsets.find(tile_edge.forward_weight) == weight_offsets.end())
         {
-            std::vector<EdgeWeight> forward_weight_vector;
-            facade.GetUncompressedWeights(edge.forward_packed_geometry_id, forward_weight_vector);
-            forward_weight = forward_weight_vector[edge.fwd_segment_position];
-
-            std::vector<uint8_t> forward_datasource_vector;
-            facade.GetUncompressedDatasources(edge.forward_packed_geometry_id,
-                                              forward_datasource_vector);
-            forward_datasource = forward_datasource_vector[edge.fwd_segment_position];
-
-            if (weight_offsets.find(forward_weight) == weight_offsets.end())
-            {
-                used_weights.push_back(forward_weight);
-                weight_offsets[forward_weight] = used_weights.size() - 1;
-            }
+            used_weights.push_back(tile_edge.forward_weight);
+            weight_offsets[tile_edge.forward_weight] = used_weights.size() - 1;
         }
 
-        if (edge.reverse_packed_geometry_id != SPECIAL_EDGEID)
+        if (edge.reverse_packed_geometry_id != SPECIAL_EDGEID &&
+            weight_offsets.find(tile_edge.reverse_weight) == weight_offsets.end())
         {
-            std::vector<EdgeWeight> reverse_weight_vector;
-            facade.GetUncompressedWeights(edge.reverse_packed_geometry_id, reverse_weight_vector);
-
-            BOOST_ASSERT(edge.fwd_segment_position < reverse_weight_vector.size());
-
-            reverse_weight =
-                reverse_weight_vector[reverse_weight_vector.size() - edge.fwd_segment_position - 1];
-
-            if (weight_offsets.find(reverse_weight) == weight_offsets.end())
-            {
-                used_weights.push_back(reverse_weight);
-                weight_offsets[reverse_weight] = used_weights.size() - 1;
-            }
-            std::vector<uint8_t> reverse_datasource_vector;
-            facade.GetUncompressedDatasources(edge.reverse_packed_geometry_id,
-                                              reverse_datasource_vector);
-            reverse_datasource = reverse_datasource_vector[reverse_datasource_vector.size() -
-                                                           edge.fwd_segment_position - 1];
+            used_weights.push_back(tile_edge.reverse_weight);
+            weight_offsets[tile_edge.reverse_weight] = used_weights.size() - 1;
         }
         // Keep track of the highest datasource seen so that we don't write unnecessary
         // data to the layer attribute values
-        max_datasource_id = std::max(max_datasource_id, forward_datasource);
-        max_datasource_id = std::max(max_datasource_id, reverse_datasource);
+        max_datasource_id = std::max(max_datasource_id, tile_edge.forward_datasource);
+        max_datasource_id = std::max(max_datasource_id, tile_edge.reverse_datasource);
 
-        std::string name = facade.GetNameForID(edge.name_id);
+        const auto name = facade.GetNameForID(edge.name_id);
 
-        if (name_offsets.find(name) == name_offsets.end())
+        const auto name_offset = name_offsets.find(name);
+        if (name_offset == name_offsets.end())
         {
+            edge_names.push_back(names.size());
+            name_offsets.emplace(name, names.size());
             names.push_back(name);
-            name_offsets[name] = names.size() - 1;
+        }
+        else
+        {
+            edge_names.push_back(name_offset->second);
         }
     }
 
     // TODO: extract speed values for compressed and uncompressed geometries
 
     // Convert tile coordinates into mercator coordinates
+    double min_lon, min_lat, max_lon, max_lat;
     util::web_mercator::xyzToMercator(
         parameters.x, parameters.y, parameters.z, min_lon, min_lat, max_lon, max_lat);
     const detail::BBox tile_bbox{min_lon, min_lat, max_lon, max_lat};
 
-    // Protobuf serialized blocks when objects go out of scope, hence
-    // the extra scoping below.
-    protozero::pbf_writer tile_writer{pbf_buffer};
+    // The lines of the segments are projected, clipped and encoded in parallel, in chunks that
+    // each thread encodes into a buffer of its own. Features get unique ids in the order of the
+    // segments, starting at 1, so the lines come first and the ids of the chunks are counted
+    // before they are encoded. The buffers are reused by the tiles the thread renders.
+    // The workers see their own thread_local buffers, they only get these through the references.
+    thread_local std::vector<detail::SegmentFeatures> thread_features;
+    thread_local std::vector<std::string> thread_feature_chunks;
+    thread_local std::string layer_buffer;
+    const auto &segments = edges;
+    const auto &segment_names = edge_names;
+    auto &features = thread_features;
+    auto &feature_chunks = thread_feature_chunks;
+    const std::size_t number_of_chunks =
+        (segments.size() + detail::FEATURE_CHUNK_SIZE - 1) / detail::FEATURE_CHUNK_SIZE;
+    features.resize(segments.size());
+    feature_chunks.resize(number_of_chunks);
+    const auto chunk_range = [&segments](const std::size_t chunk) {
+        const auto begin = chunk * detail::FEATURE_CHUNK_SIZE;
+        return util::irange(begin, std::min(begin + detail::FEATURE_CHUNK_SIZE, segments.size()));
+    };
+    // the tally above has the offsets of all weights of enabled segments
+    const auto duration_offset = [&weight_offsets](const int weight) {
+        const auto offset = weight_offsets.find(weight);
+        return offset == weight_offsets.end() ? std::size_t{0} : offset->second;
+    };
+
+    tbb::parallel_for(std::size_t{0}, number_of_chunks, [&](const std::size_t chunk) {
+        for (const auto edge_index : chunk_range(chunk))
+        {
+            const auto &tile_edge = segments[edge_index];
+            const auto &edge = tile_edge.data;
+            auto &segment = features[edge_index];
+            const double length = tile_edge.length;
+
+            // If this is a valid forward edge, go ahead and add it to the tile
+            segment.has_forward =
+                tile_edge.forward_weight != 0 && edge.forward_segment_id.enabled &&
+                detail::coordinatesToTileLine(
+                    tile_edge.source, tile_edge.target, tile_bbox, segment.forward_line);
+            if (segment.has_forward)
+            {
+                segment.forward_speed = static_cast<std::uint32_t>(
+                    round(length / tile_edge.forward_weight * 10 * 3.6));
+            }
+
+            // Repeat the above for the coordinates reversed and using the `reverse` properties
+            segment.has_reverse =
+                tile_edge.reverse_weight != 0 && edge.reverse_segment_id.enabled &&
+                detail::coordinatesToTileLine(
+                    tile_edge.target, tile_edge.source, tile_bbox, segment.reverse_line);
+            if (segment.has_reverse)
+            {
+                segment.reverse_speed = static_cast<std::uint32_t>(
+                    round(length / tile_edge.reverse_weight * 10 * 3.6));
+            }
+        }
+    });
+
+    // Each feature gets a unique id, starting at 1
+    std::vector<unsigned> first_chunk_ids(number_of_chunks);
+    unsigned next_id = 1;
+    for (const auto chunk : util::irange<std::size_t>(0UL, number_of_chunks))
+    {
+        first_chunk_ids[chunk] = next_id;
+        for (const auto edge_index : chunk_range(chunk))
+        {
+            next_id += features[edge_index].has_forward + features[edge_index].has_reverse;
+        }
+    }
+
+    tbb::parallel_for(std::size_t{0}, number_of_chunks, [&](const std::size_t chunk) {
+        auto &chunk_buffer = feature_chunks[chunk];
+        chunk_buffer.clear();
+        protozero::pbf_writer chunk_writer(chunk_buffer);
+        unsigned id = first_chunk_ids[chunk];
+
+        const auto encode_tile_line = [&](const detail::FixedLine &tile_line,
+                                          const bool is_tiny,
+                                          const std::uint32_t speed_kmh,
+                                          const std::size_t duration,
+                                          const DatasourceID datasource,
+                                          const std::size_t name) {
+            protozero::pbf_writer feature_writer(chunk_writer, util::vector_tile::FEATURE_TAG);
+            // Field 3 is the "geometry type" field.  Value 2 is "line"
+            feature_writer.add_enum(util::vector_tile::GEOMETRY_TAG,
+                                    util::vector_tile::GEOMETRY_TYPE_LINE); // geometry type
+            // Field 1 for the feature is the "id" field.
+            feature_writer.add_uint64(util::vector_tile::ID_TAG, id++); // id
+            {
+                // When adding attributes to a feature, we have to write
+                // pairs of numbers.  The first value is the index in the
+                // keys array (written later), and the second value is the
+                // index into the "values" array (also written later).  We're
+                // not writing the actual speed or bool value here, we're saving
+                // an index into the "values" array.  This means many features
+                // can share the same value data, leading to smaller tiles.
+                protozero::packed_field_uint32 field(feature_writer,
+                                                     util::vector_tile::FEATURE_ATTRIBUTES_TAG);
+
+                field.add_element(0); // "speed" tag key offset
+                field.add_element(std::min(speed_kmh, 127u)); // save the speed value, capped at 127
+                field.add_element(1);                         // "is_small" tag key offset
+                field.add_element(128 + (is_tiny ? 0 : 1));   // is_small feature
+                field.add_element(2);                         // "datasource" tag key offset
+                field.add_element(130 + datasource);          // datasource value offset
+                field.add_element(3);                         // "duration" tag key offset
+                field.add_element(130 + max_datasource_id + 1 +
+                                  duration); // duration value offset
+                field.add_element(4);        // "name" tag key offset
+
+                field.add_element(130 + max_datasource_id + 1 + used_weights.size() +
+                                  name); // name value offset
+            }
+            {
+                // Encode the geometry for the feature
+                protozero::packed_field_uint32 geometry(
+                    feature_writer, util::vector_tile::FEATURE_GEOMETRIES_TAG);
+                std::int32_t start_x = 0;
+                std::int32_t start_y = 0;
+                detail::encodeLinestring(tile_line, geometry, start_x, start_y);
+            }
+        };
+
+        for (const auto edge_index : chunk_range(chunk))
+        {
+            const auto &tile_edge = segments[edge_index];
+            const auto &segment = features[edge_index];
+            const bool is_tiny = tile_edge.data.component.is_tiny;
+            if (segment.has_forward)
+            {
+                encode_tile_line(segment.forward_line,
+                                 is_tiny,
+                                 segment.forward_speed,
+                                 duration_offset(tile_edge.forward_weight),
+                                 tile_edge.forward_datasource,
+                                 segment_names[edge_index]);
+            }
+            if (segment.has_reverse)
+            {
+                encode_tile_line(segment.reverse_line,
+                                 is_tiny,
+                                 segment.reverse_speed,
+                                 duration_offset(tile_edge.reverse_weight),
+                                 tile_edge.reverse_datasource,
+                                 segment_names[edge_index]);
+            }
+        }
+    });
+
+    // The layer is written into a buffer of its own first, which the encoded chunks of features
+    // are appended to between the fields of the layer
+    layer_buffer.clear();
     {
-        // Add a layer object to the PBF stream.  3=='layer' from the vector tile spec (2.1)
-        protozero::pbf_writer layer_writer(tile_writer, util::vector_tile::LAYER_TAG);
+        protozero::pbf_writer layer_writer(layer_buffer);
         // TODO: don't write a layer if there are no features
 
         layer_writer.add_uint32(util::vector_tile::VERSION_TAG, 2); // version
@@ -271,168 +570,10 @@ Status TilePlugin::HandleRequest(const api::TileParameters &parameters, std::str
         // for normal vector tiles.
         layer_writer.add_uint32(util::vector_tile::EXTEND_TAG, util::vector_tile::EXTENT); // extent
 
-        // Begin the layer features block
+        // The layer features block
+        for (const auto &chunk_buffer : feature_chunks)
         {
-            // Each feature gets a unique id, starting at 1
-            unsigned id = 1;
-            for (const auto &edge : edges)
-            {
-                // Get coordinates for start/end nodes of segmet (NodeIDs u and v)
-                const auto a = facade.GetCoordinateOfNode(edge.u);
-                const auto b = facade.GetCoordinateOfNode(edge.v);
-                // Calculate the length in meters
-                const double length = osrm::util::coordinate_calculation::haversineDistance(a, b);
-
-                int forward_weight = 0;
-                int reverse_weight = 0;
-
-                uint8_t forward_datasource = 0;
-                uint8_t reverse_datasource = 0;
-
-                std::string name = facade.GetNameForID(edge.name_id);
-
-                if (edge.forward_packed_geometry_id != SPECIAL_EDGEID)
-                {
-                    std::vector<EdgeWeight> forward_weight_vector;
-                    facade.GetUncompressedWeights(edge.forward_packed_geometry_id,
-                                                  forward_weight_vector);
-                    forward_weight = forward_weight_vector[edge.fwd_segment_position];
-
-                    std::vector<uint8_t> forward_datasource_vector;
-                    facade.GetUncompressedDatasources(edge.forward_packed_geometry_id,
-                                                      forward_datasource_vector);
-                    forward_datasource = forward_datasource_vector[edge.fwd_segment_position];
-                }
-
-                if (edge.reverse_packed_geometry_id != SPECIAL_EDGEID)
-                {
-                    std::vector<EdgeWeight> reverse_weight_vector;
-                    facade.GetUncompressedWeights(edge.reverse_packed_geometry_id,
-                                                  reverse_weight_vector);
-
-                    BOOST_ASSERT(edge.fwd_segment_position < reverse_weight_vector.size());
-
-                    reverse_weight = reverse_weight_vector[reverse_weight_vector.size() -
-                                                           edge.fwd_segment_position - 1];
-
-                    std::vector<uint8_t> reverse_datasource_vector;
-                    facade.GetUncompressedDatasources(edge.reverse_packed_geometry_id,
-                                                      reverse_datasource_vector);
-                    reverse_datasource =
-                        reverse_datasource_vector[reverse_datasource_vector.size() -
-                                                  edge.fwd_segment_position - 1];
-                }
-
-                // Keep track of the highest datasource seen so that we don't write unnecessary
-                // data to the layer attribute values
-                max_datasource_id = std::max(max_datasource_id, forward_datasource);
-                max_datasource_id = std::max(max_datasource_id, reverse_datasource);
-
-                const auto encode_tile_line = [&layer_writer,
-                                               &edge,
-                                               &id,
-                                               &max_datasource_id,
-                                               &used_weights](const detail::FixedLine &tile_line,
-                                                              const std::uint32_t speed_kmh,
-                                                              const std::size_t duration,
-                                                              const DatasourceID datasource,
-                                                              const std::size_t name,
-                                                              std::int32_t &start_x,
-                                                              std::int32_t &start_y) {
-                    // Here, we save the two attributes for our feature: the speed and the
-                    // is_small
-                    // boolean.  We onl serve up speeds from 0-139, so all we do is save the
-                    // first
-                    protozero::pbf_writer feature_writer(layer_writer,
-                                                         util::vector_tile::FEATURE_TAG);
-                    // Field 3 is the "geometry type" field.  Value 2 is "line"
-                    feature_writer.add_enum(util::vector_tile::GEOMETRY_TAG,
-                                            util::vector_tile::GEOMETRY_TYPE_LINE); // geometry type
-                    // Field 1 for the feature is the "id" field.
-                    feature_writer.add_uint64(util::vector_tile::ID_TAG, id++); // id
-                    {
-                        // When adding attributes to a feature, we have to write
-                        // pairs of numbers.  The first value is the index in the
-                        // keys array (written later), and the second value is the
-                        // index into the "values" array (also written later).  We're
-                        // not writing the actual speed or bool value here, we're saving
-                        // an index into the "values" array.  This means many features
-                        // can share the same value data, leading to smaller tiles.
-                        protozero::packed_field_uint32 field(
-                            feature_writer, util::vector_tile::FEATURE_ATTRIBUTES_TAG);
-
-                        field.add_element(0); // "speed" tag key offset
-                        field.add_element(
-                            std::min(speed_kmh, 127u)); // save the speed value, capped at 127
-                        field.add_element(1);           // "is_small" tag key offset
-                        field.add_element(128 +
-                                          (edge.component.is_tiny ? 0 : 1)); // is_small feature
-                        field.add_element(2);                // "datasource" tag key offset
-                        field.add_element(130 + datasource); // datasource value offset
-                        field.add_element(3);                // "duration" tag key offset
-                        field.add_element(130 + max_datasource_id + 1 +
-                                          duration); // duration value offset
-                        field.add_element(4);        // "name" tag key offset
-
-                        field.add_element(130 + max_datasource_id + 1 + used_weights.size() +
-                                          name); // name value offset
-                    }
-                    {
-
-                        // Encode the geometry for the feature
-                        protozero::packed_field_uint32 geometry(
-                            feature_writer, util::vector_tile::FEATURE_GEOMETRIES_TAG);
-                        encodeLinestring(tile_line, geometry, start_x, start_y);
-                    }
-                };
-
-                // If this is a valid forward edge, go ahead and add it to the tile
-                if (forward_weight != 0 && edge.forward_segment_id.enabled)
-                {
-                    std::int32_t start_x = 0;
-                    std::int32_t start_y = 0;
-
-                    // Calculate the speed for this line
-                    std::uint32_t speed_kmh =
-                        static_cast<std::uint32_t>(round(length / forward_weight * 10 * 3.6));
-
-                    auto tile_line = coordinatesToTileLine(a, b, tile_bbox);
-                    if (!tile_line.empty())
-                    {
-                        encode_tile_line(tile_line,
-                                         speed_kmh,
-                                         weight_offsets[forward_weight],
-                                         forward_datasource,
-                                         name_offsets[name],
-                                         start_x,
-                                         start_y);
-                    }
-                }
-
-                // Repeat the above for the coordinates reversed and using the `reverse`
-                // properties
-                if (reverse_weight != 0 && edge.reverse_segment_id.enabled)
-                {
-                    std::int32_t start_x = 0;
-                    std::int32_t start_y = 0;
-
-                    // Calculate the speed for this line
-                    std::uint32_t speed_kmh =
-                        static_cast<std::uint32_t>(round(length / reverse_weight * 10 * 3.6));
-
-                    auto tile_line = coordinatesToTileLine(b, a, tile_bbox);
-                    if (!tile_line.empty())
-                    {
-                        encode_tile_line(tile_line,
-                                         speed_kmh,
-                                         weight_offsets[reverse_weight],
-                                         reverse_datasource,
-                                         name_offsets[name],
-                                         start_x,
-                                         start_y);
-                    }
-                }
-            }
+            layer_buffer.append(chunk_buffer);
         }
 
         // Field id 3 is the "keys" attribute
@@ -469,8 +610,10 @@ Status TilePlugin::HandleRequest(const api::TileParameters &parameters, std::str
             // Writing field type 4 == variant type
             protozero::pbf_writer values_writer(layer_writer, util::vector_tile::VARIANT_TAG);
             // Attribute value 1 == string type
+            const auto datasource_name = facade.GetDatasourceName(i);
             values_writer.add_string(util::vector_tile::VARIANT_TYPE_STRING,
-                                     facade.GetDatasourceName(i));
+                                     datasource_name.data(),
+                                     datasource_name.size());
         }
         for (auto weight : used_weights)
         {
@@ -487,10 +630,15 @@ Status TilePlugin::HandleRequest(const api::TileParameters &parameters, std::str
             // Writing field type 4 == variant type
             protozero::pbf_writer values_writer(layer_writer, util::vector_tile::VARIANT_TAG);
             // Attribute value 1 == string type
-            values_writer.add_string(util::vector_tile::VARIANT_TYPE_STRING, name);
+            values_writer.add_string(
+                util::vector_tile::VARIANT_TYPE_STRING, name.data(), name.size());
         }
     }
 
+    // Add a layer object to the PBF stream.  3=='layer' from the vector tile spec (2.1)
+    protozero::pbf_writer tile_writer{pbf_buffer};
+    tile_writer.add_message(util::vector_tile::LAYER_TAG, layer_buffer);
+
     return Status::Ok;
 }
 }
@@ -4,16 +4,24 @@
 
 #include "engine/api/trip_api.hpp"
 #include "engine/api/trip_parameters.hpp"
-#include "engine/trip/trip_brute_force.hpp"
+#include "engine/search_engine_data.hpp"
+#include "engine/trip/trip_clustering.hpp"
 #include "engine/trip/trip_farthest_insertion.hpp"
+#include "engine/trip/trip_held_karp.hpp"
+#include "engine/trip/trip_local_search.hpp"
 #include "engine/trip/trip_nearest_neighbour.hpp"
 #include "util/dist_table_wrapper.hpp" // to access the dist table more easily
 #include "util/json_container.hpp"
 #include "util/matrix_graph_wrapper.hpp" // wrapper to use tarjan scc on dist table
+#include "util/query_metrics.hpp"
 
 #include <boost/assert.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <iterator>
 #include <memory>
@@ -114,14 +122,24 @@ SCC_Component SplitUnaccessibleLocations(const std::size_t number_of_locations,
     return SCC_Component(std::move(components), std::move(range));
 }
 
-InternalRouteResult TripPlugin::ComputeRoute(const std::vector<PhantomNode> &snapped_phantoms,
-                                             const std::vector<NodeID> &trip)
+InternalRouteResult
+TripPlugin::ComputeRoute(const std::vector<PhantomNode> &snapped_phantoms,
+                         const std::vector<NodeID> &trip,
+                         const util::DistTableWrapper<EdgeWeight> &result_table,
+                         const routing_algorithms::ManyToManySearchSpaces &search_spaces)
 {
     InternalRouteResult min_route;
     // given he final trip, compute total duration and return the route and location permutation
     PhantomNodes viapoint;
     const auto start = std::begin(trip);
     const auto end = std::end(trip);
+
+    // the legs are the paths that the duration table found, they only need to be unpacked
+    std::vector<NodeID> total_packed_path;
+    std::vector<std::size_t> packed_leg_begin;
+    EdgeWeight total_duration = 0;
+    bool has_packed_paths = true;
+
     // computes a roundtrip from the nodes in trip
     for (auto it = start; it != end; ++it)
     {
@@ -131,15 +149,224 @@ InternalRouteResult TripPlugin::ComputeRoute(const std::vector<PhantomNode> &sna
 
         viapoint = PhantomNodes{snapped_phantoms[from_node], snapped_phantoms[to_node]};
         min_route.segment_end_coordinates.emplace_back(viapoint);
+
+        packed_leg_begin.push_back(total_packed_path.size());
+        has_packed_paths =
+            has_packed_paths && search_spaces.GetPackedPath(from_node, to_node, total_packed_path);
+        total_duration += result_table(from_node, to_node);
+        // the entries include the arrival penalty of the traffic overlay, which the next leg
+        // adds again when it leaves the location
+        if (has_packed_paths && std::next(it) != end)
+        {
+            total_duration -= shortest_path.GetArrivalTrafficPenalty(total_packed_path.back());
+        }
     }
     BOOST_ASSERT(min_route.segment_end_coordinates.size() == trip.size());
 
-    shortest_path(min_route.segment_end_coordinates, {false}, min_route);
+    if (has_packed_paths)
+    {
+        packed_leg_begin.push_back(total_packed_path.size());
+        shortest_path.UnpackLegs(min_route.segment_end_coordinates,
+                                 total_packed_path,
+                                 packed_leg_begin,
+                                 total_duration,
+                                 min_route);
+    }
+    else
+    {
+        // legs that need a loop at their meeting node, or tables without search spaces
+        shortest_path(min_route.segment_end_coordinates, {false}, min_route);
+    }
 
     BOOST_ASSERT_MSG(min_route.shortest_path_length < INVALID_EDGE_WEIGHT, "unroutable route");
     return min_route;
 }
 
+InternalRouteResult TripPlugin::ComputeRoute(const std::vector<PhantomNode> &snapped_phantoms,
+                                             const std::vector<NodeID> &trip)
+{
+    InternalRouteResult route;
+    for (auto it = trip.begin(); it != trip.end(); ++it)
+    {
+        const auto to_node = std::next(it) != trip.end() ? *std::next(it) : trip.front();
+        route.segment_end_coordinates.push_back(
+            PhantomNodes{snapped_phantoms[*it], snapped_phantoms[to_node]});
+    }
+    shortest_path(route.segment_end_coordinates, {false}, route);
+
+    BOOST_ASSERT_MSG(route.shortest_path_length < INVALID_EDGE_WEIGHT, "unroutable route");
+    return route;
+}
+
+bool TripPlugin::ComputeTable(const std::vector<PhantomNode> &snapped_phantoms,
+                              const std::vector<NodeID> &locations,
+                              std::vector<EdgeWeight> &table) const
+{
+    const std::vector<std::size_t> indices(locations.begin(), locations.end());
+    table = duration_table(snapped_phantoms, indices, indices);
+    return table.size() == locations.size() * locations.size() &&
+           std::find(table.begin(), table.end(), INVALID_EDGE_WEIGHT) == table.end();
+}
+
+// The locations are split into clusters of up to trip::CLUSTER_MAX_LOCATIONS nearby locations.
+// A round trip through the locations at the centers of the clusters gives their order, and every
+// cluster is passed on the shortest path between the locations closest to the clusters before
+// and after it. The paths are computed exactly from the table of their cluster. At last the
+// second half of every cluster and the first half of the next one are reordered between their
+// ends from their own table, which smoothes the seams between the paths.
+//
+// Only the tables of the clusters, of their centers and of the seams are computed, so the trip
+// needs a fraction of the searches of the full table. The clusters and the seams are computed
+// in parallel.
+bool TripPlugin::ComputeClusteredTrip(const std::vector<PhantomNode> &snapped_phantoms,
+                                      std::vector<NodeID> &trip)
+{
+    std::vector<util::Coordinate> coordinates;
+    coordinates.reserve(snapped_phantoms.size());
+    for (const auto &phantom : snapped_phantoms)
+    {
+        coordinates.push_back(phantom.location);
+    }
+
+    auto clusters = trip::ClusterLocations(coordinates, trip::CLUSTER_MAX_LOCATIONS);
+    BOOST_ASSERT(clusters.size() > 1);
+
+    // the order of the clusters is the round trip through their centers
+    std::vector<NodeID> centers;
+    for (const auto &cluster : clusters)
+    {
+        centers.push_back(trip::GetClusterCenter(cluster, coordinates));
+    }
+    std::vector<EdgeWeight> center_durations;
+    if (!ComputeTable(snapped_phantoms, centers, center_durations))
+    {
+        return false;
+    }
+    const util::DistTableWrapper<EdgeWeight> center_table(std::move(center_durations),
+                                                          centers.size());
+    std::vector<NodeID> center_ids(centers.size());
+    std::iota(center_ids.begin(), center_ids.end(), 0);
+    std::vector<NodeID> cluster_order;
+    if (centers.size() <= trip::HELD_KARP_MAX_LOCATIONS)
+    {
+        cluster_order =
+            trip::HeldKarpTrip(center_ids.begin(), center_ids.end(), centers.size(), center_table);
+    }
+    else
+    {
+        cluster_order = trip::FarthestInsertionTrip(
+            center_ids.begin(), center_ids.end(), centers.size(), center_table);
+        trip::ImproveTrip(cluster_order, center_table);
+    }
+    std::vector<std::vector<NodeID>> ordered_clusters;
+    ordered_clusters.reserve(clusters.size());
+    for (const auto cluster : cluster_order)
+    {
+        ordered_clusters.push_back(std::move(clusters[cluster]));
+    }
+    const auto ends = trip::GetClusterEnds(ordered_clusters, coordinates);
+
+    // every cluster is searched on heaps checked out of the pool of the query, with its traffic
+    // overlay
+    const auto options = SearchEngineData::GetQueryControl();
+    const auto cell_metric = SearchEngineData::GetCellMetric();
+    const auto overlay = SearchEngineData::GetTrafficOverlay();
+    auto &heap_pool = SearchEngineData::GetHeapPool();
+    std::atomic<bool> is_connected{true};
+    std::vector<std::vector<NodeID>> paths(ordered_clusters.size());
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, ordered_clusters.size(), 1),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            const SearchEngineData::ScopedQueryControl control(options);
+            const SearchEngineData::ScopedCellMetric metric(cell_metric);
+            const SearchEngineData::ScopedTrafficOverlay traffic(overlay);
+            const SearchEngineData::ScopedHeaps heaps(heap_pool);
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                const auto &cluster = ordered_clusters[index];
+                std::vector<EdgeWeight> durations;
+                if (!ComputeTable(snapped_phantoms, cluster, durations))
+                {
+                    is_connected = false;
+                    return;
+                }
+                const util::DistTableWrapper<EdgeWeight> table(std::move(durations),
+                                                               cluster.size());
+                // the path runs over the positions of the locations in the cluster
+                const auto position = [&](const NodeID location) {
+                    return static_cast<NodeID>(
+                        std::find(cluster.begin(), cluster.end(), location) - cluster.begin());
+                };
+                std::vector<NodeID> positions(cluster.size());
+                std::iota(positions.begin(), positions.end(), 0);
+                const auto path = trip::OpenPathTrip(
+                    positions, position(ends[index].first), position(ends[index].second), table);
+                for (const auto path_position : path)
+                {
+                    paths[index].push_back(cluster[path_position]);
+                }
+            }
+        });
+    if (!is_connected)
+    {
+        return false;
+    }
+
+    trip.clear();
+    std::vector<std::size_t> path_begin;
+    for (const auto &path : paths)
+    {
+        path_begin.push_back(trip.size());
+        trip.insert(trip.end(), path.begin(), path.end());
+    }
+    BOOST_ASSERT(trip.size() == snapped_phantoms.size());
+
+    // The seams get the second half of their cluster and the first half of the next one, so
+    // they don't overlap. Their ends stay in place and the locations between them are reordered.
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, paths.size(), 1),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            const SearchEngineData::ScopedQueryControl control(options);
+            const SearchEngineData::ScopedCellMetric metric(cell_metric);
+            const SearchEngineData::ScopedTrafficOverlay traffic(overlay);
+            const SearchEngineData::ScopedHeaps heaps(heap_pool);
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                const auto next_index = (index + 1) % paths.size();
+                const auto seam_begin =
+                    path_begin[index] + paths[index].size() - paths[index].size() / 2;
+                const auto seam_size = paths[index].size() / 2 + paths[next_index].size() / 2;
+                if (seam_size < 4)
+                {
+                    continue;
+                }
+
+                std::vector<std::size_t> seam_positions;
+                std::vector<NodeID> seam;
+                for (std::size_t offset = 0; offset < seam_size; ++offset)
+                {
+                    seam_positions.push_back((seam_begin + offset) % trip.size());
+                    seam.push_back(trip[seam_positions.back()]);
+                }
+                std::vector<EdgeWeight> durations;
+                if (!ComputeTable(snapped_phantoms, seam, durations))
+                {
+                    continue;
+                }
+                const util::DistTableWrapper<EdgeWeight> table(std::move(durations), seam_size);
+                std::vector<NodeID> positions(seam_size);
+                std::iota(positions.begin(), positions.end(), 0);
+                const auto path = trip::OpenPathTrip(positions, 0, seam_size - 1, table);
+                for (std::size_t offset = 0; offset < seam_size; ++offset)
+                {
+                    trip[seam_positions[offset]] = seam[path[offset]];
+                }
+            }
+        });
+
+    return true;
+}
+
 Status TripPlugin::HandleRequest(const api::TripParameters &parameters,
                                  util::json::Object &json_result)
 {
@@ -152,6 +379,20 @@ Status TripPlugin::HandleRequest(const api::TripParameters &parameters,
         return Error("TooBig", "Too many trip coordinates", json_result);
     }
 
+    // the matrix of the durations between all coordinates, large trips only need it if some of
+    // their locations can't reach each other
+    const bool is_large_trip = large_trip_locations > 0 &&
+                               parameters.coordinates.size() > large_trip_locations &&
+                               parameters.coordinates.size() > trip::CLUSTER_MAX_LOCATIONS;
+    const auto reserve_table_memory = [&] {
+        return SearchEngineData::ReserveQueryMemory(
+            parameters.coordinates.size() * parameters.coordinates.size() * sizeof(EdgeWeight));
+    };
+    if (!is_large_trip && !reserve_table_memory())
+    {
+        return Error("TooBig", "Trip needs more memory than a query may use", json_result);
+    }
+
     if (!CheckAllCoordinates(parameters.coordinates))
     {
         return Error("InvalidValue", "Invalid coordinate value.", json_result);
@@ -171,16 +412,36 @@ Status TripPlugin::HandleRequest(const api::TripParameters &parameters,
 
     const auto number_of_locations = snapped_phantoms.size();
 
-    // compute the duration table of all phantom nodes
+    // the duration table, the trips and their routes are all part of the search
+    const util::QueryMetrics::ScopedPhase search(util::QueryMetrics::Phase::Search);
+
+    if (is_large_trip)
+    {
+        std::vector<NodeID> trip;
+        if (ComputeClusteredTrip(snapped_phantoms, trip))
+        {
+            const std::vector<InternalRouteResult> routes{ComputeRoute(snapped_phantoms, trip)};
+            api::TripAPI trip_api{BasePlugin::facade, parameters};
+            trip_api.MakeResponse({trip}, routes, snapped_phantoms, json_result);
+            return Status::Ok;
+        }
+        // the trips of the components of locations that reach each other need the full table
+        if (!reserve_table_memory())
+        {
+            return Error("TooBig", "Trip needs more memory than a query may use", json_result);
+        }
+    }
+
+    // compute the duration table of all phantom nodes, its search spaces give the routes
+    routing_algorithms::ManyToManySearchSpaces search_spaces;
     const auto result_table = util::DistTableWrapper<EdgeWeight>(
-        duration_table(snapped_phantoms, {}, {}), number_of_locations);
+        duration_table(snapped_phantoms, {}, {}, false, &search_spaces), number_of_locations);
 
     if (result_table.size() == 0)
     {
         return Status::Error;
     }
 
-    const constexpr std::size_t BF_MAX_FEASABLE = 10;
     BOOST_ASSERT_MSG(result_table.size() == number_of_locations * number_of_locations,
                      "Distance Table has wrong size");
 
@@ -203,15 +464,16 @@ Status TripPlugin::HandleRequest(const api::TripParameters &parameters,
         if (component_size > 1)
         {
 
-            if (component_size < BF_MAX_FEASABLE)
+            if (component_size <= trip::HELD_KARP_MAX_LOCATIONS)
             {
                 scc_route =
-                    trip::BruteForceTrip(route_begin, route_end, number_of_locations, result_table);
+                    trip::HeldKarpTrip(route_begin, route_end, number_of_locations, result_table);
             }
             else
             {
                 scc_route = trip::FarthestInsertionTrip(
                     route_begin, route_end, number_of_locations, result_table);
+                trip::ImproveTrip(scc_route, result_table);
             }
         }
         else
@@ -231,7 +493,7 @@ Status TripPlugin::HandleRequest(const api::TripParameters &parameters,
     routes.reserve(trips.size());
     for (const auto &trip : trips)
     {
-        routes.push_back(ComputeRoute(snapped_phantoms, trip));
+        routes.push_back(ComputeRoute(snapped_phantoms, trip, result_table, search_spaces));
     }
 
     api::TripAPI trip_api{BasePlugin::facade, parameters};
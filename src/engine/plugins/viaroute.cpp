@@ -1,12 +1,15 @@
 #include "engine/plugins/viaroute.hpp"
 #include "engine/api/route_api.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
+#include "engine/search_engine_data.hpp"
 #include "engine/status.hpp"
 
 #include "util/for_each_pair.hpp"
 #include "util/integer_range.hpp"
 #include "util/json_container.hpp"
+#include "util/query_metrics.hpp"
 
+#include <cmath>
 #include <cstdlib>
 
 #include <algorithm>
@@ -21,14 +24,52 @@ namespace engine
 namespace plugins
 {
 
-ViaRoutePlugin::ViaRoutePlugin(datafacade::BaseDataFacade &facade_, int max_locations_viaroute)
-    : BasePlugin(facade_), shortest_path(&facade_, heaps), alternative_path(&facade_, heaps),
-      direct_shortest_path(&facade_, heaps), max_locations_viaroute(max_locations_viaroute)
+ViaRoutePlugin::ViaRoutePlugin(datafacade::BaseDataFacade &facade_,
+                               int max_locations_viaroute,
+                               int max_pairs_route_batch,
+                               UnpackingCache *unpacking_cache,
+                               const bool use_stall_on_demand,
+                               SnappingCache *snapping_cache,
+                               const bool use_parallel_route_legs,
+                               const std::size_t parallel_unpacking_length)
+    : BasePlugin(facade_, snapping_cache), shortest_path(&facade_, heaps, unpacking_cache),
+      alternative_path(&facade_, heaps, unpacking_cache),
+      direct_shortest_path(&facade_, heaps, unpacking_cache),
+      max_locations_viaroute(max_locations_viaroute),
+      max_pairs_route_batch(max_pairs_route_batch),
+      use_parallel_route_legs(use_parallel_route_legs)
 {
+    if (use_stall_on_demand)
+    {
+        shortest_path.SetStallingMode(routing_algorithms::StallingMode::OnDemand);
+        direct_shortest_path.SetStallingMode(routing_algorithms::StallingMode::OnDemand);
+    }
+    shortest_path.SetParallelUnpackingLength(parallel_unpacking_length);
+    alternative_path.SetParallelUnpackingLength(parallel_unpacking_length);
+    direct_shortest_path.SetParallelUnpackingLength(parallel_unpacking_length);
 }
 
 Status ViaRoutePlugin::HandleRequest(const api::RouteParameters &route_parameters,
-                                     util::json::Object &json_result)
+                                     util::json::Object &result)
+{
+    return HandleRequestImpl(route_parameters, result);
+}
+
+Status ViaRoutePlugin::HandleRequest(const api::RouteParameters &route_parameters,
+                                     api::RouteResult &result)
+{
+    // the summaries only need the weights of the paths, nothing of the guidance
+    auto summary_parameters = route_parameters;
+    summary_parameters.steps = false;
+    summary_parameters.annotations = false;
+    summary_parameters.overview = api::RouteParameters::OverviewType::False;
+    return HandleRequestImpl(summary_parameters, result);
+}
+
+// Both results come from the same query, only the response is made differently
+template <typename ResultT>
+Status ViaRoutePlugin::HandleRequestImpl(const api::RouteParameters &route_parameters,
+                                         ResultT &result)
 {
     BOOST_ASSERT(route_parameters.IsValid());
 
@@ -39,12 +80,12 @@ Status ViaRoutePlugin::HandleRequest(const api::RouteParameters &route_parameter
                      "Number of entries " + std::to_string(route_parameters.coordinates.size()) +
                          " is higher than current maximum (" +
                          std::to_string(max_locations_viaroute) + ")",
-                     json_result);
+                     result);
     }
 
     if (!CheckAllCoordinates(route_parameters.coordinates))
     {
-        return Error("InvalidValue", "Invalid coordinate value.", json_result);
+        return Error("InvalidValue", "Invalid coordinate value.", result);
     }
 
     auto phantom_node_pairs = GetPhantomNodes(route_parameters);
@@ -53,17 +94,38 @@ Status ViaRoutePlugin::HandleRequest(const api::RouteParameters &route_parameter
         return Error("NoSegment",
                      std::string("Could not find a matching segment for coordinate ") +
                          std::to_string(phantom_node_pairs.size()),
-                     json_result);
+                     result);
     }
     BOOST_ASSERT(phantom_node_pairs.size() == route_parameters.coordinates.size());
 
     auto snapped_phantoms = SnapPhantomNodes(phantom_node_pairs);
 
+    InternalRouteResult raw_route;
+    ComputeRoute(route_parameters, snapped_phantoms, raw_route);
+
+    // we can only know this after the fact, different SCC ids still
+    // allow for connection in one direction.
+    if (raw_route.is_valid())
+    {
+        api::RouteAPI route_api{BasePlugin::facade, route_parameters};
+        route_api.MakeResponse(raw_route, result);
+    }
+    else
+    {
+        return NoRouteError(snapped_phantoms, result);
+    }
+
+    return Status::Ok;
+}
+
+void ViaRoutePlugin::ComputeRoute(const api::RouteParameters &route_parameters,
+                                  const std::vector<PhantomNode> &snapped_phantoms,
+                                  InternalRouteResult &raw_route)
+{
     const bool continue_straight_at_waypoint = route_parameters.continue_straight
                                                    ? *route_parameters.continue_straight
                                                    : facade.GetContinueStraightDefault();
 
-    InternalRouteResult raw_route;
     auto build_phantom_pairs = [&raw_route, continue_straight_at_waypoint](
         const PhantomNode &first_node, const PhantomNode &second_node) {
         raw_route.segment_end_coordinates.push_back(PhantomNodes{first_node, second_node});
@@ -83,49 +145,159 @@ Status ViaRoutePlugin::HandleRequest(const api::RouteParameters &route_parameter
     };
     util::for_each_pair(snapped_phantoms, build_phantom_pairs);
 
+    // the searches would exhaust the search spaces of a leg without a path before giving up
+    if (std::any_of(raw_route.segment_end_coordinates.begin(),
+                    raw_route.segment_end_coordinates.end(),
+                    [this](const PhantomNodes &leg) {
+                        return facade.IsUnreachable(leg.source_phantom, leg.target_phantom);
+                    }))
+    {
+        return;
+    }
+
+    // only the steps need the guidance data of the path
+    const auto unpack_mode = route_parameters.steps ? routing_algorithms::PathUnpackMode::Full
+                             : route_parameters.IsSummaryOnly()
+                                 ? routing_algorithms::PathUnpackMode::Weights
+                                 : routing_algorithms::PathUnpackMode::Geometry;
+
+    const util::QueryMetrics::ScopedPhase search(util::QueryMetrics::Phase::Search);
     if (1 == raw_route.segment_end_coordinates.size())
     {
-        if (route_parameters.alternatives && facade.GetCoreSize() == 0)
+        // the search of the alternatives doesn't apply the traffic overlay and only runs on
+        // the CH graph
+        if (route_parameters.alternatives && facade.GetCoreSize() == 0 &&
+            !SearchEngineData::GetTrafficOverlay() && !facade.HasMultiLevelData())
         {
-            alternative_path(raw_route.segment_end_coordinates.front(), raw_route);
+            alternative_path(raw_route.segment_end_coordinates.front(),
+                             raw_route,
+                             route_parameters.number_of_alternatives);
         }
         else
         {
-            direct_shortest_path(raw_route.segment_end_coordinates, raw_route);
+            direct_shortest_path(raw_route.segment_end_coordinates,
+                                 raw_route,
+                                 route_parameters.IsSummaryOnly(),
+                                 unpack_mode);
         }
     }
     else
     {
-        shortest_path(
-            raw_route.segment_end_coordinates, route_parameters.continue_straight, raw_route);
+        shortest_path(raw_route.segment_end_coordinates,
+                      route_parameters.continue_straight,
+                      raw_route,
+                      use_parallel_route_legs,
+                      unpack_mode);
     }
+}
 
-    // we can only know this after the fact, different SCC ids still
-    // allow for connection in one direction.
-    if (raw_route.is_valid())
+template <typename ResultT>
+Status ViaRoutePlugin::NoRouteError(const std::vector<PhantomNode> &snapped_phantoms,
+                                    ResultT &json_result) const
+{
+    auto first_component_id = snapped_phantoms.front().component.id;
+    auto not_in_same_component = std::any_of(snapped_phantoms.begin(),
+                                             snapped_phantoms.end(),
+                                             [first_component_id](const PhantomNode &node) {
+                                                 return node.component.id != first_component_id;
+                                             });
+
+    if (not_in_same_component)
     {
-        api::RouteAPI route_api{BasePlugin::facade, route_parameters};
-        route_api.MakeResponse(raw_route, json_result);
+        return Error("NoRoute", "Impossible route between points", json_result);
     }
     else
     {
-        auto first_component_id = snapped_phantoms.front().component.id;
-        auto not_in_same_component = std::any_of(snapped_phantoms.begin(),
-                                                 snapped_phantoms.end(),
-                                                 [first_component_id](const PhantomNode &node) {
-                                                     return node.component.id != first_component_id;
-                                                 });
+        return Error("NoRoute", "No route found between points", json_result);
+    }
+}
 
-        if (not_in_same_component)
+Status ViaRoutePlugin::HandleRequest(const api::RouteBatchParameters &batch_parameters,
+                                     util::json::Object &json_result)
+{
+    BOOST_ASSERT(batch_parameters.IsValid());
+
+    const auto number_of_pairs = batch_parameters.coordinates.size() / 2;
+    if (max_pairs_route_batch > 0 && (static_cast<int>(number_of_pairs) > max_pairs_route_batch))
+    {
+        return Error("TooBig",
+                     "Number of pairs " + std::to_string(number_of_pairs) +
+                         " is higher than current maximum (" +
+                         std::to_string(max_pairs_route_batch) + ")",
+                     json_result);
+    }
+
+    if (!CheckAllCoordinates(batch_parameters.coordinates))
+    {
+        return Error("InvalidValue", "Invalid coordinate value.", json_result);
+    }
+
+    auto phantom_node_pairs = GetPhantomNodes(batch_parameters);
+    if (phantom_node_pairs.size() != batch_parameters.coordinates.size())
+    {
+        return Error("NoSegment",
+                     std::string("Could not find a matching segment for coordinate ") +
+                         std::to_string(phantom_node_pairs.size()),
+                     json_result);
+    }
+
+    // Every pair gets the options of the batch but only its own two coordinates, so that each
+    // result looks exactly like the response of a single route request. Summaries don't need
+    // anything but the packed path.
+    api::RouteParameters pair_parameters;
+    if (!batch_parameters.summary)
+    {
+        pair_parameters.steps = batch_parameters.steps;
+        pair_parameters.annotations = batch_parameters.annotations;
+        pair_parameters.overview = batch_parameters.overview;
+    }
+    else
+    {
+        pair_parameters.overview = api::RouteParameters::OverviewType::False;
+    }
+    pair_parameters.geometries = batch_parameters.geometries;
+    pair_parameters.continue_straight = batch_parameters.continue_straight;
+    pair_parameters.raw_json = batch_parameters.raw_json;
+    pair_parameters.coordinates.resize(2);
+
+    util::json::Array results;
+    results.values.reserve(number_of_pairs);
+    for (const auto pair_index : util::irange<std::size_t>(0UL, number_of_pairs))
+    {
+        const auto source_index = 2 * pair_index;
+        const auto target_index = source_index + 1;
+        const auto snapped_phantoms = SnapPhantomNodes(
+            {phantom_node_pairs[source_index], phantom_node_pairs[target_index]});
+
+        InternalRouteResult raw_route;
+        ComputeRoute(pair_parameters, snapped_phantoms, raw_route);
+
+        util::json::Object pair_result;
+        if (!raw_route.is_valid())
+        {
+            NoRouteError(snapped_phantoms, pair_result);
+        }
+        else if (batch_parameters.summary)
         {
-            return Error("NoRoute", "Impossible route between points", json_result);
+            BOOST_ASSERT(raw_route.packed_leg_distances.size() == 1);
+            const auto distance = raw_route.packed_leg_distances.front();
+            pair_result.values["code"] = "Ok";
+            pair_result.values["distance"] = std::round(distance * 10) / 10.;
+            pair_result.values["duration"] = raw_route.shortest_path_length / 10.;
         }
         else
         {
-            return Error("NoRoute", "No route found between points", json_result);
+            pair_parameters.coordinates[0] = batch_parameters.coordinates[source_index];
+            pair_parameters.coordinates[1] = batch_parameters.coordinates[target_index];
+            api::RouteAPI route_api{BasePlugin::facade, pair_parameters};
+            route_api.MakeResponse(raw_route, pair_result);
         }
+        results.values.push_back(std::move(pair_result));
     }
 
+    json_result.values["code"] = "Ok";
+    json_result.values["results"] = std::move(results);
+
     return Status::Ok;
 }
 }
@@ -1,10 +1,10 @@
 #include "engine/polyline_compressor.hpp"
 
-#include <algorithm>
 #include <boost/assert.hpp>
-#include <cmath>
+
 #include <cstddef>
-#include <cstdlib>
+#include <cstdint>
+#include <iterator>
 
 namespace osrm
 {
@@ -13,81 +13,100 @@ namespace engine
 namespace /*detail*/ // anonymous to keep TU local
 {
 
-std::string encode(int number_to_encode)
+// Number of fixed point steps of a util::Coordinate per step of the polyline
+template <unsigned PRECISION> constexpr std::int32_t coordinateStepsPerPolylineStep()
 {
-    std::string output;
-    while (number_to_encode >= 0x20)
-    {
-        const int next_value = (0x20 | (number_to_encode & 0x1f)) + 63;
-        output += static_cast<char>(next_value);
-        number_to_encode >>= 5;
-    }
-
-    number_to_encode += 63;
-    output += static_cast<char>(number_to_encode);
-    return output;
+    return static_cast<std::int32_t>(COORDINATE_PRECISION) / PRECISION;
 }
 
-std::string encode(std::vector<int> &numbers)
+// Rounds half away from zero like std::round, but in integers, so the compiler can vectorize the
+// loops that call it
+template <unsigned PRECISION> std::int32_t toPolyline(const std::int32_t fixed)
 {
-    std::string output;
-    for (auto &number : numbers)
+    constexpr std::int32_t factor = coordinateStepsPerPolylineStep<PRECISION>();
+    static_assert(factor * static_cast<double>(PRECISION) == COORDINATE_PRECISION,
+                  "the polyline precision has to divide the coordinate precision");
+    if (factor == 1)
     {
-        bool isNegative = number < 0;
+        return fixed;
+    }
+    return (fixed + (fixed < 0 ? -factor / 2 : factor / 2)) / factor;
+}
 
-        if (isNegative)
-        {
-            const unsigned binary = std::llabs(number);
-            const unsigned twos = (~binary) + 1u;
-            number = twos;
-        }
+// The sign goes into the lowest bit, negative numbers are inverted
+std::uint32_t zigzag(const std::int32_t number)
+{
+    const std::uint32_t shifted = static_cast<std::uint32_t>(number) << 1;
+    return number < 0 ? ~shifted : shifted;
+}
 
-        number <<= 1u;
+// Number of characters for the five bit chunks of a number
+std::size_t encodedLength(const std::uint32_t number)
+{
+    return 1 + (number >= 1u << 5) + (number >= 1u << 10) + (number >= 1u << 15) +
+           (number >= 1u << 20) + (number >= 1u << 25) + (number >= 1u << 30);
+}
 
-        if (isNegative)
-        {
-            number = ~number;
-        }
-    }
-    for (const int number : numbers)
+char *encode(std::uint32_t number, char *output)
+{
+    while (number >= 0x20)
     {
-        output += encode(number);
+        *output++ = static_cast<char>((0x20 | (number & 0x1f)) + 63);
+        number >>= 5;
     }
+    *output++ = static_cast<char>(number + 63);
     return output;
 }
 } // anonymous ns
 
+template <unsigned PRECISION>
 std::string encodePolyline(CoordVectorForwardIter begin, CoordVectorForwardIter end)
 {
-    auto size = std::distance(begin, end);
+    const std::size_t size = std::distance(begin, end);
     if (size == 0)
     {
         return {};
     }
 
-    std::vector<int> delta_numbers;
-    BOOST_ASSERT(size > 0);
-    delta_numbers.reserve((size - 1) * 2);
-    int current_lat = 0;
-    int current_lon = 0;
-    std::for_each(
-        begin, end, [&delta_numbers, &current_lat, &current_lon](const util::Coordinate loc) {
-            const int lat_diff =
-                std::round(static_cast<int>(loc.lat) * detail::COORDINATE_TO_POLYLINE) -
-                current_lat;
-            const int lon_diff =
-                std::round(static_cast<int>(loc.lon) * detail::COORDINATE_TO_POLYLINE) -
-                current_lon;
-            delta_numbers.emplace_back(lat_diff);
-            delta_numbers.emplace_back(lon_diff);
-            current_lat += lat_diff;
-            current_lon += lon_diff;
-        });
-    return encode(delta_numbers);
+    // The differences of latitude and longitude to the previous coordinate. Computing both
+    // sides of a difference again is cheaper than a second buffer and keeps the loop free of
+    // dependencies between iterations.
+    std::vector<std::uint32_t> numbers(2 * size);
+    numbers[0] = zigzag(toPolyline<PRECISION>(static_cast<std::int32_t>(begin->lat)));
+    numbers[1] = zigzag(toPolyline<PRECISION>(static_cast<std::int32_t>(begin->lon)));
+    for (std::size_t index = 1; index < size; ++index)
+    {
+        const util::Coordinate previous = begin[index - 1];
+        const util::Coordinate current = begin[index];
+        numbers[2 * index] =
+            zigzag(toPolyline<PRECISION>(static_cast<std::int32_t>(current.lat)) -
+                   toPolyline<PRECISION>(static_cast<std::int32_t>(previous.lat)));
+        numbers[2 * index + 1] =
+            zigzag(toPolyline<PRECISION>(static_cast<std::int32_t>(current.lon)) -
+                   toPolyline<PRECISION>(static_cast<std::int32_t>(previous.lon)));
+    }
+
+    std::size_t length = 0;
+    for (const auto number : numbers)
+    {
+        length += encodedLength(number);
+    }
+
+    std::string output(length, '\0');
+    char *position = &output[0];
+    for (const auto number : numbers)
+    {
+        position = encode(number, position);
+    }
+    BOOST_ASSERT(position == &output[0] + length);
+    return output;
 }
 
+template <unsigned PRECISION>
 std::vector<util::Coordinate> decodePolyline(const std::string &geometry_string)
 {
+    constexpr std::int32_t factor = coordinateStepsPerPolylineStep<PRECISION>();
+
     std::vector<util::Coordinate> new_coordinates;
     int index = 0, len = geometry_string.size();
     int lat = 0, lng = 0;
@@ -116,14 +135,19 @@ std::vector<util::Coordinate> decodePolyline(const std::string &geometry_string)
         lng += dlng;
 
         util::Coordinate p;
-        p.lat =
-            util::FixedLatitude{static_cast<std::int32_t>(lat * detail::POLYLINE_TO_COORDINATE)};
-        p.lon =
-            util::FixedLongitude{static_cast<std::int32_t>(lng * detail::POLYLINE_TO_COORDINATE)};
+        p.lat = util::FixedLatitude{static_cast<std::int32_t>(lat * factor)};
+        p.lon = util::FixedLongitude{static_cast<std::int32_t>(lng * factor)};
         new_coordinates.push_back(p);
     }
 
     return new_coordinates;
 }
+
+template std::string encodePolyline<100000>(CoordVectorForwardIter begin,
+                                            CoordVectorForwardIter end);
+template std::string encodePolyline<1000000>(CoordVectorForwardIter begin,
+                                             CoordVectorForwardIter end);
+template std::vector<util::Coordinate> decodePolyline<100000>(const std::string &polyline);
+template std::vector<util::Coordinate> decodePolyline<1000000>(const std::string &polyline);
 }
 }
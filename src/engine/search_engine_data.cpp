@@ -1,79 +1,241 @@
 #include "engine/search_engine_data.hpp"
 
 #include "util/binary_heap.hpp"
+#include "util/make_unique.hpp"
+#include "util/query_metrics.hpp"
+
+#include <boost/assert.hpp>
+
+#include <type_traits>
+#include <utility>
 
 namespace osrm
 {
 namespace engine
 {
 
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::forward_heap_1;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::reverse_heap_1;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::forward_heap_2;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::reverse_heap_2;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::forward_heap_3;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::reverse_heap_3;
-
-void SearchEngineData::InitializeOrClearFirstThreadLocalStorage(const unsigned number_of_nodes)
+namespace
 {
-    if (forward_heap_1.get())
+// Heaps outlive datafacade swaps, so a heap built for a smaller graph has to be replaced
+// instead of cleared once its flat index storage cannot address all nodes.
+template <typename HeapPtrT>
+void InitializeOrClearHeap(HeapPtrT &heap,
+                           const unsigned number_of_nodes,
+                           SearchEngineData::Heaps &heaps)
+{
+    using HeapT = typename std::remove_reference<decltype(*heap)>::type;
+
+    if (heap.get() && heap->Capacity() >= number_of_nodes)
     {
-        forward_heap_1->Clear();
+        heap->Clear();
     }
     else
     {
-        forward_heap_1.reset(new QueryHeap(number_of_nodes));
+        // a heap is only replaced if it can address fewer nodes, its capacity is finite then
+        const std::size_t old_memory =
+            heap.get() ? heap->Capacity() * SearchEngineData::HEAP_BYTES_PER_NODE : 0;
+        const std::size_t new_memory =
+            std::size_t{number_of_nodes} * SearchEngineData::HEAP_BYTES_PER_NODE;
+        heap.reset(new HeapT(number_of_nodes));
+        ++heaps.allocations;
+        heaps.memory += new_memory - old_memory;
+        util::QueryMetrics::GetInstance().AddHeapMemory(static_cast<std::int64_t>(new_memory) -
+                                                        static_cast<std::int64_t>(old_memory));
     }
+}
+
+// Returns the set of heaps of a thread that searches outside of a query when the thread exits
+struct ThreadHeaps
+{
+    ThreadHeaps() : heaps(SearchEngineData::GetDefaultHeapPool().Acquire()) {}
+    ~ThreadHeaps() { SearchEngineData::GetDefaultHeapPool().Release(std::move(heaps)); }
 
-    if (reverse_heap_1.get())
+    std::unique_ptr<SearchEngineData::Heaps> heaps;
+};
+}
+
+constexpr std::size_t SearchEngineData::HEAP_BYTES_PER_NODE;
+
+SearchEngineData::Heaps::~Heaps()
+{
+    util::QueryMetrics::GetInstance().AddHeapMemory(-static_cast<std::int64_t>(memory));
+}
+
+SearchEngineData::Heaps &SearchEngineData::GetHeaps()
+{
+    if (Heaps *const heaps = CurrentHeaps())
     {
-        reverse_heap_1->Clear();
+        return *heaps;
     }
-    else
+    static thread_local ThreadHeaps thread_heaps;
+    return *thread_heaps.heaps;
+}
+
+SearchEngineHeapPool &SearchEngineData::GetHeapPool()
+{
+    if (SearchEngineHeapPool *const pool = CurrentHeapPool())
     {
-        reverse_heap_1.reset(new QueryHeap(number_of_nodes));
+        return *pool;
     }
+    return GetDefaultHeapPool();
+}
+
+SearchEngineHeapPool &SearchEngineData::GetDefaultHeapPool()
+{
+    static SearchEngineHeapPool pool;
+    return pool;
+}
+
+SearchEngineData::ScopedHeaps::ScopedHeaps(SearchEngineHeapPool &pool_)
+    : pool(pool_), heaps(pool_.Acquire()), outer_heaps(CurrentHeaps()),
+      outer_pool(CurrentHeapPool())
+{
+    CurrentHeaps() = heaps.get();
+    CurrentHeapPool() = &pool;
 }
 
-void SearchEngineData::InitializeOrClearSecondThreadLocalStorage(const unsigned number_of_nodes)
+SearchEngineData::ScopedHeaps::~ScopedHeaps()
 {
-    if (forward_heap_2.get())
+    CurrentHeaps() = outer_heaps;
+    CurrentHeapPool() = outer_pool;
+    pool.Release(std::move(heaps));
+}
+
+std::unique_ptr<SearchEngineData::Heaps> SearchEngineHeapPool::Acquire()
+{
+    std::unique_ptr<SearchEngineData::Heaps> heaps;
     {
-        forward_heap_2->Clear();
+        std::lock_guard<std::mutex> lock(mutex);
+        ++statistics.checkouts;
+        ++statistics.heap_sets_in_use;
+        if (!idle_heaps.empty())
+        {
+            heaps = std::move(idle_heaps.back());
+            idle_heaps.pop_back();
+            ++statistics.reuses;
+        }
+        else
+        {
+            ++statistics.heap_sets;
+        }
     }
-    else
+    util::QueryMetrics::GetInstance().AddHeapCheckout(static_cast<bool>(heaps));
+    if (!heaps)
     {
-        forward_heap_2.reset(new QueryHeap(number_of_nodes));
+        heaps = util::make_unique<SearchEngineData::Heaps>();
     }
+    return heaps;
+}
+
+void SearchEngineHeapPool::Release(std::unique_ptr<SearchEngineData::Heaps> heaps)
+{
+    BOOST_ASSERT(heaps);
+    const auto allocations = heaps->allocations;
+    heaps->allocations = 0;
+    util::QueryMetrics::GetInstance().AddHeapAllocations(allocations);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    BOOST_ASSERT(statistics.heap_sets_in_use > 0);
+    --statistics.heap_sets_in_use;
+    statistics.allocations += allocations;
+    idle_heaps.push_back(std::move(heaps));
+}
 
-    if (reverse_heap_2.get())
+SearchEngineHeapPoolStatistics SearchEngineHeapPool::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return statistics;
+}
+
+bool SearchEngineData::ReserveQueryMemory(const std::size_t bytes)
+{
+    ScopedQueryMemory *const memory = CurrentQueryMemory();
+    if (!memory)
     {
-        reverse_heap_2->Clear();
+        return true;
     }
-    else
+    if (bytes > memory->limit - memory->reserved)
     {
-        reverse_heap_2.reset(new QueryHeap(number_of_nodes));
+        memory->rejected = true;
+        return false;
     }
+    memory->reserved += bytes;
+    util::QueryMetrics::GetInstance().AddQueryMemory(memory->service,
+                                                     static_cast<std::int64_t>(bytes));
+    return true;
+}
+
+SearchEngineData::ScopedQueryMemory::ScopedQueryMemory(const util::QueryMetrics::Service service,
+                                                       const std::size_t limit)
+    : service(service), limit(limit), reserved(0), rejected(false),
+      outer_memory(CurrentQueryMemory())
+{
+    CurrentQueryMemory() = this;
 }
 
-void SearchEngineData::InitializeOrClearThirdThreadLocalStorage(const unsigned number_of_nodes)
+SearchEngineData::ScopedQueryMemory::~ScopedQueryMemory()
 {
-    if (forward_heap_3.get())
+    CurrentQueryMemory() = outer_memory;
+    auto &metrics = util::QueryMetrics::GetInstance();
+    metrics.AddQueryMemory(service, -static_cast<std::int64_t>(reserved));
+    metrics.RecordQueryMemory(service, reserved, rejected);
+}
+
+void SearchEngineData::CheckQueryControl(const AsyncOptions &options)
+{
+    if (options.cancelled && options.cancelled->load(std::memory_order_relaxed))
     {
-        forward_heap_3->Clear();
+        throw QueryAborted(Status::Error, "Cancelled", "Query was cancelled");
     }
-    else
+    if (options.deadline && std::chrono::steady_clock::now() >= *options.deadline)
     {
-        forward_heap_3.reset(new QueryHeap(number_of_nodes));
+        throw QueryAborted(Status::Timeout, "Timeout", "Query ran past its deadline");
     }
+}
 
-    if (reverse_heap_3.get())
-    {
-        reverse_heap_3->Clear();
-    }
-    else
+void SearchEngineData::InitializeOrClearFirstHeaps(const unsigned number_of_nodes)
+{
+    CheckQueryControl();
+    auto &heaps = GetHeaps();
+    InitializeOrClearHeap(heaps.forward_heap_1, number_of_nodes, heaps);
+    InitializeOrClearHeap(heaps.reverse_heap_1, number_of_nodes, heaps);
+}
+
+void SearchEngineData::InitializeOrClearSecondHeaps(const unsigned number_of_nodes)
+{
+    CheckQueryControl();
+    auto &heaps = GetHeaps();
+    InitializeOrClearHeap(heaps.forward_heap_2, number_of_nodes, heaps);
+    InitializeOrClearHeap(heaps.reverse_heap_2, number_of_nodes, heaps);
+}
+
+void SearchEngineData::InitializeOrClearThirdHeaps(const unsigned number_of_nodes)
+{
+    CheckQueryControl();
+    auto &heaps = GetHeaps();
+    InitializeOrClearHeap(heaps.forward_heap_3, number_of_nodes, heaps);
+    InitializeOrClearHeap(heaps.reverse_heap_3, number_of_nodes, heaps);
+}
+
+void SearchEngineData::InitializeOrClearManyToManyHeap(const unsigned number_of_nodes)
+{
+    CheckQueryControl();
+    auto &heaps = GetHeaps();
+    InitializeOrClearHeap(heaps.many_to_many_heap, number_of_nodes, heaps);
+}
+
+void SearchEngineData::InitializeOrClearCellHeap(const unsigned number_of_nodes)
+{
+    auto &heaps = GetHeaps();
+    InitializeOrClearHeap(heaps.cell_heap, number_of_nodes, heaps);
+}
+
+void SearchEngineData::InitializeHiddenMarkovModel()
+{
+    auto &heaps = GetHeaps();
+    if (!heaps.hidden_markov_model)
     {
-        reverse_heap_3.reset(new QueryHeap(number_of_nodes));
+        heaps.hidden_markov_model = util::make_unique<map_matching::HiddenMarkovModel>();
     }
 }
 }
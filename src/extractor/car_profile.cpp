@@ -0,0 +1,1062 @@
+#include "extractor/car_profile.hpp"
+
+#include "extractor/extraction_helper_functions.hpp"
+#include "extractor/extraction_node.hpp"
+#include "extractor/extraction_way.hpp"
+#include "extractor/guidance/road_classification.hpp"
+#include "extractor/travel_mode.hpp"
+
+#include "util/exception.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/numeric/conversion/cast.hpp>
+
+#include <osmium/osm.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+
+namespace osrm
+{
+namespace extractor
+{
+
+namespace
+{
+const constexpr double INF = std::numeric_limits<double>::infinity();
+
+// by CarProfile::Key
+const char *const FIXED_KEYS[] = {"highway",
+                                  "route",
+                                  "bridge",
+                                  "area",
+                                  "hov",
+                                  "hov:lanes",
+                                  "hov:lanes:forward",
+                                  "hov:lanes:backward",
+                                  "oneway",
+                                  "toll",
+                                  "impassable",
+                                  "status",
+                                  "duration",
+                                  "maxspeed",
+                                  "maxspeed:forward",
+                                  "maxspeed:backward",
+                                  "maxspeed:advisory",
+                                  "maxspeed:advisory:forward",
+                                  "maxspeed:advisory:backward",
+                                  "side_road",
+                                  "surface",
+                                  "tracktype",
+                                  "smoothness",
+                                  "name",
+                                  "name:pronunciation",
+                                  "ref",
+                                  "junction",
+                                  "service",
+                                  "destination",
+                                  "destination:ref",
+                                  "width",
+                                  "lanes",
+                                  "lanes:psv",
+                                  "lanes:psv:forward",
+                                  "lanes:psv:backward",
+                                  "turn:lanes",
+                                  "turn:lanes:forward",
+                                  "turn:lanes:backward",
+                                  "vehicle:lanes",
+                                  "vehicle:lanes:forward",
+                                  "vehicle:lanes:backward",
+                                  "barrier",
+                                  "bollard"};
+static_assert(sizeof(FIXED_KEYS) / sizeof(*FIXED_KEYS) == CarProfile::NUMBER_OF_FIXED_KEYS,
+              "every key needs its string");
+
+// The tables of profiles/lib/guidance.lua
+struct Classification
+{
+    Classification()
+    {
+        using namespace guidance::RoadPriorityClass;
+        const std::pair<const char *, Enum> classes[] = {{"motorway", MOTORWAY},
+                                                         {"motorway_link", LINK_ROAD},
+                                                         {"trunk", TRUNK},
+                                                         {"trunk_link", LINK_ROAD},
+                                                         {"primary", PRIMARY},
+                                                         {"primary_link", LINK_ROAD},
+                                                         {"secondary", SECONDARY},
+                                                         {"secondary_link", LINK_ROAD},
+                                                         {"tertiary", TERTIARY},
+                                                         {"tertiary_link", LINK_ROAD},
+                                                         {"unclassified", SIDE_RESIDENTIAL},
+                                                         {"residential", SIDE_RESIDENTIAL},
+                                                         {"service", CONNECTIVITY},
+                                                         {"living_street", MAIN_RESIDENTIAL},
+                                                         {"track", BIKE_PATH},
+                                                         {"path", BIKE_PATH},
+                                                         {"footway", FOOT_PATH},
+                                                         {"pedestrian", FOOT_PATH},
+                                                         {"steps", FOOT_PATH}};
+        for (const auto &highway_class : classes)
+        {
+            highway_classes.Set(highway_class.first, highway_class.second);
+        }
+        for (const auto highway : {"motorway", "motorway_link", "trunk", "trunk_link"})
+        {
+            motorway_types.Set(highway, true);
+        }
+        for (const auto highway :
+             {"motorway_link", "trunk_link", "primary_link", "secondary_link", "tertiary_link"})
+        {
+            link_types.Set(highway, true);
+        }
+        // the roads for cars, all but service roads and paths
+        for (const auto &highway_class : classes)
+        {
+            if (highway_class.second != CONNECTIVITY && highway_class.second != BIKE_PATH &&
+                highway_class.second != FOOT_PATH)
+            {
+                road_types.Set(highway_class.first, true);
+            }
+        }
+    }
+
+    StringTable<guidance::RoadPriorityClass::Enum> highway_classes;
+    StringSet motorway_types;
+    StringSet link_types;
+    StringSet road_types;
+};
+
+const Classification &getClassification()
+{
+    static const Classification classification;
+    return classification;
+}
+
+inline bool isEmpty(const char *value) { return value == nullptr || *value == '\0'; }
+
+inline bool equals(const char *value, const char *other)
+{
+    return value != nullptr && std::strcmp(value, other) == 0;
+}
+
+// tonumber(value:match("%d*")) of lua, the digits at the start
+bool parseLeadingNumber(const char *value, double &number)
+{
+    if (value == nullptr || !std::isdigit(static_cast<unsigned char>(*value)))
+    {
+        return false;
+    }
+    number = 0;
+    for (; std::isdigit(static_cast<unsigned char>(*value)); ++value)
+    {
+        number = number * 10 + (*value - '0');
+    }
+    return true;
+}
+
+// tonumber(value) of lua for decimal numbers, which allows spaces around the number
+bool parseNumber(const char *value, double &number)
+{
+    char *end;
+    number = std::strtod(value, &end);
+    if (end == value)
+    {
+        return false;
+    }
+    for (; std::isspace(static_cast<unsigned char>(*end)); ++end)
+    {
+    }
+    return *end == '\0';
+}
+
+// hov:lanes like "designated|designated", every run of letters and digits is "designated"
+bool hasAllDesignatedLanes(const char *lanes)
+{
+    const auto is_alnum = [](const char c) { return std::isalnum(static_cast<unsigned char>(c)); };
+    while (*lanes != '\0')
+    {
+        if (!is_alnum(*lanes))
+        {
+            ++lanes;
+            continue;
+        }
+        const char *begin = lanes;
+        for (; is_alnum(*lanes); ++lanes)
+        {
+        }
+        if (lanes - begin != 10 || std::strncmp(begin, "designated", 10) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// parse_maxspeed of car.lua: "50", "30 mph" and the country specific ones like "de:rural"
+double parseMaxspeed(const char *value, const CarProfileConfig &config)
+{
+    if (value == nullptr)
+    {
+        return 0;
+    }
+    double speed;
+    if (parseLeadingNumber(value, speed))
+    {
+        if (std::strstr(value, "mph") != nullptr || std::strstr(value, "mp/h") != nullptr)
+        {
+            speed = (speed * 1609) / 1000;
+        }
+        return speed;
+    }
+
+    std::string lowercase(value);
+    std::transform(lowercase.begin(), lowercase.end(), lowercase.begin(), [](const char c) {
+        return std::tolower(static_cast<unsigned char>(c));
+    });
+    if (const auto maxspeed = config.maxspeeds.Find(lowercase.c_str()))
+    {
+        return *maxspeed;
+    }
+
+    // the first two letters followed by a colon and letters
+    const auto is_alpha = [](const char c) { return std::isalpha(static_cast<unsigned char>(c)); };
+    for (std::size_t index = 0; index + 3 < lowercase.size(); ++index)
+    {
+        if (is_alpha(lowercase[index]) && is_alpha(lowercase[index + 1]) &&
+            lowercase[index + 2] == ':' && is_alpha(lowercase[index + 3]))
+        {
+            auto end = index + 3;
+            for (; end < lowercase.size() && is_alpha(lowercase[end]); ++end)
+            {
+            }
+            const auto highway_type = lowercase.substr(index + 3, end - index - 3);
+            const auto maxspeed = config.maxspeed_defaults.Find(highway_type.c_str());
+            return maxspeed ? *maxspeed : 0;
+        }
+    }
+    return 0;
+}
+
+// get_destination of profiles/lib/destination.lua
+std::string getDestination(const char *destination, const char *destination_ref)
+{
+    const auto append = [](std::string &result, const char *value) {
+        for (; *value != '\0'; ++value)
+        {
+            if (*value == ';')
+            {
+                result += ", ";
+            }
+            else
+            {
+                result += *value;
+            }
+        }
+    };
+
+    std::string result;
+    if (!isEmpty(destination_ref))
+    {
+        append(result, destination_ref);
+    }
+    if (!isEmpty(destination))
+    {
+        if (!result.empty())
+        {
+            result += ": ";
+        }
+        append(result, destination);
+    }
+    return result;
+}
+
+// process_lanes of profiles/lib/guidance.lua
+std::string processLanes(const char *turn_lanes,
+                         const char *vehicle_lanes,
+                         const double first_count,
+                         const double second_count)
+{
+    if (isEmpty(turn_lanes))
+    {
+        return "";
+    }
+    if (!isEmpty(vehicle_lanes))
+    {
+        return applyAccessTokens(turn_lanes, vehicle_lanes);
+    }
+    if (first_count != 0 || second_count != 0)
+    {
+        return trimLaneString(turn_lanes,
+                              static_cast<std::int32_t>(first_count),
+                              static_cast<std::int32_t>(second_count));
+    }
+    return turn_lanes;
+}
+
+double getLaneCount(const char *value)
+{
+    double count;
+    return isEmpty(value) || !parseNumber(value, count) ? 0 : count;
+}
+
+void setDuration(const char *duration, ExtractionWay &result)
+{
+    if (duration != nullptr && durationIsValid(duration))
+    {
+        result.duration = std::max<unsigned>(parseDuration(duration), 1);
+    }
+}
+
+// A line of the configuration file without the comment and the spaces around it
+std::string trim(const std::string &line)
+{
+    const auto end = line.find('#');
+    const auto first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || first >= end)
+    {
+        return "";
+    }
+    const auto last = line.find_last_not_of(" \t\r", end == std::string::npos ? end : end - 1);
+    return line.substr(first, last - first + 1);
+}
+
+std::vector<std::string> splitList(const std::string &value)
+{
+    std::vector<std::string> list;
+    std::istringstream stream(value);
+    std::string element;
+    while (stream >> element)
+    {
+        list.push_back(element);
+    }
+    return list;
+}
+}
+
+CarProfileConfig::CarProfileConfig()
+    : turn_penalty(7.5), turn_bias(1.075), side_road_speed_multiplier(0.8), speed_reduction(0.8),
+      obey_oneway(true), ignore_areas(true), ignore_hov_ways(true), ignore_toll_ways(false),
+      access_tags{"motorcar", "motor_vehicle", "vehicle", "access"},
+      restriction_exceptions{"motorcar", "motor_vehicle", "vehicle"},
+      name_suffixes{"N", "NE", "E", "SE", "S", "SW", "W", "NW", "North", "South", "West", "East"}
+{
+    properties.SetUturnPenalty(20);
+    properties.SetTrafficSignalPenalty(2);
+    properties.use_turn_restrictions = true;
+    properties.continue_straight_at_waypoint = true;
+    properties.left_hand_driving = false;
+
+    const std::pair<const char *, double> default_speeds[] = {{"motorway", 90},
+                                                              {"motorway_link", 45},
+                                                              {"trunk", 85},
+                                                              {"trunk_link", 40},
+                                                              {"primary", 65},
+                                                              {"primary_link", 30},
+                                                              {"secondary", 55},
+                                                              {"secondary_link", 25},
+                                                              {"tertiary", 40},
+                                                              {"tertiary_link", 20},
+                                                              {"unclassified", 25},
+                                                              {"residential", 25},
+                                                              {"living_street", 10},
+                                                              {"service", 15},
+                                                              {"ferry", 5},
+                                                              {"movable", 5},
+                                                              {"shuttle_train", 10},
+                                                              {"default", 10}};
+    for (const auto &speed : default_speeds)
+    {
+        speeds.Set(speed.first, speed.second);
+    }
+
+    service_speeds.Set("alley", 5);
+    service_speeds.Set("parking_aisle", 5);
+
+    const std::pair<const char *, double> default_surface_speeds[] = {{"cement", 80},
+                                                                      {"compacted", 80},
+                                                                      {"fine_gravel", 80},
+                                                                      {"paving_stones", 60},
+                                                                      {"metal", 60},
+                                                                      {"bricks", 60},
+                                                                      {"grass", 40},
+                                                                      {"wood", 40},
+                                                                      {"sett", 40},
+                                                                      {"grass_paver", 40},
+                                                                      {"gravel", 40},
+                                                                      {"unpaved", 40},
+                                                                      {"ground", 40},
+                                                                      {"dirt", 40},
+                                                                      {"pebblestone", 40},
+                                                                      {"tartan", 40},
+                                                                      {"cobblestone", 30},
+                                                                      {"clay", 30},
+                                                                      {"earth", 20},
+                                                                      {"stone", 20},
+                                                                      {"rocky", 20},
+                                                                      {"sand", 20},
+                                                                      {"mud", 10}};
+    for (const auto &speed : default_surface_speeds)
+    {
+        surface_speeds.Set(speed.first, speed.second);
+    }
+
+    tracktype_speeds.Set("grade1", 60);
+    tracktype_speeds.Set("grade2", 40);
+    tracktype_speeds.Set("grade3", 30);
+    tracktype_speeds.Set("grade4", 25);
+    tracktype_speeds.Set("grade5", 20);
+
+    smoothness_speeds.Set("intermediate", 80);
+    smoothness_speeds.Set("bad", 40);
+    smoothness_speeds.Set("very_bad", 20);
+    smoothness_speeds.Set("horrible", 10);
+    smoothness_speeds.Set("very_horrible", 5);
+    smoothness_speeds.Set("impassable", 0);
+
+    maxspeed_defaults.Set("urban", 50);
+    maxspeed_defaults.Set("rural", 90);
+    maxspeed_defaults.Set("trunk", 110);
+    maxspeed_defaults.Set("motorway", 130);
+
+    const std::pair<const char *, double> default_maxspeeds[] = {
+        {"ch:rural", 80},
+        {"ch:trunk", 100},
+        {"ch:motorway", 120},
+        {"de:living_street", 7},
+        {"ru:living_street", 20},
+        {"ru:urban", 60},
+        {"ua:urban", 60},
+        {"at:rural", 100},
+        {"de:rural", 100},
+        {"at:trunk", 100},
+        {"cz:trunk", 0},
+        {"ro:trunk", 100},
+        {"cz:motorway", 0},
+        {"de:motorway", 0},
+        {"ru:motorway", 110},
+        {"gb:nsl_single", (60 * 1609) / 1000.},
+        {"gb:nsl_dual", (70 * 1609) / 1000.},
+        {"gb:motorway", (70 * 1609) / 1000.},
+        {"uk:nsl_single", (60 * 1609) / 1000.},
+        {"uk:nsl_dual", (70 * 1609) / 1000.},
+        {"uk:motorway", (70 * 1609) / 1000.},
+        {"nl:rural", 80},
+        {"nl:trunk", 100},
+        {"none", 140}};
+    for (const auto &maxspeed : default_maxspeeds)
+    {
+        maxspeeds.Set(maxspeed.first, maxspeed.second);
+    }
+
+    for (const auto access : {"yes",
+                              "motorcar",
+                              "motor_vehicle",
+                              "vehicle",
+                              "permissive",
+                              "designated",
+                              "destination"})
+    {
+        access_whitelist.Set(access, true);
+    }
+    for (const auto access :
+         {"no", "private", "agricultural", "forestry", "emergency", "psv", "delivery"})
+    {
+        access_blacklist.Set(access, true);
+    }
+    access_restricted.Set("destination", true);
+    access_restricted.Set("delivery", true);
+
+    for (const auto barrier : {"cattle_grid",
+                               "border_control",
+                               "checkpoint",
+                               "toll_booth",
+                               "sally_port",
+                               "gate",
+                               "lift_gate",
+                               "no",
+                               "entrance"})
+    {
+        barrier_whitelist.Set(barrier, true);
+    }
+
+    service_restricted.Set("parking_aisle", true);
+    service_forbidden.Set("emergency_access", true);
+}
+
+void CarProfileConfig::Load(const boost::filesystem::path &path)
+{
+    boost::filesystem::ifstream stream(path);
+    if (!stream)
+    {
+        throw util::exception("Could not open profile " + path.string());
+    }
+
+    std::string section;
+    std::string line;
+    for (std::size_t line_number = 1; std::getline(stream, line); ++line_number)
+    {
+        const auto fail = [&](const std::string &message) {
+            throw util::exception(path.string() + ":" + std::to_string(line_number) + ": " +
+                                  message);
+        };
+
+        line = trim(line);
+        if (line.empty())
+        {
+            continue;
+        }
+        if (line.front() == '[')
+        {
+            if (line.back() != ']')
+            {
+                fail("Expected ] at the end of the section");
+            }
+            section = line.substr(1, line.size() - 2);
+            continue;
+        }
+
+        const auto equals_sign = line.find('=');
+        if (equals_sign == std::string::npos)
+        {
+            fail("Expected key = value");
+        }
+        const auto key = trim(line.substr(0, equals_sign));
+        const auto value = trim(line.substr(equals_sign + 1));
+        if (key.empty())
+        {
+            fail("Expected a key before =");
+        }
+
+        const auto to_number = [&] {
+            double number = 0;
+            if (!parseNumber(value.c_str(), number))
+            {
+                fail("Expected a number for " + key);
+            }
+            return number;
+        };
+        const auto to_bool = [&] {
+            if (value != "true" && value != "false")
+            {
+                fail("Expected true or false for " + key);
+            }
+            return value == "true";
+        };
+        // an empty value removes the entry, like nil in the tables of car.lua
+        const auto set_speed = [&](StringTable<double> &table) {
+            if (value.empty())
+            {
+                table.Erase(key);
+            }
+            else
+            {
+                table.Set(key, to_number());
+            }
+        };
+        const auto set_list = [&](StringSet &set) {
+            set = StringSet();
+            for (const auto &element : splitList(value))
+            {
+                set.Set(element, true);
+            }
+        };
+
+        if (section == "properties")
+        {
+            if (key == "u_turn_penalty")
+                properties.SetUturnPenalty(to_number());
+            else if (key == "traffic_signal_penalty")
+                properties.SetTrafficSignalPenalty(to_number());
+            else if (key == "use_turn_restrictions")
+                properties.use_turn_restrictions = to_bool();
+            else if (key == "continue_straight_at_waypoint")
+                properties.continue_straight_at_waypoint = to_bool();
+            else if (key == "left_hand_driving")
+                properties.left_hand_driving = to_bool();
+            else if (key == "turn_penalty")
+                turn_penalty = to_number();
+            else if (key == "turn_bias")
+                turn_bias = to_number();
+            else if (key == "side_road_speed_multiplier")
+                side_road_speed_multiplier = to_number();
+            else if (key == "speed_reduction")
+                speed_reduction = to_number();
+            else if (key == "obey_oneway")
+                obey_oneway = to_bool();
+            else if (key == "ignore_areas")
+                ignore_areas = to_bool();
+            else if (key == "ignore_hov_ways")
+                ignore_hov_ways = to_bool();
+            else if (key == "ignore_toll_ways")
+                ignore_toll_ways = to_bool();
+            else
+                fail("Unknown property " + key);
+        }
+        else if (section == "speeds")
+            set_speed(speeds);
+        else if (section == "service_speeds")
+            set_speed(service_speeds);
+        else if (section == "surface_speeds")
+            set_speed(surface_speeds);
+        else if (section == "tracktype_speeds")
+            set_speed(tracktype_speeds);
+        else if (section == "smoothness_speeds")
+            set_speed(smoothness_speeds);
+        else if (section == "maxspeeds")
+            set_speed(maxspeeds);
+        else if (section == "maxspeed_defaults")
+            set_speed(maxspeed_defaults);
+        else if (section == "access")
+        {
+            if (key == "tags")
+                access_tags = splitList(value);
+            else if (key == "whitelist")
+                set_list(access_whitelist);
+            else if (key == "blacklist")
+                set_list(access_blacklist);
+            else if (key == "restricted")
+                set_list(access_restricted);
+            else
+                fail("Unknown access setting " + key);
+        }
+        else if (section == "barriers" && key == "whitelist")
+            set_list(barrier_whitelist);
+        else if (section == "service" && key == "restricted")
+            set_list(service_restricted);
+        else if (section == "service" && key == "forbidden")
+            set_list(service_forbidden);
+        else if (section == "restrictions" && key == "exceptions")
+            restriction_exceptions = splitList(value);
+        else if (section == "names" && key == "suffixes")
+            name_suffixes = splitList(value);
+        else
+            fail("Unknown setting " + key + " in section [" + section + "]");
+    }
+}
+
+CarProfile::CarProfile(CarProfileConfig config_)
+    : config(std::move(config_)), number_of_keys(NUMBER_OF_FIXED_KEYS),
+      turn_bias(config.properties.left_hand_driving ? 1 / config.turn_bias : config.turn_bias)
+{
+    for (std::size_t key = 0; key < NUMBER_OF_FIXED_KEYS; ++key)
+    {
+        key_ids.Set(FIXED_KEYS[key], static_cast<std::uint8_t>(key));
+    }
+    for (const auto &access_tag : config.access_tags)
+    {
+        if (const auto key_id = key_ids.Find(access_tag.c_str()))
+        {
+            access_key_ids.push_back(*key_id);
+            continue;
+        }
+        if (number_of_keys == MAX_NUMBER_OF_KEYS)
+        {
+            throw util::exception("The car profile reads at most " +
+                                  std::to_string(MAX_NUMBER_OF_KEYS) + " different tags");
+        }
+        key_ids.Set(access_tag, static_cast<std::uint8_t>(number_of_keys));
+        access_key_ids.push_back(static_cast<std::uint8_t>(number_of_keys));
+        ++number_of_keys;
+    }
+}
+
+// tags[id] is the value of the first tag with the key of the id, or nullptr
+template <typename ObjectT>
+void CarProfile::CollectTags(const ObjectT &object, const char **tags) const
+{
+    std::fill(tags, tags + number_of_keys, nullptr);
+    for (const auto &tag : object.tags())
+    {
+        const auto key_id = key_ids.Find(tag.key());
+        if (key_id != nullptr && tags[*key_id] == nullptr)
+        {
+            tags[*key_id] = tag.value();
+        }
+    }
+}
+
+// find_access_tag of profiles/lib/access.lua, "" if none of the access tags is set
+const char *CarProfile::FindAccess(const char *const *tags) const
+{
+    for (const auto key_id : access_key_ids)
+    {
+        if (!isEmpty(tags[key_id]))
+        {
+            return tags[key_id];
+        }
+    }
+    return "";
+}
+
+void CarProfile::ProcessNode(const osmium::Node &node, ExtractionNode &result) const
+{
+    const char *tags[MAX_NUMBER_OF_KEYS];
+    CollectTags(node, tags);
+
+    const auto access = FindAccess(tags);
+    if (*access != '\0')
+    {
+        if (config.access_blacklist.Contains(access))
+        {
+            result.barrier = true;
+        }
+    }
+    else if (!isEmpty(tags[BARRIER]))
+    {
+        // make an exception for rising bollard barriers
+        if (!config.barrier_whitelist.Contains(tags[BARRIER]) && !equals(tags[BOLLARD], "rising"))
+        {
+            result.barrier = true;
+        }
+    }
+
+    if (equals(tags[HIGHWAY], "traffic_signals"))
+    {
+        result.traffic_lights = true;
+    }
+}
+
+void CarProfile::ProcessWay(const osmium::Way &way, ExtractionWay &result) const
+{
+    const char *tags[MAX_NUMBER_OF_KEYS];
+    CollectTags(way, tags);
+
+    const char *highway = tags[HIGHWAY];
+    const char *route = tags[ROUTE];
+    const char *bridge = tags[BRIDGE];
+    if (isEmpty(highway) && isEmpty(route) && isEmpty(bridge))
+    {
+        return;
+    }
+
+    result.forward_travel_mode = TRAVEL_MODE_DRIVING;
+    result.backward_travel_mode = TRAVEL_MODE_DRIVING;
+
+    if (config.ignore_areas && equals(tags[AREA], "yes"))
+    {
+        return;
+    }
+
+    const char *oneway = tags[ONEWAY];
+    if (config.ignore_hov_ways)
+    {
+        if (equals(tags[HOV], "designated"))
+        {
+            return;
+        }
+
+        const auto all_designated = [&](const Key key) {
+            return !isEmpty(tags[key]) && hasAllDesignatedLanes(tags[key]);
+        };
+        // forward and backward lanes depend on the direction of the way
+        const bool reverse = equals(oneway, "-1");
+        if (all_designated(HOV_LANES) || all_designated(HOV_LANES_FORWARD))
+        {
+            (reverse ? result.backward_travel_mode : result.forward_travel_mode) =
+                TRAVEL_MODE_INACCESSIBLE;
+        }
+        if (all_designated(HOV_LANES_BACKWARD))
+        {
+            (reverse ? result.forward_travel_mode : result.backward_travel_mode) =
+                TRAVEL_MODE_INACCESSIBLE;
+        }
+    }
+
+    if (config.ignore_toll_ways && equals(tags[TOLL], "yes"))
+    {
+        return;
+    }
+    if (equals(oneway, "reversible") || equals(tags[IMPASSABLE], "yes") ||
+        equals(tags[STATUS], "impassable"))
+    {
+        return;
+    }
+
+    const auto access = FindAccess(tags);
+    if (config.access_blacklist.Contains(access))
+    {
+        return;
+    }
+
+    // ferries and piers
+    const auto route_speed = config.speeds.Find(route);
+    if (route_speed != nullptr && *route_speed > 0)
+    {
+        highway = route;
+        setDuration(tags[DURATION], result);
+        result.forward_travel_mode = TRAVEL_MODE_FERRY;
+        result.backward_travel_mode = TRAVEL_MODE_FERRY;
+        result.forward_speed = *route_speed;
+        result.backward_speed = *route_speed;
+    }
+
+    // movable bridges, car.lua compares the string of capacity:car with 0 which never blocks
+    const auto bridge_speed = config.speeds.Find(bridge);
+    if (bridge_speed != nullptr && *bridge_speed > 0)
+    {
+        highway = bridge;
+        setDuration(tags[DURATION], result);
+        result.forward_speed = *bridge_speed;
+        result.backward_speed = *bridge_speed;
+    }
+
+    if (equals(highway, ""))
+    {
+        return;
+    }
+
+    if (result.forward_speed == -1)
+    {
+        const auto highway_speed = config.speeds.Find(highway);
+        auto max_speed = parseMaxspeed(tags[MAXSPEED], config);
+        if (highway_speed != nullptr)
+        {
+            const auto speed = max_speed > *highway_speed ? max_speed : *highway_speed;
+            result.forward_speed = speed;
+            result.backward_speed = speed;
+        }
+        else if (config.access_whitelist.Contains(access))
+        {
+            const auto default_speed = config.speeds.Find("default");
+            if (default_speed != nullptr)
+            {
+                result.forward_speed = *default_speed;
+                result.backward_speed = *default_speed;
+            }
+        }
+        if (max_speed == 0)
+        {
+            max_speed = INF;
+        }
+        result.forward_speed = std::min(result.forward_speed, max_speed);
+        result.backward_speed = std::min(result.backward_speed, max_speed);
+    }
+
+    if (result.forward_speed == -1 && result.backward_speed == -1)
+    {
+        return;
+    }
+
+    if (equals(tags[SIDE_ROAD], "yes") || equals(tags[SIDE_ROAD], "rotary"))
+    {
+        result.forward_speed *= config.side_road_speed_multiplier;
+        result.backward_speed *= config.side_road_speed_multiplier;
+    }
+
+    // bad surfaces
+    const auto limit_speed = [&](const double *max_speed) {
+        if (max_speed != nullptr)
+        {
+            result.forward_speed = std::min(*max_speed, result.forward_speed);
+            result.backward_speed = std::min(*max_speed, result.backward_speed);
+        }
+    };
+    limit_speed(config.surface_speeds.Find(tags[SURFACE]));
+    limit_speed(config.tracktype_speeds.Find(tags[TRACKTYPE]));
+    limit_speed(config.smoothness_speeds.Find(tags[SMOOTHNESS]));
+
+    const auto &classification = getClassification();
+    if (classification.motorway_types.Contains(highway))
+    {
+        result.road_classification.SetMotorwayFlag(true);
+    }
+    if (classification.link_types.Contains(highway))
+    {
+        result.road_classification.SetLinkClass(true);
+    }
+    const auto highway_class = classification.highway_classes.Find(highway);
+    result.road_classification.SetClass(highway_class ? *highway_class
+                                                      : guidance::RoadPriorityClass::CONNECTIVITY);
+    result.road_classification.SetLowPriorityFlag(!classification.road_types.Contains(highway));
+
+    if (!isEmpty(tags[NAME]))
+    {
+        result.name = tags[NAME];
+    }
+    if (!isEmpty(tags[REF]))
+    {
+        result.ref = tags[REF];
+    }
+    if (!isEmpty(tags[NAME_PRONUNCIATION]))
+    {
+        result.pronunciation = tags[NAME_PRONUNCIATION];
+    }
+
+    // the psv lanes are trimmed from the turn lanes
+    auto forward_psv = getLaneCount(tags[LANES_PSV]);
+    if (!isEmpty(tags[LANES_PSV_FORWARD]))
+    {
+        forward_psv = getLaneCount(tags[LANES_PSV_FORWARD]);
+    }
+    const auto backward_psv = getLaneCount(tags[LANES_PSV_BACKWARD]);
+    const auto turn_lanes =
+        processLanes(tags[TURN_LANES], tags[VEHICLE_LANES], backward_psv, forward_psv);
+    if (!turn_lanes.empty())
+    {
+        result.turn_lanes_forward = turn_lanes;
+        result.turn_lanes_backward = turn_lanes;
+    }
+    else
+    {
+        result.turn_lanes_forward = processLanes(
+            tags[TURN_LANES_FORWARD], tags[VEHICLE_LANES_FORWARD], backward_psv, forward_psv);
+        result.turn_lanes_backward = processLanes(
+            tags[TURN_LANES_BACKWARD], tags[VEHICLE_LANES_BACKWARD], forward_psv, backward_psv);
+    }
+
+    const char *junction = tags[JUNCTION];
+    if (equals(junction, "roundabout"))
+    {
+        result.roundabout = true;
+    }
+
+    if (config.access_restricted.Contains(access))
+    {
+        result.is_access_restricted = true;
+    }
+
+    const char *service = tags[SERVICE];
+    if (!isEmpty(service))
+    {
+        if (config.service_restricted.Contains(service))
+        {
+            result.is_access_restricted = true;
+        }
+        if (config.service_forbidden.Contains(service))
+        {
+            result.forward_travel_mode = TRAVEL_MODE_INACCESSIBLE;
+            result.backward_travel_mode = TRAVEL_MODE_INACCESSIBLE;
+            return;
+        }
+    }
+
+    if (config.obey_oneway)
+    {
+        if (equals(oneway, "-1"))
+        {
+            result.forward_travel_mode = TRAVEL_MODE_INACCESSIBLE;
+        }
+        else if (equals(oneway, "yes") || equals(oneway, "1") || equals(oneway, "true") ||
+                 equals(junction, "roundabout") ||
+                 (equals(highway, "motorway") && !equals(oneway, "no")))
+        {
+            result.backward_travel_mode = TRAVEL_MODE_INACCESSIBLE;
+            result.destinations = getDestination(tags[DESTINATION], tags[DESTINATION_REF]);
+        }
+    }
+
+    const auto is_bidirectional = [&] {
+        return result.forward_travel_mode != TRAVEL_MODE_INACCESSIBLE &&
+               result.backward_travel_mode != TRAVEL_MODE_INACCESSIBLE;
+    };
+
+    // explicit forward and backward maxspeeds
+    const auto maxspeed_forward = parseMaxspeed(tags[MAXSPEED_FORWARD], config);
+    const auto maxspeed_backward = parseMaxspeed(tags[MAXSPEED_BACKWARD], config);
+    if (maxspeed_forward > 0)
+    {
+        if (is_bidirectional())
+        {
+            result.backward_speed = result.forward_speed;
+        }
+        result.forward_speed = maxspeed_forward;
+    }
+    if (maxspeed_backward > 0)
+    {
+        result.backward_speed = maxspeed_backward;
+    }
+
+    // advisory speeds, the bidirectional one first
+    const auto advisory_speed = parseMaxspeed(tags[MAXSPEED_ADVISORY], config);
+    const auto advisory_forward = parseMaxspeed(tags[MAXSPEED_ADVISORY_FORWARD], config);
+    const auto advisory_backward = parseMaxspeed(tags[MAXSPEED_ADVISORY_BACKWARD], config);
+    if (advisory_speed > 0)
+    {
+        if (result.forward_travel_mode != TRAVEL_MODE_INACCESSIBLE)
+        {
+            result.forward_speed = advisory_speed;
+        }
+        if (result.backward_travel_mode != TRAVEL_MODE_INACCESSIBLE)
+        {
+            result.backward_speed = advisory_speed;
+        }
+    }
+    if (advisory_forward > 0)
+    {
+        if (is_bidirectional())
+        {
+            result.backward_speed = result.forward_speed;
+        }
+        result.forward_speed = advisory_forward;
+    }
+    if (advisory_backward > 0)
+    {
+        result.backward_speed = advisory_backward;
+    }
+
+    double width = INF;
+    double lanes = INF;
+    if (result.forward_speed > 0 || result.backward_speed > 0)
+    {
+        parseLeadingNumber(tags[WIDTH], width);
+        parseLeadingNumber(tags[LANES], lanes);
+    }
+
+    // scale speeds to get better average driving times
+    const auto service_speed = isEmpty(service) ? nullptr : config.service_speeds.Find(service);
+    const auto narrow = width <= 3 || (lanes <= 1 && is_bidirectional());
+    const auto scale_speed = [&](double &speed) {
+        if (speed > 0)
+        {
+            const auto scaled_speed = speed * config.speed_reduction + 11;
+            auto penalized_speed = INF;
+            if (service_speed != nullptr)
+            {
+                penalized_speed = *service_speed;
+            }
+            else if (narrow)
+            {
+                penalized_speed = speed / 2;
+            }
+            speed = std::min(penalized_speed, scaled_speed);
+        }
+    };
+    scale_speed(result.forward_speed);
+    scale_speed(result.backward_speed);
+
+    // ferries are no start points
+    result.is_startpoint = result.forward_travel_mode == TRAVEL_MODE_DRIVING ||
+                           result.backward_travel_mode == TRAVEL_MODE_DRIVING;
+
+    if (equals(tags[TOLL], "yes"))
+    {
+        result.classes |= getClassMask(TOLL_CLASS);
+    }
+    if (result.road_classification.IsMotorwayClass())
+    {
+        result.classes |= getClassMask(MOTORWAY_CLASS);
+    }
+    if (result.forward_travel_mode == TRAVEL_MODE_FERRY)
+    {
+        result.classes |= getClassMask(FERRY_CLASS);
+    }
+}
+
+std::int32_t CarProfile::GetTurnPenalty(const double angle) const
+{
+    // a sigmoid that maxes out at turn_penalty over 0-180 degrees
+    const auto penalty =
+        angle >= 0
+            ? 10 * config.turn_penalty /
+                  (1 + std::pow(2.718, -((13 / turn_bias) * angle / 180 - 6.5 * turn_bias)))
+            : 10 * config.turn_penalty /
+                  (1 + std::pow(2.718, -((13 * turn_bias) * -angle / 180 - 6.5 / turn_bias)));
+    return boost::numeric_cast<std::int32_t>(penalty);
+}
+}
+}
@@ -0,0 +1,145 @@
+#include "extractor/change_merger.hpp"
+
+#include "util/simple_logger.hpp"
+
+#include <osmium/io/any_input.hpp>
+#include <osmium/osm.hpp>
+
+#include <algorithm>
+#include <tuple>
+
+namespace osrm
+{
+namespace extractor
+{
+
+namespace
+{
+const constexpr std::size_t INITIAL_BUFFER_SIZE = 1024 * 1024;
+
+// the order of osmium, which sorts negative ids by their absolute value as well
+inline auto orderOf(const osmium::OSMObject &object)
+    -> decltype(std::make_tuple(object.type(), object.positive_id(), object.id()))
+{
+    return std::make_tuple(object.type(), object.positive_id(), object.id());
+}
+
+inline bool isObject(const osmium::memory::Item &item)
+{
+    return item.type() == osmium::item_type::node || item.type() == osmium::item_type::way ||
+           item.type() == osmium::item_type::relation || item.type() == osmium::item_type::area;
+}
+}
+
+ChangeMerger::ChangeMerger(const std::vector<boost::filesystem::path> &change_paths)
+    : changes(INITIAL_BUFFER_SIZE, osmium::memory::Buffer::auto_grow::yes), next_change(0)
+{
+    for (const auto &change_path : change_paths)
+    {
+        util::SimpleLogger().Write() << "Reading changes of " << change_path.string();
+        osmium::io::Reader reader(change_path.string(),
+                                  osmium::osm_entity_bits::node | osmium::osm_entity_bits::way |
+                                      osmium::osm_entity_bits::relation);
+        while (auto buffer = reader.read())
+        {
+            for (const auto &item : buffer)
+            {
+                if (isObject(item))
+                {
+                    changes.add_item(item);
+                    changes.commit();
+                }
+            }
+        }
+        reader.close();
+    }
+
+    // the buffer doesn't move anymore
+    for (const auto &item : changes)
+    {
+        changed_objects.push_back(&static_cast<const osmium::OSMObject &>(item));
+    }
+    // later files win over earlier ones with the same version
+    std::stable_sort(changed_objects.begin(),
+                     changed_objects.end(),
+                     [](const osmium::OSMObject *lhs, const osmium::OSMObject *rhs) {
+                         return std::make_tuple(orderOf(*lhs), lhs->version()) <
+                                std::make_tuple(orderOf(*rhs), rhs->version());
+                     });
+    const auto is_same_object = [](const osmium::OSMObject *lhs, const osmium::OSMObject *rhs) {
+        return orderOf(*lhs) == orderOf(*rhs);
+    };
+    // keep the last version, std::unique keeps the first of equal elements
+    std::reverse(changed_objects.begin(), changed_objects.end());
+    changed_objects.erase(
+        std::unique(changed_objects.begin(), changed_objects.end(), is_same_object),
+        changed_objects.end());
+    std::reverse(changed_objects.begin(), changed_objects.end());
+
+    util::SimpleLogger().Write() << "Changes touch " << changed_objects.size() << " objects";
+}
+
+osmium::memory::Buffer ChangeMerger::Merge(const osmium::memory::Buffer &input)
+{
+    osmium::memory::Buffer output(std::max<std::size_t>(input.committed(), INITIAL_BUFFER_SIZE),
+                                  osmium::memory::Buffer::auto_grow::yes);
+    const auto add = [&output](const osmium::memory::Item &item) {
+        output.add_item(item);
+        output.commit();
+    };
+
+    for (const auto &item : input)
+    {
+        if (!isObject(item))
+        {
+            add(item);
+            continue;
+        }
+        const auto &object = static_cast<const osmium::OSMObject &>(item);
+        const auto order = orderOf(object);
+
+        // created objects and changes of objects that aren't in the input
+        for (; next_change < changed_objects.size() &&
+               orderOf(*changed_objects[next_change]) < order;
+             ++next_change)
+        {
+            if (changed_objects[next_change]->visible())
+            {
+                add(*changed_objects[next_change]);
+            }
+        }
+
+        if (next_change < changed_objects.size() &&
+            orderOf(*changed_objects[next_change]) == order)
+        {
+            const auto &change = *changed_objects[next_change++];
+            // an older version in the change files doesn't replace the input
+            const auto &latest = change.version() >= object.version() ? change : object;
+            if (latest.visible())
+            {
+                add(latest);
+            }
+        }
+        else
+        {
+            add(object);
+        }
+    }
+    return output;
+}
+
+osmium::memory::Buffer ChangeMerger::Finish()
+{
+    osmium::memory::Buffer output(INITIAL_BUFFER_SIZE, osmium::memory::Buffer::auto_grow::yes);
+    for (; next_change < changed_objects.size(); ++next_change)
+    {
+        if (changed_objects[next_change]->visible())
+        {
+            output.add_item(*changed_objects[next_change]);
+            output.commit();
+        }
+    }
+    return output;
+}
+}
+}
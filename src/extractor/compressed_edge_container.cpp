@@ -1,12 +1,23 @@
 #include "extractor/compressed_edge_container.hpp"
+#include "extractor/compressed_geometry.hpp"
+#include "engine/douglas_peucker.hpp"
+#include "util/coordinate.hpp"
+#include "util/coordinate_calculation.hpp"
+#include "util/integer_range.hpp"
 #include "util/simple_logger.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <string>
+#include <utility>
 
 #include <iostream>
 
@@ -15,6 +26,13 @@ namespace osrm
 namespace extractor
 {
 
+namespace
+{
+const constexpr unsigned INVALID_LIST_INDEX = std::numeric_limits<unsigned>::max();
+// the offset of a bucket that ResizeBucket sized but that has no place in the arena yet
+const constexpr std::uint64_t UNALLOCATED_OFFSET = std::numeric_limits<std::uint64_t>::max();
+}
+
 CompressedEdgeContainer::CompressedEdgeContainer()
 {
     m_free_list.reserve(100);
@@ -23,7 +41,7 @@ CompressedEdgeContainer::CompressedEdgeContainer()
 
 void CompressedEdgeContainer::IncreaseFreeList()
 {
-    m_compressed_geometries.resize(m_compressed_geometries.size() + 100);
+    m_compressed_geometries.resize(m_compressed_geometries.size() + 100, BucketRange{0, 0});
     for (unsigned i = 100; i > 0; --i)
     {
         m_free_list.emplace_back(free_list_maximum);
@@ -33,57 +51,247 @@ void CompressedEdgeContainer::IncreaseFreeList()
 
 bool CompressedEdgeContainer::HasEntryForID(const EdgeID edge_id) const
 {
-    auto iter = m_edge_id_to_list_index_map.find(edge_id);
-    return iter != m_edge_id_to_list_index_map.end();
+    return edge_id < m_edge_id_to_list_index.size() &&
+           m_edge_id_to_list_index[edge_id] != INVALID_LIST_INDEX;
 }
 
 unsigned CompressedEdgeContainer::GetPositionForID(const EdgeID edge_id) const
 {
-    auto map_iterator = m_edge_id_to_list_index_map.find(edge_id);
-    BOOST_ASSERT(map_iterator != m_edge_id_to_list_index_map.end());
-    BOOST_ASSERT(map_iterator->second < m_compressed_geometries.size());
-    return map_iterator->second;
+    BOOST_ASSERT(HasEntryForID(edge_id));
+    BOOST_ASSERT(m_edge_id_to_list_index[edge_id] < m_compressed_geometries.size());
+    return m_edge_id_to_list_index[edge_id];
+}
+
+// Takes the next bucket of the free list for the edge
+unsigned CompressedEdgeContainer::AddEntryForID(const EdgeID edge_id)
+{
+    BOOST_ASSERT(!HasEntryForID(edge_id));
+    if (0 == m_free_list.size())
+    {
+        // make sure there is a place to put the entries
+        IncreaseFreeList();
+    }
+    BOOST_ASSERT(!m_free_list.empty());
+    if (edge_id >= m_edge_id_to_list_index.size())
+    {
+        m_edge_id_to_list_index.resize(edge_id + 1, INVALID_LIST_INDEX);
+    }
+    m_edge_id_to_list_index[edge_id] = m_free_list.back();
+    m_free_list.pop_back();
+    return m_edge_id_to_list_index[edge_id];
+}
+
+void CompressedEdgeContainer::RenumberEdges(const std::vector<EdgeID> &new_edge_ids)
+{
+    std::vector<unsigned> edge_id_to_list_index(new_edge_ids.size(), INVALID_LIST_INDEX);
+    for (const auto edge_id : util::irange<EdgeID>(0, m_edge_id_to_list_index.size()))
+    {
+        if (m_edge_id_to_list_index[edge_id] != INVALID_LIST_INDEX)
+        {
+            BOOST_ASSERT(edge_id < new_edge_ids.size());
+            BOOST_ASSERT(new_edge_ids[edge_id] != SPECIAL_EDGEID);
+            edge_id_to_list_index[new_edge_ids[edge_id]] = m_edge_id_to_list_index[edge_id];
+        }
+    }
+    m_edge_id_to_list_index.swap(edge_id_to_list_index);
+}
+
+// Puts the emptied bucket of the edge back on the free list
+void CompressedEdgeContainer::RemoveEntryForID(const EdgeID edge_id)
+{
+    const unsigned list_to_remove_index = GetPositionForID(edge_id);
+    m_unused_edges += m_compressed_geometries[list_to_remove_index].size;
+    m_compressed_geometries[list_to_remove_index].size = 0;
+    m_edge_id_to_list_index[edge_id] = INVALID_LIST_INDEX;
+    BOOST_ASSERT(!HasEntryForID(edge_id));
+    m_free_list.emplace_back(list_to_remove_index);
+}
+
+CompressedEdgeContainer::EdgeBucket CompressedEdgeContainer::GetBucket(const unsigned index) const
+{
+    const auto &range = m_compressed_geometries[index];
+    BOOST_ASSERT(range.size == 0 || range.offset != UNALLOCATED_OFFSET);
+    BOOST_ASSERT(range.size == 0 || range.offset + range.size <= m_compressed_edges.size());
+    const auto begin = m_compressed_edges.data() + range.offset;
+    return range.size == 0 ? EdgeBucket{} : EdgeBucket{begin, begin + range.size};
+}
+
+void CompressedEdgeContainer::MoveBucketToEnd(const unsigned index)
+{
+    auto &range = m_compressed_geometries[index];
+    if (range.size == 0)
+    {
+        range.offset = m_compressed_edges.size();
+        return;
+    }
+    if (range.offset + range.size == m_compressed_edges.size())
+    {
+        return;
+    }
+    // copied by position, the arena may be reallocated while it grows
+    const auto old_offset = range.offset;
+    range.offset = m_compressed_edges.size();
+    m_compressed_edges.resize(m_compressed_edges.size() + range.size);
+    std::copy(m_compressed_edges.begin() + old_offset,
+              m_compressed_edges.begin() + old_offset + range.size,
+              m_compressed_edges.begin() + range.offset);
+    m_unused_edges += range.size;
+}
+
+void CompressedEdgeContainer::Compact()
+{
+    if (m_unused_edges > 0)
+    {
+        LayOutBuckets();
+    }
+}
+
+// Copies the buckets into a new arena in the order of their ids, with room for the ones that
+// were sized by ResizeBucket
+void CompressedEdgeContainer::LayOutBuckets()
+{
+    std::uint64_t number_of_edges = 0;
+    for (const auto &range : m_compressed_geometries)
+    {
+        number_of_edges += range.size;
+    }
+    std::vector<CompressedEdge> compressed_edges;
+    compressed_edges.reserve(number_of_edges);
+    for (auto &range : m_compressed_geometries)
+    {
+        const auto offset = compressed_edges.size();
+        if (range.offset == UNALLOCATED_OFFSET)
+        {
+            compressed_edges.resize(offset + range.size);
+        }
+        else if (range.size > 0)
+        {
+            const auto begin = m_compressed_edges.begin() + range.offset;
+            compressed_edges.insert(compressed_edges.end(), begin, begin + range.size);
+        }
+        range.offset = offset;
+    }
+    m_compressed_edges.swap(compressed_edges);
+    m_unused_edges = 0;
 }
 
 void CompressedEdgeContainer::SerializeInternalVector(const std::string &path) const
 {
+    BOOST_ASSERT(std::numeric_limits<unsigned>::max() != m_compressed_geometries.size() + 1);
+
+    CompressedGeometryEncoder encoder;
+    for (const auto index : util::irange<std::size_t>(0, m_compressed_geometries.size()))
+    {
+        const auto bucket = GetBucket(index);
+        encoder.Append(bucket.begin(), bucket.end());
+    }
 
     boost::filesystem::fstream geometry_out_stream(path, std::ios::binary | std::ios::out);
-    const unsigned compressed_geometries = m_compressed_geometries.size() + 1;
-    BOOST_ASSERT(std::numeric_limits<unsigned>::max() != compressed_geometries);
-    geometry_out_stream.write((char *)&compressed_geometries, sizeof(unsigned));
+    encoder.Write(geometry_out_stream);
+}
 
-    // write indices array
-    unsigned prefix_sum_of_list_indices = 0;
-    for (const auto &elem : m_compressed_geometries)
+// Writes the lowest zoom level at which the overview simplification keeps each entry of the
+// compressed geometries, in the order of SerializeInternalVector.
+void CompressedEdgeContainer::SerializeZoomLevels(
+    const std::string &path, const std::vector<QueryNode> &internal_to_external_node_map) const
+{
+    std::vector<std::uint64_t> offsets;
+    offsets.reserve(m_compressed_geometries.size() + 1);
+    offsets.push_back(0);
+    for (const auto &range : m_compressed_geometries)
     {
-        geometry_out_stream.write((char *)&prefix_sum_of_list_indices, sizeof(unsigned));
-
-        const std::vector<CompressedEdge> &current_vector = elem;
-        const unsigned unpacked_size = current_vector.size();
-        BOOST_ASSERT(std::numeric_limits<unsigned>::max() != unpacked_size);
-        prefix_sum_of_list_indices += unpacked_size;
+        offsets.push_back(offsets.back() + range.size);
     }
-    // sentinel element
-    geometry_out_stream.write((char *)&prefix_sum_of_list_indices, sizeof(unsigned));
 
-    // number of geometry entries to follow, it is the (inclusive) prefix sum
-    geometry_out_stream.write((char *)&prefix_sum_of_list_indices, sizeof(unsigned));
+    std::vector<std::uint8_t> zoom_levels(offsets.back());
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, m_compressed_geometries.size()),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            std::vector<util::Coordinate> geometry;
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                geometry.clear();
+                for (const auto &compressed_edge : GetBucket(index))
+                {
+                    const auto &node = internal_to_external_node_map[compressed_edge.node_id];
+                    geometry.emplace_back(node.lon, node.lat);
+                }
+                const auto bucket_levels = engine::douglasPeuckerZoomLevels(geometry);
+                std::copy(bucket_levels.begin(),
+                          bucket_levels.end(),
+                          zoom_levels.begin() + offsets[index]);
+            }
+        });
+
+    boost::filesystem::ofstream zoom_levels_out_stream(path, std::ios::binary);
+    const std::uint64_t number_of_zoom_levels = zoom_levels.size();
+    zoom_levels_out_stream.write(reinterpret_cast<const char *>(&number_of_zoom_levels),
+                                 sizeof(number_of_zoom_levels));
+    zoom_levels_out_stream.write(reinterpret_cast<const char *>(zoom_levels.data()),
+                                 zoom_levels.size());
+}
 
-    unsigned control_sum = 0;
-    // write compressed geometries
-    for (auto &elem : m_compressed_geometries)
+// Writes the length of the segment that ends at each entry of the compressed geometries, in the
+// order of SerializeInternalVector. The buckets don't store the node they start at, that is the
+// source of their edge in the graph.
+void CompressedEdgeContainer::SerializeSegmentLengths(
+    const std::string &path,
+    const util::NodeBasedStaticGraph &graph,
+    const std::vector<QueryNode> &internal_to_external_node_map) const
+{
+    std::vector<NodeID> bucket_sources(m_compressed_geometries.size(), SPECIAL_NODEID);
+    for (const auto node : util::irange(0u, graph.GetNumberOfNodes()))
     {
-        const std::vector<CompressedEdge> &current_vector = elem;
-        const unsigned unpacked_size = current_vector.size();
-        control_sum += unpacked_size;
-        BOOST_ASSERT(std::numeric_limits<unsigned>::max() != unpacked_size);
-        for (const auto &current_node : current_vector)
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
         {
-            geometry_out_stream.write((char *)&(current_node), sizeof(CompressedEdge));
+            if (HasEntryForID(edge))
+            {
+                bucket_sources[GetPositionForID(edge)] = node;
+            }
         }
     }
-    BOOST_ASSERT(control_sum == prefix_sum_of_list_indices);
+
+    std::vector<std::uint64_t> offsets;
+    offsets.reserve(m_compressed_geometries.size() + 1);
+    offsets.push_back(0);
+    for (const auto &range : m_compressed_geometries)
+    {
+        offsets.push_back(offsets.back() + range.size);
+    }
+
+    const auto coordinate_of = [&internal_to_external_node_map](const NodeID node) {
+        const auto &query_node = internal_to_external_node_map[node];
+        return util::Coordinate{query_node.lon, query_node.lat};
+    };
+    std::vector<SegmentLength> lengths(offsets.back(), INVALID_SEGMENT_LENGTH);
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, m_compressed_geometries.size()),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                if (bucket_sources[index] == SPECIAL_NODEID)
+                {
+                    BOOST_ASSERT(m_compressed_geometries[index].size == 0);
+                    continue;
+                }
+                auto previous = coordinate_of(bucket_sources[index]);
+                auto length = lengths.begin() + offsets[index];
+                for (const auto &compressed_edge : GetBucket(index))
+                {
+                    const auto current = coordinate_of(compressed_edge.node_id);
+                    *length++ = static_cast<SegmentLength>(
+                        util::coordinate_calculation::haversineDistance(previous, current));
+                    previous = current;
+                }
+            }
+        });
+
+    boost::filesystem::ofstream lengths_out_stream(path, std::ios::binary);
+    const std::uint64_t number_of_lengths = lengths.size();
+    lengths_out_stream.write(reinterpret_cast<const char *>(&number_of_lengths),
+                             sizeof(number_of_lengths));
+    lengths_out_stream.write(reinterpret_cast<const char *>(lengths.data()),
+                             sizeof(SegmentLength) * lengths.size());
 }
 
 // Adds info for a compressed edge to the container.   edge_id_2
@@ -117,64 +325,56 @@ void CompressedEdgeContainer::CompressEdge(const EdgeID edge_id_1,
     // 2. find list for edge_id_2, if yes add all elements and delete it
 
     // Add via node id. List is created if it does not exist
-    if (!HasEntryForID(edge_id_1))
-    {
-        // create a new entry in the map
-        if (0 == m_free_list.size())
-        {
-            // make sure there is a place to put the entries
-            IncreaseFreeList();
-        }
-        BOOST_ASSERT(!m_free_list.empty());
-        m_edge_id_to_list_index_map[edge_id_1] = m_free_list.back();
-        m_free_list.pop_back();
-    }
-
-    // find bucket index
-    const auto iter = m_edge_id_to_list_index_map.find(edge_id_1);
-    BOOST_ASSERT(iter != m_edge_id_to_list_index_map.end());
-    const unsigned edge_bucket_id1 = iter->second;
-    BOOST_ASSERT(edge_bucket_id1 == GetPositionForID(edge_id_1));
+    const unsigned edge_bucket_id1 =
+        HasEntryForID(edge_id_1) ? GetPositionForID(edge_id_1) : AddEntryForID(edge_id_1);
     BOOST_ASSERT(edge_bucket_id1 < m_compressed_geometries.size());
 
-    std::vector<CompressedEdge> &edge_bucket_list1 = m_compressed_geometries[edge_bucket_id1];
+    // the bucket grows at the end of the arena
+    MoveBucketToEnd(edge_bucket_id1);
+    auto &edge_bucket_range1 = m_compressed_geometries[edge_bucket_id1];
 
     // note we don't save the start coordinate: it is implicitly given by edge 1
     // weight1 is the distance to the (currently) last coordinate in the bucket
-    if (edge_bucket_list1.empty())
+    if (edge_bucket_range1.size == 0)
     {
-        edge_bucket_list1.emplace_back(CompressedEdge{via_node_id, weight1});
+        m_compressed_edges.push_back(CompressedEdge{via_node_id, weight1});
+        ++edge_bucket_range1.size;
     }
 
-    BOOST_ASSERT(0 < edge_bucket_list1.size());
-    BOOST_ASSERT(!edge_bucket_list1.empty());
+    BOOST_ASSERT(0 < edge_bucket_range1.size);
 
     if (HasEntryForID(edge_id_2))
     {
         // second edge is not atomic anymore
         const unsigned list_to_remove_index = GetPositionForID(edge_id_2);
         BOOST_ASSERT(list_to_remove_index < m_compressed_geometries.size());
-
-        std::vector<CompressedEdge> &edge_bucket_list2 =
-            m_compressed_geometries[list_to_remove_index];
-
-        // found an existing list, append it to the list of edge_id_1
-        edge_bucket_list1.insert(
-            edge_bucket_list1.end(), edge_bucket_list2.begin(), edge_bucket_list2.end());
+        BOOST_ASSERT(list_to_remove_index != edge_bucket_id1);
+
+        // found an existing list, append it to the list of edge_id_1, by position since the
+        // arena may be reallocated while it grows
+        const auto edge_bucket_range2 = m_compressed_geometries[list_to_remove_index];
+        m_compressed_edges.resize(m_compressed_edges.size() + edge_bucket_range2.size);
+        std::copy(m_compressed_edges.begin() + edge_bucket_range2.offset,
+                  m_compressed_edges.begin() + edge_bucket_range2.offset +
+                      edge_bucket_range2.size,
+                  m_compressed_edges.end() - edge_bucket_range2.size);
+        edge_bucket_range1.size += edge_bucket_range2.size;
 
         // remove the list of edge_id_2
-        m_edge_id_to_list_index_map.erase(edge_id_2);
-        BOOST_ASSERT(m_edge_id_to_list_index_map.end() ==
-                     m_edge_id_to_list_index_map.find(edge_id_2));
-        edge_bucket_list2.clear();
-        BOOST_ASSERT(0 == edge_bucket_list2.size());
-        m_free_list.emplace_back(list_to_remove_index);
+        RemoveEntryForID(edge_id_2);
+        BOOST_ASSERT(0 == m_compressed_geometries[list_to_remove_index].size);
         BOOST_ASSERT(list_to_remove_index == m_free_list.back());
     }
     else
     {
         // we are certain that the second edge is atomic.
-        edge_bucket_list1.emplace_back(CompressedEdge{target_node_id, weight2});
+        m_compressed_edges.push_back(CompressedEdge{target_node_id, weight2});
+        ++edge_bucket_range1.size;
+    }
+
+    if (m_unused_edges > m_compressed_edges.size() / 2)
+    {
+        Compact();
     }
 }
 
@@ -188,37 +388,74 @@ void CompressedEdgeContainer::AddUncompressedEdge(const EdgeID edge_id,
     BOOST_ASSERT(INVALID_EDGE_WEIGHT != weight);
 
     // Add via node id. List is created if it does not exist
-    if (!HasEntryForID(edge_id))
-    {
-        // create a new entry in the map
-        if (0 == m_free_list.size())
-        {
-            // make sure there is a place to put the entries
-            IncreaseFreeList();
-        }
-        BOOST_ASSERT(!m_free_list.empty());
-        m_edge_id_to_list_index_map[edge_id] = m_free_list.back();
-        m_free_list.pop_back();
-    }
-
-    // find bucket index
-    const auto iter = m_edge_id_to_list_index_map.find(edge_id);
-    BOOST_ASSERT(iter != m_edge_id_to_list_index_map.end());
-    const unsigned edge_bucket_id = iter->second;
-    BOOST_ASSERT(edge_bucket_id == GetPositionForID(edge_id));
+    const unsigned edge_bucket_id =
+        HasEntryForID(edge_id) ? GetPositionForID(edge_id) : AddEntryForID(edge_id);
     BOOST_ASSERT(edge_bucket_id < m_compressed_geometries.size());
 
-    std::vector<CompressedEdge> &edge_bucket_list = m_compressed_geometries[edge_bucket_id];
+    auto &edge_bucket_range = m_compressed_geometries[edge_bucket_id];
 
     // note we don't save the start coordinate: it is implicitly given by edge_id
     // weight is the distance to the (currently) last coordinate in the bucket
     // Don't re-add this if it's already in there.
-    if (edge_bucket_list.empty())
+    if (edge_bucket_range.size == 0)
+    {
+        edge_bucket_range.offset = m_compressed_edges.size();
+        edge_bucket_range.size = 1;
+        m_compressed_edges.push_back(CompressedEdge{target_node_id, weight});
+    }
+}
+
+void CompressedEdgeContainer::ReserveCompressedEdge(const EdgeID surviving_edge_id,
+                                                    const EdgeID removed_edge_id)
+{
+    BOOST_ASSERT(SPECIAL_EDGEID != surviving_edge_id);
+    BOOST_ASSERT(SPECIAL_EDGEID != removed_edge_id);
+
+    if (!HasEntryForID(surviving_edge_id))
+    {
+        AddEntryForID(surviving_edge_id);
+    }
+    if (HasEntryForID(removed_edge_id))
     {
-        edge_bucket_list.emplace_back(CompressedEdge{target_node_id, weight});
+        RemoveEntryForID(removed_edge_id);
     }
 }
 
+void CompressedEdgeContainer::ReserveUncompressedEdge(const EdgeID edge_id)
+{
+    BOOST_ASSERT(SPECIAL_EDGEID != edge_id);
+
+    if (!HasEntryForID(edge_id))
+    {
+        AddEntryForID(edge_id);
+    }
+}
+
+void CompressedEdgeContainer::ResizeBucket(const EdgeID edge_id, const std::uint32_t size)
+{
+    auto &range = m_compressed_geometries[GetPositionForID(edge_id)];
+    BOOST_ASSERT(range.size == 0);
+    range.offset = UNALLOCATED_OFFSET;
+    range.size = size;
+}
+
+std::uint32_t CompressedEdgeContainer::GetBucketSize(const EdgeID edge_id) const
+{
+    return m_compressed_geometries[GetPositionForID(edge_id)].size;
+}
+
+void CompressedEdgeContainer::AllocateBuckets() { LayOutBuckets(); }
+
+CompressedEdgeContainer::MutableEdgeBucket
+CompressedEdgeContainer::GetMutableBucket(const EdgeID edge_id)
+{
+    const auto &range = m_compressed_geometries[GetPositionForID(edge_id)];
+    BOOST_ASSERT(range.offset != UNALLOCATED_OFFSET);
+    BOOST_ASSERT(range.offset + range.size <= m_compressed_edges.size());
+    const auto begin = m_compressed_edges.data() + range.offset;
+    return MutableEdgeBucket{begin, begin + range.size};
+}
+
 void CompressedEdgeContainer::PrintStatistics() const
 {
     const uint64_t compressed_edges = m_compressed_geometries.size();
@@ -227,10 +464,10 @@ void CompressedEdgeContainer::PrintStatistics() const
 
     uint64_t compressed_geometries = 0;
     uint64_t longest_chain_length = 0;
-    for (const std::vector<CompressedEdge> &current_vector : m_compressed_geometries)
+    for (const auto &range : m_compressed_geometries)
     {
-        compressed_geometries += current_vector.size();
-        longest_chain_length = std::max(longest_chain_length, (uint64_t)current_vector.size());
+        compressed_geometries += range.size;
+        longest_chain_length = std::max(longest_chain_length, (uint64_t)range.size);
     }
 
     util::SimpleLogger().Write()
@@ -243,11 +480,12 @@ void CompressedEdgeContainer::PrintStatistics() const
         << (float)compressed_geometries / std::max((uint64_t)1, compressed_edges);
 }
 
-const CompressedEdgeContainer::EdgeBucket &
+CompressedEdgeContainer::EdgeBucket
 CompressedEdgeContainer::GetBucketReference(const EdgeID edge_id) const
 {
-    const unsigned index = m_edge_id_to_list_index_map.at(edge_id);
-    return m_compressed_geometries.at(index);
+    const unsigned index = m_edge_id_to_list_index.at(edge_id);
+    BOOST_ASSERT(index < m_compressed_geometries.size());
+    return GetBucket(index);
 }
 
 // Since all edges are technically in the compressed geometry container,
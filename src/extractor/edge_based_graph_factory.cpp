@@ -5,6 +5,7 @@
 #include "util/exception.hpp"
 #include "util/integer_range.hpp"
 #include "util/percent.hpp"
+#include "util/phase_trace.hpp"
 #include "util/simple_logger.hpp"
 #include "util/timing_util.hpp"
 
@@ -17,6 +18,9 @@
 #include <boost/assert.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <algorithm>
 #include <cmath>
 #include <fstream>
@@ -25,15 +29,35 @@
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace osrm
 {
 namespace extractor
 {
+namespace
+{
+// Nodes whose turns are analyzed by a single task, and chunks buffered before they are written
+const constexpr NodeID NODES_PER_CHUNK = 1024;
+const constexpr NodeID CHUNKS_PER_BATCH = 64;
+
+// Result of the turn analysis of an edge, before lanes and ids are assigned
+struct AnalyzedEdge
+{
+    NodeID node_u;
+    EdgeID edge_from_u;
+    guidance::Intersection intersection;
+    // penalties of the turns onto all roads of the intersection
+    std::vector<std::int32_t> turn_penalties;
+    float edge_length;
+};
+}
+
 // Configuration to find representative candidate for turn angle calculations
 
 EdgeBasedGraphFactory::EdgeBasedGraphFactory(
-    std::shared_ptr<util::NodeBasedDynamicGraph> node_based_graph,
+    std::shared_ptr<util::NodeBasedStaticGraph> node_based_graph,
     const CompressedEdgeContainer &compressed_edge_container,
     const std::unordered_set<NodeID> &barrier_nodes,
     const std::unordered_set<NodeID> &traffic_lights,
@@ -55,7 +79,7 @@ EdgeBasedGraphFactory::EdgeBasedGraphFactory(
 }
 
 void EdgeBasedGraphFactory::GetEdgeBasedEdges(
-    util::DeallocatingVector<EdgeBasedEdge> &output_edge_list)
+    util::ChunkedVector<EdgeBasedEdge> &output_edge_list)
 {
     BOOST_ASSERT_MSG(0 == output_edge_list.size(), "Vector is not empty");
     using std::swap; // Koenig swap
@@ -89,6 +113,12 @@ void EdgeBasedGraphFactory::GetEdgeBasedNodeWeights(std::vector<EdgeWeight> &out
     swap(m_edge_based_node_weights, output_node_weights);
 }
 
+void EdgeBasedGraphFactory::GetEdgeBasedNodeClasses(std::vector<ClassData> &output_node_classes)
+{
+    using std::swap; // Koenig swap
+    swap(m_edge_based_node_classes, output_node_classes);
+}
+
 EdgeID EdgeBasedGraphFactory::GetHighestEdgeID() { return m_max_edge_id; }
 
 void EdgeBasedGraphFactory::InsertEdgeBasedNode(const NodeID node_u, const NodeID node_v)
@@ -192,21 +222,28 @@ void EdgeBasedGraphFactory::Run(ScriptingEnvironment &scripting_environment,
                                 const bool generate_edge_lookup)
 {
     TIMER_START(renumber);
+    util::PhaseTrace::ScopedPhase renumber_phase("renumber edges");
     m_max_edge_id = RenumberEdges() - 1;
+    renumber_phase.Stop();
     TIMER_STOP(renumber);
 
     TIMER_START(generate_nodes);
+    util::PhaseTrace::ScopedPhase nodes_phase("generate edge-based nodes");
     m_edge_based_node_weights.reserve(m_max_edge_id + 1);
+    m_edge_based_node_classes.reserve(m_max_edge_id + 1);
     GenerateEdgeExpandedNodes();
+    nodes_phase.Stop();
     TIMER_STOP(generate_nodes);
 
     TIMER_START(generate_edges);
+    util::PhaseTrace::ScopedPhase edges_phase("generate edge-based edges");
     GenerateEdgeExpandedEdges(scripting_environment,
                               original_edge_data_filename,
                               turn_lane_data_filename,
                               edge_segment_lookup_filename,
                               edge_penalty_filename,
                               generate_edge_lookup);
+    edges_phase.Stop();
 
     TIMER_STOP(generate_edges);
 
@@ -240,6 +277,7 @@ unsigned EdgeBasedGraphFactory::RenumberEdges()
             // of the street takes longer than the loop
             m_edge_based_node_weights.push_back(edge_data.distance +
                                                 profile_properties.u_turn_penalty);
+            m_edge_based_node_classes.push_back(edge_data.classes);
 
             BOOST_ASSERT(numbered_edges_count < m_node_based_graph->GetNumberOfEdges());
             edge_data.edge_id = numbered_edges_count;
@@ -359,194 +397,265 @@ void EdgeBasedGraphFactory::GenerateEdgeExpandedEdges(
     bearing_class_by_node_based_node.resize(m_node_based_graph->GetNumberOfNodes(),
                                             std::numeric_limits<std::uint32_t>::max());
 
-    for (const auto node_u : util::irange(0u, m_node_based_graph->GetNumberOfNodes()))
-    {
-        progress.PrintStatus(node_u);
-        for (const EdgeID edge_from_u : m_node_based_graph->GetAdjacentEdgeRange(node_u))
+    // read by the classification of the intersections, which runs in node order below
+    const auto edge_bearings = guidance::computeEdgeBearings(
+        *m_node_based_graph, m_compressed_edge_container, m_node_info_list);
+
+    // Turn analysis and the turn penalties of the profile only read the graph, so they are
+    // computed in parallel for chunks of nodes. The lanes, classes and edges are then created
+    // from the buffered intersections in node order, since they are numbered in the order
+    // they are encountered. This keeps the output the same as on a single thread.
+    const auto analyzeChunk = [&](const NodeID begin, const NodeID end) {
+        // neighbouring nodes look at the same intersections
+        guidance::IntersectionGenerator::CacheScope cache_scope(turn_analysis.getGenerator());
+        std::vector<AnalyzedEdge> analyzed_edges;
+        for (const auto node_u : util::irange(begin, end))
         {
-            if (m_node_based_graph->GetEdgeData(edge_from_u).reversed)
+            for (const EdgeID edge_from_u : m_node_based_graph->GetAdjacentEdgeRange(node_u))
             {
-                continue;
-            }
-
-            const NodeID node_v = m_node_based_graph->GetTarget(edge_from_u);
-            ++node_based_edge_counter;
-            auto intersection = turn_analysis.getIntersection(node_u, edge_from_u);
-            intersection =
-                turn_analysis.assignTurnTypes(node_u, edge_from_u, std::move(intersection));
-
-            intersection =
-                turn_lane_handler.assignTurnLanes(node_u, edge_from_u, std::move(intersection));
-            const auto possible_turns = turn_analysis.transformIntersectionIntoTurns(intersection);
-
-            // the entry class depends on the turn, so we have to classify the interesction for
-            // every edge
-            const auto turn_classification = classifyIntersection(node_v,
-                                                                  intersection,
-                                                                  *m_node_based_graph,
-                                                                  m_compressed_edge_container,
-                                                                  m_node_info_list);
-
-            const auto entry_class_id = [&](const util::guidance::EntryClass entry_class) {
-                if (0 == entry_class_hash.count(entry_class))
-                {
-                    const auto id = static_cast<std::uint16_t>(entry_class_hash.size());
-                    entry_class_hash[entry_class] = id;
-                    return id;
-                }
-                else
+                if (m_node_based_graph->GetEdgeData(edge_from_u).reversed)
                 {
-                    return entry_class_hash.find(entry_class)->second;
+                    continue;
                 }
-            }(turn_classification.first);
 
-            const auto bearing_class_id = [&](const util::guidance::BearingClass bearing_class) {
-                if (0 == bearing_class_hash.count(bearing_class))
-                {
-                    const auto id = static_cast<std::uint32_t>(bearing_class_hash.size());
-                    bearing_class_hash[bearing_class] = id;
-                    return id;
-                }
-                else
+                AnalyzedEdge analyzed_edge;
+                analyzed_edge.node_u = node_u;
+                analyzed_edge.edge_from_u = edge_from_u;
+                analyzed_edge.intersection = turn_analysis.assignTurnTypes(
+                    node_u, edge_from_u, turn_analysis.getIntersection(node_u, edge_from_u));
+
+                // lanes can still allow u-turns, so all roads get a penalty
+                for (const auto &road : analyzed_edge.intersection)
                 {
-                    return bearing_class_hash.find(bearing_class)->second;
+                    analyzed_edge.turn_penalties.push_back(
+                        scripting_environment.GetTurnPenalty(180. - road.turn.angle));
                 }
-            }(turn_classification.second);
-            bearing_class_by_node_based_node[node_v] = bearing_class_id;
-
-            for (const auto turn : possible_turns)
-            {
-                // only add an edge if turn is not prohibited
-                const EdgeData &edge_data1 = m_node_based_graph->GetEdgeData(edge_from_u);
-                const EdgeData &edge_data2 = m_node_based_graph->GetEdgeData(turn.eid);
-
-                BOOST_ASSERT(edge_data1.edge_id != edge_data2.edge_id);
-                BOOST_ASSERT(!edge_data1.reversed);
-                BOOST_ASSERT(!edge_data2.reversed);
 
-                // the following is the core of the loop.
-                unsigned distance = edge_data1.distance;
-                if (m_traffic_lights.find(node_v) != m_traffic_lights.end())
+                // all turns start at the end of this edge, so they share the length of its
+                // geometry. This is summed up the same way the engine measures an unpacked route.
+                double length = 0;
+                NodeID previous = node_u;
+                for (const auto &segment :
+                     m_compressed_edge_container.GetBucketReference(edge_from_u))
                 {
-                    distance += profile_properties.traffic_signal_penalty;
+                    length += util::coordinate_calculation::haversineDistance(
+                        m_node_info_list[previous], m_node_info_list[segment.node_id]);
+                    previous = segment.node_id;
                 }
+                analyzed_edge.edge_length = static_cast<float>(length);
 
-                const int32_t turn_penalty =
-                    scripting_environment.GetTurnPenalty(180. - turn.angle);
-                const auto turn_instruction = turn.instruction;
+                analyzed_edges.push_back(std::move(analyzed_edge));
+            }
+        }
+        return analyzed_edges;
+    };
 
-                if (turn_instruction.direction_modifier == guidance::DirectionModifier::UTurn)
+    const NodeID number_of_nodes = m_node_based_graph->GetNumberOfNodes();
+    std::vector<std::vector<AnalyzedEdge>> chunks;
+    for (NodeID batch_begin = 0; batch_begin < number_of_nodes;
+         batch_begin += NODES_PER_CHUNK * CHUNKS_PER_BATCH)
+    {
+        progress.PrintStatus(batch_begin);
+        const NodeID batch_end =
+            std::min<NodeID>(number_of_nodes, batch_begin + NODES_PER_CHUNK * CHUNKS_PER_BATCH);
+        const std::size_t number_of_chunks =
+            (batch_end - batch_begin + NODES_PER_CHUNK - 1) / NODES_PER_CHUNK;
+        chunks.resize(number_of_chunks);
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_chunks, 1),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              for (auto chunk = range.begin(); chunk != range.end(); ++chunk)
+                              {
+                                  const NodeID begin = batch_begin + chunk * NODES_PER_CHUNK;
+                                  chunks[chunk] = analyzeChunk(
+                                      begin, std::min(batch_end, begin + NODES_PER_CHUNK));
+                              }
+                          });
+
+        for (auto &chunk : chunks)
+        {
+            for (auto &analyzed_edge : chunk)
+            {
+                const NodeID node_u = analyzed_edge.node_u;
+                const EdgeID edge_from_u = analyzed_edge.edge_from_u;
+                const NodeID node_v = m_node_based_graph->GetTarget(edge_from_u);
+                const float edge_length = analyzed_edge.edge_length;
+                ++node_based_edge_counter;
+
+                const auto intersection = turn_lane_handler.assignTurnLanes(
+                    node_u, edge_from_u, std::move(analyzed_edge.intersection));
+
+                // the entry class depends on the turn, so we have to classify the interesction
+                // for every edge
+                const auto turn_classification =
+                    classifyIntersection(node_v,
+                                         intersection,
+                                         *m_node_based_graph,
+                                         m_compressed_edge_container,
+                                         m_node_info_list,
+                                         edge_bearings);
+
+                // classes get the next id when they are seen first, with a single lookup
+                const auto entry_class_id =
+                    entry_class_hash
+                        .emplace(turn_classification.first,
+                                 static_cast<std::uint16_t>(entry_class_hash.size()))
+                        .first->second;
+
+                const auto bearing_class_id =
+                    bearing_class_hash
+                        .emplace(turn_classification.second,
+                                 static_cast<std::uint32_t>(bearing_class_hash.size()))
+                        .first->second;
+                bearing_class_by_node_based_node[node_v] = bearing_class_id;
+
+                for (const auto road_index : util::irange<std::size_t>(0, intersection.size()))
                 {
-                    distance += profile_properties.u_turn_penalty;
-                }
+                    if (!intersection[road_index].entry_allowed)
+                    {
+                        continue;
+                    }
+                    const auto &turn = intersection[road_index].turn;
 
-                distance += turn_penalty;
+                    // only add an edge if turn is not prohibited
+                    const EdgeData &edge_data1 = m_node_based_graph->GetEdgeData(edge_from_u);
+                    const EdgeData &edge_data2 = m_node_based_graph->GetEdgeData(turn.eid);
 
-                BOOST_ASSERT(m_compressed_edge_container.HasEntryForID(edge_from_u));
-                original_edge_data_vector.emplace_back(
-                    m_compressed_edge_container.GetPositionForID(edge_from_u),
-                    edge_data1.name_id,
-                    turn.lane_data_id,
-                    turn_instruction,
-                    entry_class_id,
-                    edge_data1.travel_mode);
+                    BOOST_ASSERT(edge_data1.edge_id != edge_data2.edge_id);
+                    BOOST_ASSERT(!edge_data1.reversed);
+                    BOOST_ASSERT(!edge_data2.reversed);
 
-                ++original_edges_counter;
+                    // the following is the core of the loop.
+                    unsigned distance = edge_data1.distance;
+                    if (m_traffic_lights.find(node_v) != m_traffic_lights.end())
+                    {
+                        distance += profile_properties.traffic_signal_penalty;
+                    }
 
-                if (original_edge_data_vector.size() > 1024 * 1024 * 10)
-                {
-                    FlushVectorToStream(edge_data_file, original_edge_data_vector);
-                }
+                    const int32_t turn_penalty = analyzed_edge.turn_penalties[road_index];
+                    const auto turn_instruction = turn.instruction;
 
-                BOOST_ASSERT(SPECIAL_NODEID != edge_data1.edge_id);
-                BOOST_ASSERT(SPECIAL_NODEID != edge_data2.edge_id);
-
-                // NOTE: potential overflow here if we hit 2^32 routable edges
-                BOOST_ASSERT(m_edge_based_edge_list.size() <= std::numeric_limits<NodeID>::max());
-                m_edge_based_edge_list.emplace_back(edge_data1.edge_id,
-                                                    edge_data2.edge_id,
-                                                    m_edge_based_edge_list.size(),
-                                                    distance,
-                                                    true,
-                                                    false);
-
-                // Here is where we write out the mapping between the edge-expanded edges, and
-                // the node-based edges that are originally used to calculate the `distance`
-                // for the edge-expanded edges.  About 40 lines back, there is:
-                //
-                //                 unsigned distance = edge_data1.distance;
-                //
-                // This tells us that the weight for an edge-expanded-edge is based on the weight
-                // of the *source* node-based edge.  Therefore, we will look up the individual
-                // segments of the source node-based edge, and write out a mapping between
-                // those and the edge-based-edge ID.
-                // External programs can then use this mapping to quickly perform
-                // updates to the edge-expanded-edge based directly on its ID.
-                if (generate_edge_lookup)
-                {
-                    const auto node_based_edges =
-                        m_compressed_edge_container.GetBucketReference(edge_from_u);
-                    NodeID previous = node_u;
+                    if (turn_instruction.direction_modifier == guidance::DirectionModifier::UTurn)
+                    {
+                        distance += profile_properties.u_turn_penalty;
+                    }
 
-                    const unsigned node_count = node_based_edges.size() + 1;
-                    const QueryNode &first_node = m_node_info_list[previous];
+                    distance += turn_penalty;
 
-                    lookup::SegmentHeaderBlock header = {node_count, first_node.node_id};
+                    BOOST_ASSERT(m_compressed_edge_container.HasEntryForID(edge_from_u));
+                    original_edge_data_vector.emplace_back(
+                        m_compressed_edge_container.GetPositionForID(edge_from_u),
+                        edge_data1.name_id,
+                        turn.lane_data_id,
+                        turn_instruction,
+                        entry_class_id,
+                        edge_data1.travel_mode);
 
-                    edge_segment_file.write(reinterpret_cast<const char *>(&header),
-                                            sizeof(header));
+                    ++original_edges_counter;
 
-                    for (auto target_node : node_based_edges)
+                    if (original_edge_data_vector.size() > 1024 * 1024 * 10)
                     {
-                        const QueryNode &from = m_node_info_list[previous];
-                        const QueryNode &to = m_node_info_list[target_node.node_id];
-                        const double segment_length =
-                            util::coordinate_calculation::greatCircleDistance(from, to);
-
-                        lookup::SegmentBlock nodeblock = {
-                            to.node_id, segment_length, target_node.weight};
-
-                        edge_segment_file.write(reinterpret_cast<const char *>(&nodeblock),
-                                                sizeof(nodeblock));
-                        previous = target_node.node_id;
+                        FlushVectorToStream(edge_data_file, original_edge_data_vector);
                     }
 
-                    // We also now write out the mapping between the edge-expanded edges and the
-                    // original nodes. Since each edge represents a possible maneuver, external
-                    // programs can use this to quickly perform updates to edge weights in order
-                    // to penalize certain turns.
-
-                    // If this edge is 'trivial' -- where the compressed edge corresponds
-                    // exactly to an original OSM segment -- we can pull the turn's preceding
-                    // node ID directly with `node_u`; otherwise, we need to look up the node
-                    // immediately preceding the turn from the compressed edge container.
-                    const bool isTrivial = m_compressed_edge_container.IsTrivial(edge_from_u);
-
-                    const auto &from_node =
-                        isTrivial
-                            ? m_node_info_list[node_u]
-                            : m_node_info_list[m_compressed_edge_container.GetLastEdgeSourceID(
-                                  edge_from_u)];
-                    const auto &via_node =
-                        m_node_info_list[m_compressed_edge_container.GetLastEdgeTargetID(
-                            edge_from_u)];
-                    const auto &to_node =
-                        m_node_info_list[m_compressed_edge_container.GetFirstEdgeTargetID(
-                            turn.eid)];
-
-                    const unsigned fixed_penalty = distance - edge_data1.distance;
-                    lookup::PenaltyBlock penaltyblock = {
-                        fixed_penalty, from_node.node_id, via_node.node_id, to_node.node_id};
-                    edge_penalty_file.write(reinterpret_cast<const char *>(&penaltyblock),
-                                            sizeof(penaltyblock));
+                    BOOST_ASSERT(SPECIAL_NODEID != edge_data1.edge_id);
+                    BOOST_ASSERT(SPECIAL_NODEID != edge_data2.edge_id);
+
+                    // NOTE: potential overflow here if we hit 2^32 routable edges
+                    BOOST_ASSERT(m_edge_based_edge_list.size() <=
+                                 std::numeric_limits<NodeID>::max());
+                    m_edge_based_edge_list.emplace_back(edge_data1.edge_id,
+                                                        edge_data2.edge_id,
+                                                        m_edge_based_edge_list.size(),
+                                                        distance,
+                                                        edge_length,
+                                                        true,
+                                                        false);
+
+                    // Here is where we write out the mapping between the edge-expanded edges, and
+                    // the node-based edges that are originally used to calculate the `distance`
+                    // for the edge-expanded edges.  About 40 lines back, there is:
+                    //
+                    //                 unsigned distance = edge_data1.distance;
+                    //
+                    // This tells us that the weight for an edge-expanded-edge is based on the
+                    // weight of the *source* node-based edge.  Therefore, we will look up the
+                    // individual segments of the source node-based edge, and write out a mapping
+                    // between those and the edge-based-edge ID.
+                    // External programs can then use this mapping to quickly perform
+                    // updates to the edge-expanded-edge based directly on its ID.
+                    if (generate_edge_lookup)
+                    {
+                        const auto node_based_edges =
+                            m_compressed_edge_container.GetBucketReference(edge_from_u);
+                        NodeID previous = node_u;
+
+                        const unsigned node_count = node_based_edges.size() + 1;
+                        const QueryNode &first_node = m_node_info_list[previous];
+
+                        lookup::SegmentHeaderBlock header = {node_count, first_node.node_id};
+
+                        edge_segment_file.write(reinterpret_cast<const char *>(&header),
+                                                sizeof(header));
+
+                        for (auto target_node : node_based_edges)
+                        {
+                            const QueryNode &from = m_node_info_list[previous];
+                            const QueryNode &to = m_node_info_list[target_node.node_id];
+                            const double segment_length =
+                                util::coordinate_calculation::greatCircleDistance(from, to);
+
+                            lookup::SegmentBlock nodeblock = {
+                                to.node_id, segment_length, target_node.weight};
+
+                            edge_segment_file.write(reinterpret_cast<const char *>(&nodeblock),
+                                                    sizeof(nodeblock));
+                            previous = target_node.node_id;
+                        }
+
+                        // We also now write out the mapping between the edge-expanded edges and the
+                        // original nodes. Since each edge represents a possible maneuver, external
+                        // programs can use this to quickly perform updates to edge weights in order
+                        // to penalize certain turns.
+
+                        // If this edge is 'trivial' -- where the compressed edge corresponds
+                        // exactly to an original OSM segment -- we can pull the turn's preceding
+                        // node ID directly with `node_u`; otherwise, we need to look up the node
+                        // immediately preceding the turn from the compressed edge container.
+                        const bool isTrivial = m_compressed_edge_container.IsTrivial(edge_from_u);
+
+                        const auto &from_node =
+                            isTrivial
+                                ? m_node_info_list[node_u]
+                                : m_node_info_list[m_compressed_edge_container.GetLastEdgeSourceID(
+                                      edge_from_u)];
+                        const auto &via_node =
+                            m_node_info_list[m_compressed_edge_container.GetLastEdgeTargetID(
+                                edge_from_u)];
+                        const auto &to_node =
+                            m_node_info_list[m_compressed_edge_container.GetFirstEdgeTargetID(
+                                turn.eid)];
+
+                        const unsigned fixed_penalty = distance - edge_data1.distance;
+                        lookup::PenaltyBlock penaltyblock = {
+                            fixed_penalty, from_node.node_id, via_node.node_id, to_node.node_id};
+                        edge_penalty_file.write(reinterpret_cast<const char *>(&penaltyblock),
+                                                sizeof(penaltyblock));
+                    }
                 }
             }
+            chunk.clear();
         }
     }
 
     util::SimpleLogger().Write() << "Created " << entry_class_hash.size() << " entry classes and "
                                  << bearing_class_hash.size() << " Bearing Classes";
 
+    const auto &intersection_generator = turn_analysis.getGenerator();
+    util::SimpleLogger().Write()
+        << "Computed the roads of " << intersection_generator.GetNumberOfComputedConnectedRoads()
+        << " intersections, reused "
+        << intersection_generator.GetNumberOfCachedConnectedRoads();
+
     util::SimpleLogger().Write() << "Writing Turn Lane Data to File...";
     std::ofstream turn_lane_data_file(turn_lane_data_filename.c_str(), std::ios::binary);
     std::vector<util::guidance::LaneTupelIdPair> lane_data(lane_data_map.size());
@@ -1,12 +1,16 @@
 #include "extractor/extraction_containers.hpp"
+#include "extractor/extraction_segment.hpp"
 #include "extractor/extraction_way.hpp"
+#include "extractor/hybrid_sort.hpp"
 
 #include "util/coordinate_calculation.hpp"
 #include "util/range_table.hpp"
 
 #include "util/exception.hpp"
 #include "util/fingerprint.hpp"
+#include "util/integer_range.hpp"
 #include "util/io.hpp"
+#include "util/phase_trace.hpp"
 #include "util/simple_logger.hpp"
 #include "util/timing_util.hpp"
 
@@ -16,10 +20,14 @@
 #include <boost/numeric/conversion/cast.hpp>
 #include <boost/ref.hpp>
 
-#include <stxxl/sort>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
+#include <algorithm>
 #include <chrono>
+#include <iterator>
 #include <limits>
+#include <vector>
 
 namespace
 {
@@ -35,30 +43,6 @@ struct OSMNodeIDSTXXLLess
     value_type min_value() { return MIN_OSM_NODEID; }
 };
 
-struct CmpEdgeByOSMStartID
-{
-    using value_type = oe::InternalExtractorEdge;
-    bool operator()(const value_type &lhs, const value_type &rhs) const
-    {
-        return lhs.result.osm_source_id < rhs.result.osm_source_id;
-    }
-
-    value_type max_value() { return value_type::max_osm_value(); }
-    value_type min_value() { return value_type::min_osm_value(); }
-};
-
-struct CmpEdgeByOSMTargetID
-{
-    using value_type = oe::InternalExtractorEdge;
-    bool operator()(const value_type &lhs, const value_type &rhs) const
-    {
-        return lhs.result.osm_target_id < rhs.result.osm_target_id;
-    }
-
-    value_type max_value() { return value_type::max_osm_value(); }
-    value_type min_value() { return value_type::min_osm_value(); }
-};
-
 struct CmpEdgeByInternalSourceTargetAndName
 {
     using value_type = oe::InternalExtractorEdge;
@@ -83,7 +67,7 @@ struct CmpEdgeByInternalSourceTargetAndName
             return true;
 
         BOOST_ASSERT(!name_offsets.empty() && name_offsets.back() == name_data.size());
-        const oe::ExtractionContainers::STXXLNameCharData::const_iterator data = name_data.begin();
+        const auto data = name_data.begin();
         return std::lexicographical_compare(data + name_offsets[lhs.result.name_id],
                                             data + name_offsets[lhs.result.name_id + 1],
                                             data + name_offsets[rhs.result.name_id],
@@ -93,8 +77,8 @@ struct CmpEdgeByInternalSourceTargetAndName
     value_type max_value() { return value_type::max_internal_value(); }
     value_type min_value() { return value_type::min_internal_value(); }
 
-    const oe::ExtractionContainers::STXXLNameCharData &name_data;
-    const oe::ExtractionContainers::STXXLNameOffsets &name_offsets;
+    const std::vector<unsigned char> &name_data;
+    const std::vector<unsigned> &name_offsets;
 };
 }
 
@@ -105,7 +89,8 @@ namespace extractor
 
 static const int WRITE_BLOCK_BUFFER_SIZE = 8000;
 
-ExtractionContainers::ExtractionContainers()
+ExtractionContainers::ExtractionContainers(const std::size_t sort_memory)
+    : sort_memory(sort_memory)
 {
     // Check if stxxl can be instantiated
     stxxl::vector<unsigned> dummy_vector;
@@ -151,6 +136,7 @@ void ExtractionContainers::PrepareData(ScriptingEnvironment &scripting_environme
 
 void ExtractionContainers::WriteCharData(const std::string &file_name)
 {
+    const util::PhaseTrace::ScopedPhase phase("write names");
     std::cout << "[extractor] writing street name index ... " << std::flush;
     TIMER_START(write_index);
     boost::filesystem::ofstream file_stream(file_name, std::ios::binary);
@@ -197,10 +183,13 @@ void ExtractionContainers::WriteCharData(const std::string &file_name)
 
 void ExtractionContainers::PrepareNodes()
 {
+    const util::PhaseTrace::ScopedPhase phase("prepare nodes");
     std::cout << "[extractor] Sorting used nodes        ... " << std::flush;
     TIMER_START(sorting_used_nodes);
-    stxxl::sort(
-        used_node_id_list.begin(), used_node_id_list.end(), OSMNodeIDSTXXLLess(), stxxl_memory);
+    {
+        const util::PhaseTrace::ScopedPhase sort_phase("sort used nodes");
+        hybridSort(used_node_id_list, OSMNodeIDSTXXLLess(), sort_memory);
+    }
     TIMER_STOP(sorting_used_nodes);
     std::cout << "ok, after " << TIMER_SEC(sorting_used_nodes) << "s" << std::endl;
 
@@ -213,16 +202,19 @@ void ExtractionContainers::PrepareNodes()
 
     std::cout << "[extractor] Sorting all nodes         ... " << std::flush;
     TIMER_START(sorting_nodes);
-    stxxl::sort(all_nodes_list.begin(),
-                all_nodes_list.end(),
-                ExternalMemoryNodeSTXXLCompare(),
-                stxxl_memory);
+    {
+        const util::PhaseTrace::ScopedPhase sort_phase("sort nodes");
+        hybridSort(all_nodes_list, ExternalMemoryNodeSTXXLCompare(), sort_memory);
+    }
     TIMER_STOP(sorting_nodes);
     std::cout << "ok, after " << TIMER_SEC(sorting_nodes) << "s" << std::endl;
 
     std::cout << "[extractor] Building node id map      ... " << std::flush;
     TIMER_START(id_map);
-    external_to_internal_node_id_map.reserve(used_node_id_list.size());
+    internal_to_external_node_id_map.clear();
+    internal_node_coordinates.clear();
+    internal_to_external_node_id_map.reserve(used_node_id_list.size());
+    internal_node_coordinates.reserve(used_node_id_list.size());
     auto node_iter = all_nodes_list.begin();
     auto ref_iter = used_node_id_list.begin();
     const auto all_nodes_list_end = all_nodes_list.end();
@@ -247,7 +239,9 @@ void ExtractionContainers::PrepareNodes()
             continue;
         }
         BOOST_ASSERT(node_iter->node_id == *ref_iter);
-        external_to_internal_node_id_map[*ref_iter] = static_cast<NodeID>(internal_id++);
+        internal_to_external_node_id_map.push_back(*ref_iter);
+        internal_node_coordinates.emplace_back(node_iter->lon, node_iter->lat);
+        internal_id++;
         node_iter++;
         ref_iter++;
     }
@@ -261,126 +255,59 @@ void ExtractionContainers::PrepareNodes()
     std::cout << "ok, after " << TIMER_SEC(id_map) << "s" << std::endl;
 }
 
-void ExtractionContainers::PrepareEdges(ScriptingEnvironment &scripting_environment)
+NodeID ExtractionContainers::GetInternalNodeID(const OSMNodeID node_id) const
 {
-    // Sort edges by start.
-    std::cout << "[extractor] Sorting edges by start    ... " << std::flush;
-    TIMER_START(sort_edges_by_start);
-    stxxl::sort(all_edges_list.begin(), all_edges_list.end(), CmpEdgeByOSMStartID(), stxxl_memory);
-    TIMER_STOP(sort_edges_by_start);
-    std::cout << "ok, after " << TIMER_SEC(sort_edges_by_start) << "s" << std::endl;
-
-    std::cout << "[extractor] Setting start coords      ... " << std::flush;
-    TIMER_START(set_start_coords);
-    // Traverse list of edges and nodes in parallel and set start coord
-    auto node_iterator = all_nodes_list.begin();
-    auto edge_iterator = all_edges_list.begin();
-
-    const auto all_edges_list_end = all_edges_list.end();
-    const auto all_nodes_list_end = all_nodes_list.end();
-
-    while (edge_iterator != all_edges_list_end && node_iterator != all_nodes_list_end)
+    const auto iter = std::lower_bound(internal_to_external_node_id_map.begin(),
+                                       internal_to_external_node_id_map.end(),
+                                       node_id);
+    if (iter == internal_to_external_node_id_map.end() || *iter != node_id)
     {
-        if (edge_iterator->result.osm_source_id < node_iterator->node_id)
-        {
-            util::SimpleLogger().Write(LogLevel::logDEBUG) << "Found invalid node reference "
-                                                           << edge_iterator->result.source;
-            edge_iterator->result.source = SPECIAL_NODEID;
-            ++edge_iterator;
-            continue;
-        }
-        if (edge_iterator->result.osm_source_id > node_iterator->node_id)
-        {
-            node_iterator++;
-            continue;
-        }
-
-        // remove loops
-        if (edge_iterator->result.osm_source_id == edge_iterator->result.osm_target_id)
-        {
-            edge_iterator->result.source = SPECIAL_NODEID;
-            edge_iterator->result.target = SPECIAL_NODEID;
-            ++edge_iterator;
-            continue;
-        }
-
-        BOOST_ASSERT(edge_iterator->result.osm_source_id == node_iterator->node_id);
-
-        // assign new node id
-        auto id_iter = external_to_internal_node_id_map.find(node_iterator->node_id);
-        BOOST_ASSERT(id_iter != external_to_internal_node_id_map.end());
-        edge_iterator->result.source = id_iter->second;
-
-        edge_iterator->source_coordinate.lat = node_iterator->lat;
-        edge_iterator->source_coordinate.lon = node_iterator->lon;
-        ++edge_iterator;
+        return SPECIAL_NODEID;
     }
+    return static_cast<NodeID>(std::distance(internal_to_external_node_id_map.begin(), iter));
+}
 
-    // Remove all remaining edges. They are invalid because there are no corresponding nodes for
-    // them. This happens when using osmosis with bbox or polygon to extract smaller areas.
-    auto markSourcesInvalid = [](InternalExtractorEdge &edge) {
-        util::SimpleLogger().Write(LogLevel::logDEBUG) << "Found invalid node reference "
-                                                       << edge.result.source;
-        edge.result.source = SPECIAL_NODEID;
-        edge.result.osm_source_id = SPECIAL_OSM_NODEID;
-    };
-    std::for_each(edge_iterator, all_edges_list_end, markSourcesInvalid);
-    TIMER_STOP(set_start_coords);
-    std::cout << "ok, after " << TIMER_SEC(set_start_coords) << "s" << std::endl;
-
-    // Sort Edges by target
-    std::cout << "[extractor] Sorting edges by target   ... " << std::flush;
-    TIMER_START(sort_edges_by_target);
-    stxxl::sort(all_edges_list.begin(), all_edges_list.end(), CmpEdgeByOSMTargetID(), stxxl_memory);
-    TIMER_STOP(sort_edges_by_target);
-    std::cout << "ok, after " << TIMER_SEC(sort_edges_by_target) << "s" << std::endl;
-
-    // Compute edge weights
-    std::cout << "[extractor] Computing edge weights    ... " << std::flush;
-    TIMER_START(compute_weights);
-    node_iterator = all_nodes_list.begin();
-    edge_iterator = all_edges_list.begin();
-    const auto all_edges_list_end_ = all_edges_list.end();
-    const auto all_nodes_list_end_ = all_nodes_list.end();
-
-    while (edge_iterator != all_edges_list_end_ && node_iterator != all_nodes_list_end_)
-    {
-        // skip all invalid edges
-        if (edge_iterator->result.source == SPECIAL_NODEID)
+void ExtractionContainers::PrepareEdges(ScriptingEnvironment &scripting_environment)
+{
+    const util::PhaseTrace::ScopedPhase phase("prepare edges");
+    // Looks up the internal ids and the coordinates of the nodes, false for edges that are
+    // dropped. Both nodes of an edge are looked up in the sorted ids of the used nodes, which
+    // replaces sorting all edges by their OSM start and target ids to merge them with the nodes.
+    const auto resolveEdge = [&](InternalExtractorEdge &edge) {
+        // remove loops
+        if (edge.result.osm_source_id == edge.result.osm_target_id)
         {
-            ++edge_iterator;
-            continue;
+            edge.result.source = SPECIAL_NODEID;
+            edge.result.target = SPECIAL_NODEID;
+            return false;
         }
 
-        if (edge_iterator->result.osm_target_id < node_iterator->node_id)
+        // Edges without corresponding nodes are invalid. This happens when using osmosis with
+        // bbox or polygon to extract smaller areas.
+        edge.result.source = GetInternalNodeID(edge.result.osm_source_id);
+        if (edge.result.source == SPECIAL_NODEID)
         {
             util::SimpleLogger().Write(LogLevel::logDEBUG)
                 << "Found invalid node reference "
-                << static_cast<uint64_t>(edge_iterator->result.osm_target_id);
-            edge_iterator->result.target = SPECIAL_NODEID;
-            ++edge_iterator;
-            continue;
+                << static_cast<uint64_t>(edge.result.osm_source_id);
+            return false;
         }
-        if (edge_iterator->result.osm_target_id > node_iterator->node_id)
+        edge.result.target = GetInternalNodeID(edge.result.osm_target_id);
+        if (edge.result.target == SPECIAL_NODEID)
         {
-            ++node_iterator;
-            continue;
+            util::SimpleLogger().Write(LogLevel::logDEBUG)
+                << "Found invalid node reference "
+                << static_cast<uint64_t>(edge.result.osm_target_id);
+            return false;
         }
 
-        BOOST_ASSERT(edge_iterator->result.osm_target_id == node_iterator->node_id);
-        BOOST_ASSERT(edge_iterator->weight_data.speed >= 0);
-        BOOST_ASSERT(edge_iterator->source_coordinate.lat !=
-                     util::FixedLatitude{std::numeric_limits<std::int32_t>::min()});
-        BOOST_ASSERT(edge_iterator->source_coordinate.lon !=
-                     util::FixedLongitude{std::numeric_limits<std::int32_t>::min()});
-
-        const double distance = util::coordinate_calculation::greatCircleDistance(
-            edge_iterator->source_coordinate,
-            util::Coordinate(node_iterator->lon, node_iterator->lat));
-
-        scripting_environment.ProcessSegment(
-            edge_iterator->source_coordinate, *node_iterator, distance, edge_iterator->weight_data);
+        BOOST_ASSERT(edge.weight_data.speed >= 0);
+        edge.source_coordinate = internal_node_coordinates[edge.result.source];
+        return true;
+    };
 
+    // Computes the weight of the edge after the profile processed its segment
+    const auto weighEdge = [](InternalExtractorEdge &edge, const double distance) {
         const double weight = [distance](const InternalExtractorEdge::WeightData &data) {
             switch (data.type)
             {
@@ -395,48 +322,79 @@ void ExtractionContainers::PrepareEdges(ScriptingEnvironment &scripting_environm
                 util::exception("invalid weight type");
             }
             return -1.0;
-        }(edge_iterator->weight_data);
+        }(edge.weight_data);
 
-        auto &edge = edge_iterator->result;
-        edge.weight = std::max(1, static_cast<int>(std::floor(weight + .5)));
-
-        // assign new node id
-        auto id_iter = external_to_internal_node_id_map.find(node_iterator->node_id);
-        BOOST_ASSERT(id_iter != external_to_internal_node_id_map.end());
-        edge.target = id_iter->second;
+        auto &result = edge.result;
+        result.weight = std::max(1, static_cast<int>(std::floor(weight + .5)));
 
         // orient edges consistently: source id < target id
         // important for multi-edge removal
-        if (edge.source > edge.target)
+        if (result.source > result.target)
         {
-            std::swap(edge.source, edge.target);
+            std::swap(result.source, result.target);
 
             // std::swap does not work with bit-fields
-            bool temp = edge.forward;
-            edge.forward = edge.backward;
-            edge.backward = temp;
+            bool temp = result.forward;
+            result.forward = result.backward;
+            result.backward = temp;
         }
-        ++edge_iterator;
-    }
-
-    // Remove all remaining edges. They are invalid because there are no corresponding nodes for
-    // them. This happens when using osmosis with bbox or polygon to extract smaller areas.
-    auto markTargetsInvalid = [](InternalExtractorEdge &edge) {
-        util::SimpleLogger().Write(LogLevel::logDEBUG) << "Found invalid node reference "
-                                                       << edge.result.target;
-        edge.result.target = SPECIAL_NODEID;
     };
-    std::for_each(edge_iterator, all_edges_list_end_, markTargetsInvalid);
+
+    // Compute edge weights
+    std::cout << "[extractor] Computing edge weights    ... " << std::flush;
+    TIMER_START(compute_weights);
+    // stxxl vectors can't be accessed from several threads, so the edges are copied into memory
+    // in blocks that are processed in parallel
+    const std::size_t block_size =
+        std::max<std::size_t>(1, sort_memory / sizeof(InternalExtractorEdge));
+    std::vector<InternalExtractorEdge> block;
+    for (std::size_t begin = 0; begin < all_edges_list.size(); begin += block_size)
+    {
+        const std::size_t end = std::min<std::size_t>(all_edges_list.size(), begin + block_size);
+        block.assign(all_edges_list.begin() + begin, all_edges_list.begin() + end);
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, block.size()),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                // the segments of the range are handed to the profile at once
+                std::vector<InternalExtractorEdge *> edges;
+                std::vector<ExtractionSegment> segments;
+                for (auto index = range.begin(); index != range.end(); ++index)
+                {
+                    auto &edge = block[index];
+                    if (!resolveEdge(edge))
+                    {
+                        continue;
+                    }
+                    const auto &target_coordinate = internal_node_coordinates[edge.result.target];
+                    const double distance = util::coordinate_calculation::greatCircleDistance(
+                        edge.source_coordinate, target_coordinate);
+                    segments.push_back(ExtractionSegment{
+                        edge.source_coordinate, target_coordinate, distance, &edge.weight_data});
+                    edges.push_back(&edge);
+                }
+                scripting_environment.ProcessSegments(segments);
+                for (const auto index : util::irange<std::size_t>(0, edges.size()))
+                {
+                    weighEdge(*edges[index], segments[index].distance);
+                }
+            });
+        std::copy(block.begin(), block.end(), all_edges_list.begin() + begin);
+    }
     TIMER_STOP(compute_weights);
     std::cout << "ok, after " << TIMER_SEC(compute_weights) << "s" << std::endl;
 
     // Sort edges by start.
     std::cout << "[extractor] Sorting edges by renumbered start ... " << std::flush;
     TIMER_START(sort_edges_by_renumbered_start);
-    stxxl::sort(all_edges_list.begin(),
-                all_edges_list.end(),
-                CmpEdgeByInternalSourceTargetAndName{name_char_data, name_offsets},
-                stxxl_memory);
+    {
+        const util::PhaseTrace::ScopedPhase sort_phase("sort edges");
+        // the comparison is called from all threads, which can't read stxxl vectors concurrently
+        const std::vector<unsigned char> name_data(name_char_data.begin(), name_char_data.end());
+        const std::vector<unsigned> name_data_offsets(name_offsets.begin(), name_offsets.end());
+        hybridSort(all_edges_list,
+                   CmpEdgeByInternalSourceTargetAndName{name_data, name_data_offsets},
+                   sort_memory);
+    }
     TIMER_STOP(sort_edges_by_renumbered_start);
     std::cout << "ok, after " << TIMER_SEC(sort_edges_by_renumbered_start) << "s" << std::endl;
 
@@ -533,6 +491,7 @@ void ExtractionContainers::PrepareEdges(ScriptingEnvironment &scripting_environm
 
 void ExtractionContainers::WriteEdges(std::ofstream &file_out_stream) const
 {
+    const util::PhaseTrace::ScopedPhase phase("write edges");
     std::cout << "[extractor] Writing used edges       ... " << std::flush;
     TIMER_START(write_edges);
     // Traverse list of edges and nodes in parallel and set target coord
@@ -576,6 +535,7 @@ void ExtractionContainers::WriteEdges(std::ofstream &file_out_stream) const
 
 void ExtractionContainers::WriteNodes(std::ofstream &file_out_stream) const
 {
+    const util::PhaseTrace::ScopedPhase phase("write nodes");
     // write dummy value, will be overwritten later
     std::cout << "[extractor] setting number of nodes   ... " << std::flush;
     file_out_stream.write((char *)&max_internal_node_id, sizeof(unsigned));
@@ -616,6 +576,7 @@ void ExtractionContainers::WriteNodes(std::ofstream &file_out_stream) const
 
 void ExtractionContainers::WriteRestrictions(const std::string &path) const
 {
+    const util::PhaseTrace::ScopedPhase phase("write restrictions");
     // serialize restrictions
     std::ofstream restrictions_out_stream;
     unsigned written_restriction_count = 0;
@@ -643,198 +604,127 @@ void ExtractionContainers::WriteRestrictions(const std::string &path) const
 
 void ExtractionContainers::PrepareRestrictions()
 {
-    std::cout << "[extractor] Sorting used ways         ... " << std::flush;
-    TIMER_START(sort_ways);
-    stxxl::sort(way_start_end_id_list.begin(),
-                way_start_end_id_list.end(),
-                FirstAndLastSegmentOfWayStxxlCompare(),
-                stxxl_memory);
-    TIMER_STOP(sort_ways);
-    std::cout << "ok, after " << TIMER_SEC(sort_ways) << "s" << std::endl;
-
-    std::cout << "[extractor] Sorting " << restrictions_list.size() << " restriction. by from... "
-              << std::flush;
-    TIMER_START(sort_restrictions);
-    stxxl::sort(restrictions_list.begin(),
-                restrictions_list.end(),
-                CmpRestrictionContainerByFrom(),
-                stxxl_memory);
-    TIMER_STOP(sort_restrictions);
-    std::cout << "ok, after " << TIMER_SEC(sort_restrictions) << "s" << std::endl;
-
-    std::cout << "[extractor] Fixing restriction starts ... " << std::flush;
-    TIMER_START(fix_restriction_starts);
-    auto restrictions_iterator = restrictions_list.begin();
-    auto way_start_and_end_iterator = way_start_end_id_list.cbegin();
-    const auto restrictions_list_end = restrictions_list.end();
-    const auto way_start_end_id_list_end = way_start_end_id_list.cend();
-
-    while (way_start_and_end_iterator != way_start_end_id_list_end &&
-           restrictions_iterator != restrictions_list_end)
+    const util::PhaseTrace::ScopedPhase phase("prepare restrictions");
+    // Only the first and last segments of the ways restrictions start or end on are needed, so
+    // they are copied into memory and looked up by a binary search instead of sorting all ways
+    // and restrictions twice to merge them.
+    std::cout << "[extractor] Collecting restricted ways ... " << std::flush;
+    TIMER_START(collect_ways);
+    std::vector<OSMWayID> restricted_way_ids;
+    restricted_way_ids.reserve(2 * restrictions_list.size());
+    for (const auto &restriction_container : restrictions_list)
     {
-        if (way_start_and_end_iterator->way_id <
-            OSMWayID{static_cast<std::uint32_t>(restrictions_iterator->restriction.from.way)})
-        {
-            ++way_start_and_end_iterator;
-            continue;
-        }
-
-        if (way_start_and_end_iterator->way_id >
-            OSMWayID{static_cast<std::uint32_t>(restrictions_iterator->restriction.from.way)})
-        {
-            util::SimpleLogger().Write(LogLevel::logDEBUG)
-                << "Restriction references invalid way: "
-                << restrictions_iterator->restriction.from.way;
-            restrictions_iterator->restriction.from.node = SPECIAL_NODEID;
-            ++restrictions_iterator;
-            continue;
-        }
-
-        BOOST_ASSERT(
-            way_start_and_end_iterator->way_id ==
-            OSMWayID{static_cast<std::uint32_t>(restrictions_iterator->restriction.from.way)});
-        // we do not remap the via id yet, since we will need it for the to node as well
-        const OSMNodeID via_node_id = OSMNodeID{restrictions_iterator->restriction.via.node};
-
-        // check if via is actually valid, if not invalidate
-        auto via_id_iter = external_to_internal_node_id_map.find(via_node_id);
-        if (via_id_iter == external_to_internal_node_id_map.end())
-        {
-            util::SimpleLogger().Write(LogLevel::logDEBUG)
-                << "Restriction references invalid node: "
-                << restrictions_iterator->restriction.via.node;
-            restrictions_iterator->restriction.via.node = SPECIAL_NODEID;
-            ++restrictions_iterator;
-            continue;
-        }
+        const auto &restriction = restriction_container.restriction;
+        restricted_way_ids.push_back(OSMWayID{static_cast<std::uint32_t>(restriction.from.way)});
+        restricted_way_ids.push_back(OSMWayID{static_cast<std::uint32_t>(restriction.to.way)});
+    }
+    std::sort(restricted_way_ids.begin(), restricted_way_ids.end());
+    restricted_way_ids.erase(std::unique(restricted_way_ids.begin(), restricted_way_ids.end()),
+                             restricted_way_ids.end());
 
-        if (way_start_and_end_iterator->first_segment_source_id == via_node_id)
+    std::vector<FirstAndLastSegmentOfWay> restricted_ways;
+    for (const auto &way : way_start_end_id_list)
+    {
+        if (std::binary_search(restricted_way_ids.begin(), restricted_way_ids.end(), way.way_id))
         {
-            // assign new from node id
-            auto id_iter = external_to_internal_node_id_map.find(
-                way_start_and_end_iterator->first_segment_target_id);
-            if (id_iter == external_to_internal_node_id_map.end())
-            {
-                util::SimpleLogger().Write(LogLevel::logDEBUG)
-                    << "Way references invalid node: "
-                    << way_start_and_end_iterator->first_segment_target_id;
-                restrictions_iterator->restriction.from.node = SPECIAL_NODEID;
-                ++restrictions_iterator;
-                ++way_start_and_end_iterator;
-                continue;
-            }
-            restrictions_iterator->restriction.from.node = id_iter->second;
+            restricted_ways.push_back(way);
         }
-        else if (way_start_and_end_iterator->last_segment_target_id == via_node_id)
+    }
+    std::sort(
+        restricted_ways.begin(), restricted_ways.end(), FirstAndLastSegmentOfWayStxxlCompare());
+    TIMER_STOP(collect_ways);
+    std::cout << "ok, after " << TIMER_SEC(collect_ways) << "s" << std::endl;
+
+    const auto findWay = [&](const OSMEdgeID_weak way_id) -> const FirstAndLastSegmentOfWay * {
+        const OSMWayID id{static_cast<std::uint32_t>(way_id)};
+        const auto iter = std::lower_bound(
+            restricted_ways.begin(),
+            restricted_ways.end(),
+            id,
+            [](const FirstAndLastSegmentOfWay &way, const OSMWayID id) { return way.way_id < id; });
+        if (iter == restricted_ways.end() || iter->way_id != id)
         {
-            // assign new from node id
-            auto id_iter = external_to_internal_node_id_map.find(
-                way_start_and_end_iterator->last_segment_source_id);
-            if (id_iter == external_to_internal_node_id_map.end())
-            {
-                util::SimpleLogger().Write(LogLevel::logDEBUG)
-                    << "Way references invalid node: "
-                    << way_start_and_end_iterator->last_segment_target_id;
-                restrictions_iterator->restriction.from.node = SPECIAL_NODEID;
-                ++restrictions_iterator;
-                ++way_start_and_end_iterator;
-                continue;
-            }
-            restrictions_iterator->restriction.from.node = id_iter->second;
+            util::SimpleLogger().Write(LogLevel::logDEBUG) << "Restriction references invalid way: "
+                                                           << way_id;
+            return nullptr;
         }
-        ++restrictions_iterator;
-    }
+        return &*iter;
+    };
 
-    TIMER_STOP(fix_restriction_starts);
-    std::cout << "ok, after " << TIMER_SEC(fix_restriction_starts) << "s" << std::endl;
-
-    std::cout << "[extractor] Sorting restrictions. by to  ... " << std::flush;
-    TIMER_START(sort_restrictions_to);
-    stxxl::sort(restrictions_list.begin(),
-                restrictions_list.end(),
-                CmpRestrictionContainerByTo(),
-                stxxl_memory);
-    TIMER_STOP(sort_restrictions_to);
-    std::cout << "ok, after " << TIMER_SEC(sort_restrictions_to) << "s" << std::endl;
-
-    std::cout << "[extractor] Fixing restriction ends   ... " << std::flush;
-    TIMER_START(fix_restriction_ends);
-    restrictions_iterator = restrictions_list.begin();
-    way_start_and_end_iterator = way_start_end_id_list.cbegin();
-    const auto way_start_end_id_list_end_ = way_start_end_id_list.cend();
-    const auto restrictions_list_end_ = restrictions_list.end();
-
-    while (way_start_and_end_iterator != way_start_end_id_list_end_ &&
-           restrictions_iterator != restrictions_list_end_)
-    {
-        if (way_start_and_end_iterator->way_id <
-            OSMWayID{static_cast<std::uint32_t>(restrictions_iterator->restriction.to.way)})
+    // The internal id of the node next to via on the way, SPECIAL_NODEID if the way doesn't
+    // start or end at via or the node was dropped.
+    const auto findNodeNextToVia = [&](const FirstAndLastSegmentOfWay &way,
+                                       const OSMNodeID via_node_id) {
+        OSMNodeID node_id = SPECIAL_OSM_NODEID;
+        if (way.first_segment_source_id == via_node_id)
         {
-            ++way_start_and_end_iterator;
-            continue;
+            node_id = way.first_segment_target_id;
         }
-        if (restrictions_iterator->restriction.from.node == SPECIAL_NODEID ||
-            restrictions_iterator->restriction.via.node == SPECIAL_NODEID)
+        else if (way.last_segment_target_id == via_node_id)
         {
-            ++restrictions_iterator;
-            continue;
+            node_id = way.last_segment_source_id;
         }
-        if (way_start_and_end_iterator->way_id >
-            OSMWayID{static_cast<std::uint32_t>(restrictions_iterator->restriction.to.way)})
+        else
         {
             util::SimpleLogger().Write(LogLevel::logDEBUG)
-                << "Restriction references invalid way: "
-                << restrictions_iterator->restriction.to.way;
-            restrictions_iterator->restriction.to.way = SPECIAL_NODEID;
-            ++restrictions_iterator;
-            continue;
+                << "Restriction way " << static_cast<std::uint32_t>(way.way_id)
+                << " doesn't start or end at node " << static_cast<std::uint64_t>(via_node_id);
+            return SPECIAL_NODEID;
         }
-        BOOST_ASSERT(
-            way_start_and_end_iterator->way_id ==
-            OSMWayID{static_cast<std::uint32_t>(restrictions_iterator->restriction.to.way)});
-        const OSMNodeID via_node_id = OSMNodeID{restrictions_iterator->restriction.via.node};
-
-        // assign new via node id
-        auto via_id_iter = external_to_internal_node_id_map.find(via_node_id);
-        BOOST_ASSERT(via_id_iter != external_to_internal_node_id_map.end());
-        restrictions_iterator->restriction.via.node = via_id_iter->second;
 
-        if (way_start_and_end_iterator->first_segment_source_id == via_node_id)
+        const auto internal_id = GetInternalNodeID(node_id);
+        if (internal_id == SPECIAL_NODEID)
         {
-            auto to_id_iter = external_to_internal_node_id_map.find(
-                way_start_and_end_iterator->first_segment_target_id);
-            if (to_id_iter == external_to_internal_node_id_map.end())
-            {
-                util::SimpleLogger().Write(LogLevel::logDEBUG)
-                    << "Way references invalid node: "
-                    << way_start_and_end_iterator->first_segment_source_id;
-                restrictions_iterator->restriction.to.node = SPECIAL_NODEID;
-                ++restrictions_iterator;
-                ++way_start_and_end_iterator;
-                continue;
-            }
-            restrictions_iterator->restriction.to.node = to_id_iter->second;
+            util::SimpleLogger().Write(LogLevel::logDEBUG) << "Way references invalid node: "
+                                                           << static_cast<std::uint64_t>(node_id);
         }
-        else if (way_start_and_end_iterator->last_segment_target_id == via_node_id)
+        return internal_id;
+    };
+
+    // Replaces the OSM ids of from, via and to by internal node ids. Restrictions of which any
+    // can't be resolved get SPECIAL_NODEID there and are not written.
+    const auto resolveRestriction = [&](TurnRestriction &restriction) {
+        const OSMNodeID via_node_id = OSMNodeID{restriction.via.node};
+        const auto *from_way = findWay(restriction.from.way);
+        const auto *to_way = findWay(restriction.to.way);
+
+        restriction.via.node = GetInternalNodeID(via_node_id);
+        if (restriction.via.node == SPECIAL_NODEID)
         {
-            auto to_id_iter = external_to_internal_node_id_map.find(
-                way_start_and_end_iterator->last_segment_source_id);
-            if (to_id_iter == external_to_internal_node_id_map.end())
-            {
-                util::SimpleLogger().Write(LogLevel::logDEBUG)
-                    << "Way references invalid node: "
-                    << way_start_and_end_iterator->last_segment_source_id;
-                restrictions_iterator->restriction.to.node = SPECIAL_NODEID;
-                ++restrictions_iterator;
-                ++way_start_and_end_iterator;
-                continue;
-            }
-            restrictions_iterator->restriction.to.node = to_id_iter->second;
+            util::SimpleLogger().Write(LogLevel::logDEBUG)
+                << "Restriction references invalid node: "
+                << static_cast<std::uint64_t>(via_node_id);
         }
-        ++restrictions_iterator;
+        restriction.from.node =
+            from_way == nullptr ? SPECIAL_NODEID : findNodeNextToVia(*from_way, via_node_id);
+        restriction.to.node =
+            to_way == nullptr ? SPECIAL_NODEID : findNodeNextToVia(*to_way, via_node_id);
+    };
+
+    std::cout << "[extractor] Resolving " << restrictions_list.size() << " restrictions ... "
+              << std::flush;
+    TIMER_START(resolve_restrictions);
+    // stxxl vectors can't be accessed from several threads, so the restrictions are copied into
+    // memory in blocks that are resolved in parallel
+    const std::size_t block_size =
+        std::max<std::size_t>(1, sort_memory / sizeof(InputRestrictionContainer));
+    std::vector<InputRestrictionContainer> block;
+    for (std::size_t begin = 0; begin < restrictions_list.size(); begin += block_size)
+    {
+        const std::size_t end =
+            std::min<std::size_t>(restrictions_list.size(), begin + block_size);
+        block.assign(restrictions_list.begin() + begin, restrictions_list.begin() + end);
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, block.size()),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              for (auto index = range.begin(); index != range.end(); ++index)
+                              {
+                                  resolveRestriction(block[index].restriction);
+                              }
+                          });
+        std::copy(block.begin(), block.end(), restrictions_list.begin() + begin);
     }
-    TIMER_STOP(fix_restriction_ends);
-    std::cout << "ok, after " << TIMER_SEC(fix_restriction_ends) << "s" << std::endl;
+    TIMER_STOP(resolve_restrictions);
+    std::cout << "ok, after " << TIMER_SEC(resolve_restrictions) << "s" << std::endl;
 }
 }
 }
@@ -1,5 +1,8 @@
 #include "extractor/extractor.hpp"
 
+#include "extractor/change_merger.hpp"
+#include "extractor/class_data.hpp"
+#include "extractor/compressed_edge_based_edges.hpp"
 #include "extractor/edge_based_edge.hpp"
 #include "extractor/extraction_containers.hpp"
 #include "extractor/extraction_node.hpp"
@@ -7,12 +10,15 @@
 #include "extractor/extractor_callbacks.hpp"
 #include "extractor/restriction_parser.hpp"
 #include "extractor/scripting_environment.hpp"
+#include "extractor/way_results_cache.hpp"
 
 #include "extractor/raster_source.hpp"
 #include "util/graph_loader.hpp"
+#include "util/id_bitset.hpp"
 #include "util/io.hpp"
 #include "util/make_unique.hpp"
 #include "util/name_table.hpp"
+#include "util/phase_trace.hpp"
 #include "util/range_table.hpp"
 #include "util/simple_logger.hpp"
 #include "util/timing_util.hpp"
@@ -34,6 +40,7 @@
 #include <osmium/io/any_input.hpp>
 
 #include <tbb/concurrent_vector.h>
+#include <tbb/pipeline.h>
 #include <tbb/task_scheduler_init.h>
 
 #include <cstdlib>
@@ -45,11 +52,13 @@
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <numeric> //partial_sum
 #include <thread>
 #include <tuple>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -85,6 +94,124 @@ transformTurnLaneMapIntoArrays(const guidance::LaneDescriptionMap &turn_lane_map
                   turn_lane_masks.begin() + turn_lane_offsets[entry->second]);
     return std::make_tuple(std::move(turn_lane_offsets), std::move(turn_lane_masks));
 }
+
+// Reads the buffers of the input with the changes of --apply-changes applied
+class InputReader
+{
+  public:
+    InputReader(const osmium::io::File &input_file,
+                const osmium::osm_entity_bits::type entities,
+                ChangeMerger *change_merger)
+        : reader(input_file, entities), change_merger(change_merger), is_finished(false)
+    {
+        if (change_merger)
+        {
+            change_merger->Reset();
+        }
+    }
+
+    osmium::io::Header GetHeader() { return reader.header(); }
+
+    // nullptr at the end of the input
+    std::shared_ptr<const osmium::memory::Buffer> Read()
+    {
+        if (auto buffer = reader.read())
+        {
+            if (change_merger)
+            {
+                return std::make_shared<const osmium::memory::Buffer>(
+                    change_merger->Merge(buffer));
+            }
+            return std::make_shared<const osmium::memory::Buffer>(std::move(buffer));
+        }
+        if (change_merger && !is_finished)
+        {
+            is_finished = true;
+            return std::make_shared<const osmium::memory::Buffer>(change_merger->Finish());
+        }
+        return nullptr;
+    }
+
+  private:
+    osmium::io::Reader reader;
+    ChangeMerger *change_merger;
+    bool is_finished;
+};
+
+// The first pass of --two-pass, which runs the profile on the ways of the input and collects the
+// ways that ExtractorCallbacks turns into edges and their nodes. A planet has several times more
+// nodes than routable ways reference, the second pass then only keeps the referenced ones.
+void findRoutableWays(const osmium::io::File &input_file,
+                      ChangeMerger *change_merger,
+                      ScriptingEnvironment &scripting_environment,
+                      const RestrictionParser &restriction_parser,
+                      const std::size_t max_buffers_in_flight,
+                      util::IdBitset &routable_ways,
+                      util::IdBitset &referenced_nodes)
+{
+    InputReader reader(input_file, osmium::osm_entity_bits::way, change_merger);
+
+    using SharedBuffer = std::shared_ptr<const osmium::memory::Buffer>;
+    struct ParsedBuffer
+    {
+        SharedBuffer buffer;
+        std::vector<osmium::memory::Buffer::const_iterator> osm_elements;
+        tbb::concurrent_vector<std::pair<std::size_t, ExtractionNode>> resulting_nodes;
+        tbb::concurrent_vector<std::pair<std::size_t, ExtractionWay>> resulting_ways;
+        tbb::concurrent_vector<boost::optional<InputRestrictionContainer>> resulting_restrictions;
+    };
+    using SharedParsedBuffer = std::shared_ptr<ParsedBuffer>;
+
+    tbb::filter_t<void, SharedBuffer> buffer_reader(
+        tbb::filter::serial_in_order, [&reader](tbb::flow_control &flow_control) {
+            auto buffer = reader.Read();
+            if (!buffer)
+            {
+                flow_control.stop();
+            }
+            return buffer;
+        });
+
+    tbb::filter_t<SharedBuffer, SharedParsedBuffer> buffer_transform(
+        tbb::filter::parallel, [&](const SharedBuffer &buffer) {
+            auto parsed_buffer = std::make_shared<ParsedBuffer>();
+            parsed_buffer->buffer = buffer;
+            for (auto iter = std::begin(*buffer), end = std::end(*buffer); iter != end; ++iter)
+            {
+                parsed_buffer->osm_elements.push_back(iter);
+            }
+            scripting_environment.ProcessElements(parsed_buffer->osm_elements,
+                                                  restriction_parser,
+                                                  parsed_buffer->resulting_nodes,
+                                                  parsed_buffer->resulting_ways,
+                                                  parsed_buffer->resulting_restrictions);
+            return parsed_buffer;
+        });
+
+    tbb::filter_t<SharedParsedBuffer, void> buffer_storage(
+        tbb::filter::serial_in_order, [&](const SharedParsedBuffer &parsed_buffer) {
+            for (const auto &result : parsed_buffer->resulting_ways)
+            {
+                const auto &way =
+                    static_cast<const osmium::Way &>(*parsed_buffer->osm_elements[result.first]);
+                if (way.id() < 0 || !ExtractorCallbacks::IsRoutable(way, result.second))
+                {
+                    continue;
+                }
+                routable_ways.Add(way.id());
+                for (const auto &node : way.nodes())
+                {
+                    if (node.ref() >= 0)
+                    {
+                        referenced_nodes.Add(node.ref());
+                    }
+                }
+            }
+        });
+
+    tbb::parallel_pipeline(max_buffers_in_flight,
+                           buffer_reader & buffer_transform & buffer_storage);
+}
 } // namespace
 
 /**
@@ -107,6 +234,16 @@ transformTurnLaneMapIntoArrays(const guidance::LaneDescriptionMap &turn_lane_map
  *
  */
 int Extractor::run(ScriptingEnvironment &scripting_environment)
+{
+    return run(scripting_environment, nullptr);
+}
+
+int Extractor::run(ScriptingEnvironment &scripting_environment, EdgeBasedGraph &edge_based_graph)
+{
+    return run(scripting_environment, &edge_based_graph);
+}
+
+int Extractor::run(ScriptingEnvironment &scripting_environment, EdgeBasedGraph *edge_based_graph)
 {
     {
         util::LogPolicy::GetInstance().Unmute();
@@ -117,6 +254,12 @@ int Extractor::run(ScriptingEnvironment &scripting_environment)
             std::min(recommended_num_threads, config.requested_num_threads);
         tbb::task_scheduler_init init(number_of_threads);
 
+        if (!config.trace_path.empty())
+        {
+            util::PhaseTrace::GetInstance().Enable(number_of_threads);
+        }
+        const util::PhaseTrace::ScopedPhase extraction_phase("extraction");
+
         util::SimpleLogger().Write() << "Input file: " << config.input_path.filename().string();
         if (!config.profile_path.empty())
         {
@@ -124,12 +267,11 @@ int Extractor::run(ScriptingEnvironment &scripting_environment)
         }
         util::SimpleLogger().Write() << "Threads: " << number_of_threads;
 
-        ExtractionContainers extraction_containers;
+        ExtractionContainers extraction_containers(
+            static_cast<std::size_t>(config.sort_memory) << 20);
         auto extractor_callbacks = util::make_unique<ExtractorCallbacks>(extraction_containers);
 
         const osmium::io::File input_file(config.input_path.string());
-        osmium::io::Reader reader(input_file);
-        const osmium::io::Header header = reader.header();
 
         unsigned number_of_nodes = 0;
         unsigned number_of_ways = 0;
@@ -137,10 +279,68 @@ int Extractor::run(ScriptingEnvironment &scripting_environment)
 
         util::SimpleLogger().Write() << "Parsing in progress..";
         TIMER_START(parsing);
+        util::PhaseTrace::ScopedPhase parsing_phase("parsing");
 
         // setup raster sources
         scripting_environment.SetupSources();
 
+        // setup restriction parser
+        const RestrictionParser restriction_parser(scripting_environment);
+
+        // every thread can work on a buffer, with a few more being read or stored meanwhile
+        const std::size_t max_buffers_in_flight = 2 * number_of_threads;
+
+        std::unique_ptr<ChangeMerger> change_merger;
+        if (!config.change_paths.empty())
+        {
+            change_merger = util::make_unique<ChangeMerger>(config.change_paths);
+        }
+
+        util::IdBitset routable_ways;
+        util::IdBitset referenced_nodes;
+        if (config.two_pass)
+        {
+            util::SimpleLogger().Write() << "Finding the nodes of routable ways ..";
+            util::PhaseTrace::ScopedPhase routable_ways_phase("routable ways");
+            findRoutableWays(input_file,
+                             change_merger.get(),
+                             scripting_environment,
+                             restriction_parser,
+                             max_buffers_in_flight,
+                             routable_ways,
+                             referenced_nodes);
+            util::SimpleLogger().Write() << routable_ways.Size() << " routable ways reference "
+                                         << referenced_nodes.Size() << " nodes";
+        }
+        // objects with negative ids aren't in the sets, they are only in files of editors
+        const auto is_needed = [&](const osmium::OSMEntity &entity) {
+            switch (entity.type())
+            {
+            case osmium::item_type::node:
+            {
+                const auto id = static_cast<const osmium::Node &>(entity).id();
+                return id < 0 || referenced_nodes.Contains(id);
+            }
+            case osmium::item_type::way:
+            {
+                const auto id = static_cast<const osmium::Way &>(entity).id();
+                return id < 0 || routable_ways.Contains(id);
+            }
+            default:
+                return true;
+            }
+        };
+
+        std::unique_ptr<WayResultsCache> way_results_cache;
+        if (config.reuse_way_results)
+        {
+            way_results_cache = util::make_unique<WayResultsCache>(
+                config.way_results_path, WayResultsCache::HashProfile(config.profile_path));
+        }
+
+        InputReader reader(input_file, osmium::osm_entity_bits::all, change_merger.get());
+        const osmium::io::Header header = reader.GetHeader();
+
         std::string generator = header.get("generator");
         if (generator.empty())
         {
@@ -159,54 +359,186 @@ int Extractor::run(ScriptingEnvironment &scripting_environment)
         boost::filesystem::ofstream timestamp_out(config.timestamp_file_name);
         timestamp_out.write(timestamp.c_str(), timestamp.length());
 
-        // initialize vectors holding parsed objects
-        tbb::concurrent_vector<std::pair<std::size_t, ExtractionNode>> resulting_nodes;
-        tbb::concurrent_vector<std::pair<std::size_t, ExtractionWay>> resulting_ways;
-        tbb::concurrent_vector<boost::optional<InputRestrictionContainer>> resulting_restrictions;
-
-        // setup restriction parser
-        const RestrictionParser restriction_parser(scripting_environment);
-
-        while (const osmium::memory::Buffer buffer = reader.read())
+        // Reading and decompressing the input, the profile and storing the results overlap in a
+        // pipeline. Buffers are stored in the order they were read, the number of buffers in
+        // flight bounds the memory the pipeline needs.
+        using SharedBuffer = std::shared_ptr<const osmium::memory::Buffer>;
+        struct ParsedBuffer
         {
-            // create a vector of iterators into the buffer
+            SharedBuffer buffer;
             std::vector<osmium::memory::Buffer::const_iterator> osm_elements;
+            // the elements whose results were found in the way results of the last extraction
+            std::vector<bool> is_cached;
+            tbb::concurrent_vector<std::pair<std::size_t, ExtractionNode>> resulting_nodes;
+            tbb::concurrent_vector<std::pair<std::size_t, ExtractionWay>> resulting_ways;
+            // the names of the resulting ways, hashed while the buffer is processed in parallel
+            std::vector<NameInterner::Key> way_name_keys;
+            tbb::concurrent_vector<boost::optional<InputRestrictionContainer>>
+                resulting_restrictions;
+        };
+        using SharedParsedBuffer = std::shared_ptr<ParsedBuffer>;
+
+        // create a vector of iterators into the buffer, the second pass of --two-pass skips the
+        // nodes and ways that the first one found to be unused
+        const auto list_elements = [&](ParsedBuffer &parsed_buffer) {
+            const auto &buffer = *parsed_buffer.buffer;
             for (auto iter = std::begin(buffer), end = std::end(buffer); iter != end; ++iter)
             {
-                osm_elements.push_back(iter);
-            }
-
-            // clear resulting vectors
-            resulting_nodes.clear();
-            resulting_ways.clear();
-            resulting_restrictions.clear();
-
-            scripting_environment.ProcessElements(osm_elements,
-                                                  restriction_parser,
-                                                  resulting_nodes,
-                                                  resulting_ways,
-                                                  resulting_restrictions);
-
-            number_of_nodes += resulting_nodes.size();
-            // put parsed objects thru extractor callbacks
-            for (const auto &result : resulting_nodes)
-            {
-                extractor_callbacks->ProcessNode(
-                    static_cast<const osmium::Node &>(*(osm_elements[result.first])),
-                    result.second);
-            }
-            number_of_ways += resulting_ways.size();
-            for (const auto &result : resulting_ways)
-            {
-                extractor_callbacks->ProcessWay(
-                    static_cast<const osmium::Way &>(*(osm_elements[result.first])), result.second);
-            }
-            number_of_relations += resulting_restrictions.size();
-            for (const auto &result : resulting_restrictions)
-            {
-                extractor_callbacks->ProcessRestriction(result);
+                if (!config.two_pass || is_needed(*iter))
+                {
+                    parsed_buffer.osm_elements.push_back(iter);
+                }
             }
+        };
+
+        // the way results are read along with the input, so they are looked up in order
+        tbb::filter_t<void, SharedParsedBuffer> buffer_reader(
+            tbb::filter::serial_in_order, [&](tbb::flow_control &flow_control) {
+                auto buffer = reader.Read();
+                if (!buffer)
+                {
+                    flow_control.stop();
+                    return SharedParsedBuffer{};
+                }
+                auto parsed_buffer = std::make_shared<ParsedBuffer>();
+                parsed_buffer->buffer = std::move(buffer);
+                if (way_results_cache)
+                {
+                    list_elements(*parsed_buffer);
+                    const auto &osm_elements = parsed_buffer->osm_elements;
+                    parsed_buffer->is_cached.resize(osm_elements.size(), false);
+                    ExtractionWay result;
+                    for (const auto index : util::irange<std::size_t>(0, osm_elements.size()))
+                    {
+                        if (osm_elements[index]->type() == osmium::item_type::way &&
+                            way_results_cache->Find(
+                                static_cast<const osmium::Way &>(*osm_elements[index]), result))
+                        {
+                            parsed_buffer->is_cached[index] = true;
+                            parsed_buffer->resulting_ways.push_back(
+                                std::make_pair(index, std::move(result)));
+                        }
+                    }
+                }
+                return parsed_buffer;
+            });
+
+        tbb::filter_t<SharedParsedBuffer, SharedParsedBuffer> buffer_transform(
+            tbb::filter::parallel, [&](const SharedParsedBuffer &parsed_buffer) {
+                if (!way_results_cache)
+                {
+                    list_elements(*parsed_buffer);
+                }
+
+                if (parsed_buffer->resulting_ways.empty())
+                {
+                    scripting_environment.ProcessElements(parsed_buffer->osm_elements,
+                                                          restriction_parser,
+                                                          parsed_buffer->resulting_nodes,
+                                                          parsed_buffer->resulting_ways,
+                                                          parsed_buffer->resulting_restrictions);
+                }
+                else
+                {
+                    // only the elements without results go to the profile
+                    std::vector<std::size_t> indices;
+                    std::vector<osmium::memory::Buffer::const_iterator> elements;
+                    for (const auto index :
+                         util::irange<std::size_t>(0, parsed_buffer->osm_elements.size()))
+                    {
+                        if (!parsed_buffer->is_cached[index])
+                        {
+                            indices.push_back(index);
+                            elements.push_back(parsed_buffer->osm_elements[index]);
+                        }
+                    }
+                    tbb::concurrent_vector<std::pair<std::size_t, ExtractionNode>> nodes;
+                    tbb::concurrent_vector<std::pair<std::size_t, ExtractionWay>> ways;
+                    scripting_environment.ProcessElements(elements,
+                                                          restriction_parser,
+                                                          nodes,
+                                                          ways,
+                                                          parsed_buffer->resulting_restrictions);
+                    for (auto &result : nodes)
+                    {
+                        parsed_buffer->resulting_nodes.push_back(
+                            std::make_pair(indices[result.first], std::move(result.second)));
+                    }
+                    for (auto &result : ways)
+                    {
+                        parsed_buffer->resulting_ways.push_back(
+                            std::make_pair(indices[result.first], std::move(result.second)));
+                    }
+                }
+
+                // in the order of the input, so names get the same ids whichever thread ran the
+                // profile on a way and whether its results were reused
+                const auto by_index = [](const auto &lhs, const auto &rhs) {
+                    return lhs.first < rhs.first;
+                };
+                std::sort(parsed_buffer->resulting_nodes.begin(),
+                          parsed_buffer->resulting_nodes.end(),
+                          by_index);
+                std::sort(parsed_buffer->resulting_ways.begin(),
+                          parsed_buffer->resulting_ways.end(),
+                          by_index);
+
+                parsed_buffer->way_name_keys.reserve(parsed_buffer->resulting_ways.size());
+                for (const auto &result : parsed_buffer->resulting_ways)
+                {
+                    parsed_buffer->way_name_keys.push_back(NameInterner::MakeKey(result.second));
+                }
+                return parsed_buffer;
+            });
+
+        tbb::filter_t<SharedParsedBuffer, void> buffer_storage(
+            tbb::filter::serial_in_order, [&](const SharedParsedBuffer &parsed_buffer) {
+                const auto &osm_elements = parsed_buffer->osm_elements;
+
+                if (way_results_cache)
+                {
+                    for (const auto &result : parsed_buffer->resulting_ways)
+                    {
+                        way_results_cache->Add(
+                            static_cast<const osmium::Way &>(*osm_elements[result.first]),
+                            result.second);
+                    }
+                }
+
+                number_of_nodes += parsed_buffer->resulting_nodes.size();
+                // put parsed objects thru extractor callbacks
+                for (const auto &result : parsed_buffer->resulting_nodes)
+                {
+                    extractor_callbacks->ProcessNode(
+                        static_cast<const osmium::Node &>(*(osm_elements[result.first])),
+                        result.second);
+                }
+                number_of_ways += parsed_buffer->resulting_ways.size();
+                for (const auto index :
+                     util::irange<std::size_t>(0, parsed_buffer->resulting_ways.size()))
+                {
+                    const auto &result = parsed_buffer->resulting_ways[index];
+                    extractor_callbacks->ProcessWay(
+                        static_cast<const osmium::Way &>(*(osm_elements[result.first])),
+                        result.second,
+                        parsed_buffer->way_name_keys[index]);
+                }
+                number_of_relations += parsed_buffer->resulting_restrictions.size();
+                for (const auto &result : parsed_buffer->resulting_restrictions)
+                {
+                    extractor_callbacks->ProcessRestriction(result);
+                }
+            });
+
+        tbb::parallel_pipeline(max_buffers_in_flight,
+                               buffer_reader & buffer_transform & buffer_storage);
+        if (way_results_cache)
+        {
+            way_results_cache->Finish();
+            util::SimpleLogger().Write() << "Reused the profile results of "
+                                         << way_results_cache->GetNumberOfHits() << " ways";
         }
+        parsing_phase.Stop();
         TIMER_STOP(parsing);
         util::SimpleLogger().Write() << "Parsing finished after " << TIMER_SEC(parsing)
                                      << " seconds";
@@ -231,8 +563,10 @@ int Extractor::run(ScriptingEnvironment &scripting_environment)
                                           config.restriction_file_name,
                                           config.names_file_name);
 
-        WriteProfileProperties(config.profile_properties_output_path,
-                               scripting_environment.GetProfileProperties());
+        auto profile_properties = scripting_environment.GetProfileProperties();
+        // see FindComponents
+        profile_properties.component_ids_in_topological_order = true;
+        WriteProfileProperties(config.profile_properties_output_path, profile_properties);
 
         TIMER_STOP(extracting);
         util::SimpleLogger().Write() << "extraction finished after " << TIMER_SEC(extracting)
@@ -247,9 +581,10 @@ int Extractor::run(ScriptingEnvironment &scripting_environment)
         util::SimpleLogger().Write() << "Generating edge-expanded graph representation";
 
         TIMER_START(expansion);
+        util::PhaseTrace::ScopedPhase expansion_phase("edge expansion");
 
         std::vector<EdgeBasedNode> edge_based_node_list;
-        util::DeallocatingVector<EdgeBasedEdge> edge_based_edge_list;
+        util::ChunkedVector<EdgeBasedEdge> edge_based_edge_list;
         std::vector<bool> node_is_startpoint;
         std::vector<EdgeWeight> edge_based_node_weights;
         std::vector<QueryNode> internal_to_external_node_map;
@@ -264,36 +599,70 @@ int Extractor::run(ScriptingEnvironment &scripting_environment)
         auto number_of_node_based_nodes = graph_size.first;
         auto max_edge_id = graph_size.second;
 
+        expansion_phase.Stop();
         TIMER_STOP(expansion);
 
-        util::SimpleLogger().Write() << "Saving edge-based node weights to file.";
-        TIMER_START(timer_write_node_weights);
-        util::serializeVector(config.edge_based_node_weights_output_path, edge_based_node_weights);
-        TIMER_STOP(timer_write_node_weights);
-        util::SimpleLogger().Write() << "Done writing. (" << TIMER_SEC(timer_write_node_weights)
-                                     << ")";
+        if (!edge_based_graph)
+        {
+            util::SimpleLogger().Write() << "Saving edge-based node weights to file.";
+            TIMER_START(timer_write_node_weights);
+            util::PhaseTrace::ScopedPhase node_weights_phase("write node weights");
+            util::serializeVector(config.edge_based_node_weights_output_path,
+                                  edge_based_node_weights);
+            node_weights_phase.Stop();
+            TIMER_STOP(timer_write_node_weights);
+            util::SimpleLogger().Write() << "Done writing. ("
+                                         << TIMER_SEC(timer_write_node_weights) << ")";
+        }
 
         util::SimpleLogger().Write() << "Computing strictly connected components ...";
         FindComponents(max_edge_id, edge_based_edge_list, edge_based_node_list);
 
         util::SimpleLogger().Write() << "Building r-tree ...";
         TIMER_START(rtree);
+        util::PhaseTrace::ScopedPhase rtree_phase("r-tree");
         BuildRTree(std::move(edge_based_node_list),
                    std::move(node_is_startpoint),
                    internal_to_external_node_map);
+        rtree_phase.Stop();
 
         TIMER_STOP(rtree);
 
         util::SimpleLogger().Write() << "Writing node map ...";
+        util::PhaseTrace::ScopedPhase writing_phase("write node map and edge-based graph");
         WriteNodeMapping(internal_to_external_node_map);
 
-        WriteEdgeBasedGraph(config.edge_graph_output_path, max_edge_id, edge_based_edge_list);
+        if (edge_based_graph)
+        {
+            edge_based_graph->max_edge_id = max_edge_id;
+            edge_based_graph->edges.swap(edge_based_edge_list);
+            edge_based_graph->node_weights.swap(edge_based_node_weights);
+        }
+        else
+        {
+            WriteEdgeBasedGraph(config.edge_graph_output_path, max_edge_id, edge_based_edge_list);
+        }
+        writing_phase.Stop();
 
         util::SimpleLogger().Write()
             << "Expansion  : " << (number_of_node_based_nodes / TIMER_SEC(expansion))
             << " nodes/sec and " << ((max_edge_id + 1) / TIMER_SEC(expansion)) << " edges/sec";
-        util::SimpleLogger().Write() << "To prepare the data for routing, run: "
-                                     << "./osrm-contract " << config.output_file_name << std::endl;
+        if (!edge_based_graph)
+        {
+            util::SimpleLogger().Write() << "To prepare the data for routing, run: "
+                                         << "./osrm-contract " << config.output_file_name
+                                         << std::endl;
+        }
+    }
+
+    if (!config.trace_path.empty())
+    {
+        util::PhaseTrace::Format trace_format;
+        if (!util::PhaseTrace::GetFormat(config.trace_format, trace_format))
+        {
+            throw util::exception("Unknown trace format " + config.trace_format);
+        }
+        util::PhaseTrace::GetInstance().Write(config.trace_path, trace_format);
     }
 
     return 0;
@@ -312,9 +681,10 @@ void Extractor::WriteProfileProperties(const std::string &output_path,
 }
 
 void Extractor::FindComponents(unsigned max_edge_id,
-                               const util::DeallocatingVector<EdgeBasedEdge> &input_edge_list,
+                               const util::ChunkedVector<EdgeBasedEdge> &input_edge_list,
                                std::vector<EdgeBasedNode> &input_nodes) const
 {
+    const util::PhaseTrace::ScopedPhase phase("strongly connected components");
     struct UncontractedEdgeData
     {
     };
@@ -376,6 +746,8 @@ void Extractor::FindComponents(unsigned max_edge_id,
     TarjanSCC<UncontractedGraph> component_search(
         std::const_pointer_cast<const UncontractedGraph>(uncontractor_graph));
     component_search.Run();
+    // the queries tell pairs of nodes without a path between them by their component ids
+    component_search.OrderComponentsTopologically();
 
     for (auto &node : input_nodes)
     {
@@ -456,25 +828,55 @@ Extractor::BuildEdgeExpandedGraph(ScriptingEnvironment &scripting_environment,
                                   std::vector<EdgeBasedNode> &node_based_edge_list,
                                   std::vector<bool> &node_is_startpoint,
                                   std::vector<EdgeWeight> &edge_based_node_weights,
-                                  util::DeallocatingVector<EdgeBasedEdge> &edge_based_edge_list,
+                                  util::ChunkedVector<EdgeBasedEdge> &edge_based_edge_list,
                                   const std::string &intersection_class_output_file)
 {
     std::unordered_set<NodeID> barrier_nodes;
     std::unordered_set<NodeID> traffic_lights;
 
+    util::PhaseTrace::ScopedPhase loading_phase("load node-based graph");
     auto restriction_map = LoadRestrictionMap();
-    auto node_based_graph =
+    auto dynamic_node_based_graph =
         LoadNodeBasedGraph(barrier_nodes, traffic_lights, internal_to_external_node_map);
+    loading_phase.Stop();
 
     CompressedEdgeContainer compressed_edge_container;
+    util::PhaseTrace::ScopedPhase compression_phase("graph compression");
     GraphCompressor graph_compressor;
     graph_compressor.Compress(barrier_nodes,
                               traffic_lights,
                               *restriction_map,
-                              *node_based_graph,
+                              *dynamic_node_based_graph,
                               compressed_edge_container);
+    compression_phase.Stop();
 
-    compressed_edge_container.SerializeInternalVector(config.geometry_output_path);
+    // nothing changes the graph after the compression, the edges of its nodes are made
+    // consecutive and the free slots between them are dropped
+    std::shared_ptr<util::NodeBasedStaticGraph> node_based_graph;
+    {
+        const util::PhaseTrace::ScopedPhase phase("freeze node-based graph");
+        std::vector<EdgeID> new_edge_ids;
+        node_based_graph = std::make_shared<util::NodeBasedStaticGraph>(
+            *dynamic_node_based_graph, new_edge_ids);
+        dynamic_node_based_graph.reset();
+        compressed_edge_container.RenumberEdges(new_edge_ids);
+    }
+
+    {
+        const util::PhaseTrace::ScopedPhase phase("write geometries");
+        compressed_edge_container.SerializeInternalVector(config.geometry_output_path);
+        if (config.generate_geometry_zoom_levels)
+        {
+            compressed_edge_container.SerializeZoomLevels(config.geometry_zoom_levels_output_path,
+                                                          internal_to_external_node_map);
+        }
+        if (config.generate_segment_lengths)
+        {
+            compressed_edge_container.SerializeSegmentLengths(config.geometry_lengths_output_path,
+                                                              *node_based_graph,
+                                                              internal_to_external_node_map);
+        }
+    }
 
     util::NameTable name_table(config.names_file_name);
 
@@ -512,6 +914,18 @@ Extractor::BuildEdgeExpandedGraph(ScriptingEnvironment &scripting_environment,
     edge_based_graph_factory.GetEdgeBasedNodeWeights(edge_based_node_weights);
     auto max_edge_id = edge_based_graph_factory.GetHighestEdgeID();
 
+    {
+        const util::PhaseTrace::ScopedPhase phase("write classes");
+        std::vector<ClassData> edge_based_node_classes;
+        edge_based_graph_factory.GetEdgeBasedNodeClasses(edge_based_node_classes);
+        if (!writeClasses(config.classes_output_path,
+                          scripting_environment.GetClassNames(),
+                          edge_based_node_classes))
+        {
+            throw util::exception("Failed writing " + config.classes_output_path);
+        }
+    }
+
     const std::size_t number_of_node_based_nodes = node_based_graph->GetNumberOfNodes();
 
     WriteIntersectionClassificationData(intersection_class_output_file,
@@ -582,12 +996,15 @@ void Extractor::BuildRTree(std::vector<EdgeBasedNode> node_based_edge_list,
     TIMER_STOP(construction);
     util::SimpleLogger().Write() << "finished r-tree construction in " << TIMER_SEC(construction)
                                  << " seconds";
+
+    // the leaves have the ids of the edge-based graph again
+    boost::filesystem::remove(config.node_renumbering_path);
 }
 
 void Extractor::WriteEdgeBasedGraph(
     std::string const &output_file_filename,
     EdgeID const max_edge_id,
-    util::DeallocatingVector<EdgeBasedEdge> const &edge_based_edge_list)
+    util::ChunkedVector<EdgeBasedEdge> const &edge_based_edge_list)
 {
 
     std::ofstream file_out_stream;
@@ -602,12 +1019,16 @@ void Extractor::WriteEdgeBasedGraph(
     std::uint64_t number_of_used_edges = edge_based_edge_list.size();
     file_out_stream.write((char *)&number_of_used_edges, sizeof(number_of_used_edges));
     file_out_stream.write((char *)&max_edge_id, sizeof(max_edge_id));
-
-    for (const auto &edge : edge_based_edge_list)
+    const std::uint64_t header_size = file_out_stream.tellp();
+    file_out_stream.close();
+    if (!file_out_stream)
     {
-        file_out_stream.write((char *)&edge, sizeof(EdgeBasedEdge));
+        throw util::exception("Failed to write " + output_file_filename);
     }
 
+    // the blocks are written by util::AsyncIO while the next ones are encoded
+    writeEdgeBasedEdges(output_file_filename, header_size, edge_based_edge_list);
+
     TIMER_STOP(write_edges);
     util::SimpleLogger().Write() << "ok, after " << TIMER_SEC(write_edges) << "s" << std::endl;
 
@@ -35,7 +35,7 @@ ExtractorCallbacks::ExtractorCallbacks(ExtractionContainers &extraction_containe
     : external_memory(extraction_containers)
 {
     // we reserved 0, 1, 2, 3 for the empty case
-    string_map[MapKey("", "", "", "")] = 0;
+    name_interner.Intern(NameInterner::MakeKey("", "", "", ""), 0);
     lane_description_map[TurnLaneDescription()] = 0;
 }
 
@@ -79,6 +79,11 @@ void ExtractorCallbacks::ProcessRestriction(
  * warning: caller needs to take care of synchronization!
  */
 void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const ExtractionWay &parsed_way)
+{
+    ProcessWay(input_way, parsed_way, NameInterner::MakeKey(parsed_way));
+}
+
+bool ExtractorCallbacks::IsRoutable(const osmium::Way &input_way, const ExtractionWay &parsed_way)
 {
     if (((0 >= parsed_way.forward_speed) ||
          (TRAVEL_MODE_INACCESSIBLE == parsed_way.forward_travel_mode)) &&
@@ -86,18 +91,29 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
          (TRAVEL_MODE_INACCESSIBLE == parsed_way.backward_travel_mode)) &&
         (0 >= parsed_way.duration))
     { // Only true if the way is specified by the speed profile
-        return;
+        return false;
     }
 
     if (input_way.nodes().size() <= 1)
     { // safe-guard against broken data
-        return;
+        return false;
     }
 
     if (std::numeric_limits<decltype(input_way.id())>::max() == input_way.id())
     {
         util::SimpleLogger().Write(logDEBUG) << "found bogus way with id: " << input_way.id()
                                              << " of size " << input_way.nodes().size();
+        return false;
+    }
+    return true;
+}
+
+void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way,
+                                    const ExtractionWay &parsed_way,
+                                    const NameInterner::Key &name_key)
+{
+    if (!IsRoutable(input_way, parsed_way))
+    {
         return;
     }
 
@@ -233,61 +249,31 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
         }
     };
 
-    // Deduplicates street names, refs, destinations, pronunciation based on the string_map.
-    // In case we do not already store the key, inserts (key, id) tuple and return id.
-    // Otherwise fetches the id based on the name and returns it without insertion.
     const auto turn_lane_id_forward = requestId(parsed_way.turn_lanes_forward);
     const auto turn_lane_id_backward = requestId(parsed_way.turn_lanes_backward);
 
-    const constexpr auto MAX_STRING_LENGTH = 255u;
-    // Get the unique identifier for the street name, destination, and ref
-    const auto name_iterator = string_map.find(
-        MapKey(parsed_way.name, parsed_way.destinations, parsed_way.ref, parsed_way.pronunciation));
-    unsigned name_id = EMPTY_NAMEID;
-    if (string_map.end() == name_iterator)
+    // Deduplicates street names, refs, destinations, pronunciation based on the name interner.
+    // name_offsets already has an offset of a new name, take the offset index as the name id
+    const unsigned new_name_id = external_memory.name_offsets.size() - 1;
+    const unsigned name_id = name_interner.Intern(name_key, new_name_id);
+    if (name_id == new_name_id)
     {
-        const auto name_length = std::min<unsigned>(MAX_STRING_LENGTH, parsed_way.name.size());
-        const auto destinations_length =
-            std::min<unsigned>(MAX_STRING_LENGTH, parsed_way.destinations.size());
-        const auto pronunciation_length =
-            std::min<unsigned>(MAX_STRING_LENGTH, parsed_way.pronunciation.size());
-        const auto ref_length = std::min<unsigned>(MAX_STRING_LENGTH, parsed_way.ref.size());
-
-        // name_offsets already has an offset of a new name, take the offset index as the name id
-        name_id = external_memory.name_offsets.size() - 1;
-
-        external_memory.name_char_data.reserve(external_memory.name_char_data.size() + name_length +
-                                               destinations_length + pronunciation_length +
-                                               ref_length);
-
-        std::copy(parsed_way.name.c_str(),
-                  parsed_way.name.c_str() + name_length,
-                  std::back_inserter(external_memory.name_char_data));
-        external_memory.name_offsets.push_back(external_memory.name_char_data.size());
-
-        std::copy(parsed_way.destinations.c_str(),
-                  parsed_way.destinations.c_str() + destinations_length,
-                  std::back_inserter(external_memory.name_char_data));
-        external_memory.name_offsets.push_back(external_memory.name_char_data.size());
-
-        std::copy(parsed_way.pronunciation.c_str(),
-                  parsed_way.pronunciation.c_str() + pronunciation_length,
-                  std::back_inserter(external_memory.name_char_data));
-        external_memory.name_offsets.push_back(external_memory.name_char_data.size());
-
-        std::copy(parsed_way.ref.c_str(),
-                  parsed_way.ref.c_str() + ref_length,
-                  std::back_inserter(external_memory.name_char_data));
-        external_memory.name_offsets.push_back(external_memory.name_char_data.size());
-
-        auto k = MapKey{
-            parsed_way.name, parsed_way.destinations, parsed_way.ref, parsed_way.pronunciation};
-        auto v = MapVal{name_id};
-        string_map.emplace(std::move(k), std::move(v));
-    }
-    else
-    {
-        name_id = name_iterator->second;
+        std::size_t name_length = 0;
+        for (const auto &string : name_key.strings)
+        {
+            name_length += string.size();
+        }
+        external_memory.name_char_data.reserve(external_memory.name_char_data.size() +
+                                               name_length);
+
+        // name, destinations, pronunciation and ref, each followed by its end offset
+        for (const auto &string : name_key.strings)
+        {
+            std::copy(string.begin(),
+                      string.end(),
+                      std::back_inserter(external_memory.name_char_data));
+            external_memory.name_offsets.push_back(external_memory.name_char_data.size());
+        }
     }
 
     const bool split_edge = (parsed_way.forward_speed > 0) &&
@@ -332,7 +318,8 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
                                           parsed_way.backward_travel_mode,
                                           false,
                                           turn_lane_id_backward,
-                                          road_classification));
+                                          road_classification,
+                                          parsed_way.classes));
             });
 
         external_memory.way_start_end_id_list.push_back(
@@ -364,7 +351,8 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
                                           parsed_way.forward_travel_mode,
                                           split_edge,
                                           turn_lane_id_forward,
-                                          road_classification));
+                                          road_classification,
+                                          parsed_way.classes));
             });
         if (split_edge)
         {
@@ -386,7 +374,8 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
                         parsed_way.backward_travel_mode,
                         true,
                         turn_lane_id_backward,
-                        road_classification));
+                        road_classification,
+                        parsed_way.classes));
                 });
         }
 
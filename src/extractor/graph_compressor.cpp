@@ -8,16 +8,119 @@
 
 #include "util/simple_logger.hpp"
 
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
 namespace osrm
 {
 namespace extractor
 {
 
+namespace
+{
+// The edges of a degree 2 node and its current neighbours
+//
+//    reverse_e2   forward_e2
+// u <---------- v -----------> w
+//    ----------> <-----------
+//    forward_e1   reverse_e1
+struct NodeEdges
+{
+    EdgeID forward_e1;
+    EdgeID forward_e2;
+    EdgeID reverse_e1;
+    EdgeID reverse_e2;
+    NodeID node_u;
+    NodeID node_w;
+};
+
+NodeEdges getNodeEdges(const util::NodeBasedDynamicGraph &graph, const NodeID node_v)
+{
+    NodeEdges edges;
+    const bool reverse_edge_order = graph.GetEdgeData(graph.BeginEdges(node_v)).reversed;
+    edges.forward_e2 = graph.BeginEdges(node_v) + reverse_edge_order;
+    BOOST_ASSERT(SPECIAL_EDGEID != edges.forward_e2);
+    BOOST_ASSERT(edges.forward_e2 >= graph.BeginEdges(node_v) &&
+                 edges.forward_e2 < graph.EndEdges(node_v));
+    edges.reverse_e2 = graph.BeginEdges(node_v) + 1 - reverse_edge_order;
+    BOOST_ASSERT(SPECIAL_EDGEID != edges.reverse_e2);
+    BOOST_ASSERT(edges.reverse_e2 >= graph.BeginEdges(node_v) &&
+                 edges.reverse_e2 < graph.EndEdges(node_v));
+
+    edges.node_w = graph.GetTarget(edges.forward_e2);
+    BOOST_ASSERT(SPECIAL_NODEID != edges.node_w);
+    BOOST_ASSERT(node_v != edges.node_w);
+    edges.node_u = graph.GetTarget(edges.reverse_e2);
+    BOOST_ASSERT(SPECIAL_NODEID != edges.node_u);
+    BOOST_ASSERT(edges.node_u != node_v);
+
+    edges.forward_e1 = graph.FindEdge(edges.node_u, node_v);
+    BOOST_ASSERT(SPECIAL_EDGEID != edges.forward_e1);
+    BOOST_ASSERT(node_v == graph.GetTarget(edges.forward_e1));
+    edges.reverse_e1 = graph.FindEdge(edges.node_w, node_v);
+    BOOST_ASSERT(SPECIAL_EDGEID != edges.reverse_e1);
+    BOOST_ASSERT(node_v == graph.GetTarget(edges.reverse_e1));
+    return edges;
+}
+
+// How the parallel mode treats a node in the pass that applies the compressions
+enum NodeMode : std::uint8_t
+{
+    // can't be compressed
+    SKIP,
+    // checked like the serial mode does: nodes on rings of compressible nodes, on chains that
+    // start and end at the same node and degree 2 nodes with both edges to the same neighbour
+    SERIAL,
+    // inside a chain between two different nodes that can't be compressed. Only the last node of
+    // the chain by id can find its neighbours connected, all others get compressed.
+    CHAIN,
+    CHAIN_LAST
+};
+
+// A chain of compressible nodes between two nodes that can't be compressed, with the edges and
+// their weights before the compression in both directions
+struct Chain
+{
+    std::vector<NodeID> nodes;
+    // from nodes[i] to nodes[i + 1]
+    std::vector<EdgeID> forward_edges;
+    std::vector<EdgeWeight> forward_weights;
+    // from nodes[i + 1] to nodes[i]
+    std::vector<EdgeID> backward_edges;
+    std::vector<EdgeWeight> backward_weights;
+};
+}
+
 void GraphCompressor::Compress(const std::unordered_set<NodeID> &barrier_nodes,
                                const std::unordered_set<NodeID> &traffic_lights,
                                RestrictionMap &restriction_map,
                                util::NodeBasedDynamicGraph &graph,
                                CompressedEdgeContainer &geometry_compressor)
+{
+    if (mode == Mode::Serial)
+    {
+        CompressSerial(
+            barrier_nodes, traffic_lights, restriction_map, graph, geometry_compressor);
+    }
+    else
+    {
+        CompressParallel(
+            barrier_nodes, traffic_lights, restriction_map, graph, geometry_compressor);
+    }
+}
+
+void GraphCompressor::CompressSerial(const std::unordered_set<NodeID> &barrier_nodes,
+                                     const std::unordered_set<NodeID> &traffic_lights,
+                                     RestrictionMap &restriction_map,
+                                     util::NodeBasedDynamicGraph &graph,
+                                     CompressedEdgeContainer &geometry_compressor) const
 {
     const unsigned original_number_of_nodes = graph.GetNumberOfNodes();
     const unsigned original_number_of_edges = graph.GetNumberOfEdges();
@@ -28,185 +131,448 @@ void GraphCompressor::Compress(const std::unordered_set<NodeID> &barrier_nodes,
     {
         progress.PrintStatus(node_v);
 
-        // only contract degree 2 vertices
-        if (2 != graph.GetOutDegree(node_v))
+        if (CanCompress(node_v, barrier_nodes, traffic_lights, restriction_map, graph) &&
+            !HasConnectedNeighbours(node_v, graph))
         {
-            continue;
+            CompressNode(node_v, restriction_map, graph, geometry_compressor, false);
         }
+    }
 
-        // don't contract barrier node
-        if (barrier_nodes.end() != barrier_nodes.find(node_v))
+    PrintStatistics(original_number_of_nodes, original_number_of_edges, graph);
+
+    // Repeate the loop, but now add all edges as uncompressed values.
+    // The function AddUncompressedEdge does nothing if the edge is already
+    // in the CompressedEdgeContainer.
+    for (const NodeID node_u : util::irange(0u, original_number_of_nodes))
+    {
+        for (const auto edge_id : util::irange(graph.BeginEdges(node_u), graph.EndEdges(node_u)))
         {
-            continue;
+            const EdgeData &data = graph.GetEdgeData(edge_id);
+            const NodeID target = graph.GetTarget(edge_id);
+            geometry_compressor.AddUncompressedEdge(edge_id, target, data.distance);
         }
+    }
+    geometry_compressor.Compact();
+}
 
-        // check if v is a via node for a turn restriction, i.e. a 'directed' barrier node
-        if (restriction_map.IsViaNode(node_v))
+void GraphCompressor::CompressParallel(const std::unordered_set<NodeID> &barrier_nodes,
+                                       const std::unordered_set<NodeID> &traffic_lights,
+                                       RestrictionMap &restriction_map,
+                                       util::NodeBasedDynamicGraph &graph,
+                                       CompressedEdgeContainer &geometry_compressor) const
+{
+    const unsigned original_number_of_nodes = graph.GetNumberOfNodes();
+    const unsigned original_number_of_edges = graph.GetNumberOfEdges();
+    const constexpr unsigned GrainSize = 4096;
+
+    // Check every node on the graph before the compression. Compressing a neighbour only changes
+    // the target, the weight and the lanes of the edge towards a node, its name and flags are
+    // the same on all edges that it merged. So the checks give what the serial mode sees, but
+    // for the neighbours being connected.
+    const constexpr std::uint8_t NOT_COMPRESSIBLE = 0;
+    const constexpr std::uint8_t COMPRESSIBLE = 1;
+    const constexpr std::uint8_t SAME_NEIGHBOURS = 2;
+    std::vector<std::uint8_t> compressible(original_number_of_nodes, NOT_COMPRESSIBLE);
+    std::vector<std::uint8_t> modes(original_number_of_nodes, SKIP);
+    tbb::parallel_for(
+        tbb::blocked_range<NodeID>(0, original_number_of_nodes, GrainSize),
+        [&](const tbb::blocked_range<NodeID> &range) {
+            for (auto node_v = range.begin(); node_v != range.end(); ++node_v)
+            {
+                if (2 != graph.GetOutDegree(node_v))
+                {
+                    continue;
+                }
+                const auto begin = graph.BeginEdges(node_v);
+                if (graph.GetTarget(begin) == graph.GetTarget(begin + 1))
+                {
+                    compressible[node_v] = SAME_NEIGHBOURS;
+                    modes[node_v] = SERIAL;
+                }
+                else if (CanCompress(
+                             node_v, barrier_nodes, traffic_lights, restriction_map, graph))
+                {
+                    compressible[node_v] = COMPRESSIBLE;
+                    modes[node_v] = SERIAL;
+                }
+            }
+        });
+
+    // Walk the chains from both of their ends, the end with the smaller id keeps the chain
+    const auto walkChain = [&](const NodeID start, const NodeID end) {
+        Chain chain;
+        chain.nodes = {end, start};
+        chain.forward_edges.push_back(graph.FindEdge(end, start));
+        NodeID previous = end;
+        NodeID current = start;
+        while (true)
         {
-            continue;
+            const auto begin = graph.BeginEdges(current);
+            const EdgeID to_previous = graph.GetTarget(begin) == previous ? begin : begin + 1;
+            const EdgeID to_next = to_previous == begin ? begin + 1 : begin;
+            const NodeID next = graph.GetTarget(to_next);
+            chain.backward_edges.push_back(to_previous);
+            chain.forward_edges.push_back(to_next);
+            chain.nodes.push_back(next);
+            if (COMPRESSIBLE != compressible[next])
+            {
+                chain.backward_edges.push_back(graph.FindEdge(next, current));
+                break;
+            }
+            previous = current;
+            current = next;
         }
-
-        //    reverse_e2   forward_e2
-        // u <---------- v -----------> w
-        //    ----------> <-----------
-        //    forward_e1   reverse_e1
-        //
-        // Will be compressed to:
-        //
-        //    reverse_e1
-        // u <---------- w
-        //    ---------->
-        //    forward_e1
-        //
-        // If the edges are compatible.
-        const bool reverse_edge_order = graph.GetEdgeData(graph.BeginEdges(node_v)).reversed;
-        const EdgeID forward_e2 = graph.BeginEdges(node_v) + reverse_edge_order;
-        BOOST_ASSERT(SPECIAL_EDGEID != forward_e2);
-        BOOST_ASSERT(forward_e2 >= graph.BeginEdges(node_v) && forward_e2 < graph.EndEdges(node_v));
-        const EdgeID reverse_e2 = graph.BeginEdges(node_v) + 1 - reverse_edge_order;
-        BOOST_ASSERT(SPECIAL_EDGEID != reverse_e2);
-        BOOST_ASSERT(reverse_e2 >= graph.BeginEdges(node_v) && reverse_e2 < graph.EndEdges(node_v));
-
-        const EdgeData &fwd_edge_data2 = graph.GetEdgeData(forward_e2);
-        const EdgeData &rev_edge_data2 = graph.GetEdgeData(reverse_e2);
-
-        const NodeID node_w = graph.GetTarget(forward_e2);
-        BOOST_ASSERT(SPECIAL_NODEID != node_w);
-        BOOST_ASSERT(node_v != node_w);
-        const NodeID node_u = graph.GetTarget(reverse_e2);
-        BOOST_ASSERT(SPECIAL_NODEID != node_u);
-        BOOST_ASSERT(node_u != node_v);
-
-        const EdgeID forward_e1 = graph.FindEdge(node_u, node_v);
-        BOOST_ASSERT(SPECIAL_EDGEID != forward_e1);
-        BOOST_ASSERT(node_v == graph.GetTarget(forward_e1));
-        const EdgeID reverse_e1 = graph.FindEdge(node_w, node_v);
-        BOOST_ASSERT(SPECIAL_EDGEID != reverse_e1);
-        BOOST_ASSERT(node_v == graph.GetTarget(reverse_e1));
-
-        const EdgeData &fwd_edge_data1 = graph.GetEdgeData(forward_e1);
-        const EdgeData &rev_edge_data1 = graph.GetEdgeData(reverse_e1);
-
-        if (graph.FindEdgeInEitherDirection(node_u, node_w) != SPECIAL_EDGEID)
+        for (const auto edge : chain.forward_edges)
         {
-            continue;
+            chain.forward_weights.push_back(graph.GetEdgeData(edge).distance);
         }
-
-        // this case can happen if two ways with different names overlap
-        if (fwd_edge_data1.name_id != rev_edge_data1.name_id ||
-            fwd_edge_data2.name_id != rev_edge_data2.name_id)
+        for (const auto edge : chain.backward_edges)
         {
-            continue;
+            chain.backward_weights.push_back(graph.GetEdgeData(edge).distance);
         }
+        return chain;
+    };
+
+    tbb::enumerable_thread_specific<std::vector<Chain>> thread_chains;
+    tbb::parallel_for(
+        tbb::blocked_range<NodeID>(0, original_number_of_nodes, GrainSize),
+        [&](const tbb::blocked_range<NodeID> &range) {
+            auto &chains = thread_chains.local();
+            for (auto node_v = range.begin(); node_v != range.end(); ++node_v)
+            {
+                if (COMPRESSIBLE != compressible[node_v])
+                {
+                    continue;
+                }
+                const auto begin = graph.BeginEdges(node_v);
+                const NodeID first_neighbour = graph.GetTarget(begin);
+                const NodeID second_neighbour = graph.GetTarget(begin + 1);
+                const bool first_is_end = COMPRESSIBLE != compressible[first_neighbour];
+                const bool second_is_end = COMPRESSIBLE != compressible[second_neighbour];
+                if (!first_is_end && !second_is_end)
+                {
+                    continue;
+                }
+
+                auto chain = walkChain(node_v, first_is_end ? first_neighbour : second_neighbour);
+                const auto other_end = chain.nodes[chain.nodes.size() - 2];
+                if (other_end < node_v)
+                {
+                    continue;
+                }
+
+                const auto interior_begin = chain.nodes.begin() + 1;
+                const auto interior_end = chain.nodes.end() - 1;
+                if (chain.nodes.front() == chain.nodes.back())
+                {
+                    // stays SERIAL, the neighbours of its nodes can be connected anywhere
+                    continue;
+                }
+                for (auto iter = interior_begin; iter != interior_end; ++iter)
+                {
+                    modes[*iter] = CHAIN;
+                }
+                modes[*std::max_element(interior_begin, interior_end)] = CHAIN_LAST;
+                chains.push_back(std::move(chain));
+            }
+        });
+
+    // Apply the compressions in the order of the serial mode, the buckets of the chains are only
+    // assigned. Only the last node of a chain can fail to be compressed.
+    util::Percent progress(original_number_of_nodes);
+    for (const NodeID node_v : util::irange(0u, original_number_of_nodes))
+    {
+        progress.PrintStatus(node_v);
 
-        if (fwd_edge_data1.CanCombineWith(fwd_edge_data2) &&
-            rev_edge_data1.CanCombineWith(rev_edge_data2))
+        switch (modes[node_v])
         {
-            BOOST_ASSERT(graph.GetEdgeData(forward_e1).name_id ==
-                         graph.GetEdgeData(reverse_e1).name_id);
-            BOOST_ASSERT(graph.GetEdgeData(forward_e2).name_id ==
-                         graph.GetEdgeData(reverse_e2).name_id);
-
-            // Do not compress edge if it crosses a traffic signal.
-            // This can't be done in CanCombineWith, becase we only store the
-            // traffic signals in the `traffic_lights` list, which EdgeData
-            // doesn't have access to.
-            const bool has_node_penalty = traffic_lights.find(node_v) != traffic_lights.end();
-            if (has_node_penalty)
-                continue;
-
-            // Get distances before graph is modified
-            const int forward_weight1 = graph.GetEdgeData(forward_e1).distance;
-            const int forward_weight2 = graph.GetEdgeData(forward_e2).distance;
-
-            BOOST_ASSERT(0 != forward_weight1);
-            BOOST_ASSERT(0 != forward_weight2);
-
-            const int reverse_weight1 = graph.GetEdgeData(reverse_e1).distance;
-            const int reverse_weight2 = graph.GetEdgeData(reverse_e2).distance;
-
-            BOOST_ASSERT(0 != reverse_weight1);
-            BOOST_ASSERT(0 != reverse_weight2);
-
-            // add weight of e2's to e1
-            graph.GetEdgeData(forward_e1).distance += fwd_edge_data2.distance;
-            graph.GetEdgeData(reverse_e1).distance += rev_edge_data2.distance;
-
-            // extend e1's to targets of e2's
-            graph.SetTarget(forward_e1, node_w);
-            graph.SetTarget(reverse_e1, node_u);
-
-            /*
-             * Remember Lane Data for compressed parts. This handles scenarios where lane-data is
-             * only kept up until a traffic light.
-             *
-             *                |    |
-             * ----------------    |
-             *         -^ |        |
-             * -----------         |
-             *         -v |        |
-             * ---------------     |
-             *                |    |
-             *
-             *  u ------- v ---- w
-             *
-             * Since the edge is compressable, we can transfer:
-             * "left|right" (uv) and "" (uw) into a string with "left|right" (uw) for the compressed
-             * edge.
-             * Doing so, we might mess up the point from where the lanes are shown. It should be
-             * reasonable, since the announcements have to come early anyhow. So there is a
-             * potential danger in here, but it saves us from adding a lot of additional edges for
-             * turn-lanes. Without this,we would have to treat any turn-lane beginning/ending just
-             * like a barrier.
-             */
-            const auto selectLaneID = [](const LaneDescriptionID front,
-                                         const LaneDescriptionID back) {
-                // A lane has tags: u - (front) - v - (back) - w
-                // During contraction, we keep only one of the tags. Usually the one closer to the
-                // intersection is preferred. If its empty, however, we keep the non-empty one
-                if (back == INVALID_LANE_DESCRIPTIONID)
-                    return front;
-                return back;
-            };
-            graph.GetEdgeData(forward_e1).lane_description_id =
-                selectLaneID(graph.GetEdgeData(forward_e1).lane_description_id,
-                             fwd_edge_data2.lane_description_id);
-            graph.GetEdgeData(reverse_e1).lane_description_id =
-                selectLaneID(graph.GetEdgeData(reverse_e1).lane_description_id,
-                             rev_edge_data2.lane_description_id);
-
-            // remove e2's (if bidir, otherwise only one)
-            graph.DeleteEdge(node_v, forward_e2);
-            graph.DeleteEdge(node_v, reverse_e2);
-
-            // update any involved turn restrictions
-            restriction_map.FixupStartingTurnRestriction(node_u, node_v, node_w);
-            restriction_map.FixupArrivingTurnRestriction(node_u, node_v, node_w, graph);
-
-            restriction_map.FixupStartingTurnRestriction(node_w, node_v, node_u);
-            restriction_map.FixupArrivingTurnRestriction(node_w, node_v, node_u, graph);
-
-            // store compressed geometry in container
-            geometry_compressor.CompressEdge(
-                forward_e1, forward_e2, node_v, node_w, forward_weight1, forward_weight2);
-            geometry_compressor.CompressEdge(
-                reverse_e1, reverse_e2, node_v, node_u, reverse_weight1, reverse_weight2);
+        case SERIAL:
+            if (CanCompress(node_v, barrier_nodes, traffic_lights, restriction_map, graph) &&
+                !HasConnectedNeighbours(node_v, graph))
+            {
+                CompressNode(node_v, restriction_map, graph, geometry_compressor, false);
+            }
+            break;
+        case CHAIN:
+            CompressNode(node_v, restriction_map, graph, geometry_compressor, true);
+            break;
+        case CHAIN_LAST:
+            if (HasConnectedNeighbours(node_v, graph))
+            {
+                modes[node_v] = SKIP;
+            }
+            else
+            {
+                CompressNode(node_v, restriction_map, graph, geometry_compressor, true);
+            }
+            break;
+        default:
+            break;
         }
     }
 
     PrintStatistics(original_number_of_nodes, original_number_of_edges, graph);
 
-    // Repeate the loop, but now add all edges as uncompressed values.
-    // The function AddUncompressedEdge does nothing if the edge is already
-    // in the CompressedEdgeContainer.
     for (const NodeID node_u : util::irange(0u, original_number_of_nodes))
     {
         for (const auto edge_id : util::irange(graph.BeginEdges(node_u), graph.EndEdges(node_u)))
         {
-            const EdgeData &data = graph.GetEdgeData(edge_id);
-            const NodeID target = graph.GetTarget(edge_id);
-            geometry_compressor.AddUncompressedEdge(edge_id, target, data.distance);
+            geometry_compressor.ReserveUncompressedEdge(edge_id);
+        }
+    }
+
+    // The geometry of a compressed part of a chain is the list of the nodes it passes with the
+    // weights of the edges leading to them
+    std::vector<Chain> chains;
+    for (auto &local_chains : thread_chains)
+    {
+        std::move(local_chains.begin(), local_chains.end(), std::back_inserter(chains));
+    }
+    // calls f(chain, from, to) for the compressed parts of the chains in parallel
+    const auto forEachCompressedPart = [&](const auto &f) {
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, chains.size()),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                for (auto index = range.begin(); index != range.end(); ++index)
+                {
+                    const auto &chain = chains[index];
+                    std::size_t from = 0;
+                    for (std::size_t to = 1; to < chain.nodes.size(); ++to)
+                    {
+                        if (to + 1 != chain.nodes.size() && SKIP != modes[chain.nodes[to]])
+                        {
+                            continue;
+                        }
+                        if (to > from + 1)
+                        {
+                            f(chain, from, to);
+                        }
+                        from = to;
+                    }
+                }
+            });
+    };
+    // calls f(edge_id) for the edges of the graph in parallel
+    const auto forEachEdge = [&](const auto &f) {
+        tbb::parallel_for(
+            tbb::blocked_range<NodeID>(0, original_number_of_nodes, GrainSize),
+            [&](const tbb::blocked_range<NodeID> &range) {
+                for (auto node_u = range.begin(); node_u != range.end(); ++node_u)
+                {
+                    for (const auto edge_id : graph.GetAdjacentEdgeRange(node_u))
+                    {
+                        f(edge_id);
+                    }
+                }
+            });
+    };
+
+    // The sizes of the buckets are known before they are filled in, so they are laid out in the
+    // arena of the container once. The compressed parts of the chains have at least two entries,
+    // the edges that weren't compressed have one.
+    forEachCompressedPart([&](const Chain &chain, const std::size_t from, const std::size_t to) {
+        geometry_compressor.ResizeBucket(chain.forward_edges[from], to - from);
+        geometry_compressor.ResizeBucket(chain.backward_edges[to - 1], to - from);
+    });
+    forEachEdge([&](const EdgeID edge_id) {
+        if (geometry_compressor.GetBucketSize(edge_id) == 0)
+        {
+            geometry_compressor.ResizeBucket(edge_id, 1);
+        }
+    });
+    geometry_compressor.AllocateBuckets();
+
+    forEachCompressedPart([&](const Chain &chain, const std::size_t from, const std::size_t to) {
+        auto forward_bucket = geometry_compressor.GetMutableBucket(chain.forward_edges[from]);
+        auto backward_bucket = geometry_compressor.GetMutableBucket(chain.backward_edges[to - 1]);
+        for (auto hop = from; hop < to; ++hop)
+        {
+            forward_bucket[hop - from] = {chain.nodes[hop + 1], chain.forward_weights[hop]};
+            const auto backward_hop = from + to - 1 - hop;
+            backward_bucket[hop - from] = {chain.nodes[backward_hop],
+                                           chain.backward_weights[backward_hop]};
+        }
+    });
+    forEachEdge([&](const EdgeID edge_id) {
+        if (geometry_compressor.GetBucketSize(edge_id) == 1)
+        {
+            geometry_compressor.GetMutableBucket(edge_id).front() = {
+                graph.GetTarget(edge_id), graph.GetEdgeData(edge_id).distance};
         }
+    });
+}
+
+bool GraphCompressor::CanCompress(const NodeID node_v,
+                                  const std::unordered_set<NodeID> &barrier_nodes,
+                                  const std::unordered_set<NodeID> &traffic_lights,
+                                  const RestrictionMap &restriction_map,
+                                  const util::NodeBasedDynamicGraph &graph) const
+{
+    // only contract degree 2 vertices
+    if (2 != graph.GetOutDegree(node_v))
+    {
+        return false;
+    }
+
+    // don't contract barrier node
+    if (barrier_nodes.end() != barrier_nodes.find(node_v))
+    {
+        return false;
+    }
+
+    // check if v is a via node for a turn restriction, i.e. a 'directed' barrier node
+    if (restriction_map.IsViaNode(node_v))
+    {
+        return false;
+    }
+
+    const auto edges = getNodeEdges(graph, node_v);
+    const EdgeData &fwd_edge_data1 = graph.GetEdgeData(edges.forward_e1);
+    const EdgeData &rev_edge_data1 = graph.GetEdgeData(edges.reverse_e1);
+    const EdgeData &fwd_edge_data2 = graph.GetEdgeData(edges.forward_e2);
+    const EdgeData &rev_edge_data2 = graph.GetEdgeData(edges.reverse_e2);
+
+    // this case can happen if two ways with different names overlap
+    if (fwd_edge_data1.name_id != rev_edge_data1.name_id ||
+        fwd_edge_data2.name_id != rev_edge_data2.name_id)
+    {
+        return false;
+    }
+
+    if (!fwd_edge_data1.CanCombineWith(fwd_edge_data2) ||
+        !rev_edge_data1.CanCombineWith(rev_edge_data2))
+    {
+        return false;
+    }
+
+    // Do not compress edge if it crosses a traffic signal.
+    // This can't be done in CanCombineWith, becase we only store the
+    // traffic signals in the `traffic_lights` list, which EdgeData
+    // doesn't have access to.
+    return traffic_lights.find(node_v) == traffic_lights.end();
+}
+
+bool GraphCompressor::HasConnectedNeighbours(const NodeID node_v,
+                                             const util::NodeBasedDynamicGraph &graph) const
+{
+    const auto edges = getNodeEdges(graph, node_v);
+    return graph.FindEdgeInEitherDirection(edges.node_u, edges.node_w) != SPECIAL_EDGEID;
+}
+
+void GraphCompressor::CompressNode(const NodeID node_v,
+                                   RestrictionMap &restriction_map,
+                                   util::NodeBasedDynamicGraph &graph,
+                                   CompressedEdgeContainer &geometry_compressor,
+                                   const bool reserve_geometry) const
+{
+    //    reverse_e2   forward_e2
+    // u <---------- v -----------> w
+    //    ----------> <-----------
+    //    forward_e1   reverse_e1
+    //
+    // Will be compressed to:
+    //
+    //    reverse_e1
+    // u <---------- w
+    //    ---------->
+    //    forward_e1
+    const auto edges = getNodeEdges(graph, node_v);
+    const EdgeID forward_e1 = edges.forward_e1;
+    const EdgeID forward_e2 = edges.forward_e2;
+    const EdgeID reverse_e1 = edges.reverse_e1;
+    const EdgeID reverse_e2 = edges.reverse_e2;
+    const NodeID node_u = edges.node_u;
+    const NodeID node_w = edges.node_w;
+
+    const EdgeData &fwd_edge_data2 = graph.GetEdgeData(forward_e2);
+    const EdgeData &rev_edge_data2 = graph.GetEdgeData(reverse_e2);
+
+    BOOST_ASSERT(graph.GetEdgeData(forward_e1).name_id == graph.GetEdgeData(reverse_e1).name_id);
+    BOOST_ASSERT(graph.GetEdgeData(forward_e2).name_id == graph.GetEdgeData(reverse_e2).name_id);
+
+    // Get distances before graph is modified
+    const int forward_weight1 = graph.GetEdgeData(forward_e1).distance;
+    const int forward_weight2 = graph.GetEdgeData(forward_e2).distance;
+
+    BOOST_ASSERT(0 != forward_weight1);
+    BOOST_ASSERT(0 != forward_weight2);
+
+    const int reverse_weight1 = graph.GetEdgeData(reverse_e1).distance;
+    const int reverse_weight2 = graph.GetEdgeData(reverse_e2).distance;
+
+    BOOST_ASSERT(0 != reverse_weight1);
+    BOOST_ASSERT(0 != reverse_weight2);
+
+    // add weight of e2's to e1
+    graph.GetEdgeData(forward_e1).distance += fwd_edge_data2.distance;
+    graph.GetEdgeData(reverse_e1).distance += rev_edge_data2.distance;
+
+    // extend e1's to targets of e2's
+    graph.SetTarget(forward_e1, node_w);
+    graph.SetTarget(reverse_e1, node_u);
+
+    /*
+     * Remember Lane Data for compressed parts. This handles scenarios where lane-data is
+     * only kept up until a traffic light.
+     *
+     *                |    |
+     * ----------------    |
+     *         -^ |        |
+     * -----------         |
+     *         -v |        |
+     * ---------------     |
+     *                |    |
+     *
+     *  u ------- v ---- w
+     *
+     * Since the edge is compressable, we can transfer:
+     * "left|right" (uv) and "" (uw) into a string with "left|right" (uw) for the compressed
+     * edge.
+     * Doing so, we might mess up the point from where the lanes are shown. It should be
+     * reasonable, since the announcements have to come early anyhow. So there is a
+     * potential danger in here, but it saves us from adding a lot of additional edges for
+     * turn-lanes. Without this,we would have to treat any turn-lane beginning/ending just
+     * like a barrier.
+     */
+    const auto selectLaneID = [](const LaneDescriptionID front,
+                                 const LaneDescriptionID back) {
+        // A lane has tags: u - (front) - v - (back) - w
+        // During contraction, we keep only one of the tags. Usually the one closer to the
+        // intersection is preferred. If its empty, however, we keep the non-empty one
+        if (back == INVALID_LANE_DESCRIPTIONID)
+            return front;
+        return back;
+    };
+    graph.GetEdgeData(forward_e1).lane_description_id =
+        selectLaneID(graph.GetEdgeData(forward_e1).lane_description_id,
+                     fwd_edge_data2.lane_description_id);
+    graph.GetEdgeData(reverse_e1).lane_description_id =
+        selectLaneID(graph.GetEdgeData(reverse_e1).lane_description_id,
+                     rev_edge_data2.lane_description_id);
+
+    // remove e2's (if bidir, otherwise only one)
+    graph.DeleteEdge(node_v, forward_e2);
+    graph.DeleteEdge(node_v, reverse_e2);
+
+    // update any involved turn restrictions
+    restriction_map.FixupStartingTurnRestriction(node_u, node_v, node_w);
+    restriction_map.FixupArrivingTurnRestriction(node_u, node_v, node_w, graph);
+
+    restriction_map.FixupStartingTurnRestriction(node_w, node_v, node_u);
+    restriction_map.FixupArrivingTurnRestriction(node_w, node_v, node_u, graph);
+
+    // store compressed geometry in container
+    if (reserve_geometry)
+    {
+        geometry_compressor.ReserveCompressedEdge(forward_e1, forward_e2);
+        geometry_compressor.ReserveCompressedEdge(reverse_e1, reverse_e2);
+    }
+    else
+    {
+        geometry_compressor.CompressEdge(
+            forward_e1, forward_e2, node_v, node_w, forward_weight1, forward_weight2);
+        geometry_compressor.CompressEdge(
+            reverse_e1, reverse_e2, node_v, node_u, reverse_weight1, reverse_weight2);
     }
 }
 
@@ -19,25 +19,76 @@ namespace guidance
 {
 
 IntersectionGenerator::IntersectionGenerator(
-    const util::NodeBasedDynamicGraph &node_based_graph,
+    const util::NodeBasedStaticGraph &node_based_graph,
     const RestrictionMap &restriction_map,
     const std::unordered_set<NodeID> &barrier_nodes,
     const std::vector<QueryNode> &node_info_list,
     const CompressedEdgeContainer &compressed_edge_container)
     : node_based_graph(node_based_graph), restriction_map(restriction_map),
       barrier_nodes(barrier_nodes), node_info_list(node_info_list),
-      compressed_edge_container(compressed_edge_container)
+      compressed_edge_container(compressed_edge_container), number_of_computed_connected_roads(0),
+      number_of_cached_connected_roads(0)
 {
 }
 
+IntersectionGenerator::CacheScope::CacheScope(const IntersectionGenerator &generator)
+    : generator(generator)
+{
+    ++generator.connected_roads_caches.local().scope_depth;
+}
+
+IntersectionGenerator::CacheScope::~CacheScope()
+{
+    auto &cache = generator.connected_roads_caches.local();
+    BOOST_ASSERT(cache.scope_depth > 0);
+    if (--cache.scope_depth == 0)
+    {
+        cache.intersections.clear();
+    }
+}
+
+std::size_t IntersectionGenerator::GetNumberOfComputedConnectedRoads() const
+{
+    return number_of_computed_connected_roads;
+}
+
+std::size_t IntersectionGenerator::GetNumberOfCachedConnectedRoads() const
+{
+    return number_of_cached_connected_roads;
+}
+
 Intersection IntersectionGenerator::operator()(const NodeID from_node, const EdgeID via_eid) const
 {
-    auto intersection = GetConnectedRoads(from_node, via_eid);
+    auto intersection = GetCachedConnectedRoads(from_node, via_eid);
     const auto node_at_intersection = node_based_graph.GetTarget(via_eid);
     return AdjustForJoiningRoads(
         node_at_intersection, MergeSegregatedRoads(node_at_intersection, std::move(intersection)));
 }
 
+Intersection IntersectionGenerator::GetCachedConnectedRoads(const NodeID from_node,
+                                                            const EdgeID via_eid) const
+{
+    auto &cache = connected_roads_caches.local();
+    if (cache.scope_depth == 0)
+    {
+        ++number_of_computed_connected_roads;
+        return GetConnectedRoads(from_node, via_eid);
+    }
+
+    const std::uint64_t key = (static_cast<std::uint64_t>(from_node) << 32) | via_eid;
+    const auto cached = cache.intersections.find(key);
+    if (cached != cache.intersections.end())
+    {
+        ++number_of_cached_connected_roads;
+        return cached->second;
+    }
+
+    ++number_of_computed_connected_roads;
+    auto intersection = GetConnectedRoads(from_node, via_eid);
+    cache.intersections.emplace(key, intersection);
+    return intersection;
+}
+
 //                                               a
 //                                               |
 //                                               |
@@ -515,7 +566,7 @@ Intersection IntersectionGenerator::AdjustForJoiningRoads(const NodeID node_at_i
         // the example). If the initial road can be merged to the left/right, we are about to adjust
         // the angle.
         const auto next_intersection_along_road =
-            GetConnectedRoads(node_at_intersection, road.turn.eid);
+            GetCachedConnectedRoads(node_at_intersection, road.turn.eid);
         if (next_intersection_along_road.size() <= 1)
             continue;
 
@@ -572,7 +623,7 @@ IntersectionGenerator::GetActualNextIntersection(const NodeID starting_node,
 {
     // This function skips over traffic lights/graph compression issues and similar to find the next
     // actual intersection
-    Intersection result = GetConnectedRoads(starting_node, via_edge);
+    Intersection result = GetCachedConnectedRoads(starting_node, via_edge);
 
     // Skip over stuff that has not been compressed due to barriers/parallel edges
     NodeID node_at_intersection = starting_node;
@@ -591,7 +642,7 @@ IntersectionGenerator::GetActualNextIntersection(const NodeID starting_node,
         visited_nodes.insert(node_at_intersection);
         node_at_intersection = node_based_graph.GetTarget(incoming_edge);
         incoming_edge = result[1].turn.eid;
-        result = GetConnectedRoads(node_at_intersection, incoming_edge);
+        result = GetCachedConnectedRoads(node_at_intersection, incoming_edge);
 
         // When looping back to the original node, we obviously are in a loop. Stop there.
         if (termination_node == node_based_graph.GetTarget(incoming_edge))
@@ -23,24 +23,24 @@ namespace guidance
 namespace
 {
 
-inline bool isMotorwayClass(EdgeID eid, const util::NodeBasedDynamicGraph &node_based_graph)
+inline bool isMotorwayClass(EdgeID eid, const util::NodeBasedStaticGraph &node_based_graph)
 {
     return node_based_graph.GetEdgeData(eid).road_classification.IsMotorwayClass();
 }
 inline RoadClassification roadClass(const ConnectedRoad &road,
-                                    const util::NodeBasedDynamicGraph &graph)
+                                    const util::NodeBasedStaticGraph &graph)
 {
     return graph.GetEdgeData(road.turn.eid).road_classification;
 }
 
-inline bool isRampClass(EdgeID eid, const util::NodeBasedDynamicGraph &node_based_graph)
+inline bool isRampClass(EdgeID eid, const util::NodeBasedStaticGraph &node_based_graph)
 {
     return node_based_graph.GetEdgeData(eid).road_classification.IsRampClass();
 }
 
 } // namespace
 
-MotorwayHandler::MotorwayHandler(const util::NodeBasedDynamicGraph &node_based_graph,
+MotorwayHandler::MotorwayHandler(const util::NodeBasedStaticGraph &node_based_graph,
                                  const std::vector<QueryNode> &node_info_list,
                                  const util::NameTable &name_table,
                                  const SuffixTable &street_name_suffix_table,
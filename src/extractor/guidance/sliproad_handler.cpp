@@ -10,7 +10,7 @@
 
 #include <boost/assert.hpp>
 
-using EdgeData = osrm::util::NodeBasedDynamicGraph::EdgeData;
+using EdgeData = osrm::util::NodeBasedStaticGraph::EdgeData;
 using osrm::util::guidance::getTurnDirection;
 using osrm::util::guidance::angularDeviation;
 
@@ -22,7 +22,7 @@ namespace guidance
 {
 
 SliproadHandler::SliproadHandler(const IntersectionGenerator &intersection_generator,
-                                 const util::NodeBasedDynamicGraph &node_based_graph,
+                                 const util::NodeBasedStaticGraph &node_based_graph,
                                  const std::vector<QueryNode> &node_info_list,
                                  const util::NameTable &name_table,
                                  const SuffixTable &street_name_suffix_table)
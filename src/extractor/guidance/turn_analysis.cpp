@@ -24,14 +24,14 @@ namespace extractor
 namespace guidance
 {
 
-using EdgeData = util::NodeBasedDynamicGraph::EdgeData;
+using EdgeData = util::NodeBasedStaticGraph::EdgeData;
 
 bool requiresAnnouncement(const EdgeData &from, const EdgeData &to)
 {
     return !from.IsCompatibleTo(to);
 }
 
-TurnAnalysis::TurnAnalysis(const util::NodeBasedDynamicGraph &node_based_graph,
+TurnAnalysis::TurnAnalysis(const util::NodeBasedStaticGraph &node_based_graph,
                            const std::vector<QueryNode> &node_info_list,
                            const RestrictionMap &restriction_map,
                            const std::unordered_set<NodeID> &barrier_nodes,
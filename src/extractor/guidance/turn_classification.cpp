@@ -1,7 +1,11 @@
 #include "extractor/guidance/turn_classification.hpp"
 
+#include "util/integer_range.hpp"
 #include "util/simple_logger.hpp"
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <cstddef>
 #include <cstdint>
 #include <iomanip>
@@ -26,29 +30,68 @@ struct TurnPossibility
     double bearing;
 };
 
+namespace
+{
+double computeEdgeBearing(const NodeID nid,
+                          const EdgeID eid,
+                          const util::NodeBasedStaticGraph &node_based_graph,
+                          const extractor::CompressedEdgeContainer &compressed_geometries,
+                          const std::vector<extractor::QueryNode> &query_nodes)
+{
+    const auto node_coordinate = util::Coordinate(query_nodes[nid].lon, query_nodes[nid].lat);
+    const auto edge_coordinate = getRepresentativeCoordinate(
+        nid, node_based_graph.GetTarget(eid), eid, false, compressed_geometries, query_nodes);
+    return util::coordinate_calculation::bearing(node_coordinate, edge_coordinate);
+}
+}
+
+std::vector<double>
+computeEdgeBearings(const util::NodeBasedStaticGraph &node_based_graph,
+                    const extractor::CompressedEdgeContainer &compressed_geometries,
+                    const std::vector<extractor::QueryNode> &query_nodes)
+{
+    std::vector<double> edge_bearings(node_based_graph.GetNumberOfEdges(), 0.);
+    tbb::parallel_for(
+        tbb::blocked_range<NodeID>(0, node_based_graph.GetNumberOfNodes()),
+        [&](const tbb::blocked_range<NodeID> &range) {
+            for (const auto nid : util::irange(range.begin(), range.end()))
+            {
+                for (const auto eid : node_based_graph.GetAdjacentEdgeRange(nid))
+                {
+                    edge_bearings[eid] = computeEdgeBearing(
+                        nid, eid, node_based_graph, compressed_geometries, query_nodes);
+                }
+            }
+        });
+    return edge_bearings;
+}
+
 std::pair<util::guidance::EntryClass, util::guidance::BearingClass>
 classifyIntersection(NodeID nid,
                      const Intersection &intersection,
-                     const util::NodeBasedDynamicGraph &node_based_graph,
+                     const util::NodeBasedStaticGraph &node_based_graph,
                      const extractor::CompressedEdgeContainer &compressed_geometries,
-                     const std::vector<extractor::QueryNode> &query_nodes)
+                     const std::vector<extractor::QueryNode> &query_nodes,
+                     const std::vector<double> &edge_bearings)
 {
     if (intersection.empty())
         return {};
 
     std::vector<TurnPossibility> turns;
-
-    const auto node_coordinate = util::Coordinate(query_nodes[nid].lon, query_nodes[nid].lat);
+    turns.reserve(intersection.size());
 
     // generate a list of all turn angles between a base edge, the node and a current edge
     for (const auto &road : intersection)
     {
         const auto eid = road.turn.eid;
-        const auto edge_coordinate = getRepresentativeCoordinate(
-            nid, node_based_graph.GetTarget(eid), eid, false, compressed_geometries, query_nodes);
-
+        // the artificial u-turn of a dead end is the edge that leads into the node
+        const bool is_node_edge =
+            eid >= node_based_graph.BeginEdges(nid) && eid < node_based_graph.EndEdges(nid);
         const double bearing =
-            util::coordinate_calculation::bearing(node_coordinate, edge_coordinate);
+            is_node_edge
+                ? edge_bearings[eid]
+                : computeEdgeBearing(
+                      nid, eid, node_based_graph, compressed_geometries, query_nodes);
         turns.push_back({road.entry_allowed, bearing});
     }
 
@@ -12,6 +12,9 @@
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 namespace osrm
 {
 namespace extractor
@@ -31,7 +34,7 @@ std::size_t getNumberOfTurns(const Intersection &intersection)
 }
 } // namespace
 
-TurnLaneHandler::TurnLaneHandler(const util::NodeBasedDynamicGraph &node_based_graph,
+TurnLaneHandler::TurnLaneHandler(const util::NodeBasedStaticGraph &node_based_graph,
                                  std::vector<std::uint32_t> &turn_lane_offsets,
                                  std::vector<TurnLaneType::Mask> &turn_lane_masks,
                                  LaneDescriptionMap &lane_description_map,
@@ -43,6 +46,22 @@ TurnLaneHandler::TurnLaneHandler(const util::NodeBasedDynamicGraph &node_based_g
       node_info_list(node_info_list), turn_analysis(turn_analysis), id_map(id_map)
 {
     count_handled = count_called = 0;
+
+    // The descriptions are decoded once instead of at every intersection of a road that uses
+    // them. Lane descriptions for sliproads that are added later on are never looked up here.
+    lane_data_by_description.resize(turn_lane_offsets.empty() ? 0 : turn_lane_offsets.size() - 1);
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, lane_data_by_description.size()),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto description_id = range.begin(); description_id != range.end();
+                 ++description_id)
+            {
+                lane_data_by_description[description_id] = laneDataFromDescription(
+                    TurnLaneDescription(turn_lane_masks.begin() + turn_lane_offsets[description_id],
+                                        turn_lane_masks.begin() +
+                                            turn_lane_offsets[description_id + 1]));
+            }
+        });
 }
 
 TurnLaneHandler::~TurnLaneHandler()
@@ -358,13 +377,8 @@ void TurnLaneHandler::extractLaneData(const EdgeID via_edge,
     // create an empty lane data
     if (INVALID_LANE_DESCRIPTIONID != lane_description_id)
     {
-        const auto lane_description = TurnLaneDescription(
-            turn_lane_masks.begin() + turn_lane_offsets[lane_description_id],
-            turn_lane_masks.begin() + turn_lane_offsets[lane_description_id + 1]);
-
-        lane_data = laneDataFromDescription(lane_description);
-        BOOST_ASSERT(lane_description.size() == (turn_lane_offsets[lane_description_id + 1] -
-                                                 turn_lane_offsets[lane_description_id]));
+        BOOST_ASSERT(lane_description_id < lane_data_by_description.size());
+        lane_data = lane_data_by_description[lane_description_id];
     }
     else
     {
@@ -0,0 +1,163 @@
+#include "extractor/name_interner.hpp"
+#include "extractor/extraction_way.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace osrm
+{
+namespace extractor
+{
+
+namespace
+{
+const constexpr std::size_t MIN_CAPACITY_BITS = 10;
+// a block holds many names, every name fits into a block
+const constexpr std::size_t BLOCK_SIZE = 1 << 20;
+static_assert(BLOCK_SIZE >= 4 * NameInterner::MAX_STRING_LENGTH, "a name needs to fit a block");
+
+util::StringView truncate(const util::StringView string)
+{
+    return string.substr(0, NameInterner::MAX_STRING_LENGTH);
+}
+}
+
+constexpr std::size_t NameInterner::MAX_STRING_LENGTH;
+
+NameInterner::Key NameInterner::MakeKey(const util::StringView name,
+                                        const util::StringView destinations,
+                                        const util::StringView pronunciation,
+                                        const util::StringView ref)
+{
+    Key key{{{truncate(name), truncate(destinations), truncate(pronunciation), truncate(ref)}},
+            0};
+    for (const auto &string : key.strings)
+    {
+        boost::hash_combine(key.hash, boost::hash_range(string.begin(), string.end()));
+    }
+    return key;
+}
+
+NameInterner::Key NameInterner::MakeKey(const ExtractionWay &way)
+{
+    return MakeKey(way.name, way.destinations, way.pronunciation, way.ref);
+}
+
+NameInterner::NameInterner()
+    : slots(std::size_t{1} << MIN_CAPACITY_BITS, Slot{nullptr, 0, {{0, 0, 0, 0}}, 0}), size(0),
+      shift(64 - MIN_CAPACITY_BITS), block_used(0)
+{
+}
+
+unsigned NameInterner::Intern(const Key &key, const unsigned new_id)
+{
+    auto index = GetIndex(key.hash);
+    while (slots[index].data != nullptr)
+    {
+        if (Equals(slots[index], key))
+        {
+            return slots[index].id;
+        }
+        index = (index + 1) & (slots.size() - 1);
+    }
+
+    // at most half of the slots are used, so there is always an empty slot to stop a probe
+    if (2 * (size + 1) > slots.size())
+    {
+        Rehash(2 * slots.size());
+        index = GetIndex(key.hash);
+        while (slots[index].data != nullptr)
+        {
+            index = (index + 1) & (slots.size() - 1);
+        }
+    }
+
+    auto &slot = slots[index];
+    slot.data = Store(key);
+    slot.hash = key.hash;
+    for (const auto i : {0, 1, 2, 3})
+    {
+        slot.lengths[i] = static_cast<std::uint8_t>(key.strings[i].size());
+    }
+    slot.id = new_id;
+    ++size;
+    return new_id;
+}
+
+bool NameInterner::Equals(const Slot &slot, const Key &key)
+{
+    if (slot.hash != key.hash)
+    {
+        return false;
+    }
+    auto data = slot.data;
+    for (const auto i : {0, 1, 2, 3})
+    {
+        const auto &string = key.strings[i];
+        if (slot.lengths[i] != string.size() ||
+            (!string.empty() && std::memcmp(data, string.data(), string.size()) != 0))
+        {
+            return false;
+        }
+        data += string.size();
+    }
+    return true;
+}
+
+std::size_t NameInterner::GetIndex(const std::size_t hash) const
+{
+    // Fibonacci hashing spreads the hashes of similar names over the table
+    return static_cast<std::size_t>((static_cast<std::uint64_t>(hash) * 11400714819323198485ull) >>
+                                    shift);
+}
+
+const char *NameInterner::Store(const Key &key)
+{
+    std::size_t length = 0;
+    for (const auto &string : key.strings)
+    {
+        length += string.size();
+    }
+    if (blocks.empty() || block_used + length > BLOCK_SIZE)
+    {
+        blocks.emplace_back(new char[BLOCK_SIZE]);
+        block_used = 0;
+    }
+
+    const auto data = blocks.back().get() + block_used;
+    auto out = data;
+    for (const auto &string : key.strings)
+    {
+        out = std::copy(string.begin(), string.end(), out);
+    }
+    block_used += length;
+    return data;
+}
+
+void NameInterner::Rehash(const std::size_t capacity)
+{
+    BOOST_ASSERT((capacity & (capacity - 1)) == 0);
+    std::vector<Slot> old_slots(capacity, Slot{nullptr, 0, {{0, 0, 0, 0}}, 0});
+    old_slots.swap(slots);
+    --shift;
+    BOOST_ASSERT((std::size_t{1} << (64 - shift)) == capacity);
+
+    for (const auto &slot : old_slots)
+    {
+        if (slot.data == nullptr)
+        {
+            continue;
+        }
+        auto index = GetIndex(slot.hash);
+        while (slots[index].data != nullptr)
+        {
+            index = (index + 1) & (slots.size() - 1);
+        }
+        slots[index] = slot;
+    }
+}
+}
+}
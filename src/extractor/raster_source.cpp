@@ -3,13 +3,230 @@
 #include "util/simple_logger.hpp"
 #include "util/timing_util.hpp"
 
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/spirit/include/qi.hpp>
+#include <boost/spirit/include/qi_int.hpp>
+
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <mutex>
+#include <numeric>
 
 namespace osrm
 {
 namespace extractor
 {
 
+namespace
+{
+const char TILES_MAGIC[8] = {'O', 'S', 'R', 'M', 'R', 'S', 'T', 'R'};
+const std::uint32_t TILES_VERSION = 1;
+
+struct TilesHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t tile_bits;
+    std::uint64_t width;
+    std::uint64_t height;
+};
+static_assert(sizeof(TilesHeader) == 32, "the header is written as it is");
+
+std::size_t getNumberOfTiles(const std::size_t xdim, const std::size_t ydim)
+{
+    const auto tiles_per_row = (xdim + RasterGrid::TILE_SIZE - 1) / RasterGrid::TILE_SIZE;
+    const auto tiles_per_column = (ydim + RasterGrid::TILE_SIZE - 1) / RasterGrid::TILE_SIZE;
+    return tiles_per_row * tiles_per_column;
+}
+
+bool isTiledRaster(const boost::filesystem::path &filepath)
+{
+    boost::filesystem::ifstream stream(filepath, std::ios::binary);
+    char magic[sizeof(TILES_MAGIC)];
+    return stream.read(magic, sizeof(magic)) &&
+           std::equal(TILES_MAGIC, TILES_MAGIC + sizeof(TILES_MAGIC), magic);
+}
+
+// Parses an ASCII grid into tiles, the padding of the tiles at the right and bottom border is
+// never read
+std::shared_ptr<std::vector<std::int32_t>>
+parseASCIIRaster(const boost::filesystem::path &filepath, std::size_t xdim, std::size_t ydim)
+{
+    boost::filesystem::ifstream stream(filepath, std::ios::binary);
+    if (!stream)
+    {
+        throw util::exception("Unable to open raster file.");
+    }
+
+    stream.seekg(0, std::ios_base::end);
+    std::string buffer;
+    buffer.resize(static_cast<std::size_t>(stream.tellg()));
+
+    stream.seekg(0, std::ios_base::beg);
+
+    BOOST_ASSERT(buffer.size() > 1);
+    stream.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+
+    boost::algorithm::trim(buffer);
+
+    auto itr = buffer.begin();
+    auto end = buffer.end();
+
+    std::vector<std::int32_t> values;
+    values.reserve(ydim * xdim);
+
+    bool r = false;
+    try
+    {
+        r = boost::spirit::qi::parse(
+            itr, end, +boost::spirit::qi::int_ % +boost::spirit::qi::space, values);
+    }
+    catch (std::exception const &ex)
+    {
+        throw util::exception(
+            std::string("Failed to read from raster source with exception: ") + ex.what());
+    }
+
+    if (!r || itr != end || values.size() < xdim * ydim)
+    {
+        throw util::exception("Failed to parse raster source correctly.");
+    }
+
+    const auto tiles_per_row = (xdim + RasterGrid::TILE_SIZE - 1) / RasterGrid::TILE_SIZE;
+    auto tiles = std::make_shared<std::vector<std::int32_t>>(
+        getNumberOfTiles(xdim, ydim) * RasterGrid::TILE_SIZE * RasterGrid::TILE_SIZE,
+        RasterDatum::get_invalid());
+    for (std::size_t y = 0; y < ydim; ++y)
+    {
+        for (std::size_t x = 0; x < xdim; ++x)
+        {
+            const auto tile = (y >> RasterGrid::TILE_BITS) * tiles_per_row +
+                              (x >> RasterGrid::TILE_BITS);
+            const auto offset = (tile << (2 * RasterGrid::TILE_BITS)) +
+                                ((y & (RasterGrid::TILE_SIZE - 1)) << RasterGrid::TILE_BITS) +
+                                (x & (RasterGrid::TILE_SIZE - 1));
+            (*tiles)[offset] = values[y * xdim + x];
+        }
+    }
+    return tiles;
+}
+
+std::shared_ptr<boost::iostreams::mapped_file_source>
+mapTiledRaster(const boost::filesystem::path &filepath, std::size_t xdim, std::size_t ydim)
+{
+    auto mapping = std::make_shared<boost::iostreams::mapped_file_source>(filepath.string());
+
+    TilesHeader header;
+    if (mapping->size() < sizeof(header))
+    {
+        throw util::exception(filepath.string() + " is truncated.");
+    }
+    std::memcpy(&header, mapping->data(), sizeof(header));
+    if (header.version != TILES_VERSION || header.tile_bits != RasterGrid::TILE_BITS)
+    {
+        throw util::exception(filepath.string() +
+                              " was written by a different version, convert it again.");
+    }
+    if (header.width != xdim || header.height != ydim)
+    {
+        throw util::exception(filepath.string() + " has " + std::to_string(header.width) +
+                              " columns and " + std::to_string(header.height) + " rows, not " +
+                              std::to_string(xdim) + " columns and " + std::to_string(ydim) +
+                              " rows.");
+    }
+    const auto tiles_size = getNumberOfTiles(xdim, ydim) * RasterGrid::TILE_SIZE *
+                            RasterGrid::TILE_SIZE * sizeof(std::int32_t);
+    if (mapping->size() != sizeof(header) + tiles_size)
+    {
+        throw util::exception(filepath.string() + " is truncated.");
+    }
+    return mapping;
+}
+
+// The grids that are loaded, by their path and dimensions. The grids are freed when the last
+// source using them is gone.
+struct LoadedGrid
+{
+    std::weak_ptr<const void> storage;
+    const std::int32_t *tiles;
+};
+
+std::mutex loaded_grids_mutex;
+std::unordered_map<std::string, LoadedGrid> loaded_grids;
+}
+
+constexpr std::size_t RasterGrid::TILE_BITS;
+constexpr std::size_t RasterGrid::TILE_SIZE;
+
+RasterGrid::RasterGrid(std::shared_ptr<const void> storage_,
+                       const std::int32_t *tiles_,
+                       std::size_t xdim_,
+                       std::size_t ydim_)
+    : storage(std::move(storage_)), tiles(tiles_), xdim(xdim_), ydim(ydim_),
+      tiles_per_row((xdim_ + TILE_SIZE - 1) / TILE_SIZE)
+{
+}
+
+RasterGrid
+RasterGrid::Load(const boost::filesystem::path &filepath, std::size_t xdim, std::size_t ydim)
+{
+    if (xdim == 0 || ydim == 0)
+    {
+        throw util::exception("A raster source needs at least one row and column.");
+    }
+
+    const auto key = boost::filesystem::absolute(filepath).string() + ":" +
+                     std::to_string(xdim) + "x" + std::to_string(ydim);
+
+    // threads loading the same grid wait for the first one instead of parsing it again
+    std::lock_guard<std::mutex> lock(loaded_grids_mutex);
+    auto &loaded = loaded_grids[key];
+    if (const auto storage = loaded.storage.lock())
+    {
+        return RasterGrid(storage, loaded.tiles, xdim, ydim);
+    }
+
+    std::shared_ptr<const void> storage;
+    const std::int32_t *tiles;
+    if (isTiledRaster(filepath))
+    {
+        const auto mapping = mapTiledRaster(filepath, xdim, ydim);
+        tiles = reinterpret_cast<const std::int32_t *>(mapping->data() + sizeof(TilesHeader));
+        storage = mapping;
+    }
+    else
+    {
+        const auto parsed = parseASCIIRaster(filepath, xdim, ydim);
+        tiles = parsed->data();
+        storage = parsed;
+    }
+    loaded = LoadedGrid{storage, tiles};
+    return RasterGrid(std::move(storage), tiles, xdim, ydim);
+}
+
+void RasterGrid::WriteTiles(const boost::filesystem::path &filepath) const
+{
+    TilesHeader header;
+    std::copy(TILES_MAGIC, TILES_MAGIC + sizeof(TILES_MAGIC), header.magic);
+    header.version = TILES_VERSION;
+    header.tile_bits = TILE_BITS;
+    header.width = xdim;
+    header.height = ydim;
+
+    boost::filesystem::ofstream stream(filepath, std::ios::binary);
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char *>(tiles),
+                 getNumberOfTiles(xdim, ydim) * TILE_SIZE * TILE_SIZE * sizeof(std::int32_t));
+    if (!stream)
+    {
+        throw util::exception("Could not write the raster to " + filepath.string());
+    }
+}
+
 RasterSource::RasterSource(RasterGrid _raster_data,
                            std::size_t _width,
                            std::size_t _height,
@@ -75,6 +292,38 @@ RasterDatum RasterSource::GetRasterInterpolate(const int lon, const int lat) con
                                       raster_data(right, bottom) * (fromLeft * fromTop))};
 }
 
+void RasterSource::GetRasterInterpolate(const std::vector<util::Coordinate> &coordinates,
+                                        std::vector<RasterDatum> &data) const
+{
+    data.resize(coordinates.size());
+
+    // query the coordinates tile by tile, so that the pages of a tile are touched together
+    std::vector<std::pair<std::size_t, std::size_t>> tile_and_index;
+    tile_and_index.reserve(coordinates.size());
+    for (std::size_t index = 0; index < coordinates.size(); ++index)
+    {
+        const auto lon = static_cast<std::int32_t>(coordinates[index].lon);
+        const auto lat = static_cast<std::int32_t>(coordinates[index].lat);
+        if (lon < xmin || lon > xmax || lat < ymin || lat > ymax)
+        {
+            data[index] = {};
+            continue;
+        }
+        const auto x = static_cast<std::size_t>((lon - xmin) / xstep);
+        const auto y = static_cast<std::size_t>((ymax - lat) / ystep);
+        tile_and_index.emplace_back(
+            raster_data.GetTile(std::min(x, width - 1), std::min(y, height - 1)), index);
+    }
+    std::sort(tile_and_index.begin(), tile_and_index.end());
+
+    for (const auto &entry : tile_and_index)
+    {
+        const auto &coordinate = coordinates[entry.second];
+        data[entry.second] = GetRasterInterpolate(static_cast<std::int32_t>(coordinate.lon),
+                                                  static_cast<std::int32_t>(coordinate.lat));
+    }
+}
+
 // Load raster source into memory
 int SourceContainer::LoadRasterSource(const std::string &path_string,
                                       double xmin,
@@ -108,7 +357,7 @@ int SourceContainer::LoadRasterSource(const std::string &path_string,
         throw util::exception("error reading: no such path");
     }
 
-    RasterGrid rasterData{filepath, ncols, nrows};
+    auto rasterData = RasterGrid::Load(filepath, ncols, nrows);
 
     RasterSource source{std::move(rasterData), ncols, nrows, _xmin, _xmax, _ymin, _ymax};
     TIMER_STOP(loading_source);
@@ -121,20 +370,25 @@ int SourceContainer::LoadRasterSource(const std::string &path_string,
     return source_id;
 }
 
-// External function for looking up nearest data point from a specified source
-RasterDatum SourceContainer::GetRasterDataFromSource(unsigned int source_id, double lon, double lat)
+const RasterSource &SourceContainer::GetSource(unsigned int source_id) const
 {
     if (LoadedSources.size() < source_id + 1)
     {
         throw util::exception("error reading: no such loaded source");
     }
+    return LoadedSources[source_id];
+}
+
+// External function for looking up nearest data point from a specified source
+RasterDatum SourceContainer::GetRasterDataFromSource(unsigned int source_id, double lon, double lat)
+{
+    const auto &found = GetSource(source_id);
 
     BOOST_ASSERT(lat < 90);
     BOOST_ASSERT(lat > -90);
     BOOST_ASSERT(lon < 180);
     BOOST_ASSERT(lon > -180);
 
-    const auto &found = LoadedSources[source_id];
     return found.GetRasterData(static_cast<std::int32_t>(util::toFixed(util::FloatLongitude{lon})),
                                static_cast<std::int32_t>(util::toFixed(util::FloatLatitude{lat})));
 }
@@ -143,20 +397,25 @@ RasterDatum SourceContainer::GetRasterDataFromSource(unsigned int source_id, dou
 RasterDatum
 SourceContainer::GetRasterInterpolateFromSource(unsigned int source_id, double lon, double lat)
 {
-    if (LoadedSources.size() < source_id + 1)
-    {
-        throw util::exception("error reading: no such loaded source");
-    }
+    const auto &found = GetSource(source_id);
 
     BOOST_ASSERT(lat < 90);
     BOOST_ASSERT(lat > -90);
     BOOST_ASSERT(lon < 180);
     BOOST_ASSERT(lon > -180);
 
-    const auto &found = LoadedSources[source_id];
     return found.GetRasterInterpolate(
         static_cast<std::int32_t>(util::toFixed(util::FloatLongitude{lon})),
         static_cast<std::int32_t>(util::toFixed(util::FloatLatitude{lat})));
 }
+
+// External function for interpolating the data at many coordinates of a specified source
+void SourceContainer::GetRasterInterpolateFromSource(
+    unsigned int source_id,
+    const std::vector<util::Coordinate> &coordinates,
+    std::vector<RasterDatum> &data) const
+{
+    GetSource(source_id).GetRasterInterpolate(coordinates, data);
+}
 }
 }
@@ -1,5 +1,7 @@
 #include "extractor/restriction_map.hpp"
 
+#include <algorithm>
+
 namespace osrm
 {
 namespace extractor
@@ -7,6 +9,20 @@ namespace extractor
 
 RestrictionMap::RestrictionMap(const std::vector<TurnRestriction> &restriction_list) : m_count(0)
 {
+    NodeID max_start_node = 0;
+    NodeID max_via_node = 0;
+    for (const auto &restriction : restriction_list)
+    {
+        max_start_node = std::max(max_start_node, static_cast<NodeID>(restriction.from.node));
+        max_via_node = std::max(max_via_node, static_cast<NodeID>(restriction.via.node));
+    }
+    if (!restriction_list.empty())
+    {
+        m_restriction_start_nodes.resize(max_start_node + 1, false);
+        m_no_turn_via_node_set.resize(max_via_node + 1, false);
+    }
+    m_restriction_map.Reserve(restriction_list.size());
+
     // decompose restriction consisting of a start, via and end node into a
     // a pair of starting edge and a list of all end nodes
     for (auto &restriction : restriction_list)
@@ -16,24 +32,24 @@ RestrictionMap::RestrictionMap(const std::vector<TurnRestriction> &restriction_l
         // This will be a problem if we have more than 2^32 actual restrictions
         BOOST_ASSERT(restriction.from.node < std::numeric_limits<NodeID>::max());
         BOOST_ASSERT(restriction.via.node < std::numeric_limits<NodeID>::max());
-        m_restriction_start_nodes.insert(restriction.from.node);
-        m_no_turn_via_node_set.insert(restriction.via.node);
+        m_restriction_start_nodes[restriction.from.node] = true;
+        m_no_turn_via_node_set[restriction.via.node] = true;
 
         // This explicit downcasting is also OK for the same reason.
         RestrictionSource restriction_source = {static_cast<NodeID>(restriction.from.node),
                                                 static_cast<NodeID>(restriction.via.node)};
 
         std::size_t index;
-        auto restriction_iter = m_restriction_map.find(restriction_source);
-        if (restriction_iter == m_restriction_map.end())
+        const auto known_index = m_restriction_map.Find(GetKey(restriction_source));
+        if (!known_index)
         {
             index = m_restriction_bucket_list.size();
             m_restriction_bucket_list.resize(index + 1);
-            m_restriction_map.emplace(restriction_source, index);
+            m_restriction_map.Insert(GetKey(restriction_source), index);
         }
         else
         {
-            index = restriction_iter->second;
+            index = *known_index;
             // Map already contains an is_only_*-restriction
             if (m_restriction_bucket_list.at(index).begin()->is_only)
             {
@@ -55,7 +71,7 @@ RestrictionMap::RestrictionMap(const std::vector<TurnRestriction> &restriction_l
 
 bool RestrictionMap::IsViaNode(const NodeID node) const
 {
-    return m_no_turn_via_node_set.find(node) != m_no_turn_via_node_set.end();
+    return IsMarked(m_no_turn_via_node_set, node);
 }
 
 // Replaces start edge (v, w) with (u, w). Only start node changes.
@@ -72,16 +88,20 @@ void RestrictionMap::FixupStartingTurnRestriction(const NodeID node_u,
         return;
     }
 
-    const auto restriction_iterator = m_restriction_map.find({node_v, node_w});
-    if (restriction_iterator != m_restriction_map.end())
+    const auto old_key = GetKey({node_v, node_w});
+    const auto restriction_index = m_restriction_map.Find(old_key);
+    if (restriction_index)
     {
-        const unsigned index = restriction_iterator->second;
+        const unsigned index = *restriction_index;
         // remove old restriction start (v,w)
-        m_restriction_map.erase(restriction_iterator);
-        m_restriction_start_nodes.emplace(node_u);
+        m_restriction_map.Erase(old_key);
+        if (m_restriction_start_nodes.size() <= node_u)
+        {
+            m_restriction_start_nodes.resize(node_u + 1, false);
+        }
+        m_restriction_start_nodes[node_u] = true;
         // insert new restriction start (u,w) (pointing to index)
-        RestrictionSource new_source = {node_u, node_w};
-        m_restriction_map.emplace(new_source, index);
+        m_restriction_map.Insert(GetKey({node_u, node_w}), index);
     }
 }
 
@@ -97,11 +117,10 @@ NodeID RestrictionMap::CheckForEmanatingIsOnlyTurn(const NodeID node_u, const No
         return SPECIAL_NODEID;
     }
 
-    const auto restriction_iter = m_restriction_map.find({node_u, node_v});
-    if (restriction_iter != m_restriction_map.end())
+    const auto index = m_restriction_map.Find(GetKey({node_u, node_v}));
+    if (index)
     {
-        const unsigned index = restriction_iter->second;
-        const auto &bucket = m_restriction_bucket_list.at(index);
+        const auto &bucket = m_restriction_bucket_list.at(*index);
         for (const RestrictionTarget &restriction_target : bucket)
         {
             if (restriction_target.is_only)
@@ -127,14 +146,13 @@ bool RestrictionMap::CheckIfTurnIsRestricted(const NodeID node_u,
         return false;
     }
 
-    const auto restriction_iter = m_restriction_map.find({node_u, node_v});
-    if (restriction_iter == m_restriction_map.end())
+    const auto index = m_restriction_map.Find(GetKey({node_u, node_v}));
+    if (!index)
     {
         return false;
     }
 
-    const unsigned index = restriction_iter->second;
-    const auto &bucket = m_restriction_bucket_list.at(index);
+    const auto &bucket = m_restriction_bucket_list.at(*index);
 
     for (const RestrictionTarget &restriction_target : bucket)
     {
@@ -153,7 +171,7 @@ bool RestrictionMap::CheckIfTurnIsRestricted(const NodeID node_u,
 // check of node is the start of any restriction
 bool RestrictionMap::IsSourceNode(const NodeID node) const
 {
-    return m_restriction_start_nodes.find(node) != m_restriction_start_nodes.end();
+    return IsMarked(m_restriction_start_nodes, node);
 }
 }
 }
@@ -9,6 +9,7 @@
 #include "extractor/raster_source.hpp"
 #include "extractor/restriction_parser.hpp"
 #include "util/exception.hpp"
+#include "util/integer_range.hpp"
 #include "util/lua_util.hpp"
 #include "util/make_unique.hpp"
 #include "util/simple_logger.hpp"
@@ -22,7 +23,10 @@
 
 #include <tbb/parallel_for.h>
 
+#include <cstring>
 #include <sstream>
+#include <string>
+#include <vector>
 
 namespace osrm
 {
@@ -30,6 +34,9 @@ namespace extractor
 {
 namespace
 {
+// per thread, the common combinations of tags of a planet fit into it many times
+const constexpr std::size_t MAX_WAY_CACHE_SIZE = 1 << 16;
+
 // wrapper method as luabind doesn't automatically overload funcs w/ default parameters
 template <class T>
 auto get_value_by_key(T const &object, const char *key) -> decltype(object.get_value_by_key(key))
@@ -51,6 +58,59 @@ template <class T> double lonToDouble(T const &object)
 // simply wrap it
 auto get_nodes_for_way(const osmium::Way &way) -> decltype(way.nodes()) { return way.nodes(); }
 
+// the class names of the context of the thread, the profile runs on the thread of its context
+thread_local const std::vector<std::string> *way_class_names = nullptr;
+
+void setWayClass(ExtractionWay &way, const std::string &name)
+{
+    BOOST_ASSERT(way_class_names != nullptr);
+    const auto class_index = findClass(*way_class_names, name);
+    if (class_index == way_class_names->size())
+    {
+        throw util::exception("Class " + name + " is not returned by get_classes");
+    }
+    way.classes |= getClassMask(class_index);
+}
+
+// Interpolates a raster source at all coordinates of the array,
+// returns the array of their data
+luabind::object interpolateBatch(const SourceContainer &sources,
+                                 const unsigned source_id,
+                                 const luabind::object &coordinates)
+{
+    std::vector<util::Coordinate> batch;
+    for (int index = 1; luabind::type(coordinates[index]) != LUA_TNIL; ++index)
+    {
+        batch.push_back(luabind::object_cast<util::Coordinate>(coordinates[index]));
+    }
+
+    std::vector<RasterDatum> data;
+    sources.GetRasterInterpolateFromSource(source_id, batch, data);
+
+    luabind::object result = luabind::newtable(coordinates.interpreter());
+    for (const auto index : util::irange<std::size_t>(0, data.size()))
+    {
+        result[index + 1] = data[index].datum;
+    }
+    return result;
+}
+
+// Whether the object has a tag with one of the keys, objects without tags are the most common
+bool hasAnyKey(const osmium::OSMObject &object, const std::vector<std::string> &keys)
+{
+    for (const auto &tag : object.tags())
+    {
+        for (const auto &key : keys)
+        {
+            if (std::strcmp(tag.key(), key.c_str()) == 0)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 // Error handler
 int luaErrorCallback(lua_State *state)
 {
@@ -67,6 +127,36 @@ LuaScriptingEnvironment::LuaScriptingEnvironment(const std::string &file_name)
     util::SimpleLogger().Write() << "Using script " << file_name;
 }
 
+LuaScriptingEnvironment::~LuaScriptingEnvironment()
+{
+    std::size_t number_of_cached_ways = 0;
+    std::size_t number_of_signatures = 0;
+    std::size_t number_of_skipped_nodes = 0;
+    std::size_t number_of_skipped_ways = 0;
+    for (const auto &context : script_contexts)
+    {
+        if (context)
+        {
+            number_of_cached_ways += context->number_of_cached_ways;
+            number_of_signatures += context->number_of_signatures;
+            number_of_skipped_nodes += context->number_of_skipped_nodes;
+            number_of_skipped_ways += context->number_of_skipped_ways;
+        }
+    }
+    if (number_of_skipped_nodes > 0 || number_of_skipped_ways > 0)
+    {
+        util::SimpleLogger().Write() << "Skipped the profile for " << number_of_skipped_nodes
+                                     << " nodes and " << number_of_skipped_ways
+                                     << " ways without any of its keys";
+    }
+    if (number_of_signatures > 0)
+    {
+        util::SimpleLogger().Write() << "Reused the way_function results of "
+                                     << number_of_cached_ways << " of " << number_of_signatures
+                                     << " ways";
+    }
+}
+
 void LuaScriptingEnvironment::InitContext(LuaScriptingContext &context)
 {
     typedef double (osmium::Location::*location_member_ptr_type)() const;
@@ -118,7 +208,10 @@ void LuaScriptingEnvironment::InitContext(LuaScriptingContext &context)
              .def(luabind::constructor<>())
              .def("load", &SourceContainer::LoadRasterSource)
              .def("query", &SourceContainer::GetRasterDataFromSource)
-             .def("interpolate", &SourceContainer::GetRasterInterpolateFromSource),
+             .def("interpolate",
+                  static_cast<RasterDatum (SourceContainer::*)(unsigned, double, double)>(
+                      &SourceContainer::GetRasterInterpolateFromSource))
+             .def("interpolate_batch", &interpolateBatch),
          luabind::class_<const float>("constants")
              .enum_("enums")[luabind::value("precision", COORDINATE_PRECISION)],
 
@@ -189,7 +282,8 @@ void LuaScriptingEnvironment::InitContext(LuaScriptingContext &context)
                  "forward_mode", &ExtractionWay::get_forward_mode, &ExtractionWay::set_forward_mode)
              .property("backward_mode",
                        &ExtractionWay::get_backward_mode,
-                       &ExtractionWay::set_backward_mode),
+                       &ExtractionWay::set_backward_mode)
+             .def("set_class", &setWayClass),
          luabind::class_<osmium::WayNodeList>("WayNodeList").def(luabind::constructor<>()),
          luabind::class_<osmium::NodeRef>("NodeRef")
              .def(luabind::constructor<>())
@@ -232,7 +326,50 @@ void LuaScriptingEnvironment::InitContext(LuaScriptingContext &context)
     context.has_turn_penalty_function = util::luaFunctionExists(context.state, "turn_function");
     context.has_node_function = util::luaFunctionExists(context.state, "node_function");
     context.has_way_function = util::luaFunctionExists(context.state, "way_function");
+    context.has_way_batch_function = util::luaFunctionExists(context.state, "way_batch_function");
     context.has_segment_function = util::luaFunctionExists(context.state, "segment_function");
+    context.has_segment_batch_function =
+        util::luaFunctionExists(context.state, "segment_batch_function");
+    context.has_sources = false;
+
+    context.class_names.clear();
+    if (util::luaFunctionExists(context.state, "get_classes"))
+    {
+        luabind::call_function<void>(
+            context.state, "get_classes", boost::ref(context.class_names));
+        if (context.class_names.size() > MAX_CLASSES)
+        {
+            throw util::exception("Profile " + file_name + " has more than " +
+                                  std::to_string(MAX_CLASSES) + " classes");
+        }
+    }
+    way_class_names = &context.class_names;
+
+    context.has_node_keys = util::luaFunctionExists(context.state, "get_node_keys");
+    context.node_keys.clear();
+    if (context.has_node_keys)
+    {
+        luabind::call_function<void>(context.state, "get_node_keys", boost::ref(context.node_keys));
+    }
+    context.has_way_keys = util::luaFunctionExists(context.state, "get_way_keys");
+    context.way_keys.clear();
+    if (context.has_way_keys)
+    {
+        luabind::call_function<void>(context.state, "get_way_keys", boost::ref(context.way_keys));
+    }
+
+    context.has_way_cache = false;
+    if (util::luaFunctionExists(context.state, "get_way_cache_keys"))
+    {
+        if (!util::luaFunctionExists(context.state, "way_name_function"))
+        {
+            throw util::exception("Profile " + file_name +
+                                  " has get_way_cache_keys but no way_name_function");
+        }
+        luabind::call_function<void>(
+            context.state, "get_way_cache_keys", boost::ref(context.way_cache_keys));
+        context.has_way_cache = true;
+    }
 }
 
 const ProfileProperties &LuaScriptingEnvironment::GetProfileProperties()
@@ -242,15 +379,16 @@ const ProfileProperties &LuaScriptingEnvironment::GetProfileProperties()
 
 LuaScriptingContext &LuaScriptingEnvironment::GetLuaContext()
 {
-    std::lock_guard<std::mutex> lock(init_mutex);
+    // the contexts of other threads are never touched, only loading the profile is locked
     bool initialized = false;
     auto &ref = script_contexts.local(initialized);
     if (!initialized)
     {
+        std::lock_guard<std::mutex> lock(init_mutex);
         ref = util::make_unique<LuaScriptingContext>();
         InitContext(*ref);
+        luabind::set_pcall_callback(&luaErrorCallback);
     }
-    luabind::set_pcall_callback(&luaErrorCallback);
 
     return *ref;
 }
@@ -270,6 +408,10 @@ void LuaScriptingEnvironment::ProcessElements(
             ExtractionWay result_way;
             auto &local_context = this->GetLuaContext();
 
+            // ways of the range that are handed to the profile at once
+            std::vector<std::size_t> batch_indices;
+            std::vector<const osmium::Way *> batch_ways;
+
             for (auto x = range.begin(), end = range.end(); x != end; ++x)
             {
                 const auto entity = osm_elements[x];
@@ -278,7 +420,13 @@ void LuaScriptingEnvironment::ProcessElements(
                 {
                 case osmium::item_type::node:
                     result_node.clear();
-                    if (local_context.has_node_function)
+                    if (local_context.has_node_keys &&
+                        !hasAnyKey(static_cast<const osmium::OSMObject &>(*entity),
+                                   local_context.node_keys))
+                    {
+                        ++local_context.number_of_skipped_nodes;
+                    }
+                    else if (local_context.has_node_function)
                     {
                         local_context.processNode(static_cast<const osmium::Node &>(*entity),
                                                   result_node);
@@ -286,6 +434,21 @@ void LuaScriptingEnvironment::ProcessElements(
                     resulting_nodes.push_back(std::make_pair(x, std::move(result_node)));
                     break;
                 case osmium::item_type::way:
+                    if (local_context.has_way_keys &&
+                        !hasAnyKey(static_cast<const osmium::OSMObject &>(*entity),
+                                   local_context.way_keys))
+                    {
+                        ++local_context.number_of_skipped_ways;
+                        result_way.clear();
+                        resulting_ways.push_back(std::make_pair(x, std::move(result_way)));
+                        break;
+                    }
+                    if (local_context.has_way_batch_function)
+                    {
+                        batch_indices.push_back(x);
+                        batch_ways.push_back(&static_cast<const osmium::Way &>(*entity));
+                        break;
+                    }
                     result_way.clear();
                     if (local_context.has_way_function)
                     {
@@ -302,6 +465,17 @@ void LuaScriptingEnvironment::ProcessElements(
                     break;
                 }
             }
+
+            if (!batch_ways.empty())
+            {
+                std::vector<ExtractionWay> batch_results(batch_ways.size());
+                local_context.processWays(batch_ways, batch_results);
+                for (const auto index : util::irange<std::size_t>(0, batch_ways.size()))
+                {
+                    resulting_ways.push_back(
+                        std::make_pair(batch_indices[index], std::move(batch_results[index])));
+                }
+            }
         });
 }
 
@@ -341,14 +515,20 @@ std::vector<std::string> LuaScriptingEnvironment::GetExceptions()
     return restriction_exceptions;
 }
 
+std::vector<std::string> LuaScriptingEnvironment::GetClassNames()
+{
+    return GetLuaContext().class_names;
+}
+
 void LuaScriptingEnvironment::SetupSources()
 {
     auto &context = GetLuaContext();
     BOOST_ASSERT(context.state != nullptr);
-    if (util::luaFunctionExists(context.state, "source_function"))
+    if (!context.has_sources && util::luaFunctionExists(context.state, "source_function"))
     {
         luabind::call_function<void>(context.state, "source_function");
     }
+    context.has_sources = true;
 }
 
 int32_t LuaScriptingEnvironment::GetTurnPenalty(const double angle)
@@ -374,21 +554,26 @@ int32_t LuaScriptingEnvironment::GetTurnPenalty(const double angle)
     return 0;
 }
 
-void LuaScriptingEnvironment::ProcessSegment(const osrm::util::Coordinate &source,
-                                             const osrm::util::Coordinate &target,
-                                             double distance,
-                                             InternalExtractorEdge::WeightData &weight)
+void LuaScriptingEnvironment::ProcessSegments(const std::vector<ExtractionSegment> &segments)
 {
     auto &context = GetLuaContext();
-    if (context.has_segment_function)
+    if (context.has_segment_function || context.has_segment_batch_function)
     {
         BOOST_ASSERT(context.state != nullptr);
-        luabind::call_function<void>(context.state,
-                                     "segment_function",
-                                     boost::cref(source),
-                                     boost::cref(target),
-                                     distance,
-                                     boost::ref(weight));
+        // segments are processed on all threads, each of them loads its own raster sources
+        if (!context.has_sources)
+        {
+            SetupSources();
+        }
+        if (context.has_segment_batch_function)
+        {
+            context.processSegments(segments);
+            return;
+        }
+        for (const auto &segment : segments)
+        {
+            context.processSegment(segment);
+        }
     }
 }
 
@@ -401,7 +586,142 @@ void LuaScriptingContext::processNode(const osmium::Node &node, ExtractionNode &
 void LuaScriptingContext::processWay(const osmium::Way &way, ExtractionWay &result)
 {
     BOOST_ASSERT(state != nullptr);
-    luabind::call_function<void>(state, "way_function", boost::cref(way), boost::ref(result));
+    if (!has_way_cache)
+    {
+        luabind::call_function<void>(state, "way_function", boost::cref(way), boost::ref(result));
+        return;
+    }
+
+    auto signature = getWaySignature(way);
+    if (!processCachedWay(signature, way, result))
+    {
+        luabind::call_function<void>(state, "way_function", boost::cref(way), boost::ref(result));
+        cacheWay(std::move(signature), result);
+    }
+}
+
+void LuaScriptingContext::processWays(const std::vector<const osmium::Way *> &ways,
+                                      std::vector<ExtractionWay> &results)
+{
+    BOOST_ASSERT(state != nullptr);
+    BOOST_ASSERT(ways.size() == results.size());
+
+    // only the ways with signatures that aren't cached are handed to the profile
+    std::vector<std::size_t> indices;
+    std::vector<std::string> signatures;
+    for (const auto index : util::irange<std::size_t>(0, ways.size()))
+    {
+        if (has_way_cache)
+        {
+            auto signature = getWaySignature(*ways[index]);
+            if (processCachedWay(signature, *ways[index], results[index]))
+            {
+                continue;
+            }
+            signatures.push_back(std::move(signature));
+        }
+        indices.push_back(index);
+    }
+    if (indices.empty())
+    {
+        return;
+    }
+
+    luabind::object lua_ways = luabind::newtable(state);
+    luabind::object lua_results = luabind::newtable(state);
+    for (const auto position : util::irange<std::size_t>(0, indices.size()))
+    {
+        // lua arrays start at 1
+        lua_ways[position + 1] = boost::cref(*ways[indices[position]]);
+        lua_results[position + 1] = boost::ref(results[indices[position]]);
+    }
+    luabind::call_function<void>(state, "way_batch_function", lua_ways, lua_results);
+
+    for (const auto position : util::irange<std::size_t>(0, signatures.size()))
+    {
+        cacheWay(std::move(signatures[position]), results[indices[position]]);
+    }
+}
+
+std::string LuaScriptingContext::getWaySignature(const osmium::Way &way) const
+{
+    std::string signature;
+    for (const auto &key : way_cache_keys)
+    {
+        // values can't contain the \0 that ends them, a missing key differs from an empty value
+        const auto value = way.get_value_by_key(key.c_str());
+        if (value)
+        {
+            signature.push_back('=');
+            signature.append(value);
+        }
+        signature.push_back('\0');
+    }
+    return signature;
+}
+
+bool LuaScriptingContext::processCachedWay(const std::string &signature,
+                                           const osmium::Way &way,
+                                           ExtractionWay &result)
+{
+    ++number_of_signatures;
+    const auto cached = way_cache.find(signature);
+    if (cached == way_cache.end())
+    {
+        return false;
+    }
+
+    ++number_of_cached_ways;
+    result = cached->second;
+    luabind::call_function<void>(state, "way_name_function", boost::cref(way), boost::ref(result));
+    return true;
+}
+
+void LuaScriptingContext::cacheWay(std::string signature, const ExtractionWay &result)
+{
+    if (way_cache.size() >= MAX_WAY_CACHE_SIZE)
+    {
+        return;
+    }
+
+    ExtractionWay cached = result;
+    cached.name.clear();
+    cached.ref.clear();
+    cached.pronunciation.clear();
+    cached.destinations.clear();
+    cached.turn_lanes_forward.clear();
+    cached.turn_lanes_backward.clear();
+    way_cache.emplace(std::move(signature), std::move(cached));
+}
+
+void LuaScriptingContext::processSegment(const ExtractionSegment &segment)
+{
+    BOOST_ASSERT(state != nullptr);
+    luabind::call_function<void>(state,
+                                 "segment_function",
+                                 boost::cref(segment.source),
+                                 boost::cref(segment.target),
+                                 segment.distance,
+                                 boost::ref(*segment.weight));
+}
+
+void LuaScriptingContext::processSegments(const std::vector<ExtractionSegment> &segments)
+{
+    BOOST_ASSERT(state != nullptr);
+    luabind::object lua_sources = luabind::newtable(state);
+    luabind::object lua_targets = luabind::newtable(state);
+    luabind::object lua_distances = luabind::newtable(state);
+    luabind::object lua_weights = luabind::newtable(state);
+    for (const auto index : util::irange<std::size_t>(0, segments.size()))
+    {
+        // lua arrays start at 1
+        lua_sources[index + 1] = boost::cref(segments[index].source);
+        lua_targets[index + 1] = boost::cref(segments[index].target);
+        lua_distances[index + 1] = segments[index].distance;
+        lua_weights[index + 1] = boost::ref(*segments[index].weight);
+    }
+    luabind::call_function<void>(
+        state, "segment_batch_function", lua_sources, lua_targets, lua_distances, lua_weights);
 }
 }
 }
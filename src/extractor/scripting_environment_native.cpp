@@ -0,0 +1,103 @@
+#include "extractor/scripting_environment_native.hpp"
+
+#include "extractor/extraction_node.hpp"
+#include "extractor/extraction_way.hpp"
+#include "extractor/restriction_parser.hpp"
+#include "util/simple_logger.hpp"
+
+#include <osmium/osm.hpp>
+
+#include <tbb/parallel_for.h>
+
+namespace osrm
+{
+namespace extractor
+{
+namespace
+{
+CarProfileConfig loadConfig(const std::string &file_name)
+{
+    util::SimpleLogger().Write() << "Using the native car profile with " << file_name;
+    CarProfileConfig config;
+    config.Load(file_name);
+    return config;
+}
+}
+
+NativeScriptingEnvironment::NativeScriptingEnvironment(const std::string &file_name)
+    : profile(loadConfig(file_name))
+{
+}
+
+const ProfileProperties &NativeScriptingEnvironment::GetProfileProperties()
+{
+    return profile.GetConfig().properties;
+}
+
+std::vector<std::string> NativeScriptingEnvironment::GetNameSuffixList()
+{
+    return profile.GetConfig().name_suffixes;
+}
+
+std::vector<std::string> NativeScriptingEnvironment::GetExceptions()
+{
+    return profile.GetConfig().restriction_exceptions;
+}
+
+std::vector<std::string> NativeScriptingEnvironment::GetClassNames()
+{
+    return CarProfile::GetClassNames();
+}
+
+// the car profile has no raster sources and no segment function
+void NativeScriptingEnvironment::SetupSources() {}
+
+void NativeScriptingEnvironment::ProcessSegments(const std::vector<ExtractionSegment> &) {}
+
+int32_t NativeScriptingEnvironment::GetTurnPenalty(const double angle)
+{
+    return profile.GetTurnPenalty(angle);
+}
+
+void NativeScriptingEnvironment::ProcessElements(
+    const std::vector<osmium::memory::Buffer::const_iterator> &osm_elements,
+    const RestrictionParser &restriction_parser,
+    tbb::concurrent_vector<std::pair<std::size_t, ExtractionNode>> &resulting_nodes,
+    tbb::concurrent_vector<std::pair<std::size_t, ExtractionWay>> &resulting_ways,
+    tbb::concurrent_vector<boost::optional<InputRestrictionContainer>> &resulting_restrictions)
+{
+    // parse OSM entities in parallel, store in resulting vectors
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, osm_elements.size()),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            ExtractionNode result_node;
+            ExtractionWay result_way;
+
+            for (auto x = range.begin(), end = range.end(); x != end; ++x)
+            {
+                const auto entity = osm_elements[x];
+
+                switch (entity->type())
+                {
+                case osmium::item_type::node:
+                    result_node.clear();
+                    profile.ProcessNode(static_cast<const osmium::Node &>(*entity), result_node);
+                    resulting_nodes.push_back(std::make_pair(x, std::move(result_node)));
+                    break;
+                case osmium::item_type::way:
+                    result_way.clear();
+                    profile.ProcessWay(static_cast<const osmium::Way &>(*entity), result_way);
+                    resulting_ways.push_back(std::make_pair(x, std::move(result_way)));
+                    break;
+                case osmium::item_type::relation:
+                    resulting_restrictions.push_back(restriction_parser.TryParse(
+                        static_cast<const osmium::Relation &>(*entity)));
+                    break;
+                default:
+                    break;
+                }
+            }
+        });
+}
+}
+}
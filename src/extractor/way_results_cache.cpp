@@ -0,0 +1,228 @@
+#include "extractor/way_results_cache.hpp"
+
+#include "extractor/extractor_callbacks.hpp"
+#include "util/exception.hpp"
+#include "util/simple_logger.hpp"
+
+#include <boost/filesystem/operations.hpp>
+
+#include <osmium/osm.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+namespace
+{
+const constexpr char MAGIC[8] = {'O', 'S', 'R', 'M', 'W', 'A', 'Y', 'R'};
+// changes whenever the layout of the results changes
+const constexpr std::uint32_t FORMAT_VERSION = 2;
+
+// the order of ways in planet dumps and files written by osmium
+inline std::pair<std::uint64_t, std::int64_t> orderOf(const std::int64_t id)
+{
+    return std::make_pair(static_cast<std::uint64_t>(std::llabs(id)), id);
+}
+
+template <typename T> void write(std::ostream &stream, const T &value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "only plain values are written as is");
+    stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void write(std::ostream &stream, const std::string &value)
+{
+    write(stream, static_cast<std::uint32_t>(value.size()));
+    stream.write(value.data(), value.size());
+}
+
+template <typename T> void read(std::istream &stream, T &value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "only plain values are read as is");
+    stream.read(reinterpret_cast<char *>(&value), sizeof(value));
+}
+
+void read(std::istream &stream, std::string &value)
+{
+    std::uint32_t size = 0;
+    read(stream, size);
+    value.resize(stream ? size : 0);
+    stream.read(&value[0], value.size());
+}
+
+void hashFile(const boost::filesystem::path &path, std::uint64_t &hash)
+{
+    boost::filesystem::ifstream stream(path, std::ios::binary);
+    const std::string contents{std::istreambuf_iterator<char>(stream),
+                               std::istreambuf_iterator<char>()};
+    for (const auto c : contents)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+    }
+}
+}
+
+WayResultsCache::WayResultsCache(boost::filesystem::path path_, const std::uint64_t profile_hash)
+    : path(std::move(path_)), temporary_path(path.string() + ".tmp"), has_entry(false),
+      entry_id(0), entry_version(0), number_of_hits(0)
+{
+    if (boost::filesystem::exists(path))
+    {
+        previous_results.open(path, std::ios::binary);
+        char magic[sizeof(MAGIC)] = {};
+        std::uint32_t format_version = 0;
+        std::uint64_t previous_profile_hash = 0;
+        previous_results.read(magic, sizeof(magic));
+        read(previous_results, format_version);
+        read(previous_results, previous_profile_hash);
+        if (previous_results && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 &&
+            format_version == FORMAT_VERSION && previous_profile_hash == profile_hash)
+        {
+            util::SimpleLogger().Write() << "Reusing the way results of " << path.string();
+            ReadEntry();
+        }
+        else
+        {
+            util::SimpleLogger().Write() << "Not reusing the way results of " << path.string()
+                                         << ", they were extracted with another profile";
+        }
+    }
+
+    results.open(temporary_path, std::ios::binary);
+    if (!results)
+    {
+        throw util::exception("Could not open " + temporary_path.string() + " for writing.");
+    }
+    results.write(MAGIC, sizeof(MAGIC));
+    write(results, FORMAT_VERSION);
+    write(results, profile_hash);
+}
+
+void WayResultsCache::ReadEntry()
+{
+    std::uint8_t is_routable = 0;
+    read(previous_results, entry_id);
+    read(previous_results, entry_version);
+    read(previous_results, is_routable);
+    entry_result.clear();
+    if (is_routable)
+    {
+        std::uint8_t forward_mode = 0;
+        std::uint8_t backward_mode = 0;
+        read(previous_results, entry_result.forward_speed);
+        read(previous_results, entry_result.backward_speed);
+        read(previous_results, entry_result.duration);
+        read(previous_results, entry_result.name);
+        read(previous_results, entry_result.ref);
+        read(previous_results, entry_result.pronunciation);
+        read(previous_results, entry_result.destinations);
+        read(previous_results, entry_result.turn_lanes_forward);
+        read(previous_results, entry_result.turn_lanes_backward);
+        read(previous_results, entry_result.roundabout);
+        read(previous_results, entry_result.is_access_restricted);
+        read(previous_results, entry_result.is_startpoint);
+        read(previous_results, forward_mode);
+        read(previous_results, backward_mode);
+        read(previous_results, entry_result.road_classification);
+        read(previous_results, entry_result.classes);
+        entry_result.forward_travel_mode = static_cast<TravelMode>(forward_mode);
+        entry_result.backward_travel_mode = static_cast<TravelMode>(backward_mode);
+    }
+    // a truncated file ends the results
+    has_entry = static_cast<bool>(previous_results);
+}
+
+bool WayResultsCache::Find(const osmium::Way &way, ExtractionWay &result)
+{
+    const auto order = orderOf(way.id());
+    while (has_entry && orderOf(entry_id) < order)
+    {
+        ReadEntry();
+    }
+    if (!has_entry || entry_id != way.id())
+    {
+        return false;
+    }
+
+    const auto is_same_version = entry_version == way.version();
+    if (is_same_version)
+    {
+        result = entry_result;
+        ++number_of_hits;
+    }
+    ReadEntry();
+    return is_same_version;
+}
+
+void WayResultsCache::Add(const osmium::Way &way, const ExtractionWay &result)
+{
+    // only the results of ways that become edges are needed again
+    const std::uint8_t is_routable = ExtractorCallbacks::IsRoutable(way, result);
+    write(results, static_cast<std::int64_t>(way.id()));
+    write(results, static_cast<std::uint32_t>(way.version()));
+    write(results, is_routable);
+    if (is_routable)
+    {
+        write(results, result.forward_speed);
+        write(results, result.backward_speed);
+        write(results, result.duration);
+        write(results, result.name);
+        write(results, result.ref);
+        write(results, result.pronunciation);
+        write(results, result.destinations);
+        write(results, result.turn_lanes_forward);
+        write(results, result.turn_lanes_backward);
+        write(results, result.roundabout);
+        write(results, result.is_access_restricted);
+        write(results, result.is_startpoint);
+        write(results, static_cast<std::uint8_t>(result.forward_travel_mode));
+        write(results, static_cast<std::uint8_t>(result.backward_travel_mode));
+        write(results, result.road_classification);
+        write(results, result.classes);
+    }
+}
+
+void WayResultsCache::Finish()
+{
+    previous_results.close();
+    results.close();
+    if (!results)
+    {
+        throw util::exception("Failed to write to " + temporary_path.string() + ".");
+    }
+    boost::filesystem::rename(temporary_path, path);
+}
+
+std::uint64_t WayResultsCache::HashProfile(const boost::filesystem::path &profile_path)
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    hashFile(profile_path, hash);
+
+    const auto library_path = profile_path.parent_path() / "lib";
+    if (boost::filesystem::is_directory(library_path))
+    {
+        std::vector<boost::filesystem::path> libraries;
+        for (boost::filesystem::directory_iterator iter(library_path), end; iter != end; ++iter)
+        {
+            libraries.push_back(iter->path());
+        }
+        std::sort(libraries.begin(), libraries.end());
+        for (const auto &library : libraries)
+        {
+            hashFile(library, hash);
+        }
+    }
+    return hash;
+}
+}
+}
@@ -1,17 +1,110 @@
 #include "osrm/osrm.hpp"
+#include "engine/api/match_batch_parameters.hpp"
+#include "engine/api/match_batch_result.hpp"
 #include "engine/api/match_parameters.hpp"
+#include "engine/api/match_stream_parameters.hpp"
+#include "engine/api/isochrone_parameters.hpp"
 #include "engine/api/nearest_parameters.hpp"
+#include "engine/api/nearest_result.hpp"
+#include "engine/api/one_to_all_parameters.hpp"
+#include "engine/api/one_to_all_result.hpp"
+#include "engine/api/route_batch_parameters.hpp"
 #include "engine/api/route_parameters.hpp"
+#include "engine/api/route_result.hpp"
 #include "engine/api/table_parameters.hpp"
+#include "engine/api/table_result.hpp"
+#include "engine/api/table_stream.hpp"
 #include "engine/api/trip_parameters.hpp"
+#include "engine/api/tile_parameters.hpp"
 #include "engine/engine.hpp"
 #include "engine/engine_config.hpp"
+#include "engine/search_engine_data.hpp"
 #include "engine/status.hpp"
+#include "util/json_container.hpp"
 #include "util/make_unique.hpp"
 
+#include <utility>
+
 namespace osrm
 {
 
+namespace
+{
+using namespace engine::api;
+
+// the synchronous service of the parameters that fills the result
+engine::Status
+run(const engine::Engine &engine, const RouteParameters &params, json::Object &result)
+{
+    return engine.Route(params, result);
+}
+engine::Status run(const engine::Engine &engine, const RouteParameters &params, RouteResult &result)
+{
+    return engine.Route(params, result);
+}
+engine::Status
+run(const engine::Engine &engine, const RouteBatchParameters &params, json::Object &result)
+{
+    return engine.RouteBatch(params, result);
+}
+engine::Status
+run(const engine::Engine &engine, const TableParameters &params, json::Object &result)
+{
+    return engine.Table(params, result);
+}
+engine::Status run(const engine::Engine &engine, const TableParameters &params, std::string &result)
+{
+    return engine.Table(params, result);
+}
+engine::Status run(const engine::Engine &engine, const TableParameters &params, TableResult &result)
+{
+    return engine.Table(params, result);
+}
+engine::Status
+run(const engine::Engine &engine, const NearestParameters &params, json::Object &result)
+{
+    return engine.Nearest(params, result);
+}
+engine::Status
+run(const engine::Engine &engine, const NearestParameters &params, NearestResult &result)
+{
+    return engine.Nearest(params, result);
+}
+engine::Status run(const engine::Engine &engine, const TripParameters &params, json::Object &result)
+{
+    return engine.Trip(params, result);
+}
+engine::Status
+run(const engine::Engine &engine, const MatchParameters &params, json::Object &result)
+{
+    return engine.Match(params, result);
+}
+engine::Status
+run(const engine::Engine &engine, const MatchStreamParameters &params, json::Object &result)
+{
+    return engine.MatchStream(params, result);
+}
+engine::Status
+run(const engine::Engine &engine, const MatchBatchParameters &params, MatchBatchResult &result)
+{
+    return engine.MatchBatch(params, result);
+}
+engine::Status run(const engine::Engine &engine, const TileParameters &params, std::string &result)
+{
+    return engine.Tile(params, result);
+}
+engine::Status
+run(const engine::Engine &engine, const OneToAllParameters &params, OneToAllResult &result)
+{
+    return engine.OneToAll(params, result);
+}
+engine::Status
+run(const engine::Engine &engine, const IsochroneParameters &params, json::Object &result)
+{
+    return engine.Isochrone(params, result);
+}
+}
+
 // Pimpl idiom
 
 OSRM::OSRM(engine::EngineConfig &config) : engine_(util::make_unique<engine::Engine>(config)) {}
@@ -26,16 +119,51 @@ engine::Status OSRM::Route(const engine::api::RouteParameters &params, util::jso
     return engine_->Route(params, result);
 }
 
+engine::Status OSRM::Route(const engine::api::RouteParameters &params,
+                           engine::api::RouteResult &result) const
+{
+    return engine_->Route(params, result);
+}
+
+engine::Status OSRM::RouteBatch(const engine::api::RouteBatchParameters &params,
+                                json::Object &result) const
+{
+    return engine_->RouteBatch(params, result);
+}
+
 engine::Status OSRM::Table(const engine::api::TableParameters &params, json::Object &result) const
 {
     return engine_->Table(params, result);
 }
 
+engine::Status OSRM::Table(const engine::api::TableParameters &params, std::string &result) const
+{
+    return engine_->Table(params, result);
+}
+
+engine::Status OSRM::Table(const engine::api::TableParameters &params,
+                           engine::api::TableResult &result) const
+{
+    return engine_->Table(params, result);
+}
+
+engine::Status OSRM::Table(const engine::api::TableParameters &params,
+                           engine::api::TableStream &result) const
+{
+    return engine_->Table(params, result);
+}
+
 engine::Status OSRM::Nearest(const engine::api::NearestParameters &params, json::Object &result) const
 {
     return engine_->Nearest(params, result);
 }
 
+engine::Status OSRM::Nearest(const engine::api::NearestParameters &params,
+                             engine::api::NearestResult &result) const
+{
+    return engine_->Nearest(params, result);
+}
+
 engine::Status OSRM::Trip(const engine::api::TripParameters &params, json::Object &result) const
 {
     return engine_->Trip(params, result);
@@ -46,9 +174,116 @@ engine::Status OSRM::Match(const engine::api::MatchParameters &params, json::Obj
     return engine_->Match(params, result);
 }
 
+engine::Status OSRM::MatchStream(const engine::api::MatchStreamParameters &params,
+                                 json::Object &result) const
+{
+    return engine_->MatchStream(params, result);
+}
+
+engine::Status OSRM::MatchBatch(const engine::api::MatchBatchParameters &params,
+                                engine::api::MatchBatchResult &result) const
+{
+    return engine_->MatchBatch(params, result);
+}
+
 engine::Status OSRM::Tile(const engine::api::TileParameters &params, std::string &result) const
 {
     return engine_->Tile(params, result);
 }
 
+engine::Status OSRM::OneToAll(const engine::api::OneToAllParameters &params,
+                              engine::api::OneToAllResult &result) const
+{
+    return engine_->OneToAll(params, result);
+}
+
+engine::Status OSRM::Isochrone(const engine::api::IsochroneParameters &params,
+                               json::Object &result) const
+{
+    return engine_->Isochrone(params, result);
+}
+
+template <typename ResultT, typename ParameterT>
+std::future<AsyncResponse<ResultT>> OSRM::Async(ParameterT parameters, AsyncOptions options) const
+{
+    auto promise = std::make_shared<std::promise<AsyncResponse<ResultT>>>();
+    auto future = promise->get_future();
+    const std::function<void(AsyncResponse<ResultT>)> fulfil =
+        [promise](AsyncResponse<ResultT> response) {
+            if (response.exception)
+            {
+                promise->set_exception(response.exception);
+            }
+            else
+            {
+                promise->set_value(std::move(response));
+            }
+        };
+    Async<ResultT>(std::move(parameters), fulfil, std::move(options));
+    return future;
+}
+
+template <typename ResultT, typename ParameterT>
+void OSRM::Async(ParameterT parameters,
+                 std::function<void(AsyncResponse<ResultT>)> callback,
+                 AsyncOptions options) const
+{
+    // the engine doesn't move with this instance
+    const engine::Engine *const engine = engine_.get();
+    engine_->Async([engine, parameters, callback, options] {
+        AsyncResponse<ResultT> response;
+        try
+        {
+            // the engine fails queries that are aborted with the error of their options
+            const engine::SearchEngineData::ScopedQueryControl control(options);
+            response.status = run(*engine, parameters, response.result);
+        }
+        catch (...)
+        {
+            response.status = engine::Status::Error;
+            response.exception = std::current_exception();
+        }
+        callback(std::move(response));
+    });
+}
+
+// the services that run asynchronously
+#define OSRM_ASYNC_SERVICE(ResultT, ParameterT)                                                   \
+    template std::future<AsyncResponse<ResultT>> OSRM::Async<ResultT, ParameterT>(ParameterT,      \
+                                                                                  AsyncOptions)    \
+        const;                                                                                     \
+    template void OSRM::Async<ResultT, ParameterT>(                                                \
+        ParameterT, std::function<void(AsyncResponse<ResultT>)>, AsyncOptions) const;
+
+OSRM_ASYNC_SERVICE(json::Object, RouteParameters)
+OSRM_ASYNC_SERVICE(RouteResult, RouteParameters)
+OSRM_ASYNC_SERVICE(json::Object, RouteBatchParameters)
+OSRM_ASYNC_SERVICE(json::Object, TableParameters)
+OSRM_ASYNC_SERVICE(std::string, TableParameters)
+OSRM_ASYNC_SERVICE(TableResult, TableParameters)
+OSRM_ASYNC_SERVICE(json::Object, NearestParameters)
+OSRM_ASYNC_SERVICE(NearestResult, NearestParameters)
+OSRM_ASYNC_SERVICE(json::Object, TripParameters)
+OSRM_ASYNC_SERVICE(json::Object, MatchParameters)
+OSRM_ASYNC_SERVICE(json::Object, MatchStreamParameters)
+OSRM_ASYNC_SERVICE(MatchBatchResult, MatchBatchParameters)
+OSRM_ASYNC_SERVICE(std::string, TileParameters)
+OSRM_ASYNC_SERVICE(OneToAllResult, OneToAllParameters)
+OSRM_ASYNC_SERVICE(json::Object, IsochroneParameters)
+
+#undef OSRM_ASYNC_SERVICE
+
+unsigned OSRM::GetCheckSum() const { return engine_->GetCheckSum(); }
+
+unsigned OSRM::GetDataVersion() const { return engine_->GetDataVersion(); }
+
+std::uint64_t OSRM::GetTrafficOverlayVersion() const
+{
+    return engine_->GetTrafficOverlayVersion();
+}
+
+bool OSRM::IsReady() const { return engine_->IsReady(); }
+
+void OSRM::Reload() { engine_->Reload(); }
+
 } // ns osrm
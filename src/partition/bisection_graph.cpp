@@ -0,0 +1,85 @@
+#include "partition/bisection_graph.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+namespace osrm
+{
+namespace partition
+{
+
+BisectionGraph makeBisectionGraph(std::vector<std::pair<NodeID, NodeID>> edges,
+                                  std::vector<util::Coordinate> coordinates)
+{
+    const auto number_of_edges = edges.size();
+    edges.reserve(2 * number_of_edges);
+    for (std::size_t index = 0; index < number_of_edges; ++index)
+    {
+        edges.emplace_back(edges[index].second, edges[index].first);
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    edges.erase(std::remove_if(edges.begin(),
+                               edges.end(),
+                               [](const std::pair<NodeID, NodeID> &edge) {
+                                   return edge.first == edge.second;
+                               }),
+                edges.end());
+
+    BisectionGraph graph;
+    graph.coordinates = std::move(coordinates);
+    graph.first_edge.resize(graph.coordinates.size() + 1, 0);
+    graph.targets.reserve(edges.size());
+    for (const auto &edge : edges)
+    {
+        BOOST_ASSERT(edge.first < graph.coordinates.size());
+        BOOST_ASSERT(edge.second < graph.coordinates.size());
+        ++graph.first_edge[edge.first + 1];
+        graph.targets.push_back(edge.second);
+    }
+    std::partial_sum(graph.first_edge.begin(), graph.first_edge.end(), graph.first_edge.begin());
+    return graph;
+}
+
+BisectionGraph makeSubgraph(const BisectionGraph &graph,
+                            const std::vector<bool> &sides,
+                            const bool side,
+                            std::vector<NodeID> &graph_ids)
+{
+    BOOST_ASSERT(sides.size() == graph.GetNumberOfNodes());
+
+    std::vector<NodeID> subgraph_ids(graph.GetNumberOfNodes(), SPECIAL_NODEID);
+    graph_ids.clear();
+    for (NodeID node = 0; node < graph.GetNumberOfNodes(); ++node)
+    {
+        if (sides[node] == side)
+        {
+            subgraph_ids[node] = static_cast<NodeID>(graph_ids.size());
+            graph_ids.push_back(node);
+        }
+    }
+
+    // the ids keep the order of the graph, so the neighbours stay sorted
+    BisectionGraph subgraph;
+    subgraph.first_edge.reserve(graph_ids.size() + 1);
+    subgraph.first_edge.push_back(0);
+    subgraph.coordinates.reserve(graph_ids.size());
+    for (const auto node : graph_ids)
+    {
+        for (auto edge = graph.first_edge[node]; edge < graph.first_edge[node + 1]; ++edge)
+        {
+            const auto target = subgraph_ids[graph.targets[edge]];
+            if (target != SPECIAL_NODEID)
+            {
+                subgraph.targets.push_back(target);
+            }
+        }
+        subgraph.first_edge.push_back(subgraph.targets.size());
+        subgraph.coordinates.push_back(graph.coordinates[node]);
+    }
+    return subgraph;
+}
+}
+}
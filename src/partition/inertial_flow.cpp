@@ -0,0 +1,254 @@
+#include "partition/inertial_flow.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <tuple>
+
+namespace osrm
+{
+namespace partition
+{
+
+namespace
+{
+enum class Terminal : std::uint8_t
+{
+    NONE,
+    SOURCE,
+    SINK
+};
+
+// The index of the opposite direction of every edge
+std::vector<std::size_t> reverseEdges(const BisectionGraph &graph)
+{
+    std::vector<std::size_t> reverse(graph.GetNumberOfEdges());
+    tbb::parallel_for(tbb::blocked_range<NodeID>(0, graph.GetNumberOfNodes()),
+                      [&](const tbb::blocked_range<NodeID> &range) {
+                          for (auto node = range.begin(); node != range.end(); ++node)
+                          {
+                              for (auto edge = graph.first_edge[node];
+                                   edge < graph.first_edge[node + 1];
+                                   ++edge)
+                              {
+                                  const auto target = graph.targets[edge];
+                                  const auto first =
+                                      graph.targets.begin() + graph.first_edge[target];
+                                  const auto last =
+                                      graph.targets.begin() + graph.first_edge[target + 1];
+                                  const auto position = std::lower_bound(first, last, node);
+                                  BOOST_ASSERT(position != last && *position == node);
+                                  reverse[edge] = position - graph.targets.begin();
+                              }
+                          }
+                      });
+    return reverse;
+}
+
+// The smallest cut between the sources and the sinks, with Dinic's algorithm: every phase
+// numbers the nodes by their distance from the sources in the residual graph and sends flow along
+// paths of increasing numbers until there is none left. Every edge has a capacity of one in both
+// directions, so the flow of an edge is between -1 and 1.
+Bisection computeMinimumCut(const BisectionGraph &graph,
+                            const std::vector<std::size_t> &reverse,
+                            const std::vector<Terminal> &terminals)
+{
+    const auto number_of_nodes = graph.GetNumberOfNodes();
+    std::vector<std::int8_t> flows(graph.GetNumberOfEdges(), 0);
+    std::vector<std::int32_t> distances(number_of_nodes);
+    std::vector<std::size_t> next_edges(number_of_nodes);
+
+    std::vector<NodeID> sources;
+    for (NodeID node = 0; node < number_of_nodes; ++node)
+    {
+        if (terminals[node] == Terminal::SOURCE)
+        {
+            sources.push_back(node);
+        }
+    }
+
+    // false once no sink is left in reach of the sources
+    std::vector<NodeID> queue;
+    queue.reserve(number_of_nodes);
+    const auto number_nodes = [&] {
+        std::fill(distances.begin(), distances.end(), -1);
+        queue = sources;
+        for (const auto source : sources)
+        {
+            distances[source] = 0;
+        }
+        bool reached_sink = false;
+        for (std::size_t index = 0; index < queue.size(); ++index)
+        {
+            const auto node = queue[index];
+            if (terminals[node] == Terminal::SINK)
+            {
+                reached_sink = true;
+                continue;
+            }
+            for (auto edge = graph.first_edge[node]; edge < graph.first_edge[node + 1]; ++edge)
+            {
+                const auto target = graph.targets[edge];
+                if (flows[edge] < 1 && distances[target] < 0)
+                {
+                    distances[target] = distances[node] + 1;
+                    queue.push_back(target);
+                }
+            }
+        }
+        return reached_sink;
+    };
+
+    std::size_t flow = 0;
+    std::vector<std::size_t> path;
+    std::vector<NodeID> path_nodes;
+    while (number_nodes())
+    {
+        for (NodeID node = 0; node < number_of_nodes; ++node)
+        {
+            next_edges[node] = graph.first_edge[node];
+        }
+        for (const auto source : sources)
+        {
+            NodeID node = source;
+            while (true)
+            {
+                if (terminals[node] == Terminal::SINK)
+                {
+                    for (const auto edge : path)
+                    {
+                        ++flows[edge];
+                        --flows[reverse[edge]];
+                    }
+                    ++flow;
+                    path.clear();
+                    path_nodes.clear();
+                    node = source;
+                    continue;
+                }
+
+                auto &edge = next_edges[node];
+                const auto last_edge = graph.first_edge[node + 1];
+                while (edge < last_edge &&
+                       (flows[edge] == 1 || distances[graph.targets[edge]] != distances[node] + 1))
+                {
+                    ++edge;
+                }
+                if (edge == last_edge)
+                {
+                    // no sink is left in reach through the node in this phase
+                    distances[node] = -1;
+                    if (path.empty())
+                    {
+                        break;
+                    }
+                    node = path_nodes.back();
+                    path_nodes.pop_back();
+                    path.pop_back();
+                    ++next_edges[node];
+                    continue;
+                }
+                path.push_back(edge);
+                path_nodes.push_back(node);
+                node = graph.targets[edge];
+            }
+        }
+    }
+
+    // the last numbering reached the side of the sources
+    Bisection bisection{std::vector<bool>(number_of_nodes), flow};
+    for (NodeID node = 0; node < number_of_nodes; ++node)
+    {
+        bisection.sides[node] = distances[node] < 0;
+    }
+    return bisection;
+}
+}
+
+Bisection inertialFlow(const BisectionGraph &graph,
+                       const unsigned number_of_directions,
+                       const double boundary_factor,
+                       const double balance)
+{
+    const auto number_of_nodes = graph.GetNumberOfNodes();
+    BOOST_ASSERT(number_of_nodes >= 2);
+    BOOST_ASSERT(number_of_directions > 0);
+
+    const auto reverse = reverseEdges(graph);
+    const auto boundary = std::max<std::size_t>(
+        1,
+        std::min<std::size_t>(number_of_nodes / 2,
+                              static_cast<std::size_t>(number_of_nodes * boundary_factor)));
+
+    // positions in a plane that has the same scale on both axes at the center of the graph
+    std::int32_t min_lat = std::numeric_limits<std::int32_t>::max();
+    std::int32_t max_lat = std::numeric_limits<std::int32_t>::min();
+    for (const auto &coordinate : graph.coordinates)
+    {
+        min_lat = std::min(min_lat, static_cast<std::int32_t>(coordinate.lat));
+        max_lat = std::max(max_lat, static_cast<std::int32_t>(coordinate.lat));
+    }
+    const double pi = std::acos(-1.);
+    const double lon_scale =
+        std::cos((min_lat + static_cast<double>(max_lat)) / 2. / COORDINATE_PRECISION * pi / 180.);
+
+    std::vector<Bisection> bisections(number_of_directions);
+    tbb::parallel_for(
+        tbb::blocked_range<unsigned>(0, number_of_directions, 1),
+        [&](const tbb::blocked_range<unsigned> &range) {
+            for (auto direction = range.begin(); direction != range.end(); ++direction)
+            {
+                const double angle = pi * direction / number_of_directions;
+                const double lon_factor = std::cos(angle) * lon_scale;
+                const double lat_factor = std::sin(angle);
+                std::vector<double> keys(number_of_nodes);
+                for (NodeID node = 0; node < number_of_nodes; ++node)
+                {
+                    keys[node] =
+                        lon_factor * static_cast<std::int32_t>(graph.coordinates[node].lon) +
+                        lat_factor * static_cast<std::int32_t>(graph.coordinates[node].lat);
+                }
+
+                // only the nodes at both ends need to be in order
+                std::vector<NodeID> order(number_of_nodes);
+                std::iota(order.begin(), order.end(), 0);
+                const auto by_key = [&](const NodeID lhs, const NodeID rhs) {
+                    return keys[lhs] < keys[rhs];
+                };
+                std::nth_element(order.begin(), order.begin() + boundary, order.end(), by_key);
+                std::nth_element(
+                    order.begin() + boundary, order.end() - boundary, order.end(), by_key);
+
+                std::vector<Terminal> terminals(number_of_nodes, Terminal::NONE);
+                for (std::size_t index = 0; index < boundary; ++index)
+                {
+                    terminals[order[index]] = Terminal::SOURCE;
+                    terminals[order[number_of_nodes - 1 - index]] = Terminal::SINK;
+                }
+                bisections[direction] = computeMinimumCut(graph, reverse, terminals);
+            }
+        });
+
+    const auto rank = [&](const Bisection &bisection) {
+        const std::size_t second_half =
+            std::count(bisection.sides.begin(), bisection.sides.end(), true);
+        const auto larger_half = std::max(second_half, number_of_nodes - second_half);
+        return std::make_tuple(larger_half > balance * number_of_nodes / 2.,
+                               bisection.cut_size,
+                               larger_half);
+    };
+    auto best = std::min_element(
+        bisections.begin(), bisections.end(), [&](const Bisection &lhs, const Bisection &rhs) {
+            return rank(lhs) < rank(rhs);
+        });
+    return std::move(*best);
+}
+}
+}
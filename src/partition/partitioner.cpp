@@ -0,0 +1,187 @@
+#include "partition/partitioner.hpp"
+#include "contractor/node_renumbering.hpp"
+#include "extractor/compressed_edge_based_edges.hpp"
+#include "extractor/edge_based_edge.hpp"
+#include "extractor/edge_based_node.hpp"
+#include "extractor/query_node.hpp"
+#include "partition/multi_level_partition.hpp"
+#include "partition/recursive_bisection.hpp"
+#include "util/exception.hpp"
+#include "util/io.hpp"
+#include "util/simple_logger.hpp"
+#include "util/static_rtree.hpp"
+#include "util/timing_util.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace partition
+{
+
+int Partitioner::Run()
+{
+    TIMER_START(loading);
+    auto graph = LoadEdgeBasedGraph();
+    TIMER_STOP(loading);
+    util::SimpleLogger().Write() << "Loaded the edge-based graph with " << graph.GetNumberOfNodes()
+                                 << " nodes and " << graph.GetNumberOfEdges() / 2
+                                 << " edges in " << TIMER_SEC(loading) << "s";
+
+    TIMER_START(partitioning);
+    const auto partition = computeMultiLevelPartition(std::move(graph), config);
+    TIMER_STOP(partitioning);
+    util::SimpleLogger().Write() << "Partitioning took " << TIMER_SEC(partitioning) << "s";
+    for (LevelID level = 0; level < partition.GetNumberOfLevels(); ++level)
+    {
+        util::SimpleLogger().Write() << "Level " << static_cast<unsigned>(level) << ": "
+                                     << partition.GetNumberOfCells(level)
+                                     << " cells of at most " << partition.GetMaxCellSize(level)
+                                     << " nodes";
+    }
+
+    if (!writeMultiLevelPartition(config.partition_output_path, partition))
+    {
+        throw util::exception("Failed writing " + config.partition_output_path);
+    }
+    return 0;
+}
+
+BisectionGraph Partitioner::LoadEdgeBasedGraph() const
+{
+    std::ifstream stream(config.edge_based_graph_path, std::ios::binary);
+    if (!stream)
+    {
+        throw util::exception("Failed to open " + config.edge_based_graph_path);
+    }
+    if (!util::readAndCheckFingerprint(stream))
+    {
+        throw util::exception(config.edge_based_graph_path +
+                              " was written by an incompatible version");
+    }
+
+    std::uint64_t number_of_edges = 0;
+    EdgeID max_edge_id = 0;
+    stream.read(reinterpret_cast<char *>(&number_of_edges), sizeof(number_of_edges));
+    stream.read(reinterpret_cast<char *>(&max_edge_id), sizeof(max_edge_id));
+    const std::vector<unsigned char> edge_bytes{std::istreambuf_iterator<char>(stream),
+                                                std::istreambuf_iterator<char>()};
+    std::vector<extractor::EdgeBasedEdge> edge_based_edges;
+    extractor::readEdgeBasedEdges(edge_bytes.data(),
+                                  edge_bytes.data() + edge_bytes.size(),
+                                  number_of_edges,
+                                  edge_based_edges);
+
+    // the cut of a bisection doesn't depend on the direction of the turns
+    std::vector<std::pair<NodeID, NodeID>> edges;
+    edges.reserve(number_of_edges);
+    for (const auto &edge : edge_based_edges)
+    {
+        edges.emplace_back(edge.source, edge.target);
+    }
+    std::vector<extractor::EdgeBasedEdge>().swap(edge_based_edges);
+
+    const NodeID number_of_nodes = number_of_edges == 0 ? 0 : max_edge_id + 1;
+    return makeBisectionGraph(std::move(edges), LoadNodeCoordinates(number_of_nodes));
+}
+
+// The edge-based nodes have no coordinates of their own, every node gets the average of the
+// centers of its segments in the r-tree leaves
+std::vector<util::Coordinate> Partitioner::LoadNodeCoordinates(const NodeID number_of_nodes) const
+{
+    std::ifstream nodes_stream(config.node_based_graph_path, std::ios::binary);
+    if (!nodes_stream)
+    {
+        throw util::exception("Failed to open " + config.node_based_graph_path);
+    }
+    unsigned number_of_coordinates = 0;
+    nodes_stream.read(reinterpret_cast<char *>(&number_of_coordinates), sizeof(unsigned));
+    std::vector<extractor::QueryNode> query_nodes(number_of_coordinates);
+    nodes_stream.read(reinterpret_cast<char *>(query_nodes.data()),
+                      number_of_coordinates * sizeof(extractor::QueryNode));
+    if (!nodes_stream)
+    {
+        throw util::exception("Failed reading " + config.node_based_graph_path);
+    }
+
+    // osrm-contract may have renumbered the nodes of the leaves
+    std::vector<NodeID> edge_based_ids;
+    if (boost::filesystem::exists(config.node_renumbering_path))
+    {
+        std::vector<NodeID> renumbering;
+        if (!util::deserializeVector(config.node_renumbering_path, renumbering) ||
+            renumbering.size() != number_of_nodes)
+        {
+            throw util::exception("Failed reading " + config.node_renumbering_path);
+        }
+        edge_based_ids = contractor::invertNodeRenumbering(renumbering);
+    }
+
+    using RTree = util::StaticRTree<extractor::EdgeBasedNode>;
+    using boost::interprocess::file_mapping;
+    using boost::interprocess::mapped_region;
+    using boost::interprocess::read_only;
+
+    const file_mapping mapping{config.rtree_leaf_path.c_str(), read_only};
+    mapped_region region{mapping, read_only};
+    region.advise(mapped_region::advice_sequential);
+    const extractor::EdgeBasedNode *first, *last;
+    std::tie(first, last) = RTree::GetLeafFileObjects(
+        static_cast<const void *>(region.get_address()), region.get_size());
+
+    std::vector<double> lon_sums(number_of_nodes, 0.), lat_sums(number_of_nodes, 0.);
+    std::vector<std::uint32_t> counts(number_of_nodes, 0);
+    const auto add_segment = [&](const NodeID leaf_id, const extractor::EdgeBasedNode &segment) {
+        if (leaf_id >= number_of_nodes || segment.u >= number_of_coordinates ||
+            segment.v >= number_of_coordinates)
+        {
+            throw util::exception(config.rtree_leaf_path + " does not match the edge-based graph");
+        }
+        const auto node = edge_based_ids.empty() ? leaf_id : edge_based_ids[leaf_id];
+        const auto &u = query_nodes[segment.u];
+        const auto &v = query_nodes[segment.v];
+        lon_sums[node] += (static_cast<double>(static_cast<std::int32_t>(u.lon)) +
+                           static_cast<std::int32_t>(v.lon)) /
+                          2.;
+        lat_sums[node] += (static_cast<double>(static_cast<std::int32_t>(u.lat)) +
+                           static_cast<std::int32_t>(v.lat)) /
+                          2.;
+        ++counts[node];
+    };
+    for (auto segment = first; segment != last; ++segment)
+    {
+        if (segment->forward_segment_id.enabled)
+        {
+            add_segment(segment->forward_segment_id.id, *segment);
+        }
+        if (segment->reverse_segment_id.enabled)
+        {
+            add_segment(segment->reverse_segment_id.id, *segment);
+        }
+    }
+
+    // a node without segments stays at the origin
+    std::vector<util::Coordinate> coordinates(
+        number_of_nodes, util::Coordinate{util::FixedLongitude{0}, util::FixedLatitude{0}});
+    for (NodeID node = 0; node < number_of_nodes; ++node)
+    {
+        if (counts[node] > 0)
+        {
+            coordinates[node] = util::Coordinate{
+                util::FixedLongitude{static_cast<std::int32_t>(lon_sums[node] / counts[node])},
+                util::FixedLatitude{static_cast<std::int32_t>(lat_sums[node] / counts[node])}};
+        }
+    }
+    return coordinates;
+}
+}
+}
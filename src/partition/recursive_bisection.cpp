@@ -0,0 +1,116 @@
+#include "partition/recursive_bisection.hpp"
+#include "partition/inertial_flow.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/concurrent_vector.h>
+#include <tbb/parallel_invoke.h>
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace osrm
+{
+namespace partition
+{
+
+namespace
+{
+// The nodes of a part of a bisection are at begin up to end of the order
+struct Part
+{
+    std::size_t begin;
+    std::size_t end;
+};
+
+void bisect(BisectionGraph graph,
+            std::vector<NodeID> graph_ids,
+            const std::size_t begin,
+            const PartitionerConfig &config,
+            std::vector<NodeID> &order,
+            tbb::concurrent_vector<Part> &parts)
+{
+    const auto number_of_nodes = graph.GetNumberOfNodes();
+    parts.push_back({begin, begin + number_of_nodes});
+    if (number_of_nodes <= config.max_cell_sizes.front())
+    {
+        std::copy(graph_ids.begin(), graph_ids.end(), order.begin() + begin);
+        return;
+    }
+
+    const auto bisection = inertialFlow(
+        graph, config.number_of_directions, config.boundary_factor, config.balance);
+    std::vector<NodeID> first_ids, second_ids;
+    auto first = makeSubgraph(graph, bisection.sides, false, first_ids);
+    auto second = makeSubgraph(graph, bisection.sides, true, second_ids);
+    graph = BisectionGraph();
+    for (auto &id : first_ids)
+    {
+        id = graph_ids[id];
+    }
+    for (auto &id : second_ids)
+    {
+        id = graph_ids[id];
+    }
+    std::vector<NodeID>().swap(graph_ids);
+
+    const auto second_begin = begin + first_ids.size();
+    tbb::parallel_invoke(
+        [&] { bisect(std::move(first), std::move(first_ids), begin, config, order, parts); },
+        [&] {
+            bisect(std::move(second), std::move(second_ids), second_begin, config, order, parts);
+        });
+}
+}
+
+MultiLevelPartition computeMultiLevelPartition(BisectionGraph graph,
+                                               const PartitionerConfig &config)
+{
+    BOOST_ASSERT(!config.max_cell_sizes.empty() && config.max_cell_sizes.front() > 0);
+    BOOST_ASSERT(std::is_sorted(config.max_cell_sizes.begin(), config.max_cell_sizes.end()));
+
+    const std::size_t number_of_nodes = graph.GetNumberOfNodes();
+    std::vector<NodeID> order(number_of_nodes);
+    tbb::concurrent_vector<Part> parts;
+    if (number_of_nodes > 0)
+    {
+        std::vector<NodeID> graph_ids(number_of_nodes);
+        std::iota(graph_ids.begin(), graph_ids.end(), 0);
+        bisect(std::move(graph), std::move(graph_ids), 0, config, order, parts);
+    }
+
+    // the parts either nest or don't overlap, so this order has every part after the parts
+    // around it
+    tbb::parallel_sort(parts.begin(), parts.end(), [](const Part &lhs, const Part &rhs) {
+        return lhs.begin < rhs.begin || (lhs.begin == rhs.begin && lhs.end > rhs.end);
+    });
+
+    const auto number_of_levels = config.max_cell_sizes.size();
+    std::vector<CellID> cells(number_of_levels * number_of_nodes, INVALID_CELL_ID);
+    for (std::size_t level = 0; level < number_of_levels; ++level)
+    {
+        const auto level_cells = cells.begin() + level * number_of_nodes;
+        CellID cell = 0;
+        std::size_t assigned_end = 0;
+        for (const auto &part : parts)
+        {
+            if (part.begin >= assigned_end &&
+                part.end - part.begin <= config.max_cell_sizes[level])
+            {
+                for (auto index = part.begin; index < part.end; ++index)
+                {
+                    level_cells[order[index]] = cell;
+                }
+                ++cell;
+                assigned_end = part.end;
+            }
+        }
+        BOOST_ASSERT(assigned_end == number_of_nodes);
+    }
+
+    return MultiLevelPartition(config.max_cell_sizes, std::move(cells));
+}
+}
+}
@@ -0,0 +1,212 @@
+#include "server/access_log.hpp"
+
+#include "util/simple_logger.hpp"
+#include "util/string_util.hpp"
+
+#include <boost/assert.hpp>
+
+#include <ctime>
+#include <functional>
+#include <ostream>
+#include <random>
+#include <utility>
+
+namespace osrm
+{
+namespace server
+{
+
+namespace
+{
+// how long the lines wait in the buffers at most
+const constexpr auto DRAIN_INTERVAL = std::chrono::milliseconds(10);
+
+std::atomic<std::uint64_t> next_id{0};
+
+std::size_t roundUpToPowerOfTwo(const std::size_t size)
+{
+    std::size_t capacity = 1;
+    while (capacity < size)
+    {
+        capacity *= 2;
+    }
+    return capacity;
+}
+}
+
+AccessLog::RingBuffer::RingBuffer(const std::size_t capacity)
+    : slots(roundUpToPowerOfTwo(capacity)), mask(slots.size() - 1)
+{
+}
+
+bool AccessLog::RingBuffer::Push(Record &record)
+{
+    const auto current_tail = tail.load(std::memory_order_relaxed);
+    if (current_tail - head.load(std::memory_order_acquire) == slots.size())
+    {
+        return false;
+    }
+    slots[current_tail & mask] = std::move(record);
+    tail.store(current_tail + 1, std::memory_order_release);
+    return true;
+}
+
+void AccessLog::RingBuffer::PopAll(std::vector<Record> &records)
+{
+    const auto current_head = head.load(std::memory_order_relaxed);
+    const auto current_tail = tail.load(std::memory_order_acquire);
+    for (auto index = current_head; index != current_tail; ++index)
+    {
+        records.push_back(std::move(slots[index & mask]));
+    }
+    head.store(current_tail, std::memory_order_release);
+}
+
+AccessLog::AccessLog(const Format format,
+                     const double sample_rate,
+                     std::ostream &output,
+                     const std::size_t buffer_size)
+    : format(format), sample_rate(sample_rate), output(output), buffer_size(buffer_size),
+      id(next_id++)
+{
+    BOOST_ASSERT(buffer_size > 0);
+    thread = std::thread([this] { Run(); });
+}
+
+AccessLog::~AccessLog()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    stopped.notify_all();
+    thread.join();
+}
+
+bool AccessLog::IsSampled(const int status) const
+{
+    if (status != 200 || sample_rate >= 1)
+    {
+        return true;
+    }
+    thread_local std::minstd_rand generator(
+        static_cast<std::minstd_rand::result_type>(std::hash<std::thread::id>()(
+            std::this_thread::get_id())));
+    return std::uniform_real_distribution<double>(0, 1)(generator) < sample_rate;
+}
+
+void AccessLog::Add(Record record)
+{
+    if (!GetThreadBuffer().Push(record))
+    {
+        ++dropped;
+    }
+}
+
+AccessLog::RingBuffer &AccessLog::GetThreadBuffer()
+{
+    // the ids of the logs are never reused, so buffers of destroyed logs are never found
+    thread_local std::vector<std::pair<std::uint64_t, RingBuffer *>> thread_buffers;
+    for (const auto &thread_buffer : thread_buffers)
+    {
+        if (thread_buffer.first == id)
+        {
+            return *thread_buffer.second;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    buffers.push_back(std::unique_ptr<RingBuffer>(new RingBuffer(buffer_size)));
+    thread_buffers.emplace_back(id, buffers.back().get());
+    return *buffers.back();
+}
+
+void AccessLog::Run()
+{
+    std::vector<Record> records;
+    std::uint64_t reported_dropped = 0;
+    bool running = true;
+    while (running)
+    {
+        running = Wait();
+        Drain(records);
+
+        if (!records.empty())
+        {
+            std::lock_guard<std::mutex> lock(util::SimpleLogger::get_mutex());
+            for (const auto &record : records)
+            {
+                Write(format, record, output);
+            }
+            output.flush();
+            records.clear();
+        }
+
+        const std::uint64_t current_dropped = dropped;
+        if (current_dropped != reported_dropped)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "dropped " << current_dropped - reported_dropped
+                << " access log records, their buffers were full";
+            reported_dropped = current_dropped;
+        }
+    }
+}
+
+bool AccessLog::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    stopped.wait_for(lock, DRAIN_INTERVAL, [this] { return stop; });
+    return !stop;
+}
+
+void AccessLog::Drain(std::vector<Record> &records)
+{
+    std::vector<RingBuffer *> current_buffers;
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        for (const auto &buffer : buffers)
+        {
+            current_buffers.push_back(buffer.get());
+        }
+    }
+    for (auto *buffer : current_buffers)
+    {
+        buffer->PopAll(records);
+    }
+}
+
+void AccessLog::Write(const Format format, const Record &record, std::ostream &output)
+{
+    std::tm time;
+    char formatted_time[32];
+    if (format == Format::Text)
+    {
+#ifdef _WIN32
+        localtime_s(&time, &record.time);
+#else
+        localtime_r(&record.time, &time);
+#endif
+        std::strftime(formatted_time, sizeof(formatted_time), "%d-%m-%Y %H:%M:%S", &time);
+        output << "[info] " << formatted_time << " " << record.endpoint.to_string() << " "
+               << record.referrer << (record.referrer.empty() ? "- " : " ") << record.agent
+               << (record.agent.empty() ? "- " : " ") << record.status << " " << record.request
+               << "\n";
+        return;
+    }
+
+#ifdef _WIN32
+    gmtime_s(&time, &record.time);
+#else
+    gmtime_r(&record.time, &time);
+#endif
+    std::strftime(formatted_time, sizeof(formatted_time), "%Y-%m-%dT%H:%M:%SZ", &time);
+    output << "{\"time\":\"" << formatted_time << "\",\"client\":\""
+           << record.endpoint.to_string() << "\",\"referrer\":\""
+           << util::escape_JSON(record.referrer) << "\",\"agent\":\""
+           << util::escape_JSON(record.agent) << "\",\"status\":" << record.status
+           << ",\"duration_us\":" << record.duration.count() << ",\"request\":\""
+           << util::escape_JSON(record.request) << "\"}\n";
+}
+}
+}
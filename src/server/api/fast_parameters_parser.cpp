@@ -0,0 +1,261 @@
+#include "server/api/fast_parameters_parser.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+
+namespace osrm
+{
+namespace server
+{
+namespace api
+{
+namespace fast
+{
+
+namespace
+{
+// Numbers with more digits are left to the grammars, below it the mantissa and the powers of ten
+// are exact doubles and the division rounds like the real parser of boost::spirit does
+const constexpr int MAX_DIGITS = 15;
+const constexpr double POWERS_OF_TEN[] = {1e0,
+                                          1e1,
+                                          1e2,
+                                          1e3,
+                                          1e4,
+                                          1e5,
+                                          1e6,
+                                          1e7,
+                                          1e8,
+                                          1e9,
+                                          1e10,
+                                          1e11,
+                                          1e12,
+                                          1e13,
+                                          1e14,
+                                          1e15};
+// toFixed fails on degrees that don't fit into 32 bit fixed point
+const constexpr double MAX_DEGREES =
+    std::numeric_limits<std::int32_t>::max() / COORDINATE_PRECISION;
+
+inline bool isDigit(const char c) { return c >= '0' && c <= '9'; }
+
+// -?[0-9]+(\.[0-9]+)?
+bool parseDecimal(const char *&position, const char *end, double &value)
+{
+    const char *current = position;
+    const bool is_negative = current != end && *current == '-';
+    if (is_negative)
+    {
+        ++current;
+    }
+    if (current == end || !isDigit(*current))
+    {
+        return false;
+    }
+
+    std::uint64_t mantissa = 0;
+    int digits = 0;
+    int fraction_digits = 0;
+    for (; current != end && isDigit(*current); ++current, ++digits)
+    {
+        mantissa = mantissa * 10 + (*current - '0');
+    }
+    if (current + 1 < end && *current == '.' && isDigit(current[1]))
+    {
+        for (++current; current != end && isDigit(*current); ++current, ++fraction_digits)
+        {
+            mantissa = mantissa * 10 + (*current - '0');
+        }
+    }
+    if (digits + fraction_digits > MAX_DIGITS)
+    {
+        return false;
+    }
+
+    value = static_cast<double>(mantissa) / POWERS_OF_TEN[fraction_digits];
+    if (is_negative)
+    {
+        value = -value;
+    }
+    position = current;
+    return true;
+}
+
+bool parseDegrees(const char *&position, const char *end, double &degrees)
+{
+    return parseDecimal(position, end, degrees) && degrees < MAX_DEGREES &&
+           degrees > -MAX_DEGREES;
+}
+
+// the end of the element of a list that starts at begin
+inline const char *findSeparator(const char *begin, const char *end)
+{
+    const auto separator = static_cast<const char *>(std::memchr(begin, ';', end - begin));
+    return separator ? separator : end;
+}
+
+inline bool isBase64(const char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || isDigit(c) || c == '-' ||
+           c == '_' || c == '=';
+}
+
+// A format extension after the coordinates, the grammars look at it again
+inline bool isFollowedBy(const char *position, const char *end, const char *text)
+{
+    const auto length = std::strlen(text);
+    return static_cast<std::size_t>(end - position) >= length &&
+           std::memcmp(position, text, length) == 0;
+}
+}
+
+bool parseCoordinates(const char *&position,
+                      const char *end,
+                      std::vector<util::Coordinate> &coordinates)
+{
+    const char *current = position;
+    while (true)
+    {
+        double longitude, latitude;
+        if (!parseDegrees(current, end, longitude) || current == end || *current != ',')
+        {
+            return false;
+        }
+        ++current;
+        if (!parseDegrees(current, end, latitude))
+        {
+            return false;
+        }
+        coordinates.emplace_back(util::toFixed(util::FloatLongitude{longitude}),
+                                 util::toFixed(util::FloatLatitude{latitude}));
+
+        if (current == end || *current == '?' || isFollowedBy(current, end, ".json") ||
+            isFollowedBy(current, end, ".pbf"))
+        {
+            position = current;
+            return true;
+        }
+        if (*current != ';')
+        {
+            return false;
+        }
+        ++current;
+    }
+}
+
+bool parseHints(const char *begin,
+                const char *end,
+                std::vector<boost::optional<engine::Hint>> &hints)
+{
+    std::vector<boost::optional<engine::Hint>> parsed;
+    while (true)
+    {
+        const auto separator = findSeparator(begin, end);
+        const auto size = static_cast<std::size_t>(separator - begin);
+        if (size == 0)
+        {
+            parsed.emplace_back(boost::none);
+        }
+        else if ((size == engine::ENCODED_HINT_SIZE ||
+                  size == engine::ENCODED_COMPACT_HINT_SIZE) &&
+                 std::all_of(begin, separator, isBase64))
+        {
+            parsed.emplace_back(engine::Hint::FromBase64(std::string(begin, separator)));
+        }
+        else
+        {
+            return false;
+        }
+
+        if (separator == end)
+        {
+            // every hints option adds to the hints, like with the grammar
+            hints.insert(hints.end(), parsed.begin(), parsed.end());
+            return true;
+        }
+        begin = separator + 1;
+    }
+}
+
+bool parseRadiuses(const char *begin,
+                   const char *end,
+                   std::vector<boost::optional<double>> &radiuses)
+{
+    std::vector<boost::optional<double>> parsed;
+    while (true)
+    {
+        const auto separator = findSeparator(begin, end);
+        double radius;
+        if (begin == separator)
+        {
+            parsed.emplace_back(boost::none);
+        }
+        else if (isFollowedBy(begin, separator, "unlimited") && separator - begin == 9)
+        {
+            parsed.emplace_back(std::numeric_limits<double>::infinity());
+        }
+        else if (parseDecimal(begin, separator, radius) && begin == separator)
+        {
+            parsed.emplace_back(radius);
+        }
+        else
+        {
+            return false;
+        }
+
+        if (separator == end)
+        {
+            // the last option wins, like with the grammar
+            radiuses = std::move(parsed);
+            return true;
+        }
+        begin = separator + 1;
+    }
+}
+
+bool parseIndices(const char *begin, const char *end, std::vector<std::size_t> &indices)
+{
+    if (end - begin == 3 && std::memcmp(begin, "all", 3) == 0)
+    {
+        return true;
+    }
+
+    std::vector<std::size_t> parsed;
+    while (true)
+    {
+        if (begin == end || !isDigit(*begin))
+        {
+            return false;
+        }
+        std::size_t index = 0;
+        for (; begin != end && isDigit(*begin); ++begin)
+        {
+            const std::size_t digit = *begin - '0';
+            if (index > (std::numeric_limits<std::size_t>::max() - digit) / 10)
+            {
+                return false;
+            }
+            index = index * 10 + digit;
+        }
+        parsed.push_back(index);
+
+        if (begin == end)
+        {
+            indices = std::move(parsed);
+            return true;
+        }
+        if (*begin != ';')
+        {
+            return false;
+        }
+        ++begin;
+    }
+}
+}
+}
+}
+}
@@ -1,12 +1,17 @@
 #include "server/api/parameters_parser.hpp"
 
+#include "server/api/fast_parameters_parser.hpp"
+#include "server/api/isochrone_parameter_grammar.hpp"
 #include "server/api/match_parameter_grammar.hpp"
 #include "server/api/nearest_parameter_grammar.hpp"
+#include "server/api/route_batch_parameters_grammar.hpp"
 #include "server/api/route_parameters_grammar.hpp"
 #include "server/api/table_parameter_grammar.hpp"
 #include "server/api/tile_parameter_grammar.hpp"
 #include "server/api/trip_parameter_grammar.hpp"
 
+#include <cstring>
+#include <string>
 #include <type_traits>
 
 namespace osrm
@@ -22,11 +27,143 @@ template <typename T>
 using is_grammar_t =
     std::integral_constant<bool,
                            std::is_same<RouteParametersGrammar<>, T>::value ||
+                               std::is_same<RouteBatchParametersGrammar<>, T>::value ||
                                std::is_same<TableParametersGrammar<>, T>::value ||
                                std::is_same<NearestParametersGrammar<>, T>::value ||
                                std::is_same<TripParametersGrammar<>, T>::value ||
                                std::is_same<MatchParametersGrammar<>, T>::value ||
-                               std::is_same<TileParametersGrammar<>, T>::value>;
+                               std::is_same<TileParametersGrammar<>, T>::value ||
+                               std::is_same<IsochroneParametersGrammar<>, T>::value>;
+
+inline bool startsWith(const char *begin, const char *end, const char *prefix)
+{
+    const auto length = std::strlen(prefix);
+    return static_cast<std::size_t>(end - begin) >= length &&
+           std::memcmp(begin, prefix, length) == 0;
+}
+
+// Parses the options with a value per coordinate into the parameters. Returns false for the
+// other options, which are left to the grammars, and sets is_valid to false if the value is one
+// the fast parsers don't take.
+inline bool parseListOption(engine::api::BaseParameters &parameters,
+                            const char *begin,
+                            const char *end,
+                            bool &is_valid)
+{
+    if (startsWith(begin, end, "hints="))
+    {
+        is_valid = fast::parseHints(begin + std::strlen("hints="), end, parameters.hints);
+        return true;
+    }
+    if (startsWith(begin, end, "radiuses="))
+    {
+        is_valid = fast::parseRadiuses(begin + std::strlen("radiuses="), end, parameters.radiuses);
+        return true;
+    }
+    return false;
+}
+
+inline bool parseListOption(engine::api::TableParameters &parameters,
+                            const char *begin,
+                            const char *end,
+                            bool &is_valid)
+{
+    if (startsWith(begin, end, "sources="))
+    {
+        is_valid = fast::parseIndices(begin + std::strlen("sources="), end, parameters.sources);
+        return true;
+    }
+    if (startsWith(begin, end, "destinations="))
+    {
+        is_valid =
+            fast::parseIndices(begin + std::strlen("destinations="), end, parameters.destinations);
+        return true;
+    }
+    return parseListOption(static_cast<engine::api::BaseParameters &>(parameters),
+                           begin,
+                           end,
+                           is_valid);
+}
+
+// The grammars take most of the time of queries with many coordinates on the coordinates and the
+// options with a value per coordinate. These are parsed by the fast parsers, the grammar only
+// parses the format and the other options, with a placeholder in place of the coordinates.
+// Returns none for everything the fast parsers don't take, which the grammar parses on its own.
+template <typename ParameterT, typename GrammarT>
+boost::optional<ParameterT> parseParametersFast(const GrammarT &grammar,
+                                                const std::string::iterator iter,
+                                                const std::string::iterator end,
+                                                std::true_type /* has coordinates */)
+{
+    if (iter == end)
+    {
+        return boost::none;
+    }
+    const char *position = &*iter;
+    const char *const last = position + (end - iter);
+
+    ParameterT parameters;
+    std::vector<util::Coordinate> coordinates;
+    if (!fast::parseCoordinates(position, last, coordinates))
+    {
+        return boost::none;
+    }
+
+    const auto query = static_cast<const char *>(std::memchr(position, '?', last - position));
+    std::string remaining = "0,0";
+    remaining.append(position, query ? query : last);
+    if (query)
+    {
+        auto separator = '?';
+        for (const char *option = query + 1; option <= last;)
+        {
+            const auto next = static_cast<const char *>(std::memchr(option, '&', last - option));
+            const char *const option_end = next ? next : last;
+
+            bool is_valid = true;
+            if (!parseListOption(parameters, option, option_end, is_valid))
+            {
+                remaining.push_back(separator);
+                remaining.append(option, option_end);
+                separator = '&';
+            }
+            else if (!is_valid)
+            {
+                return boost::none;
+            }
+            option = option_end + 1;
+        }
+    }
+
+    // errors are reported by the grammar parsing the query itself, at their position in it
+    try
+    {
+        auto remaining_iter = remaining.begin();
+        const auto ok = boost::spirit::qi::parse(
+            remaining_iter, remaining.end(), grammar(boost::phoenix::ref(parameters)));
+        if (!ok || remaining_iter != remaining.end())
+        {
+            return boost::none;
+        }
+    }
+    catch (const qi::expectation_failure<std::string::iterator> &)
+    {
+        return boost::none;
+    }
+
+    parameters.coordinates = std::move(coordinates);
+    return std::move(parameters);
+}
+
+// tiles are requested by their x, y and zoom
+template <typename ParameterT, typename GrammarT>
+boost::optional<ParameterT> parseParametersFast(const GrammarT &,
+                                                const std::string::iterator,
+                                                const std::string::iterator,
+                                                std::false_type /* has coordinates */)
+{
+    return boost::none;
+}
 
 template <typename ParameterT,
           typename GrammarT,
@@ -41,6 +178,13 @@ boost::optional<ParameterT> parseParameters(std::string::iterator &iter,
 
     try
     {
+        if (auto parameters = parseParametersFast<ParameterT>(
+                grammar, iter, end, std::is_base_of<engine::api::BaseParameters, ParameterT>{}))
+        {
+            iter = end;
+            return parameters;
+        }
+
         ParameterT parameters;
         const auto ok =
             boost::spirit::qi::parse(iter, end, grammar(boost::phoenix::ref(parameters)));
@@ -68,6 +212,14 @@ boost::optional<engine::api::RouteParameters> parseParameters(std::string::itera
                                                                                            end);
 }
 
+template <>
+boost::optional<engine::api::RouteBatchParameters>
+parseParameters(std::string::iterator &iter, const std::string::iterator end)
+{
+    return detail::parseParameters<engine::api::RouteBatchParameters,
+                                   RouteBatchParametersGrammar<>>(iter, end);
+}
+
 template <>
 boost::optional<engine::api::TableParameters> parseParameters(std::string::iterator &iter,
                                                               const std::string::iterator end)
@@ -106,6 +258,14 @@ boost::optional<engine::api::TileParameters> parseParameters(std::string::iterat
     return detail::parseParameters<engine::api::TileParameters, TileParametersGrammar<>>(iter, end);
 }
 
+template <>
+boost::optional<engine::api::IsochroneParameters>
+parseParameters(std::string::iterator &iter, const std::string::iterator end)
+{
+    return detail::parseParameters<engine::api::IsochroneParameters,
+                                   IsochroneParametersGrammar<>>(iter, end);
+}
+
 } // ns api
 } // ns server
 } // ns osrm
@@ -1,13 +1,22 @@
 #include "server/connection.hpp"
+#include "server/query_pool.hpp"
 #include "server/request_handler.hpp"
 #include "server/request_parser.hpp"
+#include "server/tile_store.hpp"
+
+#include "util/exception.hpp"
+#include "util/query_metrics.hpp"
+#include "util/tracepoint.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/bind.hpp>
-#include <boost/iostreams/filter/gzip.hpp>
-#include <boost/iostreams/filtering_stream.hpp>
 
-#include <iterator>
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -16,17 +25,179 @@ namespace osrm
 namespace server
 {
 
-Connection::Connection(boost::asio::io_service &io_service, RequestHandler &handler)
-    : strand(io_service), TCP_socket(io_service), request_handler(handler)
+namespace
+{
+// a connection without a request for that long is closed
+const constexpr long KEEP_ALIVE_TIMEOUT_SECONDS = 5;
+// a connection is closed after this many requests
+const constexpr unsigned MAX_KEEP_ALIVE_REQUESTS = 512;
+const constexpr char CONTINUE_REPLY[] = "HTTP/1.1 100 Continue\r\n\r\n";
+// every chunk ends with a line break, the last one is empty
+const constexpr char CHUNK_END[] = "\r\n";
+const constexpr char LAST_CHUNK[] = "0\r\n\r\n";
+
+// zlib picks the format by the window bits: 16 + 15 for a gzip wrapper, -15 for raw deflate
+const constexpr int GZIP_WINDOW_BITS = 16 + MAX_WBITS;
+const constexpr int DEFLATE_WINDOW_BITS = -MAX_WBITS;
+const constexpr int MEMORY_LEVEL = 8;
+// zlib counts the buffers with 32 bit, larger replies are handed over in several steps
+const constexpr std::size_t MAX_STEP_SIZE = 1u << 30;
+
+// the service is the first part of the path, like in /route/v1/driving/...
+bool getService(const std::string &uri, util::QueryMetrics::Service &service)
+{
+    const auto begin = uri.find_first_not_of('/');
+    if (begin == std::string::npos)
+    {
+        return false;
+    }
+    const auto end = uri.find('/', begin);
+    return util::QueryMetrics::GetService(
+        uri.substr(begin, end == std::string::npos ? end : end - begin), service);
+}
+
+// A zlib stream that is reset for every reply instead of allocating its state every time
+class DeflateStream
+{
+  public:
+    explicit DeflateStream(const int window_bits)
+    {
+        std::memset(&stream, 0, sizeof(stream));
+        // there's a trade-off between speed and size. speed wins
+        if (deflateInit2(&stream,
+                         Z_BEST_SPEED,
+                         Z_DEFLATED,
+                         window_bits,
+                         MEMORY_LEVEL,
+                         Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            throw util::exception("Could not initialize zlib");
+        }
+    }
+    ~DeflateStream() { deflateEnd(&stream); }
+
+    DeflateStream(const DeflateStream &) = delete;
+    DeflateStream &operator=(const DeflateStream &) = delete;
+
+    // Compresses input into output without any intermediate buffers
+    void Compress(const std::vector<char> &input, std::vector<char> &output)
+    {
+        deflateReset(&stream);
+        output.resize(deflateBound(&stream, input.size()));
+
+        const char *next_input = input.data();
+        std::size_t remaining_input = input.size();
+        stream.avail_in = 0;
+        stream.avail_out = 0;
+        int status = Z_OK;
+        do
+        {
+            if (stream.avail_in == 0)
+            {
+                const auto step = std::min<std::size_t>(remaining_input, MAX_STEP_SIZE);
+                stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(next_input));
+                stream.avail_in = static_cast<uInt>(step);
+                next_input += step;
+                remaining_input -= step;
+            }
+            if (stream.avail_out == 0)
+            {
+                // only happens if zlib's bound doesn't hold
+                if (stream.total_out == output.size())
+                {
+                    output.resize(output.size() + output.size() / 2 + 1);
+                }
+                const auto step =
+                    std::min<std::size_t>(output.size() - stream.total_out, MAX_STEP_SIZE);
+                stream.next_out = reinterpret_cast<Bytef *>(output.data() + stream.total_out);
+                stream.avail_out = static_cast<uInt>(step);
+            }
+            status = deflate(&stream, remaining_input == 0 ? Z_FINISH : Z_NO_FLUSH);
+            BOOST_ASSERT(status != Z_STREAM_ERROR);
+        } while (status != Z_STREAM_END);
+        output.resize(stream.total_out);
+    }
+
+    // Compresses a part of a reply that is sent in chunks into output, the first part starts the
+    // stream over. Every part is flushed, so the client can decode what it got so far.
+    void CompressPart(const char *input,
+                      std::size_t size,
+                      const bool is_first,
+                      const bool is_last,
+                      std::vector<char> &output)
+    {
+        if (is_first)
+        {
+            deflateReset(&stream);
+        }
+        output.clear();
+        do
+        {
+            const auto step = std::min<std::size_t>(size, MAX_STEP_SIZE);
+            stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input));
+            stream.avail_in = static_cast<uInt>(step);
+            input += step;
+            size -= step;
+            const int flush = size > 0 ? Z_NO_FLUSH : is_last ? Z_FINISH : Z_SYNC_FLUSH;
+            // a flush is only complete with space left over
+            do
+            {
+                const auto used = output.size();
+                output.resize(used + std::min<std::size_t>(
+                                         deflateBound(&stream, stream.avail_in), MAX_STEP_SIZE));
+                stream.next_out = reinterpret_cast<Bytef *>(output.data() + used);
+                stream.avail_out = static_cast<uInt>(output.size() - used);
+                const auto status = deflate(&stream, flush);
+                BOOST_ASSERT(status != Z_STREAM_ERROR);
+                (void)status;
+                output.resize(output.size() - stream.avail_out);
+            } while (stream.avail_out == 0);
+        } while (size > 0);
+    }
+
+  private:
+    z_stream stream;
+};
+
+// The address of the client of a TCP connection, clients on a Unix domain socket are local
+boost::asio::ip::address
+getRemoteAddress(const boost::asio::generic::stream_protocol::socket &socket)
+{
+    boost::system::error_code error;
+    const auto endpoint = socket.remote_endpoint(error);
+    const auto family = endpoint.protocol().family();
+    if (error || (family != AF_INET && family != AF_INET6))
+    {
+        return boost::asio::ip::address_v4::loopback();
+    }
+    boost::asio::ip::tcp::endpoint tcp_endpoint;
+    std::memcpy(tcp_endpoint.data(), endpoint.data(), endpoint.size());
+    tcp_endpoint.resize(endpoint.size());
+    return tcp_endpoint.address();
+}
+}
+
+Connection::Connection(boost::asio::io_service &io_service,
+                       RequestHandler &handler,
+                       QueryPool *query_pool)
+    : strand(io_service), stream_socket(io_service), timer(io_service), request_handler(handler),
+      query_pool(query_pool), stream_compression(http::no_compression), stream_failed(false),
+      pending_begin(nullptr), pending_end(nullptr), keep_alive(false), processed_requests(0)
 {
 }
 
-boost::asio::ip::tcp::socket &Connection::socket() { return TCP_socket; }
+boost::asio::generic::stream_protocol::socket &Connection::socket() { return stream_socket; }
 
 /// Start the first asynchronous operation for the connection.
-void Connection::start()
+void Connection::start() { read(); }
+
+void Connection::read()
 {
-    TCP_socket.async_read_some(
+    timer.expires_from_now(boost::posix_time::seconds(KEEP_ALIVE_TIMEOUT_SECONDS));
+    timer.async_wait(strand.wrap(boost::bind(
+        &Connection::handle_timeout, this->shared_from_this(), boost::asio::placeholders::error)));
+
+    stream_socket.async_read_some(
         boost::asio::buffer(incoming_data_buffer),
         strand.wrap(boost::bind(&Connection::handle_read,
                                 this->shared_from_this(),
@@ -36,114 +207,299 @@ void Connection::start()
 
 void Connection::handle_read(const boost::system::error_code &error, std::size_t bytes_transferred)
 {
+    timer.cancel();
     if (error)
     {
         return;
     }
 
+    process(incoming_data_buffer.data(), incoming_data_buffer.data() + bytes_transferred);
+}
+
+void Connection::process(char *begin, char *end)
+{
     // no error detected, let's parse the request
     http::compression_type compression_type(http::no_compression);
     RequestParser::RequestStatus result;
-    std::tie(result, compression_type) =
-        request_parser.parse(current_request,
-                             incoming_data_buffer.data(),
-                             incoming_data_buffer.data() + bytes_transferred);
+    char *request_end;
+    std::tie(result, compression_type, request_end) =
+        request_parser.parse(current_request, begin, end);
 
     // the request has been parsed
     if (result == RequestParser::RequestStatus::valid)
     {
-        current_request.endpoint = TCP_socket.remote_endpoint().address();
-        request_handler.HandleRequest(current_request, current_reply);
+        // pipelined requests are answered in order once this one is written
+        pending_begin = request_end;
+        pending_end = end;
+        keep_alive = current_request.keep_alive && ++processed_requests < MAX_KEEP_ALIVE_REQUESTS;
 
-        // compress the result w/ gzip/deflate if requested
-        switch (compression_type)
+        current_request.endpoint = getRemoteAddress(stream_socket);
+
+        if (!query_pool)
+        {
+            handle_request(compression_type);
+            write_reply();
+            return;
+        }
+
+        // nothing else touches the connection until the query posts its reply back
+        auto self = this->shared_from_this();
+        const bool accepted = query_pool->Submit(QueryPool::GetPriority(current_request.uri),
+                                                 [self, compression_type] {
+                                                     self->handle_request(compression_type);
+                                                     self->strand.post(boost::bind(
+                                                         &Connection::write_reply, self));
+                                                 });
+        if (!accepted)
         {
-        case http::deflate_rfc1951:
-            // use deflate for compression
-            current_reply.headers.insert(current_reply.headers.begin(),
-                                         {"Content-Encoding", "deflate"});
-            compressed_output = compress_buffers(current_reply.content, compression_type);
-            current_reply.set_size(static_cast<unsigned>(compressed_output.size()));
-            output_buffer = current_reply.headers_to_buffers();
-            output_buffer.push_back(boost::asio::buffer(compressed_output));
-            break;
-        case http::gzip_rfc1952:
-            // use gzip for compression
-            current_reply.headers.insert(current_reply.headers.begin(),
-                                         {"Content-Encoding", "gzip"});
-            compressed_output = compress_buffers(current_reply.content, compression_type);
-            current_reply.set_size(static_cast<unsigned>(compressed_output.size()));
-            output_buffer = current_reply.headers_to_buffers();
-            output_buffer.push_back(boost::asio::buffer(compressed_output));
-            break;
-        case http::no_compression:
-            // don't use any compression
-            current_reply.set_uncompressed_size();
+            current_reply = http::reply::stock_reply(http::reply::too_many_requests);
+            current_reply.set_keep_alive(keep_alive);
             output_buffer = current_reply.to_buffers();
-            break;
+            write_reply();
         }
-        // write result to stream
-        boost::asio::async_write(TCP_socket,
-                                 output_buffer,
-                                 strand.wrap(boost::bind(&Connection::handle_write,
-                                                         this->shared_from_this(),
-                                                         boost::asio::placeholders::error)));
     }
     else if (result == RequestParser::RequestStatus::invalid)
     { // request is not parseable
+        keep_alive = false;
         current_reply = http::reply::stock_reply(http::reply::bad_request);
 
-        boost::asio::async_write(TCP_socket,
+        boost::asio::async_write(stream_socket,
                                  current_reply.to_buffers(),
                                  strand.wrap(boost::bind(&Connection::handle_write,
                                                          this->shared_from_this(),
                                                          boost::asio::placeholders::error)));
     }
+    else if (request_parser.ContinueExpected())
+    {
+        // the client waits for this before it sends the body
+        boost::asio::async_write(stream_socket,
+                                 boost::asio::buffer(CONTINUE_REPLY, sizeof(CONTINUE_REPLY) - 1),
+                                 strand.wrap(boost::bind(&Connection::handle_continue,
+                                                         this->shared_from_this(),
+                                                         boost::asio::placeholders::error)));
+    }
     else
     {
         // we don't have a result yet, so continue reading
-        TCP_socket.async_read_some(
-            boost::asio::buffer(incoming_data_buffer),
-            strand.wrap(boost::bind(&Connection::handle_read,
-                                    this->shared_from_this(),
-                                    boost::asio::placeholders::error,
-                                    boost::asio::placeholders::bytes_transferred)));
+        read();
+    }
+}
+
+void Connection::handle_continue(const boost::system::error_code &error)
+{
+    if (!error)
+    {
+        read();
     }
 }
 
+void Connection::handle_request(const http::compression_type compression_type)
+{
+    stream_compression = compression_type;
+    stream_failed = false;
+    request_handler.HandleRequest(current_request, current_reply, this);
+    if (current_reply.is_streamed)
+    {
+        // the chunks are sent, a reply that failed on the way is cut off without the last one
+        if (current_reply.status != http::reply::ok || !finish_stream())
+        {
+            keep_alive = false;
+        }
+        output_buffer.fill(boost::asio::const_buffer());
+        return;
+    }
+    current_reply.set_keep_alive(keep_alive);
+
+    if (current_reply.is_gzipped)
+    {
+        if (compression_type == http::gzip_rfc1952)
+        {
+            current_reply.content_encoding = "gzip";
+            output_buffer = current_reply.to_buffers();
+            return;
+        }
+        // the client doesn't accept gzip, deflate compresses the content again below
+        TileStore::Decompress(current_reply.content, compressed_output);
+        current_reply.content.swap(compressed_output);
+        current_reply.is_gzipped = false;
+    }
+
+    // compress the result w/ gzip/deflate if requested, only the compressed copy is kept
+    switch (compression_type)
+    {
+    case http::deflate_rfc1951:
+        // use deflate for compression
+        current_reply.content_encoding = "deflate";
+        compress_buffers(current_reply.content, compression_type, compressed_output);
+        output_buffer = current_reply.to_buffers(compressed_output);
+        std::vector<char>().swap(current_reply.content);
+        break;
+    case http::gzip_rfc1952:
+        // use gzip for compression
+        current_reply.content_encoding = "gzip";
+        compress_buffers(current_reply.content, compression_type, compressed_output);
+        output_buffer = current_reply.to_buffers(compressed_output);
+        std::vector<char>().swap(current_reply.content);
+        break;
+    case http::no_compression:
+        // don't use any compression
+        output_buffer = current_reply.to_buffers();
+        break;
+    }
+}
+
+bool Connection::Write(http::reply &reply, const char *data, const std::size_t size)
+{
+    return write_chunk(reply, data, size, false);
+}
+
+bool Connection::write_chunk(http::reply &reply,
+                             const char *data,
+                             const std::size_t size,
+                             const bool is_last)
+{
+    if (stream_failed)
+    {
+        return false;
+    }
+
+    std::vector<boost::asio::const_buffer> buffers;
+    const bool is_first = !reply.is_streamed;
+    if (is_first)
+    {
+        reply.is_streamed = true;
+        reply.set_keep_alive(keep_alive);
+        if (stream_compression != http::no_compression)
+        {
+            reply.content_encoding =
+                stream_compression == http::gzip_rfc1952 ? "gzip" : "deflate";
+        }
+        buffers.push_back(reply.to_buffers()[0]);
+    }
+
+    const char *body = data;
+    std::size_t body_size = size;
+    if (stream_compression != http::no_compression)
+    {
+        thread_local DeflateStream gzip_stream(GZIP_WINDOW_BITS);
+        thread_local DeflateStream deflate_stream(DEFLATE_WINDOW_BITS);
+        auto &stream = http::gzip_rfc1952 == stream_compression ? gzip_stream : deflate_stream;
+        stream.CompressPart(data, size, is_first, is_last, compressed_output);
+        body = compressed_output.data();
+        body_size = compressed_output.size();
+    }
+
+    // an empty chunk would end the body
+    if (body_size > 0)
+    {
+        std::ostringstream size_line;
+        size_line << std::hex << body_size << "\r\n";
+        chunk_header = size_line.str();
+        buffers.push_back(boost::asio::buffer(chunk_header));
+        buffers.push_back(boost::asio::buffer(body, body_size));
+        buffers.push_back(boost::asio::buffer(CHUNK_END, sizeof(CHUNK_END) - 1));
+    }
+
+    boost::system::error_code error;
+    boost::asio::write(stream_socket, buffers, error);
+    stream_failed = static_cast<bool>(error);
+    return !stream_failed;
+}
+
+bool Connection::finish_stream()
+{
+    if (stream_failed)
+    {
+        return false;
+    }
+
+    // the compressed stream is closed with its trailer in a chunk of its own
+    if (stream_compression != http::no_compression &&
+        !write_chunk(current_reply, nullptr, 0, true))
+    {
+        return false;
+    }
+
+    boost::system::error_code error;
+    boost::asio::write(
+        stream_socket, boost::asio::buffer(LAST_CHUNK, sizeof(LAST_CHUNK) - 1), error);
+    return !error;
+}
+
+void Connection::write_reply()
+{
+    // write result to stream
+    boost::asio::async_write(stream_socket,
+                             output_buffer,
+                             strand.wrap(boost::bind(&Connection::handle_write,
+                                                     this->shared_from_this(),
+                                                     boost::asio::placeholders::error)));
+}
+
 /// Handle completion of a write operation.
 void Connection::handle_write(const boost::system::error_code &error)
 {
-    if (!error)
+    if (error)
+    {
+        return;
+    }
+
+    if (!keep_alive)
     {
         // Initiate graceful connection closure.
         boost::system::error_code ignore_error;
-        TCP_socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignore_error);
+        stream_socket.shutdown(boost::asio::socket_base::shutdown_both, ignore_error);
+        return;
+    }
+
+    // start over for the next request on the connection
+    current_request = http::request();
+    current_reply = http::reply();
+    request_parser = RequestParser();
+    compressed_output.clear();
+    output_buffer.fill(boost::asio::const_buffer());
+
+    if (pending_begin != pending_end)
+    {
+        process(pending_begin, pending_end);
+    }
+    else
+    {
+        read();
     }
 }
 
-std::vector<char> Connection::compress_buffers(const std::vector<char> &uncompressed_data,
-                                               const http::compression_type compression_type)
+void Connection::handle_timeout(const boost::system::error_code &error)
 {
-    boost::iostreams::gzip_params compression_parameters;
-
-    // there's a trade-off between speed and size. speed wins
-    compression_parameters.level = boost::iostreams::zlib::best_speed;
-    // check which compression flavor is used
-    if (http::deflate_rfc1951 == compression_type)
+    if (error != boost::asio::error::operation_aborted)
     {
-        compression_parameters.noheader = true;
+        // aborts the pending read, which releases the connection
+        boost::system::error_code ignore_error;
+        stream_socket.close(ignore_error);
     }
+}
 
-    std::vector<char> compressed_data;
-    // plug data into boost's compression stream
-    boost::iostreams::filtering_ostream gzip_stream;
-    gzip_stream.push(boost::iostreams::gzip_compressor(compression_parameters));
-    gzip_stream.push(boost::iostreams::back_inserter(compressed_data));
-    gzip_stream.write(&uncompressed_data[0], uncompressed_data.size());
-    boost::iostreams::close(gzip_stream);
+void Connection::compress_buffers(const std::vector<char> &uncompressed_data,
+                                  const http::compression_type compression_type,
+                                  std::vector<char> &compressed_data)
+{
+    BOOST_ASSERT(compression_type != http::no_compression);
+    thread_local DeflateStream gzip_stream(GZIP_WINDOW_BITS);
+    thread_local DeflateStream deflate_stream(DEFLATE_WINDOW_BITS);
 
-    return compressed_data;
+    const auto start = std::chrono::steady_clock::now();
+    auto &stream = http::gzip_rfc1952 == compression_type ? gzip_stream : deflate_stream;
+    OSRM_TRACEPOINT1(compress__start, uncompressed_data.size());
+    stream.Compress(uncompressed_data, compressed_data);
+    OSRM_TRACEPOINT1(compress__done, compressed_data.size());
+
+    util::QueryMetrics::Service service;
+    if (getService(current_request.uri, service))
+    {
+        util::QueryMetrics::GetInstance().Record(service,
+                                                 util::QueryMetrics::Phase::Compression,
+                                                 std::chrono::steady_clock::now() - start);
+    }
 }
 }
 }
@@ -13,54 +13,93 @@ const char ok_html[] = "";
 const char bad_request_html[] = "";
 const char internal_server_error_html[] =
     "{\"code\": \"InternalError\",\"message\":\"Internal Server Error\"}";
-const char seperators[] = {':', ' '};
-const char crlf[] = {'\r', '\n'};
-const std::string http_ok_string = "HTTP/1.0 200 OK\r\n";
-const std::string http_bad_request_string = "HTTP/1.0 400 Bad Request\r\n";
-const std::string http_internal_server_error_string = "HTTP/1.0 500 Internal Server Error\r\n";
+const char too_many_requests_html[] =
+    "{\"code\": \"TooManyRequests\",\"message\":\"Too many requests, try again later\"}";
+const char http_ok_string[] = "HTTP/1.1 200 OK\r\n";
+const char http_bad_request_string[] = "HTTP/1.1 400 Bad Request\r\n";
+const char http_too_many_requests_string[] = "HTTP/1.1 429 Too Many Requests\r\n";
+const char http_internal_server_error_string[] = "HTTP/1.1 500 Internal Server Error\r\n";
+const char http_service_unavailable_string[] = "HTTP/1.1 503 Service Unavailable\r\n";
 
-void reply::set_size(const std::size_t size)
+// the CORS headers start the common headers of the replies of the services
+const char json_headers[] = "Access-Control-Allow-Origin: *\r\n"
+                            "Access-Control-Allow-Methods: GET, POST\r\n"
+                            "Access-Control-Allow-Headers: X-Requested-With, Content-Type\r\n"
+                            "Content-Type: application/json; charset=UTF-8\r\n"
+                            "Content-Disposition: inline; filename=\"response.json\"\r\n";
+const char protobuf_headers[] = "Access-Control-Allow-Origin: *\r\n"
+                                "Access-Control-Allow-Methods: GET, POST\r\n"
+                                "Access-Control-Allow-Headers: X-Requested-With, Content-Type\r\n"
+                                "Content-Type: application/x-protobuf\r\n";
+const char html_headers[] = "Access-Control-Allow-Origin: *\r\nContent-Type: text/html\r\n";
+
+namespace
+{
+const char *statusLine(const reply::status_type status)
 {
-    for (header &h : headers)
+    switch (status)
     {
-        if ("Content-Length" == h.name)
-        {
-            h.value = std::to_string(size);
-        }
+    case reply::ok:
+        return http_ok_string;
+    case reply::internal_server_error:
+        return http_internal_server_error_string;
+    case reply::too_many_requests:
+        return http_too_many_requests_string;
+    case reply::service_unavailable:
+        return http_service_unavailable_string;
+    default:
+        return http_bad_request_string;
     }
 }
 
-void reply::set_uncompressed_size() { set_size(content.size()); }
-
-std::vector<boost::asio::const_buffer> reply::to_buffers()
+const char *staticHeaders(const reply::static_headers headers)
 {
-    std::vector<boost::asio::const_buffer> buffers;
-    buffers.push_back(status_to_buffer(status));
-    for (const header &h : headers)
+    switch (headers)
     {
-        buffers.push_back(boost::asio::buffer(h.name));
-        buffers.push_back(boost::asio::buffer(seperators));
-        buffers.push_back(boost::asio::buffer(h.value));
-        buffers.push_back(boost::asio::buffer(crlf));
+    case reply::static_headers::json:
+        return json_headers;
+    case reply::static_headers::protobuf:
+        return protobuf_headers;
+    case reply::static_headers::html:
+        return html_headers;
+    default:
+        return "";
     }
-    buffers.push_back(boost::asio::buffer(crlf));
-    buffers.push_back(boost::asio::buffer(content));
-    return buffers;
 }
+}
+
+std::array<boost::asio::const_buffer, 2> reply::to_buffers() { return to_buffers(content); }
 
-std::vector<boost::asio::const_buffer> reply::headers_to_buffers()
+std::array<boost::asio::const_buffer, 2> reply::to_buffers(const std::vector<char> &body)
 {
-    std::vector<boost::asio::const_buffer> buffers;
-    buffers.push_back(status_to_buffer(status));
+    header_block.clear();
+    header_block += statusLine(status);
+    header_block += staticHeaders(common_headers);
     for (const header &current_header : headers)
     {
-        buffers.push_back(boost::asio::buffer(current_header.name));
-        buffers.push_back(boost::asio::buffer(seperators));
-        buffers.push_back(boost::asio::buffer(current_header.value));
-        buffers.push_back(boost::asio::buffer(crlf));
+        header_block += current_header.name;
+        header_block += ": ";
+        header_block += current_header.value;
+        header_block += "\r\n";
+    }
+    if (content_encoding)
+    {
+        header_block += "Content-Encoding: ";
+        header_block += content_encoding;
+        header_block += "\r\n";
+    }
+    if (is_streamed)
+    {
+        header_block += "Transfer-Encoding: chunked";
+    }
+    else
+    {
+        header_block += "Content-Length: ";
+        header_block += std::to_string(body.size());
     }
-    buffers.push_back(boost::asio::buffer(crlf));
-    return buffers;
+    header_block += keep_alive ? "\r\nConnection: keep-alive\r\n\r\n"
+                               : "\r\nConnection: close\r\n\r\n";
+    return {{boost::asio::buffer(header_block), boost::asio::buffer(body)}};
 }
 
 reply reply::stock_reply(const reply::status_type status)
@@ -71,9 +110,7 @@ reply reply::stock_reply(const reply::status_type status)
 
     const std::string status_string = reply.status_to_string(status);
     reply.content.insert(reply.content.end(), status_string.begin(), status_string.end());
-    reply.headers.emplace_back("Access-Control-Allow-Origin", "*");
-    reply.headers.emplace_back("Content-Length", std::to_string(reply.content.size()));
-    reply.headers.emplace_back("Content-Type", "text/html");
+    reply.common_headers = static_headers::html;
     return reply;
 }
 
@@ -87,26 +124,20 @@ std::string reply::status_to_string(const reply::status_type status)
     {
         return bad_request_html;
     }
-    return internal_server_error_html;
-}
-
-boost::asio::const_buffer reply::status_to_buffer(const reply::status_type status)
-{
-    if (reply::ok == status)
-    {
-        return boost::asio::buffer(http_ok_string);
-    }
-    if (reply::internal_server_error == status)
+    if (reply::too_many_requests == status)
     {
-        return boost::asio::buffer(http_internal_server_error_string);
+        return too_many_requests_html;
     }
-    return boost::asio::buffer(http_bad_request_string);
+    return internal_server_error_html;
 }
 
-reply::reply() : status(ok)
+void reply::set_keep_alive(const bool keep_alive_) { keep_alive = keep_alive_; }
+
+// connections are closed unless the connection decides to keep them
+reply::reply()
+    : status(ok), common_headers(static_headers::none), is_gzipped(false),
+      content_encoding(nullptr), is_streamed(false), keep_alive(false)
 {
-    // We do not currently support keep alive. Always set 'Connection: close'.
-    headers.emplace_back("Connection", "close");
 }
 }
 }
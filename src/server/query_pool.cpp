@@ -0,0 +1,104 @@
+#include "server/query_pool.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace osrm
+{
+namespace server
+{
+
+QueryPool::QueryPool(const unsigned number_of_threads, const std::size_t max_queued_queries_)
+    : max_queued_queries(max_queued_queries_),
+      max_running_heavy_queries(std::max(1u, number_of_threads - number_of_threads / 4)),
+      running_heavy_queries(0), stopping(false)
+{
+    BOOST_ASSERT(number_of_threads > 0);
+    for (unsigned index = 0; index < number_of_threads; ++index)
+    {
+        threads.emplace_back([this] { Work(); });
+    }
+}
+
+QueryPool::~QueryPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    has_work.notify_all();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+bool QueryPool::Submit(const Priority priority, std::function<void()> query)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &queue = queues[static_cast<std::size_t>(priority)];
+        if (queue.size() >= max_queued_queries)
+        {
+            return false;
+        }
+        queue.push_back(std::move(query));
+    }
+    has_work.notify_one();
+    return true;
+}
+
+QueryPool::Priority QueryPool::GetPriority(const std::string &uri)
+{
+    const auto begin = uri.find_first_not_of('/');
+    const auto end = uri.find('/', begin);
+    if (begin == std::string::npos)
+    {
+        return Priority::heavy;
+    }
+    const auto service = uri.substr(begin, end == std::string::npos ? end : end - begin);
+    return service == "nearest" || service == "route" ? Priority::cheap : Priority::heavy;
+}
+
+void QueryPool::Work()
+{
+    auto &cheap_queries = queues[static_cast<std::size_t>(Priority::cheap)];
+    auto &heavy_queries = queues[static_cast<std::size_t>(Priority::heavy)];
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        has_work.wait(lock, [&] {
+            return stopping || !cheap_queries.empty() ||
+                   (!heavy_queries.empty() && running_heavy_queries < max_running_heavy_queries);
+        });
+        if (stopping)
+        {
+            return;
+        }
+
+        const bool is_heavy = cheap_queries.empty();
+        auto &queue = is_heavy ? heavy_queries : cheap_queries;
+        auto query = std::move(queue.front());
+        queue.pop_front();
+        if (is_heavy)
+        {
+            ++running_heavy_queries;
+        }
+
+        lock.unlock();
+        query();
+        lock.lock();
+
+        if (is_heavy)
+        {
+            --running_heavy_queries;
+            // frees a slot for the heavy queries that wait
+            has_work.notify_one();
+        }
+    }
+}
+}
+}
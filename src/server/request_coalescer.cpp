@@ -0,0 +1,108 @@
+#include "server/request_coalescer.hpp"
+
+#include <boost/assert.hpp>
+
+#include <utility>
+
+namespace osrm
+{
+namespace server
+{
+
+RequestCoalescer::Ticket::Ticket(RequestCoalescer &coalescer_,
+                                 std::string key_,
+                                 std::shared_ptr<Flight> flight_,
+                                 const bool is_computing_)
+    : coalescer(&coalescer_), key(std::move(key_)), flight(std::move(flight_)),
+      is_computing(is_computing_)
+{
+}
+
+RequestCoalescer::Ticket::Ticket(Ticket &&other) noexcept { *this = std::move(other); }
+
+RequestCoalescer::Ticket &RequestCoalescer::Ticket::operator=(Ticket &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (IsComputing())
+        {
+            Complete(nullptr);
+        }
+        coalescer = other.coalescer;
+        key = std::move(other.key);
+        flight = std::move(other.flight);
+        is_computing = other.is_computing;
+        other.coalescer = nullptr;
+    }
+    return *this;
+}
+
+RequestCoalescer::Ticket::~Ticket()
+{
+    if (IsComputing())
+    {
+        Complete(nullptr);
+    }
+}
+
+bool RequestCoalescer::Ticket::Wait(http::reply &reply)
+{
+    BOOST_ASSERT(coalescer && !is_computing);
+    std::shared_ptr<const http::reply> computed_reply;
+    {
+        std::unique_lock<std::mutex> lock(flight->mutex);
+        flight->finished.wait(lock, [this] { return flight->is_finished; });
+        computed_reply = flight->reply;
+    }
+    coalescer = nullptr;
+    if (!computed_reply)
+    {
+        return false;
+    }
+    reply = *computed_reply;
+    return true;
+}
+
+void RequestCoalescer::Ticket::Finish(const http::reply &reply)
+{
+    BOOST_ASSERT(IsComputing());
+    Complete(std::make_shared<const http::reply>(reply));
+}
+
+void RequestCoalescer::Ticket::Complete(std::shared_ptr<const http::reply> reply)
+{
+    // requests that join from now on compute their own reply
+    {
+        std::lock_guard<std::mutex> lock(coalescer->mutex);
+        coalescer->flights.erase(key);
+    }
+    {
+        std::lock_guard<std::mutex> lock(flight->mutex);
+        flight->reply = std::move(reply);
+        flight->is_finished = true;
+    }
+    flight->finished.notify_all();
+    coalescer = nullptr;
+}
+
+RequestCoalescer::Ticket RequestCoalescer::Join(const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &flight = flights[key];
+    if (flight)
+    {
+        ++coalesced;
+        return Ticket(*this, key, flight, false);
+    }
+    ++computed;
+    flight = std::make_shared<Flight>();
+    return Ticket(*this, key, flight, true);
+}
+
+RequestCoalescer::Statistics RequestCoalescer::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return Statistics{computed, coalesced};
+}
+}
+}
@@ -1,15 +1,20 @@
 #include "server/request_handler.hpp"
 #include "server/service_handler.hpp"
 
+#include "server/api/parameters_parser.hpp"
 #include "server/api/url_parser.hpp"
 #include "server/http/reply.hpp"
 #include "server/http/request.hpp"
 
 #include "util/json_renderer.hpp"
+#include "util/query_metrics.hpp"
 #include "util/simple_logger.hpp"
 #include "util/string_util.hpp"
+#include "util/tracepoint.hpp"
 #include "util/typedefs.hpp"
+#include "util/web_mercator.hpp"
 
+#include "engine/api/tile_parameters.hpp"
 #include "engine/status.hpp"
 #include "osrm/osrm.hpp"
 #include "util/json_container.hpp"
@@ -21,6 +26,8 @@
 #include <ctime>
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <iterator>
 #include <string>
@@ -30,14 +37,232 @@ namespace osrm
 namespace server
 {
 
-void RequestHandler::RegisterServiceHandler(std::unique_ptr<ServiceHandler> service_handler_)
+namespace
 {
-    service_handler = std::move(service_handler_);
+// GET /stats reports how well the response cache works
+const constexpr char STATISTICS_URI[] = "/stats";
+// GET /metrics reports the latencies of the queries for Prometheus
+const constexpr char METRICS_URI[] = "/metrics";
+// GET /health answers 503 until the data is warmed up, for load balancers to wait for
+const constexpr char HEALTH_URI[] = "/health";
+
+// tiles below the zoom level aren't served, see the tile plugin
+const constexpr unsigned MIN_TILE_ZOOM = 12;
+
+// marks the end of a request for tracers, on every way out of HandleRequest
+struct RequestTrace
+{
+    explicit RequestTrace(const http::reply &reply_) : reply(reply_) {}
+    ~RequestTrace()
+    {
+        OSRM_TRACEPOINT2(request__done, static_cast<int>(reply.status), reply.content.size());
+    }
+
+    const http::reply &reply;
+};
+
+util::json::Object makeStatistics(const ResponseCache *response_cache,
+                                  const TileStore *tile_store)
+{
+    util::json::Object statistics;
+    if (response_cache)
+    {
+        const auto cache_statistics = response_cache->GetStatistics();
+        util::json::Object cache;
+        cache.values["replies"] = cache_statistics.number_of_replies;
+        cache.values["size"] = cache_statistics.size;
+        cache.values["capacity"] = cache_statistics.capacity;
+        cache.values["ttl"] = cache_statistics.time_to_live.count();
+        cache.values["hits"] = cache_statistics.hits;
+        cache.values["misses"] = cache_statistics.misses;
+        cache.values["evictions"] = cache_statistics.evictions;
+        statistics.values["response_cache"] = std::move(cache);
+    }
+    if (tile_store)
+    {
+        const auto store_statistics = tile_store->GetStatistics();
+        util::json::Object store;
+        store.values["tiles"] = store_statistics.number_of_tiles;
+        store.values["size"] = store_statistics.size;
+        store.values["capacity"] = store_statistics.capacity;
+        store.values["hits"] = store_statistics.hits;
+        store.values["disk_hits"] = store_statistics.disk_hits;
+        store.values["misses"] = store_statistics.misses;
+        statistics.values["tile_store"] = std::move(store);
+    }
+    return statistics;
+}
+
+// The parameters of a tile query that is valid and can be served from the tile store
+bool getTileParameters(api::ParsedURL &parsed_url, engine::api::TileParameters &parameters)
+{
+    if (parsed_url.service != "tile")
+    {
+        return false;
+    }
+    auto iter = parsed_url.query.begin();
+    auto maybe_parameters =
+        api::parseParameters<engine::api::TileParameters>(iter, parsed_url.query.end());
+    if (!maybe_parameters || iter != parsed_url.query.end() || !maybe_parameters->IsValid() ||
+        maybe_parameters->z < MIN_TILE_ZOOM)
+    {
+        return false;
+    }
+    parameters = *maybe_parameters;
+    return true;
+}
+
+// The range of tiles of a zoom level that covers the coordinates from west to east or from north
+// to south, clamped to the tiles that exist
+void getTileRange(const double min_pixel,
+                  const double max_pixel,
+                  const unsigned zoom,
+                  unsigned &first_tile,
+                  unsigned &last_tile)
+{
+    const auto max_tile = (1u << zoom) - 1;
+    const auto toTile = [&](const double pixel) {
+        const auto tile = std::floor(pixel / util::web_mercator::TILE_SIZE);
+        return static_cast<unsigned>(std::max(0., std::min<double>(max_tile, tile)));
+    };
+    first_tile = toTile(min_pixel);
+    last_tile = toTile(max_pixel);
+}
+
+// Serves a stored tile or renders and stores it
+engine::Status getTile(ServiceHandlerInterface &service_handler,
+                       TileStore &tile_store,
+                       const engine::api::TileParameters &parameters,
+                       TileStore::Tile &tile)
+{
+    // taken before the query, like for the response cache
+    const auto checksum = service_handler.GetCheckSum();
+    const auto data_version = service_handler.GetDataVersion();
+    tile = tile_store.Get(checksum, data_version, parameters.z, parameters.x, parameters.y);
+    if (tile)
+    {
+        return engine::Status::Ok;
+    }
+
+    std::string rendered_tile;
+    const auto status = service_handler.RunTileQuery(parameters, rendered_tile);
+    if (status == engine::Status::Ok)
+    {
+        tile = tile_store.Add(
+            checksum, data_version, parameters.z, parameters.x, parameters.y, rendered_tile);
+    }
+    return status;
+}
+}
+
+void RequestHandler::RegisterServiceHandler(
+    std::unique_ptr<ServiceHandlerInterface> service_handler, const std::string &profile)
+{
+    datasets[profile].service_handler = std::move(service_handler);
+}
+
+void RequestHandler::RegisterResponseCache(std::unique_ptr<ResponseCache> response_cache,
+                                           const std::string &profile)
+{
+    datasets[profile].response_cache = std::move(response_cache);
+}
+
+void RequestHandler::RegisterTileStore(std::unique_ptr<TileStore> tile_store,
+                                       const std::string &profile)
+{
+    datasets[profile].tile_store = std::move(tile_store);
+}
+
+RequestHandler::Dataset *RequestHandler::FindDataset(const std::string &profile)
+{
+    if (datasets.size() == 1)
+    {
+        return &datasets.begin()->second;
+    }
+    const auto iter = datasets.find(profile);
+    return iter == datasets.end() ? nullptr : &iter->second;
+}
+
+std::size_t RequestHandler::PrerenderTiles(const util::Coordinate south_west,
+                                           const util::Coordinate north_east,
+                                           const unsigned max_zoom)
+{
+    std::size_t number_of_tiles = 0;
+    for (auto &dataset : datasets)
+    {
+        if (dataset.second.tile_store)
+        {
+            number_of_tiles += PrerenderTiles(*dataset.second.service_handler,
+                                              *dataset.second.tile_store,
+                                              south_west,
+                                              north_east,
+                                              max_zoom);
+        }
+    }
+    return number_of_tiles;
+}
+
+std::size_t RequestHandler::PrerenderTiles(ServiceHandlerInterface &service_handler,
+                                           TileStore &tile_store,
+                                           const util::Coordinate south_west,
+                                           const util::Coordinate north_east,
+                                           const unsigned max_zoom)
+{
+    std::size_t number_of_tiles = 0;
+    for (unsigned zoom = MIN_TILE_ZOOM; zoom <= max_zoom; ++zoom)
+    {
+        // pixels grow to the east and to the south
+        unsigned min_x, max_x, min_y, max_y;
+        getTileRange(util::web_mercator::degreeToPixel(util::toFloating(south_west.lon), zoom),
+                     util::web_mercator::degreeToPixel(util::toFloating(north_east.lon), zoom),
+                     zoom,
+                     min_x,
+                     max_x);
+        getTileRange(util::web_mercator::degreeToPixel(util::toFloating(north_east.lat), zoom),
+                     util::web_mercator::degreeToPixel(util::toFloating(south_west.lat), zoom),
+                     zoom,
+                     min_y,
+                     max_y);
+
+        for (unsigned x = min_x; x <= max_x; ++x)
+        {
+            for (unsigned y = min_y; y <= max_y; ++y)
+            {
+                TileStore::Tile tile;
+                const engine::api::TileParameters parameters{x, y, zoom};
+                if (getTile(service_handler, tile_store, parameters, tile) == engine::Status::Ok)
+                {
+                    ++number_of_tiles;
+                }
+            }
+        }
+    }
+    return number_of_tiles;
+}
+
+void RequestHandler::RegisterAccessLog(std::unique_ptr<AccessLog> access_log_)
+{
+    access_log = std::move(access_log_);
+}
+
+void RequestHandler::RegisterRequestCoalescer(std::unique_ptr<RequestCoalescer> request_coalescer_)
+{
+    request_coalescer = std::move(request_coalescer_);
+}
+
+void RequestHandler::SetStreamedTableEntries(const std::size_t min_entries)
+{
+    streamed_table_entries = min_entries;
 }
 
-void RequestHandler::HandleRequest(const http::request &current_request, http::reply &current_reply)
+void RequestHandler::HandleRequest(const http::request &current_request,
+                                   http::reply &current_reply,
+                                   ReplyStream *stream)
 {
-    if (!service_handler)
+    const auto start = std::chrono::steady_clock::now();
+    OSRM_TRACEPOINT1(request__start, current_request.uri.c_str());
+    const RequestTrace trace(current_reply);
+    if (datasets.empty())
     {
         current_reply = http::reply::stock_reply(http::reply::internal_server_error);
         util::SimpleLogger().Write(logWARNING) << "No service handler registered." << std::endl;
@@ -48,20 +273,177 @@ void RequestHandler::HandleRequest(const http::request &current_request, http::r
     try
     {
         std::string request_string;
-        util::URIDecode(current_request.uri, request_string);
+        if (current_request.body.empty())
+        {
+            util::URIDecode(current_request.uri, request_string);
+        }
+        else
+        {
+            // POST /route/v1/driving with the coordinates and options as the body
+            std::string uri = current_request.uri;
+            if (uri.empty() || uri.back() != '/')
+            {
+                uri.push_back('/');
+            }
+            uri += current_request.body;
+            // bodies sent from a file often end with a newline
+            while (uri.back() == '\n' || uri.back() == '\r')
+            {
+                uri.pop_back();
+            }
+            util::URIDecode(uri, request_string);
+        }
         util::SimpleLogger().Write(logDEBUG) << "req: " << request_string;
 
+        // scraped every few seconds, which isn't worth the access log
+        if (request_string == METRICS_URI)
+        {
+            std::string metrics;
+            util::QueryMetrics::GetInstance().Render(metrics);
+            current_reply.content.assign(metrics.begin(), metrics.end());
+            current_reply.headers.emplace_back("Content-Type", "text/plain; version=0.0.4");
+            return;
+        }
+        if (request_string == HEALTH_URI)
+        {
+            const bool is_ready =
+                std::all_of(datasets.begin(),
+                            datasets.end(),
+                            [](const std::pair<const std::string, Dataset> &profile) {
+                                return profile.second.service_handler->IsReady();
+                            });
+            const std::string status = is_ready ? "ok\n" : "warming up\n";
+            current_reply.status = is_ready ? http::reply::ok : http::reply::service_unavailable;
+            current_reply.content.assign(status.begin(), status.end());
+            current_reply.headers.emplace_back("Content-Type", "text/plain");
+            return;
+        }
+
         auto api_iterator = request_string.begin();
         auto maybe_parsed_url = api::parseURL(api_iterator, request_string.end());
-        ServiceHandler::ResultT result;
+        const bool is_valid_url = maybe_parsed_url && api_iterator == request_string.end();
+        Dataset *const dataset = is_valid_url ? FindDataset(maybe_parsed_url->profile) : nullptr;
+        ServiceHandlerInterface::ResultT result;
+        // set if the reply is to be cached, or came from the cache
+        std::string cache_key;
+        unsigned checksum = 0;
+        unsigned data_version = 0;
+        std::uint64_t traffic_overlay_version = 0;
+        // set if the reply came from the cache or from another request
+        bool is_cached = false;
+        // set if another request computes the same reply right now, or this one does for others
+        RequestCoalescer::Ticket coalescing_ticket;
+        // set if the reply is a compressed tile of the tile store
+        TileStore::Tile stored_tile;
+        // the rendering of the JSON is measured for the known services only
+        util::QueryMetrics::Service metrics_service;
+        bool has_metrics_service = false;
 
-        // check if the was an error with the request
-        if (maybe_parsed_url && api_iterator == request_string.end())
+        if (request_string == STATISTICS_URI)
         {
+            if (datasets.size() == 1)
+            {
+                const auto &single = datasets.begin()->second;
+                result = makeStatistics(single.response_cache.get(), single.tile_store.get());
+            }
+            else
+            {
+                util::json::Object profiles;
+                for (const auto &profile : datasets)
+                {
+                    profiles.values[profile.first] = makeStatistics(
+                        profile.second.response_cache.get(), profile.second.tile_store.get());
+                }
+                result = util::json::Object();
+                result.get<util::json::Object>().values["profiles"] = std::move(profiles);
+            }
+            if (request_coalescer)
+            {
+                const auto coalescer_statistics = request_coalescer->GetStatistics();
+                util::json::Object coalescer;
+                coalescer.values["computed"] = coalescer_statistics.computed;
+                coalescer.values["coalesced"] = coalescer_statistics.coalesced;
+                result.get<util::json::Object>().values["request_coalescer"] =
+                    std::move(coalescer);
+            }
+            result.get<util::json::Object>().values["code"] = "Ok";
+        }
+        else if (is_valid_url && !dataset)
+        {
+            current_reply.status = http::reply::bad_request;
+            result = util::json::Object();
+            auto &json_result = result.get<util::json::Object>();
+            json_result.values["code"] = "InvalidUrl";
+            json_result.values["message"] =
+                "Profile " + maybe_parsed_url->profile + " is not served";
+        }
+        else if (is_valid_url)
+        {
+            auto &service_handler = dataset->service_handler;
+            auto &response_cache = dataset->response_cache;
+            auto &tile_store = dataset->tile_store;
+            const bool is_cacheable =
+                response_cache && ResponseCache::IsCacheable(maybe_parsed_url->service);
+            if (is_cacheable || request_coalescer)
+            {
+                // taken before the query, so a reply computed on new data is dropped afterwards
+                checksum = service_handler->GetCheckSum();
+                data_version = service_handler->GetDataVersion();
+                traffic_overlay_version = service_handler->GetTrafficOverlayVersion();
+            }
+            if (is_cacheable)
+            {
+                cache_key = ResponseCache::MakeKey(request_string);
+                is_cached = response_cache->Get(
+                    checksum, data_version, traffic_overlay_version, cache_key, current_reply);
+            }
+            has_metrics_service =
+                util::QueryMetrics::GetService(maybe_parsed_url->service, metrics_service);
+
+            engine::api::TileParameters tile_parameters;
+            const bool is_stored_tile =
+                tile_store && getTileParameters(*maybe_parsed_url, tile_parameters);
+            if (is_stored_tile)
+            {
+                result = std::string();
+            }
+
+            // the tile store renders a tile once by itself
+            if (request_coalescer && !is_cached && !is_stored_tile)
+            {
+                coalescing_ticket = request_coalescer->Join(
+                    std::to_string(checksum) + "/" + std::to_string(data_version) + "/" +
+                    std::to_string(traffic_overlay_version) + "/" +
+                    (cache_key.empty() ? ResponseCache::MakeKey(request_string) : cache_key));
+                // a failed computation leaves the waiting requests to compute their own replies
+                is_cached =
+                    !coalescing_ticket.IsComputing() && coalescing_ticket.Wait(current_reply);
+            }
+
+            // large tables are sent while they are computed, they are neither cached nor shared
+            if (!is_cached && !is_stored_tile && stream && current_request.chunked_encoding &&
+                streamed_table_entries > 0 && maybe_parsed_url->service == "table")
+            {
+                result = service::StreamedJSON{
+                    [&current_reply, stream](const char *data, const std::size_t size) {
+                        current_reply.common_headers = http::reply::static_headers::json;
+                        return stream->Write(current_reply, data, size);
+                    },
+                    streamed_table_entries};
+            }
 
             const engine::Status status =
-                service_handler->RunQuery(*std::move(maybe_parsed_url), result);
-            if (status != engine::Status::Ok)
+                is_cached
+                    ? engine::Status::Ok
+                    : is_stored_tile
+                          ? getTile(*service_handler, *tile_store, tile_parameters, stored_tile)
+                          : service_handler->RunQuery(*std::move(maybe_parsed_url), result);
+            if (status == engine::Status::Timeout)
+            {
+                // the query ran longer than --max-query-time, which is no fault of the request
+                current_reply.status = http::reply::service_unavailable;
+            }
+            else if (status != engine::Status::Ok)
             {
                 // 4xx bad request return code
                 current_reply.status = http::reply::bad_request;
@@ -91,67 +473,82 @@ void RequestHandler::HandleRequest(const http::request &current_request, http::r
                                             std::to_string(position) + ": \"" + context + "\"";
         }
 
-        current_reply.headers.emplace_back("Access-Control-Allow-Origin", "*");
-        current_reply.headers.emplace_back("Access-Control-Allow-Methods", "GET");
-        current_reply.headers.emplace_back("Access-Control-Allow-Headers",
-                                           "X-Requested-With, Content-Type");
-        if (result.is<util::json::Object>())
+        if (!is_cached && !current_reply.is_streamed)
         {
-            current_reply.headers.emplace_back("Content-Type", "application/json; charset=UTF-8");
-            current_reply.headers.emplace_back("Content-Disposition",
-                                               "inline; filename=\"response.json\"");
+            if (result.is<util::json::Object>())
+            {
+                current_reply.common_headers = http::reply::static_headers::json;
 
-            util::json::render(current_reply.content, result.get<util::json::Object>());
-        }
-        else
-        {
-            BOOST_ASSERT(result.is<std::string>());
-            current_reply.content.resize(result.get<std::string>().size());
-            std::copy(result.get<std::string>().cbegin(),
-                      result.get<std::string>().cend(),
-                      current_reply.content.begin());
+                const auto render_start = std::chrono::steady_clock::now();
+                OSRM_TRACEPOINT(render__start);
+                util::json::render(current_reply.content, result.get<util::json::Object>());
+                OSRM_TRACEPOINT1(render__done, current_reply.content.size());
+                if (has_metrics_service)
+                {
+                    util::QueryMetrics::GetInstance().Record(
+                        metrics_service,
+                        util::QueryMetrics::Phase::Rendering,
+                        std::chrono::steady_clock::now() - render_start);
+                }
+            }
+            else if (result.is<service::RenderedJSON>())
+            {
+                current_reply.common_headers = http::reply::static_headers::json;
 
-            current_reply.headers.emplace_back("Content-Type", "application/x-protobuf");
-        }
+                const auto &rendered = result.get<service::RenderedJSON>().value;
+                current_reply.content.assign(rendered.begin(), rendered.end());
+            }
+            else if (stored_tile)
+            {
+                current_reply.content.assign(stored_tile->begin(), stored_tile->end());
+                current_reply.is_gzipped = true;
+                current_reply.common_headers = http::reply::static_headers::protobuf;
+            }
+            else
+            {
+                BOOST_ASSERT(result.is<std::string>());
+                current_reply.content.resize(result.get<std::string>().size());
+                std::copy(result.get<std::string>().cbegin(),
+                          result.get<std::string>().cend(),
+                          current_reply.content.begin());
 
-        // set headers
-        current_reply.headers.emplace_back("Content-Length",
-                                           std::to_string(current_reply.content.size()));
+                current_reply.common_headers = http::reply::static_headers::protobuf;
+            }
 
-        if (!std::getenv("DISABLE_ACCESS_LOGGING"))
+            if (!cache_key.empty() && current_reply.status == http::reply::ok)
+            {
+                dataset->response_cache->Add(
+                    checksum, data_version, traffic_overlay_version, cache_key, current_reply);
+            }
+            if (coalescing_ticket.IsComputing())
+            {
+                coalescing_ticket.Finish(current_reply);
+            }
+        }
+
+        if (access_log && access_log->IsSampled(current_reply.status))
         {
-            // deactivated as GCC apparently does not implement that, not even in 4.9
-            // std::time_t t = std::time(nullptr);
-            // util::SimpleLogger().Write() << std::put_time(std::localtime(&t), "%m-%d-%Y
-            // %H:%M:%S") <<
-            //     " " << current_request.endpoint.to_string() << " " <<
-            //     current_request.referrer << ( 0 == current_request.referrer.length() ? "- " :" ")
-            //     <<
-            //     current_request.agent << ( 0 == current_request.agent.length() ? "- " :" ") <<
-            //     request;
-
-            time_t ltime;
-            struct tm *time_stamp;
-
-            ltime = time(nullptr);
-            time_stamp = localtime(&ltime);
-            // log timestamp
-            util::SimpleLogger().Write()
-                << (time_stamp->tm_mday < 10 ? "0" : "") << time_stamp->tm_mday << "-"
-                << (time_stamp->tm_mon + 1 < 10 ? "0" : "") << (time_stamp->tm_mon + 1) << "-"
-                << 1900 + time_stamp->tm_year << " " << (time_stamp->tm_hour < 10 ? "0" : "")
-                << time_stamp->tm_hour << ":" << (time_stamp->tm_min < 10 ? "0" : "")
-                << time_stamp->tm_min << ":" << (time_stamp->tm_sec < 10 ? "0" : "")
-                << time_stamp->tm_sec << " " << current_request.endpoint.to_string() << " "
-                << current_request.referrer << (0 == current_request.referrer.length() ? "- " : " ")
-                << current_request.agent << (0 == current_request.agent.length() ? "- " : " ")
-                << current_reply.status << " " //
-                << request_string;
+            access_log->Add({std::time(nullptr),
+                             current_request.endpoint,
+                             current_request.referrer,
+                             current_request.agent,
+                             current_reply.status,
+                             std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::steady_clock::now() - start),
+                             std::move(request_string)});
         }
     }
     catch (const std::exception &e)
     {
-        current_reply = http::reply::stock_reply(http::reply::internal_server_error);
+        // the headers of a streamed reply are sent, the connection cuts it off instead
+        if (current_reply.is_streamed)
+        {
+            current_reply.status = http::reply::internal_server_error;
+        }
+        else
+        {
+            current_reply = http::reply::stock_reply(http::reply::internal_server_error);
+        }
         util::SimpleLogger().Write(logWARNING) << "[server error] code: " << e.what()
                                                << ", uri: " << current_request.uri;
     }
@@ -6,6 +6,7 @@
 
 #include <boost/algorithm/string/predicate.hpp>
 
+#include <algorithm>
 #include <string>
 
 namespace osrm
@@ -15,24 +16,73 @@ namespace server
 
 RequestParser::RequestParser()
     : state(internal_state::method_start), current_header({"", ""}),
-      selected_compression(http::no_compression)
+      selected_compression(http::no_compression), http_version_major(0), http_version_minor(0),
+      remaining_body_size(0), expects_continue(false), continue_expected(false)
 {
 }
 
-std::tuple<RequestParser::RequestStatus, http::compression_type>
+constexpr std::size_t RequestParser::MAX_BODY_SIZE;
+
+std::tuple<RequestParser::RequestStatus, http::compression_type, char *>
 RequestParser::parse(http::request &current_request, char *begin, char *end)
 {
     while (begin != end)
     {
-        RequestStatus result = consume(current_request, *begin++);
+        // the URI and the body make up most of a request and are copied as a whole
+        if (state == internal_state::uri)
+        {
+            const auto uri_end =
+                std::find_if(begin, end, [this](const char c) { return c == ' ' || is_CTL(c); });
+            current_request.uri.append(begin, uri_end);
+            begin = uri_end;
+            if (begin == end)
+            {
+                break;
+            }
+        }
+
+        RequestStatus result = RequestStatus::indeterminate;
+        if (state == internal_state::body)
+        {
+            const auto size = std::min<std::size_t>(end - begin, remaining_body_size);
+            current_request.body.append(begin, begin + size);
+            begin += size;
+            remaining_body_size -= size;
+            if (remaining_body_size == 0)
+            {
+                result = RequestStatus::valid;
+            }
+        }
+        else
+        {
+            result = consume(current_request, *begin++);
+        }
+
         if (result != RequestStatus::indeterminate)
         {
-            return std::make_tuple(result, selected_compression);
+            if (result == RequestStatus::valid)
+            {
+                // HTTP/1.1 connections are persistent unless closed, HTTP/1.0 ones the opposite
+                const bool http_1_1 =
+                    http_version_major > 1 || (http_version_major == 1 && http_version_minor >= 1);
+                current_request.keep_alive =
+                    http_1_1 ? !boost::icontains(connection, "close")
+                             : boost::icontains(connection, "keep-alive");
+                current_request.chunked_encoding = http_1_1;
+            }
+            return std::make_tuple(result, selected_compression, begin);
         }
     }
     RequestStatus result = RequestStatus::indeterminate;
 
-    return std::make_tuple(result, selected_compression);
+    return std::make_tuple(result, selected_compression, begin);
+}
+
+bool RequestParser::ContinueExpected()
+{
+    const bool expected = continue_expected;
+    continue_expected = false;
+    return expected;
 }
 
 RequestParser::RequestStatus RequestParser::consume(http::request &current_request,
@@ -50,7 +100,7 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
     case internal_state::method:
         if (input == ' ')
         {
-            state = internal_state::uri;
+            state = internal_state::uri_start;
             return RequestStatus::indeterminate;
         }
         if (!is_char(input) || is_CTL(input) || is_special(input))
@@ -59,7 +109,8 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
         }
         return RequestStatus::indeterminate;
     case internal_state::uri_start:
-        if (is_CTL(input))
+        // the URI can't be empty, the rest of it is copied as a whole by parse
+        if (input == ' ' || is_CTL(input))
         {
             return RequestStatus::invalid;
         }
@@ -116,6 +167,7 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
     case internal_state::http_version_major_start:
         if (is_digit(input))
         {
+            http_version_major = input - '0';
             state = internal_state::http_version_major;
             return RequestStatus::indeterminate;
         }
@@ -128,12 +180,14 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
         }
         if (is_digit(input))
         {
+            http_version_major = http_version_major * 10 + input - '0';
             return RequestStatus::indeterminate;
         }
         return RequestStatus::invalid;
     case internal_state::http_version_minor_start:
         if (is_digit(input))
         {
+            http_version_minor = input - '0';
             state = internal_state::http_version_minor;
             return RequestStatus::indeterminate;
         }
@@ -146,6 +200,7 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
         }
         if (is_digit(input))
         {
+            http_version_minor = http_version_minor * 10 + input - '0';
             return RequestStatus::indeterminate;
         }
         return RequestStatus::invalid;
@@ -180,6 +235,33 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
             current_request.agent = current_header.value;
         }
 
+        if (boost::iequals(current_header.name, "Connection"))
+        {
+            connection = current_header.value;
+        }
+
+        if (boost::iequals(current_header.name, "Content-Length"))
+        {
+            const auto &value = current_header.value;
+            if (value.empty() || value.size() > 10 ||
+                !std::all_of(value.begin(), value.end(), [this](const char c) {
+                    return is_digit(c);
+                }))
+            {
+                return RequestStatus::invalid;
+            }
+            remaining_body_size = std::stoull(value);
+            if (remaining_body_size > MAX_BODY_SIZE)
+            {
+                return RequestStatus::invalid;
+            }
+        }
+
+        if (boost::iequals(current_header.name, "Expect"))
+        {
+            expects_continue = boost::icontains(current_header.value, "100-continue");
+        }
+
         if (input == '\r')
         {
             state = internal_state::expecting_newline_3;
@@ -247,8 +329,21 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
             return RequestStatus::indeterminate;
         }
         return RequestStatus::invalid;
-    default: // expecting_newline_3
-        return input == '\n' ? RequestStatus::valid : RequestStatus::invalid;
+    case internal_state::expecting_newline_3:
+        if (input != '\n')
+        {
+            return RequestStatus::invalid;
+        }
+        if (remaining_body_size == 0)
+        {
+            return RequestStatus::valid;
+        }
+        state = internal_state::body;
+        current_request.body.reserve(remaining_body_size);
+        continue_expected = expects_continue;
+        return RequestStatus::indeterminate;
+    default: // body, which parse reads directly
+        return RequestStatus::invalid;
     }
 }
 
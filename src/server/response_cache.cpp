@@ -0,0 +1,114 @@
+#include "server/response_cache.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+
+ResponseCache::ResponseCache(const std::size_t capacity, const std::chrono::seconds time_to_live_)
+    : time_to_live(time_to_live_), cache(capacity, 1)
+{
+    BOOST_ASSERT(capacity > 0);
+}
+
+bool ResponseCache::IsCacheable(const std::string &service)
+{
+    return service == "route" || service == "table";
+}
+
+std::string ResponseCache::MakeKey(const std::string &request)
+{
+    // the query string starts at the first '?' outside of polyline(...) coordinates
+    int depth = 0;
+    const auto query_begin = std::find_if(request.begin(), request.end(), [&](const char c) {
+        depth += c == '(' ? 1 : c == ')' ? -1 : 0;
+        return c == '?' && depth <= 0;
+    });
+    if (query_begin == request.end())
+    {
+        return request;
+    }
+
+    std::vector<std::string> options;
+    for (auto option_begin = query_begin + 1;; ++option_begin)
+    {
+        const auto option_end = std::find(option_begin, request.end(), '&');
+        options.emplace_back(option_begin, option_end);
+        if (option_end == request.end())
+        {
+            break;
+        }
+        option_begin = option_end;
+    }
+
+    const auto getName = [](const std::string &option) {
+        return option.substr(0, option.find('='));
+    };
+    std::stable_sort(options.begin(), options.end(), [&](const std::string &lhs,
+                                                         const std::string &rhs) {
+        return getName(lhs) < getName(rhs);
+    });
+
+    std::string key(request.begin(), query_begin + 1);
+    for (const auto &option : options)
+    {
+        key += option;
+        key.push_back('&');
+    }
+    key.pop_back();
+    return key;
+}
+
+bool ResponseCache::Get(const unsigned checksum,
+                        const unsigned data_version,
+                        const std::uint64_t traffic_overlay_version,
+                        const std::string &key,
+                        http::reply &reply,
+                        const Clock::time_point now)
+{
+    std::shared_ptr<const Entry> entry;
+    if (!cache.Get(Version{checksum, data_version, traffic_overlay_version},
+                   key,
+                   entry,
+                   [&](const std::shared_ptr<const Entry> &cached) {
+                       return now - cached->added <= time_to_live;
+                   }))
+    {
+        return false;
+    }
+
+    // the entry stays valid even if it is evicted in the meantime
+    reply = entry->reply;
+    return true;
+}
+
+void ResponseCache::Add(const unsigned checksum,
+                        const unsigned data_version,
+                        const std::uint64_t traffic_overlay_version,
+                        const std::string &key,
+                        const http::reply &reply,
+                        const Clock::time_point now)
+{
+    cache.Add(Version{checksum, data_version, traffic_overlay_version},
+              key,
+              std::shared_ptr<const Entry>(new Entry{reply, now}));
+}
+
+ResponseCache::Statistics ResponseCache::GetStatistics() const
+{
+    const auto statistics = cache.GetStatistics();
+    return Statistics{statistics.number_of_entries,
+                      statistics.cost,
+                      statistics.capacity,
+                      time_to_live,
+                      statistics.hits,
+                      statistics.misses,
+                      statistics.evictions};
+}
+}
+}
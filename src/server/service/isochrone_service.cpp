@@ -0,0 +1,99 @@
+#include "server/service/isochrone_service.hpp"
+#include "server/service/utils.hpp"
+
+#include "server/api/parameters_parser.hpp"
+#include "engine/api/isochrone_parameters.hpp"
+
+#include "util/json_container.hpp"
+
+#include <boost/format.hpp>
+
+#include <algorithm>
+#include <string>
+
+namespace osrm
+{
+namespace server
+{
+namespace service
+{
+
+namespace
+{
+std::string getWrongOptionHelp(const engine::api::IsochroneParameters &parameters)
+{
+    std::string help;
+
+    const auto coord_size = parameters.coordinates.size();
+
+    const bool param_size_mismatch =
+        constrainParamSize(
+            PARAMETER_SIZE_MISMATCH_MSG, "hints", parameters.hints, coord_size, help) ||
+        constrainParamSize(
+            PARAMETER_SIZE_MISMATCH_MSG, "bearings", parameters.bearings, coord_size, help) ||
+        constrainParamSize(
+            PARAMETER_SIZE_MISMATCH_MSG, "radiuses", parameters.radiuses, coord_size, help);
+
+    if (!param_size_mismatch)
+    {
+        if (coord_size != 1)
+        {
+            help = "Number of coordinates needs to be exactly one.";
+        }
+        else if (parameters.contours.empty() ||
+                 parameters.contours.size() > engine::api::IsochroneParameters::MAX_CONTOURS)
+        {
+            help = "Number of contours needs to be between 1 and " +
+                   std::to_string(engine::api::IsochroneParameters::MAX_CONTOURS) + ".";
+        }
+        else if (std::find(parameters.contours.begin(), parameters.contours.end(), 0u) !=
+                 parameters.contours.end())
+        {
+            help = "Contours need to be longer than 0 seconds.";
+        }
+        else if (parameters.cell_size < engine::api::IsochroneParameters::MIN_CELL_SIZE)
+        {
+            help = "Cell size needs to be at least " +
+                   std::to_string(
+                       static_cast<int>(engine::api::IsochroneParameters::MIN_CELL_SIZE)) +
+                   " meters.";
+        }
+    }
+
+    return help;
+}
+} // anon. ns
+
+engine::Status
+IsochroneService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &result)
+{
+    result = util::json::Object();
+    auto &json_result = result.get<util::json::Object>();
+
+    auto query_iterator = query.begin();
+    auto parameters =
+        api::parseParameters<engine::api::IsochroneParameters>(query_iterator, query.end());
+    if (!parameters || query_iterator != query.end())
+    {
+        const auto position = std::distance(query.begin(), query_iterator);
+        json_result.values["code"] = "InvalidQuery";
+        json_result.values["message"] =
+            "Query string malformed close to position " + std::to_string(prefix_length + position);
+        return engine::Status::Error;
+    }
+    BOOST_ASSERT(parameters);
+
+    if (!parameters->IsValid())
+    {
+        json_result.values["code"] = "InvalidOptions";
+        json_result.values["message"] = getWrongOptionHelp(*parameters);
+        return engine::Status::Error;
+    }
+    BOOST_ASSERT(parameters->IsValid());
+
+    parameters->raw_json = true;
+    return BaseService::routing_machine.Isochrone(*parameters, json_result);
+}
+}
+}
+}
@@ -68,6 +68,7 @@ MatchService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &r
     }
     BOOST_ASSERT(parameters->IsValid());
 
+    parameters->raw_json = true;
     return BaseService::routing_machine.Match(*parameters, json_result);
 }
 }
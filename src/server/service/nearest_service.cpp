@@ -31,9 +31,9 @@ std::string getWrongOptionHelp(const engine::api::NearestParameters &parameters)
         constrainParamSize(
             PARAMETER_SIZE_MISMATCH_MSG, "radiuses", parameters.radiuses, coord_size, help);
 
-    if (!param_size_mismatch && parameters.coordinates.size() < 2)
+    if (!param_size_mismatch && parameters.coordinates.empty())
     {
-        help = "Number of coordinates needs to be at least two.";
+        help = "Number of coordinates needs to be at least one.";
     }
 
     return help;
@@ -64,6 +64,7 @@ RouteService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &r
     }
     BOOST_ASSERT(parameters->IsValid());
 
+    parameters->raw_json = true;
     return BaseService::routing_machine.Route(*parameters, json_result);
 }
 }
@@ -2,10 +2,14 @@
 
 #include "server/api/parameters_parser.hpp"
 #include "engine/api/table_parameters.hpp"
+#include "engine/api/table_stream.hpp"
 
 #include "util/json_container.hpp"
 
 #include <boost/format.hpp>
+#include <boost/optional.hpp>
+
+#include <utility>
 
 namespace osrm
 {
@@ -61,6 +65,11 @@ std::string getWrongOptionHelp(const engine::api::TableParameters &parameters)
 engine::Status
 TableService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &result)
 {
+    boost::optional<StreamedJSON> streamed;
+    if (result.is<StreamedJSON>())
+    {
+        streamed = std::move(result.get<StreamedJSON>());
+    }
     result = util::json::Object();
     auto &json_result = result.get<util::json::Object>();
 
@@ -85,7 +94,37 @@ TableService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &r
     }
     BOOST_ASSERT(parameters->IsValid());
 
-    return BaseService::routing_machine.Table(*parameters, json_result);
+    // the table is rendered directly, it is too large for a json::Object with a Value per cell
+    if (parameters->format == engine::api::TableParameters::OutputFormatType::PBF)
+    {
+        result = std::string();
+        return BaseService::routing_machine.Table(*parameters, result.get<std::string>());
+    }
+    if (streamed)
+    {
+        const auto number_of_sources = parameters->sources.empty()
+                                           ? parameters->coordinates.size()
+                                           : parameters->sources.size();
+        const auto number_of_destinations = parameters->destinations.empty()
+                                                ? parameters->coordinates.size()
+                                                : parameters->destinations.size();
+        if (number_of_sources * number_of_destinations >= streamed->min_entries)
+        {
+            engine::api::TableStream stream(streamed->write);
+            const auto status = BaseService::routing_machine.Table(*parameters, stream);
+            if (stream.started)
+            {
+                result = std::move(*streamed);
+            }
+            else
+            {
+                result = RenderedJSON{std::move(stream.error)};
+            }
+            return status;
+        }
+    }
+    result = RenderedJSON();
+    return BaseService::routing_machine.Table(*parameters, result.get<RenderedJSON>().value);
 }
 }
 }
@@ -67,6 +67,7 @@ engine::Status TripService::RunQuery(std::size_t prefix_length, std::string &que
     }
     BOOST_ASSERT(parameters->IsValid());
 
+    parameters->raw_json = true;
     return BaseService::routing_machine.Trip(*parameters, json_result);
 }
 }
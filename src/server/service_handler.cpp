@@ -1,7 +1,9 @@
 #include "server/service_handler.hpp"
 
+#include "server/service/isochrone_service.hpp"
 #include "server/service/match_service.hpp"
 #include "server/service/nearest_service.hpp"
+#include "server/service/route_batch_service.hpp"
 #include "server/service/route_service.hpp"
 #include "server/service/table_service.hpp"
 #include "server/service/tile_service.hpp"
@@ -18,11 +20,13 @@ namespace server
 ServiceHandler::ServiceHandler(osrm::EngineConfig &config) : routing_machine(config)
 {
     service_map["route"] = util::make_unique<service::RouteService>(routing_machine);
+    service_map["routebatch"] = util::make_unique<service::RouteBatchService>(routing_machine);
     service_map["table"] = util::make_unique<service::TableService>(routing_machine);
     service_map["nearest"] = util::make_unique<service::NearestService>(routing_machine);
     service_map["trip"] = util::make_unique<service::TripService>(routing_machine);
     service_map["match"] = util::make_unique<service::MatchService>(routing_machine);
     service_map["tile"] = util::make_unique<service::TileService>(routing_machine);
+    service_map["isochrone"] = util::make_unique<service::IsochroneService>(routing_machine);
 }
 
 engine::Status ServiceHandler::RunQuery(api::ParsedURL parsed_url,
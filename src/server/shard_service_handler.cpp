@@ -0,0 +1,837 @@
+#include "server/shard_service_handler.hpp"
+
+#include "server/api/parameters_parser.hpp"
+#include "server/api/parsed_url.hpp"
+
+#include "engine/api/json_factory.hpp"
+#include "engine/api/tile_parameters.hpp"
+#include "engine/polyline_compressor.hpp"
+#include "util/crc32c.hpp"
+#include "util/exception.hpp"
+#include "util/http_client.hpp"
+#include "util/integer_range.hpp"
+#include "util/json_parser.hpp"
+#include "util/simple_logger.hpp"
+#include "util/web_mercator.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/split.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <future>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <utility>
+
+namespace osrm
+{
+namespace server
+{
+
+namespace
+{
+const constexpr double INFINITE_DURATION = std::numeric_limits<double>::infinity();
+
+void appendCoordinate(std::string &path, const util::Coordinate coordinate)
+{
+    path += std::to_string(static_cast<double>(util::toFloating(coordinate.lon))) + "," +
+            std::to_string(static_cast<double>(util::toFloating(coordinate.lat)));
+}
+
+// The query was decoded by the request handler, polylines may contain anything and have to be
+// encoded again before they are passed on
+std::string encodeQuery(const std::string &query)
+{
+    const auto is_unreserved = [](const char letter) {
+        return (letter >= 'a' && letter <= 'z') || (letter >= 'A' && letter <= 'Z') ||
+               (letter >= '0' && letter <= '9') || letter == '-' || letter == '_' ||
+               letter == '.' || letter == '~';
+    };
+    std::string encoded;
+    unsigned depth = 0;
+    for (const char letter : query)
+    {
+        const bool is_parenthesis = letter == '(' || (letter == ')' && depth > 0);
+        const bool is_plain = depth == 0 ? letter != ' ' && letter != '#' && letter != '%'
+                                         : is_unreserved(letter);
+        if (is_parenthesis || is_plain)
+        {
+            encoded.push_back(letter);
+        }
+        else
+        {
+            char escape[4];
+            std::snprintf(escape, sizeof(escape), "%%%02X", static_cast<unsigned char>(letter));
+            encoded += escape;
+        }
+        depth += letter == '(' ? 1 : 0;
+        depth -= letter == ')' && depth > 0 ? 1 : 0;
+    }
+    return encoded;
+}
+
+// The coordinates of a query of any service, either a list or a polyline. Returns false if they
+// can't be parsed, the shard answers those with the right error.
+bool parseCoordinates(const std::string &query, std::vector<util::Coordinate> &coordinates)
+{
+    const auto coordinates_end = query.find('?');
+    const auto text = query.substr(0, coordinates_end);
+    for (const auto &prefix : {std::string("polyline6("), std::string("polyline(")})
+    {
+        if (boost::algorithm::starts_with(text, prefix) && text.back() == ')')
+        {
+            const auto polyline = text.substr(prefix.size(), text.size() - prefix.size() - 1);
+            coordinates = prefix.size() == 10 ? engine::decodePolyline<1000000>(polyline)
+                                              : engine::decodePolyline<100000>(polyline);
+            return !coordinates.empty();
+        }
+    }
+
+    std::vector<std::string> pairs;
+    boost::algorithm::split(pairs, text, [](const char letter) { return letter == ';'; });
+    for (const auto &pair : pairs)
+    {
+        double longitude, latitude;
+        char separator;
+        std::istringstream pair_stream(pair);
+        if (!(pair_stream >> longitude >> separator >> latitude) || separator != ',')
+        {
+            return false;
+        }
+        coordinates.emplace_back(util::FloatLongitude{longitude}, util::FloatLatitude{latitude});
+    }
+    return !coordinates.empty();
+}
+
+const util::json::Object &asObject(const util::json::Value &value)
+{
+    return value.get<util::json::Object>();
+}
+
+const util::json::Array &asArray(const util::json::Value &value)
+{
+    return value.get<util::json::Array>();
+}
+
+std::string getCode(const util::json::Object &response)
+{
+    const auto code = response.values.find("code");
+    return code == response.values.end() || !code->second.is<util::json::String>()
+               ? std::string()
+               : code->second.get<util::json::String>().value;
+}
+
+using GeometriesType = engine::api::RouteParameters::GeometriesType;
+
+// the overview geometry of a route in the format the shards were asked for
+void appendGeometry(const util::json::Value &geometry,
+                    const GeometriesType geometries,
+                    std::vector<util::Coordinate> &coordinates)
+{
+    std::vector<util::Coordinate> piece;
+    if (geometries == GeometriesType::GeoJSON)
+    {
+        for (const auto &position : asArray(asObject(geometry).values.at("coordinates")).values)
+        {
+            const auto &values = asArray(position).values;
+            piece.emplace_back(
+                util::FloatLongitude{values.at(0).get<util::json::Number>().value},
+                util::FloatLatitude{values.at(1).get<util::json::Number>().value});
+        }
+    }
+    else
+    {
+        const auto &polyline = geometry.get<util::json::String>().value;
+        piece = geometries == GeometriesType::Polyline6 ? engine::decodePolyline<1000000>(polyline)
+                                                        : engine::decodePolyline<100000>(polyline);
+    }
+    // the pieces meet at the boundary points
+    const auto first = coordinates.empty() || piece.empty() ? piece.begin() : piece.begin() + 1;
+    coordinates.insert(coordinates.end(), first, piece.end());
+}
+
+util::json::Value makeGeometry(const std::vector<util::Coordinate> &coordinates,
+                               const GeometriesType geometries)
+{
+    switch (geometries)
+    {
+    case GeometriesType::GeoJSON:
+        return engine::api::json::makeGeoJSONGeometry(coordinates.begin(), coordinates.end());
+    case GeometriesType::Polyline6:
+        return util::json::String(
+            engine::encodePolyline<1000000>(coordinates.begin(), coordinates.end()));
+    default:
+        return util::json::String(
+            engine::encodePolyline<100000>(coordinates.begin(), coordinates.end()));
+    }
+}
+
+void makeError(const std::string &code, const std::string &message, util::json::Object &result)
+{
+    result.values["code"] = code;
+    result.values["message"] = message;
+}
+}
+
+ShardServiceHandler::ShardServiceHandler(util::ShardMap shard_map_,
+                                         const unsigned max_table_size,
+                                         const double timeout)
+    : shard_map(std::move(shard_map_)), max_table_size(std::max(2u, max_table_size)),
+      timeout(timeout), checksum(0)
+{
+    // identifies the shard map for the response cache
+    const auto &boundary_points = shard_map.GetBoundaryPoints();
+    const auto &overlay_edges = shard_map.GetOverlayEdges();
+    checksum = util::crc32c(checksum,
+                            boundary_points.data(),
+                            boundary_points.size() * sizeof(util::ShardMap::BoundaryPoint));
+    for (const auto &edge : overlay_edges)
+    {
+        const std::uint32_t edge_data[] = {
+            edge.shard, edge.from, edge.to, static_cast<std::uint32_t>(edge.duration * 10)};
+        checksum = util::crc32c(checksum, edge_data, sizeof(edge_data));
+    }
+
+    for (const auto shard : util::irange<std::size_t>(0, shard_map.GetShards().size()))
+    {
+        if (shard_map.GetShards()[shard].host.empty())
+        {
+            throw util::exception("Shard " + std::to_string(shard) + " has no backend");
+        }
+    }
+    util::SimpleLogger().Write() << "Serving " << shard_map.GetShards().size() << " shards with "
+                                 << boundary_points.size() << " boundary points and "
+                                 << overlay_edges.size() << " overlay edges";
+}
+
+engine::Status ShardServiceHandler::RunQuery(api::ParsedURL parsed_url, ResultT &result)
+{
+    const auto path = "/" + parsed_url.service + "/v" + std::to_string(parsed_url.version) + "/" +
+                      parsed_url.profile + "/" + parsed_url.query;
+
+    try
+    {
+        if (parsed_url.service == "tile")
+        {
+            const auto parameters =
+                api::parseParameters<engine::api::TileParameters>(parsed_url.query);
+            if (!parameters)
+            {
+                return Forward(0, path, result);
+            }
+            double west, south, east, north;
+            util::web_mercator::xyzToWGS84(
+                parameters->x, parameters->y, parameters->z, west, south, east, north);
+            const util::Coordinate center(util::FloatLongitude{(west + east) / 2},
+                                          util::FloatLatitude{(south + north) / 2});
+            return Forward(shard_map.FindShard(center), path, result);
+        }
+
+        std::vector<util::Coordinate> coordinates;
+        if (!parseCoordinates(parsed_url.query, coordinates))
+        {
+            return Forward(0, path, result);
+        }
+        const auto common_shard = FindCommonShard(coordinates);
+        if (common_shard != util::ShardMap::INVALID_INDEX)
+        {
+            return Forward(common_shard, path, result);
+        }
+
+        result = util::json::Object();
+        auto &json_result = result.get<util::json::Object>();
+        if (parsed_url.service == "route")
+        {
+            const auto parameters =
+                api::parseParameters<engine::api::RouteParameters>(parsed_url.query);
+            if (!parameters || !parameters->IsValid())
+            {
+                return Forward(shard_map.FindShard(coordinates.front()), path, result);
+            }
+            return RouteAcrossShards(parsed_url.profile, *parameters, json_result);
+        }
+        if (parsed_url.service == "table")
+        {
+            const auto parameters =
+                api::parseParameters<engine::api::TableParameters>(parsed_url.query);
+            if (!parameters || !parameters->IsValid())
+            {
+                return Forward(shard_map.FindShard(coordinates.front()), path, result);
+            }
+            return TableAcrossShards(parsed_url.profile, *parameters, json_result);
+        }
+
+        makeError("InvalidQuery",
+                  "The coordinates of " + parsed_url.service +
+                      " queries have to be in the region of a single shard",
+                  json_result);
+        return engine::Status::Error;
+    }
+    catch (const std::exception &e)
+    {
+        // the shards are the data of the front end, without them it's unavailable
+        util::SimpleLogger().Write(logWARNING) << "[shards] " << e.what();
+        result = util::json::Object();
+        makeError("ShardUnavailable", e.what(), result.get<util::json::Object>());
+        return engine::Status::Timeout;
+    }
+}
+
+engine::Status ShardServiceHandler::RunTileQuery(const engine::api::TileParameters &parameters,
+                                                 std::string &result)
+{
+    ResultT tile;
+    const auto status = RunQuery(
+        api::ParsedURL{"tile",
+                       1,
+                       "driving",
+                       "tile(" + std::to_string(parameters.x) + "," + std::to_string(parameters.y) +
+                           "," + std::to_string(parameters.z) + ").mvt",
+                       0},
+        tile);
+    if (status == engine::Status::Ok && tile.is<std::string>())
+    {
+        result = std::move(tile.get<std::string>());
+        return status;
+    }
+    return engine::Status::Error;
+}
+
+engine::Status ShardServiceHandler::Forward(const std::uint32_t shard,
+                                           const std::string &path,
+                                           ResultT &result) const
+{
+    const auto &backend = shard_map.GetShards()[shard];
+    auto response = util::httpGet(backend.host, backend.port, encodeQuery(path), timeout);
+    if (boost::algorithm::starts_with(path, "/tile/") && response.status == 200)
+    {
+        result = std::move(response.body);
+    }
+    else
+    {
+        result = service::RenderedJSON{std::move(response.body)};
+    }
+    return response.status == 200 ? engine::Status::Ok : response.status == 503
+                                                             ? engine::Status::Timeout
+                                                             : engine::Status::Error;
+}
+
+ShardServiceHandler::ShardTable
+ShardServiceHandler::GetTable(const std::uint32_t shard,
+                              const std::string &profile,
+                              const std::vector<util::Coordinate> &sources,
+                              const std::vector<util::Coordinate> &destinations) const
+{
+    ShardTable table;
+    table.durations.assign(sources.size(),
+                           std::vector<double>(destinations.size(), INFINITE_DURATION));
+    if (sources.empty() || destinations.empty())
+    {
+        return table;
+    }
+
+    // the tables of the shards are limited to max_table_size coordinates
+    const auto source_block = std::min<std::size_t>(sources.size(), max_table_size / 2);
+    const auto destination_block = max_table_size - source_block;
+    const auto &backend = shard_map.GetShards()[shard];
+    for (std::size_t first_source = 0; first_source < sources.size();
+         first_source += source_block)
+    {
+        for (std::size_t first_destination = 0; first_destination < destinations.size();
+             first_destination += destination_block)
+        {
+            const auto number_of_sources =
+                std::min(source_block, sources.size() - first_source);
+            const auto number_of_destinations =
+                std::min(destination_block, destinations.size() - first_destination);
+
+            std::string path = "/table/v1/" + profile + "/";
+            for (const auto index : util::irange<std::size_t>(0, number_of_sources))
+            {
+                path += index == 0 ? "" : ";";
+                appendCoordinate(path, sources[first_source + index]);
+            }
+            for (const auto index : util::irange<std::size_t>(0, number_of_destinations))
+            {
+                path += ";";
+                appendCoordinate(path, destinations[first_destination + index]);
+            }
+            path += "?sources=";
+            for (const auto index : util::irange<std::size_t>(0, number_of_sources))
+            {
+                path += (index == 0 ? "" : ";") + std::to_string(index);
+            }
+            path += "&destinations=";
+            for (const auto index : util::irange<std::size_t>(0, number_of_destinations))
+            {
+                path += (index == 0 ? "" : ";") + std::to_string(number_of_sources + index);
+            }
+
+            const auto response = util::httpGet(backend.host, backend.port, path, timeout);
+            util::json::Value value;
+            if (!util::json::parse(response.body, value) || getCode(asObject(value)) != "Ok")
+            {
+                throw util::exception("Table query of shard " + std::to_string(shard) +
+                                      " failed with status " + std::to_string(response.status));
+            }
+
+            const auto &reply = asObject(value);
+            const auto &rows = asArray(reply.values.at("durations")).values;
+            for (const auto row : util::irange<std::size_t>(0, number_of_sources))
+            {
+                const auto &columns = asArray(rows.at(row)).values;
+                for (const auto column : util::irange<std::size_t>(0, number_of_destinations))
+                {
+                    if (columns.at(column).is<util::json::Number>())
+                    {
+                        table.durations[first_source + row][first_destination + column] =
+                            columns.at(column).get<util::json::Number>().value;
+                    }
+                }
+            }
+            if (first_destination == 0)
+            {
+                const auto &waypoints = asArray(reply.values.at("sources")).values;
+                table.sources.values.insert(
+                    table.sources.values.end(), waypoints.begin(), waypoints.end());
+            }
+            if (first_source == 0)
+            {
+                const auto &waypoints = asArray(reply.values.at("destinations")).values;
+                table.destinations.values.insert(
+                    table.destinations.values.end(), waypoints.begin(), waypoints.end());
+            }
+        }
+    }
+    return table;
+}
+
+util::json::Object
+ShardServiceHandler::GetRoute(const std::uint32_t shard,
+                              const std::string &profile,
+                              const util::Coordinate from,
+                              const util::Coordinate to,
+                              const engine::api::RouteParameters &parameters) const
+{
+    std::string path = "/route/v1/" + profile + "/";
+    appendCoordinate(path, from);
+    path += ";";
+    appendCoordinate(path, to);
+    path += "?steps=";
+    path += parameters.steps ? "true" : "false";
+    path += "&overview=";
+    path += parameters.overview == engine::api::RouteParameters::OverviewType::False ? "false"
+                                                                                       : "full";
+    path += "&geometries=";
+    path += parameters.geometries == GeometriesType::GeoJSON
+                ? "geojson"
+                : parameters.geometries == GeometriesType::Polyline6 ? "polyline6" : "polyline";
+
+    const auto &backend = shard_map.GetShards()[shard];
+    const auto response = util::httpGet(backend.host, backend.port, path, timeout);
+    util::json::Value value;
+    if (!util::json::parse(response.body, value) ||
+        !value.is<mapbox::util::recursive_wrapper<util::json::Object>>())
+    {
+        throw util::exception("Route query of shard " + std::to_string(shard) +
+                              " failed with status " + std::to_string(response.status));
+    }
+    return std::move(value.get<util::json::Object>());
+}
+
+std::uint32_t
+ShardServiceHandler::FindCommonShard(const std::vector<util::Coordinate> &coordinates) const
+{
+    const auto shard = shard_map.FindShard(coordinates.front());
+    const bool is_common = std::all_of(
+        coordinates.begin(), coordinates.end(), [&](const util::Coordinate coordinate) {
+            return shard_map.IsInRegion(shard, coordinate);
+        });
+    return is_common || coordinates.size() == 1 ? shard : util::ShardMap::INVALID_INDEX;
+}
+
+engine::Status
+ShardServiceHandler::RouteAcrossShards(const std::string &profile,
+                                       const engine::api::RouteParameters &parameters,
+                                       util::json::Object &result) const
+{
+    struct Piece
+    {
+        std::uint32_t shard;
+        util::Coordinate from;
+        util::Coordinate to;
+    };
+
+    // the pieces of every leg, the shards are asked for the routes of all of them at once
+    const auto &boundary_points = shard_map.GetBoundaryPoints();
+    std::vector<std::vector<Piece>> leg_pieces;
+    for (const auto leg : util::irange<std::size_t>(0, parameters.coordinates.size() - 1))
+    {
+        const auto from = parameters.coordinates[leg];
+        const auto to = parameters.coordinates[leg + 1];
+        const auto common_shard = FindCommonShard({from, to});
+        if (common_shard != util::ShardMap::INVALID_INDEX)
+        {
+            leg_pieces.push_back({{common_shard, from, to}});
+            continue;
+        }
+
+        const auto source_shard = shard_map.FindShard(from);
+        const auto target_shard = shard_map.FindShard(to);
+        const auto source_points = shard_map.GetBoundaryPoints(source_shard);
+        const auto target_points = shard_map.GetBoundaryPoints(target_shard);
+        const auto getCoordinates = [&](const std::vector<std::uint32_t> &points) {
+            std::vector<util::Coordinate> coordinates;
+            for (const auto point : points)
+            {
+                coordinates.push_back(boundary_points[point].coordinate);
+            }
+            return coordinates;
+        };
+        auto target_table = std::async(std::launch::async, [&] {
+            return GetTable(target_shard, profile, getCoordinates(target_points), {to});
+        });
+        const auto source_table =
+            GetTable(source_shard, profile, {from}, getCoordinates(source_points));
+
+        std::vector<double> durations(boundary_points.size(), INFINITE_DURATION);
+        for (const auto index : util::irange<std::size_t>(0, source_points.size()))
+        {
+            durations[source_points[index]] = source_table.durations[0][index];
+        }
+        std::vector<std::uint32_t> parent_edges;
+        shard_map.SearchOverlay(durations, parent_edges);
+
+        const auto table = target_table.get();
+        auto best_duration = INFINITE_DURATION;
+        auto best_point = util::ShardMap::INVALID_INDEX;
+        for (const auto index : util::irange<std::size_t>(0, target_points.size()))
+        {
+            const auto duration = durations[target_points[index]] + table.durations[index][0];
+            if (duration < best_duration)
+            {
+                best_duration = duration;
+                best_point = target_points[index];
+            }
+        }
+        if (best_point == util::ShardMap::INVALID_INDEX)
+        {
+            makeError("NoRoute", "No route found across the shards", result);
+            return engine::Status::Error;
+        }
+
+        const auto &overlay_edges = shard_map.GetOverlayEdges();
+        const auto path = shard_map.GetOverlayPath(parent_edges, best_point);
+        const auto first_point = path.empty() ? best_point : overlay_edges[path.front()].from;
+        std::vector<Piece> pieces{{source_shard, from, boundary_points[first_point].coordinate}};
+        for (const auto edge : path)
+        {
+            pieces.push_back({overlay_edges[edge].shard,
+                              boundary_points[overlay_edges[edge].from].coordinate,
+                              boundary_points[overlay_edges[edge].to].coordinate});
+        }
+        pieces.push_back({target_shard, boundary_points[best_point].coordinate, to});
+        leg_pieces.push_back(std::move(pieces));
+    }
+
+    std::vector<std::vector<std::future<util::json::Object>>> leg_routes(leg_pieces.size());
+    for (const auto leg : util::irange<std::size_t>(0, leg_pieces.size()))
+    {
+        for (const auto &piece : leg_pieces[leg])
+        {
+            leg_routes[leg].push_back(std::async(std::launch::async, [&, piece] {
+                return GetRoute(piece.shard, profile, piece.from, piece.to, parameters);
+            }));
+        }
+    }
+
+    // the legs are stitched from the routes of their pieces, without the arrival and departure
+    // at the boundary points
+    util::json::Array legs;
+    util::json::Array waypoints;
+    std::vector<util::Coordinate> geometry;
+    double distance = 0;
+    double duration = 0;
+    for (auto &routes : leg_routes)
+    {
+        util::json::Object leg;
+        util::json::Array steps;
+        double leg_distance = 0;
+        double leg_duration = 0;
+        double longest_duration = -1;
+        util::json::Value summary = util::json::String();
+        for (const auto index : util::irange<std::size_t>(0, routes.size()))
+        {
+            auto response = routes[index].get();
+            if (getCode(response) != "Ok")
+            {
+                result = std::move(response);
+                return engine::Status::Error;
+            }
+            const auto &route = asObject(asArray(response.values.at("routes")).values.at(0));
+            const auto &piece_leg = asObject(asArray(route.values.at("legs")).values.at(0));
+            const auto piece_duration = route.values.at("duration").get<util::json::Number>().value;
+            leg_distance += route.values.at("distance").get<util::json::Number>().value;
+            leg_duration += piece_duration;
+            if (piece_duration > longest_duration)
+            {
+                longest_duration = piece_duration;
+                summary = piece_leg.values.at("summary");
+            }
+
+            const auto &piece_waypoints = asArray(response.values.at("waypoints")).values;
+            if (waypoints.values.empty())
+            {
+                waypoints.values.push_back(piece_waypoints.front());
+            }
+            if (index + 1 == routes.size())
+            {
+                waypoints.values.push_back(piece_waypoints.back());
+            }
+
+            if (parameters.steps)
+            {
+                const auto &piece_steps = asArray(piece_leg.values.at("steps")).values;
+                const auto first = index == 0 || piece_steps.empty() ? piece_steps.begin()
+                                                                     : piece_steps.begin() + 1;
+                const auto last = index + 1 == routes.size() || piece_steps.empty()
+                                      ? piece_steps.end()
+                                      : piece_steps.end() - 1;
+                if (first < last)
+                {
+                    steps.values.insert(steps.values.end(), first, last);
+                }
+            }
+            if (parameters.overview != engine::api::RouteParameters::OverviewType::False)
+            {
+                appendGeometry(route.values.at("geometry"), parameters.geometries, geometry);
+            }
+        }
+
+        leg.values["distance"] = leg_distance;
+        leg.values["duration"] = leg_duration;
+        leg.values["summary"] = std::move(summary);
+        leg.values["steps"] = std::move(steps);
+        legs.values.push_back(std::move(leg));
+        distance += leg_distance;
+        duration += leg_duration;
+    }
+
+    util::json::Object route;
+    route.values["distance"] = distance;
+    route.values["duration"] = duration;
+    if (parameters.overview != engine::api::RouteParameters::OverviewType::False)
+    {
+        route.values["geometry"] = makeGeometry(geometry, parameters.geometries);
+    }
+    route.values["legs"] = std::move(legs);
+
+    util::json::Array routes;
+    routes.values.push_back(std::move(route));
+    result.values["waypoints"] = std::move(waypoints);
+    result.values["routes"] = std::move(routes);
+    result.values["code"] = "Ok";
+    return engine::Status::Ok;
+}
+
+engine::Status
+ShardServiceHandler::TableAcrossShards(const std::string &profile,
+                                       const engine::api::TableParameters &parameters,
+                                       util::json::Object &result) const
+{
+    const auto getIndices = [&](const std::vector<std::size_t> &indices) {
+        if (!indices.empty())
+        {
+            return indices;
+        }
+        std::vector<std::size_t> all(parameters.coordinates.size());
+        std::iota(all.begin(), all.end(), 0);
+        return all;
+    };
+    const auto sources = getIndices(parameters.sources);
+    const auto destinations = getIndices(parameters.destinations);
+
+    // the sources and destinations of every shard, as indices into sources and destinations
+    std::map<std::uint32_t, std::vector<std::size_t>> shard_sources;
+    std::map<std::uint32_t, std::vector<std::size_t>> shard_destinations;
+    for (const auto index : util::irange<std::size_t>(0, sources.size()))
+    {
+        shard_sources[shard_map.FindShard(parameters.coordinates[sources[index]])].push_back(index);
+    }
+    for (const auto index : util::irange<std::size_t>(0, destinations.size()))
+    {
+        shard_destinations[shard_map.FindShard(parameters.coordinates[destinations[index]])]
+            .push_back(index);
+    }
+
+    const auto &boundary_points = shard_map.GetBoundaryPoints();
+    const auto getCoordinates = [&](const std::vector<std::size_t> &indices,
+                                    const std::vector<std::size_t> &coordinate_indices) {
+        std::vector<util::Coordinate> coordinates;
+        for (const auto index : indices)
+        {
+            coordinates.push_back(parameters.coordinates[coordinate_indices[index]]);
+        }
+        return coordinates;
+    };
+    const auto getBoundaryCoordinates = [&](const std::vector<std::uint32_t> &points) {
+        std::vector<util::Coordinate> coordinates;
+        for (const auto point : points)
+        {
+            coordinates.push_back(boundary_points[point].coordinate);
+        }
+        return coordinates;
+    };
+
+    // The shard of sources computes the durations to its boundary points and to the destinations
+    // in its region, the shard of destinations from its boundary points. All shards at once.
+    struct SourceShard
+    {
+        std::vector<std::uint32_t> points;
+        std::vector<std::size_t> direct_destinations;
+        std::future<ShardTable> table;
+    };
+    struct DestinationShard
+    {
+        std::vector<std::uint32_t> points;
+        std::future<ShardTable> table;
+    };
+    std::map<std::uint32_t, SourceShard> source_shards;
+    std::map<std::uint32_t, DestinationShard> destination_shards;
+    for (const auto &shard_and_sources : shard_sources)
+    {
+        const auto shard = shard_and_sources.first;
+        auto &source_shard = source_shards[shard];
+        source_shard.points = shard_map.GetBoundaryPoints(shard);
+        for (const auto index : util::irange<std::size_t>(0, destinations.size()))
+        {
+            if (shard_map.IsInRegion(shard, parameters.coordinates[destinations[index]]))
+            {
+                source_shard.direct_destinations.push_back(index);
+            }
+        }
+        auto table_destinations = getBoundaryCoordinates(source_shard.points);
+        const auto direct = getCoordinates(source_shard.direct_destinations, destinations);
+        table_destinations.insert(table_destinations.end(), direct.begin(), direct.end());
+        source_shard.table = std::async(std::launch::async,
+                                        &ShardServiceHandler::GetTable,
+                                        this,
+                                        shard,
+                                        std::cref(profile),
+                                        getCoordinates(shard_and_sources.second, sources),
+                                        std::move(table_destinations));
+    }
+    for (const auto &shard_and_destinations : shard_destinations)
+    {
+        const auto shard = shard_and_destinations.first;
+        auto &destination_shard = destination_shards[shard];
+        destination_shard.points = shard_map.GetBoundaryPoints(shard);
+        destination_shard.table =
+            std::async(std::launch::async,
+                       &ShardServiceHandler::GetTable,
+                       this,
+                       shard,
+                       std::cref(profile),
+                       getBoundaryCoordinates(destination_shard.points),
+                       getCoordinates(shard_and_destinations.second, destinations));
+    }
+
+    std::map<std::uint32_t, ShardTable> destination_tables;
+    for (auto &destination_shard : destination_shards)
+    {
+        destination_tables[destination_shard.first] = destination_shard.second.table.get();
+    }
+
+    std::vector<std::vector<double>> durations(
+        sources.size(), std::vector<double>(destinations.size(), INFINITE_DURATION));
+    util::json::Array source_waypoints;
+    source_waypoints.values.resize(sources.size());
+    util::json::Array destination_waypoints;
+    destination_waypoints.values.resize(destinations.size());
+    for (const auto &shard_and_destinations : shard_destinations)
+    {
+        const auto &table = destination_tables[shard_and_destinations.first];
+        for (const auto index : util::irange<std::size_t>(0, shard_and_destinations.second.size()))
+        {
+            destination_waypoints.values[shard_and_destinations.second[index]] =
+                table.destinations.values.at(index);
+        }
+    }
+
+    for (auto &shard_and_source_shard : source_shards)
+    {
+        const auto &shard_indices = shard_sources[shard_and_source_shard.first];
+        auto &source_shard = shard_and_source_shard.second;
+        const auto table = source_shard.table.get();
+        for (const auto row : util::irange<std::size_t>(0, shard_indices.size()))
+        {
+            const auto source = shard_indices[row];
+            source_waypoints.values[source] = table.sources.values.at(row);
+
+            std::vector<double> point_durations(boundary_points.size(), INFINITE_DURATION);
+            for (const auto index : util::irange<std::size_t>(0, source_shard.points.size()))
+            {
+                point_durations[source_shard.points[index]] = table.durations[row][index];
+            }
+            std::vector<std::uint32_t> parent_edges;
+            shard_map.SearchOverlay(point_durations, parent_edges);
+
+            for (const auto &shard_and_destinations : shard_destinations)
+            {
+                const auto &destination_points =
+                    destination_shards[shard_and_destinations.first].points;
+                const auto &destination_table = destination_tables[shard_and_destinations.first];
+                for (const auto column :
+                     util::irange<std::size_t>(0, shard_and_destinations.second.size()))
+                {
+                    auto &duration = durations[source][shard_and_destinations.second[column]];
+                    for (const auto index : util::irange<std::size_t>(0, destination_points.size()))
+                    {
+                        duration = std::min(duration,
+                                            point_durations[destination_points[index]] +
+                                                destination_table.durations[index][column]);
+                    }
+                }
+            }
+
+            // routes within the region of the source shard may not pass a boundary point
+            for (const auto index :
+                 util::irange<std::size_t>(0, source_shard.direct_destinations.size()))
+            {
+                auto &duration = durations[source][source_shard.direct_destinations[index]];
+                duration =
+                    std::min(duration, table.durations[row][source_shard.points.size() + index]);
+            }
+        }
+    }
+
+    util::json::Array rows;
+    for (const auto &row_durations : durations)
+    {
+        util::json::Array row;
+        for (const auto duration : row_durations)
+        {
+            if (duration < INFINITE_DURATION)
+            {
+                // like the tables of the shards, in seconds with a decimal
+                row.values.push_back(util::json::Number(std::round(duration * 10.) / 10.));
+            }
+            else
+            {
+                row.values.push_back(util::json::Null());
+            }
+        }
+        rows.values.push_back(std::move(row));
+    }
+    result.values["code"] = "Ok";
+    result.values["durations"] = std::move(rows);
+    result.values["sources"] = std::move(source_waypoints);
+    result.values["destinations"] = std::move(destination_waypoints);
+    return engine::Status::Ok;
+}
+}
+}
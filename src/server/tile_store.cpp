@@ -0,0 +1,222 @@
+#include "server/tile_store.hpp"
+
+#include "util/exception.hpp"
+#include "util/simple_logger.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/filesystem.hpp>
+
+#include <zlib.h>
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace osrm
+{
+namespace server
+{
+
+namespace
+{
+// zlib writes a gzip wrapper with 16 + 15 window bits
+const constexpr int GZIP_WINDOW_BITS = 16 + MAX_WBITS;
+const constexpr int MEMORY_LEVEL = 8;
+// tiles are compressed once, so they are compressed well
+const constexpr int COMPRESSION_LEVEL = Z_BEST_COMPRESSION;
+// zoom levels are below 32, the x and y of a tile below 2^29 then
+const constexpr unsigned COORDINATE_BITS = 29;
+}
+
+TileStore::TileStore(const std::size_t capacity, boost::filesystem::path directory_)
+    : directory(std::move(directory_)), cache(capacity, 1), disk_hits(0),
+      reported_write_error(false)
+{
+}
+
+TileStore::Tile TileStore::Get(const unsigned checksum,
+                               const unsigned data_version,
+                               const unsigned z,
+                               const unsigned x,
+                               const unsigned y)
+{
+    const auto key = MakeKey(z, x, y);
+    Tile tile;
+    if (cache.Get(Version{checksum, data_version}, key, tile) || directory.empty())
+    {
+        return tile;
+    }
+
+    tile = Load(GetPath(checksum, data_version, z, x, y));
+    if (tile)
+    {
+        disk_hits.fetch_add(1, std::memory_order_relaxed);
+        cache.Add(Version{checksum, data_version}, key, tile);
+    }
+    return tile;
+}
+
+TileStore::Tile TileStore::Add(const unsigned checksum,
+                               const unsigned data_version,
+                               const unsigned z,
+                               const unsigned x,
+                               const unsigned y,
+                               const std::string &tile)
+{
+    auto compressed_tile = std::make_shared<std::vector<char>>();
+    Compress(tile, *compressed_tile);
+    Tile stored_tile = std::move(compressed_tile);
+
+    if (!directory.empty())
+    {
+        Save(GetPath(checksum, data_version, z, x, y), *stored_tile);
+    }
+
+    cache.Add(Version{checksum, data_version}, MakeKey(z, x, y), stored_tile);
+    return stored_tile;
+}
+
+TileStore::Statistics TileStore::GetStatistics() const
+{
+    // read first, every disk hit follows a miss in memory
+    const auto number_of_disk_hits = disk_hits.load(std::memory_order_relaxed);
+    const auto statistics = cache.GetStatistics();
+    return Statistics{statistics.number_of_entries,
+                      statistics.cost,
+                      statistics.capacity,
+                      statistics.hits,
+                      number_of_disk_hits,
+                      statistics.misses - number_of_disk_hits};
+}
+
+void TileStore::Compress(const std::string &input, std::vector<char> &output)
+{
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream,
+                     COMPRESSION_LEVEL,
+                     Z_DEFLATED,
+                     GZIP_WINDOW_BITS,
+                     MEMORY_LEVEL,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        throw util::exception("Could not initialize zlib");
+    }
+
+    // tiles are far below the 4 GB zlib handles in one step
+    output.resize(deflateBound(&stream, input.size()));
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef *>(output.data());
+    stream.avail_out = static_cast<uInt>(output.size());
+    const auto status = deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    if (status != Z_STREAM_END)
+    {
+        throw util::exception("Could not compress tile");
+    }
+}
+
+void TileStore::Decompress(const std::vector<char> &input, std::vector<char> &output)
+{
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, GZIP_WINDOW_BITS) != Z_OK)
+    {
+        throw util::exception("Could not initialize zlib");
+    }
+
+    // vector tiles usually compress to a third
+    output.resize(input.size() * 4 + 1);
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    int status = Z_OK;
+    while (status == Z_OK)
+    {
+        if (stream.total_out == output.size())
+        {
+            output.resize(output.size() * 2);
+        }
+        stream.next_out = reinterpret_cast<Bytef *>(output.data() + stream.total_out);
+        stream.avail_out = static_cast<uInt>(output.size() - stream.total_out);
+        status = inflate(&stream, Z_NO_FLUSH);
+    }
+    output.resize(stream.total_out);
+    inflateEnd(&stream);
+
+    if (status != Z_STREAM_END)
+    {
+        throw util::exception("Could not decompress tile");
+    }
+}
+
+TileStore::Key TileStore::MakeKey(const unsigned z, const unsigned x, const unsigned y)
+{
+    BOOST_ASSERT(z < 32 && x < (1u << COORDINATE_BITS) && y < (1u << COORDINATE_BITS));
+    return (static_cast<Key>(z) << (2 * COORDINATE_BITS)) |
+           (static_cast<Key>(x) << COORDINATE_BITS) | y;
+}
+
+boost::filesystem::path TileStore::GetPath(const unsigned checksum_,
+                                           const unsigned data_version_,
+                                           const unsigned z,
+                                           const unsigned x,
+                                           const unsigned y) const
+{
+    return directory / (std::to_string(checksum_) + "-" + std::to_string(data_version_)) /
+           std::to_string(z) / std::to_string(x) / (std::to_string(y) + ".mvt.gz");
+}
+
+TileStore::Tile TileStore::Load(const boost::filesystem::path &path) const
+{
+    std::ifstream file(path.string(), std::ios::binary);
+    if (!file)
+    {
+        return Tile();
+    }
+
+    auto tile = std::make_shared<std::vector<char>>((std::istreambuf_iterator<char>(file)),
+                                                    std::istreambuf_iterator<char>());
+    if (file.bad() || tile->empty())
+    {
+        return Tile();
+    }
+    return tile;
+}
+
+void TileStore::Save(const boost::filesystem::path &path, const std::vector<char> &tile)
+{
+    boost::system::error_code error;
+    boost::filesystem::create_directories(path.parent_path(), error);
+
+    // other threads and processes only ever see complete tiles
+    const auto temporary_path =
+        path.parent_path() / boost::filesystem::unique_path("%%%%-%%%%-%%%%.tmp");
+    {
+        std::ofstream file(temporary_path.string(), std::ios::binary);
+        file.write(tile.data(), tile.size());
+        if (!file)
+        {
+            error = boost::system::errc::make_error_code(boost::system::errc::io_error);
+        }
+    }
+    if (!error)
+    {
+        boost::filesystem::rename(temporary_path, path, error);
+    }
+
+    if (error)
+    {
+        boost::system::error_code ignore_error;
+        boost::filesystem::remove(temporary_path, ignore_error);
+        if (!reported_write_error.exchange(true))
+        {
+            util::SimpleLogger().Write(logWARNING) << "Could not store tile " << path.string()
+                                                   << ": " << error.message();
+        }
+    }
+}
+}
+}
@@ -0,0 +1,263 @@
+#include "storage/compressed_file.hpp"
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+#include "util/simple_logger.hpp"
+#include "util/timing_util.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace storage
+{
+namespace compressed_file
+{
+
+namespace
+{
+const char COMPRESSED_FILE_MAGIC[8] = {'O', 'S', 'R', 'M', 'Z', 'B', 'L', 'K'};
+
+// the compressed blocks of a batch are kept in memory until they are written
+const constexpr std::size_t BLOCKS_PER_BATCH = 256;
+
+struct Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t block_size;
+    std::uint64_t size;
+    std::uint64_t number_of_blocks;
+};
+
+boost::filesystem::path getTemporaryPath(const boost::filesystem::path &path)
+{
+    return path.string() + ".tmp";
+}
+}
+
+boost::filesystem::path getCompressedPath(const boost::filesystem::path &path)
+{
+    return path.string() + EXTENSION;
+}
+
+void compress(const boost::filesystem::path &path,
+              const boost::filesystem::path &compressed_path,
+              const std::size_t block_size)
+{
+    BOOST_ASSERT(block_size > 0 && block_size <= std::numeric_limits<std::uint32_t>::max());
+    if (!boost::filesystem::is_regular_file(path))
+    {
+        throw util::exception("Could not open " + path.string() + " for reading.");
+    }
+
+    Header header;
+    std::copy(COMPRESSED_FILE_MAGIC,
+              COMPRESSED_FILE_MAGIC + sizeof(COMPRESSED_FILE_MAGIC),
+              header.magic);
+    header.version = VERSION;
+    header.block_size = static_cast<std::uint32_t>(block_size);
+    header.size = boost::filesystem::file_size(path);
+    header.number_of_blocks = (header.size + block_size - 1) / block_size;
+
+    // empty files can't be mapped
+    boost::iostreams::mapped_file_source input;
+    if (header.size > 0)
+    {
+        input.open(path);
+    }
+    const auto input_data = reinterpret_cast<const Bytef *>(input.data());
+
+    const auto temporary_path = getTemporaryPath(compressed_path);
+    boost::filesystem::ofstream output(temporary_path, std::ios::binary);
+    if (!output)
+    {
+        throw util::exception("Could not open " + temporary_path.string() + " for writing.");
+    }
+
+    // the offsets are written again when the sizes of the blocks are known
+    std::vector<std::uint64_t> offsets(header.number_of_blocks + 1, 0);
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char *>(offsets.data()),
+                 offsets.size() * sizeof(std::uint64_t));
+
+    std::vector<std::vector<Bytef>> blocks;
+    for (std::uint64_t first_block = 0; first_block < header.number_of_blocks;
+         first_block += BLOCKS_PER_BATCH)
+    {
+        const auto last_block =
+            std::min<std::uint64_t>(first_block + BLOCKS_PER_BATCH, header.number_of_blocks);
+        blocks.resize(last_block - first_block);
+        tbb::parallel_for(
+            tbb::blocked_range<std::uint64_t>(first_block, last_block, 1),
+            [&](const tbb::blocked_range<std::uint64_t> &range) {
+                for (auto block = range.begin(); block != range.end(); ++block)
+                {
+                    const auto begin = block * block_size;
+                    const auto length = std::min<std::uint64_t>(block_size, header.size - begin);
+                    auto &compressed = blocks[block - first_block];
+                    uLongf compressed_length = compressBound(length);
+                    compressed.resize(compressed_length);
+                    if (compress2(compressed.data(),
+                                  &compressed_length,
+                                  input_data + begin,
+                                  length,
+                                  Z_DEFAULT_COMPRESSION) != Z_OK)
+                    {
+                        throw util::exception("Could not compress " + path.string());
+                    }
+                    compressed.resize(compressed_length);
+                }
+            });
+
+        for (const auto block : util::irange(first_block, last_block))
+        {
+            const auto &compressed = blocks[block - first_block];
+            output.write(reinterpret_cast<const char *>(compressed.data()), compressed.size());
+            offsets[block + 1] = offsets[block] + compressed.size();
+        }
+    }
+
+    output.seekp(sizeof(header));
+    output.write(reinterpret_cast<const char *>(offsets.data()),
+                 offsets.size() * sizeof(std::uint64_t));
+    output.close();
+    if (!output)
+    {
+        throw util::exception("Could not write " + temporary_path.string());
+    }
+    boost::filesystem::rename(temporary_path, compressed_path);
+
+    // a copy is only decompressed if it is newer than the file, which it isn't where it was made
+    boost::filesystem::last_write_time(compressed_path, boost::filesystem::last_write_time(path));
+}
+
+void decompress(const boost::filesystem::path &compressed_path, const boost::filesystem::path &path)
+{
+    if (!boost::filesystem::is_regular_file(compressed_path))
+    {
+        throw util::exception("Could not open " + compressed_path.string() + " for reading.");
+    }
+    const auto invalid = [&] {
+        return util::exception(compressed_path.string() + " is not a valid compressed file.");
+    };
+
+    boost::iostreams::mapped_file_source input(compressed_path);
+    Header header;
+    if (input.size() < sizeof(header))
+    {
+        throw invalid();
+    }
+    std::memcpy(&header, input.data(), sizeof(header));
+    if (!std::equal(COMPRESSED_FILE_MAGIC,
+                    COMPRESSED_FILE_MAGIC + sizeof(COMPRESSED_FILE_MAGIC),
+                    header.magic))
+    {
+        throw invalid();
+    }
+    if (header.version != VERSION)
+    {
+        throw util::exception(compressed_path.string() + " has version " +
+                              std::to_string(header.version) + ", expected " +
+                              std::to_string(VERSION) + ".");
+    }
+    if (header.block_size == 0 ||
+        header.number_of_blocks != (header.size + header.block_size - 1) / header.block_size ||
+        (input.size() - sizeof(header)) / sizeof(std::uint64_t) <= header.number_of_blocks)
+    {
+        throw invalid();
+    }
+
+    std::vector<std::uint64_t> offsets(header.number_of_blocks + 1);
+    std::memcpy(offsets.data(),
+                input.data() + sizeof(header),
+                offsets.size() * sizeof(std::uint64_t));
+    const auto data_begin = sizeof(header) + offsets.size() * sizeof(std::uint64_t);
+    if (offsets.front() != 0 || !std::is_sorted(offsets.begin(), offsets.end()) ||
+        data_begin + offsets.back() != input.size())
+    {
+        throw invalid();
+    }
+    const auto input_data = reinterpret_cast<const Bytef *>(input.data() + data_begin);
+
+    const auto temporary_path = getTemporaryPath(path);
+    if (header.size == 0)
+    {
+        boost::filesystem::ofstream output(temporary_path, std::ios::binary);
+        if (!output)
+        {
+            throw util::exception("Could not open " + temporary_path.string() + " for writing.");
+        }
+    }
+    else
+    {
+        boost::iostreams::mapped_file_params parameters(temporary_path.string());
+        parameters.flags = boost::iostreams::mapped_file::readwrite;
+        parameters.new_file_size = header.size;
+        boost::iostreams::mapped_file_sink output(parameters);
+        const auto output_data = reinterpret_cast<Bytef *>(output.data());
+
+        tbb::parallel_for(
+            tbb::blocked_range<std::uint64_t>(0, header.number_of_blocks, 1),
+            [&](const tbb::blocked_range<std::uint64_t> &range) {
+                for (auto block = range.begin(); block != range.end(); ++block)
+                {
+                    const auto begin = block * header.block_size;
+                    const auto length =
+                        std::min<std::uint64_t>(header.block_size, header.size - begin);
+                    uLongf decompressed_length = length;
+                    if (uncompress(output_data + begin,
+                                   &decompressed_length,
+                                   input_data + offsets[block],
+                                   offsets[block + 1] - offsets[block]) != Z_OK ||
+                        decompressed_length != length)
+                    {
+                        throw invalid();
+                    }
+                }
+            });
+        output.close();
+    }
+    boost::filesystem::rename(temporary_path, path);
+}
+
+std::size_t decompressUpdated(const std::vector<boost::filesystem::path> &paths)
+{
+    std::size_t number_of_files = 0;
+    for (const auto &path : paths)
+    {
+        const auto compressed_path = getCompressedPath(path);
+        if (!boost::filesystem::is_regular_file(compressed_path) ||
+            (boost::filesystem::exists(path) &&
+             boost::filesystem::last_write_time(path) >=
+                 boost::filesystem::last_write_time(compressed_path)))
+        {
+            continue;
+        }
+
+        util::SimpleLogger().Write() << "decompressing " << compressed_path.string();
+        TIMER_START(decompression);
+        decompress(compressed_path, path);
+        TIMER_STOP(decompression);
+        util::SimpleLogger().Write() << "decompressed " << path.string() << " in "
+                                     << TIMER_SEC(decompression) << " sec";
+        ++number_of_files;
+    }
+    return number_of_files;
+}
+}
+}
+}
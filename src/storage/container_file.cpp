@@ -0,0 +1,203 @@
+#include "storage/container_file.hpp"
+#include "util/crc32c.hpp"
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+#include "util/simple_logger.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace osrm
+{
+namespace storage
+{
+
+namespace
+{
+const char CONTAINER_MAGIC[8] = {'O', 'S', 'R', 'M', 'C', 'T', 'N', 'R'};
+
+std::uint64_t alignSection(const std::uint64_t offset)
+{
+    return (offset + ContainerFile::SECTION_ALIGNMENT - 1) / ContainerFile::SECTION_ALIGNMENT *
+           ContainerFile::SECTION_ALIGNMENT;
+}
+}
+
+constexpr std::uint32_t ContainerFile::VERSION;
+constexpr std::size_t ContainerFile::SECTION_ALIGNMENT;
+
+ContainerFile::ContainerFile(const boost::filesystem::path &path_) : path(path_)
+{
+    if (!boost::filesystem::is_regular_file(path))
+    {
+        throw util::exception("Could not open " + path.string() + " for reading.");
+    }
+    mapping.open(path, boost::iostreams::mapped_file::priv);
+
+    Header header;
+    if (mapping.size() < sizeof(header))
+    {
+        throw util::exception(path.string() + " is not an OSRM container.");
+    }
+    std::memcpy(&header, mapping.data(), sizeof(header));
+    if (!std::equal(CONTAINER_MAGIC, CONTAINER_MAGIC + sizeof(CONTAINER_MAGIC), header.magic))
+    {
+        throw util::exception(path.string() + " is not an OSRM container.");
+    }
+    if (header.version != VERSION)
+    {
+        throw util::exception(path.string() + " has container version " +
+                              std::to_string(header.version) + ", expected " +
+                              std::to_string(VERSION) + ". Reprocess the dataset.");
+    }
+    if (!header.fingerprint.TestQueryObjects(util::FingerPrint::GetValid()))
+    {
+        util::SimpleLogger().Write(logWARNING) << path.string()
+                                               << " was prepared with a different build. "
+                                                  "Reprocess to get rid of this warning.";
+    }
+
+    const std::size_t table_size = header.number_of_sections * sizeof(Entry);
+    if (mapping.size() < sizeof(header) + table_size)
+    {
+        throw util::exception(path.string() + " is truncated.");
+    }
+    entries.resize(header.number_of_sections);
+    std::memcpy(entries.data(), mapping.data() + sizeof(header), table_size);
+
+    for (const auto &entry : entries)
+    {
+        if (entry.offset % SECTION_ALIGNMENT != 0 || entry.offset > mapping.size() ||
+            entry.size > mapping.size() - entry.offset)
+        {
+            throw util::exception(path.string() + " is truncated.");
+        }
+    }
+}
+
+void ContainerFile::Write(const boost::filesystem::path &path,
+                          const std::vector<boost::filesystem::path> &files)
+{
+    Header header;
+    std::copy(CONTAINER_MAGIC, CONTAINER_MAGIC + sizeof(CONTAINER_MAGIC), header.magic);
+    header.version = VERSION;
+    header.number_of_sections = files.size();
+    header.fingerprint = util::FingerPrint::GetValid();
+
+    std::vector<Entry> entries(files.size());
+    std::uint64_t offset = alignSection(sizeof(header) + files.size() * sizeof(Entry));
+    for (const auto index : util::irange<std::size_t>(0, files.size()))
+    {
+        const auto name = files[index].extension().string();
+        if (name.empty() || name.size() >= sizeof(Entry::name))
+        {
+            throw util::exception("Can't name a section after " + files[index].string());
+        }
+        auto &entry = entries[index];
+        std::fill(entry.name, entry.name + sizeof(entry.name), '\0');
+        std::copy(name.begin(), name.end(), entry.name);
+        entry.offset = offset;
+        entry.size = boost::filesystem::file_size(files[index]);
+        entry.padding = 0;
+        offset = alignSection(offset + entry.size);
+    }
+
+    boost::filesystem::ofstream container_stream(path, std::ios::binary);
+    if (!container_stream)
+    {
+        throw util::exception("Could not open " + path.string() + " for writing.");
+    }
+
+    const std::array<char, SECTION_ALIGNMENT> zeros{};
+    const auto pad = [&](const std::uint64_t position) {
+        const std::uint64_t padding = alignSection(position) - position;
+        container_stream.write(zeros.data(), padding);
+        return position + padding;
+    };
+
+    // the table of contents is rewritten with the checksums at the end
+    container_stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    container_stream.write(reinterpret_cast<const char *>(entries.data()),
+                           entries.size() * sizeof(Entry));
+    std::uint64_t position = pad(sizeof(header) + entries.size() * sizeof(Entry));
+
+    std::vector<char> buffer(1 << 20);
+    for (const auto index : util::irange<std::size_t>(0, files.size()))
+    {
+        auto &entry = entries[index];
+        BOOST_ASSERT(position == entry.offset);
+
+        boost::filesystem::ifstream file_stream(files[index], std::ios::binary);
+        if (!file_stream)
+        {
+            throw util::exception("Could not open " + files[index].string() + " for reading.");
+        }
+
+        std::uint32_t checksum = 0;
+        std::uint64_t remaining = entry.size;
+        while (remaining > 0)
+        {
+            const std::size_t block = std::min<std::uint64_t>(remaining, buffer.size());
+            file_stream.read(buffer.data(), block);
+            if (!file_stream)
+            {
+                throw util::exception("Reading from " + files[index].string() + " failed.");
+            }
+            checksum = util::crc32c(checksum, buffer.data(), block);
+            container_stream.write(buffer.data(), block);
+            remaining -= block;
+        }
+        entry.checksum = checksum;
+        position = pad(position + entry.size);
+    }
+
+    container_stream.seekp(sizeof(header));
+    container_stream.write(reinterpret_cast<const char *>(entries.data()),
+                           entries.size() * sizeof(Entry));
+    if (!container_stream)
+    {
+        throw util::exception("Writing to " + path.string() + " failed.");
+    }
+}
+
+const ContainerFile::Entry *ContainerFile::FindEntry(const std::string &name) const
+{
+    const auto found = std::find_if(entries.begin(), entries.end(), [&](const Entry &entry) {
+        return name.size() < sizeof(entry.name) && name == entry.name;
+    });
+    return found == entries.end() ? nullptr : &*found;
+}
+
+bool ContainerFile::HasSection(const std::string &name) const
+{
+    return FindEntry(name) != nullptr;
+}
+
+ContainerFile::Section ContainerFile::GetSection(const std::string &name) const
+{
+    const auto entry = FindEntry(name);
+    if (entry == nullptr)
+    {
+        throw util::exception(path.string() + " has no " + name + " section.");
+    }
+    return Section{mapping.data() + entry->offset, entry->size};
+}
+
+ContainerFile::Section ContainerFile::GetContents() const
+{
+    return Section{mapping.data(), mapping.size()};
+}
+
+bool ContainerFile::ValidateChecksums() const
+{
+    return std::all_of(entries.begin(), entries.end(), [&](const Entry &entry) {
+        return util::parallelCRC32C(mapping.data() + entry.offset, entry.size) == entry.checksum;
+    });
+}
+}
+}
@@ -1,24 +1,28 @@
 #include "storage/storage.hpp"
 #include "contractor/query_edge.hpp"
+#include "contractor/query_graph.hpp"
 #include "extractor/compressed_edge_container.hpp"
+#include "extractor/compressed_geometry.hpp"
 #include "extractor/guidance/turn_instruction.hpp"
 #include "extractor/original_edge_data.hpp"
 #include "extractor/profile_properties.hpp"
 #include "extractor/query_node.hpp"
 #include "extractor/travel_mode.hpp"
+#include "partition/cell_storage.hpp"
 #include "storage/shared_barriers.hpp"
 #include "storage/shared_datatype.hpp"
 #include "storage/shared_memory.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
 #include "util/coordinate.hpp"
+#include "util/async_io.hpp"
 #include "util/exception.hpp"
 #include "util/fingerprint.hpp"
 #include "util/io.hpp"
+#include "util/packed_bitset.hpp"
 #include "util/packed_vector.hpp"
 #include "util/range_table.hpp"
 #include "util/shared_memory_vector_wrapper.hpp"
 #include "util/simple_logger.hpp"
-#include "util/static_graph.hpp"
 #include "util/static_rtree.hpp"
 #include "util/typedefs.hpp"
 
@@ -27,13 +31,20 @@
 #endif
 
 #include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
 #include <boost/iostreams/seek.hpp>
 
+#include <tbb/parallel_invoke.h>
+
+#include <algorithm>
 #include <cstdint>
 
 #include <fstream>
+#include <initializer_list>
+#include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <new>
 #include <string>
 
@@ -60,8 +71,18 @@ void deleteRegion(const SharedDataType region)
                 return "LAYOUT_2";
             case DATA_2:
                 return "DATA_2";
+            case LAYOUT_3:
+                return "LAYOUT_3";
+            case DATA_3:
+                return "DATA_3";
+            case LAYOUT_4:
+                return "LAYOUT_4";
+            case DATA_4:
+                return "DATA_4";
             case LAYOUT_NONE:
                 return "LAYOUT_NONE";
+            case TRAFFIC_OVERLAY:
+                return "TRAFFIC_OVERLAY";
             default: // DATA_NONE:
                 return "DATA_NONE";
             }
@@ -71,12 +92,83 @@ void deleteRegion(const SharedDataType region)
     }
 }
 
+namespace
+{
+// Queues a read of size bytes at the position of the stream into buffer and moves the stream past
+// them. The bytes are there once io.Wait() returned.
+void readAsync(util::AsyncIO &io,
+               const boost::filesystem::path &path,
+               std::istream &stream,
+               void *buffer,
+               const std::uint64_t size)
+{
+    io.Read(path, static_cast<std::uint64_t>(stream.tellg()), buffer, size);
+    stream.seekg(size, std::ios::cur);
+}
+
+// Picks the slot to load a new dataset into, and removes the datasets that no facade uses anymore
+// on the way. Needs the exclusive query lock.
+unsigned claimDatasetSlot(SharedDataTimestamp &current)
+{
+    const auto current_slot = getDatasetSlot(current.layout);
+    unsigned claimed_slot = NUM_DATASET_SLOTS;
+    for (unsigned slot = 0; slot < NUM_DATASET_SLOTS; ++slot)
+    {
+        auto &generation = current.generations[slot];
+        if (slot == current_slot || generation.references > 0)
+        {
+            continue;
+        }
+        deleteRegion(getLayoutRegion(slot));
+        deleteRegion(getDataRegion(slot));
+        generation.timestamp = 0;
+        if (claimed_slot == NUM_DATASET_SLOTS)
+        {
+            claimed_slot = slot;
+        }
+    }
+    if (claimed_slot != NUM_DATASET_SLOTS)
+    {
+        return claimed_slot;
+    }
+
+    // All other datasets are still in use, or were never released by processes that crashed.
+    // The oldest one is removed anyway, the processes attached to it keep their mappings.
+    for (unsigned slot = 0; slot < NUM_DATASET_SLOTS; ++slot)
+    {
+        if (slot != current_slot &&
+            (claimed_slot == NUM_DATASET_SLOTS ||
+             current.generations[slot].timestamp < current.generations[claimed_slot].timestamp))
+        {
+            claimed_slot = slot;
+        }
+    }
+    auto &generation = current.generations[claimed_slot];
+    util::SimpleLogger().Write(logWARNING) << "replacing the dataset " << generation.timestamp
+                                           << " that is still used by " << generation.references
+                                           << " facades";
+    deleteRegion(getLayoutRegion(claimed_slot));
+    deleteRegion(getDataRegion(claimed_slot));
+    generation.timestamp = 0;
+    generation.references = 0;
+    return claimed_slot;
+}
+}
+
 using RTreeLeaf = engine::datafacade::BaseDataFacade::RTreeLeaf;
 using RTreeNode =
     util::StaticRTree<RTreeLeaf, util::ShM<util::Coordinate, true>::vector, true>::TreeNode;
-using QueryGraph = util::StaticGraph<contractor::QueryEdge::EdgeData>;
+using QueryGraph = contractor::QueryGraph<false>;
+
+// number of node and edge records that are read from their files at once
+const constexpr unsigned RECORDS_PER_READ = 1 << 16;
 
-Storage::Storage(StorageConfig config_) : config(std::move(config_)) {}
+Storage::Storage(StorageConfig config_,
+                 const std::size_t huge_page_size_,
+                 const bool weights_only_)
+    : config(std::move(config_)), huge_page_size(huge_page_size_), weights_only(weights_only_)
+{
+}
 
 int Storage::Run()
 {
@@ -96,7 +188,7 @@ int Storage::Run()
 
     try
     {
-        boost::interprocess::scoped_lock<boost::interprocess::named_mutex> pending_lock(
+        boost::interprocess::scoped_lock<SharedBarriers::Mutex> pending_lock(
             barrier.pending_update_mutex);
     }
     catch (...)
@@ -105,18 +197,23 @@ int Storage::Run()
         barrier.pending_update_mutex.unlock();
     }
 
-    // determine segment to use
-    bool segment2_in_use = SharedMemory::RegionExists(LAYOUT_2);
-    const storage::SharedDataType layout_region = [&] {
-        return segment2_in_use ? LAYOUT_1 : LAYOUT_2;
-    }();
-    const storage::SharedDataType data_region = [&] { return segment2_in_use ? DATA_1 : DATA_2; }();
-    const storage::SharedDataType previous_layout_region = [&] {
-        return segment2_in_use ? LAYOUT_2 : LAYOUT_1;
-    }();
-    const storage::SharedDataType previous_data_region = [&] {
-        return segment2_in_use ? DATA_2 : DATA_1;
+    // The datasets osrm-routed still uses stay in their slots while the new one is loaded into
+    // another slot, so loading doesn't wait for queries on older datasets.
+    SharedMemory *data_type_memory =
+        makeSharedMemory(CURRENT_REGIONS, sizeof(SharedDataTimestamp), true, false);
+    SharedDataTimestamp *data_timestamp_ptr =
+        static_cast<SharedDataTimestamp *>(data_type_memory->Ptr());
+    const auto slot = [&] {
+        boost::interprocess::scoped_lock<SharedBarriers::SharableMutex> query_lock(
+            barrier.query_mutex);
+        return claimDatasetSlot(*data_timestamp_ptr);
     }();
+    const storage::SharedDataType layout_region = getLayoutRegion(slot);
+    const storage::SharedDataType data_region = getDataRegion(slot);
+    // the dataset that is loaded right now, not removed before the new one replaces it
+    const storage::SharedDataType previous_layout_region = data_timestamp_ptr->layout;
+    const storage::SharedDataType previous_data_region = data_timestamp_ptr->data;
+    util::SimpleLogger().Write() << "loading the dataset into slot " << slot + 1;
 
     // Allocate a memory layout in shared memory, deallocate previous
     auto *layout_memory = makeSharedMemory(layout_region, sizeof(SharedDataLayout));
@@ -218,8 +315,10 @@ int Storage::Run()
     unsigned number_of_graph_edges = 0;
     hsgr_input_stream.read((char *)&number_of_graph_edges, sizeof(unsigned));
     // BOOST_ASSERT_MSG(0 != number_of_graph_edges, "number of graph edges is zero");
-    shared_layout_ptr->SetBlockSize<QueryGraph::EdgeArrayEntry>(SharedDataLayout::GRAPH_EDGE_LIST,
-                                                                number_of_graph_edges);
+    shared_layout_ptr->SetBlockSize<contractor::QueryEdgeSearchData>(
+        SharedDataLayout::GRAPH_SEARCH_EDGE_LIST, number_of_graph_edges);
+    shared_layout_ptr->SetBlockSize<contractor::QueryEdgeUnpackData>(
+        SharedDataLayout::GRAPH_UNPACK_EDGE_LIST, number_of_graph_edges);
 
     // load rsearch tree size
     boost::filesystem::ifstream tree_node_file(config.ram_index_path, std::ios::binary);
@@ -246,8 +345,118 @@ int Storage::Run()
 
     uint32_t number_of_core_markers = 0;
     core_marker_file.read((char *)&number_of_core_markers, sizeof(uint32_t));
-    shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::CORE_MARKER,
-                                              number_of_core_markers);
+    shared_layout_ptr->SetBlockSize<util::PackedBitsetView::Word>(SharedDataLayout::CORE_MARKER,
+                                                                  number_of_core_markers);
+
+    // load landmark table sizes, datasets without a landmarks file have none
+    boost::filesystem::ifstream landmarks_file;
+    unsigned number_of_landmarks = 0;
+    unsigned number_of_landmark_core_nodes = 0;
+    if (boost::filesystem::exists(config.landmarks_data_path))
+    {
+        landmarks_file.open(config.landmarks_data_path, std::ios::binary);
+        if (!landmarks_file)
+        {
+            throw util::exception("Could not open " + config.landmarks_data_path.string() +
+                                  " for reading.");
+        }
+        landmarks_file.read((char *)&number_of_landmarks, sizeof(unsigned));
+        landmarks_file.read((char *)&number_of_landmark_core_nodes, sizeof(unsigned));
+    }
+    shared_layout_ptr->SetBlockSize<NodeID>(SharedDataLayout::LANDMARK_CORE_NODES,
+                                            number_of_landmark_core_nodes);
+    shared_layout_ptr->SetBlockSize<EdgeWeight>(SharedDataLayout::LANDMARK_DISTANCES,
+                                                std::uint64_t{2} * number_of_landmarks *
+                                                    number_of_landmark_core_nodes);
+
+    // load hub label sizes, datasets without a hub labels file have none
+    boost::filesystem::ifstream hub_labels_file;
+    unsigned number_of_hub_label_nodes = 0;
+    std::uint64_t number_of_hub_label_entries = 0;
+    if (boost::filesystem::exists(config.hub_labels_data_path))
+    {
+        hub_labels_file.open(config.hub_labels_data_path, std::ios::binary);
+        if (!hub_labels_file)
+        {
+            throw util::exception("Could not open " + config.hub_labels_data_path.string() +
+                                  " for reading.");
+        }
+        hub_labels_file.read((char *)&number_of_hub_label_nodes, sizeof(unsigned));
+        hub_labels_file.read((char *)&number_of_hub_label_entries, sizeof(std::uint64_t));
+    }
+    shared_layout_ptr->SetBlockSize<std::uint64_t>(
+        SharedDataLayout::HUB_LABEL_OFFSETS,
+        number_of_hub_label_nodes > 0 ? std::uint64_t{2} * number_of_hub_label_nodes + 1 : 0);
+    shared_layout_ptr->SetBlockSize<NodeID>(SharedDataLayout::HUB_LABEL_HUBS,
+                                            number_of_hub_label_entries);
+    shared_layout_ptr->SetBlockSize<EdgeWeight>(SharedDataLayout::HUB_LABEL_WEIGHTS,
+                                                number_of_hub_label_entries);
+
+    // load the sizes of the multi-level graph and its cells, datasets without the files of
+    // osrm-customize have none
+    boost::filesystem::ifstream mld_graph_file;
+    boost::filesystem::ifstream cells_file;
+    unsigned number_of_mld_graph_nodes = 0;
+    unsigned number_of_mld_graph_edges = 0;
+    partition::CellStorageHeader cells_header;
+    if (boost::filesystem::exists(config.mld_graph_data_path) &&
+        boost::filesystem::exists(config.cells_data_path))
+    {
+        mld_graph_file.open(config.mld_graph_data_path, std::ios::binary);
+        cells_file.open(config.cells_data_path, std::ios::binary);
+        if (!mld_graph_file || !cells_file)
+        {
+            throw util::exception("Could not open " + config.mld_graph_data_path.string() +
+                                  " and " + config.cells_data_path.string() + " for reading.");
+        }
+        // the checksum of the graph is not needed
+        mld_graph_file.ignore(sizeof(util::FingerPrint) + sizeof(unsigned));
+        mld_graph_file.read((char *)&number_of_mld_graph_nodes, sizeof(unsigned));
+        mld_graph_file.read((char *)&number_of_mld_graph_edges, sizeof(unsigned));
+        if (!partition::readCellStorageHeader(cells_file, cells_header))
+        {
+            throw util::exception(config.cells_data_path.string() +
+                                  " was written by an incompatible version");
+        }
+        if (cells_header.number_of_named_weights > 0 &&
+            cells_header.number_of_edges != number_of_mld_graph_edges)
+        {
+            throw util::exception(config.cells_data_path.string() + " does not match " +
+                                  config.mld_graph_data_path.string());
+        }
+    }
+    shared_layout_ptr->SetBlockSize<QueryGraph::NodeArrayEntry>(
+        SharedDataLayout::MLD_GRAPH_NODE_LIST, number_of_mld_graph_nodes);
+    shared_layout_ptr->SetBlockSize<contractor::QueryEdgeSearchData>(
+        SharedDataLayout::MLD_GRAPH_SEARCH_EDGE_LIST, number_of_mld_graph_edges);
+    shared_layout_ptr->SetBlockSize<contractor::QueryEdgeUnpackData>(
+        SharedDataLayout::MLD_GRAPH_UNPACK_EDGE_LIST, number_of_mld_graph_edges);
+    shared_layout_ptr->SetBlockSize<partition::CellData>(SharedDataLayout::MLD_CELLS,
+                                                         cells_header.number_of_cells);
+    shared_layout_ptr->SetBlockSize<std::uint32_t>(
+        SharedDataLayout::MLD_LEVEL_OFFSETS,
+        number_of_mld_graph_nodes > 0 ? cells_header.GetNumberOfLevelOffsets() : 0);
+    shared_layout_ptr->SetBlockSize<partition::CellID>(SharedDataLayout::MLD_NODE_CELLS,
+                                                       cells_header.GetNumberOfNodeCells());
+    shared_layout_ptr->SetBlockSize<NodeID>(SharedDataLayout::MLD_CELL_SOURCES,
+                                            cells_header.number_of_sources);
+    shared_layout_ptr->SetBlockSize<NodeID>(SharedDataLayout::MLD_CELL_DESTINATIONS,
+                                            cells_header.number_of_destinations);
+    shared_layout_ptr->SetBlockSize<EdgeWeight>(SharedDataLayout::MLD_CELL_WEIGHTS,
+                                                cells_header.GetNumberOfMetricWeights());
+    shared_layout_ptr->SetBlockSize<extractor::ClassData>(
+        SharedDataLayout::MLD_EXCLUDE_MASKS,
+        number_of_mld_graph_nodes > 0 ? cells_header.number_of_metrics : 0);
+    shared_layout_ptr->SetBlockSize<extractor::ClassData>(SharedDataLayout::MLD_NODE_CLASSES,
+                                                          cells_header.number_of_node_classes);
+    shared_layout_ptr->SetBlockSize<char>(SharedDataLayout::MLD_CLASS_NAMES,
+                                          cells_header.class_names_size);
+    shared_layout_ptr->SetBlockSize<EdgeWeight>(SharedDataLayout::MLD_EDGE_WEIGHTS,
+                                                cells_header.GetNumberOfEdgeWeights());
+    shared_layout_ptr->SetBlockSize<std::uint32_t>(SharedDataLayout::MLD_METRIC_EDGE_WEIGHTS,
+                                                   cells_header.GetNumberOfMetricEdgeWeights());
+    shared_layout_ptr->SetBlockSize<char>(SharedDataLayout::MLD_EDGE_WEIGHT_NAMES,
+                                          cells_header.edge_weight_names_size);
 
     // load coordinate size
     boost::filesystem::ifstream nodes_input_stream(config.nodes_data_path, std::ios::binary);
@@ -281,8 +490,18 @@ int Storage::Run()
     boost::iostreams::seek(
         geometry_input_stream, number_of_geometries_indices * sizeof(unsigned), BOOST_IOS::cur);
     geometry_input_stream.read((char *)&number_of_compressed_geometries, sizeof(unsigned));
-    shared_layout_ptr->SetBlockSize<extractor::CompressedEdgeContainer::CompressedEdge>(
-        SharedDataLayout::GEOMETRIES_LIST, number_of_compressed_geometries);
+    unsigned number_of_geometry_blocks = 0;
+    geometry_input_stream.read((char *)&number_of_geometry_blocks, sizeof(unsigned));
+    shared_layout_ptr->SetBlockSize<std::uint64_t>(SharedDataLayout::GEOMETRIES_BLOCK_OFFSETS,
+                                                   number_of_geometry_blocks);
+    boost::iostreams::seek(geometry_input_stream,
+                           extractor::detail::blockOffsetsPadding(number_of_geometries_indices) +
+                               number_of_geometry_blocks * sizeof(std::uint64_t),
+                           BOOST_IOS::cur);
+    std::uint64_t number_of_geometry_bytes = 0;
+    geometry_input_stream.read((char *)&number_of_geometry_bytes, sizeof(number_of_geometry_bytes));
+    shared_layout_ptr->SetBlockSize<unsigned char>(SharedDataLayout::GEOMETRIES_DATA,
+                                                   number_of_geometry_bytes);
 
     // load datasource sizes.  This file is optional, and it's non-fatal if it doesn't
     // exist.
@@ -303,6 +522,41 @@ int Storage::Run()
     shared_layout_ptr->SetBlockSize<uint8_t>(SharedDataLayout::DATASOURCES_LIST,
                                              number_of_compressed_datasources);
 
+    // load the zoom level sizes of the geometries, datasets without the file have none
+    boost::filesystem::ifstream geometry_zoom_levels_input_stream;
+    std::uint64_t number_of_geometry_zoom_levels = 0;
+    if (boost::filesystem::exists(config.geometry_zoom_levels_path))
+    {
+        geometry_zoom_levels_input_stream.open(config.geometry_zoom_levels_path, std::ios::binary);
+        if (!geometry_zoom_levels_input_stream)
+        {
+            throw util::exception("Could not open " + config.geometry_zoom_levels_path.string() +
+                                  " for reading.");
+        }
+        geometry_zoom_levels_input_stream.read(
+            reinterpret_cast<char *>(&number_of_geometry_zoom_levels),
+            sizeof(number_of_geometry_zoom_levels));
+    }
+    shared_layout_ptr->SetBlockSize<std::uint8_t>(SharedDataLayout::GEOMETRIES_ZOOM_LEVELS,
+                                                  number_of_geometry_zoom_levels);
+
+    // load the segment length sizes of the geometries, datasets without the file have none
+    boost::filesystem::ifstream geometry_lengths_input_stream;
+    std::uint64_t number_of_geometry_lengths = 0;
+    if (boost::filesystem::exists(config.geometry_lengths_path))
+    {
+        geometry_lengths_input_stream.open(config.geometry_lengths_path, std::ios::binary);
+        if (!geometry_lengths_input_stream)
+        {
+            throw util::exception("Could not open " + config.geometry_lengths_path.string() +
+                                  " for reading.");
+        }
+        geometry_lengths_input_stream.read(reinterpret_cast<char *>(&number_of_geometry_lengths),
+                                           sizeof(number_of_geometry_lengths));
+    }
+    shared_layout_ptr->SetBlockSize<SegmentLength>(SharedDataLayout::GEOMETRIES_LENGTHS,
+                                                   number_of_geometry_lengths);
+
     // Load datasource name sizes.  This file is optional, and it's non-fatal if it doesn't
     // exist
     boost::filesystem::ifstream datasource_names_input_stream(config.datasource_names_path,
@@ -406,8 +660,15 @@ int Storage::Run()
     // allocate shared memory block
     util::SimpleLogger().Write() << "allocating shared memory of "
                                  << shared_layout_ptr->GetSizeOfLayout() << " bytes";
-    auto *shared_memory = makeSharedMemory(data_region, shared_layout_ptr->GetSizeOfLayout());
+    auto *shared_memory = makeSharedMemory(
+        data_region, shared_layout_ptr->GetSizeOfLayout(), false, true, huge_page_size);
     char *shared_memory_ptr = static_cast<char *>(shared_memory->Ptr());
+    shared_layout_ptr->huge_page_size = shared_memory->HugePageSize();
+    if (shared_layout_ptr->huge_page_size > 0)
+    {
+        util::SimpleLogger().Write() << "shared memory is backed by huge pages of "
+                                     << shared_layout_ptr->huge_page_size << " bytes";
+    }
 
     // read actual data into shared memory object //
 
@@ -428,328 +689,697 @@ int Storage::Run()
               absolute_file_index_path.string().end(),
               file_index_path_ptr);
 
-    // Loading street names
-    unsigned *name_offsets_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::NAME_OFFSETS);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_OFFSETS) > 0)
+    // store timestamp
+    char *timestamp_ptr =
+        shared_layout_ptr->GetBlockPtr<char, true>(shared_memory_ptr, SharedDataLayout::TIMESTAMP);
+    std::copy(m_timestamp.c_str(), m_timestamp.c_str() + m_timestamp.length(), timestamp_ptr);
+
+    // If only the weights changed, the blocks that don't depend on them are copied from the
+    // dataset that is loaded right now instead of being read and parsed from their files again.
+    std::unique_ptr<SharedMemory> previous_layout_memory;
+    std::unique_ptr<SharedMemory> previous_data_memory;
+    if (weights_only && getDatasetSlot(previous_layout_region) != NUM_DATASET_SLOTS &&
+        SharedMemory::RegionExists(previous_layout_region) &&
+        SharedMemory::RegionExists(previous_data_region))
     {
-        name_stream.read((char *)name_offsets_ptr,
-                         shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_OFFSETS));
+        previous_layout_memory.reset(makeSharedMemory(previous_layout_region));
+        previous_data_memory.reset(makeSharedMemory(previous_data_region));
     }
-
-    unsigned *name_blocks_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::NAME_BLOCKS);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_BLOCKS) > 0)
+    else if (weights_only)
     {
-        name_stream.read((char *)name_blocks_ptr,
-                         shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_BLOCKS));
+        util::SimpleLogger().Write(logWARNING)
+            << "no dataset is loaded to copy the unchanged blocks from, loading all files";
     }
+    // false if the blocks need to be loaded from their files
+    const auto reuseBlocks = [&](std::initializer_list<SharedDataLayout::BlockID> blocks) {
+        if (!previous_data_memory)
+        {
+            return false;
+        }
+        const auto *previous_layout_ptr =
+            static_cast<SharedDataLayout *>(previous_layout_memory->Ptr());
+        const auto hasSameSize = [&](const SharedDataLayout::BlockID block) {
+            return previous_layout_ptr->num_entries[block] ==
+                       shared_layout_ptr->num_entries[block] &&
+                   previous_layout_ptr->entry_size[block] == shared_layout_ptr->entry_size[block];
+        };
+        const bool unchanged = std::all_of(blocks.begin(), blocks.end(), hasSameSize);
+        if (!unchanged)
+        {
+            return false;
+        }
 
-    char *name_char_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
-        shared_memory_ptr, SharedDataLayout::NAME_CHAR_LIST);
-    unsigned temp_length = 0;
-    name_stream.read((char *)&temp_length, sizeof(unsigned));
-
-    BOOST_ASSERT_MSG(shared_layout_ptr->AlignBlockSize(temp_length) ==
-                         shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST),
-                     "Name file corrupted!");
+        // the previous layout is a copy, GetBlockPtr isn't const
+        SharedDataLayout previous_layout = *previous_layout_ptr;
+        auto *previous_data_ptr = static_cast<char *>(previous_data_memory->Ptr());
+        for (const auto block : blocks)
+        {
+            const char *source = previous_layout.GetBlockPtr<char>(previous_data_ptr, block);
+            char *target = shared_layout_ptr->GetBlockPtr<char, true>(shared_memory_ptr, block);
+            std::copy(source, source + shared_layout_ptr->GetBlockSize(block), target);
+        }
+        return true;
+    };
+
+    // Every block has its place in the layout already and is read from its own file, so the
+    // files are loaded concurrently. The large blocks are read straight into the shared memory
+    // with many reads in flight, see util::AsyncIO.
+    util::AsyncIO io;
+    const auto loadNames = [&] {
+        // Loading street names
+        unsigned *name_offsets_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+            shared_memory_ptr, SharedDataLayout::NAME_OFFSETS);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_OFFSETS) > 0)
+        {
+            name_stream.read((char *)name_offsets_ptr,
+                             shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_OFFSETS));
+        }
 
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST) > 0)
-    {
-        name_stream.read(name_char_ptr,
-                         shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST));
-    }
-    name_stream.close();
+        unsigned *name_blocks_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+            shared_memory_ptr, SharedDataLayout::NAME_BLOCKS);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_BLOCKS) > 0)
+        {
+            name_stream.read((char *)name_blocks_ptr,
+                             shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_BLOCKS));
+        }
 
-    // make sure do write canary...
-    auto *turn_lane_data_ptr =
-        shared_layout_ptr->GetBlockPtr<util::guidance::LaneTupelIdPair, true>(
-            shared_memory_ptr, SharedDataLayout::TURN_LANE_DATA);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::TURN_LANE_DATA) > 0)
-    {
-        lane_data_stream.read(reinterpret_cast<char *>(turn_lane_data_ptr),
-                              shared_layout_ptr->GetBlockSize(SharedDataLayout::TURN_LANE_DATA));
-    }
-    lane_data_stream.close();
+        char *name_char_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
+            shared_memory_ptr, SharedDataLayout::NAME_CHAR_LIST);
+        unsigned temp_length = 0;
+        name_stream.read((char *)&temp_length, sizeof(unsigned));
 
-    auto *turn_lane_offset_ptr = shared_layout_ptr->GetBlockPtr<std::uint32_t, true>(
-        shared_memory_ptr, SharedDataLayout::LANE_DESCRIPTION_OFFSETS);
-    if (!lane_description_offsets.empty())
-    {
-        BOOST_ASSERT(shared_layout_ptr->GetBlockSize(SharedDataLayout::LANE_DESCRIPTION_OFFSETS) >=
-                     sizeof(lane_description_offsets[0]) * lane_description_offsets.size());
-        std::copy(
-            lane_description_offsets.begin(), lane_description_offsets.end(), turn_lane_offset_ptr);
-        std::vector<std::uint32_t> tmp;
-        lane_description_offsets.swap(tmp);
-    }
+        BOOST_ASSERT_MSG(shared_layout_ptr->AlignBlockSize(temp_length) ==
+                             shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST),
+                         "Name file corrupted!");
 
-    auto *turn_lane_mask_ptr =
-        shared_layout_ptr->GetBlockPtr<extractor::guidance::TurnLaneType::Mask, true>(
-            shared_memory_ptr, SharedDataLayout::LANE_DESCRIPTION_MASKS);
-    if (!lane_description_masks.empty())
-    {
-        BOOST_ASSERT(shared_layout_ptr->GetBlockSize(SharedDataLayout::LANE_DESCRIPTION_MASKS) >=
-                     sizeof(lane_description_masks[0]) * lane_description_masks.size());
-        std::copy(lane_description_masks.begin(), lane_description_masks.end(), turn_lane_mask_ptr);
-        std::vector<extractor::guidance::TurnLaneType::Mask> tmp;
-        lane_description_masks.swap(tmp);
-    }
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST) > 0)
+        {
+            readAsync(io,
+                      config.names_data_path,
+                      name_stream,
+                      name_char_ptr,
+                      shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST));
+        }
+        name_stream.close();
+    };
+
+    const auto loadLanes = [&] {
+        // make sure do write canary...
+        auto *turn_lane_data_ptr =
+            shared_layout_ptr->GetBlockPtr<util::guidance::LaneTupelIdPair, true>(
+                shared_memory_ptr, SharedDataLayout::TURN_LANE_DATA);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::TURN_LANE_DATA) > 0)
+        {
+            lane_data_stream.read(
+                reinterpret_cast<char *>(turn_lane_data_ptr),
+                shared_layout_ptr->GetBlockSize(SharedDataLayout::TURN_LANE_DATA));
+        }
+        lane_data_stream.close();
 
-    // load original edge information
-    NodeID *via_node_ptr = shared_layout_ptr->GetBlockPtr<NodeID, true>(
-        shared_memory_ptr, SharedDataLayout::VIA_NODE_LIST);
+        auto *turn_lane_offset_ptr = shared_layout_ptr->GetBlockPtr<std::uint32_t, true>(
+            shared_memory_ptr, SharedDataLayout::LANE_DESCRIPTION_OFFSETS);
+        if (!lane_description_offsets.empty())
+        {
+            BOOST_ASSERT(
+                shared_layout_ptr->GetBlockSize(SharedDataLayout::LANE_DESCRIPTION_OFFSETS) >=
+                sizeof(lane_description_offsets[0]) * lane_description_offsets.size());
+            std::copy(lane_description_offsets.begin(),
+                      lane_description_offsets.end(),
+                      turn_lane_offset_ptr);
+            std::vector<std::uint32_t> tmp;
+            lane_description_offsets.swap(tmp);
+        }
 
-    unsigned *name_id_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::NAME_ID_LIST);
+        auto *turn_lane_mask_ptr =
+            shared_layout_ptr->GetBlockPtr<extractor::guidance::TurnLaneType::Mask, true>(
+                shared_memory_ptr, SharedDataLayout::LANE_DESCRIPTION_MASKS);
+        if (!lane_description_masks.empty())
+        {
+            BOOST_ASSERT(
+                shared_layout_ptr->GetBlockSize(SharedDataLayout::LANE_DESCRIPTION_MASKS) >=
+                sizeof(lane_description_masks[0]) * lane_description_masks.size());
+            std::copy(
+                lane_description_masks.begin(), lane_description_masks.end(), turn_lane_mask_ptr);
+            std::vector<extractor::guidance::TurnLaneType::Mask> tmp;
+            lane_description_masks.swap(tmp);
+        }
+    };
 
-    extractor::TravelMode *travel_mode_ptr =
-        shared_layout_ptr->GetBlockPtr<extractor::TravelMode, true>(shared_memory_ptr,
-                                                                    SharedDataLayout::TRAVEL_MODE);
+    const auto loadEdges = [&] {
+        // load original edge information
+        NodeID *via_node_ptr = shared_layout_ptr->GetBlockPtr<NodeID, true>(
+            shared_memory_ptr, SharedDataLayout::VIA_NODE_LIST);
 
-    LaneDataID *lane_data_id_ptr = shared_layout_ptr->GetBlockPtr<LaneDataID, true>(
-        shared_memory_ptr, SharedDataLayout::LANE_DATA_ID);
+        unsigned *name_id_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+            shared_memory_ptr, SharedDataLayout::NAME_ID_LIST);
 
-    extractor::guidance::TurnInstruction *turn_instructions_ptr =
-        shared_layout_ptr->GetBlockPtr<extractor::guidance::TurnInstruction, true>(
-            shared_memory_ptr, SharedDataLayout::TURN_INSTRUCTION);
+        extractor::TravelMode *travel_mode_ptr =
+            shared_layout_ptr->GetBlockPtr<extractor::TravelMode, true>(
+                shared_memory_ptr, SharedDataLayout::TRAVEL_MODE);
 
-    EntryClassID *entry_class_id_ptr = shared_layout_ptr->GetBlockPtr<EntryClassID, true>(
-        shared_memory_ptr, SharedDataLayout::ENTRY_CLASSID);
+        LaneDataID *lane_data_id_ptr = shared_layout_ptr->GetBlockPtr<LaneDataID, true>(
+            shared_memory_ptr, SharedDataLayout::LANE_DATA_ID);
 
-    extractor::OriginalEdgeData current_edge_data;
-    for (unsigned i = 0; i < number_of_original_edges; ++i)
-    {
-        edges_input_stream.read((char *)&(current_edge_data), sizeof(extractor::OriginalEdgeData));
-        via_node_ptr[i] = current_edge_data.via_node;
-        name_id_ptr[i] = current_edge_data.name_id;
-        travel_mode_ptr[i] = current_edge_data.travel_mode;
-        lane_data_id_ptr[i] = current_edge_data.lane_data_id;
-        turn_instructions_ptr[i] = current_edge_data.turn_instruction;
-        entry_class_id_ptr[i] = current_edge_data.entry_classid;
-    }
-    edges_input_stream.close();
+        extractor::guidance::TurnInstruction *turn_instructions_ptr =
+            shared_layout_ptr->GetBlockPtr<extractor::guidance::TurnInstruction, true>(
+                shared_memory_ptr, SharedDataLayout::TURN_INSTRUCTION);
 
-    // load compressed geometry
-    unsigned temporary_value;
-    unsigned *geometries_index_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::GEOMETRIES_INDEX);
-    geometry_input_stream.seekg(0, geometry_input_stream.beg);
-    geometry_input_stream.read((char *)&temporary_value, sizeof(unsigned));
-    BOOST_ASSERT(temporary_value ==
-                 shared_layout_ptr->num_entries[SharedDataLayout::GEOMETRIES_INDEX]);
+        EntryClassID *entry_class_id_ptr = shared_layout_ptr->GetBlockPtr<EntryClassID, true>(
+            shared_memory_ptr, SharedDataLayout::ENTRY_CLASSID);
 
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_INDEX) > 0)
-    {
-        geometry_input_stream.read(
-            (char *)geometries_index_ptr,
-            shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_INDEX));
-    }
-    extractor::CompressedEdgeContainer::CompressedEdge *geometries_list_ptr =
-        shared_layout_ptr->GetBlockPtr<extractor::CompressedEdgeContainer::CompressedEdge, true>(
-            shared_memory_ptr, SharedDataLayout::GEOMETRIES_LIST);
+        // the records are split into one block per field, read them in large chunks
+        std::vector<extractor::OriginalEdgeData> edge_data_buffer(RECORDS_PER_READ);
+        for (unsigned begin = 0; begin < number_of_original_edges; begin += RECORDS_PER_READ)
+        {
+            const unsigned count = std::min(RECORDS_PER_READ, number_of_original_edges - begin);
+            edges_input_stream.read((char *)edge_data_buffer.data(),
+                                    count * sizeof(extractor::OriginalEdgeData));
+            for (unsigned index = 0; index < count; ++index)
+            {
+                const auto &current_edge_data = edge_data_buffer[index];
+                const unsigned i = begin + index;
+                via_node_ptr[i] = current_edge_data.via_node;
+                name_id_ptr[i] = current_edge_data.name_id;
+                travel_mode_ptr[i] = current_edge_data.travel_mode;
+                lane_data_id_ptr[i] = current_edge_data.lane_data_id;
+                turn_instructions_ptr[i] = current_edge_data.turn_instruction;
+                entry_class_id_ptr[i] = current_edge_data.entry_classid;
+            }
+        }
+        edges_input_stream.close();
+    };
+
+    const auto loadGeometries = [&] {
+        // load compressed geometry
+        unsigned temporary_value;
+        unsigned *geometries_index_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+            shared_memory_ptr, SharedDataLayout::GEOMETRIES_INDEX);
+        geometry_input_stream.seekg(0, geometry_input_stream.beg);
+        geometry_input_stream.read((char *)&temporary_value, sizeof(unsigned));
+        BOOST_ASSERT(temporary_value ==
+                     shared_layout_ptr->num_entries[SharedDataLayout::GEOMETRIES_INDEX]);
+
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_INDEX) > 0)
+        {
+            readAsync(io,
+                      config.geometries_path,
+                      geometry_input_stream,
+                      geometries_index_ptr,
+                      shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_INDEX));
+        }
+        // skip the number of points, it is known from the indices
+        geometry_input_stream.read((char *)&temporary_value, sizeof(unsigned));
+
+        std::uint64_t *geometries_block_offsets_ptr =
+            shared_layout_ptr->GetBlockPtr<std::uint64_t, true>(
+                shared_memory_ptr, SharedDataLayout::GEOMETRIES_BLOCK_OFFSETS);
+        geometry_input_stream.read((char *)&temporary_value, sizeof(unsigned));
+        BOOST_ASSERT(temporary_value ==
+                     shared_layout_ptr->num_entries[SharedDataLayout::GEOMETRIES_BLOCK_OFFSETS]);
+        geometry_input_stream.ignore(extractor::detail::blockOffsetsPadding(
+            shared_layout_ptr->num_entries[SharedDataLayout::GEOMETRIES_INDEX]));
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_BLOCK_OFFSETS) > 0)
+        {
+            readAsync(io,
+                      config.geometries_path,
+                      geometry_input_stream,
+                      geometries_block_offsets_ptr,
+                      shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_BLOCK_OFFSETS));
+        }
 
-    geometry_input_stream.read((char *)&temporary_value, sizeof(unsigned));
-    BOOST_ASSERT(temporary_value ==
-                 shared_layout_ptr->num_entries[SharedDataLayout::GEOMETRIES_LIST]);
+        unsigned char *geometries_data_ptr = shared_layout_ptr->GetBlockPtr<unsigned char, true>(
+            shared_memory_ptr, SharedDataLayout::GEOMETRIES_DATA);
+        std::uint64_t number_of_geometry_bytes = 0;
+        geometry_input_stream.read((char *)&number_of_geometry_bytes,
+                                   sizeof(number_of_geometry_bytes));
+        BOOST_ASSERT(number_of_geometry_bytes ==
+                     shared_layout_ptr->num_entries[SharedDataLayout::GEOMETRIES_DATA]);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_DATA) > 0)
+        {
+            readAsync(io,
+                      config.geometries_path,
+                      geometry_input_stream,
+                      geometries_data_ptr,
+                      number_of_geometry_bytes);
+        }
+    };
 
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_LIST) > 0)
-    {
-        geometry_input_stream.read(
-            (char *)geometries_list_ptr,
-            shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_LIST));
-    }
+    const auto loadDatasources = [&] {
+        // load datasource information (if it exists)
+        uint8_t *datasources_list_ptr = shared_layout_ptr->GetBlockPtr<uint8_t, true>(
+            shared_memory_ptr, SharedDataLayout::DATASOURCES_LIST);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCES_LIST) > 0)
+        {
+            readAsync(io,
+                      config.datasource_indexes_path,
+                      geometry_datasource_input_stream,
+                      datasources_list_ptr,
+                      shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCES_LIST));
+        }
 
-    // load datasource information (if it exists)
-    uint8_t *datasources_list_ptr = shared_layout_ptr->GetBlockPtr<uint8_t, true>(
-        shared_memory_ptr, SharedDataLayout::DATASOURCES_LIST);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCES_LIST) > 0)
-    {
-        geometry_datasource_input_stream.read(
-            reinterpret_cast<char *>(datasources_list_ptr),
-            shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCES_LIST));
-    }
+        // load datasource name information (if it exists)
+        char *datasource_name_data_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
+            shared_memory_ptr, SharedDataLayout::DATASOURCE_NAME_DATA);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCE_NAME_DATA) > 0)
+        {
+            util::SimpleLogger().Write()
+                << "Copying " << (m_datasource_name_data.end() - m_datasource_name_data.begin())
+                << " chars into name data ptr";
+            std::copy(m_datasource_name_data.begin(),
+                      m_datasource_name_data.end(),
+                      datasource_name_data_ptr);
+        }
 
-    // load datasource name information (if it exists)
-    char *datasource_name_data_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
-        shared_memory_ptr, SharedDataLayout::DATASOURCE_NAME_DATA);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCE_NAME_DATA) > 0)
-    {
-        util::SimpleLogger().Write()
-            << "Copying " << (m_datasource_name_data.end() - m_datasource_name_data.begin())
-            << " chars into name data ptr";
-        std::copy(
-            m_datasource_name_data.begin(), m_datasource_name_data.end(), datasource_name_data_ptr);
-    }
+        auto datasource_name_offsets_ptr = shared_layout_ptr->GetBlockPtr<std::size_t, true>(
+            shared_memory_ptr, SharedDataLayout::DATASOURCE_NAME_OFFSETS);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCE_NAME_OFFSETS) > 0)
+        {
+            std::copy(m_datasource_name_offsets.begin(),
+                      m_datasource_name_offsets.end(),
+                      datasource_name_offsets_ptr);
+        }
 
-    auto datasource_name_offsets_ptr = shared_layout_ptr->GetBlockPtr<std::size_t, true>(
-        shared_memory_ptr, SharedDataLayout::DATASOURCE_NAME_OFFSETS);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCE_NAME_OFFSETS) > 0)
-    {
-        std::copy(m_datasource_name_offsets.begin(),
-                  m_datasource_name_offsets.end(),
-                  datasource_name_offsets_ptr);
-    }
+        auto datasource_name_lengths_ptr = shared_layout_ptr->GetBlockPtr<std::size_t, true>(
+            shared_memory_ptr, SharedDataLayout::DATASOURCE_NAME_LENGTHS);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCE_NAME_LENGTHS) > 0)
+        {
+            std::copy(m_datasource_name_lengths.begin(),
+                      m_datasource_name_lengths.end(),
+                      datasource_name_lengths_ptr);
+        }
+    };
 
-    auto datasource_name_lengths_ptr = shared_layout_ptr->GetBlockPtr<std::size_t, true>(
-        shared_memory_ptr, SharedDataLayout::DATASOURCE_NAME_LENGTHS);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCE_NAME_LENGTHS) > 0)
-    {
-        std::copy(m_datasource_name_lengths.begin(),
-                  m_datasource_name_lengths.end(),
-                  datasource_name_lengths_ptr);
-    }
+    const auto loadZoomLevels = [&] {
+        std::uint8_t *zoom_levels_ptr = shared_layout_ptr->GetBlockPtr<std::uint8_t, true>(
+            shared_memory_ptr, SharedDataLayout::GEOMETRIES_ZOOM_LEVELS);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_ZOOM_LEVELS) > 0)
+        {
+            readAsync(io,
+                      config.geometry_zoom_levels_path,
+                      geometry_zoom_levels_input_stream,
+                      zoom_levels_ptr,
+                      shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_ZOOM_LEVELS));
+        }
+    };
 
-    // Loading list of coordinates
-    util::Coordinate *coordinates_ptr = shared_layout_ptr->GetBlockPtr<util::Coordinate, true>(
-        shared_memory_ptr, SharedDataLayout::COORDINATE_LIST);
-    std::uint64_t *osmnodeid_ptr = shared_layout_ptr->GetBlockPtr<std::uint64_t, true>(
-        shared_memory_ptr, SharedDataLayout::OSM_NODE_ID_LIST);
-    util::PackedVector<OSMNodeID, true> osmnodeid_list;
-    osmnodeid_list.reset(
-        osmnodeid_ptr, shared_layout_ptr->num_entries[storage::SharedDataLayout::OSM_NODE_ID_LIST]);
+    const auto loadLengths = [&] {
+        SegmentLength *lengths_ptr = shared_layout_ptr->GetBlockPtr<SegmentLength, true>(
+            shared_memory_ptr, SharedDataLayout::GEOMETRIES_LENGTHS);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_LENGTHS) > 0)
+        {
+            readAsync(io,
+                      config.geometry_lengths_path,
+                      geometry_lengths_input_stream,
+                      lengths_ptr,
+                      shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_LENGTHS));
+        }
+    };
+
+    const auto loadNodes = [&] {
+        // Loading list of coordinates
+        util::Coordinate *coordinates_ptr = shared_layout_ptr->GetBlockPtr<util::Coordinate, true>(
+            shared_memory_ptr, SharedDataLayout::COORDINATE_LIST);
+        std::uint64_t *osmnodeid_ptr = shared_layout_ptr->GetBlockPtr<std::uint64_t, true>(
+            shared_memory_ptr, SharedDataLayout::OSM_NODE_ID_LIST);
+        util::PackedVector<OSMNodeID, true> osmnodeid_list;
+        osmnodeid_list.reset(
+            osmnodeid_ptr,
+            shared_layout_ptr->num_entries[storage::SharedDataLayout::OSM_NODE_ID_LIST]);
+
+        std::vector<extractor::QueryNode> node_buffer(RECORDS_PER_READ);
+        for (unsigned begin = 0; begin < coordinate_list_size; begin += RECORDS_PER_READ)
+        {
+            const unsigned count = std::min(RECORDS_PER_READ, coordinate_list_size - begin);
+            nodes_input_stream.read((char *)node_buffer.data(),
+                                    count * sizeof(extractor::QueryNode));
+            for (unsigned index = 0; index < count; ++index)
+            {
+                const auto &current_node = node_buffer[index];
+                coordinates_ptr[begin + index] =
+                    util::Coordinate(current_node.lon, current_node.lat);
+                osmnodeid_list.push_back(current_node.node_id);
+            }
+        }
+        nodes_input_stream.close();
+    };
 
-    extractor::QueryNode current_node;
-    for (unsigned i = 0; i < coordinate_list_size; ++i)
-    {
-        nodes_input_stream.read((char *)&current_node, sizeof(extractor::QueryNode));
-        coordinates_ptr[i] = util::Coordinate(current_node.lon, current_node.lat);
-        osmnodeid_list.push_back(current_node.node_id);
-    }
-    nodes_input_stream.close();
+    const auto loadRTree = [&] {
+        // store search tree portion of rtree
+        char *rtree_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
+            shared_memory_ptr, SharedDataLayout::R_SEARCH_TREE);
 
-    // store timestamp
-    char *timestamp_ptr =
-        shared_layout_ptr->GetBlockPtr<char, true>(shared_memory_ptr, SharedDataLayout::TIMESTAMP);
-    std::copy(m_timestamp.c_str(), m_timestamp.c_str() + m_timestamp.length(), timestamp_ptr);
+        if (tree_size > 0)
+        {
+            readAsync(io,
+                      config.ram_index_path,
+                      tree_node_file,
+                      rtree_ptr,
+                      sizeof(RTreeNode) * tree_size);
+        }
+        tree_node_file.close();
+    };
+
+    const auto loadCoreMarkers = [&] {
+        // load core markers
+        std::vector<char> unpacked_core_markers(number_of_core_markers);
+        core_marker_file.read((char *)unpacked_core_markers.data(),
+                              sizeof(char) * number_of_core_markers);
+
+        auto core_marker_ptr = shared_layout_ptr->GetBlockPtr<util::PackedBitsetView::Word, true>(
+            shared_memory_ptr, SharedDataLayout::CORE_MARKER);
+        util::PackedBitsetView::Pack(
+            unpacked_core_markers.data(), number_of_core_markers, core_marker_ptr);
+    };
+
+    const auto loadLandmarks = [&] {
+        // load landmarks, the ids of the landmarks themselves are not needed for queries
+        NodeID *landmark_core_nodes_ptr = shared_layout_ptr->GetBlockPtr<NodeID, true>(
+            shared_memory_ptr, SharedDataLayout::LANDMARK_CORE_NODES);
+        EdgeWeight *landmark_distances_ptr = shared_layout_ptr->GetBlockPtr<EdgeWeight, true>(
+            shared_memory_ptr, SharedDataLayout::LANDMARK_DISTANCES);
+        if (number_of_landmarks > 0)
+        {
+            landmarks_file.ignore(sizeof(NodeID) * number_of_landmarks);
+            readAsync(io,
+                      config.landmarks_data_path,
+                      landmarks_file,
+                      landmark_core_nodes_ptr,
+                      shared_layout_ptr->GetBlockSize(SharedDataLayout::LANDMARK_CORE_NODES));
+            readAsync(io,
+                      config.landmarks_data_path,
+                      landmarks_file,
+                      landmark_distances_ptr,
+                      shared_layout_ptr->GetBlockSize(SharedDataLayout::LANDMARK_DISTANCES));
+        }
+    };
+
+    const auto loadHubLabels = [&] {
+        std::uint64_t *offsets_ptr = shared_layout_ptr->GetBlockPtr<std::uint64_t, true>(
+            shared_memory_ptr, SharedDataLayout::HUB_LABEL_OFFSETS);
+        NodeID *hubs_ptr = shared_layout_ptr->GetBlockPtr<NodeID, true>(
+            shared_memory_ptr, SharedDataLayout::HUB_LABEL_HUBS);
+        EdgeWeight *weights_ptr = shared_layout_ptr->GetBlockPtr<EdgeWeight, true>(
+            shared_memory_ptr, SharedDataLayout::HUB_LABEL_WEIGHTS);
+        if (number_of_hub_label_nodes > 0)
+        {
+            readAsync(io,
+                      config.hub_labels_data_path,
+                      hub_labels_file,
+                      offsets_ptr,
+                      shared_layout_ptr->GetBlockSize(SharedDataLayout::HUB_LABEL_OFFSETS));
+            readAsync(io,
+                      config.hub_labels_data_path,
+                      hub_labels_file,
+                      hubs_ptr,
+                      shared_layout_ptr->GetBlockSize(SharedDataLayout::HUB_LABEL_HUBS));
+            readAsync(io,
+                      config.hub_labels_data_path,
+                      hub_labels_file,
+                      weights_ptr,
+                      shared_layout_ptr->GetBlockSize(SharedDataLayout::HUB_LABEL_WEIGHTS));
+        }
+    };
 
-    // store search tree portion of rtree
-    char *rtree_ptr = shared_layout_ptr->GetBlockPtr<char, true>(shared_memory_ptr,
-                                                                 SharedDataLayout::R_SEARCH_TREE);
+    const auto loadMultiLevelData = [&] {
+        if (number_of_mld_graph_nodes == 0)
+        {
+            return;
+        }
+        // the graph and the cells are read in the order of their files
+        for (const auto block : {SharedDataLayout::MLD_GRAPH_NODE_LIST,
+                                 SharedDataLayout::MLD_GRAPH_SEARCH_EDGE_LIST,
+                                 SharedDataLayout::MLD_GRAPH_UNPACK_EDGE_LIST})
+        {
+            readAsync(io,
+                      config.mld_graph_data_path,
+                      mld_graph_file,
+                      shared_layout_ptr->GetBlockPtr<char, true>(shared_memory_ptr, block),
+                      shared_layout_ptr->GetBlockSize(block));
+        }
+        for (const auto block : {SharedDataLayout::MLD_CELLS,
+                                 SharedDataLayout::MLD_LEVEL_OFFSETS,
+                                 SharedDataLayout::MLD_NODE_CELLS,
+                                 SharedDataLayout::MLD_CELL_SOURCES,
+                                 SharedDataLayout::MLD_CELL_DESTINATIONS,
+                                 SharedDataLayout::MLD_CELL_WEIGHTS,
+                                 SharedDataLayout::MLD_EDGE_WEIGHTS,
+                                 SharedDataLayout::MLD_METRIC_EDGE_WEIGHTS,
+                                 SharedDataLayout::MLD_EXCLUDE_MASKS,
+                                 SharedDataLayout::MLD_NODE_CLASSES,
+                                 SharedDataLayout::MLD_CLASS_NAMES,
+                                 SharedDataLayout::MLD_EDGE_WEIGHT_NAMES})
+        {
+            readAsync(io,
+                      config.cells_data_path,
+                      cells_file,
+                      shared_layout_ptr->GetBlockPtr<char, true>(shared_memory_ptr, block),
+                      shared_layout_ptr->GetBlockSize(block));
+        }
+    };
+
+    const auto loadGraph = [&] {
+        // load the nodes of the search graph
+        QueryGraph::NodeArrayEntry *graph_node_list_ptr =
+            shared_layout_ptr->GetBlockPtr<QueryGraph::NodeArrayEntry, true>(
+                shared_memory_ptr, SharedDataLayout::GRAPH_NODE_LIST);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GRAPH_NODE_LIST) > 0)
+        {
+            readAsync(io,
+                      config.hsgr_data_path,
+                      hsgr_input_stream,
+                      graph_node_list_ptr,
+                      shared_layout_ptr->GetBlockSize(SharedDataLayout::GRAPH_NODE_LIST));
+        }
 
-    if (tree_size > 0)
-    {
-        tree_node_file.read(rtree_ptr, sizeof(RTreeNode) * tree_size);
-    }
-    tree_node_file.close();
+        // load the edges of the search graph, the data for searches comes first
+        for (const auto block :
+             {SharedDataLayout::GRAPH_SEARCH_EDGE_LIST, SharedDataLayout::GRAPH_UNPACK_EDGE_LIST})
+        {
+            auto graph_edge_list_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
+                shared_memory_ptr, block);
+            if (shared_layout_ptr->GetBlockSize(block) > 0)
+            {
+                readAsync(io,
+                          config.hsgr_data_path,
+                          hsgr_input_stream,
+                          graph_edge_list_ptr,
+                          shared_layout_ptr->GetBlockSize(block));
+            }
+        }
+        hsgr_input_stream.close();
+    };
+
+    const auto loadClasses = [&] {
+        // load profile properties
+        auto profile_properties_ptr =
+            shared_layout_ptr->GetBlockPtr<extractor::ProfileProperties, true>(
+                shared_memory_ptr, SharedDataLayout::PROPERTIES);
+        boost::filesystem::ifstream profile_properties_stream(config.properties_path);
+        if (!profile_properties_stream)
+        {
+            util::exception("Could not open " + config.properties_path.string() + " for reading!");
+        }
+        // files of older versions are shorter and leave the new fields at their defaults
+        new (profile_properties_ptr) extractor::ProfileProperties();
+        profile_properties_stream.read(reinterpret_cast<char *>(profile_properties_ptr),
+                                       sizeof(extractor::ProfileProperties));
 
-    // load core markers
-    std::vector<char> unpacked_core_markers(number_of_core_markers);
-    core_marker_file.read((char *)unpacked_core_markers.data(),
-                          sizeof(char) * number_of_core_markers);
+        // load intersection classes
+        if (!bearing_class_id_table.empty())
+        {
+            auto bearing_id_ptr = shared_layout_ptr->GetBlockPtr<BearingClassID, true>(
+                shared_memory_ptr, SharedDataLayout::BEARING_CLASSID);
+            std::copy(bearing_class_id_table.begin(), bearing_class_id_table.end(), bearing_id_ptr);
+        }
 
-    unsigned *core_marker_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::CORE_MARKER);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::BEARING_OFFSETS) > 0)
+        {
+            auto *bearing_offsets_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+                shared_memory_ptr, SharedDataLayout::BEARING_OFFSETS);
+            std::copy(
+                bearing_offsets_data.begin(), bearing_offsets_data.end(), bearing_offsets_ptr);
+        }
 
-    for (auto i = 0u; i < number_of_core_markers; ++i)
-    {
-        BOOST_ASSERT(unpacked_core_markers[i] == 0 || unpacked_core_markers[i] == 1);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::BEARING_BLOCKS) > 0)
+        {
+            auto *bearing_blocks_ptr =
+                shared_layout_ptr->GetBlockPtr<typename util::RangeTable<16, true>::BlockT, true>(
+                    shared_memory_ptr, SharedDataLayout::BEARING_BLOCKS);
+            std::copy(bearing_blocks_data.begin(), bearing_blocks_data.end(), bearing_blocks_ptr);
+        }
 
-        if (unpacked_core_markers[i] == 1)
+        if (!bearing_class_table.empty())
         {
-            const unsigned bucket = i / 32;
-            const unsigned offset = i % 32;
-            const unsigned value = [&] {
-                unsigned return_value = 0;
-                if (0 != offset)
-                {
-                    return_value = core_marker_ptr[bucket];
-                }
-                return return_value;
-            }();
+            auto bearing_class_ptr = shared_layout_ptr->GetBlockPtr<DiscreteBearing, true>(
+                shared_memory_ptr, SharedDataLayout::BEARING_VALUES);
+            std::copy(bearing_class_table.begin(), bearing_class_table.end(), bearing_class_ptr);
+        }
 
-            core_marker_ptr[bucket] = (value | (1u << offset));
+        if (!entry_class_table.empty())
+        {
+            auto entry_class_ptr = shared_layout_ptr->GetBlockPtr<util::guidance::EntryClass, true>(
+                shared_memory_ptr, SharedDataLayout::ENTRY_CLASS);
+            std::copy(entry_class_table.begin(), entry_class_table.end(), entry_class_ptr);
         }
-    }
+    };
+
+    // the geometries hold the weights of the segments, the graph those of the edges
+    tbb::parallel_invoke(
+        [&] {
+            if (!reuseBlocks({SharedDataLayout::NAME_OFFSETS,
+                              SharedDataLayout::NAME_BLOCKS,
+                              SharedDataLayout::NAME_CHAR_LIST}))
+            {
+                loadNames();
+            }
+        },
+        [&] {
+            if (!reuseBlocks({SharedDataLayout::TURN_LANE_DATA,
+                              SharedDataLayout::LANE_DESCRIPTION_OFFSETS,
+                              SharedDataLayout::LANE_DESCRIPTION_MASKS}))
+            {
+                loadLanes();
+            }
+            if (!reuseBlocks({SharedDataLayout::PROPERTIES,
+                              SharedDataLayout::BEARING_CLASSID,
+                              SharedDataLayout::BEARING_OFFSETS,
+                              SharedDataLayout::BEARING_BLOCKS,
+                              SharedDataLayout::BEARING_VALUES,
+                              SharedDataLayout::ENTRY_CLASS}))
+            {
+                loadClasses();
+            }
+        },
+        [&] {
+            if (!reuseBlocks({SharedDataLayout::VIA_NODE_LIST,
+                              SharedDataLayout::NAME_ID_LIST,
+                              SharedDataLayout::TURN_INSTRUCTION,
+                              SharedDataLayout::LANE_DATA_ID,
+                              SharedDataLayout::TRAVEL_MODE,
+                              SharedDataLayout::ENTRY_CLASSID}))
+            {
+                loadEdges();
+            }
+        },
+        [&] {
+            loadGeometries();
+            loadZoomLevels();
+            loadLengths();
+        },
+        loadDatasources,
+        [&] {
+            if (!reuseBlocks(
+                    {SharedDataLayout::COORDINATE_LIST, SharedDataLayout::OSM_NODE_ID_LIST}))
+            {
+                loadNodes();
+            }
+        },
+        [&] {
+            if (!reuseBlocks({SharedDataLayout::R_SEARCH_TREE}))
+            {
+                loadRTree();
+            }
+        },
+        loadCoreMarkers,
+        // parallel_invoke takes at most ten functions
+        [&] {
+            loadLandmarks();
+            loadHubLabels();
+            loadMultiLevelData();
+        },
+        loadGraph);
+    io.Wait();
+    previous_data_memory.reset();
+    previous_layout_memory.reset();
 
-    // load the nodes of the search graph
-    QueryGraph::NodeArrayEntry *graph_node_list_ptr =
-        shared_layout_ptr->GetBlockPtr<QueryGraph::NodeArrayEntry, true>(
-            shared_memory_ptr, SharedDataLayout::GRAPH_NODE_LIST);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GRAPH_NODE_LIST) > 0)
     {
-        hsgr_input_stream.read((char *)graph_node_list_ptr,
-                               shared_layout_ptr->GetBlockSize(SharedDataLayout::GRAPH_NODE_LIST));
-    }
+        boost::interprocess::scoped_lock<SharedBarriers::SharableMutex> query_lock(
+            barrier.query_mutex);
 
-    // load the edges of the search graph
-    QueryGraph::EdgeArrayEntry *graph_edge_list_ptr =
-        shared_layout_ptr->GetBlockPtr<QueryGraph::EdgeArrayEntry, true>(
-            shared_memory_ptr, SharedDataLayout::GRAPH_EDGE_LIST);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GRAPH_EDGE_LIST) > 0)
-    {
-        hsgr_input_stream.read((char *)graph_edge_list_ptr,
-                               shared_layout_ptr->GetBlockSize(SharedDataLayout::GRAPH_EDGE_LIST));
-    }
-    hsgr_input_stream.close();
+        data_timestamp_ptr->layout = layout_region;
+        data_timestamp_ptr->data = data_region;
+        data_timestamp_ptr->timestamp += 1;
+        data_timestamp_ptr->generations[slot].timestamp = data_timestamp_ptr->timestamp;
 
-    // load profile properties
-    auto profile_properties_ptr =
-        shared_layout_ptr->GetBlockPtr<extractor::ProfileProperties, true>(
-            shared_memory_ptr, SharedDataLayout::PROPERTIES);
-    boost::filesystem::ifstream profile_properties_stream(config.properties_path);
-    if (!profile_properties_stream)
-    {
-        util::exception("Could not open " + config.properties_path.string() + " for reading!");
+        // the last facade that releases the previous dataset removes it otherwise
+        const auto previous_slot = getDatasetSlot(previous_layout_region);
+        if (previous_slot != NUM_DATASET_SLOTS)
+        {
+            auto &previous_generation = data_timestamp_ptr->generations[previous_slot];
+            if (previous_generation.references == 0)
+            {
+                deleteRegion(previous_data_region);
+                deleteRegion(previous_layout_region);
+                previous_generation.timestamp = 0;
+            }
+            else
+            {
+                util::SimpleLogger().Write() << "the previous dataset stays loaded for the "
+                                             << previous_generation.references
+                                             << " facades that use it";
+            }
+        }
     }
-    profile_properties_stream.read(reinterpret_cast<char *>(profile_properties_ptr),
-                                   sizeof(extractor::ProfileProperties));
+    util::SimpleLogger().Write() << "all data loaded";
 
-    // load intersection classes
-    if (!bearing_class_id_table.empty())
-    {
-        auto bearing_id_ptr = shared_layout_ptr->GetBlockPtr<BearingClassID, true>(
-            shared_memory_ptr, SharedDataLayout::BEARING_CLASSID);
-        std::copy(bearing_class_id_table.begin(), bearing_class_id_table.end(), bearing_id_ptr);
-    }
+    return EXIT_SUCCESS;
+}
 
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::BEARING_OFFSETS) > 0)
+bool logCurrentLayout()
+{
+    if (!SharedMemory::RegionExists(CURRENT_REGIONS))
     {
-        auto *bearing_offsets_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-            shared_memory_ptr, SharedDataLayout::BEARING_OFFSETS);
-        std::copy(bearing_offsets_data.begin(), bearing_offsets_data.end(), bearing_offsets_ptr);
+        return false;
     }
-
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::BEARING_BLOCKS) > 0)
+    const std::unique_ptr<SharedMemory> timestamp_memory(makeSharedMemory(CURRENT_REGIONS));
+    const auto &regions = *static_cast<const SharedDataTimestamp *>(timestamp_memory->Ptr());
+    const auto slot = getDatasetSlot(regions.layout);
+    if (slot == NUM_DATASET_SLOTS || !SharedMemory::RegionExists(regions.layout))
     {
-        auto *bearing_blocks_ptr =
-            shared_layout_ptr->GetBlockPtr<typename util::RangeTable<16, true>::BlockT, true>(
-                shared_memory_ptr, SharedDataLayout::BEARING_BLOCKS);
-        std::copy(bearing_blocks_data.begin(), bearing_blocks_data.end(), bearing_blocks_ptr);
+        return false;
     }
+    const std::unique_ptr<SharedMemory> layout_memory(makeSharedMemory(regions.layout));
+    const auto &layout = *static_cast<const SharedDataLayout *>(layout_memory->Ptr());
 
-    if (!bearing_class_table.empty())
+    std::vector<SharedDataLayout::BlockID> blocks;
+    for (int block = 0; block < SharedDataLayout::NUM_BLOCKS; ++block)
     {
-        auto bearing_class_ptr = shared_layout_ptr->GetBlockPtr<DiscreteBearing, true>(
-            shared_memory_ptr, SharedDataLayout::BEARING_VALUES);
-        std::copy(bearing_class_table.begin(), bearing_class_table.end(), bearing_class_ptr);
+        const auto block_id = static_cast<SharedDataLayout::BlockID>(block);
+        if (layout.GetBlockSize(block_id) > 0)
+        {
+            blocks.push_back(block_id);
+        }
     }
-
-    if (!entry_class_table.empty())
+    std::stable_sort(blocks.begin(),
+                     blocks.end(),
+                     [&](const SharedDataLayout::BlockID lhs, const SharedDataLayout::BlockID rhs) {
+                         return layout.GetBlockSize(lhs) > layout.GetBlockSize(rhs);
+                     });
+
+    const auto total_size = layout.GetSizeOfLayout();
+    util::SimpleLogger().Write() << "dataset " << regions.timestamp << " in slot " << slot + 1
+                                 << ": " << (total_size >> 20) << " MB in " << blocks.size()
+                                 << " blocks, huge pages of " << layout.huge_page_size << " bytes";
+    for (const auto block_id : blocks)
     {
-        auto entry_class_ptr = shared_layout_ptr->GetBlockPtr<util::guidance::EntryClass, true>(
-            shared_memory_ptr, SharedDataLayout::ENTRY_CLASS);
-        std::copy(entry_class_table.begin(), entry_class_table.end(), entry_class_ptr);
+        const auto size = layout.GetBlockSize(block_id);
+        util::SimpleLogger().Write() << "  " << block_id_to_name[block_id] << ": "
+                                     << layout.num_entries[block_id] << " entries of "
+                                     << layout.entry_size[block_id] << " bytes, " << (size >> 10)
+                                     << " KB (" << std::fixed << std::setprecision(1)
+                                     << 100. * size / total_size << "%)";
     }
-
-    // acquire lock
-    SharedMemory *data_type_memory =
-        makeSharedMemory(CURRENT_REGIONS, sizeof(SharedDataTimestamp), true, false);
-    SharedDataTimestamp *data_timestamp_ptr =
-        static_cast<SharedDataTimestamp *>(data_type_memory->Ptr());
-
+    for (unsigned other_slot = 0; other_slot < NUM_DATASET_SLOTS; ++other_slot)
     {
-        boost::interprocess::scoped_lock<boost::interprocess::named_sharable_mutex> query_lock(barrier.query_mutex);
-
-        data_timestamp_ptr->layout = layout_region;
-        data_timestamp_ptr->data = data_region;
-        data_timestamp_ptr->timestamp += 1;
-        deleteRegion(previous_data_region);
-        deleteRegion(previous_layout_region);
+        const auto &generation = regions.generations[other_slot];
+        if (other_slot != slot && generation.timestamp > 0)
+        {
+            util::SimpleLogger().Write() << "outdated dataset " << generation.timestamp
+                                         << " in slot " << other_slot + 1 << ": used by "
+                                         << generation.references << " facades";
+        }
     }
-    util::SimpleLogger().Write() << "all data loaded";
-
-    return EXIT_SUCCESS;
+    return true;
 }
 }
 }
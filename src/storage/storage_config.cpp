@@ -12,17 +12,84 @@ StorageConfig::StorageConfig(const boost::filesystem::path &base)
     : ram_index_path{base.string() + ".ramIndex"}, file_index_path{base.string() + ".fileIndex"},
       hsgr_data_path{base.string() + ".hsgr"}, nodes_data_path{base.string() + ".nodes"},
       edges_data_path{base.string() + ".edges"}, core_data_path{base.string() + ".core"},
-      geometries_path{base.string() + ".geometry"}, timestamp_path{base.string() + ".timestamp"},
+      landmarks_data_path{base.string() + ".landmarks"},
+      hub_labels_data_path{base.string() + ".hub_labels"},
+      mld_graph_data_path{base.string() + ".mldgr"}, cells_data_path{base.string() + ".cells"},
+      geometries_path{base.string() + ".geometry"},
+      geometry_zoom_levels_path{base.string() + ".geometry_zoom_levels"},
+      geometry_lengths_path{base.string() + ".geometry_lengths"},
+      timestamp_path{base.string() + ".timestamp"},
       datasource_names_path{base.string() + ".datasource_names"},
       datasource_indexes_path{base.string() + ".datasource_indexes"},
       names_data_path{base.string() + ".names"}, properties_path{base.string() + ".properties"},
       intersection_class_path{base.string() + ".icd"}, turn_lane_data_path{base.string() + ".tld"},
-      turn_lane_description_path{base.string() + ".tls"}
+      turn_lane_description_path{base.string() + ".tls"},
+      container_path{base.string() + ".container"}
 {
 }
 
+std::vector<boost::filesystem::path> StorageConfig::GetContainerFiles() const
+{
+    std::vector<boost::filesystem::path> files = {hsgr_data_path,
+                                                  nodes_data_path,
+                                                  edges_data_path,
+                                                  core_data_path,
+                                                  geometries_path,
+                                                  timestamp_path,
+                                                  datasource_names_path,
+                                                  datasource_indexes_path,
+                                                  names_data_path,
+                                                  properties_path,
+                                                  intersection_class_path,
+                                                  turn_lane_data_path,
+                                                  turn_lane_description_path};
+    if (boost::filesystem::exists(landmarks_data_path))
+    {
+        files.push_back(landmarks_data_path);
+    }
+    if (boost::filesystem::exists(hub_labels_data_path))
+    {
+        files.push_back(hub_labels_data_path);
+    }
+    if (boost::filesystem::exists(mld_graph_data_path) &&
+        boost::filesystem::exists(cells_data_path))
+    {
+        files.push_back(mld_graph_data_path);
+        files.push_back(cells_data_path);
+    }
+    if (boost::filesystem::exists(geometry_zoom_levels_path))
+    {
+        files.push_back(geometry_zoom_levels_path);
+    }
+    if (boost::filesystem::exists(geometry_lengths_path))
+    {
+        files.push_back(geometry_lengths_path);
+    }
+    return files;
+}
+
+std::vector<boost::filesystem::path> StorageConfig::GetCompressibleFiles() const
+{
+    return {hsgr_data_path, geometries_path, file_index_path, edges_data_path, nodes_data_path};
+}
+
 bool StorageConfig::IsValid() const
 {
+    // a container replaces all files besides the r-tree
+    if (boost::filesystem::is_regular_file(container_path))
+    {
+        bool success = true;
+        for (const auto &path : {ram_index_path, file_index_path})
+        {
+            if (!boost::filesystem::is_regular_file(path))
+            {
+                util::SimpleLogger().Write(logWARNING) << "Missing/Broken File: " << path.string();
+                success = false;
+            }
+        }
+        return success;
+    }
+
     const constexpr auto num_files = 13;
     const boost::filesystem::path paths[num_files] = {ram_index_path,
                                                       file_index_path,
@@ -0,0 +1,156 @@
+#include "storage/traffic_overlay.hpp"
+#include "storage/shared_barriers.hpp"
+#include "storage/shared_datatype.hpp"
+#include "storage/shared_memory.hpp"
+
+#include "util/exception.hpp"
+#include "util/simple_logger.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/interprocess/sync/sharable_lock.hpp>
+#include <boost/optional.hpp>
+#include <boost/spirit/include/qi.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+namespace osrm
+{
+namespace storage
+{
+
+namespace
+{
+// at the start of the TRAFFIC_OVERLAY region, followed by the penalties
+struct SharedTrafficOverlayHeader
+{
+    std::uint64_t version;
+    std::uint64_t number_of_penalties;
+};
+}
+
+std::vector<TrafficPenalty> readTrafficPenaltyFile(const std::string &filename)
+{
+    boost::filesystem::ifstream input(filename);
+    if (!input)
+    {
+        throw util::exception("Could not open traffic penalty file " + filename);
+    }
+
+    namespace qi = boost::spirit::qi;
+    std::vector<TrafficPenalty> penalties;
+    std::string line;
+    std::size_t line_number = 0;
+    while (std::getline(input, line))
+    {
+        ++line_number;
+        if (line.empty())
+        {
+            continue;
+        }
+
+        NodeID node = SPECIAL_NODEID;
+        // empty for a closed node
+        boost::optional<double> seconds;
+        auto begin = line.cbegin();
+        const auto end = line.cend();
+        const bool ok = qi::parse(begin,
+                                  end,
+                                  qi::uint_ >> ',' >> (qi::lit("closed") | qi::double_) >>
+                                      -qi::lit('\r'),
+                                  node,
+                                  seconds);
+        if (!ok || begin != end || (seconds && (*seconds < 0 || !std::isfinite(*seconds))))
+        {
+            throw util::exception("Traffic penalty file " + filename + " malformed on line " +
+                                  std::to_string(line_number));
+        }
+        // the weights are in deci-seconds
+        penalties.push_back(
+            {node, seconds ? static_cast<EdgeWeight>(std::lround(*seconds * 10)) : TRAFFIC_CLOSED});
+    }
+    return penalties;
+}
+
+std::uint64_t writeSharedTrafficOverlay(const std::vector<TrafficPenalty> &penalties)
+{
+    SharedBarriers barriers;
+    boost::interprocess::scoped_lock<SharedBarriers::SharableMutex> traffic_lock(
+        barriers.traffic_mutex);
+
+    std::uint64_t version = 1;
+    if (SharedMemory::RegionExists(TRAFFIC_OVERLAY))
+    {
+        std::unique_ptr<SharedMemory> previous(makeSharedMemory(TRAFFIC_OVERLAY));
+        version += static_cast<const SharedTrafficOverlayHeader *>(previous->Ptr())->version;
+    }
+
+    std::vector<TrafficPenalty> sorted_penalties(penalties);
+    // a later penalty of a node takes precedence over the earlier ones
+    std::stable_sort(sorted_penalties.begin(),
+                     sorted_penalties.end(),
+                     [](const TrafficPenalty &lhs, const TrafficPenalty &rhs) {
+                         return lhs.node < rhs.node;
+                     });
+    std::vector<TrafficPenalty> unique_penalties;
+    for (const auto &penalty : sorted_penalties)
+    {
+        if (!unique_penalties.empty() && unique_penalties.back().node == penalty.node)
+        {
+            unique_penalties.back() = penalty;
+        }
+        else
+        {
+            unique_penalties.push_back(penalty);
+        }
+    }
+
+    const auto size = sizeof(SharedTrafficOverlayHeader) +
+                      unique_penalties.size() * sizeof(TrafficPenalty);
+    // The region has to outlive this process, so it is never removed by SharedMemory. Engines
+    // that attached the previous region keep it until they detach, which is right after reading.
+    auto *memory = makeSharedMemory(TRAFFIC_OVERLAY, size, true, true);
+    auto *header = static_cast<SharedTrafficOverlayHeader *>(memory->Ptr());
+    header->version = version;
+    header->number_of_penalties = unique_penalties.size();
+    if (!unique_penalties.empty())
+    {
+        std::memcpy(header + 1, unique_penalties.data(), size - sizeof(*header));
+    }
+
+    util::SimpleLogger().Write() << "wrote " << unique_penalties.size()
+                                 << " traffic penalties as version " << version;
+    return version;
+}
+
+bool readSharedTrafficOverlay(const std::uint64_t known_version,
+                              std::uint64_t &version,
+                              std::vector<TrafficPenalty> &penalties)
+{
+    SharedBarriers barriers;
+    boost::interprocess::sharable_lock<SharedBarriers::SharableMutex> traffic_lock(
+        barriers.traffic_mutex);
+
+    if (!SharedMemory::RegionExists(TRAFFIC_OVERLAY))
+    {
+        version = 0;
+        penalties.clear();
+        return known_version != version;
+    }
+
+    std::unique_ptr<SharedMemory> memory(makeSharedMemory(TRAFFIC_OVERLAY));
+    const auto *header = static_cast<const SharedTrafficOverlayHeader *>(memory->Ptr());
+    version = header->version;
+    if (version == known_version)
+    {
+        return false;
+    }
+    const auto *begin = reinterpret_cast<const TrafficPenalty *>(header + 1);
+    penalties.assign(begin, begin + header->number_of_penalties);
+    return true;
+}
+}
+}
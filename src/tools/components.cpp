@@ -8,8 +8,13 @@
 #include "util/simple_logger.hpp"
 #include "util/static_graph.hpp"
 #include "util/typedefs.hpp"
+#include "util/version.hpp"
 
 #include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 #if defined(__APPLE__) || defined(_WIN32)
 #include <gdal.h>
@@ -21,8 +26,11 @@
 
 #include "osrm/coordinate.hpp"
 
+#include <algorithm>
 #include <fstream>
+#include <iomanip>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -31,6 +39,25 @@ namespace osrm
 namespace tools
 {
 
+struct ComponentsConfig
+{
+    boost::filesystem::path input_path;
+    boost::filesystem::path output_path;
+    std::string bbox;
+    unsigned max_size;
+
+    // set from bbox if given
+    bool restricted = false;
+    util::Coordinate south_west;
+    util::Coordinate north_east;
+
+    bool Contains(const extractor::QueryNode &node) const
+    {
+        return !restricted || (node.lon >= south_west.lon && node.lon <= north_east.lon &&
+                               node.lat >= south_west.lat && node.lat <= north_east.lat);
+    }
+};
+
 struct TarjanEdgeData
 {
     TarjanEdgeData() : distance(INVALID_EDGE_WEIGHT), name_id(INVALID_NAMEID) {}
@@ -42,6 +69,15 @@ struct TarjanEdgeData
 using TarjanGraph = util::StaticGraph<TarjanEdgeData>;
 using TarjanEdge = TarjanGraph::InputEdge;
 
+// An edge of a small component in the output
+struct ComponentEdge
+{
+    NodeID source;
+    NodeID target;
+    unsigned component_id;
+    unsigned component_size;
+};
+
 void deleteFileIfExists(const std::string &file_name)
 {
     if (boost::filesystem::exists(file_name))
@@ -50,11 +86,15 @@ void deleteFileIfExists(const std::string &file_name)
     }
 }
 
-std::size_t loadGraph(const char *path,
+// Loads the node-based graph, with only the edges that have both ends in the bounding box of the
+// config if it has one. The nodes outside of it are kept, as the ids of the edges refer to them,
+// and end up as components of size one without any edges.
+std::size_t loadGraph(const ComponentsConfig &config,
                       std::vector<extractor::QueryNode> &coordinate_list,
                       std::vector<TarjanEdge> &graph_edge_list)
 {
-    std::ifstream input_stream(path, std::ifstream::in | std::ifstream::binary);
+    std::ifstream input_stream(config.input_path.string(),
+                               std::ifstream::in | std::ifstream::binary);
     if (!input_stream.is_open())
     {
         throw util::exception("Cannot open osrm file");
@@ -80,6 +120,11 @@ std::size_t loadGraph(const char *path,
         {
             continue;
         }
+        if (!config.Contains(coordinate_list[input_edge.source]) ||
+            !config.Contains(coordinate_list[input_edge.target]))
+        {
+            continue;
+        }
 
         if (input_edge.forward)
         {
@@ -99,132 +144,368 @@ std::size_t loadGraph(const char *path,
 
     return number_of_nodes;
 }
-}
-}
 
-int main(int argc, char *argv[])
+// Receives the edges of the small components one block after the other, so that the output
+// never has to be held in memory as a whole
+class ComponentWriter
 {
-    std::vector<osrm::extractor::QueryNode> coordinate_list;
-    osrm::util::LogPolicy::GetInstance().Unmute();
+  public:
+    virtual ~ComponentWriter() = default;
+    virtual void Write(const std::vector<extractor::QueryNode> &coordinate_list,
+                       const std::vector<ComponentEdge> &edges) = 0;
+    virtual void Finish() = 0;
+};
 
-    // enable logging
-    if (argc < 2)
+// The ESRI shapefile written by GDAL, one line string per edge
+class ShapefileWriter final : public ComponentWriter
+{
+  public:
+    explicit ShapefileWriter(const boost::filesystem::path &path)
     {
-        osrm::util::SimpleLogger().Write(logWARNING) << "usage:\n" << argv[0] << " <osrm>";
-        return EXIT_FAILURE;
-    }
+        // remove files from previous run if exist
+        auto file = path;
+        deleteFileIfExists(file.replace_extension(".dbf").string());
+        deleteFileIfExists(file.replace_extension(".shx").string());
+        deleteFileIfExists(path.string());
 
-    std::vector<osrm::tools::TarjanEdge> graph_edge_list;
-    auto number_of_nodes = osrm::tools::loadGraph(argv[1], coordinate_list, graph_edge_list);
+        OGRRegisterAll();
 
-    tbb::parallel_sort(graph_edge_list.begin(), graph_edge_list.end());
-    const auto graph = std::make_shared<osrm::tools::TarjanGraph>(number_of_nodes, graph_edge_list);
-    graph_edge_list.clear();
-    graph_edge_list.shrink_to_fit();
+        const char *psz_driver_name = "ESRI Shapefile";
+        auto *po_driver = OGRSFDriverRegistrar::GetRegistrar()->GetDriverByName(psz_driver_name);
+        if (nullptr == po_driver)
+        {
+            throw util::exception("ESRI Shapefile driver not available");
+        }
+        po_datasource = po_driver->CreateDataSource(path.string().c_str(), nullptr);
 
-    osrm::util::SimpleLogger().Write() << "Starting SCC graph traversal";
+        if (nullptr == po_datasource)
+        {
+            throw util::exception("Creation of output file failed");
+        }
 
-    auto tarjan =
-        osrm::util::make_unique<osrm::extractor::TarjanSCC<osrm::tools::TarjanGraph>>(graph);
-    tarjan->Run();
-    osrm::util::SimpleLogger().Write() << "identified: " << tarjan->GetNumberOfComponents()
-                                       << " many components";
-    osrm::util::SimpleLogger().Write() << "identified " << tarjan->GetSizeOneCount()
-                                       << " size 1 SCCs";
+        po_srs = new OGRSpatialReference();
+        po_srs->importFromEPSG(4326);
 
-    // output
-    TIMER_START(SCC_RUN_SETUP);
+        po_layer = po_datasource->CreateLayer("component", po_srs, wkbLineString, nullptr);
 
-    // remove files from previous run if exist
-    osrm::tools::deleteFileIfExists("component.dbf");
-    osrm::tools::deleteFileIfExists("component.shx");
-    osrm::tools::deleteFileIfExists("component.shp");
+        if (nullptr == po_layer)
+        {
+            throw util::exception("Layer creation failed.");
+        }
+    }
 
-    OGRRegisterAll();
+    ~ShapefileWriter() { Finish(); }
 
-    const char *psz_driver_name = "ESRI Shapefile";
-    auto *po_driver = OGRSFDriverRegistrar::GetRegistrar()->GetDriverByName(psz_driver_name);
-    if (nullptr == po_driver)
+    void Write(const std::vector<extractor::QueryNode> &coordinate_list,
+               const std::vector<ComponentEdge> &edges) override final
     {
-        throw osrm::util::exception("ESRI Shapefile driver not available");
+        for (const auto &edge : edges)
+        {
+            const auto &source = coordinate_list[edge.source];
+            const auto &target = coordinate_list[edge.target];
+            OGRLineString line_string;
+            line_string.addPoint(static_cast<double>(util::toFloating(source.lon)),
+                                 static_cast<double>(util::toFloating(source.lat)));
+            line_string.addPoint(static_cast<double>(util::toFloating(target.lon)),
+                                 static_cast<double>(util::toFloating(target.lat)));
+
+            OGRFeature *po_feature = OGRFeature::CreateFeature(po_layer->GetLayerDefn());
+
+            po_feature->SetGeometry(&line_string);
+            if (OGRERR_NONE != po_layer->CreateFeature(po_feature))
+            {
+                throw util::exception("Failed to create feature in shapefile.");
+            }
+            OGRFeature::DestroyFeature(po_feature);
+        }
     }
-    auto *po_datasource = po_driver->CreateDataSource("component.shp", nullptr);
 
-    if (nullptr == po_datasource)
+    void Finish() override final
     {
-        throw osrm::util::exception("Creation of output file failed");
+        if (po_datasource != nullptr)
+        {
+            OGRSpatialReference::DestroySpatialReference(po_srs);
+            OGRDataSource::DestroyDataSource(po_datasource);
+            po_srs = nullptr;
+            po_datasource = nullptr;
+        }
     }
 
-    auto *po_srs = new OGRSpatialReference();
-    po_srs->importFromEPSG(4326);
+  private:
+    OGRSpatialReference *po_srs = nullptr;
+    OGRDataSource *po_datasource = nullptr;
+    OGRLayer *po_layer = nullptr;
+};
 
-    auto *po_layer = po_datasource->CreateLayer("component", po_srs, wkbLineString, nullptr);
+// A GeoJSON FeatureCollection with a feature per line, written as the edges come in. The features
+// carry the id and the size of their component, so that the islands can be told apart.
+class GeoJSONWriter final : public ComponentWriter
+{
+  public:
+    explicit GeoJSONWriter(const boost::filesystem::path &path)
+        : output(path.string(), std::ofstream::out | std::ofstream::trunc)
+    {
+        if (!output.is_open())
+        {
+            throw util::exception("Creation of output file failed");
+        }
+        output << std::fixed << std::setprecision(6);
+        output << "{\"type\":\"FeatureCollection\",\"features\":[";
+    }
 
-    if (nullptr == po_layer)
+    void Write(const std::vector<extractor::QueryNode> &coordinate_list,
+               const std::vector<ComponentEdge> &edges) override final
     {
-        throw osrm::util::exception("Layer creation failed.");
+        for (const auto &edge : edges)
+        {
+            const auto &source = coordinate_list[edge.source];
+            const auto &target = coordinate_list[edge.target];
+            output << (first ? "\n" : ",\n") << "{\"type\":\"Feature\",\"properties\":{"
+                   << "\"component\":" << edge.component_id << ",\"size\":" << edge.component_size
+                   << "},\"geometry\":{\"type\":\"LineString\",\"coordinates\":[["
+                   << static_cast<double>(util::toFloating(source.lon)) << ','
+                   << static_cast<double>(util::toFloating(source.lat)) << "],["
+                   << static_cast<double>(util::toFloating(target.lon)) << ','
+                   << static_cast<double>(util::toFloating(target.lat)) << "]]}}";
+            first = false;
+        }
+        if (!output)
+        {
+            throw util::exception("Failed to write the GeoJSON output");
+        }
     }
-    TIMER_STOP(SCC_RUN_SETUP);
-    osrm::util::SimpleLogger().Write() << "shapefile setup took "
-                                       << TIMER_MSEC(SCC_RUN_SETUP) / 1000. << "s";
 
-    uint64_t total_network_length = 0;
-    osrm::util::Percent percentage(graph->GetNumberOfNodes());
-    TIMER_START(SCC_OUTPUT);
-    for (const NodeID source : osrm::util::irange(0u, graph->GetNumberOfNodes()))
+    void Finish() override final
     {
-        percentage.PrintIncrement();
-        for (const auto current_edge : graph->GetAdjacentEdgeRange(source))
+        output << "\n]}\n";
+        output.close();
+        if (!output)
         {
-            const auto target = graph->GetTarget(current_edge);
+            throw util::exception("Failed to write the GeoJSON output");
+        }
+    }
 
-            if (source < target || SPECIAL_EDGEID == graph->FindEdge(target, source))
-            {
-                total_network_length +=
-                    100 * osrm::util::coordinate_calculation::greatCircleDistance(
-                              coordinate_list[source], coordinate_list[target]);
+  private:
+    std::ofstream output;
+    bool first = true;
+};
+
+bool parseArguments(const int argc, char *argv[], ComponentsConfig &config)
+{
+    using boost::program_options::value;
+
+    boost::program_options::options_description generic_options("Options");
+    generic_options.add_options()("version,v", "Show version")("help,h", "Show this help message");
+
+    boost::program_options::options_description config_options("Configuration");
+    config_options.add_options() //
+        ("output,o",
+         value<boost::filesystem::path>(&config.output_path)->default_value("component.shp"),
+         "Output file, GeoJSON if it ends in .geojson, an ESRI shapefile otherwise") //
+        ("bbox",
+         value<std::string>(&config.bbox),
+         "Only analyse the edges inside of minlon,minlat,maxlon,maxlat") //
+        ("max-size",
+         value<unsigned>(&config.max_size)->default_value(1000),
+         "Write the edges of the components with fewer nodes than this");
+
+    boost::program_options::options_description hidden_options("Hidden options");
+    hidden_options.add_options()(
+        "input", value<boost::filesystem::path>(&config.input_path), "The .osrm file");
+
+    boost::program_options::positional_options_description positional_options;
+    positional_options.add("input", 1);
+
+    boost::program_options::options_description cmdline_options;
+    cmdline_options.add(generic_options).add(config_options).add(hidden_options);
+
+    boost::program_options::options_description visible_options(
+        boost::filesystem::path(argv[0]).filename().string() + " <input.osrm> [<options>]");
+    visible_options.add(generic_options).add(config_options);
+
+    boost::program_options::variables_map option_variables;
+    boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                      .options(cmdline_options)
+                                      .positional(positional_options)
+                                      .run(),
+                                  option_variables);
+
+    if (option_variables.count("version"))
+    {
+        util::SimpleLogger().Write() << OSRM_VERSION;
+        return false;
+    }
+    if (option_variables.count("help") || !option_variables.count("input"))
+    {
+        util::SimpleLogger().Write() << visible_options;
+        return false;
+    }
+    boost::program_options::notify(option_variables);
 
-                BOOST_ASSERT(current_edge != SPECIAL_EDGEID);
-                BOOST_ASSERT(source != SPECIAL_NODEID);
-                BOOST_ASSERT(target != SPECIAL_NODEID);
+    if (!config.bbox.empty())
+    {
+        std::vector<double> bounds;
+        std::istringstream stream(config.bbox);
+        std::string bound;
+        while (std::getline(stream, bound, ','))
+        {
+            bounds.push_back(std::stod(bound));
+        }
+        if (bounds.size() != 4 || bounds[0] > bounds[2] || bounds[1] > bounds[3])
+        {
+            throw util::exception("Invalid --bbox " + config.bbox +
+                                  ", expected minlon,minlat,maxlon,maxlat");
+        }
+        config.restricted = true;
+        config.south_west = util::Coordinate{util::FloatLongitude{bounds[0]},
+                                             util::FloatLatitude{bounds[1]}};
+        config.north_east = util::Coordinate{util::FloatLongitude{bounds[2]},
+                                             util::FloatLatitude{bounds[3]}};
+    }
+    return true;
+}
+}
+}
 
-                const unsigned size_of_containing_component =
-                    std::min(tarjan->GetComponentSize(tarjan->GetComponentID(source)),
-                             tarjan->GetComponentSize(tarjan->GetComponentID(target)));
+int main(int argc, char *argv[]) try
+{
+    using namespace osrm;
 
-                // edges that end on bollard nodes may actually be in two distinct components
-                if (size_of_containing_component < 1000)
+    util::LogPolicy::GetInstance().Unmute();
+    tools::ComponentsConfig config;
+    if (!tools::parseArguments(argc, argv, config))
+    {
+        return EXIT_SUCCESS;
+    }
+
+    std::vector<extractor::QueryNode> coordinate_list;
+    std::vector<tools::TarjanEdge> graph_edge_list;
+    auto number_of_nodes = tools::loadGraph(config, coordinate_list, graph_edge_list);
+
+    tbb::parallel_sort(graph_edge_list.begin(), graph_edge_list.end());
+    const auto graph = std::make_shared<tools::TarjanGraph>(number_of_nodes, graph_edge_list);
+    graph_edge_list.clear();
+    graph_edge_list.shrink_to_fit();
+
+    util::SimpleLogger().Write() << "Starting SCC graph traversal";
+
+    auto tarjan = util::make_unique<extractor::TarjanSCC<tools::TarjanGraph>>(graph);
+    tarjan->Run();
+    util::SimpleLogger().Write() << "identified: " << tarjan->GetNumberOfComponents()
+                                 << " many components";
+    util::SimpleLogger().Write() << "identified " << tarjan->GetSizeOneCount() << " size 1 SCCs";
+
+    // output
+    TIMER_START(SCC_RUN_SETUP);
+    std::unique_ptr<tools::ComponentWriter> writer;
+    if (config.output_path.extension() == ".geojson")
+    {
+        writer = util::make_unique<tools::GeoJSONWriter>(config.output_path);
+    }
+    else
+    {
+        writer = util::make_unique<tools::ShapefileWriter>(config.output_path);
+    }
+    TIMER_STOP(SCC_RUN_SETUP);
+    util::SimpleLogger().Write() << "output setup took " << TIMER_MSEC(SCC_RUN_SETUP) / 1000.
+                                 << "s";
+
+    // The nodes are scanned in parallel a chunk at a time and the edges of the chunk written
+    // before the next one, in the order of the nodes. The sub-blocks of a chunk keep their edges
+    // apart, so that the output doesn't depend on the scheduling of the threads.
+    const constexpr NodeID CHUNK_SIZE = 1u << 20;
+    const constexpr NodeID SUB_BLOCK_SIZE = 1u << 12;
+    const constexpr std::size_t SUB_BLOCKS = CHUNK_SIZE / SUB_BLOCK_SIZE;
+    std::vector<std::vector<tools::ComponentEdge>> sub_block_edges(SUB_BLOCKS);
+    std::vector<double> sub_block_lengths(SUB_BLOCKS);
+
+    double total_network_length = 0;
+    std::size_t number_of_written_edges = 0;
+    util::Percent percentage(graph->GetNumberOfNodes());
+    TIMER_START(SCC_OUTPUT);
+    for (NodeID chunk_begin = 0; chunk_begin < graph->GetNumberOfNodes();
+         chunk_begin += std::min(CHUNK_SIZE, graph->GetNumberOfNodes() - chunk_begin))
+    {
+        const auto chunk_end = chunk_begin + std::min(CHUNK_SIZE, graph->GetNumberOfNodes() -
+                                                                      chunk_begin);
+        const std::size_t number_of_sub_blocks =
+            (chunk_end - chunk_begin + SUB_BLOCK_SIZE - 1) / SUB_BLOCK_SIZE;
+
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_sub_blocks),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                for (auto sub_block = range.begin(); sub_block != range.end(); ++sub_block)
                 {
-                    OGRLineString line_string;
-                    line_string.addPoint(
-                        static_cast<double>(osrm::util::toFloating(coordinate_list[source].lon)),
-                        static_cast<double>(osrm::util::toFloating(coordinate_list[source].lat)));
-                    line_string.addPoint(
-                        static_cast<double>(osrm::util::toFloating(coordinate_list[target].lon)),
-                        static_cast<double>(osrm::util::toFloating(coordinate_list[target].lat)));
-
-                    OGRFeature *po_feature = OGRFeature::CreateFeature(po_layer->GetLayerDefn());
-
-                    po_feature->SetGeometry(&line_string);
-                    if (OGRERR_NONE != po_layer->CreateFeature(po_feature))
+                    auto &edges = sub_block_edges[sub_block];
+                    auto &length = sub_block_lengths[sub_block];
+                    edges.clear();
+                    length = 0;
+
+                    const NodeID begin = chunk_begin + sub_block * SUB_BLOCK_SIZE;
+                    const NodeID end = std::min(begin + SUB_BLOCK_SIZE, chunk_end);
+                    for (const NodeID source : util::irange(begin, end))
                     {
-                        throw osrm::util::exception("Failed to create feature in shapefile.");
+                        for (const auto current_edge : graph->GetAdjacentEdgeRange(source))
+                        {
+                            const auto target = graph->GetTarget(current_edge);
+
+                            if (source < target ||
+                                SPECIAL_EDGEID == graph->FindEdge(target, source))
+                            {
+                                length += util::coordinate_calculation::greatCircleDistance(
+                                    coordinate_list[source], coordinate_list[target]);
+
+                                BOOST_ASSERT(current_edge != SPECIAL_EDGEID);
+                                BOOST_ASSERT(source != SPECIAL_NODEID);
+                                BOOST_ASSERT(target != SPECIAL_NODEID);
+
+                                const auto source_component = tarjan->GetComponentID(source);
+                                const auto target_component = tarjan->GetComponentID(target);
+                                const auto source_size =
+                                    tarjan->GetComponentSize(source_component);
+                                const auto target_size =
+                                    tarjan->GetComponentSize(target_component);
+
+                                // edges that end on bollard nodes may actually be in two
+                                // distinct components
+                                if (std::min(source_size, target_size) < config.max_size)
+                                {
+                                    edges.push_back({source,
+                                                     target,
+                                                     source_size <= target_size
+                                                         ? source_component
+                                                         : target_component,
+                                                     std::min(source_size, target_size)});
+                                }
+                            }
+                        }
                     }
-                    OGRFeature::DestroyFeature(po_feature);
                 }
-            }
+            });
+
+        for (const auto sub_block : util::irange<std::size_t>(0, number_of_sub_blocks))
+        {
+            writer->Write(coordinate_list, sub_block_edges[sub_block]);
+            number_of_written_edges += sub_block_edges[sub_block].size();
+            total_network_length += sub_block_lengths[sub_block];
         }
+        percentage.PrintStatus(chunk_end);
     }
-    OGRSpatialReference::DestroySpatialReference(po_srs);
-    OGRDataSource::DestroyDataSource(po_datasource);
+    writer->Finish();
     TIMER_STOP(SCC_OUTPUT);
-    osrm::util::SimpleLogger().Write()
-        << "generating output took: " << TIMER_MSEC(SCC_OUTPUT) / 1000. << "s";
+    util::SimpleLogger().Write() << "generating output took: " << TIMER_MSEC(SCC_OUTPUT) / 1000.
+                                 << "s";
 
-    osrm::util::SimpleLogger().Write()
-        << "total network distance: " << static_cast<uint64_t>(total_network_length / 100 / 1000.)
-        << " km";
+    util::SimpleLogger().Write() << "wrote " << number_of_written_edges << " edges to "
+                                 << config.output_path.string();
+    util::SimpleLogger().Write() << "total network distance: "
+                                 << static_cast<uint64_t>(total_network_length / 1000.) << " km";
 
-    osrm::util::SimpleLogger().Write() << "finished component analysis";
+    util::SimpleLogger().Write() << "finished component analysis";
     return EXIT_SUCCESS;
 }
+catch (const std::exception &e)
+{
+    osrm::util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    return EXIT_FAILURE;
+}
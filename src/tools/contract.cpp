@@ -1,5 +1,6 @@
 #include "contractor/contractor.hpp"
 #include "contractor/contractor_config.hpp"
+#include "util/phase_trace.hpp"
 #include "util/simple_logger.hpp"
 #include "util/version.hpp"
 
@@ -39,6 +40,43 @@ return_code parseArguments(int argc, char *argv[], contractor::ContractorConfig
         "core,k",
         boost::program_options::value<double>(&contractor_config.core_factor)->default_value(1.0),
         "Percentage of the graph (in vertices) to contract [0..1]")(
+        "core-landmarks",
+        boost::program_options::value<unsigned>(&contractor_config.number_of_landmarks)
+            ->default_value(0),
+        "Number of landmarks for A* searches in the uncontracted core, 0 to disable")(
+        "hub-labels",
+        boost::program_options::value<bool>(&contractor_config.compute_hub_labels)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Compute hub labels for distance tables from the contraction hierarchy")(
+        "hub-labels-max-nodes",
+        boost::program_options::value<unsigned>(&contractor_config.max_hub_label_nodes)
+            ->default_value(2000000),
+        "Largest number of graph nodes hub labels are computed for")(
+        "witness-cache",
+        boost::program_options::value<bool>(&contractor_config.use_witness_cache)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Reuse the witness paths of earlier searches while they are valid. Faster, but needs "
+        "more memory")(
+        "witness-hop-limit",
+        boost::program_options::value<unsigned>(&contractor_config.witness_hop_limit)
+            ->default_value(0),
+        "Limit the hops of witness searches while the graph is sparse, 0 to disable")(
+        "witness-hop-limit-degree",
+        boost::program_options::value<double>(&contractor_config.witness_hop_limit_degree)
+            ->default_value(3.3),
+        "Average degree of the remaining graph below which the hop limit applies")(
+        "checkpoint-interval",
+        boost::program_options::value<double>(&contractor_config.checkpoint_interval)
+            ->default_value(0),
+        "Write the state of the contraction to <input>.checkpoint every this many seconds, 0 "
+        "to disable. SIGTERM and SIGINT then stop it with a checkpoint after the running round")(
+        "resume",
+        boost::program_options::value<bool>(&contractor_config.resume)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Continue an interrupted contraction from its checkpoint if there is one")(
         "segment-speed-file",
         boost::program_options::value<std::vector<std::string>>(
             &contractor_config.segment_speed_lookup_paths)
@@ -52,7 +90,33 @@ return_code parseArguments(int argc, char *argv[], contractor::ContractorConfig
         "level-cache,o",
         boost::program_options::value<bool>(&contractor_config.use_cached_priority)
             ->default_value(false),
-        "Use .level file to retain the contaction level for each node from the last run.");
+        "Use .level file to retain the contaction level for each node from the last run.")(
+        "partition-order",
+        boost::program_options::value<bool>(&contractor_config.use_partition_order)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Contract the nodes in the nested dissection order of the .partition of osrm-partition "
+        "instead of by their priority. The order doesn't depend on the weights, it is written to "
+        "the .level file for --level-cache.")(
+        "recustomize",
+        boost::program_options::value<bool>(&contractor_config.recustomize)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Only update the weights of the previous contraction, keeping its node order and "
+        "shortcuts. Much faster, but routes can be suboptimal until the next full contraction.")(
+        "renumber-nodes",
+        boost::program_options::value<bool>(&contractor_config.renumber_nodes)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Renumber the nodes by their contraction level and their position for faster queries. "
+        "Rewrites the node ids of the r-tree leaves.")(
+        "trace",
+        boost::program_options::value<boost::filesystem::path>(&contractor_config.trace_path),
+        "Write the time, memory and I/O of every phase to this file")(
+        "trace-format",
+        boost::program_options::value<std::string>(&contractor_config.trace_format)
+            ->default_value("chrome"),
+        "Format of the trace: json, or chrome for chrome://tracing");
 
     // hidden options, will be allowed on command line, but will not be shown to the user
     boost::program_options::options_description hidden_options("Hidden options");
@@ -139,6 +203,14 @@ int main(int argc, char *argv[]) try
         return EXIT_FAILURE;
     }
 
+    util::PhaseTrace::Format trace_format;
+    if (!util::PhaseTrace::GetFormat(contractor_config.trace_format, trace_format))
+    {
+        util::SimpleLogger().Write(logWARNING) << "Unknown trace format "
+                                               << contractor_config.trace_format;
+        return EXIT_FAILURE;
+    }
+
     const unsigned recommended_num_threads = tbb::task_scheduler_init::default_num_threads();
 
     if (recommended_num_threads != contractor_config.requested_num_threads)
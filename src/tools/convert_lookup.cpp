@@ -0,0 +1,43 @@
+#include "contractor/update_lookups.hpp"
+#include "util/simple_logger.hpp"
+#include "util/timing_util.hpp"
+
+#include <cstdlib>
+#include <exception>
+#include <string>
+
+// Converts a CSV file of segment speeds or turn penalties into the binary format, which
+// osrm-contract reads without parsing when the same values are applied again
+int main(int argc, char *argv[]) try
+{
+    using namespace osrm;
+
+    util::LogPolicy::GetInstance().Unmute();
+    const std::string type = argc == 4 ? argv[1] : "";
+    if (type != "speeds" && type != "penalties")
+    {
+        util::SimpleLogger().Write(logWARNING) << "usage: " << argv[0]
+                                               << " speeds|penalties input.csv output";
+        return EXIT_FAILURE;
+    }
+
+    TIMER_START(convert);
+    if (type == "speeds")
+    {
+        contractor::writeSegmentSpeedFile(argv[3], contractor::readSegmentSpeedFiles({argv[2]}));
+    }
+    else
+    {
+        contractor::writeTurnPenaltyFile(argv[3], contractor::readTurnPenaltyFiles({argv[2]}));
+    }
+    TIMER_STOP(convert);
+
+    util::SimpleLogger().Write() << "Wrote " << argv[3] << " after " << TIMER_SEC(convert)
+                                 << "s";
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    osrm::util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    return EXIT_FAILURE;
+}
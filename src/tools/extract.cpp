@@ -1,6 +1,9 @@
 #include "extractor/extractor.hpp"
 #include "extractor/extractor_config.hpp"
 #include "extractor/scripting_environment_lua.hpp"
+#include "extractor/scripting_environment_native.hpp"
+#include "util/phase_trace.hpp"
+#include "util/make_unique.hpp"
 #include "util/simple_logger.hpp"
 #include "util/version.hpp"
 
@@ -11,7 +14,9 @@
 
 #include <cstdlib>
 #include <exception>
+#include <memory>
 #include <new>
+#include <vector>
 
 using namespace osrm;
 
@@ -34,7 +39,7 @@ return_code parseArguments(int argc, char *argv[], extractor::ExtractorConfig &e
         "profile,p",
         boost::program_options::value<boost::filesystem::path>(&extractor_config.profile_path)
             ->default_value("profile.lua"),
-        "Path to LUA routing profile")(
+        "Path to LUA routing profile, or to a .ini configuration of the native car profile")(
         "threads,t",
         boost::program_options::value<unsigned int>(&extractor_config.requested_num_threads)
             ->default_value(tbb::task_scheduler_init::default_num_threads()),
@@ -44,11 +49,49 @@ return_code parseArguments(int argc, char *argv[], extractor::ExtractorConfig &e
             ->implicit_value(true)
             ->default_value(false),
         "Generate a lookup table for internal edge-expanded-edge IDs to OSM node pairs")(
+        "generate-geometry-zoom-levels",
+        boost::program_options::value<bool>(&extractor_config.generate_geometry_zoom_levels)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Precompute the zoom levels of the geometries to speed up simplified route overviews")(
+        "generate-segment-lengths",
+        boost::program_options::value<bool>(&extractor_config.generate_segment_lengths)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Precompute the lengths of the segments to speed up annotations and debug tiles")(
         "small-component-size",
         boost::program_options::value<unsigned int>(&extractor_config.small_component_size)
             ->default_value(1000),
         "Number of nodes required before a strongly-connected-componennt is considered big "
-        "(affects nearest neighbor snapping)");
+        "(affects nearest neighbor snapping)")(
+        "sort-memory",
+        boost::program_options::value<unsigned int>(&extractor_config.sort_memory)
+            ->default_value(4096),
+        "Memory in MiB to sort data in, larger data is sorted in runs of this size and merged")(
+        "two-pass",
+        boost::program_options::value<bool>(&extractor_config.two_pass)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Read the input twice, the ways first to only keep the nodes of routable ways. Lowers "
+        "the disk space and time needed to sort nodes")(
+        "apply-changes",
+        boost::program_options::value<std::vector<boost::filesystem::path>>(
+            &extractor_config.change_paths)
+            ->multitoken(),
+        "Apply these OSM change files (.osc) to the input while it is read")(
+        "reuse-way-results",
+        boost::program_options::value<bool>(&extractor_config.reuse_way_results)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Reuse the profile results of the ways that didn't change since the last extraction "
+        "with this option, which are stored in .osrm.way_results")(
+        "trace",
+        boost::program_options::value<boost::filesystem::path>(&extractor_config.trace_path),
+        "Write the time, memory and I/O of every phase to this file")(
+        "trace-format",
+        boost::program_options::value<std::string>(&extractor_config.trace_format)
+            ->default_value("chrome"),
+        "Format of the trace: json, or chrome for chrome://tracing");
 
     // hidden options, will be allowed on command line, but will not be
     // shown to the user
@@ -136,6 +179,14 @@ int main(int argc, char *argv[]) try
         return EXIT_FAILURE;
     }
 
+    util::PhaseTrace::Format trace_format;
+    if (!util::PhaseTrace::GetFormat(extractor_config.trace_format, trace_format))
+    {
+        util::SimpleLogger().Write(logWARNING) << "Unknown trace format "
+                                               << extractor_config.trace_format;
+        return EXIT_FAILURE;
+    }
+
     if (!boost::filesystem::is_regular_file(extractor_config.input_path))
     {
         util::SimpleLogger().Write(logWARNING)
@@ -143,6 +194,16 @@ int main(int argc, char *argv[]) try
         return EXIT_FAILURE;
     }
 
+    for (const auto &change_path : extractor_config.change_paths)
+    {
+        if (!boost::filesystem::is_regular_file(change_path))
+        {
+            util::SimpleLogger().Write(logWARNING) << "Change file " << change_path.string()
+                                                   << " not found!";
+            return EXIT_FAILURE;
+        }
+    }
+
     if (!boost::filesystem::is_regular_file(extractor_config.profile_path))
     {
         util::SimpleLogger().Write(logWARNING)
@@ -151,9 +212,18 @@ int main(int argc, char *argv[]) try
     }
 
     // setup scripting environment
-    extractor::LuaScriptingEnvironment scripting_environment(
-        extractor_config.profile_path.string().c_str());
-    return extractor::Extractor(extractor_config).run(scripting_environment);
+    std::unique_ptr<extractor::ScriptingEnvironment> scripting_environment;
+    if (extractor_config.profile_path.extension() == ".ini")
+    {
+        scripting_environment = util::make_unique<extractor::NativeScriptingEnvironment>(
+            extractor_config.profile_path.string());
+    }
+    else
+    {
+        scripting_environment = util::make_unique<extractor::LuaScriptingEnvironment>(
+            extractor_config.profile_path.string().c_str());
+    }
+    return extractor::Extractor(extractor_config).run(*scripting_environment);
 }
 catch (const std::bad_alloc &e)
 {
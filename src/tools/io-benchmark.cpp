@@ -1,3 +1,4 @@
+#include "util/async_io.hpp"
 #include "util/exception.hpp"
 #include "util/simple_logger.hpp"
 #include "util/timing_util.hpp"
@@ -170,6 +171,30 @@ int main(int argc, char *argv[])
                                            << std::fixed << 1024 * 1024 / TIMER_SEC(read_1gb)
                                            << "MB/sec";
 
+        // the same read with many reads in flight, as the data is loaded
+        for (const auto backend : {osrm::util::AsyncIO::Backend::IOUring,
+                                   osrm::util::AsyncIO::Backend::ThreadPool})
+        {
+            if (!osrm::util::AsyncIO::IsAvailable(backend))
+            {
+                osrm::util::SimpleLogger().Write()
+                    << osrm::util::AsyncIO::GetBackendName(backend) << " is not available";
+                continue;
+            }
+            osrm::util::AsyncIO io(backend);
+            TIMER_START(async_read_1gb);
+            io.Read(test_path,
+                    0,
+                    raw_array,
+                    osrm::tools::NUMBER_OF_ELEMENTS * sizeof(unsigned));
+            io.Wait();
+            TIMER_STOP(async_read_1gb);
+            osrm::util::SimpleLogger().Write()
+                << osrm::util::AsyncIO::GetBackendName(backend)
+                << " read performance: " << std::setprecision(5) << std::fixed
+                << 1024 * 1024 / TIMER_SEC(async_read_1gb) << "MB/sec";
+        }
+
         std::vector<double> timing_results_raw_random;
         osrm::util::SimpleLogger().Write(logDEBUG) << "running 1000 random I/Os of 4KB";
 
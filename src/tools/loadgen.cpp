@@ -0,0 +1,546 @@
+#include "util/latency_histogram.hpp"
+#include "util/simple_logger.hpp"
+#include "util/version.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/asio.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/program_options.hpp>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/time.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <istream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace osrm
+{
+namespace tools
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadgenConfig
+{
+    boost::filesystem::path request_log;
+    std::string host;
+    std::string port;
+    unsigned concurrency;
+    bool keep_alive;
+    bool gzip;
+    // requests per second of the open loop, 0 sends the next request as soon as one is answered
+    double rate;
+    unsigned repetitions;
+    double duration;
+    double timeout;
+    double max_error_rate;
+};
+
+// Every line of the log is a request URL, with or without scheme and host. Lines of access logs
+// are recognized by the GET before the path, so the logs of a reverse proxy can be replayed.
+std::vector<std::string> readRequestLog(const boost::filesystem::path &path)
+{
+    boost::filesystem::ifstream input(path);
+    if (!input)
+    {
+        throw std::runtime_error("Could not open " + path.string());
+    }
+
+    std::vector<std::string> requests;
+    std::string line;
+    while (std::getline(input, line))
+    {
+        boost::algorithm::trim(line);
+        if (line.empty() || line.front() == '#')
+        {
+            continue;
+        }
+
+        const auto method = line.find("GET ");
+        if (method != std::string::npos)
+        {
+            const auto path_begin = method + 4;
+            line = line.substr(path_begin, line.find(' ', path_begin) - path_begin);
+        }
+        const auto scheme = line.find("://");
+        if (scheme != std::string::npos)
+        {
+            const auto path_begin = line.find('/', scheme + 3);
+            line = path_begin == std::string::npos ? "/" : line.substr(path_begin);
+        }
+        if (line.empty() || line.front() != '/')
+        {
+            continue;
+        }
+        requests.push_back(line);
+    }
+
+    if (requests.empty())
+    {
+        throw std::runtime_error(path.string() + " contains no requests");
+    }
+    return requests;
+}
+
+// A blocking HTTP/1.1 client for the replies of osrm-routed, which always have a Content-Length
+class HTTPConnection
+{
+  public:
+    HTTPConnection(const LoadgenConfig &config,
+                   const boost::asio::ip::tcp::resolver::iterator &endpoints)
+        : config(config), endpoints(endpoints), socket(io_service)
+    {
+    }
+
+    // Sends the request and reads the reply, returns the status code. Throws on transport errors.
+    unsigned Get(const std::string &path)
+    {
+        if (socket.is_open())
+        {
+            try
+            {
+                return Exchange(path);
+            }
+            catch (const boost::system::system_error &e)
+            {
+                Close();
+                // the server closes idle connections, one more try on a new one
+                if (e.code() != boost::asio::error::eof &&
+                    e.code() != boost::asio::error::connection_reset &&
+                    e.code() != boost::asio::error::broken_pipe)
+                {
+                    throw;
+                }
+            }
+            catch (...)
+            {
+                Close();
+                throw;
+            }
+        }
+
+        Connect();
+        try
+        {
+            return Exchange(path);
+        }
+        catch (...)
+        {
+            Close();
+            throw;
+        }
+    }
+
+    std::size_t GetNumberOfConnections() const { return number_of_connections; }
+
+  private:
+    void Connect()
+    {
+        boost::asio::connect(socket, endpoints);
+        ++number_of_connections;
+        socket.set_option(boost::asio::ip::tcp::no_delay(true));
+        SetTimeout();
+    }
+
+    void Close()
+    {
+        boost::system::error_code ignore_error;
+        socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignore_error);
+        socket.close(ignore_error);
+        response.consume(response.size());
+    }
+
+    // blocking asio calls have no timeouts, the socket has to time out its reads and writes
+    void SetTimeout()
+    {
+        if (config.timeout <= 0)
+        {
+            return;
+        }
+#ifdef _WIN32
+        const DWORD milliseconds = static_cast<DWORD>(config.timeout * 1000);
+        const auto *value = reinterpret_cast<const char *>(&milliseconds);
+        const int size = sizeof(milliseconds);
+#else
+        timeval value_struct;
+        value_struct.tv_sec = static_cast<long>(config.timeout);
+        value_struct.tv_usec = static_cast<long>((config.timeout - value_struct.tv_sec) * 1e6);
+        const auto *value = &value_struct;
+        const socklen_t size = sizeof(value_struct);
+#endif
+        setsockopt(socket.native_handle(), SOL_SOCKET, SO_RCVTIMEO, value, size);
+        setsockopt(socket.native_handle(), SOL_SOCKET, SO_SNDTIMEO, value, size);
+    }
+
+    unsigned Exchange(const std::string &path)
+    {
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: " + config.host + "\r\n";
+        request += config.keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+        if (config.gzip)
+        {
+            request += "Accept-Encoding: gzip\r\n";
+        }
+        request += "\r\n";
+        boost::asio::write(socket, boost::asio::buffer(request));
+
+        boost::asio::read_until(socket, response, "\r\n\r\n");
+        std::istream header_stream(&response);
+        std::string line;
+        std::getline(header_stream, line);
+        if (!boost::algorithm::starts_with(line, "HTTP/1.") || line.size() < 12)
+        {
+            throw std::runtime_error("invalid status line");
+        }
+        const unsigned status = std::stoul(line.substr(9, 3));
+
+        std::size_t content_length = 0;
+        bool close = !config.keep_alive;
+        while (std::getline(header_stream, line) && line != "\r")
+        {
+            const auto colon = line.find(':');
+            if (colon == std::string::npos)
+            {
+                continue;
+            }
+            const auto name = line.substr(0, colon);
+            const auto value = boost::algorithm::trim_copy(line.substr(colon + 1));
+            if (boost::algorithm::iequals(name, "Content-Length"))
+            {
+                content_length = std::stoul(value);
+            }
+            else if (boost::algorithm::iequals(name, "Connection"))
+            {
+                close = close || boost::algorithm::iequals(value, "close");
+            }
+        }
+
+        // the body may partially be in the buffer already
+        if (response.size() < content_length)
+        {
+            boost::asio::read(
+                socket, response, boost::asio::transfer_exactly(content_length - response.size()));
+        }
+        response.consume(content_length);
+
+        if (close)
+        {
+            Close();
+        }
+        return status;
+    }
+
+    const LoadgenConfig &config;
+    boost::asio::ip::tcp::resolver::iterator endpoints;
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::socket socket;
+    boost::asio::streambuf response;
+    std::size_t number_of_connections = 0;
+};
+
+struct WorkerResult
+{
+    std::chrono::nanoseconds max_latency{0};
+    std::map<unsigned, std::uint64_t> status_counts;
+    std::uint64_t transport_errors = 0;
+    std::size_t connections = 0;
+};
+
+// Replays the requests with one connection per worker. In the open loop the requests are due at
+// fixed times and the latency is measured from then, so that requests that wait for a busy worker
+// count the waiting, which a closed loop hides by slowing down with the server.
+void runWorker(const LoadgenConfig &config,
+               const boost::asio::ip::tcp::resolver::iterator &endpoints,
+               const std::vector<std::string> &requests,
+               const std::uint64_t number_of_requests,
+               const Clock::time_point start,
+               const Clock::time_point deadline,
+               std::atomic<std::uint64_t> &next_request,
+               util::LatencyHistogram &latencies,
+               WorkerResult &result)
+{
+    HTTPConnection connection(config, endpoints);
+    for (auto index = next_request++; index < number_of_requests; index = next_request++)
+    {
+        auto due = Clock::now();
+        if (config.rate > 0)
+        {
+            due = start + std::chrono::duration_cast<Clock::duration>(
+                              std::chrono::duration<double>(index / config.rate));
+            std::this_thread::sleep_until(due);
+        }
+        if (due >= deadline)
+        {
+            break;
+        }
+
+        try
+        {
+            const auto status = connection.Get(requests[index % requests.size()]);
+            ++result.status_counts[status];
+        }
+        catch (const std::exception &)
+        {
+            ++result.transport_errors;
+        }
+        const auto latency = Clock::now() - due;
+        latencies.Record(latency);
+        result.max_latency = std::max<std::chrono::nanoseconds>(result.max_latency, latency);
+    }
+    result.connections = connection.GetNumberOfConnections();
+}
+
+// one line per power of two of microseconds that has latencies in it
+void printHistogram(const util::LatencyHistogram::Snapshot &snapshot)
+{
+    using util::LatencyHistogram;
+    std::uint64_t cumulative = 0;
+    for (std::size_t first = 0; first < LatencyHistogram::NUMBER_OF_BUCKETS;
+         first += LatencyHistogram::SUB_BUCKETS)
+    {
+        const auto last = first + LatencyHistogram::SUB_BUCKETS - 1;
+        std::uint64_t count = 0;
+        for (auto bucket = first; bucket <= last; ++bucket)
+        {
+            count += snapshot.counts[bucket];
+        }
+        if (count == 0)
+        {
+            continue;
+        }
+        cumulative += count;
+        const auto bar = static_cast<std::size_t>(50. * count / snapshot.count);
+        std::cout << "  < " << std::setw(10) << std::setprecision(3)
+                  << LatencyHistogram::GetUpperBound(last).count() / 1000. << " ms "
+                  << std::setw(9) << count << std::setw(8) << std::setprecision(2)
+                  << 100. * cumulative / snapshot.count << "% " << std::string(bar, '#') << "\n";
+    }
+}
+
+// Returns the share of requests that failed: transport errors, 429 and 5xx. 400 is answered to
+// queries without a route, which is a valid reply of the server.
+double printReport(const LoadgenConfig &config,
+                   const util::LatencyHistogram &latencies,
+                   const std::vector<WorkerResult> &results,
+                   const double seconds)
+{
+    WorkerResult total;
+    for (const auto &result : results)
+    {
+        total.max_latency = std::max(total.max_latency, result.max_latency);
+        for (const auto &status_count : result.status_counts)
+        {
+            total.status_counts[status_count.first] += status_count.second;
+        }
+        total.transport_errors += result.transport_errors;
+        total.connections += result.connections;
+    }
+
+    const auto snapshot = latencies.GetSnapshot();
+    const auto requests = snapshot.count;
+    std::uint64_t errors = total.transport_errors;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << requests << " requests in " << seconds << "s, " << requests / seconds
+              << " requests/s";
+    if (config.rate > 0)
+    {
+        std::cout << " (" << config.rate << " requested)";
+    }
+    std::cout << ", " << config.concurrency << " connection(s) at a time, " << total.connections
+              << " opened\n";
+
+    std::cout << "status:";
+    for (const auto &status_count : total.status_counts)
+    {
+        std::cout << " " << status_count.first << "=" << status_count.second;
+        if (status_count.first == 429 || status_count.first >= 500)
+        {
+            errors += status_count.second;
+        }
+    }
+    std::cout << " transport-errors=" << total.transport_errors << "\n";
+
+    const double error_rate = requests == 0 ? 0. : static_cast<double>(errors) / requests;
+    std::cout << "error rate: " << std::setprecision(4) << 100. * error_rate << "%\n";
+
+    // the quantiles are the upper bounds of their buckets, up to the largest latency
+    const auto max_ms = total.max_latency.count() / 1e6;
+    const auto quantile = [&](const double q) {
+        return std::min(max_ms, snapshot.GetQuantile(q).count() / 1000.);
+    };
+    const auto mean = requests == 0 ? 0. : snapshot.sum.count() / 1e6 / requests;
+    std::cout << std::setprecision(3) << "latency ms: mean " << mean << " p50 " << quantile(0.5)
+              << " p90 " << quantile(0.9) << " p99 " << quantile(0.99) << " p99.9 "
+              << quantile(0.999) << " max " << max_ms << "\n";
+    printHistogram(snapshot);
+    std::cout << std::flush;
+
+    return error_rate;
+}
+
+bool parseArguments(const int argc, const char *argv[], LoadgenConfig &config)
+{
+    using boost::program_options::value;
+
+    boost::program_options::options_description generic_options("Options");
+    generic_options.add_options()("version,v", "Show version")("help,h", "Show this help message");
+
+    boost::program_options::options_description config_options("Configuration");
+    config_options.add_options() //
+        ("host,i",
+         value<std::string>(&config.host)->default_value("127.0.0.1"),
+         "Host of osrm-routed") //
+        ("port,p",
+         value<std::string>(&config.port)->default_value("5000"),
+         "TCP/IP port of osrm-routed") //
+        ("concurrency,c",
+         value<unsigned>(&config.concurrency)->default_value(1),
+         "Number of connections that send requests at the same time") //
+        ("keep-alive,k",
+         value<bool>(&config.keep_alive)->implicit_value(true)->default_value(false),
+         "Send the requests of a connection over the same TCP connection") //
+        ("gzip",
+         value<bool>(&config.gzip)->implicit_value(true)->default_value(false),
+         "Accept gzip compressed replies") //
+        ("rate,r",
+         value<double>(&config.rate)->default_value(0),
+         "Requests per second sent independently of the replies, 0 to send the next request "
+         "of a connection when the last one is answered") //
+        ("repetitions,n",
+         value<unsigned>(&config.repetitions)->default_value(1),
+         "Number of times the log is replayed") //
+        ("duration,d",
+         value<double>(&config.duration)->default_value(0),
+         "Seconds after which no new requests are sent, 0 for no limit") //
+        ("timeout",
+         value<double>(&config.timeout)->default_value(30),
+         "Seconds to wait for a reply before it counts as an error, 0 to wait forever") //
+        ("max-error-rate",
+         value<double>(&config.max_error_rate)->default_value(1),
+         "Exit with an error if more than this share of requests fails");
+
+    boost::program_options::options_description hidden_options("Hidden options");
+    hidden_options.add_options()("requests",
+                                 value<boost::filesystem::path>(&config.request_log),
+                                 "file with one request URL per line");
+
+    boost::program_options::positional_options_description positional_options;
+    positional_options.add("requests", 1);
+
+    boost::program_options::options_description cmdline_options;
+    cmdline_options.add(generic_options).add(config_options).add(hidden_options);
+
+    boost::program_options::options_description visible_options(
+        boost::filesystem::path(argv[0]).filename().string() + " <requests> [<options>]");
+    visible_options.add(generic_options).add(config_options);
+
+    boost::program_options::variables_map option_variables;
+    boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                      .options(cmdline_options)
+                                      .positional(positional_options)
+                                      .run(),
+                                  option_variables);
+
+    if (option_variables.count("version"))
+    {
+        util::SimpleLogger().Write() << OSRM_VERSION;
+        return false;
+    }
+    if (option_variables.count("help") || !option_variables.count("requests"))
+    {
+        util::SimpleLogger().Write() << visible_options;
+        return false;
+    }
+    boost::program_options::notify(option_variables);
+
+    config.concurrency = std::max(1u, config.concurrency);
+    config.repetitions = std::max(1u, config.repetitions);
+    return true;
+}
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    using namespace osrm;
+
+    util::LogPolicy::GetInstance().Unmute();
+    tools::LoadgenConfig config;
+    if (!tools::parseArguments(argc, argv, config))
+    {
+        return EXIT_SUCCESS;
+    }
+
+    const auto requests = tools::readRequestLog(config.request_log);
+
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::resolver resolver(io_service);
+    const auto endpoints =
+        resolver.resolve(boost::asio::ip::tcp::resolver::query(config.host, config.port));
+
+    // with a duration the log is replayed until it runs out
+    const std::uint64_t number_of_requests =
+        config.duration > 0 ? std::numeric_limits<std::uint64_t>::max()
+                            : std::uint64_t{requests.size()} * config.repetitions;
+    util::SimpleLogger().Write() << "Replaying " << requests.size() << " requests against "
+                                 << config.host << ":" << config.port;
+
+    util::LatencyHistogram latencies;
+    std::vector<tools::WorkerResult> results(config.concurrency);
+    std::vector<std::thread> workers;
+    std::atomic<std::uint64_t> next_request(0);
+    const auto start = tools::Clock::now();
+    const auto deadline =
+        config.duration > 0 ? start + std::chrono::duration_cast<tools::Clock::duration>(
+                                          std::chrono::duration<double>(config.duration))
+                            : tools::Clock::time_point::max();
+    for (unsigned worker = 0; worker < config.concurrency; ++worker)
+    {
+        workers.emplace_back([&, worker] {
+            tools::runWorker(config,
+                             endpoints,
+                             requests,
+                             number_of_requests,
+                             start,
+                             deadline,
+                             next_request,
+                             latencies,
+                             results[worker]);
+        });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    const auto seconds = std::chrono::duration<double>(tools::Clock::now() - start).count();
+
+    const auto error_rate = tools::printReport(config, latencies, results, seconds);
+    if (error_rate > config.max_error_rate)
+    {
+        util::SimpleLogger().Write(logWARNING) << "Error rate above " << config.max_error_rate;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    osrm::util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    return EXIT_FAILURE;
+}
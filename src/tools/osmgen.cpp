@@ -0,0 +1,529 @@
+#include "util/simple_logger.hpp"
+#include "util/version.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/any_output.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace tools
+{
+
+struct GeneratorConfig
+{
+    boost::filesystem::path output;
+    std::uint64_t nodes;
+    std::uint64_t seed;
+    // meters between two intersections of the grid
+    double spacing;
+    // shape nodes on every road segment between two intersections
+    unsigned shape_nodes;
+    // intersections on a way before it is split into the next one
+    unsigned way_length;
+    double removed_rate;
+    double oneway_rate;
+    double restriction_rate;
+    double lanes_rate;
+};
+
+/**
+ * Generates a road network on a jittered square grid of intersections. Every row and column of
+ * the grid is a road whose class follows a hierarchy: every 64th line is a trunk road, every
+ * 16th a primary, every 4th a secondary road and every other one residential. Residential ways
+ * are removed and made oneway at random, so the intersections have degrees between one and
+ * four. Major roads get turn lanes and the intersections at which ways end get turn
+ * restrictions.
+ *
+ * Every random decision is a hash of the seed and the element it is about, so the nodes, ways
+ * and relations are written in passes over the grid without holding any of them in memory and
+ * the same seed always generates the same file.
+ */
+class NetworkGenerator
+{
+  public:
+    explicit NetworkGenerator(const GeneratorConfig &config)
+        : config(config),
+          side(std::max<std::uint64_t>(
+              2,
+              std::ceil(std::sqrt(static_cast<double>(config.nodes) /
+                                  (1 + 2 * config.shape_nodes))))),
+          pieces(((side - 1) + config.way_length - 1) / config.way_length),
+          latitude_step(config.spacing / METERS_PER_DEGREE),
+          longitude_step(config.spacing / METERS_PER_DEGREE)
+    {
+    }
+
+    std::uint64_t Side() const { return side; }
+
+    std::uint64_t NumberOfNodes() const
+    {
+        return side * side + 2 * side * (side - 1) * config.shape_nodes;
+    }
+
+    osmium::Box BoundingBox() const
+    {
+        return osmium::Box{-0.5 * longitude_step,
+                           -0.5 * latitude_step,
+                           (side - 0.5) * longitude_step,
+                           (side - 0.5) * latitude_step};
+    }
+
+    template <typename Write> void WriteNodes(osmium::memory::Buffer &buffer, Write write) const
+    {
+        using namespace osmium::builder::attr;
+
+        for (std::uint64_t row = 0; row < side; ++row)
+        {
+            for (std::uint64_t column = 0; column < side; ++column)
+            {
+                osmium::builder::add_node(buffer,
+                                          _id(IntersectionID(row, column)),
+                                          _version(1),
+                                          _location(IntersectionLocation(row, column)));
+                write();
+            }
+        }
+
+        // shape nodes are written in the order of their ids, first those of the rows
+        for (const auto orientation : {ROW, COLUMN})
+        {
+            for (std::uint64_t line = 0; line < side; ++line)
+            {
+                for (std::uint64_t position = 0; position + 1 < side; ++position)
+                {
+                    if (IsRemoved(orientation, line, position / config.way_length))
+                    {
+                        continue;
+                    }
+                    for (unsigned index = 0; index < config.shape_nodes; ++index)
+                    {
+                        osmium::builder::add_node(
+                            buffer,
+                            _id(ShapeID(orientation, line, position, index)),
+                            _version(1),
+                            _location(ShapeLocation(orientation, line, position, index)));
+                        write();
+                    }
+                }
+            }
+        }
+    }
+
+    template <typename Write> void WriteWays(osmium::memory::Buffer &buffer, Write write) const
+    {
+        using namespace osmium::builder::attr;
+
+        std::vector<osmium::object_id_type> nodes;
+        for (const auto orientation : {ROW, COLUMN})
+        {
+            for (std::uint64_t line = 0; line < side; ++line)
+            {
+                const auto road_class = ClassOf(line);
+                const auto name = (orientation == ROW ? "Row Street " : "Column Street ") +
+                                  std::to_string(line);
+                for (std::uint64_t piece = 0; piece < pieces; ++piece)
+                {
+                    if (IsRemoved(orientation, line, piece))
+                    {
+                        continue;
+                    }
+
+                    nodes.clear();
+                    const auto first = piece * config.way_length;
+                    const auto last = std::min(first + config.way_length, side - 1);
+                    for (auto position = first; position < last; ++position)
+                    {
+                        nodes.push_back(PositionID(orientation, line, position));
+                        for (unsigned index = 0; index < config.shape_nodes; ++index)
+                        {
+                            nodes.push_back(ShapeID(orientation, line, position, index));
+                        }
+                    }
+                    nodes.push_back(PositionID(orientation, line, last));
+
+                    std::vector<std::pair<std::string, std::string>> tags{
+                        {"highway", HIGHWAY_VALUES[road_class]},
+                        {"name", name},
+                        {"maxspeed", MAXSPEED_VALUES[road_class]}};
+                    if (road_class == TRUNK)
+                    {
+                        tags.emplace_back("ref", "T " + std::to_string(line / 64));
+                    }
+                    if (IsOneway(orientation, line, piece))
+                    {
+                        // neighbouring oneway streets point into opposite directions
+                        tags.emplace_back("oneway", line % 2 == 0 ? "yes" : "-1");
+                    }
+                    if (road_class != RESIDENTIAL &&
+                        Random(LANES, orientation, line, piece) < config.lanes_rate)
+                    {
+                        tags.emplace_back("turn:lanes:forward", "left|through|through;right");
+                        tags.emplace_back("turn:lanes:backward", "left;through|through|right");
+                    }
+
+                    osmium::builder::add_way(buffer,
+                                             _id(WayID(orientation, line, piece)),
+                                             _version(1),
+                                             _nodes(nodes),
+                                             _tags(tags));
+                    write();
+                }
+            }
+        }
+    }
+
+    // The restrictions are at the intersections at which both the row and the column ways end.
+    // The from way arrives from the west.
+    template <typename Write>
+    std::uint64_t WriteRestrictions(osmium::memory::Buffer &buffer, Write write) const
+    {
+        using namespace osmium::builder::attr;
+
+        std::uint64_t relation_id = 0;
+        for (std::uint64_t row = 0; row < side; row += config.way_length)
+        {
+            for (std::uint64_t column = config.way_length; column < side;
+                 column += config.way_length)
+            {
+                const auto from_piece = column / config.way_length - 1;
+                if (IsRemoved(ROW, row, from_piece) || IsOneway(ROW, row, from_piece) ||
+                    Random(RESTRICTION, row, column) >= config.restriction_rate)
+                {
+                    continue;
+                }
+
+                // north is a left turn, south a right turn and east straight on
+                const auto turn = static_cast<unsigned>(3 * Random(TURN, row, column));
+                const auto column_piece = row / config.way_length;
+                const char *restriction = nullptr;
+                osmium::object_id_type to_way = 0;
+                if (turn == 0 && row + 1 < side && !IsRemoved(COLUMN, column, column_piece))
+                {
+                    restriction = "no_left_turn";
+                    to_way = WayID(COLUMN, column, column_piece);
+                }
+                else if (turn == 1 && row > 0 && !IsRemoved(COLUMN, column, column_piece - 1))
+                {
+                    restriction = "no_right_turn";
+                    to_way = WayID(COLUMN, column, column_piece - 1);
+                }
+                else if (turn == 2 && column + 1 < side && !IsRemoved(ROW, row, from_piece + 1))
+                {
+                    restriction = "only_straight_on";
+                    to_way = WayID(ROW, row, from_piece + 1);
+                }
+                if (restriction == nullptr)
+                {
+                    continue;
+                }
+
+                osmium::builder::add_relation(
+                    buffer,
+                    _id(++relation_id),
+                    _version(1),
+                    _member(osmium::item_type::way, WayID(ROW, row, from_piece), "from"),
+                    _member(osmium::item_type::node, IntersectionID(row, column), "via"),
+                    _member(osmium::item_type::way, to_way, "to"),
+                    _tag("type", "restriction"),
+                    _tag("restriction", restriction));
+                write();
+            }
+        }
+        return relation_id;
+    }
+
+  private:
+    static constexpr double METERS_PER_DEGREE = 111319.49;
+
+    enum Orientation
+    {
+        ROW,
+        COLUMN
+    };
+
+    enum RoadClass
+    {
+        TRUNK,
+        PRIMARY,
+        SECONDARY,
+        RESIDENTIAL
+    };
+
+    // keys that make the random decisions about the same element independent
+    enum Decision : std::uint64_t
+    {
+        JITTER_LATITUDE = 1,
+        JITTER_LONGITUDE,
+        SHAPE,
+        REMOVED,
+        ONEWAY,
+        LANES,
+        RESTRICTION,
+        TURN
+    };
+
+    static constexpr const char *HIGHWAY_VALUES[] = {
+        "trunk", "primary", "secondary", "residential"};
+    static constexpr const char *MAXSPEED_VALUES[] = {"100", "70", "50", "30"};
+
+    static RoadClass ClassOf(const std::uint64_t line)
+    {
+        return line % 64 == 0 ? TRUNK
+                              : line % 16 == 0 ? PRIMARY : line % 4 == 0 ? SECONDARY : RESIDENTIAL;
+    }
+
+    // splitmix64 of the seed and the keys, mapped to [0, 1)
+    double Random(const std::uint64_t decision,
+                  const std::uint64_t first,
+                  const std::uint64_t second = 0,
+                  const std::uint64_t third = 0) const
+    {
+        std::uint64_t value = config.seed;
+        for (const auto key : {decision, first, second, third})
+        {
+            value += key + 0x9e3779b97f4a7c15ULL;
+            value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+            value = value ^ (value >> 31);
+        }
+        return (value >> 11) * (1. / (std::uint64_t{1} << 53));
+    }
+
+    bool IsRemoved(const Orientation orientation,
+                   const std::uint64_t line,
+                   const std::uint64_t piece) const
+    {
+        return ClassOf(line) == RESIDENTIAL &&
+               Random(REMOVED, orientation, line, piece) < config.removed_rate;
+    }
+
+    bool IsOneway(const Orientation orientation,
+                  const std::uint64_t line,
+                  const std::uint64_t piece) const
+    {
+        return ClassOf(line) == RESIDENTIAL &&
+               Random(ONEWAY, orientation, line, piece) < config.oneway_rate;
+    }
+
+    osmium::object_id_type IntersectionID(const std::uint64_t row, const std::uint64_t column) const
+    {
+        return 1 + row * side + column;
+    }
+
+    // the intersection at a position along a row or a column
+    osmium::object_id_type PositionID(const Orientation orientation,
+                                      const std::uint64_t line,
+                                      const std::uint64_t position) const
+    {
+        return orientation == ROW ? IntersectionID(line, position)
+                                  : IntersectionID(position, line);
+    }
+
+    osmium::object_id_type ShapeID(const Orientation orientation,
+                                   const std::uint64_t line,
+                                   const std::uint64_t position,
+                                   const unsigned index) const
+    {
+        const auto segments_per_orientation = side * (side - 1);
+        return 1 + side * side +
+               ((orientation == ROW ? 0 : segments_per_orientation) + line * (side - 1) +
+                position) *
+                   config.shape_nodes +
+               index;
+    }
+
+    osmium::object_id_type WayID(const Orientation orientation,
+                                 const std::uint64_t line,
+                                 const std::uint64_t piece) const
+    {
+        return 1 + (orientation == ROW ? 0 : side * pieces) + line * pieces + piece;
+    }
+
+    // intersections are moved by up to a fifth of the spacing, so bearings and lengths vary
+    osmium::Location IntersectionLocation(const std::uint64_t row, const std::uint64_t column) const
+    {
+        const auto jitter_latitude = 0.4 * (Random(JITTER_LATITUDE, row, column) - 0.5);
+        const auto jitter_longitude = 0.4 * (Random(JITTER_LONGITUDE, row, column) - 0.5);
+        return osmium::Location{(column + jitter_longitude) * longitude_step,
+                                (row + jitter_latitude) * latitude_step};
+    }
+
+    // shape nodes are spread along the segment and bent off it by up to a tenth of the spacing
+    osmium::Location ShapeLocation(const Orientation orientation,
+                                   const std::uint64_t line,
+                                   const std::uint64_t position,
+                                   const unsigned index) const
+    {
+        const auto from = orientation == ROW ? IntersectionLocation(line, position)
+                                             : IntersectionLocation(position, line);
+        const auto to = orientation == ROW ? IntersectionLocation(line, position + 1)
+                                           : IntersectionLocation(position + 1, line);
+        const auto ratio = (index + 1.) / (config.shape_nodes + 1.);
+        const auto bend = 0.2 * (Random(SHAPE, orientation, line * side + position, index) - 0.5);
+        const auto lon = from.lon() + ratio * (to.lon() - from.lon());
+        const auto lat = from.lat() + ratio * (to.lat() - from.lat());
+        return orientation == ROW ? osmium::Location{lon, lat + bend * latitude_step}
+                                  : osmium::Location{lon + bend * longitude_step, lat};
+    }
+
+    const GeneratorConfig config;
+    const std::uint64_t side;
+    // ways per row or column
+    const std::uint64_t pieces;
+    const double latitude_step;
+    const double longitude_step;
+};
+
+constexpr double NetworkGenerator::METERS_PER_DEGREE;
+constexpr const char *NetworkGenerator::HIGHWAY_VALUES[];
+constexpr const char *NetworkGenerator::MAXSPEED_VALUES[];
+
+bool parseArguments(const int argc, const char *argv[], GeneratorConfig &config)
+{
+    using boost::program_options::value;
+
+    boost::program_options::options_description generic_options("Options");
+    generic_options.add_options()("version,v", "Show version")("help,h", "Show this help message");
+
+    boost::program_options::options_description config_options("Configuration");
+    config_options.add_options() //
+        ("nodes,n",
+         value<std::uint64_t>(&config.nodes)->default_value(10000),
+         "Approximate number of nodes of the network") //
+        ("seed,s",
+         value<std::uint64_t>(&config.seed)->default_value(1),
+         "Seed of the random decisions, the same seed generates the same network") //
+        ("spacing",
+         value<double>(&config.spacing)->default_value(100),
+         "Meters between two intersections") //
+        ("shape-nodes",
+         value<unsigned>(&config.shape_nodes)->default_value(1),
+         "Nodes between two intersections that only shape the road") //
+        ("way-length",
+         value<unsigned>(&config.way_length)->default_value(8),
+         "Intersections after which a way is split") //
+        ("removed-rate",
+         value<double>(&config.removed_rate)->default_value(0.2),
+         "Share of residential ways that are left out") //
+        ("oneway-rate",
+         value<double>(&config.oneway_rate)->default_value(0.1),
+         "Share of residential ways that are oneway") //
+        ("restriction-rate",
+         value<double>(&config.restriction_rate)->default_value(0.3),
+         "Share of the intersections between way ends that get a turn restriction") //
+        ("lanes-rate",
+         value<double>(&config.lanes_rate)->default_value(0.5),
+         "Share of major roads that get turn lanes");
+
+    boost::program_options::options_description hidden_options("Hidden options");
+    hidden_options.add_options()("output",
+                                 value<boost::filesystem::path>(&config.output),
+                                 "output file, the format follows from the extension");
+
+    boost::program_options::positional_options_description positional_options;
+    positional_options.add("output", 1);
+
+    boost::program_options::options_description cmdline_options;
+    cmdline_options.add(generic_options).add(config_options).add(hidden_options);
+
+    boost::program_options::options_description visible_options(
+        boost::filesystem::path(argv[0]).filename().string() + " <output.osm.pbf> [<options>]");
+    visible_options.add(generic_options).add(config_options);
+
+    boost::program_options::variables_map option_variables;
+    boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                      .options(cmdline_options)
+                                      .positional(positional_options)
+                                      .run(),
+                                  option_variables);
+
+    if (option_variables.count("version"))
+    {
+        util::SimpleLogger().Write() << OSRM_VERSION;
+        return false;
+    }
+    if (option_variables.count("help") || !option_variables.count("output"))
+    {
+        util::SimpleLogger().Write() << visible_options;
+        return false;
+    }
+    boost::program_options::notify(option_variables);
+
+    config.way_length = std::max(1u, config.way_length);
+    return true;
+}
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    using namespace osrm;
+
+    util::LogPolicy::GetInstance().Unmute();
+    tools::GeneratorConfig config;
+    if (!tools::parseArguments(argc, argv, config))
+    {
+        return EXIT_SUCCESS;
+    }
+
+    const tools::NetworkGenerator generator(config);
+    util::SimpleLogger().Write() << "Generating a grid of " << generator.Side() << "x"
+                                 << generator.Side() << " intersections with up to "
+                                 << generator.NumberOfNodes() << " nodes";
+
+    osmium::io::Header header;
+    header.set("generator", "osrm-osmgen " OSRM_VERSION);
+    header.set("osrm_osmgen_seed", std::to_string(config.seed));
+    header.add_box(generator.BoundingBox());
+    osmium::io::Writer writer(config.output.string(), header, osmium::io::overwrite::allow);
+
+    const constexpr std::size_t BUFFER_SIZE = 8 * 1024 * 1024;
+    osmium::memory::Buffer buffer(BUFFER_SIZE, osmium::memory::Buffer::auto_grow::yes);
+    std::uint64_t number_of_objects = 0;
+    const auto write = [&] {
+        ++number_of_objects;
+        if (buffer.committed() > BUFFER_SIZE / 2)
+        {
+            writer(std::move(buffer));
+            buffer = osmium::memory::Buffer(BUFFER_SIZE, osmium::memory::Buffer::auto_grow::yes);
+        }
+    };
+
+    generator.WriteNodes(buffer, write);
+    const auto number_of_nodes = number_of_objects;
+    generator.WriteWays(buffer, write);
+    const auto number_of_ways = number_of_objects - number_of_nodes;
+    const auto number_of_restrictions = generator.WriteRestrictions(buffer, write);
+    writer(std::move(buffer));
+    writer.close();
+
+    util::SimpleLogger().Write() << "Wrote " << number_of_nodes << " nodes, " << number_of_ways
+                                 << " ways and " << number_of_restrictions << " restrictions to "
+                                 << config.output.string();
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    osrm::util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    return EXIT_FAILURE;
+}
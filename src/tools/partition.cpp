@@ -0,0 +1,188 @@
+#include "partition/partitioner.hpp"
+#include "partition/partitioner_config.hpp"
+#include "util/simple_logger.hpp"
+#include "util/version.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <boost/program_options/errors.hpp>
+
+#include <tbb/task_scheduler_init.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <new>
+#include <ostream>
+#include <vector>
+
+using namespace osrm;
+
+enum class return_code : unsigned
+{
+    ok,
+    fail,
+    exit
+};
+
+return_code parseArguments(int argc, char *argv[], partition::PartitionerConfig &partition_config)
+{
+    // declare a group of options that will be allowed only on command line
+    boost::program_options::options_description generic_options("Options");
+    generic_options.add_options()("version,v", "Show version")("help,h", "Show this help message");
+
+    // declare a group of options that will be allowed on command line
+    boost::program_options::options_description config_options("Configuration");
+    config_options.add_options()(
+        "threads,t",
+        boost::program_options::value<unsigned int>(&partition_config.requested_num_threads)
+            ->default_value(tbb::task_scheduler_init::default_num_threads()),
+        "Number of threads to use")(
+        "max-cell-sizes",
+        boost::program_options::value<std::vector<std::uint32_t>>(
+            &partition_config.max_cell_sizes)
+            ->multitoken()
+            ->default_value(partition_config.max_cell_sizes, "128 4096 65536 2097152"),
+        "Largest number of nodes in a cell of every level, from the smallest cells up")(
+        "balance",
+        boost::program_options::value<double>(&partition_config.balance)->default_value(1.2),
+        "Largest half of a bisection relative to half of its nodes that is preferred over "
+        "smaller cuts")(
+        "boundary",
+        boost::program_options::value<double>(&partition_config.boundary_factor)
+            ->default_value(0.25),
+        "Share of the nodes at either end of a direction that its cut separates [0..0.5]")(
+        "directions",
+        boost::program_options::value<unsigned>(&partition_config.number_of_directions)
+            ->default_value(10),
+        "Number of directions every bisection tries cuts along");
+
+    // hidden options, will be allowed on command line, but will not be shown to the user
+    boost::program_options::options_description hidden_options("Hidden options");
+    hidden_options.add_options()(
+        "input,i",
+        boost::program_options::value<boost::filesystem::path>(&partition_config.osrm_input_path),
+        "Input file in .osrm format");
+
+    // positional option
+    boost::program_options::positional_options_description positional_options;
+    positional_options.add("input", 1);
+
+    // combine above options for parsing
+    boost::program_options::options_description cmdline_options;
+    cmdline_options.add(generic_options).add(config_options).add(hidden_options);
+
+    const auto *executable = argv[0];
+    boost::program_options::options_description visible_options(
+        "Usage: " + boost::filesystem::path(executable).filename().string() +
+        " <input.osrm> [options]");
+    visible_options.add(generic_options).add(config_options);
+
+    // parse command line options
+    boost::program_options::variables_map option_variables;
+    try
+    {
+        boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                          .options(cmdline_options)
+                                          .positional(positional_options)
+                                          .run(),
+                                      option_variables);
+    }
+    catch (const boost::program_options::error &e)
+    {
+        util::SimpleLogger().Write(logWARNING) << "[error] " << e.what();
+        return return_code::fail;
+    }
+
+    if (option_variables.count("version"))
+    {
+        util::SimpleLogger().Write() << OSRM_VERSION;
+        return return_code::exit;
+    }
+
+    if (option_variables.count("help"))
+    {
+        util::SimpleLogger().Write() << visible_options;
+        return return_code::exit;
+    }
+
+    boost::program_options::notify(option_variables);
+
+    if (!option_variables.count("input"))
+    {
+        util::SimpleLogger().Write() << visible_options;
+        return return_code::fail;
+    }
+
+    return return_code::ok;
+}
+
+int main(int argc, char *argv[]) try
+{
+    util::LogPolicy::GetInstance().Unmute();
+    partition::PartitionerConfig partition_config;
+
+    const return_code result = parseArguments(argc, argv, partition_config);
+
+    if (return_code::fail == result)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (return_code::exit == result)
+    {
+        return EXIT_SUCCESS;
+    }
+
+    partition_config.UseDefaultOutputNames();
+
+    if (1 > partition_config.requested_num_threads)
+    {
+        util::SimpleLogger().Write(logWARNING) << "Number of threads must be 1 or larger";
+        return EXIT_FAILURE;
+    }
+
+    const auto &max_cell_sizes = partition_config.max_cell_sizes;
+    if (max_cell_sizes.empty() || max_cell_sizes.size() > 16 || max_cell_sizes.front() == 0 ||
+        std::adjacent_find(max_cell_sizes.begin(),
+                           max_cell_sizes.end(),
+                           std::greater_equal<std::uint32_t>()) != max_cell_sizes.end())
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "The cell sizes must be between one and 16 increasing sizes above 0";
+        return EXIT_FAILURE;
+    }
+
+    if (partition_config.boundary_factor <= 0 || partition_config.boundary_factor > 0.5 ||
+        partition_config.balance < 1 || partition_config.number_of_directions < 1)
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "The boundary must be in (0..0.5], the balance at least 1 and the directions "
+               "at least 1";
+        return EXIT_FAILURE;
+    }
+
+    if (!boost::filesystem::is_regular_file(partition_config.osrm_input_path))
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "Input file " << partition_config.osrm_input_path.string() << " not found!";
+        return EXIT_FAILURE;
+    }
+
+    util::SimpleLogger().Write() << "Input file: "
+                                 << partition_config.osrm_input_path.filename().string();
+    util::SimpleLogger().Write() << "Threads: " << partition_config.requested_num_threads;
+
+    tbb::task_scheduler_init init(partition_config.requested_num_threads);
+
+    return partition::Partitioner(partition_config).Run();
+}
+catch (const std::bad_alloc &e)
+{
+    util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    util::SimpleLogger().Write(logWARNING)
+        << "Please provide more memory or consider using a larger swapfile";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,309 @@
+#include "contractor/contractor.hpp"
+#include "contractor/contractor_config.hpp"
+#include "extractor/edge_based_graph.hpp"
+#include "extractor/extractor.hpp"
+#include "extractor/extractor_config.hpp"
+#include "extractor/scripting_environment_lua.hpp"
+#include "extractor/scripting_environment_native.hpp"
+#include "util/make_unique.hpp"
+#include "util/phase_trace.hpp"
+#include "util/simple_logger.hpp"
+#include "util/version.hpp"
+
+#include <tbb/task_scheduler_init.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <new>
+#include <vector>
+
+using namespace osrm;
+
+enum class return_code : unsigned
+{
+    ok,
+    fail,
+    exit
+};
+
+return_code parseArguments(int argc,
+                           char *argv[],
+                           extractor::ExtractorConfig &extractor_config,
+                           contractor::ContractorConfig &contractor_config)
+{
+    // declare a group of options that will be allowed only on command line
+    boost::program_options::options_description generic_options("Options");
+    generic_options.add_options()("version,v", "Show version")("help,h", "Show this help message");
+
+    boost::program_options::options_description config_options("Configuration");
+    config_options.add_options()(
+        "threads,t",
+        boost::program_options::value<unsigned int>(&extractor_config.requested_num_threads)
+            ->default_value(tbb::task_scheduler_init::default_num_threads()),
+        "Number of threads to use")(
+        "trace",
+        boost::program_options::value<boost::filesystem::path>(&extractor_config.trace_path),
+        "Write the time, memory and I/O of every phase to this file")(
+        "trace-format",
+        boost::program_options::value<std::string>(&extractor_config.trace_format)
+            ->default_value("chrome"),
+        "Format of the trace: json, or chrome for chrome://tracing");
+
+    // the options of osrm-extract, except the edge lookup which is only needed to update the
+    // weights of the .ebg
+    boost::program_options::options_description extractor_options("Extraction");
+    extractor_options.add_options()(
+        "profile,p",
+        boost::program_options::value<boost::filesystem::path>(&extractor_config.profile_path)
+            ->default_value("profile.lua"),
+        "Path to LUA routing profile, or to a .ini configuration of the native car profile")(
+        "generate-geometry-zoom-levels",
+        boost::program_options::value<bool>(&extractor_config.generate_geometry_zoom_levels)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Precompute the zoom levels of the geometries to speed up simplified route overviews")(
+        "generate-segment-lengths",
+        boost::program_options::value<bool>(&extractor_config.generate_segment_lengths)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Precompute the lengths of the segments to speed up annotations and debug tiles")(
+        "small-component-size",
+        boost::program_options::value<unsigned int>(&extractor_config.small_component_size)
+            ->default_value(1000),
+        "Number of nodes required before a strongly-connected-componennt is considered big "
+        "(affects nearest neighbor snapping)")(
+        "sort-memory",
+        boost::program_options::value<unsigned int>(&extractor_config.sort_memory)
+            ->default_value(4096),
+        "Memory in MiB to sort data in, larger data is sorted in runs of this size and merged")(
+        "two-pass",
+        boost::program_options::value<bool>(&extractor_config.two_pass)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Read the input twice, the ways first to only keep the nodes of routable ways. Lowers "
+        "the disk space and time needed to sort nodes")(
+        "apply-changes",
+        boost::program_options::value<std::vector<boost::filesystem::path>>(
+            &extractor_config.change_paths)
+            ->multitoken(),
+        "Apply these OSM change files (.osc) to the input while it is read")(
+        "reuse-way-results",
+        boost::program_options::value<bool>(&extractor_config.reuse_way_results)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Reuse the profile results of the ways that didn't change since the last extraction "
+        "with this option, which are stored in .osrm.way_results");
+
+    // the options of osrm-contract, except the ones that update the weights of the .ebg
+    boost::program_options::options_description contractor_options("Contraction");
+    contractor_options.add_options()(
+        "core,k",
+        boost::program_options::value<double>(&contractor_config.core_factor)->default_value(1.0),
+        "Percentage of the graph (in vertices) to contract [0..1]")(
+        "core-landmarks",
+        boost::program_options::value<unsigned>(&contractor_config.number_of_landmarks)
+            ->default_value(0),
+        "Number of landmarks for A* searches in the uncontracted core, 0 to disable")(
+        "hub-labels",
+        boost::program_options::value<bool>(&contractor_config.compute_hub_labels)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Compute hub labels for distance tables from the contraction hierarchy")(
+        "hub-labels-max-nodes",
+        boost::program_options::value<unsigned>(&contractor_config.max_hub_label_nodes)
+            ->default_value(2000000),
+        "Largest number of graph nodes hub labels are computed for")(
+        "witness-cache",
+        boost::program_options::value<bool>(&contractor_config.use_witness_cache)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Reuse the witness paths of earlier searches while they are valid. Faster, but needs "
+        "more memory")(
+        "witness-hop-limit",
+        boost::program_options::value<unsigned>(&contractor_config.witness_hop_limit)
+            ->default_value(0),
+        "Limit the hops of witness searches while the graph is sparse, 0 to disable")(
+        "witness-hop-limit-degree",
+        boost::program_options::value<double>(&contractor_config.witness_hop_limit_degree)
+            ->default_value(3.3),
+        "Average degree of the remaining graph below which the hop limit applies")(
+        "level-cache,o",
+        boost::program_options::value<bool>(&contractor_config.use_cached_priority)
+            ->default_value(false),
+        "Use .level file to retain the contaction level for each node from the last run.")(
+        "renumber-nodes",
+        boost::program_options::value<bool>(&contractor_config.renumber_nodes)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Renumber the nodes by their contraction level and their position for faster queries");
+
+    // hidden options, will be allowed on command line, but will not be
+    // shown to the user
+    boost::program_options::options_description hidden_options("Hidden options");
+    hidden_options.add_options()(
+        "input,i",
+        boost::program_options::value<boost::filesystem::path>(&extractor_config.input_path),
+        "Input file in .osm, .osm.bz2 or .osm.pbf format");
+
+    // positional option
+    boost::program_options::positional_options_description positional_options;
+    positional_options.add("input", 1);
+
+    // combine above options for parsing
+    boost::program_options::options_description cmdline_options;
+    cmdline_options.add(generic_options)
+        .add(config_options)
+        .add(extractor_options)
+        .add(contractor_options)
+        .add(hidden_options);
+
+    const auto *executable = argv[0];
+    boost::program_options::options_description visible_options(
+        boost::filesystem::path(executable).filename().string() +
+        " <input.osm/.osm.bz2/.osm.pbf> [options]");
+    visible_options.add(generic_options)
+        .add(config_options)
+        .add(extractor_options)
+        .add(contractor_options);
+
+    // parse command line options
+    boost::program_options::variables_map option_variables;
+    try
+    {
+        boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                          .options(cmdline_options)
+                                          .positional(positional_options)
+                                          .run(),
+                                      option_variables);
+    }
+    catch (const boost::program_options::error &e)
+    {
+        util::SimpleLogger().Write(logWARNING) << "[error] " << e.what();
+        return return_code::fail;
+    }
+
+    if (option_variables.count("version"))
+    {
+        util::SimpleLogger().Write() << OSRM_VERSION;
+        return return_code::exit;
+    }
+
+    if (option_variables.count("help"))
+    {
+        util::SimpleLogger().Write() << visible_options;
+        return return_code::exit;
+    }
+
+    boost::program_options::notify(option_variables);
+
+    if (!option_variables.count("input"))
+    {
+        util::SimpleLogger().Write() << visible_options;
+        return return_code::exit;
+    }
+
+    return return_code::ok;
+}
+
+// osrm-extract and osrm-contract in one process: the edge-expanded graph is contracted where the
+// extraction leaves it, without writing and reading the .ebg and .enw
+int main(int argc, char *argv[]) try
+{
+    util::LogPolicy::GetInstance().Unmute();
+    extractor::ExtractorConfig extractor_config;
+    contractor::ContractorConfig contractor_config;
+
+    const auto result = parseArguments(argc, argv, extractor_config, contractor_config);
+
+    if (return_code::fail == result)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (return_code::exit == result)
+    {
+        return EXIT_SUCCESS;
+    }
+
+    extractor_config.UseDefaultOutputNames();
+    contractor_config.osrm_input_path = extractor_config.output_file_name;
+    contractor_config.UseDefaultOutputNames();
+    contractor_config.requested_num_threads = extractor_config.requested_num_threads;
+    contractor_config.trace_path = extractor_config.trace_path;
+    contractor_config.trace_format = extractor_config.trace_format;
+
+    if (1 > extractor_config.requested_num_threads)
+    {
+        util::SimpleLogger().Write(logWARNING) << "Number of threads must be 1 or larger";
+        return EXIT_FAILURE;
+    }
+
+    util::PhaseTrace::Format trace_format;
+    if (!util::PhaseTrace::GetFormat(extractor_config.trace_format, trace_format))
+    {
+        util::SimpleLogger().Write(logWARNING) << "Unknown trace format "
+                                               << extractor_config.trace_format;
+        return EXIT_FAILURE;
+    }
+
+    if (!boost::filesystem::is_regular_file(extractor_config.input_path))
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "Input file " << extractor_config.input_path.string() << " not found!";
+        return EXIT_FAILURE;
+    }
+
+    for (const auto &change_path : extractor_config.change_paths)
+    {
+        if (!boost::filesystem::is_regular_file(change_path))
+        {
+            util::SimpleLogger().Write(logWARNING) << "Change file " << change_path.string()
+                                                   << " not found!";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!boost::filesystem::is_regular_file(extractor_config.profile_path))
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "Profile " << extractor_config.profile_path.string() << " not found!";
+        return EXIT_FAILURE;
+    }
+
+    extractor::EdgeBasedGraph edge_based_graph;
+    {
+        // the profile isn't needed anymore while contracting
+        std::unique_ptr<extractor::ScriptingEnvironment> scripting_environment;
+        if (extractor_config.profile_path.extension() == ".ini")
+        {
+            scripting_environment = util::make_unique<extractor::NativeScriptingEnvironment>(
+                extractor_config.profile_path.string());
+        }
+        else
+        {
+            scripting_environment = util::make_unique<extractor::LuaScriptingEnvironment>(
+                extractor_config.profile_path.string().c_str());
+        }
+        const auto extractor_result =
+            extractor::Extractor(extractor_config).run(*scripting_environment, edge_based_graph);
+        if (extractor_result != 0)
+        {
+            return extractor_result;
+        }
+    }
+
+    tbb::task_scheduler_init init(contractor_config.requested_num_threads);
+
+    return contractor::Contractor(contractor_config).Run(edge_based_graph);
+}
+catch (const std::bad_alloc &e)
+{
+    util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    util::SimpleLogger().Write(logWARNING)
+        << "Please provide more memory or consider using a larger swapfile";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,37 @@
+#include "extractor/raster_source.hpp"
+#include "util/simple_logger.hpp"
+#include "util/timing_util.hpp"
+
+#include <cstdlib>
+#include <exception>
+#include <string>
+
+// Converts an ASCII grid of a raster source into the tiled binary format, which the
+// sources:load of a profile maps into memory instead of parsing it on every extraction
+int main(int argc, char *argv[]) try
+{
+    osrm::util::LogPolicy::GetInstance().Unmute();
+    if (argc != 5)
+    {
+        osrm::util::SimpleLogger().Write(logWARNING) << "usage: " << argv[0]
+                                                     << " input.asc nrows ncols output.raster";
+        return EXIT_FAILURE;
+    }
+
+    const std::size_t nrows = std::stoul(argv[2]);
+    const std::size_t ncols = std::stoul(argv[3]);
+
+    TIMER_START(convert);
+    const auto grid = osrm::extractor::RasterGrid::Load(argv[1], ncols, nrows);
+    grid.WriteTiles(argv[4]);
+    TIMER_STOP(convert);
+
+    osrm::util::SimpleLogger().Write() << "Wrote " << argv[4] << " after "
+                                       << TIMER_SEC(convert) << "s";
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    osrm::util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    return EXIT_FAILURE;
+}
@@ -1,5 +1,9 @@
 #include "server/server.hpp"
+#include "server/shard_service_handler.hpp"
+#include "storage/compressed_file.hpp"
 #include "util/make_unique.hpp"
+#include "util/sampling_profiler.hpp"
+#include "util/shard_map.hpp"
 #include "util/simple_logger.hpp"
 #include "util/version.hpp"
 
@@ -19,12 +23,17 @@
 
 #include <signal.h>
 
+#include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <future>
 #include <iostream>
+#include <memory>
 #include <new>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #ifdef _WIN32
 boost::function0<void> console_ctrl_function;
@@ -54,7 +63,7 @@ const static unsigned INIT_FAILED = -1;
 // generate boost::program_options object for the routing part
 inline unsigned generateServerProgramOptions(const int argc,
                                              const char *argv[],
-                                             boost::filesystem::path &base_path,
+                                             std::vector<std::string> &base_paths,
                                              std::string &ip_address,
                                              int &ip_port,
                                              int &requested_num_threads,
@@ -64,11 +73,56 @@ inline unsigned generateServerProgramOptions(const int argc,
                                              int &max_locations_viaroute,
                                              int &max_locations_distance_table,
                                              int &max_locations_map_matching,
-                                             int &max_results_nearest)
+                                             int &max_results_nearest,
+                                             int &max_locations_nearest,
+                                             int &max_pairs_route_batch,
+                                             int &max_duration_isochrone,
+                                             int &max_query_time,
+                                             int &max_query_memory,
+                                             bool &use_parallel_distance_table,
+                                             bool &use_parallel_route_legs,
+                                             std::size_t &parallel_unpacking_length,
+                                             std::size_t &large_trip_locations,
+                                             std::size_t &unpacking_cache_size,
+                                             std::size_t &snapping_cache_size,
+                                             std::size_t &search_space_cache_size,
+                                             std::size_t &tile_cache_size,
+                                             std::size_t &max_table_sessions,
+                                             bool &use_stall_on_demand,
+                                             bool &use_mmap,
+                                             bool &use_numa_replicas,
+                                             bool &prefetch_rtree_leaves,
+                                             bool &prefetch_search_graph,
+                                             bool &warmup_data,
+                                             bool &lock_data,
+                                             unsigned &block_heat_interval,
+                                             bool &use_traffic_overlay,
+                                             EngineConfig::Algorithm &algorithm,
+                                             bool &io_service_per_thread,
+                                             int &compute_threads,
+                                             std::size_t &max_queued_queries,
+                                             std::string &unix_socket_path,
+                                             std::size_t &response_cache_size,
+                                             int &response_cache_ttl,
+                                             bool &coalesce_requests,
+                                             std::size_t &stream_table_entries,
+                                             std::size_t &tile_store_size,
+                                             boost::filesystem::path &tile_store_directory,
+                                             std::vector<double> &prerender_tiles,
+                                             unsigned &prerender_max_zoom,
+                                             boost::filesystem::path &shard_map_path,
+                                             double &shard_timeout,
+                                             std::string &access_log_format,
+                                             double &access_log_sample_rate,
+                                             unsigned &profile_seconds,
+                                             unsigned &profile_frequency,
+                                             boost::filesystem::path &profile_directory)
 {
     using boost::program_options::value;
     using boost::filesystem::path;
 
+    std::string algorithm_name;
+
     // declare a group of options that will be allowed only on command line
     boost::program_options::options_description generic_options("Options");
     generic_options.add_options()                                         //
@@ -104,16 +158,157 @@ inline unsigned generateServerProgramOptions(const int argc,
          "Max. locations supported in map matching query") //
         ("max-nearest-size",
          value<int>(&max_results_nearest)->default_value(100),
-         "Max. results supported in nearest query");
+         "Max. results supported in nearest query") //
+        ("max-nearest-locations",
+         value<int>(&max_locations_nearest)->default_value(1000),
+         "Max. locations supported in nearest query") //
+        ("max-route-batch-size",
+         value<int>(&max_pairs_route_batch)->default_value(1000),
+         "Max. coordinate pairs supported in route batch query") //
+        ("max-isochrone-duration",
+         value<int>(&max_duration_isochrone)->default_value(3600),
+         "Max. seconds of the contours supported in isochrone query") //
+        ("max-query-time",
+         value<int>(&max_query_time)->default_value(-1),
+         "Milliseconds a query may run before it is answered with 503, -1 for no limit") //
+        ("max-query-memory",
+         value<int>(&max_query_memory)->default_value(-1),
+         "Megabytes a query may reserve for its tables and matrices before it fails with "
+         "TooBig, -1 for no limit") //
+        ("parallel-table",
+         value<bool>(&use_parallel_distance_table)->implicit_value(true)->default_value(false),
+         "Use all cores for the searches of a single distance table query") //
+        ("parallel-route",
+         value<bool>(&use_parallel_route_legs)->implicit_value(true)->default_value(false),
+         "Use all cores for the legs of a single route query with several waypoints") //
+        ("parallel-unpacking",
+         value<std::size_t>(&parallel_unpacking_length)->default_value(0),
+         "Unpack the paths of route and trip legs with at least this many packed edges on all "
+         "cores, 0 to disable") //
+        ("large-trip-locations",
+         value<std::size_t>(&large_trip_locations)->default_value(0),
+         "Solve trips with more than this many locations in clusters of nearby locations instead "
+         "of from the table of all of them, 0 to disable") //
+        ("unpacking-cache-size",
+         value<std::size_t>(&unpacking_cache_size)->default_value(0),
+         "Number of unpacked shortcuts cached across queries, 0 to disable") //
+        ("snapping-cache-size",
+         value<std::size_t>(&snapping_cache_size)->default_value(0),
+         "Number of snapped coordinates cached across queries, 0 to disable") //
+        ("search-space-cache-size",
+         value<std::size_t>(&search_space_cache_size)->default_value(0),
+         "Number of upward search spaces of table locations cached across queries, 0 to "
+         "disable") //
+        ("tile-cache-size",
+         value<std::size_t>(&tile_cache_size)->default_value(0),
+         "Number of zoom 13 tiles whose segments are cached for tile queries, 0 to disable") //
+        ("max-table-sessions",
+         value<std::size_t>(&max_table_sessions)->default_value(0),
+         "Number of table sessions kept for incremental updates, 0 to disable") //
+        ("stall-on-demand",
+         value<bool>(&use_stall_on_demand)->implicit_value(true)->default_value(false),
+         "Also prune the nodes reached from stalled nodes in route, trip and match queries") //
+        ("mmap",
+         value<bool>(&use_mmap)->implicit_value(true)->default_value(false),
+         "Map the graph, geometry and name files into memory instead of reading them") //
+        ("numa",
+         value<bool>(&use_numa_replicas)->implicit_value(true)->default_value(false),
+         "Bind the threads to the NUMA nodes and load a copy of the data on each node") //
+        ("prefetch-rtree-leaves",
+         value<bool>(&prefetch_rtree_leaves)->implicit_value(true)->default_value(false),
+         "Read ahead the r-tree leaves queries visit next and count their page faults") //
+        ("prefetch-search-graph",
+         value<bool>(&prefetch_search_graph)->implicit_value(true)->default_value(false),
+         "Load the edges of the nodes route searches settle next into the cache ahead of time") //
+        ("warmup",
+         value<bool>(&warmup_data)->implicit_value(true)->default_value(false),
+         "Read all of the data in the background after the start, /health answers 503 until "
+         "it is done") //
+        ("lock-data",
+         value<bool>(&lock_data)->implicit_value(true)->default_value(false),
+         "Lock the data into memory once it is warmed up, needs --warmup") //
+        ("block-heat",
+         value<unsigned>(&block_heat_interval)->default_value(0),
+         "Log which share of every block of the data was accessed every this many seconds, 0 "
+         "to disable. Needs CAP_SYS_ADMIN, else it reports the resident pages") //
+        ("traffic-overlay",
+         value<bool>(&use_traffic_overlay)->implicit_value(true)->default_value(false),
+         "Add the traffic penalties written by osrm-traffic to route, table and trip queries") //
+        ("algorithm",
+         value<std::string>(&algorithm_name)->default_value("CH"),
+         "Algorithm of the route and table searches: CH or MLD, which needs osrm-customize") //
+        ("io-service-per-thread",
+         value<bool>(&io_service_per_thread)->implicit_value(true)->default_value(false),
+         "Give every thread its own acceptor and connections instead of sharing them") //
+        ("compute-threads",
+         value<int>(&compute_threads)->default_value(0),
+         "Number of threads that run the queries, 0 to run them on the I/O threads") //
+        ("max-queued-queries",
+         value<std::size_t>(&max_queued_queries)->default_value(0),
+         "Queries of a service class waiting for a compute thread before new ones are answered "
+         "with 429, 0 for 64 per compute thread") //
+        ("unix-socket",
+         value<std::string>(&unix_socket_path),
+         "Also accept connections on a Unix domain socket at this path") //
+        ("response-cache-size",
+         value<std::size_t>(&response_cache_size)->default_value(0),
+         "Megabytes of route and table replies cached for repeated queries, 0 to disable") //
+        ("response-cache-ttl",
+         value<int>(&response_cache_ttl)->default_value(300),
+         "Seconds a cached reply is used for") //
+        ("coalesce-requests",
+         value<bool>(&coalesce_requests)->implicit_value(true)->default_value(false),
+         "Compute identical queries that arrive at the same time once and share the reply") //
+        ("stream-table-entries",
+         value<std::size_t>(&stream_table_entries)->default_value(0),
+         "Send JSON tables of at least this many entries in chunks while they are computed, "
+         "0 to disable") //
+        ("tile-store-size",
+         value<std::size_t>(&tile_store_size)->default_value(0),
+         "Megabytes of rendered tiles kept in memory, 0 to disable") //
+        ("tile-store-dir",
+         value<boost::filesystem::path>(&tile_store_directory),
+         "Directory the rendered tiles are stored in") //
+        ("prerender-tiles",
+         value<std::vector<double>>(&prerender_tiles)->multitoken(),
+         "Render the tiles of a bounding box into the tile store on startup: "
+         "min_lon min_lat max_lon max_lat") //
+        ("prerender-max-zoom",
+         value<unsigned>(&prerender_max_zoom)->default_value(14),
+         "Highest zoom level of the tiles rendered on startup") //
+        ("shards",
+         value<boost::filesystem::path>(&shard_map_path),
+         "Answer the queries with the osrm-routed of the shards of a shard map of osrm-shard "
+         "instead of a dataset") //
+        ("shard-timeout",
+         value<double>(&shard_timeout)->default_value(30),
+         "Seconds to wait for the reply of a shard, 0 to wait forever") //
+        ("access-log",
+         value<std::string>(&access_log_format)->default_value("text"),
+         "Format of the access log: text, json or none") //
+        ("access-log-sample",
+         value<double>(&access_log_sample_rate)->default_value(1),
+         "Share of the successful requests that are logged, failed ones are always logged") //
+        ("profile-seconds",
+         value<unsigned>(&profile_seconds)->default_value(30),
+         "Seconds that SIGUSR2 samples the stacks of the threads for") //
+        ("profile-frequency",
+         value<unsigned>(&profile_frequency)
+             ->default_value(util::SamplingProfiler::DEFAULT_FREQUENCY),
+         "Samples per second of CPU time of the profile of SIGUSR2") //
+        ("profile-dir",
+         value<boost::filesystem::path>(&profile_directory)->default_value("."),
+         "Directory that the profiles of SIGUSR2 are written to as collapsed stacks");
 
     // hidden options, will be allowed on command line, but will not be shown to the user
     boost::program_options::options_description hidden_options("Hidden options");
-    hidden_options.add_options()(
-        "base,b", value<boost::filesystem::path>(&base_path), "base path to .osrm file");
+    hidden_options.add_options()("base,b",
+                                 value<std::vector<std::string>>(&base_paths)->composing(),
+                                 "base path to .osrm file, or profile=path for several");
 
     // positional option
     boost::program_options::positional_options_description positional_options;
-    positional_options.add("base", 1);
+    positional_options.add("base", -1);
 
     // combine above options for parsing
     boost::program_options::options_description cmdline_options;
@@ -121,7 +316,8 @@ inline unsigned generateServerProgramOptions(const int argc,
 
     const auto *executable = argv[0];
     boost::program_options::options_description visible_options(
-        boost::filesystem::path(executable).filename().string() + " <base.osrm> [<options>]");
+        boost::filesystem::path(executable).filename().string() +
+        " <base.osrm> | <profile>=<base.osrm>... | --shards <map> [<options>]");
     visible_options.add(generic_options).add(config_options);
 
     // parse command line options
@@ -154,6 +350,62 @@ inline unsigned generateServerProgramOptions(const int argc,
 
     boost::program_options::notify(option_variables);
 
+    if (algorithm_name == "CH")
+    {
+        algorithm = EngineConfig::Algorithm::CH;
+    }
+    else if (algorithm_name == "MLD")
+    {
+        algorithm = EngineConfig::Algorithm::MLD;
+    }
+    else
+    {
+        util::SimpleLogger().Write(logWARNING) << "--algorithm expects CH or MLD";
+        return INIT_FAILED;
+    }
+
+    if (access_log_format != "text" && access_log_format != "json" &&
+        access_log_format != "none")
+    {
+        util::SimpleLogger().Write(logWARNING) << "--access-log expects text, json or none";
+        return INIT_FAILED;
+    }
+    if (access_log_sample_rate < 0 || access_log_sample_rate > 1)
+    {
+        util::SimpleLogger().Write(logWARNING) << "--access-log-sample expects a share of 0 to 1";
+        return INIT_FAILED;
+    }
+
+    if (profile_seconds == 0 || profile_frequency == 0 || profile_frequency > 10000)
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "--profile-seconds expects at least 1, --profile-frequency 1 to 10000";
+        return INIT_FAILED;
+    }
+
+    if (lock_data && !warmup_data)
+    {
+        util::SimpleLogger().Write(logWARNING) << "--lock-data needs --warmup";
+        return INIT_FAILED;
+    }
+
+    if (!prerender_tiles.empty() && prerender_tiles.size() != 4)
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "--prerender-tiles expects min_lon min_lat max_lon max_lat";
+        return INIT_FAILED;
+    }
+
+    if (option_variables.count("shards"))
+    {
+        if (!use_shared_memory && !option_variables.count("base"))
+        {
+            return INIT_OK_START_ENGINE;
+        }
+        util::SimpleLogger().Write(logWARNING) << "--shards conflicts with the dataset settings.";
+        return INIT_FAILED;
+    }
+
     if (!use_shared_memory && option_variables.count("base"))
     {
         return INIT_OK_START_ENGINE;
@@ -172,6 +424,143 @@ inline unsigned generateServerProgramOptions(const int argc,
     return INIT_OK_DO_NOT_START_ENGINE;
 }
 
+// Splits the base paths into the profiles and the configurations of their datasets. A single
+// dataset may come without a profile, it answers the queries of every profile then.
+bool makeDatasets(const std::vector<std::string> &base_paths,
+                  const EngineConfig &config,
+                  std::vector<std::pair<std::string, EngineConfig>> &datasets)
+{
+    if (config.use_shared_memory)
+    {
+        datasets.emplace_back(std::string(), config);
+        return true;
+    }
+
+    for (const auto &base_path : base_paths)
+    {
+        const auto separator = base_path.find('=');
+        if (separator == std::string::npos && base_paths.size() > 1)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "several datasets need a profile each: <profile>=<base.osrm>";
+            return false;
+        }
+        const auto profile =
+            separator == std::string::npos ? std::string() : base_path.substr(0, separator);
+        const auto is_alpha_numeric = [](const char c) { return std::isalnum(c) != 0; };
+        if (separator != std::string::npos &&
+            (profile.empty() || !std::all_of(profile.begin(), profile.end(), is_alpha_numeric)))
+        {
+            util::SimpleLogger().Write(logWARNING) << "profile names are alphanumeric, not "
+                                                   << profile;
+            return false;
+        }
+        const auto has_profile = [&](const std::pair<std::string, EngineConfig> &dataset) {
+            return dataset.first == profile;
+        };
+        if (std::any_of(datasets.begin(), datasets.end(), has_profile))
+        {
+            util::SimpleLogger().Write(logWARNING) << "profile " << profile << " is given twice";
+            return false;
+        }
+
+        EngineConfig dataset_config = config;
+        dataset_config.storage_config = storage::StorageConfig(
+            separator == std::string::npos ? base_path : base_path.substr(separator + 1));
+        // the datasets of several profiles share the files they have in common
+        dataset_config.share_data = base_paths.size() > 1;
+        datasets.emplace_back(profile, std::move(dataset_config));
+    }
+    return true;
+}
+
+void logMissingFiles(const storage::StorageConfig &storage_config)
+{
+    if (!boost::filesystem::is_regular_file(storage_config.ram_index_path))
+    {
+        util::SimpleLogger().Write(logWARNING) << storage_config.ram_index_path << " is not found";
+    }
+    if (!boost::filesystem::is_regular_file(storage_config.file_index_path))
+    {
+        util::SimpleLogger().Write(logWARNING) << storage_config.file_index_path << " is not found";
+    }
+    if (!boost::filesystem::is_regular_file(storage_config.hsgr_data_path))
+    {
+        util::SimpleLogger().Write(logWARNING) << storage_config.hsgr_data_path << " is not found";
+    }
+    if (!boost::filesystem::is_regular_file(storage_config.nodes_data_path))
+    {
+        util::SimpleLogger().Write(logWARNING) << storage_config.nodes_data_path << " is not found";
+    }
+    if (!boost::filesystem::is_regular_file(storage_config.edges_data_path))
+    {
+        util::SimpleLogger().Write(logWARNING) << storage_config.edges_data_path << " is not found";
+    }
+    if (!boost::filesystem::is_regular_file(storage_config.core_data_path))
+    {
+        util::SimpleLogger().Write(logWARNING) << storage_config.core_data_path << " is not found";
+    }
+    if (!boost::filesystem::is_regular_file(storage_config.geometries_path))
+    {
+        util::SimpleLogger().Write(logWARNING) << storage_config.geometries_path << " is not found";
+    }
+    if (!boost::filesystem::is_regular_file(storage_config.timestamp_path))
+    {
+        util::SimpleLogger().Write(logWARNING) << storage_config.timestamp_path << " is not found";
+    }
+    if (!boost::filesystem::is_regular_file(storage_config.datasource_names_path))
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << storage_config.datasource_names_path << " is not found";
+    }
+    if (!boost::filesystem::is_regular_file(storage_config.datasource_indexes_path))
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << storage_config.datasource_indexes_path << " is not found";
+    }
+    if (!boost::filesystem::is_regular_file(storage_config.names_data_path))
+    {
+        util::SimpleLogger().Write(logWARNING) << storage_config.names_data_path << " is not found";
+    }
+    if (!boost::filesystem::is_regular_file(storage_config.properties_path))
+    {
+        util::SimpleLogger().Write(logWARNING) << storage_config.properties_path << " is not found";
+    }
+}
+
+#ifndef _WIN32
+// Samples the stacks of the threads and writes them to osrm-routed.<pid>.<unix time>.folded
+void profileThreads(const unsigned seconds,
+                    const unsigned frequency,
+                    const boost::filesystem::path &directory)
+{
+    const auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count();
+    const auto path = directory / ("osrm-routed." + std::to_string(getpid()) + "." +
+                                   std::to_string(timestamp) + ".folded");
+    util::SimpleLogger().Write() << "profiling for " << seconds << "s into " << path;
+    try
+    {
+        util::SamplingProfiler::Summary summary;
+        if (!util::SamplingProfiler::GetInstance().Profile(
+                std::chrono::seconds(seconds), frequency, path, summary))
+        {
+            util::SimpleLogger().Write(logWARNING) << "profiling failed, a profile is running";
+            return;
+        }
+        util::SimpleLogger().Write() << "wrote " << summary.number_of_samples << " samples of "
+                                     << summary.number_of_stacks << " stacks to " << path << ", "
+                                     << summary.number_of_dropped_samples
+                                     << " samples didn't fit";
+    }
+    catch (const std::exception &e)
+    {
+        util::SimpleLogger().Write(logWARNING) << "profiling failed: " << e.what();
+    }
+}
+#endif
+
 int main(int argc, const char *argv[]) try
 {
     util::LogPolicy::GetInstance().Unmute();
@@ -179,12 +568,31 @@ int main(int argc, const char *argv[]) try
     bool trial_run = false;
     std::string ip_address;
     int ip_port, requested_thread_num;
+    bool io_service_per_thread = false;
+    int compute_threads = 0;
+    std::size_t max_queued_queries = 0;
+    std::string unix_socket_path;
+    std::size_t response_cache_size = 0;
+    int response_cache_ttl = 0;
+    bool coalesce_requests = false;
+    std::size_t stream_table_entries = 0;
+    std::size_t tile_store_size = 0;
+    boost::filesystem::path tile_store_directory;
+    std::vector<double> prerender_tiles;
+    unsigned prerender_max_zoom = 0;
+    boost::filesystem::path shard_map_path;
+    double shard_timeout = 0;
+    std::string access_log_format;
+    double access_log_sample_rate = 1;
+    unsigned profile_seconds = 0;
+    unsigned profile_frequency = 0;
+    boost::filesystem::path profile_directory;
 
     EngineConfig config;
-    boost::filesystem::path base_path;
+    std::vector<std::string> base_paths;
     const unsigned init_result = generateServerProgramOptions(argc,
                                                               argv,
-                                                              base_path,
+                                                              base_paths,
                                                               ip_address,
                                                               ip_port,
                                                               requested_thread_num,
@@ -194,7 +602,50 @@ int main(int argc, const char *argv[]) try
                                                               config.max_locations_viaroute,
                                                               config.max_locations_distance_table,
                                                               config.max_locations_map_matching,
-                                                              config.max_results_nearest);
+                                                              config.max_results_nearest,
+                                                              config.max_locations_nearest,
+                                                              config.max_pairs_route_batch,
+                                                              config.max_duration_isochrone,
+                                                              config.max_query_time,
+                                                              config.max_query_memory,
+                                                              config.use_parallel_distance_table,
+                                                              config.use_parallel_route_legs,
+                                                              config.parallel_unpacking_length,
+                                                              config.large_trip_locations,
+                                                              config.unpacking_cache_size,
+                                                              config.snapping_cache_size,
+                                                              config.search_space_cache_size,
+                                                              config.tile_cache_size,
+                                                              config.max_table_sessions,
+                                                              config.use_stall_on_demand,
+                                                              config.use_mmap,
+                                                              config.use_numa_replicas,
+                                                              config.prefetch_rtree_leaves,
+                                                              config.prefetch_search_graph,
+                                                              config.warmup_data,
+                                                              config.lock_data,
+                                                              config.block_heat_interval,
+                                                              config.use_traffic_overlay,
+                                                              config.algorithm,
+                                                              io_service_per_thread,
+                                                              compute_threads,
+                                                              max_queued_queries,
+                                                              unix_socket_path,
+                                                              response_cache_size,
+                                                              response_cache_ttl,
+                                                              coalesce_requests,
+                                                              stream_table_entries,
+                                                              tile_store_size,
+                                                              tile_store_directory,
+                                                              prerender_tiles,
+                                                              prerender_max_zoom,
+                                                              shard_map_path,
+                                                              shard_timeout,
+                                                              access_log_format,
+                                                              access_log_sample_rate,
+                                                              profile_seconds,
+                                                              profile_frequency,
+                                                              profile_directory);
     if (init_result == INIT_OK_DO_NOT_START_ENGINE)
     {
         return EXIT_SUCCESS;
@@ -203,80 +654,25 @@ int main(int argc, const char *argv[]) try
     {
         return EXIT_FAILURE;
     }
-    if (!base_path.empty())
+    // the front end of shards has no dataset of its own
+    std::vector<std::pair<std::string, EngineConfig>> datasets;
+    if (shard_map_path.empty() && !makeDatasets(base_paths, config, datasets))
     {
-        config.storage_config = storage::StorageConfig(base_path);
+        return EXIT_FAILURE;
     }
-    if (!config.IsValid())
+    for (const auto &dataset : datasets)
     {
-        if (base_path.empty() != config.use_shared_memory)
+        // osrm-datastore decompressed the files of a dataset in shared memory
+        if (!config.use_shared_memory)
         {
-            util::SimpleLogger().Write(logWARNING) << "Path settings and shared memory conflicts.";
+            storage::compressed_file::decompressUpdated(
+                dataset.second.storage_config.GetCompressibleFiles());
         }
-        else
+        if (!dataset.second.IsValid())
         {
-            if (!boost::filesystem::is_regular_file(config.storage_config.ram_index_path))
-            {
-                util::SimpleLogger().Write(logWARNING) << config.storage_config.ram_index_path
-                                                       << " is not found";
-            }
-            if (!boost::filesystem::is_regular_file(config.storage_config.file_index_path))
-            {
-                util::SimpleLogger().Write(logWARNING) << config.storage_config.file_index_path
-                                                       << " is not found";
-            }
-            if (!boost::filesystem::is_regular_file(config.storage_config.hsgr_data_path))
-            {
-                util::SimpleLogger().Write(logWARNING) << config.storage_config.hsgr_data_path
-                                                       << " is not found";
-            }
-            if (!boost::filesystem::is_regular_file(config.storage_config.nodes_data_path))
-            {
-                util::SimpleLogger().Write(logWARNING) << config.storage_config.nodes_data_path
-                                                       << " is not found";
-            }
-            if (!boost::filesystem::is_regular_file(config.storage_config.edges_data_path))
-            {
-                util::SimpleLogger().Write(logWARNING) << config.storage_config.edges_data_path
-                                                       << " is not found";
-            }
-            if (!boost::filesystem::is_regular_file(config.storage_config.core_data_path))
-            {
-                util::SimpleLogger().Write(logWARNING) << config.storage_config.core_data_path
-                                                       << " is not found";
-            }
-            if (!boost::filesystem::is_regular_file(config.storage_config.geometries_path))
-            {
-                util::SimpleLogger().Write(logWARNING) << config.storage_config.geometries_path
-                                                       << " is not found";
-            }
-            if (!boost::filesystem::is_regular_file(config.storage_config.timestamp_path))
-            {
-                util::SimpleLogger().Write(logWARNING) << config.storage_config.timestamp_path
-                                                       << " is not found";
-            }
-            if (!boost::filesystem::is_regular_file(config.storage_config.datasource_names_path))
-            {
-                util::SimpleLogger().Write(logWARNING)
-                    << config.storage_config.datasource_names_path << " is not found";
-            }
-            if (!boost::filesystem::is_regular_file(config.storage_config.datasource_indexes_path))
-            {
-                util::SimpleLogger().Write(logWARNING)
-                    << config.storage_config.datasource_indexes_path << " is not found";
-            }
-            if (!boost::filesystem::is_regular_file(config.storage_config.names_data_path))
-            {
-                util::SimpleLogger().Write(logWARNING) << config.storage_config.names_data_path
-                                                       << " is not found";
-            }
-            if (!boost::filesystem::is_regular_file(config.storage_config.properties_path))
-            {
-                util::SimpleLogger().Write(logWARNING) << config.storage_config.properties_path
-                                                       << " is not found";
-            }
+            logMissingFiles(dataset.second.storage_config);
+            return EXIT_FAILURE;
         }
-        return EXIT_FAILURE;
     }
 
 #ifdef __linux__
@@ -314,13 +710,119 @@ int main(int argc, const char *argv[]) try
     sigset_t new_mask;
     sigset_t old_mask;
     sigfillset(&new_mask);
+    // the threads of the server and the engine are sampled by the profiler of SIGUSR2
+    sigdelset(&new_mask, SIGPROF);
     pthread_sigmask(SIG_BLOCK, &new_mask, &old_mask);
 #endif
 
-    auto routing_server = server::Server::CreateServer(ip_address, ip_port, requested_thread_num);
-    auto service_handler = util::make_unique<server::ServiceHandler>(config);
+    auto routing_server = server::Server::CreateServer(ip_address,
+                                                       ip_port,
+                                                       requested_thread_num,
+                                                       config.use_numa_replicas,
+                                                       io_service_per_thread,
+                                                       std::max(0, compute_threads),
+                                                       max_queued_queries,
+                                                       unix_socket_path);
+    // the old way to turn the access log off still works
+    if (access_log_format != "none" && !std::getenv("DISABLE_ACCESS_LOGGING"))
+    {
+        routing_server->RegisterAccessLog(util::make_unique<server::AccessLog>(
+            access_log_format == "json" ? server::AccessLog::Format::JSON
+                                        : server::AccessLog::Format::Text,
+            access_log_sample_rate,
+            std::cout));
+    }
+    if (coalesce_requests)
+    {
+        routing_server->RegisterRequestCoalescer(util::make_unique<server::RequestCoalescer>());
+    }
+    routing_server->SetStreamedTableEntries(stream_table_entries);
+    // the caches and tile stores are per profile, their sizes are as well
+    if (response_cache_size > 0)
+    {
+        util::SimpleLogger().Write() << "caching " << response_cache_size
+                                     << " MB of replies for " << response_cache_ttl << "s";
+    }
+    const bool use_tile_store = tile_store_size > 0 || !tile_store_directory.empty();
+    if (use_tile_store)
+    {
+        util::SimpleLogger().Write() << "storing " << tile_store_size << " MB of tiles in memory"
+                                     << (tile_store_directory.empty()
+                                             ? std::string()
+                                             : " and in " + tile_store_directory.string());
+    }
+
+    // owned by the server from here on
+    std::vector<server::ServiceHandler *> reloadable_handlers;
+    std::vector<std::pair<std::string, std::unique_ptr<server::ServiceHandlerInterface>>>
+        service_handlers;
+    if (!shard_map_path.empty())
+    {
+        util::SimpleLogger().Write() << "answering the queries with the shards of "
+                                     << shard_map_path.string();
+        service_handlers.emplace_back(
+            std::string(),
+            util::make_unique<server::ShardServiceHandler>(
+                util::ShardMap(shard_map_path.string()),
+                // the tables asked of the shards stay within their own limit
+                config.max_locations_distance_table > 0
+                    ? static_cast<unsigned>(std::max(2, config.max_locations_distance_table))
+                    : 100u,
+                shard_timeout));
+    }
+    for (auto &dataset : datasets)
+    {
+        const auto &profile = dataset.first;
+        if (!profile.empty())
+        {
+            util::SimpleLogger().Write() << "loading the dataset of profile " << profile;
+        }
+        auto service_handler = util::make_unique<server::ServiceHandler>(dataset.second);
+        reloadable_handlers.push_back(service_handler.get());
+        service_handlers.emplace_back(profile, std::move(service_handler));
+    }
+    const auto number_of_profiles = service_handlers.size();
+    for (auto &profile_and_handler : service_handlers)
+    {
+        const auto &profile = profile_and_handler.first;
+        routing_server->RegisterServiceHandler(std::move(profile_and_handler.second), profile);
+        if (response_cache_size > 0)
+        {
+            routing_server->RegisterResponseCache(
+                util::make_unique<server::ResponseCache>(
+                    response_cache_size * 1024 * 1024, std::chrono::seconds(response_cache_ttl)),
+                profile);
+        }
+        if (use_tile_store)
+        {
+            const auto directory = number_of_profiles > 1 && !tile_store_directory.empty()
+                                       ? tile_store_directory / profile
+                                       : tile_store_directory;
+            routing_server->RegisterTileStore(
+                util::make_unique<server::TileStore>(tile_store_size * 1024 * 1024, directory),
+                profile);
+        }
+    }
 
-    routing_server->RegisterServiceHandler(std::move(service_handler));
+    if (use_tile_store)
+    {
+        if (!prerender_tiles.empty())
+        {
+            const util::Coordinate south_west{util::FloatLongitude{prerender_tiles[0]},
+                                              util::FloatLatitude{prerender_tiles[1]}};
+            const util::Coordinate north_east{util::FloatLongitude{prerender_tiles[2]},
+                                              util::FloatLatitude{prerender_tiles[3]}};
+            const auto prerender_start = std::chrono::steady_clock::now();
+            const auto number_of_tiles =
+                routing_server->PrerenderTiles(south_west, north_east, prerender_max_zoom);
+            util::SimpleLogger().Write()
+                << "rendered " << number_of_tiles << " tiles in "
+                << std::chrono::duration_cast<std::chrono::seconds>(
+                       std::chrono::steady_clock::now() - prerender_start)
+                       .count()
+                << "s";
+        }
+    }
 
     if (trial_run)
     {
@@ -342,13 +844,72 @@ int main(int argc, const char *argv[]) try
         sigaddset(&wait_mask, SIGINT);
         sigaddset(&wait_mask, SIGQUIT);
         sigaddset(&wait_mask, SIGTERM);
+        sigaddset(&wait_mask, SIGHUP);
+        sigaddset(&wait_mask, SIGUSR2);
         pthread_sigmask(SIG_BLOCK, &wait_mask, nullptr);
         util::SimpleLogger().Write() << "running and waiting for requests";
         if (std::getenv("SIGNAL_PARENT_WHEN_READY"))
         {
             kill(getppid(), SIGUSR1);
         }
-        sigwait(&wait_mask, &sig);
+        // SIGHUP reloads the files in the background, another one while a reload runs is dropped.
+        // SIGUSR2 profiles the threads in the background the same way.
+        std::future<void> reload;
+        std::future<void> profile;
+        while (sigwait(&wait_mask, &sig) == 0 && (sig == SIGHUP || sig == SIGUSR2))
+        {
+            if (sig == SIGUSR2)
+            {
+                if (profile.valid() &&
+                    profile.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                {
+                    util::SimpleLogger().Write(logWARNING)
+                        << "SIGUSR2 ignored, a profile is running";
+                    continue;
+                }
+                profile = std::async(
+                    std::launch::async, [profile_seconds, profile_frequency, &profile_directory] {
+                        profileThreads(profile_seconds, profile_frequency, profile_directory);
+                    });
+                continue;
+            }
+            if (config.use_shared_memory)
+            {
+                util::SimpleLogger().Write(logWARNING)
+                    << "SIGHUP ignored, data in shared memory is reloaded by osrm-datastore";
+                continue;
+            }
+            if (reload.valid() &&
+                reload.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                util::SimpleLogger().Write(logWARNING) << "SIGHUP ignored, a reload is running";
+                continue;
+            }
+            reload = std::async(std::launch::async, [&reloadable_handlers] {
+                for (auto *const reloadable_handler : reloadable_handlers)
+                {
+                    try
+                    {
+                        reloadable_handler->Reload();
+                    }
+                    catch (const std::exception &e)
+                    {
+                        util::SimpleLogger().Write(logWARNING)
+                            << "reloading failed, keeping the current data: " << e.what();
+                    }
+                }
+            });
+        }
+        if (reload.valid())
+        {
+            util::SimpleLogger().Write() << "waiting for the reload to finish";
+            reload.wait();
+        }
+        if (profile.valid())
+        {
+            util::SimpleLogger().Write() << "waiting for the profile to finish";
+            profile.wait();
+        }
 #else
         // Set console control handler to allow server to be stopped.
         console_ctrl_function = std::bind(&server::Server::Stop, routing_server);
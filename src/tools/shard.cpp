@@ -0,0 +1,462 @@
+#include "extractor/node_based_edge.hpp"
+#include "extractor/query_node.hpp"
+
+#include "util/coordinate_calculation.hpp"
+#include "util/exception.hpp"
+#include "util/graph_loader.hpp"
+#include "util/http_client.hpp"
+#include "util/integer_range.hpp"
+#include "util/json_container.hpp"
+#include "util/json_parser.hpp"
+#include "util/shard_map.hpp"
+#include "util/simple_logger.hpp"
+#include "util/typedefs.hpp"
+#include "util/version.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <numeric>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace osrm
+{
+namespace tools
+{
+
+struct ShardConfig
+{
+    boost::filesystem::path input_path;
+    boost::filesystem::path shard_map_path;
+    bool overlay;
+    unsigned number_of_shards;
+    double overlap;
+    double boundary_spacing;
+    std::vector<std::string> backends;
+    std::string profile;
+    unsigned table_size;
+    double timeout;
+};
+
+// degrees of latitude in a meter, and of longitude at the latitude
+const constexpr double DEGREES_PER_METER = 1. / 111319.49;
+double getLongitudeDegreesPerMeter(const double latitude)
+{
+    const auto cosine = std::cos(latitude * util::coordinate_calculation::detail::DEGREE_TO_RAD);
+    return DEGREES_PER_METER / std::max(0.01, static_cast<double>(cosine));
+}
+
+util::RectangleInt2D
+makeBox(const double west, const double south, const double east, const double north)
+{
+    return util::RectangleInt2D(util::FloatLongitude{west},
+                                util::FloatLongitude{east},
+                                util::FloatLatitude{south},
+                                util::FloatLatitude{north});
+}
+
+// Splits the nodes into shards of about the same number of nodes by cutting the longer side of a
+// box at the median node, down to boxes of single shards. The boxes tile the box of the network.
+void bisect(const std::vector<extractor::QueryNode> &nodes,
+            std::vector<NodeID>::iterator first,
+            std::vector<NodeID>::iterator last,
+            const util::RectangleInt2D box,
+            const unsigned number_of_shards,
+            std::vector<util::RectangleInt2D> &cores,
+            std::vector<std::uint32_t> &node_shards)
+{
+    if (number_of_shards == 1 || first == last)
+    {
+        for (auto node = first; node != last; ++node)
+        {
+            node_shards[*node] = cores.size();
+        }
+        cores.push_back(box);
+        // the shards that would have been split from an empty box stay empty
+        for (unsigned empty = 1; empty < number_of_shards; ++empty)
+        {
+            cores.push_back(box);
+        }
+        return;
+    }
+
+    const auto center_latitude = util::toFloating(box.Centroid().lat);
+    const auto width = static_cast<double>(util::toFloating(box.max_lon - box.min_lon)) /
+                       getLongitudeDegreesPerMeter(static_cast<double>(center_latitude));
+    const auto height = static_cast<double>(util::toFloating(box.max_lat - box.min_lat)) /
+                        DEGREES_PER_METER;
+    const bool split_longitude = width >= height;
+    const auto key = [&](const NodeID node) {
+        return split_longitude ? static_cast<std::int32_t>(nodes[node].lon)
+                               : static_cast<std::int32_t>(nodes[node].lat);
+    };
+
+    const auto left_shards = number_of_shards / 2;
+    const auto middle = first + (last - first) * left_shards / number_of_shards;
+    std::nth_element(first, middle, last, [&](const NodeID lhs, const NodeID rhs) {
+        return key(lhs) < key(rhs);
+    });
+    const auto split = middle == last ? key(*(last - 1)) : key(*middle);
+    // nodes on the cut belong to the right box
+    const auto right_first = std::partition(first, last, [&](const NodeID node) {
+        return key(node) < split;
+    });
+
+    auto left_box = box;
+    auto right_box = box;
+    if (split_longitude)
+    {
+        left_box.max_lon = util::FixedLongitude{split};
+        right_box.min_lon = util::FixedLongitude{split};
+    }
+    else
+    {
+        left_box.max_lat = util::FixedLatitude{split};
+        right_box.min_lat = util::FixedLatitude{split};
+    }
+    bisect(nodes, first, right_first, left_box, left_shards, cores, node_shards);
+    bisect(nodes,
+           right_first,
+           last,
+           right_box,
+           number_of_shards - left_shards,
+           cores,
+           node_shards);
+}
+
+util::RectangleInt2D growBox(const util::RectangleInt2D &box, const double meters)
+{
+    const auto west = static_cast<double>(util::toFloating(box.min_lon));
+    const auto south = static_cast<double>(util::toFloating(box.min_lat));
+    const auto east = static_cast<double>(util::toFloating(box.max_lon));
+    const auto north = static_cast<double>(util::toFloating(box.max_lat));
+    // a meter takes the most degrees of longitude at the latitude farthest from the equator
+    const auto longitude_offset =
+        meters * getLongitudeDegreesPerMeter(std::max(std::abs(south), std::abs(north)));
+    const auto latitude_offset = meters * DEGREES_PER_METER;
+    return makeBox(std::max(-180., west - longitude_offset),
+                   std::max(-90., south - latitude_offset),
+                   std::min(180., east + longitude_offset),
+                   std::min(90., north + latitude_offset));
+}
+
+util::ShardMap buildShardMap(const ShardConfig &config)
+{
+    std::ifstream input_stream(config.input_path.string(), std::ios::in | std::ios::binary);
+    if (!input_stream)
+    {
+        throw util::exception("Cannot open " + config.input_path.string());
+    }
+    std::vector<extractor::QueryNode> nodes;
+    std::vector<NodeID> barrier_nodes;
+    std::vector<NodeID> traffic_lights;
+    std::vector<extractor::NodeBasedEdge> edges;
+    util::loadNodesFromFile(input_stream, barrier_nodes, traffic_lights, nodes);
+    util::loadEdgesFromFile(input_stream, edges);
+    if (nodes.empty())
+    {
+        throw util::exception(config.input_path.string() + " contains no nodes");
+    }
+
+    util::RectangleInt2D network_box;
+    for (const auto &node : nodes)
+    {
+        network_box.MergeBoundingBoxes(
+            util::RectangleInt2D(node.lon, node.lon, node.lat, node.lat));
+    }
+
+    std::vector<NodeID> node_order(nodes.size());
+    std::iota(node_order.begin(), node_order.end(), 0);
+    std::vector<util::RectangleInt2D> cores;
+    std::vector<std::uint32_t> node_shards(nodes.size());
+    bisect(nodes,
+           node_order.begin(),
+           node_order.end(),
+           network_box,
+           config.number_of_shards,
+           cores,
+           node_shards);
+
+    util::ShardMap shard_map;
+    for (const auto &core : cores)
+    {
+        shard_map.AddShard(core, growBox(core, config.overlap));
+    }
+
+    // A boundary point for every road between two shards, but only one per cell of the spacing
+    // between the same shards, otherwise the overlay is as large as the boundary is detailed.
+    const auto cell_size = std::max(1e-6, config.boundary_spacing * DEGREES_PER_METER);
+    std::set<std::tuple<std::uint32_t, std::uint32_t, std::int64_t, std::int64_t>> used_cells;
+    std::size_t skipped_roads = 0;
+    for (const auto &edge : edges)
+    {
+        const auto first_shard = node_shards[edge.source];
+        const auto second_shard = node_shards[edge.target];
+        if (first_shard == second_shard)
+        {
+            continue;
+        }
+        const util::Coordinate coordinate(nodes[edge.source].lon, nodes[edge.source].lat);
+        if (!shard_map.IsInRegion(first_shard, coordinate) ||
+            !shard_map.IsInRegion(second_shard, coordinate))
+        {
+            ++skipped_roads;
+            continue;
+        }
+
+        const auto lower_shard = std::min(first_shard, second_shard);
+        const auto upper_shard = std::max(first_shard, second_shard);
+        const auto cell_x = static_cast<std::int64_t>(
+            std::floor(static_cast<double>(util::toFloating(coordinate.lon)) / cell_size));
+        const auto cell_y = static_cast<std::int64_t>(
+            std::floor(static_cast<double>(util::toFloating(coordinate.lat)) / cell_size));
+        if (used_cells.emplace(lower_shard, upper_shard, cell_x, cell_y).second)
+        {
+            shard_map.AddBoundaryPoint(coordinate, lower_shard, upper_shard);
+        }
+    }
+
+    util::SimpleLogger().Write() << "Split " << nodes.size() << " nodes into " << cores.size()
+                                 << " shards with " << shard_map.GetBoundaryPoints().size()
+                                 << " boundary points";
+    if (skipped_roads > 0)
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << skipped_roads << " roads between shards end outside of the overlap, the routes "
+            << "along them aren't found across shards. Use a larger --overlap.";
+    }
+    return shard_map;
+}
+
+std::string makeTablePath(const ShardConfig &config,
+                          const util::ShardMap &shard_map,
+                          const std::vector<std::uint32_t> &sources,
+                          const std::vector<std::uint32_t> &destinations)
+{
+    std::string path = "/table/v1/" + config.profile + "/";
+    for (const auto index : util::irange<std::size_t>(0, sources.size() + destinations.size()))
+    {
+        const auto point = index < sources.size() ? sources[index]
+                                                  : destinations[index - sources.size()];
+        const auto coordinate = shard_map.GetBoundaryPoints()[point].coordinate;
+        path += (index == 0 ? "" : ";") +
+                std::to_string(static_cast<double>(util::toFloating(coordinate.lon))) + "," +
+                std::to_string(static_cast<double>(util::toFloating(coordinate.lat)));
+    }
+    path += "?sources=";
+    for (const auto index : util::irange<std::size_t>(0, sources.size()))
+    {
+        path += (index == 0 ? "" : ";") + std::to_string(index);
+    }
+    path += "&destinations=";
+    for (const auto index : util::irange<std::size_t>(0, destinations.size()))
+    {
+        path += (index == 0 ? "" : ";") + std::to_string(sources.size() + index);
+    }
+    return path;
+}
+
+// Asks the osrm-routed of every shard for the durations between all of its boundary points, in
+// tables of at most table_size coordinates.
+void computeOverlay(const ShardConfig &config, util::ShardMap &shard_map)
+{
+    std::vector<util::ShardMap::OverlayEdge> overlay_edges;
+    const auto block_size = std::max(1u, config.table_size / 2);
+    for (const auto shard : util::irange<std::uint32_t>(0, shard_map.GetShards().size()))
+    {
+        const auto &backend = shard_map.GetShards()[shard];
+        if (backend.host.empty())
+        {
+            throw util::exception("Shard " + std::to_string(shard) + " has no backend");
+        }
+        const auto points = shard_map.GetBoundaryPoints(shard);
+        for (std::size_t source_block = 0; source_block < points.size(); source_block += block_size)
+        {
+            for (std::size_t target_block = 0; target_block < points.size();
+                 target_block += block_size)
+            {
+                const std::vector<std::uint32_t> sources(
+                    points.begin() + source_block,
+                    points.begin() + std::min(points.size(), source_block + block_size));
+                const std::vector<std::uint32_t> destinations(
+                    points.begin() + target_block,
+                    points.begin() + std::min(points.size(), target_block + block_size));
+
+                const auto response =
+                    util::httpGet(backend.host,
+                                  backend.port,
+                                  makeTablePath(config, shard_map, sources, destinations),
+                                  config.timeout);
+                util::json::Value table;
+                if (response.status != 200 || !util::json::parse(response.body, table))
+                {
+                    throw util::exception("Table query of shard " + std::to_string(shard) +
+                                          " failed with status " +
+                                          std::to_string(response.status));
+                }
+
+                const auto &rows = table.get<util::json::Object>()
+                                       .values.at("durations")
+                                       .get<util::json::Array>();
+                for (const auto row : util::irange<std::size_t>(0, sources.size()))
+                {
+                    const auto &durations = rows.values.at(row).get<util::json::Array>();
+                    for (const auto column : util::irange<std::size_t>(0, destinations.size()))
+                    {
+                        const auto &duration = durations.values.at(column);
+                        if (sources[row] != destinations[column] &&
+                            duration.is<util::json::Number>())
+                        {
+                            overlay_edges.push_back({shard,
+                                                     sources[row],
+                                                     destinations[column],
+                                                     duration.get<util::json::Number>().value});
+                        }
+                    }
+                }
+            }
+        }
+        util::SimpleLogger().Write() << "Shard " << shard << ": " << points.size()
+                                     << " boundary points";
+    }
+
+    util::SimpleLogger().Write() << "Overlay with " << overlay_edges.size() << " edges";
+    shard_map.SetOverlay(std::move(overlay_edges));
+}
+
+bool parseArguments(const int argc, const char *argv[], ShardConfig &config)
+{
+    using boost::program_options::value;
+
+    boost::program_options::options_description generic_options("Options");
+    generic_options.add_options()("version,v", "Show version")("help,h", "Show this help message");
+
+    boost::program_options::options_description config_options("Configuration");
+    config_options.add_options() //
+        ("output,o",
+         value<boost::filesystem::path>(&config.shard_map_path),
+         "Shard map that is written, defaults to <input>.shards") //
+        ("overlay",
+         value<bool>(&config.overlay)->implicit_value(true)->default_value(false),
+         "Compute the overlay of the shard map <input> with the osrm-routed of its shards") //
+        ("shards,n",
+         value<unsigned>(&config.number_of_shards)->default_value(4),
+         "Number of shards") //
+        ("overlap",
+         value<double>(&config.overlap)->default_value(50000),
+         "Meters by which the region of a shard reaches into its neighbours") //
+        ("boundary-spacing",
+         value<double>(&config.boundary_spacing)->default_value(2000),
+         "Meters between the boundary points of two shards") //
+        ("backend,b",
+         value<std::vector<std::string>>(&config.backends)->composing(),
+         "osrm-routed of a shard as <shard>=<host>:<port>, can be given multiple times") //
+        ("profile",
+         value<std::string>(&config.profile)->default_value("driving"),
+         "Profile in the URLs of the table queries") //
+        ("table-size",
+         value<unsigned>(&config.table_size)->default_value(100),
+         "Coordinates per table query, at most the --max-table-size of the shards") //
+        ("timeout",
+         value<double>(&config.timeout)->default_value(600),
+         "Seconds to wait for a table query, 0 to wait forever");
+
+    boost::program_options::options_description hidden_options("Hidden options");
+    hidden_options.add_options()("input",
+                                 value<boost::filesystem::path>(&config.input_path),
+                                 "The .osrm file, or the shard map with --overlay");
+
+    boost::program_options::positional_options_description positional_options;
+    positional_options.add("input", 1);
+
+    boost::program_options::options_description cmdline_options;
+    cmdline_options.add(generic_options).add(config_options).add(hidden_options);
+
+    boost::program_options::options_description visible_options(
+        boost::filesystem::path(argv[0]).filename().string() +
+        " <input.osrm> [<options>] | <input.shards> --overlay [<options>]");
+    visible_options.add(generic_options).add(config_options);
+
+    boost::program_options::variables_map option_variables;
+    boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                      .options(cmdline_options)
+                                      .positional(positional_options)
+                                      .run(),
+                                  option_variables);
+
+    if (option_variables.count("version"))
+    {
+        util::SimpleLogger().Write() << OSRM_VERSION;
+        return false;
+    }
+    if (option_variables.count("help") || !option_variables.count("input"))
+    {
+        util::SimpleLogger().Write() << visible_options;
+        return false;
+    }
+    boost::program_options::notify(option_variables);
+
+    if (config.shard_map_path.empty())
+    {
+        config.shard_map_path = config.overlay ? config.input_path
+                                               : boost::filesystem::path(
+                                                     config.input_path.string() + ".shards");
+    }
+    config.number_of_shards = std::max(1u, config.number_of_shards);
+    return true;
+}
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    using namespace osrm;
+
+    util::LogPolicy::GetInstance().Unmute();
+    tools::ShardConfig config;
+    if (!tools::parseArguments(argc, argv, config))
+    {
+        return EXIT_SUCCESS;
+    }
+
+    auto shard_map = config.overlay ? util::ShardMap(config.input_path.string())
+                                    : tools::buildShardMap(config);
+    for (const auto &backend : config.backends)
+    {
+        const auto equals = backend.find('=');
+        const auto colon = backend.rfind(':');
+        if (equals == std::string::npos || colon == std::string::npos || colon < equals)
+        {
+            throw util::exception("Invalid backend " + backend +
+                                  ", expected <shard>=<host>:<port>");
+        }
+        const auto shard = std::stoul(backend.substr(0, equals));
+        if (shard >= shard_map.GetShards().size())
+        {
+            throw util::exception("Invalid shard in backend " + backend);
+        }
+        shard_map.SetBackend(
+            shard, backend.substr(equals + 1, colon - equals - 1), backend.substr(colon + 1));
+    }
+
+    if (config.overlay)
+    {
+        tools::computeOverlay(config, shard_map);
+    }
+    shard_map.Write(config.shard_map_path.string());
+    util::SimpleLogger().Write() << "Wrote " << config.shard_map_path.string();
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    osrm::util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    return EXIT_FAILURE;
+}
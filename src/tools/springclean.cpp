@@ -29,8 +29,18 @@ void deleteRegion(const SharedDataType region)
                 return "LAYOUT_2";
             case DATA_2:
                 return "DATA_2";
+            case LAYOUT_3:
+                return "LAYOUT_3";
+            case DATA_3:
+                return "DATA_3";
+            case LAYOUT_4:
+                return "LAYOUT_4";
+            case DATA_4:
+                return "DATA_4";
             case LAYOUT_NONE:
                 return "LAYOUT_NONE";
+            case TRAFFIC_OVERLAY:
+                return "TRAFFIC_OVERLAY";
             default: // DATA_NONE:
                 return "DATA_NONE";
             }
@@ -44,11 +54,13 @@ void deleteRegion(const SharedDataType region)
 void springclean()
 {
     util::SimpleLogger().Write() << "spring-cleaning all shared memory regions";
-    deleteRegion(DATA_1);
-    deleteRegion(LAYOUT_1);
-    deleteRegion(DATA_2);
-    deleteRegion(LAYOUT_2);
+    for (unsigned slot = 0; slot < NUM_DATASET_SLOTS; ++slot)
+    {
+        deleteRegion(getDataRegion(slot));
+        deleteRegion(getLayoutRegion(slot));
+    }
     deleteRegion(CURRENT_REGIONS);
+    deleteRegion(TRAFFIC_OVERLAY);
 }
 }
 }
@@ -1,3 +1,5 @@
+#include "storage/compressed_file.hpp"
+#include "storage/container_file.hpp"
 #include "storage/storage.hpp"
 #include "util/exception.hpp"
 #include "util/simple_logger.hpp"
@@ -7,12 +9,20 @@
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 
+#include <cstddef>
+#include <string>
+
 using namespace osrm;
 
 // generate boost::program_options object for the routing part
 bool generateDataStoreOptions(const int argc,
                               const char *argv[],
-                              boost::filesystem::path &base_path)
+                              boost::filesystem::path &base_path,
+                              bool &write_container,
+                              bool &compress,
+                              std::string &huge_pages,
+                              bool &weights_only,
+                              bool &stats)
 {
     // declare a group of options that will be allowed only on command line
     boost::program_options::options_description generic_options("Options");
@@ -21,6 +31,35 @@ bool generateDataStoreOptions(const int argc,
     // declare a group of options that will be allowed both on command line
     // as well as in a config file
     boost::program_options::options_description config_options("Configuration");
+    config_options.add_options()(
+        "write-container",
+        boost::program_options::value<bool>(&write_container)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Pack the files of the dataset besides the r-tree into <base>.container for osrm-routed "
+        "instead of loading them into shared memory")(
+        "compress",
+        boost::program_options::value<bool>(&compress)->implicit_value(true)->default_value(false),
+        "Write compressed copies <file>.zb of the .hsgr, .geometry, .fileIndex, .edges and .nodes "
+        "to copy to other hosts. osrm-datastore and osrm-routed decompress the copies that are "
+        "newer than their files with all threads")(
+        "huge-pages",
+        boost::program_options::value<std::string>(&huge_pages)
+            ->implicit_value("2M")
+            ->default_value("none"),
+        "Allocate the data in shared memory on huge pages of the given size: none, 2M or 1G. "
+        "Falls back to the default pages if the system has not reserved enough of them")(
+        "weights-only",
+        boost::program_options::value<bool>(&weights_only)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Only the weights changed since the dataset in shared memory was loaded, e.g. by "
+        "osrm-contract --segment-speed-file. Copies the other blocks from it instead of "
+        "reading their files")(
+        "stats",
+        boost::program_options::value<bool>(&stats)->implicit_value(true)->default_value(false),
+        "Log the size of every block of the dataset in shared memory, after loading the dataset "
+        "if one is given");
 
     // hidden options, will be allowed on command line but will not be shown to the user
     boost::program_options::options_description hidden_options("Hidden options");
@@ -79,6 +118,12 @@ bool generateDataStoreOptions(const int argc,
 
     boost::program_options::notify(option_variables);
 
+    if (huge_pages != "none" && huge_pages != "2M" && huge_pages != "1G")
+    {
+        util::SimpleLogger().Write(logWARNING) << "[error] unknown huge page size " << huge_pages;
+        return false;
+    }
+
     return true;
 }
 
@@ -87,18 +132,60 @@ int main(const int argc, const char *argv[]) try
     util::LogPolicy::GetInstance().Unmute();
 
     boost::filesystem::path base_path;
-    if (!generateDataStoreOptions(argc, argv, base_path))
+    bool write_container = false;
+    bool compress = false;
+    std::string huge_pages;
+    bool weights_only = false;
+    bool stats = false;
+    if (!generateDataStoreOptions(
+            argc, argv, base_path, write_container, compress, huge_pages, weights_only, stats))
     {
         return EXIT_SUCCESS;
     }
+    if (stats && base_path.empty())
+    {
+        if (!storage::logCurrentLayout())
+        {
+            util::SimpleLogger().Write(logWARNING) << "No dataset in shared memory";
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
     storage::StorageConfig config(base_path);
+    if (!compress)
+    {
+        storage::compressed_file::decompressUpdated(config.GetCompressibleFiles());
+    }
     if (!config.IsValid())
     {
         util::SimpleLogger().Write(logWARNING) << "Config contains invalid file paths. Exiting!";
         return EXIT_FAILURE;
     }
-    storage::Storage storage(std::move(config));
-    return storage.Run();
+    if (compress)
+    {
+        for (const auto &path : config.GetCompressibleFiles())
+        {
+            const auto compressed_path = storage::compressed_file::getCompressedPath(path);
+            util::SimpleLogger().Write() << "writing " << compressed_path.string();
+            storage::compressed_file::compress(path, compressed_path);
+        }
+        return EXIT_SUCCESS;
+    }
+    if (write_container)
+    {
+        util::SimpleLogger().Write() << "writing " << config.container_path.string();
+        storage::ContainerFile::Write(config.container_path, config.GetContainerFiles());
+        return EXIT_SUCCESS;
+    }
+    const std::size_t huge_page_size =
+        huge_pages == "2M" ? std::size_t{1} << 21 : huge_pages == "1G" ? std::size_t{1} << 30 : 0;
+    storage::Storage storage(std::move(config), huge_page_size, weights_only);
+    const auto result = storage.Run();
+    if (result == EXIT_SUCCESS && stats)
+    {
+        storage::logCurrentLayout();
+    }
+    return result;
 }
 catch (const std::bad_alloc &e)
 {
@@ -0,0 +1,33 @@
+#include "storage/traffic_overlay.hpp"
+#include "util/simple_logger.hpp"
+
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <vector>
+
+// Replaces the traffic overlay in shared memory by the penalties of a CSV file, or clears it.
+// The engines with a traffic overlay pick it up within a second, no osrm-datastore needed.
+int main(int argc, char *argv[]) try
+{
+    using namespace osrm;
+
+    util::LogPolicy::GetInstance().Unmute();
+    if (argc != 2)
+    {
+        util::SimpleLogger().Write(logWARNING) << "usage: " << argv[0]
+                                               << " penalties.csv|--clear";
+        return EXIT_FAILURE;
+    }
+
+    const std::string argument = argv[1];
+    const auto penalties = argument == "--clear" ? std::vector<storage::TrafficPenalty>()
+                                                 : storage::readTrafficPenaltyFile(argument);
+    storage::writeSharedTrafficOverlay(penalties);
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    osrm::util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    return EXIT_FAILURE;
+}
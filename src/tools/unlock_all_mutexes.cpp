@@ -10,5 +10,6 @@ int main()
     osrm::storage::SharedBarriers barrier;
     barrier.pending_update_mutex.unlock();
     barrier.query_mutex.unlock();
+    barrier.traffic_mutex.unlock();
     return 0;
 }
@@ -0,0 +1,576 @@
+#include "util/async_io.hpp"
+#include "util/exception.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef OSRM_ENABLE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace osrm
+{
+namespace util
+{
+
+namespace
+{
+// the thread pool doesn't start more threads than that, however deep the queue is
+const constexpr unsigned MAX_THREADS = 32;
+
+// A block of a read or write
+struct Request
+{
+    int fd;
+    // the file of fd for the errors
+    const std::string *path;
+    std::uint64_t offset;
+    char *data;
+    std::uint64_t size;
+    bool write;
+};
+
+std::string describeError(const Request &request, const int error)
+{
+    return std::string("Failed to ") + (request.write ? "write " : "read ") + *request.path + ": " +
+           std::strerror(error);
+}
+
+std::string describeEndOfFile(const Request &request)
+{
+    return "Unexpected end of file reading " + *request.path + " at byte " +
+           std::to_string(request.offset);
+}
+
+class Queue
+{
+  public:
+    virtual ~Queue() = default;
+    virtual void Submit(const Request &request) = 0;
+    // Waits for all requests, returns the error of the first one that failed or an empty string
+    virtual std::string Wait() = 0;
+};
+
+class ThreadPoolQueue final : public Queue
+{
+  public:
+    explicit ThreadPoolQueue(const unsigned queue_depth)
+    {
+        const auto number_of_threads = std::max(1u, std::min(queue_depth, MAX_THREADS));
+        for (unsigned thread = 0; thread < number_of_threads; ++thread)
+        {
+            threads.emplace_back([this] { Run(); });
+        }
+    }
+
+    ~ThreadPoolQueue() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        work_available.notify_all();
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    void Submit(const Request &request) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(request);
+            ++number_of_outstanding;
+        }
+        work_available.notify_one();
+    }
+
+    std::string Wait() override
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return number_of_outstanding == 0; });
+        std::string result;
+        result.swap(error);
+        return result;
+    }
+
+  private:
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            work_available.wait(lock, [this] { return stop || !pending.empty(); });
+            if (pending.empty())
+            {
+                return;
+            }
+            const auto request = pending.front();
+            pending.pop_front();
+            lock.unlock();
+            const auto request_error = Transfer(request);
+            lock.lock();
+            if (error.empty())
+            {
+                error = request_error;
+            }
+            if (--number_of_outstanding == 0)
+            {
+                done.notify_all();
+            }
+        }
+    }
+
+    static std::string Transfer(Request request)
+    {
+        while (request.size > 0)
+        {
+            const auto result =
+                request.write
+                    ? pwrite(request.fd, request.data, request.size, request.offset)
+                    : pread(request.fd, request.data, request.size, request.offset);
+            if (result < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (result < 0)
+            {
+                return describeError(request, errno);
+            }
+            if (result == 0)
+            {
+                return describeEndOfFile(request);
+            }
+            request.offset += result;
+            request.data += result;
+            request.size -= result;
+        }
+        return {};
+    }
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable done;
+    std::deque<Request> pending;
+    std::size_t number_of_outstanding = 0;
+    std::string error;
+    bool stop = false;
+};
+
+#ifdef OSRM_ENABLE_IO_URING
+// An io_uring set up with the system calls of the kernel, without liburing. Submit blocks while
+// the queue is full until requests complete.
+class IOUringQueue final : public Queue
+{
+  public:
+    explicit IOUringQueue(const unsigned queue_depth)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth, &params));
+        if (ring_fd < 0)
+        {
+            throw util::exception(std::string("Failed to set up an io_uring: ") +
+                                  std::strerror(errno));
+        }
+
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap)
+        {
+            sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        }
+        sq_ring = Map(sq_ring_size, IORING_OFF_SQ_RING);
+        cq_ring = single_mmap ? sq_ring : Map(cq_ring_size, IORING_OFF_CQ_RING);
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(Map(sqes_size, IORING_OFF_SQES));
+
+        auto *sq = static_cast<char *>(sq_ring);
+        sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        auto *cq = static_cast<char *>(cq_ring);
+        cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        // no more requests in flight than the completion queue holds
+        slots.resize(std::min(params.sq_entries, params.cq_entries));
+        for (std::size_t slot = 0; slot < slots.size(); ++slot)
+        {
+            free_slots.push_back(slot);
+        }
+    }
+
+    ~IOUringQueue() override
+    {
+        try
+        {
+            Wait();
+        }
+        catch (const util::exception &)
+        {
+            // the requests in flight still point into the rings
+            return;
+        }
+        munmap(sqes, sqes_size);
+        if (cq_ring != sq_ring)
+        {
+            munmap(cq_ring, cq_ring_size);
+        }
+        munmap(sq_ring, sq_ring_size);
+        close(ring_fd);
+    }
+
+    void Submit(const Request &request) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (free_slots.empty())
+        {
+            Reap(1);
+        }
+        const auto slot = free_slots.back();
+        free_slots.pop_back();
+        slots[slot].request = request;
+        Push(slot);
+    }
+
+    std::string Wait() override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (free_slots.size() < slots.size())
+        {
+            Reap(1);
+        }
+        std::string result;
+        result.swap(error);
+        return result;
+    }
+
+  private:
+    struct Slot
+    {
+        Request request;
+        iovec vector;
+    };
+
+    void *Map(const std::size_t size, const off_t offset)
+    {
+        void *address =
+            mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+        if (address == MAP_FAILED)
+        {
+            const auto map_error = errno;
+            close(ring_fd);
+            throw util::exception(std::string("Failed to map an io_uring: ") +
+                                  std::strerror(map_error));
+        }
+        return address;
+    }
+
+    // Submits the request of the slot, or what is left of it
+    void Push(const std::size_t slot)
+    {
+        auto &entry = slots[slot];
+        entry.vector.iov_base = entry.request.data;
+        entry.vector.iov_len = entry.request.size;
+
+        const auto tail = *sq_tail;
+        const auto index = tail & sq_mask;
+        auto &sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        // the vectored operations go back to the first kernels with io_uring
+        sqe.opcode = entry.request.write ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe.fd = entry.request.fd;
+        sqe.off = entry.request.offset;
+        sqe.addr = reinterpret_cast<std::uint64_t>(&entry.vector);
+        sqe.len = 1;
+        sqe.user_data = slot;
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        while (syscall(__NR_io_uring_enter, ring_fd, 1, 0, 0, nullptr, 0) < 0)
+        {
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                throw util::exception(std::string("Failed to submit to an io_uring: ") +
+                                      std::strerror(errno));
+            }
+        }
+    }
+
+    // Waits for at least min_complete requests and handles all completed ones
+    void Reap(const unsigned min_complete)
+    {
+        if (__atomic_load_n(cq_head, __ATOMIC_RELAXED) ==
+            __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+        {
+            while (syscall(__NR_io_uring_enter,
+                           ring_fd,
+                           0,
+                           min_complete,
+                           IORING_ENTER_GETEVENTS,
+                           nullptr,
+                           0) < 0)
+            {
+                if (errno != EINTR)
+                {
+                    throw util::exception(std::string("Failed to wait for an io_uring: ") +
+                                          std::strerror(errno));
+                }
+            }
+        }
+
+        auto head = __atomic_load_n(cq_head, __ATOMIC_RELAXED);
+        while (head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+        {
+            const auto &cqe = cqes[head & cq_mask];
+            const auto slot = static_cast<std::size_t>(cqe.user_data);
+            const auto result = cqe.res;
+            __atomic_store_n(cq_head, ++head, __ATOMIC_RELEASE);
+
+            auto &request = slots[slot].request;
+            std::string request_error;
+            if (result < 0 && (result == -EINTR || result == -EAGAIN))
+            {
+                Push(slot);
+                continue;
+            }
+            if (result < 0)
+            {
+                request_error = describeError(request, -result);
+            }
+            else if (result == 0)
+            {
+                request_error = describeEndOfFile(request);
+            }
+            else if (static_cast<std::uint64_t>(result) < request.size)
+            {
+                // short reads and writes continue where they stopped
+                request.offset += result;
+                request.data += result;
+                request.size -= result;
+                Push(slot);
+                continue;
+            }
+            if (error.empty())
+            {
+                error = request_error;
+            }
+            free_slots.push_back(slot);
+        }
+    }
+
+    int ring_fd;
+    void *sq_ring;
+    void *cq_ring;
+    io_uring_sqe *sqes;
+    std::size_t sq_ring_size;
+    std::size_t cq_ring_size;
+    std::size_t sqes_size;
+    unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    io_uring_cqe *cqes;
+
+    std::mutex mutex;
+    std::vector<Slot> slots;
+    std::vector<std::size_t> free_slots;
+    std::string error;
+};
+#endif
+
+std::unique_ptr<Queue> makeQueue(const AsyncIO::Backend backend, const unsigned queue_depth)
+{
+    if (backend == AsyncIO::Backend::ThreadPool)
+    {
+        return std::unique_ptr<Queue>(new ThreadPoolQueue(queue_depth));
+    }
+#ifdef OSRM_ENABLE_IO_URING
+    return std::unique_ptr<Queue>(new IOUringQueue(queue_depth));
+#else
+    throw util::exception("osrm was built without io_uring, see ENABLE_IO_URING");
+#endif
+}
+}
+
+struct AsyncIO::Impl
+{
+    Impl(const Backend backend, const unsigned queue_depth)
+        : backend(backend), queue(makeQueue(backend, std::max(1u, queue_depth)))
+    {
+    }
+
+    ~Impl()
+    {
+        queue.reset();
+        CloseFiles();
+    }
+
+    // the file descriptor of the path, opened for reading or writing on first use
+    std::pair<int, const std::string *> Open(const boost::filesystem::path &path,
+                                             const bool write,
+                                             const bool truncate)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &files = write ? write_files : read_files;
+        auto file = files.find(path.string());
+        if (file != files.end() && !truncate)
+        {
+            return {file->second, &file->first};
+        }
+        const int flags = write ? (O_WRONLY | O_CREAT | (truncate ? O_TRUNC : 0)) : O_RDONLY;
+        const int fd = open(path.string().c_str(), flags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (fd < 0)
+        {
+            throw util::exception("Failed to open " + path.string() + ": " +
+                                  std::strerror(errno));
+        }
+        if (file != files.end())
+        {
+            close(file->second);
+            file->second = fd;
+            return {fd, &file->first};
+        }
+        file = files.emplace(path.string(), fd).first;
+        return {fd, &file->first};
+    }
+
+    void Add(const boost::filesystem::path &path,
+             std::uint64_t offset,
+             char *data,
+             std::uint64_t size,
+             const bool write)
+    {
+        const auto file = Open(path, write, false);
+        while (size > 0)
+        {
+            const auto block_size = std::min<std::uint64_t>(size, BLOCK_SIZE);
+            queue->Submit(Request{file.first, file.second, offset, data, block_size, write});
+            offset += block_size;
+            data += block_size;
+            size -= block_size;
+        }
+    }
+
+    void CloseFiles()
+    {
+        for (auto *files : {&read_files, &write_files})
+        {
+            for (const auto &file : *files)
+            {
+                close(file.second);
+            }
+            files->clear();
+        }
+    }
+
+    const Backend backend;
+    std::unique_ptr<Queue> queue;
+    std::mutex mutex;
+    std::unordered_map<std::string, int> read_files;
+    std::unordered_map<std::string, int> write_files;
+};
+
+AsyncIO::AsyncIO(const unsigned queue_depth)
+{
+    impl.reset(new Impl(IsAvailable(Backend::IOUring) ? Backend::IOUring : Backend::ThreadPool,
+                        queue_depth));
+}
+
+AsyncIO::AsyncIO(const Backend backend, const unsigned queue_depth)
+    : impl(new Impl(backend, queue_depth))
+{
+}
+
+AsyncIO::~AsyncIO() {}
+
+AsyncIO::Backend AsyncIO::GetBackend() const { return impl->backend; }
+
+const char *AsyncIO::GetBackendName(const Backend backend)
+{
+    return backend == Backend::IOUring ? "io_uring" : "thread pool";
+}
+
+bool AsyncIO::IsAvailable(const Backend backend)
+{
+    if (backend == Backend::ThreadPool)
+    {
+        return true;
+    }
+#ifdef OSRM_ENABLE_IO_URING
+    // the kernel may not have io_uring or not allow it
+    static const bool has_io_uring = [] {
+        try
+        {
+            IOUringQueue queue(1);
+            return true;
+        }
+        catch (const util::exception &)
+        {
+            return false;
+        }
+    }();
+    return has_io_uring;
+#else
+    return false;
+#endif
+}
+
+void AsyncIO::Read(const boost::filesystem::path &path,
+                   const std::uint64_t offset,
+                   void *buffer,
+                   const std::uint64_t size)
+{
+    impl->Add(path, offset, static_cast<char *>(buffer), size, false);
+}
+
+void AsyncIO::Create(const boost::filesystem::path &path) { impl->Open(path, true, true); }
+
+void AsyncIO::Write(const boost::filesystem::path &path,
+                    const std::uint64_t offset,
+                    const void *buffer,
+                    const std::uint64_t size)
+{
+    // the queue only reads from the buffer of a write
+    impl->Add(path, offset, const_cast<char *>(static_cast<const char *>(buffer)), size, true);
+}
+
+void AsyncIO::Wait()
+{
+    const auto error = impl->queue->Wait();
+    {
+        std::lock_guard<std::mutex> lock(impl->mutex);
+        impl->CloseFiles();
+    }
+    if (!error.empty())
+    {
+        throw util::exception(error);
+    }
+}
+}
+}
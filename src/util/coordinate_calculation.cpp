@@ -7,8 +7,10 @@
 
 #include <cmath>
 
+#include <cstddef>
 #include <limits>
 #include <utility>
+#include <vector>
 
 namespace osrm
 {
@@ -77,6 +79,135 @@ double greatCircleDistance(const Coordinate coordinate_1, const Coordinate coord
     return std::hypot(x_value, y_value) * detail::EARTH_RADIUS;
 }
 
+namespace
+{
+// in radians, converted like haversineDistance and greatCircleDistance do
+inline double toRadians(const FixedLatitude lat)
+{
+    return (static_cast<int>(lat) / COORDINATE_PRECISION) * detail::DEGREE_TO_RAD;
+}
+
+inline double toRadians(const FixedLongitude lon)
+{
+    return (static_cast<int>(lon) / COORDINATE_PRECISION) * detail::DEGREE_TO_RAD;
+}
+
+// The angles of the coordinates and the cosines of their latitudes, for the distances of many
+// pairs. Reused by the batch functions a thread calls.
+struct RadianCoordinates
+{
+    void Assign(const std::vector<Coordinate> &coordinates)
+    {
+        lons.resize(coordinates.size());
+        lats.resize(coordinates.size());
+        cos_lats.resize(coordinates.size());
+        for (std::size_t index = 0; index < coordinates.size(); ++index)
+        {
+            lons[index] = toRadians(coordinates[index].lon);
+            lats[index] = toRadians(coordinates[index].lat);
+        }
+        for (std::size_t index = 0; index < coordinates.size(); ++index)
+        {
+            cos_lats[index] = std::cos(lats[index]);
+        }
+    }
+
+    std::vector<double> lons;
+    std::vector<double> lats;
+    std::vector<double> cos_lats;
+};
+
+// the central angle of the haversine formula, from the haversine of the angle
+inline double haversineAngle(const double aharv)
+{
+    return 2. * std::atan2(std::sqrt(aharv), std::sqrt(1.0 - aharv));
+}
+}
+
+void haversineDistances(const std::vector<Coordinate> &coordinates, std::vector<double> &distances)
+{
+    distances.resize(coordinates.size() < 2 ? 0 : coordinates.size() - 1);
+    if (distances.empty())
+    {
+        return;
+    }
+
+    thread_local RadianCoordinates radians;
+    radians.Assign(coordinates);
+    const double *const lons = radians.lons.data();
+    const double *const lats = radians.lats.data();
+    const double *const cos_lats = radians.cos_lats.data();
+    double *const values = distances.data();
+
+    for (std::size_t index = 0; index < distances.size(); ++index)
+    {
+        const double sin_dlat = std::sin((lats[index] - lats[index + 1]) / 2.0);
+        const double sin_dlong = std::sin((lons[index] - lons[index + 1]) / 2.);
+        values[index] = sin_dlat * sin_dlat +
+                        cos_lats[index] * cos_lats[index + 1] * (sin_dlong * sin_dlong);
+    }
+    for (std::size_t index = 0; index < distances.size(); ++index)
+    {
+        values[index] = detail::EARTH_RADIUS * haversineAngle(values[index]);
+    }
+}
+
+void haversineDistances(const Coordinate source,
+                        const std::vector<Coordinate> &targets,
+                        std::vector<double> &distances)
+{
+    distances.resize(targets.size());
+
+    thread_local RadianCoordinates radians;
+    radians.Assign(targets);
+    const double source_lon = toRadians(source.lon);
+    const double source_lat = toRadians(source.lat);
+    const double source_cos_lat = std::cos(source_lat);
+    const double *const lons = radians.lons.data();
+    const double *const lats = radians.lats.data();
+    const double *const cos_lats = radians.cos_lats.data();
+    double *const values = distances.data();
+
+    for (std::size_t index = 0; index < targets.size(); ++index)
+    {
+        const double sin_dlat = std::sin((source_lat - lats[index]) / 2.0);
+        const double sin_dlong = std::sin((source_lon - lons[index]) / 2.);
+        values[index] =
+            sin_dlat * sin_dlat + source_cos_lat * cos_lats[index] * (sin_dlong * sin_dlong);
+    }
+    for (std::size_t index = 0; index < targets.size(); ++index)
+    {
+        values[index] = detail::EARTH_RADIUS * haversineAngle(values[index]);
+    }
+}
+
+void greatCircleDistances(const Coordinate source,
+                          const std::vector<Coordinate> &targets,
+                          std::vector<double> &distances)
+{
+    distances.resize(targets.size());
+
+    thread_local std::vector<double> x_values;
+    thread_local std::vector<double> y_values;
+    x_values.resize(targets.size());
+    y_values.resize(targets.size());
+    const double source_lon = toRadians(source.lon);
+    const double source_lat = toRadians(source.lat);
+
+    // the equirectangular projection at the mean latitude of each pair
+    for (std::size_t index = 0; index < targets.size(); ++index)
+    {
+        const double target_lat = toRadians(targets[index].lat);
+        x_values[index] = toRadians(targets[index].lon) - source_lon;
+        y_values[index] = target_lat - source_lat;
+        x_values[index] *= std::cos((source_lat + target_lat) / 2.0);
+    }
+    for (std::size_t index = 0; index < targets.size(); ++index)
+    {
+        distances[index] = std::hypot(x_values[index], y_values[index]) * detail::EARTH_RADIUS;
+    }
+}
+
 double perpendicularDistance(const Coordinate segment_source,
                              const Coordinate segment_target,
                              const Coordinate query_location,
@@ -155,6 +286,44 @@ double bearing(const Coordinate first_coordinate, const Coordinate second_coordi
     return result;
 }
 
+void bearings(const std::vector<Coordinate> &coordinates, std::vector<double> &bearings)
+{
+    bearings.resize(coordinates.size() < 2 ? 0 : coordinates.size() - 1);
+    if (bearings.empty())
+    {
+        return;
+    }
+
+    // the sine and cosine of every latitude, for both segments the coordinate is on
+    thread_local std::vector<double> sin_lats;
+    thread_local std::vector<double> cos_lats;
+    sin_lats.resize(coordinates.size());
+    cos_lats.resize(coordinates.size());
+    for (std::size_t index = 0; index < coordinates.size(); ++index)
+    {
+        const double lat = degToRad(static_cast<double>(toFloating(coordinates[index].lat)));
+        sin_lats[index] = std::sin(lat);
+        cos_lats[index] = std::cos(lat);
+    }
+
+    double *const values = bearings.data();
+    for (std::size_t index = 0; index < bearings.size(); ++index)
+    {
+        const double lon_delta = degToRad(static_cast<double>(
+            toFloating(coordinates[index + 1].lon - coordinates[index].lon)));
+        const double y = std::sin(lon_delta) * cos_lats[index + 1];
+        const double x = cos_lats[index] * sin_lats[index + 1] -
+                         sin_lats[index] * cos_lats[index + 1] * std::cos(lon_delta);
+        values[index] = radToDeg(std::atan2(y, x));
+    }
+    // atan2 is in [-pi, pi], the same as the loops of bearing
+    for (std::size_t index = 0; index < bearings.size(); ++index)
+    {
+        values[index] += values[index] < 0.0 ? 360.0 : 0.0;
+        values[index] -= values[index] >= 360.0 ? 360.0 : 0.0;
+    }
+}
+
 double computeAngle(const Coordinate first, const Coordinate second, const Coordinate third)
 {
     using namespace boost::math::constants;
@@ -0,0 +1,320 @@
+#include "util/crc32c.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__MINGW64__)
+#define OSRM_CRC32C_X86
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define OSRM_CRC32C_ARM
+#include <arm_acle.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+namespace
+{
+// reflected 0x1EDC6F41
+const constexpr std::uint32_t POLYNOMIAL = 0x82F63B78;
+
+// The three streams of the instructions are LANE_SIZE bytes long, their CRCs are shifted over the
+// lanes that follow them with tables and combined. Short lanes are used for the rest of the data.
+const constexpr std::size_t LONG_LANE_SIZE = 8192;
+const constexpr std::size_t SHORT_LANE_SIZE = 256;
+
+// parts of parallelCRC32C
+const constexpr std::size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+// The product of two polynomials modulo the CRC polynomial, in the reflected representation of
+// the CRC where x^0 is the highest bit
+std::uint32_t multiply(std::uint32_t a, std::uint32_t b)
+{
+    std::uint32_t product = 0;
+    for (std::uint32_t bit = std::uint32_t{1} << 31; bit != 0; bit >>= 1)
+    {
+        if (a & bit)
+        {
+            product ^= b;
+        }
+        b = (b & 1) ? (b >> 1) ^ POLYNOMIAL : b >> 1;
+    }
+    return product;
+}
+
+// A CRC shifted over a fixed number of zero bytes with four table lookups, since the shift is
+// linear in the bits of the CRC
+struct ShiftTable
+{
+    explicit ShiftTable(const std::uint32_t power)
+    {
+        for (const auto byte : {0, 1, 2, 3})
+        {
+            for (std::uint32_t value = 0; value < 256; ++value)
+            {
+                entries[byte][value] = multiply(power, value << (8 * byte));
+            }
+        }
+    }
+
+    std::uint32_t operator()(const std::uint32_t crc) const
+    {
+        return entries[0][crc & 0xff] ^ entries[1][(crc >> 8) & 0xff] ^
+               entries[2][(crc >> 16) & 0xff] ^ entries[3][crc >> 24];
+    }
+
+    std::uint32_t entries[4][256];
+};
+
+struct Tables
+{
+    Tables()
+    {
+        for (std::uint32_t value = 0; value < 256; ++value)
+        {
+            auto crc = value;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc & 1) ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+            }
+            bytes[0][value] = crc;
+        }
+        for (std::uint32_t value = 0; value < 256; ++value)
+        {
+            for (int slice = 1; slice < 8; ++slice)
+            {
+                const auto previous = bytes[slice - 1][value];
+                bytes[slice][value] = (previous >> 8) ^ bytes[0][previous & 0xff];
+            }
+        }
+
+        // x^1
+        powers[0] = std::uint32_t{1} << 30;
+        for (std::size_t index = 1; index < sizeof(powers) / sizeof(powers[0]); ++index)
+        {
+            powers[index] = multiply(powers[index - 1], powers[index - 1]);
+        }
+    }
+
+    // x^(8 * size) appends size zero bytes to a CRC
+    std::uint32_t GetBytePower(std::uint64_t size) const
+    {
+        // x^0
+        std::uint32_t power = std::uint32_t{1} << 31;
+        // 2^3 bits per byte
+        for (std::size_t index = 3; size != 0; size >>= 1, ++index)
+        {
+            if (size & 1)
+            {
+                power = multiply(powers[index], power);
+            }
+        }
+        return power;
+    }
+
+    // the CRCs of a byte followed by 0 to 7 zero bytes, for slicing by 8 bytes
+    std::uint32_t bytes[8][256];
+    // x^(2^index), enough for the bits of 64 bit sizes
+    std::uint32_t powers[67];
+};
+
+const Tables &getTables()
+{
+    static const Tables tables;
+    return tables;
+}
+
+const ShiftTable &getLongLaneShift()
+{
+    static const ShiftTable shift(getTables().GetBytePower(LONG_LANE_SIZE));
+    return shift;
+}
+
+const ShiftTable &getShortLaneShift()
+{
+    static const ShiftTable shift(getTables().GetBytePower(SHORT_LANE_SIZE));
+    return shift;
+}
+
+std::uint64_t load64(const unsigned char *data)
+{
+    std::uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+std::uint32_t crc32cInSoftware(std::uint32_t crc, const unsigned char *data, std::size_t size)
+{
+    const auto &bytes = getTables().bytes;
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        const auto word = load64(data) ^ crc;
+        crc = bytes[7][word & 0xff] ^ bytes[6][(word >> 8) & 0xff] ^
+              bytes[5][(word >> 16) & 0xff] ^ bytes[4][(word >> 24) & 0xff] ^
+              bytes[3][(word >> 32) & 0xff] ^ bytes[2][(word >> 40) & 0xff] ^
+              bytes[1][(word >> 48) & 0xff] ^ bytes[0][word >> 56];
+    }
+#endif
+    for (; size > 0; ++data, --size)
+    {
+        crc = bytes[0][(crc ^ *data) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(OSRM_CRC32C_X86)
+// Consumes the blocks of three lanes at the start of the data
+__attribute__((target("sse4.2"))) std::uint32_t crc32cLanesInHardware(std::uint32_t crc,
+                                                                      const unsigned char *&data,
+                                                                      std::size_t &size,
+                                                                      const std::size_t lane_size,
+                                                                      const ShiftTable &shift)
+{
+    for (; size >= 3 * lane_size; data += 3 * lane_size, size -= 3 * lane_size)
+    {
+        std::uint64_t crc0 = crc, crc1 = 0, crc2 = 0;
+        for (std::size_t offset = 0; offset < lane_size; offset += 8)
+        {
+            crc0 = _mm_crc32_u64(crc0, load64(data + offset));
+            crc1 = _mm_crc32_u64(crc1, load64(data + lane_size + offset));
+            crc2 = _mm_crc32_u64(crc2, load64(data + 2 * lane_size + offset));
+        }
+        crc = shift(shift(static_cast<std::uint32_t>(crc0)) ^ static_cast<std::uint32_t>(crc1)) ^
+              static_cast<std::uint32_t>(crc2);
+    }
+    return crc;
+}
+
+__attribute__((target("sse4.2"))) std::uint32_t
+crc32cInHardware(std::uint32_t crc, const unsigned char *data, std::size_t size)
+{
+    crc = crc32cLanesInHardware(crc, data, size, LONG_LANE_SIZE, getLongLaneShift());
+    crc = crc32cLanesInHardware(crc, data, size, SHORT_LANE_SIZE, getShortLaneShift());
+
+    std::uint64_t crc64 = crc;
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        crc64 = _mm_crc32_u64(crc64, load64(data));
+    }
+    crc = static_cast<std::uint32_t>(crc64);
+    for (; size > 0; ++data, --size)
+    {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+    return crc;
+}
+#elif defined(OSRM_CRC32C_ARM)
+// Consumes the blocks of three lanes at the start of the data
+std::uint32_t crc32cLanesInHardware(std::uint32_t crc,
+                                    const unsigned char *&data,
+                                    std::size_t &size,
+                                    const std::size_t lane_size,
+                                    const ShiftTable &shift)
+{
+    for (; size >= 3 * lane_size; data += 3 * lane_size, size -= 3 * lane_size)
+    {
+        std::uint32_t crc0 = crc, crc1 = 0, crc2 = 0;
+        for (std::size_t offset = 0; offset < lane_size; offset += 8)
+        {
+            crc0 = __crc32cd(crc0, load64(data + offset));
+            crc1 = __crc32cd(crc1, load64(data + lane_size + offset));
+            crc2 = __crc32cd(crc2, load64(data + 2 * lane_size + offset));
+        }
+        crc = shift(shift(crc0) ^ crc1) ^ crc2;
+    }
+    return crc;
+}
+
+std::uint32_t crc32cInHardware(std::uint32_t crc, const unsigned char *data, std::size_t size)
+{
+    crc = crc32cLanesInHardware(crc, data, size, LONG_LANE_SIZE, getLongLaneShift());
+    crc = crc32cLanesInHardware(crc, data, size, SHORT_LANE_SIZE, getShortLaneShift());
+
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        crc = __crc32cd(crc, load64(data));
+    }
+    for (; size > 0; ++data, --size)
+    {
+        crc = __crc32cb(crc, *data);
+    }
+    return crc;
+}
+#endif
+
+bool detectHardwareSupport()
+{
+#if defined(OSRM_CRC32C_X86)
+    return __builtin_cpu_supports("sse4.2");
+#elif defined(OSRM_CRC32C_ARM)
+    return true;
+#else
+    return false;
+#endif
+}
+
+using Implementation = std::uint32_t (*)(std::uint32_t, const unsigned char *, std::size_t);
+
+Implementation getImplementation()
+{
+#if defined(OSRM_CRC32C_X86) || defined(OSRM_CRC32C_ARM)
+    static const Implementation implementation =
+        detectHardwareSupport() ? crc32cInHardware : crc32cInSoftware;
+#else
+    static const Implementation implementation = crc32cInSoftware;
+#endif
+    return implementation;
+}
+}
+
+std::uint32_t crc32c(const std::uint32_t crc, const void *data, const std::size_t size)
+{
+    return getImplementation()(crc, static_cast<const unsigned char *>(data), size);
+}
+
+std::uint32_t
+crc32cCombine(const std::uint32_t crc_a, const std::uint32_t crc_b, const std::uint64_t size_b)
+{
+    return multiply(getTables().GetBytePower(size_b), crc_a) ^ crc_b;
+}
+
+std::uint32_t parallelCRC32C(const void *data, const std::size_t size)
+{
+    const auto bytes = static_cast<const unsigned char *>(data);
+    if (size <= CHUNK_SIZE)
+    {
+        return crc32c(0, bytes, size);
+    }
+
+    const auto number_of_chunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<std::uint32_t> chunk_crcs(number_of_chunks);
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_chunks, 1),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          for (auto chunk = range.begin(); chunk != range.end(); ++chunk)
+                          {
+                              const auto begin = chunk * CHUNK_SIZE;
+                              chunk_crcs[chunk] = crc32c(
+                                  0, bytes + begin, std::min(CHUNK_SIZE, size - begin));
+                          }
+                      });
+
+    const ShiftTable chunk_shift(getTables().GetBytePower(CHUNK_SIZE));
+    std::uint32_t crc = 0;
+    for (std::size_t chunk = 0; chunk + 1 < number_of_chunks; ++chunk)
+    {
+        crc = chunk_shift(crc) ^ chunk_crcs[chunk];
+    }
+    return crc32cCombine(crc, chunk_crcs.back(), size - (number_of_chunks - 1) * CHUNK_SIZE);
+}
+
+bool isCRC32CInHardware() { return getImplementation() != crc32cInSoftware; }
+}
+}
@@ -0,0 +1,126 @@
+#include "util/http_client.hpp"
+#include "util/exception.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/asio.hpp>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/time.h>
+#endif
+
+#include <istream>
+#include <stdexcept>
+
+namespace osrm
+{
+namespace util
+{
+
+namespace
+{
+// blocking asio calls have no timeouts, the socket has to time out its reads and writes
+void setTimeout(boost::asio::ip::tcp::socket &socket, const double timeout)
+{
+    if (timeout <= 0)
+    {
+        return;
+    }
+#ifdef _WIN32
+    const DWORD milliseconds = static_cast<DWORD>(timeout * 1000);
+    const auto *value = reinterpret_cast<const char *>(&milliseconds);
+    const int size = sizeof(milliseconds);
+#else
+    timeval value_struct;
+    value_struct.tv_sec = static_cast<long>(timeout);
+    value_struct.tv_usec = static_cast<long>((timeout - value_struct.tv_sec) * 1e6);
+    const auto *value = &value_struct;
+    const socklen_t size = sizeof(value_struct);
+#endif
+    setsockopt(socket.native_handle(), SOL_SOCKET, SO_RCVTIMEO, value, size);
+    setsockopt(socket.native_handle(), SOL_SOCKET, SO_SNDTIMEO, value, size);
+}
+}
+
+HTTPResponse httpGet(const std::string &host,
+                     const std::string &port,
+                     const std::string &path,
+                     const double timeout)
+{
+    try
+    {
+        boost::asio::io_service io_service;
+        boost::asio::ip::tcp::resolver resolver(io_service);
+        boost::asio::ip::tcp::socket socket(io_service);
+        boost::asio::connect(socket,
+                             resolver.resolve(boost::asio::ip::tcp::resolver::query(host, port)));
+        socket.set_option(boost::asio::ip::tcp::no_delay(true));
+        setTimeout(socket, timeout);
+
+        const std::string request =
+            "GET " + path + " HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n\r\n";
+        boost::asio::write(socket, boost::asio::buffer(request));
+
+        boost::asio::streambuf response;
+        boost::asio::read_until(socket, response, "\r\n\r\n");
+        std::istream header_stream(&response);
+        std::string line;
+        std::getline(header_stream, line);
+        if (!boost::algorithm::starts_with(line, "HTTP/1.") || line.size() < 12)
+        {
+            throw exception("Invalid status line from " + host + ":" + port);
+        }
+
+        HTTPResponse result;
+        result.status = std::stoul(line.substr(9, 3));
+        bool has_content_length = false;
+        std::size_t content_length = 0;
+        while (std::getline(header_stream, line) && line != "\r")
+        {
+            const auto colon = line.find(':');
+            if (colon != std::string::npos &&
+                boost::algorithm::iequals(line.substr(0, colon), "Content-Length"))
+            {
+                has_content_length = true;
+                content_length = std::stoul(boost::algorithm::trim_copy(line.substr(colon + 1)));
+            }
+        }
+
+        // the body may partially be in the buffer already, without a length it ends with the
+        // connection
+        boost::system::error_code error;
+        if (has_content_length)
+        {
+            if (response.size() < content_length)
+            {
+                boost::asio::read(socket,
+                                  response,
+                                  boost::asio::transfer_exactly(content_length - response.size()));
+            }
+        }
+        else
+        {
+            boost::asio::read(socket, response, boost::asio::transfer_all(), error);
+            if (error && error != boost::asio::error::eof)
+            {
+                throw boost::system::system_error(error);
+            }
+        }
+
+        const auto *body = boost::asio::buffer_cast<const char *>(response.data());
+        result.body.assign(body, has_content_length ? content_length : response.size());
+        socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+        return result;
+    }
+    catch (const boost::system::system_error &e)
+    {
+        throw exception("Request to " + host + ":" + port + " failed: " + e.what());
+    }
+    catch (const std::logic_error &)
+    {
+        throw exception("Invalid reply from " + host + ":" + port);
+    }
+}
+}
+}
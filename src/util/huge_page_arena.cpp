@@ -0,0 +1,81 @@
+#include "util/huge_page_arena.hpp"
+#include "util/exception.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace osrm
+{
+namespace util
+{
+
+namespace
+{
+const constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+std::size_t roundToHugePages(const std::size_t size)
+{
+    return (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+}
+
+void *allocateHugePageArena(const std::size_t size)
+{
+    const auto failed = [size] {
+        return util::exception("Could not allocate an arena of " + std::to_string(size) +
+                               " bytes.");
+    };
+#ifdef __linux__
+    const auto arena_size = roundToHugePages(size);
+    // the kernel only backs aligned huge pages, so the mapping is cut to an aligned range
+    const auto mapping_size = arena_size + HUGE_PAGE_SIZE;
+    void *mapping =
+        mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        throw failed();
+    }
+    const auto first = reinterpret_cast<std::uintptr_t>(mapping);
+    const auto aligned = (first + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    if (aligned > first)
+    {
+        munmap(mapping, aligned - first);
+    }
+    const auto tail = first + mapping_size - (aligned + arena_size);
+    if (tail > 0)
+    {
+        munmap(reinterpret_cast<void *>(aligned + arena_size), tail);
+    }
+
+    void *arena = reinterpret_cast<void *>(aligned);
+#ifdef MADV_HUGEPAGE
+    // only a hint, the arena uses normal pages if transparent huge pages are disabled
+    madvise(arena, arena_size, MADV_HUGEPAGE);
+#endif
+    return arena;
+#else
+    void *arena = std::calloc(1, size);
+    if (arena == nullptr)
+    {
+        throw failed();
+    }
+    return arena;
+#endif
+}
+
+void releaseHugePageArena(void *arena, const std::size_t size)
+{
+#ifdef __linux__
+    munmap(arena, roundToHugePages(size));
+#else
+    (void)size;
+    std::free(arena);
+#endif
+}
+}
+}
@@ -0,0 +1,364 @@
+#include "util/json_parser.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace osrm
+{
+namespace util
+{
+namespace json
+{
+
+namespace
+{
+// responses nest a few levels, this only guards the stack against hostile input
+const constexpr unsigned MAX_DEPTH = 64;
+
+class Parser
+{
+  public:
+    Parser(const std::string &text) : position(text.c_str()), end(text.c_str() + text.size()) {}
+
+    bool ParseDocument(Value &value)
+    {
+        if (!ParseValue(value, 0))
+        {
+            return false;
+        }
+        SkipWhitespace();
+        return position == end;
+    }
+
+  private:
+    void SkipWhitespace()
+    {
+        while (position != end &&
+               (*position == ' ' || *position == '\n' || *position == '\r' || *position == '\t'))
+        {
+            ++position;
+        }
+    }
+
+    bool Consume(const char *literal)
+    {
+        const auto length = std::strlen(literal);
+        if (static_cast<std::size_t>(end - position) < length ||
+            std::strncmp(position, literal, length) != 0)
+        {
+            return false;
+        }
+        position += length;
+        return true;
+    }
+
+    bool ParseValue(Value &value, const unsigned depth)
+    {
+        SkipWhitespace();
+        if (position == end || depth > MAX_DEPTH)
+        {
+            return false;
+        }
+        switch (*position)
+        {
+        case '{':
+        {
+            Object object;
+            if (!ParseObject(object, depth))
+            {
+                return false;
+            }
+            value = std::move(object);
+            return true;
+        }
+        case '[':
+        {
+            Array array;
+            if (!ParseArray(array, depth))
+            {
+                return false;
+            }
+            value = std::move(array);
+            return true;
+        }
+        case '"':
+        {
+            String string;
+            if (!ParseString(string.value))
+            {
+                return false;
+            }
+            value = std::move(string);
+            return true;
+        }
+        case 't':
+            value = True();
+            return Consume("true");
+        case 'f':
+            value = False();
+            return Consume("false");
+        case 'n':
+            value = Null();
+            return Consume("null");
+        default:
+            return ParseNumber(value);
+        }
+    }
+
+    bool ParseObject(Object &object, const unsigned depth)
+    {
+        ++position;
+        SkipWhitespace();
+        if (position != end && *position == '}')
+        {
+            ++position;
+            return true;
+        }
+        while (true)
+        {
+            SkipWhitespace();
+            std::string key;
+            if (position == end || *position != '"' || !ParseString(key))
+            {
+                return false;
+            }
+            SkipWhitespace();
+            if (position == end || *position != ':')
+            {
+                return false;
+            }
+            ++position;
+            if (!ParseValue(object.values[key], depth + 1))
+            {
+                return false;
+            }
+            SkipWhitespace();
+            if (position == end)
+            {
+                return false;
+            }
+            if (*position == '}')
+            {
+                ++position;
+                return true;
+            }
+            if (*position != ',')
+            {
+                return false;
+            }
+            ++position;
+        }
+    }
+
+    bool ParseArray(Array &array, const unsigned depth)
+    {
+        ++position;
+        SkipWhitespace();
+        if (position != end && *position == ']')
+        {
+            ++position;
+            return true;
+        }
+        while (true)
+        {
+            array.values.emplace_back();
+            if (!ParseValue(array.values.back(), depth + 1))
+            {
+                return false;
+            }
+            SkipWhitespace();
+            if (position == end)
+            {
+                return false;
+            }
+            if (*position == ']')
+            {
+                ++position;
+                return true;
+            }
+            if (*position != ',')
+            {
+                return false;
+            }
+            ++position;
+        }
+    }
+
+    bool ParseHex(unsigned &code_unit)
+    {
+        if (end - position < 4)
+        {
+            return false;
+        }
+        code_unit = 0;
+        for (int digit = 0; digit < 4; ++digit, ++position)
+        {
+            const char letter = *position;
+            code_unit <<= 4;
+            if (letter >= '0' && letter <= '9')
+            {
+                code_unit |= letter - '0';
+            }
+            else if (letter >= 'a' && letter <= 'f')
+            {
+                code_unit |= letter - 'a' + 10;
+            }
+            else if (letter >= 'A' && letter <= 'F')
+            {
+                code_unit |= letter - 'A' + 10;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void AppendUTF8(const unsigned code_point, std::string &output)
+    {
+        if (code_point < 0x80)
+        {
+            output.push_back(static_cast<char>(code_point));
+        }
+        else if (code_point < 0x800)
+        {
+            output.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+            output.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+        else if (code_point < 0x10000)
+        {
+            output.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+            output.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+        else
+        {
+            output.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+            output.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+    }
+
+    bool ParseString(std::string &output)
+    {
+        ++position;
+        while (position != end && *position != '"')
+        {
+            const char letter = *position++;
+            if (static_cast<unsigned char>(letter) < 0x20)
+            {
+                return false;
+            }
+            if (letter != '\\')
+            {
+                output.push_back(letter);
+                continue;
+            }
+            if (position == end)
+            {
+                return false;
+            }
+            switch (*position++)
+            {
+            case '"':
+                output.push_back('"');
+                break;
+            case '\\':
+                output.push_back('\\');
+                break;
+            case '/':
+                output.push_back('/');
+                break;
+            case 'b':
+                output.push_back('\b');
+                break;
+            case 'f':
+                output.push_back('\f');
+                break;
+            case 'n':
+                output.push_back('\n');
+                break;
+            case 'r':
+                output.push_back('\r');
+                break;
+            case 't':
+                output.push_back('\t');
+                break;
+            case 'u':
+            {
+                unsigned code_point;
+                if (!ParseHex(code_point))
+                {
+                    return false;
+                }
+                // characters outside of the basic plane come as a surrogate pair
+                if (code_point >= 0xD800 && code_point < 0xDC00)
+                {
+                    unsigned low_surrogate;
+                    if (!Consume("\\u") || !ParseHex(low_surrogate) || low_surrogate < 0xDC00 ||
+                        low_surrogate >= 0xE000)
+                    {
+                        return false;
+                    }
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low_surrogate - 0xDC00);
+                }
+                AppendUTF8(code_point, output);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        if (position == end)
+        {
+            return false;
+        }
+        ++position;
+        return true;
+    }
+
+    bool ParseNumber(Value &value)
+    {
+        // strtod accepts more than JSON does, like hex numbers and infinity
+        const char *first = position;
+        if (position != end && *position == '-')
+        {
+            ++position;
+        }
+        if (position == end || *position < '0' || *position > '9')
+        {
+            return false;
+        }
+        while (position != end && ((*position >= '0' && *position <= '9') || *position == '.' ||
+                                   *position == 'e' || *position == 'E' || *position == '+' ||
+                                   *position == '-'))
+        {
+            ++position;
+        }
+        const std::string number(first, position);
+        char *number_end;
+        const double number_value = std::strtod(number.c_str(), &number_end);
+        if (number_end != number.c_str() + number.size())
+        {
+            return false;
+        }
+        value = Number(number_value);
+        return true;
+    }
+
+    const char *position;
+    const char *const end;
+};
+}
+
+bool parse(const std::string &text, Value &value)
+{
+    Parser parser(text);
+    return parser.ParseDocument(value);
+}
+}
+}
+}
@@ -48,27 +48,21 @@ NameTable::NameTable(const std::string &filename)
                         filename);
 }
 
-std::string NameTable::GetNameForID(const unsigned name_id) const
+StringView NameTable::GetNameForID(const unsigned name_id) const
 {
     if (std::numeric_limits<unsigned>::max() == name_id)
     {
-        return "";
+        return {};
     }
-    auto range = m_name_table.GetRange(name_id);
-
-    std::string result;
-    result.reserve(range.size());
-    if (range.begin() != range.end())
+    const auto range = m_name_table.GetRange(name_id);
+    if (range.size() == 0)
     {
-        result.resize(range.back() - range.front() + 1);
-        std::copy(m_names_char_list.begin() + range.front(),
-                  m_names_char_list.begin() + range.back() + 1,
-                  result.begin());
+        return {};
     }
-    return result;
+    return StringView(&m_names_char_list[range.front()], range.size());
 }
 
-std::string NameTable::GetRefForID(const unsigned name_id) const
+StringView NameTable::GetRefForID(const unsigned name_id) const
 {
     // Way string data is stored in blocks based on `name_id` as follows:
     //
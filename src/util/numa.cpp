@@ -0,0 +1,114 @@
+#include "util/numa.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace osrm
+{
+namespace util
+{
+
+namespace
+{
+thread_local unsigned thread_numa_node = 0;
+}
+
+NUMANode parseCPUList(const std::string &cpu_list)
+{
+    NUMANode cpus;
+    std::istringstream stream(cpu_list);
+    std::string range;
+    while (std::getline(stream, range, ','))
+    {
+        const auto dash = range.find('-');
+        try
+        {
+            const unsigned first = std::stoul(range.substr(0, dash));
+            const unsigned last =
+                dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+            for (unsigned cpu = first; cpu <= last; ++cpu)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        catch (const std::logic_error &)
+        {
+            // empty lists end with a newline only
+        }
+    }
+    return cpus;
+}
+
+std::vector<NUMANode> getNUMANodes()
+{
+    std::vector<NUMANode> nodes;
+#ifdef __linux__
+    for (unsigned index = 0;; ++index)
+    {
+        boost::filesystem::ifstream cpu_list_stream("/sys/devices/system/node/node" +
+                                                    std::to_string(index) + "/cpulist");
+        if (!cpu_list_stream)
+        {
+            break;
+        }
+        std::string cpu_list;
+        std::getline(cpu_list_stream, cpu_list);
+        auto cpus = parseCPUList(cpu_list);
+        // nodes with memory only don't run any threads
+        if (!cpus.empty())
+        {
+            nodes.push_back(std::move(cpus));
+        }
+    }
+#endif
+    if (nodes.empty())
+    {
+        NUMANode all_cpus(std::max(1u, std::thread::hardware_concurrency()));
+        for (unsigned cpu = 0; cpu < all_cpus.size(); ++cpu)
+        {
+            all_cpus[cpu] = cpu;
+        }
+        nodes.push_back(std::move(all_cpus));
+    }
+    return nodes;
+}
+
+bool bindThreadToNUMANode(const unsigned node_index, const NUMANode &node)
+{
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const auto cpu : node)
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+    if (0 != pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set))
+    {
+        return false;
+    }
+    thread_numa_node = node_index;
+    return true;
+#else
+    (void)node_index;
+    (void)node;
+    return false;
+#endif
+}
+
+unsigned getThreadNUMANode() { return thread_numa_node; }
+}
+}
@@ -0,0 +1,103 @@
+#include "util/page_faults.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace osrm
+{
+namespace util
+{
+
+void adviseWillNeed(const void *address, const std::size_t size)
+{
+#ifdef __linux__
+    static const auto page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    const auto first = reinterpret_cast<std::uintptr_t>(address) & ~(page_size - 1);
+    const auto last = reinterpret_cast<std::uintptr_t>(address) + size;
+    // only a hint, the pages are read on access if it fails
+    madvise(reinterpret_cast<void *>(first), last - first, MADV_WILLNEED);
+#else
+    (void)address;
+    (void)size;
+#endif
+}
+
+namespace
+{
+std::uintptr_t getPageSize()
+{
+#ifdef __linux__
+    static const auto page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    return page_size;
+#else
+    return 4096;
+#endif
+}
+
+// pages touched by a task between checks of the stop flag
+const constexpr std::size_t PREFAULT_GRAIN_SIZE = 256;
+}
+
+std::uint64_t getThreadMajorPageFaults()
+{
+#ifdef __linux__
+    struct rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage) == 0)
+    {
+        return static_cast<std::uint64_t>(usage.ru_majflt);
+    }
+#endif
+    return 0;
+}
+
+void prefaultMemory(const MemoryRegion &region, const std::atomic<bool> &stop)
+{
+    if (region.size == 0)
+    {
+        return;
+    }
+    adviseWillNeed(region.data, region.size);
+
+    const auto page_size = getPageSize();
+    const auto first = reinterpret_cast<std::uintptr_t>(region.data) & ~(page_size - 1);
+    const auto last = reinterpret_cast<std::uintptr_t>(region.data) + region.size;
+    const std::size_t number_of_pages = (last - first + page_size - 1) / page_size;
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, number_of_pages, PREFAULT_GRAIN_SIZE),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            if (stop.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+            // the sum keeps the reads from being optimized away
+            unsigned char sum = 0;
+            for (auto page = range.begin(); page != range.end(); ++page)
+            {
+                // the first page may start before the region
+                const auto address = std::max(first + page * page_size,
+                                              reinterpret_cast<std::uintptr_t>(region.data));
+                sum += *reinterpret_cast<const volatile unsigned char *>(address);
+            }
+            static_cast<void>(sum);
+        });
+}
+
+bool lockMemory(const MemoryRegion &region)
+{
+#ifdef __linux__
+    return region.size == 0 || mlock(region.data, region.size) == 0;
+#else
+    (void)region;
+    return false;
+#endif
+}
+}
+}
@@ -0,0 +1,390 @@
+#include "util/page_heat.hpp"
+#include "util/simple_logger.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <utility>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace osrm
+{
+namespace util
+{
+
+namespace
+{
+std::uintptr_t getPageSize()
+{
+#ifdef __linux__
+    static const auto page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    return page_size;
+#else
+    return 4096;
+#endif
+}
+
+// the pages that overlap the region
+std::pair<std::uintptr_t, std::size_t> getPages(const MemoryRegion &region)
+{
+    const auto page_size = getPageSize();
+    const auto first = reinterpret_cast<std::uintptr_t>(region.data) & ~(page_size - 1);
+    const auto last = reinterpret_cast<std::uintptr_t>(region.data) + region.size;
+    const std::size_t number_of_pages =
+        region.size == 0 ? 0 : (last - first + page_size - 1) / page_size;
+    return std::make_pair(first, number_of_pages);
+}
+
+#ifdef __linux__
+// Reads the page frames of our pages from /proc/self/pagemap and marks them idle in the bitmap
+// of the idle page tracking. The kernel clears the idle bit of a frame when it is accessed.
+class IdlePageTracker
+{
+  public:
+    IdlePageTracker()
+        : pagemap(open("/proc/self/pagemap", O_RDONLY)),
+          bitmap(open("/sys/kernel/mm/page_idle/bitmap", O_RDWR))
+    {
+    }
+
+    ~IdlePageTracker()
+    {
+        if (pagemap >= 0)
+        {
+            close(pagemap);
+        }
+        if (bitmap >= 0)
+        {
+            close(bitmap);
+        }
+    }
+
+    IdlePageTracker(const IdlePageTracker &) = delete;
+    IdlePageTracker &operator=(const IdlePageTracker &) = delete;
+
+    // without CAP_SYS_ADMIN the frames of the page map read as 0
+    bool IsAvailable() const
+    {
+        if (pagemap < 0 || bitmap < 0)
+        {
+            return false;
+        }
+        volatile char probe = 0;
+        probe = 1;
+        const auto frames = GetFrames(MemoryRegion{const_cast<char *>(&probe), 1});
+        return !frames.empty() && frames.front() != 0;
+    }
+
+    // the frames of the pages of the region, 0 for pages that are not present
+    std::vector<std::uint64_t> GetFrames(const MemoryRegion &region) const
+    {
+        const auto pages = getPages(region);
+        std::vector<std::uint64_t> frames(pages.second, 0);
+        const auto first_page = pages.first / getPageSize();
+        for (std::size_t begin = 0; begin < frames.size(); begin += ENTRIES_PER_READ)
+        {
+            const auto count = std::min(ENTRIES_PER_READ, frames.size() - begin);
+            const auto bytes = count * sizeof(std::uint64_t);
+            const auto offset = (first_page + begin) * sizeof(std::uint64_t);
+            if (pread(pagemap, &frames[begin], bytes, offset) != static_cast<ssize_t>(bytes))
+            {
+                std::fill(frames.begin() + begin, frames.begin() + begin + count, 0);
+            }
+        }
+        for (auto &frame : frames)
+        {
+            frame = (frame & PRESENT_BIT) != 0 ? frame & FRAME_MASK : 0;
+        }
+        return frames;
+    }
+
+    void MarkIdle(const std::vector<std::uint64_t> &frames) const
+    {
+        const auto words = GetWords(frames);
+        std::vector<std::uint64_t> buffer;
+        ForEachRun(words, [&](const std::size_t begin, const std::size_t end) {
+            buffer.clear();
+            for (auto index = begin; index != end; ++index)
+            {
+                buffer.push_back(words[index].second);
+            }
+            // frames that can't be tracked are ignored, they count as accessed
+            static_cast<void>(pwrite(bitmap,
+                                     buffer.data(),
+                                     buffer.size() * sizeof(std::uint64_t),
+                                     words[begin].first * sizeof(std::uint64_t)));
+        });
+    }
+
+    // the frames whose idle bit was cleared since MarkIdle, not the ones that are not present
+    std::vector<bool> GetAccessed(const std::vector<std::uint64_t> &frames) const
+    {
+        const auto words = GetWords(frames);
+        std::vector<std::uint64_t> idle_bits(words.size());
+        ForEachRun(words, [&](const std::size_t begin, const std::size_t end) {
+            const auto bytes = (end - begin) * sizeof(std::uint64_t);
+            const auto offset = words[begin].first * sizeof(std::uint64_t);
+            if (pread(bitmap, &idle_bits[begin], bytes, offset) != static_cast<ssize_t>(bytes))
+            {
+                for (auto index = begin; index != end; ++index)
+                {
+                    idle_bits[index] = words[index].second;
+                }
+            }
+        });
+
+        std::vector<bool> accessed(frames.size(), false);
+        for (std::size_t page = 0; page < frames.size(); ++page)
+        {
+            if (frames[page] == 0)
+            {
+                continue;
+            }
+            const auto word = std::lower_bound(
+                words.begin(), words.end(), std::make_pair(frames[page] / 64, std::uint64_t{0}));
+            BOOST_ASSERT(word != words.end() && word->first == frames[page] / 64);
+            const auto bit = std::uint64_t{1} << (frames[page] % 64);
+            accessed[page] = (idle_bits[word - words.begin()] & bit) == 0;
+        }
+        return accessed;
+    }
+
+  private:
+    using Word = std::pair<std::uint64_t, std::uint64_t>;
+
+    // the indices of the words of the bitmap the frames are in, sorted, with the bits of the
+    // frames in them
+    static std::vector<Word> GetWords(const std::vector<std::uint64_t> &frames)
+    {
+        std::vector<Word> words;
+        words.reserve(frames.size());
+        for (const auto frame : frames)
+        {
+            if (frame != 0)
+            {
+                words.emplace_back(frame / 64, std::uint64_t{1} << (frame % 64));
+            }
+        }
+        std::sort(words.begin(), words.end());
+        std::vector<Word> merged;
+        for (const auto &word : words)
+        {
+            if (!merged.empty() && merged.back().first == word.first)
+            {
+                merged.back().second |= word.second;
+            }
+            else
+            {
+                merged.push_back(word);
+            }
+        }
+        return merged;
+    }
+
+    // calls f with the ranges of words that are next to each other in the bitmap, so each of
+    // them is read or written with a single call
+    template <typename F> static void ForEachRun(const std::vector<Word> &words, const F &f)
+    {
+        std::size_t begin = 0;
+        while (begin < words.size())
+        {
+            auto end = begin + 1;
+            while (end < words.size() && words[end].first == words[end - 1].first + 1 &&
+                   end - begin < ENTRIES_PER_READ)
+            {
+                ++end;
+            }
+            f(begin, end);
+            begin = end;
+        }
+    }
+
+    static constexpr std::size_t ENTRIES_PER_READ = 4096;
+    static constexpr std::uint64_t PRESENT_BIT = std::uint64_t{1} << 63;
+    static constexpr std::uint64_t FRAME_MASK = (std::uint64_t{1} << 55) - 1;
+
+    const int pagemap;
+    const int bitmap;
+};
+
+constexpr std::size_t IdlePageTracker::ENTRIES_PER_READ;
+constexpr std::uint64_t IdlePageTracker::PRESENT_BIT;
+constexpr std::uint64_t IdlePageTracker::FRAME_MASK;
+#endif
+}
+
+PageHeatSampler::PageHeatSampler(GetBlocksT get_blocks_, const std::chrono::seconds interval_)
+    : get_blocks(std::move(get_blocks_)), interval(interval_), mode(Mode::Resident)
+{
+#ifdef __linux__
+    if (IdlePageTracker().IsAvailable())
+    {
+        mode = Mode::Accessed;
+    }
+#endif
+    SimpleLogger().Write() << "sampling the " << (mode == Mode::Accessed ? "accessed" : "resident")
+                           << " pages of the data every " << interval.count() << "s";
+    thread = std::thread([this] { Run(); });
+}
+
+PageHeatSampler::~PageHeatSampler()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    stopped.notify_all();
+    thread.join();
+}
+
+std::vector<bool> PageHeatSampler::GetResidentPages(const MemoryRegion &region)
+{
+#ifdef __linux__
+    const auto pages = getPages(region);
+    std::vector<unsigned char> residency(pages.second);
+    std::vector<bool> resident(pages.second, false);
+    // the region may have been unmapped since the blocks were taken, none is resident then
+    if (pages.second > 0 &&
+        mincore(reinterpret_cast<void *>(pages.first),
+                region.size + (reinterpret_cast<std::uintptr_t>(region.data) - pages.first),
+                residency.data()) == 0)
+    {
+        for (std::size_t page = 0; page < pages.second; ++page)
+        {
+            resident[page] = (residency[page] & 1) != 0;
+        }
+    }
+    return resident;
+#else
+    (void)region;
+    return {};
+#endif
+}
+
+bool PageHeatSampler::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    return !stopped.wait_for(lock, interval, [this] { return stop; });
+}
+
+void PageHeatSampler::Run()
+{
+#ifdef __linux__
+    const IdlePageTracker tracker;
+#endif
+    while (true)
+    {
+        std::vector<NamedMemoryRegion> blocks;
+        std::vector<std::vector<bool>> hot_pages;
+#ifdef __linux__
+        if (mode == Mode::Accessed)
+        {
+            // only the frames are kept over the interval, the blocks may be unmapped meanwhile
+            blocks = get_blocks();
+            std::vector<std::vector<std::uint64_t>> frames;
+            for (const auto &block : blocks)
+            {
+                frames.push_back(tracker.GetFrames(block.region));
+                tracker.MarkIdle(frames.back());
+            }
+            if (!Wait())
+            {
+                return;
+            }
+            for (const auto &block_frames : frames)
+            {
+                hot_pages.push_back(tracker.GetAccessed(block_frames));
+            }
+            Report(blocks, hot_pages);
+            continue;
+        }
+#endif
+        if (!Wait())
+        {
+            return;
+        }
+        blocks = get_blocks();
+        for (const auto &block : blocks)
+        {
+            hot_pages.push_back(GetResidentPages(block.region));
+        }
+        Report(blocks, hot_pages);
+    }
+}
+
+void PageHeatSampler::Report(const std::vector<NamedMemoryRegion> &blocks,
+                             const std::vector<std::vector<bool>> &hot_pages)
+{
+    BOOST_ASSERT(blocks.size() == hot_pages.size());
+    const auto page_size = getPageSize();
+
+    struct Line
+    {
+        const std::string *name;
+        std::size_t size;
+        std::size_t number_of_pages;
+        std::size_t number_of_hot_pages;
+        std::size_t number_of_ever_hot_pages;
+    };
+    std::vector<Line> lines;
+    std::size_t total_size = 0;
+    std::size_t total_hot_size = 0;
+    for (std::size_t index = 0; index < blocks.size(); ++index)
+    {
+        const auto &pages = hot_pages[index];
+        auto &block_heat = heat[blocks[index].name];
+        if (block_heat.size != blocks[index].region.size ||
+            block_heat.ever_hot.size() != pages.size())
+        {
+            block_heat.size = blocks[index].region.size;
+            block_heat.ever_hot.assign(pages.size(), false);
+        }
+
+        Line line{&blocks[index].name, blocks[index].region.size, pages.size(), 0, 0};
+        for (std::size_t page = 0; page < pages.size(); ++page)
+        {
+            if (pages[page])
+            {
+                ++line.number_of_hot_pages;
+                block_heat.ever_hot[page] = true;
+            }
+            if (block_heat.ever_hot[page])
+            {
+                ++line.number_of_ever_hot_pages;
+            }
+        }
+        total_size += line.size;
+        total_hot_size += std::min<std::size_t>(line.size, line.number_of_hot_pages * page_size);
+        lines.push_back(line);
+    }
+    std::stable_sort(lines.begin(), lines.end(), [](const Line &lhs, const Line &rhs) {
+        return lhs.number_of_hot_pages > rhs.number_of_hot_pages;
+    });
+
+    const auto percent = [](const std::size_t part, const std::size_t whole) {
+        return whole == 0 ? 0. : 100. * part / whole;
+    };
+    SimpleLogger().Write() << (mode == Mode::Accessed ? "accessed" : "resident")
+                           << " in the last " << interval.count()
+                           << "s: " << (total_hot_size >> 20) << " of " << (total_size >> 20)
+                           << " MB of the data";
+    for (const auto &line : lines)
+    {
+        const auto hot_size =
+            std::min<std::size_t>(line.size, line.number_of_hot_pages * page_size);
+        SimpleLogger().Write() << "  " << *line.name << ": " << (hot_size >> 10) << " of "
+                               << (line.size >> 10) << " KB (" << std::fixed
+                               << std::setprecision(1)
+                               << percent(line.number_of_hot_pages, line.number_of_pages) << "%), "
+                               << percent(line.number_of_ever_hot_pages, line.number_of_pages)
+                               << "% since the start";
+    }
+}
+}
+}
@@ -0,0 +1,254 @@
+#include "util/phase_trace.hpp"
+#include "util/exception.hpp"
+#include "util/json_container.hpp"
+#include "util/json_renderer.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+namespace osrm
+{
+namespace util
+{
+
+namespace
+{
+thread_local unsigned current_depth = 0;
+
+std::chrono::microseconds toMicroseconds(const std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration);
+}
+
+double toSeconds(const std::chrono::microseconds duration) { return duration.count() / 1e6; }
+
+// the share of the threads the CPU time of a phase kept busy
+double getUtilization(const PhaseTrace::Phase &phase, const unsigned number_of_threads)
+{
+    if (phase.wall_time.count() == 0)
+    {
+        return 0.;
+    }
+    return static_cast<double>(phase.cpu_time.count()) /
+           (static_cast<double>(phase.wall_time.count()) * number_of_threads);
+}
+
+// the rchar and wchar of /proc/self/io, zero where there is none
+void readIOCounters(std::uint64_t &bytes_read, std::uint64_t &bytes_written)
+{
+    bytes_read = 0;
+    bytes_written = 0;
+#ifdef __linux__
+    std::ifstream io("/proc/self/io");
+    std::string name;
+    std::uint64_t value;
+    while (io >> name >> value)
+    {
+        if (name == "rchar:")
+        {
+            bytes_read = value;
+        }
+        else if (name == "wchar:")
+        {
+            bytes_written = value;
+        }
+    }
+#endif
+}
+}
+
+PhaseTrace &PhaseTrace::GetInstance()
+{
+    static PhaseTrace trace;
+    return trace;
+}
+
+void PhaseTrace::Enable(const unsigned number_of_threads_)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    number_of_threads = std::max(1u, number_of_threads_);
+    start = std::chrono::steady_clock::now();
+    phases.clear();
+    enabled = true;
+}
+
+void PhaseTrace::Record(Phase phase)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    phases.push_back(std::move(phase));
+}
+
+bool PhaseTrace::GetFormat(const std::string &name, Format &format)
+{
+    if (name == "json")
+    {
+        format = Format::JSON;
+        return true;
+    }
+    if (name == "chrome")
+    {
+        format = Format::Chrome;
+        return true;
+    }
+    return false;
+}
+
+void PhaseTrace::Write(const boost::filesystem::path &path, const Format format) const
+{
+    std::vector<Phase> sorted_phases;
+    unsigned threads;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sorted_phases = phases;
+        threads = number_of_threads;
+    }
+    // phases are recorded when they end, the outer phases after their nested ones
+    std::stable_sort(sorted_phases.begin(),
+                     sorted_phases.end(),
+                     [](const Phase &lhs, const Phase &rhs) {
+                         return lhs.start < rhs.start ||
+                                (lhs.start == rhs.start && lhs.depth < rhs.depth);
+                     });
+
+    json::Object trace;
+    if (format == Format::JSON)
+    {
+        json::Array json_phases;
+        json_phases.values.reserve(sorted_phases.size());
+        for (const auto &phase : sorted_phases)
+        {
+            json::Object json_phase;
+            json_phase.values["name"] = phase.name;
+            json_phase.values["depth"] = phase.depth;
+            json_phase.values["start"] = toSeconds(phase.start);
+            json_phase.values["wall_time"] = toSeconds(phase.wall_time);
+            json_phase.values["cpu_time"] = toSeconds(phase.cpu_time);
+            json_phase.values["utilization"] = getUtilization(phase, threads);
+            json_phase.values["peak_rss"] = static_cast<double>(phase.peak_rss);
+            json_phase.values["bytes_read"] = static_cast<double>(phase.bytes_read);
+            json_phase.values["bytes_written"] = static_cast<double>(phase.bytes_written);
+            json_phases.values.push_back(std::move(json_phase));
+        }
+        trace.values["threads"] = threads;
+        trace.values["phases"] = std::move(json_phases);
+    }
+    else
+    {
+        // complete events for the phases and a counter of the peak memory, times are in us
+        json::Array events;
+        events.values.reserve(2 * sorted_phases.size());
+        for (const auto &phase : sorted_phases)
+        {
+            json::Object args;
+            args.values["cpu_time_ms"] = phase.cpu_time.count() / 1000.;
+            args.values["utilization"] = getUtilization(phase, threads);
+            args.values["peak_rss_mb"] = phase.peak_rss / (1024. * 1024.);
+            args.values["bytes_read"] = static_cast<double>(phase.bytes_read);
+            args.values["bytes_written"] = static_cast<double>(phase.bytes_written);
+
+            json::Object event;
+            event.values["name"] = phase.name;
+            event.values["cat"] = "phase";
+            event.values["ph"] = "X";
+            event.values["ts"] = static_cast<double>(phase.start.count());
+            event.values["dur"] = static_cast<double>(phase.wall_time.count());
+            event.values["pid"] = 1;
+            event.values["tid"] = 1;
+            event.values["args"] = std::move(args);
+            events.values.push_back(std::move(event));
+
+            json::Object counter_args;
+            counter_args.values["peak_rss_mb"] = phase.peak_rss / (1024. * 1024.);
+            json::Object counter;
+            counter.values["name"] = "memory";
+            counter.values["ph"] = "C";
+            counter.values["ts"] = static_cast<double>((phase.start + phase.wall_time).count());
+            counter.values["pid"] = 1;
+            counter.values["args"] = std::move(counter_args);
+            events.values.push_back(std::move(counter));
+        }
+        trace.values["traceEvents"] = std::move(events);
+        trace.values["displayTimeUnit"] = "ms";
+    }
+
+    boost::filesystem::ofstream output(path);
+    json::render(output, trace);
+    output << "\n";
+    if (!output)
+    {
+        throw exception("Could not write the trace to " + path.string());
+    }
+}
+
+PhaseTrace::ScopedPhase::ScopedPhase(std::string name_)
+    : running(PhaseTrace::GetInstance().IsEnabled())
+{
+    if (!running)
+    {
+        return;
+    }
+    name = std::move(name_);
+    depth = current_depth++;
+    start = TakeSample();
+}
+
+PhaseTrace::ScopedPhase::~ScopedPhase() { Stop(); }
+
+void PhaseTrace::ScopedPhase::Stop()
+{
+    if (!running)
+    {
+        return;
+    }
+    running = false;
+    --current_depth;
+    const auto end = TakeSample();
+
+    auto &trace = PhaseTrace::GetInstance();
+    Phase phase;
+    phase.name = std::move(name);
+    phase.depth = depth;
+    phase.start = toMicroseconds(start.wall - trace.start);
+    phase.wall_time = toMicroseconds(end.wall - start.wall);
+    phase.cpu_time = end.cpu - start.cpu;
+    phase.peak_rss = end.peak_rss;
+    phase.bytes_read = end.bytes_read - start.bytes_read;
+    phase.bytes_written = end.bytes_written - start.bytes_written;
+    trace.Record(std::move(phase));
+}
+
+PhaseTrace::ScopedPhase::Sample PhaseTrace::ScopedPhase::TakeSample()
+{
+    Sample sample;
+    sample.wall = std::chrono::steady_clock::now();
+    sample.cpu = std::chrono::microseconds(0);
+    sample.peak_rss = 0;
+#ifndef _WIN32
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        const auto toMicros = [](const timeval &time) {
+            return std::chrono::seconds(time.tv_sec) + std::chrono::microseconds(time.tv_usec);
+        };
+        sample.cpu = toMicros(usage.ru_utime) + toMicros(usage.ru_stime);
+#ifdef __APPLE__
+        sample.peak_rss = usage.ru_maxrss;
+#else
+        // kilobytes everywhere but on OS X
+        sample.peak_rss = static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+    readIOCounters(sample.bytes_read, sample.bytes_written);
+    return sample;
+}
+}
+}
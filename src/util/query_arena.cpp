@@ -0,0 +1,120 @@
+#include "util/query_arena.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace osrm
+{
+namespace util
+{
+
+namespace
+{
+// every allocation starts with a header that tells where its memory comes from
+const constexpr std::size_t HEADER_SIZE = alignof(std::max_align_t);
+const constexpr std::uintptr_t HEAP_MEMORY = 0;
+const constexpr std::uintptr_t ARENA_MEMORY = 1;
+
+const constexpr std::size_t INITIAL_BLOCK_SIZE = 64 * 1024;
+// larger arenas of a query are released when it is done, not kept for the next one
+const constexpr std::size_t MAX_KEPT_SIZE = 4 * 1024 * 1024;
+
+thread_local QueryArena thread_arena;
+thread_local QueryArena *current_arena = nullptr;
+thread_local unsigned number_of_scopes = 0;
+}
+
+QueryArena::Scope::Scope()
+{
+    if (number_of_scopes++ == 0)
+    {
+        current_arena = &thread_arena;
+    }
+}
+
+QueryArena::Scope::~Scope()
+{
+    BOOST_ASSERT(number_of_scopes > 0);
+    if (--number_of_scopes == 0)
+    {
+        current_arena = nullptr;
+        thread_arena.Reset();
+    }
+}
+
+QueryArena *QueryArena::Current() { return current_arena; }
+
+void *QueryArena::Allocate(QueryArena *arena, const std::size_t bytes)
+{
+    if (bytes > static_cast<std::size_t>(-1) - 2 * HEADER_SIZE)
+    {
+        throw std::bad_alloc();
+    }
+    const auto size = HEADER_SIZE + (bytes + HEADER_SIZE - 1) / HEADER_SIZE * HEADER_SIZE;
+
+    char *memory;
+    std::uintptr_t source;
+    if (arena && arena == current_arena)
+    {
+        if (static_cast<std::size_t>(arena->end - arena->position) < size)
+        {
+            arena->AllocateBlock(size);
+        }
+        memory = arena->position;
+        arena->position += size;
+        source = ARENA_MEMORY;
+    }
+    else
+    {
+        memory = static_cast<char *>(::operator new(size));
+        source = HEAP_MEMORY;
+    }
+    *reinterpret_cast<std::uintptr_t *>(memory) = source;
+    return memory + HEADER_SIZE;
+}
+
+void QueryArena::Deallocate(void *pointer) noexcept
+{
+    if (!pointer)
+    {
+        return;
+    }
+    const auto memory = static_cast<char *>(pointer) - HEADER_SIZE;
+    if (*reinterpret_cast<const std::uintptr_t *>(memory) == HEAP_MEMORY)
+    {
+        ::operator delete(memory);
+    }
+}
+
+void QueryArena::AllocateBlock(const std::size_t bytes)
+{
+    // the blocks grow with the queries, the rest of the last one is left unused
+    const auto size = std::max(bytes, std::max(INITIAL_BLOCK_SIZE, 2 * last_block_size));
+    blocks.emplace_back(new char[size]);
+    position = blocks.back().get();
+    end = position + size;
+    last_block_size = size;
+    capacity += size;
+}
+
+void QueryArena::Reset()
+{
+    if (blocks.size() > 1)
+    {
+        // the next query gets the memory of this one in a single block
+        const auto size = std::min(capacity, MAX_KEPT_SIZE);
+        blocks.clear();
+        last_block_size = 0;
+        capacity = 0;
+        AllocateBlock(size);
+    }
+    else if (!blocks.empty())
+    {
+        position = blocks.front().get();
+        end = position + capacity;
+    }
+}
+}
+}
@@ -0,0 +1,373 @@
+#include "util/query_metrics.hpp"
+#include "util/tracepoint.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace osrm
+{
+namespace util
+{
+
+namespace
+{
+const char *const SERVICE_NAMES[] = {"route",
+                                     "routebatch",
+                                     "table",
+                                     "nearest",
+                                     "trip",
+                                     "match",
+                                     "tile",
+                                     "onetoall",
+                                     "isochrone"};
+const char *const PHASE_NAMES[] = {
+    "query", "snapping", "search", "unpacking", "guidance", "rendering", "compression"};
+const char *const SEARCH_COUNTER_NAMES[] = {
+    "settled_nodes", "relaxed_edges", "stalled_nodes", "core_entries", "unpacked_shortcuts"};
+const char *const SWAP_PHASE_NAMES[] = {"barriers", "mapping", "draining"};
+const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+static_assert(sizeof(SERVICE_NAMES) / sizeof(*SERVICE_NAMES) ==
+                  QueryMetrics::NUMBER_OF_SERVICES,
+              "every service needs a name");
+static_assert(sizeof(PHASE_NAMES) / sizeof(*PHASE_NAMES) == QueryMetrics::NUMBER_OF_PHASES,
+              "every phase needs a name");
+static_assert(sizeof(SEARCH_COUNTER_NAMES) / sizeof(*SEARCH_COUNTER_NAMES) ==
+                  QueryMetrics::NUMBER_OF_SEARCH_COUNTERS,
+              "every search counter needs a name");
+static_assert(sizeof(SWAP_PHASE_NAMES) / sizeof(*SWAP_PHASE_NAMES) ==
+                  QueryMetrics::NUMBER_OF_SWAP_PHASES,
+              "every swap phase needs a name");
+
+thread_local QueryMetrics::ScopedQuery *current_query = nullptr;
+thread_local QueryMetrics::ScopedPhase *current_phase = nullptr;
+
+double toSeconds(const std::chrono::nanoseconds duration)
+{
+    return std::chrono::duration<double>(duration).count();
+}
+
+// the quantiles, sum and count of a summary, nothing if it has no samples
+void renderSummary(std::ostream &stream,
+                   const std::string &name,
+                   const std::string &labels,
+                   const LatencyHistogram::Snapshot &snapshot)
+{
+    if (snapshot.count == 0)
+    {
+        return;
+    }
+    const auto separator = labels.empty() ? "" : ",";
+    for (const auto quantile : QUANTILES)
+    {
+        stream << name << "{" << labels << separator << "quantile=\"" << quantile << "\"} "
+               << toSeconds(snapshot.GetQuantile(quantile)) << "\n";
+    }
+    const auto braced_labels = labels.empty() ? labels : "{" + labels + "}";
+    stream << name << "_sum" << braced_labels << " " << toSeconds(snapshot.sum) << "\n"
+           << name << "_count" << braced_labels << " " << snapshot.count << "\n";
+}
+}
+
+constexpr std::size_t QueryMetrics::NUMBER_OF_SERVICES;
+constexpr std::size_t QueryMetrics::NUMBER_OF_PHASES;
+constexpr std::size_t QueryMetrics::NUMBER_OF_SEARCH_COUNTERS;
+constexpr std::size_t QueryMetrics::NUMBER_OF_SWAP_PHASES;
+
+QueryMetrics &QueryMetrics::GetInstance()
+{
+    static QueryMetrics metrics;
+    return metrics;
+}
+
+void QueryMetrics::Record(const Service service,
+                          const Phase phase,
+                          const std::chrono::nanoseconds duration)
+{
+    histograms[static_cast<std::size_t>(service)][static_cast<std::size_t>(phase)].Record(
+        duration);
+}
+
+void QueryMetrics::AddSearchCount(const Service service,
+                                  const SearchCounter counter,
+                                  const std::uint64_t count)
+{
+    search_counts[static_cast<std::size_t>(service)][static_cast<std::size_t>(counter)].fetch_add(
+        count, std::memory_order_relaxed);
+}
+
+void QueryMetrics::AddLeafPageFaults(const std::uint64_t number_of_faults)
+{
+    leaf_page_faults.fetch_add(number_of_faults, std::memory_order_relaxed);
+}
+
+void QueryMetrics::AddHeapCheckout(const bool reused)
+{
+    heap_checkouts.fetch_add(1, std::memory_order_relaxed);
+    if (reused)
+    {
+        reused_heap_checkouts.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void QueryMetrics::AddHeapAllocations(const std::uint64_t number_of_allocations)
+{
+    heap_allocations.fetch_add(number_of_allocations, std::memory_order_relaxed);
+}
+
+void QueryMetrics::AddHeapMemory(const std::int64_t bytes)
+{
+    heap_memory.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void QueryMetrics::AddQueryMemory(const Service service, const std::int64_t bytes)
+{
+    query_memory[static_cast<std::size_t>(service)].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void QueryMetrics::RecordQueryMemory(const Service service,
+                                     const std::uint64_t bytes,
+                                     const bool rejected)
+{
+    const auto index = static_cast<std::size_t>(service);
+    query_memory_total[index].fetch_add(bytes, std::memory_order_relaxed);
+    if (rejected)
+    {
+        query_memory_rejections[index].fetch_add(1, std::memory_order_relaxed);
+    }
+    auto peak = query_memory_peak[index].load(std::memory_order_relaxed);
+    while (bytes > peak &&
+           !query_memory_peak[index].compare_exchange_weak(peak, bytes, std::memory_order_relaxed))
+    {
+    }
+}
+
+void QueryMetrics::RecordSwap(const SwapPhase phase, const std::chrono::nanoseconds duration)
+{
+    swap_histograms[static_cast<std::size_t>(phase)].Record(duration);
+}
+
+void QueryMetrics::RecordSwapStall(const std::chrono::nanoseconds duration)
+{
+    swap_stalls.Record(duration);
+}
+
+bool QueryMetrics::GetService(const std::string &name, Service &service)
+{
+    const auto found = std::find(std::begin(SERVICE_NAMES), std::end(SERVICE_NAMES), name);
+    if (found == std::end(SERVICE_NAMES))
+    {
+        return false;
+    }
+    service = static_cast<Service>(std::distance(std::begin(SERVICE_NAMES), found));
+    return true;
+}
+
+const char *QueryMetrics::GetServiceName(const Service service)
+{
+    return SERVICE_NAMES[static_cast<std::size_t>(service)];
+}
+
+const char *QueryMetrics::GetPhaseName(const Phase phase)
+{
+    return PHASE_NAMES[static_cast<std::size_t>(phase)];
+}
+
+bool QueryMetrics::GetCurrentQuery(Service &service, Phase &phase)
+{
+    const auto *const query = current_query;
+    if (!query)
+    {
+        return false;
+    }
+    service = query->service;
+    // the phases of an outer query don't belong to a nested one
+    const auto *const innermost_phase = current_phase;
+    phase = innermost_phase && innermost_phase->query == query ? innermost_phase->phase
+                                                                : Phase::Query;
+    return true;
+}
+
+void QueryMetrics::Render(std::string &output) const
+{
+    std::ostringstream stream;
+    stream << "# HELP osrm_query_duration_seconds Duration of the queries of a service and of "
+              "the phases of the queries\n"
+           << "# TYPE osrm_query_duration_seconds summary\n";
+    for (std::size_t service = 0; service < NUMBER_OF_SERVICES; ++service)
+    {
+        for (std::size_t phase = 0; phase < NUMBER_OF_PHASES; ++phase)
+        {
+            renderSummary(stream,
+                          "osrm_query_duration_seconds",
+                          std::string("service=\"") + SERVICE_NAMES[service] + "\",phase=\"" +
+                              PHASE_NAMES[phase] + "\"",
+                          histograms[service][phase].GetSnapshot());
+        }
+    }
+    stream << "# HELP osrm_search_total Nodes settled, edges relaxed, nodes stalled, core "
+              "entries and shortcuts unpacked by the searches of the queries of a service\n"
+           << "# TYPE osrm_search_total counter\n";
+    for (std::size_t service = 0; service < NUMBER_OF_SERVICES; ++service)
+    {
+        for (std::size_t counter = 0; counter < NUMBER_OF_SEARCH_COUNTERS; ++counter)
+        {
+            const auto count = search_counts[service][counter].load(std::memory_order_relaxed);
+            if (count == 0)
+            {
+                continue;
+            }
+            stream << "osrm_search_total{service=\"" << SERVICE_NAMES[service]
+                   << "\",counter=\"" << SEARCH_COUNTER_NAMES[counter] << "\"} " << count
+                   << "\n";
+        }
+    }
+    stream << "# HELP osrm_dataset_swap_duration_seconds Time that swaps to a new dataset in "
+              "shared memory spent waiting for the barriers of osrm-datastore, mapping the new "
+              "dataset, and draining the queries on the previous one until it was released\n"
+           << "# TYPE osrm_dataset_swap_duration_seconds summary\n";
+    for (std::size_t phase = 0; phase < NUMBER_OF_SWAP_PHASES; ++phase)
+    {
+        renderSummary(stream,
+                      "osrm_dataset_swap_duration_seconds",
+                      std::string("phase=\"") + SWAP_PHASE_NAMES[phase] + "\"",
+                      swap_histograms[phase].GetSnapshot());
+    }
+    stream << "# HELP osrm_dataset_swap_stall_seconds Time that queries waited for a swap of "
+              "the dataset before they could start\n"
+           << "# TYPE osrm_dataset_swap_stall_seconds summary\n";
+    renderSummary(stream, "osrm_dataset_swap_stall_seconds", "", swap_stalls.GetSnapshot());
+    stream << "# HELP osrm_rtree_leaf_page_faults_total Major page faults of queries on r-tree "
+              "leaves, counted with --prefetch-rtree-leaves\n"
+           << "# TYPE osrm_rtree_leaf_page_faults_total counter\n"
+           << "osrm_rtree_leaf_page_faults_total "
+           << leaf_page_faults.load(std::memory_order_relaxed) << "\n";
+    // a reused checkout is counted after the checkout, so this never counts more reused ones
+    const auto reused_checkouts = reused_heap_checkouts.load(std::memory_order_relaxed);
+    const auto checkouts = heap_checkouts.load(std::memory_order_relaxed);
+    stream << "# HELP osrm_heap_checkouts_total Sets of search heaps that queries checked out of "
+              "the heap pool, reused ones were created by an earlier query\n"
+           << "# TYPE osrm_heap_checkouts_total counter\n"
+           << "osrm_heap_checkouts_total{reused=\"true\"} " << reused_checkouts << "\n"
+           << "osrm_heap_checkouts_total{reused=\"false\"} " << checkouts - reused_checkouts
+           << "\n"
+           << "# HELP osrm_heap_allocations_total Search heaps that were allocated, or grown for "
+              "a larger graph\n"
+           << "# TYPE osrm_heap_allocations_total counter\n"
+           << "osrm_heap_allocations_total "
+           << heap_allocations.load(std::memory_order_relaxed) << "\n"
+           << "# HELP osrm_heap_memory_bytes Bytes of the index storage of the search heaps of "
+              "all heap pools\n"
+           << "# TYPE osrm_heap_memory_bytes gauge\n"
+           << "osrm_heap_memory_bytes " << heap_memory.load(std::memory_order_relaxed) << "\n";
+
+    // the services whose queries never reserved any memory are left out
+    const auto has_query_memory = [this](const std::size_t service) {
+        return query_memory[service].load(std::memory_order_relaxed) != 0 ||
+               query_memory_total[service].load(std::memory_order_relaxed) > 0 ||
+               query_memory_rejections[service].load(std::memory_order_relaxed) > 0;
+    };
+    const auto render_per_service = [&](const char *name,
+                                        const char *type,
+                                        const char *help,
+                                        const auto &values) {
+        stream << "# HELP " << name << " " << help << "\n"
+               << "# TYPE " << name << " " << type << "\n";
+        for (std::size_t service = 0; service < NUMBER_OF_SERVICES; ++service)
+        {
+            if (has_query_memory(service))
+            {
+                stream << name << "{service=\"" << SERVICE_NAMES[service] << "\"} "
+                       << values[service].load(std::memory_order_relaxed) << "\n";
+            }
+        }
+    };
+    render_per_service("osrm_query_memory_bytes",
+                       "gauge",
+                       "Bytes that the running queries of a service reserved",
+                       query_memory);
+    render_per_service("osrm_query_memory_peak_bytes",
+                       "gauge",
+                       "The most bytes that a single query of a service reserved",
+                       query_memory_peak);
+    render_per_service("osrm_query_memory_bytes_total",
+                       "counter",
+                       "Bytes that the queries of a service reserved",
+                       query_memory_total);
+    render_per_service("osrm_query_memory_rejections_total",
+                       "counter",
+                       "Queries of a service that failed for needing more than the memory limit",
+                       query_memory_rejections);
+    output += stream.str();
+}
+
+QueryMetrics::ScopedQuery::ScopedQuery(const Service service_)
+    : service(service_), start(std::chrono::steady_clock::now()), outer_query(current_query)
+{
+    phases.fill(std::chrono::nanoseconds(0));
+    has_phase.fill(false);
+    current_query = this;
+    OSRM_TRACEPOINT1(query__start, SERVICE_NAMES[static_cast<std::size_t>(service)]);
+}
+
+QueryMetrics::ScopedQuery::~ScopedQuery()
+{
+    BOOST_ASSERT(current_query == this);
+    current_query = outer_query;
+
+    const auto duration = std::chrono::steady_clock::now() - start;
+    OSRM_TRACEPOINT2(query__done,
+                     SERVICE_NAMES[static_cast<std::size_t>(service)],
+                     std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    auto &metrics = GetInstance();
+    metrics.Record(service, Phase::Query, duration);
+    for (std::size_t phase = 0; phase < NUMBER_OF_PHASES; ++phase)
+    {
+        if (has_phase[phase])
+        {
+            metrics.Record(service, static_cast<Phase>(phase), phases[phase]);
+        }
+    }
+}
+
+QueryMetrics::ScopedPhase::ScopedPhase(const Phase phase_)
+    : phase(phase_), query(current_query), outer_phase(current_phase), nested(0)
+{
+    if (query)
+    {
+        current_phase = this;
+        start = std::chrono::steady_clock::now();
+        OSRM_TRACEPOINT1(phase__start, PHASE_NAMES[static_cast<std::size_t>(phase)]);
+    }
+}
+
+QueryMetrics::ScopedPhase::~ScopedPhase()
+{
+    if (!query)
+    {
+        return;
+    }
+    BOOST_ASSERT(current_phase == this);
+    current_phase = outer_phase;
+
+    const auto duration = std::chrono::steady_clock::now() - start;
+    const auto index = static_cast<std::size_t>(phase);
+    const auto phase_duration = duration - nested;
+    query->phases[index] += phase_duration;
+    OSRM_TRACEPOINT2(
+        phase__done,
+        PHASE_NAMES[index],
+        std::chrono::duration_cast<std::chrono::nanoseconds>(phase_duration).count());
+    query->has_phase[index] = true;
+    if (outer_phase && outer_phase->query == query)
+    {
+        outer_phase->nested += duration;
+    }
+}
+}
+}
@@ -0,0 +1,292 @@
+#include "util/sampling_profiler.hpp"
+#include "util/exception.hpp"
+#include "util/make_unique.hpp"
+#include "util/query_metrics.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#ifndef _WIN32
+#include <cxxabi.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/time.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+#ifndef _WIN32
+namespace
+{
+const constexpr int MAX_FRAMES = 64;
+// the signal handler and the trampoline of the kernel that called it
+const constexpr int SKIPPED_FRAMES = 2;
+// about 34 MB of frames
+const constexpr std::size_t MAX_SAMPLES = 1 << 16;
+
+struct Sample
+{
+    // set once the handler wrote the sample
+    std::atomic<bool> complete;
+    bool has_query;
+    QueryMetrics::Service service;
+    QueryMetrics::Phase phase;
+    int depth;
+    void *frames[MAX_FRAMES];
+};
+
+struct SampleBuffer
+{
+    explicit SampleBuffer(const std::size_t capacity)
+        : samples(new Sample[capacity]()), capacity(capacity)
+    {
+    }
+
+    std::unique_ptr<Sample[]> samples;
+    const std::size_t capacity;
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::uint64_t> dropped{0};
+};
+
+// the buffer of the running profile, the handler does nothing without one
+std::atomic<SampleBuffer *> active_buffer{nullptr};
+// a buffer is only freed once no handler can write into it anymore
+std::atomic<unsigned> running_handlers{0};
+
+void handleProfilingSignal(int)
+{
+    const auto saved_errno = errno;
+    running_handlers.fetch_add(1);
+    auto *const buffer = active_buffer.load();
+    if (buffer)
+    {
+        const auto index = buffer->next.fetch_add(1, std::memory_order_relaxed);
+        if (index < buffer->capacity)
+        {
+            auto &sample = buffer->samples[index];
+            sample.depth = backtrace(sample.frames, MAX_FRAMES);
+            sample.has_query = QueryMetrics::GetCurrentQuery(sample.service, sample.phase);
+            sample.complete.store(true, std::memory_order_release);
+        }
+        else
+        {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    running_handlers.fetch_sub(1);
+    errno = saved_errno;
+}
+
+// The demangled name of the function of a frame from backtrace_symbols, which looks like
+// "file(symbol+offset) [address]", or the file name and the offset without a symbol
+std::string getFrameName(const char *symbol)
+{
+    const char *const open = std::strchr(symbol, '(');
+    const char *const close = open ? std::strchr(open, ')') : nullptr;
+    if (!open || !close)
+    {
+        return symbol;
+    }
+    const char *const plus = std::find(open, close, '+');
+    const std::string name(open + 1, plus);
+
+    std::string frame;
+    if (name.empty())
+    {
+        const std::string file(symbol, open);
+        const auto slash = file.find_last_of('/');
+        frame = (slash == std::string::npos ? file : file.substr(slash + 1)) +
+                std::string(plus, close);
+    }
+    else
+    {
+        int status = 0;
+        char *const demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+        frame = status == 0 && demangled ? demangled : name;
+        std::free(demangled);
+    }
+    // semicolons separate the frames of a collapsed stack
+    std::replace(frame.begin(), frame.end(), ';', ':');
+    return frame;
+}
+
+// The names of the frames of the samples, symbolized once per address
+std::unordered_map<void *, std::string> getFrameNames(const SampleBuffer &buffer,
+                                                      const std::size_t number_of_samples)
+{
+    std::vector<void *> addresses;
+    for (std::size_t index = 0; index < number_of_samples; ++index)
+    {
+        const auto &sample = buffer.samples[index];
+        if (sample.complete.load(std::memory_order_acquire))
+        {
+            addresses.insert(addresses.end(),
+                             sample.frames + std::min(SKIPPED_FRAMES, sample.depth),
+                             sample.frames + sample.depth);
+        }
+    }
+    std::sort(addresses.begin(), addresses.end());
+    addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+
+    std::unordered_map<void *, std::string> names;
+    if (addresses.empty())
+    {
+        return names;
+    }
+    char **const symbols = backtrace_symbols(addresses.data(), static_cast<int>(addresses.size()));
+    for (std::size_t index = 0; index < addresses.size(); ++index)
+    {
+        names[addresses[index]] = symbols ? getFrameName(symbols[index]) : "??";
+    }
+    std::free(symbols);
+    return names;
+}
+}
+#endif
+
+SamplingProfiler &SamplingProfiler::GetInstance()
+{
+    static SamplingProfiler profiler;
+    return profiler;
+}
+
+bool SamplingProfiler::IsAvailable()
+{
+#ifndef _WIN32
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SamplingProfiler::Profile(const std::chrono::milliseconds duration,
+                               const unsigned frequency,
+                               const boost::filesystem::path &path,
+                               Summary &summary)
+{
+#ifndef _WIN32
+    BOOST_ASSERT(frequency > 0);
+    if (running.exchange(true))
+    {
+        return false;
+    }
+    struct RunningReset
+    {
+        ~RunningReset() { running = false; }
+        std::atomic<bool> &running;
+    } running_reset{running};
+
+    // the first call of backtrace loads the unwinder, which the handler must not do
+    void *frame = nullptr;
+    backtrace(&frame, 1);
+
+    // stays installed, a SIGPROF that is still pending after the profile would end the process
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = handleProfilingSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    if (sigaction(SIGPROF, &action, nullptr) != 0)
+    {
+        throw exception("Could not install the handler of SIGPROF");
+    }
+
+    // every thread that can run may be sampled at the frequency
+    const std::uint64_t number_of_threads = std::max(1u, std::thread::hardware_concurrency());
+    const std::uint64_t expected_samples =
+        duration.count() * std::uint64_t{frequency} / 1000 * number_of_threads + 1;
+    const auto buffer = util::make_unique<SampleBuffer>(
+        static_cast<std::size_t>(std::min<std::uint64_t>(expected_samples, MAX_SAMPLES)));
+
+    const long interval = std::max(1L, 1000000L / static_cast<long>(frequency));
+    itimerval timer;
+    timer.it_interval.tv_sec = interval / 1000000;
+    timer.it_interval.tv_usec = interval % 1000000;
+    timer.it_value = timer.it_interval;
+    active_buffer.store(buffer.get());
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0)
+    {
+        active_buffer.store(nullptr);
+        throw exception("Could not start the timer of the profiler");
+    }
+    std::this_thread::sleep_for(duration);
+
+    itimerval stopped;
+    std::memset(&stopped, 0, sizeof(stopped));
+    setitimer(ITIMER_PROF, &stopped, nullptr);
+    active_buffer.store(nullptr);
+    while (running_handlers.load() != 0)
+    {
+        std::this_thread::yield();
+    }
+
+    const auto number_of_samples = std::min(buffer->next.load(), buffer->capacity);
+    const auto frame_names = getFrameNames(*buffer, number_of_samples);
+    std::map<std::string, std::uint64_t> stacks;
+    summary.number_of_samples = 0;
+    for (std::size_t index = 0; index < number_of_samples; ++index)
+    {
+        const auto &sample = buffer->samples[index];
+        if (!sample.complete.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+        std::string stack;
+        if (sample.has_query)
+        {
+            stack = std::string(QueryMetrics::GetServiceName(sample.service)) + ';' +
+                    QueryMetrics::GetPhaseName(sample.phase);
+        }
+        // from the root of the stack
+        for (auto frame = sample.depth - 1; frame >= SKIPPED_FRAMES; --frame)
+        {
+            if (!stack.empty())
+            {
+                stack += ';';
+            }
+            stack += frame_names.at(sample.frames[frame]);
+        }
+        if (!stack.empty())
+        {
+            ++stacks[stack];
+            ++summary.number_of_samples;
+        }
+    }
+    summary.number_of_dropped_samples = buffer->dropped.load();
+    summary.number_of_stacks = stacks.size();
+
+    boost::filesystem::ofstream stream(path);
+    for (const auto &stack : stacks)
+    {
+        stream << stack.first << ' ' << stack.second << '\n';
+    }
+    stream.close();
+    if (!stream)
+    {
+        throw exception("Could not write the profile to " + path.string());
+    }
+    return true;
+#else
+    (void)duration;
+    (void)frequency;
+    (void)path;
+    (void)summary;
+    throw exception("Profiling needs SIGPROF, which this platform doesn't have");
+#endif
+}
+}
+}
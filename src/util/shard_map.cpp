@@ -0,0 +1,291 @@
+#include "util/shard_map.hpp"
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <numeric>
+#include <queue>
+#include <sstream>
+#include <utility>
+
+namespace osrm
+{
+namespace util
+{
+
+const constexpr std::uint32_t ShardMap::INVALID_INDEX;
+
+namespace
+{
+RectangleInt2D readBox(std::istream &input)
+{
+    double west, south, east, north;
+    input >> west >> south >> east >> north;
+    return RectangleInt2D(
+        FloatLongitude{west}, FloatLongitude{east}, FloatLatitude{south}, FloatLatitude{north});
+}
+
+void writeBox(std::ostream &output, const RectangleInt2D &box)
+{
+    output << " " << toFloating(box.min_lon) << " " << toFloating(box.min_lat) << " "
+           << toFloating(box.max_lon) << " " << toFloating(box.max_lat);
+}
+}
+
+ShardMap::ShardMap(const std::string &path)
+{
+    boost::filesystem::ifstream input(path);
+    if (!input)
+    {
+        throw exception("Failed to open " + path + " for reading.");
+    }
+
+    std::vector<OverlayEdge> edges;
+    std::string line;
+    std::size_t line_number = 0;
+    while (std::getline(input, line))
+    {
+        ++line_number;
+        std::istringstream line_stream(line);
+        std::string kind;
+        if (!(line_stream >> kind) || kind.front() == '#')
+        {
+            continue;
+        }
+
+        bool is_valid = false;
+        if (kind == "shard")
+        {
+            std::uint32_t index;
+            line_stream >> index;
+            const auto core = readBox(line_stream);
+            const auto region = readBox(line_stream);
+            is_valid = line_stream && index == shards.size();
+            if (is_valid)
+            {
+                AddShard(core, region);
+            }
+        }
+        else if (kind == "backend")
+        {
+            std::uint32_t shard;
+            std::string backend;
+            line_stream >> shard >> backend;
+            const auto colon = backend.rfind(':');
+            is_valid = line_stream && shard < shards.size() && colon != std::string::npos;
+            if (is_valid)
+            {
+                SetBackend(shard, backend.substr(0, colon), backend.substr(colon + 1));
+            }
+        }
+        else if (kind == "boundary")
+        {
+            double longitude, latitude;
+            std::uint32_t first_shard, second_shard;
+            line_stream >> longitude >> latitude >> first_shard >> second_shard;
+            is_valid = line_stream && first_shard < shards.size() && second_shard < shards.size();
+            if (is_valid)
+            {
+                AddBoundaryPoint(Coordinate(FloatLongitude{longitude}, FloatLatitude{latitude}),
+                                 first_shard,
+                                 second_shard);
+            }
+        }
+        else if (kind == "overlay")
+        {
+            OverlayEdge edge;
+            line_stream >> edge.shard >> edge.from >> edge.to >> edge.duration;
+            is_valid = line_stream && edge.shard < shards.size() &&
+                       edge.from < boundary_points.size() && edge.to < boundary_points.size();
+            edges.push_back(edge);
+        }
+
+        if (!is_valid)
+        {
+            throw exception("Invalid line " + std::to_string(line_number) + " in " + path);
+        }
+    }
+
+    if (shards.empty())
+    {
+        throw exception(path + " contains no shards");
+    }
+    SetOverlay(std::move(edges));
+}
+
+void ShardMap::Write(const std::string &path) const
+{
+    boost::filesystem::ofstream output(path);
+    if (!output)
+    {
+        throw exception("Failed to open " + path + " for writing.");
+    }
+
+    output << std::setprecision(9);
+    output << "# shard <index> <core west south east north> <region west south east north>\n";
+    for (const auto index : util::irange<std::size_t>(0, shards.size()))
+    {
+        output << "shard " << index;
+        writeBox(output, shards[index].core);
+        writeBox(output, shards[index].region);
+        output << "\n";
+    }
+    for (const auto index : util::irange<std::size_t>(0, shards.size()))
+    {
+        if (!shards[index].host.empty())
+        {
+            output << "backend " << index << " " << shards[index].host << ":"
+                   << shards[index].port << "\n";
+        }
+    }
+    for (const auto &point : boundary_points)
+    {
+        output << "boundary " << toFloating(point.coordinate.lon) << " "
+               << toFloating(point.coordinate.lat) << " " << point.shards[0] << " "
+               << point.shards[1] << "\n";
+    }
+    for (const auto &edge : overlay_edges)
+    {
+        output << "overlay " << edge.shard << " " << edge.from << " " << edge.to << " "
+               << edge.duration << "\n";
+    }
+
+    if (!output)
+    {
+        throw exception("Failed to write " + path);
+    }
+}
+
+void ShardMap::AddShard(const RectangleInt2D &core, const RectangleInt2D &region)
+{
+    shards.push_back(Shard{core, region, "", ""});
+}
+
+void ShardMap::SetBackend(const std::uint32_t shard,
+                          const std::string &host,
+                          const std::string &port)
+{
+    shards[shard].host = host;
+    shards[shard].port = port;
+}
+
+std::uint32_t ShardMap::AddBoundaryPoint(const Coordinate coordinate,
+                                         const std::uint32_t first_shard,
+                                         const std::uint32_t second_shard)
+{
+    boundary_points.push_back(BoundaryPoint{coordinate, {first_shard, second_shard}});
+    first_overlay_edge.assign(boundary_points.size() + 1, 0);
+    overlay_edges.clear();
+    return boundary_points.size() - 1;
+}
+
+void ShardMap::SetOverlay(std::vector<OverlayEdge> edges)
+{
+    overlay_edges = std::move(edges);
+    std::stable_sort(overlay_edges.begin(),
+                     overlay_edges.end(),
+                     [](const OverlayEdge &lhs, const OverlayEdge &rhs) {
+                         return lhs.from < rhs.from;
+                     });
+
+    first_overlay_edge.assign(boundary_points.size() + 1, 0);
+    for (const auto &edge : overlay_edges)
+    {
+        ++first_overlay_edge[edge.from + 1];
+    }
+    std::partial_sum(
+        first_overlay_edge.begin(), first_overlay_edge.end(), first_overlay_edge.begin());
+}
+
+std::vector<std::uint32_t> ShardMap::GetBoundaryPoints(const std::uint32_t shard) const
+{
+    std::vector<std::uint32_t> points;
+    for (const auto index : util::irange<std::uint32_t>(0, boundary_points.size()))
+    {
+        if (IsInRegion(shard, boundary_points[index].coordinate))
+        {
+            points.push_back(index);
+        }
+    }
+    return points;
+}
+
+std::uint32_t ShardMap::FindShard(const Coordinate coordinate) const
+{
+    std::uint32_t nearest_shard = 0;
+    std::uint64_t nearest_distance = std::numeric_limits<std::uint64_t>::max();
+    for (const auto index : util::irange<std::uint32_t>(0, shards.size()))
+    {
+        const auto distance = shards[index].core.GetMinSquaredDist(coordinate);
+        if (distance == 0)
+        {
+            return index;
+        }
+        if (distance < nearest_distance)
+        {
+            nearest_distance = distance;
+            nearest_shard = index;
+        }
+    }
+    return nearest_shard;
+}
+
+void ShardMap::SearchOverlay(std::vector<double> &durations,
+                             std::vector<std::uint32_t> &parent_edges) const
+{
+    BOOST_ASSERT(durations.size() == boundary_points.size());
+    parent_edges.assign(boundary_points.size(), INVALID_INDEX);
+
+    using QueueEntry = std::pair<double, std::uint32_t>;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+    for (const auto index : util::irange<std::uint32_t>(0, durations.size()))
+    {
+        if (durations[index] < std::numeric_limits<double>::infinity())
+        {
+            queue.emplace(durations[index], index);
+        }
+    }
+
+    while (!queue.empty())
+    {
+        const auto entry = queue.top();
+        queue.pop();
+        if (entry.first > durations[entry.second])
+        {
+            continue;
+        }
+        for (auto edge = first_overlay_edge[entry.second];
+             edge < first_overlay_edge[entry.second + 1];
+             ++edge)
+        {
+            const auto to = overlay_edges[edge].to;
+            const auto duration = entry.first + overlay_edges[edge].duration;
+            if (duration < durations[to])
+            {
+                durations[to] = duration;
+                parent_edges[to] = edge;
+                queue.emplace(duration, to);
+            }
+        }
+    }
+}
+
+std::vector<std::uint32_t> ShardMap::GetOverlayPath(const std::vector<std::uint32_t> &parent_edges,
+                                                    std::uint32_t boundary_point) const
+{
+    std::vector<std::uint32_t> path;
+    while (parent_edges[boundary_point] != INVALID_INDEX)
+    {
+        path.push_back(parent_edges[boundary_point]);
+        boundary_point = overlay_edges[path.back()].from;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+}
+}
@@ -0,0 +1,83 @@
+#include "contractor/graph_contractor.hpp"
+
+#include "helper.hpp"
+
+#include "util/chunked_vector.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(checkpoint)
+
+using namespace osrm;
+using namespace osrm::contractor;
+
+namespace
+{
+const constexpr NodeID NUMBER_OF_NODES = 1000;
+
+// Stops the contraction before the given round, the checkpoint is written then
+void contractUntil(const EdgeBasedEdges &edges, const std::string &path, const unsigned round)
+{
+    auto input_edges = toChunkedVector(edges);
+    GraphContractor graph_contractor(
+        NUMBER_OF_NODES, input_edges, {}, std::vector<EdgeWeight>(NUMBER_OF_NODES, 0));
+
+    CheckpointConfig checkpoint_config;
+    checkpoint_config.path = path;
+    unsigned current_round = 0;
+    checkpoint_config.stop = [&current_round, round] { return current_round++ == round; };
+    BOOST_CHECK(!graph_contractor.Run(1.0, WitnessSearchConfig(), checkpoint_config));
+    BOOST_CHECK(boost::filesystem::exists(path));
+}
+
+CheckpointConfig resumeFrom(const std::string &path)
+{
+    CheckpointConfig checkpoint_config;
+    checkpoint_config.path = path;
+    checkpoint_config.resume = true;
+    return checkpoint_config;
+}
+}
+
+// The rounds cover the start and checkpoints before and after the flush of the remaining graph,
+// which comes after about 90 rounds
+BOOST_AUTO_TEST_CASE(resumed_contraction_equals_uninterrupted)
+{
+    const auto path =
+        (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    const auto edges = makeGraph(NUMBER_OF_NODES, 5);
+    const auto uninterrupted_edges = contract(NUMBER_OF_NODES, edges);
+
+    for (const unsigned round : {0, 20, 100})
+    {
+        contractUntil(edges, path, round);
+        const auto resumed_edges = contract(NUMBER_OF_NODES, edges, 1.0, {}, resumeFrom(path));
+        BOOST_CHECK_EQUAL(resumed_edges.size(), uninterrupted_edges.size());
+        BOOST_CHECK(resumed_edges == uninterrupted_edges);
+    }
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(checkpoint_of_other_input_ignored)
+{
+    const auto path =
+        (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    const auto edges = makeGraph(NUMBER_OF_NODES, 6);
+    contractUntil(edges, path, 20);
+
+    auto other_edges = edges;
+    other_edges.front().weight += 1;
+    const auto resumed_edges = contract(NUMBER_OF_NODES, other_edges, 1.0, {}, resumeFrom(path));
+    const auto uninterrupted_edges = contract(NUMBER_OF_NODES, other_edges);
+    BOOST_CHECK_EQUAL(resumed_edges.size(), uninterrupted_edges.size());
+    BOOST_CHECK(resumed_edges == uninterrupted_edges);
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
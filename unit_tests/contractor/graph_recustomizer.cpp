@@ -0,0 +1,195 @@
+#include "contractor/graph_recustomizer.hpp"
+
+#include "helper.hpp"
+
+#include "util/chunked_vector.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(graph_recustomizer)
+
+using namespace osrm;
+using namespace osrm::contractor;
+
+namespace
+{
+const constexpr NodeID NUMBER_OF_NODES = 300;
+const constexpr EdgeWeight INVALID = std::numeric_limits<EdgeWeight>::max();
+
+using Adjacency = std::vector<std::vector<std::pair<NodeID, EdgeWeight>>>;
+
+std::vector<EdgeWeight> dijkstra(const Adjacency &adjacency, const NodeID source)
+{
+    std::vector<EdgeWeight> weights(adjacency.size(), INVALID);
+    using HeapEntry = std::pair<EdgeWeight, NodeID>;
+    std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap;
+    weights[source] = 0;
+    heap.emplace(0, source);
+    while (!heap.empty())
+    {
+        const auto entry = heap.top();
+        heap.pop();
+        if (entry.first > weights[entry.second])
+        {
+            continue;
+        }
+        for (const auto &edge : adjacency[entry.second])
+        {
+            if (entry.first + edge.second < weights[edge.first])
+            {
+                weights[edge.first] = entry.first + edge.second;
+                heap.emplace(weights[edge.first], edge.first);
+            }
+        }
+    }
+    return weights;
+}
+
+// The weights of the shortest paths between all nodes of a graph without a core: the upward
+// search from the source meets the upward search from the target, every edge is stored at its
+// lower node with a forward flag for the direction up and a backward flag for the one down.
+std::vector<std::vector<EdgeWeight>> queryWeights(const QueryEdges &edges)
+{
+    Adjacency forward(NUMBER_OF_NODES);
+    Adjacency backward(NUMBER_OF_NODES);
+    for (const auto &edge : edges)
+    {
+        if (edge.data.forward)
+        {
+            forward[edge.source].emplace_back(edge.target, edge.data.distance);
+        }
+        if (edge.data.backward)
+        {
+            backward[edge.source].emplace_back(edge.target, edge.data.distance);
+        }
+    }
+
+    std::vector<std::vector<EdgeWeight>> backward_weights;
+    for (NodeID target = 0; target < NUMBER_OF_NODES; ++target)
+    {
+        backward_weights.push_back(dijkstra(backward, target));
+    }
+
+    std::vector<std::vector<EdgeWeight>> weights(NUMBER_OF_NODES,
+                                                 std::vector<EdgeWeight>(NUMBER_OF_NODES, INVALID));
+    for (NodeID source = 0; source < NUMBER_OF_NODES; ++source)
+    {
+        const auto forward_weights = dijkstra(forward, source);
+        for (NodeID target = 0; target < NUMBER_OF_NODES; ++target)
+        {
+            for (NodeID middle = 0; middle < NUMBER_OF_NODES; ++middle)
+            {
+                if (forward_weights[middle] != INVALID &&
+                    backward_weights[target][middle] != INVALID)
+                {
+                    weights[source][target] =
+                        std::min(weights[source][target],
+                                 forward_weights[middle] + backward_weights[target][middle]);
+                }
+            }
+        }
+    }
+    return weights;
+}
+
+std::vector<std::vector<EdgeWeight>> shortestPathWeights(const EdgeBasedEdges &edges)
+{
+    Adjacency adjacency(NUMBER_OF_NODES);
+    for (const auto &edge : edges)
+    {
+        const EdgeWeight weight = std::max<EdgeWeight>(edge.weight, 1);
+        if (edge.forward)
+        {
+            adjacency[edge.source].emplace_back(edge.target, weight);
+        }
+        if (edge.backward)
+        {
+            adjacency[edge.target].emplace_back(edge.source, weight);
+        }
+    }
+
+    std::vector<std::vector<EdgeWeight>> weights;
+    for (NodeID source = 0; source < NUMBER_OF_NODES; ++source)
+    {
+        weights.push_back(dijkstra(adjacency, source));
+    }
+    return weights;
+}
+
+QueryEdges recustomize(const QueryEdges &previous_edges, const EdgeBasedEdges &edges)
+{
+    util::ChunkedVector<QueryEdge> previous_edge_list;
+    previous_edge_list.append(previous_edges.begin(), previous_edges.end());
+    GraphRecustomizer graph_recustomizer(NUMBER_OF_NODES, previous_edge_list, {});
+    BOOST_CHECK_GT(graph_recustomizer.Run(edges), 0);
+
+    util::ChunkedVector<QueryEdge> recustomized_edges;
+    graph_recustomizer.GetEdges(recustomized_edges);
+    return sortEdges(recustomized_edges);
+}
+}
+
+// A speed file that slows down every road by the same factor keeps all witnesses of the previous
+// contraction, so recustomizing has to give exactly the weights of a new contraction
+BOOST_AUTO_TEST_CASE(same_query_weights_as_contraction)
+{
+    const auto edges = makeGraph(NUMBER_OF_NODES, 1);
+    const auto contracted_edges = contract(NUMBER_OF_NODES, edges);
+
+    auto slower_edges = edges;
+    for (auto &edge : slower_edges)
+    {
+        edge.weight = 3 * edge.weight;
+    }
+    const auto recustomized_weights = queryWeights(recustomize(contracted_edges, slower_edges));
+    const auto contracted_weights = queryWeights(contract(NUMBER_OF_NODES, slower_edges));
+    const auto expected_weights = shortestPathWeights(slower_edges);
+
+    for (NodeID source = 0; source < NUMBER_OF_NODES; ++source)
+    {
+        BOOST_CHECK_EQUAL_COLLECTIONS(recustomized_weights[source].begin(),
+                                      recustomized_weights[source].end(),
+                                      contracted_weights[source].begin(),
+                                      contracted_weights[source].end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(recustomized_weights[source].begin(),
+                                      recustomized_weights[source].end(),
+                                      expected_weights[source].begin(),
+                                      expected_weights[source].end());
+    }
+}
+
+// Other speeds can invalidate witnesses, the recustomized routes are still real paths but may be
+// longer than the ones of a new contraction
+BOOST_AUTO_TEST_CASE(query_weights_bounded_by_contraction)
+{
+    const auto edges = makeGraph(NUMBER_OF_NODES, 2);
+    const auto contracted_edges = contract(NUMBER_OF_NODES, edges);
+
+    auto changed_edges = edges;
+    for (std::size_t index = 0; index < changed_edges.size(); index += 7)
+    {
+        changed_edges[index].weight = 1 + (changed_edges[index].weight * 13) % 200;
+    }
+    const auto recustomized_weights = queryWeights(recustomize(contracted_edges, changed_edges));
+    const auto contracted_weights = queryWeights(contract(NUMBER_OF_NODES, changed_edges));
+
+    for (NodeID source = 0; source < NUMBER_OF_NODES; ++source)
+    {
+        for (NodeID target = 0; target < NUMBER_OF_NODES; ++target)
+        {
+            BOOST_CHECK_GE(recustomized_weights[source][target],
+                           contracted_weights[source][target]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,90 @@
+#ifndef OSRM_TEST_CONTRACTOR_HELPER
+#define OSRM_TEST_CONTRACTOR_HELPER
+
+#include "contractor/graph_contractor.hpp"
+#include "contractor/query_edge.hpp"
+#include "extractor/edge_based_edge.hpp"
+#include "util/chunked_vector.hpp"
+#include "util/typedefs.hpp"
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using EdgeBasedEdges = std::vector<osrm::extractor::EdgeBasedEdge>;
+using QueryEdges = std::vector<osrm::contractor::QueryEdge>;
+
+// A random graph on a ring, every node has three edges to one of the next 50 nodes and half of
+// them are one-ways. The weights are between 1 and 100, the lengths equal the weights.
+inline EdgeBasedEdges makeGraph(const NodeID number_of_nodes, const unsigned seed)
+{
+    std::mt19937 generator(seed);
+    EdgeBasedEdges edges;
+    for (NodeID source = 0; source < number_of_nodes; ++source)
+    {
+        for (NodeID edge = 0; edge < 3; ++edge)
+        {
+            const NodeID target = (source + 1 + generator() % 50) % number_of_nodes;
+            const EdgeWeight weight = 1 + generator() % 100;
+            const bool backward = generator() % 2 == 0;
+            edges.emplace_back(
+                source, target, source * 3 + edge, weight, static_cast<float>(weight), true,
+                backward);
+        }
+    }
+    return edges;
+}
+
+inline osrm::util::ChunkedVector<osrm::extractor::EdgeBasedEdge>
+toChunkedVector(const EdgeBasedEdges &edges)
+{
+    osrm::util::ChunkedVector<osrm::extractor::EdgeBasedEdge> chunked_edges;
+    for (const auto &edge : edges)
+    {
+        chunked_edges.push_back(edge);
+    }
+    return chunked_edges;
+}
+
+// The order of the edges of a contracted graph depends on the order of the insertions, tests
+// compare them sorted by all their fields
+inline QueryEdges sortEdges(const osrm::util::ChunkedVector<osrm::contractor::QueryEdge> &edges)
+{
+    QueryEdges sorted_edges(edges.begin(), edges.end());
+    const auto key = [](const osrm::contractor::QueryEdge &edge) {
+        return std::make_tuple(edge.source,
+                               edge.target,
+                               static_cast<int>(edge.data.distance),
+                               static_cast<NodeID>(edge.data.id),
+                               static_cast<bool>(edge.data.shortcut),
+                               static_cast<bool>(edge.data.forward),
+                               static_cast<bool>(edge.data.backward),
+                               edge.data.length);
+    };
+    std::sort(sorted_edges.begin(),
+              sorted_edges.end(),
+              [&key](const osrm::contractor::QueryEdge &lhs,
+                     const osrm::contractor::QueryEdge &rhs) { return key(lhs) < key(rhs); });
+    return sorted_edges;
+}
+
+// Contracts the graph like osrm-contract and returns the edges it would write to the .hsgr
+inline QueryEdges
+contract(const NodeID number_of_nodes,
+         const EdgeBasedEdges &edges,
+         const double core_factor = 1.0,
+         const osrm::contractor::WitnessSearchConfig &witness_config = {},
+         const osrm::contractor::CheckpointConfig &checkpoint_config = {})
+{
+    auto input_edges = toChunkedVector(edges);
+    osrm::contractor::GraphContractor graph_contractor(
+        number_of_nodes, input_edges, {}, std::vector<EdgeWeight>(number_of_nodes, 0));
+    graph_contractor.Run(core_factor, witness_config, checkpoint_config);
+
+    osrm::util::ChunkedVector<osrm::contractor::QueryEdge> contracted_edges;
+    graph_contractor.GetEdges(contracted_edges);
+    return sortEdges(contracted_edges);
+}
+
+#endif
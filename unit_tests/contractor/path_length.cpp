@@ -0,0 +1,143 @@
+#include "contractor/graph_contractor.hpp"
+
+#include "helper.hpp"
+
+#include "util/typedefs.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(path_length)
+
+using namespace osrm;
+using namespace osrm::contractor;
+
+namespace
+{
+const constexpr NodeID NUMBER_OF_NODES = 300;
+const constexpr EdgeWeight INVALID = std::numeric_limits<EdgeWeight>::max();
+
+struct Arc
+{
+    NodeID target;
+    EdgeWeight weight;
+    float length;
+};
+using Adjacency = std::vector<std::vector<Arc>>;
+
+// weights and the lengths summed up in double along the paths of the smallest weight
+struct Paths
+{
+    std::vector<EdgeWeight> weights;
+    std::vector<double> lengths;
+};
+
+Paths dijkstra(const Adjacency &adjacency, const NodeID source)
+{
+    Paths paths{std::vector<EdgeWeight>(adjacency.size(), INVALID),
+                std::vector<double>(adjacency.size(), 0)};
+    using HeapEntry = std::pair<EdgeWeight, NodeID>;
+    std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap;
+    paths.weights[source] = 0;
+    heap.emplace(0, source);
+    while (!heap.empty())
+    {
+        const auto entry = heap.top();
+        heap.pop();
+        if (entry.first > paths.weights[entry.second])
+        {
+            continue;
+        }
+        for (const auto &arc : adjacency[entry.second])
+        {
+            if (entry.first + arc.weight < paths.weights[arc.target])
+            {
+                paths.weights[arc.target] = entry.first + arc.weight;
+                paths.lengths[arc.target] = paths.lengths[entry.second] + arc.length;
+                heap.emplace(paths.weights[arc.target], arc.target);
+            }
+        }
+    }
+    return paths;
+}
+}
+
+// The lengths of shortcuts are float sums of the lengths of their edges. Summing up the lengths of
+// a packed path gives the length of the unpacked path up to the rounding of these sums.
+BOOST_AUTO_TEST_CASE(packed_path_lengths_close_to_unpacked)
+{
+    auto edges = makeGraph(NUMBER_OF_NODES, 4);
+    for (auto &edge : edges)
+    {
+        edge.length = static_cast<float>(edge.weight * 1.1);
+    }
+    const auto contracted_edges = contract(NUMBER_OF_NODES, edges);
+
+    Adjacency adjacency(NUMBER_OF_NODES);
+    for (const auto &edge : edges)
+    {
+        if (edge.forward)
+        {
+            adjacency[edge.source].push_back({edge.target, edge.weight, edge.length});
+        }
+        if (edge.backward)
+        {
+            adjacency[edge.target].push_back({edge.source, edge.weight, edge.length});
+        }
+    }
+
+    // the upward search from the source meets the upward search from the target
+    Adjacency forward(NUMBER_OF_NODES);
+    Adjacency backward(NUMBER_OF_NODES);
+    for (const auto &edge : contracted_edges)
+    {
+        const Arc arc{edge.target, edge.data.distance, edge.data.length};
+        if (edge.data.forward)
+        {
+            forward[edge.source].push_back(arc);
+        }
+        if (edge.data.backward)
+        {
+            backward[edge.source].push_back(arc);
+        }
+    }
+    std::vector<Paths> backward_paths;
+    for (NodeID target = 0; target < NUMBER_OF_NODES; ++target)
+    {
+        backward_paths.push_back(dijkstra(backward, target));
+    }
+
+    for (NodeID source = 0; source < NUMBER_OF_NODES; ++source)
+    {
+        const auto unpacked_paths = dijkstra(adjacency, source);
+        const auto forward_paths = dijkstra(forward, source);
+        for (NodeID target = 0; target < NUMBER_OF_NODES; ++target)
+        {
+            EdgeWeight weight = INVALID;
+            double length = 0;
+            for (NodeID middle = 0; middle < NUMBER_OF_NODES; ++middle)
+            {
+                const auto &to_target = backward_paths[target];
+                if (forward_paths.weights[middle] != INVALID &&
+                    to_target.weights[middle] != INVALID &&
+                    forward_paths.weights[middle] + to_target.weights[middle] < weight)
+                {
+                    weight = forward_paths.weights[middle] + to_target.weights[middle];
+                    length = forward_paths.lengths[middle] + to_target.lengths[middle];
+                }
+            }
+
+            BOOST_REQUIRE_EQUAL(weight, unpacked_paths.weights[target]);
+            // paths of the same weight have the same length before rounding
+            BOOST_CHECK_CLOSE(length, unpacked_paths.lengths[target], 1e-3);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
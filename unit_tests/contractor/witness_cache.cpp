@@ -0,0 +1,34 @@
+#include "contractor/graph_contractor.hpp"
+
+#include "helper.hpp"
+
+#include "util/typedefs.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(witness_cache)
+
+using namespace osrm;
+using namespace osrm::contractor;
+
+// The cache only skips searches whose witnesses are still valid. Searches that are not limited
+// find a witness as well, so the shortcuts can't change.
+BOOST_AUTO_TEST_CASE(same_shortcuts_as_uncached_contraction)
+{
+    const NodeID number_of_nodes = 1000;
+    const auto edges = makeGraph(number_of_nodes, 3);
+
+    WitnessSearchConfig uncached_config;
+    uncached_config.simulation_settled_nodes = number_of_nodes;
+    uncached_config.contraction_settled_nodes = number_of_nodes;
+    auto cached_config = uncached_config;
+    cached_config.use_cache = true;
+
+    const auto uncached_edges = contract(number_of_nodes, edges, 1.0, uncached_config);
+    const auto cached_edges = contract(number_of_nodes, edges, 1.0, cached_config);
+    BOOST_CHECK_EQUAL(cached_edges.size(), uncached_edges.size());
+    BOOST_CHECK(cached_edges == uncached_edges);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
 
 // RFC 4648 "The Base16, Base32, and Base64 Data Encodings"
@@ -75,4 +76,55 @@ BOOST_AUTO_TEST_CASE(hint_encoding_decoding_roundtrip_bytewise)
                            reinterpret_cast<const unsigned char *>(&decoded)));
 }
 
+BOOST_AUTO_TEST_CASE(binary_roundtrip)
+{
+    using namespace osrm::engine;
+
+    std::string bytes;
+    for (int value = 0; value < 256; ++value)
+    {
+        bytes.push_back(static_cast<char>(value));
+        BOOST_CHECK_EQUAL(decodeBase64(encodeBase64(bytes)), bytes);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(compact_hint_encoding_decoding_roundtrip)
+{
+    using namespace osrm::engine;
+    using namespace osrm::util;
+
+    PhantomNode phantom;
+    phantom.forward_segment_id = {7, true};
+    phantom.reverse_segment_id = {8, false};
+    phantom.fwd_segment_position = 3;
+    phantom.forward_offset = 100;
+    phantom.forward_weight = 20;
+    phantom.reverse_offset = 50;
+    phantom.reverse_weight = INVALID_EDGE_WEIGHT;
+    phantom.location = Coordinate{FloatLongitude{7.419758}, FloatLatitude{43.731142}};
+
+    const Hint hint{phantom, 0x12345678};
+    const auto base64 = hint.ToCompactBase64();
+    BOOST_CHECK_EQUAL(base64.size(), ENCODED_COMPACT_HINT_SIZE);
+    BOOST_CHECK(0 == std::count(begin(base64), end(base64), '+'));
+    BOOST_CHECK(0 == std::count(begin(base64), end(base64), '/'));
+
+    const auto decoded = Hint::FromBase64(base64);
+    BOOST_CHECK_EQUAL(decoded.data_checksum, hint.data_checksum);
+    BOOST_CHECK_EQUAL(decoded.phantom.forward_segment_id.id, 7);
+    BOOST_CHECK(decoded.phantom.forward_segment_id.enabled);
+    BOOST_CHECK_EQUAL(decoded.phantom.reverse_segment_id.id, 8);
+    BOOST_CHECK(!decoded.phantom.reverse_segment_id.enabled);
+    BOOST_CHECK_EQUAL(decoded.phantom.fwd_segment_position, 3);
+    // the weights to the location are kept in the offsets, also the ones of closed directions
+    BOOST_CHECK_EQUAL(decoded.phantom.forward_offset + decoded.phantom.forward_weight, 120);
+    BOOST_CHECK_EQUAL(static_cast<std::uint32_t>(decoded.phantom.reverse_offset) +
+                          static_cast<std::uint32_t>(decoded.phantom.reverse_weight),
+                      static_cast<std::uint32_t>(50) + INVALID_EDGE_WEIGHT);
+
+    // the phantom node itself is rebuilt from the segment
+    BOOST_CHECK(!decoded.phantom.location.IsValid());
+    BOOST_CHECK(!decoded.phantom.IsValid());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,66 @@
+#include "engine/datafacade/block_registry.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(block_registry)
+
+using namespace osrm;
+using namespace osrm::engine::datafacade;
+
+BOOST_AUTO_TEST_CASE(share_equal_contents)
+{
+    BlockRegistry registry;
+    const std::string contents = "the contents of a .names file";
+    const auto key = BlockRegistry::MakeKey(0, ".names", contents.data(), contents.size());
+
+    BOOST_CHECK(!registry.Find<std::vector<char>>(key));
+    const auto first = registry.Share(
+        key, std::make_shared<const std::vector<char>>(contents.begin(), contents.end()));
+    const auto second = registry.Share(
+        key, std::make_shared<const std::vector<char>>(contents.begin(), contents.end()));
+    BOOST_CHECK(first == second);
+    BOOST_CHECK(registry.Find<std::vector<char>>(key) == first);
+    BOOST_CHECK_EQUAL(registry.GetNumberOfBlocks(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(keys_of_other_contents)
+{
+    const std::string contents = "the contents of a .names file";
+    std::string changed = contents;
+    changed.back() = 'F';
+    const auto key = BlockRegistry::MakeKey(0, ".names", contents.data(), contents.size());
+
+    BlockRegistry registry;
+    const auto block = registry.Share(key, std::make_shared<const int>(1));
+    const auto is_shared = [&](const BlockRegistry::Key &other) {
+        return static_cast<bool>(registry.Find<int>(other));
+    };
+    BOOST_CHECK(is_shared(BlockRegistry::MakeKey(0, ".names", contents.data(), contents.size())));
+    BOOST_CHECK(!is_shared(BlockRegistry::MakeKey(0, ".names", changed.data(), changed.size())));
+    BOOST_CHECK(!is_shared(BlockRegistry::MakeKey(0, ".names", contents.data(), 8)));
+    // replicas on other NUMA nodes and blocks of other files are never shared
+    BOOST_CHECK(!is_shared(BlockRegistry::MakeKey(1, ".names", contents.data(), contents.size())));
+    BOOST_CHECK(!is_shared(BlockRegistry::MakeKey(0, ".nodes", contents.data(), contents.size())));
+}
+
+BOOST_AUTO_TEST_CASE(blocks_are_not_owned)
+{
+    BlockRegistry registry;
+    const std::string contents = "12345678";
+    const auto key = BlockRegistry::MakeKey(0, ".geometry", contents.data(), contents.size());
+    {
+        const auto block = registry.Share(key, std::make_shared<const int>(1));
+        BOOST_CHECK_EQUAL(registry.GetNumberOfBlocks(), 1);
+    }
+    // the dataset that held the block is gone
+    BOOST_CHECK_EQUAL(registry.GetNumberOfBlocks(), 0);
+    BOOST_CHECK(!registry.Find<int>(key));
+
+    const auto block = std::make_shared<const int>(2);
+    BOOST_CHECK(registry.Share(key, block) == block);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,79 @@
+#include "engine/routing_algorithms/many_to_many.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(bucket_columns)
+
+using namespace osrm;
+using namespace osrm::engine;
+using namespace osrm::engine::routing_algorithms;
+
+BOOST_AUTO_TEST_CASE(ranges_of_nodes)
+{
+    std::vector<ManyToManyNodeBucket> buckets{
+        {7, 1, 10}, {3, 0, 5}, {7, 0, 12}, {9, 2, 4}, {3, 2, 8}};
+    std::sort(buckets.begin(), buckets.end());
+    const ManyToManyBucketColumns columns(buckets);
+
+    BOOST_CHECK_EQUAL(columns.nodes.size(), 3);
+    BOOST_CHECK(!columns.has_negative_distances);
+
+    const auto range = columns.GetRange(7);
+    BOOST_REQUIRE_EQUAL(range.second - range.first, 2);
+    // ordered by target like the buckets
+    BOOST_CHECK_EQUAL(columns.target_ids[range.first], 0);
+    BOOST_CHECK_EQUAL(columns.distances[range.first], 12);
+    BOOST_CHECK_EQUAL(columns.target_ids[range.first + 1], 1);
+    BOOST_CHECK_EQUAL(columns.distances[range.first + 1], 10);
+
+    const auto last = columns.GetRange(9);
+    BOOST_CHECK_EQUAL(last.second - last.first, 1);
+    BOOST_CHECK_EQUAL(last.second, buckets.size());
+
+    const auto missing = columns.GetRange(5);
+    BOOST_CHECK_EQUAL(missing.first, missing.second);
+    BOOST_CHECK(columns.GetRange(100).first == columns.GetRange(100).second);
+}
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+    const ManyToManyBucketColumns columns(std::vector<ManyToManyNodeBucket>{});
+    const auto range = columns.GetRange(0);
+    BOOST_CHECK_EQUAL(range.first, range.second);
+}
+
+// The backward searches append their buckets target by target, sources and targets on the same
+// node leave several buckets there. Sorted, the buckets of a node come in target order.
+BOOST_AUTO_TEST_CASE(buckets_of_a_node_by_target)
+{
+    std::vector<ManyToManyNodeBucket> buckets;
+    for (const unsigned target_id : {2, 0, 1})
+    {
+        buckets.emplace_back(5, target_id, 10 * target_id);
+        buckets.emplace_back(target_id, target_id, 0);
+    }
+    std::sort(buckets.begin(), buckets.end());
+
+    const auto range = std::equal_range(
+        buckets.begin(), buckets.end(), NodeID{5}, ManyToManyNodeBucket::Compare());
+    BOOST_REQUIRE_EQUAL(range.second - range.first, 3);
+    unsigned target_id = 0;
+    for (auto bucket = range.first; bucket != range.second; ++bucket, ++target_id)
+    {
+        BOOST_CHECK_EQUAL(bucket->middle_node, 5);
+        BOOST_CHECK_EQUAL(bucket->target_id, target_id);
+        BOOST_CHECK_EQUAL(bucket->distance, 10 * target_id);
+    }
+
+    const auto on_target = std::equal_range(
+        buckets.begin(), buckets.end(), NodeID{1}, ManyToManyNodeBucket::Compare());
+    BOOST_REQUIRE_EQUAL(on_target.second - on_target.first, 1);
+    BOOST_CHECK_EQUAL(on_target.first->target_id, 1);
+    BOOST_CHECK_EQUAL(on_target.first->distance, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
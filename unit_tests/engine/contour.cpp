@@ -0,0 +1,117 @@
+#include "engine/contour.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <osrm/coordinate.hpp>
+
+#include <cstdint>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(contour)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+util::Coordinate makeCoordinate(const double lon, const double lat)
+{
+    return util::Coordinate{util::FloatLongitude{lon}, util::FloatLatitude{lat}};
+}
+
+// twice the area, positive for counterclockwise rings
+std::int64_t signedArea(const std::vector<util::Coordinate> &ring)
+{
+    std::int64_t area = 0;
+    for (std::size_t index = 1; index < ring.size(); ++index)
+    {
+        area += std::int64_t{static_cast<std::int32_t>(ring[index - 1].lon)} *
+                    static_cast<std::int32_t>(ring[index].lat) -
+                std::int64_t{static_cast<std::int32_t>(ring[index].lon)} *
+                    static_cast<std::int32_t>(ring[index - 1].lat);
+    }
+    return area;
+}
+
+void checkContains(const std::vector<util::Coordinate> &ring, const util::Coordinate coordinate)
+{
+    const auto lon = static_cast<std::int32_t>(coordinate.lon);
+    const auto lat = static_cast<std::int32_t>(coordinate.lat);
+    bool west = false, east = false, south = false, north = false;
+    for (const auto &corner : ring)
+    {
+        west = west || static_cast<std::int32_t>(corner.lon) < lon;
+        east = east || static_cast<std::int32_t>(corner.lon) > lon;
+        south = south || static_cast<std::int32_t>(corner.lat) < lat;
+        north = north || static_cast<std::int32_t>(corner.lat) > lat;
+    }
+    BOOST_CHECK(west && east && south && north);
+}
+}
+
+BOOST_AUTO_TEST_CASE(no_segments)
+{
+    BOOST_CHECK(makeContour({}, 100).empty());
+}
+
+BOOST_AUTO_TEST_CASE(single_coordinate)
+{
+    const auto coordinate = makeCoordinate(13.4, 52.5);
+    const auto rings = makeContour({{coordinate, coordinate}}, 100);
+    BOOST_REQUIRE_EQUAL(rings.size(), 1);
+    // the cell of the coordinate and its neighbours make a square
+    BOOST_CHECK_EQUAL(rings[0].size(), 5);
+    BOOST_CHECK(rings[0].front() == rings[0].back());
+    BOOST_CHECK_GT(signedArea(rings[0]), 0);
+    checkContains(rings[0], coordinate);
+}
+
+BOOST_AUTO_TEST_CASE(separate_areas)
+{
+    const auto first = makeCoordinate(13.4, 52.5);
+    const auto second = makeCoordinate(13.5, 52.5);
+    const auto rings = makeContour({{first, first}, {second, second}}, 100);
+    BOOST_REQUIRE_EQUAL(rings.size(), 2);
+    for (const auto &ring : rings)
+    {
+        BOOST_CHECK(ring.front() == ring.back());
+        BOOST_CHECK_GT(signedArea(ring), 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(diagonal_road)
+{
+    // the cells of a diagonal road only share a corner, the widening connects them
+    const auto rings =
+        makeContour({{makeCoordinate(13.4, 52.5), makeCoordinate(13.45, 52.53)}}, 100);
+    BOOST_CHECK_EQUAL(rings.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(enclosed_area)
+{
+    // the roads around a block enclose it, the contour has no hole
+    const auto south_west = makeCoordinate(13.40, 52.50);
+    const auto south_east = makeCoordinate(13.43, 52.50);
+    const auto north_east = makeCoordinate(13.43, 52.52);
+    const auto north_west = makeCoordinate(13.40, 52.52);
+    const auto rings = makeContour({{south_west, south_east},
+                                    {south_east, north_east},
+                                    {north_east, north_west},
+                                    {north_west, south_west}},
+                                   100);
+    BOOST_REQUIRE_EQUAL(rings.size(), 1);
+    // a rectangle
+    BOOST_CHECK_EQUAL(rings[0].size(), 5);
+    BOOST_CHECK_GT(signedArea(rings[0]), 0);
+    checkContains(rings[0], makeCoordinate(13.415, 52.51));
+}
+
+BOOST_AUTO_TEST_CASE(large_area)
+{
+    // more than 2048 cells to a side use larger cells
+    const auto rings =
+        makeContour({{makeCoordinate(0., 0.), makeCoordinate(10., 10.)}}, 10);
+    BOOST_CHECK_EQUAL(rings.size(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,8 @@
 
 #include <osrm/coordinate.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 BOOST_AUTO_TEST_SUITE(douglas_peucker_simplification)
@@ -114,4 +116,60 @@ BOOST_AUTO_TEST_CASE(remove_second_node_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(long_geometry_test)
+{
+    // a long and noisy straight line with a detour in its middle
+    const auto size = 2 * detail::DOUGLAS_PEUCKER_RADIAL_FILTER_SIZE;
+    std::vector<util::Coordinate> input;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        const double noise = (i % 2 == 0 ? 1 : -1) * 0.00001;
+        const double detour = i == size / 2 ? 10 : 0;
+        input.push_back(util::Coordinate{util::FloatLongitude{5 + 10. * i / size},
+                                         util::FloatLatitude{5 + noise + detour}});
+    }
+
+    for (unsigned z = 0; z < 15; z++)
+    {
+        auto result = douglasPeucker(input, z);
+        BOOST_CHECK(result.size() >= 3);
+        BOOST_CHECK_EQUAL(result.front(), input.front());
+        BOOST_CHECK_EQUAL(result.back(), input.back());
+        BOOST_CHECK(std::find(result.begin(), result.end(), input[size / 2]) != result.end());
+    }
+    // at z0 the noise is removed in the whole line
+    BOOST_CHECK_EQUAL(douglasPeucker(input, 0).size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(zoom_levels_test)
+{
+    // a winding line that keeps more of its points with every zoom level
+    std::vector<util::Coordinate> input;
+    for (std::size_t i = 0; i < 500; ++i)
+    {
+        const double lon = 5 + 0.01 * i;
+        const double lat = 5 + 0.5 * std::sin(i / 10.) + 0.001 * std::sin(i * 1.7);
+        input.push_back(util::Coordinate{util::FloatLongitude{lon}, util::FloatLatitude{lat}});
+    }
+
+    const auto zoom_levels = douglasPeuckerZoomLevels(input);
+    BOOST_REQUIRE_EQUAL(zoom_levels.size(), input.size());
+    BOOST_CHECK_EQUAL(zoom_levels.front(), 0);
+    BOOST_CHECK_EQUAL(zoom_levels.back(), 0);
+
+    for (unsigned z = 0; z < detail::DOUGLAS_PEUCKER_THRESHOLDS_SIZE; z++)
+    {
+        std::vector<util::Coordinate> kept;
+        for (std::size_t i = 0; i < input.size(); ++i)
+        {
+            if (zoom_levels[i] <= z)
+            {
+                kept.push_back(input[i]);
+            }
+        }
+        const auto result = douglasPeucker(input, z);
+        BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), kept.begin(), kept.end());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
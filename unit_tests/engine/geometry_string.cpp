@@ -44,4 +44,41 @@ BOOST_AUTO_TEST_CASE(decode)
     }
 }
 
+BOOST_AUTO_TEST_CASE(encode)
+{
+    // Example from the documentation of the polyline format
+    const std::vector<util::Coordinate> coords = {
+        {util::FloatLongitude{-120.2}, util::FloatLatitude{38.5}},
+        {util::FloatLongitude{-120.95}, util::FloatLatitude{40.7}},
+        {util::FloatLongitude{-126.453}, util::FloatLatitude{43.252}}};
+
+    BOOST_CHECK_EQUAL(encodePolyline(coords.begin(), coords.end()), "_p~iF~ps|U_ulLnnqC_mqNvxq`@");
+    BOOST_CHECK_EQUAL(encodePolyline<1000000>(coords.begin(), coords.end()),
+                      "_izlhA~rlgdF_{geC~ywl@_kwzCn`{nI");
+    BOOST_CHECK_EQUAL(encodePolyline(coords.begin(), coords.begin()), "");
+}
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+    const std::vector<util::Coordinate> coords = {
+        {util::FixedLongitude{13388860}, util::FixedLatitude{52517037}},
+        {util::FixedLongitude{13388862}, util::FixedLatitude{52517041}},
+        {util::FixedLongitude{-179999999}, util::FixedLatitude{-89999999}},
+        {util::FixedLongitude{180000000}, util::FixedLatitude{90000000}}};
+
+    // polyline6 keeps every digit of a coordinate
+    const auto polyline6 = encodePolyline<1000000>(coords.begin(), coords.end());
+    const auto decoded6 = decodePolyline<1000000>(polyline6);
+    BOOST_CHECK_EQUAL_COLLECTIONS(decoded6.begin(), decoded6.end(), coords.begin(), coords.end());
+
+    // while polyline rounds to five digits
+    const auto decoded = decodePolyline(encodePolyline(coords.begin(), coords.end()));
+    BOOST_REQUIRE_EQUAL(decoded.size(), coords.size());
+    BOOST_CHECK_EQUAL(decoded[0], decoded[1]);
+    BOOST_CHECK_EQUAL(decoded[0].lon, util::FixedLongitude{13388860});
+    BOOST_CHECK_EQUAL(decoded[0].lat, util::FixedLatitude{52517040});
+    BOOST_CHECK_EQUAL(decoded[2].lon, util::FixedLongitude{-180000000});
+    BOOST_CHECK_EQUAL(decoded[3], coords[3]);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
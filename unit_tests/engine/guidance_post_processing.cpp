@@ -0,0 +1,94 @@
+#include "engine/guidance/post_processing.hpp"
+
+#include "extractor/guidance/turn_instruction.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(guidance_post_processing)
+
+using namespace osrm;
+using namespace osrm::engine::guidance;
+using osrm::extractor::guidance::TurnInstruction;
+namespace TurnType = osrm::extractor::guidance::TurnType;
+namespace DirectionModifier = osrm::extractor::guidance::DirectionModifier;
+
+namespace
+{
+RouteStep makeStep(const TurnInstruction instruction,
+                   const WaypointType waypoint_type,
+                   const std::size_t geometry_begin,
+                   const std::size_t geometry_end,
+                   const std::vector<short> &bearings)
+{
+    auto step = getInvalidRouteStep();
+    step.name = "street";
+    step.duration = 10;
+    step.distance = 100;
+    step.mode = TRAVEL_MODE_DRIVING;
+    step.maneuver.instruction = instruction;
+    step.maneuver.waypoint_type = waypoint_type;
+    step.geometry_begin = geometry_begin;
+    step.geometry_end = geometry_end;
+    auto &intersection = step.intersections.front();
+    intersection.bearings = bearings;
+    intersection.entry = std::vector<bool>(bearings.size(), true);
+    intersection.in = 0;
+    intersection.out = bearings.size() - 1;
+    return step;
+}
+}
+
+BOOST_AUTO_TEST_CASE(suppressed_steps_become_intersections)
+{
+    std::vector<RouteStep> steps = {
+        makeStep(TurnInstruction::NO_TURN(), WaypointType::Depart, 0, 2, {90}),
+        makeStep({TurnType::Suppressed, DirectionModifier::Straight},
+                 WaypointType::None,
+                 1,
+                 3,
+                 {270, 90}),
+        makeStep({TurnType::Turn, DirectionModifier::Left}, WaypointType::None, 2, 4, {180, 0}),
+        makeStep(TurnInstruction::NO_TURN(), WaypointType::Arrive, 3, 4, {180})};
+
+    buildIntersections(steps);
+
+    BOOST_REQUIRE_EQUAL(steps.size(), 3);
+    BOOST_CHECK(steps[0].maneuver.waypoint_type == WaypointType::Depart);
+    BOOST_CHECK_EQUAL(steps[0].intersections.size(), 2);
+    BOOST_CHECK_EQUAL(steps[0].geometry_end, 3);
+    BOOST_CHECK_EQUAL(steps[0].distance, 200);
+    BOOST_CHECK_EQUAL(steps[0].duration, 20);
+    BOOST_CHECK(steps[1].maneuver.instruction.type == TurnType::Turn);
+    BOOST_CHECK(steps[2].maneuver.waypoint_type == WaypointType::Arrive);
+}
+
+BOOST_AUTO_TEST_CASE(elongate_in_place)
+{
+    auto step =
+        makeStep({TurnType::Turn, DirectionModifier::Right}, WaypointType::None, 0, 2, {0, 90});
+    const auto next = makeStep({TurnType::Suppressed, DirectionModifier::Straight},
+                               WaypointType::None,
+                               1,
+                               3,
+                               {270, 90});
+
+    elongate(step, next);
+    BOOST_CHECK_EQUAL(step.geometry_begin, 0);
+    BOOST_CHECK_EQUAL(step.geometry_end, 3);
+    BOOST_CHECK_EQUAL(step.intersections.size(), 2);
+    BOOST_CHECK(step.maneuver.instruction.type == TurnType::Turn);
+
+    // a step before is added at the front and takes over the maneuver
+    auto later = makeStep(
+        {TurnType::NewName, DirectionModifier::Straight}, WaypointType::None, 2, 4, {270, 90});
+    elongate(later, step);
+    BOOST_CHECK_EQUAL(later.geometry_begin, 0);
+    BOOST_CHECK_EQUAL(later.geometry_end, 4);
+    BOOST_CHECK_EQUAL(later.intersections.size(), 3);
+    BOOST_CHECK(later.maneuver.instruction.type == TurnType::Turn);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
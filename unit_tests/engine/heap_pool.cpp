@@ -0,0 +1,160 @@
+#include "engine/search_engine_data.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(heap_pool)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+BOOST_AUTO_TEST_CASE(reuse_heaps)
+{
+    SearchEngineHeapPool pool;
+    SearchEngineData data;
+    const SearchEngineData::Heaps *first_heaps = nullptr;
+    {
+        const SearchEngineData::ScopedHeaps heaps(pool);
+        BOOST_CHECK(&SearchEngineData::GetHeapPool() == &pool);
+        data.InitializeOrClearFirstHeaps(100);
+        first_heaps = &SearchEngineData::GetHeaps();
+        BOOST_CHECK(first_heaps->forward_heap_1);
+        BOOST_CHECK(!first_heaps->many_to_many_heap);
+    }
+    BOOST_CHECK(&SearchEngineData::GetHeapPool() == &SearchEngineData::GetDefaultHeapPool());
+    {
+        const SearchEngineData::ScopedHeaps heaps(pool);
+        BOOST_CHECK(&SearchEngineData::GetHeaps() == first_heaps);
+        // the heaps are only cleared, unless they are too small for the graph
+        data.InitializeOrClearFirstHeaps(50);
+        data.InitializeOrClearFirstHeaps(200);
+    }
+
+    const auto statistics = pool.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.checkouts, 2);
+    BOOST_CHECK_EQUAL(statistics.reuses, 1);
+    BOOST_CHECK_EQUAL(statistics.allocations, 4);
+    BOOST_CHECK_EQUAL(statistics.heap_sets, 1);
+    BOOST_CHECK_EQUAL(statistics.heap_sets_in_use, 0);
+}
+
+BOOST_AUTO_TEST_CASE(nested_heaps)
+{
+    SearchEngineHeapPool pool;
+    const SearchEngineData::ScopedHeaps outer(pool);
+    const auto outer_heaps = &SearchEngineData::GetHeaps();
+    {
+        const SearchEngineData::ScopedHeaps inner(pool);
+        BOOST_CHECK(&SearchEngineData::GetHeaps() != outer_heaps);
+        BOOST_CHECK_EQUAL(pool.GetStatistics().heap_sets_in_use, 2);
+    }
+    BOOST_CHECK(&SearchEngineData::GetHeaps() == outer_heaps);
+    BOOST_CHECK_EQUAL(pool.GetStatistics().heap_sets_in_use, 1);
+}
+
+BOOST_AUTO_TEST_CASE(heaps_across_threads)
+{
+    SearchEngineHeapPool pool;
+    SearchEngineData data;
+    {
+        const SearchEngineData::ScopedHeaps heaps(pool);
+        data.InitializeOrClearManyToManyHeap(10);
+    }
+
+    // a query that continues on another thread gets the heaps of the query before it
+    std::thread worker([&] {
+        const SearchEngineData::ScopedHeaps heaps(pool);
+        BOOST_CHECK(SearchEngineData::GetHeaps().many_to_many_heap);
+        data.InitializeOrClearManyToManyHeap(10);
+    });
+    worker.join();
+
+    const auto statistics = pool.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.heap_sets, 1);
+    BOOST_CHECK_EQUAL(statistics.reuses, 1);
+    BOOST_CHECK_EQUAL(statistics.allocations, 1);
+}
+
+BOOST_AUTO_TEST_CASE(heaps_outside_of_queries)
+{
+    SearchEngineData data;
+    data.InitializeOrClearSecondHeaps(10);
+    const auto thread_heaps = &SearchEngineData::GetHeaps();
+    BOOST_CHECK(thread_heaps->forward_heap_2);
+
+    SearchEngineHeapPool pool;
+    {
+        const SearchEngineData::ScopedHeaps heaps(pool);
+        BOOST_CHECK(&SearchEngineData::GetHeaps() != thread_heaps);
+    }
+    BOOST_CHECK(&SearchEngineData::GetHeaps() == thread_heaps);
+}
+
+BOOST_AUTO_TEST_CASE(heap_memory)
+{
+    std::string before;
+    util::QueryMetrics::GetInstance().Render(before);
+    BOOST_CHECK(before.find("\nosrm_heap_memory_bytes ") != std::string::npos);
+
+    SearchEngineData data;
+    {
+        SearchEngineHeapPool pool;
+        const SearchEngineData::ScopedHeaps heaps(pool);
+        data.InitializeOrClearFirstHeaps(100);
+        BOOST_CHECK_EQUAL(SearchEngineData::GetHeaps().memory,
+                          2 * 100 * SearchEngineData::HEAP_BYTES_PER_NODE);
+        // a grown heap replaces the memory of the old one
+        data.InitializeOrClearFirstHeaps(300);
+        BOOST_CHECK_EQUAL(SearchEngineData::GetHeaps().memory,
+                          2 * 300 * SearchEngineData::HEAP_BYTES_PER_NODE);
+    }
+    // the heaps are freed with their pool
+    std::string after;
+    util::QueryMetrics::GetInstance().Render(after);
+    BOOST_CHECK_EQUAL(after.substr(after.find("\nosrm_heap_memory_bytes ")),
+                      before.substr(before.find("\nosrm_heap_memory_bytes ")));
+}
+
+BOOST_AUTO_TEST_CASE(query_memory)
+{
+    // not part of a query
+    BOOST_CHECK(SearchEngineData::ReserveQueryMemory(1ul << 40));
+
+    {
+        const SearchEngineData::ScopedQueryMemory memory(util::QueryMetrics::Service::Isochrone,
+                                                         1000);
+        BOOST_CHECK(SearchEngineData::ReserveQueryMemory(600));
+        BOOST_CHECK(SearchEngineData::ReserveQueryMemory(400));
+        BOOST_CHECK(!SearchEngineData::ReserveQueryMemory(1));
+
+        std::string metrics;
+        util::QueryMetrics::GetInstance().Render(metrics);
+        BOOST_CHECK(metrics.find("\nosrm_query_memory_bytes{service=\"isochrone\"} 1000\n") !=
+                    std::string::npos);
+    }
+    {
+        const SearchEngineData::ScopedQueryMemory memory(util::QueryMetrics::Service::Isochrone,
+                                                         1000);
+        BOOST_CHECK(SearchEngineData::ReserveQueryMemory(200));
+
+        std::string metrics;
+        util::QueryMetrics::GetInstance().Render(metrics);
+        BOOST_CHECK(metrics.find("\nosrm_query_memory_bytes{service=\"isochrone\"} 200\n") !=
+                    std::string::npos);
+    }
+
+    std::string metrics;
+    util::QueryMetrics::GetInstance().Render(metrics);
+    const std::string service = "{service=\"isochrone\"} ";
+    BOOST_CHECK(metrics.find("\nosrm_query_memory_bytes" + service + "0\n") != std::string::npos);
+    BOOST_CHECK(metrics.find("\nosrm_query_memory_peak_bytes" + service + "1000\n") !=
+                std::string::npos);
+    BOOST_CHECK(metrics.find("\nosrm_query_memory_bytes_total" + service + "1200\n") !=
+                std::string::npos);
+    BOOST_CHECK(metrics.find("\nosrm_query_memory_rejections_total" + service + "1\n") !=
+                std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,74 @@
+#include "engine/map_matching/hidden_markov_model.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(hidden_markov_model)
+
+using namespace osrm;
+using namespace osrm::engine::map_matching;
+
+namespace
+{
+// only the number of candidates of a timestamp matters for the layout
+using CandidateLists = std::vector<std::vector<int>>;
+}
+
+BOOST_AUTO_TEST_CASE(flat_columns)
+{
+    HiddenMarkovModel model;
+    model.Reset(CandidateLists{{1, 2}, {}, {1, 2, 3}});
+
+    BOOST_CHECK_EQUAL(model.GetNumberOfTimestamps(), 3);
+    BOOST_CHECK_EQUAL(model.viterbi.size(), 5);
+    BOOST_CHECK_EQUAL(model.GetColumn(model.viterbi, 0).size(), 2);
+    BOOST_CHECK_EQUAL(model.GetColumn(model.viterbi, 1).size(), 0);
+    BOOST_CHECK_EQUAL(model.GetColumn(model.viterbi, 2).size(), 3);
+
+    model.GetColumn(model.viterbi, 2)[1] = -1.;
+    BOOST_CHECK_EQUAL(model.viterbi[3], -1.);
+    for (const auto pruned : model.pruned)
+    {
+        BOOST_CHECK(pruned);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(initialize_skips_broken_timestamps)
+{
+    HiddenMarkovModel model;
+    model.Reset(CandidateLists{{1}, {1, 2}, {1}});
+    model.emission_log_probabilities = {IMPOSSIBLE_LOG_PROB, -1.f, -2.f, -3.f};
+
+    // the first timestamp has no viable candidate
+    BOOST_CHECK_EQUAL(model.initialize(0), 1);
+    BOOST_CHECK(model.breakage[0]);
+    BOOST_CHECK(!model.breakage[1]);
+    const auto parents = model.GetColumn(model.parents, 1);
+    BOOST_CHECK_EQUAL(parents[1].first, 1);
+    BOOST_CHECK_EQUAL(parents[1].second, 1);
+    BOOST_CHECK_EQUAL(model.GetColumn(model.viterbi, 1)[1], -2.);
+
+    // clearing keeps the timestamps before
+    model.Clear(2);
+    BOOST_CHECK(!model.breakage[1]);
+    BOOST_CHECK(model.breakage[2]);
+    BOOST_CHECK_EQUAL(model.viterbi[3], IMPOSSIBLE_LOG_PROB);
+}
+
+BOOST_AUTO_TEST_CASE(reuse_for_shorter_traces)
+{
+    HiddenMarkovModel model;
+    model.Reset(CandidateLists(100, std::vector<int>(3)));
+    model.viterbi[0] = 0.;
+
+    model.Reset(CandidateLists{{1}, {1}});
+    BOOST_CHECK_EQUAL(model.GetNumberOfTimestamps(), 2);
+    BOOST_CHECK_EQUAL(model.viterbi.size(), 2);
+    BOOST_CHECK_EQUAL(model.viterbi[0], IMPOSSIBLE_LOG_PROB);
+    BOOST_CHECK_GE(model.viterbi.capacity(), 300);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,154 @@
+#include "contractor/hub_labels.hpp"
+#include "contractor/query_edge.hpp"
+#include "engine/hub_labels.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(hub_labels)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+contractor::QueryEdge makeEdge(const NodeID source,
+                               const NodeID target,
+                               const EdgeWeight weight,
+                               const bool forward,
+                               const bool backward)
+{
+    contractor::QueryEdge::EdgeData data;
+    data.distance = weight;
+    data.forward = forward;
+    data.backward = backward;
+    return {source, target, data};
+}
+
+HubLabel getLabel(const contractor::HubLabels &labels, const NodeID node, const bool forward)
+{
+    const auto index = 2 * node + (forward ? 0 : 1);
+    const auto begin = labels.offsets[index];
+    return {labels.hubs.data() + begin,
+            labels.weights.data() + begin,
+            labels.offsets[index + 1] - begin};
+}
+
+EdgeWeight query(const contractor::HubLabels &labels, const NodeID source, const NodeID target)
+{
+    return queryHubLabels(getLabel(labels, source, true), getLabel(labels, target, false));
+}
+}
+
+BOOST_AUTO_TEST_CASE(intersect_labels)
+{
+    const std::vector<NodeID> forward_hubs = {1, 4, 6, 9};
+    const std::vector<EdgeWeight> forward_weights = {10, 3, 8, 1};
+    const std::vector<NodeID> backward_hubs = {2, 4, 9, 11};
+    const std::vector<EdgeWeight> backward_weights = {1, 5, 9, 1};
+    const HubLabel forward{forward_hubs.data(), forward_weights.data(), forward_hubs.size()};
+    const HubLabel backward{backward_hubs.data(), backward_weights.data(), backward_hubs.size()};
+    // through hub 4 (3 + 5) rather than hub 9 (1 + 9)
+    BOOST_CHECK_EQUAL(queryHubLabels(forward, backward), 8);
+
+    const std::vector<NodeID> other_hubs = {0, 5, 12};
+    const std::vector<EdgeWeight> other_weights = {1, 1, 1};
+    const HubLabel other{other_hubs.data(), other_weights.data(), other_hubs.size()};
+    BOOST_CHECK_EQUAL(queryHubLabels(forward, other), INVALID_EDGE_WEIGHT);
+    BOOST_CHECK_EQUAL(queryHubLabels(forward, HubLabel{}), INVALID_EDGE_WEIGHT);
+}
+
+BOOST_AUTO_TEST_CASE(contracted_path)
+{
+    // 0 - 1 - 2 - 3 - 4 contracted in the order 0, 2, 4, 1, 3 with the shortcut 1 -> 3,
+    // the edges of 1 - 2 are one-way towards 2
+    const std::vector<contractor::QueryEdge> edges = {makeEdge(0, 1, 2, true, true),
+                                                      makeEdge(2, 1, 3, false, true),
+                                                      makeEdge(2, 3, 4, true, true),
+                                                      makeEdge(4, 3, 1, true, true),
+                                                      makeEdge(1, 3, 7, true, false)};
+    const auto labels = contractor::computeHubLabels(edges, 5);
+    BOOST_REQUIRE_EQUAL(labels.offsets.size(), 11);
+
+    BOOST_CHECK_EQUAL(query(labels, 0, 4), 2 + 3 + 4 + 1);
+    BOOST_CHECK_EQUAL(query(labels, 1, 2), 3);
+    BOOST_CHECK_EQUAL(query(labels, 3, 3), 0);
+    BOOST_CHECK_EQUAL(query(labels, 2, 0), INVALID_EDGE_WEIGHT);
+    BOOST_CHECK_EQUAL(query(labels, 4, 2), 5);
+
+    for (const auto index : util::irange<std::size_t>(0, 10))
+    {
+        BOOST_CHECK(std::is_sorted(labels.hubs.begin() + labels.offsets[index],
+                                   labels.hubs.begin() + labels.offsets[index + 1]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(random_hierarchy)
+{
+    // A hierarchy of the shortest distances between all nodes is correct for every order,
+    // here the order of their ids
+    const NodeID number_of_nodes = 60;
+    std::mt19937 generator(23);
+    std::vector<EdgeWeight> distances(number_of_nodes * number_of_nodes, INVALID_EDGE_WEIGHT);
+    for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+    {
+        distances[node * number_of_nodes + node] = 0;
+        for (int edge = 0; edge < 3; ++edge)
+        {
+            const NodeID target = generator() % number_of_nodes;
+            auto &distance = distances[node * number_of_nodes + target];
+            distance = std::min<EdgeWeight>(distance, 1 + generator() % 50);
+        }
+    }
+    for (const auto via : util::irange<NodeID>(0, number_of_nodes))
+    {
+        for (const auto from : util::irange<NodeID>(0, number_of_nodes))
+        {
+            for (const auto to : util::irange<NodeID>(0, number_of_nodes))
+            {
+                const auto first = distances[from * number_of_nodes + via];
+                const auto second = distances[via * number_of_nodes + to];
+                if (first != INVALID_EDGE_WEIGHT && second != INVALID_EDGE_WEIGHT)
+                {
+                    auto &distance = distances[from * number_of_nodes + to];
+                    distance = std::min(distance, first + second);
+                }
+            }
+        }
+    }
+
+    std::vector<contractor::QueryEdge> edges;
+    for (const auto lower : util::irange<NodeID>(0, number_of_nodes))
+    {
+        for (const auto upper : util::irange<NodeID>(lower + 1, number_of_nodes))
+        {
+            const auto up = distances[lower * number_of_nodes + upper];
+            const auto down = distances[upper * number_of_nodes + lower];
+            if (up != INVALID_EDGE_WEIGHT)
+            {
+                edges.push_back(makeEdge(lower, upper, up, true, false));
+            }
+            if (down != INVALID_EDGE_WEIGHT)
+            {
+                edges.push_back(makeEdge(lower, upper, down, false, true));
+            }
+        }
+    }
+
+    const auto labels = contractor::computeHubLabels(edges, number_of_nodes);
+    // the top of the hierarchy only has itself
+    BOOST_CHECK_EQUAL(labels.offsets[2 * number_of_nodes] - labels.offsets[2 * number_of_nodes - 2],
+                      2);
+    for (const auto from : util::irange<NodeID>(0, number_of_nodes))
+    {
+        for (const auto to : util::irange<NodeID>(0, number_of_nodes))
+        {
+            BOOST_CHECK_EQUAL(query(labels, from, to), distances[from * number_of_nodes + to]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
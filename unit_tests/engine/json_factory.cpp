@@ -1,8 +1,12 @@
 #include "engine/api/json_factory.hpp"
+#include "util/json_renderer.hpp"
 
 #include <boost/test/test_case_template.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <string>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(json_factory)
 
 BOOST_AUTO_TEST_CASE(instructionTypeToString_test_size)
@@ -13,4 +17,50 @@ BOOST_AUTO_TEST_CASE(instructionTypeToString_test_size)
     BOOST_CHECK_EQUAL(instructionTypeToString(TurnType::Sliproad), "invalid");
 }
 
+BOOST_AUTO_TEST_CASE(geojson_geometry_like_arrays)
+{
+    using namespace osrm;
+    using namespace osrm::engine::api::json;
+
+    const std::vector<util::Coordinate> coordinates = {
+        {util::FloatLongitude{13.38886}, util::FloatLatitude{52.517037}},
+        {util::FloatLongitude{-0.000001}, util::FloatLatitude{0}},
+        {util::FloatLongitude{-179.999999}, util::FloatLatitude{-85.5}}};
+
+    util::json::Array reference;
+    for (const auto coordinate : coordinates)
+    {
+        reference.values.push_back(detail::coordinateToLonLat(coordinate));
+    }
+    std::string reference_text;
+    util::json::ArrayRenderer<std::string>{reference_text}(reference);
+
+    // the library gets Arrays, the renderers write the same text
+    const auto geometry = makeGeoJSONGeometry(coordinates.begin(), coordinates.end());
+    BOOST_CHECK_EQUAL(geometry.values.at("type").get<util::json::String>().value, "LineString");
+    std::string geometry_text;
+    util::json::ArrayRenderer<std::string>{geometry_text}(
+        geometry.values.at("coordinates").get<util::json::Array>());
+    BOOST_CHECK_EQUAL(geometry_text, reference_text);
+
+    const auto rendered_geometry =
+        makeGeoJSONGeometry(coordinates.begin(), coordinates.end(), true);
+    BOOST_CHECK_EQUAL(rendered_geometry.values.at("coordinates").get<util::json::RawJSON>().value,
+                      reference_text);
+
+    const auto point = makeGeoJSONGeometry(coordinates.begin(), coordinates.begin() + 1, true);
+    BOOST_CHECK_EQUAL(point.values.at("type").get<util::json::String>().value, "Point");
+    BOOST_CHECK_EQUAL(point.values.at("coordinates").get<util::json::RawJSON>().value,
+                      "[[13.38886,52.517037]]");
+
+    const std::vector<double> durations = {0, 1.5, 12.25, 0.1};
+    const auto identity = [](const double value) { return value; };
+    const auto numbers = makeNumberArray(durations.begin(), durations.end(), identity);
+    BOOST_REQUIRE_EQUAL(numbers.values.size(), durations.size());
+    BOOST_CHECK_EQUAL(numbers.values[1].get<util::json::Number>().value, 1.5);
+    BOOST_CHECK_EQUAL(renderNumberArray(durations.begin(), durations.end(), identity).value,
+                      "[0,1.5,12.25,0.1]");
+    BOOST_CHECK_EQUAL(renderNumberArray(durations.end(), durations.end(), identity).value, "[]");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
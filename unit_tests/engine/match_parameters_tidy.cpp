@@ -0,0 +1,87 @@
+#include "engine/api/match_parameters_tidy.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(match_parameters_tidy)
+
+using namespace osrm;
+using namespace osrm::engine::api;
+
+namespace
+{
+// points along a meridian, a millionth of a degree is about 0.11 meters
+MatchParameters makeTrace(const std::vector<int> &microdegrees, std::vector<unsigned> timestamps)
+{
+    MatchParameters parameters;
+    for (const auto latitude : microdegrees)
+    {
+        parameters.coordinates.push_back(util::Coordinate{
+            util::FixedLongitude{13000000}, util::FixedLatitude{52000000 + latitude}});
+        parameters.radiuses.push_back(boost::make_optional<double>(latitude));
+    }
+    parameters.timestamps = std::move(timestamps);
+    return parameters;
+}
+}
+
+BOOST_AUTO_TEST_CASE(thin_by_distance)
+{
+    // a point about every 2.2 meters
+    std::vector<int> microdegrees;
+    for (int index = 0; index < 20; ++index)
+    {
+        microdegrees.push_back(index * 20);
+    }
+    const auto result = tidy::tidy(makeTrace(microdegrees, {}));
+
+    // every fifth point is more than 10 meters from the one kept before, and the last point
+    const std::vector<unsigned> reference = {0, 5, 10, 15, 19};
+    BOOST_CHECK_EQUAL_COLLECTIONS(result.original_indices.begin(),
+                                  result.original_indices.end(),
+                                  reference.begin(),
+                                  reference.end());
+    BOOST_REQUIRE_EQUAL(result.parameters.coordinates.size(), reference.size());
+    BOOST_REQUIRE_EQUAL(result.parameters.radiuses.size(), reference.size());
+    for (const auto index : util::irange<std::size_t>(0, reference.size()))
+    {
+        BOOST_CHECK_EQUAL(*result.parameters.radiuses[index], microdegrees[reference[index]]);
+    }
+    BOOST_CHECK(result.parameters.timestamps.empty());
+    BOOST_CHECK(result.parameters.IsValid());
+}
+
+BOOST_AUTO_TEST_CASE(merge_stationary_points)
+{
+    // standing still for 12 seconds at 10 Hz, then moving on
+    std::vector<int> microdegrees(120, 0);
+    std::vector<unsigned> timestamps;
+    for (unsigned index = 0; index < 120; ++index)
+    {
+        timestamps.push_back(1000 + index / 10);
+    }
+    microdegrees.push_back(1000);
+    timestamps.push_back(1013);
+
+    const auto result = tidy::tidy(makeTrace(microdegrees, timestamps));
+    // a point every 5 seconds and the one after the stop
+    const std::vector<unsigned> reference = {0, 50, 100, 120};
+    BOOST_CHECK_EQUAL_COLLECTIONS(result.original_indices.begin(),
+                                  result.original_indices.end(),
+                                  reference.begin(),
+                                  reference.end());
+    const std::vector<unsigned> reference_timestamps = {1000, 1005, 1010, 1013};
+    BOOST_CHECK_EQUAL_COLLECTIONS(result.parameters.timestamps.begin(),
+                                  result.parameters.timestamps.end(),
+                                  reference_timestamps.begin(),
+                                  reference_timestamps.end());
+}
+
+BOOST_AUTO_TEST_CASE(keep_short_traces)
+{
+    const auto result = tidy::tidy(makeTrace({0, 1}, {}));
+    BOOST_CHECK_EQUAL(result.original_indices.size(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
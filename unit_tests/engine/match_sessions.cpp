@@ -0,0 +1,74 @@
+#include "engine/match_sessions.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(match_sessions)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+BOOST_AUTO_TEST_CASE(get_and_remove)
+{
+    MatchSessions sessions(4);
+
+    const auto session = sessions.Get("a");
+    BOOST_REQUIRE(session);
+    session->number_of_points = 3;
+    BOOST_CHECK_EQUAL(sessions.Get("a"), session);
+    BOOST_CHECK(sessions.Get("b") != session);
+    BOOST_CHECK_EQUAL(sessions.GetNumberOfSessions(), 2);
+
+    sessions.Remove("a", session);
+    BOOST_CHECK_EQUAL(sessions.GetNumberOfSessions(), 1);
+    const auto new_session = sessions.Get("a");
+    BOOST_CHECK(new_session != session);
+    BOOST_CHECK_EQUAL(new_session->number_of_points, 0);
+    BOOST_CHECK_EQUAL(sessions.GetNumberOfCreatedSessions(), 3);
+    BOOST_CHECK_EQUAL(sessions.GetNumberOfEvictedSessions(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(remove_only_the_same_session)
+{
+    MatchSessions sessions(1);
+
+    const auto session = sessions.Get("a");
+    // evicted by b, the a that comes after is a new one
+    sessions.Get("b");
+    const auto new_session = sessions.Get("a");
+    sessions.Remove("a", session);
+    BOOST_CHECK_EQUAL(sessions.Get("a"), new_session);
+}
+
+BOOST_AUTO_TEST_CASE(bounded_number_of_sessions)
+{
+    MatchSessions sessions(2);
+
+    const auto a = sessions.Get("a");
+    sessions.Get("b");
+    // a is used more recently than b
+    sessions.Get("a");
+    sessions.Get("c");
+
+    BOOST_CHECK_EQUAL(sessions.GetNumberOfSessions(), 2);
+    BOOST_CHECK_EQUAL(sessions.GetNumberOfEvictedSessions(), 1);
+    BOOST_CHECK_EQUAL(sessions.Get("a"), a);
+    BOOST_CHECK_EQUAL(sessions.GetNumberOfCreatedSessions(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(clear_keeps_the_trace_indices)
+{
+    map_matching::MatchSession session;
+    session.number_of_points = 5;
+    session.first_index = 2;
+    session.frontier = 4;
+    session.points.resize(3);
+
+    session.Clear();
+    BOOST_CHECK(session.points.empty());
+    BOOST_CHECK_EQUAL(session.first_index, 5);
+    BOOST_CHECK_EQUAL(session.final_end, 5);
+    BOOST_CHECK_EQUAL(session.frontier, map_matching::INVALID_STATE);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,94 @@
+#include "engine/search_engine_data.hpp"
+#include "engine/trip/trip_held_karp.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(query_control)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+BOOST_AUTO_TEST_CASE(no_query_control)
+{
+    BOOST_CHECK(SearchEngineData::GetQueryControl() == nullptr);
+    BOOST_CHECK_NO_THROW(SearchEngineData::CheckQueryControl());
+    for (auto poll = 0; poll < 10000; ++poll)
+    {
+        SearchEngineData::PollQueryControl();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(cancelled_query)
+{
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    AsyncOptions options;
+    options.cancelled = cancelled;
+
+    const SearchEngineData::ScopedQueryControl control(options);
+    BOOST_CHECK(SearchEngineData::GetQueryControl() == &options);
+    BOOST_CHECK_NO_THROW(SearchEngineData::CheckQueryControl());
+
+    cancelled->store(true);
+    try
+    {
+        SearchEngineData::CheckQueryControl();
+        BOOST_FAIL("the query was cancelled");
+    }
+    catch (const QueryAborted &aborted)
+    {
+        BOOST_CHECK(aborted.status == Status::Error);
+        BOOST_CHECK_EQUAL(aborted.code, "Cancelled");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(polled_deadline)
+{
+    AsyncOptions options;
+    options.deadline = std::chrono::steady_clock::now() - std::chrono::milliseconds(1);
+
+    {
+        const SearchEngineData::ScopedQueryControl control(options);
+        // the deadline is only checked every few polls
+        std::size_t polls = 0;
+        try
+        {
+            for (; polls < 10000; ++polls)
+            {
+                SearchEngineData::PollQueryControl();
+            }
+        }
+        catch (const QueryAborted &aborted)
+        {
+            BOOST_CHECK(aborted.status == Status::Timeout);
+            BOOST_CHECK_EQUAL(aborted.code, "Timeout");
+        }
+        BOOST_CHECK_LT(polls, 10000);
+    }
+    // the options of the query are gone with it
+    BOOST_CHECK(SearchEngineData::GetQueryControl() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(aborted_trip)
+{
+    const std::size_t number_of_locations = 8;
+    std::vector<EdgeWeight> durations(number_of_locations * number_of_locations, 1);
+    const util::DistTableWrapper<EdgeWeight> table(std::move(durations), number_of_locations);
+    std::vector<NodeID> locations(number_of_locations);
+    std::iota(locations.begin(), locations.end(), 0);
+
+    AsyncOptions options;
+    options.cancelled = std::make_shared<const std::atomic<bool>>(true);
+    const SearchEngineData::ScopedQueryControl control(options);
+    BOOST_CHECK_THROW(
+        trip::HeldKarpTrip(locations.begin(), locations.end(), number_of_locations, table),
+        QueryAborted);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
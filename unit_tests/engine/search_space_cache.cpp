@@ -0,0 +1,114 @@
+#include "engine/search_space_cache.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(search_space_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+PhantomNode makePhantomNode(const NodeID segment_id, const int forward_offset)
+{
+    PhantomNode phantom;
+    phantom.forward_segment_id = {segment_id, true};
+    phantom.reverse_segment_id = {segment_id + 1, true};
+    phantom.forward_weight = 10;
+    phantom.reverse_weight = 20;
+    phantom.forward_offset = forward_offset;
+    phantom.reverse_offset = 0;
+    return phantom;
+}
+
+SearchSpaceCache::SearchSpacePtr makeSearchSpace(const NodeID node)
+{
+    return std::make_shared<const SearchSpaceCache::SearchSpace>(
+        SearchSpaceCache::SearchSpace{{node, 0, node}, {node + 2, 5, node}});
+}
+}
+
+BOOST_AUTO_TEST_CASE(hit_and_miss)
+{
+    SearchSpaceCache cache(64);
+    const SearchSpaceCache::Key key(makePhantomNode(1, 0), true);
+
+    BOOST_CHECK(!cache.Get(0, key));
+    cache.Add(0, key, makeSearchSpace(1));
+
+    const auto search_space = cache.Get(0, key);
+    BOOST_REQUIRE(search_space);
+    BOOST_REQUIRE_EQUAL(search_space->size(), 2);
+    BOOST_CHECK_EQUAL(search_space->back().node, 3);
+    BOOST_CHECK_EQUAL(search_space->back().distance, 5);
+    BOOST_CHECK_EQUAL(search_space->back().parent, 1);
+
+    BOOST_CHECK_EQUAL(cache.GetNumberOfHits(), 1);
+    BOOST_CHECK_EQUAL(cache.GetNumberOfMisses(), 1);
+    BOOST_CHECK_CLOSE(cache.GetHitRate(), 0.5, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(key_includes_offsets_and_direction)
+{
+    SearchSpaceCache cache(64);
+    cache.Add(0, SearchSpaceCache::Key(makePhantomNode(1, 0), true), makeSearchSpace(1));
+
+    // the same segments snapped at another offset
+    BOOST_CHECK(!cache.Get(0, SearchSpaceCache::Key(makePhantomNode(1, 3), true)));
+    // the search towards the phantom node
+    BOOST_CHECK(!cache.Get(0, SearchSpaceCache::Key(makePhantomNode(1, 0), false)));
+
+    auto one_way = makePhantomNode(1, 0);
+    one_way.reverse_segment_id = {SPECIAL_SEGMENTID, false};
+    BOOST_CHECK(!cache.Get(0, SearchSpaceCache::Key(one_way, true)));
+
+    BOOST_CHECK(cache.Get(0, SearchSpaceCache::Key(makePhantomNode(1, 0), true)));
+}
+
+BOOST_AUTO_TEST_CASE(evicts_least_recently_used)
+{
+    // 16 shards with one entry each, so 17 search spaces can't all stay
+    SearchSpaceCache cache(16);
+    const auto evicted_candidate = makeSearchSpace(1);
+    for (NodeID segment_id = 0; segment_id < 17; ++segment_id)
+    {
+        cache.Add(0,
+                  SearchSpaceCache::Key(makePhantomNode(2 * segment_id, 0), true),
+                  segment_id == 0 ? evicted_candidate : makeSearchSpace(2 * segment_id));
+    }
+
+    std::size_t number_of_cached = 0;
+    for (NodeID segment_id = 0; segment_id < 17; ++segment_id)
+    {
+        number_of_cached +=
+            cache.Get(0, SearchSpaceCache::Key(makePhantomNode(2 * segment_id, 0), true)) !=
+            nullptr;
+    }
+    BOOST_CHECK_LT(number_of_cached, 17);
+    // the last search space is the most recently used one of its shard
+    BOOST_CHECK(cache.Get(0, SearchSpaceCache::Key(makePhantomNode(32, 0), true)));
+
+    // search spaces handed out before stay valid
+    BOOST_CHECK_EQUAL(evicted_candidate->front().node, 1);
+}
+
+BOOST_AUTO_TEST_CASE(new_data_version_invalidates)
+{
+    SearchSpaceCache cache(64);
+    const SearchSpaceCache::Key key(makePhantomNode(1, 0), false);
+
+    cache.Add(0, key, makeSearchSpace(1));
+    BOOST_CHECK(cache.Get(0, key));
+    BOOST_CHECK(!cache.Get(1, key));
+
+    cache.Add(1, key, makeSearchSpace(7));
+    const auto search_space = cache.Get(1, key);
+    BOOST_REQUIRE(search_space);
+    BOOST_CHECK_EQUAL(search_space->front().node, 7);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,105 @@
+#include "engine/snapping_cache.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+
+BOOST_AUTO_TEST_SUITE(snapping_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+util::Coordinate makeCoordinate(const int index)
+{
+    return {util::FixedLongitude{7000000 + index}, util::FixedLatitude{50000000 + index}};
+}
+
+PhantomNodePair makePhantomNodes(const unsigned name_id)
+{
+    PhantomNodePair phantom_nodes;
+    phantom_nodes.first.name_id = name_id;
+    phantom_nodes.second.name_id = name_id + 1;
+    return phantom_nodes;
+}
+}
+
+BOOST_AUTO_TEST_CASE(hit_and_miss)
+{
+    SnappingCache cache(64);
+    const SnappingCache::Key key{makeCoordinate(0), boost::none};
+
+    PhantomNodePair phantom_nodes;
+    BOOST_CHECK(!cache.Get(0, key, phantom_nodes));
+    cache.Add(0, key, makePhantomNodes(3));
+
+    BOOST_REQUIRE(cache.Get(0, key, phantom_nodes));
+    BOOST_CHECK_EQUAL(phantom_nodes.first.name_id, 3);
+    BOOST_CHECK_EQUAL(phantom_nodes.second.name_id, 4);
+
+    BOOST_CHECK_EQUAL(cache.GetNumberOfHits(), 1);
+    BOOST_CHECK_EQUAL(cache.GetNumberOfMisses(), 1);
+    BOOST_CHECK_CLOSE(cache.GetHitRate(), 0.5, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(key_includes_bearing_and_radius)
+{
+    SnappingCache cache(64);
+    const auto coordinate = makeCoordinate(0);
+    cache.Add(0, {coordinate, boost::none}, makePhantomNodes(1));
+    cache.Add(0, {coordinate, 20.}, makePhantomNodes(2));
+    cache.Add(0, {coordinate, boost::none, 90, 10}, makePhantomNodes(3));
+    cache.Add(0, {coordinate, boost::none, 90, 20}, makePhantomNodes(4));
+
+    PhantomNodePair phantom_nodes;
+    BOOST_REQUIRE(cache.Get(0, {coordinate, boost::none}, phantom_nodes));
+    BOOST_CHECK_EQUAL(phantom_nodes.first.name_id, 1);
+    BOOST_REQUIRE(cache.Get(0, {coordinate, 20.}, phantom_nodes));
+    BOOST_CHECK_EQUAL(phantom_nodes.first.name_id, 2);
+    BOOST_REQUIRE(cache.Get(0, {coordinate, boost::none, 90, 10}, phantom_nodes));
+    BOOST_CHECK_EQUAL(phantom_nodes.first.name_id, 3);
+    BOOST_REQUIRE(cache.Get(0, {coordinate, boost::none, 90, 20}, phantom_nodes));
+    BOOST_CHECK_EQUAL(phantom_nodes.first.name_id, 4);
+
+    BOOST_CHECK(!cache.Get(0, {coordinate, 30.}, phantom_nodes));
+    BOOST_CHECK(!cache.Get(0, {makeCoordinate(1), boost::none}, phantom_nodes));
+}
+
+BOOST_AUTO_TEST_CASE(bounded_size)
+{
+    // 16 shards with one entry each
+    SnappingCache cache(16);
+
+    PhantomNodePair phantom_nodes;
+    for (int index = 0; index < 100; ++index)
+    {
+        const SnappingCache::Key key{makeCoordinate(index), boost::none};
+        cache.Add(0, key, makePhantomNodes(index));
+        // the last coordinate is always kept
+        BOOST_CHECK(cache.Get(0, key, phantom_nodes));
+    }
+
+    std::size_t number_of_cached = 0;
+    for (int index = 0; index < 100; ++index)
+    {
+        number_of_cached += cache.Get(0, {makeCoordinate(index), boost::none}, phantom_nodes);
+    }
+    BOOST_CHECK_LE(number_of_cached, 16);
+    BOOST_CHECK_GT(number_of_cached, 0);
+}
+
+BOOST_AUTO_TEST_CASE(new_checksum_invalidates)
+{
+    SnappingCache cache(64);
+    const SnappingCache::Key key{makeCoordinate(0), boost::none};
+
+    PhantomNodePair phantom_nodes;
+    cache.Add(1, key, makePhantomNodes(1));
+    BOOST_CHECK(cache.Get(1, key, phantom_nodes));
+    BOOST_CHECK(!cache.Get(2, key, phantom_nodes));
+    BOOST_CHECK(!cache.Get(1, key, phantom_nodes));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,73 @@
+#include "engine/tile_cache.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <memory>
+
+BOOST_AUTO_TEST_SUITE(tile_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+std::shared_ptr<const TileEdges> makeEdges(const std::size_t number_of_edges)
+{
+    return std::make_shared<const TileEdges>(number_of_edges);
+}
+}
+
+BOOST_AUTO_TEST_CASE(hit_and_miss)
+{
+    TileCache cache(64);
+
+    BOOST_CHECK(!cache.Get(0, 4398, 2834));
+    cache.Add(0, 4398, 2834, makeEdges(3));
+
+    const auto edges = cache.Get(0, 4398, 2834);
+    BOOST_REQUIRE(edges);
+    BOOST_CHECK_EQUAL(edges->size(), 3);
+    // x and y are not interchangeable
+    BOOST_CHECK(!cache.Get(0, 2834, 4398));
+
+    BOOST_CHECK_EQUAL(cache.GetNumberOfHits(), 1);
+    BOOST_CHECK_EQUAL(cache.GetNumberOfMisses(), 2);
+    BOOST_CHECK_CLOSE(cache.GetHitRate(), 1. / 3., 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(bounded_size)
+{
+    // 16 shards with one entry each
+    TileCache cache(16);
+
+    for (unsigned x = 0; x < 100; ++x)
+    {
+        cache.Add(0, x, 7, makeEdges(x));
+        // the last tile is always kept
+        BOOST_CHECK(cache.Get(0, x, 7));
+    }
+
+    std::size_t number_of_cached = 0;
+    for (unsigned x = 0; x < 100; ++x)
+    {
+        number_of_cached += static_cast<bool>(cache.Get(0, x, 7));
+    }
+    BOOST_CHECK_LE(number_of_cached, 16);
+    BOOST_CHECK_GT(number_of_cached, 0);
+}
+
+BOOST_AUTO_TEST_CASE(evicted_tiles_stay_alive)
+{
+    TileCache cache(1);
+    cache.Add(0, 1, 1, makeEdges(5));
+    const auto edges = cache.Get(0, 1, 1);
+    BOOST_REQUIRE(edges);
+
+    // a new checksum drops the tile from the cache, but not from the query holding it
+    BOOST_CHECK(!cache.Get(1, 1, 1));
+    BOOST_CHECK_EQUAL(edges->size(), 5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+#include "engine/search_engine_data.hpp"
+#include "engine/traffic_overlay.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(traffic_overlay)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+BOOST_AUTO_TEST_CASE(empty_overlay)
+{
+    const TrafficOverlay overlay;
+    BOOST_CHECK(overlay.Empty());
+    BOOST_CHECK_EQUAL(overlay.GetVersion(), 0);
+    BOOST_CHECK_EQUAL(overlay.GetPenalty(0), 0);
+    BOOST_CHECK_EQUAL(overlay.GetPenalty(42), 0);
+}
+
+BOOST_AUTO_TEST_CASE(penalties_and_closures)
+{
+    const TrafficOverlay overlay({{3, 50}, {7, storage::TRAFFIC_CLOSED}, {1000000, 1}}, 4);
+    BOOST_CHECK(!overlay.Empty());
+    BOOST_CHECK_EQUAL(overlay.Size(), 3);
+    BOOST_CHECK_EQUAL(overlay.GetVersion(), 4);
+    BOOST_CHECK_EQUAL(overlay.GetPenalty(3), 50);
+    BOOST_CHECK_EQUAL(overlay.GetPenalty(7), storage::TRAFFIC_CLOSED);
+    BOOST_CHECK_EQUAL(overlay.GetPenalty(1000000), 1);
+    for (const NodeID node : {0u, 2u, 4u, 6u, 8u, 999999u, 1000001u})
+    {
+        BOOST_CHECK_EQUAL(overlay.GetPenalty(node), 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(many_penalties)
+{
+    // more penalties than fit the smallest bitset
+    std::vector<storage::TrafficPenalty> penalties;
+    for (NodeID node = 0; node < 10000; node += 3)
+    {
+        penalties.push_back({node, static_cast<EdgeWeight>(node + 1)});
+    }
+    const TrafficOverlay overlay(penalties, 1);
+    for (NodeID node = 0; node < 10000; ++node)
+    {
+        BOOST_CHECK_EQUAL(overlay.GetPenalty(node),
+                          node % 3 == 0 ? static_cast<EdgeWeight>(node + 1) : 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hidden_penalties)
+{
+    HiddenTrafficPenalties hidden;
+    BOOST_CHECK(!hidden.Contains(1, 2));
+    BOOST_CHECK_EQUAL(hidden.Get(1, 2), 0);
+
+    hidden.Set(1, 2, 30);
+    hidden.Set(2, 1, 0);
+    BOOST_CHECK(hidden.Contains(1, 2));
+    BOOST_CHECK(hidden.Contains(2, 1));
+    BOOST_CHECK_EQUAL(hidden.Get(1, 2), 30);
+    BOOST_CHECK_EQUAL(hidden.Get(2, 1), 0);
+    BOOST_CHECK(!hidden.Contains(1, 3));
+}
+
+BOOST_AUTO_TEST_CASE(scoped_overlay)
+{
+    BOOST_CHECK(SearchEngineData::GetTrafficOverlay() == nullptr);
+    const TrafficOverlay overlay({{3, 50}}, 1);
+    {
+        const SearchEngineData::ScopedTrafficOverlay traffic(&overlay);
+        BOOST_CHECK(SearchEngineData::GetTrafficOverlay() == &overlay);
+
+        // the searches skip the lookups of an empty overlay
+        const TrafficOverlay empty_overlay;
+        const SearchEngineData::ScopedTrafficOverlay no_traffic(&empty_overlay);
+        BOOST_CHECK(SearchEngineData::GetTrafficOverlay() == nullptr);
+    }
+    BOOST_CHECK(SearchEngineData::GetTrafficOverlay() == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,156 @@
+#include "engine/trip/trip_clustering.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(trip_clustering)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+EdgeWeight getLength(const std::vector<NodeID> &path,
+                     const util::DistTableWrapper<EdgeWeight> &table)
+{
+    EdgeWeight length = 0;
+    for (std::size_t i = 0; i + 1 < path.size(); ++i)
+    {
+        length += table(path[i], path[i + 1]);
+    }
+    return length;
+}
+
+util::DistTableWrapper<EdgeWeight> makeRandomTable(const std::size_t number_of_locations,
+                                                   std::mt19937 &generator)
+{
+    std::uniform_int_distribution<EdgeWeight> durations(1, 1000);
+    std::vector<EdgeWeight> table;
+    for (std::size_t from = 0; from < number_of_locations; ++from)
+    {
+        for (std::size_t to = 0; to < number_of_locations; ++to)
+        {
+            table.push_back(from == to ? 0 : durations(generator));
+        }
+    }
+    return util::DistTableWrapper<EdgeWeight>(std::move(table), number_of_locations);
+}
+
+util::Coordinate makeCoordinate(const double lon, const double lat)
+{
+    return {util::FloatLongitude{lon}, util::FloatLatitude{lat}};
+}
+}
+
+BOOST_AUTO_TEST_CASE(clusters_of_nearby_locations)
+{
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> offset(0, 0.01);
+    // four towns far apart from each other with 16 locations each
+    const std::vector<std::pair<double, double>> towns = {{7, 50}, {8, 50}, {7, 51}, {8, 51}};
+    std::vector<util::Coordinate> coordinates;
+    for (std::size_t location = 0; location < 64; ++location)
+    {
+        const auto &town = towns[location % towns.size()];
+        coordinates.push_back(
+            makeCoordinate(town.first + offset(generator), town.second + offset(generator)));
+    }
+
+    const auto clusters = trip::ClusterLocations(coordinates, trip::CLUSTER_MAX_LOCATIONS);
+    BOOST_REQUIRE_EQUAL(clusters.size(), towns.size());
+    std::vector<NodeID> locations;
+    for (const auto &cluster : clusters)
+    {
+        BOOST_CHECK_EQUAL(cluster.size(), trip::CLUSTER_MAX_LOCATIONS);
+        for (const auto location : cluster)
+        {
+            BOOST_CHECK_EQUAL(location % towns.size(), cluster.front() % towns.size());
+        }
+        locations.insert(locations.end(), cluster.begin(), cluster.end());
+    }
+    std::sort(locations.begin(), locations.end());
+    for (std::size_t location = 0; location < locations.size(); ++location)
+    {
+        BOOST_CHECK_EQUAL(locations[location], location);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(cluster_sizes)
+{
+    std::vector<util::Coordinate> coordinates;
+    for (std::size_t location = 0; location < 100; ++location)
+    {
+        coordinates.push_back(makeCoordinate(0.001 * location, 0.0005 * (location % 7)));
+    }
+    const auto clusters = trip::ClusterLocations(coordinates, 16);
+    std::size_t number_of_locations = 0;
+    for (const auto &cluster : clusters)
+    {
+        BOOST_CHECK_GT(cluster.size(), 8);
+        BOOST_CHECK_LE(cluster.size(), 16);
+        number_of_locations += cluster.size();
+    }
+    BOOST_CHECK_EQUAL(number_of_locations, coordinates.size());
+}
+
+BOOST_AUTO_TEST_CASE(cluster_ends)
+{
+    // three clusters on a line, the round trip goes back from the last to the first
+    const std::vector<util::Coordinate> coordinates = {makeCoordinate(0, 0),
+                                                       makeCoordinate(0.01, 0),
+                                                       makeCoordinate(1, 0),
+                                                       makeCoordinate(1.01, 0),
+                                                       makeCoordinate(2, 0)};
+    const std::vector<std::vector<NodeID>> clusters = {{0, 1}, {2, 3}, {4}};
+    const auto ends = trip::GetClusterEnds(clusters, coordinates);
+    BOOST_REQUIRE_EQUAL(ends.size(), 3);
+    // left towards the next cluster at the location closer to it, so entered at the other one
+    BOOST_CHECK_EQUAL(ends[0].first, 0);
+    BOOST_CHECK_EQUAL(ends[0].second, 1);
+    BOOST_CHECK_EQUAL(ends[1].first, 2);
+    BOOST_CHECK_EQUAL(ends[1].second, 3);
+    BOOST_CHECK_EQUAL(ends[2].first, 4);
+    BOOST_CHECK_EQUAL(ends[2].second, 4);
+}
+
+BOOST_AUTO_TEST_CASE(shortest_open_paths)
+{
+    std::mt19937 generator(13);
+    for (std::size_t number_of_locations = 1; number_of_locations <= 8; ++number_of_locations)
+    {
+        const auto table = makeRandomTable(number_of_locations + 2, generator);
+        // a part of the locations of the table
+        std::vector<NodeID> locations(number_of_locations);
+        std::iota(locations.begin(), locations.end(), 2);
+        const auto first = locations.front();
+        const auto last = locations.back();
+
+        const auto path = trip::OpenPathTrip(locations, first, last, table);
+        BOOST_REQUIRE_EQUAL(path.size(), number_of_locations);
+        BOOST_CHECK(std::is_permutation(path.begin(), path.end(), locations.begin()));
+        BOOST_CHECK_EQUAL(path.front(), first);
+        BOOST_CHECK_EQUAL(path.back(), last);
+
+        // the shortest of all paths between the ends
+        auto shortest_length = getLength(path, table);
+        if (number_of_locations > 2)
+        {
+            std::vector<NodeID> inner(locations.begin() + 1, locations.end() - 1);
+            do
+            {
+                std::vector<NodeID> other_path{first};
+                other_path.insert(other_path.end(), inner.begin(), inner.end());
+                other_path.push_back(last);
+                shortest_length = std::min(shortest_length, getLength(other_path, table));
+            } while (std::next_permutation(inner.begin(), inner.end()));
+        }
+        BOOST_CHECK_EQUAL(getLength(path, table), shortest_length);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
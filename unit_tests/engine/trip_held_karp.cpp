@@ -0,0 +1,115 @@
+#include "engine/trip/trip_held_karp.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(trip_held_karp)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+EdgeWeight getLength(const std::vector<NodeID> &route,
+                     const util::DistTableWrapper<EdgeWeight> &table)
+{
+    EdgeWeight length = 0;
+    for (std::size_t i = 0; i < route.size(); ++i)
+    {
+        length += table(route[i], route[(i + 1) % route.size()]);
+    }
+    return length;
+}
+
+// the shortest round trip of all permutations
+EdgeWeight getShortestLength(std::vector<NodeID> locations,
+                             const util::DistTableWrapper<EdgeWeight> &table)
+{
+    std::sort(locations.begin(), locations.end());
+    auto shortest_length = getLength(locations, table);
+    while (std::next_permutation(locations.begin(), locations.end()))
+    {
+        shortest_length = std::min(shortest_length, getLength(locations, table));
+    }
+    return shortest_length;
+}
+
+util::DistTableWrapper<EdgeWeight> makeRandomTable(const std::size_t number_of_locations,
+                                                   std::mt19937 &generator)
+{
+    std::uniform_int_distribution<EdgeWeight> durations(1, 1000);
+    std::vector<EdgeWeight> table;
+    for (std::size_t from = 0; from < number_of_locations; ++from)
+    {
+        for (std::size_t to = 0; to < number_of_locations; ++to)
+        {
+            table.push_back(from == to ? 0 : durations(generator));
+        }
+    }
+    return util::DistTableWrapper<EdgeWeight>(std::move(table), number_of_locations);
+}
+}
+
+BOOST_AUTO_TEST_CASE(shortest_asymmetric_trips)
+{
+    std::mt19937 generator(3);
+    for (std::size_t number_of_locations = 1; number_of_locations <= 9; ++number_of_locations)
+    {
+        const auto table = makeRandomTable(number_of_locations, generator);
+        std::vector<NodeID> locations(number_of_locations);
+        std::iota(locations.begin(), locations.end(), 0);
+
+        const auto route =
+            trip::HeldKarpTrip(locations.begin(), locations.end(), number_of_locations, table);
+        BOOST_CHECK_EQUAL(route.size(), number_of_locations);
+        BOOST_CHECK(std::is_permutation(route.begin(), route.end(), locations.begin()));
+        BOOST_CHECK_EQUAL(getLength(route, table), getShortestLength(locations, table));
+        // the trip starts at the first location
+        BOOST_CHECK_EQUAL(route.front(), locations.front());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(part_of_the_locations)
+{
+    std::mt19937 generator(5);
+    const auto table = makeRandomTable(12, generator);
+
+    const std::vector<NodeID> component = {11, 2, 7, 4, 9, 0, 5};
+    const auto route = trip::HeldKarpTrip(component.begin(), component.end(), 12, table);
+    BOOST_CHECK(std::is_permutation(route.begin(), route.end(), component.begin()));
+    BOOST_CHECK_EQUAL(getLength(route, table), getShortestLength(component, table));
+}
+
+BOOST_AUTO_TEST_CASE(largest_component)
+{
+    std::mt19937 generator(11);
+    const auto number_of_locations = trip::HELD_KARP_MAX_LOCATIONS;
+    const auto table = makeRandomTable(number_of_locations, generator);
+    std::vector<NodeID> locations(number_of_locations);
+    std::iota(locations.begin(), locations.end(), 0);
+
+    const auto route =
+        trip::HeldKarpTrip(locations.begin(), locations.end(), number_of_locations, table);
+    BOOST_CHECK(std::is_permutation(route.begin(), route.end(), locations.begin()));
+
+    // no single move of a location makes the trip shorter
+    const auto length = getLength(route, table);
+    for (std::size_t from = 1; from < route.size(); ++from)
+    {
+        for (std::size_t to = 1; to < route.size(); ++to)
+        {
+            auto moved_route = route;
+            const auto location = moved_route[from];
+            moved_route.erase(moved_route.begin() + from);
+            moved_route.insert(moved_route.begin() + to, location);
+            BOOST_CHECK_LE(length, getLength(moved_route, table));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,125 @@
+#include "engine/trip/trip_local_search.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(trip_local_search)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+EdgeWeight getLength(const std::vector<NodeID> &route,
+                     const util::DistTableWrapper<EdgeWeight> &table)
+{
+    EdgeWeight length = 0;
+    for (std::size_t i = 0; i < route.size(); ++i)
+    {
+        length += table(route[i], route[(i + 1) % route.size()]);
+    }
+    return length;
+}
+
+bool isPermutation(std::vector<NodeID> route, const std::size_t number_of_locations)
+{
+    std::sort(route.begin(), route.end());
+    std::vector<NodeID> locations(number_of_locations);
+    std::iota(locations.begin(), locations.end(), 0);
+    return route == locations;
+}
+
+// the locations are evenly spaced on a circle, so the shortest trip goes around it
+util::DistTableWrapper<EdgeWeight> makeCircleTable(const std::size_t number_of_locations)
+{
+    std::vector<EdgeWeight> table;
+    for (std::size_t from = 0; from < number_of_locations; ++from)
+    {
+        for (std::size_t to = 0; to < number_of_locations; ++to)
+        {
+            const auto angle_from = 2 * M_PI * from / number_of_locations;
+            const auto angle_to = 2 * M_PI * to / number_of_locations;
+            table.push_back(static_cast<EdgeWeight>(std::round(
+                1000 * std::hypot(std::cos(angle_from) - std::cos(angle_to),
+                                  std::sin(angle_from) - std::sin(angle_to)))));
+        }
+    }
+    return util::DistTableWrapper<EdgeWeight>(std::move(table), number_of_locations);
+}
+}
+
+BOOST_AUTO_TEST_CASE(untangles_circle)
+{
+    const std::size_t number_of_locations = 40;
+    const auto table = makeCircleTable(number_of_locations);
+
+    std::vector<NodeID> circle(number_of_locations);
+    std::iota(circle.begin(), circle.end(), 0);
+    const auto shortest_length = getLength(circle, table);
+
+    std::mt19937 generator(42);
+    for (int round = 0; round < 5; ++round)
+    {
+        auto route = circle;
+        std::shuffle(route.begin(), route.end(), generator);
+        trip::ImproveTrip(route, table);
+        BOOST_CHECK(isPermutation(route, number_of_locations));
+        BOOST_CHECK_EQUAL(getLength(route, table), shortest_length);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(never_longer_on_asymmetric_tables)
+{
+    const std::size_t number_of_locations = 100;
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<EdgeWeight> durations(1, 1000);
+
+    for (int round = 0; round < 5; ++round)
+    {
+        std::vector<EdgeWeight> durations_table;
+        for (std::size_t i = 0; i < number_of_locations * number_of_locations; ++i)
+        {
+            durations_table.push_back(i % (number_of_locations + 1) == 0 ? 0
+                                                                          : durations(generator));
+        }
+        const util::DistTableWrapper<EdgeWeight> table(std::move(durations_table),
+                                                       number_of_locations);
+
+        std::vector<NodeID> route(number_of_locations);
+        std::iota(route.begin(), route.end(), 0);
+        std::shuffle(route.begin(), route.end(), generator);
+        const auto initial_length = getLength(route, table);
+
+        trip::ImproveTrip(route, table);
+        BOOST_CHECK(isPermutation(route, number_of_locations));
+        BOOST_CHECK_LT(getLength(route, table), initial_length);
+
+        // the result is a local optimum
+        auto improved_route = route;
+        trip::ImproveTrip(improved_route, table);
+        BOOST_CHECK_EQUAL(getLength(improved_route, table), getLength(route, table));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(part_of_the_locations)
+{
+    const auto table = makeCircleTable(20);
+
+    // a component with every other location of the circle
+    std::vector<NodeID> route = {0, 10, 4, 14, 8, 18, 2, 12, 6, 16};
+    trip::ImproveTrip(route, table);
+    BOOST_CHECK_EQUAL(getLength(route, table),
+                      getLength({0, 2, 4, 6, 8, 10, 12, 14, 16, 18}, table));
+
+    std::vector<NodeID> small_route = {3, 1, 2};
+    trip::ImproveTrip(small_route, table);
+    BOOST_CHECK((small_route == std::vector<NodeID>{3, 1, 2}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
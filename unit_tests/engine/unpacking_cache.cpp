@@ -0,0 +1,69 @@
+#include "engine/unpacking_cache.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(unpacking_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+UnpackingCache::ExpansionPtr makeExpansion(std::vector<EdgeID> edges)
+{
+    return std::make_shared<const UnpackingCache::Expansion>(std::move(edges));
+}
+}
+
+BOOST_AUTO_TEST_CASE(hit_and_miss)
+{
+    UnpackingCache cache(64);
+
+    BOOST_CHECK(!cache.Get(0, 1));
+    cache.Add(0, 1, makeExpansion({4, 5, 6}));
+
+    const auto expansion = cache.Get(0, 1);
+    BOOST_REQUIRE(expansion);
+    const std::vector<EdgeID> reference = {4, 5, 6};
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        expansion->begin(), expansion->end(), reference.begin(), reference.end());
+
+    BOOST_CHECK_EQUAL(cache.GetNumberOfHits(), 1);
+    BOOST_CHECK_EQUAL(cache.GetNumberOfMisses(), 1);
+    BOOST_CHECK_CLOSE(cache.GetHitRate(), 0.5, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(evicts_least_recently_used)
+{
+    // 16 shards with one entry each, edges 0 and 16 share a shard
+    UnpackingCache cache(16);
+
+    cache.Add(0, 0, makeExpansion({1}));
+    cache.Add(0, 1, makeExpansion({2}));
+    const auto evicted = cache.Get(0, 0);
+    cache.Add(0, 16, makeExpansion({3}));
+
+    BOOST_CHECK(!cache.Get(0, 0));
+    BOOST_CHECK(cache.Get(0, 1));
+    BOOST_CHECK(cache.Get(0, 16));
+
+    // expansions handed out before stay valid
+    BOOST_REQUIRE(evicted);
+    BOOST_CHECK_EQUAL(evicted->front(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(new_data_version_invalidates)
+{
+    UnpackingCache cache(64);
+
+    cache.Add(1, 7, makeExpansion({8, 9}));
+    BOOST_CHECK(cache.Get(1, 7));
+    BOOST_CHECK(!cache.Get(2, 7));
+    BOOST_CHECK(!cache.Get(1, 7));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,212 @@
+#include "extractor/car_profile.hpp"
+#include "extractor/extraction_node.hpp"
+#include "extractor/extraction_way.hpp"
+#include "util/exception.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(car_profile)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+using Tags = std::vector<std::pair<std::string, std::string>>;
+
+ExtractionWay processWay(const CarProfile &profile, const Tags &tags)
+{
+    using namespace osmium::builder::attr;
+    osmium::memory::Buffer buffer(1024, osmium::memory::Buffer::auto_grow::yes);
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 2}), _tags(tags));
+    ExtractionWay result;
+    profile.ProcessWay(buffer.get<osmium::Way>(0), result);
+    return result;
+}
+
+ExtractionNode processNode(const CarProfile &profile, const Tags &tags)
+{
+    using namespace osmium::builder::attr;
+    osmium::memory::Buffer buffer(1024, osmium::memory::Buffer::auto_grow::yes);
+    osmium::builder::add_node(buffer, _id(1), _tags(tags));
+    ExtractionNode result;
+    profile.ProcessNode(buffer.get<osmium::Node>(0), result);
+    return result;
+}
+
+BOOST_AUTO_TEST_CASE(string_table)
+{
+    StringTable<int> table;
+    BOOST_CHECK(table.Find("missing") == nullptr);
+    BOOST_CHECK(table.Find(nullptr) == nullptr);
+
+    for (int index = 0; index < 100; ++index)
+    {
+        table.Set(std::to_string(index), index);
+    }
+    table.Set("42", -42);
+    table.Erase("7");
+    BOOST_CHECK_EQUAL(table.Size(), 99);
+    BOOST_CHECK_EQUAL(*table.Find("42"), -42);
+    BOOST_CHECK_EQUAL(*table.Find("99"), 99);
+    BOOST_CHECK(!table.Contains("7"));
+    BOOST_CHECK(!table.Contains("100"));
+}
+
+BOOST_AUTO_TEST_CASE(speeds_of_car_lua)
+{
+    const CarProfile profile{CarProfileConfig()};
+
+    const auto primary = processWay(profile, {{"highway", "primary"}});
+    BOOST_CHECK_EQUAL(primary.forward_speed, 65 * 0.8 + 11);
+    BOOST_CHECK_EQUAL(primary.backward_speed, 65 * 0.8 + 11);
+    BOOST_CHECK_EQUAL(primary.forward_travel_mode, TRAVEL_MODE_DRIVING);
+    BOOST_CHECK_EQUAL(primary.backward_travel_mode, TRAVEL_MODE_DRIVING);
+    BOOST_CHECK_EQUAL(primary.road_classification.GetClass(),
+                      guidance::RoadPriorityClass::PRIMARY);
+    BOOST_CHECK(!primary.road_classification.IsLowPriorityRoadClass());
+
+    // a higher maxspeed raises the speed of the highway, a lower one limits it
+    const auto fast = processWay(profile, {{"highway", "primary"}, {"maxspeed", "100"}});
+    BOOST_CHECK_EQUAL(fast.forward_speed, 100 * 0.8 + 11);
+    const auto slow = processWay(profile, {{"highway", "primary"}, {"maxspeed", "de:urban"}});
+    BOOST_CHECK_EQUAL(slow.forward_speed, 50 * 0.8 + 11);
+    const auto mph = processWay(profile, {{"highway", "primary"}, {"maxspeed", "30 mph"}});
+    BOOST_CHECK_CLOSE(mph.forward_speed, (30 * 1609) / 1000. * 0.8 + 11, 1e-9);
+
+    const auto narrow =
+        processWay(profile, {{"highway", "residential"}, {"lanes", "1"}, {"surface", "gravel"}});
+    BOOST_CHECK_EQUAL(narrow.forward_speed, 25 / 2.);
+
+    const auto ferry = processWay(profile, {{"route", "ferry"}});
+    BOOST_CHECK_EQUAL(ferry.forward_speed, 5 * 0.8 + 11);
+    BOOST_CHECK_EQUAL(ferry.forward_travel_mode, TRAVEL_MODE_FERRY);
+    BOOST_CHECK(!ferry.is_startpoint);
+}
+
+BOOST_AUTO_TEST_CASE(access_and_oneways_of_car_lua)
+{
+    const CarProfile profile{CarProfileConfig()};
+
+    BOOST_CHECK_EQUAL(processWay(profile, {{"building", "yes"}}).forward_travel_mode,
+                      TRAVEL_MODE_INACCESSIBLE);
+    BOOST_CHECK_EQUAL(processWay(profile, {{"highway", "primary"}, {"access", "no"}}).forward_speed,
+                      -1);
+    // the more specific access tag wins
+    BOOST_CHECK_EQUAL(
+        processWay(profile, {{"highway", "primary"}, {"access", "no"}, {"motorcar", "yes"}})
+            .forward_speed,
+        65 * 0.8 + 11);
+    const auto destination =
+        processWay(profile, {{"highway", "primary"}, {"motor_vehicle", "destination"}});
+    BOOST_CHECK(destination.is_access_restricted);
+
+    const auto oneway = processWay(profile,
+                                   {{"highway", "motorway"},
+                                    {"name", "A 1"},
+                                    {"destination", "Köln;Bonn"},
+                                    {"destination:ref", "A 3"}});
+    BOOST_CHECK_EQUAL(oneway.forward_travel_mode, TRAVEL_MODE_DRIVING);
+    BOOST_CHECK_EQUAL(oneway.backward_travel_mode, TRAVEL_MODE_INACCESSIBLE);
+    BOOST_CHECK_EQUAL(oneway.name, "A 1");
+    BOOST_CHECK_EQUAL(oneway.destinations, "A 3: Köln, Bonn");
+    BOOST_CHECK(oneway.road_classification.IsMotorwayClass());
+
+    const auto reverse = processWay(profile, {{"highway", "residential"}, {"oneway", "-1"}});
+    BOOST_CHECK_EQUAL(reverse.forward_travel_mode, TRAVEL_MODE_INACCESSIBLE);
+    BOOST_CHECK_EQUAL(reverse.backward_travel_mode, TRAVEL_MODE_DRIVING);
+
+    const auto hov =
+        processWay(profile, {{"highway", "primary"}, {"hov:lanes:forward", "designated"}});
+    BOOST_CHECK_EQUAL(hov.forward_travel_mode, TRAVEL_MODE_INACCESSIBLE);
+    BOOST_CHECK_EQUAL(hov.backward_travel_mode, TRAVEL_MODE_DRIVING);
+
+    BOOST_CHECK(processNode(profile, {{"barrier", "wall"}}).barrier);
+    BOOST_CHECK(!processNode(profile, {{"barrier", "gate"}}).barrier);
+    BOOST_CHECK(!processNode(profile, {{"barrier", "bollard"}, {"bollard", "rising"}}).barrier);
+    BOOST_CHECK(processNode(profile, {{"highway", "traffic_signals"}}).traffic_lights);
+}
+
+BOOST_AUTO_TEST_CASE(turn_penalty_of_car_lua)
+{
+    const CarProfile profile{CarProfileConfig()};
+    BOOST_CHECK_EQUAL(profile.GetTurnPenalty(0), 0);
+    BOOST_CHECK_EQUAL(profile.GetTurnPenalty(90), 21);
+    BOOST_CHECK_EQUAL(profile.GetTurnPenalty(-90), 53);
+    BOOST_CHECK_EQUAL(profile.GetTurnPenalty(180), 74);
+
+    CarProfileConfig config;
+    config.properties.left_hand_driving = true;
+    BOOST_CHECK_EQUAL(CarProfile(config).GetTurnPenalty(90), 53);
+}
+
+BOOST_AUTO_TEST_CASE(load_config)
+{
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("car-profile-%%%%%%%%.ini");
+    {
+        boost::filesystem::ofstream stream(path);
+        stream << "# comment\n"
+                  "[properties]\n"
+                  "u_turn_penalty = 30 # seconds\n"
+                  "ignore_toll_ways = true\n"
+                  "[speeds]\n"
+                  "primary = 100\n"
+                  "residential =\n"
+                  "[access]\n"
+                  "tags = hgv motor_vehicle access\n";
+    }
+    CarProfileConfig config;
+    config.Load(path);
+    BOOST_CHECK_EQUAL(config.properties.GetUturnPenalty(), 30);
+    BOOST_CHECK(config.ignore_toll_ways);
+    BOOST_CHECK_EQUAL(*config.speeds.Find("primary"), 100);
+    BOOST_CHECK(!config.speeds.Contains("residential"));
+    BOOST_CHECK_EQUAL(*config.speeds.Find("motorway"), 90);
+
+    const CarProfile profile{config};
+    BOOST_CHECK_EQUAL(processWay(profile, {{"highway", "primary"}}).forward_speed, 100 * 0.8 + 11);
+    BOOST_CHECK_EQUAL(processWay(profile, {{"highway", "primary"}, {"hgv", "no"}}).forward_speed,
+                      -1);
+    BOOST_CHECK_EQUAL(processWay(profile, {{"highway", "primary"}, {"toll", "yes"}}).forward_speed,
+                      -1);
+
+    {
+        boost::filesystem::ofstream stream(path);
+        stream << "[speeds]\nprimary = fast\n";
+    }
+    BOOST_CHECK_THROW(config.Load(path), util::exception);
+    {
+        boost::filesystem::ofstream stream(path);
+        stream << "[bicycle]\nprimary = 20\n";
+    }
+    BOOST_CHECK_THROW(config.Load(path), util::exception);
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(load_car_ini)
+{
+    // profiles/car.ini has the tables of car.lua
+    CarProfileConfig config;
+    config.Load("../profiles/car.ini");
+    const CarProfileConfig defaults;
+    BOOST_CHECK_EQUAL(config.speeds.Size(), defaults.speeds.Size());
+    BOOST_CHECK_EQUAL(config.surface_speeds.Size(), defaults.surface_speeds.Size());
+    BOOST_CHECK_EQUAL(config.maxspeeds.Size(), defaults.maxspeeds.Size());
+    BOOST_CHECK_CLOSE(*config.maxspeeds.Find("gb:nsl_single"),
+                      *defaults.maxspeeds.Find("gb:nsl_single"),
+                      1e-9);
+    BOOST_CHECK_EQUAL(config.access_blacklist.Size(), defaults.access_blacklist.Size());
+    BOOST_CHECK(config.name_suffixes == defaults.name_suffixes);
+    BOOST_CHECK_EQUAL(config.properties.GetUturnPenalty(), 20);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,75 @@
+#include "extractor/change_merger.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(change_merger)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+// type and id of the objects, like "n1 w2"
+std::string describe(const osmium::memory::Buffer &buffer)
+{
+    std::string description;
+    for (const auto &item : buffer)
+    {
+        const auto &object = static_cast<const osmium::OSMObject &>(item);
+        description += description.empty() ? "" : " ";
+        description += osmium::item_type_to_char(object.type()) + std::to_string(object.id());
+        if (object.tags().get_value_by_key("name"))
+        {
+            description += std::string("=") + object.tags().get_value_by_key("name");
+        }
+    }
+    return description;
+}
+
+BOOST_AUTO_TEST_CASE(merge_changes)
+{
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("changes-%%%%%%%%.osc");
+    {
+        boost::filesystem::ofstream stream(path);
+        stream << "<?xml version='1.0' encoding='UTF-8'?>\n"
+                  "<osmChange version='0.6'>\n"
+                  "<create><node id='3' version='1' lat='1' lon='1'/></create>\n"
+                  "<modify><way id='2' version='2'><nd ref='1'/><nd ref='3'/>"
+                  "<tag k='name' v='new'/></way></modify>\n"
+                  "<modify><way id='2' version='3'><nd ref='1'/><nd ref='3'/>"
+                  "<tag k='name' v='newer'/></way></modify>\n"
+                  "<delete><node id='4' version='2' lat='1' lon='1'/></delete>\n"
+                  "<create><relation id='9' version='1'/></create>\n"
+                  "</osmChange>\n";
+    }
+
+    using namespace osmium::builder::attr;
+    osmium::memory::Buffer first(1024, osmium::memory::Buffer::auto_grow::yes);
+    osmium::builder::add_node(first, _id(1), _version(1));
+    osmium::builder::add_node(first, _id(4), _version(1));
+    osmium::memory::Buffer second(1024, osmium::memory::Buffer::auto_grow::yes);
+    osmium::builder::add_way(second, _id(1), _version(1), _tag("name", "unchanged"));
+    osmium::builder::add_way(second, _id(2), _version(1), _tag("name", "old"));
+
+    ChangeMerger merger({path});
+    BOOST_CHECK_EQUAL(merger.GetNumberOfChanges(), 4);
+    for (int read = 0; read < 2; ++read)
+    {
+        // the created node goes where it belongs, the latest version replaces the way
+        BOOST_CHECK_EQUAL(describe(merger.Merge(first)), "n1 n3");
+        BOOST_CHECK_EQUAL(describe(merger.Merge(second)), "w1=unchanged w2=newer");
+        BOOST_CHECK_EQUAL(describe(merger.Finish()), "r9");
+        merger.Reset();
+    }
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,137 @@
+#include "extractor/compressed_edge_based_edges.hpp"
+#include "util/chunked_vector.hpp"
+#include "util/exception.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(compressed_edge_based_edges)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+namespace
+{
+std::vector<EdgeBasedEdge> makeEdges(const std::size_t number_of_edges)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<NodeID> node_distribution(0, 1000000);
+    std::uniform_int_distribution<EdgeWeight> weight_distribution(0, (1 << 29) - 1);
+
+    std::vector<EdgeBasedEdge> edges;
+    NodeID source = 0;
+    for (const auto edge_id : util::irange<NodeID>(0, number_of_edges))
+    {
+        if (edge_id % 3 == 0)
+        {
+            source = node_distribution(generator);
+        }
+        edges.emplace_back(source,
+                           node_distribution(generator),
+                           edge_id,
+                           weight_distribution(generator),
+                           edge_id * 0.5f,
+                           edge_id % 2 == 0,
+                           edge_id % 5 == 0);
+    }
+    // the largest ids
+    edges.emplace_back(SPECIAL_NODEID - 1, 0, SPECIAL_NODEID - 1, 0, 0.f, true, true);
+    return edges;
+}
+
+std::string write(const std::vector<EdgeBasedEdge> &edges)
+{
+    std::ostringstream out;
+    writeEdgeBasedEdges(out, edges);
+    return out.str();
+}
+
+template <typename EdgeContainer>
+void read(const std::string &bytes, const std::uint64_t number_of_edges, EdgeContainer &edges)
+{
+    const auto data = reinterpret_cast<const unsigned char *>(bytes.data());
+    readEdgeBasedEdges(data, data + bytes.size(), number_of_edges, edges);
+}
+
+void checkEqual(const EdgeBasedEdge &lhs, const EdgeBasedEdge &rhs)
+{
+    BOOST_CHECK_EQUAL(lhs.source, rhs.source);
+    BOOST_CHECK_EQUAL(lhs.target, rhs.target);
+    BOOST_CHECK_EQUAL(lhs.edge_id, rhs.edge_id);
+    BOOST_CHECK_EQUAL(lhs.weight, rhs.weight);
+    BOOST_CHECK_EQUAL(lhs.length, rhs.length);
+    BOOST_CHECK_EQUAL(lhs.forward, rhs.forward);
+    BOOST_CHECK_EQUAL(lhs.backward, rhs.backward);
+}
+}
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+    // more than two blocks
+    const auto edges = makeEdges(2 * EDGE_BASED_EDGE_BLOCK_SIZE + 17);
+    const auto bytes = write(edges);
+    BOOST_CHECK_LT(bytes.size(), edges.size() * sizeof(EdgeBasedEdge));
+
+    util::ChunkedVector<EdgeBasedEdge> read_edges;
+    read(bytes, edges.size(), read_edges);
+    BOOST_REQUIRE_EQUAL(read_edges.size(), edges.size());
+    for (const auto index : util::irange<std::size_t>(0, edges.size()))
+    {
+        checkEqual(read_edges[index], edges[index]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(write_to_file)
+{
+    // more than one batch of blocks
+    const auto edges = makeEdges(65 * EDGE_BASED_EDGE_BLOCK_SIZE + 3);
+    const auto bytes = write(edges);
+
+    const auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    const std::string header = "header";
+    {
+        boost::filesystem::ofstream out(path, std::ios::binary);
+        out << header;
+    }
+    BOOST_CHECK_EQUAL(writeEdgeBasedEdges(path, header.size(), edges),
+                      header.size() + bytes.size());
+
+    boost::filesystem::ifstream in(path, std::ios::binary);
+    const std::string file_bytes{std::istreambuf_iterator<char>(in),
+                                 std::istreambuf_iterator<char>()};
+    in.close();
+    boost::filesystem::remove(path);
+    BOOST_CHECK(file_bytes == header + bytes);
+}
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+    const auto bytes = write({});
+    BOOST_CHECK(bytes.empty());
+
+    std::vector<EdgeBasedEdge> read_edges;
+    read(bytes, 0, read_edges);
+    BOOST_CHECK(read_edges.empty());
+}
+
+BOOST_AUTO_TEST_CASE(truncated)
+{
+    const auto edges = makeEdges(100);
+    const auto bytes = write(edges);
+
+    std::vector<EdgeBasedEdge> read_edges;
+    BOOST_CHECK_THROW(read(bytes.substr(0, bytes.size() - 1), edges.size(), read_edges),
+                      util::exception);
+    BOOST_CHECK_THROW(read(bytes, edges.size() + 1, read_edges), util::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
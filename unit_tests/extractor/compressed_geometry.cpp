@@ -0,0 +1,139 @@
+#include "extractor/compressed_geometry.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <sstream>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(compressed_geometry)
+
+using namespace osrm;
+using namespace osrm::extractor;
+using CompressedEdge = CompressedEdgeContainer::CompressedEdge;
+
+BOOST_AUTO_TEST_CASE(zigzag_varint_test)
+{
+    for (const std::int32_t value : {0, 1, -1, 63, -64, 64, 1 << 20, -(1 << 30), 0x7fffffff})
+    {
+        BOOST_CHECK_EQUAL(detail::decodeZigZag(detail::encodeZigZag(value)), value);
+    }
+
+    std::vector<unsigned char> data;
+    const std::vector<std::uint32_t> values = {0, 127, 128, 16383, 16384, 0xffffffff};
+    for (const auto value : values)
+    {
+        detail::encodeVarint(value, data);
+    }
+    BOOST_CHECK_EQUAL(data.size(), 1 + 1 + 2 + 2 + 3 + 5);
+
+    const unsigned char *position = data.data();
+    for (const auto value : values)
+    {
+        BOOST_CHECK_EQUAL(detail::decodeVarint(position), value);
+    }
+    BOOST_CHECK(position == data.data() + data.size());
+}
+
+BOOST_AUTO_TEST_CASE(round_trip_test)
+{
+    std::mt19937 generator(23);
+    std::uniform_int_distribution<NodeID> nodes(0, 1 << 30);
+    std::uniform_int_distribution<int> offsets(-50, 50);
+    std::uniform_int_distribution<EdgeWeight> weights(0, 1 << 20);
+    std::uniform_int_distribution<std::size_t> lengths(0, 12);
+
+    // more than a block, with empty geometries in between
+    std::vector<std::vector<CompressedEdge>> geometries(100);
+    for (auto &geometry : geometries)
+    {
+        const auto length = lengths(generator);
+        NodeID node = nodes(generator);
+        for (std::size_t i = 0; i < length; ++i)
+        {
+            // mostly close nodes, sometimes a large jump
+            node = i % 5 == 4 ? nodes(generator) : node + offsets(generator);
+            geometry.push_back(CompressedEdge{node, weights(generator)});
+        }
+    }
+    geometries[16].clear();
+    geometries.back().push_back(CompressedEdge{SPECIAL_NODEID - 1, 0});
+
+    CompressedGeometryEncoder encoder;
+    for (const auto &geometry : geometries)
+    {
+        encoder.Append(geometry.begin(), geometry.end());
+    }
+    std::stringstream stream;
+    encoder.Write(stream);
+
+    std::vector<unsigned> indices;
+    std::vector<CompressedEdge> points;
+    readCompressedGeometries(stream, indices, points);
+    BOOST_REQUIRE_EQUAL(indices.size(), geometries.size() + 1);
+
+    for (std::size_t id = 0; id < geometries.size(); ++id)
+    {
+        const auto &geometry = geometries[id];
+        BOOST_REQUIRE_EQUAL(indices[id + 1] - indices[id], geometry.size());
+        for (std::size_t i = 0; i < geometry.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL(points[indices[id] + i].node_id, geometry[i].node_id);
+            BOOST_CHECK_EQUAL(points[indices[id] + i].weight, geometry[i].weight);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(single_geometry_test)
+{
+    const std::vector<std::vector<CompressedEdge>> geometries = {
+        {{5, 1}, {3, 2}}, {}, {{100000, 7}, {1, 0}, {100001, 300}}};
+
+    CompressedGeometryEncoder encoder;
+    for (const auto &geometry : geometries)
+    {
+        encoder.Append(geometry.begin(), geometry.end());
+    }
+    std::stringstream stream;
+    encoder.Write(stream);
+
+    // the file layout that the data facades read
+    unsigned number_of_indices = 0;
+    stream.read(reinterpret_cast<char *>(&number_of_indices), sizeof(number_of_indices));
+    std::vector<unsigned> indices(number_of_indices);
+    stream.read(reinterpret_cast<char *>(indices.data()), sizeof(unsigned) * number_of_indices);
+    unsigned number_of_points = 0;
+    stream.read(reinterpret_cast<char *>(&number_of_points), sizeof(number_of_points));
+    BOOST_CHECK_EQUAL(number_of_points, 5);
+    unsigned number_of_blocks = 0;
+    stream.read(reinterpret_cast<char *>(&number_of_blocks), sizeof(number_of_blocks));
+    BOOST_CHECK_EQUAL(number_of_blocks, 1);
+    stream.ignore(detail::blockOffsetsPadding(number_of_indices));
+    std::vector<std::uint64_t> block_offsets(number_of_blocks);
+    stream.read(reinterpret_cast<char *>(block_offsets.data()),
+                sizeof(std::uint64_t) * number_of_blocks);
+    std::uint64_t number_of_bytes = 0;
+    stream.read(reinterpret_cast<char *>(&number_of_bytes), sizeof(number_of_bytes));
+    std::vector<unsigned char> data(number_of_bytes);
+    stream.read(reinterpret_cast<char *>(data.data()), number_of_bytes);
+    BOOST_REQUIRE(stream);
+
+    for (EdgeID id = 0; id < geometries.size(); ++id)
+    {
+        std::vector<CompressedEdge> decoded;
+        decodeCompressedGeometry(
+            indices, block_offsets, data, id, [&](const NodeID node, const EdgeWeight weight) {
+                decoded.push_back(CompressedEdge{node, weight});
+            });
+        BOOST_REQUIRE_EQUAL(decoded.size(), geometries[id].size());
+        for (std::size_t i = 0; i < decoded.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL(decoded[i].node_id, geometries[id][i].node_id);
+            BOOST_CHECK_EQUAL(decoded[i].weight, geometries[id][i].weight);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,13 +1,27 @@
 #include "extractor/graph_compressor.hpp"
 #include "extractor/compressed_edge_container.hpp"
+#include "extractor/query_node.hpp"
 #include "extractor/restriction_map.hpp"
+#include "util/coordinate.hpp"
+#include "util/coordinate_calculation.hpp"
 #include "util/node_based_graph.hpp"
 #include "util/typedefs.hpp"
 
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
 #include <boost/test/test_case_template.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 BOOST_AUTO_TEST_SUITE(graph_compressor)
 
@@ -543,4 +557,332 @@ BOOST_AUTO_TEST_CASE(direction_changes)
     BOOST_CHECK(graph.FindEdge(1, 2) != SPECIAL_EDGEID);
 }
 
+namespace
+{
+// Junctions connected by chains of degree 2 nodes with parallel chains, chains that return to
+// their junction, rings, one ways, name changes, barriers, traffic lights and restrictions
+struct RandomNetwork
+{
+    NodeID number_of_nodes = 0;
+    std::vector<InputEdge> edges;
+    std::unordered_set<NodeID> barrier_nodes;
+    std::unordered_set<NodeID> traffic_lights;
+    std::vector<TurnRestriction> restrictions;
+};
+
+RandomNetwork makeRandomNetwork(const unsigned seed)
+{
+    std::mt19937 generator(seed);
+    const auto random = [&](const unsigned bound) {
+        return std::uniform_int_distribution<unsigned>(0, bound - 1)(generator);
+    };
+
+    const unsigned number_of_junctions = 60;
+    std::vector<std::pair<NodeID, NodeID>> ways;
+    std::vector<std::pair<bool, unsigned>> way_data;
+    NodeID next_node = number_of_junctions;
+    const auto addChain = [&](const NodeID from, const NodeID to, const unsigned length) {
+        const bool oneway = random(4) == 0;
+        const unsigned name = random(3) == 0 ? 1 : 0;
+        NodeID previous = from;
+        for (unsigned index = 0; index < length; ++index)
+        {
+            ways.emplace_back(previous, next_node);
+            way_data.emplace_back(oneway, random(8) == 0 ? 1 - name : name);
+            previous = next_node++;
+        }
+        ways.emplace_back(previous, to);
+        way_data.emplace_back(oneway, name);
+    };
+    for (unsigned chain = 0; chain < 150; ++chain)
+    {
+        const NodeID from = random(number_of_junctions);
+        const NodeID to = random(8) == 0 ? from : random(number_of_junctions);
+        if (from == to)
+        {
+            addChain(from, to, 2 + random(4));
+        }
+        else
+        {
+            addChain(from, to, random(6));
+        }
+    }
+    // a ring without junctions
+    const NodeID ring_begin = next_node;
+    for (unsigned index = 0; index < 5; ++index)
+    {
+        ways.emplace_back(ring_begin + index, ring_begin + (index + 1) % 5);
+        way_data.emplace_back(false, 0);
+    }
+    next_node += 5;
+
+    RandomNetwork network;
+    network.number_of_nodes = next_node;
+    std::vector<NodeID> permutation(next_node);
+    std::iota(permutation.begin(), permutation.end(), 0);
+    std::shuffle(permutation.begin(), permutation.end(), generator);
+
+    for (std::size_t way = 0; way < ways.size(); ++way)
+    {
+        const NodeID source = permutation[ways[way].first];
+        const NodeID target = permutation[ways[way].second];
+        if (source == target)
+        {
+            continue;
+        }
+        const bool oneway = way_data[way].first;
+        const unsigned name = way_data[way].second;
+        const int weight = 1 + random(10);
+        const LaneDescriptionID lanes = random(5) == 0 ? random(3) : INVALID_LANE_DESCRIPTIONID;
+        network.edges.push_back({source,
+                                 target,
+                                 weight,
+                                 SPECIAL_EDGEID,
+                                 name,
+                                 false,
+                                 false,
+                                 false,
+                                 true,
+                                 TRAVEL_MODE_INACCESSIBLE,
+                                 lanes});
+        network.edges.push_back({target,
+                                 source,
+                                 weight,
+                                 SPECIAL_EDGEID,
+                                 name,
+                                 false,
+                                 oneway,
+                                 false,
+                                 true,
+                                 TRAVEL_MODE_INACCESSIBLE,
+                                 lanes});
+    }
+    std::stable_sort(network.edges.begin(), network.edges.end());
+
+    for (NodeID node = 0; node < next_node; ++node)
+    {
+        if (random(40) == 0)
+        {
+            network.barrier_nodes.insert(node);
+        }
+        else if (random(40) == 0)
+        {
+            network.traffic_lights.insert(node);
+        }
+    }
+
+    // from a neighbour over a junction to another neighbour
+    for (const auto &edge : network.edges)
+    {
+        if (random(10) != 0)
+        {
+            continue;
+        }
+        for (const auto &next : network.edges)
+        {
+            if (next.source == edge.target && next.target != edge.source)
+            {
+                TurnRestriction restriction(random(2) == 0);
+                restriction.from.node = edge.source;
+                restriction.via.node = edge.target;
+                restriction.to.node = next.target;
+                network.restrictions.push_back(restriction);
+                break;
+            }
+        }
+    }
+    return network;
+}
+
+std::string serializeGeometry(const CompressedEdgeContainer &container)
+{
+    const auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    container.SerializeInternalVector(path.string());
+    boost::filesystem::ifstream input(path, std::ios::binary);
+    const std::string bytes{std::istreambuf_iterator<char>(input),
+                            std::istreambuf_iterator<char>()};
+    boost::filesystem::remove(path);
+    return bytes;
+}
+}
+
+BOOST_AUTO_TEST_CASE(parallel_equals_serial)
+{
+    for (const unsigned seed : {1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u})
+    {
+        const auto network = makeRandomNetwork(seed);
+
+        Graph serial_graph(network.number_of_nodes, network.edges);
+        RestrictionMap serial_map(network.restrictions);
+        CompressedEdgeContainer serial_container;
+        GraphCompressor(GraphCompressor::Mode::Serial)
+            .Compress(network.barrier_nodes,
+                      network.traffic_lights,
+                      serial_map,
+                      serial_graph,
+                      serial_container);
+
+        Graph parallel_graph(network.number_of_nodes, network.edges);
+        RestrictionMap parallel_map(network.restrictions);
+        CompressedEdgeContainer parallel_container;
+        GraphCompressor(GraphCompressor::Mode::Parallel)
+            .Compress(network.barrier_nodes,
+                      network.traffic_lights,
+                      parallel_map,
+                      parallel_graph,
+                      parallel_container);
+
+        BOOST_REQUIRE_EQUAL(parallel_graph.GetNumberOfEdges(), serial_graph.GetNumberOfEdges());
+        for (NodeID node = 0; node < network.number_of_nodes; ++node)
+        {
+            BOOST_REQUIRE_EQUAL(parallel_graph.BeginEdges(node), serial_graph.BeginEdges(node));
+            BOOST_REQUIRE_EQUAL(parallel_graph.EndEdges(node), serial_graph.EndEdges(node));
+            for (const auto edge : serial_graph.GetAdjacentEdgeRange(node))
+            {
+                const auto &serial_data = serial_graph.GetEdgeData(edge);
+                const auto &parallel_data = parallel_graph.GetEdgeData(edge);
+                BOOST_CHECK_EQUAL(parallel_graph.GetTarget(edge), serial_graph.GetTarget(edge));
+                BOOST_CHECK_EQUAL(parallel_data.distance, serial_data.distance);
+                BOOST_CHECK_EQUAL(parallel_data.name_id, serial_data.name_id);
+                BOOST_CHECK_EQUAL(parallel_data.lane_description_id,
+                                  serial_data.lane_description_id);
+
+                BOOST_REQUIRE(parallel_container.HasEntryForID(edge));
+                BOOST_CHECK_EQUAL(parallel_container.GetPositionForID(edge),
+                                  serial_container.GetPositionForID(edge));
+                const auto &serial_bucket = serial_container.GetBucketReference(edge);
+                const auto &parallel_bucket = parallel_container.GetBucketReference(edge);
+                BOOST_REQUIRE_EQUAL(parallel_bucket.size(), serial_bucket.size());
+                for (std::size_t index = 0; index < serial_bucket.size(); ++index)
+                {
+                    BOOST_CHECK_EQUAL(parallel_bucket[index].node_id,
+                                      serial_bucket[index].node_id);
+                    BOOST_CHECK_EQUAL(parallel_bucket[index].weight, serial_bucket[index].weight);
+                }
+
+                // the turns from this edge
+                const auto via = serial_graph.GetTarget(edge);
+                BOOST_CHECK_EQUAL(parallel_map.CheckForEmanatingIsOnlyTurn(node, via),
+                                  serial_map.CheckForEmanatingIsOnlyTurn(node, via));
+                for (const auto next : serial_graph.GetAdjacentEdgeRange(via))
+                {
+                    const auto target = serial_graph.GetTarget(next);
+                    BOOST_CHECK_EQUAL(parallel_map.CheckIfTurnIsRestricted(node, via, target),
+                                      serial_map.CheckIfTurnIsRestricted(node, via, target));
+                }
+            }
+        }
+        BOOST_CHECK(serializeGeometry(parallel_container) == serializeGeometry(serial_container));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(static_graph)
+{
+    for (const unsigned seed : {1u, 2u, 3u})
+    {
+        const auto network = makeRandomNetwork(seed);
+        Graph graph(network.number_of_nodes, network.edges);
+        RestrictionMap map(network.restrictions);
+        CompressedEdgeContainer container;
+        GraphCompressor().Compress(
+            network.barrier_nodes, network.traffic_lights, map, graph, container);
+        const auto geometry = serializeGeometry(container);
+
+        std::vector<EdgeID> new_edge_ids;
+        const util::NodeBasedStaticGraph static_graph(graph, new_edge_ids);
+        CompressedEdgeContainer renumbered_container = container;
+        renumbered_container.RenumberEdges(new_edge_ids);
+
+        BOOST_REQUIRE_EQUAL(static_graph.GetNumberOfNodes(), graph.GetNumberOfNodes());
+        BOOST_REQUIRE_EQUAL(static_graph.GetNumberOfEdges(), graph.GetNumberOfEdges());
+        EdgeID next_edge = 0;
+        for (NodeID node = 0; node < network.number_of_nodes; ++node)
+        {
+            BOOST_REQUIRE_EQUAL(static_graph.GetOutDegree(node), graph.GetOutDegree(node));
+            BOOST_CHECK_EQUAL(static_graph.GetDirectedOutDegree(node),
+                              graph.GetDirectedOutDegree(node));
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                // the edges keep their order and are consecutive
+                const auto new_edge = new_edge_ids[edge];
+                BOOST_REQUIRE_EQUAL(new_edge, next_edge++);
+                BOOST_CHECK_EQUAL(static_graph.GetTarget(new_edge), graph.GetTarget(edge));
+                BOOST_CHECK_EQUAL(static_graph.GetEdgeData(new_edge).distance,
+                                  graph.GetEdgeData(edge).distance);
+                BOOST_CHECK_EQUAL(static_graph.FindEdge(node, graph.GetTarget(edge)),
+                                  new_edge_ids[graph.FindEdge(node, graph.GetTarget(edge))]);
+
+                BOOST_REQUIRE(renumbered_container.HasEntryForID(new_edge));
+                BOOST_CHECK_EQUAL(renumbered_container.GetPositionForID(new_edge),
+                                  container.GetPositionForID(edge));
+            }
+        }
+        BOOST_CHECK_EQUAL(static_graph.FindEdge(0, network.number_of_nodes), SPECIAL_EDGEID);
+        BOOST_CHECK(serializeGeometry(renumbered_container) == geometry);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(segment_lengths)
+{
+    //
+    // 0---1---2---3---4 along the equator, 0.001 degrees apart
+    //
+    std::vector<InputEdge> edges;
+    std::vector<QueryNode> nodes;
+    for (const NodeID node : {0u, 1u, 2u, 3u, 4u})
+    {
+        nodes.emplace_back(util::toFixed(util::FloatLongitude{0.001 * node}),
+                           util::toFixed(util::FloatLatitude{0.}),
+                           OSMNodeID{node});
+        if (node > 0)
+        {
+            for (const auto source : {node - 1, node})
+            {
+                edges.emplace_back(source,
+                                   source == node ? node - 1 : node,
+                                   1,
+                                   SPECIAL_EDGEID,
+                                   0,
+                                   false,
+                                   false,
+                                   false,
+                                   true,
+                                   TRAVEL_MODE_INACCESSIBLE,
+                                   INVALID_LANE_DESCRIPTIONID);
+            }
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::unordered_set<NodeID> barrier_nodes;
+    std::unordered_set<NodeID> traffic_lights;
+    RestrictionMap map;
+    CompressedEdgeContainer container;
+    Graph graph(5, edges);
+    GraphCompressor().Compress(barrier_nodes, traffic_lights, map, graph, container);
+    std::vector<EdgeID> new_edge_ids;
+    const util::NodeBasedStaticGraph static_graph(graph, new_edge_ids);
+    container.RenumberEdges(new_edge_ids);
+
+    const auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    container.SerializeSegmentLengths(path.string(), static_graph, nodes);
+    boost::filesystem::ifstream input(path, std::ios::binary);
+    std::uint64_t number_of_lengths = 0;
+    input.read(reinterpret_cast<char *>(&number_of_lengths), sizeof(number_of_lengths));
+    std::vector<SegmentLength> lengths(number_of_lengths);
+    input.read(reinterpret_cast<char *>(lengths.data()), sizeof(SegmentLength) * lengths.size());
+    BOOST_CHECK(input);
+    input.close();
+    boost::filesystem::remove(path);
+
+    // both directions of the road are compressed into a geometry of four segments
+    const auto expected_length = util::coordinate_calculation::haversineDistance(
+        util::Coordinate{nodes[0].lon, nodes[0].lat}, util::Coordinate{nodes[1].lon, nodes[1].lat});
+    BOOST_CHECK_EQUAL(number_of_lengths, 8);
+    for (const auto length : lengths)
+    {
+        BOOST_CHECK_CLOSE(length, expected_length, 0.01);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,82 @@
+#include "extractor/hybrid_sort.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(hybrid_sort)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+namespace
+{
+std::vector<std::pair<unsigned, unsigned>> makeRandomPairs(const std::size_t size)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<unsigned> distribution(0, 100);
+    std::vector<std::pair<unsigned, unsigned>> pairs;
+    for (std::size_t index = 0; index < size; ++index)
+    {
+        pairs.emplace_back(distribution(generator), index);
+    }
+    return pairs;
+}
+
+const auto by_first = [](const std::pair<unsigned, unsigned> &lhs,
+                         const std::pair<unsigned, unsigned> &rhs) {
+    return lhs.first < rhs.first;
+};
+}
+
+BOOST_AUTO_TEST_CASE(in_memory)
+{
+    auto pairs = makeRandomPairs(1000);
+    auto reference = pairs;
+
+    hybridSort(pairs, by_first, 1000 * sizeof(pairs.front()));
+
+    BOOST_CHECK(std::is_sorted(pairs.begin(), pairs.end(), by_first));
+    std::sort(pairs.begin(), pairs.end());
+    std::sort(reference.begin(), reference.end());
+    BOOST_CHECK(pairs == reference);
+}
+
+BOOST_AUTO_TEST_CASE(merged_runs)
+{
+    // 7 runs of 150 elements, the last one is shorter
+    auto pairs = makeRandomPairs(1000);
+    auto reference = pairs;
+
+    hybridSort(pairs, by_first, 150 * sizeof(pairs.front()));
+
+    BOOST_CHECK_EQUAL(pairs.size(), reference.size());
+    BOOST_CHECK(std::is_sorted(pairs.begin(), pairs.end(), by_first));
+    std::sort(pairs.begin(), pairs.end());
+    std::sort(reference.begin(), reference.end());
+    BOOST_CHECK(pairs == reference);
+}
+
+BOOST_AUTO_TEST_CASE(tiny_budget)
+{
+    std::vector<unsigned> values = {5, 3, 9, 1, 1, 7, 0};
+
+    hybridSort(values, std::less<unsigned>(), 1);
+
+    const std::vector<unsigned> reference = {0, 1, 1, 3, 5, 7, 9};
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(), reference.begin(), reference.end());
+}
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+    std::vector<unsigned> values;
+    hybridSort(values, std::less<unsigned>(), 1024);
+    BOOST_CHECK(values.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
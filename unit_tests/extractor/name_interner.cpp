@@ -0,0 +1,62 @@
+#include "extractor/name_interner.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(name_interner)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+BOOST_AUTO_TEST_CASE(deduplicate_names)
+{
+    NameInterner interner;
+    BOOST_CHECK_EQUAL(interner.Intern(NameInterner::MakeKey("", "", "", ""), 0), 0);
+    BOOST_CHECK_EQUAL(interner.Intern(NameInterner::MakeKey("Main", "", "", "A1"), 4), 4);
+    BOOST_CHECK_EQUAL(interner.Intern(NameInterner::MakeKey("Main", "", "A1", ""), 8), 8);
+    BOOST_CHECK_EQUAL(interner.Intern(NameInterner::MakeKey("Mai", "n", "", "A1"), 12), 12);
+
+    // the strings of the keys are copied, the key of a name can outlive them
+    std::string name = "Main";
+    BOOST_CHECK_EQUAL(interner.Intern(NameInterner::MakeKey(name, "", "", "A1"), 16), 4);
+    name = "Side";
+    BOOST_CHECK_EQUAL(interner.Intern(NameInterner::MakeKey("Main", "", "A1", ""), 16), 8);
+    BOOST_CHECK_EQUAL(interner.Intern(NameInterner::MakeKey("", "", "", ""), 16), 0);
+    BOOST_CHECK_EQUAL(interner.Size(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(truncate_long_names)
+{
+    NameInterner interner;
+    const std::string long_name(300, 'x');
+    const auto key = NameInterner::MakeKey(long_name, "", "", "");
+    BOOST_CHECK_EQUAL(key.strings[0].size(), NameInterner::MAX_STRING_LENGTH);
+    BOOST_CHECK_EQUAL(interner.Intern(key, 0), 0);
+    BOOST_CHECK_EQUAL(interner.Intern(NameInterner::MakeKey(long_name + "y", "", "", ""), 4), 0);
+}
+
+BOOST_AUTO_TEST_CASE(many_names)
+{
+    // grows the table and fills more than one block of the arena
+    NameInterner interner;
+    std::vector<std::string> names;
+    for (unsigned index = 0; index < 20000; ++index)
+    {
+        names.push_back(std::to_string(index) + std::string(100, 'n'));
+    }
+    for (unsigned index = 0; index < names.size(); ++index)
+    {
+        const auto key = NameInterner::MakeKey(names[index], "", std::to_string(index), "");
+        BOOST_CHECK_EQUAL(interner.Intern(key, index), index);
+    }
+    for (unsigned index = 0; index < names.size(); ++index)
+    {
+        const auto key = NameInterner::MakeKey(names[index], "", std::to_string(index), "");
+        BOOST_CHECK_EQUAL(interner.Intern(key, names.size()), index);
+    }
+    BOOST_CHECK_EQUAL(interner.Size(), names.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
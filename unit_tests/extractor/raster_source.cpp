@@ -7,6 +7,8 @@
 #include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(raster_source)
 
 using namespace osrm;
@@ -79,4 +81,60 @@ BOOST_AUTO_TEST_CASE(raster_test)
         util::exception);
 }
 
+BOOST_AUTO_TEST_CASE(tiled_raster_test)
+{
+    const auto tiles_path =
+        boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    RasterGrid::Load("../unit_tests/fixtures/raster_data.asc", 10, 10).WriteTiles(tiles_path);
+
+    // the tiled copy answers like the ASCII grid
+    SourceContainer sources;
+    BOOST_CHECK_EQUAL(sources.LoadRasterSource(
+                          "../unit_tests/fixtures/raster_data.asc", 1, 1.09, 1, 1.09, 10, 10),
+                      0);
+    BOOST_CHECK_EQUAL(sources.LoadRasterSource(tiles_path.string(), 1, 1.09, 1, 1.09, 10, 10), 1);
+    for (const auto lon : {1.00, 1.01, 1.054, 1.056, 1.08, 1.09})
+    {
+        for (const auto lat : {1.00, 1.023, 1.028, 1.05, 1.07, 1.09})
+        {
+            BOOST_CHECK_EQUAL(sources.GetRasterDataFromSource(1, lon, lat).datum,
+                              sources.GetRasterDataFromSource(0, lon, lat).datum);
+            BOOST_CHECK_EQUAL(sources.GetRasterInterpolateFromSource(1, lon, lat).datum,
+                              sources.GetRasterInterpolateFromSource(0, lon, lat).datum);
+        }
+    }
+
+    // a tiled raster knows its dimensions
+    SourceContainer other_sources;
+    BOOST_CHECK_THROW(
+        other_sources.LoadRasterSource(tiles_path.string(), 1, 1.09, 1, 1.09, 10, 11),
+        util::exception);
+    boost::filesystem::remove(tiles_path);
+}
+
+BOOST_AUTO_TEST_CASE(batch_interpolate_test)
+{
+    SourceContainer sources;
+    sources.LoadRasterSource("../unit_tests/fixtures/raster_data.asc", 1, 1.09, 1, 1.09, 10, 10);
+
+    const std::vector<util::Coordinate> coordinates = {
+        {util::FloatLongitude{1.054}, util::FloatLatitude{1.023}},
+        {util::FloatLongitude{-1.1}, util::FloatLatitude{1.07}},
+        {util::FloatLongitude{1.09}, util::FloatLatitude{1.07}},
+        {util::FloatLongitude{1.00}, util::FloatLatitude{1.00}},
+        {util::FloatLongitude{1.056}, util::FloatLatitude{1.028}}};
+    std::vector<RasterDatum> data;
+    sources.GetRasterInterpolateFromSource(0, coordinates, data);
+
+    BOOST_REQUIRE_EQUAL(data.size(), coordinates.size());
+    BOOST_CHECK_EQUAL(data[0].datum, 53);
+    BOOST_CHECK_EQUAL(data[1].datum, RasterDatum::get_invalid());
+    BOOST_CHECK_EQUAL(data[2].datum, 140);
+    BOOST_CHECK_EQUAL(data[3].datum, 10);
+    BOOST_CHECK_EQUAL(data[4].datum, 68);
+
+    BOOST_CHECK_THROW(sources.GetRasterInterpolateFromSource(1, coordinates, data),
+                      util::exception);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,184 @@
+#include "extractor/tarjan_scc.hpp"
+#include "util/integer_range.hpp"
+#include "util/matrix_graph_wrapper.hpp"
+#include "util/static_graph.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(tarjan_scc)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+struct EdgeData
+{
+};
+using Graph = util::StaticGraph<EdgeData>;
+using SCC = TarjanSCC<Graph>;
+
+namespace
+{
+std::shared_ptr<const Graph> makeGraph(const unsigned number_of_nodes,
+                                       std::vector<std::pair<NodeID, NodeID>> edges)
+{
+    std::sort(edges.begin(), edges.end());
+    std::vector<Graph::InputEdge> input_edges;
+    for (const auto &edge : edges)
+    {
+        input_edges.emplace_back(edge.first, edge.second);
+    }
+    return std::make_shared<const Graph>(number_of_nodes, input_edges);
+}
+
+// random graph of a ring with shortcuts and a tail of one way edges
+std::shared_ptr<const Graph> makeRandomGraph(const unsigned number_of_nodes, const unsigned seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<NodeID> node(0, number_of_nodes - 1);
+    std::vector<std::pair<NodeID, NodeID>> edges;
+    for (NodeID source = 0; source < number_of_nodes; ++source)
+    {
+        if (source % 7 != 0)
+        {
+            edges.emplace_back(source, (source + 1) % number_of_nodes);
+        }
+        edges.emplace_back(source, node(generator));
+    }
+    return makeGraph(number_of_nodes, std::move(edges));
+}
+
+// two nodes are in the same component if they reach each other
+void checkComponents(const Graph &graph, const SCC &scc)
+{
+    const auto number_of_nodes = graph.GetNumberOfNodes();
+    std::vector<std::vector<bool>> reaches(number_of_nodes);
+    for (NodeID source = 0; source < number_of_nodes; ++source)
+    {
+        auto &reached = reaches[source];
+        reached.resize(number_of_nodes, false);
+        std::vector<NodeID> queue = {source};
+        reached[source] = true;
+        while (!queue.empty())
+        {
+            const auto node = queue.back();
+            queue.pop_back();
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                const auto target = graph.GetTarget(edge);
+                if (!reached[target])
+                {
+                    reached[target] = true;
+                    queue.push_back(target);
+                }
+            }
+        }
+    }
+
+    std::vector<unsigned> sizes(scc.GetNumberOfComponents(), 0);
+    for (NodeID node = 0; node < number_of_nodes; ++node)
+    {
+        BOOST_REQUIRE_LT(scc.GetComponentID(node), scc.GetNumberOfComponents());
+        ++sizes[scc.GetComponentID(node)];
+        for (NodeID other = 0; other < number_of_nodes; ++other)
+        {
+            const bool strongly_connected = reaches[node][other] && reaches[other][node];
+            BOOST_CHECK_EQUAL(scc.GetComponentID(node) == scc.GetComponentID(other),
+                              strongly_connected);
+        }
+    }
+    for (unsigned component = 0; component < sizes.size(); ++component)
+    {
+        BOOST_CHECK_EQUAL(scc.GetComponentSize(component), sizes[component]);
+    }
+}
+}
+
+BOOST_AUTO_TEST_CASE(small_graph)
+{
+    // 0 <-> 1 -> 2 <-> 3, 4 alone
+    const auto graph = makeGraph(5, {{0, 1}, {1, 0}, {1, 2}, {2, 3}, {3, 2}});
+    SCC scc(graph);
+    scc.Run();
+
+    BOOST_CHECK_EQUAL(scc.GetNumberOfComponents(), 3);
+    BOOST_CHECK_EQUAL(scc.GetSizeOneCount(), 1);
+    // components are found in reverse topological order
+    BOOST_CHECK_EQUAL(scc.GetComponentID(2), 0);
+    BOOST_CHECK_EQUAL(scc.GetComponentID(3), 0);
+    BOOST_CHECK_EQUAL(scc.GetComponentID(0), 1);
+    BOOST_CHECK_EQUAL(scc.GetComponentID(1), 1);
+    BOOST_CHECK_EQUAL(scc.GetComponentID(4), 2);
+    checkComponents(*graph, scc);
+}
+
+BOOST_AUTO_TEST_CASE(random_graphs)
+{
+    // below and above the size that runs on fixed stacks
+    for (const unsigned number_of_nodes : {50u, 300u})
+    {
+        const auto graph = makeRandomGraph(number_of_nodes, number_of_nodes);
+        SCC scc(graph);
+        scc.Run();
+        checkComponents(*graph, scc);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_pivot_component)
+{
+    const auto graph = makeRandomGraph(2000, 42);
+    SCC sequential(graph);
+    sequential.Run();
+    SCC parallel(graph, 0);
+    parallel.Run();
+
+    BOOST_CHECK_EQUAL(parallel.GetNumberOfComponents(), sequential.GetNumberOfComponents());
+    BOOST_CHECK_EQUAL(parallel.GetSizeOneCount(), sequential.GetSizeOneCount());
+    checkComponents(*graph, parallel);
+}
+
+BOOST_AUTO_TEST_CASE(topological_order)
+{
+    // 4 -> 0 <-> 1 -> 2 <-> 3, 5 -> 3
+    const auto small_graph =
+        makeGraph(6, {{0, 1}, {1, 0}, {1, 2}, {2, 3}, {3, 2}, {4, 0}, {5, 3}});
+    const auto random_graph = makeRandomGraph(300, 7);
+    for (const auto &graph : {small_graph, random_graph})
+    {
+        SCC scc(graph, 0);
+        scc.Run();
+        scc.OrderComponentsTopologically();
+        checkComponents(*graph, scc);
+        for (const auto node : util::irange(0u, graph->GetNumberOfNodes()))
+        {
+            for (const auto edge : graph->GetAdjacentEdgeRange(node))
+            {
+                BOOST_CHECK_LE(scc.GetComponentID(node),
+                               scc.GetComponentID(graph->GetTarget(edge)));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(matrix_graph)
+{
+    const auto X = INVALID_EDGE_WEIGHT;
+    // 0 <-> 1, 2 -> 0
+    const std::vector<EdgeWeight> table = {0, 1, X, 1, 0, X, 1, X, 0};
+    const auto graph = std::make_shared<util::MatrixGraphWrapper<EdgeWeight>>(table, 3);
+    TarjanSCC<util::MatrixGraphWrapper<EdgeWeight>> scc(graph);
+    scc.Run();
+
+    BOOST_CHECK_EQUAL(scc.GetNumberOfComponents(), 2);
+    BOOST_CHECK_EQUAL(scc.GetComponentID(0), scc.GetComponentID(1));
+    BOOST_CHECK_EQUAL(scc.GetComponentSize(scc.GetComponentID(0)), 2);
+    BOOST_CHECK_EQUAL(scc.GetComponentSize(scc.GetComponentID(2)), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
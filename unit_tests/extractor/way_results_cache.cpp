@@ -0,0 +1,76 @@
+#include "extractor/way_results_cache.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(way_results_cache)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+BOOST_AUTO_TEST_CASE(reuse_results_of_unchanged_ways)
+{
+    using namespace osmium::builder::attr;
+    osmium::memory::Buffer buffer(1024, osmium::memory::Buffer::auto_grow::yes);
+    osmium::builder::add_way(buffer, _id(1), _version(1), _nodes({1, 2}));
+    osmium::builder::add_way(buffer, _id(2), _version(1), _nodes({2, 3}));
+    osmium::builder::add_way(buffer, _id(3), _version(1), _nodes({3, 4}));
+    osmium::builder::add_way(buffer, _id(2), _version(2), _nodes({2, 5}));
+    auto iter = buffer.begin<osmium::Way>();
+    const auto &way_1 = *iter++;
+    const auto &way_2 = *iter++;
+    const auto &way_3 = *iter++;
+    const auto &changed_way_2 = *iter++;
+
+    ExtractionWay result;
+    result.forward_speed = 50;
+    result.backward_speed = 40;
+    result.forward_travel_mode = TRAVEL_MODE_DRIVING;
+    result.backward_travel_mode = TRAVEL_MODE_DRIVING;
+    result.name = "Hauptstraße";
+    result.turn_lanes_forward = "left|through";
+    result.road_classification.SetMotorwayFlag(true);
+    const ExtractionWay unroutable;
+
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("way-results-%%%%%%%%");
+    {
+        WayResultsCache cache(path, 42);
+        BOOST_CHECK(!cache.Find(way_1, result));
+        cache.Add(way_1, result);
+        cache.Add(way_2, result);
+        cache.Add(way_3, unroutable);
+        cache.Finish();
+    }
+    {
+        WayResultsCache cache(path, 42);
+        ExtractionWay cached;
+        BOOST_CHECK(cache.Find(way_1, cached));
+        BOOST_CHECK_EQUAL(cached.forward_speed, 50);
+        BOOST_CHECK_EQUAL(cached.backward_speed, 40);
+        BOOST_CHECK_EQUAL(cached.name, "Hauptstraße");
+        BOOST_CHECK_EQUAL(cached.turn_lanes_forward, "left|through");
+        BOOST_CHECK_EQUAL(cached.forward_travel_mode, TRAVEL_MODE_DRIVING);
+        BOOST_CHECK(cached.road_classification == result.road_classification);
+        // another version of the way
+        BOOST_CHECK(!cache.Find(changed_way_2, cached));
+        BOOST_CHECK(cache.Find(way_3, cached));
+        BOOST_CHECK_EQUAL(cached.forward_speed, -1);
+        BOOST_CHECK_EQUAL(cache.GetNumberOfHits(), 2);
+        cache.Finish();
+    }
+    {
+        // the results of another profile
+        WayResultsCache cache(path, 43);
+        ExtractionWay cached;
+        BOOST_CHECK(!cache.Find(way_1, cached));
+        cache.Finish();
+    }
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,116 @@
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "args.hpp"
+#include "coordinates.hpp"
+#include "fixture.hpp"
+
+#include "osrm/table_parameters.hpp"
+#include "osrm/table_result.hpp"
+
+#include "osrm/async.hpp"
+#include "osrm/coordinate.hpp"
+#include "osrm/engine_config.hpp"
+#include "osrm/json_container.hpp"
+#include "osrm/osrm.hpp"
+#include "osrm/status.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(async)
+
+namespace
+{
+osrm::TableParameters getTableParameters()
+{
+    osrm::TableParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    return params;
+}
+}
+
+BOOST_AUTO_TEST_CASE(test_async_table_matches_sync)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    const auto params = getTableParameters();
+    TableResult expected;
+    BOOST_REQUIRE(osrm.Table(params, expected) == Status::Ok);
+
+    std::vector<std::future<AsyncResponse<TableResult>>> futures;
+    for (auto index = 0; index < 8; ++index)
+    {
+        futures.push_back(osrm.Async<TableResult>(params));
+    }
+    for (auto &future : futures)
+    {
+        const auto response = future.get();
+        BOOST_REQUIRE(response.status == Status::Ok);
+        BOOST_CHECK_EQUAL(response.result.code, "Ok");
+        BOOST_REQUIRE_EQUAL(response.result.durations.size(), expected.durations.size());
+        for (std::size_t index = 0; index < expected.durations.size(); ++index)
+        {
+            BOOST_CHECK_EQUAL(response.result.durations[index], expected.durations[index]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_async_callback)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    std::promise<json::Object> promise;
+    auto future = promise.get_future();
+    osrm.Async<json::Object>(getTableParameters(),
+                             std::function<void(AsyncResponse<json::Object>)>(
+                                 [&promise](AsyncResponse<json::Object> response) {
+                                     promise.set_value(std::move(response.result));
+                                 }));
+
+    const auto result = future.get();
+    BOOST_CHECK_EQUAL(result.values.at("code").get<json::String>().value, "Ok");
+}
+
+BOOST_AUTO_TEST_CASE(test_async_cancelled)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    AsyncOptions options;
+    options.cancelled = std::make_shared<const std::atomic<bool>>(true);
+
+    const auto response = osrm.Async<TableResult>(getTableParameters(), options).get();
+    BOOST_CHECK(response.status == Status::Error);
+    BOOST_CHECK_EQUAL(response.result.code, "Cancelled");
+}
+
+BOOST_AUTO_TEST_CASE(test_async_deadline)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    AsyncOptions options;
+    options.deadline = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+
+    const auto response = osrm.Async<json::Object>(getTableParameters(), options).get();
+    BOOST_CHECK(response.status == Status::Timeout);
+    BOOST_CHECK_EQUAL(response.result.values.at("code").get<json::String>().value, "Timeout");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 
 #include "osrm/coordinate.hpp"
 
+#include <cstddef>
 #include <vector>
 
 // Somewhere in 2b8dd9343d5e615afc9c67bcc7028a63 Monaco
@@ -32,4 +33,19 @@ inline Locations get_locations_in_big_component()
             {Longitude{7.421315}, Latitude{43.738814}}};
 }
 
+// Locations on a grid over Monaco, many of them snap to the same segments
+inline Locations get_grid_locations(const std::size_t columns, const std::size_t rows)
+{
+    Locations locations;
+    for (std::size_t row = 0; row < rows; ++row)
+    {
+        for (std::size_t column = 0; column < columns; ++column)
+        {
+            locations.push_back({Longitude{7.409 + 0.03 * column / columns},
+                                 Latitude{43.725 + 0.026 * row / rows}});
+        }
+    }
+    return locations;
+}
+
 #endif
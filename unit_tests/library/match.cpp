@@ -6,7 +6,10 @@
 #include "fixture.hpp"
 #include "waypoint_check.hpp"
 
+#include "osrm/match_batch_parameters.hpp"
+#include "osrm/match_batch_result.hpp"
 #include "osrm/match_parameters.hpp"
+#include "osrm/match_stream_parameters.hpp"
 
 #include "osrm/coordinate.hpp"
 #include "osrm/engine_config.hpp"
@@ -14,6 +17,12 @@
 #include "osrm/osrm.hpp"
 #include "osrm/status.hpp"
 
+#include "util/coordinate_calculation.hpp"
+#include "util/integer_range.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
 BOOST_AUTO_TEST_SUITE(match)
 
 BOOST_AUTO_TEST_CASE(test_match)
@@ -68,4 +77,176 @@ BOOST_AUTO_TEST_CASE(test_match)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_match_big_component)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    MatchParameters params;
+    params.coordinates = get_locations_in_big_component();
+
+    json::Object result;
+    const auto rc = osrm.Match(params, result);
+    BOOST_CHECK(rc == Status::Ok);
+    BOOST_CHECK_EQUAL(result.values.at("code").get<json::String>().value, "Ok");
+
+    // the locations are a few hundred meters apart on connected roads
+    const auto &tracepoints = result.values.at("tracepoints").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(tracepoints.size(), params.coordinates.size());
+    for (const auto &waypoint : tracepoints)
+    {
+        BOOST_CHECK(waypoint_check(waypoint));
+    }
+
+    const auto &matchings = result.values.at("matchings").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(matchings.size(), 1);
+    const auto &matching = matchings.front().get<json::Object>();
+    const auto distance = matching.values.at("distance").get<json::Number>().value;
+    BOOST_CHECK_GE(distance,
+                   util::coordinate_calculation::haversineDistance(params.coordinates.front(),
+                                                                   params.coordinates.back()) -
+                       100);
+    BOOST_CHECK_EQUAL(matching.values.at("legs").get<json::Array>().values.size(),
+                      params.coordinates.size() - 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_match_stream)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    EngineConfig config;
+    config.storage_config = {args[0]};
+    config.use_shared_memory = false;
+    config.max_match_sessions = 4;
+    config.max_match_session_points = 4;
+    OSRM osrm{config};
+
+    const auto locations = get_locations_in_big_component();
+
+    // the points come in one by one, every tracepoint is returned exactly once
+    std::size_t number_of_tracepoints = 0;
+    std::size_t number_of_legs = 0;
+    for (const auto i : util::irange<std::size_t>(0UL, locations.size() + 1))
+    {
+        MatchStreamParameters params;
+        params.session = "vehicle";
+        if (i < locations.size())
+        {
+            params.coordinates.push_back(locations[i]);
+        }
+        else
+        {
+            params.finish = true;
+        }
+
+        json::Object result;
+        const auto rc = osrm.MatchStream(params, result);
+        BOOST_REQUIRE(rc == Status::Ok);
+        BOOST_CHECK_EQUAL(result.values.at("code").get<json::String>().value, "Ok");
+        BOOST_CHECK_EQUAL(result.values.at("first_tracepoint").get<json::Number>().value,
+                          number_of_tracepoints);
+
+        const auto &tracepoints = result.values.at("tracepoints").get<json::Array>().values;
+        number_of_tracepoints += tracepoints.size();
+        for (const auto &waypoint : tracepoints)
+        {
+            BOOST_CHECK(waypoint_check(waypoint));
+        }
+
+        const auto pending = result.values.at("pending").get<json::Number>().value;
+        BOOST_CHECK_EQUAL(number_of_tracepoints + pending, std::min(i + 1, locations.size()));
+        // the session doesn't keep more than its points
+        BOOST_CHECK_LE(pending, config.max_match_session_points);
+
+        for (const auto &matching : result.values.at("matchings").get<json::Array>().values)
+        {
+            number_of_legs +=
+                matching.get<json::Object>().values.at("legs").get<json::Array>().values.size();
+        }
+    }
+    BOOST_CHECK_EQUAL(number_of_tracepoints, locations.size());
+    // the pieces of the trace are connected at their boundary points
+    BOOST_CHECK_EQUAL(number_of_legs, locations.size() - 1);
+
+    // sessions are opt-in
+    auto disabled_osrm = getOSRM(args[0]);
+    MatchStreamParameters params;
+    params.session = "vehicle";
+    params.coordinates.push_back(locations.front());
+    json::Object result;
+    BOOST_CHECK(disabled_osrm.MatchStream(params, result) == Status::Error);
+    BOOST_CHECK_EQUAL(result.values.at("code").get<json::String>().value, "NotImplemented");
+}
+
+BOOST_AUTO_TEST_CASE(test_match_batch)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    MatchParameters trace;
+    trace.coordinates = get_locations_in_big_component();
+    for (const auto i : util::irange<unsigned>(0, trace.coordinates.size()))
+    {
+        trace.timestamps.push_back(1000 + 30 * i);
+    }
+    MatchParameters invalid_trace;
+    invalid_trace.coordinates.emplace_back(util::FloatLongitude{200}, util::FloatLatitude{100});
+    invalid_trace.coordinates.push_back(get_dummy_location());
+
+    MatchBatchParameters params;
+    params.durations = true;
+    params.traces = {trace, invalid_trace, trace};
+
+    MatchBatchResult result;
+    const auto rc = osrm.MatchBatch(params, result);
+    BOOST_CHECK(rc == Status::Ok);
+    BOOST_CHECK_EQUAL(result.code, "Ok");
+    BOOST_REQUIRE_EQUAL(result.traces.size(), params.traces.size());
+
+    // a trace that can't be matched doesn't fail the others
+    BOOST_CHECK_EQUAL(result.traces[1].code, "InvalidValue");
+    BOOST_CHECK(result.traces[1].tracepoints.empty());
+
+    json::Object reference;
+    BOOST_REQUIRE(osrm.Match(trace, reference) == Status::Ok);
+    const auto &reference_matching =
+        reference.values.at("matchings").get<json::Array>().values.front().get<json::Object>();
+
+    for (const auto index : {0, 2})
+    {
+        const auto &matched_trace = result.traces[index];
+        BOOST_CHECK_EQUAL(matched_trace.code, "Ok");
+        BOOST_REQUIRE_EQUAL(matched_trace.tracepoints.size(), trace.coordinates.size());
+        BOOST_REQUIRE_EQUAL(matched_trace.matchings.size(), 1);
+        for (const auto i : util::irange<std::size_t>(0UL, trace.coordinates.size()))
+        {
+            const auto &tracepoint = matched_trace.tracepoints[i];
+            BOOST_CHECK(tracepoint.matchings_index == 0);
+            BOOST_CHECK(tracepoint.forward_segment_id != SPECIAL_NODEID ||
+                        tracepoint.reverse_segment_id != SPECIAL_NODEID);
+            BOOST_CHECK_EQUAL(tracepoint.timestamp, trace.timestamps[i]);
+        }
+
+        const auto &matching = matched_trace.matchings.front();
+        BOOST_CHECK_CLOSE(matching.confidence,
+                          reference_matching.values.at("confidence").get<json::Number>().value,
+                          1e-6);
+        // deci-seconds, the reference is rounded from the assembled legs
+        BOOST_CHECK_CLOSE(matching.duration / 10.,
+                          reference_matching.values.at("duration").get<json::Number>().value,
+                          1);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
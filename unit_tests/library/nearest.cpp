@@ -6,6 +6,7 @@
 #include "fixture.hpp"
 
 #include "osrm/nearest_parameters.hpp"
+#include "osrm/nearest_result.hpp"
 
 #include "osrm/coordinate.hpp"
 #include "osrm/engine_config.hpp"
@@ -70,13 +71,39 @@ BOOST_AUTO_TEST_CASE(test_nearest_response_multiple_coordinates)
     NearestParameters params;
     params.coordinates.push_back(get_dummy_location());
     params.coordinates.push_back(get_dummy_location());
+    params.radiuses.push_back(boost::none);
+    params.radiuses.push_back(50.);
 
     json::Object result;
     const auto rc = osrm.Nearest(params, result);
-    BOOST_REQUIRE(rc == Status::Error);
+    BOOST_REQUIRE(rc == Status::Ok);
 
     const auto code = result.values.at("code").get<json::String>().value;
-    BOOST_CHECK_EQUAL(code, "InvalidOptions");
+    BOOST_CHECK_EQUAL(code, "Ok");
+    BOOST_CHECK(result.values.find("waypoints") == result.values.end());
+
+    // a result for each coordinate
+    const auto &results = result.values.at("results").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(results.size(), 2);
+    for (const auto &coordinate_result : results)
+    {
+        const auto &result_object = coordinate_result.get<json::Object>();
+        const auto result_code = result_object.values.at("code").get<json::String>().value;
+        if (result_code == "NoSegment")
+        {
+            continue;
+        }
+        BOOST_CHECK_EQUAL(result_code, "Ok");
+
+        const auto &waypoints = result_object.values.at("waypoints").get<json::Array>().values;
+        BOOST_CHECK(!waypoints.empty());
+        for (const auto &waypoint : waypoints)
+        {
+            const auto &waypoint_object = waypoint.get<json::Object>();
+            const auto distance = waypoint_object.values.at("distance").get<json::Number>().value;
+            BOOST_CHECK(distance >= 0);
+        }
+    }
 }
 
 BOOST_AUTO_TEST_CASE(test_nearest_response_for_location_in_small_component)
@@ -113,4 +140,33 @@ BOOST_AUTO_TEST_CASE(test_nearest_response_for_location_in_small_component)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_nearest_typed_result)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    NearestParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.number_of_results = 3;
+
+    NearestResult result;
+    BOOST_REQUIRE(osrm.Nearest(params, result) == Status::Ok);
+    BOOST_CHECK_EQUAL(result.code, "Ok");
+
+    BOOST_REQUIRE_EQUAL(result.results.size(), params.coordinates.size());
+    for (const auto &waypoints : result.results)
+    {
+        BOOST_CHECK(!waypoints.empty());
+        BOOST_CHECK(waypoints.size() <= params.number_of_results);
+        for (const auto &waypoint : waypoints)
+        {
+            BOOST_CHECK(waypoint.location.IsValid());
+            BOOST_CHECK(waypoint.distance >= 0);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
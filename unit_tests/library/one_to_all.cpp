@@ -0,0 +1,104 @@
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "args.hpp"
+#include "coordinates.hpp"
+#include "fixture.hpp"
+
+#include "engine/hint.hpp"
+
+#include "osrm/one_to_all_parameters.hpp"
+#include "osrm/one_to_all_result.hpp"
+#include "osrm/table_parameters.hpp"
+
+#include "osrm/coordinate.hpp"
+#include "osrm/json_container.hpp"
+#include "osrm/osrm.hpp"
+#include "osrm/status.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+BOOST_AUTO_TEST_SUITE(one_to_all)
+
+BOOST_AUTO_TEST_CASE(test_one_to_all_sizes)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    OneToAllParameters params;
+    params.coordinates = get_locations_in_big_component();
+
+    OneToAllResult result;
+    const auto rc = osrm.OneToAll(params, result);
+
+    BOOST_REQUIRE(rc == Status::Ok);
+    BOOST_CHECK_EQUAL(result.code, "Ok");
+    BOOST_CHECK_EQUAL(result.number_of_sources, params.coordinates.size());
+    BOOST_CHECK_EQUAL(result.durations.size(),
+                      result.number_of_sources * result.number_of_nodes);
+}
+
+// The duration of a table entry is where the search from its source meets the search to its
+// target, at one of the segments of the target. The one-to-all durations of a target to its own
+// segments are the negative offsets of the target on them, so the entry is the smallest
+// difference between the durations of the source and the target to a segment of the target.
+BOOST_AUTO_TEST_CASE(test_one_to_all_matches_table)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+    const auto locations = get_locations_in_big_component();
+
+    OneToAllParameters one_to_all_params;
+    one_to_all_params.coordinates = locations;
+    OneToAllResult one_to_all;
+    BOOST_REQUIRE(osrm.OneToAll(one_to_all_params, one_to_all) == Status::Ok);
+    const auto number_of_sources = one_to_all.number_of_sources;
+    const auto duration = [&](const std::size_t source_idx, const NodeID node) {
+        return one_to_all.durations[node * number_of_sources + source_idx];
+    };
+
+    TableParameters table_params;
+    table_params.coordinates = locations;
+    json::Object table;
+    BOOST_REQUIRE(osrm.Table(table_params, table) == Status::Ok);
+    const auto &durations = table.values.at("durations").get<json::Array>().values;
+    const auto &destinations = table.values.at("destinations").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(durations.size(), locations.size());
+    BOOST_REQUIRE_EQUAL(destinations.size(), locations.size());
+
+    for (const auto target_idx : {1u, 2u})
+    {
+        const auto &destination = destinations[target_idx].get<json::Object>();
+        const auto hint =
+            engine::Hint::FromBase64(destination.values.at("hint").get<json::String>().value);
+
+        EdgeWeight expected = INVALID_EDGE_WEIGHT;
+        for (const auto segment_id :
+             {hint.phantom.forward_segment_id, hint.phantom.reverse_segment_id})
+        {
+            if (!segment_id.enabled || duration(0, segment_id.id) == INVALID_EDGE_WEIGHT)
+            {
+                continue;
+            }
+            const auto target_offset = -duration(target_idx, segment_id.id);
+            BOOST_REQUIRE_GE(target_offset, 0);
+            expected = std::min(expected, duration(0, segment_id.id) + target_offset);
+        }
+        BOOST_REQUIRE_NE(expected, INVALID_EDGE_WEIGHT);
+
+        const auto table_duration =
+            durations[0].get<json::Array>().values[target_idx].get<json::Number>().value;
+        BOOST_CHECK_EQUAL(std::lround(table_duration * 10.), expected);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
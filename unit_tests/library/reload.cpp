@@ -0,0 +1,98 @@
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "args.hpp"
+#include "coordinates.hpp"
+#include "equal_json.hpp"
+#include "fixture.hpp"
+
+#include "osrm/route_parameters.hpp"
+#include "osrm/table_parameters.hpp"
+#include "osrm/table_result.hpp"
+
+#include "osrm/async.hpp"
+#include "osrm/coordinate.hpp"
+#include "osrm/engine_config.hpp"
+#include "osrm/json_container.hpp"
+#include "osrm/osrm.hpp"
+#include "osrm/status.hpp"
+
+#include <cmath>
+#include <future>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(reload)
+
+// The reloaded data gets the next data version, the queries after the swap give the same results
+BOOST_AUTO_TEST_CASE(test_reload_swaps_data)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    RouteParameters params;
+    params.steps = true;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+
+    json::Object result;
+    BOOST_REQUIRE(osrm.Route(params, result) == Status::Ok);
+    const auto data_version = osrm.GetDataVersion();
+
+    osrm.Reload();
+    BOOST_CHECK_EQUAL(osrm.GetDataVersion(), data_version + 1);
+
+    json::Object reloaded_result;
+    BOOST_REQUIRE(osrm.Route(params, reloaded_result) == Status::Ok);
+    CHECK_EQUAL_JSON(result, reloaded_result);
+}
+
+// Queries that run while the data is reloaded finish on the data they started with
+BOOST_AUTO_TEST_CASE(test_reload_during_queries)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    TableParameters params;
+    params.coordinates = get_grid_locations(8, 8);
+    TableResult expected;
+    BOOST_REQUIRE(osrm.Table(params, expected) == Status::Ok);
+
+    std::vector<std::future<AsyncResponse<TableResult>>> futures;
+    for (auto index = 0; index < 16; ++index)
+    {
+        futures.push_back(osrm.Async<TableResult>(params));
+    }
+    osrm.Reload();
+    for (auto index = 0; index < 16; ++index)
+    {
+        futures.push_back(osrm.Async<TableResult>(params));
+    }
+
+    for (auto &future : futures)
+    {
+        const auto response = future.get();
+        BOOST_REQUIRE(response.status == Status::Ok);
+        BOOST_REQUIRE_EQUAL(response.result.durations.size(), expected.durations.size());
+        for (std::size_t index = 0; index < expected.durations.size(); ++index)
+        {
+            if (std::isnan(expected.durations[index]))
+            {
+                BOOST_CHECK(std::isnan(response.result.durations[index]));
+            }
+            else
+            {
+                BOOST_CHECK_EQUAL(response.result.durations[index], expected.durations[index]);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
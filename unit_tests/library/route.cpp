@@ -11,7 +11,9 @@
 #include "osrm/json_container.hpp"
 #include "osrm/json_container.hpp"
 #include "osrm/osrm.hpp"
+#include "osrm/route_batch_parameters.hpp"
 #include "osrm/route_parameters.hpp"
+#include "osrm/route_result.hpp"
 #include "osrm/status.hpp"
 
 BOOST_AUTO_TEST_SUITE(route)
@@ -361,4 +363,279 @@ BOOST_AUTO_TEST_CASE(test_route_response_for_locations_across_components)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_route_summary_only_matches_full_route)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    const auto locations = get_locations_in_big_component();
+
+    RouteParameters full_params;
+    full_params.overview = RouteParameters::OverviewType::Full;
+    full_params.coordinates = locations;
+
+    RouteParameters summary_params;
+    summary_params.overview = RouteParameters::OverviewType::False;
+    summary_params.coordinates = locations;
+    BOOST_CHECK(summary_params.IsSummaryOnly());
+
+    json::Object full_result;
+    BOOST_CHECK(osrm.Route(full_params, full_result) == Status::Ok);
+    json::Object summary_result;
+    BOOST_CHECK(osrm.Route(summary_params, summary_result) == Status::Ok);
+
+    const auto &full_route =
+        full_result.values.at("routes").get<json::Array>().values.at(0).get<json::Object>();
+    const auto &summary_route =
+        summary_result.values.at("routes").get<json::Array>().values.at(0).get<json::Object>();
+
+    BOOST_CHECK(summary_route.values.count("geometry") == 0);
+    BOOST_CHECK_EQUAL(summary_route.values.at("duration").get<json::Number>().value,
+                      full_route.values.at("duration").get<json::Number>().value);
+    BOOST_CHECK_EQUAL(summary_route.values.at("distance").get<json::Number>().value,
+                      full_route.values.at("distance").get<json::Number>().value);
+
+    const auto &full_legs = full_route.values.at("legs").get<json::Array>().values;
+    const auto &summary_legs = summary_route.values.at("legs").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(summary_legs.size(), full_legs.size());
+    for (std::size_t idx = 0; idx < full_legs.size(); ++idx)
+    {
+        const auto &full_leg = full_legs[idx].get<json::Object>();
+        const auto &summary_leg = summary_legs[idx].get<json::Object>();
+        BOOST_CHECK_EQUAL(summary_leg.values.at("duration").get<json::Number>().value,
+                          full_leg.values.at("duration").get<json::Number>().value);
+        BOOST_CHECK_EQUAL(summary_leg.values.at("distance").get<json::Number>().value,
+                          full_leg.values.at("distance").get<json::Number>().value);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_route_packed_summary_matches_full_route)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    // with just a source and a target the distance comes from the packed path
+    const auto locations = get_locations_in_big_component();
+
+    RouteParameters full_params;
+    full_params.overview = RouteParameters::OverviewType::Full;
+    full_params.coordinates = {locations.at(0), locations.at(1)};
+
+    RouteParameters summary_params;
+    summary_params.overview = RouteParameters::OverviewType::False;
+    summary_params.coordinates = full_params.coordinates;
+
+    json::Object full_result;
+    BOOST_CHECK(osrm.Route(full_params, full_result) == Status::Ok);
+    json::Object summary_result;
+    BOOST_CHECK(osrm.Route(summary_params, summary_result) == Status::Ok);
+
+    const auto &full_route =
+        full_result.values.at("routes").get<json::Array>().values.at(0).get<json::Object>();
+    const auto &summary_route =
+        summary_result.values.at("routes").get<json::Array>().values.at(0).get<json::Object>();
+
+    BOOST_CHECK_EQUAL(summary_route.values.at("duration").get<json::Number>().value,
+                      full_route.values.at("duration").get<json::Number>().value);
+    // edge lengths are stored as floats, so allow for rounding
+    BOOST_CHECK_CLOSE(summary_route.values.at("distance").get<json::Number>().value,
+                      full_route.values.at("distance").get<json::Number>().value,
+                      0.1);
+}
+
+BOOST_AUTO_TEST_CASE(test_route_batch_matches_single_routes)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    const auto locations = get_locations_in_big_component();
+
+    RouteBatchParameters batch_params;
+    batch_params.coordinates.push_back(locations.at(0));
+    batch_params.coordinates.push_back(locations.at(1));
+    batch_params.coordinates.push_back(locations.at(1));
+    batch_params.coordinates.push_back(locations.at(2));
+
+    json::Object batch_result;
+    BOOST_CHECK(osrm.RouteBatch(batch_params, batch_result) == Status::Ok);
+    BOOST_CHECK_EQUAL(batch_result.values.at("code").get<json::String>().value, "Ok");
+
+    batch_params.summary = true;
+    json::Object summary_result;
+    BOOST_CHECK(osrm.RouteBatch(batch_params, summary_result) == Status::Ok);
+
+    const auto &results = batch_result.values.at("results").get<json::Array>().values;
+    const auto &summaries = summary_result.values.at("results").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(results.size(), 2);
+    BOOST_REQUIRE_EQUAL(summaries.size(), 2);
+
+    for (const auto pair_index : {0, 1})
+    {
+        RouteParameters params;
+        params.coordinates.push_back(batch_params.coordinates.at(2 * pair_index));
+        params.coordinates.push_back(batch_params.coordinates.at(2 * pair_index + 1));
+
+        json::Object result;
+        BOOST_CHECK(osrm.Route(params, result) == Status::Ok);
+        const auto &route =
+            result.values.at("routes").get<json::Array>().values.at(0).get<json::Object>();
+
+        const auto &pair_result = results[pair_index].get<json::Object>();
+        BOOST_CHECK_EQUAL(pair_result.values.at("code").get<json::String>().value, "Ok");
+        const auto &pair_route =
+            pair_result.values.at("routes").get<json::Array>().values.at(0).get<json::Object>();
+        BOOST_CHECK_EQUAL(pair_route.values.at("duration").get<json::Number>().value,
+                          route.values.at("duration").get<json::Number>().value);
+        BOOST_CHECK_EQUAL(pair_route.values.at("distance").get<json::Number>().value,
+                          route.values.at("distance").get<json::Number>().value);
+
+        const auto &summary = summaries[pair_index].get<json::Object>();
+        BOOST_CHECK_EQUAL(summary.values.at("code").get<json::String>().value, "Ok");
+        BOOST_CHECK(summary.values.count("routes") == 0);
+        BOOST_CHECK_CLOSE(summary.values.at("duration").get<json::Number>().value,
+                          route.values.at("duration").get<json::Number>().value,
+                          1);
+        BOOST_CHECK_CLOSE(summary.values.at("distance").get<json::Number>().value,
+                          route.values.at("distance").get<json::Number>().value,
+                          1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_route_typed_result_matches_json)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    const auto locations = get_locations_in_big_component();
+
+    // the typed result only has the summaries, whatever else is asked for
+    RouteParameters params;
+    params.steps = true;
+    params.overview = RouteParameters::OverviewType::Full;
+    params.coordinates = locations;
+
+    json::Object json_result;
+    BOOST_REQUIRE(osrm.Route(params, json_result) == Status::Ok);
+    RouteResult result;
+    BOOST_REQUIRE(osrm.Route(params, result) == Status::Ok);
+    BOOST_CHECK_EQUAL(result.code, "Ok");
+
+    BOOST_CHECK_EQUAL(result.waypoints.size(), locations.size());
+    BOOST_REQUIRE_EQUAL(result.routes.size(), 1);
+    const auto &route = result.routes.front();
+    const auto &json_route =
+        json_result.values.at("routes").get<json::Array>().values.at(0).get<json::Object>();
+    // the JSON response rounds to a decimal
+    BOOST_CHECK_SMALL(route.duration - json_route.values.at("duration").get<json::Number>().value,
+                      0.051);
+    BOOST_CHECK_SMALL(route.distance - json_route.values.at("distance").get<json::Number>().value,
+                      0.051);
+
+    const auto &json_legs = json_route.values.at("legs").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(route.legs.size(), json_legs.size());
+    for (std::size_t idx = 0; idx < json_legs.size(); ++idx)
+    {
+        const auto &json_leg = json_legs[idx].get<json::Object>();
+        BOOST_CHECK_SMALL(route.legs[idx].duration -
+                              json_leg.values.at("duration").get<json::Number>().value,
+                          0.051);
+        BOOST_CHECK_SMALL(route.legs[idx].distance -
+                              json_leg.values.at("distance").get<json::Number>().value,
+                          0.051);
+    }
+}
+
+// With a length of 1 every packed path is split into as many chunks as it has edges, up to 64,
+// so the routes across Monaco cover chunks of single and several edges and all their boundaries
+BOOST_AUTO_TEST_CASE(test_route_parallel_unpacking_matches_serial)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto serial_osrm = getOSRM(args[0]);
+    EngineConfig config;
+    config.storage_config = {args[0]};
+    config.use_shared_memory = false;
+    config.parallel_unpacking_length = 1;
+    OSRM parallel_osrm{config};
+
+    // from every location on the border of the grid to the one across
+    const std::size_t size = 5;
+    const auto grid = get_grid_locations(size, size);
+    for (std::size_t index = 0; index < size; ++index)
+    {
+        for (const auto &locations :
+             {Locations{grid[index], grid[size * size - 1 - index]},
+              Locations{grid[index * size], grid[size * size - 1 - index * size]}})
+        {
+            RouteParameters params;
+            params.steps = true;
+            params.annotations = true;
+            params.alternatives = true;
+            params.overview = RouteParameters::OverviewType::Full;
+            params.coordinates = locations;
+
+            json::Object serial_result;
+            json::Object parallel_result;
+            const auto serial_status = serial_osrm.Route(params, serial_result);
+            BOOST_REQUIRE(parallel_osrm.Route(params, parallel_result) == serial_status);
+            CHECK_EQUAL_JSON(serial_result, parallel_result);
+        }
+    }
+}
+
+// Stalling only skips nodes whose keys are not their distances, so the default stalling on settle
+// and stall-on-demand have to give the same route weights. Paths of equal weight may differ, so
+// only the weights are compared.
+BOOST_AUTO_TEST_CASE(test_route_stall_on_demand_same_weights)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+    EngineConfig config;
+    config.storage_config = {args[0]};
+    config.use_shared_memory = false;
+    config.use_stall_on_demand = true;
+    OSRM stalling_osrm{config};
+
+    const auto grid = get_grid_locations(5, 5);
+    for (std::size_t source = 0; source < grid.size(); source += 2)
+    {
+        for (std::size_t target = 1; target < grid.size(); target += 3)
+        {
+            RouteParameters params;
+            params.coordinates = {grid[source], grid[target], grid[(source + target) % 25]};
+
+            json::Object result;
+            json::Object stalling_result;
+            const auto status = osrm.Route(params, result);
+            BOOST_REQUIRE(stalling_osrm.Route(params, stalling_result) == status);
+            if (status != Status::Ok)
+            {
+                continue;
+            }
+
+            const auto &route = result.values.at("routes").get<json::Array>().values.at(0);
+            const auto &stalling_route =
+                stalling_result.values.at("routes").get<json::Array>().values.at(0);
+            BOOST_CHECK_EQUAL(
+                route.get<json::Object>().values.at("weight").get<json::Number>().value,
+                stalling_route.get<json::Object>().values.at("weight").get<json::Number>().value);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
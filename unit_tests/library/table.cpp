@@ -7,6 +7,7 @@
 #include "waypoint_check.hpp"
 
 #include "osrm/table_parameters.hpp"
+#include "osrm/table_result.hpp"
 
 #include "osrm/coordinate.hpp"
 #include "osrm/engine_config.hpp"
@@ -14,8 +15,66 @@
 #include "osrm/osrm.hpp"
 #include "osrm/status.hpp"
 
+#include "util/cast.hpp"
+
+#include <boost/optional.hpp>
+
+#include <protozero/pbf_reader.hpp>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(table)
 
+namespace
+{
+// The durations of the table, row by row, NaN for the entries without a route
+std::vector<float> get_durations(const osrm::OSRM &osrm,
+                                 const Locations &locations,
+                                 const std::vector<std::size_t> &sources,
+                                 const std::vector<std::size_t> &destinations,
+                                 const boost::optional<double> max_duration = boost::none)
+{
+    osrm::TableParameters params;
+    params.coordinates = locations;
+    params.sources = sources;
+    params.destinations = destinations;
+    params.max_duration = max_duration;
+    osrm::TableResult result;
+    BOOST_REQUIRE(osrm.Table(params, result) == osrm::Status::Ok);
+    return result.durations;
+}
+
+void check_equal_durations(const std::vector<float> &lhs, const std::vector<float> &rhs)
+{
+    BOOST_REQUIRE_EQUAL(lhs.size(), rhs.size());
+    for (std::size_t index = 0; index < lhs.size(); ++index)
+    {
+        if (std::isnan(lhs[index]) || std::isnan(rhs[index]))
+        {
+            BOOST_CHECK_MESSAGE(std::isnan(lhs[index]) && std::isnan(rhs[index]),
+                                "entry " << index << " has a route in only one table");
+        }
+        else
+        {
+            BOOST_CHECK_EQUAL(lhs[index], rhs[index]);
+        }
+    }
+}
+
+// A grid over Monaco with some of its locations repeated. Many of them snap to the same segments,
+// so the searches of several targets leave buckets on the same nodes and sources start on them.
+Locations get_locations_on_same_nodes()
+{
+    auto locations = get_grid_locations(4, 4);
+    locations.push_back(locations[5]);
+    locations.push_back(locations[10]);
+    locations.push_back(locations[5]);
+    return locations;
+}
+}
+
 BOOST_AUTO_TEST_CASE(test_table_three_coords_one_source_one_dest_matrix)
 {
     const auto args = get_args();
@@ -161,4 +220,344 @@ BOOST_AUTO_TEST_CASE(test_table_three_coordinates_matrix)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_table_pbf_matrix)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    TableParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.sources.push_back(0);
+    params.format = TableParameters::OutputFormatType::PBF;
+
+    std::string result;
+    const auto rc = osrm.Table(params, result);
+    BOOST_CHECK(rc == Status::Ok);
+
+    // the field numbers are the ones of the schema in docs/http.md
+    std::string code;
+    unsigned number_of_sources = 0;
+    unsigned number_of_destinations = 0;
+    unsigned number_of_durations = 0;
+    protozero::pbf_reader reader(result);
+    while (reader.next())
+    {
+        switch (reader.tag())
+        {
+        case 1:
+            code = reader.get_string();
+            break;
+        case 3:
+            reader.skip();
+            ++number_of_sources;
+            break;
+        case 4:
+        {
+            protozero::pbf_reader waypoint = reader.get_message();
+            bool has_hint = false;
+            while (waypoint.next(1))
+            {
+                has_hint = !waypoint.get_string().empty();
+            }
+            BOOST_CHECK(has_hint);
+            ++number_of_destinations;
+            break;
+        }
+        case 5:
+        {
+            const auto durations = reader.get_packed_float();
+            for (auto duration = durations.first; duration != durations.second; ++duration)
+            {
+                BOOST_CHECK(std::isnan(*duration) || *duration >= 0);
+                ++number_of_durations;
+            }
+            break;
+        }
+        default:
+            reader.skip();
+        }
+    }
+
+    BOOST_CHECK_EQUAL(code, "Ok");
+    BOOST_CHECK_EQUAL(number_of_sources, 1);
+    BOOST_CHECK_EQUAL(number_of_destinations, params.coordinates.size());
+    BOOST_CHECK_EQUAL(number_of_durations, params.coordinates.size());
+}
+
+BOOST_AUTO_TEST_CASE(test_table_rendered_json)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    TableParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.destinations.push_back(1);
+
+    std::string result;
+    const auto rc = osrm.Table(params, result);
+    BOOST_CHECK(rc == Status::Ok);
+
+    json::Object object_result;
+    BOOST_CHECK(osrm.Table(params, object_result) == Status::Ok);
+    const auto &durations = object_result.values.at("durations").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(durations.size(), 2);
+
+    // the same durations as in the json::Object response, one destination per row
+    std::string expected_durations = "\"durations\":[";
+    for (const auto &row : durations)
+    {
+        const auto &cell = row.get<json::Array>().values.at(0);
+        expected_durations += &row == &durations.front() ? "[" : ",[";
+        if (cell.is<json::Null>())
+        {
+            expected_durations += "null";
+        }
+        else
+        {
+            const auto duration = cell.get<json::Number>().value;
+            expected_durations += util::cast::to_string_with_precision(duration);
+        }
+        expected_durations += "]";
+    }
+    expected_durations += "]";
+
+    BOOST_CHECK_EQUAL(result.compare(0, 15, "{\"code\":\"Ok\","), 0);
+    BOOST_CHECK(result.find(expected_durations) != std::string::npos);
+    BOOST_CHECK(result.find("\"sources\":[{") != std::string::npos);
+    BOOST_CHECK(result.find("\"destinations\":[{") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(test_table_typed_result)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    TableParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.sources.push_back(0);
+    params.sources.push_back(1);
+
+    json::Object json_result;
+    BOOST_REQUIRE(osrm.Table(params, json_result) == Status::Ok);
+    TableResult result;
+    BOOST_REQUIRE(osrm.Table(params, result) == Status::Ok);
+    BOOST_CHECK_EQUAL(result.code, "Ok");
+
+    // the same durations as the JSON response, in one row major array
+    BOOST_CHECK_EQUAL(result.sources.size(), params.sources.size());
+    BOOST_CHECK_EQUAL(result.destinations.size(), params.coordinates.size());
+    BOOST_REQUIRE_EQUAL(result.durations.size(),
+                        result.sources.size() * result.destinations.size());
+    const auto &durations_array = json_result.values.at("durations").get<json::Array>().values;
+    for (std::size_t row = 0; row < result.sources.size(); ++row)
+    {
+        const auto &json_row = durations_array.at(row).get<json::Array>().values;
+        for (std::size_t column = 0; column < result.destinations.size(); ++column)
+        {
+            const auto duration = result.durations[row * result.destinations.size() + column];
+            BOOST_CHECK_CLOSE(duration, json_row.at(column).get<json::Number>().value, 0.001);
+        }
+    }
+
+    for (const auto &waypoint : result.sources)
+    {
+        BOOST_CHECK(waypoint.location.IsValid());
+        BOOST_CHECK_EQUAL(waypoint.hint.data_checksum, osrm.GetCheckSum());
+    }
+
+    params.coordinates.clear();
+    params.coordinates.push_back(get_dummy_location());
+    params.sources = {0};
+    params.destinations = {0};
+    params.coordinates.push_back(util::Coordinate{util::FloatLongitude{1000.},
+                                                  util::FloatLatitude{1000.}});
+    TableResult error_result;
+    BOOST_CHECK(osrm.Table(params, error_result) == Status::Error);
+    BOOST_CHECK_EQUAL(error_result.code, "InvalidOptions");
+    BOOST_CHECK(!error_result.message.empty());
+}
+
+// 96 sources and 4096 destinations are computed with RPHAST, a third of the sources with buckets.
+// Sources in small components are left out of the searches, the others are still enough.
+BOOST_AUTO_TEST_CASE(test_table_rphast_matches_buckets)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+    const auto locations = get_grid_locations(64, 64);
+
+    std::vector<std::size_t> sources;
+    for (std::size_t source = 0; source < 96; ++source)
+    {
+        sources.push_back(source * 42);
+    }
+    const auto rphast_durations = get_durations(osrm, locations, sources, {});
+
+    std::vector<float> bucket_durations;
+    for (auto first = sources.begin(); first != sources.end(); first += 32)
+    {
+        const auto durations = get_durations(osrm, locations, {first, first + 32}, {});
+        bucket_durations.insert(bucket_durations.end(), durations.begin(), durations.end());
+    }
+
+    check_equal_durations(rphast_durations, bucket_durations);
+}
+
+// Every entry has to be the duration of its own pair, a source and a target at the same location
+// are 0 apart
+BOOST_AUTO_TEST_CASE(test_table_sources_and_targets_on_same_nodes)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+    const auto locations = get_locations_on_same_nodes();
+    const auto size = locations.size();
+    const auto durations = get_durations(osrm, locations, {}, {});
+    BOOST_REQUIRE_EQUAL(durations.size(), size * size);
+
+    for (std::size_t source = 0; source < size; ++source)
+    {
+        if (!std::isnan(durations[source * size + source]))
+        {
+            BOOST_CHECK_EQUAL(durations[source * size + source], 0);
+        }
+        for (std::size_t target = 0; target < size; ++target)
+        {
+            check_equal_durations({durations[source * size + target]},
+                                  get_durations(osrm, locations, {source}, {target}));
+        }
+    }
+}
+
+// The buckets of a node are ordered by target, whatever order the destinations come in the
+// entries have to end up in the column of their own destination
+BOOST_AUTO_TEST_CASE(test_table_destination_order)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+    const auto locations = get_locations_on_same_nodes();
+    const auto size = locations.size();
+
+    // every third location in turn, this visits all of them as the size is not a multiple of 3
+    BOOST_REQUIRE_NE(size % 3, 0);
+    std::vector<std::size_t> destinations;
+    for (std::size_t destination = 0; destination < size; ++destination)
+    {
+        destinations.push_back((destination * 3) % size);
+    }
+    const auto durations = get_durations(osrm, locations, {}, {});
+    const auto shuffled_durations = get_durations(osrm, locations, {}, destinations);
+
+    std::vector<float> expected_durations;
+    for (std::size_t source = 0; source < size; ++source)
+    {
+        for (const auto destination : destinations)
+        {
+            expected_durations.push_back(durations[source * size + destination]);
+        }
+    }
+    check_equal_durations(shuffled_durations, expected_durations);
+}
+
+// The workers search rows and columns in blocks of 16. The tables cover several blocks with
+// buckets, a single source that parallel mode does not search on its own and, with 80 sources to
+// all 4096 destinations, RPHAST.
+BOOST_AUTO_TEST_CASE(test_table_parallel_matches_serial)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto serial_osrm = getOSRM(args[0]);
+    EngineConfig config;
+    config.storage_config = {args[0]};
+    config.use_shared_memory = false;
+    config.use_parallel_distance_table = true;
+    OSRM parallel_osrm{config};
+
+    const auto locations = get_grid_locations(64, 64);
+    std::vector<std::size_t> sources;
+    for (std::size_t source = 0; source < 50; ++source)
+    {
+        sources.push_back(source * 81);
+    }
+    std::vector<std::size_t> many_sources;
+    for (std::size_t source = 0; source < 80; ++source)
+    {
+        many_sources.push_back(source * 51);
+    }
+
+    for (const auto &table_sources : {sources, std::vector<std::size_t>{7}, many_sources})
+    {
+        check_equal_durations(get_durations(parallel_osrm, locations, table_sources, sources),
+                              get_durations(serial_osrm, locations, table_sources, sources));
+        check_equal_durations(get_durations(parallel_osrm, locations, table_sources, {}),
+                              get_durations(serial_osrm, locations, table_sources, {}));
+    }
+}
+
+// A single source or target is searched without buckets, the searches of the others stop once
+// they can't improve on their entry. Rows and columns have to be the ones of the full table, also
+// when max_duration bounds the searches.
+BOOST_AUTO_TEST_CASE(test_table_one_to_many_matches_many_to_many)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+    const auto locations = get_grid_locations(16, 16);
+    const auto size = locations.size();
+
+    for (const auto max_duration : {boost::optional<double>{}, boost::optional<double>{120.}})
+    {
+        const auto durations = get_durations(osrm, locations, {}, {}, max_duration);
+        BOOST_REQUIRE_EQUAL(durations.size(), size * size);
+
+        for (std::size_t index = 0; index < size; index += 17)
+        {
+            const std::vector<float> row(durations.begin() + index * size,
+                                         durations.begin() + (index + 1) * size);
+            check_equal_durations(get_durations(osrm, locations, {index}, {}, max_duration), row);
+
+            std::vector<float> column;
+            for (std::size_t source = 0; source < size; ++source)
+            {
+                column.push_back(durations[source * size + index]);
+            }
+            check_equal_durations(get_durations(osrm, locations, {}, {index}, max_duration),
+                                  column);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -16,6 +16,10 @@
 
 #include <protozero/pbf_reader.hpp>
 
+#include <algorithm>
+#include <string>
+#include <utility>
+
 BOOST_AUTO_TEST_SUITE(tile)
 
 BOOST_AUTO_TEST_CASE(test_tile)
@@ -135,4 +139,41 @@ BOOST_AUTO_TEST_CASE(test_tile)
     BOOST_CHECK_GT(number_of_values, 128); // speed value resolution
 }
 
+// Tiles cut from a cached tile of a lower zoom level are the same as the ones from the r-tree
+BOOST_AUTO_TEST_CASE(test_tile_cache)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    EngineConfig config;
+    config.storage_config = {args.at(0)};
+    config.use_shared_memory = false;
+    config.tile_cache_size = 16;
+    OSRM cached_osrm{config};
+
+    for (const unsigned z : {13u, 15u, 16u})
+    {
+        // the tiles of monaco at the zoom level
+        const unsigned shift = 15 - std::min(z, 15u);
+        const unsigned x = (17059 >> shift) << (z - std::min(z, 15u));
+        const unsigned y = (11948 >> shift) << (z - std::min(z, 15u));
+        for (const auto &offset : {std::make_pair(0u, 0u), std::make_pair(1u, 1u)})
+        {
+            const TileParameters params{x + offset.first, y + offset.second, z};
+
+            std::string result;
+            BOOST_CHECK(osrm.Tile(params, result) == Status::Ok);
+            // the second tile of a cached one is cut from it as well
+            for (int repetition = 0; repetition < 2; ++repetition)
+            {
+                std::string cached_result;
+                BOOST_CHECK(cached_osrm.Tile(params, cached_result) == Status::Ok);
+                BOOST_CHECK(result == cached_result);
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
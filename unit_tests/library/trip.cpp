@@ -5,6 +5,10 @@
 #include "coordinates.hpp"
 #include "fixture.hpp"
 
+#include "engine/hint.hpp"
+#include "storage/traffic_overlay.hpp"
+
+#include "osrm/nearest_parameters.hpp"
 #include "osrm/trip_parameters.hpp"
 
 #include "osrm/coordinate.hpp"
@@ -13,6 +17,11 @@
 #include "osrm/osrm.hpp"
 #include "osrm/status.hpp"
 
+#include <tbb/task_arena.h>
+
+#include <set>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(trip)
 
 BOOST_AUTO_TEST_CASE(test_trip_response_for_locations_in_small_component)
@@ -151,4 +160,100 @@ BOOST_AUTO_TEST_CASE(test_trip_response_for_locations_across_components)
     }
 }
 
+// The clusters of a large trip are searched on other threads, which have to close the same nodes
+// as the calling thread. The trip on a single thread is the same then.
+BOOST_AUTO_TEST_CASE(test_clustered_trip_across_closed_node)
+{
+    const auto args = get_args();
+
+    using namespace osrm;
+
+    TripParameters params;
+    params.coordinates = get_grid_locations(8, 6);
+
+    // the segments around the middle of the grid that no location snaps to
+    std::set<NodeID> waypoint_segments;
+    {
+        auto osrm = getOSRM(args.at(0));
+        json::Object result;
+        BOOST_REQUIRE(osrm.Trip(params, result) == Status::Ok);
+        for (const auto &waypoint : result.values.at("waypoints").get<json::Array>().values)
+        {
+            const auto hint = engine::Hint::FromBase64(
+                waypoint.get<json::Object>().values.at("hint").get<json::String>().value);
+            waypoint_segments.insert(hint.phantom.forward_segment_id.id);
+            waypoint_segments.insert(hint.phantom.reverse_segment_id.id);
+        }
+
+        NearestParameters nearest_params;
+        nearest_params.coordinates.push_back({util::FloatLongitude{7.4222},
+                                              util::FloatLatitude{43.7359}});
+        nearest_params.number_of_results = 10;
+        json::Object nearest;
+        BOOST_REQUIRE(osrm.Nearest(nearest_params, nearest) == Status::Ok);
+        std::vector<storage::TrafficPenalty> closures;
+        for (const auto &waypoint : nearest.values.at("waypoints").get<json::Array>().values)
+        {
+            const auto hint = engine::Hint::FromBase64(
+                waypoint.get<json::Object>().values.at("hint").get<json::String>().value);
+            for (const auto segment_id :
+                 {hint.phantom.forward_segment_id, hint.phantom.reverse_segment_id})
+            {
+                if (segment_id.enabled && waypoint_segments.count(segment_id.id) == 0)
+                {
+                    closures.push_back({segment_id.id, storage::TRAFFIC_CLOSED});
+                }
+            }
+        }
+        BOOST_REQUIRE(!closures.empty());
+        storage::writeSharedTrafficOverlay(closures);
+    }
+
+    EngineConfig config;
+    config.storage_config = {args.at(0)};
+    config.use_shared_memory = false;
+    config.use_traffic_overlay = true;
+    config.large_trip_locations = 20;
+    OSRM osrm{config};
+
+    json::Object parallel_result;
+    BOOST_REQUIRE(osrm.Trip(params, parallel_result) == Status::Ok);
+    BOOST_CHECK_NE(osrm.GetTrafficOverlayVersion(), 0);
+
+    json::Object serial_result;
+    tbb::task_arena single_thread(1);
+    single_thread.execute(
+        [&] { BOOST_REQUIRE(osrm.Trip(params, serial_result) == Status::Ok); });
+    storage::writeSharedTrafficOverlay({});
+
+    const auto &parallel_waypoints =
+        parallel_result.values.at("waypoints").get<json::Array>().values;
+    const auto &serial_waypoints = serial_result.values.at("waypoints").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(parallel_waypoints.size(), params.coordinates.size());
+    BOOST_REQUIRE_EQUAL(serial_waypoints.size(), params.coordinates.size());
+    for (std::size_t index = 0; index < params.coordinates.size(); ++index)
+    {
+        BOOST_CHECK_EQUAL(parallel_waypoints[index]
+                              .get<json::Object>()
+                              .values.at("waypoint_index")
+                              .get<json::Number>()
+                              .value,
+                          serial_waypoints[index]
+                              .get<json::Object>()
+                              .values.at("waypoint_index")
+                              .get<json::Number>()
+                              .value);
+    }
+    const auto duration = [](const json::Object &result) {
+        return result.values.at("trips")
+            .get<json::Array>()
+            .values.at(0)
+            .get<json::Object>()
+            .values.at("duration")
+            .get<json::Number>()
+            .value;
+    };
+    BOOST_CHECK_EQUAL(duration(parallel_result), duration(serial_result));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
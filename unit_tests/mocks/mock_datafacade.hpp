@@ -16,17 +16,27 @@ namespace osrm
 namespace test
 {
 
-class MockDataFacade final : public engine::datafacade::BaseDataFacade
+class MockDataFacade : public engine::datafacade::BaseDataFacade
 {
   private:
     EdgeData foo;
+    partition::CellStorageView cell_storage;
+    contractor::QueryEdgeSearchData search_foo;
 
   public:
     unsigned GetNumberOfNodes() const override { return 0; }
     unsigned GetNumberOfEdges() const override { return 0; }
     unsigned GetOutDegree(const NodeID /* n */) const override { return 0; }
     NodeID GetTarget(const EdgeID /* e */) const override { return SPECIAL_NODEID; }
-    const EdgeData &GetEdgeData(const EdgeID /* e */) const override { return foo; }
+    EdgeData GetEdgeData(const EdgeID /* e */) const override { return foo; }
+    const contractor::QueryEdgeSearchData &GetSearchData(const EdgeID /* e */) const override
+    {
+        return search_foo;
+    }
+    contractor::QueryGraphView GetSearchGraph() const override
+    {
+        return contractor::QueryGraphView();
+    }
     EdgeID BeginEdges(const NodeID /* n */) const override { return SPECIAL_EDGEID; }
     EdgeID EndEdges(const NodeID /* n */) const override { return SPECIAL_EDGEID; }
     osrm::engine::datafacade::EdgeRange GetAdjacentEdgeRange(const NodeID /* node */) const override
@@ -71,9 +81,17 @@ class MockDataFacade final : public engine::datafacade::BaseDataFacade
                                     std::vector<uint8_t> & /*data_sources*/) const override
     {
     }
-    std::string GetDatasourceName(const uint8_t /*datasource_name_id*/) const override
+    void GetUncompressedZoomLevels(const EdgeID /*id*/,
+                                   std::vector<std::uint8_t> & /*zoom_levels*/) const override
+    {
+    }
+    void GetUncompressedLengths(const EdgeID /*id*/,
+                                std::vector<SegmentLength> & /*lengths*/) const override
     {
-        return "";
+    }
+    util::StringView GetDatasourceName(const uint8_t /*datasource_name_id*/) const override
+    {
+        return {};
     }
     extractor::guidance::TurnInstruction
     GetTurnInstructionForEdgeID(const unsigned /* id */) const override
@@ -171,16 +189,47 @@ class MockDataFacade final : public engine::datafacade::BaseDataFacade
         return {};
     };
 
+    engine::PhantomNode SegmentPhantomNode(const util::Coordinate /*input_coordinate*/,
+                                           const engine::PhantomNode & /*segment*/) const override
+    {
+        return {};
+    }
+
     unsigned GetCheckSum() const override { return 0; }
+    unsigned GetDataVersion() const override { return 0; }
     bool IsCoreNode(const NodeID /* id */) const override { return false; }
+    util::PackedBitsetView GetCoreMarkers() const override { return {}; }
     unsigned GetNameIndexFromEdgeID(const unsigned /* id */) const override { return 0; }
-    std::string GetNameForID(const unsigned /* name_id */) const override { return ""; }
-    std::string GetRefForID(const unsigned /* name_id */) const override { return ""; }
-    std::string GetPronunciationForID(const unsigned /* name_id */) const override { return ""; }
-    std::string GetDestinationsForID(const unsigned /* name_id */) const override { return ""; }
+    util::StringView GetNameForID(const unsigned /* name_id */) const override { return {}; }
+    util::StringView GetRefForID(const unsigned /* name_id */) const override { return {}; }
+    util::StringView GetPronunciationForID(const unsigned /* name_id */) const override
+    {
+        return {};
+    }
+    util::StringView GetDestinationsForID(const unsigned /* name_id */) const override
+    {
+        return {};
+    }
     std::size_t GetCoreSize() const override { return 0; }
+    unsigned GetNumberOfLandmarks() const override { return 0; }
+    const EdgeWeight *GetLandmarkDistances(const NodeID /* id */) const override
+    {
+        return nullptr;
+    }
+    bool HasHubLabels() const override { return false; }
+    engine::HubLabel GetHubLabel(const NodeID /* id */, const bool /* forward */) const override
+    {
+        return {};
+    }
+    bool HasMultiLevelData() const override { return false; }
+    contractor::QueryGraphView GetMultiLevelGraph() const override { return {}; }
+    EdgeData GetMultiLevelEdgeData(const EdgeID /* e */) const override { return foo; }
+    const partition::CellStorageView &GetCellStorage() const override { return cell_storage; }
     std::string GetTimestamp() const override { return ""; }
+    std::vector<util::MemoryRegion> GetMemoryRegions() const override { return {}; }
+    std::vector<util::NamedMemoryRegion> GetMemoryBlocks() const override { return {}; }
     bool GetContinueStraightDefault() const override { return true; }
+    bool HasOrderedComponentIDs() const override { return false; }
     BearingClassID GetBearingClassID(const NodeID /*id*/) const override { return 0; };
     EntryClassID GetEntryClassID(const EdgeID /*id*/) const override { return 0; }
 
@@ -0,0 +1,378 @@
+#include "partition/cell_storage.hpp"
+#include "contractor/query_graph.hpp"
+#include "customizer/cell_customizer.hpp"
+#include "extractor/class_data.hpp"
+#include "partition/multi_level_partition.hpp"
+#include "util/integer_range.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(cell_storage)
+
+using namespace osrm;
+using namespace osrm::partition;
+
+namespace
+{
+const static NodeID WIDTH = 4;
+const static NodeID NUMBER_OF_NODES = WIDTH * WIDTH;
+
+// A 4x4 grid with edges in both directions, except for the one-way from 5 to 6
+struct Grid
+{
+    Grid()
+    {
+        for (NodeID y = 0; y < WIDTH; ++y)
+        {
+            for (NodeID x = 0; x < WIDTH; ++x)
+            {
+                const NodeID node = y * WIDTH + x;
+                if (x > 0)
+                {
+                    add(node - 1, node, 1 + (node * 7) % 5);
+                    if (node != 6)
+                    {
+                        add(node, node - 1, 1 + (node * 3) % 4);
+                    }
+                }
+                if (y > 0)
+                {
+                    add(node - WIDTH, node, 2 + (node * 5) % 3);
+                    add(node, node - WIDTH, 1 + node % 6);
+                }
+            }
+        }
+
+        // every edge is stored at both of its nodes, like osrm-customize does
+        std::vector<std::pair<NodeID, contractor::QueryEdgeSearchData>> stored_edges;
+        for (const auto &edge : edges)
+        {
+            contractor::QueryEdgeSearchData data;
+            data.target = std::get<1>(edge);
+            data.distance = std::get<2>(edge);
+            data.forward = true;
+            data.backward = false;
+            stored_edges.emplace_back(std::get<0>(edge), data);
+            data.target = std::get<0>(edge);
+            data.forward = false;
+            data.backward = true;
+            stored_edges.emplace_back(std::get<1>(edge), data);
+        }
+        std::stable_sort(stored_edges.begin(),
+                         stored_edges.end(),
+                         [](const std::pair<NodeID, contractor::QueryEdgeSearchData> &lhs,
+                            const std::pair<NodeID, contractor::QueryEdgeSearchData> &rhs) {
+                             return lhs.first < rhs.first;
+                         });
+
+        nodes.resize(NUMBER_OF_NODES + 1);
+        for (auto &node : nodes)
+        {
+            node.first_edge = 0;
+        }
+        for (const auto &stored_edge : stored_edges)
+        {
+            ++nodes[stored_edge.first + 1].first_edge;
+            search_edges.push_back(stored_edge.second);
+        }
+        for (NodeID node = 0; node < NUMBER_OF_NODES; ++node)
+        {
+            nodes[node + 1].first_edge += nodes[node].first_edge;
+        }
+    }
+
+    contractor::QueryGraphView GetView() const
+    {
+        return contractor::QueryGraphView(NUMBER_OF_NODES, nodes.data(), search_edges.data());
+    }
+
+    // Bellman-Ford on the edges between the nodes of the cell that are not excluded
+    EdgeWeight GetCellWeight(const MultiLevelPartition &partition,
+                             const LevelID level,
+                             const NodeID source,
+                             const NodeID destination,
+                             const std::vector<bool> &excluded = {}) const
+    {
+        const auto cell = partition.GetCell(level, source);
+        const auto is_excluded = [&](const NodeID node) {
+            return !excluded.empty() && excluded[node];
+        };
+        std::vector<EdgeWeight> weights(NUMBER_OF_NODES, INVALID_EDGE_WEIGHT);
+        if (is_excluded(source))
+        {
+            return INVALID_EDGE_WEIGHT;
+        }
+        weights[source] = 0;
+        for (NodeID round = 0; round < NUMBER_OF_NODES; ++round)
+        {
+            for (const auto &edge : edges)
+            {
+                const auto from = std::get<0>(edge);
+                const auto to = std::get<1>(edge);
+                if (weights[from] != INVALID_EDGE_WEIGHT && !is_excluded(to) &&
+                    partition.GetCell(level, from) == cell && partition.GetCell(level, to) == cell)
+                {
+                    weights[to] = std::min(weights[to], weights[from] + std::get<2>(edge));
+                }
+            }
+        }
+        return weights[destination];
+    }
+
+    void add(const NodeID from, const NodeID to, const EdgeWeight weight)
+    {
+        edges.emplace_back(from, to, weight);
+    }
+
+    std::vector<std::tuple<NodeID, NodeID, EdgeWeight>> edges;
+    std::vector<contractor::QueryGraphNode> nodes;
+    std::vector<contractor::QueryEdgeSearchData> search_edges;
+};
+
+// level 0: the four 2x2 quarters, level 1: the left and the right half
+MultiLevelPartition makePartition()
+{
+    std::vector<CellID> cells(2 * NUMBER_OF_NODES);
+    for (NodeID node = 0; node < NUMBER_OF_NODES; ++node)
+    {
+        const NodeID x = node % WIDTH;
+        const NodeID y = node / WIDTH;
+        cells[node] = (y / 2) * 2 + x / 2;
+        cells[NUMBER_OF_NODES + node] = x / 2;
+    }
+    return MultiLevelPartition({4, 8}, std::move(cells));
+}
+}
+
+BOOST_AUTO_TEST_CASE(boundary_nodes)
+{
+    const Grid grid;
+    const auto partition = makePartition();
+    const CellStorage storage(partition, grid.GetView());
+    const auto cells = storage.GetView();
+
+    BOOST_REQUIRE_EQUAL(cells.GetNumberOfLevels(), 2);
+    BOOST_CHECK_EQUAL(cells.GetNumberOfCells(0), 4);
+    BOOST_CHECK_EQUAL(cells.GetNumberOfCells(1), 2);
+    BOOST_CHECK_EQUAL(cells.GetCommonLevel(0, 5), 0);
+    BOOST_CHECK_EQUAL(cells.GetCommonLevel(0, 8), 1);
+    BOOST_CHECK_EQUAL(cells.GetCommonLevel(0, 15), 2);
+
+    // the left half is left from 1, 5, 9 and 13, but not entered at 5 as 5 to 6 is a one-way
+    const auto left = cells.GetCell(1, 0);
+    BOOST_REQUIRE_EQUAL(left.GetNumberOfSources(), 3);
+    BOOST_REQUIRE_EQUAL(left.GetNumberOfDestinations(), 4);
+    BOOST_CHECK_EQUAL(left.GetSource(0), 1);
+    BOOST_CHECK_EQUAL(left.GetSource(2), 13);
+    BOOST_CHECK_EQUAL(left.FindSource(5), left.GetNumberOfSources());
+    BOOST_CHECK_EQUAL(left.FindDestination(5), 1);
+    BOOST_CHECK_EQUAL(left.FindDestination(0), left.GetNumberOfDestinations());
+}
+
+BOOST_AUTO_TEST_CASE(customized_weights)
+{
+    const Grid grid;
+    const auto partition = makePartition();
+    const auto graph = grid.GetView();
+    CellStorage storage(partition, graph);
+    customizer::customizeCells(graph, storage);
+    const auto cells = storage.GetView();
+
+    for (LevelID level = 0; level < cells.GetNumberOfLevels(); ++level)
+    {
+        for (CellID cell_id = 0; cell_id < cells.GetNumberOfCells(level); ++cell_id)
+        {
+            const auto cell = cells.GetCell(level, cell_id);
+            BOOST_CHECK_GT(cell.GetNumberOfSources(), 0);
+            for (std::uint32_t source = 0; source < cell.GetNumberOfSources(); ++source)
+            {
+                for (std::uint32_t destination = 0; destination < cell.GetNumberOfDestinations();
+                     ++destination)
+                {
+                    BOOST_CHECK_EQUAL(cell.GetWeight(source, destination),
+                                      grid.GetCellWeight(partition,
+                                                         level,
+                                                         cell.GetSource(source),
+                                                         cell.GetDestination(destination)));
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(excluded_classes)
+{
+    const Grid grid;
+    const auto partition = makePartition();
+    const auto graph = grid.GetView();
+    CellStorage storage(partition, graph);
+
+    // the nodes of the middle column on the left are tolls, the last node is a ferry
+    std::vector<extractor::ClassData> node_classes(NUMBER_OF_NODES, 0);
+    node_classes[1] = node_classes[5] = node_classes[9] = extractor::getClassMask(0);
+    node_classes[NUMBER_OF_NODES - 1] = extractor::getClassMask(1);
+    storage.SetClasses(node_classes, {"toll", "ferry"});
+    BOOST_CHECK_EQUAL(storage.AddMetric(extractor::getClassMask(0)), 1);
+    BOOST_CHECK_EQUAL(storage.AddMetric(extractor::getClassMask(0) | extractor::getClassMask(1)),
+                      2);
+    customizer::customizeCells(graph, storage);
+    const auto cells = storage.GetView();
+
+    BOOST_REQUIRE_EQUAL(cells.GetNumberOfMetrics(), 3);
+    BOOST_CHECK((cells.GetClassNames() == std::vector<std::string>{"toll", "ferry"}));
+    BOOST_CHECK_EQUAL(cells.FindMetric(0), 0);
+    BOOST_CHECK_EQUAL(cells.FindMetric(extractor::getClassMask(0)), 1);
+    BOOST_CHECK_EQUAL(cells.FindMetric(extractor::getClassMask(1)), 3);
+    BOOST_CHECK(!cells.IsExcluded(5));
+    BOOST_CHECK(cells.GetMetric(1).IsExcluded(5));
+    BOOST_CHECK(!cells.GetMetric(1).IsExcluded(NUMBER_OF_NODES - 1));
+    BOOST_CHECK(cells.GetMetric(2).IsExcluded(NUMBER_OF_NODES - 1));
+
+    for (const auto metric : util::irange<std::uint32_t>(0, cells.GetNumberOfMetrics()))
+    {
+        const auto metric_cells = cells.GetMetric(metric);
+        std::vector<bool> excluded(NUMBER_OF_NODES);
+        for (NodeID node = 0; node < NUMBER_OF_NODES; ++node)
+        {
+            excluded[node] = metric_cells.IsExcluded(node);
+        }
+        for (LevelID level = 0; level < cells.GetNumberOfLevels(); ++level)
+        {
+            for (CellID cell_id = 0; cell_id < cells.GetNumberOfCells(level); ++cell_id)
+            {
+                const auto cell = metric_cells.GetCell(level, cell_id);
+                for (std::uint32_t source = 0; source < cell.GetNumberOfSources(); ++source)
+                {
+                    for (std::uint32_t destination = 0;
+                         destination < cell.GetNumberOfDestinations();
+                         ++destination)
+                    {
+                        BOOST_CHECK_EQUAL(cell.GetWeight(source, destination),
+                                          grid.GetCellWeight(partition,
+                                                             level,
+                                                             cell.GetSource(source),
+                                                             cell.GetDestination(destination),
+                                                             excluded));
+                    }
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(named_edge_weights)
+{
+    const Grid grid;
+    const auto partition = makePartition();
+    const auto graph = grid.GetView();
+    CellStorage storage(partition, graph);
+    std::vector<extractor::ClassData> node_classes(NUMBER_OF_NODES, 0);
+    node_classes[9] = extractor::getClassMask(0);
+    storage.SetClasses(node_classes, {"toll"});
+    BOOST_CHECK_EQUAL(storage.AddMetric(extractor::getClassMask(0)), 1);
+
+    // other weights for every edge, the one from 0 to 1 is closed
+    const auto reweigh = [](const EdgeWeight weight) { return 1 + (weight * 3) % 7; };
+    Grid reweighed_grid = grid;
+    reweighed_grid.edges.clear();
+    for (const auto &edge : grid.edges)
+    {
+        if (std::get<0>(edge) != 0 || std::get<1>(edge) != 1)
+        {
+            reweighed_grid.add(std::get<0>(edge), std::get<1>(edge), reweigh(std::get<2>(edge)));
+        }
+    }
+    std::vector<EdgeWeight> edge_weights(grid.search_edges.size());
+    for (NodeID node = 0; node < NUMBER_OF_NODES; ++node)
+    {
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            const auto &data = graph.GetSearchData(edge);
+            const bool is_closed = (node == 0 && data.target == 1 && data.forward) ||
+                                   (node == 1 && data.target == 0 && data.backward);
+            edge_weights[edge] = is_closed ? INVALID_EDGE_WEIGHT : reweigh(data.distance);
+        }
+    }
+    BOOST_CHECK_EQUAL(storage.AddEdgeWeights("reweighed", edge_weights), 1);
+    BOOST_CHECK_EQUAL(storage.AddMetric(0, 1), 2);
+    BOOST_CHECK_EQUAL(storage.AddMetric(extractor::getClassMask(0), 1), 3);
+    customizer::customizeCells(graph, storage);
+    const auto cells = storage.GetView();
+
+    BOOST_REQUIRE_EQUAL(cells.GetNumberOfMetrics(), 4);
+    BOOST_CHECK((cells.GetEdgeWeightNames() == std::vector<std::string>{"reweighed"}));
+    BOOST_CHECK_EQUAL(cells.FindEdgeWeights("reweighed"), 1);
+    BOOST_CHECK_EQUAL(cells.FindEdgeWeights("shortest"), 2);
+    BOOST_CHECK_EQUAL(cells.FindMetric(0, 1), 2);
+    BOOST_CHECK_EQUAL(cells.FindMetric(extractor::getClassMask(0), 1), 3);
+    BOOST_CHECK_EQUAL(cells.FindMetric(extractor::getClassMask(0)), 1);
+    BOOST_CHECK_EQUAL(cells.GetEdgeWeight(0, 42), 42);
+    BOOST_CHECK_EQUAL(cells.GetMetric(2).GetEdgeWeight(0, 42), edge_weights[0]);
+
+    for (const auto metric : util::irange<std::uint32_t>(0, cells.GetNumberOfMetrics()))
+    {
+        const auto metric_cells = cells.GetMetric(metric);
+        const auto &metric_grid = metric < 2 ? grid : reweighed_grid;
+        std::vector<bool> excluded(NUMBER_OF_NODES);
+        for (NodeID node = 0; node < NUMBER_OF_NODES; ++node)
+        {
+            excluded[node] = metric_cells.IsExcluded(node);
+        }
+        for (LevelID level = 0; level < cells.GetNumberOfLevels(); ++level)
+        {
+            for (CellID cell_id = 0; cell_id < cells.GetNumberOfCells(level); ++cell_id)
+            {
+                const auto cell = metric_cells.GetCell(level, cell_id);
+                for (std::uint32_t source = 0; source < cell.GetNumberOfSources(); ++source)
+                {
+                    for (std::uint32_t destination = 0;
+                         destination < cell.GetNumberOfDestinations();
+                         ++destination)
+                    {
+                        const auto expected_weight =
+                            metric_grid.GetCellWeight(partition,
+                                                      level,
+                                                      cell.GetSource(source),
+                                                      cell.GetDestination(destination),
+                                                      excluded);
+                        BOOST_CHECK_EQUAL(cell.GetWeight(source, destination), expected_weight);
+                    }
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(write_header)
+{
+    const Grid grid;
+    const auto partition = makePartition();
+    const CellStorage storage(partition, grid.GetView());
+    const std::string path = "test_cells.tmp";
+    BOOST_REQUIRE(storage.Write(path));
+
+    std::ifstream stream(path, std::ios::binary);
+    CellStorageHeader header;
+    BOOST_REQUIRE(readCellStorageHeader(stream, header));
+    BOOST_CHECK_EQUAL(header.number_of_levels, 2);
+    BOOST_CHECK_EQUAL(header.number_of_nodes, NUMBER_OF_NODES);
+    BOOST_CHECK_EQUAL(header.number_of_cells, 6);
+    BOOST_CHECK_EQUAL(header.GetNumberOfLevelOffsets(), 3);
+    BOOST_CHECK_EQUAL(header.GetNumberOfNodeCells(), 2 * NUMBER_OF_NODES);
+    BOOST_CHECK_EQUAL(header.number_of_metrics, 1);
+    BOOST_CHECK_EQUAL(header.GetNumberOfMetricWeights(), header.number_of_weights);
+    BOOST_CHECK_EQUAL(header.number_of_node_classes, 0);
+    BOOST_CHECK_EQUAL(header.number_of_named_weights, 0);
+    BOOST_CHECK_EQUAL(header.GetNumberOfMetricEdgeWeights(), 0);
+    stream.close();
+    std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
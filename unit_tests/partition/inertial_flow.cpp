@@ -0,0 +1,107 @@
+#include "partition/bisection_graph.hpp"
+#include "partition/inertial_flow.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(inertial_flow)
+
+using namespace osrm;
+using namespace osrm::partition;
+
+namespace
+{
+util::Coordinate makeCoordinate(const double lon, const double lat)
+{
+    return util::Coordinate{util::FloatLongitude{lon}, util::FloatLatitude{lat}};
+}
+
+// A grid of width times height nodes, which are 0.001 degrees apart
+void addGrid(const NodeID width,
+             const NodeID height,
+             const double lon,
+             std::vector<std::pair<NodeID, NodeID>> &edges,
+             std::vector<util::Coordinate> &coordinates)
+{
+    const NodeID first = coordinates.size();
+    for (NodeID y = 0; y < height; ++y)
+    {
+        for (NodeID x = 0; x < width; ++x)
+        {
+            const NodeID node = first + y * width + x;
+            coordinates.push_back(makeCoordinate(lon + x * 0.001, 52.5 + y * 0.001));
+            if (x > 0)
+            {
+                edges.emplace_back(node - 1, node);
+            }
+            if (y > 0)
+            {
+                edges.emplace_back(node - width, node);
+            }
+        }
+    }
+}
+}
+
+BOOST_AUTO_TEST_CASE(make_graph)
+{
+    // duplicates in both directions and loops are dropped
+    const auto graph = makeBisectionGraph(
+        {{0, 1}, {1, 0}, {1, 2}, {0, 1}, {2, 2}},
+        {makeCoordinate(13.4, 52.5), makeCoordinate(13.5, 52.5), makeCoordinate(13.6, 52.5)});
+    BOOST_CHECK_EQUAL(graph.GetNumberOfNodes(), 3);
+    BOOST_CHECK_EQUAL(graph.GetNumberOfEdges(), 4);
+    const std::vector<std::size_t> first_edge = {0, 1, 3, 4};
+    const std::vector<NodeID> targets = {1, 0, 2, 1};
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        graph.first_edge.begin(), graph.first_edge.end(), first_edge.begin(), first_edge.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        graph.targets.begin(), graph.targets.end(), targets.begin(), targets.end());
+
+    std::vector<NodeID> graph_ids;
+    const auto subgraph = makeSubgraph(graph, {false, true, true}, true, graph_ids);
+    BOOST_CHECK_EQUAL(subgraph.GetNumberOfNodes(), 2);
+    BOOST_CHECK_EQUAL(subgraph.GetNumberOfEdges(), 2);
+    const std::vector<NodeID> expected_ids = {1, 2};
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        graph_ids.begin(), graph_ids.end(), expected_ids.begin(), expected_ids.end());
+    BOOST_CHECK(subgraph.coordinates[1] == graph.coordinates[2]);
+}
+
+BOOST_AUTO_TEST_CASE(separate_grids)
+{
+    // two grids next to each other with a single road between them
+    std::vector<std::pair<NodeID, NodeID>> edges;
+    std::vector<util::Coordinate> coordinates;
+    addGrid(10, 10, 13.4, edges, coordinates);
+    addGrid(10, 10, 13.42, edges, coordinates);
+    edges.emplace_back(9, 100);
+    const auto graph = makeBisectionGraph(std::move(edges), std::move(coordinates));
+
+    const auto bisection = inertialFlow(graph, 4, 0.25, 1.2);
+    BOOST_CHECK_EQUAL(bisection.cut_size, 1);
+    for (NodeID node = 0; node < graph.GetNumberOfNodes(); ++node)
+    {
+        BOOST_CHECK_EQUAL(bisection.sides[node], bisection.sides[0] != (node >= 100));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(balanced_grid)
+{
+    // the shortest cut of a wide grid is across it
+    std::vector<std::pair<NodeID, NodeID>> edges;
+    std::vector<util::Coordinate> coordinates;
+    addGrid(40, 10, 13.4, edges, coordinates);
+    const auto graph = makeBisectionGraph(std::move(edges), std::move(coordinates));
+
+    const auto bisection = inertialFlow(graph, 4, 0.25, 1.2);
+    BOOST_CHECK_EQUAL(bisection.cut_size, 10);
+    const auto second_half = std::count(bisection.sides.begin(), bisection.sides.end(), true);
+    BOOST_CHECK_GE(second_half, 100);
+    BOOST_CHECK_LE(second_half, 300);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
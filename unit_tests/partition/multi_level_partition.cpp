@@ -0,0 +1,111 @@
+#include "partition/bisection_graph.hpp"
+#include "partition/multi_level_partition.hpp"
+#include "partition/partitioner_config.hpp"
+#include "partition/recursive_bisection.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(multi_level_partition)
+
+using namespace osrm;
+using namespace osrm::partition;
+
+namespace
+{
+const static std::string PARTITION_TMP_FILE = "test_partition.tmp";
+
+BisectionGraph makeGrid(const NodeID width, const NodeID height)
+{
+    std::vector<std::pair<NodeID, NodeID>> edges;
+    std::vector<util::Coordinate> coordinates;
+    for (NodeID y = 0; y < height; ++y)
+    {
+        for (NodeID x = 0; x < width; ++x)
+        {
+            const NodeID node = y * width + x;
+            coordinates.push_back(util::Coordinate{util::FloatLongitude{13.4 + x * 0.001},
+                                                   util::FloatLatitude{52.5 + y * 0.001}});
+            if (x > 0)
+            {
+                edges.emplace_back(node - 1, node);
+            }
+            if (y > 0)
+            {
+                edges.emplace_back(node - width, node);
+            }
+        }
+    }
+    return makeBisectionGraph(std::move(edges), std::move(coordinates));
+}
+}
+
+BOOST_AUTO_TEST_CASE(common_level)
+{
+    // level 0: {0, 1} {2} {3}, level 1: {0, 1, 2} {3}
+    const MultiLevelPartition partition({2, 3}, {0, 0, 1, 2, 0, 0, 0, 1});
+    BOOST_CHECK_EQUAL(partition.GetNumberOfLevels(), 2);
+    BOOST_CHECK_EQUAL(partition.GetNumberOfNodes(), 4);
+    BOOST_CHECK_EQUAL(partition.GetNumberOfCells(0), 3);
+    BOOST_CHECK_EQUAL(partition.GetNumberOfCells(1), 2);
+    BOOST_CHECK_EQUAL(partition.GetCell(1, 3), 1);
+    BOOST_CHECK_EQUAL(partition.GetCommonLevel(0, 1), 0);
+    BOOST_CHECK_EQUAL(partition.GetCommonLevel(1, 2), 1);
+    BOOST_CHECK_EQUAL(partition.GetCommonLevel(2, 3), 2);
+}
+
+BOOST_AUTO_TEST_CASE(nested_cells)
+{
+    PartitionerConfig config;
+    config.max_cell_sizes = {16, 128, 1024};
+    const auto partition = computeMultiLevelPartition(makeGrid(32, 32), config);
+    BOOST_REQUIRE_EQUAL(partition.GetNumberOfLevels(), 3);
+    BOOST_REQUIRE_EQUAL(partition.GetNumberOfNodes(), 32 * 32);
+    BOOST_CHECK_EQUAL(partition.GetNumberOfCells(2), 1);
+    BOOST_CHECK_GE(partition.GetNumberOfCells(0), 64);
+
+    for (LevelID level = 0; level < partition.GetNumberOfLevels(); ++level)
+    {
+        std::vector<std::uint32_t> cell_sizes(partition.GetNumberOfCells(level), 0);
+        std::vector<CellID> parent_cells(partition.GetNumberOfCells(level), INVALID_CELL_ID);
+        for (NodeID node = 0; node < partition.GetNumberOfNodes(); ++node)
+        {
+            const auto cell = partition.GetCell(level, node);
+            BOOST_REQUIRE_LT(cell, partition.GetNumberOfCells(level));
+            ++cell_sizes[cell];
+            if (level + 1 < partition.GetNumberOfLevels())
+            {
+                // all nodes of a cell are in the same cell of the level above
+                const auto parent_cell = partition.GetCell(level + 1, node);
+                BOOST_CHECK(parent_cells[cell] == INVALID_CELL_ID ||
+                            parent_cells[cell] == parent_cell);
+                parent_cells[cell] = parent_cell;
+            }
+        }
+        for (const auto size : cell_sizes)
+        {
+            BOOST_CHECK_GT(size, 0);
+            BOOST_CHECK_LE(size, partition.GetMaxCellSize(level));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(read_write)
+{
+    const MultiLevelPartition partition({2, 3}, {0, 0, 1, 2, 0, 0, 0, 1});
+    BOOST_REQUIRE(writeMultiLevelPartition(PARTITION_TMP_FILE, partition));
+
+    MultiLevelPartition read_partition;
+    BOOST_REQUIRE(readMultiLevelPartition(PARTITION_TMP_FILE, read_partition));
+    BOOST_CHECK_EQUAL(read_partition.GetNumberOfLevels(), 2);
+    BOOST_CHECK_EQUAL(read_partition.GetMaxCellSize(1), 3);
+    const auto &cells = partition.GetCells();
+    const auto &read_cells = read_partition.GetCells();
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        read_cells.begin(), read_cells.end(), cells.begin(), cells.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,77 @@
+#include "contractor/nested_dissection_order.hpp"
+#include "contractor/query_edge.hpp"
+#include "partition/multi_level_partition.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(nested_dissection_order)
+
+using namespace osrm;
+using namespace osrm::contractor;
+using namespace osrm::partition;
+
+namespace
+{
+struct TestEdge
+{
+    NodeID source;
+    NodeID target;
+};
+
+contractor::QueryEdge makeUpwardEdge(const NodeID source, const NodeID target)
+{
+    contractor::QueryEdge::EdgeData data;
+    data.forward = true;
+    return contractor::QueryEdge(source, target, data);
+}
+}
+
+BOOST_AUTO_TEST_CASE(separator_levels)
+{
+    // a path of eight nodes in four cells on level 0 and two cells on level 1
+    const MultiLevelPartition partition({2, 4},
+                                        {0, 0, 1, 1, 2, 2, 3, 3, 0, 0, 0, 0, 1, 1, 1, 1});
+    std::vector<TestEdge> edges;
+    for (NodeID node = 0; node + 1 < 8; ++node)
+    {
+        edges.push_back(TestEdge{node, node + 1});
+    }
+
+    const auto order = computeNestedDissectionOrder(partition, edges);
+    BOOST_REQUIRE_EQUAL(order.size(), 8);
+
+    // the nodes inside the cells, at the cuts of level 0 and at the cut of level 1
+    const std::vector<float> levels = {0, 1, 1, 2, 2, 1, 1, 0};
+    for (NodeID node = 0; node < 8; ++node)
+    {
+        BOOST_CHECK_EQUAL(std::floor(order[node]), levels[node]);
+    }
+    // the ends of the path have fewer edges
+    BOOST_CHECK_LT(order[0], order[1] - 1);
+    BOOST_CHECK_EQUAL(order[1], order[2]);
+}
+
+BOOST_AUTO_TEST_CASE(search_space_sizes)
+{
+    // 0 -> 1 -> 2 <- 3 and the isolated node 4, with the downward edges that are ignored
+    std::vector<contractor::QueryEdge> edges = {
+        makeUpwardEdge(0, 1), makeUpwardEdge(1, 2), makeUpwardEdge(3, 2)};
+    edges.push_back(contractor::QueryEdge(2, 0, contractor::QueryEdge::EdgeData()));
+
+    const auto all_nodes = computeSearchSpaceSizes(edges, 5, 10);
+    BOOST_CHECK_EQUAL(all_nodes.number_of_samples, 5);
+    BOOST_CHECK_CLOSE(all_nodes.average, (3 + 2 + 1 + 2 + 1) / 5., 1e-6);
+    BOOST_CHECK_EQUAL(all_nodes.maximum, 3);
+
+    // every second node
+    const auto sample = computeSearchSpaceSizes(edges, 4, 2);
+    BOOST_CHECK_EQUAL(sample.number_of_samples, 2);
+    BOOST_CHECK_CLOSE(sample.average, (3 + 1) / 2., 1e-6);
+
+    BOOST_CHECK_EQUAL(computeSearchSpaceSizes(edges, 0, 2).number_of_samples, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
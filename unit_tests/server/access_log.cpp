@@ -0,0 +1,110 @@
+#include "server/access_log.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(access_log)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+AccessLog::Record makeRecord(const int status, const std::string &request)
+{
+    return {0,
+            boost::asio::ip::address::from_string("127.0.0.1"),
+            "",
+            "curl \"7\"",
+            status,
+            std::chrono::microseconds(1500),
+            request};
+}
+}
+
+BOOST_AUTO_TEST_CASE(formats)
+{
+    std::ostringstream json;
+    AccessLog::Write(AccessLog::Format::JSON, makeRecord(200, "/route/v1/driving/1,2;3,4"), json);
+    BOOST_CHECK_EQUAL(json.str(),
+                      "{\"time\":\"1970-01-01T00:00:00Z\",\"client\":\"127.0.0.1\",\"referrer\":"
+                      "\"\",\"agent\":\"curl \\\"7\\\"\",\"status\":200,\"duration_us\":1500,"
+                      "\"request\":\"\\/route\\/v1\\/driving\\/1,2;3,4\"}\n");
+
+    // the time is local
+    std::ostringstream text;
+    AccessLog::Write(AccessLog::Format::Text, makeRecord(400, "/nearest"), text);
+    const auto line = text.str();
+    BOOST_CHECK_EQUAL(line.substr(0, 7), "[info] ");
+    const std::string end = " 127.0.0.1 - curl \"7\" 400 /nearest\n";
+    BOOST_REQUIRE_GT(line.size(), end.size());
+    BOOST_CHECK_EQUAL(line.substr(line.size() - end.size()), end);
+}
+
+BOOST_AUTO_TEST_CASE(drained_from_all_threads)
+{
+    std::ostringstream output;
+    {
+        AccessLog log(AccessLog::Format::Text, 1, output, 64);
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < 4; ++thread)
+        {
+            threads.emplace_back([&log, thread] {
+                for (int request = 0; request < 50; ++request)
+                {
+                    log.Add(makeRecord(200, "/" + std::to_string(thread * 100 + request)));
+                }
+            });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        BOOST_CHECK_EQUAL(log.GetDropped(), 0);
+    }
+
+    const auto text = output.str();
+    BOOST_CHECK_EQUAL(std::count(text.begin(), text.end(), '\n'), 200);
+    BOOST_CHECK(text.find(" 200 /0\n") != std::string::npos);
+    BOOST_CHECK(text.find(" 200 /349\n") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(full_buffers_drop_records)
+{
+    std::ostringstream output;
+    std::uint64_t dropped = 0;
+    {
+        AccessLog log(AccessLog::Format::Text, 1, output, 4);
+        for (int request = 0; request < 1000; ++request)
+        {
+            log.Add(makeRecord(200, "/" + std::to_string(request)));
+        }
+        dropped = log.GetDropped();
+    }
+
+    const auto text = output.str();
+    BOOST_CHECK_GT(dropped, 0);
+    BOOST_CHECK_EQUAL(std::count(text.begin(), text.end(), '\n') + dropped, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(sampling)
+{
+    std::ostringstream output;
+    AccessLog log(AccessLog::Format::Text, 0, output);
+    BOOST_CHECK(!log.IsSampled(200));
+    BOOST_CHECK(log.IsSampled(400));
+    BOOST_CHECK(log.IsSampled(500));
+
+    AccessLog full_log(AccessLog::Format::Text, 1, output);
+    BOOST_CHECK(full_log.IsSampled(200));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
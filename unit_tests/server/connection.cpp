@@ -0,0 +1,125 @@
+#include "server/connection.hpp"
+#include "server/request_handler.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <string>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(connection)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+// A connection of a request handler without datasets, which answers every request with an
+// internal server error. The client side is a blocking socket of the test.
+struct ConnectedClient
+{
+    ConnectedClient()
+        : acceptor(io_service,
+                   boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)),
+          client(io_service)
+    {
+        const auto connection = std::make_shared<Connection>(io_service, request_handler);
+        client.connect(acceptor.local_endpoint());
+        acceptor.accept(connection->socket());
+        connection->start();
+        // runs until the connection is closed
+        worker = std::thread([this] { io_service.run(); });
+    }
+
+    ~ConnectedClient()
+    {
+        boost::system::error_code ignore_error;
+        client.close(ignore_error);
+        worker.join();
+    }
+
+    void Write(const std::string &requests)
+    {
+        boost::asio::write(client, boost::asio::buffer(requests));
+    }
+
+    // the status line and headers of the next reply, its body is skipped
+    std::string ReadReply()
+    {
+        const auto header_size = boost::asio::read_until(client, input, "\r\n\r\n");
+        std::string headers(header_size, '\0');
+        std::istream(&input).read(&headers[0], header_size);
+
+        const std::string content_length = "Content-Length: ";
+        const auto length_begin = headers.find(content_length);
+        BOOST_REQUIRE(length_begin != std::string::npos);
+        const std::size_t body_size =
+            std::stoul(headers.substr(length_begin + content_length.size()));
+        if (input.size() < body_size)
+        {
+            boost::asio::read(
+                client, input, boost::asio::transfer_exactly(body_size - input.size()));
+        }
+        input.consume(body_size);
+        return headers;
+    }
+
+    bool IsClosed()
+    {
+        boost::system::error_code error;
+        char byte;
+        client.read_some(boost::asio::buffer(&byte, 1), error);
+        return error == boost::asio::error::eof;
+    }
+
+    boost::asio::io_service io_service;
+    RequestHandler request_handler;
+    boost::asio::ip::tcp::acceptor acceptor;
+    boost::asio::ip::tcp::socket client;
+    boost::asio::streambuf input;
+    std::thread worker;
+};
+
+bool KeepsAlive(const std::string &headers)
+{
+    return headers.find("\r\nConnection: keep-alive\r\n") != std::string::npos;
+}
+}
+
+BOOST_AUTO_TEST_CASE(requests_on_one_connection)
+{
+    ConnectedClient client;
+    for (const auto &uri : {"/route/v1/driving/1,2;3,4", "/table/v1/driving/1,2;3,4"})
+    {
+        client.Write(std::string("GET ") + uri + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        const auto reply = client.ReadReply();
+        BOOST_CHECK_EQUAL(reply.substr(0, reply.find("\r\n")),
+                          "HTTP/1.1 500 Internal Server Error");
+        BOOST_CHECK(KeepsAlive(reply));
+    }
+
+    client.Write("GET /nearest/v1/driving/1,2 HTTP/1.1\r\nConnection: close\r\n\r\n");
+    BOOST_CHECK(!KeepsAlive(client.ReadReply()));
+    BOOST_CHECK(client.IsClosed());
+}
+
+// requests sent before the replies are answered in order, one reply each
+BOOST_AUTO_TEST_CASE(pipelined_requests)
+{
+    ConnectedClient client;
+    client.Write("GET /route/v1/driving/1,2;3,4 HTTP/1.1\r\n\r\n"
+                 "GET /route/v1/driving/5,6;7,8 HTTP/1.1\r\n\r\n"
+                 "GET /route/v1/driving/1,2;3,4 HTTP/1.0\r\n\r\n");
+
+    BOOST_CHECK(KeepsAlive(client.ReadReply()));
+    BOOST_CHECK(KeepsAlive(client.ReadReply()));
+    // HTTP/1.0 closes the connection without a keep-alive header
+    BOOST_CHECK(!KeepsAlive(client.ReadReply()));
+    BOOST_CHECK(client.IsClosed());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,8 +3,10 @@
 #include "parameters_io.hpp"
 
 #include "engine/api/base_parameters.hpp"
+#include "engine/api/isochrone_parameters.hpp"
 #include "engine/api/match_parameters.hpp"
 #include "engine/api/nearest_parameters.hpp"
+#include "engine/api/route_batch_parameters.hpp"
 #include "engine/api/route_parameters.hpp"
 #include "engine/api/table_parameters.hpp"
 #include "engine/api/tile_parameters.hpp"
@@ -14,6 +16,9 @@
 #include <boost/test/test_tools.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <limits>
+#include <string>
+
 #define CHECK_EQUAL_RANGE(R1, R2)                                                                  \
     BOOST_CHECK_EQUAL_COLLECTIONS(R1.begin(), R1.end(), R2.begin(), R2.end());
 
@@ -72,6 +77,8 @@ BOOST_AUTO_TEST_CASE(invalid_table_urls)
         testInvalidOptions<TableParameters>("1,2;3,4?sources=1&destinations=1&bla=foo"), 32UL);
     BOOST_CHECK_EQUAL(testInvalidOptions<TableParameters>("1,2;3,4?sources=foo"), 16UL);
     BOOST_CHECK_EQUAL(testInvalidOptions<TableParameters>("1,2;3,4?destinations=foo"), 21UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<TableParameters>("1,2;3,4?max_duration=foo"), 21UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<TableParameters>("1,2;3,4?session="), 16UL);
 }
 
 BOOST_AUTO_TEST_CASE(valid_route_urls)
@@ -289,6 +296,47 @@ BOOST_AUTO_TEST_CASE(valid_route_urls)
     CHECK_EQUAL_RANGE(reference_10.radiuses, result_10->radiuses);
     CHECK_EQUAL_RANGE(reference_10.coordinates, result_10->coordinates);
     CHECK_EQUAL_RANGE(reference_10.hints, result_10->hints);
+
+    auto result_11 = parseParameters<RouteParameters>("1,2;3,4?geometries=polyline6");
+    BOOST_CHECK(result_11);
+    BOOST_CHECK_EQUAL(result_11->geometries, RouteParameters::GeometriesType::Polyline6);
+
+    engine::PhantomNode compact_phantom;
+    compact_phantom.forward_segment_id = {12, true};
+    compact_phantom.reverse_segment_id = {13, true};
+    compact_phantom.fwd_segment_position = 2;
+    compact_phantom.forward_offset = 30;
+    compact_phantom.forward_weight = 4;
+    const auto compact_hint = engine::Hint{compact_phantom, 42}.ToCompactBase64();
+    auto result_12 = parseParameters<RouteParameters>(
+        "1,2;3,4?hints=" + compact_hint +
+        ";cgAAgP___39jAAAADgAAACIAAABeAAAAkQAAANoDAABOAgAAGwAAAFVGcQCiRJsCR0VxAOZFmwIF"
+        "AAEBl-Umfg==");
+    BOOST_REQUIRE(result_12);
+    BOOST_REQUIRE_EQUAL(result_12->hints.size(), 2);
+    BOOST_REQUIRE(result_12->hints[0]);
+    BOOST_CHECK_EQUAL(result_12->hints[0]->data_checksum, 42);
+    BOOST_CHECK_EQUAL(result_12->hints[0]->phantom.forward_segment_id.id, 12);
+    BOOST_CHECK_EQUAL(result_12->hints[0]->phantom.reverse_segment_id.id, 13);
+    BOOST_CHECK_EQUAL(result_12->hints[0]->phantom.fwd_segment_position, 2);
+    BOOST_CHECK_EQUAL(result_12->hints[0]->phantom.forward_offset +
+                          result_12->hints[0]->phantom.forward_weight,
+                      34);
+    BOOST_CHECK_EQUAL(result_12->hints[1], hints_4[1]);
+
+    auto result_13 = parseParameters<RouteParameters>("1,2;3,4?alternatives=3");
+    BOOST_CHECK(result_13);
+    BOOST_CHECK_EQUAL(result_13->alternatives, true);
+    BOOST_CHECK_EQUAL(result_13->number_of_alternatives, 3);
+
+    auto result_14 = parseParameters<RouteParameters>("1,2;3,4?alternatives=0");
+    BOOST_CHECK(result_14);
+    BOOST_CHECK_EQUAL(result_14->alternatives, false);
+
+    auto result_15 = parseParameters<RouteParameters>("1,2;3,4?alternatives=true");
+    BOOST_CHECK(result_15);
+    BOOST_CHECK_EQUAL(result_15->alternatives, true);
+    BOOST_CHECK_EQUAL(result_15->number_of_alternatives, 1);
 }
 
 BOOST_AUTO_TEST_CASE(valid_table_urls)
@@ -325,6 +373,34 @@ BOOST_AUTO_TEST_CASE(valid_table_urls)
     CHECK_EQUAL_RANGE(reference_1.bearings, result_3->bearings);
     CHECK_EQUAL_RANGE(reference_1.radiuses, result_3->radiuses);
     CHECK_EQUAL_RANGE(reference_1.coordinates, result_3->coordinates);
+
+    auto result_4 = parseParameters<TableParameters>("1,2;3,4.json?sources=1");
+    BOOST_CHECK(result_4);
+    BOOST_CHECK(result_4->format == TableParameters::OutputFormatType::JSON);
+    CHECK_EQUAL_RANGE(reference_1.coordinates, result_4->coordinates);
+
+    auto result_5 = parseParameters<TableParameters>("1,2;3,4.pbf?sources=1");
+    BOOST_CHECK(result_5);
+    BOOST_CHECK(result_5->format == TableParameters::OutputFormatType::PBF);
+    CHECK_EQUAL_RANGE(reference_1.coordinates, result_5->coordinates);
+
+    auto result_6 = parseParameters<TableParameters>("1,2;3,4.5.pbf");
+    BOOST_CHECK(result_6);
+    BOOST_CHECK(result_6->format == TableParameters::OutputFormatType::PBF);
+    BOOST_CHECK_EQUAL(result_6->coordinates.back(),
+                      util::Coordinate(util::FloatLongitude{3}, util::FloatLatitude{4.5}));
+
+    BOOST_CHECK(!result_1->max_duration);
+    auto result_7 = parseParameters<TableParameters>("1,2;3,4?sources=1&max_duration=1800.5");
+    BOOST_CHECK(result_7);
+    BOOST_REQUIRE(result_7->max_duration);
+    BOOST_CHECK_EQUAL(*result_7->max_duration, 1800.5);
+    CHECK_EQUAL_RANGE(result_4->sources, result_7->sources);
+
+    BOOST_CHECK(result_1->session.empty());
+    auto result_8 = parseParameters<TableParameters>("1,2;3,4?session=fleet-7_a.b~");
+    BOOST_CHECK(result_8);
+    BOOST_CHECK_EQUAL(result_8->session, "fleet-7_a.b~");
 }
 
 BOOST_AUTO_TEST_CASE(valid_match_urls)
@@ -350,6 +426,62 @@ BOOST_AUTO_TEST_CASE(valid_match_urls)
     CHECK_EQUAL_RANGE(reference_2.bearings, result_2->bearings);
     CHECK_EQUAL_RANGE(reference_2.radiuses, result_2->radiuses);
     CHECK_EQUAL_RANGE(reference_2.coordinates, result_2->coordinates);
+    BOOST_CHECK_EQUAL(result_2->max_candidates, 0);
+    BOOST_CHECK(!result_2->heading_tolerance);
+    BOOST_CHECK(!result_2->tidy);
+
+    auto result_3 =
+        parseParameters<MatchParameters>("1,2;3,4?max_candidates=3&heading_tolerance=45");
+    BOOST_CHECK(result_3);
+    BOOST_CHECK(result_3->IsValid());
+    BOOST_CHECK_EQUAL(result_3->max_candidates, 3);
+    BOOST_CHECK_EQUAL(result_3->heading_tolerance, boost::make_optional(45u));
+    CHECK_EQUAL_RANGE(reference_1.coordinates, result_3->coordinates);
+
+    auto result_4 = parseParameters<MatchParameters>("1,2;3,4?heading_tolerance=270");
+    BOOST_CHECK(result_4);
+    BOOST_CHECK(!result_4->IsValid());
+
+    auto result_5 = parseParameters<MatchParameters>("1,2;3,4?tidy=true&timestamps=5;6");
+    BOOST_CHECK(result_5);
+    BOOST_CHECK(result_5->tidy);
+    CHECK_EQUAL_RANGE(reference_2.timestamps, result_5->timestamps);
+
+    BOOST_CHECK_EQUAL(testInvalidOptions<MatchParameters>("1,2;3,4?max_candidates=-1"), 23UL);
+}
+
+BOOST_AUTO_TEST_CASE(valid_route_batch_urls)
+{
+    std::vector<util::Coordinate> coords_1 = {{util::FloatLongitude{1}, util::FloatLatitude{2}},
+                                              {util::FloatLongitude{3}, util::FloatLatitude{4}},
+                                              {util::FloatLongitude{5}, util::FloatLatitude{6}},
+                                              {util::FloatLongitude{7}, util::FloatLatitude{8}}};
+
+    auto result_1 = parseParameters<RouteBatchParameters>("1,2;3,4;5,6;7,8");
+    BOOST_CHECK(result_1);
+    BOOST_CHECK(result_1->IsValid());
+    BOOST_CHECK_EQUAL(result_1->summary, false);
+    CHECK_EQUAL_RANGE(coords_1, result_1->coordinates);
+
+    auto result_2 =
+        parseParameters<RouteBatchParameters>("1,2;3,4;5,6;7,8?summary=true&overview=false");
+    BOOST_CHECK(result_2);
+    BOOST_CHECK_EQUAL(result_2->summary, true);
+    BOOST_CHECK(result_2->overview == RouteParameters::OverviewType::False);
+    CHECK_EQUAL_RANGE(coords_1, result_2->coordinates);
+
+    auto result_3 = parseParameters<RouteBatchParameters>("1,2;3,4;5,6");
+    BOOST_CHECK(result_3);
+    BOOST_CHECK(!result_3->IsValid());
+
+    // the pairs are routed without alternatives, also if the parameters come from libosrm
+    auto result_4 = parseParameters<RouteBatchParameters>("1,2;3,4");
+    BOOST_REQUIRE(result_4);
+    result_4->alternatives = true;
+    BOOST_CHECK(!result_4->IsValid());
+
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteBatchParameters>("1,2;3,4?summary=yes"), 16UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteBatchParameters>("1,2;3,4?alternatives=true"), 8UL);
 }
 
 BOOST_AUTO_TEST_CASE(valid_nearest_urls)
@@ -374,6 +506,46 @@ BOOST_AUTO_TEST_CASE(valid_nearest_urls)
     CHECK_EQUAL_RANGE(reference_2.bearings, result_2->bearings);
     CHECK_EQUAL_RANGE(reference_2.radiuses, result_2->radiuses);
     CHECK_EQUAL_RANGE(reference_2.coordinates, result_2->coordinates);
+
+    auto result_3 = parseParameters<NearestParameters>("1,2?debug=true&number=3");
+    BOOST_CHECK(result_3);
+    BOOST_CHECK_EQUAL(result_3->debug, true);
+    BOOST_CHECK_EQUAL(result_3->number_of_results, 3);
+    BOOST_CHECK_EQUAL(result_1->debug, false);
+
+    BOOST_CHECK_EQUAL(testInvalidOptions<NearestParameters>("1,2?debug=yes"), 10UL);
+}
+
+BOOST_AUTO_TEST_CASE(valid_isochrone_urls)
+{
+    std::vector<util::Coordinate> coords_1 = {{util::FloatLongitude{1}, util::FloatLatitude{2}}};
+
+    auto result_1 = parseParameters<IsochroneParameters>("1,2?contours=300;600;900");
+    BOOST_CHECK(result_1);
+    BOOST_CHECK(result_1->IsValid());
+    std::vector<unsigned> contours_1 = {300, 600, 900};
+    CHECK_EQUAL_RANGE(contours_1, result_1->contours);
+    BOOST_CHECK_EQUAL(result_1->cell_size, 100.);
+    CHECK_EQUAL_RANGE(coords_1, result_1->coordinates);
+
+    auto result_2 = parseParameters<IsochroneParameters>("1,2.json?cell_size=250&contours=60");
+    BOOST_CHECK(result_2);
+    BOOST_CHECK(result_2->IsValid());
+    BOOST_CHECK_EQUAL(result_2->contours.size(), 1);
+    BOOST_CHECK_EQUAL(result_2->cell_size, 250.);
+
+    // a contour is needed, and only one coordinate
+    auto result_3 = parseParameters<IsochroneParameters>("1,2");
+    BOOST_CHECK(result_3);
+    BOOST_CHECK(!result_3->IsValid());
+    auto result_4 = parseParameters<IsochroneParameters>("1,2;3,4?contours=60");
+    BOOST_CHECK(result_4);
+    BOOST_CHECK(!result_4->IsValid());
+    auto result_5 = parseParameters<IsochroneParameters>("1,2?contours=60&cell_size=1");
+    BOOST_CHECK(result_5);
+    BOOST_CHECK(!result_5->IsValid());
+
+    BOOST_CHECK_EQUAL(testInvalidOptions<IsochroneParameters>("1,2?contours=a"), 13UL);
 }
 
 BOOST_AUTO_TEST_CASE(valid_tile_urls)
@@ -400,4 +572,68 @@ BOOST_AUTO_TEST_CASE(valid_trip_urls)
     CHECK_EQUAL_RANGE(reference_1.coordinates, result_1->coordinates);
 }
 
+BOOST_AUTO_TEST_CASE(valid_urls_with_many_coordinates)
+{
+    std::vector<util::Coordinate> coordinates;
+    std::string query;
+    std::string radiuses = "radiuses=";
+    std::string sources = "sources=";
+    for (int index = 0; index < 100; ++index)
+    {
+        const auto longitude = std::to_string(13 + index / 1000.) + "1234";
+        const auto latitude = "-52." + std::to_string(100000 + index);
+        coordinates.emplace_back(util::FloatLongitude{std::stod(longitude)},
+                                 util::FloatLatitude{std::stod(latitude)});
+        query += (index == 0 ? "" : ";") + longitude + "," + latitude;
+        radiuses += index == 0 ? "" : index % 3 == 0 ? ";unlimited" : ";" + std::to_string(index);
+        sources += (index == 0 ? "" : ";") + std::to_string(99 - index);
+    }
+
+    auto result_1 = parseParameters<RouteParameters>(query + "?steps=true&" + radiuses);
+    BOOST_REQUIRE(result_1);
+    BOOST_CHECK(result_1->steps);
+    CHECK_EQUAL_RANGE(coordinates, result_1->coordinates);
+    BOOST_REQUIRE_EQUAL(result_1->radiuses.size(), 100);
+    BOOST_CHECK(!result_1->radiuses[0]);
+    BOOST_CHECK_EQUAL(*result_1->radiuses[1], 1.);
+    BOOST_CHECK_EQUAL(*result_1->radiuses[3], std::numeric_limits<double>::infinity());
+
+    auto result_2 =
+        parseParameters<TableParameters>(query + ".pbf?" + sources + "&destinations=all");
+    BOOST_REQUIRE(result_2);
+    BOOST_CHECK(result_2->format == TableParameters::OutputFormatType::PBF);
+    CHECK_EQUAL_RANGE(coordinates, result_2->coordinates);
+    BOOST_REQUIRE_EQUAL(result_2->sources.size(), 100);
+    BOOST_CHECK_EQUAL(result_2->sources.front(), 99);
+    BOOST_CHECK(result_2->destinations.empty());
+
+    // lists of compact hints, where the full encoding must not run over the separators
+    engine::PhantomNode phantom;
+    phantom.forward_segment_id = {12, true};
+    phantom.reverse_segment_id = {13, true};
+    const auto hint = engine::Hint{phantom, 42}.ToCompactBase64();
+    auto result_3 = parseParameters<MatchParameters>(
+        "1,2;3,4;5,6;7,8;9,10?hints=" + hint + ";" + hint + ";;" + hint + ";" + hint);
+    BOOST_REQUIRE(result_3);
+    BOOST_REQUIRE_EQUAL(result_3->hints.size(), 5);
+    BOOST_CHECK(!result_3->hints[2]);
+    BOOST_REQUIRE(result_3->hints[4]);
+    BOOST_CHECK_EQUAL(result_3->hints[4]->phantom.reverse_segment_id.id, 13);
+
+    // the forms only the grammars take give the same parameters
+    auto result_4 = parseParameters<RouteParameters>("+1,.2;3.,40?radiuses=1e2;unlimited");
+    BOOST_REQUIRE(result_4);
+    BOOST_CHECK_EQUAL(result_4->coordinates.front(),
+                      util::Coordinate(util::FloatLongitude{1}, util::FloatLatitude{0.2}));
+    BOOST_CHECK_EQUAL(result_4->coordinates.back(),
+                      util::Coordinate(util::FloatLongitude{3}, util::FloatLatitude{40}));
+    BOOST_REQUIRE_EQUAL(result_4->radiuses.size(), 2);
+    BOOST_CHECK_EQUAL(*result_4->radiuses.front(), 100.);
+
+    auto result_5 = parseParameters<RouteParameters>("1,2;3,4?radiuses=1e2&hints=;");
+    BOOST_REQUIRE(result_5);
+    BOOST_CHECK_EQUAL(result_5->hints.size(), 2);
+    BOOST_CHECK_EQUAL(*result_5->radiuses.front(), 100.);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
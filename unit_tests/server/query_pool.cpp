@@ -0,0 +1,123 @@
+#include "server/query_pool.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(query_pool)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+// Keeps the queries that wait on it running until it is opened
+struct Gate
+{
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        opened.wait(lock, [this] { return open; });
+    }
+
+    void Open()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            open = true;
+        }
+        opened.notify_all();
+    }
+
+    std::mutex mutex;
+    std::condition_variable opened;
+    bool open = false;
+};
+
+// Records the order in which queries ran and lets the test wait for them
+struct Log
+{
+    void Add(const std::string &name)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            names.push_back(name);
+        }
+        changed.notify_all();
+    }
+
+    std::vector<std::string> WaitFor(const std::size_t number_of_names)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return names.size() >= number_of_names; });
+        return names;
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::string> names;
+};
+}
+
+BOOST_AUTO_TEST_CASE(priority_by_service)
+{
+    using Priority = QueryPool::Priority;
+    BOOST_CHECK(QueryPool::GetPriority("/route/v1/driving/1,2;3,4") == Priority::cheap);
+    BOOST_CHECK(QueryPool::GetPriority("/nearest/v1/driving/1,2") == Priority::cheap);
+    BOOST_CHECK(QueryPool::GetPriority("route") == Priority::cheap);
+    BOOST_CHECK(QueryPool::GetPriority("/table/v1/driving/1,2;3,4") == Priority::heavy);
+    BOOST_CHECK(QueryPool::GetPriority("/routes/v1/driving/1,2;3,4") == Priority::heavy);
+    BOOST_CHECK(QueryPool::GetPriority("/") == Priority::heavy);
+    BOOST_CHECK(QueryPool::GetPriority("") == Priority::heavy);
+}
+
+BOOST_AUTO_TEST_CASE(cheap_queries_first)
+{
+    Gate gate;
+    Log log;
+    QueryPool pool(1, 4);
+
+    // occupies the only thread until the other queries are queued
+    BOOST_CHECK(pool.Submit(QueryPool::Priority::cheap, [&] {
+        gate.Wait();
+        log.Add("blocker");
+    }));
+    BOOST_CHECK(pool.Submit(QueryPool::Priority::heavy, [&] { log.Add("heavy"); }));
+    BOOST_CHECK(pool.Submit(QueryPool::Priority::cheap, [&] { log.Add("cheap"); }));
+    gate.Open();
+
+    const std::vector<std::string> expected = {"blocker", "cheap", "heavy"};
+    const auto names = log.WaitFor(expected.size());
+    BOOST_CHECK_EQUAL_COLLECTIONS(names.begin(), names.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(full_queue_rejects)
+{
+    Gate gate;
+    Log log;
+    QueryPool pool(1, 1);
+
+    BOOST_CHECK(pool.Submit(QueryPool::Priority::heavy, [&] {
+        gate.Wait();
+        log.Add("running");
+    }));
+    // the running query has left the queue once the next one fits, which needs a moment
+    while (!pool.Submit(QueryPool::Priority::heavy, [&] { log.Add("queued"); }))
+    {
+    }
+    BOOST_CHECK(!pool.Submit(QueryPool::Priority::heavy, [&] { log.Add("rejected"); }));
+    // the queues are bounded per priority
+    BOOST_CHECK(pool.Submit(QueryPool::Priority::cheap, [&] { log.Add("cheap"); }));
+    BOOST_CHECK(!pool.Submit(QueryPool::Priority::cheap, [&] { log.Add("rejected"); }));
+    gate.Open();
+
+    const std::vector<std::string> expected = {"running", "cheap", "queued"};
+    const auto names = log.WaitFor(expected.size());
+    BOOST_CHECK_EQUAL_COLLECTIONS(names.begin(), names.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
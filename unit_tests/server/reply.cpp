@@ -0,0 +1,104 @@
+#include "server/http/reply.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(reply)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+template <typename BuffersT> std::string concatenate(const BuffersT &buffers)
+{
+    std::string written;
+    for (const auto &buffer : buffers)
+    {
+        const auto *data = boost::asio::buffer_cast<const char *>(buffer);
+        written.append(data, boost::asio::buffer_size(buffer));
+    }
+    return written;
+}
+}
+
+BOOST_AUTO_TEST_CASE(service_reply)
+{
+    http::reply reply;
+    reply.common_headers = http::reply::static_headers::json;
+    const std::string content = "{\"code\":\"Ok\"}";
+    reply.content.assign(content.begin(), content.end());
+    reply.set_keep_alive(true);
+
+    BOOST_CHECK_EQUAL(concatenate(reply.to_buffers()),
+                      "HTTP/1.1 200 OK\r\n"
+                      "Access-Control-Allow-Origin: *\r\n"
+                      "Access-Control-Allow-Methods: GET, POST\r\n"
+                      "Access-Control-Allow-Headers: X-Requested-With, Content-Type\r\n"
+                      "Content-Type: application/json; charset=UTF-8\r\n"
+                      "Content-Disposition: inline; filename=\"response.json\"\r\n"
+                      "Content-Length: 13\r\n"
+                      "Connection: keep-alive\r\n"
+                      "\r\n"
+                      "{\"code\":\"Ok\"}");
+}
+
+BOOST_AUTO_TEST_CASE(compressed_body)
+{
+    http::reply reply;
+    reply.common_headers = http::reply::static_headers::protobuf;
+    reply.headers.emplace_back("X-Tile", "1");
+    reply.content.assign(100, 'a');
+    reply.content_encoding = "gzip";
+    const std::vector<char> compressed(10, 'z');
+
+    BOOST_CHECK_EQUAL(concatenate(reply.to_buffers(compressed)),
+                      "HTTP/1.1 200 OK\r\n"
+                      "Access-Control-Allow-Origin: *\r\n"
+                      "Access-Control-Allow-Methods: GET, POST\r\n"
+                      "Access-Control-Allow-Headers: X-Requested-With, Content-Type\r\n"
+                      "Content-Type: application/x-protobuf\r\n"
+                      "X-Tile: 1\r\n"
+                      "Content-Encoding: gzip\r\n"
+                      "Content-Length: 10\r\n"
+                      "Connection: close\r\n"
+                      "\r\n"
+                      "zzzzzzzzzz");
+}
+
+BOOST_AUTO_TEST_CASE(streamed_reply)
+{
+    http::reply reply;
+    reply.common_headers = http::reply::static_headers::json;
+    reply.is_streamed = true;
+    reply.set_keep_alive(true);
+
+    // the chunks follow the headers
+    BOOST_CHECK_EQUAL(concatenate(reply.to_buffers()),
+                      "HTTP/1.1 200 OK\r\n"
+                      "Access-Control-Allow-Origin: *\r\n"
+                      "Access-Control-Allow-Methods: GET, POST\r\n"
+                      "Access-Control-Allow-Headers: X-Requested-With, Content-Type\r\n"
+                      "Content-Type: application/json; charset=UTF-8\r\n"
+                      "Content-Disposition: inline; filename=\"response.json\"\r\n"
+                      "Transfer-Encoding: chunked\r\n"
+                      "Connection: keep-alive\r\n"
+                      "\r\n");
+}
+
+BOOST_AUTO_TEST_CASE(stock_reply)
+{
+    auto reply = http::reply::stock_reply(http::reply::too_many_requests);
+    const auto written = concatenate(reply.to_buffers());
+    BOOST_CHECK_EQUAL(written.substr(0, written.find("\r\n\r\n")),
+                      "HTTP/1.1 429 Too Many Requests\r\n"
+                      "Access-Control-Allow-Origin: *\r\n"
+                      "Content-Type: text/html\r\n"
+                      "Content-Length: 74\r\n"
+                      "Connection: close");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+#include "server/request_coalescer.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(request_coalescer)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+std::string getContent(const http::reply &reply)
+{
+    return std::string(reply.content.begin(), reply.content.end());
+}
+}
+
+BOOST_AUTO_TEST_CASE(shared_reply)
+{
+    RequestCoalescer coalescer;
+    auto computing = coalescer.Join("1/0/route/a");
+    BOOST_REQUIRE(computing.IsComputing());
+
+    // another key computes by itself
+    auto other = coalescer.Join("1/0/route/b");
+    BOOST_CHECK(other.IsComputing());
+
+    std::vector<std::string> contents(4);
+    std::vector<std::thread> threads;
+    for (auto &content : contents)
+    {
+        auto waiting = coalescer.Join("1/0/route/a");
+        BOOST_REQUIRE(!waiting.IsComputing());
+        threads.emplace_back([&content](RequestCoalescer::Ticket &&ticket) {
+            http::reply reply;
+            if (ticket.Wait(reply))
+            {
+                content = getContent(reply);
+            }
+        }, std::move(waiting));
+    }
+
+    http::reply reply;
+    const std::string content = "{\"code\":\"Ok\"}";
+    reply.content.assign(content.begin(), content.end());
+    computing.Finish(reply);
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    for (const auto &waited_content : contents)
+    {
+        BOOST_CHECK_EQUAL(waited_content, content);
+    }
+
+    // the key computes again once it finished
+    BOOST_CHECK(coalescer.Join("1/0/route/a").IsComputing());
+
+    const auto statistics = coalescer.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.computed, 3);
+    BOOST_CHECK_EQUAL(statistics.coalesced, 4);
+}
+
+BOOST_AUTO_TEST_CASE(failed_computation)
+{
+    RequestCoalescer coalescer;
+    auto waiting = [&] {
+        auto computing = coalescer.Join("1/0/table/a");
+        BOOST_REQUIRE(computing.IsComputing());
+        return coalescer.Join("1/0/table/a");
+        // the computation ends without a reply
+    }();
+
+    http::reply reply;
+    BOOST_CHECK(!waiting.Wait(reply));
+    BOOST_CHECK(coalescer.Join("1/0/table/a").IsComputing());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,145 @@
+#include "server/request_parser.hpp"
+#include "server/http/request.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <tuple>
+
+BOOST_AUTO_TEST_SUITE(request_parser)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+struct Result
+{
+    RequestParser::RequestStatus status;
+    http::compression_type compression;
+    // input that is left after the request
+    std::string rest;
+};
+
+// Feeds the input in pieces of the given size, like reads from a socket
+Result parse(RequestParser &parser,
+             http::request &request,
+             std::string input,
+             const std::size_t piece_size = std::string::npos)
+{
+    char *begin = &input[0];
+    char *const end = begin + input.size();
+    Result result{RequestParser::RequestStatus::indeterminate, http::no_compression, ""};
+    while (begin != end && result.status == RequestParser::RequestStatus::indeterminate)
+    {
+        char *const piece_end = begin + std::min<std::size_t>(piece_size, end - begin);
+        char *parsed_end;
+        std::tie(result.status, result.compression, parsed_end) =
+            parser.parse(request, begin, piece_end);
+        if (result.status != RequestParser::RequestStatus::indeterminate)
+        {
+            BOOST_CHECK(parsed_end <= piece_end);
+            result.rest.assign(parsed_end, end);
+        }
+        begin = piece_end;
+    }
+    return result;
+}
+}
+
+BOOST_AUTO_TEST_CASE(get_request)
+{
+    RequestParser parser;
+    http::request request;
+    const auto result = parse(parser,
+                              request,
+                              "GET /route/v1/driving/1,2;3,4 HTTP/1.1\r\n"
+                              "Accept-Encoding: gzip, deflate\r\n"
+                              "User-Agent: test\r\n\r\n"
+                              "GET /next");
+    BOOST_CHECK(result.status == RequestParser::RequestStatus::valid);
+    BOOST_CHECK_EQUAL(result.compression, http::gzip_rfc1952);
+    BOOST_CHECK_EQUAL(result.rest, "GET /next");
+    BOOST_CHECK_EQUAL(request.uri, "/route/v1/driving/1,2;3,4");
+    BOOST_CHECK_EQUAL(request.agent, "test");
+    BOOST_CHECK(request.body.empty());
+    BOOST_CHECK(request.keep_alive);
+    BOOST_CHECK(request.chunked_encoding);
+}
+
+BOOST_AUTO_TEST_CASE(http_1_0_request)
+{
+    RequestParser parser;
+    http::request request;
+    const auto result = parse(parser, request, "GET /table/v1/driving/1,2;3,4 HTTP/1.0\r\n\r\n");
+    BOOST_CHECK(result.status == RequestParser::RequestStatus::valid);
+    BOOST_CHECK(!request.keep_alive);
+    // the body can't be sent in chunks
+    BOOST_CHECK(!request.chunked_encoding);
+}
+
+BOOST_AUTO_TEST_CASE(post_request_in_pieces)
+{
+    const std::string body = "1,2;3,4?overview=false";
+    const std::string input = "POST /route/v1/driving HTTP/1.1\r\nContent-Length: " +
+                              std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" +
+                              body + "GET /next";
+
+    for (const std::size_t piece_size : {1, 3, 7, 1000})
+    {
+        RequestParser parser;
+        http::request request;
+        const auto result = parse(parser, request, input, piece_size);
+        BOOST_CHECK(result.status == RequestParser::RequestStatus::valid);
+        BOOST_CHECK_EQUAL(request.uri, "/route/v1/driving");
+        BOOST_CHECK_EQUAL(request.body, body);
+        BOOST_CHECK(!request.keep_alive);
+        BOOST_CHECK_EQUAL(result.rest, "GET /next");
+        BOOST_CHECK(!parser.ContinueExpected());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(expect_continue)
+{
+    RequestParser parser;
+    http::request request;
+    const auto result = parse(parser,
+                              request,
+                              "POST /table/v1/driving HTTP/1.1\r\n"
+                              "Content-Length: 3\r\n"
+                              "Expect: 100-continue\r\n\r\n");
+    BOOST_CHECK(result.status == RequestParser::RequestStatus::indeterminate);
+    BOOST_CHECK(parser.ContinueExpected());
+    BOOST_CHECK(!parser.ContinueExpected());
+
+    BOOST_CHECK(parse(parser, request, "1,2").status == RequestParser::RequestStatus::valid);
+    BOOST_CHECK_EQUAL(request.body, "1,2");
+}
+
+BOOST_AUTO_TEST_CASE(empty_uri)
+{
+    for (const std::size_t piece_size : {1, 1000})
+    {
+        RequestParser parser;
+        http::request request;
+        const auto result = parse(parser, request, "GET  HTTP/1.1\r\n\r\n", piece_size);
+        BOOST_CHECK(result.status == RequestParser::RequestStatus::invalid);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(invalid_content_length)
+{
+    for (const std::string length : {"", "abc", "-1", "12345678901", "999999999"})
+    {
+        RequestParser parser;
+        http::request request;
+        const auto result = parse(parser,
+                                  request,
+                                  "POST /route/v1/driving HTTP/1.1\r\nContent-Length: " + length +
+                                      "\r\n\r\n");
+        BOOST_CHECK(result.status == RequestParser::RequestStatus::invalid);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
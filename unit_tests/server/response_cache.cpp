@@ -0,0 +1,122 @@
+#include "server/response_cache.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(response_cache)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+http::reply makeReply(const std::string &content)
+{
+    http::reply reply;
+    reply.content.assign(content.begin(), content.end());
+    reply.headers.emplace_back("Content-Type", "application/json; charset=UTF-8");
+    return reply;
+}
+
+std::string getContent(const http::reply &reply)
+{
+    return std::string(reply.content.begin(), reply.content.end());
+}
+}
+
+BOOST_AUTO_TEST_CASE(normalized_keys)
+{
+    BOOST_CHECK_EQUAL(ResponseCache::MakeKey("/route/v1/driving/1,2;3,4"),
+                      "/route/v1/driving/1,2;3,4");
+    BOOST_CHECK_EQUAL(ResponseCache::MakeKey("/route/v1/driving/1,2;3,4?steps=true&b=1&a=2"),
+                      "/route/v1/driving/1,2;3,4?a=2&b=1&steps=true");
+    // the last of repeated options wins, so they keep their order
+    BOOST_CHECK_EQUAL(ResponseCache::MakeKey("/route/v1/driving/1,2?steps=true&a=1&steps=false"),
+                      "/route/v1/driving/1,2?a=1&steps=true&steps=false");
+    // polylines may contain question marks
+    BOOST_CHECK_EQUAL(ResponseCache::MakeKey("/route/v1/driving/polyline(_ibE?_seK)?b=1&a=1"),
+                      "/route/v1/driving/polyline(_ibE?_seK)?a=1&b=1");
+    BOOST_CHECK_EQUAL(ResponseCache::MakeKey("/table/v1/driving/1,2;3,4?"),
+                      "/table/v1/driving/1,2;3,4?");
+
+    BOOST_CHECK(ResponseCache::IsCacheable("route"));
+    BOOST_CHECK(ResponseCache::IsCacheable("table"));
+    BOOST_CHECK(!ResponseCache::IsCacheable("tile"));
+}
+
+BOOST_AUTO_TEST_CASE(lookup_and_expiry)
+{
+    ResponseCache cache(1000, std::chrono::seconds(60));
+    const auto start = ResponseCache::Clock::now();
+
+    http::reply reply;
+    BOOST_CHECK(!cache.Get(1, 0, 0, "/route/a", reply, start));
+    cache.Add(1, 0, 0, "/route/a", makeReply("a"), start);
+    BOOST_CHECK(cache.Get(1, 0, 0, "/route/a", reply, start + std::chrono::seconds(30)));
+    BOOST_CHECK_EQUAL(getContent(reply), "a");
+    BOOST_CHECK_EQUAL(reply.headers.back().value, "application/json; charset=UTF-8");
+
+    BOOST_CHECK(!cache.Get(1, 0, 0, "/route/a", reply, start + std::chrono::seconds(61)));
+
+    const auto statistics = cache.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.number_of_replies, 0);
+    BOOST_CHECK_EQUAL(statistics.size, 0);
+    BOOST_CHECK_EQUAL(statistics.hits, 1);
+    BOOST_CHECK_EQUAL(statistics.misses, 2);
+}
+
+BOOST_AUTO_TEST_CASE(new_data_drops_replies)
+{
+    ResponseCache cache(1000, std::chrono::seconds(60));
+
+    http::reply reply;
+    cache.Add(1, 0, 0, "/route/a", makeReply("a"));
+    BOOST_CHECK(!cache.Get(2, 0, 0, "/route/a", reply));
+    cache.Add(2, 0, 0, "/route/a", makeReply("b"));
+    BOOST_CHECK(!cache.Get(2, 1, 0, "/route/a", reply));
+    BOOST_CHECK_EQUAL(cache.GetStatistics().number_of_replies, 0);
+}
+
+BOOST_AUTO_TEST_CASE(new_traffic_overlay_drops_replies)
+{
+    ResponseCache cache(1000, std::chrono::seconds(60));
+
+    http::reply reply;
+    cache.Add(1, 0, 0, "/route/a", makeReply("a"));
+    BOOST_CHECK(cache.Get(1, 0, 0, "/route/a", reply));
+    BOOST_CHECK(!cache.Get(1, 0, 7, "/route/a", reply));
+    cache.Add(1, 0, 7, "/route/a", makeReply("b"));
+    BOOST_CHECK(cache.Get(1, 0, 7, "/route/a", reply));
+    BOOST_CHECK_EQUAL(getContent(reply), "b");
+}
+
+BOOST_AUTO_TEST_CASE(least_recently_used_evicted)
+{
+    // room for two replies of 8 byte keys and 2 byte contents
+    ResponseCache cache(25, std::chrono::seconds(60));
+
+    http::reply reply;
+    cache.Add(1, 0, 0, "/route/a", makeReply("aa"));
+    cache.Add(1, 0, 0, "/route/b", makeReply("bb"));
+    BOOST_CHECK(cache.Get(1, 0, 0, "/route/a", reply));
+    cache.Add(1, 0, 0, "/route/c", makeReply("cc"));
+
+    BOOST_CHECK(cache.Get(1, 0, 0, "/route/a", reply));
+    BOOST_CHECK(!cache.Get(1, 0, 0, "/route/b", reply));
+    BOOST_CHECK(cache.Get(1, 0, 0, "/route/c", reply));
+    BOOST_CHECK_EQUAL(getContent(reply), "cc");
+
+    // too large to be cached at all
+    cache.Add(1, 0, 0, "/route/d", makeReply(std::string(100, 'd')));
+    BOOST_CHECK(!cache.Get(1, 0, 0, "/route/d", reply));
+
+    const auto statistics = cache.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.number_of_replies, 2);
+    BOOST_CHECK_EQUAL(statistics.size, 20);
+    BOOST_CHECK_EQUAL(statistics.evictions, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,134 @@
+#include "server/tile_store.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(tile_store)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+std::string decompress(const TileStore::Tile &tile)
+{
+    std::vector<char> content;
+    TileStore::Decompress(*tile, content);
+    return std::string(content.begin(), content.end());
+}
+
+// Removes the directory of the test once it is done
+struct TemporaryDirectory
+{
+    TemporaryDirectory()
+        : path(boost::filesystem::temp_directory_path() /
+               boost::filesystem::unique_path("osrm-tiles-%%%%-%%%%"))
+    {
+    }
+    ~TemporaryDirectory() { boost::filesystem::remove_all(path); }
+
+    boost::filesystem::path path;
+};
+}
+
+BOOST_AUTO_TEST_CASE(compression_round_trip)
+{
+    const std::string tile(10000, 'a');
+    std::vector<char> compressed;
+    TileStore::Compress(tile, compressed);
+    BOOST_CHECK_LT(compressed.size(), tile.size());
+    // the magic bytes of gzip
+    BOOST_REQUIRE_GT(compressed.size(), 2);
+    BOOST_CHECK_EQUAL(static_cast<unsigned char>(compressed[0]), 0x1f);
+    BOOST_CHECK_EQUAL(static_cast<unsigned char>(compressed[1]), 0x8b);
+
+    std::vector<char> decompressed;
+    TileStore::Decompress(compressed, decompressed);
+    BOOST_CHECK_EQUAL(std::string(decompressed.begin(), decompressed.end()), tile);
+
+    TileStore::Compress("", compressed);
+    TileStore::Decompress(compressed, decompressed);
+    BOOST_CHECK(decompressed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(hit_and_miss)
+{
+    TileStore store(1024 * 1024, "");
+    BOOST_CHECK(!store.Get(1, 0, 14, 8800, 5373));
+
+    const auto added = store.Add(1, 0, 14, 8800, 5373, "tile");
+    BOOST_CHECK_EQUAL(decompress(added), "tile");
+
+    const auto tile = store.Get(1, 0, 14, 8800, 5373);
+    BOOST_REQUIRE(tile);
+    BOOST_CHECK_EQUAL(decompress(tile), "tile");
+    BOOST_CHECK(!store.Get(1, 0, 14, 5373, 8800));
+    BOOST_CHECK(!store.Get(1, 0, 15, 8800, 5373));
+
+    const auto statistics = store.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.number_of_tiles, 1);
+    BOOST_CHECK_EQUAL(statistics.size, added->size());
+    BOOST_CHECK_EQUAL(statistics.hits, 1);
+    BOOST_CHECK_EQUAL(statistics.disk_hits, 0);
+    BOOST_CHECK_EQUAL(statistics.misses, 3);
+}
+
+BOOST_AUTO_TEST_CASE(new_dataset_invalidates)
+{
+    TileStore store(1024 * 1024, "");
+    store.Add(1, 0, 14, 1, 2, "tile");
+    BOOST_CHECK(store.Get(1, 0, 14, 1, 2));
+    BOOST_CHECK(!store.Get(1, 1, 14, 1, 2));
+    BOOST_CHECK(!store.Get(1, 0, 14, 1, 2));
+
+    store.Add(1, 0, 14, 1, 2, "tile");
+    BOOST_CHECK(!store.Get(2, 0, 14, 1, 2));
+}
+
+BOOST_AUTO_TEST_CASE(bounded_size)
+{
+    std::vector<char> compressed;
+    TileStore::Compress("tile", compressed);
+    TileStore store(3 * compressed.size(), "");
+
+    for (unsigned y = 0; y < 10; ++y)
+    {
+        store.Add(1, 0, 14, 0, y, "tile");
+    }
+    const auto statistics = store.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.number_of_tiles, 3);
+    BOOST_CHECK_LE(statistics.size, statistics.capacity);
+    // the tiles that were added last are kept
+    BOOST_CHECK(store.Get(1, 0, 14, 0, 9));
+    BOOST_CHECK(!store.Get(1, 0, 14, 0, 0));
+}
+
+BOOST_AUTO_TEST_CASE(tiles_on_disk)
+{
+    TemporaryDirectory directory;
+    {
+        TileStore store(0, directory.path);
+        store.Add(1, 2, 14, 8800, 5373, "tile");
+        BOOST_CHECK(boost::filesystem::is_regular_file(directory.path / "1-2" / "14" / "8800" /
+                                                       "5373.mvt.gz"));
+    }
+
+    // a restart finds the tile again, but only for the same dataset
+    TileStore store(1024 * 1024, directory.path);
+    const auto tile = store.Get(1, 2, 14, 8800, 5373);
+    BOOST_REQUIRE(tile);
+    BOOST_CHECK_EQUAL(decompress(tile), "tile");
+    BOOST_CHECK(store.Get(1, 2, 14, 8800, 5373));
+    BOOST_CHECK(!store.Get(1, 3, 14, 8800, 5373));
+
+    const auto statistics = store.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.hits, 1);
+    BOOST_CHECK_EQUAL(statistics.disk_hits, 1);
+    BOOST_CHECK_EQUAL(statistics.misses, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,124 @@
+#include "storage/compressed_file.hpp"
+#include "util/exception.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <ctime>
+#include <iterator>
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(compressed_files)
+
+using namespace osrm;
+using namespace osrm::storage;
+
+namespace
+{
+// Removes the files of a test when it is done
+struct TemporaryDirectory
+{
+    TemporaryDirectory()
+        : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+    {
+        boost::filesystem::create_directories(path);
+    }
+    ~TemporaryDirectory() { boost::filesystem::remove_all(path); }
+
+    boost::filesystem::path Write(const std::string &name, const std::string &contents) const
+    {
+        const auto file_path = path / name;
+        boost::filesystem::ofstream stream(file_path, std::ios::binary);
+        stream.write(contents.data(), contents.size());
+        return file_path;
+    }
+
+    boost::filesystem::path path;
+};
+
+std::string read(const boost::filesystem::path &path)
+{
+    boost::filesystem::ifstream stream(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+}
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+    TemporaryDirectory directory;
+    std::string contents;
+    for (int index = 0; index < 10000; ++index)
+    {
+        contents += std::to_string(index * index);
+    }
+    const auto path = directory.Write("data.osrm.hsgr", contents);
+    const auto compressed_path = compressed_file::getCompressedPath(path);
+    BOOST_CHECK_EQUAL(compressed_path.filename().string(), "data.osrm.hsgr.zb");
+
+    // the last of the blocks is shorter than the others
+    compressed_file::compress(path, compressed_path, 1000);
+    BOOST_CHECK_LT(boost::filesystem::file_size(compressed_path), contents.size());
+
+    const auto decompressed_path = directory.path / "decompressed";
+    compressed_file::decompress(compressed_path, decompressed_path);
+    BOOST_CHECK(read(decompressed_path) == contents);
+    BOOST_CHECK(!boost::filesystem::exists(decompressed_path.string() + ".tmp"));
+
+    const auto empty_path = directory.Write("empty", "");
+    compressed_file::compress(empty_path, compressed_file::getCompressedPath(empty_path));
+    compressed_file::decompress(compressed_file::getCompressedPath(empty_path), decompressed_path);
+    BOOST_CHECK_EQUAL(boost::filesystem::file_size(decompressed_path), 0);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_files)
+{
+    TemporaryDirectory directory;
+    const auto path = directory.Write("data.osrm.nodes", std::string(5000, 'x'));
+    const auto compressed_path = compressed_file::getCompressedPath(path);
+    const auto decompressed_path = directory.path / "decompressed";
+
+    BOOST_CHECK_THROW(compressed_file::decompress(path, decompressed_path), util::exception);
+    BOOST_CHECK_THROW(compressed_file::decompress(directory.path / "missing", decompressed_path),
+                      util::exception);
+
+    compressed_file::compress(path, compressed_path, 1024);
+    auto contents = read(compressed_path);
+    contents[contents.size() - 3] ^= 0x55;
+    directory.Write(compressed_path.filename().string(), contents);
+    BOOST_CHECK_THROW(compressed_file::decompress(compressed_path, decompressed_path),
+                      util::exception);
+
+    directory.Write(compressed_path.filename().string(), contents.substr(0, contents.size() - 1));
+    BOOST_CHECK_THROW(compressed_file::decompress(compressed_path, decompressed_path),
+                      util::exception);
+}
+
+BOOST_AUTO_TEST_CASE(decompress_updated)
+{
+    TemporaryDirectory directory;
+    const auto path = directory.Write("data.osrm.edges", "new edges");
+    const auto compressed_path = compressed_file::getCompressedPath(path);
+    compressed_file::compress(path, compressed_path);
+    const auto unchanged_path = directory.Write("data.osrm.geometry", "geometry");
+    const auto without_copy_path = directory.Write("data.osrm.nodes", "nodes");
+    compressed_file::compress(unchanged_path, compressed_file::getCompressedPath(unchanged_path));
+
+    // copies have the time of their file where they were made
+    BOOST_CHECK_EQUAL(compressed_file::decompressUpdated({path, unchanged_path, without_copy_path}),
+                      0);
+
+    // the file of the last dataset is older than the copy of the new one
+    directory.Write("data.osrm.edges", "old edges");
+    boost::filesystem::last_write_time(path, std::time(nullptr) - 3600);
+    BOOST_CHECK_EQUAL(compressed_file::decompressUpdated({path, unchanged_path, without_copy_path}),
+                      1);
+    BOOST_CHECK_EQUAL(read(path), "new edges");
+
+    boost::filesystem::remove(unchanged_path);
+    BOOST_CHECK_EQUAL(compressed_file::decompressUpdated({path, unchanged_path, without_copy_path}),
+                      1);
+    BOOST_CHECK_EQUAL(read(unchanged_path), "geometry");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,115 @@
+#include "storage/container_file.hpp"
+#include "util/exception.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(container_file)
+
+using namespace osrm;
+using namespace osrm::storage;
+
+namespace
+{
+// Removes the files of a test when it is done
+struct TemporaryDirectory
+{
+    TemporaryDirectory()
+        : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+    {
+        boost::filesystem::create_directories(path);
+    }
+    ~TemporaryDirectory() { boost::filesystem::remove_all(path); }
+
+    boost::filesystem::path Write(const std::string &name, const std::string &contents) const
+    {
+        const auto file_path = path / name;
+        boost::filesystem::ofstream stream(file_path, std::ios::binary);
+        stream.write(contents.data(), contents.size());
+        return file_path;
+    }
+
+    boost::filesystem::path path;
+};
+
+std::string getSection(const ContainerFile &container, const std::string &name)
+{
+    const auto section = container.GetSection(name);
+    return std::string(section.data, section.size);
+}
+}
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+    TemporaryDirectory directory;
+    const std::string names(10000, 'n');
+    const std::vector<boost::filesystem::path> files = {
+        directory.Write("test.osrm.hsgr", "graph"),
+        directory.Write("test.osrm.names", names),
+        directory.Write("test.osrm.timestamp", "")};
+
+    const auto container_path = directory.path / "test.osrm.container";
+    ContainerFile::Write(container_path, files);
+
+    ContainerFile container(container_path);
+    BOOST_CHECK(container.ValidateChecksums());
+    BOOST_CHECK(container.HasSection(".hsgr"));
+    BOOST_CHECK(container.HasSection(".timestamp"));
+    BOOST_CHECK(!container.HasSection(".nodes"));
+    BOOST_CHECK_EQUAL(getSection(container, ".hsgr"), "graph");
+    BOOST_CHECK_EQUAL(getSection(container, ".names"), names);
+    BOOST_CHECK_EQUAL(getSection(container, ".timestamp"), "");
+    BOOST_CHECK_THROW(container.GetSection(".nodes"), util::exception);
+}
+
+BOOST_AUTO_TEST_CASE(aligned_sections)
+{
+    TemporaryDirectory directory;
+    const std::vector<boost::filesystem::path> files = {
+        directory.Write("test.osrm.geometry", std::string(5000, 'g')),
+        directory.Write("test.osrm.edges", "e")};
+
+    const auto container_path = directory.path / "test.osrm.container";
+    ContainerFile::Write(container_path, files);
+
+    ContainerFile container(container_path);
+    const char *begin = container.GetSection(".geometry").data;
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(begin) % ContainerFile::SECTION_ALIGNMENT,
+                      0);
+    BOOST_CHECK_EQUAL(container.GetSection(".edges").data - begin,
+                      2 * ContainerFile::SECTION_ALIGNMENT);
+}
+
+BOOST_AUTO_TEST_CASE(corrupted_section)
+{
+    TemporaryDirectory directory;
+    const auto container_path = directory.path / "test.osrm.container";
+    ContainerFile::Write(container_path, {directory.Write("test.osrm.hsgr", "graph")});
+
+    {
+        boost::filesystem::fstream stream(container_path,
+                                          std::ios::binary | std::ios::in | std::ios::out);
+        stream.seekp(ContainerFile::SECTION_ALIGNMENT);
+        stream.put('G');
+    }
+
+    ContainerFile container(container_path);
+    BOOST_CHECK_EQUAL(getSection(container, ".hsgr"), "Graph");
+    BOOST_CHECK(!container.ValidateChecksums());
+}
+
+BOOST_AUTO_TEST_CASE(not_a_container)
+{
+    TemporaryDirectory directory;
+    const auto path = directory.Write("test.osrm.container", std::string(4096, 'x'));
+    BOOST_CHECK_THROW(ContainerFile{path}, util::exception);
+    BOOST_CHECK_THROW(ContainerFile{directory.path / "missing.container"}, util::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
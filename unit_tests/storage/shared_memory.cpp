@@ -0,0 +1,128 @@
+#include "storage/shared_barriers.hpp"
+#include "storage/shared_dataset.hpp"
+#include "storage/shared_datatype.hpp"
+#include "storage/shared_memory.hpp"
+
+#include "util/exception.hpp"
+#include "util/make_unique.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/sync/sharable_lock.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(shared_memory)
+
+using namespace osrm;
+using namespace osrm::storage;
+
+#ifndef _WIN32
+namespace
+{
+// Puts the regions into files of a directory of its own while a test runs
+struct SharedMemoryDirectory
+{
+    SharedMemoryDirectory()
+        : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+    {
+        boost::filesystem::create_directories(path);
+        setenv("OSRM_SHARED_MEMORY_DIR", path.string().c_str(), 1);
+    }
+    ~SharedMemoryDirectory()
+    {
+        unsetenv("OSRM_SHARED_MEMORY_DIR");
+        boost::filesystem::remove_all(path);
+    }
+
+    boost::filesystem::path path;
+};
+}
+
+BOOST_AUTO_TEST_CASE(regions_in_files)
+{
+    const SharedMemoryDirectory directory;
+    BOOST_CHECK(!SharedMemory::RegionExists(DATA_1));
+
+    std::unique_ptr<SharedMemory> writer(makeSharedMemory(DATA_1, 100, true, true));
+    std::strcpy(static_cast<char *>(writer->Ptr()), "dataset");
+    BOOST_CHECK(SharedMemory::RegionExists(DATA_1));
+    BOOST_CHECK(!SharedMemory::RegionExists(DATA_2));
+    BOOST_CHECK(boost::filesystem::exists(directory.path / "osrm-region-2"));
+
+    // another mapping of the file sees the data, also after the file is removed
+    std::unique_ptr<SharedMemory> reader(makeSharedMemory(DATA_1));
+    BOOST_CHECK_EQUAL(static_cast<const char *>(reader->Ptr()), "dataset");
+    BOOST_CHECK(SharedMemory::Remove(DATA_1));
+    BOOST_CHECK(!SharedMemory::RegionExists(DATA_1));
+    BOOST_CHECK_EQUAL(static_cast<const char *>(reader->Ptr()), "dataset");
+}
+
+BOOST_AUTO_TEST_CASE(barriers_in_a_file)
+{
+    const SharedMemoryDirectory directory;
+    SharedBarriers barriers;
+    SharedBarriers other_barriers;
+    BOOST_CHECK(boost::filesystem::exists(directory.path / "osrm-barriers"));
+
+    {
+        boost::interprocess::sharable_lock<SharedBarriers::SharableMutex> query_lock(
+            barriers.query_mutex);
+        BOOST_CHECK(other_barriers.query_mutex.try_lock_sharable());
+        other_barriers.query_mutex.unlock_sharable();
+        BOOST_CHECK(!other_barriers.query_mutex.try_lock());
+    }
+    BOOST_CHECK(other_barriers.query_mutex.try_lock());
+    other_barriers.query_mutex.unlock();
+
+    boost::interprocess::scoped_lock<SharedBarriers::Mutex> pending_lock(
+        barriers.pending_update_mutex);
+    BOOST_CHECK(!other_barriers.pending_update_mutex.try_lock());
+}
+
+BOOST_AUTO_TEST_CASE(outdated_dataset_removed_by_last_reference)
+{
+    const SharedMemoryDirectory directory;
+    BOOST_CHECK_THROW(SharedDatasetReference(), util::exception);
+
+    std::unique_ptr<SharedMemory> timestamp_memory(
+        makeSharedMemory(CURRENT_REGIONS, sizeof(SharedDataTimestamp), true, false));
+    auto &current = *static_cast<SharedDataTimestamp *>(timestamp_memory->Ptr());
+    // like osrm-datastore, keeps the regions it created from being removed with it
+    std::vector<std::unique_ptr<SharedMemory>> created_regions;
+    const auto publish = [&](const unsigned slot) {
+        created_regions.emplace_back(makeSharedMemory(getLayoutRegion(slot), 10, true, true));
+        created_regions.emplace_back(makeSharedMemory(getDataRegion(slot), 10, true, true));
+        current.layout = getLayoutRegion(slot);
+        current.data = getDataRegion(slot);
+        current.generations[slot].timestamp = ++current.timestamp;
+    };
+
+    publish(0);
+    auto first = util::make_unique<SharedDatasetReference>();
+    auto second = util::make_unique<SharedDatasetReference>();
+    BOOST_CHECK_EQUAL(first->Timestamp(), 1);
+    BOOST_CHECK_EQUAL(current.generations[0].references, 2);
+    BOOST_CHECK(first->IsCurrent());
+
+    publish(1);
+    BOOST_CHECK(!first->IsCurrent());
+    first.reset();
+    BOOST_CHECK(SharedMemory::RegionExists(DATA_1));
+    second.reset();
+    BOOST_CHECK(!SharedMemory::RegionExists(LAYOUT_1));
+    BOOST_CHECK(!SharedMemory::RegionExists(DATA_1));
+    BOOST_CHECK_EQUAL(current.generations[0].timestamp, 0);
+
+    // the current dataset stays after its last reference is gone
+    SharedDatasetReference{};
+    BOOST_CHECK(SharedMemory::RegionExists(DATA_2));
+    BOOST_CHECK_EQUAL(current.generations[1].references, 0);
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,77 @@
+#include "util/async_io.hpp"
+#include "util/exception.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(async_io)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+std::vector<AsyncIO::Backend> getBackends()
+{
+    std::vector<AsyncIO::Backend> backends{AsyncIO::Backend::ThreadPool};
+    if (AsyncIO::IsAvailable(AsyncIO::Backend::IOUring))
+    {
+        backends.push_back(AsyncIO::Backend::IOUring);
+    }
+    return backends;
+}
+}
+
+BOOST_AUTO_TEST_CASE(write_and_read)
+{
+    const auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    // several blocks and a partial one
+    std::vector<std::uint32_t> data(AsyncIO::BLOCK_SIZE + 12345);
+    std::iota(data.begin(), data.end(), 0u);
+    const std::uint32_t header = 42;
+
+    for (const auto backend : getBackends())
+    {
+        AsyncIO io(backend, 4);
+        BOOST_CHECK(io.GetBackend() == backend);
+        io.Create(path);
+        io.Write(path, sizeof(header), data.data(), data.size() * sizeof(std::uint32_t));
+        io.Write(path, 0, &header, sizeof(header));
+        io.Wait();
+        BOOST_CHECK_EQUAL(boost::filesystem::file_size(path),
+                          sizeof(header) + data.size() * sizeof(std::uint32_t));
+
+        std::uint32_t read_header = 0;
+        std::vector<std::uint32_t> read_data(data.size());
+        io.Read(path, 0, &read_header, sizeof(read_header));
+        io.Read(path, sizeof(header), read_data.data(), read_data.size() * sizeof(std::uint32_t));
+        io.Wait();
+        BOOST_CHECK_EQUAL(read_header, header);
+        BOOST_CHECK(read_data == data);
+
+        // past the end of the file
+        io.Read(path, sizeof(header), read_data.data(), (data.size() + 1) * sizeof(std::uint32_t));
+        BOOST_CHECK_THROW(io.Wait(), exception);
+
+        // the error doesn't stay with the next requests
+        io.Read(path, 0, &read_header, sizeof(read_header));
+        io.Wait();
+    }
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(missing_file)
+{
+    AsyncIO io;
+    std::uint32_t value;
+    BOOST_CHECK_THROW(io.Read(boost::filesystem::unique_path(), 0, &value, sizeof(value)),
+                      exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
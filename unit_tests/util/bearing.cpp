@@ -47,4 +47,41 @@ BOOST_AUTO_TEST_CASE(bearing_range_test)
     BOOST_CHECK_EQUAL(true, bearing::CheckInBounds(1, 1, 0));
 }
 
+BOOST_AUTO_TEST_CASE(quantized_bearing_test)
+{
+    BOOST_CHECK_EQUAL(bearing::quantize(0.), 0);
+    BOOST_CHECK_EQUAL(bearing::quantize(90.), 64);
+    BOOST_CHECK_EQUAL(bearing::quantize(359.9), 0);
+    BOOST_CHECK_EQUAL(bearing::quantize(360.), 0);
+    BOOST_CHECK_EQUAL(bearing::reverseQuantized(64), 192);
+    BOOST_CHECK_EQUAL(bearing::reverseQuantized(192), 64);
+
+    BOOST_CHECK_EQUAL(false, bearing::QuantizedRange(1, -1).Contains(bearing::quantize(1.)));
+    BOOST_CHECK_EQUAL(true, bearing::QuantizedRange(1, 0).Contains(bearing::quantize(1.)));
+    BOOST_CHECK_EQUAL(true, bearing::QuantizedRange(5, 10).Contains(bearing::quantize(359.)));
+    BOOST_CHECK_EQUAL(false, bearing::QuantizedRange(5, 10).Contains(bearing::quantize(352.)));
+
+    // a quantized range accepts every bearing of the range and only bearings up to a step
+    // outside of it
+    for (const int filter_bearing : {-721, -5, 0, 1, 45, 100, 270, 355, 359, 719})
+    {
+        for (const int range : {0, 1, 10, 45, 90, 179, 180})
+        {
+            const bearing::QuantizedRange quantized_range(filter_bearing, range);
+            for (int degrees = 0; degrees < 360; ++degrees)
+            {
+                const auto contained = quantized_range.Contains(bearing::quantize(degrees));
+                if (bearing::CheckInBounds(degrees, filter_bearing, range))
+                {
+                    BOOST_CHECK(contained);
+                }
+                if (contained)
+                {
+                    BOOST_CHECK(bearing::CheckInBounds(degrees, filter_bearing, range + 2));
+                }
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
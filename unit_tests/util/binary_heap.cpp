@@ -1,4 +1,6 @@
 #include "util/binary_heap.hpp"
+#include "util/d_ary_heap.hpp"
+#include "util/radix_heap.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/mpl/list.hpp>
@@ -6,6 +8,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <random>
 #include <vector>
@@ -24,6 +27,7 @@ typedef NodeID TestNodeID;
 typedef int TestKey;
 typedef int TestWeight;
 typedef boost::mpl::list<ArrayStorage<TestNodeID, TestKey>,
+                         TimestampedArrayStorage<TestNodeID, TestKey>,
                          MapStorage<TestNodeID, TestKey>,
                          UnorderedMapStorage<TestNodeID, TestKey>>
     storage_types;
@@ -123,6 +127,27 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(delete_all_test, T, storage_types, RandomDataFi
     BOOST_CHECK(heap.Empty());
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(clear_test, T, storage_types, RandomDataFixture<NUM_NODES>)
+{
+    BinaryHeap<TestNodeID, TestKey, TestWeight, TestData, T> heap(NUM_NODES);
+
+    for (unsigned round = 0; round < 3; ++round)
+    {
+        for (unsigned idx : order)
+        {
+            heap.Insert(ids[idx], weights[idx], data[idx]);
+        }
+
+        heap.Clear();
+
+        BOOST_CHECK(heap.Empty());
+        for (auto id : ids)
+        {
+            BOOST_CHECK(!heap.WasInserted(id));
+        }
+    }
+}
+
 BOOST_FIXTURE_TEST_CASE_TEMPLATE(decrease_key_test, T, storage_types, RandomDataFixture<10>)
 {
     BinaryHeap<TestNodeID, TestKey, TestWeight, TestData, T> heap(10);
@@ -157,4 +182,108 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(decrease_key_test, T, storage_types, RandomData
     }
 }
 
+typedef boost::mpl::list<DAryHeap<TestNodeID, TestKey, TestWeight, TestData>,
+                         DAryHeap<TestNodeID,
+                                  TestKey,
+                                  TestWeight,
+                                  TestData,
+                                  ArrayStorage<TestNodeID, TestKey>,
+                                  8>,
+                         RadixHeap<TestNodeID, TestKey, TestWeight, TestData>>
+    heap_types;
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(variant_delete_min_test,
+                                 T,
+                                 heap_types,
+                                 RandomDataFixture<NUM_NODES>)
+{
+    T heap(NUM_NODES);
+
+    for (unsigned idx : order)
+    {
+        BOOST_CHECK(!heap.WasInserted(ids[idx]));
+        heap.Insert(ids[idx], weights[idx], data[idx]);
+        BOOST_CHECK(heap.WasInserted(ids[idx]));
+    }
+    BOOST_CHECK_EQUAL(heap.Size(), NUM_NODES);
+
+    for (auto id : ids)
+    {
+        BOOST_CHECK(!heap.WasRemoved(id));
+        BOOST_CHECK_EQUAL(heap.GetData(id).value, data[id].value);
+        BOOST_CHECK_EQUAL(heap.Min(), id);
+        BOOST_CHECK_EQUAL(heap.MinKey(), weights[id]);
+        BOOST_CHECK_EQUAL(id, heap.DeleteMin());
+        BOOST_CHECK(heap.WasRemoved(id));
+    }
+    BOOST_CHECK(heap.Empty());
+
+    heap.Clear();
+    for (auto id : ids)
+    {
+        BOOST_CHECK(!heap.WasInserted(id));
+    }
+}
+
+// Runs the same monotone Dijkstra-like sequence of operations on a heap variant and on
+// BinaryHeap and checks that both settle nodes with the same weights.
+BOOST_AUTO_TEST_CASE_TEMPLATE(variant_dijkstra_test, T, heap_types)
+{
+    constexpr unsigned NUM_TEST_NODES = 1000;
+    BinaryHeap<TestNodeID, TestKey, TestWeight, TestData> reference(NUM_TEST_NODES);
+    T heap(NUM_TEST_NODES);
+
+    std::mt19937 g(15);
+    std::uniform_int_distribution<TestNodeID> node_dist(0, NUM_TEST_NODES - 1);
+    std::uniform_int_distribution<TestWeight> weight_dist(1, 100);
+
+    // negative offsets like the ones phantom nodes introduce
+    reference.Insert(0, -50, TestData{0});
+    heap.Insert(0, -50, TestData{0});
+    reference.Insert(1, 20, TestData{1});
+    heap.Insert(1, 20, TestData{1});
+
+    while (!reference.Empty())
+    {
+        BOOST_REQUIRE(!heap.Empty());
+        BOOST_CHECK_EQUAL(reference.MinKey(), heap.MinKey());
+        const auto reference_node = reference.DeleteMin();
+        const auto weight = reference.GetKey(reference_node);
+        const auto node = heap.DeleteMin();
+        BOOST_CHECK_EQUAL(weight, heap.GetKey(node));
+
+        // relax the same edges in both heaps, they only see the same node if there are ties
+        for (unsigned i = 0; i < 5; ++i)
+        {
+            const auto to = node_dist(g);
+            const auto to_weight = weight + weight_dist(g);
+            const auto relax_edge = [&](auto &h) {
+                if (!h.WasInserted(to))
+                {
+                    h.Insert(to, to_weight, TestData{to});
+                }
+                else if (!h.WasRemoved(to) && to_weight < h.GetKey(to))
+                {
+                    h.DecreaseKey(to, to_weight);
+                }
+            };
+            relax_edge(reference);
+            relax_edge(heap);
+        }
+    }
+    BOOST_CHECK(heap.Empty());
+}
+
+BOOST_AUTO_TEST_CASE(aligned_allocator_test)
+{
+    util::detail::AlignedAllocator<std::uint64_t, 64> allocator;
+    for (const std::size_t size : {1, 3, 8, 1000})
+    {
+        const auto pointer = allocator.allocate(size);
+        BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(pointer) % 64, 0);
+        std::fill(pointer, pointer + size, size);
+        allocator.deallocate(pointer, size);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,126 @@
+#include "util/chunked_vector.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(chunked_vector_test)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+// large enough to fill a few chunks with a few thousand elements
+struct Element
+{
+    Element() : value(0) {}
+    explicit Element(const std::uint32_t value) : value(value) {}
+
+    bool operator<(const Element &other) const { return value < other.value; }
+
+    std::uint32_t value;
+    char padding[4092];
+};
+
+using ElementVector = ChunkedVector<Element>;
+}
+
+BOOST_AUTO_TEST_CASE(chunk_size)
+{
+    BOOST_CHECK_EQUAL(ElementVector::ELEMENTS_PER_CHUNK, 8192);
+    BOOST_CHECK_EQUAL(ChunkedVector<std::uint64_t>::ELEMENTS_PER_CHUNK, 4 * 1024 * 1024);
+}
+
+BOOST_AUTO_TEST_CASE(append_and_access)
+{
+    ElementVector vector;
+    BOOST_CHECK(vector.empty());
+    BOOST_CHECK(vector.begin() == vector.end());
+
+    const std::uint32_t size = 2 * ElementVector::ELEMENTS_PER_CHUNK + 3;
+    for (std::uint32_t index = 0; index < size; ++index)
+    {
+        vector.emplace_back(index);
+    }
+    BOOST_CHECK_EQUAL(vector.size(), size);
+    BOOST_CHECK_EQUAL(vector.capacity(), 3 * ElementVector::ELEMENTS_PER_CHUNK);
+    BOOST_CHECK_EQUAL(vector.back().value, size - 1);
+    BOOST_CHECK_EQUAL(std::distance(vector.begin(), vector.end()), size);
+
+    std::uint32_t expected = 0;
+    for (const auto &element : static_cast<const ElementVector &>(vector))
+    {
+        BOOST_CHECK_EQUAL(element.value, expected);
+        ++expected;
+    }
+    BOOST_CHECK_EQUAL(vector[ElementVector::ELEMENTS_PER_CHUNK].value,
+                      ElementVector::ELEMENTS_PER_CHUNK);
+    BOOST_CHECK_EQUAL((vector.begin() + ElementVector::ELEMENTS_PER_CHUNK + 1)->value,
+                      ElementVector::ELEMENTS_PER_CHUNK + 1);
+
+    ElementVector moved(std::move(vector));
+    BOOST_CHECK(vector.empty());
+    BOOST_CHECK_EQUAL(moved.size(), size);
+
+    moved.clear();
+    BOOST_CHECK_EQUAL(moved.size(), 0);
+    BOOST_CHECK_EQUAL(moved.capacity(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(resize)
+{
+    ElementVector vector;
+    vector.emplace_back(42);
+    vector.resize(ElementVector::ELEMENTS_PER_CHUNK + 10);
+    BOOST_CHECK_EQUAL(vector[0].value, 42);
+    BOOST_CHECK(std::all_of(vector.begin() + 1, vector.end(), [](const Element &element) {
+        return element.value == 0;
+    }));
+
+    vector.resize(5);
+    BOOST_CHECK_EQUAL(vector.size(), 5);
+    BOOST_CHECK_EQUAL(vector.capacity(), ElementVector::ELEMENTS_PER_CHUNK);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_sort)
+{
+    std::mt19937 generator(7);
+    ElementVector vector;
+    for (std::uint32_t index = 0; index < 3 * ElementVector::ELEMENTS_PER_CHUNK; ++index)
+    {
+        vector.emplace_back(generator());
+    }
+    tbb::parallel_sort(vector.begin(), vector.end());
+    BOOST_CHECK(std::is_sorted(vector.begin(), vector.end()));
+}
+
+BOOST_AUTO_TEST_CASE(consume_chunks)
+{
+    ElementVector vector;
+    const std::uint32_t size = ElementVector::ELEMENTS_PER_CHUNK + 7;
+    for (std::uint32_t index = 0; index < size; ++index)
+    {
+        vector.emplace_back(index);
+    }
+
+    std::vector<std::size_t> chunk_sizes;
+    vector.ConsumeChunks(
+        [&](const std::size_t first_index, const Element *first, const Element *last) {
+            BOOST_CHECK_EQUAL(first->value, first_index);
+            BOOST_CHECK_EQUAL((last - 1)->value, first_index + (last - first) - 1);
+            chunk_sizes.push_back(last - first);
+        });
+    BOOST_CHECK_EQUAL(chunk_sizes.size(), 2);
+    BOOST_CHECK_EQUAL(chunk_sizes[0], ElementVector::ELEMENTS_PER_CHUNK);
+    BOOST_CHECK_EQUAL(chunk_sizes[1], 7);
+    BOOST_CHECK(vector.empty());
+    BOOST_CHECK_EQUAL(vector.capacity(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
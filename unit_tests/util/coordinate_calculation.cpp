@@ -6,6 +6,8 @@
 #include <osrm/coordinate.hpp>
 
 #include <cmath>
+#include <random>
+#include <vector>
 
 using namespace osrm;
 using namespace osrm::util;
@@ -311,4 +313,96 @@ BOOST_AUTO_TEST_CASE(circleCenter)
     BOOST_CHECK(!result);
 }
 
+namespace
+{
+// coordinates all over the world, with duplicates, the poles and the antimeridian
+std::vector<Coordinate> makeBatchCoordinates()
+{
+    std::vector<Coordinate> coordinates{Coordinate(FloatLongitude{13.4}, FloatLatitude{52.5}),
+                                        Coordinate(FloatLongitude{13.4}, FloatLatitude{52.5}),
+                                        Coordinate(FloatLongitude{180}, FloatLatitude{90}),
+                                        Coordinate(FloatLongitude{-180}, FloatLatitude{-90}),
+                                        Coordinate(FloatLongitude{179.9}, FloatLatitude{0}),
+                                        Coordinate(FloatLongitude{-179.9}, FloatLatitude{0})};
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> lon(-180, 180);
+    std::uniform_real_distribution<double> lat(-85, 85);
+    std::uniform_real_distribution<double> step(-0.001, 0.001);
+    for (int index = 0; index < 100; ++index)
+    {
+        coordinates.emplace_back(FloatLongitude{lon(generator)}, FloatLatitude{lat(generator)});
+    }
+    // a road
+    for (int index = 0; index < 100; ++index)
+    {
+        const auto &last = coordinates.back();
+        coordinates.emplace_back(
+            FloatLongitude{static_cast<double>(toFloating(last.lon)) + step(generator)},
+            FloatLatitude{static_cast<double>(toFloating(last.lat)) + step(generator)});
+    }
+    return coordinates;
+}
+}
+
+BOOST_AUTO_TEST_CASE(batch_distances)
+{
+    const auto coordinates = makeBatchCoordinates();
+    std::vector<double> distances;
+
+    coordinate_calculation::haversineDistances(coordinates, distances);
+    BOOST_REQUIRE_EQUAL(distances.size(), coordinates.size() - 1);
+    for (std::size_t index = 0; index + 1 < coordinates.size(); ++index)
+    {
+        const auto expected = coordinate_calculation::haversineDistance(coordinates[index],
+                                                                        coordinates[index + 1]);
+        BOOST_CHECK_SMALL(distances[index] - expected, 1e-6);
+    }
+
+    for (const auto &source : coordinates)
+    {
+        coordinate_calculation::haversineDistances(source, coordinates, distances);
+        BOOST_REQUIRE_EQUAL(distances.size(), coordinates.size());
+        for (std::size_t index = 0; index < coordinates.size(); ++index)
+        {
+            const auto expected =
+                coordinate_calculation::haversineDistance(source, coordinates[index]);
+            BOOST_CHECK_SMALL(distances[index] - expected, 1e-6);
+        }
+
+        coordinate_calculation::greatCircleDistances(source, coordinates, distances);
+        BOOST_REQUIRE_EQUAL(distances.size(), coordinates.size());
+        for (std::size_t index = 0; index < coordinates.size(); ++index)
+        {
+            const auto expected =
+                coordinate_calculation::greatCircleDistance(source, coordinates[index]);
+            BOOST_CHECK_SMALL(distances[index] - expected, 1e-6);
+        }
+    }
+
+    // lines without segments
+    coordinate_calculation::haversineDistances(std::vector<Coordinate>(1), distances);
+    BOOST_CHECK(distances.empty());
+    coordinate_calculation::haversineDistances(std::vector<Coordinate>(), distances);
+    BOOST_CHECK(distances.empty());
+}
+
+BOOST_AUTO_TEST_CASE(batch_bearings)
+{
+    const auto coordinates = makeBatchCoordinates();
+    std::vector<double> bearings;
+
+    coordinate_calculation::bearings(coordinates, bearings);
+    BOOST_REQUIRE_EQUAL(bearings.size(), coordinates.size() - 1);
+    for (std::size_t index = 0; index + 1 < coordinates.size(); ++index)
+    {
+        const auto expected =
+            coordinate_calculation::bearing(coordinates[index], coordinates[index + 1]);
+        BOOST_CHECK_SMALL(bearings[index] - expected, 1e-9);
+        BOOST_CHECK(bearings[index] >= 0 && bearings[index] < 360);
+    }
+
+    coordinate_calculation::bearings(std::vector<Coordinate>(1), bearings);
+    BOOST_CHECK(bearings.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,106 @@
+#include "util/crc32c.hpp"
+#include "contractor/crc32_processor.hpp"
+
+#include <boost/crc.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(crc32c_checksums)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+using ReferenceCRC32C = boost::crc_optimal<32, 0x1EDC6F41, 0, 0, true, true>;
+
+std::uint32_t referenceCRC32C(const char *data, const std::size_t size)
+{
+    ReferenceCRC32C reference;
+    reference.process_bytes(data, size);
+    return reference.checksum();
+}
+
+std::vector<char> randomBytes(const std::size_t size)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, 255);
+    std::vector<char> bytes(size);
+    for (auto &byte : bytes)
+    {
+        byte = static_cast<char>(distribution(generator));
+    }
+    return bytes;
+}
+}
+
+BOOST_AUTO_TEST_CASE(check_value)
+{
+    const std::string check = "123456789";
+    // the standard CRC-32C inverts the CRC at the start and the end
+    BOOST_CHECK_EQUAL(crc32c(0xFFFFFFFF, check.data(), check.size()) ^ 0xFFFFFFFF, 0xE3069283);
+    BOOST_CHECK_EQUAL(crc32c(0, check.data(), 0), 0);
+}
+
+BOOST_AUTO_TEST_CASE(sizes_and_offsets)
+{
+    const auto bytes = randomBytes(200000);
+    // the streams of the instructions use lanes of 256 and 8192 bytes
+    for (const std::size_t size : {1, 7, 8, 9, 767, 768, 769, 24575, 24576, 25000, 199990})
+    {
+        for (const std::size_t offset : {0, 1, 3})
+        {
+            BOOST_CHECK_EQUAL(crc32c(0, bytes.data() + offset, size),
+                              referenceCRC32C(bytes.data() + offset, size));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(continue_and_combine)
+{
+    const auto bytes = randomBytes(100000);
+    const auto expected = referenceCRC32C(bytes.data(), bytes.size());
+    for (const std::size_t split : {0, 1, 4096, 33333, 100000})
+    {
+        const auto crc_a = crc32c(0, bytes.data(), split);
+        const auto crc_b = crc32c(0, bytes.data() + split, bytes.size() - split);
+        BOOST_CHECK_EQUAL(crc32c(crc_a, bytes.data() + split, bytes.size() - split), expected);
+        BOOST_CHECK_EQUAL(crc32cCombine(crc_a, crc_b, bytes.size() - split), expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel)
+{
+    // more than two chunks, the last one is shorter
+    const auto bytes = randomBytes(10 * 1024 * 1024 + 13);
+    BOOST_CHECK_EQUAL(parallelCRC32C(bytes.data(), bytes.size()),
+                      referenceCRC32C(bytes.data(), bytes.size()));
+    BOOST_CHECK_EQUAL(parallelCRC32C(bytes.data(), 100), referenceCRC32C(bytes.data(), 100));
+}
+
+BOOST_AUTO_TEST_CASE(range_of_elements)
+{
+    struct Element
+    {
+        std::uint32_t first;
+        std::uint32_t second;
+        std::uint32_t third;
+    };
+    std::vector<Element> elements;
+    for (std::uint32_t index = 0; index < 300000; ++index)
+    {
+        elements.push_back({index, index * index, ~index});
+    }
+
+    contractor::RangebasedCRC32 crc32;
+    BOOST_CHECK_EQUAL(crc32(elements),
+                      referenceCRC32C(reinterpret_cast<const char *>(elements.data()),
+                                      elements.size() * sizeof(Element)));
+    BOOST_CHECK_EQUAL(crc32(std::vector<Element>()), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -64,4 +64,81 @@ BOOST_AUTO_TEST_CASE(find_test)
     BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(eit).id, 2);
 }
 
+BOOST_AUTO_TEST_CASE(insert_edges_test)
+{
+    std::vector<TestInputEdge> input_edges = {TestInputEdge{0, 1, TestData{1}},
+                                              TestInputEdge{1, 0, TestData{2}},
+                                              TestInputEdge{1, 2, TestData{3}},
+                                              TestInputEdge{2, 1, TestData{4}}};
+    TestDynamicGraph simple_graph(4, input_edges);
+    // frees a slot behind the edges of node 1
+    simple_graph.DeleteEdgesTo(1, 2);
+
+    // node 1 fits in place, node 0 has to be moved and node 3 has no edges yet
+    std::vector<TestInputEdge> new_edges = {TestInputEdge{0, 2, TestData{5}},
+                                            TestInputEdge{0, 3, TestData{6}},
+                                            TestInputEdge{1, 3, TestData{7}},
+                                            TestInputEdge{3, 0, TestData{8}},
+                                            TestInputEdge{3, 1, TestData{9}}};
+    simple_graph.InsertEdges(new_edges.begin(), new_edges.end());
+
+    BOOST_CHECK_EQUAL(simple_graph.GetNumberOfEdges(), 8);
+    BOOST_CHECK_EQUAL(simple_graph.GetOutDegree(0), 3);
+    BOOST_CHECK_EQUAL(simple_graph.GetOutDegree(1), 2);
+    BOOST_CHECK_EQUAL(simple_graph.GetOutDegree(2), 1);
+    BOOST_CHECK_EQUAL(simple_graph.GetOutDegree(3), 2);
+
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(0, 1)).id, 1);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(0, 2)).id, 5);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(0, 3)).id, 6);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(1, 0)).id, 2);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(1, 3)).id, 7);
+    BOOST_CHECK_EQUAL(simple_graph.FindEdge(1, 2), SPECIAL_EDGEID);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(2, 1)).id, 4);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(3, 0)).id, 8);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(3, 1)).id, 9);
+
+    // single edges still go through the moved nodes
+    simple_graph.InsertEdge(0, 0, TestData{10});
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(0, 0)).id, 10);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(3, 1)).id, 9);
+}
+
+BOOST_AUTO_TEST_CASE(compact_test)
+{
+    std::vector<TestInputEdge> input_edges = {TestInputEdge{0, 1, TestData{1}},
+                                              TestInputEdge{0, 2, TestData{2}},
+                                              TestInputEdge{1, 0, TestData{3}},
+                                              TestInputEdge{1, 2, TestData{4}},
+                                              TestInputEdge{1, 3, TestData{5}},
+                                              TestInputEdge{2, 0, TestData{6}}};
+    TestDynamicGraph simple_graph(4, input_edges);
+    // moves node 0 to the end of the edge list, node 2 loses its only edge
+    simple_graph.InsertEdge(0, 3, TestData{7});
+    simple_graph.DeleteEdgesTo(1, 3);
+    simple_graph.DeleteEdgesTo(2, 0);
+    const auto edge_list_size = simple_graph.GetEdgeListSize();
+
+    simple_graph.Compact();
+
+    BOOST_CHECK_LT(simple_graph.GetEdgeListSize(), edge_list_size);
+    BOOST_CHECK_EQUAL(simple_graph.GetNumberOfEdges(), 5);
+    BOOST_CHECK_EQUAL(simple_graph.GetOutDegree(0), 3);
+    BOOST_CHECK_EQUAL(simple_graph.GetOutDegree(1), 2);
+    BOOST_CHECK_EQUAL(simple_graph.GetOutDegree(2), 0);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(0, 1)).id, 1);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(0, 2)).id, 2);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(0, 3)).id, 7);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(1, 0)).id, 3);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(1, 2)).id, 4);
+
+    // the free slots are still usable
+    simple_graph.InsertEdge(1, 3, TestData{8});
+    simple_graph.InsertEdge(2, 1, TestData{9});
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(1, 3)).id, 8);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(2, 1)).id, 9);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(0, 3)).id, 7);
+    BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(simple_graph.FindEdge(1, 0)).id, 3);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+#include "util/flat_hash_map.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+
+BOOST_AUTO_TEST_SUITE(flat_hash_map)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(insert_find_erase)
+{
+    FlatHashMap<unsigned, int> map;
+    BOOST_CHECK(map.Empty());
+    BOOST_CHECK(map.Find(1) == nullptr);
+
+    BOOST_CHECK(map.Insert(1, 10));
+    BOOST_CHECK(map.Insert(2, 20));
+    BOOST_CHECK(!map.Insert(1, 30));
+    BOOST_CHECK_EQUAL(map.Size(), 2);
+    BOOST_CHECK_EQUAL(*map.Find(1), 10);
+    BOOST_CHECK_EQUAL(*map.Find(2), 20);
+
+    *map.Find(2) = 21;
+    BOOST_CHECK_EQUAL(*map.Find(2), 21);
+
+    BOOST_CHECK(map.Erase(1));
+    BOOST_CHECK(!map.Erase(1));
+    BOOST_CHECK(map.Find(1) == nullptr);
+    BOOST_CHECK_EQUAL(*map.Find(2), 21);
+    BOOST_CHECK_EQUAL(map.Size(), 1);
+}
+
+// mixes inserts and erases of a small key range, so probe sequences collide and get shifted
+BOOST_AUTO_TEST_CASE(random_operations)
+{
+    std::mt19937 generator(42);
+    for (const std::uint64_t range : {64u, 1024u, 100000u})
+    {
+        std::uniform_int_distribution<std::uint64_t> key_distribution(0, range);
+        FlatHashMap<std::uint64_t, std::uint64_t> map;
+        std::unordered_map<std::uint64_t, std::uint64_t> reference;
+
+        for (int step = 0; step < 200000; ++step)
+        {
+            // spread the keys over both halves of the 64 bit key like the packed node pairs
+            const auto key = key_distribution(generator) << (step % 2 == 0 ? 32 : 0);
+            if (generator() % 3 == 0)
+            {
+                BOOST_CHECK_EQUAL(map.Erase(key), reference.erase(key) == 1);
+            }
+            else
+            {
+                BOOST_CHECK_EQUAL(map.Insert(key, step), reference.emplace(key, step).second);
+            }
+        }
+
+        BOOST_CHECK_EQUAL(map.Size(), reference.size());
+        for (const auto &entry : reference)
+        {
+            const auto value = map.Find(entry.first);
+            BOOST_REQUIRE(value != nullptr);
+            BOOST_CHECK_EQUAL(*value, entry.second);
+        }
+        for (std::uint64_t key = 0; key <= range; ++key)
+        {
+            BOOST_CHECK_EQUAL(map.Find(key) != nullptr, reference.count(key) == 1);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(reserve)
+{
+    FlatHashMap<unsigned, unsigned> map;
+    map.Reserve(1000);
+    for (unsigned key = 0; key < 1000; ++key)
+    {
+        BOOST_CHECK(map.Insert(key, key * 2));
+    }
+    for (unsigned key = 0; key < 1000; ++key)
+    {
+        BOOST_CHECK_EQUAL(*map.Find(key), key * 2);
+    }
+    BOOST_CHECK(map.Find(1000) == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+#include "util/graph_loader.hpp"
+#include "util/fingerprint.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(graph_loader)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+void writeNodes(std::ostream &output, const std::vector<extractor::ExternalMemoryNode> &nodes)
+{
+    const auto fingerprint = FingerPrint::GetValid();
+    output.write(reinterpret_cast<const char *>(&fingerprint), sizeof(fingerprint));
+    const NodeID number_of_nodes = nodes.size();
+    output.write(reinterpret_cast<const char *>(&number_of_nodes), sizeof(number_of_nodes));
+    output.write(reinterpret_cast<const char *>(nodes.data()),
+                 nodes.size() * sizeof(extractor::ExternalMemoryNode));
+}
+}
+
+BOOST_AUTO_TEST_CASE(load_nodes_in_blocks)
+{
+    // more nodes than fit into a block
+    const NodeID number_of_nodes = 1024 * 1024 + 3;
+    std::vector<extractor::ExternalMemoryNode> nodes;
+    nodes.reserve(number_of_nodes);
+    for (NodeID node = 0; node < number_of_nodes; ++node)
+    {
+        nodes.emplace_back(FixedLongitude{static_cast<std::int32_t>(node)},
+                           FixedLatitude{-static_cast<std::int32_t>(node)},
+                           OSMNodeID{node + 100u},
+                           node % 1000 == 7,
+                           node == number_of_nodes - 1);
+    }
+    std::stringstream stream;
+    writeNodes(stream, nodes);
+
+    std::vector<NodeID> barriers;
+    std::vector<NodeID> traffic_lights;
+    std::vector<extractor::QueryNode> query_nodes;
+    BOOST_CHECK_EQUAL(loadNodesFromFile(stream, barriers, traffic_lights, query_nodes),
+                      number_of_nodes);
+
+    BOOST_REQUIRE_EQUAL(query_nodes.size(), number_of_nodes);
+    for (const auto node : {0u, 1024u * 1024u - 1u, 1024u * 1024u, number_of_nodes - 1})
+    {
+        BOOST_CHECK_EQUAL(static_cast<std::int32_t>(query_nodes[node].lon), node);
+        BOOST_CHECK_EQUAL(static_cast<std::int32_t>(query_nodes[node].lat),
+                          -static_cast<std::int32_t>(node));
+        BOOST_CHECK_EQUAL(static_cast<std::uint64_t>(query_nodes[node].node_id), node + 100u);
+    }
+    BOOST_CHECK_EQUAL(barriers.size(), (number_of_nodes + 992) / 1000);
+    BOOST_CHECK_EQUAL(barriers.front(), 7);
+    BOOST_CHECK_EQUAL(barriers.back(), 1048007);
+    BOOST_REQUIRE_EQUAL(traffic_lights.size(), 1);
+    BOOST_CHECK_EQUAL(traffic_lights.front(), number_of_nodes - 1);
+}
+
+BOOST_AUTO_TEST_CASE(truncated_nodes)
+{
+    std::vector<extractor::ExternalMemoryNode> nodes(10);
+    std::stringstream stream;
+    writeNodes(stream, nodes);
+    auto content = stream.str();
+    content.resize(content.size() - sizeof(extractor::ExternalMemoryNode) / 2);
+    std::stringstream truncated(content);
+
+    std::vector<NodeID> barriers;
+    std::vector<NodeID> traffic_lights;
+    std::vector<extractor::QueryNode> query_nodes;
+    BOOST_CHECK_THROW(loadNodesFromFile(truncated, barriers, traffic_lights, query_nodes),
+                      exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,36 @@
+#include "util/id_bitset.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+
+BOOST_AUTO_TEST_SUITE(id_bitset)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(add_and_contains)
+{
+    IdBitset ids;
+    BOOST_CHECK(!ids.Contains(0));
+    BOOST_CHECK_EQUAL(ids.Size(), 0);
+
+    // ids of a planet are far apart, only their pages are allocated
+    const std::uint64_t large_ids[] = {0, 63, 64, (1 << 20) - 1, 1 << 20, 12000000000};
+    for (const auto id : large_ids)
+    {
+        ids.Add(id);
+    }
+    ids.Add(64);
+    BOOST_CHECK_EQUAL(ids.Size(), 6);
+    for (const auto id : large_ids)
+    {
+        BOOST_CHECK(ids.Contains(id));
+    }
+    BOOST_CHECK(!ids.Contains(1));
+    BOOST_CHECK(!ids.Contains(65));
+    BOOST_CHECK(!ids.Contains(12000000001));
+    BOOST_CHECK(!ids.Contains(20000000000));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,50 @@
+#include "util/json_container.hpp"
+#include "util/json_renderer.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(json_container)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(object_keeps_insertion_order)
+{
+    json::Object object;
+    object.values["code"] = json::String("Ok");
+    object.values["durations"] = json::Array();
+    object.values["a"] = json::Number(1);
+    object.values["code"] = json::String("NoRoute");
+
+    std::string text;
+    json::render(text, object);
+    BOOST_CHECK_EQUAL(text, "{\"code\":\"NoRoute\",\"durations\":[],\"a\":1}");
+}
+
+BOOST_AUTO_TEST_CASE(object_lookup)
+{
+    json::Object object;
+    BOOST_CHECK(object.values.empty());
+    object.values.reserve(2);
+    BOOST_CHECK(object.values.emplace("name", json::String("first")).second);
+    BOOST_CHECK(!object.values.emplace("name", json::String("second")).second);
+    object.values["distance"] = json::Number(2.5);
+
+    BOOST_CHECK_EQUAL(object.values.size(), 2);
+    BOOST_CHECK_EQUAL(object.values.count("name"), 1);
+    BOOST_CHECK_EQUAL(object.values.count("duration"), 0);
+    BOOST_CHECK(object.values.find("duration") == object.values.end());
+    BOOST_CHECK_EQUAL(object.values.at("name").get<json::String>().value, "first");
+    BOOST_CHECK_EQUAL(object.values.at("distance").get<json::Number>().value, 2.5);
+    BOOST_CHECK_THROW(object.values.at("duration"), std::out_of_range);
+
+    BOOST_CHECK_EQUAL(object.values.erase("name"), 1);
+    BOOST_CHECK_EQUAL(object.values.erase("name"), 0);
+    BOOST_CHECK_EQUAL(object.values.begin()->first, "distance");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,87 @@
+#include "util/json_container.hpp"
+#include "util/json_parser.hpp"
+#include "util/json_renderer.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(json_parser)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(parse_response)
+{
+    const std::string text = "{\"code\":\"Ok\", \"durations\": [[0, 12.5, null], [-3e2, 1E1, 7]],"
+                             " \"ok\": true, \"failed\": false, \"empty\": {}, \"none\": []}";
+    json::Value value;
+    BOOST_REQUIRE(json::parse(text, value));
+    BOOST_REQUIRE(value.is<mapbox::util::recursive_wrapper<json::Object>>());
+    const auto &object = value.get<json::Object>();
+    BOOST_CHECK_EQUAL(object.values.at("code").get<json::String>().value, "Ok");
+
+    const auto &durations = object.values.at("durations").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(durations.size(), 2);
+    const auto &first_row = durations[0].get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(first_row.size(), 3);
+    BOOST_CHECK_EQUAL(first_row[0].get<json::Number>().value, 0);
+    BOOST_CHECK_EQUAL(first_row[1].get<json::Number>().value, 12.5);
+    BOOST_CHECK(first_row[2].is<json::Null>());
+    const auto &second_row = durations[1].get<json::Array>().values;
+    BOOST_CHECK_EQUAL(second_row[0].get<json::Number>().value, -300);
+    BOOST_CHECK_EQUAL(second_row[1].get<json::Number>().value, 10);
+
+    BOOST_CHECK(object.values.at("ok").is<json::True>());
+    BOOST_CHECK(object.values.at("failed").is<json::False>());
+    BOOST_CHECK(object.values.at("empty").get<json::Object>().values.empty());
+    BOOST_CHECK(object.values.at("none").get<json::Array>().values.empty());
+}
+
+BOOST_AUTO_TEST_CASE(parse_escapes)
+{
+    json::Value value;
+    BOOST_REQUIRE(json::parse("[\"a\\\"b\\\\c\\/d\\n\", \"\\u00e9\\u20ac\\ud83d\\ude97\"]", value));
+    const auto &strings = value.get<json::Array>().values;
+    BOOST_CHECK_EQUAL(strings[0].get<json::String>().value, "a\"b\\c/d\n");
+    BOOST_CHECK_EQUAL(strings[1].get<json::String>().value, "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x9A\x97");
+}
+
+BOOST_AUTO_TEST_CASE(render_parsed)
+{
+    const std::string text = "{\"code\":\"Ok\",\"routes\":[{\"geometry\":\"_p~iF~ps|U\\\\\","
+                             "\"duration\":12.5,\"legs\":[]}],\"waypoints\":[null,true]}";
+    json::Value value;
+    BOOST_REQUIRE(json::parse(text, value));
+    std::string rendered;
+    json::render(rendered, value.get<json::Object>());
+    BOOST_CHECK_EQUAL(rendered, text);
+}
+
+BOOST_AUTO_TEST_CASE(reject_invalid)
+{
+    const std::vector<std::string> invalid = {"",
+                                              "{",
+                                              "{\"a\" 1}",
+                                              "{\"a\":1,}",
+                                              "[1 2]",
+                                              "[1,]",
+                                              "\"open",
+                                              "\"\\x\"",
+                                              "\"\\ud83d\"",
+                                              "tru",
+                                              "nul",
+                                              "0x10",
+                                              "-",
+                                              "1.5.5",
+                                              "{} {}",
+                                              std::string(100, '[') + std::string(100, ']')};
+    for (const auto &text : invalid)
+    {
+        json::Value value;
+        BOOST_CHECK_MESSAGE(!json::parse(text, value), text);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,70 @@
+#include "util/cast.hpp"
+#include "util/json_container.hpp"
+#include "util/json_renderer.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(json_renderer)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(number_like_stringstream)
+{
+    const std::vector<double> numbers = {0,
+                                         1,
+                                         -1,
+                                         0.1,
+                                         -0.5,
+                                         13.388860,
+                                         52.517037,
+                                         -179.999999,
+                                         1234.5,
+                                         0.000001,
+                                         0.0000004,
+                                         123456789.1,
+                                         1e13,
+                                         -2.5e14};
+    for (const auto number : numbers)
+    {
+        std::string rendered;
+        json::renderNumber(rendered, number);
+        BOOST_CHECK_EQUAL(rendered, cast::to_string_with_precision(number));
+    }
+
+    // deciseconds, like the durations of a table
+    for (int deciseconds = 0; deciseconds < 100000; deciseconds += 7)
+    {
+        std::string rendered;
+        json::renderNumber(rendered, deciseconds / 10.);
+        BOOST_CHECK_EQUAL(rendered, cast::to_string_with_precision(deciseconds / 10.));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(render_object)
+{
+    json::Array row;
+    row.values.push_back(json::Number(1.5));
+    row.values.push_back(json::Null());
+    row.values.push_back(json::True());
+    row.values.push_back(json::False());
+    row.values.push_back(json::String("a\"b"));
+    row.values.push_back(json::RawJSON("[[1,2]]"));
+
+    json::Object object;
+    object.values["row"] = std::move(row);
+
+    std::string text;
+    json::render(text, object);
+    BOOST_CHECK_EQUAL(text, "{\"row\":[1.5,null,true,false,\"a\\\"b\",[[1,2]]]}");
+
+    std::vector<char> buffer;
+    json::render(buffer, object);
+    BOOST_CHECK_EQUAL(std::string(buffer.begin(), buffer.end()), text);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,100 @@
+#include "util/latency_histogram.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(latency_histogram)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(bucket_bounds)
+{
+    BOOST_CHECK_EQUAL(LatencyHistogram::GetBucket(0), 0);
+    BOOST_CHECK_EQUAL(LatencyHistogram::GetBucket(7), 7);
+    BOOST_CHECK_EQUAL(LatencyHistogram::GetBucket(8), 8);
+    BOOST_CHECK_EQUAL(LatencyHistogram::GetBucket(15), 15);
+    BOOST_CHECK_EQUAL(LatencyHistogram::GetBucket(16), 16);
+    BOOST_CHECK_EQUAL(LatencyHistogram::GetBucket(17), 16);
+    BOOST_CHECK_EQUAL(LatencyHistogram::GetBucket(1u << 30),
+                      LatencyHistogram::NUMBER_OF_BUCKETS - 1);
+
+    // every duration is below the upper bound of its bucket and not below the one before
+    for (std::uint64_t microseconds = 0; microseconds < (1u << 20); microseconds += 37)
+    {
+        const auto bucket = LatencyHistogram::GetBucket(microseconds);
+        BOOST_REQUIRE(bucket < LatencyHistogram::NUMBER_OF_BUCKETS);
+        BOOST_CHECK_LT(microseconds, LatencyHistogram::GetUpperBound(bucket).count());
+        if (bucket > 0)
+        {
+            BOOST_CHECK_GE(microseconds, LatencyHistogram::GetUpperBound(bucket - 1).count());
+        }
+    }
+    BOOST_CHECK_EQUAL(
+        LatencyHistogram::GetUpperBound(LatencyHistogram::NUMBER_OF_BUCKETS - 1).count(),
+        1u << (LatencyHistogram::MAX_EXPONENT + 1));
+}
+
+BOOST_AUTO_TEST_CASE(quantiles)
+{
+    LatencyHistogram histogram;
+    BOOST_CHECK_EQUAL(histogram.GetSnapshot().GetQuantile(0.5).count(), 0);
+
+    // 1ms to 100ms
+    for (int milliseconds = 1; milliseconds <= 100; ++milliseconds)
+    {
+        histogram.Record(std::chrono::milliseconds(milliseconds));
+    }
+    const auto snapshot = histogram.GetSnapshot();
+    BOOST_CHECK_EQUAL(snapshot.count, 100);
+    BOOST_CHECK_EQUAL(std::chrono::duration_cast<std::chrono::milliseconds>(snapshot.sum).count(),
+                      5050);
+
+    const auto check_quantile = [&](const double quantile, const double expected_us) {
+        const auto value = snapshot.GetQuantile(quantile).count();
+        BOOST_CHECK_GE(value, expected_us);
+        BOOST_CHECK_LE(value, expected_us * 1.125);
+    };
+    check_quantile(0., 1000);
+    check_quantile(0.5, 50000);
+    check_quantile(0.9, 90000);
+    check_quantile(0.99, 99000);
+    check_quantile(1., 100000);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_recording)
+{
+    LatencyHistogram histogram;
+    const unsigned number_of_threads = 4;
+    const unsigned samples_per_thread = 10000;
+
+    std::vector<std::thread> threads;
+    for (unsigned index = 0; index < number_of_threads; ++index)
+    {
+        threads.emplace_back([&] {
+            for (unsigned sample = 0; sample < samples_per_thread; ++sample)
+            {
+                histogram.Record(std::chrono::microseconds(sample % 100));
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    const auto snapshot = histogram.GetSnapshot();
+    BOOST_CHECK_EQUAL(snapshot.count, number_of_threads * samples_per_thread);
+    std::uint64_t count = 0;
+    for (const auto bucket_count : snapshot.counts)
+    {
+        count += bucket_count;
+    }
+    BOOST_CHECK_EQUAL(count, snapshot.count);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
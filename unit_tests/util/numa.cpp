@@ -0,0 +1,48 @@
+#include "util/numa.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(numa)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(parse_cpu_list)
+{
+    const std::vector<unsigned> ranges = {0, 1, 2, 3, 8, 10, 11};
+    const auto parsed = parseCPUList("0-3,8,10-11\n");
+    BOOST_CHECK_EQUAL_COLLECTIONS(parsed.begin(), parsed.end(), ranges.begin(), ranges.end());
+
+    BOOST_CHECK(parseCPUList("").empty());
+    BOOST_CHECK(parseCPUList("\n").empty());
+}
+
+BOOST_AUTO_TEST_CASE(nodes_have_cpus)
+{
+    const auto nodes = getNUMANodes();
+    BOOST_REQUIRE(!nodes.empty());
+    for (const auto &node : nodes)
+    {
+        BOOST_CHECK(!node.empty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(bound_threads_know_their_node)
+{
+    const auto nodes = getNUMANodes();
+    // binds a thread of its own to leave the affinity of the other tests alone
+    std::thread thread([&] {
+        BOOST_CHECK_EQUAL(getThreadNUMANode(), 0);
+        if (bindThreadToNUMANode(nodes.size() - 1, nodes.back()))
+        {
+            BOOST_CHECK_EQUAL(getThreadNUMANode(), nodes.size() - 1);
+        }
+    });
+    thread.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,42 @@
+#include "util/packed_bitset.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(packed_bitset)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(pack_and_test)
+{
+    BOOST_CHECK_EQUAL(PackedBitsetView::GetNumberOfWords(0), 0);
+    BOOST_CHECK_EQUAL(PackedBitsetView::GetNumberOfWords(64), 1);
+    BOOST_CHECK_EQUAL(PackedBitsetView::GetNumberOfWords(65), 2);
+
+    // the flags of a partial last word and of the bits on the word boundaries
+    const std::size_t size = 150;
+    std::vector<char> unpacked(size, 0);
+    for (const std::size_t index : {0, 5, 63, 64, 127, 128, 149})
+    {
+        unpacked[index] = 1;
+    }
+    std::vector<PackedBitsetView::Word> words(PackedBitsetView::GetNumberOfWords(size), ~0ull);
+    PackedBitsetView::Pack(unpacked.data(), size, words.data());
+
+    const PackedBitsetView bits(words.data(), size);
+    BOOST_CHECK_EQUAL(bits.Size(), size);
+    BOOST_CHECK(!bits.Empty());
+    for (std::size_t index = 0; index < size; ++index)
+    {
+        BOOST_CHECK_EQUAL(bits.Test(index), unpacked[index] == 1);
+    }
+    // the bits past the end are cleared
+    BOOST_CHECK_EQUAL(words.back() >> (size % 64), 0);
+
+    BOOST_CHECK(PackedBitsetView().Empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
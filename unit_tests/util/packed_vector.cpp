@@ -4,6 +4,10 @@
 #include <boost/test/test_case_template.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <iterator>
+#include <utility>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(packed_vector_test)
 
 using namespace osrm;
@@ -19,7 +23,7 @@ BOOST_AUTO_TEST_CASE(insert_and_retrieve_packed_test)
 
     for (std::size_t i = 0; i < num_test_cases; i++)
     {
-        OSMNodeID r{static_cast<std::uint64_t>(rand() % 2147483647)}; // max 33-bit uint
+        OSMNodeID r{static_cast<std::uint64_t>(rand() % 2147483647)};
 
         packed_ids.push_back(r);
         original_ids.push_back(r);
@@ -31,6 +35,87 @@ BOOST_AUTO_TEST_CASE(insert_and_retrieve_packed_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(large_ids_packed_test)
+{
+    PackedVector<OSMNodeID, false> packed_ids;
+    std::vector<OSMNodeID> original_ids;
+
+    // ids past 33 bits and the largest 34 bit id
+    for (std::uint64_t i = 0; i < 200; i++)
+    {
+        original_ids.push_back(OSMNodeID{(std::uint64_t{1} << 33) + i * 40000019});
+    }
+    original_ids.push_back(OSMNodeID{(std::uint64_t{1} << 34) - 1});
+    original_ids.push_back(OSMNodeID{0});
+
+    for (const auto id : original_ids)
+    {
+        packed_ids.push_back(id);
+    }
+    BOOST_CHECK_EQUAL(packed_ids.size(), original_ids.size());
+
+    for (std::size_t i = 0; i < original_ids.size(); i++)
+    {
+        BOOST_CHECK_EQUAL(original_ids.at(i), packed_ids.at(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(bit_sizes_packed_test)
+{
+    PackedVector<std::uint64_t, false, 7> small_values;
+    PackedVector<std::uint64_t, false, 63> large_values;
+    for (std::uint64_t i = 0; i < 300; i++)
+    {
+        small_values.push_back(i % 128);
+        large_values.push_back(i * 0x12345678abcdefULL & ((std::uint64_t{1} << 63) - 1));
+    }
+
+    for (std::uint64_t i = 0; i < 300; i++)
+    {
+        BOOST_CHECK_EQUAL(small_values.at(i), i % 128);
+        BOOST_CHECK_EQUAL(large_values.at(i),
+                          i * 0x12345678abcdefULL & ((std::uint64_t{1} << 63) - 1));
+    }
+
+    BOOST_CHECK_EQUAL((PackedVector<std::uint64_t, false, 7>::elements_to_blocks(9)), 1);
+    BOOST_CHECK_EQUAL((PackedVector<std::uint64_t, false, 7>::elements_to_blocks(10)), 2);
+    BOOST_CHECK_EQUAL(PackedVector<OSMNodeID>::elements_to_blocks(32), 17);
+}
+
+BOOST_AUTO_TEST_CASE(decode_range_test)
+{
+    PackedVector<OSMNodeID, false> packed_ids;
+    PackedVector<std::uint64_t, false, 13> small_values;
+    std::vector<OSMNodeID> original_ids;
+    for (std::uint64_t i = 0; i < 1000; i++)
+    {
+        original_ids.push_back(OSMNodeID{(std::uint64_t{1} << 33) + i * 8000009});
+        packed_ids.push_back(original_ids.back());
+        small_values.push_back(i * 37 % 8192);
+    }
+
+    // ranges inside a group, over group borders, of whole groups and up to the end
+    for (const auto &range : std::vector<std::pair<std::size_t, std::size_t>>{
+             {0, 0}, {3, 17}, {60, 70}, {64, 192}, {1, 1000}, {0, 1000}, {999, 1000}})
+    {
+        std::vector<OSMNodeID> decoded_ids;
+        packed_ids.decode_range(range.first, range.second, std::back_inserter(decoded_ids));
+        BOOST_CHECK_EQUAL_COLLECTIONS(decoded_ids.begin(),
+                                      decoded_ids.end(),
+                                      original_ids.begin() + range.first,
+                                      original_ids.begin() + range.second);
+
+        std::vector<std::uint64_t> decoded_values(range.second - range.first);
+        const auto end =
+            small_values.decode_range(range.first, range.second, decoded_values.begin());
+        BOOST_CHECK(end == decoded_values.end());
+        for (std::size_t i = 0; i < decoded_values.size(); i++)
+        {
+            BOOST_CHECK_EQUAL(decoded_values[i], small_values.at(range.first + i));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(packed_vector_capacity_test)
 {
     PackedVector<OSMNodeID, false> packed_vec;
@@ -0,0 +1,61 @@
+#include "util/page_heat.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+BOOST_AUTO_TEST_SUITE(page_heat)
+
+using namespace osrm;
+using namespace osrm::util;
+
+#ifdef __linux__
+BOOST_AUTO_TEST_CASE(resident_pages)
+{
+    const std::size_t page_size = sysconf(_SC_PAGESIZE);
+    const std::size_t number_of_pages = 8;
+    auto *const data = static_cast<char *>(mmap(nullptr,
+                                                number_of_pages * page_size,
+                                                PROT_READ | PROT_WRITE,
+                                                MAP_PRIVATE | MAP_ANONYMOUS,
+                                                -1,
+                                                0));
+    BOOST_REQUIRE(data != MAP_FAILED);
+    data[0] = 1;
+    data[3 * page_size + 10] = 1;
+
+    const auto resident =
+        PageHeatSampler::GetResidentPages(MemoryRegion{data, number_of_pages * page_size});
+    BOOST_CHECK_EQUAL(resident.size(), number_of_pages);
+    BOOST_CHECK(resident[0]);
+    BOOST_CHECK(!resident[1]);
+    BOOST_CHECK(resident[3]);
+    BOOST_CHECK(!resident[7]);
+
+    // a region within a page starts at its page
+    const auto inner = PageHeatSampler::GetResidentPages(MemoryRegion{data + 3 * page_size + 5, 2});
+    BOOST_REQUIRE_EQUAL(inner.size(), 1);
+    BOOST_CHECK(inner[0]);
+
+    munmap(data, number_of_pages * page_size);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(stops_without_waiting_for_the_interval)
+{
+    const auto start = std::chrono::steady_clock::now();
+    {
+        PageHeatSampler sampler([] { return std::vector<NamedMemoryRegion>(); },
+                                std::chrono::seconds(3600));
+    }
+    BOOST_CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(60));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
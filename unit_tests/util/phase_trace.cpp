@@ -0,0 +1,84 @@
+#include "util/phase_trace.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <iterator>
+#include <string>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(phase_trace)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+std::string writeTrace(const PhaseTrace::Format format)
+{
+    const auto path =
+        boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    PhaseTrace::GetInstance().Write(path, format);
+    boost::filesystem::ifstream input(path);
+    const std::string trace{std::istreambuf_iterator<char>(input),
+                            std::istreambuf_iterator<char>()};
+    boost::filesystem::remove(path);
+    return trace;
+}
+}
+
+BOOST_AUTO_TEST_CASE(formats)
+{
+    PhaseTrace::Format format;
+    BOOST_CHECK(PhaseTrace::GetFormat("json", format));
+    BOOST_CHECK(format == PhaseTrace::Format::JSON);
+    BOOST_CHECK(PhaseTrace::GetFormat("chrome", format));
+    BOOST_CHECK(format == PhaseTrace::Format::Chrome);
+    BOOST_CHECK(!PhaseTrace::GetFormat("xml", format));
+}
+
+BOOST_AUTO_TEST_CASE(nested_phases)
+{
+    // nothing is recorded before tracing is enabled
+    {
+        const PhaseTrace::ScopedPhase ignored("ignored");
+    }
+
+    PhaseTrace::GetInstance().Enable(2);
+    BOOST_CHECK(PhaseTrace::GetInstance().IsEnabled());
+    {
+        const PhaseTrace::ScopedPhase outer("outer");
+        {
+            const PhaseTrace::ScopedPhase inner("inner");
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        PhaseTrace::ScopedPhase second("second");
+        second.Stop();
+        second.Stop();
+    }
+
+    // sorted by their start, the outer phase first
+    const auto json = writeTrace(PhaseTrace::Format::JSON);
+    BOOST_CHECK_EQUAL(json.find("ignored"), std::string::npos);
+    BOOST_CHECK_EQUAL(json.find("{\"threads\":2,\"phases\":[{\"name\":\"outer\",\"depth\":0,"), 0);
+    const auto inner = json.find("{\"name\":\"inner\",\"depth\":1,");
+    const auto second = json.find("{\"name\":\"second\",\"depth\":1,");
+    BOOST_CHECK(inner != std::string::npos);
+    BOOST_CHECK(second != std::string::npos);
+    BOOST_CHECK(inner < second);
+    BOOST_CHECK_EQUAL(json.find("second", second + 10), std::string::npos);
+    BOOST_CHECK(json.find("\"wall_time\":") != std::string::npos);
+    BOOST_CHECK(json.find("\"utilization\":") != std::string::npos);
+
+    const auto chrome = writeTrace(PhaseTrace::Format::Chrome);
+    BOOST_CHECK_EQUAL(chrome.find("{\"traceEvents\":[{\"name\":\"outer\",\"cat\":\"phase\","
+                                  "\"ph\":\"X\","),
+                      0);
+    BOOST_CHECK(chrome.find("\"name\":\"memory\",\"ph\":\"C\"") != std::string::npos);
+    BOOST_CHECK(chrome.find("\"displayTimeUnit\":\"ms\"}") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
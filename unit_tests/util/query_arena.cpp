@@ -0,0 +1,105 @@
+#include "util/query_arena.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(query_arena)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+using QueryVector = std::vector<std::uint64_t, QueryAllocator<std::uint64_t>>;
+
+// every test runs on its own thread, which starts with an empty arena
+template <typename Test> void runOnThread(Test test)
+{
+    std::thread thread(test);
+    thread.join();
+}
+}
+
+BOOST_AUTO_TEST_CASE(outside_of_a_query)
+{
+    runOnThread([] {
+        BOOST_CHECK(QueryArena::Current() == nullptr);
+        QueryVector values(1000, 1);
+        values.push_back(2);
+        BOOST_CHECK_EQUAL(values.back(), 2);
+    });
+}
+
+BOOST_AUTO_TEST_CASE(scopes)
+{
+    runOnThread([] {
+        {
+            const QueryArena::Scope scope;
+            auto *const arena = QueryArena::Current();
+            BOOST_REQUIRE(arena != nullptr);
+            BOOST_CHECK_EQUAL(arena->GetCapacity(), 0);
+            {
+                // a nested query shares the arena
+                const QueryArena::Scope nested_scope;
+                BOOST_CHECK_EQUAL(QueryArena::Current(), arena);
+                QueryVector values(100, 1);
+                BOOST_CHECK_GT(arena->GetCapacity(), 0);
+            }
+            BOOST_CHECK_EQUAL(QueryArena::Current(), arena);
+
+            // more than the first block
+            std::vector<QueryVector> vectors;
+            for (std::uint64_t index = 0; index < 100; ++index)
+            {
+                vectors.emplace_back(1000, index);
+            }
+            for (std::uint64_t index = 0; index < 100; ++index)
+            {
+                BOOST_CHECK_EQUAL(vectors[index].front(), index);
+                BOOST_CHECK_EQUAL(vectors[index].back(), index);
+            }
+        }
+        BOOST_CHECK(QueryArena::Current() == nullptr);
+
+        // the next query gets the memory of the last one in one block
+        const QueryArena::Scope scope;
+        const auto capacity = QueryArena::Current()->GetCapacity();
+        BOOST_CHECK_GE(capacity, 100 * 1000 * sizeof(std::uint64_t));
+        std::vector<QueryVector> vectors;
+        for (std::uint64_t index = 0; index < 50; ++index)
+        {
+            vectors.emplace_back(1000, index);
+        }
+        BOOST_CHECK_EQUAL(QueryArena::Current()->GetCapacity(), capacity);
+    });
+}
+
+BOOST_AUTO_TEST_CASE(other_threads)
+{
+    runOnThread([] {
+        const QueryArena::Scope scope;
+        auto *const arena = QueryArena::Current();
+
+        // a thread that helps with the query allocates from the heap
+        QueryVector values;
+        runOnThread([&] {
+            BOOST_CHECK(QueryArena::Current() == nullptr);
+            values.assign(1000, 1);
+        });
+        BOOST_CHECK_EQUAL(arena->GetCapacity(), 0);
+
+        // the vector grows into the arena on the thread of the query
+        values.resize(2000, 2);
+        BOOST_CHECK_GT(arena->GetCapacity(), 0);
+        BOOST_CHECK_EQUAL(values[999], 1);
+        BOOST_CHECK_EQUAL(values[1999], 2);
+
+        const QueryVector copy = values;
+        BOOST_CHECK(copy == values);
+    });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,182 @@
+#include "util/query_metrics.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(query_metrics)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+// the line of a series of the rendered metrics, empty if there is none
+std::string getLine(const std::string &metrics, const std::string &series)
+{
+    // the help lines start with the name of the series, too
+    const auto newline = metrics.find("\n" + series + " ");
+    if (newline == std::string::npos)
+    {
+        return "";
+    }
+    const auto begin = newline + 1;
+    return metrics.substr(begin, metrics.find('\n', begin) - begin);
+}
+
+double getValue(const std::string &metrics, const std::string &series)
+{
+    const auto line = getLine(metrics, series);
+    BOOST_REQUIRE(!line.empty());
+    return std::stod(line.substr(series.size() + 1));
+}
+}
+
+BOOST_AUTO_TEST_CASE(service_names)
+{
+    QueryMetrics::Service service;
+    BOOST_CHECK(QueryMetrics::GetService("route", service));
+    BOOST_CHECK(service == QueryMetrics::Service::Route);
+    BOOST_CHECK(QueryMetrics::GetService("routebatch", service));
+    BOOST_CHECK(service == QueryMetrics::Service::RouteBatch);
+    BOOST_CHECK(QueryMetrics::GetService("tile", service));
+    BOOST_CHECK(service == QueryMetrics::Service::Tile);
+    BOOST_CHECK(!QueryMetrics::GetService("routes", service));
+    BOOST_CHECK(!QueryMetrics::GetService("", service));
+}
+
+// The metrics are global, so the tests use different services
+BOOST_AUTO_TEST_CASE(nested_phases)
+{
+    {
+        const QueryMetrics::ScopedQuery query(QueryMetrics::Service::Match);
+        const QueryMetrics::ScopedPhase search(QueryMetrics::Phase::Search);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        {
+            const QueryMetrics::ScopedPhase unpacking(QueryMetrics::Phase::Unpacking);
+            std::this_thread::sleep_for(std::chrono::milliseconds(40));
+        }
+    }
+    // outside of a query
+    {
+        const QueryMetrics::ScopedPhase search(QueryMetrics::Phase::Search);
+    }
+
+    std::string metrics;
+    QueryMetrics::GetInstance().Render(metrics);
+
+    const std::string query = "{service=\"match\",phase=\"query\"}";
+    const std::string search = "{service=\"match\",phase=\"search\"}";
+    const std::string unpacking = "{service=\"match\",phase=\"unpacking\"}";
+    BOOST_CHECK_EQUAL(getValue(metrics, "osrm_query_duration_seconds_count" + query), 1);
+    BOOST_CHECK_EQUAL(getValue(metrics, "osrm_query_duration_seconds_count" + search), 1);
+    BOOST_CHECK_EQUAL(getValue(metrics, "osrm_query_duration_seconds_count" + unpacking), 1);
+
+    // the search doesn't include the unpacking nested into it, or they would add up to more
+    // than the query
+    const auto query_seconds = getValue(metrics, "osrm_query_duration_seconds_sum" + query);
+    const auto search_seconds = getValue(metrics, "osrm_query_duration_seconds_sum" + search);
+    const auto unpacking_seconds =
+        getValue(metrics, "osrm_query_duration_seconds_sum" + unpacking);
+    BOOST_CHECK_GE(search_seconds, 0.02);
+    BOOST_CHECK_GE(unpacking_seconds, 0.04);
+    BOOST_CHECK_GE(query_seconds, search_seconds + unpacking_seconds);
+
+    // phases without samples are left out
+    BOOST_CHECK(getLine(metrics, "osrm_query_duration_seconds_count{service=\"match\","
+                                 "phase=\"snapping\"}")
+                    .empty());
+}
+
+BOOST_AUTO_TEST_CASE(render_summary)
+{
+    auto &metrics = QueryMetrics::GetInstance();
+    for (int index = 0; index < 10; ++index)
+    {
+        metrics.Record(QueryMetrics::Service::Trip,
+                       QueryMetrics::Phase::Compression,
+                       std::chrono::milliseconds(1));
+    }
+
+    std::string output;
+    metrics.Render(output);
+    BOOST_CHECK_EQUAL(output.find("# TYPE osrm_query_duration_seconds summary\n"),
+                      output.find('\n') + 1);
+
+    const std::string labels = "service=\"trip\",phase=\"compression\"";
+    BOOST_CHECK_EQUAL(getValue(output, "osrm_query_duration_seconds_count{" + labels + "}"), 10);
+    BOOST_CHECK_CLOSE(
+        getValue(output, "osrm_query_duration_seconds_sum{" + labels + "}"), 0.01, 0.001);
+    const auto median =
+        getValue(output, "osrm_query_duration_seconds{" + labels + ",quantile=\"0.5\"}");
+    BOOST_CHECK_GE(median, 0.001);
+    BOOST_CHECK_LE(median, 0.001125);
+    BOOST_CHECK(!getLine(output, "osrm_query_duration_seconds{" + labels + ",quantile=\"0.999\"}")
+                     .empty());
+}
+
+BOOST_AUTO_TEST_CASE(leaf_page_faults)
+{
+    auto &metrics = QueryMetrics::GetInstance();
+    std::string before;
+    metrics.Render(before);
+    metrics.AddLeafPageFaults(3);
+    std::string after;
+    metrics.Render(after);
+
+    const auto counter = "osrm_rtree_leaf_page_faults_total";
+    BOOST_CHECK_EQUAL(getValue(after, counter) - getValue(before, counter), 3);
+}
+
+BOOST_AUTO_TEST_CASE(search_counts)
+{
+    auto &metrics = QueryMetrics::GetInstance();
+    metrics.AddSearchCount(
+        QueryMetrics::Service::Table, QueryMetrics::SearchCounter::SettledNodes, 40);
+    metrics.AddSearchCount(
+        QueryMetrics::Service::Table, QueryMetrics::SearchCounter::SettledNodes, 2);
+    metrics.AddSearchCount(
+        QueryMetrics::Service::Table, QueryMetrics::SearchCounter::UnpackedShortcuts, 5);
+
+    std::string output;
+    metrics.Render(output);
+    BOOST_CHECK_EQUAL(
+        getValue(output, "osrm_search_total{service=\"table\",counter=\"settled_nodes\"}"), 42);
+    BOOST_CHECK_EQUAL(
+        getValue(output, "osrm_search_total{service=\"table\",counter=\"unpacked_shortcuts\"}"),
+        5);
+    // counters without counts are left out
+    BOOST_CHECK(
+        getLine(output, "osrm_search_total{service=\"table\",counter=\"core_entries\"}").empty());
+}
+
+BOOST_AUTO_TEST_CASE(dataset_swaps)
+{
+    auto &metrics = QueryMetrics::GetInstance();
+    std::string before;
+    metrics.Render(before);
+    // nothing was swapped yet
+    BOOST_CHECK(getLine(before, "osrm_dataset_swap_stall_seconds_count").empty());
+
+    metrics.RecordSwap(QueryMetrics::SwapPhase::Barriers, std::chrono::milliseconds(2));
+    metrics.RecordSwap(QueryMetrics::SwapPhase::Mapping, std::chrono::milliseconds(30));
+    metrics.RecordSwap(QueryMetrics::SwapPhase::Draining, std::chrono::milliseconds(500));
+    metrics.RecordSwapStall(std::chrono::milliseconds(530));
+    metrics.RecordSwapStall(std::chrono::milliseconds(100));
+
+    std::string output;
+    metrics.Render(output);
+    BOOST_CHECK_EQUAL(
+        getValue(output, "osrm_dataset_swap_duration_seconds_count{phase=\"draining\"}"), 1);
+    BOOST_CHECK_CLOSE(
+        getValue(output, "osrm_dataset_swap_duration_seconds_sum{phase=\"mapping\"}"), 0.03, 1);
+    BOOST_CHECK_EQUAL(getValue(output, "osrm_dataset_swap_stall_seconds_count"), 2);
+    BOOST_CHECK_CLOSE(getValue(output, "osrm_dataset_swap_stall_seconds_sum"), 0.63, 1);
+    // the quantiles of the summary without labels of its own
+    BOOST_CHECK(!getLine(output, "osrm_dataset_swap_stall_seconds{quantile=\"0.5\"}").empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,92 @@
+#include "util/query_metrics.hpp"
+#include "util/sampling_profiler.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(sampling_profiler)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(collapsed_stacks_of_a_query)
+{
+    if (!SamplingProfiler::IsAvailable())
+    {
+        return;
+    }
+    const auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    auto &profiler = SamplingProfiler::GetInstance();
+
+    SamplingProfiler::Summary summary;
+    auto profile = std::async(std::launch::async, [&] {
+        return profiler.Profile(std::chrono::milliseconds(500), 1000, path, summary);
+    });
+
+    {
+        // keeps the thread busy in the search phase of a table query until the profile is done
+        QueryMetrics::ScopedQuery query(QueryMetrics::Service::Table);
+        QueryMetrics::ScopedPhase phase(QueryMetrics::Phase::Search);
+        volatile std::uint64_t sum = 0;
+        while (profile.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            for (int step = 0; step < 100000; ++step)
+            {
+                sum = sum + step;
+            }
+            SamplingProfiler::Summary other;
+            BOOST_CHECK(!profiler.IsRunning() ||
+                        !profiler.Profile(std::chrono::milliseconds(1), 1, path, other));
+        }
+    }
+    BOOST_REQUIRE(profile.get());
+    BOOST_CHECK(!profiler.IsRunning());
+    BOOST_CHECK_GT(summary.number_of_samples, 0);
+    BOOST_CHECK_GT(summary.number_of_stacks, 0);
+
+    boost::filesystem::ifstream stream(path);
+    std::string line;
+    std::uint64_t number_of_samples = 0;
+    bool has_query = false;
+    while (std::getline(stream, line))
+    {
+        const auto space = line.find_last_of(' ');
+        BOOST_REQUIRE(space != std::string::npos);
+        number_of_samples += std::stoull(line.substr(space + 1));
+        has_query = has_query || line.compare(0, 13, "table;search;") == 0;
+    }
+    BOOST_CHECK_EQUAL(number_of_samples, summary.number_of_samples);
+    BOOST_CHECK(has_query);
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(current_query)
+{
+    QueryMetrics::Service service;
+    QueryMetrics::Phase phase;
+    BOOST_CHECK(!QueryMetrics::GetCurrentQuery(service, phase));
+    {
+        QueryMetrics::ScopedQuery query(QueryMetrics::Service::Route);
+        BOOST_REQUIRE(QueryMetrics::GetCurrentQuery(service, phase));
+        BOOST_CHECK(service == QueryMetrics::Service::Route);
+        BOOST_CHECK(phase == QueryMetrics::Phase::Query);
+        {
+            QueryMetrics::ScopedPhase unpacking(QueryMetrics::Phase::Unpacking);
+            BOOST_REQUIRE(QueryMetrics::GetCurrentQuery(service, phase));
+            BOOST_CHECK(phase == QueryMetrics::Phase::Unpacking);
+        }
+        BOOST_REQUIRE(QueryMetrics::GetCurrentQuery(service, phase));
+        BOOST_CHECK(phase == QueryMetrics::Phase::Query);
+    }
+    BOOST_CHECK(!QueryMetrics::GetCurrentQuery(service, phase));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,115 @@
+#include "util/shard_map.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <limits>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(shard_map_test)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+RectangleInt2D makeBox(const double west, const double south, const double east, const double north)
+{
+    return RectangleInt2D(
+        FloatLongitude{west}, FloatLongitude{east}, FloatLatitude{south}, FloatLatitude{north});
+}
+
+Coordinate makeCoordinate(const double longitude, const double latitude)
+{
+    return Coordinate(FloatLongitude{longitude}, FloatLatitude{latitude});
+}
+
+// three shards side by side, with two boundary points between each pair of neighbours
+ShardMap makeShardMap()
+{
+    ShardMap shard_map;
+    shard_map.AddShard(makeBox(0, 0, 1, 1), makeBox(-0.1, -0.1, 1.1, 1.1));
+    shard_map.AddShard(makeBox(1, 0, 2, 1), makeBox(0.9, -0.1, 2.1, 1.1));
+    shard_map.AddShard(makeBox(2, 0, 3, 1), makeBox(1.9, -0.1, 3.1, 1.1));
+    shard_map.AddBoundaryPoint(makeCoordinate(1, 0.2), 0, 1);
+    shard_map.AddBoundaryPoint(makeCoordinate(1, 0.8), 0, 1);
+    shard_map.AddBoundaryPoint(makeCoordinate(2, 0.2), 1, 2);
+    shard_map.AddBoundaryPoint(makeCoordinate(2, 0.8), 1, 2);
+    // the road along the bottom of shard 1 is slow
+    shard_map.SetOverlay({{1, 0, 2, 500}, {1, 2, 0, 500}, {1, 1, 3, 100}, {1, 3, 1, 100},
+                          {1, 0, 1, 60}, {1, 1, 0, 60}, {1, 2, 3, 60}, {1, 3, 2, 60}});
+    return shard_map;
+}
+}
+
+BOOST_AUTO_TEST_CASE(find_shard)
+{
+    const auto shard_map = makeShardMap();
+    BOOST_CHECK_EQUAL(shard_map.FindShard(makeCoordinate(0.5, 0.5)), 0);
+    BOOST_CHECK_EQUAL(shard_map.FindShard(makeCoordinate(1.5, 0.5)), 1);
+    BOOST_CHECK_EQUAL(shard_map.FindShard(makeCoordinate(2.5, 0.5)), 2);
+    // outside of all cores the nearest one
+    BOOST_CHECK_EQUAL(shard_map.FindShard(makeCoordinate(3.5, 0.5)), 2);
+    BOOST_CHECK_EQUAL(shard_map.FindShard(makeCoordinate(1.5, -1)), 1);
+
+    BOOST_CHECK(shard_map.IsInRegion(0, makeCoordinate(1.05, 0.5)));
+    BOOST_CHECK(!shard_map.IsInRegion(0, makeCoordinate(1.5, 0.5)));
+    BOOST_CHECK((shard_map.GetBoundaryPoints(0) == std::vector<std::uint32_t>{0, 1}));
+    BOOST_CHECK((shard_map.GetBoundaryPoints(1) == std::vector<std::uint32_t>{0, 1, 2, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(search_overlay)
+{
+    const auto shard_map = makeShardMap();
+    const auto infinity = std::numeric_limits<double>::infinity();
+
+    // from shard 0, where the bottom boundary point is closer
+    std::vector<double> durations = {10, 30, infinity, infinity};
+    std::vector<std::uint32_t> parent_edges;
+    shard_map.SearchOverlay(durations, parent_edges);
+    BOOST_CHECK_EQUAL(durations[0], 10);
+    BOOST_CHECK_EQUAL(durations[1], 30);
+    BOOST_CHECK_EQUAL(durations[2], 190);
+    BOOST_CHECK_EQUAL(durations[3], 130);
+
+    const auto path = shard_map.GetOverlayPath(parent_edges, 2);
+    BOOST_REQUIRE_EQUAL(path.size(), 2);
+    const auto &edges = shard_map.GetOverlayEdges();
+    BOOST_CHECK_EQUAL(edges[path[0]].from, 1);
+    BOOST_CHECK_EQUAL(edges[path[0]].to, 3);
+    BOOST_CHECK_EQUAL(edges[path[1]].from, 3);
+    BOOST_CHECK_EQUAL(edges[path[1]].to, 2);
+    BOOST_CHECK(shard_map.GetOverlayPath(parent_edges, 0).empty());
+}
+
+BOOST_AUTO_TEST_CASE(write_and_read)
+{
+    auto shard_map = makeShardMap();
+    shard_map.SetBackend(0, "localhost", "5001");
+    shard_map.SetBackend(2, "10.0.0.3", "5000");
+
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("shard_map_test_%%%%-%%%%.txt");
+    shard_map.Write(path.string());
+    const ShardMap read_map(path.string());
+    boost::filesystem::remove(path);
+
+    BOOST_REQUIRE_EQUAL(read_map.GetShards().size(), 3);
+    BOOST_CHECK_EQUAL(read_map.GetShards()[0].host, "localhost");
+    BOOST_CHECK_EQUAL(read_map.GetShards()[0].port, "5001");
+    BOOST_CHECK(read_map.GetShards()[1].host.empty());
+    BOOST_CHECK_EQUAL(read_map.GetShards()[2].host, "10.0.0.3");
+    BOOST_CHECK_EQUAL(read_map.GetShards()[1].region.min_lon, toFixed(FloatLongitude{0.9}));
+    BOOST_REQUIRE_EQUAL(read_map.GetBoundaryPoints().size(), 4);
+    BOOST_CHECK_EQUAL(read_map.GetBoundaryPoints()[3].coordinate, makeCoordinate(2, 0.8));
+    BOOST_CHECK_EQUAL(read_map.GetBoundaryPoints()[3].shards[1], 2);
+    BOOST_CHECK_EQUAL(read_map.GetOverlayEdges().size(), 8);
+
+    std::vector<double> durations = {10, 30, std::numeric_limits<double>::infinity(), 0};
+    std::vector<std::uint32_t> parent_edges;
+    read_map.SearchOverlay(durations, parent_edges);
+    BOOST_CHECK_EQUAL(durations[1], 30);
+    BOOST_CHECK_EQUAL(durations[2], 60);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,136 @@
+#include "util/sharded_lru_cache.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(sharded_lru_cache)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+struct LengthCost
+{
+    std::size_t operator()(const unsigned, const std::string &value) const
+    {
+        return value.size();
+    }
+};
+}
+
+BOOST_AUTO_TEST_CASE(evicts_least_recently_used)
+{
+    ShardedLRUCache<unsigned, std::string> cache(3, 1);
+    cache.Add(0, 1, "a");
+    cache.Add(0, 2, "b");
+    cache.Add(0, 3, "c");
+
+    std::string value;
+    BOOST_CHECK(cache.Get(0, 1, value));
+    BOOST_CHECK_EQUAL(value, "a");
+
+    cache.Add(0, 4, "d");
+    BOOST_CHECK(!cache.Get(0, 2, value));
+    BOOST_CHECK(cache.Get(0, 1, value));
+    BOOST_CHECK(cache.Get(0, 3, value));
+    BOOST_CHECK(cache.Get(0, 4, value));
+
+    const auto statistics = cache.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.number_of_entries, 3);
+    BOOST_CHECK_EQUAL(statistics.cost, 3);
+    BOOST_CHECK_EQUAL(statistics.capacity, 3);
+    BOOST_CHECK_EQUAL(statistics.hits, 4);
+    BOOST_CHECK_EQUAL(statistics.misses, 1);
+    BOOST_CHECK_EQUAL(statistics.evictions, 1);
+    BOOST_CHECK_CLOSE(cache.GetHitRate(), 0.8, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(shards_split_the_capacity)
+{
+    // std::hash of an unsigned is the value itself, so 0 and 4 share a shard
+    ShardedLRUCache<unsigned, std::string> cache(4, 4);
+    cache.Add(0, 0, "a");
+    cache.Add(0, 1, "b");
+    cache.Add(0, 4, "c");
+
+    std::string value;
+    BOOST_CHECK(!cache.Get(0, 0, value));
+    BOOST_CHECK(cache.Get(0, 1, value));
+    BOOST_CHECK(cache.Get(0, 4, value));
+}
+
+BOOST_AUTO_TEST_CASE(cost_of_entries)
+{
+    ShardedLRUCache<unsigned, std::string, std::hash<unsigned>, unsigned, LengthCost> cache(5, 1);
+    cache.Add(0, 1, "aa");
+    cache.Add(0, 2, "bb");
+    // more than the capacity
+    cache.Add(0, 3, "cccccc");
+    BOOST_CHECK_EQUAL(cache.GetStatistics().number_of_entries, 2);
+
+    // replaces the entry of the key
+    cache.Add(0, 2, "bbb");
+    BOOST_CHECK_EQUAL(cache.GetStatistics().cost, 5);
+
+    cache.Add(0, 3, "c");
+    std::string value;
+    BOOST_CHECK(!cache.Get(0, 1, value));
+    BOOST_CHECK(cache.Get(0, 2, value));
+    BOOST_CHECK_EQUAL(value, "bbb");
+    BOOST_CHECK_EQUAL(cache.GetStatistics().cost, 4);
+}
+
+BOOST_AUTO_TEST_CASE(zero_capacity)
+{
+    ShardedLRUCache<unsigned, std::string> cache(0);
+    cache.Add(0, 1, "a");
+
+    std::string value;
+    BOOST_CHECK(!cache.Get(0, 1, value));
+    BOOST_CHECK_EQUAL(cache.GetOrAdd(0, 1, [] { return std::string("b"); }), "b");
+    BOOST_CHECK_EQUAL(cache.GetStatistics().number_of_entries, 0);
+}
+
+BOOST_AUTO_TEST_CASE(new_version_invalidates)
+{
+    ShardedLRUCache<unsigned, std::shared_ptr<const int>> cache(16);
+    cache.Add(3, 1, std::make_shared<const int>(1));
+    BOOST_CHECK(cache.Get(3, 1));
+    BOOST_CHECK(!cache.Get(4, 1));
+    BOOST_CHECK(!cache.Get(3, 1));
+    // dropped for the version, not evicted
+    BOOST_CHECK_EQUAL(cache.GetNumberOfEvictions(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_entries)
+{
+    ShardedLRUCache<unsigned, int> cache(16);
+    cache.Add(0, 1, 10);
+
+    int value = 0;
+    BOOST_CHECK(cache.Get(0, 1, value, [](const int cached) { return cached == 10; }));
+    BOOST_CHECK(!cache.Get(0, 1, value, [](const int cached) { return cached != 10; }));
+    BOOST_CHECK(!cache.Get(0, 1, value));
+}
+
+BOOST_AUTO_TEST_CASE(get_or_add_and_remove)
+{
+    ShardedLRUCache<unsigned, std::shared_ptr<int>> cache(16);
+    const auto first = cache.GetOrAdd(0, 1, [] { return std::make_shared<int>(1); });
+    const auto second = cache.GetOrAdd(0, 1, [] { return std::make_shared<int>(2); });
+    BOOST_CHECK_EQUAL(first, second);
+    BOOST_CHECK_EQUAL(cache.GetNumberOfMisses(), 1);
+    BOOST_CHECK_EQUAL(cache.GetNumberOfHits(), 1);
+
+    const auto other = std::make_shared<int>(1);
+    cache.Remove(0, 1, [&](const std::shared_ptr<int> &cached) { return cached == other; });
+    BOOST_CHECK_EQUAL(cache.Get(0, 1), first);
+    cache.Remove(0, 1, [&](const std::shared_ptr<int> &cached) { return cached == first; });
+    BOOST_CHECK(!cache.Get(0, 1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
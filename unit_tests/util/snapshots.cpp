@@ -0,0 +1,127 @@
+#include "util/snapshots.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(snapshots)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+// Counts the versions that are alive and fails reads of destroyed ones
+struct Version
+{
+    Version(const unsigned number_, std::atomic<int> &alive_) : number(number_), alive(alive_)
+    {
+        ++alive;
+    }
+    ~Version()
+    {
+        valid = false;
+        --alive;
+    }
+
+    unsigned number;
+    std::atomic<int> &alive;
+    std::atomic<bool> valid{true};
+};
+}
+
+BOOST_AUTO_TEST_CASE(update_replaces_value)
+{
+    std::atomic<int> alive{0};
+    Snapshots<Version> versions(std::unique_ptr<Version>(new Version(0, alive)));
+    BOOST_CHECK_EQUAL(versions.Acquire()->number, 0);
+
+    versions.Update([&](const Version &current) {
+        BOOST_CHECK_EQUAL(current.number, 0);
+        return std::unique_ptr<Version>(new Version(1, alive));
+    });
+    BOOST_CHECK_EQUAL(versions.Acquire()->number, 1);
+    BOOST_CHECK_EQUAL(alive, 1);
+
+    versions.Update([](const Version &) { return std::unique_ptr<Version>(); });
+    BOOST_CHECK_EQUAL(versions.Acquire()->number, 1);
+    BOOST_CHECK_EQUAL(alive, 1);
+}
+
+// the update doesn't wait for the pins of the previous version, the last one destroys it
+BOOST_AUTO_TEST_CASE(pin_outlives_update)
+{
+    std::atomic<int> alive{0};
+    Snapshots<Version> versions(std::unique_ptr<Version>(new Version(0, alive)));
+
+    auto pin = versions.Acquire();
+    auto other_pin = versions.Acquire();
+    versions.Update(
+        [&](const Version &) { return std::unique_ptr<Version>(new Version(1, alive)); });
+
+    // new readers see the new version while the old one is still pinned
+    BOOST_CHECK_EQUAL(versions.Acquire()->number, 1);
+    BOOST_CHECK_EQUAL(pin->number, 0);
+    BOOST_CHECK(pin->valid);
+    BOOST_CHECK_EQUAL(alive, 2);
+
+    pin = {};
+    BOOST_CHECK(other_pin->valid);
+    BOOST_CHECK_EQUAL(alive, 2);
+    other_pin = {};
+    BOOST_CHECK_EQUAL(alive, 1);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_readers)
+{
+    std::atomic<int> alive{0};
+    Snapshots<Version> versions(std::unique_ptr<Version>(new Version(0, alive)));
+
+    const unsigned number_of_updates = 200;
+    std::atomic<bool> done{false};
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> readers;
+    for (unsigned index = 0; index < 4; ++index)
+    {
+        readers.emplace_back([&] {
+            unsigned last_number = 0;
+            while (!done)
+            {
+                const auto pin = versions.Acquire();
+                // versions only move forward and stay valid while pinned
+                if (!pin->valid || pin->number < last_number)
+                {
+                    failed = true;
+                }
+                last_number = pin->number;
+                std::this_thread::yield();
+                if (!pin->valid)
+                {
+                    failed = true;
+                }
+            }
+        });
+    }
+
+    for (unsigned number = 1; number <= number_of_updates; ++number)
+    {
+        versions.Update([&](const Version &) {
+            return std::unique_ptr<Version>(new Version(number, alive));
+        });
+    }
+    done = true;
+    for (auto &reader : readers)
+    {
+        reader.join();
+    }
+
+    BOOST_CHECK(!failed);
+    BOOST_CHECK_EQUAL(versions.Acquire()->number, number_of_updates);
+    BOOST_CHECK_EQUAL(alive, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,6 +1,7 @@
 #include "util/static_rtree.hpp"
 #include "extractor/edge_based_node.hpp"
 #include "engine/geospatial_query.hpp"
+#include "engine/hint.hpp"
 #include "util/coordinate.hpp"
 #include "util/coordinate_calculation.hpp"
 #include "util/exception.hpp"
@@ -10,6 +11,7 @@
 #include "mocks/mock_datafacade.hpp"
 
 #include <boost/functional/hash.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/test/auto_unit_test.hpp>
 #include <boost/test/test_case_template.hpp>
 #include <boost/test/unit_test.hpp>
@@ -18,6 +20,7 @@
 #include <cstdint>
 
 #include <algorithm>
+#include <iterator>
 #include <memory>
 #include <random>
 #include <string>
@@ -32,7 +35,7 @@ using namespace osrm::util;
 using namespace osrm::test;
 
 constexpr uint32_t TEST_BRANCHING_FACTOR = 8;
-constexpr uint32_t TEST_LEAF_NODE_SIZE = 64;
+constexpr uint32_t TEST_LEAF_NODE_SIZE = 128;
 
 using TestData = extractor::EdgeBasedNode;
 using TestStaticRTree = StaticRTree<TestData,
@@ -269,7 +272,7 @@ void construction_test(const std::string &prefix, FixtureT *fixture)
 
 BOOST_FIXTURE_TEST_CASE(construct_tiny, TestRandomGraphFixture_10_30)
 {
-    using TinyTestTree = StaticRTree<TestData, std::vector<Coordinate>, false, 2, 64>;
+    using TinyTestTree = StaticRTree<TestData, std::vector<Coordinate>, false, 2, 128>;
     construction_test<TinyTestTree>("test_tiny", this);
 }
 
@@ -298,6 +301,130 @@ BOOST_FIXTURE_TEST_CASE(construct_multiple_levels_test, TestRandomGraphFixture_M
     construction_test("test_5", this);
 }
 
+BOOST_FIXTURE_TEST_CASE(prefetch_leaves_test, TestRandomGraphFixture_MultipleLevels)
+{
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree<TestRandomGraphFixture_MultipleLevels>(
+        "test_prefetch", this, leaves_path, nodes_path);
+    TestStaticRTree rtree(nodes_path, leaves_path, coords);
+    rtree.SetLeafPrefetching(true);
+    LinearSearchNN<TestData> lsnn(coords, edges);
+
+    simple_verify_rtree(rtree, coords, edges);
+    sampling_verify_rtree(rtree, lsnn, coords, 100);
+}
+
+// Only the query for a number of results skips the parts of the tree that are too far away
+BOOST_FIXTURE_TEST_CASE(nearest_k_test, TestRandomGraphFixture_MultipleLevels)
+{
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree<TestRandomGraphFixture_MultipleLevels>("test_k", this, leaves_path, nodes_path);
+    TestStaticRTree rtree(nodes_path, leaves_path, coords);
+
+    std::mt19937 g(RANDOM_SEED);
+    std::uniform_int_distribution<> lat_udist(WORLD_MIN_LAT, WORLD_MAX_LAT);
+    std::uniform_int_distribution<> lon_udist(WORLD_MIN_LON, WORLD_MAX_LON);
+    using Candidate = TestStaticRTree::CandidateSegment;
+    for (unsigned i = 0; i < 100; i++)
+    {
+        const Coordinate q{FixedLongitude{lon_udist(g)}, FixedLatitude{lat_udist(g)}};
+        for (const std::size_t max_results : {1, 5, 20})
+        {
+            const auto pruned = rtree.Nearest(q, max_results);
+            const auto unpruned = rtree.Nearest(
+                q,
+                [](const Candidate &) { return std::make_pair(true, true); },
+                [max_results](const std::size_t num_results, const Candidate &) {
+                    return num_results >= max_results;
+                });
+            BOOST_REQUIRE_EQUAL(pruned.size(), max_results);
+            BOOST_REQUIRE_EQUAL(unpruned.size(), max_results);
+            // segments that share their nearest point can come in any order
+            for (const auto index : irange<std::size_t>(0, max_results))
+            {
+                const double pruned_dist = coordinate_calculation::perpendicularDistance(
+                    coords[pruned[index].u], coords[pruned[index].v], q);
+                const double unpruned_dist = coordinate_calculation::perpendicularDistance(
+                    coords[unpruned[index].u], coords[unpruned[index].v], q);
+                BOOST_CHECK_CLOSE(pruned_dist, unpruned_dist, 0.0001);
+            }
+        }
+    }
+}
+
+// A search in a box finds the same segments as the best-first search within a radius the box
+// contains
+BOOST_FIXTURE_TEST_CASE(nearest_in_box_test, TestRandomGraphFixture_MultipleLevels)
+{
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree<TestRandomGraphFixture_MultipleLevels>("test_box", this, leaves_path, nodes_path);
+    TestStaticRTree rtree(nodes_path, leaves_path, coords);
+
+    std::mt19937 g(RANDOM_SEED);
+    std::uniform_int_distribution<> lat_udist(-60 * COORDINATE_PRECISION,
+                                              60 * COORDINATE_PRECISION);
+    std::uniform_int_distribution<> lon_udist(WORLD_MIN_LON, WORLD_MAX_LON);
+    using Candidate = TestStaticRTree::CandidateSegment;
+    // about 9 degrees
+    const double max_distance = 1000000.;
+    for (unsigned i = 0; i < 100; i++)
+    {
+        const Coordinate q{FixedLongitude{lon_udist(g)}, FixedLatitude{lat_udist(g)}};
+        const auto accept_all = [](const Candidate &) { return std::make_pair(true, true); };
+        const auto outside = [&](const std::size_t, const Candidate &segment) {
+            return coordinate_calculation::haversineDistance(
+                       q, web_mercator::toWGS84(segment.fixed_projected_coordinate)) >
+                   max_distance;
+        };
+        const TestStaticRTree::Rectangle box{FixedLongitude{WORLD_MIN_LON},
+                                             FixedLongitude{WORLD_MAX_LON},
+                                             q.lat - toFixed(FloatLatitude{10.}),
+                                             q.lat + toFixed(FloatLatitude{10.})};
+
+        const auto best_first = rtree.Nearest(q, accept_all, outside);
+        const auto in_box = rtree.NearestInBox(q, box, accept_all, outside);
+        BOOST_REQUIRE_EQUAL(best_first.size(), in_box.size());
+        for (const auto index : irange<std::size_t>(0, best_first.size()))
+        {
+            const double best_first_dist = coordinate_calculation::perpendicularDistance(
+                coords[best_first[index].u], coords[best_first[index].v], q);
+            const double in_box_dist = coordinate_calculation::perpendicularDistance(
+                coords[in_box[index].u], coords[in_box[index].v], q);
+            BOOST_CHECK_CLOSE(best_first_dist, in_box_dist, 0.0001);
+        }
+        BOOST_CHECK_LE(rtree.CountLeavesInBox(box, 3), 3);
+    }
+}
+
+// The objects are stored after the leaves, the tools that go over all segments read them there
+BOOST_FIXTURE_TEST_CASE(leaf_file_objects_test, TestRandomGraphFixture_MultipleLevels)
+{
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree<TestRandomGraphFixture_MultipleLevels>(
+        "test_objects", this, leaves_path, nodes_path);
+
+    boost::iostreams::mapped_file_source leaf_file(leaves_path);
+    const auto objects = TestStaticRTree::GetLeafFileObjects(leaf_file.data(), leaf_file.size());
+    BOOST_REQUIRE_EQUAL(objects.second - objects.first, edges.size());
+
+    const auto end_points = [](const TestData &object) {
+        return std::make_pair(object.u, object.v);
+    };
+    std::vector<std::pair<NodeID, NodeID>> expected, stored;
+    std::transform(edges.begin(), edges.end(), std::back_inserter(expected), end_points);
+    std::transform(objects.first, objects.second, std::back_inserter(stored), end_points);
+    std::sort(expected.begin(), expected.end());
+    std::sort(stored.begin(), stored.end());
+    BOOST_CHECK(expected == stored);
+
+    BOOST_CHECK_THROW(TestStaticRTree::GetLeafFileObjects(leaf_file.data(), leaf_file.size() - 1),
+                      util::exception);
+}
+
 // Bug: If you querry a point that lies between two BBs that have a gap,
 // one BB will be pruned, even if it could contain a nearer match.
 BOOST_AUTO_TEST_CASE(regression_test)
@@ -366,6 +493,48 @@ BOOST_AUTO_TEST_CASE(radius_regression_test)
     }
 }
 
+// Small radii are searched in the leaves of their bounding box
+BOOST_AUTO_TEST_CASE(radius_box_search_test)
+{
+    using Coord = std::pair<FloatLongitude, FloatLatitude>;
+    using Edge = std::pair<unsigned, unsigned>;
+    std::vector<Coord> grid;
+    std::vector<Edge> edges;
+    for (const auto i : irange(0u, 20u))
+    {
+        grid.emplace_back(FloatLongitude{0.001 * i}, FloatLatitude{0.});
+        grid.emplace_back(FloatLongitude{0.001 * i}, FloatLatitude{0.001});
+        edges.emplace_back(2 * i, 2 * i + 1);
+    }
+    GraphFixture fixture(grid, edges);
+
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree<GraphFixture, MiniStaticRTree>("test_radius", &fixture, leaves_path, nodes_path);
+    MiniStaticRTree rtree(nodes_path, leaves_path, fixture.coords);
+    MockDataFacade mockfacade;
+    engine::GeospatialQuery<MiniStaticRTree, MockDataFacade> query(
+        rtree, fixture.coords, mockfacade);
+
+    // the vertical segments are about 111 meters apart
+    const Coordinate input(FloatLongitude{0.0052}, FloatLatitude{0.0005});
+    const auto results = query.NearestPhantomNodesInRange(input, 230.);
+    BOOST_REQUIRE_EQUAL(results.size(), 4);
+    for (const auto index : irange<std::size_t>(0, results.size()))
+    {
+        BOOST_CHECK_LE(results[index].distance, 230.);
+        if (index > 0)
+        {
+            BOOST_CHECK_LE(results[index - 1].distance, results[index].distance);
+        }
+    }
+
+    const auto nearest = query.NearestPhantomNodes(input, 2, 230.);
+    BOOST_REQUIRE_EQUAL(nearest.size(), 2);
+    BOOST_CHECK_EQUAL(nearest[0].phantom_node.location, results[0].phantom_node.location);
+    BOOST_CHECK_EQUAL(nearest[1].phantom_node.location, results[1].phantom_node.location);
+}
+
 BOOST_AUTO_TEST_CASE(bearing_tests)
 {
     using Coord = std::pair<FloatLongitude, FloatLatitude>;
@@ -436,6 +605,120 @@ BOOST_AUTO_TEST_CASE(bearing_tests)
     }
 }
 
+// The mock with the geometries and weights of compressed edges, by their geometry id
+class GeometryDataFacade final : public MockDataFacade
+{
+  public:
+    void GetUncompressedGeometry(const EdgeID id, std::vector<NodeID> &result_nodes) const override
+    {
+        result_nodes = geometries.at(id);
+    }
+    void GetUncompressedWeights(const EdgeID id,
+                                std::vector<EdgeWeight> &result_weights) const override
+    {
+        result_weights = weights.at(id);
+    }
+
+    std::vector<std::vector<NodeID>> geometries;
+    std::vector<std::vector<EdgeWeight>> weights;
+};
+
+BOOST_AUTO_TEST_CASE(segment_phantom_node_tests)
+{
+    using Coord = std::pair<FloatLongitude, FloatLatitude>;
+    using Edge = std::pair<unsigned, unsigned>;
+    // a compressed edge in both directions and one in reverse direction only, of two segments
+    GraphFixture fixture(
+        {
+            Coord(FloatLongitude{0.0}, FloatLatitude{0.0}),
+            Coord(FloatLongitude{1.0}, FloatLatitude{0.0}),
+            Coord(FloatLongitude{2.0}, FloatLatitude{0.0}),
+            Coord(FloatLongitude{0.0}, FloatLatitude{1.0}),
+            Coord(FloatLongitude{1.0}, FloatLatitude{1.0}),
+            Coord(FloatLongitude{2.0}, FloatLatitude{1.0}),
+        },
+        {Edge(0, 1), Edge(1, 2), Edge(3, 4), Edge(4, 5)});
+    for (const auto index : {0, 1})
+    {
+        auto &edge = fixture.edges[index];
+        edge.forward_segment_id = {10, true};
+        edge.reverse_segment_id = {11, true};
+        edge.forward_packed_geometry_id = 0;
+        edge.reverse_packed_geometry_id = 1;
+        edge.fwd_segment_position = index;
+    }
+    for (const auto index : {2, 3})
+    {
+        auto &edge = fixture.edges[index];
+        edge.forward_segment_id = {SPECIAL_SEGMENTID, false};
+        edge.reverse_segment_id = {20, true};
+        edge.forward_packed_geometry_id = SPECIAL_EDGEID;
+        edge.reverse_packed_geometry_id = 2;
+        edge.fwd_segment_position = index - 2;
+    }
+
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree<GraphFixture, MiniStaticRTree>("test_segment", &fixture, leaves_path, nodes_path);
+    MiniStaticRTree rtree(nodes_path, leaves_path, fixture.coords);
+    GeometryDataFacade facade;
+    // geometries only store the target of each segment
+    facade.geometries = {{1, 2}, {1, 0}, {4, 3}};
+    facade.weights = {{30, 50}, {50, 30}, {60, 40}};
+    engine::GeospatialQuery<MiniStaticRTree, GeometryDataFacade> query(
+        rtree, fixture.coords, facade);
+
+    const auto decode = [](const engine::PhantomNode &phantom) {
+        return engine::Hint::FromBase64(engine::Hint{phantom, 0}.ToCompactBase64()).phantom;
+    };
+
+    // the same coordinate gets the same phantom node on every segment
+    for (const auto &input : {Coordinate(FloatLongitude{0.3}, FloatLatitude{0.1}),
+                              Coordinate(FloatLongitude{1.6}, FloatLatitude{-0.1}),
+                              Coordinate(FloatLongitude{0.2}, FloatLatitude{0.9}),
+                              Coordinate(FloatLongitude{1.7}, FloatLatitude{1.1})})
+    {
+        const auto results = query.NearestPhantomNodes(input, 1);
+        BOOST_REQUIRE_EQUAL(results.size(), 1);
+        const auto &snapped = results.front().phantom_node;
+
+        const auto rebuilt = query.SegmentPhantomNode(input, decode(snapped));
+        BOOST_CHECK(rebuilt.location == snapped.location);
+        BOOST_CHECK_EQUAL(rebuilt.forward_segment_id.id, snapped.forward_segment_id.id);
+        BOOST_CHECK_EQUAL(rebuilt.forward_segment_id.enabled, snapped.forward_segment_id.enabled);
+        BOOST_CHECK_EQUAL(rebuilt.reverse_segment_id.id, snapped.reverse_segment_id.id);
+        BOOST_CHECK_EQUAL(rebuilt.reverse_segment_id.enabled, snapped.reverse_segment_id.enabled);
+        BOOST_CHECK_EQUAL(rebuilt.fwd_segment_position, snapped.fwd_segment_position);
+        BOOST_CHECK_EQUAL(rebuilt.forward_weight, snapped.forward_weight);
+        BOOST_CHECK_EQUAL(rebuilt.forward_offset, snapped.forward_offset);
+        BOOST_CHECK_EQUAL(rebuilt.reverse_weight, snapped.reverse_weight);
+        BOOST_CHECK_EQUAL(rebuilt.reverse_offset, snapped.reverse_offset);
+    }
+
+    Coordinate input(FloatLongitude{1.6}, FloatLatitude{0.1});
+    const auto snapped = query.NearestPhantomNodes(input, 1).front().phantom_node;
+    BOOST_REQUIRE_EQUAL(snapped.fwd_segment_position, 1);
+
+    // a coordinate that projects elsewhere on the segment doesn't
+    Coordinate other_input(FloatLongitude{1.2}, FloatLatitude{0.1});
+    BOOST_CHECK(!query.SegmentPhantomNode(other_input, decode(snapped)).location.IsValid());
+
+    // neither does another segment of the compressed edge
+    auto other_segment = decode(snapped);
+    other_segment.fwd_segment_position = 0;
+    BOOST_CHECK(!query.SegmentPhantomNode(input, other_segment).location.IsValid());
+
+    // nor a segment position or ids that don't exist
+    auto missing_segment = decode(snapped);
+    missing_segment.fwd_segment_position = 2;
+    BOOST_CHECK(!query.SegmentPhantomNode(input, missing_segment).location.IsValid());
+    auto unknown_segment = decode(snapped);
+    unknown_segment.forward_segment_id = {42, true};
+    BOOST_CHECK(!query.SegmentPhantomNode(input, unknown_segment).location.IsValid());
+    unknown_segment.forward_segment_id = {20, true};
+    BOOST_CHECK(!query.SegmentPhantomNode(input, unknown_segment).location.IsValid());
+}
+
 BOOST_AUTO_TEST_CASE(bbox_search_tests)
 {
     using Coord = std::pair<FloatLongitude, FloatLatitude>;